@@ -0,0 +1,399 @@
+// PathView tile cache / loader contention benchmark
+// Runs reader threads (the render thread's GetTile / HasTile), inserter
+// threads (decode workers' InsertTile), submitter threads (frames of
+// SubmitRequests) and canceller threads (CancelRequest, with the odd
+// CancelAllRequests) at once against one TileCache and one
+// TileLoadThreadPool decoding a synthetic slide into it, and reports each
+// operation's throughput and latency percentiles. Lock wait is estimated
+// as each call's time above the median of the same call made alone (a
+// calibration pass before the threads start), summed: the cache and the
+// pool keep their locks private, and timing them from outside measures
+// the layout under test rather than an instrumented copy of it. Run the
+// same options before and after a change to compare designs.
+
+#include "SlideLoader.h"
+#include "TileCache.h"
+#include "TileLoadThreadPool.h"
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string slidePath = "synthetic://400000x400000?tile=256";
+    double seconds = 5.0;
+    size_t readers = 4;
+    size_t inserters = 2;
+    size_t submitters = 1;
+    size_t cancellers = 1;
+    size_t workers = 4;        // Pool decode threads; 0 leaves the pool out
+    size_t tiles = 4096;       // Level 0 tiles every thread draws its keys from
+    size_t cacheMB = 256;      // Below tiles x a tile's bytes, so inserts evict
+    int32_t tileSize = 256;    // Of the inserters' tiles
+    size_t frameRequests = 64; // Requests per submitted frame
+    double fps = 60.0;         // Frames each submitter submits a second; 0: as fast as it can
+    TileEvictionPolicy eviction = TileEvictionPolicy::Clock;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --slide PATH         Slide the pool decodes (default: synthetic://400000x400000?tile=256)\n"
+              << "  --seconds S          Length of the contended run (default: 5)\n"
+              << "  --readers N          GetTile / HasTile threads (default: 4)\n"
+              << "  --inserters N        InsertTile threads (default: 2)\n"
+              << "  --submitters N       SubmitRequests threads (default: 1)\n"
+              << "  --cancellers N       CancelRequest threads (default: 1)\n"
+              << "  --workers N          Pool decode threads, 0 for the cache alone (default: 4)\n"
+              << "  --tiles N            Tiles in the key space (default: 4096)\n"
+              << "  --cache-mb MB        Tile cache size (default: 256)\n"
+              << "  --tile-size N        Inserted tiles' width and height (default: 256)\n"
+              << "  --frame-requests N   Requests per submitted frame (default: 64)\n"
+              << "  --fps N              Frames per second per submitter, 0 for no pause (default: 60)\n"
+              << "  --tile-eviction P    clock (default) or scan-resistant\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto count = [&]() { return std::strtoull(argv[++i], nullptr, 10); };
+
+        if (arg == "--slide" && i + 1 < argc) {
+            options.slidePath = argv[++i];
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "--readers" && i + 1 < argc) {
+            options.readers = count();
+        } else if (arg == "--inserters" && i + 1 < argc) {
+            options.inserters = count();
+        } else if (arg == "--submitters" && i + 1 < argc) {
+            options.submitters = count();
+        } else if (arg == "--cancellers" && i + 1 < argc) {
+            options.cancellers = count();
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = count();
+        } else if (arg == "--tiles" && i + 1 < argc) {
+            options.tiles = count();
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            options.cacheMB = count();
+        } else if (arg == "--tile-size" && i + 1 < argc) {
+            options.tileSize = static_cast<int32_t>(std::clamp<unsigned long long>(count(), 16, 4096));
+        } else if (arg == "--frame-requests" && i + 1 < argc) {
+            options.frameRequests = std::max<size_t>(1, count());
+        } else if (arg == "--fps" && i + 1 < argc) {
+            options.fps = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--tile-eviction" && i + 1 < argc) {
+            std::optional<TileEvictionPolicy> policy = TileCache::ParseEvictionPolicy(argv[++i]);
+            if (!policy) {
+                std::cerr << "Unknown eviction policy: " << argv[i] << std::endl;
+                return false;
+            }
+            options.eviction = *policy;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.tiles > 0 && options.cacheMB > 0;
+}
+
+enum Operation : size_t { GET, HAS, INSERT, SUBMIT, CANCEL, OPERATION_COUNT };
+
+const char* OperationName(size_t operation) {
+    static const char* const NAMES[OPERATION_COUNT] = {
+        "GetTile", "HasTile", "InsertTile", "SubmitRequests", "CancelRequest"
+    };
+    return NAMES[operation];
+}
+
+// One operation's calls across its threads. Latencies are recorded in
+// nanoseconds: LatencyHistogram's buckets are unit-free.
+struct OperationStats {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> waitNs{0};  // Above soloNs, summed
+    uint64_t soloNs = 0;              // Median alone (calibration)
+    size_t threads = 0;
+};
+
+// Level 0 tiles of a square patch in the slide's corner, as keys
+class KeySpace {
+public:
+    explicit KeySpace(size_t tiles)
+        : tiles_(tiles), side_(static_cast<int32_t>(std::max(1.0, std::ceil(std::sqrt(double(tiles)))))) {}
+
+    TileKey operator()(std::mt19937_64& random) const {
+        const int32_t index = static_cast<int32_t>(random() % tiles_);
+        return TileKey{0, index % side_, index / side_};
+    }
+
+private:
+    size_t tiles_;
+    int32_t side_;
+};
+
+TileData MakeTile(TileCache& cache, int32_t tileSize, uint32_t color) {
+    const size_t pixelCount = static_cast<size_t>(tileSize) * tileSize;
+    size_t capacity = 0;
+    std::shared_ptr<TileBufferPool> bufferPool = cache.GetBufferPool();
+    uint32_t* pixels = bufferPool->Acquire(pixelCount, &capacity);
+    // Not uniform, so it is stored as pixels even with solid tiles on
+    for (size_t i = 0; i < pixelCount; ++i) {
+        pixels[i] = 0xFF000000u | (color + static_cast<uint32_t>(i));
+    }
+    return TileData(pixels, tileSize, tileSize, std::move(bufferPool), capacity);
+}
+
+// Unpaced, a canceller makes millions of calls a second: clearing the
+// queue on more of them would leave the workers nothing to decode
+constexpr uint64_t CANCEL_ALL_ONE_IN = 1 << 16;
+
+// The calls each thread kind makes; one per call of Step
+class Workload {
+public:
+    Workload(const Options& options, TileCache& cache, TileLoadThreadPool* pool)
+        : options_(options), cache_(cache), pool_(pool), keys_(options.tiles) {}
+
+    // Times one call of operation (GET / HAS alternate for readers)
+    uint64_t Step(size_t operation, std::mt19937_64& random, std::vector<TileLoadRequest>& frame) {
+        switch (operation) {
+            case GET: {
+                const TileKey key = keys_(random);
+                const auto start = Clock::now();
+                TileHandle tile = cache_.GetTile(key);
+                const auto end = Clock::now();
+                checksum_.fetch_add(tile ? 1 : 0, std::memory_order_relaxed);
+                return Nanoseconds(start, end);
+            }
+            case HAS: {
+                const TileKey key = keys_(random);
+                const auto start = Clock::now();
+                const bool cached = cache_.HasTile(key);
+                const auto end = Clock::now();
+                checksum_.fetch_add(cached ? 1 : 0, std::memory_order_relaxed);
+                return Nanoseconds(start, end);
+            }
+            case INSERT: {
+                const TileKey key = keys_(random);
+                TileData tile = MakeTile(cache_, options_.tileSize, static_cast<uint32_t>(random()));
+                const auto start = Clock::now();
+                cache_.InsertTile(key, std::move(tile));
+                return Nanoseconds(start, Clock::now());
+            }
+            case SUBMIT: {
+                const uint64_t generation = generation_.fetch_add(1) + 1;
+                frame.clear();
+                for (size_t i = 0; i < options_.frameRequests; ++i) {
+                    frame.emplace_back(keys_(random),
+                                       i % 4 == 0 ? TileLoadPriority::ADJACENT : TileLoadPriority::VISIBLE,
+                                       generation);
+                }
+                const auto start = Clock::now();
+                pool_->SubmitRequests(frame.data(), frame.size());
+                pool_->RetireStaleRequests(generation);
+                return Nanoseconds(start, Clock::now());
+            }
+            case CANCEL: {
+                const TileKey key = keys_(random);
+                const bool all = random() % CANCEL_ALL_ONE_IN == 0;  // A slide switch now and then
+                const auto start = Clock::now();
+                if (all) {
+                    pool_->CancelAllRequests();
+                } else {
+                    pool_->CancelRequest(key);
+                }
+                return Nanoseconds(start, Clock::now());
+            }
+        }
+        return 0;
+    }
+
+    uint64_t GetChecksum() const { return checksum_.load(); }
+
+private:
+    static uint64_t Nanoseconds(Clock::time_point start, Clock::time_point end) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    const Options& options_;
+    TileCache& cache_;
+    TileLoadThreadPool* pool_;
+    KeySpace keys_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<uint64_t> checksum_{0};  // Keeps the reads from being optimised out
+};
+
+// The median of operation alone on this thread, over CALIBRATION_CALLS
+constexpr size_t CALIBRATION_CALLS = 20000;
+
+uint64_t Calibrate(Workload& workload, size_t operation) {
+    std::mt19937_64 random(operation + 1);
+    std::vector<TileLoadRequest> frame;
+    std::vector<uint64_t> samples;
+    samples.reserve(CALIBRATION_CALLS);
+    for (size_t i = 0; i < CALIBRATION_CALLS; ++i) {
+        samples.push_back(workload.Step(operation, random, frame));
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Nanoseconds in the largest unit that keeps three digits or so
+std::string FormatNs(uint64_t ns) {
+    char text[32];
+    if (ns < 10000) {
+        std::snprintf(text, sizeof(text), "%lluns", static_cast<unsigned long long>(ns));
+    } else if (ns < 10000000) {
+        std::snprintf(text, sizeof(text), "%.1fus", ns / 1e3);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1fms", ns / 1e6);
+    }
+    return text;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    const bool usePool = options.workers > 0;
+    if (!usePool) {
+        options.submitters = 0;
+        options.cancellers = 0;
+    }
+
+    std::unique_ptr<SlideLoader> loader;
+    if (usePool) {
+        loader = std::make_unique<SlideLoader>(options.slidePath);
+        if (!loader->IsValid()) {
+            std::cerr << "Failed to open slide: " << options.slidePath << std::endl;
+            return 1;
+        }
+    }
+
+    TileCache cache(options.cacheMB * 1024 * 1024);
+    cache.SetEvictionPolicy(options.eviction);
+    std::atomic<uint64_t> tilesDecoded{0};
+    std::unique_ptr<TileLoadThreadPool> pool;
+    if (usePool) {
+        pool = std::make_unique<TileLoadThreadPool>(options.workers);
+        pool->Initialize(loader.get(), &cache, [&](const TileKey&) { tilesDecoded++; });
+    }
+    Workload workload(options, cache, pool.get());
+
+    std::array<OperationStats, OPERATION_COUNT> stats;
+    stats[GET].threads = options.readers;
+    stats[HAS].threads = options.readers;
+    stats[INSERT].threads = options.inserters;
+    stats[SUBMIT].threads = options.submitters;
+    stats[CANCEL].threads = options.cancellers;
+
+    // Alone, before any other thread runs: inserts first, so reads find
+    // a full cache, and the pool's queue calls before its workers start
+    for (size_t operation : {INSERT, GET, HAS, SUBMIT, CANCEL}) {
+        if (stats[operation].threads > 0) {
+            stats[operation].soloNs = Calibrate(workload, operation);
+        }
+    }
+    if (pool) {
+        pool->CancelAllRequests();
+        pool->Start();
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    auto launch = [&](size_t count, std::vector<size_t> operations) {
+        for (size_t t = 0; t < count; ++t) {
+            const uint64_t seed = 1000 + threads.size();
+            threads.emplace_back([&, operations, seed]() {
+                std::mt19937_64 random(seed);
+                std::vector<TileLoadRequest> frame;
+                Clock::time_point nextFrame = Clock::now();
+                for (size_t call = 0; !stop.load(std::memory_order_relaxed); ++call) {
+                    // Readers check for a tile about once for every three reads
+                    const size_t operation = operations[call % operations.size()];
+                    OperationStats& stat = stats[operation];
+                    const uint64_t ns = workload.Step(operation, random, frame);
+                    stat.latency.Record(ns);
+                    stat.calls.fetch_add(1, std::memory_order_relaxed);
+                    if (ns > stat.soloNs) {
+                        stat.waitNs.fetch_add(ns - stat.soloNs, std::memory_order_relaxed);
+                    }
+                    if (operation == SUBMIT && options.fps > 0.0) {
+                        nextFrame += std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>(1.0 / options.fps));
+                        std::this_thread::sleep_until(nextFrame);
+                    }
+                }
+            });
+        }
+    };
+    const auto start = Clock::now();
+    launch(options.readers, {GET, GET, GET, HAS});
+    launch(options.inserters, {INSERT});
+    launch(options.submitters, {SUBMIT});
+    launch(options.cancellers, {CANCEL});
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    if (pool) {
+        pool->Stop();
+    }
+
+    std::printf("\n%zu readers, %zu inserters, %zu submitters, %zu cancellers, %zu pool workers; "
+                "%zu tiles, %zu MB cache (%s), %.1f s\n\n",
+                options.readers, options.inserters, options.submitters, options.cancellers, options.workers,
+                options.tiles, options.cacheMB, TileCache::EvictionPolicyName(options.eviction), elapsed);
+    std::printf("  %-15s %12s %9s %9s %9s %9s %9s %6s\n", "operation", "calls/s", "alone", "p50", "p99", "p99.9",
+                "max", "wait");
+    for (size_t operation = 0; operation < OPERATION_COUNT; ++operation) {
+        const OperationStats& stat = stats[operation];
+        if (stat.threads == 0) {
+            continue;
+        }
+        // Share of its threads' time spent in this call beyond the solo
+        // median (readers split their time between GetTile and HasTile)
+        const double threadNs = elapsed * 1e9 * static_cast<double>(stat.threads);
+        std::printf("  %-15s %12.0f %9s %9s %9s %9s %9s %5.1f%%\n", OperationName(operation),
+                    stat.calls.load() / elapsed, FormatNs(stat.soloNs).c_str(),
+                    FormatNs(stat.latency.GetPercentile(0.5)).c_str(),
+                    FormatNs(stat.latency.GetPercentile(0.99)).c_str(),
+                    FormatNs(stat.latency.GetPercentile(0.999)).c_str(), FormatNs(stat.latency.GetMax()).c_str(),
+                    100.0 * static_cast<double>(stat.waitNs.load()) / threadNs);
+    }
+    std::printf("\n  wait: time above the solo median, i.e. lock waits, plus preemption once the threads\n"
+                "  (%zu here, pool threads included) outnumber the cores (%u)\n",
+                threads.size() + (pool ? pool->GetThreadCount() + pool->GetReadAheadThreads() : 0),
+                std::thread::hardware_concurrency());
+
+    std::printf("\nCache:  %.1f%% hits, %zu evictions, %zu tiles (%.0f MB)\n", 100.0 * cache.GetHitRate(),
+                cache.GetEvictionCount(), cache.GetTileCount(), cache.GetMemoryUsage() / (1024.0 * 1024.0));
+    if (pool) {
+        std::printf("Pool:   %llu tiles decoded, %zu stale requests dropped\n",
+                    static_cast<unsigned long long>(tilesDecoded.load()), pool->GetDroppedCount());
+    }
+    std::printf("(checksum %llu)\n", static_cast<unsigned long long>(workload.GetChecksum()));
+    return 0;
+}
@@ -0,0 +1,262 @@
+// PathView spatial index benchmark
+// Builds PolygonIndex (packed Hilbert R-tree) and, for reference, the
+// fixed 100x100 grid it replaced over the same synthetic cell layout, then
+// times viewport queries at cell, tissue and whole-slide zoom. Both must
+// return the same polygons; the run fails if they do not.
+
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t polygons = 1000000;
+    double slideWidth = 150000.0;
+    double slideHeight = 100000.0;
+    int queries = 200;
+    int gridSize = 100;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --polygons N     Cells to generate (default: 1000000)\n"
+              << "  --slide W H      Slide size in level 0 pixels (default: 150000 100000)\n"
+              << "  --queries N      Queries per viewport size (default: 200)\n"
+              << "  --grid N         Reference grid cells per side (default: 100)\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--polygons" && i + 1 < argc) {
+            options.polygons = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--slide" && i + 2 < argc) {
+            options.slideWidth = std::atof(argv[++i]);
+            options.slideHeight = std::atof(argv[++i]);
+        } else if (arg == "--queries" && i + 1 < argc) {
+            options.queries = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--grid" && i + 1 < argc) {
+            options.gridSize = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.polygons > 0 && options.slideWidth > 0.0 && options.slideHeight > 0.0;
+}
+
+// The grid PolygonIndex used before the R-tree: every polygon listed in
+// each cell its box overlaps, queries gather, sort and deduplicate the
+// cells' lists
+class GridIndex {
+public:
+    GridIndex(int gridSize, double slideWidth, double slideHeight)
+        : gridSize_(gridSize)
+        , cellWidth_(slideWidth / gridSize)
+        , cellHeight_(slideHeight / gridSize)
+        , cells_(static_cast<size_t>(gridSize) * gridSize) {
+    }
+
+    void Build(const PolygonStore& polygons) {
+        polygons_ = &polygons;
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            int minX, minY, maxX, maxY;
+            CellRange(polygons.GetBoundingBox(polygon), minX, minY, maxX, maxY);
+            for (int y = minY; y <= maxY; ++y) {
+                for (int x = minX; x <= maxX; ++x) {
+                    cells_[static_cast<size_t>(y) * gridSize_ + x].push_back(polygon);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> QueryRegion(const Rect& region) const {
+        int minX, minY, maxX, maxY;
+        CellRange(region, minX, minY, maxX, maxY);
+        std::vector<uint32_t> candidates;
+        for (int y = minY; y <= maxY; ++y) {
+            for (int x = minX; x <= maxX; ++x) {
+                const std::vector<uint32_t>& cell = cells_[static_cast<size_t>(y) * gridSize_ + x];
+                candidates.insert(candidates.end(), cell.begin(), cell.end());
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<uint32_t> result;
+        for (uint32_t polygon : candidates) {
+            if (polygons_->Intersects(polygon, region)) {
+                result.push_back(polygon);
+            }
+        }
+        return result;
+    }
+
+    size_t GetMemoryUsage() const {
+        size_t bytes = cells_.capacity() * sizeof(cells_[0]);
+        for (const auto& cell : cells_) {
+            bytes += cell.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    void CellRange(const Rect& box, int& minX, int& minY, int& maxX, int& maxY) const {
+        auto clamp = [this](double value) {
+            return std::max(0, std::min(static_cast<int>(value), gridSize_ - 1));
+        };
+        minX = clamp(box.x / cellWidth_);
+        minY = clamp(box.y / cellHeight_);
+        maxX = clamp((box.x + box.width) / cellWidth_);
+        maxY = clamp((box.y + box.height) / cellHeight_);
+    }
+
+    const PolygonStore* polygons_ = nullptr;
+    int gridSize_;
+    double cellWidth_;
+    double cellHeight_;
+    std::vector<std::vector<uint32_t>> cells_;
+};
+
+// Hexagon-ish cells of 8-30 px radius, denser in a few tissue blobs
+void GenerateCells(const Options& options, PolygonStore& polygons) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> spread(0.0, 1.0);
+
+    struct Blob {
+        double x, y, radius;
+    };
+    std::vector<Blob> blobs;
+    for (int i = 0; i < 6; ++i) {
+        blobs.push_back({options.slideWidth * (0.15 + 0.7 * unit(random)),
+                         options.slideHeight * (0.15 + 0.7 * unit(random)),
+                         std::min(options.slideWidth, options.slideHeight) * (0.05 + 0.1 * unit(random))});
+    }
+
+    polygons.Reserve(options.polygons, options.polygons * 6);
+    std::vector<Vec2> vertices(6);
+    for (size_t i = 0; i < options.polygons; ++i) {
+        double x, y;
+        if (i % 4 == 0) {
+            x = unit(random) * options.slideWidth;
+            y = unit(random) * options.slideHeight;
+        } else {
+            const Blob& blob = blobs[i % blobs.size()];
+            x = std::clamp(blob.x + spread(random) * blob.radius, 0.0, options.slideWidth);
+            y = std::clamp(blob.y + spread(random) * blob.radius, 0.0, options.slideHeight);
+        }
+        double radius = 8.0 + 22.0 * unit(random);
+        for (int v = 0; v < 6; ++v) {
+            double angle = v * 3.14159265358979 / 3.0;
+            vertices[v] = Vec2(x + radius * std::cos(angle), y + radius * std::sin(angle));
+        }
+        polygons.Add(static_cast<int>(i % 5), vertices);
+    }
+}
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    PolygonStore polygons;
+    GenerateCells(options, polygons);
+
+    auto start = Clock::now();
+    GridIndex grid(options.gridSize, options.slideWidth, options.slideHeight);
+    grid.Build(polygons);
+    const double gridBuildMs = ElapsedMs(start);
+
+    start = Clock::now();
+    PolygonIndex tree;
+    tree.Build(polygons);
+    const double treeBuildMs = ElapsedMs(start);
+
+    std::printf("\n%zu polygons on a %.0f x %.0f slide\n\n", polygons.Size(), options.slideWidth,
+                options.slideHeight);
+    std::printf("  %-22s %10s %10s\n", "index", "build ms", "MB");
+    std::printf("  %-22s %10.1f %10.1f\n", ("grid " + std::to_string(options.gridSize) + "x" +
+                std::to_string(options.gridSize)).c_str(), gridBuildMs, grid.GetMemoryUsage() / (1024.0 * 1024.0));
+    std::printf("  %-22s %10.1f %10.1f\n", "Hilbert R-tree", treeBuildMs, tree.GetMemoryUsage() / (1024.0 * 1024.0));
+
+    // A 1920x1080 window at 1x, 0.1x and fit-to-window zoom
+    struct Viewport {
+        const char* name;
+        double width;
+        double height;
+    };
+    const Viewport viewports[] = {
+        {"cells (1x)", 1920.0, 1080.0},
+        {"tissue (0.1x)", 19200.0, 10800.0},
+        {"whole slide", options.slideWidth, options.slideHeight},
+    };
+
+    std::printf("\n  %-22s %12s %12s %10s %12s\n", "viewport", "grid us", "tree us", "speedup", "polygons");
+    bool consistent = true;
+    for (const Viewport& viewport : viewports) {
+        std::mt19937 random(7);
+        std::vector<Rect> regions;
+        for (int i = 0; i < options.queries; ++i) {
+            double x = std::uniform_real_distribution<double>(
+                0.0, std::max(1.0, options.slideWidth - viewport.width))(random);
+            double y = std::uniform_real_distribution<double>(
+                0.0, std::max(1.0, options.slideHeight - viewport.height))(random);
+            regions.emplace_back(x, y, viewport.width, viewport.height);
+        }
+
+        size_t found = 0;
+        start = Clock::now();
+        for (const Rect& region : regions) {
+            found += grid.QueryRegion(region).size();
+        }
+        const double gridUs = ElapsedMs(start) * 1000.0 / regions.size();
+
+        // As the overlay queries: unordered, into a buffer reused per frame
+        std::vector<uint32_t> visible;
+        start = Clock::now();
+        for (const Rect& region : regions) {
+            tree.QueryRegion(region, visible);
+        }
+        const double treeUs = ElapsedMs(start) * 1000.0 / regions.size();
+
+        for (const Rect& region : regions) {
+            tree.QueryRegion(region, visible);
+            std::sort(visible.begin(), visible.end());
+            if (grid.QueryRegion(region) != visible) {
+                consistent = false;
+            }
+        }
+
+        std::printf("  %-22s %12.1f %12.1f %9.2fx %12zu\n", viewport.name, gridUs, treeUs,
+                    treeUs > 0.0 ? gridUs / treeUs : 0.0, found / regions.size());
+    }
+
+    if (!consistent) {
+        std::printf("\nError: the grid and the tree returned different polygons\n");
+        return 2;
+    }
+    return 0;
+}
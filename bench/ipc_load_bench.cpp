@@ -0,0 +1,609 @@
+// PathView IPC / MCP load generator
+// Opens N concurrent sessions against a running viewer, either straight
+// to its IPC server (IPCServer -> Application::HandleIPCCommand) or
+// through pathview-mcp's MCP endpoint, and drives a weighted command mix
+// for a fixed time, as fast as each session's round trips allow or at a
+// fixed rate. Reports each command's throughput and p50/p99/max latency,
+// and what the load did to the GUI: frame time and rate from the
+// viewer's own pathview_frame_seconds histogram (its "metrics" IPC
+// event), idle baseline against under load, and the IPC server's
+// executed / throttled / over-budget counts from perf.ipc.
+
+#include "LatencyHistogram.h"
+#include "ipc/IPCClient.h"
+#ifdef PATHVIEW_HAS_MCP_CLIENT
+#include "mcp_sse_client.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using pathview::ipc::IPCClient;
+using pathview::ipc::IPCRequest;
+using pathview::ipc::IPCResponse;
+using pathview::ipc::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* DEFAULT_IPC_MIX = "viewport.pan=4,viewport.zoom=2,perf.ipc=2,perf.tile_stats=1";
+const char* DEFAULT_MCP_MIX = "pan=4,zoom=2,capture_snapshot=1";
+
+struct Options {
+    int port = -1;
+    std::string socketPath;
+    std::string mcpUrl;  // Empty: drive IPC directly
+    int sessions = 4;
+    double seconds = 10.0;
+    double baselineSeconds = 3.0;
+    double rate = 0.0;  // Requests per second per session; 0 = closed loop
+    int timeoutMs = 10000;
+    std::string mix;
+    std::map<std::string, json> params;  // Fixed params by command
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --port N             Viewer IPC port (default: auto-detect)\n"
+              << "  --socket PATH        Viewer IPC Unix socket (default: auto-detect)\n"
+              << "  --mcp URL            Drive MCP tools through pathview-mcp at URL\n"
+              << "                       (e.g. http://127.0.0.1:9000) instead of IPC methods\n"
+              << "  --sessions N         Concurrent sessions (default: 4)\n"
+              << "  --seconds S          Load duration (default: 10)\n"
+              << "  --baseline S         Idle time to measure frames before the load (default: 3, 0 = skip)\n"
+              << "  --rate R             Requests per second per session (default: 0 = as fast as possible)\n"
+              << "  --mix SPEC           Weighted commands, e.g. viewport.pan=4,perf.ipc=1\n"
+              << "                       (default: " << DEFAULT_IPC_MIX << ";\n"
+              << "                       with --mcp: " << DEFAULT_MCP_MIX << ")\n"
+              << "  --params CMD JSON    Fixed params for CMD instead of the built-in ones\n"
+              << "  --timeout-ms N       Per-request timeout (default: 10000)\n"
+              << "\nPan and zoom alternate direction so the view stays put; other commands\n"
+              << "get empty params unless --params gives some. The viewer needs a slide\n"
+              << "loaded for viewport and snapshot commands.\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--port" && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--socket" && i + 1 < argc) {
+            options.socketPath = argv[++i];
+        } else if (arg == "--mcp" && i + 1 < argc) {
+            options.mcpUrl = argv[++i];
+        } else if (arg == "--sessions" && i + 1 < argc) {
+            options.sessions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            options.baselineSeconds = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--mix" && i + 1 < argc) {
+            options.mix = argv[++i];
+        } else if (arg == "--params" && i + 2 < argc) {
+            const std::string command = argv[++i];
+            try {
+                options.params[command] = json::parse(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Bad --params for " << command << ": " << e.what() << std::endl;
+                return false;
+            }
+        } else if (arg == "--timeout-ms" && i + 1 < argc) {
+            options.timeoutMs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+#ifndef PATHVIEW_HAS_MCP_CLIENT
+    if (!options.mcpUrl.empty()) {
+        std::cerr << "--mcp needs cpp-mcp, which this build does not have" << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+// ============================================================================
+// Command mix
+// ============================================================================
+
+struct Command {
+    std::string name;
+    double weight = 1.0;
+    LatencyHistogram latency;
+    std::atomic<uint64_t> errors{0};
+    std::mutex errorMutex;
+    std::string firstError;
+};
+
+// "a=3,b,c=0.5" -> a weight 3, b 1, c 0.5
+bool ParseMix(const std::string& spec, std::vector<std::unique_ptr<Command>>& commands) {
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        if (entry.empty()) {
+            continue;
+        }
+        auto command = std::make_unique<Command>();
+        const size_t equals = entry.find('=');
+        command->name = entry.substr(0, equals);
+        if (equals != std::string::npos) {
+            char* end = nullptr;
+            command->weight = std::strtod(entry.c_str() + equals + 1, &end);
+            if (*end != '\0' || !(command->weight > 0.0)) {
+                std::cerr << "Bad weight in --mix: " << entry << std::endl;
+                return false;
+            }
+        }
+        commands.push_back(std::move(command));
+    }
+    if (commands.empty()) {
+        std::cerr << "--mix names no commands" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Built-in params; forward alternates so pans and zooms cancel out
+json MakeParams(const Options& options, const std::string& command, bool forward) {
+    auto fixed = options.params.find(command);
+    if (fixed != options.params.end()) {
+        return fixed->second;
+    }
+    if (command == "viewport.pan" || command == "pan") {
+        return json{{"dx", forward ? 200.0 : -200.0}, {"dy", forward ? 150.0 : -150.0}};
+    }
+    if (command == "viewport.zoom" || command == "zoom") {
+        return json{{"delta", forward ? 1.25 : 0.8}};
+    }
+    return json::object();
+}
+
+// ============================================================================
+// Sessions
+// ============================================================================
+
+// One client connection issuing one request at a time
+class Session {
+public:
+    virtual ~Session() = default;
+    virtual bool Connect(std::string& error) = 0;
+    // False with error set if the command failed
+    virtual bool Call(const std::string& command, const json& params, std::string& error) = 0;
+};
+
+std::unique_ptr<IPCClient> MakeIPCClient(const Options& options) {
+    return options.socketPath.empty() ? std::make_unique<IPCClient>(options.port)
+                                      : std::make_unique<IPCClient>(options.socketPath);
+}
+
+class IPCSession : public Session {
+public:
+    explicit IPCSession(const Options& options)
+        : client_(MakeIPCClient(options)), timeoutMs_(options.timeoutMs) {}
+
+    bool Connect(std::string& error) override {
+        if (!client_->Connect()) {
+            error = "cannot connect to the viewer's IPC server";
+            return false;
+        }
+        return true;
+    }
+
+    bool Call(const std::string& command, const json& params, std::string& error) override {
+        IPCRequest request;
+        request.id = 1;
+        request.method = command;
+        request.params = params;
+        const IPCResponse response = client_->SendRequest(request, timeoutMs_);
+        if (response.error) {
+            error = response.error->message;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::unique_ptr<IPCClient> client_;
+    int timeoutMs_;
+};
+
+#ifdef PATHVIEW_HAS_MCP_CLIENT
+class MCPSession : public Session {
+public:
+    explicit MCPSession(const Options& options) : client_(options.mcpUrl) {
+        client_.set_timeout(std::max(1, options.timeoutMs / 1000));
+    }
+
+    bool Connect(std::string& error) override {
+        try {
+            if (client_.initialize("pathview-ipc-load-bench", "0.1.0")) {
+                return true;
+            }
+            error = "MCP initialize failed";
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        return false;
+    }
+
+    bool Call(const std::string& command, const json& params, std::string& error) override {
+        try {
+            const json result = client_.call_tool(command, params);
+            if (result.value("isError", false)) {
+                error = result.dump();
+                return false;
+            }
+            return true;
+        } catch (const std::exception& e) {
+            error = e.what();
+            return false;
+        }
+    }
+
+private:
+    ::mcp::sse_client client_;
+};
+#endif
+
+std::unique_ptr<Session> MakeSession(const Options& options) {
+#ifdef PATHVIEW_HAS_MCP_CLIENT
+    if (!options.mcpUrl.empty()) {
+        return std::make_unique<MCPSession>(options);
+    }
+#endif
+    return std::make_unique<IPCSession>(options);
+}
+
+// Picks commands by weight until end. With a rate, requests are scheduled
+// on a fixed timetable and each latency counts from its scheduled start,
+// so a stalled server shows up as latency rather than as fewer requests.
+void RunSession(Session& session, const Options& options, std::vector<std::unique_ptr<Command>>& commands,
+                unsigned seed, Clock::time_point start, Clock::time_point end) {
+    std::vector<double> weights;
+    for (const auto& command : commands) {
+        weights.push_back(command->weight);
+    }
+    std::mt19937 random(seed);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::vector<bool> forward(commands.size(), true);
+    const auto interval = options.rate > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.rate))
+        : Clock::duration::zero();
+
+    Clock::time_point scheduled = start;
+    while (true) {
+        if (options.rate > 0.0) {
+            std::this_thread::sleep_until(scheduled);
+        } else {
+            scheduled = Clock::now();
+        }
+        if (scheduled >= end) {
+            break;
+        }
+        const size_t index = pick(random);
+        Command& command = *commands[index];
+        const json params = MakeParams(options, command.name, forward[index]);
+        forward[index] = !forward[index];
+
+        std::string error;
+        const bool ok = session.Call(command.name, params, error);
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled);
+        if (ok) {
+            command.latency.Record(static_cast<uint64_t>(micros.count()));
+        } else if (command.errors.fetch_add(1) == 0) {
+            std::lock_guard<std::mutex> lock(command.errorMutex);
+            command.firstError = error;
+        }
+        scheduled += interval;
+    }
+}
+
+// ============================================================================
+// GUI frame monitor
+// ============================================================================
+
+// Cumulative pathview_frame_seconds buckets from one metrics event
+struct FrameCounts {
+    std::vector<double> bounds;  // Upper bounds in seconds, the last +Inf
+    std::vector<uint64_t> cumulative;
+    double sum = 0.0;
+    Clock::time_point at;
+
+    uint64_t GetCount() const { return cumulative.empty() ? 0 : cumulative.back(); }
+};
+
+bool ParseFrameCounts(const std::string& text, FrameCounts& counts) {
+    const std::string bucket = "pathview_frame_seconds_bucket{le=\"";
+    const std::string sum = "pathview_frame_seconds_sum ";
+    counts.bounds.clear();
+    counts.cumulative.clear();
+    std::stringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.compare(0, bucket.size(), bucket) == 0) {
+            const size_t quote = line.find('"', bucket.size());
+            const size_t space = line.rfind(' ');
+            if (quote == std::string::npos || space == std::string::npos) {
+                return false;
+            }
+            const std::string bound = line.substr(bucket.size(), quote - bucket.size());
+            counts.bounds.push_back(bound == "+Inf" ? std::numeric_limits<double>::infinity() : std::atof(bound.c_str()));
+            counts.cumulative.push_back(std::strtoull(line.c_str() + space + 1, nullptr, 10));
+        } else if (line.compare(0, sum.size(), sum) == 0) {
+            counts.sum = std::atof(line.c_str() + sum.size());
+        }
+    }
+    return !counts.bounds.empty();
+}
+
+// Frames between two metrics events
+struct FrameWindow {
+    FrameCounts counts;  // Per-window cumulative buckets
+    double seconds = 0.0;
+
+    FrameWindow(const FrameCounts& from, const FrameCounts& to) {
+        counts.bounds = to.bounds;
+        for (size_t i = 0; i < to.cumulative.size(); ++i) {
+            const uint64_t before = i < from.cumulative.size() ? from.cumulative[i] : 0;
+            counts.cumulative.push_back(to.cumulative[i] - std::min(before, to.cumulative[i]));
+        }
+        counts.sum = to.sum - from.sum;
+        seconds = std::chrono::duration<double>(to.at - from.at).count();
+    }
+
+    // Interpolated within its bucket, as Prometheus' histogram_quantile
+    double GetPercentileMs(double fraction) const {
+        const uint64_t count = counts.GetCount();
+        if (count == 0) {
+            return 0.0;
+        }
+        const double rank = fraction * static_cast<double>(count);
+        for (size_t i = 0; i < counts.cumulative.size(); ++i) {
+            if (static_cast<double>(counts.cumulative[i]) < rank) {
+                continue;
+            }
+            if (counts.bounds[i] == std::numeric_limits<double>::infinity()) {
+                return i > 0 ? counts.bounds[i - 1] * 1000.0 : 0.0;
+            }
+            const double lower = i > 0 ? counts.bounds[i - 1] : 0.0;
+            const uint64_t below = i > 0 ? counts.cumulative[i - 1] : 0;
+            const uint64_t inBucket = counts.cumulative[i] - below;
+            const double within = inBucket > 0 ? (rank - static_cast<double>(below)) / inBucket : 1.0;
+            return (lower + (counts.bounds[i] - lower) * within) * 1000.0;
+        }
+        return 0.0;
+    }
+
+    // Share of frames over seconds, to the nearest bucket bound at or above it
+    double GetShareOver(double limit) const {
+        const uint64_t count = counts.GetCount();
+        for (size_t i = 0; i < counts.bounds.size() && count > 0; ++i) {
+            if (counts.bounds[i] >= limit) {
+                return 1.0 - static_cast<double>(counts.cumulative[i]) / static_cast<double>(count);
+            }
+        }
+        return 0.0;
+    }
+};
+
+// A separate IPC connection subscribed to the viewer's metrics event,
+// which carries its Prometheus text about once a second
+class FrameMonitor {
+public:
+    explicit FrameMonitor(const Options& options) : client_(MakeIPCClient(options)) {}
+
+    bool Start(std::string& error) {
+        client_->SetNotificationHandler([this](const std::string& method, const json& params) {
+            FrameCounts counts;
+            if (method != "event.metrics" || !ParseFrameCounts(params.value("text", std::string()), counts)) {
+                return;
+            }
+            counts.at = Clock::now();
+            std::lock_guard<std::mutex> lock(mutex_);
+            latest_ = std::move(counts);
+            ++sequence_;
+            updated_.notify_all();
+        });
+        if (!client_->Connect()) {
+            error = "cannot connect to the viewer's IPC server";
+            return false;
+        }
+        IPCRequest subscribe;
+        subscribe.id = 1;
+        subscribe.method = "events.subscribe";
+        subscribe.params = {{"events", {"metrics"}}};
+        const IPCResponse response = client_->SendRequest(subscribe);
+        if (response.error) {
+            error = response.error->message;
+            return false;
+        }
+        return true;
+    }
+
+    // The next metrics event after this call; false on timeout
+    bool WaitForNext(FrameCounts& counts, std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t seen = sequence_;
+        if (!updated_.wait_for(lock, timeout, [&] { return sequence_ != seen; })) {
+            return false;
+        }
+        counts = latest_;
+        return true;
+    }
+
+    // perf.ipc's counters, or null if it failed
+    json GetServerStats() {
+        IPCRequest request;
+        request.id = 2;
+        request.method = "perf.ipc";
+        const IPCResponse response = client_->SendRequest(request);
+        return response.result && !response.error ? *response.result : json();
+    }
+
+private:
+    std::unique_ptr<IPCClient> client_;
+    std::mutex mutex_;
+    std::condition_variable updated_;
+    FrameCounts latest_;
+    uint64_t sequence_ = 0;
+};
+
+// ============================================================================
+// Report
+// ============================================================================
+
+void PrintCommands(const std::vector<std::unique_ptr<Command>>& commands, double seconds) {
+    std::printf("\nCommands\n  %-24s %10s %10s %10s %10s %10s %8s\n", "", "req/s", "mean ms", "p50 ms",
+                "p99 ms", "max ms", "errors");
+    uint64_t total = 0;
+    uint64_t errors = 0;
+    for (const auto& command : commands) {
+        const LatencyHistogram& latency = command->latency;
+        total += latency.GetCount();
+        errors += command->errors.load();
+        std::printf("  %-24s %10.1f %10.3f %10.3f %10.3f %10.3f %8llu\n", command->name.c_str(),
+                    static_cast<double>(latency.GetCount()) / seconds, latency.GetMean() / 1000.0,
+                    static_cast<double>(latency.GetPercentile(0.50)) / 1000.0,
+                    static_cast<double>(latency.GetPercentile(0.99)) / 1000.0,
+                    static_cast<double>(latency.GetMax()) / 1000.0,
+                    static_cast<unsigned long long>(command->errors.load()));
+    }
+    std::printf("  %-24s %10.1f %54llu\n", "total", static_cast<double>(total) / seconds,
+                static_cast<unsigned long long>(errors));
+
+    for (const auto& command : commands) {
+        if (command->errors.load() > 0) {
+            std::lock_guard<std::mutex> lock(command->errorMutex);
+            std::printf("  first %s error: %s\n", command->name.c_str(), command->firstError.c_str());
+        }
+    }
+}
+
+void PrintFrames(const char* name, const FrameWindow& window) {
+    const uint64_t frames = window.counts.GetCount();
+    std::printf("  %-24s %10.1f %10.2f %10.2f %10.2f %9.1f%%\n", name,
+                window.seconds > 0.0 ? static_cast<double>(frames) / window.seconds : 0.0,
+                frames > 0 ? window.counts.sum * 1000.0 / static_cast<double>(frames) : 0.0,
+                window.GetPercentileMs(0.50), window.GetPercentileMs(0.99),
+                window.GetShareOver(1.0 / 60.0) * 100.0);
+}
+
+void PrintServerStats(const json& before, const json& after) {
+    if (before.is_null() || after.is_null()) {
+        return;
+    }
+    auto delta = [&](const char* key) {
+        return after.value(key, uint64_t{0}) - std::min(after.value(key, uint64_t{0}), before.value(key, uint64_t{0}));
+    };
+    std::printf("\nIPC server during the load: %llu executed, %llu throttled, %llu over-budget frames "
+                "(frame budget %.1f ms)\n",
+                static_cast<unsigned long long>(delta("executed")),
+                static_cast<unsigned long long>(delta("throttled")),
+                static_cast<unsigned long long>(delta("over_budget_frames")),
+                after.value("frame_budget_ms", 0.0));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    // Auto-detect as pathview-mcp does: the GUI's Unix socket if it has one
+    if (options.port < 0 && options.socketPath.empty()) {
+        options.socketPath = IPCClient::ReadSocketPathFromFile();
+        if (options.socketPath.empty()) {
+            options.port = IPCClient::ReadPortFromFile();
+        }
+    }
+    const bool mcp = !options.mcpUrl.empty();
+    std::vector<std::unique_ptr<Command>> commands;
+    if (!ParseMix(options.mix.empty() ? (mcp ? DEFAULT_MCP_MIX : DEFAULT_IPC_MIX) : options.mix, commands)) {
+        return 1;
+    }
+
+    std::cout << "Target: " << (mcp ? options.mcpUrl + " (MCP)"
+                                    : options.socketPath.empty() ? "localhost:" + std::to_string(options.port)
+                                                                 : options.socketPath)
+              << ", " << options.sessions << " sessions, " << options.seconds << " s, "
+              << (options.rate > 0.0 ? std::to_string(options.rate) + " req/s each" : std::string("closed loop"))
+              << std::endl;
+
+    // Frame timings come from the viewer itself, so they are optional
+    FrameMonitor monitor(options);
+    std::string error;
+    FrameCounts idleStart;
+    FrameCounts loadStart;
+    bool frames = monitor.Start(error);
+    if (!frames) {
+        std::cerr << "No GUI frame timings: " << error << std::endl;
+    } else if (!monitor.WaitForNext(idleStart)) {
+        std::cerr << "No GUI frame timings: no metrics event from the viewer" << std::endl;
+        frames = false;
+    }
+    if (frames && options.baselineSeconds > 0.0) {
+        std::cout << "Measuring idle frames for " << options.baselineSeconds << " s..." << std::endl;
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.baselineSeconds));
+    }
+    frames = frames && monitor.WaitForNext(loadStart);
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (int i = 0; i < options.sessions; ++i) {
+        sessions.push_back(MakeSession(options));
+        if (!sessions.back()->Connect(error)) {
+            std::cerr << "Session " << i << ": " << error << std::endl;
+            return 1;
+        }
+    }
+
+    const json serverBefore = frames ? monitor.GetServerStats() : json();
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.sessions; ++i) {
+        threads.emplace_back(RunSession, std::ref(*sessions[i]), std::cref(options), std::ref(commands),
+                             static_cast<unsigned>(i + 1), start, end);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    PrintCommands(commands, seconds);
+
+    FrameCounts loadEnd;
+    if (frames && monitor.WaitForNext(loadEnd)) {
+        std::printf("\nGUI frames\n  %-24s %10s %10s %10s %10s %10s\n", "", "fps", "mean ms", "p50 ms", "p99 ms",
+                    ">16.7 ms");
+        if (options.baselineSeconds > 0.0) {
+            PrintFrames("idle", FrameWindow(idleStart, loadStart));
+        }
+        PrintFrames("under load", FrameWindow(loadStart, loadEnd));
+        PrintServerStats(serverBefore, monitor.GetServerStats());
+    }
+    return 0;
+}
@@ -0,0 +1,507 @@
+// PathView headless tile pipeline benchmark
+// Replays a pan/zoom trace through SlideLoader + TileLoadThreadPool +
+// TileCache without a window and reports throughput, time to first pixel
+// and peak memory, so loader/cache changes can be compared in CI.
+
+#include "SlideLoader.h"
+#include "SlideRenderer.h"  // For SelectLevel and LevelSelection
+#include "TileCache.h"
+#include "TileLoadThreadPool.h"
+#include "DiskTileCache.h"
+#include "PyramidLayout.h"
+#include "LatencyHistogram.h"
+#include "ViewportTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string slidePath;
+    std::string tracePath;       // Empty: synthetic trace
+    std::string writeTracePath;  // Save the trace that was replayed
+    size_t threads = 0;
+    size_t cacheMB = 512;
+    size_t compressedCacheMB = 0;
+    size_t diskCacheMB = 0;      // Cold decodes by default
+    std::string diskCacheDir;
+    int windowWidth = 1920;
+    int windowHeight = 1080;
+    bool realtime = false;
+    bool coalescing = true;
+    bool directTiff = false;
+    bool gpuJpeg = false;
+    bool mmapTiff = false;
+    LevelSelection levelSelection = LevelSelection::Closest;
+    TileEvictionPolicy eviction = TileEvictionPolicy::Clock;
+    int pinnedCoarseLevels = 0;
+};
+
+// Longest a drained step waits for its tiles before giving up
+constexpr double STEP_TIMEOUT_MS = 10000.0;
+constexpr double SYNTHETIC_FRAME_MS = 1000.0 / 60.0;
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " <slide> [options]\n"
+              << "\n<slide> may be synthetic://WIDTHxHEIGHT?levels=N&tile=T&latency_us=U&seed=S, a\n"
+              << "procedural slide that needs no data (e.g. synthetic://100000x80000?latency_us=800)\n"
+              << "\nOptions:\n"
+              << "  --trace FILE         Pan/zoom trace to replay: a viewer recording (--record-trace)\n"
+              << "                       or text (default: synthetic zoom-pan-zoom)\n"
+              << "  --write-trace FILE   Save the replayed trace (e.g. to edit the synthetic one)\n"
+              << "  --threads N          Decode worker threads (default: auto)\n"
+              << "  --cache-mb MB        In-memory tile cache size (default: 512)\n"
+              << "  --compressed-cache-mb MB\n"
+              << "                       Compressed in-memory tier behind it (default: 0, off)\n"
+              << "  --disk-cache-mb MB   Persistent tile cache size (default: 0, cold decodes)\n"
+              << "  --disk-cache-dir DIR Persistent tile cache location\n"
+              << "  --window WxH         Window size for the synthetic trace (default: 1920x1080)\n"
+              << "  --realtime           Follow trace timestamps instead of waiting for each step\n"
+              << "  --no-coalesce        Decode every tile with its own region read\n"
+              << "  --direct-tiff        Decode SVS / tiled TIFF JPEG tiles without OpenSlide\n"
+              << "  --gpu-jpeg           Batch those decodes on the GPU (nvJPEG builds)\n"
+              << "  --mmap-tiff          Memory-map the slide for those direct reads\n"
+              << "  --level-selection M  closest (default) or coarser\n"
+              << "  --tile-eviction P    Tile cache eviction: clock (default) or scan-resistant\n"
+              << "  --pin-coarse-levels N\n"
+              << "                       Never evict the N coarsest levels (default: 0)\n"
+              << "\nText traces: one step per line, \"time_ms x y zoom width height\",\n"
+              << "with x/y the viewport's top-left corner in level-0 pixels; '#' starts a comment.\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--trace" && i + 1 < argc) {
+            options.tracePath = argv[++i];
+        } else if (arg == "--write-trace" && i + 1 < argc) {
+            options.writeTracePath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            options.cacheMB = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--compressed-cache-mb" && i + 1 < argc) {
+            options.compressedCacheMB = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--disk-cache-mb" && i + 1 < argc) {
+            options.diskCacheMB = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--disk-cache-dir" && i + 1 < argc) {
+            options.diskCacheDir = argv[++i];
+        } else if (arg == "--window" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.windowWidth, &options.windowHeight) != 2 ||
+                options.windowWidth <= 0 || options.windowHeight <= 0) {
+                std::cerr << "Invalid window size: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--realtime") {
+            options.realtime = true;
+        } else if (arg == "--no-coalesce") {
+            options.coalescing = false;
+        } else if (arg == "--direct-tiff") {
+            options.directTiff = true;
+        } else if (arg == "--gpu-jpeg") {
+            options.directTiff = true;
+            options.gpuJpeg = true;
+        } else if (arg == "--mmap-tiff") {
+            options.directTiff = true;
+            options.mmapTiff = true;
+        } else if (arg == "--level-selection" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "closest") {
+                options.levelSelection = LevelSelection::Closest;
+            } else if (value == "coarser") {
+                options.levelSelection = LevelSelection::CoarserOrEqual;
+            } else {
+                std::cerr << "Unknown level selection: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--tile-eviction" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::optional<TileEvictionPolicy> policy = TileCache::ParseEvictionPolicy(value);
+            if (!policy) {
+                std::cerr << "Unknown tile eviction policy: " << value << std::endl;
+                return false;
+            }
+            options.eviction = *policy;
+        } else if (arg == "--pin-coarse-levels" && i + 1 < argc) {
+            options.pinnedCoarseLevels = std::max(0, std::atoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-' && options.slidePath.empty()) {
+            options.slidePath = arg;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.slidePath.empty();
+}
+
+bool LoadTrace(const std::string& path, std::vector<ViewportSample>& steps) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open trace: " << path << std::endl;
+        return false;
+    }
+
+    // Binary traces recorded by the viewer start with their magic
+    char magic[4] = {};
+    if (file.read(magic, sizeof(magic)) && std::string(magic, sizeof(magic)) == "PVVT") {
+        ViewportTrace trace;
+        if (!trace.Load(path)) {
+            return false;
+        }
+        steps = trace.GetSamples();
+        return !steps.empty();
+    }
+    file.clear();
+    file.seekg(0);
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        ViewportSample step{};
+        if (!(fields >> step.timeMs >> step.x >> step.y >> step.zoom >> step.windowWidth >> step.windowHeight) ||
+            step.zoom <= 0.0 || step.windowWidth <= 0 || step.windowHeight <= 0) {
+            std::cerr << path << ":" << lineNumber << ": malformed trace step" << std::endl;
+            return false;
+        }
+        steps.push_back(step);
+    }
+    return !steps.empty();
+}
+
+bool SaveTrace(const std::string& path, const std::vector<ViewportSample>& steps) {
+    std::ofstream file(path);
+    file << "# time_ms x y zoom width height\n";
+    for (const ViewportSample& step : steps) {
+        file << step.timeMs << ' ' << step.x << ' ' << step.y << ' ' << step.zoom << ' '
+             << step.windowWidth << ' ' << step.windowHeight << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+// A typical review: zoom from the whole slide into the centre at 100%,
+// pan four screens to the right, then zoom back out to 25%. One step per
+// 60 Hz frame.
+std::vector<ViewportSample> SyntheticTrace(int64_t slideWidth, int64_t slideHeight, int width, int height) {
+    std::vector<ViewportSample> steps;
+    double fitZoom = std::min(static_cast<double>(width) / slideWidth,
+                              static_cast<double>(height) / slideHeight);
+    double centerX = slideWidth / 2.0;
+    double centerY = slideHeight / 2.0;
+
+    auto add = [&](double cx, double cy, double zoom) {
+        double timeMs = steps.size() * SYNTHETIC_FRAME_MS;
+        steps.push_back({timeMs, cx - width / zoom / 2.0, cy - height / zoom / 2.0, zoom, width, height});
+    };
+
+    constexpr int ZOOM_STEPS = 60;
+    constexpr int PAN_STEPS = 120;
+    constexpr int ZOOM_OUT_STEPS = 30;
+
+    for (int i = 0; i <= ZOOM_STEPS; ++i) {
+        double t = static_cast<double>(i) / ZOOM_STEPS;
+        add(centerX, centerY, fitZoom * std::pow(1.0 / fitZoom, t));
+    }
+    double panDistance = 4.0 * width;
+    for (int i = 1; i <= PAN_STEPS; ++i) {
+        add(centerX + panDistance * i / PAN_STEPS, centerY, 1.0);
+    }
+    for (int i = 1; i <= ZOOM_OUT_STEPS; ++i) {
+        double t = static_cast<double>(i) / ZOOM_OUT_STEPS;
+        add(centerX + panDistance, centerY, std::pow(0.25, t));
+    }
+    return steps;
+}
+
+// Tiles of level covering the trace step's visible region
+std::vector<TileKey> VisibleTiles(const PyramidLayout& pyramid, const ViewportSample& step, int32_t level) {
+    std::vector<TileKey> tiles;
+    double downsample = pyramid.GetLevelDownsample(level);
+    LevelDimensions dims = pyramid.GetLevelDimensions(level);
+    int32_t tileWidth = pyramid.GetTileWidth(level);
+    int32_t tileHeight = pyramid.GetTileHeight(level);
+
+    int64_t left = std::max<int64_t>(0, static_cast<int64_t>(step.x / downsample));
+    int64_t top = std::max<int64_t>(0, static_cast<int64_t>(step.y / downsample));
+    int64_t right = std::min(dims.width - 1, static_cast<int64_t>((step.x + step.windowWidth / step.zoom) / downsample));
+    int64_t bottom = std::min(dims.height - 1, static_cast<int64_t>((step.y + step.windowHeight / step.zoom) / downsample));
+    if (right < left || bottom < top) {
+        return tiles;
+    }
+
+    for (int64_t ty = top / tileHeight; ty <= bottom / tileHeight; ++ty) {
+        for (int64_t tx = left / tileWidth; tx <= right / tileWidth; ++tx) {
+            tiles.push_back({level, static_cast<int32_t>(tx), static_cast<int32_t>(ty)});
+        }
+    }
+    return tiles;
+}
+
+// Whether a coarser cached tile covers the middle of key, which the viewer
+// draws in its place while it loads; without one the tile shows black
+bool HasFallback(const PyramidLayout& pyramid, const TileCache& cache, const TileKey& key) {
+    const double downsample = pyramid.GetLevelDownsample(key.level);
+    const double x = (key.tileX + 0.5) * pyramid.GetTileWidth(key.level) * downsample;
+    const double y = (key.tileY + 0.5) * pyramid.GetTileHeight(key.level) * downsample;
+    for (int32_t level = key.level + 1; level < pyramid.GetLevelCount(); ++level) {
+        const double coarse = pyramid.GetLevelDownsample(level);
+        const LevelDimensions dims = pyramid.GetLevelDimensions(level);
+        const int32_t tileWidth = pyramid.GetTileWidth(level);
+        const int32_t tileHeight = pyramid.GetTileHeight(level);
+        TileKey fallback{level,
+                         static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(x / coarse) / tileWidth,
+                                                                (dims.width - 1) / tileWidth)),
+                         static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(y / coarse) / tileHeight,
+                                                                (dims.height - 1) / tileHeight))};
+        if (cache.HasTile(fallback)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t PeakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);  // Bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;  // Kilobytes on Linux
+#endif
+#endif
+}
+
+double Millis(uint64_t micros) {
+    return static_cast<double>(micros) / 1000.0;
+}
+
+void PrintStage(const char* name, const LatencyHistogram& histogram) {
+    std::printf("  %-14s %8llu  %9.2f  %9.2f  %9.2f  %9.2f  %9.2f\n", name,
+                static_cast<unsigned long long>(histogram.GetCount()),
+                histogram.GetMean() / 1000.0,
+                Millis(histogram.GetPercentile(0.50)), Millis(histogram.GetPercentile(0.90)),
+                Millis(histogram.GetPercentile(0.99)), Millis(histogram.GetMax()));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    SlideLoader loader(options.slidePath);
+    if (!loader.IsValid()) {
+        std::cerr << "Failed to open slide: " << loader.GetError() << std::endl;
+        return 1;
+    }
+    if (options.directTiff && loader.SetDirectTiffRead(true, options.mmapTiff) && options.gpuJpeg) {
+        loader.SetHardwareJpegDecode(true);
+    }
+
+    std::vector<ViewportSample> steps;
+    if (options.tracePath.empty()) {
+        steps = SyntheticTrace(loader.GetWidth(), loader.GetHeight(), options.windowWidth, options.windowHeight);
+    } else if (!LoadTrace(options.tracePath, steps)) {
+        return 1;
+    }
+    if (!options.writeTracePath.empty() && !SaveTrace(options.writeTracePath, steps)) {
+        std::cerr << "Cannot write trace: " << options.writeTracePath << std::endl;
+    }
+
+    PyramidLayout pyramid = PyramidLayout::FromSlide(loader, static_cast<int32_t>(TileLoadThreadPool::DEFAULT_TILE_SIZE));
+    std::vector<double> downsamples = pyramid.GetDownsamples();
+
+    TileCache cache(options.cacheMB * 1024 * 1024);
+    cache.GetCompressedTier().SetMaxBytes(options.compressedCacheMB * 1024 * 1024);
+    cache.SetEvictionPolicy(options.eviction);
+    if (options.pinnedCoarseLevels > 0) {
+        cache.PinLevels(0, pyramid.GetLevelCount() - options.pinnedCoarseLevels);
+    }
+    std::unique_ptr<DiskTileCache> diskCache;
+    if (options.diskCacheMB > 0) {
+        std::string root = options.diskCacheDir.empty() ? DiskTileCache::DefaultRootDirectory() : options.diskCacheDir;
+        diskCache = std::make_unique<DiskTileCache>(root, options.slidePath, options.diskCacheMB * 1024 * 1024);
+    }
+
+    // Submission time of every tile still waiting for its first pixel. A
+    // tile is drawable as soon as it lands in the cache, so arrival is the
+    // headless equivalent of the renderer's first draw.
+    TilePipelineStats stats;
+    std::mutex arrivalMutex;
+    std::condition_variable arrivalCondition;
+    std::unordered_map<TileKey, Clock::time_point, TileKeyHash> awaiting;
+    size_t tilesLoaded = 0;
+
+    TileLoadThreadPool pool(options.threads);
+    pool.Initialize(&loader, &cache, [&](const TileKey& key) {
+        std::lock_guard<std::mutex> lock(arrivalMutex);
+        auto it = awaiting.find(key);
+        if (it != awaiting.end()) {
+            stats.RecordSince(TileStage::FirstDraw, it->second);
+            awaiting.erase(it);
+        }
+        tilesLoaded++;
+        arrivalCondition.notify_all();
+    });
+    pool.SetDiskCache(diskCache.get());
+    pool.SetPyramid(&pyramid);
+    pool.SetStats(&stats);
+    pool.SetCoalescing(options.coalescing);
+
+    std::cout << "Slide: " << options.slidePath << " (" << loader.GetWidth() << "x" << loader.GetHeight()
+              << ", " << pyramid.GetLevelCount() << " levels)" << std::endl;
+    std::cout << "Trace: " << steps.size() << " steps, " << (options.realtime ? "realtime" : "drained")
+              << ", " << pool.GetThreadCount() << " workers" << std::endl;
+    std::cout << "Eviction: " << TileCache::EvictionPolicyName(options.eviction);
+    if (options.pinnedCoarseLevels > 0) {
+        std::cout << ", coarsest " << options.pinnedCoarseLevels << " levels pinned";
+    }
+    std::cout << std::endl;
+
+    pool.Start();
+
+    size_t incompleteSteps = 0;
+    size_t uncoveredTiles = 0;  // Missing at their step, with no fallback either
+    const int32_t coarsest = pyramid.GetLevelCount() - 1;
+    std::vector<TileLoadRequest> requests;
+    Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const ViewportSample& step = steps[i];
+        uint64_t generation = i + 1;
+        int32_t level = SlideRenderer::SelectLevel(downsamples, step.zoom, options.levelSelection);
+        std::vector<TileKey> visible = VisibleTiles(pyramid, step, level);
+
+        Clock::time_point submitStart = Clock::now();
+        requests.clear();
+        {
+            std::lock_guard<std::mutex> lock(arrivalMutex);
+            for (const TileKey& key : visible) {
+                if (cache.HasTile(key)) {
+                    continue;
+                }
+                if (!HasFallback(pyramid, cache, key)) {
+                    uncoveredTiles++;
+                }
+                requests.emplace_back(key, TileLoadPriority::VISIBLE, generation);
+                awaiting.emplace(key, requests.back().requestTime);
+            }
+        }
+        // The coarsest level as well, as the viewer preloads it for fallbacks
+        if (level != coarsest) {
+            for (const TileKey& key : VisibleTiles(pyramid, step, coarsest)) {
+                if (!cache.HasTile(key)) {
+                    requests.emplace_back(key, TileLoadPriority::ADJACENT, generation);
+                }
+            }
+        }
+        pool.SubmitRequests(requests.data(), requests.size());
+        pool.RetireStaleRequests(generation);
+        stats.RecordSince(TileStage::Submit, submitStart);
+
+        if (options.realtime) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<int64_t>(step.timeMs * 1000.0)));
+            continue;
+        }
+
+        // Drained: the next step starts once this one is fully on screen
+        std::unique_lock<std::mutex> lock(arrivalMutex);
+        bool complete = arrivalCondition.wait_for(lock, std::chrono::duration<double, std::milli>(STEP_TIMEOUT_MS), [&]() {
+            return std::all_of(visible.begin(), visible.end(),
+                               [&](const TileKey& key) { return cache.HasTile(key); });
+        });
+        if (!complete) {
+            incompleteSteps++;
+        }
+    }
+
+    double elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    pool.Stop();
+
+    size_t loaded;
+    {
+        std::lock_guard<std::mutex> lock(arrivalMutex);
+        loaded = tilesLoaded;
+    }
+
+    std::printf("\nReplayed %zu steps in %.2f s", steps.size(), elapsedSeconds);
+    if (incompleteSteps > 0) {
+        std::printf(" (%zu timed out)", incompleteSteps);
+    }
+    std::printf("\n");
+    std::printf("Tiles loaded:   %zu (%.1f tiles/s)\n", loaded, elapsedSeconds > 0.0 ? loaded / elapsedSeconds : 0.0);
+    std::printf("Decoded:        %.1f MB, %zu coalesced reads covering %zu tiles\n",
+                pool.GetDecodedBytes() / (1024.0 * 1024.0), pool.GetCoalescedReadCount(), pool.GetCoalescedTileCount());
+    std::printf("Dropped:        %zu stale requests\n", pool.GetDroppedCount());
+    std::printf("Uncovered:      %zu tiles with no cached fallback (drawn black), %.1f MB pinned\n",
+                uncoveredTiles, cache.GetPinnedMemory() / (1024.0 * 1024.0));
+    if (loader.IsDirectTiffReadActive()) {
+        std::printf("Direct TIFF:    %zu reads, %zu OpenSlide fallbacks, %zu GPU tiles\n",
+                    loader.GetDirectReadCount(), loader.GetDirectFallbackCount(),
+                    loader.GetHardwareDecodeCount());
+    }
+
+    const LatencyHistogram& firstPixel = stats.Get(TileStage::FirstDraw);
+    std::printf("First pixel:    p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                Millis(firstPixel.GetPercentile(0.50)), Millis(firstPixel.GetPercentile(0.99)),
+                Millis(firstPixel.GetMax()));
+    std::printf("Peak RSS:       %.1f MB (tile cache %.1f MB)\n",
+                PeakResidentBytes() / (1024.0 * 1024.0), cache.GetMemoryUsage() / (1024.0 * 1024.0));
+    const CompressedTileCache& compressedTier = cache.GetCompressedTier();
+    if (compressedTier.IsEnabled()) {
+        std::printf("Compressed:     %zu tiles in %.1f MB (%.1fx), %zu hits, %zu misses\n",
+                    compressedTier.GetTileCount(), compressedTier.GetMemoryUsage() / (1024.0 * 1024.0),
+                    compressedTier.GetCompressionRatio(), compressedTier.GetHitCount(), compressedTier.GetMissCount());
+    }
+
+    std::printf("\n  %-14s %8s  %9s  %9s  %9s  %9s  %9s\n", "stage (ms)", "count", "mean", "p50", "p90", "p99", "max");
+    for (size_t s = 0; s < TilePipelineStats::STAGE_COUNT; ++s) {
+        TileStage stage = static_cast<TileStage>(s);
+        if (stats.Get(stage).GetCount() > 0) {
+            PrintStage(TilePipelineStats::StageName(stage), stats.Get(stage));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+// PathView polygon loading benchmark
+// Loads the same cell segmentation exported in several formats (e.g. the
+// JSON and protobuf files of one slide) with the viewer's loaders and
+// reports load time and throughput per file, so loader changes can be
+// compared against each other. A file with a fresh binary cache (written
+// by the viewer after a load) gets a second row for loading from it.
+// --write-v2 converts a version 1 protobuf file to the packed version 2
+// format first and benchmarks both. --viewport times random access to
+// version 1 files instead of whole loads: indexing the tiles, then
+// parsing just those under one viewport at the slide center.
+
+#include "MappedFile.h"
+#include "PolygonCache.h"
+#include "PolygonLoaderFactory.h"
+#include "PolygonStore.h"
+#include "ProtobufTileSource.h"
+#include "SegmentationV2.h"
+#include "cell_polygons.pb.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<std::string> paths;
+    std::string writeV2Path;  // Version 2 copy of the first file
+    float v2Scale = 1.0f;
+    double viewport = 0.0;    // Slide pixels on a side; 0: whole loads only
+    int runs = 5;
+    bool verbose = false;
+};
+
+struct Result {
+    std::string path;
+    bool cached = false;
+    std::vector<double> loadMs;  // Sorted
+    size_t polygons = 0;
+    size_t vertices = 0;
+    size_t classes = 0;
+    size_t storeBytes = 0;
+    double fileMB = 0.0;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " <polygons> [<polygons> ...] [options]\n"
+              << "\nPass the same dataset in each format to compare loaders, e.g.\n"
+              << "  " << progName << " cells.json cells.pb\n"
+              << "\nOptions:\n"
+              << "  --runs N     Loads per file; the fastest and median are reported (default: 5)\n"
+              << "  --verbose    Keep the loaders' own log output\n"
+              << "  --write-v2 FILE\n"
+              << "               Convert the first file (version 1 protobuf) to version 2 and add it\n"
+              << "  --v2-scale N Version 2 coordinate units per tile pixel (default: 1)\n"
+              << "  --viewport N Also time random access to version 1 files: index, then the tiles\n"
+              << "               under an N x N slide pixel view at the slide center\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--runs" && i + 1 < argc) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg == "--write-v2" && i + 1 < argc) {
+            options.writeV2Path = argv[++i];
+        } else if (arg == "--v2-scale" && i + 1 < argc) {
+            options.v2Scale = static_cast<float>(std::max(0.01, std::atof(argv[++i])));
+        } else if (arg == "--viewport" && i + 1 < argc) {
+            options.viewport = std::max(1.0, std::atof(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.paths.push_back(arg);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.paths.empty();
+}
+
+// Re-encode a version 1 file as version 2, cell for cell
+bool WriteV2(const std::string& inputPath, const std::string& outputPath, float coordinateScale) {
+    DataProtoPolygon::SlideSegmentationData slideData;
+    std::ifstream input(inputPath, std::ios::binary);
+    if (!input || !slideData.ParseFromIstream(&input)) {
+        std::cerr << "Not a version 1 protobuf file: " << inputPath << std::endl;
+        return false;
+    }
+
+    SegmentationV2Writer writer(coordinateScale);
+    writer.SetSlideInfo(slideData.slide_id(), slideData.slide_path(), slideData.mpp(), slideData.max_level(),
+                        slideData.cell_model_name(), slideData.tissue_model_name(), slideData.tissue_empty_class());
+    for (const auto& pair : slideData.tissue_class_mapping()) {
+        writer.SetTissueClass(pair.first, pair.second);
+    }
+    std::vector<float> xy;
+    for (const auto& tile : slideData.tiles()) {
+        writer.BeginTile(tile.tile_id(), tile.level(), tile.x(), tile.y(), tile.width(), tile.height());
+        for (const auto& mask : tile.masks()) {
+            xy.clear();
+            for (const auto& point : mask.coordinates()) {
+                xy.push_back(point.x());
+                xy.push_back(point.y());
+            }
+            writer.AddCell(mask.cell_type(), xy.data(), xy.size() / 2, mask.centroid().x(), mask.centroid().y(),
+                           mask.confidence());
+        }
+        if (tile.has_tissue_segmentation_map()) {
+            const auto& map = tile.tissue_segmentation_map();
+            writer.SetTissueMap(reinterpret_cast<const uint8_t*>(map.data().data()), map.data().size(), map.width(),
+                                map.height(), map.dtype());
+        }
+        writer.EndTile();
+    }
+
+    std::vector<uint8_t> bytes = writer.Finish();
+    std::ofstream output(outputPath, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!output) {
+        std::cerr << "Cannot write: " << outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Benchmark(const std::string& path, bool cached, const Options& options, Result& result) {
+    result.path = path;
+    result.cached = cached;
+    std::error_code error;
+    result.fileMB = std::filesystem::file_size(cached ? PolygonCache::SidecarPath(path) : path, error) /
+                    (1024.0 * 1024.0);
+
+    for (int run = 0; run < options.runs; ++run) {
+        std::unique_ptr<PolygonLoader> loader = PolygonLoaderFactory::CreateLoader(path, cached);
+        if (!loader) {
+            std::cerr << "No loader for: " << path << std::endl;
+            return false;
+        }
+
+        PolygonStore polygons;
+        std::map<int, SDL_Color> classColors;
+        std::map<int, std::string> classNames;
+
+        // The loaders log every load; keep the table readable
+        std::ostringstream discarded;
+        std::streambuf* coutBuffer = options.verbose ? nullptr : std::cout.rdbuf(discarded.rdbuf());
+        auto start = Clock::now();
+        bool loaded = loader->Load(path, polygons, classColors, classNames);
+        double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (coutBuffer) {
+            std::cout.rdbuf(coutBuffer);
+        }
+
+        if (!loaded) {
+            std::cerr << "Failed to load: " << path << std::endl;
+            return false;
+        }
+
+        result.loadMs.push_back(elapsedMs);
+        result.polygons = polygons.Size();
+        result.vertices = polygons.GetTotalVertexCount();
+        result.classes = classNames.size();
+        result.storeBytes = polygons.GetVertexMemoryUsage();
+    }
+
+    std::sort(result.loadMs.begin(), result.loadMs.end());
+    return true;
+}
+
+// Index a version 1 file and parse only the tiles under one viewport;
+// false if the file is not version 1 protobuf
+bool BenchmarkViewport(const std::string& path, const Options& options) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    if (extension != ".pb" && extension != ".proto" && extension != ".bin") {
+        return false;
+    }
+    {
+        MappedFile input(path);
+        if (!input.Data() || SegmentationV2Reader::IsV2(input.Data(), input.Size())) {
+            return false;
+        }
+    }
+
+    std::ostringstream discarded;
+    std::streambuf* coutBuffer = options.verbose ? nullptr : std::cout.rdbuf(discarded.rdbuf());
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    auto start = Clock::now();
+    std::unique_ptr<ProtobufTileSource> source = ProtobufPolygonLoader::OpenTiles(path, classColors, classNames);
+    double indexMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (coutBuffer) {
+        std::cout.rdbuf(coutBuffer);
+    }
+    if (!source || source->GetTiles().empty()) {
+        return false;
+    }
+
+    Rect slide = source->GetTiles().front().bounds;
+    for (const auto& tile : source->GetTiles()) {
+        double right = std::max(slide.Right(), tile.bounds.Right());
+        double bottom = std::max(slide.Bottom(), tile.bounds.Bottom());
+        slide.x = std::min(slide.x, tile.bounds.x);
+        slide.y = std::min(slide.y, tile.bounds.y);
+        slide.width = right - slide.x;
+        slide.height = bottom - slide.y;
+    }
+    Rect view(slide.x + (slide.width - options.viewport) / 2, slide.y + (slide.height - options.viewport) / 2,
+              options.viewport, options.viewport);
+
+    start = Clock::now();
+    std::vector<size_t> tiles;
+    source->QueryTiles(view, tiles);
+    size_t polygons = 0;
+    for (size_t tile : tiles) {
+        std::shared_ptr<const PolygonStore> store = source->GetTile(tile);
+        polygons += store ? store->Size() : 0;
+    }
+    double viewMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::printf("  %-32s %9.1f %10.1f %8zu/%-8zu %10zu %9.1f\n", std::filesystem::path(path).filename().string().c_str(),
+                indexMs, viewMs, tiles.size(), source->GetTiles().size(), polygons,
+                source->GetCachedBytes() / (1024.0 * 1024.0));
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (!options.writeV2Path.empty()) {
+        if (!WriteV2(options.paths.front(), options.writeV2Path, options.v2Scale)) {
+            return 1;
+        }
+        options.paths.push_back(options.writeV2Path);
+    }
+
+    std::vector<Result> results;
+    for (const std::string& path : options.paths) {
+        for (bool cached : {false, true}) {
+            if (cached && !PolygonCache::IsFresh(path)) {
+                continue;
+            }
+            Result result;
+            if (!Benchmark(path, cached, options, result)) {
+                return 1;
+            }
+            results.push_back(result);
+        }
+    }
+
+    std::printf("\n%d run(s) per file\n\n", options.runs);
+    std::printf("  %-32s %9s %10s %10s %10s %8s %10s %8s\n", "file", "MB", "best ms", "median ms",
+                "MB/s", "speedup", "polygons", "classes");
+    const double baselineMs = results.front().loadMs.front();
+    for (const Result& result : results) {
+        double bestMs = result.loadMs.front();
+        double medianMs = result.loadMs[result.loadMs.size() / 2];
+        std::string name = std::filesystem::path(result.path).filename().string() + (result.cached ? " (cache)" : "");
+        std::printf("  %-32s %9.1f %10.1f %10.1f %10.1f %7.2fx %10zu %8zu\n", name.c_str(), result.fileMB,
+                    bestMs, medianMs, bestMs > 0.0 ? result.fileMB / (bestMs / 1000.0) : 0.0,
+                    bestMs > 0.0 ? baselineMs / bestMs : 0.0, result.polygons, result.classes);
+    }
+    std::printf("\nStore: %.1f MB for %zu vertices\n", results.front().storeBytes / (1024.0 * 1024.0),
+                results.front().vertices);
+
+    // Comparing loaders only means something on the same dataset
+    bool consistent = true;
+    for (const Result& result : results) {
+        if (result.polygons != results.front().polygons || result.vertices != results.front().vertices ||
+            result.classes != results.front().classes) {
+            std::printf("Warning: %s holds %zu polygons / %zu vertices / %zu classes, %s %zu / %zu / %zu\n",
+                        result.path.c_str(), result.polygons, result.vertices, result.classes,
+                        results.front().path.c_str(), results.front().polygons,
+                        results.front().vertices, results.front().classes);
+            consistent = false;
+        }
+    }
+
+    if (options.viewport > 0.0) {
+        std::printf("\nRandom access, %.0f x %.0f view at the slide center\n\n", options.viewport, options.viewport);
+        std::printf("  %-32s %9s %10s %17s %10s %9s\n", "file", "index ms", "view ms", "tiles", "polygons",
+                    "cache MB");
+        for (const std::string& path : options.paths) {
+            if (!BenchmarkViewport(path, options)) {
+                std::printf("  %-32s (not version 1 protobuf)\n",
+                            std::filesystem::path(path).filename().string().c_str());
+            }
+        }
+    }
+
+    return consistent ? 0 : 2;
+}
@@ -0,0 +1,412 @@
+// PathView polygon subsystem benchmark suite
+// Times every stage cells go through, on one synthetic segmentation
+// (SyntheticCells over a synthetic:// slide) so runs compare across
+// machines and changes: loading each file format, building PolygonIndex at
+// several densities, viewport queries from cell to whole-slide zoom,
+// triangulation by outline size, ROI cell counts (the PolygonMask path
+// AnnotationManager::ComputeCellCounts takes) by ROI size, and the
+// overlay's per-frame vertex generation from PolygonGeometryCache, cold
+// and warm. Each row reports the best run's time, its throughput and the
+// heap allocations one operation makes.
+
+#include "SyntheticSlide.h"
+#include "SyntheticCellWriter.h"
+#include "PolygonCache.h"
+#include "PolygonGeometryCache.h"
+#include "PolygonIndex.h"
+#include "PolygonLoaderFactory.h"
+#include "PolygonMask.h"
+#include "PolygonStore.h"
+#include "PolygonTriangulator.h"
+#include "Viewport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Every allocation through operator new, for the allocations column
+namespace {
+std::atomic<size_t> allocationCount{0};
+}  // namespace
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t cells = 1000000;
+    std::string slideUrl = "synthetic://100000x80000";
+    int runs = 5;
+    int queries = 200;
+    bool loaders = true;
+    bool verbose = false;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --cells N      Cells in the segmentation (default: 1000000)\n"
+              << "  --slide URL    synthetic:// slide they cover (default: synthetic://100000x80000)\n"
+              << "  --runs N       Runs per row; the fastest is reported (default: 5)\n"
+              << "  --queries N    Viewport queries per zoom (default: 200)\n"
+              << "  --no-loaders   Skip writing and loading the cell files\n"
+              << "  --verbose      Keep the loaders' own log output\n"
+              << "  --help         Show this help message\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--cells" && i + 1 < argc) {
+            options.cells = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--slide" && i + 1 < argc) {
+            options.slideUrl = argv[++i];
+        } else if (arg == "--runs" && i + 1 < argc) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--queries" && i + 1 < argc) {
+            options.queries = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-loaders") {
+            options.loaders = false;
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else {
+            if (arg != "--help" && arg != "-h") {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+            }
+            return false;
+        }
+    }
+    return options.cells > 0;
+}
+
+// Fastest of the runs and the allocations of one run
+struct Measurement {
+    double ms = std::numeric_limits<double>::max();
+    size_t allocations = 0;
+};
+
+// setup runs untimed before each run (e.g. to reset state the run
+// consumes)
+template <typename Setup, typename Run>
+Measurement Measure(int runs, Setup&& setup, Run&& run) {
+    Measurement result;
+    for (int i = 0; i < runs; ++i) {
+        setup();
+        const size_t allocations = allocationCount.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        run();
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        result.allocations = allocationCount.load(std::memory_order_relaxed) - allocations;
+        result.ms = std::min(result.ms, ms);
+    }
+    return result;
+}
+
+template <typename Run>
+Measurement Measure(int runs, Run&& run) {
+    return Measure(runs, [] {}, std::forward<Run>(run));
+}
+
+void PrintHeader(const char* title, const char* unit) {
+    std::printf("\n%s\n  %-26s %12s %14s %14s\n", title, "", "ms", unit, "allocs/op");
+}
+
+// items per second over operations of ms each, allocations per operation
+void PrintRow(const std::string& name, const Measurement& measurement, double items, size_t operations = 1) {
+    const double perSecond = measurement.ms > 0.0 ? items * operations / (measurement.ms / 1000.0) : 0.0;
+    std::printf("  %-26s %12.3f %14.0f %14.1f\n", name.c_str(), measurement.ms / operations, perSecond,
+                static_cast<double>(measurement.allocations) / operations);
+}
+
+// The cells as a loader would leave them: slide coordinates, class,
+// confidence, triangulated
+void FillStore(const SyntheticCells& generator, PolygonStore& polygons) {
+    std::vector<SyntheticCells::Cell> cells;
+    std::vector<float> xy;
+    for (int64_t row = 0; row < generator.GetRows(); ++row) {
+        for (int64_t column = 0; column < generator.GetColumns(); ++column) {
+            generator.Generate(column, row, cells, xy);
+            const double left = static_cast<double>(column * SyntheticCells::TILE_SIZE);
+            const double top = static_cast<double>(row * SyntheticCells::TILE_SIZE);
+            for (const SyntheticCells::Cell& cell : cells) {
+                polygons.BeginPolygon(cell.classId);
+                for (uint32_t v = 0; v < cell.vertexCount; ++v) {
+                    const float* point = &xy[(cell.firstVertex + v) * 2];
+                    polygons.AddVertex(left + point[0], top + point[1]);
+                }
+                polygons.SetConfidence(polygons.EndPolygon(), cell.confidence);
+            }
+        }
+    }
+    polygons.TriangulateAll();
+}
+
+void BenchmarkLoaders(const Options& options, const SyntheticCells& generator) {
+    const fs::path directory = fs::temp_directory_path() / "pathview_polygon_suite";
+    fs::create_directories(directory);
+    const std::string jsonPath = (directory / "cells.json").string();
+    const std::string protobufPath = (directory / "cells.pb").string();
+    if (!SyntheticCellWriter::WriteJson(jsonPath, options.slideUrl, generator) ||
+        !SyntheticCellWriter::WriteProtobuf(protobufPath, options.slideUrl, generator)) {
+        std::cerr << "Failed to write the cell files to " << directory.string() << std::endl;
+        return;
+    }
+
+    PrintHeader("Loading (cells/s)", "cells/s");
+    struct Format {
+        std::string name;
+        std::string path;
+        bool allowCache;
+    };
+    std::vector<Format> formats = {
+        {"JSON", jsonPath, false},
+        {"protobuf v2", protobufPath, false},
+    };
+    for (size_t i = 0; i < formats.size(); ++i) {
+        const Format format = formats[i];  // The sidecar row is appended below
+        std::unique_ptr<PolygonLoader> loader = PolygonLoaderFactory::CreateLoader(format.path, format.allowCache);
+        PolygonStore polygons;
+        std::map<int, SDL_Color> classColors;
+        std::map<int, std::string> classNames;
+        bool loaded = true;
+
+        // The loaders log every load; keep the table readable
+        std::ostringstream discarded;
+        std::streambuf* coutBuffer = options.verbose ? nullptr : std::cout.rdbuf(discarded.rdbuf());
+        Measurement measurement = Measure(options.runs, [&] {
+            polygons.Clear();
+            classColors.clear();
+            classNames.clear();
+        }, [&] {
+            loaded = loaded && loader && loader->Load(format.path, polygons, classColors, classNames);
+        });
+
+        // The sidecar the viewer writes after the first load of a file,
+        // with its index
+        bool cached = false;
+        if (loaded && !format.allowCache && format.path == protobufPath) {
+            PolygonIndex index;
+            index.Build(polygons);
+            cached = PolygonCache::Write(format.path, polygons, &index, classColors, classNames, nullptr);
+        }
+        if (coutBuffer) {
+            std::cout.rdbuf(coutBuffer);
+        }
+        if (!loaded) {
+            std::cerr << "  Failed to load " << format.path << std::endl;
+            continue;
+        }
+        const std::string filePath = format.allowCache ? PolygonCache::SidecarPath(format.path) : format.path;
+        const double megabytes = static_cast<double>(fs::file_size(filePath)) / (1024.0 * 1024.0);
+        PrintRow(format.name + " (" + std::to_string(static_cast<int>(megabytes + 0.5)) + " MB)", measurement,
+                 static_cast<double>(polygons.Size()));
+        if (cached) {
+            formats.push_back({"sidecar", format.path, true});
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+}
+
+void BenchmarkIndexBuild(const Options& options, const SyntheticSlide& slide) {
+    PrintHeader("PolygonIndex::Build (cells/s)", "cells/s");
+    for (size_t density : {options.cells / 100, options.cells / 10, options.cells}) {
+        if (density == 0) {
+            continue;
+        }
+        PolygonStore polygons;
+        FillStore(SyntheticCells(slide, density), polygons);
+        PolygonIndex index;
+        Measurement measurement = Measure(options.runs, [&] { index.Build(polygons); });
+        PrintRow(std::to_string(density) + " cells", measurement, static_cast<double>(density));
+    }
+}
+
+void BenchmarkQueries(const Options& options, const SyntheticSlide& slide, const PolygonIndex& index) {
+    PrintHeader("PolygonIndex::QueryRegion, 1920x1080 window (queries/s)", "queries/s");
+    const SyntheticSlideSpec& spec = slide.GetSpec();
+    const double fit = std::min(1920.0 / spec.width, 1080.0 / spec.height);
+    for (double zoom : {1.0, 0.25, 0.05, fit}) {
+        const double width = std::min(1920.0 / zoom, static_cast<double>(spec.width));
+        const double height = std::min(1080.0 / zoom, static_cast<double>(spec.height));
+        std::mt19937 random(7);
+        std::vector<Rect> regions;
+        for (int i = 0; i < options.queries; ++i) {
+            regions.emplace_back(std::uniform_real_distribution<double>(0.0, spec.width - width)(random),
+                                 std::uniform_real_distribution<double>(0.0, spec.height - height)(random),
+                                 width, height);
+        }
+
+        // As the overlay queries: into a buffer reused per frame
+        std::vector<uint32_t> visible;
+        size_t found = 0;
+        Measurement measurement = Measure(options.runs, [&] { found = 0; }, [&] {
+            for (const Rect& region : regions) {
+                index.QueryRegion(region, visible);
+                found += visible.size();
+            }
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "zoom %.2g (%zu cells)", zoom, found / regions.size());
+        PrintRow(name, measurement, 1.0, regions.size());
+    }
+}
+
+void BenchmarkTriangulation(const Options& options) {
+    PrintHeader("PolygonTriangulator::Triangulate (vertices/s)", "vertices/s");
+    std::mt19937 random(11);
+    for (size_t vertexCount : {8, 64, 512, 4096, 32768}) {
+        // A wobbly star: concave, as traced regions are
+        std::vector<Vec2> outline(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const double angle = 2.0 * 3.14159265358979 * i / vertexCount;
+            const double radius = 1000.0 * (0.7 + 0.3 * std::uniform_real_distribution<double>(0.0, 1.0)(random));
+            outline[i] = Vec2(radius * std::cos(angle), radius * std::sin(angle));
+        }
+        std::vector<int> triangles;
+        Measurement measurement = Measure(options.runs, [&] { triangles = PolygonTriangulator::Triangulate(outline); });
+        if (triangles.size() != (vertexCount - 2) * 3) {
+            std::cerr << "  " << vertexCount << " vertices gave " << triangles.size() / 3 << " triangles"
+                      << std::endl;
+        }
+        PrintRow(std::to_string(vertexCount) + " vertices", measurement, static_cast<double>(vertexCount));
+    }
+}
+
+void BenchmarkCellCounts(const Options& options, const SyntheticSlide& slide, const PolygonStore& polygons,
+                         const PolygonIndex& index) {
+    PrintHeader("ROI cell counts, octagon at the slide center (cells/s)", "cells/s");
+    const SyntheticSlideSpec& spec = slide.GetSpec();
+    const Vec2 center(spec.width / 2.0, spec.height / 2.0);
+    for (double size : {500.0, 2000.0, 10000.0, 40000.0}) {
+        std::vector<Vec2> outline;
+        for (int i = 0; i < 8; ++i) {
+            const double angle = 2.0 * 3.14159265358979 * (i + 0.5) / 8.0;
+            outline.emplace_back(center.x + size / 2.0 * std::cos(angle), center.y + size / 2.0 * std::sin(angle));
+        }
+        std::map<int, int> counts;
+        Measurement measurement = Measure(options.runs, [&] { counts.clear(); }, [&] {
+            PolygonMask(outline).CountCentroids(polygons, &index, counts);
+        });
+        size_t total = 0;
+        for (const auto& [classId, count] : counts) {
+            total += static_cast<size_t>(count);
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "%.0f px (%zu cells)", size, total);
+        PrintRow(name, measurement, static_cast<double>(total));
+    }
+}
+
+void BenchmarkOverlayFrames(const Options& options, const SyntheticSlide& slide, const PolygonStore& polygons) {
+    const SyntheticSlideSpec& spec = slide.GetSpec();
+    Viewport viewport(1920, 1080, spec.width, spec.height);
+    PrintHeader("Overlay vertex generation per frame, 1920x1080 (vertices/s)", "vertices/s");
+    auto colorOf = [](int classId) {
+        return SDL_Color{static_cast<uint8_t>(classId * 50), 128, 200, 160};
+    };
+
+    for (double zoom : {1.0, 0.5, 0.25}) {
+        viewport.SetView(Vec2(spec.width / 2.0, spec.height / 2.0), zoom);
+        PolygonGeometryCache geometry;
+        std::vector<uint32_t> chunks;
+        std::vector<std::vector<float>> screen;
+        size_t vertices = 0;
+
+        // As PolygonOverlay::RenderChunks: build the chunks in view, map
+        // their positions to the screen, each chunk into its own buffer
+        auto frame = [&] {
+            geometry.QueryChunks(viewport.GetVisibleRegion(), chunks);
+            screen.resize(chunks.size());
+            geometry.Prepare(chunks, polygons, [&](size_t slot, const PolygonChunkGeometry& chunk) {
+                screen[slot].resize(chunk.xy.size());
+                viewport.TransformToScreen(chunk.xy.data(), chunk.xy.size() / 2, screen[slot].data(),
+                                           geometry.GetOriginX(chunks[slot]), geometry.GetOriginY(chunks[slot]));
+            });
+        };
+        Measurement cold = Measure(options.runs, [&] {
+            geometry.Build(polygons);
+            geometry.SetStyle(colorOf);
+            screen.clear();
+        }, frame);
+        Measurement warm = Measure(options.runs, frame);
+        for (const std::vector<float>& positions : screen) {
+            vertices += positions.size() / 2;
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "zoom %.2g cold (%zu chunks)", zoom, chunks.size());
+        PrintRow(name, cold, static_cast<double>(vertices));
+        std::snprintf(name, sizeof(name), "zoom %.2g warm", zoom);
+        PrintRow(name, warm, static_cast<double>(vertices));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    SyntheticSlideSpec spec;
+    std::string error;
+    if (!SyntheticSlideSpec::Parse(options.slideUrl, spec, error)) {
+        std::cerr << error << ": " << options.slideUrl << std::endl;
+        return 1;
+    }
+    SyntheticSlide slide(spec);
+    SyntheticCells generator(slide, options.cells);
+
+    PolygonStore polygons;
+    const auto start = Clock::now();
+    FillStore(generator, polygons);
+    const double generateMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::printf("\n%zu cells (%zu vertices) on %s, generated and triangulated in %.0f ms\n", polygons.Size(),
+                polygons.GetTotalVertexCount(), options.slideUrl.c_str(), generateMs);
+
+    if (options.loaders) {
+        BenchmarkLoaders(options, generator);
+    }
+    BenchmarkIndexBuild(options, slide);
+
+    PolygonIndex index;
+    index.Build(polygons);
+    BenchmarkQueries(options, slide, index);
+    BenchmarkTriangulation(options);
+    BenchmarkCellCounts(options, slide, polygons, index);
+    BenchmarkOverlayFrames(options, slide, polygons);
+    return 0;
+}
@@ -0,0 +1,148 @@
+// PathView snapshot encoder benchmark
+// Encodes synthetic 1080p and 4K viewport frames in every snapshot format
+// this build supports, PNG at several zlib levels and thread counts, and
+// reports time and size per frame. The frames mimic a slide view: pale
+// background, textured tissue, and a few flat UI-coloured bars.
+
+#include "PNGEncoder.h"
+#include "SnapshotEncoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pathview;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    int iterations = 5;
+    int quality = 90;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --iterations N   Encodes per configuration, best kept (default: 5)\n"
+              << "  --quality N      JPEG / WebP quality (default: 90)\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--iterations" && i + 1 < argc) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--quality" && i + 1 < argc) {
+            options.quality = std::max(1, std::min(100, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Background, noisy pink/purple tissue blobs, opaque
+std::vector<uint8_t> MakeFrame(int width, int height) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> noise(-12, 12);
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* px = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            const double u = static_cast<double>(x) / width - 0.5;
+            const double v = static_cast<double>(y) / height - 0.5;
+            const bool tissue = u * u + v * v * 1.5 < 0.12 || (u > 0.25 && v < -0.2);
+            if (y < height / 40) {
+                px[0] = 45; px[1] = 45; px[2] = 48;  // Toolbar
+            } else if (tissue) {
+                const int n = noise(random);
+                px[0] = static_cast<uint8_t>(std::clamp(200 + n + (x * 7 % 23), 0, 255));
+                px[1] = static_cast<uint8_t>(std::clamp(120 + n + (y * 5 % 31), 0, 255));
+                px[2] = static_cast<uint8_t>(std::clamp(190 + n, 0, 255));
+            } else {
+                const int n = noise(random) / 6;
+                px[0] = static_cast<uint8_t>(242 + n);
+                px[1] = static_cast<uint8_t>(242 + n);
+                px[2] = static_cast<uint8_t>(240 + n);
+            }
+            px[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Best of N: the least disturbed run
+template <typename Encode>
+void Run(const char* label, int iterations, size_t rawBytes, const Encode& encode) {
+    double bestMs = 1e30;
+    size_t bytes = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        bytes = encode().size();
+        bestMs = std::min(bestMs, ElapsedMs(start));
+    }
+    std::printf("  %-24s %10.2f %10.2f %8.1f%%\n", label, bestMs, bytes / (1024.0 * 1024.0),
+                100.0 * bytes / rawBytes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const struct {
+        const char* name;
+        int width;
+        int height;
+    } sizes[] = {{"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> pixels = MakeFrame(size.width, size.height);
+        std::printf("\n%s (%d x %d), best of %d\n\n", size.name, size.width, size.height, options.iterations);
+        std::printf("  %-24s %10s %10s %9s\n", "encoder", "ms", "MB", "of raw");
+
+        for (int level : {PNGEncoder::DEFAULT_LEVEL, PNGEncoder::FAST_LEVEL}) {
+            for (size_t threads : {size_t(1), size_t(4), PNGEncoder::MAX_THREADS}) {
+                char label[64];
+                std::snprintf(label, sizeof(label), "png level %d, %zu thr", level, threads);
+                Run(label, options.iterations, pixels.size(), [&]() {
+                    return PNGEncoder::Encode(pixels, size.width, size.height, level, threads);
+                });
+            }
+        }
+
+        for (SnapshotFormat format : {SnapshotFormat::Jpeg, SnapshotFormat::WebP, SnapshotFormat::Qoi}) {
+            if (!SnapshotEncoder::IsSupported(format)) {
+                std::printf("  %-24s (not in this build)\n", SnapshotEncoder::FormatName(format));
+                continue;
+            }
+            SnapshotEncoder::Options encoding;
+            encoding.format = format;
+            encoding.quality = options.quality;
+            char label[64];
+            std::snprintf(label, sizeof(label), "%s q%d", SnapshotEncoder::FormatName(format), options.quality);
+            Run(format == SnapshotFormat::Qoi ? "qoi" : label, options.iterations, pixels.size(), [&]() {
+                return SnapshotEncoder::Encode(pixels, size.width, size.height, encoding).data;
+            });
+        }
+    }
+    std::printf("\n");
+    return 0;
+}
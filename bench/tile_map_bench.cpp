@@ -0,0 +1,216 @@
+// PathView tile map benchmark
+// Times FlatTileMap (open addressing, mixed TileKeyHash) against the
+// std::unordered_map with the shift-packed hash it replaced, on the tile
+// subsystem's access patterns: building a cache, lookups that hit and
+// miss, insert/erase churn as a pan evicts tiles, and full sweeps. Both
+// maps must agree on every lookup; the run fails if they do not.
+
+#include "FlatTileMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t tiles = 20000;   // A full tile cache is a few thousand to tens of thousands
+    int rounds = 20;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --tiles N        Tiles held (default: 20000)\n"
+              << "  --rounds N       Repetitions of each pass (default: 20)\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--tiles" && i + 1 < argc) {
+            options.tiles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            options.rounds = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.tiles > 0;
+}
+
+// The hash TileKey used before: fields packed with shifts, which overlap
+// past 24 bits and sign-extend negative coordinates over the others
+struct ShiftedTileKeyHash {
+    size_t operator()(const TileKey& k) const {
+        return (((size_t)k.level << 48) | ((size_t)k.tileX << 24) | (size_t)k.tileY) ^
+               ((size_t)k.slide * 0xC2B2AE3D27D4EB4Full);
+    }
+};
+
+// Stand-in for a cache entry (TextureEntry is about this size)
+struct Entry {
+    uint64_t payload[6];
+};
+
+// Tiles of a pyramid as a review visits them: square patches of
+// neighbouring tiles on a few levels of two slides
+std::vector<TileKey> GenerateKeys(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<TileKey> keys;
+    std::unordered_set<TileKey, TileKeyHash> seen;
+    while (keys.size() < count) {
+        int32_t level = static_cast<int32_t>(random() % 6);
+        int32_t span = 2000 >> level;
+        int32_t x0 = static_cast<int32_t>(random() % span);
+        int32_t y0 = static_cast<int32_t>(random() % span);
+        uint32_t slide = random() % 2;
+        for (int32_t y = y0; y < y0 + 8 && keys.size() < count; ++y) {
+            for (int32_t x = x0; x < x0 + 8 && keys.size() < count; ++x) {
+                TileKey key{level, x, y, slide};
+                if (seen.insert(key).second) {
+                    keys.push_back(key);
+                }
+            }
+        }
+    }
+    return keys;
+}
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Timings {
+    double insertMs = 0.0;
+    double hitMs = 0.0;
+    double missMs = 0.0;
+    double churnMs = 0.0;
+    double sweepMs = 0.0;
+    uint64_t checksum = 0;  // Found entries and their payloads, to compare
+};
+
+template <typename Map>
+Timings Run(const Options& options, const std::vector<TileKey>& keys, const std::vector<TileKey>& lookups,
+            const std::vector<TileKey>& absent) {
+    Timings timings;
+    for (int round = 0; round < options.rounds; ++round) {
+        Map map;
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            map.emplace(keys[i], Entry{{i, 0, 0, 0, 0, 0}});
+        }
+        timings.insertMs += ElapsedMs(start);
+
+        start = Clock::now();
+        for (const TileKey& key : lookups) {
+            auto it = map.find(key);
+            if (it != map.end()) {
+                timings.checksum += it->second.payload[0];
+            }
+        }
+        timings.hitMs += ElapsedMs(start);
+
+        start = Clock::now();
+        for (const TileKey& key : absent) {
+            timings.checksum += map.count(key);
+        }
+        timings.missMs += ElapsedMs(start);
+
+        // Evict the oldest quarter and load as many new tiles, as a pan does
+        start = Clock::now();
+        size_t quarter = keys.size() / 4;
+        for (size_t i = 0; i < quarter; ++i) {
+            map.erase(keys[i]);
+            map.emplace(absent[i % absent.size()], Entry{{i, 1, 0, 0, 0, 0}});
+        }
+        timings.churnMs += ElapsedMs(start);
+
+        start = Clock::now();
+        for (const auto& entry : map) {
+            timings.checksum += entry.second.payload[0] + entry.second.payload[1];
+        }
+        timings.sweepMs += ElapsedMs(start);
+    }
+    return timings;
+}
+
+// Distinct hashes over keys the shifted hash packs into overlapping bits
+template <typename Hash>
+size_t CountDistinctHashes(const std::vector<TileKey>& keys) {
+    std::unordered_set<size_t> hashes;
+    for (const TileKey& key : keys) {
+        hashes.insert(Hash{}(key));
+    }
+    return hashes.size();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<TileKey> keys = GenerateKeys(options.tiles, 42);
+    std::vector<TileKey> absent = GenerateKeys(options.tiles, 43);
+    for (TileKey& key : absent) {
+        key.slide += 2;  // Never in the map
+    }
+    // Frames look tiles up long after, and in another order than, they
+    // were loaded
+    std::vector<TileKey> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(44));
+
+    Timings flat = Run<FlatTileMap<Entry>>(options, keys, lookups, absent);
+    Timings node = Run<std::unordered_map<TileKey, Entry, ShiftedTileKeyHash>>(options, keys, lookups, absent);
+
+    const double perOp = 1e6 / (static_cast<double>(options.rounds) * keys.size());
+    std::printf("\n%zu tiles, %d rounds (ns per operation)\n\n", keys.size(), options.rounds);
+    std::printf("  %-12s %14s %14s %10s\n", "pass", "unordered_map", "FlatTileMap", "speedup");
+    auto row = [perOp](const char* name, double nodeMs, double flatMs) {
+        std::printf("  %-12s %14.1f %14.1f %9.2fx\n", name, nodeMs * perOp, flatMs * perOp,
+                    flatMs > 0.0 ? nodeMs / flatMs : 0.0);
+    };
+    row("insert", node.insertMs, flat.insertMs);
+    row("find hit", node.hitMs, flat.hitMs);
+    row("find miss", node.missMs, flat.missMs);
+    row("churn", node.churnMs * 4, flat.churnMs * 4);
+    row("sweep", node.sweepMs, flat.sweepMs);
+
+    // Keys whose fields overlap in the shifted hash: columns past 2^24,
+    // and a row at y = -1 (synthesized border tiles) sign-extended over
+    // everything
+    std::vector<TileKey> extreme;
+    for (int32_t level = 0; level < 8; ++level) {
+        for (int32_t x = 0; x < 128; ++x) {
+            extreme.push_back({level, x << 24, 0});
+        }
+    }
+    for (int32_t x = 0; x < 4096; ++x) {
+        extreme.push_back({0, x, -1});
+    }
+    std::printf("\n  distinct hashes of %zu large or negative keys: shifted %zu, mixed %zu\n", extreme.size(),
+                CountDistinctHashes<ShiftedTileKeyHash>(extreme), CountDistinctHashes<TileKeyHash>(extreme));
+
+    if (flat.checksum != node.checksum) {
+        std::printf("\nError: the maps returned different entries\n");
+        return 2;
+    }
+    return 0;
+}
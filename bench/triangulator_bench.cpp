@@ -0,0 +1,219 @@
+// PathView triangulator benchmark
+// Times PolygonTriangulator on traced outlines of 10, 1k and 100k vertices
+// (a cell, a lasso annotation, a large tissue outline) and on an outline
+// with holes, against the O(n^3) ear clipper it replaced on the sizes
+// where that finishes. The triangles must cover the polygon's area; the
+// run fails if they do not.
+
+#include "PolygonTriangulator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<size_t> sizes = {10, 1000, 100000};
+    size_t referenceMax = 1000;  // Largest outline given to the old clipper
+    double minSeconds = 0.5;     // Per measurement
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --sizes N,N,...       Outline vertex counts (default: 10,1000,100000)\n"
+              << "  --reference-max N     Largest outline for the old ear clipper (default: 1000)\n"
+              << "  --seconds S           Minimum time per measurement (default: 0.5)\n"
+              << std::endl;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--sizes" && i + 1 < argc) {
+            options.sizes.clear();
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start < list.size()) {
+                size_t comma = list.find(',', start);
+                if (comma == std::string::npos) comma = list.size();
+                options.sizes.push_back(std::strtoull(list.substr(start, comma - start).c_str(), nullptr, 10));
+                start = comma + 1;
+            }
+        } else if (arg == "--reference-max" && i + 1 < argc) {
+            options.referenceMax = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.minSeconds = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.sizes.empty() &&
+           std::all_of(options.sizes.begin(), options.sizes.end(), [](size_t n) { return n >= 3; });
+}
+
+// The ear clipper PolygonTriangulator used before: each ear test scans
+// every remaining vertex, and each clip restarts the search
+std::vector<int> ReferenceTriangulate(const std::vector<Vec2>& vertices) {
+    auto area = [](const Vec2& a, const Vec2& b, const Vec2& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    };
+    auto isEar = [&](const std::vector<int>& indices, size_t i) {
+        const size_t n = indices.size();
+        const size_t prev = i == 0 ? n - 1 : i - 1;
+        const size_t next = i == n - 1 ? 0 : i + 1;
+        const Vec2& a = vertices[indices[prev]];
+        const Vec2& b = vertices[indices[i]];
+        const Vec2& c = vertices[indices[next]];
+        if ((b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x) <= 0) {
+            return false;
+        }
+        for (size_t j = 0; j < n; ++j) {
+            if (j == prev || j == i || j == next) continue;
+            const Vec2& p = vertices[indices[j]];
+            double d1 = area(p, a, b), d2 = area(p, b, c), d3 = area(p, c, a);
+            bool hasNeg = d1 < 0 || d2 < 0 || d3 < 0;
+            bool hasPos = d1 > 0 || d2 > 0 || d3 > 0;
+            if (!(hasNeg && hasPos)) return false;
+        }
+        return true;
+    };
+
+    std::vector<int> triangles;
+    std::vector<int> indices(vertices.size());
+    for (size_t i = 0; i < indices.size(); ++i) indices[i] = static_cast<int>(i);
+    while (indices.size() > 3) {
+        bool earFound = false;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (isEar(indices, i)) {
+                triangles.push_back(indices[i == 0 ? indices.size() - 1 : i - 1]);
+                triangles.push_back(indices[i]);
+                triangles.push_back(indices[i == indices.size() - 1 ? 0 : i + 1]);
+                indices.erase(indices.begin() + i);
+                earFound = true;
+                break;
+            }
+        }
+        if (!earFound) {
+            for (size_t i = 1; i + 1 < indices.size(); ++i) {
+                triangles.insert(triangles.end(), {indices[0], indices[i], indices[i + 1]});
+            }
+            return triangles;
+        }
+    }
+    triangles.insert(triangles.end(), indices.begin(), indices.end());
+    return triangles;
+}
+
+// Counter-clockwise wobbly trace of n vertices, like a hand-drawn lasso
+std::vector<Vec2> Lasso(size_t n, double radius) {
+    std::vector<Vec2> vertices;
+    vertices.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        double angle = 2.0 * 3.14159265358979 * i / n;
+        double r = radius * (1.0 + 0.2 * std::sin(angle * 7) + 0.05 * std::sin(angle * 53));
+        vertices.emplace_back(r * std::cos(angle), r * std::sin(angle));
+    }
+    return vertices;
+}
+
+double RingArea(const std::vector<Vec2>& ring) {
+    double sum = 0.0;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        sum += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+    }
+    return std::abs(sum) / 2.0;
+}
+
+double TriangleArea(const std::vector<Vec2>& vertices, const std::vector<int>& indices) {
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const Vec2& a = vertices[indices[i]];
+        const Vec2& b = vertices[indices[i + 1]];
+        const Vec2& c = vertices[indices[i + 2]];
+        area += std::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) / 2.0;
+    }
+    return area;
+}
+
+// Mean milliseconds per call, repeating until minSeconds have passed
+template <typename Function>
+double TimeMs(double minSeconds, Function&& function) {
+    size_t runs = 0;
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        function();
+        ++runs;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed * 1000.0 / runs;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    bool consistent = true;
+    auto check = [&consistent](const std::vector<Vec2>& vertices, const std::vector<int>& indices, double expected) {
+        if (std::abs(TriangleArea(vertices, indices) - expected) > expected * 1e-9) {
+            consistent = false;
+        }
+    };
+
+    std::printf("\n  %-22s %12s %12s %10s %12s\n", "outline", "old ms", "earcut ms", "speedup", "triangles");
+    for (size_t size : options.sizes) {
+        const std::vector<Vec2> outline = Lasso(size, 1000.0);
+        std::vector<int> indices;
+        const double newMs = TimeMs(options.minSeconds, [&]() { indices = PolygonTriangulator::Triangulate(outline); });
+        check(outline, indices, RingArea(outline));
+
+        const std::string name = std::to_string(size) + " vertices";
+        if (size <= options.referenceMax) {
+            std::vector<int> reference;
+            const double oldMs = TimeMs(options.minSeconds, [&]() { reference = ReferenceTriangulate(outline); });
+            std::printf("  %-22s %12.4f %12.4f %9.1fx %12zu\n", name.c_str(), oldMs, newMs,
+                        newMs > 0.0 ? oldMs / newMs : 0.0, indices.size() / 3);
+        } else {
+            std::printf("  %-22s %12s %12.4f %10s %12zu\n", name.c_str(), "-", newMs, "-", indices.size() / 3);
+        }
+    }
+
+    // Largest outline with 100 square holes across its middle
+    const size_t holeOutline = *std::max_element(options.sizes.begin(), options.sizes.end());
+    const std::vector<Vec2> outer = Lasso(holeOutline, 1000.0);
+    std::vector<std::vector<Vec2>> holes;
+    std::vector<Vec2> all = outer;
+    double expected = RingArea(outer);
+    for (int i = 0; i < 100; ++i) {
+        const double x = -700.0 + i * 14.0;
+        holes.push_back({Vec2(x, -5), Vec2(x, 5), Vec2(x + 10, 5), Vec2(x + 10, -5)});
+        all.insert(all.end(), holes.back().begin(), holes.back().end());
+        expected -= 100.0;
+    }
+    std::vector<int> indices;
+    const double holesMs = TimeMs(options.minSeconds, [&]() { indices = PolygonTriangulator::Triangulate(outer, holes); });
+    check(all, indices, expected);
+    const std::string name = std::to_string(holeOutline) + " + 100 holes";
+    std::printf("  %-22s %12s %12.4f %10s %12zu\n", name.c_str(), "-", holesMs, "-", indices.size() / 3);
+
+    if (!consistent) {
+        std::printf("\nError: triangles do not cover the polygon's area\n");
+        return 2;
+    }
+    return 0;
+}
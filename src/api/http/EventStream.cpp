@@ -0,0 +1,55 @@
+#include "EventStream.h"
+#include <algorithm>
+
+namespace pathview {
+namespace http {
+
+void EventStream::Publish(const std::string& type, std::string data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Event& event = latest_[type];
+        event.type = type;
+        event.data = std::move(data);
+        event.sequence = ++sequence_;
+    }
+    eventAvailable_.notify_all();
+}
+
+std::vector<EventStream::Event> EventStream::WaitForEvents(uint64_t afterSequence,
+                                                           std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    eventAvailable_.wait_for(lock, timeout, [&]() { return closed_ || sequence_ > afterSequence; });
+    std::vector<Event> events;
+    if (closed_) {
+        return events;
+    }
+    for (const auto& [type, event] : latest_) {
+        if (event.sequence > afterSequence) {
+            events.push_back(event);
+        }
+    }
+    std::sort(events.begin(), events.end(),
+              [](const Event& a, const Event& b) { return a.sequence < b.sequence; });
+    return events;
+}
+
+uint64_t EventStream::GetSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequence_;
+}
+
+void EventStream::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    eventAvailable_.notify_all();
+}
+
+bool EventStream::IsClosed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+} // namespace http
+} // namespace pathview
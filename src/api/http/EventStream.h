@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace http {
+
+/**
+ * Latest viewer event of each type, for server-sent events and for agents
+ * blocking until something happens
+ *
+ * Like FrameStream: the producer publishes, every subscriber waits for a
+ * sequence newer than the last it saw. Only the latest event of each type
+ * is kept, so a slow subscriber skips to the current state rather than
+ * replaying every intermediate viewport.
+ */
+class EventStream {
+public:
+    struct Event {
+        std::string type;
+        std::string data;       // JSON text
+        uint64_t sequence = 0;  // 1 for the first event
+    };
+
+    /**
+     * Publish an event, replacing the previous one of its type
+     */
+    void Publish(const std::string& type, std::string data);
+
+    /**
+     * Wait for events newer than afterSequence (0: the latest of each type)
+     * @return Them in sequence order; empty on timeout or once closed
+     */
+    std::vector<Event> WaitForEvents(uint64_t afterSequence, std::chrono::milliseconds timeout);
+
+    uint64_t GetSequence() const;
+
+    /**
+     * Wake every subscriber for good (server shutdown)
+     */
+    void Close();
+    bool IsClosed() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable eventAvailable_;
+    std::map<std::string, Event> latest_;
+    uint64_t sequence_ = 0;
+    bool closed_ = false;
+};
+
+} // namespace http
+} // namespace pathview
@@ -0,0 +1,77 @@
+#include "FrameStream.h"
+
+namespace pathview {
+namespace http {
+
+void FrameStream::Publish(std::vector<uint8_t> data, std::string mimeType, int width, int height) {
+    auto frame = std::make_shared<Frame>();
+    frame->data = std::move(data);
+    frame->mimeType = std::move(mimeType);
+    frame->width = width;
+    frame->height = height;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frame->sequence = ++sequence_;
+        latest_ = std::move(frame);
+    }
+    frameAvailable_.notify_all();
+}
+
+std::shared_ptr<const FrameStream::Frame> FrameStream::WaitForFrame(uint64_t afterSequence,
+                                                                    std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    frameAvailable_.wait_for(lock, timeout, [&]() { return closed_ || sequence_ > afterSequence; });
+    if (closed_ || sequence_ <= afterSequence) {
+        return nullptr;
+    }
+    return latest_;
+}
+
+std::shared_ptr<const FrameStream::Frame> FrameStream::GetLatestFrame() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+void FrameStream::AddSubscriber(int fps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++subscribersByFps_[fps];
+    ++subscriberCount_;
+}
+
+void FrameStream::RemoveSubscriber(int fps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscribersByFps_.find(fps);
+    if (it == subscribersByFps_.end()) {
+        return;
+    }
+    if (--it->second == 0) {
+        subscribersByFps_.erase(it);
+    }
+    --subscriberCount_;
+}
+
+size_t FrameStream::GetSubscriberCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriberCount_;
+}
+
+int FrameStream::GetRequestedFps() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribersByFps_.empty() ? 0 : subscribersByFps_.rbegin()->first;
+}
+
+void FrameStream::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    frameAvailable_.notify_all();
+}
+
+bool FrameStream::IsClosed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+} // namespace http
+} // namespace pathview
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace http {
+
+/**
+ * Latest encoded frame of a live stream, fanned out to every subscriber
+ *
+ * The producer publishes a frame only when it changed; each is encoded
+ * once and shared, and every subscriber waits for a sequence newer than
+ * the one it last sent, so nothing is re-sent and idle streams cost
+ * nothing. A subscriber slower than the producer skips to the latest
+ * frame. Subscribers register the frame rate they want; the producer
+ * asks for the fastest (0: nobody is watching, produce nothing).
+ */
+class FrameStream {
+public:
+    struct Frame {
+        std::vector<uint8_t> data;
+        std::string mimeType;
+        int width = 0;
+        int height = 0;
+        uint64_t sequence = 0;  // 1 for the first frame
+    };
+
+    /**
+     * Publish a new frame and wake every waiting subscriber
+     */
+    void Publish(std::vector<uint8_t> data, std::string mimeType, int width, int height);
+
+    /**
+     * Wait for a frame newer than afterSequence (0: any frame)
+     * @return The latest frame, or nullptr on timeout or once closed
+     */
+    std::shared_ptr<const Frame> WaitForFrame(uint64_t afterSequence, std::chrono::milliseconds timeout);
+
+    /**
+     * Latest frame without waiting (nullptr before the first)
+     */
+    std::shared_ptr<const Frame> GetLatestFrame() const;
+
+    void AddSubscriber(int fps);
+    void RemoveSubscriber(int fps);
+    size_t GetSubscriberCount() const;
+
+    /**
+     * Fastest frame rate any subscriber asked for, 0 without subscribers
+     */
+    int GetRequestedFps() const;
+
+    /**
+     * Wake every subscriber for good (server shutdown)
+     */
+    void Close();
+    bool IsClosed() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable frameAvailable_;
+    std::shared_ptr<const Frame> latest_;
+    uint64_t sequence_ = 0;
+    std::map<int, size_t> subscribersByFps_;
+    size_t subscriberCount_ = 0;
+    bool closed_ = false;
+};
+
+} // namespace http
+} // namespace pathview
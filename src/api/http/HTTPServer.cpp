@@ -3,16 +3,49 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 namespace pathview {
 namespace http {
 
+namespace {
+
+// Weak comparison, as RFC 9110 asks for If-None-Match: "*" or any tag in
+// the comma-separated list, with or without W/
+bool MatchesETag(const std::string& ifNoneMatch, const std::string& etag) {
+    size_t start = 0;
+    while (start < ifNoneMatch.size()) {
+        size_t end = ifNoneMatch.find(',', start);
+        if (end == std::string::npos) {
+            end = ifNoneMatch.size();
+        }
+        size_t first = ifNoneMatch.find_first_not_of(" \t", start);
+        size_t last = ifNoneMatch.find_last_not_of(" \t", end - 1);
+        if (first < end && last != std::string::npos && last >= first) {
+            std::string tag = ifNoneMatch.substr(first, last - first + 1);
+            if (tag.compare(0, 2, "W/") == 0) {
+                tag.erase(0, 2);
+            }
+            if (tag == "*" || tag == etag) {
+                return true;
+            }
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+}  // namespace
+
 HTTPServer::HTTPServer(int port, SnapshotManager* snapshotManager)
     : server_(std::make_unique<httplib::Server>())
     , snapshotManager_(snapshotManager)
     , port_(port)
     , running_(false)
 {
+    server_->set_keep_alive_max_count(KEEP_ALIVE_MAX_REQUESTS);
+    server_->set_keep_alive_timeout(KEEP_ALIVE_TIMEOUT_SECONDS);
     SetupRoutes();
 }
 
@@ -20,34 +53,26 @@ HTTPServer::~HTTPServer() {
     Stop();
 }
 
+bool HTTPServer::IsNotModified(const httplib::Request& req, httplib::Response& res,
+                               const std::string& etag, const char* cacheControl) {
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", cacheControl);
+    if (!req.has_header("If-None-Match") || !MatchesETag(req.get_header_value("If-None-Match"), etag)) {
+        return false;
+    }
+    res.status = 304;
+    return true;
+}
+
 void HTTPServer::SetupRoutes() {
     // Health check endpoint
     server_->Get("/health", [](const httplib::Request&, httplib::Response& res) {
         res.set_content("OK", "text/plain");
     });
 
-    // Snapshot endpoint
-    server_->Get(R"(/snapshot/([a-f0-9\-]+))", [this](const httplib::Request& req, httplib::Response& res) {
-        std::string id = req.matches[1];
-
-        // Get snapshot from manager
-        auto snapshot = snapshotManager_->GetSnapshot(id);
-
-        if (!snapshot) {
-            res.status = 404;
-            res.set_content("Snapshot not found", "text/plain");
-            return;
-        }
-
-        // Serve PNG image
-        res.set_content(
-            reinterpret_cast<const char*>(snapshot->pngData.data()),
-            snapshot->pngData.size(),
-            "image/png"
-        );
-    });
-
-    // MJPEG stream endpoint
+    // MJPEG stream endpoint: parts are pushed as frames are published to
+    // frameStream_ (at most fps a second, only frames this client has not
+    // seen), each with its own content type
     server_->Get("/stream", [this](const httplib::Request& req, httplib::Response& res) {
         // Parse FPS parameter (default 5, max 30)
         int fps = 5;
@@ -59,7 +84,7 @@ void HTTPServer::SetupRoutes() {
                 fps = 5;
             }
         }
-        int frameDelayMs = 1000 / fps;
+        const auto frameInterval = std::chrono::milliseconds(1000 / fps);
 
         // Set MJPEG headers
         res.set_header("Content-Type", "multipart/x-mixed-replace; boundary=frame");
@@ -69,59 +94,129 @@ void HTTPServer::SetupRoutes() {
         // Use content provider for streaming
         res.set_content_provider(
             "multipart/x-mixed-replace; boundary=frame",
-            [this, frameDelayMs](size_t offset, httplib::DataSink& sink) {
-                auto lastFrameTime = std::chrono::steady_clock::now();
+            [this, fps, frameInterval](size_t, httplib::DataSink& sink) {
+                struct Subscription {
+                    FrameStream& stream;
+                    int fps;
+                    ~Subscription() { stream.RemoveSubscriber(fps); }
+                } subscription{frameStream_, fps};
+                frameStream_.AddSubscriber(fps);
 
+                uint64_t lastSequence = 0;
                 while (running_) {
-                    // FPS throttling
-                    auto now = std::chrono::steady_clock::now();
-                    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now - lastFrameTime).count();
-
-                    if (elapsed < frameDelayMs) {
-                        std::this_thread::sleep_for(
-                            std::chrono::milliseconds(frameDelayMs - elapsed));
-                    }
-                    lastFrameTime = std::chrono::steady_clock::now();
-
-                    // Get latest snapshot from stream buffer
-                    std::string snapshotId = snapshotManager_->GetLatestStreamFrame();
-                    if (snapshotId.empty()) {
-                        continue;
-                    }
-
-                    auto snapshot = snapshotManager_->GetSnapshot(snapshotId);
-                    if (!snapshot) {
+                    // Wakes for a new frame; the timeout only rechecks running_
+                    auto frame = frameStream_.WaitForFrame(lastSequence, std::chrono::seconds(1));
+                    if (!frame) {
+                        if (frameStream_.IsClosed()) {
+                            break;
+                        }
                         continue;
                     }
+                    lastSequence = frame->sequence;
+                    const auto sentAt = std::chrono::steady_clock::now();
 
                     // Build MJPEG frame
-                    std::ostringstream frame;
-                    frame << "--frame\r\n"
-                         << "Content-Type: image/png\r\n"
-                         << "Content-Length: " << snapshot->pngData.size() << "\r\n\r\n";
-
-                    // Write frame header
-                    if (!sink.write(frame.str().data(), frame.str().size())) {
+                    std::ostringstream header;
+                    header << "--frame\r\n"
+                           << "Content-Type: " << frame->mimeType << "\r\n"
+                           << "Content-Length: " << frame->data.size() << "\r\n\r\n";
+                    const std::string headerText = header.str();
+                    if (!sink.write(headerText.data(), headerText.size()) ||
+                        !sink.write(reinterpret_cast<const char*>(frame->data.data()), frame->data.size()) ||
+                        !sink.write("\r\n", 2)) {
                         return false;  // Client disconnected
                     }
 
-                    // Write frame data
-                    if (!sink.write(reinterpret_cast<const char*>(snapshot->pngData.data()),
-                                   snapshot->pngData.size())) {
-                        return false;
-                    }
+                    // FPS throttling: frames published meanwhile collapse
+                    // into the latest
+                    std::this_thread::sleep_until(sentAt + frameInterval);
+                }
+                return false;
+            }
+        );
+    });
+
+    // Server-sent events: the viewer events published to eventStream_,
+    // latest of each type; Last-Event-ID resumes after a reconnect
+    server_->Get("/events", [this](const httplib::Request& req, httplib::Response& res) {
+        uint64_t lastSequence = 0;
+        if (req.has_header("Last-Event-ID")) {
+            try {
+                lastSequence = std::stoull(req.get_header_value("Last-Event-ID"));
+            } catch (...) {
+                lastSequence = 0;
+            }
+        }
 
-                    // Write frame footer
-                    if (!sink.write("\r\n", 2)) {
-                        return false;
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Connection", "keep-alive");
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [this, lastSequence](size_t, httplib::DataSink& sink) mutable {
+                while (running_) {
+                    auto events = eventStream_.WaitForEvents(lastSequence, std::chrono::seconds(EVENT_KEEPALIVE_SECONDS));
+                    if (eventStream_.IsClosed()) {
+                        break;
+                    }
+                    // A comment line on timeout notices clients that left
+                    std::string text = events.empty() ? std::string(":\n\n") : std::string();
+                    for (const EventStream::Event& event : events) {
+                        text += "id: " + std::to_string(event.sequence) + "\n" +
+                                "event: " + event.type + "\n" +
+                                "data: " + event.data + "\n\n";
+                        lastSequence = event.sequence;
+                    }
+                    if (!sink.write(text.data(), text.size())) {
+                        return false;  // Client disconnected
                     }
                 }
+                sink.done();
                 return true;
             }
         );
     });
 
+    if (!snapshotManager_) {
+        return;  // Tile-only server, see SetTileService
+    }
+
+    // Snapshot endpoint
+    server_->Get(R"(/snapshot/([a-f0-9\-]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string id = req.matches[1];
+
+        // Get snapshot from manager
+        auto snapshot = snapshotManager_->GetSnapshot(id);
+
+        if (!snapshot) {
+            res.status = 404;
+            res.set_content("Snapshot not found", "text/plain");
+            return;
+        }
+
+        // Snapshots never change under their id, so clients keep them for
+        // good and only ever revalidate after a forced reload
+        if (IsNotModified(req, res, "\"" + snapshot->id + "\"", "public, max-age=31536000, immutable")) {
+            return;
+        }
+
+        // Serve the image as it was encoded, straight from the cached
+        // buffer; the provider holds it even if the cache evicts it
+        std::shared_ptr<const std::vector<uint8_t>> data = snapshot->data;
+        res.set_content_provider(
+            data->size(),
+            snapshot->mimeType,
+            [data](size_t offset, size_t length, httplib::DataSink& sink) {
+                return sink.write(reinterpret_cast<const char*>(data->data()) + offset, length);
+            }
+        );
+    });
+
+    // Prometheus scrape: reads the registry's atomics, never waits for
+    // whoever records into it
+    server_->Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+        res.set_content(metrics_->Render(), Metrics::CONTENT_TYPE);
+    });
+
     // Root endpoint
     server_->Get("/", [this](const httplib::Request&, httplib::Response& res) {
         std::string html = R"(
@@ -136,6 +231,8 @@ void HTTPServer::SetupRoutes() {
         <li>GET /health - Health check</li>
         <li>GET /snapshot/{id} - Get snapshot image</li>
         <li>GET /stream?fps=N - MJPEG stream (default 5 FPS, max 30)</li>
+        <li>GET /events - Viewer events (server-sent events)</li>
+        <li>GET /metrics - Prometheus metrics</li>
     </ul>
     <p>Cached snapshots: )" + std::to_string(snapshotManager_->GetCacheSize()) + R"(</p>
 </body>
@@ -151,10 +248,10 @@ void HTTPServer::Start() {
     }
 
     running_ = true;
-    std::cout << "HTTP server starting on http://127.0.0.1:" << port_ << std::endl;
+    std::cout << "HTTP server starting on http://" << host_ << ":" << port_ << std::endl;
 
-    // Bind to localhost only for security
-    if (!server_->listen("127.0.0.1", port_)) {
+    // Localhost only unless SetHost says otherwise
+    if (!server_->listen(host_.c_str(), port_)) {
         std::cerr << "Failed to start HTTP server on port " << port_ << std::endl;
         running_ = false;
     }
@@ -166,6 +263,8 @@ void HTTPServer::Stop() {
     }
 
     running_ = false;
+    frameStream_.Close();  // Wakes /stream clients waiting for a frame
+    eventStream_.Close();  // And /events clients
     server_->stop();
     std::cout << "HTTP server stopped" << std::endl;
 }
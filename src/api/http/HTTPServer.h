@@ -1,25 +1,41 @@
 #pragma once
 
 #include "SnapshotManager.h"
+#include "FrameStream.h"
+#include "EventStream.h"
+#include "Metrics.h"
 #include <memory>
 #include <string>
 #include <atomic>
 #include <thread>
 
-// Forward declare httplib::Server
+// Forward declare httplib types
 namespace httplib {
     class Server;
+    struct Request;
+    struct Response;
 }
 
+class TileService;
+class CellTileService;
+struct EncodedTile;
+
 namespace pathview {
 namespace http {
 
 /**
- * HTTP server for serving snapshot images
+ * HTTP server for serving snapshot images, and optionally the open
+ * slide's DeepZoom / IIIF tiles (see SetTileService). Every instance
+ * streams what is published to GetFrameStream() as MJPEG at /stream, and
+ * what is published to GetEventStream() as server-sent events at /events,
+ * and GetMetrics() in the Prometheus text format at /metrics.
+ * Snapshots and tiles carry strong ETags and answer If-None-Match with 304;
+ * connections are kept alive across the many requests of a tiled view.
  * Uses cpp-httplib (header-only library)
  */
 class HTTPServer {
 public:
+    // snapshotManager may be nullptr for a tile-only server
     HTTPServer(int port, SnapshotManager* snapshotManager);
     ~HTTPServer();
 
@@ -27,6 +43,31 @@ public:
     HTTPServer(const HTTPServer&) = delete;
     HTTPServer& operator=(const HTTPServer&) = delete;
 
+    /**
+     * Serve tiles from tileService (call before Start; defined in
+     * HTTPTileRoutes.cpp, linked only into the viewer):
+     *   GET /slides                                      - Slide ids (JSON)
+     *   GET /slides/{id}/dzi                             - DeepZoom descriptor
+     *   GET /slides/{id}/tiles/{level}/{x}_{y}.{fmt}     - DeepZoom tile
+     *   GET /slides/{id}/dzi_files/{level}/{x}_{y}.{fmt} - Same, at the path
+     *                                                      OpenSeadragon derives
+     *   GET /iiif/{id}/info.json                         - IIIF image information
+     *   GET /iiif/{id}/{region}/{w},/0/default.{fmt}     - IIIF tile
+     */
+    void SetTileService(TileService* tileService);
+
+    /**
+     * Serve the loaded cell polygons as Mapbox Vector Tiles on the same
+     * grid (call before Start; defined in HTTPTileRoutes.cpp):
+     *   GET /slides/{id}/cells/{level}/{x}_{y}.mvt       - Cell vector tile
+     */
+    void SetCellTileService(CellTileService* cellTileService);
+
+    /**
+     * Address to listen on (default 127.0.0.1; call before Start)
+     */
+    void SetHost(const std::string& host) { host_ = host; }
+
     /**
      * Start the HTTP server (blocking)
      * Should be called in a separate thread
@@ -48,13 +89,56 @@ public:
      */
     int GetPort() const { return port_; }
 
+    /**
+     * Frames for GET /stream?fps=N (thread-safe; publish from anywhere)
+     */
+    FrameStream& GetFrameStream() { return frameStream_; }
+
+    /**
+     * Events for GET /events (thread-safe; publish from anywhere)
+     */
+    EventStream& GetEventStream() { return eventStream_; }
+
+    /**
+     * Series for GET /metrics (thread-safe; record from anywhere)
+     */
+    Metrics& GetMetrics() { return *metrics_; }
+
+    /**
+     * Serve another registry at /metrics instead of this server's own,
+     * e.g. one that outlives the server (call before Start)
+     */
+    void SetMetrics(Metrics* metrics) { metrics_ = metrics ? metrics : &ownMetrics_; }
+
 private:
     void SetupRoutes();
+    void SetupTileRoutes();
+
+    /**
+     * Set ETag (quoted) and Cache-Control on res; true if the request's
+     * If-None-Match already names etag, in which case res is a bodiless 304
+     */
+    static bool IsNotModified(const httplib::Request& req, httplib::Response& res,
+                              const std::string& etag, const char* cacheControl);
+    static void SendTile(const EncodedTile& tile, const httplib::Request& req, httplib::Response& res,
+                         const char* cacheControl = "public, max-age=86400");
 
     std::unique_ptr<httplib::Server> server_;
     SnapshotManager* snapshotManager_;
+    TileService* tileService_ = nullptr;
+    CellTileService* cellTileService_ = nullptr;
+    FrameStream frameStream_;
+    EventStream eventStream_;
+    Metrics ownMetrics_;
+    Metrics* metrics_ = &ownMetrics_;
+    std::string host_ = "127.0.0.1";
     int port_;
     std::atomic<bool> running_;
+
+    static constexpr int EVENT_KEEPALIVE_SECONDS = 15;
+    // A viewer loads dozens of tiles per pan over a handful of connections
+    static constexpr size_t KEEP_ALIVE_MAX_REQUESTS = 1000;
+    static constexpr int KEEP_ALIVE_TIMEOUT_SECONDS = 30;
 };
 
 } // namespace http
@@ -0,0 +1,187 @@
+// Tile routes of HTTPServer, in their own translation unit so that only
+// binaries serving tiles (the viewer) link TileService and the pipeline
+// behind it
+#include "HTTPServer.h"
+#include "CellTileService.h"
+#include "TileService.h"
+#include "httplib.h"  // From cpp-mcp/common/httplib.h
+#include <limits>
+#include <sstream>
+
+namespace pathview {
+namespace http {
+
+namespace {
+
+// Past any slide's tile grid or pixel size; keeps the services' index
+// arithmetic far from overflow
+constexpr int64_t MAX_PATH_NUMBER = std::numeric_limits<int32_t>::max();
+
+// Parse a URL path number in 0..maxValue, rejecting overflow
+bool ParseNumber(const std::string& text, int64_t& value, int64_t maxValue = MAX_PATH_NUMBER) {
+    try {
+        size_t used = 0;
+        value = std::stoll(text, &used);
+        return used == text.size() && value >= 0 && value <= maxValue;
+    } catch (...) {
+        return false;
+    }
+}
+
+void SetTileStatus(TileServiceStatus status, httplib::Response& res) {
+    if (status == TileServiceStatus::NotFound) {
+        res.status = 404;
+        res.set_content("Tile not found", "text/plain");
+    } else {
+        res.status = 503;
+        res.set_header("Retry-After", "1");
+        res.set_content("Tile not available yet", "text/plain");
+    }
+}
+
+}  // namespace
+
+// Send an encoded tile, or 304 if the client already has it
+void HTTPServer::SendTile(const EncodedTile& tile, const httplib::Request& req, httplib::Response& res,
+                          const char* cacheControl) {
+    if (IsNotModified(req, res, tile.etag, cacheControl)) {
+        return;
+    }
+    res.set_content(reinterpret_cast<const char*>(tile.data->data()), tile.data->size(), tile.mimeType);
+}
+
+void HTTPServer::SetTileService(TileService* tileService) {
+    if (tileService_ || !tileService) {
+        return;
+    }
+    tileService_ = tileService;
+    SetupTileRoutes();
+}
+
+void HTTPServer::SetCellTileService(CellTileService* cellTileService) {
+    if (cellTileService_ || !cellTileService) {
+        return;
+    }
+    cellTileService_ = cellTileService;
+    server_->set_default_headers({{"Access-Control-Allow-Origin", "*"}});
+
+    server_->Get(R"(/slides/([0-9a-f]+)/cells/(\d+)/(\d+)_(\d+)\.mvt)",
+                 [this](const httplib::Request& req, httplib::Response& res) {
+        int64_t level = 0;
+        int64_t column = 0;
+        int64_t row = 0;
+        if (!ParseNumber(req.matches[2], level, 62) || !ParseNumber(req.matches[3], column) ||
+            !ParseNumber(req.matches[4], row)) {
+            SetTileStatus(TileServiceStatus::NotFound, res);
+            return;
+        }
+        EncodedTile tile;
+        TileServiceStatus status = cellTileService_->GetTile(req.matches[1], static_cast<int32_t>(level),
+                                                             column, row, tile);
+        if (status != TileServiceStatus::Ok) {
+            SetTileStatus(status, res);
+            return;
+        }
+        // Loading other polygons changes the tile: revalidate every time
+        SendTile(tile, req, res, "no-cache");
+    });
+}
+
+void HTTPServer::SetupTileRoutes() {
+    // Browser viewers load tiles cross-origin
+    server_->set_default_headers({{"Access-Control-Allow-Origin", "*"}});
+
+    server_->Get("/slides", [this](const httplib::Request&, httplib::Response& res) {
+        std::ostringstream json;
+        json << "[";
+        auto ids = tileService_->GetSlideIds();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            json << (i ? "," : "") << "\"" << ids[i] << "\"";
+        }
+        json << "]";
+        res.set_content(json.str(), "application/json");
+    });
+
+    server_->Get(R"(/slides/([0-9a-f]+)/dzi)", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string xml;
+        if (tileService_->GetDzi(req.matches[1], xml) != TileServiceStatus::Ok) {
+            res.status = 404;
+            res.set_content("Slide not found", "text/plain");
+            return;
+        }
+        res.set_content(xml, "application/xml");
+    });
+
+    server_->Get(R"(/slides/([0-9a-f]+)/(?:tiles|dzi_files)/(\d+)/(\d+)_(\d+)\.(jpg|png))",
+                 [this](const httplib::Request& req, httplib::Response& res) {
+        int64_t level = 0;
+        int64_t column = 0;
+        int64_t row = 0;
+        if (!ParseNumber(req.matches[2], level, 62) || !ParseNumber(req.matches[3], column) ||
+            !ParseNumber(req.matches[4], row) || req.matches[5] != TileService::GetTileFormat()) {
+            SetTileStatus(TileServiceStatus::NotFound, res);
+            return;
+        }
+        EncodedTile tile;
+        TileServiceStatus status = tileService_->GetTile(req.matches[1], static_cast<int32_t>(level),
+                                                         column, row, tile);
+        if (status != TileServiceStatus::Ok) {
+            SetTileStatus(status, res);
+            return;
+        }
+        SendTile(tile, req, res);
+    });
+
+    server_->Get(R"(/iiif/([0-9a-f]+)/info\.json)", [this](const httplib::Request& req, httplib::Response& res) {
+        std::string id = req.matches[1];
+        std::string host = req.get_header_value("Host");
+        if (host.empty()) {
+            host = host_ + ":" + std::to_string(port_);
+        }
+        std::string json;
+        if (tileService_->GetIiifInfo(id, "http://" + host + "/iiif/" + id, json) != TileServiceStatus::Ok) {
+            res.status = 404;
+            res.set_content("Slide not found", "text/plain");
+            return;
+        }
+        res.set_content(json, "application/json");
+    });
+
+    // Region is "full" or x,y,w,h; size is "w," or "full" / "max"
+    server_->Get(R"(/iiif/([0-9a-f]+)/(full|\d+,\d+,\d+,\d+)/(full|max|\d+,)/0/default\.(jpg|png))",
+                 [this](const httplib::Request& req, httplib::Response& res) {
+        int64_t region[4] = {0, 0, 0, 0};  // Zero: the full image
+        std::string regionText = req.matches[2];
+        if (regionText != "full") {
+            std::istringstream parts(regionText);
+            std::string part;
+            for (int i = 0; i < 4 && std::getline(parts, part, ','); ++i) {
+                if (!ParseNumber(part, region[i])) {
+                    SetTileStatus(TileServiceStatus::NotFound, res);
+                    return;
+                }
+            }
+        }
+        int64_t sizeWidth = 0;  // Zero: unscaled
+        std::string sizeText = req.matches[3];
+        if (sizeText.back() == ',' && !ParseNumber(sizeText.substr(0, sizeText.size() - 1), sizeWidth)) {
+            SetTileStatus(TileServiceStatus::NotFound, res);
+            return;
+        }
+        if (req.matches[4] != TileService::GetTileFormat()) {
+            SetTileStatus(TileServiceStatus::NotFound, res);
+            return;
+        }
+        EncodedTile tile;
+        TileServiceStatus status = tileService_->GetIiifTile(req.matches[1], region[0], region[1], region[2],
+                                                             region[3], sizeWidth, tile);
+        if (status != TileServiceStatus::Ok) {
+            SetTileStatus(status, res);
+            return;
+        }
+        SendTile(tile, req, res);
+    });
+}
+
+} // namespace http
+} // namespace pathview
@@ -0,0 +1,207 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+namespace pathview {
+namespace http {
+
+namespace {
+
+// Label values and help text escape backslashes, quotes and newlines
+std::string Escape(const std::string& text, bool quotes) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '"' && quotes) {
+            escaped += "\\\"";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string FormatValue(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
+
+const char* TypeName(Metrics::Type type) {
+    switch (type) {
+        case Metrics::Type::Counter: return "counter";
+        case Metrics::Type::Histogram: return "histogram";
+        case Metrics::Type::Gauge: break;
+    }
+    return "gauge";
+}
+
+void AddTo(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+Metrics::Series::Series(std::string name, std::string help, Type type, std::string label,
+                        std::vector<double> bounds)
+    : name_(std::move(name)), help_(std::move(help)), type_(type), label_(std::move(label)),
+      bounds_(std::move(bounds)) {
+    if (type_ == Type::Histogram) {
+        buckets_ = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Metrics::Series::Add(double value) {
+    AddTo(value_, value);
+}
+
+void Metrics::Series::Observe(double value) {
+    if (!buckets_) {
+        return;
+    }
+    const size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    AddTo(value_, value);
+}
+
+void Metrics::Series::SetBuckets(const std::vector<uint64_t>& counts, double sum) {
+    if (!buckets_) {
+        return;
+    }
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        buckets_[i].store(i < counts.size() ? counts[i] : 0, std::memory_order_relaxed);
+    }
+    value_.store(sum, std::memory_order_relaxed);
+}
+
+Metrics::~Metrics() {
+    Series* series = head_.load();
+    while (series) {
+        Series* next = series->next_;
+        delete series;
+        series = next;
+    }
+}
+
+Metrics::Series& Metrics::Counter(const std::string& name, const std::string& help,
+                                  const std::string& labelName, const std::string& labelValue) {
+    return Find(name, help, Type::Counter, {}, labelName, labelValue);
+}
+
+Metrics::Series& Metrics::Gauge(const std::string& name, const std::string& help,
+                                const std::string& labelName, const std::string& labelValue) {
+    return Find(name, help, Type::Gauge, {}, labelName, labelValue);
+}
+
+Metrics::Series& Metrics::Histogram(const std::string& name, const std::string& help,
+                                    const std::vector<double>& bounds,
+                                    const std::string& labelName, const std::string& labelValue) {
+    return Find(name, help, Type::Histogram, bounds, labelName, labelValue);
+}
+
+Metrics::Series& Metrics::Find(const std::string& name, const std::string& help, Type type,
+                               const std::vector<double>& bounds,
+                               const std::string& labelName, const std::string& labelValue) {
+    const std::string label = labelName.empty() ? std::string()
+                                                : labelName + "=\"" + Escape(labelValue, true) + "\"";
+    auto find = [&](Series* from, Series* until) -> Series* {
+        for (Series* series = from; series != until; series = series->next_) {
+            if (series->name_ == name && series->label_ == label) {
+                return series;
+            }
+        }
+        return nullptr;
+    };
+
+    Series* head = head_.load(std::memory_order_acquire);
+    if (Series* found = find(head, nullptr)) {
+        return *found;
+    }
+
+    // Push a new one; if another thread pushed meanwhile, it may have
+    // added this very series
+    Series* created = new Series(name, help, type, label, bounds);
+    created->next_ = head;
+    while (!head_.compare_exchange_weak(created->next_, created, std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+        if (Series* found = find(created->next_, head)) {
+            delete created;
+            return *found;
+        }
+        head = created->next_;
+    }
+    return *created;
+}
+
+void Metrics::SetForwarded(std::string text) {
+    std::lock_guard<std::mutex> lock(forwardedMutex_);
+    forwarded_ = std::move(text);
+}
+
+std::string Metrics::Render() const {
+    // Oldest first, grouped by name for one HELP / TYPE each
+    std::vector<const Series*> all;
+    for (const Series* series = head_.load(std::memory_order_acquire); series; series = series->next_) {
+        all.push_back(series);
+    }
+    std::reverse(all.begin(), all.end());
+    std::map<std::string, size_t> firstSeen;
+    for (const Series* series : all) {
+        firstSeen.try_emplace(series->name_, firstSeen.size());
+    }
+    std::stable_sort(all.begin(), all.end(), [&](const Series* a, const Series* b) {
+        return firstSeen[a->name_] < firstSeen[b->name_];
+    });
+
+    std::string text;
+    const std::string* previous = nullptr;
+    for (const Series* series : all) {
+        if (!previous || *previous != series->name_) {
+            text += "# HELP " + series->name_ + " " + Escape(series->help_, false) + "\n";
+            text += "# TYPE " + series->name_ + " " + TypeName(series->type_) + "\n";
+            previous = &series->name_;
+        }
+        const std::string labels = series->label_.empty() ? std::string() : "{" + series->label_ + "}";
+        if (series->type_ != Type::Histogram) {
+            text += series->name_ + labels + " " + FormatValue(series->Get()) + "\n";
+            continue;
+        }
+
+        const std::string prefix = series->label_.empty() ? std::string() : series->label_ + ",";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i <= series->bounds_.size(); ++i) {
+            cumulative += series->buckets_[i].load(std::memory_order_relaxed);
+            const std::string bound = i < series->bounds_.size() ? FormatValue(series->bounds_[i]) : "+Inf";
+            text += series->name_ + "_bucket{" + prefix + "le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        text += series->name_ + "_sum" + labels + " " + FormatValue(series->Get()) + "\n";
+        text += series->name_ + "_count" + labels + " " + std::to_string(cumulative) + "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(forwardedMutex_);
+    return text + forwarded_;
+}
+
+const std::vector<double>& Metrics::LatencyBounds() {
+    static const std::vector<double> bounds = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                               0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+    return bounds;
+}
+
+const std::vector<double>& Metrics::FrameBounds() {
+    static const std::vector<double> bounds = {0.002, 0.004, 0.008, 0.012, 0.0167, 0.025,
+                                               0.0333, 0.05, 0.1, 0.25};
+    return bounds;
+}
+
+} // namespace http
+} // namespace pathview
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace http {
+
+/**
+ * Counters, gauges and histograms for GET /metrics (Prometheus text format)
+ *
+ * Each series is created on first use and lives as long as the registry,
+ * in a list new series are pushed onto with a compare-and-swap, so
+ * looking one up, updating it and rendering the lot never take a lock:
+ * the render thread records into it and a scrape only reads atomics.
+ * Series are named by metric and at most one label ("method", "stage").
+ * Text forwarded from another process (SetForwarded()) is appended as it
+ * is.
+ */
+class Metrics {
+public:
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    class Series {
+    public:
+        // Counter: add (values only grow); Gauge: set
+        void Add(double value);
+        void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+        double Get() const { return value_.load(std::memory_order_relaxed); }
+
+        // Histogram: one sample
+        void Observe(double value);
+
+        /**
+         * Histogram: replace every bucket at once, from a histogram kept
+         * elsewhere
+         * @param counts Samples per bucket (not cumulative), one per bound
+         *        and one above the last
+         */
+        void SetBuckets(const std::vector<uint64_t>& counts, double sum);
+
+        const std::vector<double>& GetBounds() const { return bounds_; }
+
+    private:
+        friend class Metrics;
+        Series(std::string name, std::string help, Type type, std::string label, std::vector<double> bounds);
+
+        const std::string name_;
+        const std::string help_;
+        const Type type_;
+        const std::string label_;  // name="value", or empty
+        const std::vector<double> bounds_;
+        std::atomic<double> value_{0.0};  // Counter or gauge value; histogram sum
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets_;  // bounds_.size() + 1
+        Series* next_ = nullptr;
+    };
+
+    Metrics() = default;
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * The series of name (and label), created if new (thread-safe); the
+     * same name always needs the same help, type and bounds
+     */
+    Series& Counter(const std::string& name, const std::string& help,
+                    const std::string& labelName = "", const std::string& labelValue = "");
+    Series& Gauge(const std::string& name, const std::string& help,
+                  const std::string& labelName = "", const std::string& labelValue = "");
+    Series& Histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                      const std::string& labelName = "", const std::string& labelValue = "");
+
+    /**
+     * Text another process rendered, served after this registry's series
+     */
+    void SetForwarded(std::string text);
+
+    /**
+     * Every series in the Prometheus text exposition format (version 0.0.4)
+     */
+    std::string Render() const;
+
+    // Upper bounds in seconds for request, encode and tile stage latencies
+    static const std::vector<double>& LatencyBounds();
+    // Upper bounds in seconds for frame times, around 60 Hz
+    static const std::vector<double>& FrameBounds();
+
+    static constexpr const char* CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+private:
+    Series& Find(const std::string& name, const std::string& help, Type type, const std::vector<double>& bounds,
+                 const std::string& labelName, const std::string& labelValue);
+
+    std::atomic<Series*> head_{nullptr};
+    mutable std::mutex forwardedMutex_;  // Never held by a recording thread
+    std::string forwarded_;
+};
+
+} // namespace http
+} // namespace pathview
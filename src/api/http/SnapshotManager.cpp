@@ -7,8 +7,10 @@
 namespace pathview {
 namespace http {
 
-SnapshotManager::SnapshotManager(size_t maxSnapshots, std::chrono::milliseconds cleanupInterval)
+SnapshotManager::SnapshotManager(size_t maxSnapshots, std::chrono::milliseconds cleanupInterval,
+                                 size_t maxBytes)
     : maxSnapshots_(maxSnapshots)
+    , maxBytes_(maxBytes)
     , cleanupInterval_(cleanupInterval)
 {
     // Start cleanup thread
@@ -39,49 +41,71 @@ SnapshotManager::~SnapshotManager() {
     }
 }
 
-std::string SnapshotManager::AddSnapshot(const std::vector<uint8_t>& pngData, int width, int height) {
+std::string SnapshotManager::AddSnapshot(std::vector<uint8_t> pngData, int width, int height,
+                                         std::string mimeType, const std::string& contentKey) {
+    return AddSnapshot(std::make_shared<const std::vector<uint8_t>>(std::move(pngData)), width, height,
+                       std::move(mimeType), contentKey);
+}
+
+std::string SnapshotManager::AddSnapshot(std::shared_ptr<const std::vector<uint8_t>> data, int width,
+                                         int height, std::string mimeType, const std::string& contentKey) {
+    if (!data) {
+        data = std::make_shared<const std::vector<uint8_t>>();
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    // Generate UUID
-    std::string id = GenerateUUID();
+    // The same content already stored: hand its ID out again, fresh
+    std::string id;
+    if (!contentKey.empty()) {
+        auto it = cache_.find(contentKey);
+        if (it != cache_.end()) {
+            it->second.lastAccess = std::chrono::steady_clock::now();
+            lruList_.splice(lruList_.begin(), lruList_, it->second.lruPosition);
+            return contentKey;
+        }
+        id = contentKey;
+    } else {
+        id = GenerateUUID();
+    }
 
-    // Evict oldest if cache is full
-    while (cache_.size() >= maxSnapshots_) {
+    // Evict least recently used until the new one fits
+    const size_t size = data->size();
+    while (!cache_.empty() && (cache_.size() >= maxSnapshots_ || bytes_ + size > maxBytes_)) {
         EvictOldest();
     }
 
     // Create snapshot
-    Snapshot snapshot{
-        id,
-        pngData,
-        width,
-        height,
-        std::chrono::steady_clock::now()
-    };
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->id = id;
+    snapshot->data = std::move(data);
+    snapshot->width = width;
+    snapshot->height = height;
+    snapshot->mimeType = std::move(mimeType);
 
     // Add to cache and LRU list
-    cache_[id] = std::move(snapshot);
     lruList_.push_front(id);
+    cache_[id] = Entry{std::move(snapshot), std::chrono::steady_clock::now(), lruList_.begin()};
+    bytes_ += size;
 
     return id;
 }
 
-std::optional<SnapshotManager::Snapshot> SnapshotManager::GetSnapshot(const std::string& id) {
+std::shared_ptr<const SnapshotManager::Snapshot> SnapshotManager::GetSnapshot(const std::string& id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     auto it = cache_.find(id);
     if (it == cache_.end()) {
-        return std::nullopt;
+        return nullptr;
     }
 
     // Update last access time
     it->second.lastAccess = std::chrono::steady_clock::now();
 
     // Move to front of LRU list
-    lruList_.remove(id);
-    lruList_.push_front(id);
+    lruList_.splice(lruList_.begin(), lruList_, it->second.lruPosition);
 
-    return it->second;
+    return it->second.snapshot;
 }
 
 void SnapshotManager::Cleanup() {
@@ -89,16 +113,14 @@ void SnapshotManager::Cleanup() {
 
     auto now = std::chrono::steady_clock::now();
 
-    // Remove expired snapshots
-    auto it = cache_.begin();
-    while (it != cache_.end()) {
+    // Remove expired snapshots, oldest first
+    while (!lruList_.empty()) {
+        auto it = cache_.find(lruList_.back());
         auto age = std::chrono::duration_cast<std::chrono::hours>(now - it->second.lastAccess);
-        if (age >= TTL) {
-            lruList_.remove(it->first);
-            it = cache_.erase(it);
-        } else {
-            ++it;
+        if (age < TTL) {
+            break;
         }
+        Erase(it);
     }
 }
 
@@ -107,15 +129,24 @@ size_t SnapshotManager::GetCacheSize() const {
     return cache_.size();
 }
 
+size_t SnapshotManager::GetMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
 void SnapshotManager::EvictOldest() {
     if (lruList_.empty()) {
         return;
     }
 
     // Remove oldest (back of list)
-    std::string oldestId = lruList_.back();
-    lruList_.pop_back();
-    cache_.erase(oldestId);
+    Erase(cache_.find(lruList_.back()));
+}
+
+void SnapshotManager::Erase(std::unordered_map<std::string, Entry>::iterator it) {
+    bytes_ -= it->second.snapshot->data->size();
+    lruList_.erase(it->second.lruPosition);
+    cache_.erase(it);
 }
 
 std::string SnapshotManager::GenerateUUID() {
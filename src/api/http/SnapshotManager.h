@@ -2,12 +2,12 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <list>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <chrono>
-#include <optional>
 #include <thread>
 #include <atomic>
 #include <condition_variable>
@@ -17,37 +17,58 @@ namespace http {
 
 /**
  * Manages snapshot images with LRU caching
+ *
+ * Bounded by total encoded bytes as well as by count: the least recently
+ * used snapshots go once either limit is reached (the newest is kept even
+ * if it alone is over the byte budget). Snapshots are immutable and
+ * handed out shared, so serving one copies nothing and an evicted
+ * snapshot stays valid for a response still sending it.
  */
 class SnapshotManager {
 public:
     struct Snapshot {
         std::string id;
-        std::vector<uint8_t> pngData;
+        // Encoded image, PNG unless mimeType says otherwise
+        std::shared_ptr<const std::vector<uint8_t>> data;
         int width;
         int height;
-        std::chrono::steady_clock::time_point lastAccess;
+        std::string mimeType = "image/png";
     };
 
+    static constexpr size_t DEFAULT_MAX_BYTES = 256 * 1024 * 1024;
+
     explicit SnapshotManager(size_t maxSnapshots = 50,
-                             std::chrono::milliseconds cleanupInterval = std::chrono::seconds(30));
+                             std::chrono::milliseconds cleanupInterval = std::chrono::seconds(30),
+                             size_t maxBytes = DEFAULT_MAX_BYTES);
     ~SnapshotManager();
 
     /**
      * Add a new snapshot and generate UUID
-     * @param pngData PNG-encoded image data
+     * @param pngData Encoded image data (taken by value: move it in)
      * @param width Image width
      * @param height Image height
-     * @return Generated UUID for the snapshot
+     * @param mimeType Content type the image is served with
+     * @param contentKey Hash of the image's content (the encoder's
+     *        "content_hash"): used as the ID, and when a snapshot with it
+     *        is cached that one is kept and data dropped. Empty: a new UUID.
+     * @return ID of the snapshot
+     */
+    std::string AddSnapshot(std::vector<uint8_t> pngData, int width, int height,
+                            std::string mimeType = "image/png", const std::string& contentKey = "");
+
+    /**
+     * Add an encoded image already shared with another consumer
      */
-    std::string AddSnapshot(const std::vector<uint8_t>& pngData, int width, int height);
+    std::string AddSnapshot(std::shared_ptr<const std::vector<uint8_t>> data, int width, int height,
+                            std::string mimeType = "image/png", const std::string& contentKey = "");
 
     /**
      * Get snapshot by ID
      * Updates last access time for LRU
      * @param id Snapshot UUID
-     * @return Snapshot if found, nullopt otherwise
+     * @return Snapshot if found, nullptr otherwise
      */
-    std::optional<Snapshot> GetSnapshot(const std::string& id);
+    std::shared_ptr<const Snapshot> GetSnapshot(const std::string& id);
 
     /**
      * Remove expired snapshots (older than TTL)
@@ -59,6 +80,11 @@ public:
      */
     size_t GetCacheSize() const;
 
+    /**
+     * Get the encoded bytes of the cached snapshots
+     */
+    size_t GetMemoryUsage() const;
+
     /**
      * Add snapshot ID to stream buffer
      * Used for MJPEG streaming - maintains circular buffer of recent frames
@@ -76,11 +102,20 @@ private:
     void EvictOldest();
     std::string GenerateUUID();
 
-    std::map<std::string, Snapshot> cache_;
+    struct Entry {
+        std::shared_ptr<const Snapshot> snapshot;
+        std::chrono::steady_clock::time_point lastAccess;
+        std::list<std::string>::iterator lruPosition;
+    };
+    void Erase(std::unordered_map<std::string, Entry>::iterator it);
+
+    std::unordered_map<std::string, Entry> cache_;
     std::list<std::string> lruList_;  // Most recent at front
     mutable std::mutex mutex_;
 
     size_t maxSnapshots_;
+    size_t maxBytes_;
+    size_t bytes_ = 0;
     static constexpr std::chrono::hours TTL{1};  // 1 hour TTL
 
     // Stream buffer (separate from LRU cache)
@@ -0,0 +1,76 @@
+#include "CommandExecutor.h"
+
+namespace pathview {
+namespace ipc {
+
+CommandExecutor::CommandExecutor(size_t threadCount, std::function<void()> onComplete)
+    : onComplete_(std::move(onComplete))
+{
+    if (threadCount == 0) {
+        threadCount = DEFAULT_THREADS;
+    }
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&CommandExecutor::WorkerLoop, this);
+    }
+}
+
+CommandExecutor::~CommandExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    workAvailable_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+std::future<json> CommandExecutor::Submit(Job job) {
+    std::packaged_task<json()> task(std::move(job));
+    std::future<json> result = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(task));
+    }
+    workAvailable_.notify_one();
+    return result;
+}
+
+void CommandExecutor::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return queue_.empty() && running_ == 0; });
+}
+
+void CommandExecutor::WorkerLoop() {
+    while (true) {
+        std::packaged_task<json()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            ++running_;
+        }
+
+        task();  // Exceptions are stored in the future
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
+        }
+        idle_.notify_all();
+        if (onComplete_) {
+            onComplete_();
+        }
+    }
+}
+
+} // namespace ipc
+} // namespace pathview
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "IPCMessage.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pathview {
+namespace ipc {
+
+/**
+ * Worker threads for IPC commands too slow for the GUI thread
+ *
+ * The command handler still runs on the GUI thread: it validates the
+ * request, copies what the job needs (pixels, vertices, pointers to data
+ * that stays put while jobs run) and submits the rest here, handing the
+ * future to IPCServer::Defer(). Jobs must not touch state the GUI thread
+ * changes; the owner calls WaitIdle() before changing data jobs read.
+ */
+class CommandExecutor {
+public:
+    using Job = std::function<json()>;
+
+    /**
+     * @param threadCount Worker threads (0: DEFAULT_THREADS)
+     * @param onComplete Runs on the worker after each job, e.g. to wake the
+     *        GUI loop so the response goes out without waiting for input
+     */
+    explicit CommandExecutor(size_t threadCount = 0, std::function<void()> onComplete = nullptr);
+    ~CommandExecutor();
+
+    CommandExecutor(const CommandExecutor&) = delete;
+    CommandExecutor& operator=(const CommandExecutor&) = delete;
+
+    /**
+     * Queue a job
+     * @return Its result, or the exception it threw. Jobs still queued when
+     *         the executor is destroyed are dropped (broken promise).
+     */
+    std::future<json> Submit(Job job);
+
+    // Block until every submitted job has finished
+    void WaitIdle();
+
+    size_t GetThreadCount() const { return workers_.size(); }
+
+    // Encoding and counting jobs are short; a couple of threads keep one
+    // client's snapshot from queueing behind another's metrics
+    static constexpr size_t DEFAULT_THREADS = 2;
+
+private:
+    void WorkerLoop();
+
+    std::function<void()> onComplete_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable idle_;
+    std::deque<std::packaged_task<json()>> queue_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace ipc
+} // namespace pathview
@@ -0,0 +1,114 @@
+#include "EventSubscriptions.h"
+
+namespace pathview {
+namespace ipc {
+
+const char* EventTypeName(EventType type) {
+    switch (type) {
+        case EventType::Viewport: return "viewport";
+        case EventType::TilesSettled: return "tiles_settled";
+        case EventType::Annotations: return "annotations";
+        case EventType::Metrics: return "metrics";
+    }
+    return "";
+}
+
+std::optional<EventType> ParseEventType(const std::string& name) {
+    for (size_t i = 0; i < EVENT_TYPE_COUNT; ++i) {
+        EventType type = static_cast<EventType>(i);
+        if (name == EventTypeName(type)) {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+void EventSubscriptions::Subscribe(socket_t clientFd, const std::vector<EventType>& types,
+                                   std::chrono::milliseconds minInterval) {
+    Subscriber& subscriber = subscribers_[clientFd];
+    subscriber.minInterval = minInterval;
+    for (EventType type : types) {
+        subscriber.subscribed[static_cast<size_t>(type)] = true;
+    }
+}
+
+void EventSubscriptions::Unsubscribe(socket_t clientFd, const std::vector<EventType>& types) {
+    auto it = subscribers_.find(clientFd);
+    if (it == subscribers_.end()) {
+        return;
+    }
+    Subscriber& subscriber = it->second;
+    for (EventType type : types) {
+        subscriber.subscribed[static_cast<size_t>(type)] = false;
+        subscriber.pending[static_cast<size_t>(type)].reset();
+    }
+    bool any = false;
+    for (bool subscribed : subscriber.subscribed) {
+        any = any || subscribed;
+    }
+    if (types.empty() || !any) {
+        subscribers_.erase(it);
+    }
+}
+
+void EventSubscriptions::RemoveClient(socket_t clientFd) {
+    subscribers_.erase(clientFd);
+}
+
+bool EventSubscriptions::HasSubscribers(EventType type) const {
+    for (const auto& [clientFd, subscriber] : subscribers_) {
+        if (subscriber.subscribed[static_cast<size_t>(type)]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EventSubscriptions::IsSubscribed(socket_t clientFd, EventType type) const {
+    auto it = subscribers_.find(clientFd);
+    return it != subscribers_.end() && it->second.subscribed[static_cast<size_t>(type)];
+}
+
+void EventSubscriptions::Post(EventType type, const json& payload) {
+    const size_t index = static_cast<size_t>(type);
+    for (auto& [clientFd, subscriber] : subscribers_) {
+        if (subscriber.subscribed[index]) {
+            subscriber.pending[index] = payload;
+        }
+    }
+}
+
+std::vector<EventSubscriptions::Event> EventSubscriptions::TakeDue(Clock::time_point now) {
+    std::vector<Event> due;
+    for (auto& [clientFd, subscriber] : subscribers_) {
+        for (size_t i = 0; i < EVENT_TYPE_COUNT; ++i) {
+            std::optional<json>& pending = subscriber.pending[i];
+            if (!pending || now < subscriber.lastSent[i] + subscriber.minInterval) {
+                continue;
+            }
+            due.push_back({clientFd, static_cast<EventType>(i), std::move(*pending)});
+            pending.reset();
+            subscriber.lastSent[i] = now;
+        }
+    }
+    return due;
+}
+
+std::optional<EventSubscriptions::Clock::time_point> EventSubscriptions::NextDue() const {
+    std::optional<Clock::time_point> next;
+    for (const auto& [clientFd, subscriber] : subscribers_) {
+        for (size_t i = 0; i < EVENT_TYPE_COUNT; ++i) {
+            if (!subscriber.pending[i]) {
+                continue;
+            }
+            Clock::time_point due = subscriber.lastSent[i] + subscriber.minInterval;
+            if (!next || due < *next) {
+                next = due;
+            }
+        }
+    }
+    return next;
+}
+
+} // namespace ipc
+} // namespace pathview
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "IPCMessage.h"
+#include "SocketPoller.h"  // socket_t
+#include <array>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace ipc {
+
+/**
+ * Viewer events an IPC client can subscribe to instead of polling
+ */
+enum class EventType {
+    Viewport,      // Position or zoom changed
+    TilesSettled,  // Every visible tile is at full resolution
+    Annotations,   // Annotation created, deleted or renamed
+    Metrics        // Prometheus text of the viewer's metrics, every second
+};
+
+constexpr size_t EVENT_TYPE_COUNT = 4;
+
+/**
+ * Name on the wire ("viewport", "tiles_settled", "annotations",
+ * "metrics"); the
+ * notification method is "event." followed by it
+ */
+const char* EventTypeName(EventType type);
+std::optional<EventType> ParseEventType(const std::string& name);
+
+/**
+ * Which clients want which events, and the events waiting to be sent
+ *
+ * Events are coalesced: each subscriber holds only the latest payload of
+ * each type, sent once minInterval has passed since its last one of that
+ * type, so a pan produces a few viewport events rather than one a frame.
+ * Used on the GUI thread only.
+ */
+class EventSubscriptions {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        socket_t clientFd;
+        EventType type;
+        json payload;
+    };
+
+    /**
+     * Add types to a client's subscription (a repeat replaces minInterval)
+     */
+    void Subscribe(socket_t clientFd, const std::vector<EventType>& types,
+                   std::chrono::milliseconds minInterval);
+
+    /**
+     * Drop types from a client's subscription; all of them if types is empty
+     */
+    void Unsubscribe(socket_t clientFd, const std::vector<EventType>& types);
+
+    /**
+     * Forget a client that disconnected
+     */
+    void RemoveClient(socket_t clientFd);
+
+    bool HasSubscribers(EventType type) const;
+    bool IsSubscribed(socket_t clientFd, EventType type) const;
+
+    /**
+     * Queue an event for every subscriber, replacing one not yet sent
+     */
+    void Post(EventType type, const json& payload);
+
+    /**
+     * Remove and return the events whose subscriber's minInterval has passed
+     */
+    std::vector<Event> TakeDue(Clock::time_point now);
+
+    /**
+     * When the earliest queued event falls due (nullopt: none queued)
+     */
+    std::optional<Clock::time_point> NextDue() const;
+
+    static constexpr std::chrono::milliseconds DEFAULT_MIN_INTERVAL{100};
+
+private:
+    struct Subscriber {
+        std::chrono::milliseconds minInterval{DEFAULT_MIN_INTERVAL};
+        std::array<bool, EVENT_TYPE_COUNT> subscribed{};
+        std::array<std::optional<json>, EVENT_TYPE_COUNT> pending;
+        std::array<Clock::time_point, EVENT_TYPE_COUNT> lastSent{};
+    };
+
+    std::map<socket_t, Subscriber> subscribers_;
+};
+
+} // namespace ipc
+} // namespace pathview
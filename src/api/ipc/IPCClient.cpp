@@ -5,11 +5,15 @@
 #include <chrono>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstdint>
 
 #ifdef _WIN32
     #pragma comment(lib, "ws2_32.lib")
+    #include <afunix.h>
 #else
     #include <sys/socket.h>
+    #include <sys/un.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <sys/select.h>
@@ -88,9 +92,34 @@ int IPCClient::ReadPortFromFile() {
     return 9999;  // Default port
 }
 
+std::string IPCClient::ReadSocketPathFromFile() {
+    std::string path;
+#ifdef _WIN32
+    const char* temp = std::getenv("TEMP");
+    if (!temp) temp = std::getenv("TMP");
+    if (!temp) temp = ".";
+    path = std::string(temp) + "\\pathview-socket.txt";
+#else
+    path = "/tmp/pathview-socket";
+#endif
+
+    std::ifstream file(path);
+    std::string socketPath;
+    if (file.is_open()) {
+        std::getline(file, socketPath);
+    }
+    return socketPath;
+}
+
 IPCClient::IPCClient(int port)
     : port_(port)
-    , clientFd_(INVALID_SOCKET_VALUE)
+    , nextId_(1)
+{
+}
+
+IPCClient::IPCClient(const std::string& socketPath)
+    : port_(0)
+    , socketPath_(socketPath)
     , nextId_(1)
 {
 }
@@ -99,22 +128,33 @@ IPCClient::~IPCClient() {
     Disconnect();
 }
 
-bool IPCClient::Connect() {
-    if (clientFd_ != INVALID_SOCKET_VALUE) {
-        return true;  // Already connected
-    }
-
-#ifdef _WIN32
-    if (!InitializeWinsock()) {
-        return false;
+socket_t IPCClient::OpenSocket() {
+    if (!socketPath_.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socketPath_.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "IPC socket path too long: " << socketPath_ << std::endl;
+            return INVALID_SOCKET_VALUE;
+        }
+        std::memcpy(addr.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+        socket_t fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == INVALID_SOCKET_VALUE ||
+            connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::cerr << "Failed to connect to " << socketPath_ << ": " << GetLastErrorString() << std::endl;
+            if (fd != INVALID_SOCKET_VALUE) {
+                CloseSocket(fd);
+            }
+            return INVALID_SOCKET_VALUE;
+        }
+        return fd;
     }
-#endif
 
     // Create TCP socket
-    clientFd_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (clientFd_ == INVALID_SOCKET_VALUE) {
+    socket_t fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd == INVALID_SOCKET_VALUE) {
         std::cerr << "Failed to create socket: " << GetLastErrorString() << std::endl;
-        return false;
+        return INVALID_SOCKET_VALUE;
     }
 
     // Prepare address (localhost)
@@ -124,61 +164,220 @@ bool IPCClient::Connect() {
     addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // 127.0.0.1
 
     // Connect to server
-    if (connect(clientFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
         std::cerr << "Failed to connect to localhost:" << port_ << ": " 
                   << GetLastErrorString() << std::endl;
-        CloseSocket(clientFd_);
-        clientFd_ = INVALID_SOCKET_VALUE;
+        CloseSocket(fd);
+        return INVALID_SOCKET_VALUE;
+    }
+    return fd;
+}
+
+bool IPCClient::Connect() {
+    if (!connections_.empty()) {
+        return true;  // Already connected
+    }
+
+#ifdef _WIN32
+    if (!InitializeWinsock()) {
         return false;
     }
+#endif
+
+    for (size_t i = 0; i < poolSize_; ++i) {
+        socket_t fd = OpenSocket();
+        if (fd == INVALID_SOCKET_VALUE) {
+            if (i == 0) {
+                return false;
+            }
+            break;  // Fewer connections will do
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        Connection* reading = connection.get();
+        connection->reader = std::thread([this, reading]() { ReadLoop(*reading); });
+        connections_.push_back(std::move(connection));
+    }
 
-    std::cout << "Connected to IPC server at localhost:" << port_ << std::endl;
+    std::cout << "Connected to IPC server at "
+              << (socketPath_.empty() ? "localhost:" + std::to_string(port_) : socketPath_);
+    if (connections_.size() > 1) {
+        std::cout << " (" << connections_.size() << " connections)";
+    }
+    std::cout << std::endl;
     return true;
 }
 
 void IPCClient::Disconnect() {
-    if (clientFd_ != INVALID_SOCKET_VALUE) {
-        CloseSocket(clientFd_);
-        clientFd_ = INVALID_SOCKET_VALUE;
-        std::cout << "Disconnected from IPC server" << std::endl;
+    if (connections_.empty()) {
+        return;
+    }
+
+    for (auto& connection : connections_) {
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->stopping = true;
+        }
+        connection->changed.notify_all();
+        if (connection->reader.joinable()) {
+            connection->reader.join();
+        }
+        FailPending(*connection, "Disconnected from IPC server");
+        CloseSocket(connection->fd);
+    }
+    connections_.clear();
+
+    std::lock_guard<std::mutex> lock(passedFdsMutex_);
+#ifndef _WIN32
+    for (int fd : passedFds_) {
+        close(fd);
+    }
+#endif
+    passedFds_.clear();
+    std::cout << "Disconnected from IPC server" << std::endl;
+}
+
+bool IPCClient::IsConnected() const {
+    if (connections_.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(connections_.front()->mutex);
+    return !connections_.front()->closed;
+}
+
+WireEncoding IPCClient::GetEncoding() const {
+    if (connections_.empty()) {
+        return WireEncoding::Json;
+    }
+    std::lock_guard<std::mutex> lock(connections_.front()->mutex);
+    return connections_.front()->encoding;
+}
+
+int IPCClient::TakePassedFd() {
+    std::lock_guard<std::mutex> lock(passedFdsMutex_);
+    if (passedFds_.empty()) {
+        return -1;
     }
+    int fd = passedFds_.front();
+    passedFds_.pop_front();
+    return fd;
 }
 
-IPCResponse IPCClient::SendRequest(const IPCRequest& request, int timeoutMs) {
-    if (!IsConnected()) {
+IPCClient::Connection& IPCClient::PickConnection(bool anyConnection) {
+    if (connections_.empty()) {
         throw std::runtime_error("Not connected to IPC server");
     }
+    Connection* best = connections_.front().get();
+    if (!anyConnection) {
+        return *best;
+    }
 
-    // Serialize request
-    std::string requestStr = request.ToJson().dump();
-    requestStr += "\n";  // Add newline delimiter
+    // The least busy open one, the first on a tie
+    size_t bestWaiting = SIZE_MAX;
+    for (auto& connection : connections_) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (!connection->closed && connection->pending.size() < bestWaiting) {
+            best = connection.get();
+            bestWaiting = connection->pending.size();
+        }
+    }
+    return *best;
+}
 
-    // Send request (handle short writes)
-    SendAll(requestStr, timeoutMs);
+IPCResponse IPCClient::SendRequest(const IPCRequest& request, int timeoutMs, bool anyConnection) {
+    return SendRequestAsync(request, timeoutMs, anyConnection).get();
+}
 
-    // Wait for response
-    std::string responseStr = ReadResponse(timeoutMs);
+std::future<IPCResponse> IPCClient::SendRequestAsync(const IPCRequest& request, int timeoutMs,
+                                                     bool anyConnection) {
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    return std::move(Send(PickConnection(anyConnection), {request}, deadline).front());
+}
 
-    // Parse response
-    try {
-        json responseJson = json::parse(responseStr);
-        return IPCResponse::FromJson(responseJson);
-    } catch (const json::exception& e) {
-        throw std::runtime_error(std::string("Failed to parse response: ") + e.what());
+std::vector<IPCResponse> IPCClient::SendRequests(const std::vector<IPCRequest>& requests, int timeoutMs) {
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::vector<std::future<IPCResponse>> futures = Send(PickConnection(false), requests, deadline);
+
+    std::vector<IPCResponse> responses;
+    responses.reserve(futures.size());
+    for (std::future<IPCResponse>& future : futures) {
+        responses.push_back(future.get());
     }
+    return responses;
 }
 
-void IPCClient::SendAll(const std::string& data, int timeoutMs) {
-    using Clock = std::chrono::steady_clock;
-    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+std::vector<std::future<IPCResponse>> IPCClient::Send(Connection& connection,
+                                                      const std::vector<IPCRequest>& requests,
+                                                      Clock::time_point deadline) {
+    std::lock_guard<std::mutex> sendLock(connection.sendMutex);
+
+    // On the wire every request carries an id of our own, so a late answer
+    // to one that timed out earlier is recognised and skipped
+    std::string batch;
+    std::vector<int> wireIds;
+    std::vector<std::future<IPCResponse>> futures;
+    {
+        std::unique_lock<std::mutex> lock(connection.mutex);
+        // Requests after a hello choosing an encoding wait for its answer
+        if (!connection.changed.wait_until(lock, deadline, [&connection]() {
+                return !connection.helloPending || connection.closed;
+            })) {
+            throw std::runtime_error("Timeout sending request");
+        }
+        if (connection.closed) {
+            throw std::runtime_error("Not connected to IPC server");
+        }
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const bool hello = requests[i].method == "session.hello" && requests[i].params.is_object() &&
+                               requests[i].params.contains("encoding");
+            if (hello && i + 1 < requests.size()) {
+                // The server switches encoding right after answering it
+                for (int wireId : wireIds) {
+                    connection.pending.erase(wireId);
+                }
+                throw std::invalid_argument("session.hello choosing an encoding must end its batch");
+            }
+            IPCRequest framed = requests[i];
+            framed.id = nextId_++;
+            batch += EncodeMessage(framed.ToJson(), connection.encoding);
+
+            Pending& pending = connection.pending[framed.id];
+            pending.id = requests[i].id;
+            pending.hello = hello;
+            pending.deadline = deadline;
+            futures.push_back(pending.promise.get_future());
+            wireIds.push_back(framed.id);
+            connection.helloPending = connection.helloPending || hello;
+        }
+    }
+    connection.changed.notify_all();  // The reader has something to wait for
+
+    try {
+        SendAll(connection.fd, batch, deadline);
+    } catch (const std::runtime_error&) {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.closed = true;  // Part of a message may be out: the stream is unusable
+        connection.helloPending = false;
+        for (int wireId : wireIds) {
+            connection.pending.erase(wireId);
+        }
+        connection.changed.notify_all();
+        throw;
+    }
+    return futures;
+}
 
+void IPCClient::SendAll(socket_t fd, const std::string& data, Clock::time_point deadline) {
     size_t totalSent = 0;
     while (totalSent < data.size()) {
 #ifdef _WIN32
-        int sent = send(clientFd_, data.data() + totalSent, 
+        int sent = send(fd, data.data() + totalSent, 
                        static_cast<int>(data.size() - totalSent), 0);
+#elif defined(MSG_NOSIGNAL)
+        ssize_t sent = send(fd, data.data() + totalSent, data.size() - totalSent, MSG_NOSIGNAL);
 #else
-        ssize_t sent = send(clientFd_, data.data() + totalSent, data.size() - totalSent, 0);
+        ssize_t sent = send(fd, data.data() + totalSent, data.size() - totalSent, 0);
 #endif
         if (sent > 0) {
             totalSent += static_cast<size_t>(sent);
@@ -204,13 +403,13 @@ void IPCClient::SendAll(const std::string& data, int timeoutMs) {
 
             fd_set writefds;
             FD_ZERO(&writefds);
-            FD_SET(clientFd_, &writefds);
+            FD_SET(fd, &writefds);
 
             timeval timeout;
             timeout.tv_sec = remainingMs / 1000;
             timeout.tv_usec = (remainingMs % 1000) * 1000;
 
-            int activity = select(static_cast<int>(clientFd_) + 1, nullptr, &writefds, nullptr, &timeout);
+            int activity = select(static_cast<int>(fd) + 1, nullptr, &writefds, nullptr, &timeout);
             if (activity <= 0) {
                 throw std::runtime_error("Timeout sending request");
             }
@@ -221,38 +420,77 @@ void IPCClient::SendAll(const std::string& data, int timeoutMs) {
     }
 }
 
-std::string IPCClient::ReadResponse(int timeoutMs) {
-    using Clock = std::chrono::steady_clock;
-    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
-
-    std::string response;
-    response.reserve(8192);
+void IPCClient::FailPending(Connection& connection, const std::string& reason) {
+    std::map<int, Pending> failed;
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        failed.swap(connection.pending);
+        connection.helloPending = false;
+    }
+    connection.changed.notify_all();
+    for (auto& [wireId, pending] : failed) {
+        pending.promise.set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+    }
+}
 
+void IPCClient::ReadLoop(Connection& connection) {
     while (true) {
-        // Return once we see the newline delimiter.
-        size_t newlinePos = response.find('\n');
-        if (newlinePos != std::string::npos) {
-            return response.substr(0, newlinePos);
-        }
+        // Sleep until there is something to read for; fail what is overdue
+        std::vector<Pending> expired;
+        Clock::time_point wakeAt;
+        {
+            std::unique_lock<std::mutex> lock(connection.mutex);
+            // With a notification handler there is always something to read for
+            connection.changed.wait(lock, [this, &connection]() {
+                return connection.stopping || connection.closed || !connection.pending.empty() ||
+                       notificationHandler_;
+            });
+            if (connection.stopping || connection.closed) {
+                return;
+            }
 
-        auto now = Clock::now();
-        if (now >= deadline) {
-            throw std::runtime_error("Timeout waiting for response");
+            const auto now = Clock::now();
+            wakeAt = now + std::chrono::milliseconds(READ_WAIT_MS);
+            for (auto it = connection.pending.begin(); it != connection.pending.end(); ) {
+                if (it->second.deadline <= now) {
+                    if (it->second.hello) {
+                        connection.closed = true;  // Which encoding the server is in is unknown now
+                    }
+                    expired.push_back(std::move(it->second));
+                    it = connection.pending.erase(it);
+                } else {
+                    wakeAt = std::min(wakeAt, it->second.deadline);
+                    ++it;
+                }
+            }
+        }
+        if (!expired.empty()) {
+            for (Pending& pending : expired) {
+                pending.promise.set_exception(
+                    std::make_exception_ptr(std::runtime_error("Timeout waiting for response")));
+            }
+            bool closed;
+            {
+                std::lock_guard<std::mutex> lock(connection.mutex);
+                closed = connection.closed;
+            }
+            if (closed) {
+                FailPending(connection, "Connection reset after a timed-out session.hello");
+                return;
+            }
+            continue;
         }
 
-        int remainingMs = static_cast<int>(
-            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()
-        );
-
+        const int waitMs = static_cast<int>(std::max<int64_t>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(wakeAt - Clock::now()).count()));
         fd_set readfds;
         FD_ZERO(&readfds);
-        FD_SET(clientFd_, &readfds);
-
+        FD_SET(connection.fd, &readfds);
         timeval timeout;
-        timeout.tv_sec = remainingMs / 1000;
-        timeout.tv_usec = (remainingMs % 1000) * 1000;
+        timeout.tv_sec = waitMs / 1000;
+        timeout.tv_usec = (waitMs % 1000) * 1000;
 
-        int activity = select(static_cast<int>(clientFd_) + 1, &readfds, nullptr, nullptr, &timeout);
+        int activity = select(static_cast<int>(connection.fd) + 1, &readfds, nullptr, nullptr, &timeout);
         if (activity < 0) {
 #ifdef _WIN32
             if (WSAGetLastError() == WSAEINTR) {
@@ -263,18 +501,74 @@ std::string IPCClient::ReadResponse(int timeoutMs) {
                 continue;
             }
 #endif
-            throw std::runtime_error(std::string("Select error: ") + GetLastErrorString());
+            FailPending(connection, std::string("Select error: ") + GetLastErrorString());
+            return;
         }
-
         if (activity == 0) {
-            throw std::runtime_error("Timeout waiting for response");
+            continue;
+        }
+
+        try {
+            if (!ReadChunk(connection)) {
+                {
+                    std::lock_guard<std::mutex> lock(connection.mutex);
+                    connection.closed = true;
+                }
+                FailPending(connection, "Connection closed by server");
+                return;
+            }
+            std::string message;
+            while (connection.received.Next(message)) {
+                if (!message.empty()) {
+                    HandleMessage(connection, message);
+                }
+            }
+        } catch (const std::runtime_error& e) {
+            {
+                std::lock_guard<std::mutex> lock(connection.mutex);
+                connection.closed = true;
+            }
+            FailPending(connection, e.what());
+            return;
         }
+    }
+}
 
+bool IPCClient::ReadChunk(Connection& connection) {
+    while (true) {
         char buffer[CHUNK_SIZE];
 #ifdef _WIN32
-        int n = recv(clientFd_, buffer, sizeof(buffer), 0);
+        int n = recv(connection.fd, buffer, sizeof(buffer), 0);
+#else
+        // recvmsg: descriptors the server passes come as ancillary data
+        iovec vector{buffer, sizeof(buffer)};
+        alignas(cmsghdr) char control[CMSG_SPACE(4 * sizeof(int))];
+        msghdr header{};
+        header.msg_iov = &vector;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+#ifdef MSG_CMSG_CLOEXEC
+        ssize_t n = recvmsg(connection.fd, &header, MSG_CMSG_CLOEXEC);
 #else
-        ssize_t n = recv(clientFd_, buffer, sizeof(buffer), 0);
+        ssize_t n = recvmsg(connection.fd, &header, 0);
+#endif
+        for (cmsghdr* item = n >= 0 ? CMSG_FIRSTHDR(&header) : nullptr; item; item = CMSG_NXTHDR(&header, item)) {
+            if (item->cmsg_level != SOL_SOCKET || item->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            const size_t count = (item->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            std::lock_guard<std::mutex> lock(passedFdsMutex_);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(item) + i * sizeof(int), sizeof(int));
+                passedFds_.push_back(fd);
+                if (passedFds_.size() > MAX_PASSED_FDS) {
+                    close(passedFds_.front());
+                    passedFds_.pop_front();
+                }
+            }
+        }
 #endif
         if (n < 0) {
 #ifdef _WIN32
@@ -290,11 +584,65 @@ std::string IPCClient::ReadResponse(int timeoutMs) {
         }
 
         if (n == 0) {
-            throw std::runtime_error("Connection closed by server");
+            return false;
+        }
+
+        if (!connection.received.Append(buffer, static_cast<size_t>(n))) {
+            throw std::runtime_error("Response too large");
+        }
+        return true;
+    }
+}
+
+void IPCClient::HandleMessage(Connection& connection, const std::string& message) {
+    IPCResponse response;
+    try {
+        json decoded = DecodeMessage(message, connection.received.GetEncoding());
+        if (IPCNotification::IsNotification(decoded)) {
+            IPCNotification notification = IPCNotification::FromJson(decoded);
+            if (notificationHandler_) {
+                notificationHandler_(notification.method, notification.params);
+            }
+            return;
         }
+        response = IPCResponse::FromJson(decoded);
+    } catch (const json::exception& e) {
+        throw std::runtime_error(std::string("Failed to parse response: ") + e.what());
+    }
 
-        response.append(buffer, buffer + n);
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        auto it = connection.pending.find(response.id);
+        if (it == connection.pending.end() && response.id == 0 && response.error &&
+            !connection.pending.empty()) {
+            // The server could not parse a request: requests are answered
+            // in order, so it is the oldest one waiting
+            it = connection.pending.begin();
+        }
+        if (it == connection.pending.end()) {
+            return;  // Answer to a request that timed out
+        }
+        pending = std::move(it->second);
+        connection.pending.erase(it);
+
+        // Everything after the hello's reply comes in the encoding it chose
+        if (pending.hello) {
+            if (response.result && response.result->is_object()) {
+                if (auto encoding = ParseWireEncoding(response.result->value("encoding", std::string()))) {
+                    connection.received.SetEncoding(*encoding);
+                    connection.encoding = *encoding;
+                }
+            }
+            connection.helloPending = false;
+        }
     }
+    if (pending.hello) {
+        connection.changed.notify_all();
+    }
+
+    response.id = pending.id;
+    pending.promise.set_value(std::move(response));
 }
 
 } // namespace ipc
@@ -1,8 +1,18 @@
 #pragma once
 
 #include "IPCMessage.h"
-#include <string>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Cross-platform socket includes
 #ifdef _WIN32
@@ -22,9 +32,22 @@ namespace pathview {
 namespace ipc {
 
 /**
- * TCP socket client for IPC
+ * Receives a server notification: method and params
+ */
+using NotificationHandler = std::function<void(const std::string& method, const json& params)>;
+
+/**
+ * Socket client for IPC, over localhost TCP or the GUI's Unix socket
  * Used by MCP server to communicate with GUI application
  * Cross-platform: works on Windows (Winsock) and Unix (BSD sockets)
+ *
+ * Requests are multiplexed: each connection has a reader thread that hands
+ * every response to the future of the request with its id, so callers on
+ * several threads share the connection without waiting for each other's
+ * round trips, and each request has its own timeout. The GUI still answers
+ * a connection's requests in order, a deferred one (snapshot.capture)
+ * holding back the rest, so SetPoolSize() opens more connections for
+ * requests that may go on any of them.
  */
 class IPCClient {
 public:
@@ -33,62 +56,170 @@ public:
      * @param port Port to connect to (default: 9999)
      */
     explicit IPCClient(int port = 9999);
+
+    /**
+     * Construct client for a Unix socket (see IPCServer::SetSocketPath)
+     */
+    explicit IPCClient(const std::string& socketPath);
     ~IPCClient();
 
     // Delete copy constructor and assignment
     IPCClient(const IPCClient&) = delete;
     IPCClient& operator=(const IPCClient&) = delete;
 
+    /**
+     * Connections to open (set before Connect()); the first carries every
+     * request that is not sent with anyConnection
+     */
+    void SetPoolSize(size_t connections) { poolSize_ = connections > 0 ? connections : 1; }
+    size_t GetPoolSize() const { return poolSize_; }
+
+    /**
+     * Receive notifications the server pushes, e.g. events subscribed to
+     * with events.subscribe (set before Connect()). Called on a connection's
+     * reader thread with the method and params; keep it short.
+     */
+    void SetNotificationHandler(NotificationHandler handler) { notificationHandler_ = std::move(handler); }
+
     /**
      * Connect to the IPC server
+     * Opens the pool; only the first connection has to succeed
      * @return true on success
      */
     bool Connect();
 
     /**
      * Disconnect from the IPC server
+     * Requests still waiting fail
      */
     void Disconnect();
 
     /**
-     * Check if connected to server
+     * Check if connected to server (the first connection is open)
      */
-    bool IsConnected() const { return clientFd_ != INVALID_SOCKET_VALUE; }
+    bool IsConnected() const;
 
     /**
      * Send a request and wait for response
-     * Blocking call with timeout
+     * Blocking call with timeout; thread-safe
      * @param request The IPC request to send
      * @param timeoutMs Timeout in milliseconds (default 5000)
+     * @param anyConnection See SendRequestAsync
      * @return IPCResponse from server
      * @throws std::runtime_error on timeout or error
      */
-    IPCResponse SendRequest(const IPCRequest& request, int timeoutMs = 5000);
+    IPCResponse SendRequest(const IPCRequest& request, int timeoutMs = 5000, bool anyConnection = false);
+
+    /**
+     * Send a request without waiting for its response
+     * @param anyConnection Send on the pooled connection with the fewest
+     *        requests waiting. Only for requests that do not depend on the
+     *        connection they come on (the navigation lock belongs to one)
+     *        nor on being ordered after requests still waiting
+     * @return The response's future; it holds std::runtime_error on timeout
+     *         (after timeoutMs) or error
+     * @throws std::runtime_error if the request cannot be sent
+     */
+    std::future<IPCResponse> SendRequestAsync(const IPCRequest& request, int timeoutMs = 5000,
+                                              bool anyConnection = false);
+
+    /**
+     * Send several requests at once (pipelined) and wait for every response
+     * The server handles them in order; the round trips overlap. Thread-safe
+     * with SendRequest.
+     * A session.hello with "encoding" switches the connection once answered
+     * (see WireEncoding), so it has to be the last request of its batch.
+     * @return Responses in the order of requests, ids as the caller set them
+     * @throws std::runtime_error on timeout (for the whole batch) or error
+     */
+    std::vector<IPCResponse> SendRequests(const std::vector<IPCRequest>& requests, int timeoutMs = 5000);
+
+    /**
+     * Encoding the first connection currently uses (Json until a
+     * session.hello chose another)
+     */
+    WireEncoding GetEncoding() const;
 
     /**
      * Get the port number
      */
     int GetPort() const { return port_; }
 
+    /**
+     * Get the Unix socket path (empty over TCP)
+     */
+    const std::string& GetSocketPath() const { return socketPath_; }
+
+    /**
+     * Take the oldest file descriptor the server passed with a response
+     * (Unix socket, POSIX); the caller closes it
+     * @return The descriptor, or -1 if none is waiting
+     */
+    int TakePassedFd();
+
     /**
      * Try to read port from port file
      * @return port number if found, or default port if not
      */
     static int ReadPortFromFile();
 
+    /**
+     * Try to read the Unix socket path from the socket file
+     * @return The path, or empty if there is none
+     */
+    static std::string ReadSocketPathFromFile();
+
 private:
-    std::string ReadResponse(int timeoutMs);
-    void SendAll(const std::string& data, int timeoutMs);
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        int id;              // The caller's
+        bool hello;          // session.hello choosing an encoding
+        Clock::time_point deadline;
+        std::promise<IPCResponse> promise;
+    };
+
+    // One socket and the requests sent on it, answered by its reader thread
+    struct Connection {
+        socket_t fd = INVALID_SOCKET_VALUE;
+        std::thread reader;
+        std::mutex sendMutex;        // One writer at a time
+        mutable std::mutex mutex;    // Guards the rest
+        std::condition_variable changed;
+        std::map<int, Pending> pending;  // Wire id -> waiting request
+        WireEncoding encoding = WireEncoding::Json;
+        bool helloPending = false;   // Sends wait: the encoding may change
+        bool closed = false;         // By the server, or after an error
+        bool stopping = false;
+        MessageBuffer received;      // Reader thread only
+    };
+
+    socket_t OpenSocket();
+    Connection& PickConnection(bool anyConnection);
+    std::vector<std::future<IPCResponse>> Send(Connection& connection, const std::vector<IPCRequest>& requests,
+                                               Clock::time_point deadline);
+    void ReadLoop(Connection& connection);
+    bool ReadChunk(Connection& connection);  // false: closed or failed
+    void HandleMessage(Connection& connection, const std::string& message);
+    static void FailPending(Connection& connection, const std::string& reason);
+    static void SendAll(socket_t fd, const std::string& data, Clock::time_point deadline);
     
     // Platform-specific helpers
     static void CloseSocket(socket_t fd);
     static std::string GetLastErrorString();
 
     int port_;
-    socket_t clientFd_;
+    std::string socketPath_;
+    size_t poolSize_ = 1;
+    std::vector<std::unique_ptr<Connection>> connections_;
     std::atomic<int> nextId_;
+    std::mutex passedFdsMutex_;
+    std::deque<int> passedFds_;  // Received with responses, not yet taken
+    NotificationHandler notificationHandler_;
 
     static constexpr int CHUNK_SIZE = 65536;  // Read chunk size
+    static constexpr size_t MAX_PASSED_FDS = 16;  // Older ones are closed
+    static constexpr int READ_WAIT_MS = 100;  // Reader rechecks deadlines and stopping this often
 
 #ifdef _WIN32
     static bool wsaInitialized_;
@@ -1,8 +1,41 @@
 #include "IPCMessage.h"
+#include <cstring>
+#include <stdexcept>
 
 namespace pathview {
 namespace ipc {
 
+namespace {
+
+// Binary values as base64 strings, for Json connections
+void ReplaceBinaryWithBase64(json& value) {
+    if (value.is_binary()) {
+        value = Base64Encode(value.get_binary());
+    } else if (value.is_structured()) {
+        for (json& element : value) {
+            ReplaceBinaryWithBase64(element);
+        }
+    }
+}
+
+// Values as one binary value, little-endian whatever the host's order;
+// Bits is the unsigned integer of the same size as T
+template <typename Bits, typename T>
+json PackLittleEndian(const std::vector<T>& values) {
+    static_assert(sizeof(Bits) == sizeof(T), "Bits must be as wide as T");
+    std::vector<uint8_t> bytes(values.size() * sizeof(T));
+    for (size_t i = 0; i < values.size(); ++i) {
+        Bits bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        for (size_t b = 0; b < sizeof(bits); ++b) {
+            bytes[i * sizeof(T) + b] = static_cast<uint8_t>(bits >> (8 * b));
+        }
+    }
+    return json::binary(std::move(bytes));
+}
+
+}  // namespace
+
 // IPCError methods
 json IPCError::ToJson() const {
     json j = {
@@ -31,12 +64,18 @@ IPCError IPCError::FromJson(const json& j) {
 
 // IPCRequest methods
 json IPCRequest::ToJson() const {
-    return json{
+    json j = {
         {"jsonrpc", jsonrpc},
         {"id", id},
         {"method", method},
         {"params", params}
     };
+
+    if (!traceId.empty()) {
+        j["trace_id"] = traceId;
+    }
+
+    return j;
 }
 
 IPCRequest IPCRequest::FromJson(const json& j) {
@@ -45,10 +84,32 @@ IPCRequest IPCRequest::FromJson(const json& j) {
     request.id = j.at("id").get<int>();
     request.method = j.at("method").get<std::string>();
     request.params = j.value("params", json::object());
+    request.traceId = j.value("trace_id", "");
 
     return request;
 }
 
+// IPCNotification methods
+json IPCNotification::ToJson() const {
+    return json{
+        {"jsonrpc", jsonrpc},
+        {"method", method},
+        {"params", params}
+    };
+}
+
+IPCNotification IPCNotification::FromJson(const json& j) {
+    IPCNotification notification;
+    notification.jsonrpc = j.value("jsonrpc", "2.0");
+    notification.method = j.at("method").get<std::string>();
+    notification.params = j.value("params", json::object());
+    return notification;
+}
+
+bool IPCNotification::IsNotification(const json& j) {
+    return j.is_object() && j.contains("method") && (!j.contains("id") || j["id"].is_null());
+}
+
 // IPCResponse methods
 json IPCResponse::ToJson() const {
     json j = {
@@ -64,6 +125,10 @@ json IPCResponse::ToJson() const {
         j["error"] = error.value().ToJson();
     }
 
+    if (trace.has_value()) {
+        j["trace"] = trace.value();
+    }
+
     return j;
 }
 
@@ -80,8 +145,202 @@ IPCResponse IPCResponse::FromJson(const json& j) {
         response.error = IPCError::FromJson(j.at("error"));
     }
 
+    if (j.contains("trace")) {
+        response.trace = j.at("trace");
+    }
+
     return response;
 }
 
+// Wire encoding
+std::optional<WireEncoding> ParseWireEncoding(const std::string& name) {
+    if (name == "json") return WireEncoding::Json;
+    if (name == "msgpack" || name == "messagepack") return WireEncoding::MessagePack;
+    if (name == "cbor") return WireEncoding::Cbor;
+    return std::nullopt;
+}
+
+const char* WireEncodingName(WireEncoding encoding) {
+    switch (encoding) {
+        case WireEncoding::MessagePack: return "msgpack";
+        case WireEncoding::Cbor: return "cbor";
+        case WireEncoding::Json: break;
+    }
+    return "json";
+}
+
+std::string EncodeMessage(json message, WireEncoding encoding) {
+    if (encoding == WireEncoding::Json) {
+        ReplaceBinaryWithBase64(message);
+        return message.dump() + "\n";
+    }
+
+    // Length prefix first, then the body straight behind it
+    std::string framed(MessageBuffer::LENGTH_PREFIX_BYTES, '\0');
+    if (encoding == WireEncoding::MessagePack) {
+        json::to_msgpack(message, framed);
+    } else {
+        json::to_cbor(message, framed);
+    }
+    const size_t length = framed.size() - MessageBuffer::LENGTH_PREFIX_BYTES;
+    if (length > MessageBuffer::MAX_MESSAGE_BYTES) {
+        throw std::runtime_error("Message too large");
+    }
+    for (size_t i = 0; i < MessageBuffer::LENGTH_PREFIX_BYTES; ++i) {
+        framed[i] = static_cast<char>((length >> (8 * (MessageBuffer::LENGTH_PREFIX_BYTES - 1 - i))) & 0xFF);
+    }
+    return framed;
+}
+
+json DecodeMessage(const std::string& message, WireEncoding encoding) {
+    switch (encoding) {
+        case WireEncoding::MessagePack: return json::from_msgpack(message);
+        case WireEncoding::Cbor: return json::from_cbor(message);
+        case WireEncoding::Json: break;
+    }
+    return json::parse(message);
+}
+
+std::string Base64Encode(const std::vector<uint8_t>& data) {
+    static const char* base64_chars =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz"
+        "0123456789+/";
+
+    std::string base64;
+    base64.reserve((data.size() + 2) / 3 * 4);
+    int i = 0;
+    unsigned char char_array_3[3];
+    unsigned char char_array_4[4];
+
+    for (size_t idx = 0; idx < data.size(); idx++) {
+        char_array_3[i++] = data[idx];
+        if (i == 3) {
+            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+            char_array_4[3] = char_array_3[2] & 0x3f;
+
+            for(i = 0; i < 4; i++)
+                base64 += base64_chars[char_array_4[i]];
+            i = 0;
+        }
+    }
+
+    if (i) {
+        for(int j = i; j < 3; j++)
+            char_array_3[j] = '\0';
+
+        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+
+        for (int j = 0; j < i + 1; j++)
+            base64 += base64_chars[char_array_4[j]];
+
+        while(i++ < 3)
+            base64 += '=';
+    }
+
+    return base64;
+}
+
+json PackDoubles(const std::vector<double>& values) {
+    return PackLittleEndian<uint64_t>(values);
+}
+
+json PackFloats(const std::vector<float>& values) {
+    return PackLittleEndian<uint32_t>(values);
+}
+
+json PackUInt32s(const std::vector<uint32_t>& values) {
+    return PackLittleEndian<uint32_t>(values);
+}
+
+json PackInt32s(const std::vector<int32_t>& values) {
+    return PackLittleEndian<uint32_t>(values);
+}
+
+std::vector<double> UnpackDoubles(const json& value) {
+    if (!value.is_binary() || value.get_binary().size() % sizeof(double) != 0) {
+        throw std::runtime_error("Expected binary of little-endian float64 values");
+    }
+    const auto& bytes = value.get_binary();
+    std::vector<double> values(bytes.size() / sizeof(double));
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint64_t bits = 0;
+        for (size_t b = 0; b < sizeof(bits); ++b) {
+            bits |= static_cast<uint64_t>(bytes[i * sizeof(double) + b]) << (8 * b);
+        }
+        std::memcpy(&values[i], &bits, sizeof(bits));
+    }
+    return values;
+}
+
+// MessageBuffer methods
+bool MessageBuffer::Append(const char* data, size_t size) {
+    // Drop consumed messages before growing
+    if (start_ > 0 && (start_ == buffer_.size() || start_ >= buffer_.size() / 2)) {
+        buffer_.erase(0, start_);
+        start_ = 0;
+    }
+    buffer_.append(data, size);
+    return !HasOversizedMessage();
+}
+
+bool MessageBuffer::HasOversizedMessage() {
+    if (encoding_ != WireEncoding::Json) {
+        // The prefix says up front how big the next message will be
+        return GetBufferedBytes() >= LENGTH_PREFIX_BYTES && PeekLength() > MAX_MESSAGE_BYTES;
+    }
+    if (buffer_.find('\n', start_ + scanned_) != std::string::npos) {
+        return false;
+    }
+    scanned_ = buffer_.size() - start_;  // Only new bytes need searching next time
+    return scanned_ > MAX_MESSAGE_BYTES;
+}
+
+size_t MessageBuffer::PeekLength() const {
+    size_t length = 0;
+    for (size_t i = 0; i < LENGTH_PREFIX_BYTES; ++i) {
+        length = (length << 8) | static_cast<uint8_t>(buffer_[start_ + i]);
+    }
+    return length;
+}
+
+void MessageBuffer::SetEncoding(WireEncoding encoding) {
+    encoding_ = encoding;
+    scanned_ = 0;
+}
+
+bool MessageBuffer::Next(std::string& message) {
+    if (encoding_ != WireEncoding::Json) {
+        if (GetBufferedBytes() < LENGTH_PREFIX_BYTES) {
+            return false;
+        }
+        const size_t length = PeekLength();
+        if (GetBufferedBytes() - LENGTH_PREFIX_BYTES < length) {
+            return false;
+        }
+        message.assign(buffer_, start_ + LENGTH_PREFIX_BYTES, length);
+        start_ += LENGTH_PREFIX_BYTES + length;
+        return true;
+    }
+
+    const size_t newline = buffer_.find('\n', start_ + scanned_);
+    if (newline == std::string::npos) {
+        scanned_ = buffer_.size() - start_;  // Only new bytes need searching next time
+        return false;
+    }
+    size_t end = newline;
+    if (end > start_ && buffer_[end - 1] == '\r') {
+        --end;  // Tolerate CRLF from hand-written clients
+    }
+    message.assign(buffer_, start_, end - start_);
+    start_ = newline + 1;
+    scanned_ = 0;
+    return true;
+}
+
 } // namespace ipc
 } // namespace pathview
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <optional>
+#include <vector>
 #include "json.hpp"
 
 namespace pathview {
@@ -23,12 +25,15 @@ struct IPCError {
 
 /**
  * JSON-RPC 2.0 request message
+ * A "trace_id" asks the server to time the request (RequestTrace) and
+ * return its spans with the response
  */
 struct IPCRequest {
     std::string jsonrpc = "2.0";
     int id;
     std::string method;
     json params;
+    std::string traceId;  // Empty: not traced
 
     json ToJson() const;
     static IPCRequest FromJson(const json& j);
@@ -42,11 +47,129 @@ struct IPCResponse {
     int id;
     std::optional<json> result;
     std::optional<IPCError> error;
+    std::optional<json> trace;  // Spans of a traced request (RequestTrace::ToJson())
 
     json ToJson() const;
     static IPCResponse FromJson(const json& j);
 };
 
+/**
+ * JSON-RPC 2.0 notification: a message without an id, never answered
+ * The server pushes events to clients that subscribed (events.subscribe)
+ */
+struct IPCNotification {
+    std::string jsonrpc = "2.0";
+    std::string method;
+    json params;
+
+    json ToJson() const;
+    static IPCNotification FromJson(const json& j);
+
+    // A decoded message is one if it has a method and no id
+    static bool IsNotification(const json& j);
+};
+
+/**
+ * How messages on a connection are serialized
+ *
+ * Every connection starts as Json: one compact JSON document per line
+ * (json::dump() escapes newlines inside strings). session.hello with
+ * "encoding": "msgpack" or "cbor" switches both directions, from the
+ * message after its reply, to that binary form of the same JSON-RPC
+ * messages, each preceded by its length (4 bytes, big-endian). Binary
+ * values (json::binary: snapshot images, packed vertex lists) travel as
+ * raw bytes there; on a Json connection they are sent as base64 strings.
+ */
+enum class WireEncoding {
+    Json,
+    MessagePack,
+    Cbor
+};
+
+std::optional<WireEncoding> ParseWireEncoding(const std::string& name);
+const char* WireEncodingName(WireEncoding encoding);
+
+/**
+ * Serialize a message with its framing (newline or length prefix)
+ */
+std::string EncodeMessage(json message, WireEncoding encoding);
+
+/**
+ * Parse one message as returned by MessageBuffer::Next()
+ * @throws json::exception if it is malformed
+ */
+json DecodeMessage(const std::string& message, WireEncoding encoding);
+
+/**
+ * Standard base64 with padding
+ */
+std::string Base64Encode(const std::vector<uint8_t>& data);
+
+/**
+ * Doubles as one binary value (little-endian float64, in order): vertex
+ * lists as typed arrays instead of nested arrays of numbers
+ */
+json PackDoubles(const std::vector<double>& values);
+
+/**
+ * Float32, uint32 and int32 columns packed the same way (little-endian,
+ * in order), for bulk results such as polygons.query pages
+ */
+json PackFloats(const std::vector<float>& values);
+json PackUInt32s(const std::vector<uint32_t>& values);
+json PackInt32s(const std::vector<int32_t>& values);
+
+/**
+ * Inverse of PackDoubles()
+ * @throws std::runtime_error unless value is binary of whole doubles
+ */
+std::vector<double> UnpackDoubles(const json& value);
+
+/**
+ * Reassembles messages from a byte stream
+ *
+ * Bytes go in as recv() returns them, however the stream was split;
+ * complete messages come out in order, several per recv or one per many.
+ * Framing follows the connection's WireEncoding.
+ */
+class MessageBuffer {
+public:
+    /**
+     * Append received bytes
+     * @return false once an unfinished message exceeds MAX_MESSAGE_BYTES
+     *         (the peer is not speaking the protocol; drop it)
+     */
+    bool Append(const char* data, size_t size);
+
+    /**
+     * Take the next complete message, without its newline
+     * @return false if no complete message is buffered
+     */
+    bool Next(std::string& message);
+
+    size_t GetBufferedBytes() const { return buffer_.size() - start_; }
+
+    /**
+     * Framing of the messages after the one last taken
+     */
+    void SetEncoding(WireEncoding encoding);
+    WireEncoding GetEncoding() const { return encoding_; }
+
+    // Annotation vertex lists and batch metrics run to megabytes
+    static constexpr size_t MAX_MESSAGE_BYTES = 64 * 1024 * 1024;
+
+    static constexpr size_t LENGTH_PREFIX_BYTES = 4;
+
+private:
+    bool HasOversizedMessage();
+    size_t PeekLength() const;  // Of a length-prefixed message, prefix buffered
+
+    std::string buffer_;
+    size_t start_ = 0;    // Start of the first unconsumed message
+    size_t scanned_ = 0;  // Bytes from start_ already searched for '\n'
+    WireEncoding encoding_ = WireEncoding::Json;
+};
+
 /**
  * JSON-RPC 2.0 error codes
  */
@@ -5,14 +5,18 @@
 #include <chrono>
 #include <fstream>
 #include <filesystem>
+#include <thread>
 
 #ifdef _WIN32
     #pragma comment(lib, "ws2_32.lib")
+    #include <afunix.h>
+    #include <process.h>
 #else
     #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
-    #include <sys/select.h>
     #include <unistd.h>
     #include <fcntl.h>
     #include <cerrno>
@@ -21,6 +25,71 @@
 namespace pathview {
 namespace ipc {
 
+namespace {
+
+// A batch step's params with "$<step>.<path>" strings replaced by what
+// the earlier step's result holds there
+json ResolveReferences(const json& params, const json& results, size_t step) {
+    if (params.is_object() || params.is_array()) {
+        json resolved = params;
+        for (auto& [key, value] : resolved.items()) {
+            value = ResolveReferences(value, results, step);
+        }
+        return resolved;
+    }
+    if (!params.is_string()) {
+        return params;
+    }
+    const std::string& text = params.get_ref<const std::string&>();
+    if (text.empty() || text[0] != '$') {
+        return params;
+    }
+    if (text.compare(0, 2, "$$") == 0) {
+        return text.substr(1);
+    }
+
+    const size_t dot = std::min(text.find('.'), text.size());
+    const std::string name = text.substr(1, dot - 1);
+    size_t source = 0;
+    if (name == "prev") {
+        source = step - 1;
+    } else if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos) {
+        source = std::stoul(name);
+    } else {
+        throw std::runtime_error("Bad step reference: " + text);
+    }
+    if (step == 0 || source >= step || !results[source].contains("result")) {
+        throw std::runtime_error("No earlier result for " + text);
+    }
+
+    const json* value = &results[source]["result"];
+    for (size_t begin = dot + 1; begin <= text.size() && dot < text.size(); ) {
+        const size_t end = std::min(text.find('.', begin), text.size());
+        const std::string key = text.substr(begin, end - begin);
+        if (value->is_object() && value->contains(key)) {
+            value = &(*value)[key];
+        } else if (value->is_array() && !key.empty() &&
+                   key.find_first_not_of("0123456789") == std::string::npos && std::stoul(key) < value->size()) {
+            value = &(*value)[std::stoul(key)];
+        } else {
+            throw std::runtime_error("No " + key + " in the result for " + text);
+        }
+        begin = end + 1;
+    }
+    return *value;
+}
+
+// What a request costs its session's bucket: a batch a request per step
+double RequestCost(const IPCRequest& request) {
+    if (request.method == IPCServer::BATCH_METHOD && request.params.is_object() &&
+        request.params.contains("steps") && request.params["steps"].is_array()) {
+        return std::max<double>(1.0, request.params["steps"].size());
+    }
+    return 1.0;
+}
+
+}  // namespace
+
 #ifdef _WIN32
 bool IPCServer::wsaInitialized_ = false;
 
@@ -78,6 +147,43 @@ void IPCServer::CloseSocket(socket_t fd) {
 #endif
 }
 
+void IPCServer::CloseDescriptor(int fd) {
+#ifndef _WIN32
+    if (fd >= 0) {
+        close(fd);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+static std::string TempDirectory() {
+#ifdef _WIN32
+    const char* temp = std::getenv("TEMP");
+    if (!temp) temp = std::getenv("TMP");
+    if (!temp) temp = ".";
+    return temp;
+#else
+    return "/tmp";
+#endif
+}
+
+std::string IPCServer::DefaultSocketPath() {
+#ifdef _WIN32
+    return TempDirectory() + "\\pathview-" + std::to_string(_getpid()) + ".sock";
+#else
+    return TempDirectory() + "/pathview-" + std::to_string(getpid()) + ".sock";
+#endif
+}
+
+std::string IPCServer::GetSocketFilePath() {
+#ifdef _WIN32
+    return TempDirectory() + "\\pathview-socket.txt";
+#else
+    return TempDirectory() + "/pathview-socket";
+#endif
+}
+
 std::string IPCServer::GetPortFilePath() const {
 #ifdef _WIN32
     const char* temp = std::getenv("TEMP");
@@ -106,66 +212,152 @@ void IPCServer::RemovePortFile() {
     std::filesystem::remove(path);
 }
 
-static bool SendAll(socket_t fd, const std::string& data, int timeoutMs) {
-    using Clock = std::chrono::steady_clock;
-    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+void IPCServer::WriteSocketFile() {
+    std::string path = GetSocketFilePath();
+    std::ofstream file(path);
+    if (file.is_open()) {
+        file << socketPath_;
+        file.close();
+        std::cout << "Wrote socket path " << socketPath_ << " to " << path << std::endl;
+    } else {
+        std::cerr << "Warning: Failed to write socket file: " << path << std::endl;
+    }
+}
 
-    size_t totalSent = 0;
-    while (totalSent < data.size()) {
+void IPCServer::RemoveSocketFile() {
+    // Only if it still names our socket: a later viewer may have replaced it
+    std::string path = GetSocketFilePath();
+    std::ifstream file(path);
+    std::string named;
+    std::getline(file, named);
+    file.close();
+    if (named == socketPath_) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+}
+
+bool IPCServer::CreateWakePair(socket_t& readEnd, socket_t& writeEnd) {
 #ifdef _WIN32
-        int sent = send(fd, data.data() + totalSent, 
-                       static_cast<int>(data.size() - totalSent), 0);
+    // WSAPoll only watches sockets: a loopback connection stands in for a pipe
+    socket_t listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET_VALUE) {
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int addrLen = sizeof(addr);
+    writeEnd = INVALID_SOCKET_VALUE;
+    readEnd = INVALID_SOCKET_VALUE;
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0 &&
+        listen(listener, 1) == 0) {
+        writeEnd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (writeEnd != INVALID_SOCKET_VALUE &&
+            connect(writeEnd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            readEnd = accept(listener, nullptr, nullptr);
+        }
+    }
+    CloseSocket(listener);
+    if (readEnd == INVALID_SOCKET_VALUE) {
+        if (writeEnd != INVALID_SOCKET_VALUE) {
+            CloseSocket(writeEnd);
+        }
+        return false;
+    }
 #else
-        ssize_t sent = send(fd, data.data() + totalSent, data.size() - totalSent, 0);
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    readEnd = fds[0];
+    writeEnd = fds[1];
 #endif
-        if (sent > 0) {
-            totalSent += static_cast<size_t>(sent);
-            continue;
-        }
+    SetNonBlocking(readEnd);
+    SetNonBlocking(writeEnd);
+    return true;
+}
 
+void IPCServer::Wake() {
+    // One byte in the pipe at a time, however many responses are posted
+    if (wakeWriteFd_ == INVALID_SOCKET_VALUE || wakePending_.exchange(true)) {
+        return;
+    }
+    char byte = 1;
 #ifdef _WIN32
-        int err = WSAGetLastError();
-        if (err == WSAEWOULDBLOCK) {
+    send(wakeWriteFd_, &byte, 1, 0);
 #else
-        if (errno == EINTR) {
-            continue;
-        }
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    ssize_t written = write(wakeWriteFd_, &byte, 1);
+    (void)written;  // Full pipe: a wake is pending anyway
 #endif
-            auto now = Clock::now();
-            if (now >= deadline) {
-                return false;
-            }
-
-            int remainingMs = static_cast<int>(
-                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()
-            );
-
-            fd_set writefds;
-            FD_ZERO(&writefds);
-            FD_SET(fd, &writefds);
+}
 
-            timeval timeout;
-            timeout.tv_sec = remainingMs / 1000;
-            timeout.tv_usec = (remainingMs % 1000) * 1000;
+static bool SendSome(socket_t fd, const char* data, size_t size, size_t& sent) {
+#ifdef _WIN32
+    int n = send(fd, data, static_cast<int>(size), 0);
+#elif defined(MSG_NOSIGNAL)
+    ssize_t n = send(fd, data, size, MSG_NOSIGNAL);  // A vanished client is an error, not SIGPIPE
+#else
+    ssize_t n = send(fd, data, size, 0);
+#endif
+    sent = n > 0 ? static_cast<size_t>(n) : 0;
+    return n >= 0;
+}
 
-            int activity = select(static_cast<int>(fd) + 1, nullptr, &writefds, nullptr, &timeout);
-            if (activity <= 0) {
-                return false;
-            }
-            continue;
-        }
+// send(), or sendmsg() carrying attachedFd (SCM_RIGHTS) with the first byte
+bool IPCServer::SendWithDescriptor(socket_t fd, const char* data, size_t size, int attachedFd, size_t& sent) {
+#ifdef _WIN32
+    (void)attachedFd;
+    return SendSome(fd, data, size, sent);
+#else
+    if (attachedFd < 0) {
+        return SendSome(fd, data, size, sent);
+    }
+    iovec vector{const_cast<char*>(data), size};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &attachedFd, sizeof(int));
+#ifdef MSG_NOSIGNAL
+    ssize_t n = sendmsg(fd, &message, MSG_NOSIGNAL);
+#else
+    ssize_t n = sendmsg(fd, &message, 0);
+#endif
+    sent = n > 0 ? static_cast<size_t>(n) : 0;
+    return n >= 0;
+#endif
+}
 
-        return false;
+const char* RequestPriorityName(RequestPriority priority) {
+    switch (priority) {
+        case RequestPriority::Interactive: return "interactive";
+        case RequestPriority::Background: return "background";
+        case RequestPriority::Normal: break;
     }
+    return "normal";
+}
 
-    return true;
+std::optional<RequestPriority> ParseRequestPriority(const std::string& name) {
+    if (name == "interactive") return RequestPriority::Interactive;
+    if (name == "normal") return RequestPriority::Normal;
+    if (name == "background") return RequestPriority::Background;
+    return std::nullopt;
 }
 
 IPCServer::IPCServer(CommandHandler handler)
     : handler_(std::move(handler))
     , serverFd_(INVALID_SOCKET_VALUE)
     , port_(DEFAULT_PORT)
+    , socketPath_(DefaultSocketPath())
     , currentClientFd_(INVALID_SOCKET_VALUE)
 {
 }
@@ -181,6 +373,48 @@ bool IPCServer::Start() {
     }
 #endif
 
+    if (!poller_.IsOpen()) {
+        std::cerr << "Failed to create IPC poller: " << GetLastErrorString() << std::endl;
+        return false;
+    }
+
+    const bool tcp = ListenTcp();
+    const bool local = !socketPath_.empty() && ListenUnix();
+    if (!tcp && !local) {
+        return false;
+    }
+
+    if (!CreateWakePair(wakeReadFd_, wakeWriteFd_) || !poller_.Add(wakeReadFd_, true, false) ||
+        (tcp && !poller_.Add(serverFd_, true, false)) ||
+        (local && !poller_.Add(unixServerFd_, true, false))) {
+        std::cerr << "Failed to set up IPC I/O thread: " << GetLastErrorString() << std::endl;
+        Stop();
+        return false;
+    }
+
+    // Write port and socket files for client discovery
+    if (tcp) {
+        WritePortFile();
+    }
+    if (local) {
+        WriteSocketFile();
+    }
+
+    stopping_ = false;
+    ioThread_ = std::thread(&IPCServer::IoLoop, this);
+
+    std::cout << "IPC server listening on";
+    if (tcp) {
+        std::cout << " 127.0.0.1:" << port_;
+    }
+    if (local) {
+        std::cout << " " << socketPath_;
+    }
+    std::cout << " (up to " << maxClients_ << " clients)" << std::endl;
+    return true;
+}
+
+bool IPCServer::ListenTcp() {
     // Create TCP socket
     serverFd_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (serverFd_ == INVALID_SOCKET_VALUE) {
@@ -218,197 +452,809 @@ bool IPCServer::Start() {
         return false;
     }
 
-    // Listen for connections
-    if (listen(serverFd_, MAX_CLIENTS) < 0) {
+    // Listen for connections (a burst of agents connecting at once queues)
+    if (listen(serverFd_, SOMAXCONN) < 0) {
         std::cerr << "Failed to listen on socket: " << GetLastErrorString() << std::endl;
         CloseSocket(serverFd_);
         serverFd_ = INVALID_SOCKET_VALUE;
         return false;
     }
 
-    // Write port file for client discovery
-    WritePortFile();
+    return true;
+}
+
+bool IPCServer::ListenUnix() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath_.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "IPC socket path too long: " << socketPath_ << std::endl;
+        return false;
+    }
+    std::memcpy(addr.sun_path, socketPath_.c_str(), socketPath_.size() + 1);
+
+    unixServerFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (unixServerFd_ == INVALID_SOCKET_VALUE) {
+        std::cerr << "Failed to create Unix socket: " << GetLastErrorString() << std::endl;
+        return false;
+    }
 
-    std::cout << "IPC server listening on 127.0.0.1:" << port_ << std::endl;
+    // A socket file nobody answers on is left from a crashed viewer
+    if (connect(unixServerFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        std::cerr << "IPC socket in use by another viewer: " << socketPath_ << std::endl;
+        CloseSocket(unixServerFd_);
+        unixServerFd_ = INVALID_SOCKET_VALUE;
+        return false;
+    }
+    CloseSocket(unixServerFd_);
+    std::error_code error;
+    std::filesystem::remove(socketPath_, error);
+
+    unixServerFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (unixServerFd_ == INVALID_SOCKET_VALUE || !SetNonBlocking(unixServerFd_) ||
+        bind(unixServerFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Failed to bind Unix socket " << socketPath_ << ": " << GetLastErrorString() << std::endl;
+        if (unixServerFd_ != INVALID_SOCKET_VALUE) {
+            CloseSocket(unixServerFd_);
+            unixServerFd_ = INVALID_SOCKET_VALUE;
+        }
+        return false;
+    }
+#ifndef _WIN32
+    chmod(socketPath_.c_str(), S_IRUSR | S_IWUSR);  // This user's processes only
+#endif
+
+    if (listen(unixServerFd_, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on Unix socket: " << GetLastErrorString() << std::endl;
+        CloseSocket(unixServerFd_);
+        unixServerFd_ = INVALID_SOCKET_VALUE;
+        std::filesystem::remove(socketPath_, error);
+        return false;
+    }
     return true;
 }
 
 void IPCServer::Stop() {
-    if (serverFd_ == INVALID_SOCKET_VALUE) {
+    if (!IsRunning()) {
         return;
     }
 
+    // Stop the I/O thread first: it owns the sockets
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakePending_ = false;
+    Wake();
+    if (ioThread_.joinable()) {
+        ioThread_.join();
+    }
+
     // Close all client connections
-    for (socket_t fd : clients_) {
-        CloseSocket(fd);
+    for (auto& [id, connection] : connections_) {
+        poller_.Remove(connection.fd);
+        CloseSocket(connection.fd);
+        for (const auto& attached : connection.attachedFds) {
+            CloseDescriptor(attached.second);
+        }
+    }
+    connections_.clear();
+    connectionIds_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inbox_.clear();
+        for (OutboundMessage& outbound : outbox_) {
+            CloseDescriptor(outbound.attachedFd);
+        }
+        outbox_.clear();
     }
     clients_.clear();
+    clientIds_.clear();
+    for (DeferredResponse& entry : deferred_) {
+        CloseDescriptor(entry.attachedFd);
+    }
+    deferred_.clear();
+
+    if (wakeReadFd_ != INVALID_SOCKET_VALUE) {
+        poller_.Remove(wakeReadFd_);
+        CloseSocket(wakeReadFd_);
+        CloseSocket(wakeWriteFd_);
+        wakeReadFd_ = INVALID_SOCKET_VALUE;
+        wakeWriteFd_ = INVALID_SOCKET_VALUE;
+    }
 
-    // Close server socket
-    CloseSocket(serverFd_);
-    serverFd_ = INVALID_SOCKET_VALUE;
-
-    // Remove port file
-    RemovePortFile();
+    // Close server sockets, remove the discovery files
+    if (serverFd_ != INVALID_SOCKET_VALUE) {
+        poller_.Remove(serverFd_);
+        CloseSocket(serverFd_);
+        serverFd_ = INVALID_SOCKET_VALUE;
+        RemovePortFile();
+    }
+    if (unixServerFd_ != INVALID_SOCKET_VALUE) {
+        poller_.Remove(unixServerFd_);
+        CloseSocket(unixServerFd_);
+        unixServerFd_ = INVALID_SOCKET_VALUE;
+        std::error_code error;
+        std::filesystem::remove(socketPath_, error);
+        RemoveSocketFile();
+    }
 
     std::cout << "IPC server stopped" << std::endl;
 }
 
-void IPCServer::ProcessMessages(int timeoutMs) {
-    if (serverFd_ == INVALID_SOCKET_VALUE) {
-        return;
-    }
+// ---------------------------------------------------------------------------
+// I/O thread
+// ---------------------------------------------------------------------------
+
+void IPCServer::IoLoop() {
+    std::vector<SocketPoller::Event> events;
+    while (true) {
+        if (poller_.Wait(events, -1) < 0) {
+#ifdef _WIN32
+            if (WSAGetLastError() != WSAEINTR) {
+#else
+            if (errno != EINTR) {
+#endif
+                std::cerr << "IPC poll error: " << GetLastErrorString() << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            continue;
+        }
 
-    // Prepare fd_set for select()
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(serverFd_, &readfds);
+        for (const SocketPoller::Event& event : events) {
+            if (event.fd == wakeReadFd_) {
+                wakePending_ = false;
+                char drain[64];
+#ifdef _WIN32
+                while (recv(wakeReadFd_, drain, sizeof(drain), 0) > 0) {
+#else
+                while (read(wakeReadFd_, drain, sizeof(drain)) > 0) {
+#endif
+                }
+                continue;
+            }
+            if (event.fd == serverFd_ || event.fd == unixServerFd_) {
+                AcceptConnections(event.fd, event.fd == unixServerFd_);
+                continue;
+            }
 
-    int maxFd = static_cast<int>(serverFd_);
-    for (socket_t fd : clients_) {
-        FD_SET(fd, &readfds);
-        maxFd = std::max(maxFd, static_cast<int>(fd));
+            auto id = connectionIds_.find(event.fd);
+            if (id == connectionIds_.end()) {
+                continue;  // Closed earlier in this batch
+            }
+            const uint64_t connectionId = id->second;
+            if (event.writable) {
+                Connection& connection = connections_.at(connectionId);
+                if (!FlushOutgoing(connection)) {
+                    CloseConnection(connection);
+                    continue;
+                }
+                if (CloseIfDone(connection)) {
+                    continue;
+                }
+                UpdateInterest(connection);
+            }
+            if (event.readable || event.hangup) {
+                ReadFrom(connections_.at(connectionId));
+            }
+        }
+
+        TakeResponses();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
     }
+}
 
-    // Set timeout
-    timeval timeout;
-    timeout.tv_sec = timeoutMs / 1000;
-    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+void IPCServer::AcceptConnections(socket_t listenFd, bool local) {
+    while (true) {
+        sockaddr_storage clientAddr{};
+        socklen_t clientLen = sizeof(clientAddr);
 
-    int activity = select(maxFd + 1, &readfds, nullptr, nullptr, &timeout);
+        socket_t clientFd = accept(listenFd, reinterpret_cast<sockaddr*>(&clientAddr), &clientLen);
+        if (clientFd == INVALID_SOCKET_VALUE) {
+#ifdef _WIN32
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+#else
+            if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
+#endif
+                std::cerr << "Accept failed: " << GetLastErrorString() << std::endl;
+            }
+            return;
+        }
 
-    if (activity < 0) {
+        if (connections_.size() >= maxClients_) {
+            std::cerr << "Max clients (" << maxClients_ << ") reached, rejecting connection" << std::endl;
+            CloseSocket(clientFd);
+            continue;
+        }
+
+        // Set client socket non-blocking
+        if (!SetNonBlocking(clientFd) || !poller_.Add(clientFd, true, false)) {
+            std::cerr << "Failed to set up client socket: " << GetLastErrorString() << std::endl;
+            CloseSocket(clientFd);
+            continue;
+        }
+
+        Connection& connection = connections_[nextConnectionId_];
+        connection.id = nextConnectionId_++;
+        connection.fd = clientFd;
+        connection.local = local;
+        connectionIds_[clientFd] = connection.id;
+        std::cout << "New IPC client connected (fd=" << clientFd << (local ? ", Unix socket" : "") << ")"
+                  << std::endl;
+    }
+}
+
+void IPCServer::ReadFrom(Connection& connection) {
+    // Read what has arrived (bounded, so one busy client cannot starve the
+    // others); the poller reports the rest next time
+    for (int chunk = 0; chunk < MAX_CHUNKS_PER_READ; ++chunk) {
+        char buffer[RECV_CHUNK_BYTES];
 #ifdef _WIN32
-        if (WSAGetLastError() != WSAEINTR) {
+        int n = recv(connection.fd, buffer, sizeof(buffer), 0);
 #else
-        if (errno != EINTR) {
+        ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
 #endif
-            std::cerr << "Select error: " << GetLastErrorString() << std::endl;
+        if (n > 0) {
+            if (!connection.received.Append(buffer, static_cast<size_t>(n))) {
+                std::cerr << "IPC request too large (fd=" << connection.fd << "), disconnecting" << std::endl;
+                CloseConnection(connection);
+                return;
+            }
+            if (n < static_cast<int>(sizeof(buffer))) {
+                break;
+            }
+            continue;
         }
-        return;
+#ifdef _WIN32
+        if (n < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
+            break;
+        }
+#else
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+            break;
+        }
+#endif
+        connection.peerClosed = true;  // Closed or failed: answer what came before
+        break;
     }
 
-    if (activity == 0) {
-        // Timeout, no activity
-        return;
+    DispatchRequests(connection);
+    if (!CloseIfDone(connection)) {
+        UpdateInterest(connection);
+    }
+}
+
+void IPCServer::DispatchRequests(Connection& connection) {
+    std::vector<InboundEvent> events;
+    std::string message;
+    while (connection.queuedRequests < MAX_QUEUED_REQUESTS && connection.received.Next(message)) {
+        if (message.empty()) {
+            continue;
+        }
+
+        const WireEncoding encoding = connection.received.GetEncoding();
+        try {
+            // Parse JSON-RPC request
+            IPCRequest request = IPCRequest::FromJson(DecodeMessage(message, encoding));
+
+            // session.hello may switch the connection to a binary encoding:
+            // what the client sends next is in it, and so is everything
+            // after the reply (which says what was chosen)
+            if (request.method == "session.hello") {
+                WireEncoding next = encoding;
+                if (request.params.is_object()) {
+                    if (auto requested = ParseWireEncoding(request.params.value("encoding", std::string()))) {
+                        next = *requested;
+                    }
+                }
+                connection.hello = std::make_pair(request.id, next);
+                connection.received.SetEncoding(next);
+            }
+
+            ++connection.queuedRequests;
+            const int64_t receivedUs = request.traceId.empty() ? 0 : RequestTrace::NowUs();
+            events.push_back({connection.id, connection.fd, encoding, connection.local, std::move(request),
+                              false, receivedUs});
+        } catch (const json::exception& e) {
+            std::cerr << "JSON parse error: " << e.what() << std::endl;
+
+            // Send error response
+            IPCResponse errorResponse;
+            errorResponse.id = 0;  // Unknown ID
+            errorResponse.error = IPCError{
+                ErrorCodes::ParseError,
+                std::string("Parse error: ") + e.what()
+            };
+            QueueResponse(connection, std::move(errorResponse));
+        }
     }
 
-    // Check for new connections
-    if (FD_ISSET(serverFd_, &readfds)) {
-        AcceptConnections();
+    if (connection.outgoingSent < connection.outgoing.size() && !FlushOutgoing(connection)) {
+        connection.peerClosed = true;
     }
 
-    // Check for client messages
-    std::vector<socket_t> clientsCopy = clients_;  // Copy to avoid iterator invalidation
-    for (socket_t fd : clientsCopy) {
-        if (FD_ISSET(fd, &readfds)) {
-            HandleClient(fd);
+    if (!events.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (InboundEvent& event : events) {
+                inbox_.push_back(std::move(event));
+            }
+        }
+        inboxReady_.notify_one();
+        if (requestCallback_) {
+            requestCallback_();
         }
     }
 }
 
-void IPCServer::AcceptConnections() {
-    sockaddr_in clientAddr{};
-    socklen_t clientLen = sizeof(clientAddr);
+void IPCServer::TakeResponses() {
+    std::deque<OutboundMessage> responses;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        responses.swap(outbox_);
+    }
 
-    socket_t clientFd = accept(serverFd_, reinterpret_cast<sockaddr*>(&clientAddr), &clientLen);
-    if (clientFd == INVALID_SOCKET_VALUE) {
-#ifdef _WIN32
-        if (WSAGetLastError() != WSAEWOULDBLOCK) {
-#else
-        if (errno != EWOULDBLOCK && errno != EAGAIN) {
-#endif
-            std::cerr << "Accept failed: " << GetLastErrorString() << std::endl;
+    std::vector<uint64_t> answered;
+    for (auto& [connectionId, response, attachedFd, notification] : responses) {
+        auto it = connections_.find(connectionId);
+        if (it == connections_.end()) {
+            CloseDescriptor(attachedFd);
+            continue;  // Gone meanwhile
+        }
+        Connection& connection = it->second;
+
+        if (notification) {
+            // A client that is not reading gets no more events meanwhile
+            if (connection.outgoing.size() - connection.outgoingSent < MAX_OUTGOING_BYTES / 2) {
+                QueueData(connection, EncodeMessage(notification->ToJson(), connection.sendEncoding), -1);
+            }
+            if (answered.empty() || answered.back() != connectionId) {
+                answered.push_back(connectionId);
+            }
+            continue;
+        }
+
+        if (connection.queuedRequests > 0) {
+            --connection.queuedRequests;
+        }
+
+        // The hello's reply goes out in the old encoding, the rest in the new
+        WireEncoding next = connection.sendEncoding;
+        if (connection.hello && connection.hello->first == response.id) {
+            if (response.result && response.result->is_object()) {
+                next = connection.hello->second;
+                (*response.result)["encoding"] = WireEncodingName(next);
+            } else {
+                connection.received.SetEncoding(next);  // Failed: the client did not switch
+            }
+            connection.hello.reset();
+        }
+        QueueResponse(connection, std::move(response), attachedFd);
+        connection.sendEncoding = next;
+
+        if (answered.empty() || answered.back() != connectionId) {
+            answered.push_back(connectionId);
         }
-        return;
     }
 
-    if (clients_.size() >= MAX_CLIENTS) {
-        std::cerr << "Max clients reached, rejecting connection" << std::endl;
-        CloseSocket(clientFd);
-        return;
+    for (uint64_t connectionId : answered) {
+        auto it = connections_.find(connectionId);
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = it->second;
+        DispatchRequests(connection);  // Requests held back by the queue limit
+        if (!FlushOutgoing(connection)) {
+            std::cerr << "Failed to send response: " << GetLastErrorString() << std::endl;
+            CloseConnection(connection);
+            continue;
+        }
+        if (!CloseIfDone(connection)) {
+            UpdateInterest(connection);
+        }
     }
+}
 
-    // Set client socket non-blocking
-    if (!SetNonBlocking(clientFd)) {
-        std::cerr << "Failed to set client non-blocking: " << GetLastErrorString() << std::endl;
-        CloseSocket(clientFd);
-        return;
+void IPCServer::QueueResponse(Connection& connection, IPCResponse response, int attachedFd) {
+    std::string data;
+    try {
+        data = EncodeMessage(response.ToJson(), connection.sendEncoding);
+    } catch (const std::exception& e) {
+        // Too large for the framing: answer with the reason instead
+        IPCResponse errorResponse;
+        errorResponse.id = response.id;
+        errorResponse.error = IPCError{ErrorCodes::InternalError, e.what()};
+        data = EncodeMessage(errorResponse.ToJson(), connection.sendEncoding);
     }
+    QueueData(connection, data, attachedFd);
+}
 
-    clients_.push_back(clientFd);
-    std::cout << "New IPC client connected (fd=" << clientFd << ")" << std::endl;
+void IPCServer::QueueData(Connection& connection, const std::string& data, int attachedFd) {
+    if (connection.outgoingSent == connection.outgoing.size()) {
+        connection.outgoing.clear();
+        connection.outgoingSent = 0;
+    }
+    if (attachedFd >= 0) {
+        connection.attachedFds.emplace_back(connection.outgoing.size(), attachedFd);
+    }
+    connection.outgoing += data;
 }
 
-void IPCServer::HandleClient(socket_t clientFd) {
-    char buffer[BUFFER_SIZE];
+bool IPCServer::FlushOutgoing(Connection& connection) {
+    while (connection.outgoingSent < connection.outgoing.size()) {
+        // A passed descriptor rides on the first byte of its message: stop
+        // short of it, then send it with that byte
+        size_t end = connection.outgoing.size();
+        int attachedFd = -1;
+        if (!connection.attachedFds.empty()) {
+            if (connection.attachedFds.front().first == connection.outgoingSent) {
+                attachedFd = connection.attachedFds.front().second;
+            } else {
+                end = connection.attachedFds.front().first;
+            }
+        }
+        size_t sent = 0;
+        if (SendWithDescriptor(connection.fd, connection.outgoing.data() + connection.outgoingSent,
+                               end - connection.outgoingSent, attachedFd, sent)) {
+            if (attachedFd >= 0 && sent > 0) {
+                CloseDescriptor(attachedFd);  // The client has its own copy now
+                connection.attachedFds.pop_front();
+            }
+            connection.outgoingSent += sent;
+            continue;
+        }
 #ifdef _WIN32
-    int n = recv(clientFd, buffer, sizeof(buffer) - 1, 0);
+        if (WSAGetLastError() == WSAEWOULDBLOCK) {
 #else
-    ssize_t n = recv(clientFd, buffer, sizeof(buffer) - 1, 0);
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
 #endif
+            break;  // The poller says when it can take more
+        }
+        return false;
+    }
 
-    if (n <= 0) {
-#ifdef _WIN32
-        if (n < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
-            return;
+    if (connection.outgoingSent == connection.outgoing.size()) {
+        connection.outgoing.clear();
+        connection.outgoingSent = 0;
+    }
+    return true;
+}
+
+void IPCServer::UpdateInterest(Connection& connection) {
+    // Backpressure: stop reading a client that is far ahead of us
+    const bool read = !connection.peerClosed &&
+                      connection.queuedRequests < MAX_QUEUED_REQUESTS &&
+                      connection.outgoing.size() - connection.outgoingSent < MAX_OUTGOING_BYTES;
+    const bool write = connection.outgoingSent < connection.outgoing.size();
+    if (read != connection.watchingRead || write != connection.watchingWrite) {
+        poller_.Modify(connection.fd, read, write);
+        connection.watchingRead = read;
+        connection.watchingWrite = write;
+    }
+}
+
+bool IPCServer::CloseIfDone(Connection& connection) {
+    if (connection.peerClosed && connection.queuedRequests == 0 &&
+        connection.outgoingSent == connection.outgoing.size()) {
+        CloseConnection(connection);
+        return true;
+    }
+    return false;
+}
+
+void IPCServer::CloseConnection(Connection& connection) {
+    const uint64_t connectionId = connection.id;
+    const socket_t fd = connection.fd;
+    std::cout << "IPC client disconnected (fd=" << fd << ")" << std::endl;
+
+    poller_.Remove(fd);
+    CloseSocket(fd);
+    for (const auto& attached : connection.attachedFds) {
+        CloseDescriptor(attached.second);
+    }
+    connectionIds_.erase(fd);
+    connections_.erase(connectionId);
+
+    // Ordered after its requests: the GUI thread answers those first
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inbox_.push_back({connectionId, fd, WireEncoding::Json, false, std::nullopt});
+    }
+    inboxReady_.notify_one();
+    if (requestCallback_) {
+        requestCallback_();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GUI thread
+// ---------------------------------------------------------------------------
+
+bool IPCServer::ProcessMessages(int timeoutMs) {
+    if (!IsRunning()) {
+        return false;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + frameBudget_;
+    bool handled = SendDeferredResponses();
+
+    std::deque<InboundEvent> events;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (inbox_.empty() && !handled && !overBudgetLast_ && timeoutMs > 0) {
+            inboxReady_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                 [this]() { return !inbox_.empty(); });
         }
-#else
-        if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
-            return;
+        events.swap(inbox_);
+    }
+
+    for (InboundEvent& event : events) {
+        handled = true;
+        const uint64_t connectionId = event.connectionId;
+        if (event.request) {
+            clientIds_[event.fd] = connectionId;
+            auto [it, inserted] = clients_.try_emplace(connectionId);
+            if (inserted) {
+                it->second.fd = event.fd;
+            }
+            it->second.requests.push_back(std::move(event));
+            continue;
+        }
+
+        // Disconnected: answer what came before, then forget it
+        HandleQueuedRequests(connectionId);
+        RemoveClient(connectionId, event.fd);
+    }
+
+    return HandleReadyRequests(deadline) || handled;
+}
+
+bool IPCServer::HandleReadyRequests(std::chrono::steady_clock::time_point deadline) {
+    overBudgetLast_ = false;
+    bool handled = false;
+    for (RequestPriority priority : {RequestPriority::Interactive, RequestPriority::Normal,
+                                     RequestPriority::Background}) {
+        for (bool progress = true; progress; ) {
+            // A round: one request from each client, starting after the
+            // one served last so none is always first
+            std::vector<uint64_t> round;
+            for (const auto& [connectionId, queue] : clients_) {
+                if (SessionOf(connectionId).priority == priority) {
+                    round.push_back(connectionId);
+                }
+            }
+            std::rotate(round.begin(), std::upper_bound(round.begin(), round.end(), lastServed_), round.end());
+
+            progress = false;
+            for (uint64_t connectionId : round) {
+                if (handled && frameBudget_.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+                    ++overBudget_;  // The rest wait for the next frame
+                    overBudgetLast_ = true;
+                    return true;
+                }
+                if (HandleNextRequest(connectionId, true)) {
+                    lastServed_ = connectionId;
+                    handled = progress = true;
+                }
+            }
         }
+    }
+    return handled;
+}
+
+bool IPCServer::HandleNextRequest(uint64_t connectionId, bool limited) {
+    auto it = clients_.find(connectionId);
+    if (it == clients_.end()) {
+        return false;
+    }
+
+    // A deferred request holds back the ones after it
+    std::deque<InboundEvent>& requests = it->second.requests;
+    if (HasDeferredResponse(connectionId) || requests.empty()) {
+        return false;
+    }
+    Session& session = SessionOf(connectionId);
+    if (limited && !TakeTokens(session, RequestCost(*requests.front().request))) {
+        if (!requests.front().throttled) {
+            requests.front().throttled = true;
+            ++session.throttled;
+            ++throttledTotal_;
+        }
+        return false;
+    }
+
+    InboundEvent event = std::move(requests.front());
+    requests.pop_front();
+    const IPCRequest& request = *event.request;
+    if (request.method == "session.hello") {
+        JoinSession(connectionId, request);
+    }
+    ++SessionOf(connectionId).executed;
+    ++executedTotal_;
+
+    // Set current client for handler
+    currentClientFd_ = event.fd;
+    currentEncoding_ = event.encoding;
+#ifndef _WIN32
+    currentClientLocal_ = event.local;
 #endif
-        // Client disconnected or error
-        std::cout << "IPC client disconnected (fd=" << clientFd << ")" << std::endl;
-        RemoveClient(clientFd);
-        return;
+
+    // Handle request, timed if the client traces it
+    if (!request.traceId.empty()) {
+        currentTrace_ = std::make_shared<RequestTrace>(request.traceId, TRACE_PROCESS);
+        currentTrace_->Add("ipc.queue", event.receivedUs, RequestTrace::NowUs());
+    }
+    RequestTrace::Scope handleSpan(currentTrace_.get(), request.method);
+    IPCResponse response = HandleRequest(request);
+    handleSpan.End();
+    std::shared_ptr<RequestTrace> trace = std::move(currentTrace_);
+
+    currentClientFd_ = INVALID_SOCKET_VALUE;
+    currentEncoding_ = WireEncoding::Json;
+    currentClientLocal_ = false;
+    const int attachedFd = currentAttachedFd_;
+    currentAttachedFd_ = -1;
+
+    if (request.method == "session.hello" && response.result && response.result->is_object()) {
+        (*response.result)["priority"] = RequestPriorityName(SessionOf(connectionId).priority);
     }
 
-    buffer[n] = '\0';
+    // Answered by a later ProcessMessages() (unless the handler failed
+    // after deferring)
+    std::shared_ptr<BatchState> batch = std::move(currentBatch_);
+    bool deferred = false;
+    if (currentDeferred_.valid()) {
+        std::future<json> result = std::move(currentDeferred_);
+        if (!response.error) {
+            deferred_.push_back({connectionId, request.id, std::move(result), attachedFd, std::move(batch),
+                                 trace, trace ? RequestTrace::NowUs() : 0});
+            deferred = true;
+        }
+    }
+    if (!deferred) {
+        if (trace) {
+            response.trace = trace->ToJson();
+        }
+        PostResponse(connectionId, std::move(response), attachedFd);
+    }
 
-    try {
-        // Parse JSON-RPC request
-        json requestJson = json::parse(buffer);
-        IPCRequest request = IPCRequest::FromJson(requestJson);
+    if (requests.empty() && !HasDeferredResponse(connectionId)) {
+        clients_.erase(it);  // Nothing pending: recreated by its next request
+    }
+    return true;
+}
 
-        // Set current client FD for handler
-        currentClientFd_ = clientFd;
+void IPCServer::HandleQueuedRequests(uint64_t connectionId) {
+    while (HandleNextRequest(connectionId, false)) {
+    }
+}
 
-        // Handle request
-        IPCResponse response = HandleRequest(request);
+IPCServer::Session& IPCServer::SessionOf(uint64_t connectionId) {
+    auto [it, inserted] = connectionSessions_.try_emplace(connectionId);
+    if (inserted) {
+        it->second.name = "connection-" + std::to_string(connectionId);
+        ++sessions_[it->second.name].connections;
+    }
+    return sessions_[it->second.name];
+}
 
-        // Clear current client FD
-        currentClientFd_ = INVALID_SOCKET_VALUE;
+bool IPCServer::TakeTokens(Session& session, double cost) {
+    const RateLimit& limit = rateLimits_[size_t(session.priority)];
+    if (limit.requestsPerSecond <= 0.0) {
+        return true;
+    }
 
-        // Send response
-        std::string responseStr = response.ToJson().dump();
-        responseStr += "\n";  // Add newline delimiter
+    // Refill for the time since the last request, up to the burst; a
+    // batch larger than the burst waits for a full bucket
+    const double burst = std::max(1.0, limit.burst);
+    const auto now = std::chrono::steady_clock::now();
+    if (session.tokens < 0.0) {
+        session.tokens = burst;
+    } else {
+        const double seconds = std::chrono::duration<double>(now - session.refilled).count();
+        session.tokens = std::min(burst, session.tokens + seconds * limit.requestsPerSecond);
+    }
+    session.refilled = now;
 
-        if (!SendAll(clientFd, responseStr, 5000)) {
-            std::cerr << "Failed to send response: " << GetLastErrorString() << std::endl;
-            RemoveClient(clientFd);
+    cost = std::min(cost, burst);
+    if (session.tokens < cost) {
+        return false;
+    }
+    session.tokens -= cost;
+    return true;
+}
+
+void IPCServer::JoinSession(uint64_t connectionId, const IPCRequest& hello) {
+    if (!hello.params.is_object()) {
+        return;
+    }
+    SessionOf(connectionId);
+    SessionRef& ref = connectionSessions_[connectionId];
+
+    // The first hello naming a session moves the connection there; later
+    // ones cannot leave it (a new name would be a fresh bucket)
+    const std::string name = hello.params.value("session_id", std::string());
+    if (!ref.named && !name.empty()) {
+        const Session old = sessions_[ref.name];
+        if (--sessions_[ref.name].connections == 0) {
+            sessions_.erase(ref.name);
+        }
+        // A new session starts from the connection's bucket, so a hello
+        // does not refill it
+        auto [it, inserted] = sessions_.try_emplace(name);
+        if (inserted) {
+            it->second.priority = old.priority;
+            it->second.tokens = old.tokens;
+            it->second.refilled = old.refilled;
         }
-    } catch (const json::exception& e) {
-        std::cerr << "JSON parse error: " << e.what() << std::endl;
+        ++it->second.connections;
+        ref.name = name;
+        ref.named = true;
+    }
+    if (auto priority = ParseRequestPriority(hello.params.value("priority", std::string()))) {
+        sessions_[ref.name].priority = *priority;
+    }
+}
 
-        // Send error response
-        IPCResponse errorResponse;
-        errorResponse.id = 0;  // Unknown ID
-        errorResponse.error = IPCError{
-            ErrorCodes::ParseError,
-            std::string("Parse error: ") + e.what()
-        };
+void IPCServer::SetRateLimit(RequestPriority priority, RateLimit limit) {
+    rateLimits_[size_t(priority)] = limit;
+}
 
-        std::string responseStr = errorResponse.ToJson().dump() + "\n";
-        SendAll(clientFd, responseStr, 5000);
-    } catch (const std::exception& e) {
-        std::cerr << "IPC error: " << e.what() << std::endl;
+IPCServer::Stats IPCServer::GetStats() const {
+    Stats stats;
+    stats.throttled = throttledTotal_;
+    stats.executed = executedTotal_;
+    stats.overBudget = overBudget_;
+
+    std::map<std::string, size_t> queued;
+    for (const auto& [connectionId, queue] : clients_) {
+        auto ref = connectionSessions_.find(connectionId);
+        if (ref != connectionSessions_.end()) {
+            queued[ref->second.name] += queue.requests.size();
+        }
+        stats.queued += queue.requests.size();
+    }
+    for (const auto& [name, session] : sessions_) {
+        stats.sessions.push_back({name, session.priority, session.connections, queued[name],
+                                  session.throttled, session.executed});
     }
+    return stats;
 }
 
-void IPCServer::RemoveClient(socket_t clientFd) {
-    CloseSocket(clientFd);
-    clients_.erase(std::remove(clients_.begin(), clients_.end(), clientFd), clients_.end());
+void IPCServer::RemoveClient(uint64_t connectionId, socket_t clientFd) {
+    clients_.erase(connectionId);
+    auto ref = connectionSessions_.find(connectionId);
+    if (ref != connectionSessions_.end()) {
+        auto session = sessions_.find(ref->second.name);
+        if (session != sessions_.end() && --session->second.connections == 0) {
+            sessions_.erase(session);
+        }
+        connectionSessions_.erase(ref);
+    }
+    auto id = clientIds_.find(clientFd);
+    if (id != clientIds_.end() && id->second == connectionId) {
+        clientIds_.erase(id);
+    }
+
+    // Results nobody will read are dropped when they finish
+    deferred_.erase(std::remove_if(deferred_.begin(), deferred_.end(),
+                                   [connectionId](const DeferredResponse& entry) {
+                                       if (entry.connectionId != connectionId) {
+                                           return false;
+                                       }
+                                       CloseDescriptor(entry.attachedFd);
+                                       return true;
+                                   }),
+                    deferred_.end());
 
     if (disconnectCallback_) {
         disconnectCallback_(clientFd);
@@ -420,6 +1266,29 @@ IPCResponse IPCServer::HandleRequest(const IPCRequest& request) {
     response.id = request.id;
 
     try {
+        if (request.method == BATCH_METHOD) {
+            if (!request.params.is_object() || !request.params.contains("steps") ||
+                !request.params["steps"].is_array()) {
+                throw std::runtime_error("batch needs a steps array");
+            }
+            if (request.params["steps"].size() > MAX_BATCH_STEPS) {
+                throw std::runtime_error("batch takes at most " + std::to_string(MAX_BATCH_STEPS) + " steps");
+            }
+            auto batch = std::make_shared<BatchState>();
+            batch->steps = request.params["steps"];
+            batch->continueOnError = request.params.value("continue_on_error", false);
+            batch->fd = currentClientFd_;
+            batch->encoding = currentEncoding_;
+            batch->local = currentClientLocal_;
+            RunBatch(*batch);
+            if (currentDeferred_.valid()) {
+                currentBatch_ = std::move(batch);
+            } else {
+                response.result = json{{"results", std::move(batch->results)}};
+            }
+            return response;
+        }
+
         // Call the application's command handler
         json result = handler_(request.method, request.params);
         response.result = result;
@@ -434,5 +1303,158 @@ IPCResponse IPCServer::HandleRequest(const IPCRequest& request) {
     return response;
 }
 
+void IPCServer::Defer(std::future<json> result) {
+    currentDeferred_ = std::move(result);
+}
+
+bool IPCServer::AttachDescriptor(int fd) {
+#ifdef _WIN32
+    (void)fd;
+    return false;
+#else
+    if (!currentClientLocal_ || fd < 0) {
+        return false;
+    }
+    int copy = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (copy < 0) {
+        return false;
+    }
+    CloseDescriptor(currentAttachedFd_);  // One per response
+    currentAttachedFd_ = copy;
+    return true;
+#endif
+}
+
+bool IPCServer::HasDeferredResponse(uint64_t connectionId) const {
+    return std::any_of(deferred_.begin(), deferred_.end(),
+                       [connectionId](const DeferredResponse& entry) { return entry.connectionId == connectionId; });
+}
+
+void IPCServer::PostResponse(uint64_t connectionId, IPCResponse response, int attachedFd) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outbox_.push_back({connectionId, std::move(response), attachedFd, std::nullopt});
+    }
+    Wake();
+}
+
+bool IPCServer::Notify(socket_t clientFd, const std::string& method, const json& params) {
+    auto id = clientIds_.find(clientFd);
+    if (id == clientIds_.end()) {
+        return false;
+    }
+    IPCNotification notification;
+    notification.method = method;
+    notification.params = params;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outbox_.push_back({id->second, IPCResponse{}, -1, std::move(notification)});
+    }
+    Wake();
+    return true;
+}
+
+void IPCServer::RunBatch(BatchState& batch) {
+    while (batch.next < batch.steps.size()) {
+        const size_t step = batch.next++;
+        json result;
+        try {
+            const json& entry = batch.steps[step];
+            if (!entry.is_object() || !entry.contains("method") || !entry["method"].is_string()) {
+                throw std::runtime_error("Each step needs a method");
+            }
+            const std::string method = entry["method"].get<std::string>();
+            // A hello would switch the encoding mid-response
+            if (method == BATCH_METHOD || method == "session.hello") {
+                throw std::runtime_error(method + " cannot be a batch step");
+            }
+            RequestTrace::Scope stepSpan(currentTrace_.get(), method);
+            result = handler_(method, ResolveReferences(entry.value("params", json::object()),
+                                                        batch.results, step));
+        } catch (const std::exception& e) {
+            currentDeferred_ = std::future<json>();  // Failed after deferring
+            batch.results.push_back({{"error", e.what()}});
+            if (!batch.continueOnError) {
+                batch.next = batch.steps.size();
+            }
+            continue;
+        }
+        if (currentDeferred_.valid()) {
+            return;  // Resumed by SendDeferredResponses() with its result
+        }
+        batch.results.push_back({{"result", std::move(result)}});
+    }
+}
+
+bool IPCServer::SendDeferredResponses() {
+    std::vector<DeferredResponse> ready;
+    for (auto it = deferred_.begin(); it != deferred_.end(); ) {
+        if (it->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            ready.push_back(std::move(*it));
+            it = deferred_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (DeferredResponse& entry : ready) {
+        IPCResponse response;
+        response.id = entry.id;
+        int attachedFd = entry.attachedFd;
+        if (entry.trace) {
+            entry.trace->Add("ipc.deferred", entry.deferredUs, RequestTrace::NowUs());
+        }
+        if (entry.batch) {
+            // The deferred step's result, then the steps after it
+            BatchState& batch = *entry.batch;
+            try {
+                batch.results.push_back({{"result", entry.result.get()}});
+            } catch (const std::exception& e) {
+                batch.results.push_back({{"error", e.what()}});
+                if (!batch.continueOnError) {
+                    batch.next = batch.steps.size();
+                }
+            }
+
+            currentClientFd_ = batch.fd;
+            currentEncoding_ = batch.encoding;
+            currentClientLocal_ = batch.local;
+            currentAttachedFd_ = attachedFd;
+            currentTrace_ = entry.trace;
+            RunBatch(batch);
+            currentTrace_.reset();
+            currentClientFd_ = INVALID_SOCKET_VALUE;
+            currentEncoding_ = WireEncoding::Json;
+            currentClientLocal_ = false;
+            attachedFd = currentAttachedFd_;
+            currentAttachedFd_ = -1;
+
+            if (currentDeferred_.valid()) {
+                const int64_t deferredUs = entry.trace ? RequestTrace::NowUs() : 0;
+                deferred_.push_back({entry.connectionId, entry.id, std::move(currentDeferred_), attachedFd,
+                                     std::move(entry.batch), std::move(entry.trace), deferredUs});
+                continue;
+            }
+            response.result = json{{"results", std::move(batch.results)}};
+        } else {
+            try {
+                response.result = entry.result.get();
+            } catch (const std::exception& e) {
+                response.error = IPCError{
+                    ErrorCodes::InternalError,
+                    e.what()
+                };
+            }
+        }
+        if (entry.trace) {
+            response.trace = entry.trace->ToJson();
+        }
+        PostResponse(entry.connectionId, std::move(response), attachedFd);
+        // Requests it pipelined behind this one run in the next round
+    }
+
+    return !ready.empty();
+}
+
 } // namespace ipc
 } // namespace pathview
@@ -1,24 +1,23 @@
 #pragma once
 
 #include "IPCMessage.h"
+#include "RequestTrace.h"
+#include "SocketPoller.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <string>
 
-// Cross-platform socket includes
-#ifdef _WIN32
-    #ifndef WIN32_LEAN_AND_MEAN
-        #define WIN32_LEAN_AND_MEAN
-    #endif
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    using socket_t = SOCKET;
-    #define INVALID_SOCKET_VALUE INVALID_SOCKET
-#else
-    using socket_t = int;
-    #define INVALID_SOCKET_VALUE (-1)
-#endif
-
 namespace pathview {
 namespace ipc {
 
@@ -35,9 +34,79 @@ using CommandHandler = std::function<json(const std::string& method, const json&
 using DisconnectCallback = std::function<void(socket_t clientFd)>;
 
 /**
- * TCP socket server for IPC
- * Non-blocking, integrates with GUI event loop
+ * Scheduling class of a session's requests, named by session.hello's
+ * "priority": each frame handles interactive sessions' requests first and
+ * background ones last
+ */
+enum class RequestPriority {
+    Interactive,
+    Normal,
+    Background
+};
+
+const char* RequestPriorityName(RequestPriority priority);
+std::optional<RequestPriority> ParseRequestPriority(const std::string& name);
+
+/**
+ * Token bucket of a session: requests per second, and how many may come at
+ * once after a quiet spell. 0 requests per second is unlimited
+ */
+struct RateLimit {
+    double requestsPerSecond = 0.0;
+    double burst = 0.0;  // At least 1
+};
+
+/**
+ * Socket server for IPC
  * Cross-platform: works on Windows (Winsock) and Unix (BSD sockets)
+ *
+ * Listens on localhost TCP and on a Unix domain socket (AF_UNIX, also on
+ * Windows 10+), found through a port file and a socket-path file. The
+ * Unix socket skips the TCP stack, is private to the user (mode 0600),
+ * needs no free port, so several viewers can run at once, and on POSIX
+ * can carry file descriptors with a response (AttachDescriptor()).
+ *
+ * A dedicated I/O thread accepts connections, reads, frames and parses
+ * requests and serializes and writes responses, waiting on a SocketPoller
+ * (epoll / poll), so clients are served whatever the frame rate. Command
+ * handlers run on the GUI thread in ProcessMessages(), since they touch
+ * viewer state; slow work goes on to a CommandExecutor through Defer().
+ *
+ * Requests and responses are JSON-RPC, newline-framed JSON until the
+ * client picks a binary encoding with session.hello (see WireEncoding).
+ * Each client's bytes are reassembled however TCP split them, and a client
+ * may pipeline: requests sent without waiting are handled one after
+ * another, in order, and answered in that order.
+ *
+ * Backpressure: a client with MAX_QUEUED_REQUESTS unanswered requests, or
+ * more than MAX_OUTGOING_BYTES of responses it has not read, is not read
+ * from until it catches up.
+ *
+ * Scheduling: requests run inside the GUI frame, so ProcessMessages()
+ * stops starting new ones once it has spent the frame budget (at least one
+ * runs per call) and leaves the rest for the next frame. Requests are
+ * grouped by session: a connection joins the session its first
+ * session.hello names ("session_id"), else it is a session of its own. The
+ * session's RequestPriority decides which go first; within a priority the
+ * sessions take turns, one request each. A session past its RateLimit
+ * keeps its requests queued (still in order, and backpressured as above)
+ * until its bucket refills. GetStats() counts queued, throttled and
+ * executed requests.
+ *
+ * The server itself answers "batch": {"steps": [{"method", "params"}, ...]}
+ * runs the steps in order in one round trip and answers {"results": [...]},
+ * each {"result": ...} or {"error": "..."}. A step's params may take an
+ * earlier step's result: a string "$2.token" is replaced by step 2's
+ * "token" ("$prev" for the step before, a path of keys and array indices;
+ * "$$" escapes a leading "$"). A step that defers holds the rest until its
+ * result is ready. The first failing step ends the batch unless
+ * "continue_on_error" is set.
+ *
+ * Tracing: a request with a trace_id is timed as RequestTrace spans
+ * ("ipc.queue" from its arrival to its turn, one named after the method
+ * for the handler and after each batch step for the step, "ipc.deferred"
+ * until a deferred result was ready) plus any the handler adds through
+ * GetCurrentTrace(), and answered with them.
  */
 class IPCServer {
 public:
@@ -50,8 +119,10 @@ public:
 
     /**
      * Start the IPC server
-     * Binds to localhost on a specific port
-     * Writes port number to a file for discovery
+     * Binds to localhost on a specific port and to the Unix socket, starts
+     * the I/O thread. Writes the port number and socket path to files for
+     * discovery. Either listener is enough: a port already taken by another
+     * viewer leaves the Unix socket.
      * @return true on success
      */
     bool Start();
@@ -63,64 +134,354 @@ public:
     void Stop();
 
     /**
-     * Process pending IPC messages (non-blocking)
-     * Should be called from the GUI event loop
-     * @param timeoutMs Maximum time to spend processing (milliseconds)
+     * Handle requests the I/O thread has received (call on the GUI thread,
+     * from the event loop) and hand finished deferred responses back to it
+     * @param timeoutMs How long to wait for a request if none is queued
+     * @return true if a request, deferred response or disconnect was handled
      */
-    void ProcessMessages(int timeoutMs);
+    bool ProcessMessages(int timeoutMs);
 
     /**
      * Check if server is running
      */
-    bool IsRunning() const { return serverFd_ != INVALID_SOCKET_VALUE; }
+    bool IsRunning() const {
+        return serverFd_ != INVALID_SOCKET_VALUE || unixServerFd_ != INVALID_SOCKET_VALUE;
+    }
 
     /**
      * Get the port number the server is listening on
      */
     int GetPort() const { return port_; }
 
+    /**
+     * Unix socket to listen on (set before Start()); empty for TCP only.
+     * Defaults to DefaultSocketPath()
+     */
+    void SetSocketPath(const std::string& path) { socketPath_ = path; }
+    const std::string& GetSocketPath() const { return socketPath_; }
+
+    /**
+     * <temp dir>/pathview-<pid>.sock: one per viewer process
+     */
+    static std::string DefaultSocketPath();
+
     /**
      * Get the port file path (for client discovery)
      */
     std::string GetPortFilePath() const;
 
     /**
-     * Set callback for client disconnections
+     * Get the file naming the Unix socket (for client discovery)
+     */
+    static std::string GetSocketFilePath();
+
+    /**
+     * Set callback for client disconnections (runs on the GUI thread)
      */
     void SetDisconnectCallback(DisconnectCallback callback) {
         disconnectCallback_ = callback;
     }
 
+    /**
+     * Set callback run on the I/O thread when requests arrive, e.g. to wake
+     * an event loop sleeping until input
+     */
+    void SetRequestCallback(std::function<void()> callback) {
+        requestCallback_ = std::move(callback);
+    }
+
+    /**
+     * Most clients connected at once (set before Start())
+     */
+    void SetMaxClients(size_t maxClients) { maxClients_ = maxClients; }
+    size_t GetMaxClients() const { return maxClients_; }
+
     /**
      * Get client FD for current request (called during HandleRequest)
      */
     socket_t GetCurrentClientFd() const { return currentClientFd_; }
 
+    /**
+     * Get the wire encoding of the current request's client (called during
+     * HandleRequest), e.g. to send bulk arrays as binary
+     */
+    WireEncoding GetCurrentEncoding() const { return currentEncoding_; }
+
+    /**
+     * Check if the current request's client can be sent file descriptors
+     * (called during HandleRequest): connected over the Unix socket, POSIX
+     */
+    bool CanPassDescriptors() const { return currentClientLocal_; }
+
+    /**
+     * Send a duplicate of fd with the current request's response, deferred
+     * or not (called during HandleRequest; see CanPassDescriptors()). The
+     * client takes it with IPCClient::TakePassedFd().
+     * @return false if it cannot be passed
+     */
+    bool AttachDescriptor(int fd);
+
+    /**
+     * Answer the current request later (called during HandleRequest)
+     * The handler's return value is ignored; the response is sent by a
+     * later ProcessMessages() once result is ready, an exception becoming
+     * an error response. The client's later requests are queued but not
+     * handled meanwhile, so they still see its effects and are answered
+     * in order.
+     */
+    void Defer(std::future<json> result);
+
+    /**
+     * Trace of the current request (called during HandleRequest), null if
+     * it is not traced. Handlers time their steps with RequestTrace::Scope,
+     * and a deferred job keeps the pointer to time its own: the response
+     * carries the spans recorded until its result is ready.
+     */
+    std::shared_ptr<RequestTrace> GetCurrentTrace() const { return currentTrace_; }
+
+    /**
+     * Push a notification (no id, no answer) to a client, e.g. an event it
+     * subscribed to (call on the GUI thread). Dropped while the client has
+     * not read MAX_OUTGOING_BYTES / 2 of earlier messages: events describe
+     * the latest state, so a later one makes up for it.
+     * @param clientFd As GetCurrentClientFd() gave it
+     * @return false if the client is not connected
+     */
+    bool Notify(socket_t clientFd, const std::string& method, const json& params);
+
+    /**
+     * Rate limit of the sessions with a priority (GUI thread). A batch
+     * costs one request per step
+     */
+    void SetRateLimit(RequestPriority priority, RateLimit limit);
+    RateLimit GetRateLimit(RequestPriority priority) const { return rateLimits_[size_t(priority)]; }
+
+    /**
+     * Time ProcessMessages() may spend handling requests (GUI thread); 0
+     * for no limit
+     */
+    void SetFrameBudget(std::chrono::microseconds budget) { frameBudget_ = budget; }
+    std::chrono::microseconds GetFrameBudget() const { return frameBudget_; }
+
+    struct SessionStats {
+        std::string session;  // Its session_id, or "connection-N" before a hello names one
+        RequestPriority priority = RequestPriority::Normal;
+        size_t connections = 0;
+        size_t queued = 0;       // Received, not yet handled
+        uint64_t throttled = 0;  // Requests its rate limit held back
+        uint64_t executed = 0;
+    };
+
+    struct Stats {
+        size_t queued = 0;
+        uint64_t throttled = 0;
+        uint64_t executed = 0;
+        uint64_t overBudget = 0;  // ProcessMessages() calls that left requests for the next
+        std::vector<SessionStats> sessions;  // Connected ones
+    };
+
+    /**
+     * Request counters, over the server's lifetime and per connected
+     * session (GUI thread)
+     */
+    Stats GetStats() const;
+
+    /**
+     * Check if deferred responses are still waiting for their results
+     */
+    bool HasDeferredResponses() const { return !deferred_.empty(); }
+
     // Default port for IPC communication
     static constexpr int DEFAULT_PORT = 9999;
+    // Agents plus monitoring; each idle connection costs a few KB
+    static constexpr size_t DEFAULT_MAX_CLIENTS = 64;
+    static constexpr size_t MAX_QUEUED_REQUESTS = 256;
+    static constexpr size_t MAX_OUTGOING_BYTES = 2 * MessageBuffer::MAX_MESSAGE_BYTES;
+    static constexpr const char* BATCH_METHOD = "batch";
+    static constexpr size_t MAX_BATCH_STEPS = 64;
+    // A quarter of a 60 Hz frame
+    static constexpr std::chrono::microseconds DEFAULT_FRAME_BUDGET{4000};
+    // Background sessions by default; the others are unlimited
+    static constexpr double DEFAULT_BACKGROUND_RATE = 20.0;
+    // Process of the spans the server records
+    static constexpr const char* TRACE_PROCESS = "pathview";
 
 private:
-    void AcceptConnections();
-    void HandleClient(socket_t clientFd);
-    void RemoveClient(socket_t clientFd);
+    // Connection state owned by the I/O thread
+    struct Connection {
+        uint64_t id = 0;
+        socket_t fd = INVALID_SOCKET_VALUE;
+        MessageBuffer received;
+        std::string outgoing;
+        size_t outgoingSent = 0;
+        WireEncoding sendEncoding = WireEncoding::Json;
+        std::optional<std::pair<int, WireEncoding>> hello;  // Request id, encoding its reply switches to
+        size_t queuedRequests = 0;  // Passed to the GUI thread, not yet answered
+        bool peerClosed = false;    // Answer what came before, then close
+        bool watchingRead = true;
+        bool watchingWrite = false;
+        bool local = false;  // Unix socket
+        std::deque<std::pair<size_t, int>> attachedFds;  // Offset in outgoing of the message to carry it
+    };
+
+    // Passed from the I/O thread to the GUI thread
+    struct InboundEvent {
+        uint64_t connectionId;
+        socket_t fd;
+        WireEncoding encoding;
+        bool local;
+        std::optional<IPCRequest> request;  // Empty: the client disconnected
+        bool throttled = false;  // Counted once however long it waits
+        int64_t receivedUs = 0;  // Traced requests: when the I/O thread parsed it
+    };
+
+    // Passed from the GUI thread to the I/O thread
+    struct OutboundMessage {
+        uint64_t connectionId;
+        IPCResponse response;
+        int attachedFd;  // Owned; -1 for none
+        std::optional<IPCNotification> notification;  // Sent instead of response
+    };
+
+    // Requests the GUI thread has yet to handle, per client
+    struct ClientQueue {
+        socket_t fd = INVALID_SOCKET_VALUE;
+        std::deque<InboundEvent> requests;
+    };
+
+    // A batch between its steps, kept while one of them is deferred
+    struct BatchState {
+        json steps;
+        json results = json::array();
+        size_t next = 0;  // Step to run next
+        bool continueOnError = false;
+        socket_t fd = INVALID_SOCKET_VALUE;  // The client's, restored for the steps resumed later
+        WireEncoding encoding = WireEncoding::Json;
+        bool local = false;
+    };
+
+    // Connections sharing a session_id share its priority and token bucket
+    struct Session {
+        RequestPriority priority = RequestPriority::Normal;
+        double tokens = -1.0;  // Below 0 until first used: a full bucket
+        std::chrono::steady_clock::time_point refilled;
+        size_t connections = 0;
+        uint64_t throttled = 0;
+        uint64_t executed = 0;
+    };
+
+    struct SessionRef {
+        std::string name;
+        bool named = false;  // By the connection's hello, which it keeps
+    };
+
+    struct DeferredResponse {
+        uint64_t connectionId;
+        int id;
+        std::future<json> result;
+        int attachedFd;
+        std::shared_ptr<BatchState> batch;  // Set when result is a batch step's
+        std::shared_ptr<RequestTrace> trace;  // Traced requests
+        int64_t deferredUs = 0;
+    };
+
+    // I/O thread
+    void IoLoop();
+    void AcceptConnections(socket_t listenFd, bool local);
+    void ReadFrom(Connection& connection);
+    void DispatchRequests(Connection& connection);
+    void TakeResponses();
+    void QueueResponse(Connection& connection, IPCResponse response, int attachedFd = -1);
+    void QueueData(Connection& connection, const std::string& data, int attachedFd);
+    bool FlushOutgoing(Connection& connection);  // false: the socket failed
+    void UpdateInterest(Connection& connection);
+    bool CloseIfDone(Connection& connection);
+    void CloseConnection(Connection& connection);
+
+    // GUI thread
+    // Handle clients' requests by priority and in turns until the budget is spent
+    bool HandleReadyRequests(std::chrono::steady_clock::time_point deadline);
+    // Handle the client's next request unless a deferred one or (if limited)
+    // its session's rate limit holds it back
+    bool HandleNextRequest(uint64_t connectionId, bool limited);
+    // Handle all of them, without limits (before the client is removed)
+    void HandleQueuedRequests(uint64_t connectionId);
+    Session& SessionOf(uint64_t connectionId);
+    bool TakeTokens(Session& session, double cost);
+    void JoinSession(uint64_t connectionId, const IPCRequest& hello);
+    void RemoveClient(uint64_t connectionId, socket_t clientFd);
     IPCResponse HandleRequest(const IPCRequest& request);
-    
+    // Run batch steps from next until the last or one defers (left in currentDeferred_)
+    void RunBatch(BatchState& batch);
+    bool SendDeferredResponses();
+    bool HasDeferredResponse(uint64_t connectionId) const;
+    void PostResponse(uint64_t connectionId, IPCResponse response, int attachedFd);
+
+    void Wake();
+
     // Platform-specific helpers
     static bool SetNonBlocking(socket_t fd);
     static void CloseSocket(socket_t fd);
     static std::string GetLastErrorString();
+    static bool CreateWakePair(socket_t& readEnd, socket_t& writeEnd);
+    static void CloseDescriptor(int fd);
+    static bool SendWithDescriptor(socket_t fd, const char* data, size_t size, int attachedFd, size_t& sent);
+    bool ListenTcp();
+    bool ListenUnix();
     void WritePortFile();
     void RemovePortFile();
+    void WriteSocketFile();
+    void RemoveSocketFile();
 
     CommandHandler handler_;
     socket_t serverFd_;
+    socket_t unixServerFd_ = INVALID_SOCKET_VALUE;
     int port_;
-    std::vector<socket_t> clients_;
+    std::string socketPath_;
+    size_t maxClients_ = DEFAULT_MAX_CLIENTS;
     DisconnectCallback disconnectCallback_;
+    std::function<void()> requestCallback_;
+
+    // I/O thread
+    std::thread ioThread_;
+    SocketPoller poller_;
+    socket_t wakeReadFd_ = INVALID_SOCKET_VALUE;   // Readable once Wake() was called
+    socket_t wakeWriteFd_ = INVALID_SOCKET_VALUE;
+    std::atomic<bool> wakePending_{false};
+    std::map<uint64_t, Connection> connections_;
+    std::map<socket_t, uint64_t> connectionIds_;
+    uint64_t nextConnectionId_ = 1;
+
+    // Shared between the threads
+    std::mutex mutex_;
+    std::condition_variable inboxReady_;
+    std::deque<InboundEvent> inbox_;
+    std::deque<OutboundMessage> outbox_;
+    bool stopping_ = false;
+
+    // GUI thread
+    std::map<uint64_t, ClientQueue> clients_;
+    std::map<socket_t, uint64_t> clientIds_;  // Connected clients seen by this thread
     socket_t currentClientFd_;  // Set during HandleRequest
+    WireEncoding currentEncoding_ = WireEncoding::Json;
+    bool currentClientLocal_ = false;
+    std::future<json> currentDeferred_;  // Set by Defer() during HandleRequest
+    int currentAttachedFd_ = -1;         // Set by AttachDescriptor() during HandleRequest
+    std::shared_ptr<BatchState> currentBatch_;  // Set by a batch request that deferred
+    std::shared_ptr<RequestTrace> currentTrace_;  // Set during a traced request's HandleRequest
+    std::vector<DeferredResponse> deferred_;
+    std::map<std::string, Session> sessions_;
+    std::map<uint64_t, SessionRef> connectionSessions_;  // Until the client disconnects
+    RateLimit rateLimits_[3] = {{}, {}, {DEFAULT_BACKGROUND_RATE, DEFAULT_BACKGROUND_RATE}};
+    std::chrono::microseconds frameBudget_ = DEFAULT_FRAME_BUDGET;
+    uint64_t lastServed_ = 0;  // Connection served last, for turns across frames
+    uint64_t throttledTotal_ = 0;
+    uint64_t executedTotal_ = 0;
+    uint64_t overBudget_ = 0;
+    bool overBudgetLast_ = false;  // Requests left over: the next call need not wait
 
-    static constexpr int MAX_CLIENTS = 5;
-    static constexpr int BUFFER_SIZE = 65536;  // 64KB buffer for messages
+    static constexpr int RECV_CHUNK_BYTES = 65536;
+    static constexpr int MAX_CHUNKS_PER_READ = 16;  // Then the other clients get a turn
 
 #ifdef _WIN32
     static bool wsaInitialized_;
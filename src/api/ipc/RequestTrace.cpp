@@ -0,0 +1,133 @@
+#include "RequestTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+
+namespace pathview {
+namespace ipc {
+
+namespace {
+
+// Numbered as threads first record, for Chrome's per-thread rows
+int ThreadIndex() {
+    static std::atomic<int> next{1};
+    thread_local const int index = next++;
+    return index;
+}
+
+}  // namespace
+
+RequestTrace::Scope::Scope(RequestTrace* trace, std::string name)
+    : trace_(trace)
+    , name_(trace ? std::move(name) : std::string())
+    , startUs_(trace ? NowUs() : 0) {
+}
+
+void RequestTrace::Scope::End() {
+    if (trace_) {
+        trace_->Add(name_, startUs_, NowUs());
+        trace_ = nullptr;
+    }
+}
+
+RequestTrace::RequestTrace(std::string id, std::string process)
+    : id_(std::move(id))
+    , process_(std::move(process)) {
+}
+
+void RequestTrace::Add(const std::string& name, int64_t startUs, int64_t endUs) {
+    Span span{name, process_, ThreadIndex(), startUs, std::max<int64_t>(0, endUs - startUs)};
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans_.push_back(std::move(span));
+}
+
+void RequestTrace::Merge(const json& spans) {
+    if (!spans.is_array()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const json& entry : spans) {
+        if (!entry.is_object() || !entry.contains("name") || !entry.contains("start_us")) {
+            continue;
+        }
+        try {
+            spans_.push_back({entry.at("name").get<std::string>(), entry.value("process", ""),
+                              entry.value("thread", 0), entry.at("start_us").get<int64_t>(),
+                              entry.value("duration_us", int64_t(0))});
+        } catch (const json::exception&) {
+            continue;
+        }
+    }
+}
+
+std::vector<RequestTrace::Span> RequestTrace::GetSpans() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return spans_;
+}
+
+json RequestTrace::ToJson() const {
+    json spans = json::array();
+    for (const Span& span : GetSpans()) {
+        spans.push_back({
+            {"name", span.name},
+            {"process", span.process},
+            {"thread", span.thread},
+            {"start_us", span.startUs},
+            {"duration_us", span.durationUs}
+        });
+    }
+    return spans;
+}
+
+json RequestTrace::ToChromeTrace() const {
+    // A pid per process, named by a metadata event
+    json events = json::array();
+    std::map<std::string, int> pids;
+    for (const Span& span : GetSpans()) {
+        auto [it, inserted] = pids.emplace(span.process, int(pids.size()) + 1);
+        if (inserted) {
+            events.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", it->second},
+                              {"args", {{"name", span.process}}}});
+        }
+        events.push_back({
+            {"name", span.name},
+            {"ph", "X"},
+            {"ts", span.startUs},
+            {"dur", span.durationUs},
+            {"pid", it->second},
+            {"tid", span.thread},
+            {"args", {{"trace_id", id_}}}
+        });
+    }
+    return json{
+        {"traceEvents", std::move(events)},
+        {"displayTimeUnit", "ms"},
+        {"otherData", {{"trace_id", id_}}}
+    };
+}
+
+std::string RequestTrace::NewId() {
+    static std::mutex mutex;
+    static std::mt19937_64 random(std::random_device{}());
+    uint64_t high, low;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        high = random();
+        low = random();
+    }
+    char id[33];
+    std::snprintf(id, sizeof(id), "%016llx%016llx", static_cast<unsigned long long>(high),
+                  static_cast<unsigned long long>(low));
+    return id;
+}
+
+int64_t RequestTrace::NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace ipc
+} // namespace pathview
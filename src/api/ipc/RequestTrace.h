@@ -0,0 +1,98 @@
+#pragma once
+
+#include "IPCMessage.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace ipc {
+
+/**
+ * Timed spans of one request on its way through pathview-mcp, the IPC link
+ * and the GUI, to see where a slow tool call spent its time
+ *
+ * The id (32 hex digits, as W3C / OpenTelemetry trace ids) travels with the
+ * request as IPCRequest::traceId; each process records its own spans and
+ * returns them with its answer (IPCResponse::trace), where the caller
+ * merges them into its own. Times are wall-clock microseconds, so spans of
+ * processes on one host line up. Thread-safe: a deferred job adds spans
+ * from its worker thread.
+ */
+class RequestTrace {
+public:
+    struct Span {
+        std::string name;     // e.g. "gui.encode"
+        std::string process;  // "pathview", "pathview-mcp"
+        int thread = 0;       // Small index of the recording thread in its process
+        int64_t startUs = 0;
+        int64_t durationUs = 0;
+    };
+
+    /**
+     * Times a scope: a span from construction to End() or destruction.
+     * Does nothing without a trace, so untraced requests cost a null check
+     */
+    class Scope {
+    public:
+        Scope(RequestTrace* trace, std::string name);
+        ~Scope() { End(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void End();
+
+    private:
+        RequestTrace* trace_;
+        std::string name_;
+        int64_t startUs_;
+    };
+
+    RequestTrace(std::string id, std::string process);
+
+    const std::string& GetId() const { return id_; }
+
+    /**
+     * Record a span of this process between two NowUs() times
+     */
+    void Add(const std::string& name, int64_t startUs, int64_t endUs);
+
+    /**
+     * Add spans another process returned (ToJson()); malformed ones are skipped
+     */
+    void Merge(const json& spans);
+
+    std::vector<Span> GetSpans() const;
+
+    /**
+     * Spans as a JSON array of {name, process, thread, start_us, duration_us}
+     */
+    json ToJson() const;
+
+    /**
+     * Chrome trace event format ({"traceEvents": [...]}, complete events,
+     * a pid per process): opens in chrome://tracing and Perfetto
+     */
+    json ToChromeTrace() const;
+
+    /**
+     * New random trace id
+     */
+    static std::string NewId();
+
+    /**
+     * Wall-clock time in microseconds since the epoch
+     */
+    static int64_t NowUs();
+
+private:
+    const std::string id_;
+    const std::string process_;
+    mutable std::mutex mutex_;
+    std::vector<Span> spans_;
+};
+
+} // namespace ipc
+} // namespace pathview
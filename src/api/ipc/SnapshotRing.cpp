@@ -0,0 +1,276 @@
+#include "SnapshotRing.h"
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pathview {
+namespace ipc {
+
+namespace {
+
+constexpr uint32_t RING_MAGIC = 0x52535650;  // "PVSR"
+constexpr uint32_t RING_VERSION = 1;
+
+// First cache line of the region
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t slotBytes;
+    uint8_t padding[40];
+};
+static_assert(sizeof(RingHeader) == 64, "RingHeader is one cache line");
+
+std::string PlatformName(const std::string& name) {
+#ifdef _WIN32
+    return "Local\\" + name;
+#else
+    return "/" + name;
+#endif
+}
+
+}  // namespace
+
+// Each slot: this header on its own cache line, then slotBytes of data.
+// The sequence is 0 for a slot never written.
+struct SnapshotRing::SlotHeader {
+    std::atomic<uint64_t> sequence;
+    uint64_t size;
+    uint8_t padding[48];
+};
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Sequence must be a plain 64-bit word");
+
+std::string SnapshotRing::DefaultName() {
+#ifdef _WIN32
+    return "pathview-snapshots-" + std::to_string(GetCurrentProcessId());
+#else
+    return "pathview-snapshots-" + std::to_string(getpid());
+#endif
+}
+
+std::unique_ptr<SnapshotRing> SnapshotRing::Create(const std::string& name, uint32_t slotCount,
+                                                   uint64_t slotBytes) {
+    if (slotCount == 0 || slotBytes == 0) {
+        return nullptr;
+    }
+    std::unique_ptr<SnapshotRing> ring(new SnapshotRing());
+    ring->name_ = name;
+    ring->owner_ = true;
+    const uint64_t bytes = sizeof(RingHeader) + uint64_t(slotCount) * (sizeof(SlotHeader) + slotBytes);
+    if (!ring->MapRegion(true, bytes)) {
+        return nullptr;
+    }
+
+    // New mappings are zero-filled: sequences start at 0
+    ring->slotCount_ = slotCount;
+    ring->slotBytes_ = slotBytes;
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        new (&ring->Slot(i)) SlotHeader{};
+    }
+    RingHeader header{RING_MAGIC, RING_VERSION, slotCount, 0, slotBytes, {}};
+    std::memcpy(ring->base_, &header, sizeof(header));
+    return ring;
+}
+
+std::unique_ptr<SnapshotRing> SnapshotRing::Open(const std::string& name) {
+    std::unique_ptr<SnapshotRing> ring(new SnapshotRing());
+    ring->name_ = name;
+    if (!ring->MapRegion(false, 0) || !ring->ReadHeader()) {
+        return nullptr;
+    }
+    return ring;
+}
+
+std::unique_ptr<SnapshotRing> SnapshotRing::OpenFd(int fd, const std::string& name) {
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::unique_ptr<SnapshotRing> ring(new SnapshotRing());
+    ring->name_ = name;
+#ifdef _WIN32
+    return nullptr;
+#else
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || !ring->MapDescriptor(fd, false, static_cast<uint64_t>(info.st_size))) {
+        close(fd);
+        return nullptr;
+    }
+    close(fd);
+    if (!ring->ReadHeader()) {
+        return nullptr;
+    }
+    return ring;
+#endif
+}
+
+bool SnapshotRing::ReadHeader() {
+    if (bytes_ < sizeof(RingHeader)) {
+        return false;
+    }
+    RingHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    const uint64_t needed = sizeof(RingHeader) +
+                            uint64_t(header.slotCount) * (sizeof(SlotHeader) + header.slotBytes);
+    if (header.magic != RING_MAGIC || header.version != RING_VERSION || header.slotCount == 0 ||
+        needed > bytes_) {
+        return false;
+    }
+    slotCount_ = header.slotCount;
+    slotBytes_ = header.slotBytes;
+    return true;
+}
+
+bool SnapshotRing::MapRegion(bool create, uint64_t bytes) {
+    const std::string platformName = PlatformName(name_);
+#ifdef _WIN32
+    if (create) {
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                      static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes),
+                                      platformName.c_str());
+    } else {
+        mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, platformName.c_str());
+    }
+    if (!mapping_) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping_, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+    if (!create) {
+        MEMORY_BASIC_INFORMATION info{};
+        VirtualQuery(view, &info, sizeof(info));
+        bytes = static_cast<uint64_t>(info.RegionSize);
+    }
+    base_ = static_cast<uint8_t*>(view);
+    bytes_ = bytes;
+    return true;
+#else
+    int fd = -1;
+    if (create) {
+        shm_unlink(platformName.c_str());  // Left behind by a crashed GUI with our pid
+        fd = shm_open(platformName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            close(fd);
+            shm_unlink(platformName.c_str());
+            return false;
+        }
+    } else {
+        fd = shm_open(platformName.c_str(), O_RDONLY, 0);
+        struct stat info{};
+        if (fd >= 0 && fstat(fd, &info) == 0) {
+            bytes = static_cast<uint64_t>(info.st_size);
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    const bool mapped = MapDescriptor(fd, create, bytes);
+    if (mapped && create) {
+        fd_ = fd;  // Kept to pass to readers
+    } else {
+        close(fd);
+    }
+    if (!mapped && create) {
+        shm_unlink(platformName.c_str());
+    }
+    return mapped;
+#endif
+}
+
+bool SnapshotRing::MapDescriptor(int fd, bool writable, uint64_t bytes) {
+#ifdef _WIN32
+    (void)fd;
+    (void)writable;
+    (void)bytes;
+    return false;
+#else
+    void* view = bytes > 0 ? mmap(nullptr, static_cast<size_t>(bytes),
+                                  writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0)
+                           : MAP_FAILED;
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(view);
+    bytes_ = bytes;
+    return true;
+#endif
+}
+
+SnapshotRing::~SnapshotRing() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(mapping_);
+#else
+    if (base_) munmap(base_, static_cast<size_t>(bytes_));
+    if (base_ && owner_) shm_unlink(PlatformName(name_).c_str());
+    if (fd_ >= 0) close(fd_);
+#endif
+}
+
+SnapshotRing::SlotHeader& SnapshotRing::Slot(uint32_t index) const {
+    return *reinterpret_cast<SlotHeader*>(base_ + sizeof(RingHeader) +
+                                          uint64_t(index) * (sizeof(SlotHeader) + slotBytes_));
+}
+
+uint8_t* SnapshotRing::SlotData(uint32_t index) const {
+    return reinterpret_cast<uint8_t*>(&Slot(index)) + sizeof(SlotHeader);
+}
+
+bool SnapshotRing::Write(const uint8_t* data, uint64_t size, SlotRef& out) {
+    if (!owner_ || size > slotBytes_) {
+        return false;
+    }
+    const uint64_t ticket = nextTicket_.fetch_add(1);
+    const uint32_t index = static_cast<uint32_t>(ticket % slotCount_);
+    SlotHeader& slot = Slot(index);
+
+    // Claim the slot: odd while writing. A writer a whole lap behind may
+    // still be in it; leave it that one.
+    uint64_t current = slot.sequence.load(std::memory_order_acquire);
+    if ((current & 1) != 0 ||
+        !slot.sequence.compare_exchange_strong(current, 2 * ticket + 1, std::memory_order_acq_rel)) {
+        return false;
+    }
+    slot.size = size;
+    std::memcpy(SlotData(index), data, static_cast<size_t>(size));
+    slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+
+    out.slot = index;
+    out.sequence = 2 * ticket + 2;
+    out.size = size;
+    return true;
+}
+
+bool SnapshotRing::Read(const SlotRef& ref, std::vector<uint8_t>& out) const {
+    if (ref.slot >= slotCount_ || ref.sequence == 0 || (ref.sequence & 1) != 0 || ref.size > slotBytes_) {
+        return false;
+    }
+    const SlotHeader& slot = Slot(ref.slot);
+    if (slot.sequence.load(std::memory_order_acquire) != ref.sequence || slot.size != ref.size) {
+        return false;
+    }
+    const uint8_t* data = SlotData(ref.slot);
+    out.assign(data, data + ref.size);
+
+    // Still the same write: nothing overwrote it while it was copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == ref.sequence;
+}
+
+} // namespace ipc
+} // namespace pathview
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace ipc {
+
+/**
+ * Shared-memory ring of snapshot slots between the GUI and pathview-mcp
+ *
+ * The GUI creates the ring and writes each captured PNG into the next slot;
+ * the snapshot.capture response then carries only the slot reference
+ * instead of the base64 data, and the MCP server copies the bytes straight
+ * out of the mapping. Slots are reused round-robin: every write stamps its
+ * slot with a new sequence number (odd while writing, even once done), and
+ * a reader whose sequence no longer matches has lost the slot to a later
+ * capture and asks again without the ring.
+ *
+ * POSIX shared memory (shm_open) or a pagefile-backed file mapping on
+ * Windows, named after the GUI's process id. Over a Unix domain socket the
+ * GUI can also pass the ring's descriptor along (OpenFd()), for readers
+ * that cannot see its name (another /dev/shm, a sandbox).
+ */
+class SnapshotRing {
+public:
+    // Where a write landed, as sent in the IPC response
+    struct SlotRef {
+        uint32_t slot = 0;
+        uint64_t sequence = 0;
+        uint64_t size = 0;
+    };
+
+    /**
+     * Create (owner side); a stale ring of the same name is replaced
+     * @return The ring, or null if shared memory is unavailable
+     */
+    static std::unique_ptr<SnapshotRing> Create(const std::string& name,
+                                                uint32_t slotCount = DEFAULT_SLOTS,
+                                                uint64_t slotBytes = DEFAULT_SLOT_BYTES);
+
+    /**
+     * Map an existing ring read-only (reader side)
+     * @return The ring, or null if it does not exist or is not a ring
+     */
+    static std::unique_ptr<SnapshotRing> Open(const std::string& name);
+
+    /**
+     * Map a ring from a descriptor passed by the owner (POSIX); takes
+     * ownership of fd, which is closed once mapped
+     * @return The ring, or null if fd is not a ring
+     */
+    static std::unique_ptr<SnapshotRing> OpenFd(int fd, const std::string& name);
+
+    ~SnapshotRing();
+
+    SnapshotRing(const SnapshotRing&) = delete;
+    SnapshotRing& operator=(const SnapshotRing&) = delete;
+
+    /**
+     * Copy data into the next slot (owner side, thread-safe)
+     * @return False if the data does not fit a slot or a writer still holds
+     *         the slot; the caller sends the data inline instead
+     */
+    bool Write(const uint8_t* data, uint64_t size, SlotRef& out);
+
+    /**
+     * Copy a slot's data out
+     * @return False if the slot has been rewritten since (or is being)
+     */
+    bool Read(const SlotRef& ref, std::vector<uint8_t>& out) const;
+
+    const std::string& GetName() const { return name_; }
+
+    /**
+     * Owner side: the shared memory's descriptor, to pass to a reader
+     * (-1 on Windows)
+     */
+    int GetFd() const { return fd_; }
+    uint32_t GetSlotCount() const { return slotCount_; }
+    uint64_t GetSlotBytes() const { return slotBytes_; }
+
+    // Ring name for this process
+    static std::string DefaultName();
+
+    // A 4K capture compresses well below a slot; larger ones go inline
+    static constexpr uint32_t DEFAULT_SLOTS = 4;
+    static constexpr uint64_t DEFAULT_SLOT_BYTES = 32ull * 1024 * 1024;
+
+private:
+    struct SlotHeader;
+
+    SnapshotRing() = default;
+
+    // Map the region; false (nothing mapped) on failure
+    bool MapRegion(bool create, uint64_t bytes);
+    bool MapDescriptor(int fd, bool writable, uint64_t bytes);
+    // Reader side: check the header and take the layout from it
+    bool ReadHeader();
+    SlotHeader& Slot(uint32_t index) const;
+    uint8_t* SlotData(uint32_t index) const;
+
+    std::string name_;
+    bool owner_ = false;
+    uint8_t* base_ = nullptr;
+    uint64_t bytes_ = 0;
+    uint32_t slotCount_ = 0;
+    uint64_t slotBytes_ = 0;
+    std::atomic<uint64_t> nextTicket_{0};  // Owner side: next write
+    int fd_ = -1;                           // Owner side, POSIX: kept for passing
+#ifdef _WIN32
+    void* mapping_ = nullptr;  // File mapping HANDLE
+#endif
+};
+
+} // namespace ipc
+} // namespace pathview
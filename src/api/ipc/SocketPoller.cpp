@@ -0,0 +1,125 @@
+#include "SocketPoller.h"
+#include <algorithm>
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <unistd.h>
+#endif
+
+namespace pathview {
+namespace ipc {
+
+#ifdef __linux__
+
+static uint32_t EpollEvents(bool read, bool write) {
+    return (read ? EPOLLIN : 0u) | (write ? EPOLLOUT : 0u);
+}
+
+SocketPoller::SocketPoller()
+    : epollFd_(epoll_create1(EPOLL_CLOEXEC))
+{
+}
+
+SocketPoller::~SocketPoller() {
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+bool SocketPoller::IsOpen() const {
+    return epollFd_ >= 0;
+}
+
+bool SocketPoller::Add(socket_t fd, bool read, bool write) {
+    epoll_event event{};
+    event.events = EpollEvents(read, write);
+    event.data.fd = fd;
+    return epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool SocketPoller::Modify(socket_t fd, bool read, bool write) {
+    epoll_event event{};
+    event.events = EpollEvents(read, write);
+    event.data.fd = fd;
+    return epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void SocketPoller::Remove(socket_t fd) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int SocketPoller::Wait(std::vector<Event>& events, int timeoutMs) {
+    epoll_event ready[64];
+    int count = epoll_wait(epollFd_, ready, 64, timeoutMs);
+    events.clear();
+    for (int i = 0; i < count; ++i) {
+        events.push_back({ready[i].data.fd,
+                          (ready[i].events & EPOLLIN) != 0,
+                          (ready[i].events & EPOLLOUT) != 0,
+                          (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0});
+    }
+    return count;
+}
+
+#else
+
+static short PollEvents(bool read, bool write) {
+    return static_cast<short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+}
+
+SocketPoller::SocketPoller() = default;
+SocketPoller::~SocketPoller() = default;
+
+bool SocketPoller::IsOpen() const {
+    return true;
+}
+
+bool SocketPoller::Add(socket_t fd, bool read, bool write) {
+    pollfd entry{};
+    entry.fd = fd;
+    entry.events = PollEvents(read, write);
+    fds_.push_back(entry);
+    return true;
+}
+
+bool SocketPoller::Modify(socket_t fd, bool read, bool write) {
+    for (pollfd& entry : fds_) {
+        if (entry.fd == fd) {
+            entry.events = PollEvents(read, write);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SocketPoller::Remove(socket_t fd) {
+    fds_.erase(std::remove_if(fds_.begin(), fds_.end(),
+                              [fd](const pollfd& entry) { return entry.fd == fd; }),
+               fds_.end());
+}
+
+int SocketPoller::Wait(std::vector<Event>& events, int timeoutMs) {
+#ifdef _WIN32
+    int count = WSAPoll(fds_.data(), static_cast<ULONG>(fds_.size()), timeoutMs);
+#else
+    int count = poll(fds_.data(), static_cast<nfds_t>(fds_.size()), timeoutMs);
+#endif
+    events.clear();
+    if (count <= 0) {
+        return count;
+    }
+    for (const pollfd& entry : fds_) {
+        if (entry.revents != 0) {
+            events.push_back({entry.fd,
+                              (entry.revents & POLLIN) != 0,
+                              (entry.revents & POLLOUT) != 0,
+                              (entry.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0});
+        }
+    }
+    return static_cast<int>(events.size());
+}
+
+#endif
+
+} // namespace ipc
+} // namespace pathview
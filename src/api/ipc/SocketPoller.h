@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+// Cross-platform socket includes
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    using socket_t = SOCKET;
+    #define INVALID_SOCKET_VALUE INVALID_SOCKET
+#else
+    #include <poll.h>
+    using socket_t = int;
+    #define INVALID_SOCKET_VALUE (-1)
+#endif
+
+namespace pathview {
+namespace ipc {
+
+/**
+ * Readiness of many sockets at once, for IPCServer's I/O thread
+ *
+ * epoll on Linux, poll() elsewhere (WSAPoll on Windows): unlike select()
+ * there is no FD_SETSIZE ceiling, and epoll's cost does not grow with
+ * idle connections. Level-triggered; used by one thread.
+ */
+class SocketPoller {
+public:
+    struct Event {
+        socket_t fd;
+        bool readable;
+        bool writable;
+        bool hangup;  // Error or peer gone: reading reports which
+    };
+
+    SocketPoller();
+    ~SocketPoller();
+
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+    bool IsOpen() const;
+
+    /**
+     * Watch fd for reading and/or writing (Modify() changes which)
+     */
+    bool Add(socket_t fd, bool read, bool write);
+    bool Modify(socket_t fd, bool read, bool write);
+    void Remove(socket_t fd);
+
+    /**
+     * Wait for readiness
+     * @param timeoutMs -1 to wait until something is ready
+     * @return Number of events (0 on timeout), -1 on error (errno set;
+     *         EINTR is worth retrying)
+     */
+    int Wait(std::vector<Event>& events, int timeoutMs);
+
+private:
+#ifdef __linux__
+    int epollFd_;
+#else
+    std::vector<pollfd> fds_;
+#endif
+};
+
+} // namespace ipc
+} // namespace pathview
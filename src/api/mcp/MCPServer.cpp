@@ -4,7 +4,9 @@
 #include "../http/SnapshotManager.h"
 #include "../http/HTTPServer.h"
 #include "mcp_tool.h"
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 namespace pathview {
 namespace mcp {
@@ -12,16 +14,21 @@ namespace mcp {
 MCPServer::MCPServer(ipc::IPCClient* ipcClient,
                      http::SnapshotManager* snapshotManager,
                      http::HTTPServer* httpServer,
-                     int mcpPort)
+                     int mcpPort,
+                     size_t threadCount,
+                     const std::string& host)
     : ipcClient_(ipcClient)
     , snapshotManager_(snapshotManager)
     , httpServer_(httpServer)
 {
     // Initialize MCP server with HTTP+SSE transport
     ::mcp::server::configuration config;
-    config.host = "127.0.0.1";
+    config.host = host;
     config.port = mcpPort;
     config.sse_endpoint = "/sse";
+    if (threadCount > 0) {
+        config.threadpool_size = static_cast<unsigned int>(threadCount);
+    }
 
     server_ = std::make_unique<::mcp::server>(config);
 
@@ -36,7 +43,10 @@ MCPServer::MCPServer(ipc::IPCClient* ipcClient,
     server_->set_capabilities(capabilities);
 
     // Initialize tool handlers with our infrastructure
-    tools::Initialize(ipcClient_, snapshotManager_, httpServer_);
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    tools::Initialize(ipcClient_, snapshotManager_, httpServer_, std::max<size_t>(1, threadCount / 2));
 }
 
 MCPServer::~MCPServer() {
@@ -47,14 +57,15 @@ void MCPServer::RegisterTools() {
     // Slide control tools
     ::mcp::tool load_slide = ::mcp::tool_builder("load_slide")
         .with_description("Load a whole-slide image file")
-        .with_string_param("path", "Absolute path to slide file (.svs, .tiff, etc.)")
+        .with_string_param("path", "Absolute path to slide file (.svs, .tiff, etc.), or an http(s) URL of a tiled TIFF / SVS")
         .build();
-    server_->register_tool(load_slide, tools::HandleLoadSlide);
+    server_->register_tool(load_slide, tools::Traced("load_slide", tools::HandleLoadSlide));
 
     ::mcp::tool get_slide_info = ::mcp::tool_builder("get_slide_info")
-        .with_description("Get information about the currently loaded slide")
+        .with_description("Get information about the currently loaded slide: size, levels, scan resolution (mpp), objective, associated images")
+        .with_boolean_param("properties", "Also return every vendor property of the slide (optional)", false)
         .build();
-    server_->register_tool(get_slide_info, tools::HandleGetSlideInfo);
+    server_->register_tool(get_slide_info, tools::Traced("get_slide_info", tools::HandleGetSlideInfo));
 
     // Viewport control tools
     ::mcp::tool pan = ::mcp::tool_builder("pan")
@@ -62,20 +73,20 @@ void MCPServer::RegisterTools() {
         .with_number_param("dx", "X delta in pixels")
         .with_number_param("dy", "Y delta in pixels")
         .build();
-    server_->register_tool(pan, tools::HandlePan);
+    server_->register_tool(pan, tools::Traced("pan", tools::HandlePan));
 
     ::mcp::tool center_on = ::mcp::tool_builder("center_on")
         .with_description("Center viewport on a specific point in slide coordinates")
         .with_number_param("x", "X coordinate in slide space")
         .with_number_param("y", "Y coordinate in slide space")
         .build();
-    server_->register_tool(center_on, tools::HandleCenterOn);
+    server_->register_tool(center_on, tools::Traced("center_on", tools::HandleCenterOn));
 
     ::mcp::tool zoom = ::mcp::tool_builder("zoom")
         .with_description("Zoom in or out (delta: 1.1 = 10% in, 0.9 = 10% out)")
         .with_number_param("delta", "Zoom factor (> 1.0 zooms in, < 1.0 zooms out)")
         .build();
-    server_->register_tool(zoom, tools::HandleZoom);
+    server_->register_tool(zoom, tools::Traced("zoom", tools::HandleZoom));
 
     ::mcp::tool zoom_at_point = ::mcp::tool_builder("zoom_at_point")
         .with_description("Zoom at a specific screen point")
@@ -83,42 +94,144 @@ void MCPServer::RegisterTools() {
         .with_number_param("screen_y", "Screen Y coordinate")
         .with_number_param("delta", "Zoom factor")
         .build();
-    server_->register_tool(zoom_at_point, tools::HandleZoomAtPoint);
+    server_->register_tool(zoom_at_point, tools::Traced("zoom_at_point", tools::HandleZoomAtPoint));
 
     ::mcp::tool reset_view = ::mcp::tool_builder("reset_view")
         .with_description("Reset viewport to fit entire slide in window")
         .build();
-    server_->register_tool(reset_view, tools::HandleResetView);
+    server_->register_tool(reset_view, tools::Traced("reset_view", tools::HandleResetView));
 
-    // Snapshot tool
+    // Snapshot tools
     ::mcp::tool capture_snapshot = ::mcp::tool_builder("capture_snapshot")
-        .with_description("Capture current viewport as PNG image")
+        .with_description("Capture current viewport as an image (PNG by default)")
         .with_number_param("width", "Image width (optional)", false)
         .with_number_param("height", "Image height (optional)", false)
+        .with_string_param("format", "png (default), jpeg, webp or qoi (optional)", false)
+        .with_number_param("quality", "JPEG / WebP quality 1-100, default 90 (optional)", false)
+        .with_number_param("max_dimension", "Scale down so the longer side is at most this many pixels, e.g. 1024 for vision models (optional)", false)
+        .with_number_param("scale", "Scale down by this factor, 0-1 (optional)", false)
+        .with_boolean_param("await_sharp", "Wait until every visible tile is loaded at full resolution instead of capturing the current, possibly blurry, frame (optional)", false)
+        .with_number_param("timeout_ms", "With await_sharp: capture anyway after this long, default 5000, max 30000 (optional)", false)
+        .with_boolean_param("trace", "Also return where the call's time went: timed spans in this server, over IPC and in the viewer, as Chrome trace JSON in \"trace\" (optional; every tool takes it)", false)
+        .build();
+    server_->register_tool(capture_snapshot, tools::Traced("capture_snapshot", tools::HandleCaptureSnapshot));
+
+    ::mcp::tool render_region = ::mcp::tool_builder("render_region")
+        .with_description("Render any region of the slide at any resolution as an image, off screen: the viewport does not move. Params: overlays (array of \"polygons\", \"annotations\", optional)")
+        .with_number_param("x", "Region left edge in level 0 pixels")
+        .with_number_param("y", "Region top edge in level 0 pixels")
+        .with_number_param("width", "Region width in level 0 pixels")
+        .with_number_param("height", "Region height in level 0 pixels")
+        .with_number_param("downsample", "Level 0 pixels per image pixel, default 1, at least 0.25 (optional)", false)
+        .with_number_param("output_width", "Image width; sets the downsample instead (optional)", false)
+        .with_string_param("format", "png (default), jpeg, webp or qoi (optional)", false)
+        .with_number_param("quality", "JPEG / WebP quality 1-100, default 90 (optional)", false)
+        .with_boolean_param("trace", "Also return where the call's time went, as for capture_snapshot (optional)", false)
+        .build();
+    server_->register_tool(render_region, tools::Traced("render_region", tools::HandleRenderRegion));
+
+    ::mcp::tool scan_regions = ::mcp::tool_builder("scan_regions")
+        .with_description("Start rendering many regions of the slide off screen in parallel, e.g. to screen a whole slide, instead of stepping the viewport; returns a token immediately. Params: regions (array of {x, y, width, height} in level 0 pixels) or grid ({field_width, field_height, overlap (optional), x, y, width, height (optional, default the whole slide)}), level (optional: render at this pyramid level's downsample). Fields render in Hilbert order so neighbours share cached tiles; fetch them with get_region_scan_results")
+        .with_number_param("downsample", "Level 0 pixels per image pixel, default 1, at least 0.25 (optional)", false)
+        .with_string_param("format", "png (default), jpeg, webp or qoi (optional)", false)
+        .with_number_param("quality", "JPEG / WebP quality 1-100, default 90 (optional)", false)
+        .with_number_param("threads", "Fields rendered at once, 1-4 (optional)", false)
+        .build();
+    server_->register_tool(scan_regions, tools::Traced("scan_regions", tools::HandleScanRegions));
+
+    ::mcp::tool get_region_scan_results = ::mcp::tool_builder("get_region_scan_results")
+        .with_description("Poll a scan_regions token for fields finished so far, stored as images like render_region's (each tagged with its field index and region, or an error). The scan pauses while 16 finished fields wait to be received, so keep polling.")
+        .with_string_param("token", "Token from scan_regions")
+        .with_number_param("since", "Results already received; their images are released (optional)", false)
+        .with_number_param("limit", "Results at most, default 4 (optional)", false)
         .build();
-    server_->register_tool(capture_snapshot, tools::HandleCaptureSnapshot);
+    server_->register_tool(get_region_scan_results, tools::Traced("get_region_scan_results", tools::HandleGetRegionScanResults));
+
+    ::mcp::tool cancel_region_scan = ::mcp::tool_builder("cancel_region_scan")
+        .with_description("Stop a scan_regions scan and drop its results")
+        .with_string_param("token", "Token from scan_regions")
+        .build();
+    server_->register_tool(cancel_region_scan, tools::Traced("cancel_region_scan", tools::HandleCancelRegionScan));
+
+    ::mcp::tool export_region = ::mcp::tool_builder("export_region")
+        .with_description("Write a region of the slide, with overlays burned in, as a tiled pyramidal TIFF (JPEG tiles, a level at every halving) that slide viewers open; for regions too large for render_region. Runs in the background and returns an action card id at once: follow its progress with list_action_cards, stop it by setting the card's status to cancelled. One export at a time. Params: overlays (array of \"polygons\", \"annotations\", optional)")
+        .with_number_param("x", "Region left edge in level 0 pixels")
+        .with_number_param("y", "Region top edge in level 0 pixels")
+        .with_number_param("width", "Region width in level 0 pixels")
+        .with_number_param("height", "Region height in level 0 pixels")
+        .with_string_param("path", "Absolute path of the .tiff file to write")
+        .with_number_param("downsample", "Level 0 pixels per output pixel, default 1, at least 0.25 (optional)", false)
+        .with_number_param("output_width", "Output width; sets the downsample instead (optional)", false)
+        .with_number_param("quality", "JPEG quality 1-100, default 90 (optional)", false)
+        .build();
+    server_->register_tool(export_region, tools::Traced("export_region", tools::HandleExportRegion));
 
     // Polygon tools
     ::mcp::tool load_polygons = ::mcp::tool_builder("load_polygons")
         .with_description("Load polygon overlay from protobuf file")
         .with_string_param("path", "Absolute path to .pb or .protobuf file")
+        .with_boolean_param("new_layer", "Load into a new layer, keeping the loaded ones, e.g. to compare two models (optional)", false)
         .build();
-    server_->register_tool(load_polygons, tools::HandleLoadPolygons);
+    server_->register_tool(load_polygons, tools::Traced("load_polygons", tools::HandleLoadPolygons));
 
     ::mcp::tool query_polygons = ::mcp::tool_builder("query_polygons")
-        .with_description("Query polygons in a rectangular region")
+        .with_description("Query the cells whose bounding box meets a rectangular region, a page at a time: id, class, confidence and centroid of each, or its outline too")
+        .with_number_param("x", "Region X coordinate (slide space)")
+        .with_number_param("y", "Region Y coordinate (slide space)")
+        .with_number_param("w", "Region width")
+        .with_number_param("h", "Region height")
+        .with_string_param("classes", "Comma-separated class IDs to include, default all (optional)", false)
+        .with_number_param("min_confidence", "Leave out cells below this confidence, default 0 (optional)", false)
+        .with_string_param("geometry", "centroid (default) or vertices (optional)", false)
+        .with_number_param("limit", "Cells per page, default 1000, max 50000 (optional)", false)
+        .with_number_param("cursor", "next_cursor of the previous page (optional)", false)
+        .build();
+    server_->register_tool(query_polygons, tools::Traced("query_polygons", tools::HandleQueryPolygons));
+
+    ::mcp::tool summarize_polygons = ::mcp::tool_builder("summarize_polygons")
+        .with_description("Count the cells whose centroid lies in a rectangular region by class, with their total and mean area and mean confidence, without listing them (fast for any region size)")
         .with_number_param("x", "Region X coordinate (slide space)")
         .with_number_param("y", "Region Y coordinate (slide space)")
         .with_number_param("w", "Region width")
         .with_number_param("h", "Region height")
         .build();
-    server_->register_tool(query_polygons, tools::HandleQueryPolygons);
+    server_->register_tool(summarize_polygons, tools::Traced("summarize_polygons", tools::HandleSummarizePolygons));
 
     ::mcp::tool set_polygon_visibility = ::mcp::tool_builder("set_polygon_visibility")
-        .with_description("Show or hide polygon overlay")
-        .with_boolean_param("visible", "True to show, false to hide")
+        .with_description("Show or hide polygon overlay, and/or hide cells below a segmentation confidence")
+        .with_boolean_param("visible", "True to show, false to hide", false)
+        .with_number_param("min_confidence", "Cells with a lower confidence are not drawn (0-1, 0 shows all)", false)
         .build();
-    server_->register_tool(set_polygon_visibility, tools::HandleSetPolygonVisibility);
+    server_->register_tool(set_polygon_visibility, tools::Traced("set_polygon_visibility", tools::HandleSetPolygonVisibility));
+
+    ::mcp::tool set_polygon_outline = ::mcp::tool_builder("set_polygon_outline")
+        .with_description("Draw cells as contours instead of filled polygons, so the stain shows through, and set their line width")
+        .with_boolean_param("enabled", "True for contours, false for filled cells (optional)", false)
+        .with_number_param("width", "Line width in screen pixels, 0.5-8 (optional; default 1.5)", false)
+        .with_number_param("class_id", "Class the width is for (optional; default every class)", false)
+        .build();
+    server_->register_tool(set_polygon_outline, tools::Traced("set_polygon_outline", tools::HandleSetPolygonOutline));
+
+    ::mcp::tool set_minimap_density = ::mcp::tool_builder("set_minimap_density")
+        .with_description("Draw the cell density of the whole slide over the minimap, to find hot spots without zooming out")
+        .with_boolean_param("enabled", "True to draw it, false to hide it (optional)", false)
+        .with_number_param("class_id", "Only this class's cells (optional; -1, the default, for the visible classes)", false)
+        .build();
+    server_->register_tool(set_minimap_density, tools::Traced("set_minimap_density", tools::HandleSetMinimapDensity));
+
+    ::mcp::tool list_polygon_layers = ::mcp::tool_builder("list_polygon_layers")
+        .with_description("List the polygon layers: file, visibility, cell count, and which one is active (the one the other polygon tools act on)")
+        .build();
+    server_->register_tool(list_polygon_layers, tools::Traced("list_polygon_layers", tools::HandleListPolygonLayers));
+
+    ::mcp::tool set_polygon_layer = ::mcp::tool_builder("set_polygon_layer")
+        .with_description("Show, hide, activate or remove a polygon layer; switching between loaded layers reloads nothing")
+        .with_number_param("layer", "Layer index from list_polygon_layers")
+        .with_boolean_param("visible", "True to show, false to hide (optional)", false)
+        .with_boolean_param("active", "True to make it the layer the other polygon tools act on (optional)", false)
+        .with_boolean_param("remove", "True to unload and remove it (optional)", false)
+        .build();
+    server_->register_tool(set_polygon_layer, tools::Traced("set_polygon_layer", tools::HandleSetPolygonLayer));
 
     // Session management tools
     ::mcp::tool agent_hello = ::mcp::tool_builder("agent_hello")
@@ -126,7 +239,7 @@ void MCPServer::RegisterTools() {
         .with_string_param("agent_name", "Name/identifier of the AI agent")
         .with_string_param("agent_version", "Version of the AI agent (optional)", false)
         .build();
-    server_->register_tool(agent_hello, tools::HandleAgentHello);
+    server_->register_tool(agent_hello, tools::Traced("agent_hello", tools::HandleAgentHello));
 
     // Navigation lock tools
     ::mcp::tool nav_lock = ::mcp::tool_builder("nav_lock")
@@ -134,18 +247,18 @@ void MCPServer::RegisterTools() {
         .with_string_param("owner_uuid", "UUID of lock owner (agent)")
         .with_number_param("ttl_seconds", "Lock time-to-live in seconds (default 300)", false)
         .build();
-    server_->register_tool(nav_lock, tools::HandleNavLock);
+    server_->register_tool(nav_lock, tools::Traced("nav_lock", tools::HandleNavLock));
 
     ::mcp::tool nav_unlock = ::mcp::tool_builder("nav_unlock")
         .with_description("Release navigation lock")
         .with_string_param("owner_uuid", "UUID of lock owner (agent)")
         .build();
-    server_->register_tool(nav_unlock, tools::HandleNavUnlock);
+    server_->register_tool(nav_unlock, tools::Traced("nav_unlock", tools::HandleNavUnlock));
 
     ::mcp::tool nav_lock_status = ::mcp::tool_builder("nav_lock_status")
         .with_description("Check navigation lock status")
         .build();
-    server_->register_tool(nav_lock_status, tools::HandleNavLockStatus);
+    server_->register_tool(nav_lock_status, tools::Traced("nav_lock_status", tools::HandleNavLockStatus));
 
     // Tracked viewport movement
     ::mcp::tool move_camera = ::mcp::tool_builder("move_camera")
@@ -155,39 +268,76 @@ void MCPServer::RegisterTools() {
         .with_number_param("zoom", "Target zoom level")
         .with_number_param("duration_ms", "Animation duration in milliseconds (default 300)", false)
         .build();
-    server_->register_tool(move_camera, tools::HandleMoveCamera);
+    server_->register_tool(move_camera, tools::Traced("move_camera", tools::HandleMoveCamera));
 
     ::mcp::tool await_move = ::mcp::tool_builder("await_move")
         .with_description("Wait for camera move to complete (poll until done)")
         .with_string_param("token", "Move token from move_camera")
         .build();
-    server_->register_tool(await_move, tools::HandleAwaitMove);
+    server_->register_tool(await_move, tools::Traced("await_move", tools::HandleAwaitMove));
+
+    ::mcp::tool plan_tour = ::mcp::tool_builder("plan_tour")
+        .with_description("Announce the views you will move_camera through next, so their tiles load ahead while you look at the current one: each stop is then sharp on arrival. Params: waypoints (array of {center_x, center_y, zoom} in move order; empty drops the plan; omit to get progress only), budget_mb (number, optional: decoded tiles the plan may hold, default a quarter of the tile cache). Returns next_waypoint and how many waypoints fit the budget")
+        .build();
+    server_->register_tool(plan_tour, tools::Traced("plan_tour", tools::HandlePlanTour));
+
+    ::mcp::tool wait_for_events = ::mcp::tool_builder("wait_for_events")
+        .with_description("Block until the viewer reports events newer than after_sequence: viewport (moved or zoomed), tiles_settled (view fully sharp), annotations (changed). Returns the latest of each type and the sequence to pass next time")
+        .with_number_param("after_sequence", "Sequence returned by the previous call (default 0: latest of each type)", false)
+        .with_number_param("timeout_ms", "Longest wait in milliseconds (default 10000, max 60000)", false)
+        .build();
+    server_->register_tool(wait_for_events, tools::Traced("wait_for_events", tools::HandleWaitForEvents));
+
+    ::mcp::tool run_steps = ::mcp::tool_builder("run_steps")
+        .with_description("Run several tools in one round trip to the viewer, in order, e.g. move_camera, capture_snapshot (await_sharp), compute_roi_metrics. Params: steps (array of {tool, params}); a string param \"$N.key\" takes step N's result key (\"$prev.key\": the step before; keys may be nested, e.g. \"$0.position.x\"); continue_on_error (boolean, optional: by default the first failing step ends the run). Returns results, one {result} or {error} per step run. Steps: get_slide_info, pan, center_on, zoom, zoom_at_point, reset_view, move_camera, await_move, capture_snapshot, render_region, summarize_polygons, set_polygon_visibility, create_annotation, list_annotations, get_annotation, delete_annotation, compute_roi_metrics, create_action_card, update_action_card, append_action_card_log")
+        .build();
+    server_->register_tool(run_steps, tools::Traced("run_steps", tools::HandleRunSteps));
 
     // Annotation/ROI tools
     ::mcp::tool create_annotation = ::mcp::tool_builder("create_annotation")
         .with_description("Create a polygon annotation/ROI with automatic cell counting. Params: vertices (array of [x,y] pairs), name (optional string)")
         .build();
-    server_->register_tool(create_annotation, tools::HandleCreateAnnotation);
+    server_->register_tool(create_annotation, tools::Traced("create_annotation", tools::HandleCreateAnnotation));
 
     ::mcp::tool list_annotations = ::mcp::tool_builder("list_annotations")
         .with_description("List all annotations with optional metrics. Params: include_metrics (optional boolean)")
         .build();
-    server_->register_tool(list_annotations, tools::HandleListAnnotations);
+    server_->register_tool(list_annotations, tools::Traced("list_annotations", tools::HandleListAnnotations));
 
     ::mcp::tool get_annotation = ::mcp::tool_builder("get_annotation")
         .with_description("Get detailed info about a specific annotation. Params: id (number)")
         .build();
-    server_->register_tool(get_annotation, tools::HandleGetAnnotation);
+    server_->register_tool(get_annotation, tools::Traced("get_annotation", tools::HandleGetAnnotation));
 
     ::mcp::tool delete_annotation = ::mcp::tool_builder("delete_annotation")
         .with_description("Delete an annotation by ID. Params: id (number)")
         .build();
-    server_->register_tool(delete_annotation, tools::HandleDeleteAnnotation);
+    server_->register_tool(delete_annotation, tools::Traced("delete_annotation", tools::HandleDeleteAnnotation));
+
+    ::mcp::tool export_annotations = ::mcp::tool_builder("export_annotations")
+        .with_description("Export every annotation as one GeoJSON FeatureCollection (level 0 pixel coordinates). Params: path (optional string: write the file there instead of returning it)")
+        .build();
+    server_->register_tool(export_annotations, tools::Traced("export_annotations", tools::HandleExportAnnotations));
+
+    ::mcp::tool import_annotations = ::mcp::tool_builder("import_annotations")
+        .with_description("Create annotations from GeoJSON polygons (level 0 pixel coordinates), each with a new id. Params: geojson (object) or path (string: a GeoJSON file)")
+        .build();
+    server_->register_tool(import_annotations, tools::Traced("import_annotations", tools::HandleImportAnnotations));
 
     ::mcp::tool compute_roi_metrics = ::mcp::tool_builder("compute_roi_metrics")
-        .with_description("Compute metrics for arbitrary polygon WITHOUT creating annotation (quick probe). Params: vertices (array of [x,y] pairs)")
+        .with_description("Compute metrics for arbitrary polygon WITHOUT creating annotation (quick probe). Params: vertices (array of [x,y] pairs), min_confidence (number, optional: skip cells the segmentation is less confident about), cell_overlap (string, optional: centroid (default), exact, raster or auto - also weigh cells straddling the outline by their area inside), tissue (boolean, optional: area of each tissue class inside)")
         .build();
-    server_->register_tool(compute_roi_metrics, tools::HandleComputeROIMetrics);
+    server_->register_tool(compute_roi_metrics, tools::Traced("compute_roi_metrics", tools::HandleComputeROIMetrics));
+
+    ::mcp::tool compute_roi_metrics_batch = ::mcp::tool_builder("compute_roi_metrics_batch")
+        .with_description("Start computing metrics for many ROIs in parallel without creating annotations; returns a token immediately. Params: rois (array of vertex arrays), min_confidence, cell_overlap, tissue (optional, as for compute_roi_metrics)")
+        .build();
+    server_->register_tool(compute_roi_metrics_batch, tools::Traced("compute_roi_metrics_batch", tools::HandleComputeROIMetricsBatch));
+
+    ::mcp::tool get_roi_metrics_batch = ::mcp::tool_builder("get_roi_metrics_batch")
+        .with_description("Poll a compute_roi_metrics_batch token for results finished so far (each tagged with its roi index). Params: token (string), since (number, optional: results already received)")
+        .build();
+    server_->register_tool(get_roi_metrics_batch, tools::Traced("get_roi_metrics_batch", tools::HandleGetROIMetricsBatch));
 
     // Action card tools
     ::mcp::tool create_action_card = ::mcp::tool_builder("create_action_card")
@@ -197,7 +347,7 @@ void MCPServer::RegisterTools() {
         .with_string_param("reasoning", "Detailed reasoning (optional)", false)
         .with_string_param("owner_uuid", "UUID of creating agent (optional)", false)
         .build();
-    server_->register_tool(create_action_card, tools::HandleCreateActionCard);
+    server_->register_tool(create_action_card, tools::Traced("create_action_card", tools::HandleCreateActionCard));
 
     ::mcp::tool update_action_card = ::mcp::tool_builder("update_action_card")
         .with_description("Update action card status or content")
@@ -206,7 +356,7 @@ void MCPServer::RegisterTools() {
         .with_string_param("summary", "Updated summary (optional)", false)
         .with_string_param("reasoning", "Updated reasoning (optional)", false)
         .build();
-    server_->register_tool(update_action_card, tools::HandleUpdateActionCard);
+    server_->register_tool(update_action_card, tools::Traced("update_action_card", tools::HandleUpdateActionCard));
 
     ::mcp::tool append_action_card_log = ::mcp::tool_builder("append_action_card_log")
         .with_description("Append a log entry to action card for incremental progress updates")
@@ -214,20 +364,28 @@ void MCPServer::RegisterTools() {
         .with_string_param("message", "Log message")
         .with_string_param("level", "Log level: info, warning, error, success (optional, default: info)", false)
         .build();
-    server_->register_tool(append_action_card_log, tools::HandleAppendActionCardLog);
+    server_->register_tool(append_action_card_log, tools::Traced("append_action_card_log", tools::HandleAppendActionCardLog));
 
     ::mcp::tool list_action_cards = ::mcp::tool_builder("list_action_cards")
         .with_description("List all action cards with summary information")
         .build();
-    server_->register_tool(list_action_cards, tools::HandleListActionCards);
+    server_->register_tool(list_action_cards, tools::Traced("list_action_cards", tools::HandleListActionCards));
+
+    ::mcp::tool get_action_card_log = ::mcp::tool_builder("get_action_card_log")
+        .with_description("Read a page of an action card's log, oldest first. Cards keep their newest 1000 entries; log_first_index is the oldest still kept. Returns entries (index, timestamp, level, message), log_count and next_offset")
+        .with_string_param("id", "Action card ID")
+        .with_number_param("offset", "Index of the first entry wanted (optional, default: the oldest kept)", false)
+        .with_number_param("limit", "Most entries to return (optional, default: 100, at most 1000)", false)
+        .build();
+    server_->register_tool(get_action_card_log, tools::Traced("get_action_card_log", tools::HandleGetActionCardLog));
 
     ::mcp::tool delete_action_card = ::mcp::tool_builder("delete_action_card")
         .with_description("Delete an action card by ID")
         .with_string_param("id", "Action card ID")
         .build();
-    server_->register_tool(delete_action_card, tools::HandleDeleteActionCard);
+    server_->register_tool(delete_action_card, tools::Traced("delete_action_card", tools::HandleDeleteActionCard));
 
-    std::cout << "Registered " << 27 << " MCP tools" << std::endl;
+    std::cout << "Registered " << server_->get_tools().size() << " MCP tools" << std::endl;
 }
 
 void MCPServer::Run() {
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "mcp_server.h"  // From cpp-mcp
+#include <cstddef>
 #include <memory>
+#include <string>
 
 namespace pathview {
 
@@ -22,10 +24,19 @@ namespace mcp {
  */
 class MCPServer {
 public:
+    /**
+     * @param threadCount Threads running tool calls (0: cpp-mcp's default,
+     *        one per core). Half of them at most wait for events at a time,
+     *        so waiting sessions never starve the others' tool calls
+     * @param host Address to listen on (another machine's pathview-pool
+     *        needs one it can reach)
+     */
     MCPServer(ipc::IPCClient* ipcClient,
               http::SnapshotManager* snapshotManager,
               http::HTTPServer* httpServer,
-              int mcpPort = 9000);
+              int mcpPort = 9000,
+              size_t threadCount = 0,
+              const std::string& host = "127.0.0.1");
     ~MCPServer();
 
     // Delete copy constructor and assignment
@@ -2,8 +2,20 @@
 #include "../ipc/IPCClient.h"
 #include "../http/SnapshotManager.h"
 #include "../http/HTTPServer.h"
+#include "../ipc/SnapshotRing.h"
+#include "../ipc/RequestTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
 namespace pathview {
 namespace mcp {
 namespace tools {
@@ -13,16 +25,60 @@ static ipc::IPCClient* g_ipcClient = nullptr;
 static http::SnapshotManager* g_snapshotManager = nullptr;
 static http::HTTPServer* g_httpServer = nullptr;
 
+// Calls blocked in wait_for_events, each holding a server thread
+static size_t g_maxWaitingCalls = 4;
+static std::atomic<size_t> g_waitingCalls{0};
+
 void Initialize(ipc::IPCClient* ipcClient,
                 http::SnapshotManager* snapshotManager,
-                http::HTTPServer* httpServer) {
+                http::HTTPServer* httpServer,
+                size_t maxWaitingCalls) {
     g_ipcClient = ipcClient;
     g_snapshotManager = snapshotManager;
     g_httpServer = httpServer;
+    g_maxWaitingCalls = std::max<size_t>(1, maxWaitingCalls);
+}
+
+// Trace of the tool call this thread runs, if it was called with "trace"
+static thread_local ipc::RequestTrace* t_trace = nullptr;
+
+// Process of the spans recorded here
+static constexpr const char* TRACE_PROCESS = "pathview-mcp";
+
+ToolHandler Traced(const std::string& tool, ToolHandler handler) {
+    return [tool, handler = std::move(handler)](const ::mcp::json& params, const std::string& sessionId) {
+        if (!params.is_object() || !params.value("trace", false)) {
+            return handler(params, sessionId);
+        }
+        ::mcp::json forwarded = params;
+        forwarded.erase("trace");
+
+        ipc::RequestTrace trace(ipc::RequestTrace::NewId(), TRACE_PROCESS);
+        struct CurrentTrace {
+            ~CurrentTrace() { t_trace = nullptr; }
+        } current;
+        t_trace = &trace;
+        ipc::RequestTrace::Scope span(&trace, "mcp." + tool);
+        ::mcp::json result = handler(forwarded, sessionId);
+        span.End();
+        if (result.is_object()) {
+            result["trace"] = trace.ToChromeTrace();
+        }
+        return result;
+    };
 }
 
+// Requests that read state without depending on their connection may go on
+// any pooled IPC connection, so they do not wait behind other sessions'
+// slow requests (a snapshot being encoded, a slide being opened)
+static constexpr bool ANY_CONNECTION = true;
+static constexpr int IPC_TIMEOUT_MS = 5000;
+// A large region reads many tiles, each allowed 10s to load
+static constexpr int REGION_RENDER_TIMEOUT_MS = 120000;
+
 // Helper: Send IPC request and return response
-static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json& params) {
+static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json& params,
+                                  bool anyConnection = false, int timeoutMs = IPC_TIMEOUT_MS) {
     if (!g_ipcClient || !g_ipcClient->IsConnected()) {
         throw ::mcp::mcp_exception(::mcp::error_code::internal_error, "Not connected to GUI");
     }
@@ -31,9 +87,17 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     request.id = 1;  // ID doesn't matter for us
     request.method = method;
     request.params = params;
+    if (t_trace) {
+        request.traceId = t_trace->GetId();
+    }
 
     try {
-        ipc::IPCResponse response = g_ipcClient->SendRequest(request);
+        ipc::RequestTrace::Scope span(t_trace, "ipc.round_trip");
+        ipc::IPCResponse response = g_ipcClient->SendRequest(request, timeoutMs, anyConnection);
+        span.End();
+        if (t_trace && response.trace) {
+            t_trace->Merge(*response.trace);
+        }
 
         if (response.error.has_value()) {
             throw ::mcp::mcp_exception(
@@ -56,8 +120,12 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     return SendIPCRequest("slide.load", params);
 }
 
-::mcp::json HandleGetSlideInfo(const ::mcp::json&, const std::string&) {
-    return SendIPCRequest("slide.info", ::mcp::json::object());
+::mcp::json HandleGetSlideInfo(const ::mcp::json& params, const std::string&) {
+    ::mcp::json ipcParams = ::mcp::json::object();
+    if (params.contains("properties")) {
+        ipcParams["properties"] = params["properties"];
+    }
+    return SendIPCRequest("slide.info", ipcParams, ANY_CONNECTION);
 }
 
 ::mcp::json HandlePan(const ::mcp::json& params, const std::string&) {
@@ -100,31 +168,8 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     return SendIPCRequest("viewport.reset", ::mcp::json::object());
 }
 
-::mcp::json HandleCaptureSnapshot(const ::mcp::json& params, const std::string&) {
-    // Send IPC request to capture screenshot
-    ::mcp::json result = SendIPCRequest("snapshot.capture", params);
-
-    // If the GUI reported an error (returned as a normal result object), surface it cleanly.
-    if (result.contains("error")) {
-        throw ::mcp::mcp_exception(
-            ::mcp::error_code::internal_error,
-            result["error"].get<std::string>()
-        );
-    }
-
-    if (!result.contains("png_data")) {
-        throw ::mcp::mcp_exception(
-            ::mcp::error_code::internal_error,
-            "snapshot.capture response missing 'png_data'"
-        );
-    }
-
-    // Decode base64 PNG data
-    std::string base64 = result["png_data"].get<std::string>();
-    int width = result["width"].get<int>();
-    int height = result["height"].get<int>();
-
-    // Decode base64 to binary
+// Standard base64 (snapshot.capture's inline PNG data) to binary
+static std::vector<uint8_t> DecodeBase64(const std::string& base64) {
     static const std::string base64_chars =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
         "abcdefghijklmnopqrstuvwxyz"
@@ -163,19 +208,270 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
         for (j = 0; j < i - 1; j++)
             pngData.push_back(char_array_3[j]);
     }
+    return pngData;
+}
+
+// Reader side of the GUI's shared-memory snapshot slots, opened on first
+// use and again when a different GUI (ring name) answers; from the
+// descriptor passed over the Unix socket when there is one
+static std::unique_ptr<ipc::SnapshotRing> g_snapshotRing;
+static std::mutex g_snapshotRingMutex;
+
+static bool ReadSnapshotSlot(const ::mcp::json& shm, std::vector<uint8_t>& pngData) {
+    std::lock_guard<std::mutex> lock(g_snapshotRingMutex);
+    const std::string name = shm.value("name", "");
+    const int passedFd = shm.value("fd_attached", false) ? g_ipcClient->TakePassedFd() : -1;
+    const bool reopen = !g_snapshotRing || g_snapshotRing->GetName() != name;
+    if (reopen) {
+        g_snapshotRing = passedFd >= 0 ? ipc::SnapshotRing::OpenFd(passedFd, name)
+                                       : ipc::SnapshotRing::Open(name);
+    }
+#ifndef _WIN32
+    if (!reopen && passedFd >= 0) {
+        close(passedFd);  // Already mapped
+    }
+#endif
+    if (!g_snapshotRing) {
+        return false;
+    }
+    ipc::SnapshotRing::SlotRef ref;
+    ref.slot = shm.value("slot", 0u);
+    ref.sequence = shm.value("sequence", uint64_t(0));
+    ref.size = shm.value("size", uint64_t(0));
+    return g_snapshotRing->Read(ref, pngData);
+}
 
-    // Store in snapshot manager
-    std::string snapshotId = g_snapshotManager->AddSnapshot(pngData, width, height);
+// Image bytes of a snapshot.capture or region.render result: from its
+// shared-memory slot, else inline. false if the slot is gone (this process
+// cannot map it, or later images reused it before it was read).
+static bool ReadImage(const std::string& method, const ::mcp::json& result, std::vector<uint8_t>& pngData) {
+    if (result.contains("shm")) {
+        return ReadSnapshotSlot(result["shm"], pngData);
+    }
 
-    // Also add to stream buffer for MJPEG streaming
-    g_snapshotManager->AddStreamFrame(snapshotId);
+    // PNG arrives as "png_data", other formats as "image_data"
+    const char* key = result.contains("png_data") ? "png_data" : "image_data";
+    if (!result.contains(key)) {
+        throw ::mcp::mcp_exception(
+            ::mcp::error_code::internal_error,
+            method + " response missing image data"
+        );
+    }
+    if (result[key].is_binary()) {
+        pngData = result[key].get_binary();  // Binary IPC encoding
+    } else {
+        pngData = DecodeBase64(result[key].get<std::string>());
+    }
+    return true;
+}
+
+// Store an image in the snapshot manager, also pushing it to /stream
+// clients if publish. result is the GUI's answer; the response names the
+// stored image.
+static ::mcp::json StoreImage(std::vector<uint8_t> pngData, const ::mcp::json& result, bool publish) {
+    int width = result["width"].get<int>();
+    int height = result["height"].get<int>();
+    std::string mimeType = result.value("mime_type", std::string("image/png"));
+
+    if (publish && g_httpServer) {
+        g_httpServer->GetFrameStream().Publish(pngData, mimeType, width, height);
+    }
+    // An image seen before (same "content_hash") keeps its ID and is not stored twice
+    std::string snapshotId = g_snapshotManager->AddSnapshot(std::move(pngData), width, height, mimeType,
+                                                            result.value("content_hash", std::string()));
 
     return ::mcp::json{
         {"id", snapshotId},
         {"url", "http://127.0.0.1:8080/snapshot/" + snapshotId},
         {"width", width},
-        {"height", height}
+        {"height", height},
+        {"format", result.value("format", std::string("png"))}
+    };
+}
+
+// Fetch an image the GUI encodes (snapshot.capture, region.render) and
+// store it (StoreImage). result is the GUI's answer.
+static ::mcp::json FetchImage(const std::string& method, ::mcp::json request, int timeoutMs, bool publish,
+                              ::mcp::json& result) {
+    // Ask for the image in shared memory: the response carries only its
+    // slot. "format" and "quality" pass through to the GUI.
+    request["transport"] = "shm";
+    result = SendIPCRequest(method, request, ANY_CONNECTION, timeoutMs);
+
+    // If the GUI reported an error (returned as a normal result object), surface it cleanly.
+    if (result.contains("error")) {
+        throw ::mcp::mcp_exception(
+            ::mcp::error_code::internal_error,
+            result["error"].get<std::string>()
+        );
+    }
+
+    // The slot can be gone: ask again with the data inline
+    std::vector<uint8_t> pngData;
+    ipc::RequestTrace::Scope readSpan(t_trace, "mcp.read_image");
+    const bool read = ReadImage(method, result, pngData);
+    readSpan.End();
+    if (!read) {
+        request["transport"] = "inline";
+        request.erase("await_sharp");  // Waited once already
+        result = SendIPCRequest(method, request, ANY_CONNECTION, timeoutMs);
+        if (result.contains("error")) {
+            throw ::mcp::mcp_exception(::mcp::error_code::internal_error, result["error"].get<std::string>());
+        }
+        ipc::RequestTrace::Scope inlineSpan(t_trace, "mcp.read_image");
+        ReadImage(method, result, pngData);
+    }
+    ipc::RequestTrace::Scope storeSpan(t_trace, "mcp.store");
+    return StoreImage(std::move(pngData), result, publish);
+}
+
+// snapshot.capture's timeout: "await_sharp" holds the answer until the
+// view is sharp, up to its "timeout_ms"; the GUI clamps it to 30s
+static int CaptureTimeoutMs(const ::mcp::json& params) {
+    return params.value("await_sharp", false)
+               ? IPC_TIMEOUT_MS + std::clamp(params.value("timeout_ms", 5000), 0, 30000)
+               : IPC_TIMEOUT_MS;
+}
+
+::mcp::json HandleCaptureSnapshot(const ::mcp::json& params, const std::string&) {
+    ::mcp::json result;
+    ::mcp::json response = FetchImage("snapshot.capture", params, CaptureTimeoutMs(params), true, result);
+    if (result.contains("sharp")) {
+        response["sharp"] = result["sharp"];
+        response["waited_ms"] = result["waited_ms"];
+    }
+    return response;
+}
+
+::mcp::json HandleRenderRegion(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("x") || !params.contains("y") ||
+        !params.contains("width") || !params.contains("height")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'x', 'y', 'width', or 'height' parameters");
+    }
+
+    // Not the live view: stored, not pushed to /stream
+    ::mcp::json result;
+    ::mcp::json response = FetchImage("region.render", params, REGION_RENDER_TIMEOUT_MS, false, result);
+    response["region"] = result["region"];
+    response["downsample"] = result["downsample"];
+    if (result.contains("overlays")) {
+        response["overlays"] = result["overlays"];
+    }
+    return response;
+}
+
+::mcp::json HandleScanRegions(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("regions") && !params.contains("grid")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'regions' or 'grid' parameter");
+    }
+    return SendIPCRequest("region.scan", params, ANY_CONNECTION);
+}
+
+::mcp::json HandleGetRegionScanResults(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("token")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'token' parameter");
+    }
+
+    // Images come in shared-memory slots, one per slot at most. The GUI
+    // keeps them until a later call's 'since' passes them, so a slot
+    // reused before it was read is fetched again inline.
+    ::mcp::json request = params;
+    request["transport"] = "shm";
+    ::mcp::json result = SendIPCRequest("region.scan_results", request, ANY_CONNECTION);
+    if (result.contains("error")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::internal_error, result["error"].get<std::string>());
+    }
+    std::vector<std::vector<uint8_t>> images;
+    for (const ::mcp::json& field : result["results"]) {
+        images.emplace_back();
+        if (!field.contains("error") && !ReadImage("region.scan_results", field, images.back())) {
+            request["transport"] = "inline";
+            result = SendIPCRequest("region.scan_results", request, ANY_CONNECTION);
+            if (result.contains("error")) {
+                throw ::mcp::mcp_exception(::mcp::error_code::internal_error, result["error"].get<std::string>());
+            }
+            images.clear();
+            for (const ::mcp::json& inlineField : result["results"]) {
+                images.emplace_back();
+                if (!inlineField.contains("error")) {
+                    ReadImage("region.scan_results", inlineField, images.back());
+                }
+            }
+            break;
+        }
+    }
+
+    // Not the live view: stored, not pushed to /stream
+    ::mcp::json fields = ::mcp::json::array();
+    for (size_t i = 0; i < result["results"].size() && i < images.size(); ++i) {
+        const ::mcp::json& field = result["results"][i];
+        ::mcp::json stored = field.contains("error")
+            ? ::mcp::json{{"error", field["error"]}}
+            : StoreImage(std::move(images[i]), field, false);
+        stored["field"] = field["field"];
+        stored["region"] = field["region"];
+        fields.push_back(std::move(stored));
+    }
+    result["results"] = fields;
+    return result;
+}
+
+::mcp::json HandleCancelRegionScan(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("token")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'token' parameter");
+    }
+    return SendIPCRequest("region.scan_cancel", params, ANY_CONNECTION);
+}
+
+::mcp::json HandleExportRegion(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("x") || !params.contains("y") ||
+        !params.contains("width") || !params.contains("height") || !params.contains("path")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'x', 'y', 'width', 'height', or 'path' parameters");
+    }
+    return SendIPCRequest("region.export", params);
+}
+
+::mcp::json HandleWaitForEvents(const ::mcp::json& params, const std::string&) {
+    if (!g_httpServer) {
+        throw ::mcp::mcp_exception(::mcp::error_code::internal_error, "Event stream not available");
+    }
+    const uint64_t afterSequence = params.value("after_sequence", static_cast<uint64_t>(0));
+    int timeoutMs = std::clamp(params.value("timeout_ms", 10000), 0, 60000);
+
+    // Past the limit of waiting calls, answer with what there is instead of
+    // taking another server thread away from other sessions' tool calls
+    const bool throttled = g_waitingCalls.fetch_add(1) >= g_maxWaitingCalls;
+    struct WaitSlot {
+        ~WaitSlot() { g_waitingCalls.fetch_sub(1); }
+    } slot;
+    if (throttled) {
+        timeoutMs = 0;
+    }
+
+    http::EventStream& stream = g_httpServer->GetEventStream();
+    ::mcp::json events = ::mcp::json::array();
+    uint64_t sequence = afterSequence;
+    for (const http::EventStream::Event& event : stream.WaitForEvents(afterSequence, std::chrono::milliseconds(timeoutMs))) {
+        events.push_back({
+            {"type", event.type},
+            {"sequence", event.sequence},
+            {"data", ::mcp::json::parse(event.data)}
+        });
+        sequence = event.sequence;
+    }
+    ::mcp::json result = {
+        {"events", events},
+        {"sequence", sequence}
     };
+    if (throttled) {
+        result["throttled"] = true;
+    }
+    return result;
 }
 
 ::mcp::json HandleLoadPolygons(const ::mcp::json& params, const std::string&) {
@@ -194,18 +490,86 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
                                     "Missing 'x', 'y', 'w', or 'h' parameters");
     }
 
-    return SendIPCRequest("polygons.query", params);
+    ::mcp::json ipcParams = params;
+    if (params.contains("classes") && params["classes"].is_string()) {
+        ::mcp::json classes = ::mcp::json::array();
+        std::stringstream list(params["classes"].get<std::string>());
+        std::string classId;
+        while (std::getline(list, classId, ',')) {
+            if (classId.find_first_not_of(" ") == std::string::npos) {
+                continue;
+            }
+            try {
+                classes.push_back(std::stoi(classId));
+            } catch (const std::exception&) {
+                throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                            "'classes' must be comma-separated class IDs");
+            }
+        }
+        ipcParams["classes"] = classes;
+    }
+    // Agents read the cells as JSON whatever this connection's encoding
+    ipcParams["packed"] = false;
+    return SendIPCRequest("polygons.query", ipcParams, ANY_CONNECTION);
+}
+
+::mcp::json HandleSummarizePolygons(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("x") || !params.contains("y") ||
+        !params.contains("w") || !params.contains("h")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'x', 'y', 'w', or 'h' parameters");
+    }
+    return SendIPCRequest("polygons.summarize", params, ANY_CONNECTION);
 }
 
 ::mcp::json HandleSetPolygonVisibility(const ::mcp::json& params, const std::string&) {
-    if (!params.contains("visible")) {
+    if (!params.contains("visible") && !params.contains("min_confidence")) {
         throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
-                                    "Missing 'visible' parameter");
+                                    "Missing 'visible' or 'min_confidence' parameter");
     }
 
     return SendIPCRequest("polygons.set_visibility", params);
 }
 
+::mcp::json HandleSetPolygonOutline(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("enabled") && !params.contains("width")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'enabled' or 'width' parameter");
+    }
+    if (params.contains("class_id") && !params.contains("width")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "'class_id' needs a 'width'");
+    }
+
+    return SendIPCRequest("polygons.set_outline", params);
+}
+
+::mcp::json HandleSetMinimapDensity(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("enabled") && !params.contains("class_id")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'enabled' or 'class_id' parameter");
+    }
+
+    return SendIPCRequest("polygons.set_minimap_density", params);
+}
+
+::mcp::json HandleListPolygonLayers(const ::mcp::json&, const std::string&) {
+    return SendIPCRequest("polygons.layers", ::mcp::json::object());
+}
+
+::mcp::json HandleSetPolygonLayer(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("layer")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'layer' parameter");
+    }
+    if (!params.contains("visible") && !params.contains("active") && !params.contains("remove")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'visible', 'active' or 'remove' parameter");
+    }
+
+    return SendIPCRequest("polygons.set_layer", params);
+}
+
 ::mcp::json HandleAgentHello(const ::mcp::json& params, const std::string& sessionId) {
     // Extract agent identity
     std::string agentName = params.value("agent_name", "");
@@ -245,7 +609,7 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
 }
 
 ::mcp::json HandleNavLockStatus(const ::mcp::json&, const std::string&) {
-    return SendIPCRequest("nav.lock_status", ::mcp::json::object());
+    return SendIPCRequest("nav.lock_status", ::mcp::json::object(), ANY_CONNECTION);
 }
 
 ::mcp::json HandleMoveCamera(const ::mcp::json& params, const std::string&) {
@@ -264,6 +628,11 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     return SendIPCRequest("viewport.await_move", params);
 }
 
+::mcp::json HandlePlanTour(const ::mcp::json& params, const std::string&) {
+    // Prefetch only: the view does not move, so no navigation lock
+    return SendIPCRequest("viewport.plan", params, ANY_CONNECTION);
+}
+
 ::mcp::json HandleCreateAnnotation(const ::mcp::json& params, const std::string&) {
     if (!params.contains("vertices")) {
         throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
@@ -273,7 +642,7 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
 }
 
 ::mcp::json HandleListAnnotations(const ::mcp::json& params, const std::string&) {
-    return SendIPCRequest("annotations.list", params);
+    return SendIPCRequest("annotations.list", params, ANY_CONNECTION);
 }
 
 ::mcp::json HandleGetAnnotation(const ::mcp::json& params, const std::string&) {
@@ -281,7 +650,7 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
         throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
                                     "Missing 'id' parameter");
     }
-    return SendIPCRequest("annotations.get", params);
+    return SendIPCRequest("annotations.get", params, ANY_CONNECTION);
 }
 
 ::mcp::json HandleDeleteAnnotation(const ::mcp::json& params, const std::string&) {
@@ -292,12 +661,40 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     return SendIPCRequest("annotations.delete", params);
 }
 
+::mcp::json HandleExportAnnotations(const ::mcp::json& params, const std::string&) {
+    return SendIPCRequest("annotations.export", params, ANY_CONNECTION);
+}
+
+::mcp::json HandleImportAnnotations(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("geojson") && !params.contains("path")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'geojson' or 'path' parameter");
+    }
+    return SendIPCRequest("annotations.import", params);
+}
+
 ::mcp::json HandleComputeROIMetrics(const ::mcp::json& params, const std::string&) {
     if (!params.contains("vertices")) {
         throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
                                     "Missing 'vertices' parameter");
     }
-    return SendIPCRequest("annotations.compute_metrics", params);
+    return SendIPCRequest("annotations.compute_metrics", params, ANY_CONNECTION);
+}
+
+::mcp::json HandleComputeROIMetricsBatch(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("rois")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'rois' parameter");
+    }
+    return SendIPCRequest("annotations.compute_metrics_batch", params);
+}
+
+::mcp::json HandleGetROIMetricsBatch(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("token")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'token' parameter");
+    }
+    return SendIPCRequest("annotations.batch_results", params, ANY_CONNECTION);
 }
 
 ::mcp::json HandleCreateActionCard(const ::mcp::json& params, const std::string&) {
@@ -325,7 +722,15 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
 }
 
 ::mcp::json HandleListActionCards(const ::mcp::json&, const std::string&) {
-    return SendIPCRequest("action_card.list", ::mcp::json::object());
+    return SendIPCRequest("action_card.list", ::mcp::json::object(), ANY_CONNECTION);
+}
+
+::mcp::json HandleGetActionCardLog(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("id")) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'id' parameter");
+    }
+    return SendIPCRequest("action_card.get_log", params, ANY_CONNECTION);
 }
 
 ::mcp::json HandleDeleteActionCard(const ::mcp::json& params, const std::string&) {
@@ -336,6 +741,102 @@ static ::mcp::json SendIPCRequest(const std::string& method, const ::mcp::json&
     return SendIPCRequest("action_card.delete", params);
 }
 
+// Tools run_steps can chain, by the IPC method each forwards to
+struct StepTool {
+    const char* tool;
+    const char* method;
+    bool image;  // Answered with an image, stored like capture_snapshot's
+};
+
+static constexpr StepTool STEP_TOOLS[] = {
+    {"get_slide_info", "slide.info", false},
+    {"pan", "viewport.pan", false},
+    {"center_on", "viewport.center_on", false},
+    {"zoom", "viewport.zoom", false},
+    {"zoom_at_point", "viewport.zoom_at_point", false},
+    {"reset_view", "viewport.reset", false},
+    {"move_camera", "viewport.move", false},
+    {"await_move", "viewport.await_move", false},
+    {"capture_snapshot", "snapshot.capture", true},
+    {"render_region", "region.render", true},
+    {"summarize_polygons", "polygons.summarize", false},
+    {"set_polygon_visibility", "polygons.set_visibility", false},
+    {"create_annotation", "annotations.create", false},
+    {"list_annotations", "annotations.list", false},
+    {"get_annotation", "annotations.get", false},
+    {"delete_annotation", "annotations.delete", false},
+    {"compute_roi_metrics", "annotations.compute_metrics", false},
+    {"create_action_card", "action_card.create", false},
+    {"update_action_card", "action_card.update", false},
+    {"append_action_card_log", "action_card.append_log", false},
+};
+
+::mcp::json HandleRunSteps(const ::mcp::json& params, const std::string&) {
+    if (!params.contains("steps") || !params["steps"].is_array() || params["steps"].empty()) {
+        throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                    "Missing 'steps' array");
+    }
+
+    // One IPC batch: the GUI runs the steps back to back, so the timeout
+    // is the sum of theirs
+    ::mcp::json steps = ::mcp::json::array();
+    std::vector<const StepTool*> tools;
+    int timeoutMs = 0;
+    for (const ::mcp::json& step : params["steps"]) {
+        const std::string name = step.is_object() ? step.value("tool", std::string()) : std::string();
+        const StepTool* tool = nullptr;
+        for (const StepTool& candidate : STEP_TOOLS) {
+            if (name == candidate.tool) {
+                tool = &candidate;
+            }
+        }
+        if (!tool) {
+            throw ::mcp::mcp_exception(::mcp::error_code::invalid_params,
+                                        "'" + name + "' cannot be a step");
+        }
+        ::mcp::json stepParams = step.value("params", ::mcp::json::object());
+        if (tool->image) {
+            // Several images in one response: inline, not one slot each
+            stepParams["transport"] = "inline";
+            timeoutMs += tool->method == std::string("region.render") ? REGION_RENDER_TIMEOUT_MS
+                                                                      : CaptureTimeoutMs(stepParams);
+        } else {
+            timeoutMs += IPC_TIMEOUT_MS;
+        }
+        steps.push_back({{"method", tool->method}, {"params", stepParams}});
+        tools.push_back(tool);
+    }
+
+    ::mcp::json response = SendIPCRequest("batch", {
+        {"steps", steps},
+        {"continue_on_error", params.value("continue_on_error", false)}
+    }, false, timeoutMs);
+
+    // Images are stored and named, as capture_snapshot and render_region answer
+    ::mcp::json& results = response["results"];
+    for (size_t i = 0; i < results.size() && i < tools.size(); ++i) {
+        if (!tools[i]->image || !results[i].contains("result")) {
+            continue;
+        }
+        const ::mcp::json result = results[i]["result"];
+        if (result.contains("error")) {
+            results[i] = {{"error", result["error"]}};
+            continue;
+        }
+        ipc::RequestTrace::Scope storeSpan(t_trace, "mcp.store");
+        std::vector<uint8_t> pngData;
+        ReadImage(tools[i]->method, result, pngData);
+        ::mcp::json stored = StoreImage(std::move(pngData), result, tools[i]->method == std::string("snapshot.capture"));
+        for (const char* key : {"sharp", "waited_ms", "region", "downsample", "overlays"}) {
+            if (result.contains(key)) {
+                stored[key] = result[key];
+            }
+        }
+        results[i]["result"] = stored;
+    }
+    return response;
+}
+
 } // namespace tools
 } // namespace mcp
 } // namespace pathview
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "mcp_message.h"  // From cpp-mcp
+#include <cstddef>
+#include <functional>
 #include <string>
 
 namespace pathview {
@@ -23,10 +25,20 @@ namespace mcp {
  */
 namespace tools {
 
-// Initialize tool handlers with IPC client and HTTP infrastructure
+// Initialize tool handlers with IPC client and HTTP infrastructure.
+// maxWaitingCalls: wait_for_events calls that may block a server thread at
+// once; later ones return at once with "throttled"
 void Initialize(ipc::IPCClient* ipcClient,
                 http::SnapshotManager* snapshotManager,
-                http::HTTPServer* httpServer);
+                http::HTTPServer* httpServer,
+                size_t maxWaitingCalls = 4);
+
+using ToolHandler = std::function<::mcp::json(const ::mcp::json& params, const std::string& sessionId)>;
+
+// handler, traced when called with "trace": true: the call, its GUI
+// requests and the GUI's own spans (ipc::RequestTrace) are returned in the
+// result's "trace", in Chrome trace format
+ToolHandler Traced(const std::string& tool, ToolHandler handler);
 
 // Slide control tools
 ::mcp::json HandleLoadSlide(const ::mcp::json& params, const std::string& sessionId);
@@ -39,13 +51,33 @@ void Initialize(ipc::IPCClient* ipcClient,
 ::mcp::json HandleZoomAtPoint(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleResetView(const ::mcp::json& params, const std::string& sessionId);
 
-// Snapshot tool
+// Snapshot tools: the viewport as shown, or any region at any resolution
 ::mcp::json HandleCaptureSnapshot(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleRenderRegion(const ::mcp::json& params, const std::string& sessionId);
+
+// Region scans: many fields rendered off screen in parallel, results
+// polled by token and stored like render_region's
+::mcp::json HandleScanRegions(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleGetRegionScanResults(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleCancelRegionScan(const ::mcp::json& params, const std::string& sessionId);
+
+// Pyramidal TIFF export of a region with overlays burned in, in the
+// background, its progress on an action card
+::mcp::json HandleExportRegion(const ::mcp::json& params, const std::string& sessionId);
+
+// Pushed viewer events (viewport, tiles_settled, annotations), instead of
+// polling get_slide_info until the view settles
+::mcp::json HandleWaitForEvents(const ::mcp::json& params, const std::string& sessionId);
 
 // Polygon tools
 ::mcp::json HandleLoadPolygons(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleQueryPolygons(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleSummarizePolygons(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleSetPolygonVisibility(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleSetPolygonOutline(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleSetMinimapDensity(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleListPolygonLayers(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleSetPolygonLayer(const ::mcp::json& params, const std::string& sessionId);
 
 // Session management tools
 ::mcp::json HandleAgentHello(const ::mcp::json& params, const std::string& sessionId);
@@ -58,19 +90,28 @@ void Initialize(ipc::IPCClient* ipcClient,
 // Tracked camera movement tools
 ::mcp::json HandleMoveCamera(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleAwaitMove(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandlePlanTour(const ::mcp::json& params, const std::string& sessionId);
 
 // Annotation/ROI tools
 ::mcp::json HandleCreateAnnotation(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleListAnnotations(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleGetAnnotation(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleDeleteAnnotation(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleExportAnnotations(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleImportAnnotations(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleComputeROIMetrics(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleComputeROIMetricsBatch(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleGetROIMetricsBatch(const ::mcp::json& params, const std::string& sessionId);
+
+// Several tools in one GUI round trip, later steps taking earlier results
+::mcp::json HandleRunSteps(const ::mcp::json& params, const std::string& sessionId);
 
 // Action card tools
 ::mcp::json HandleCreateActionCard(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleUpdateActionCard(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleAppendActionCardLog(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleListActionCards(const ::mcp::json& params, const std::string& sessionId);
+::mcp::json HandleGetActionCardLog(const ::mcp::json& params, const std::string& sessionId);
 ::mcp::json HandleDeleteActionCard(const ::mcp::json& params, const std::string& sessionId);
 
 } // namespace tools
@@ -17,6 +17,7 @@
 #include <thread>
 #include <csignal>
 #include <atomic>
+#include <algorithm>
 
 // Global flag for graceful shutdown
 std::atomic<bool> g_running(true);
@@ -37,8 +38,18 @@ void print_usage(const char* progName) {
     std::cout << "Usage: " << progName << " [options]\n"
               << "\nOptions:\n"
               << "  --ipc-port PORT    IPC port to connect to GUI (default: auto-detect from port file)\n"
+              << "  --ipc-socket PATH  IPC Unix socket to connect to GUI instead (default: auto-detect\n"
+              << "                     from socket file, preferred over the port)\n"
+              << "  --ipc-connections N\n"
+              << "                     IPC connections to the GUI, for read-only calls from\n"
+              << "                     parallel sessions (default: 4)\n"
               << "  --http-port PORT   HTTP server port (default: 8080)\n"
               << "  --mcp-port PORT    MCP server port (default: 9000)\n"
+              << "  --host HOST        Address the MCP and HTTP servers listen on (default:\n"
+              << "                     127.0.0.1; another machine's pathview-pool needs one\n"
+              << "                     it can reach)\n"
+              << "  --mcp-threads N    Threads running tool calls, half of which may wait in\n"
+              << "                     wait_for_events at once (default: one per core)\n"
               << "  --help             Show this help message\n"
               << "\nExample:\n"
               << "  " << progName << " --ipc-port 9999 --http-port 8080\n"
@@ -48,8 +59,12 @@ void print_usage(const char* progName) {
 int main(int argc, char** argv) {
     // Parse command line arguments
     int ipcPort = -1;  // -1 means auto-detect from port file
+    std::string ipcSocket;
+    int ipcConnections = 4;
     int httpPort = 8080;
     int mcpPort = 9000;
+    int mcpThreads = 0;
+    std::string host = "127.0.0.1";
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -59,10 +74,18 @@ int main(int argc, char** argv) {
             return 0;
         } else if (arg == "--ipc-port" && i + 1 < argc) {
             ipcPort = std::atoi(argv[++i]);
+        } else if (arg == "--ipc-socket" && i + 1 < argc) {
+            ipcSocket = argv[++i];
+        } else if (arg == "--ipc-connections" && i + 1 < argc) {
+            ipcConnections = std::max(1, std::atoi(argv[++i]));
         } else if (arg == "--http-port" && i + 1 < argc) {
             httpPort = std::atoi(argv[++i]);
         } else if (arg == "--mcp-port" && i + 1 < argc) {
             mcpPort = std::atoi(argv[++i]);
+        } else if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "--mcp-threads" && i + 1 < argc) {
+            mcpThreads = std::max(0, std::atoi(argv[++i]));
         } else {
             std::cerr << "Unknown argument: " << arg << std::endl;
             print_usage(argv[0]);
@@ -70,10 +93,16 @@ int main(int argc, char** argv) {
         }
     }
 
-    // Auto-detect port if not specified
-    if (ipcPort < 0) {
-        ipcPort = pathview::ipc::IPCClient::ReadPortFromFile();
-        std::cout << "Auto-detected IPC port: " << ipcPort << std::endl;
+    // Auto-detect if not specified: the GUI's Unix socket if it has one
+    // (faster, and snapshot memory can be passed over it), else its port
+    if (ipcPort < 0 && ipcSocket.empty()) {
+        ipcSocket = pathview::ipc::IPCClient::ReadSocketPathFromFile();
+        if (!ipcSocket.empty()) {
+            std::cout << "Auto-detected IPC socket: " << ipcSocket << std::endl;
+        } else {
+            ipcPort = pathview::ipc::IPCClient::ReadPortFromFile();
+            std::cout << "Auto-detected IPC port: " << ipcPort << std::endl;
+        }
     }
 
     // Setup signal handlers
@@ -83,8 +112,31 @@ int main(int argc, char** argv) {
     std::cout << "PathView MCP Server v0.1.0\n" << std::endl;
 
     // 1. Connect to GUI via IPC
-    std::cout << "Connecting to PathView GUI at localhost:" << ipcPort << "..." << std::endl;
-    pathview::ipc::IPCClient ipcClient(ipcPort);
+    std::cout << "Connecting to PathView GUI at "
+              << (ipcSocket.empty() ? "localhost:" + std::to_string(ipcPort) : ipcSocket) << "..." << std::endl;
+    pathview::ipc::IPCClient ipcClient = ipcSocket.empty() ? pathview::ipc::IPCClient(ipcPort)
+                                                           : pathview::ipc::IPCClient(ipcSocket);
+    ipcClient.SetPoolSize(static_cast<size_t>(ipcConnections));
+
+    // Viewer events the GUI pushes feed the HTTP server's /events and the
+    // wait_for_events tool, once the HTTP server exists; its metrics are
+    // served at /metrics instead
+    std::atomic<pathview::http::EventStream*> eventStream{nullptr};
+    std::atomic<pathview::http::Metrics*> metrics{nullptr};
+    ipcClient.SetNotificationHandler([&eventStream, &metrics](const std::string& method,
+                                                              const pathview::ipc::json& params) {
+        const std::string prefix = "event.";
+        if (method == "event.metrics") {
+            if (pathview::http::Metrics* target = metrics.load()) {
+                target->SetForwarded(params.value("text", std::string()));
+            }
+            return;
+        }
+        pathview::http::EventStream* stream = eventStream.load();
+        if (stream && method.compare(0, prefix.size(), prefix) == 0) {
+            stream->Publish(method.substr(prefix.size()), params.dump());
+        }
+    });
 
     if (!ipcClient.Connect()) {
         std::cerr << "Failed to connect to GUI. Please ensure PathView is running." << std::endl;
@@ -99,9 +151,10 @@ int main(int argc, char** argv) {
 
     // 3. Create HTTP server
     pathview::http::HTTPServer httpServer(httpPort, &snapshotManager);
+    httpServer.SetHost(host);
 
     // 4. Start HTTP server in background thread
-    std::cout << "Starting HTTP server on http://127.0.0.1:" << httpPort << "..." << std::endl;
+    std::cout << "Starting HTTP server on http://" << host << ":" << httpPort << "..." << std::endl;
     std::thread httpThread([&httpServer]() {
         httpServer.Start();
     });
@@ -117,9 +170,26 @@ int main(int argc, char** argv) {
 
     std::cout << "HTTP server running\n" << std::endl;
 
+    // Subscribe on the first connection, whose reader hands events over
+    eventStream = &httpServer.GetEventStream();
+    metrics = &httpServer.GetMetrics();
+    try {
+        pathview::ipc::IPCRequest subscribe;
+        subscribe.id = 0;
+        subscribe.method = "events.subscribe";
+        subscribe.params = {{"events", {"viewport", "tiles_settled", "annotations", "metrics"}}};
+        pathview::ipc::IPCResponse response = ipcClient.SendRequest(subscribe);
+        if (response.error) {
+            std::cerr << "Warning: GUI did not accept event subscription: " << response.error->message << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: Failed to subscribe to GUI events: " << e.what() << std::endl;
+    }
+
     // 5. Create and configure MCP server
     std::cout << "Initializing MCP server..." << std::endl;
-    pathview::mcp::MCPServer mcpServer(&ipcClient, &snapshotManager, &httpServer, mcpPort);
+    pathview::mcp::MCPServer mcpServer(&ipcClient, &snapshotManager, &httpServer, mcpPort,
+                                       static_cast<size_t>(mcpThreads), host);
     g_mcpServer = &mcpServer;
     mcpServer.RegisterTools();
 
@@ -130,15 +200,16 @@ int main(int argc, char** argv) {
               << " PathView MCP Server Ready!\n"
               << "===========================================================\n"
               << "\n"
-              << "  MCP Server:  http://127.0.0.1:" << mcpPort << "\n"
-              << "  SSE Endpoint: http://127.0.0.1:" << mcpPort << "/sse\n"
-              << "  HTTP Server: http://127.0.0.1:" << httpPort << "\n"
+              << "  MCP Server:  http://" << host << ":" << mcpPort << "\n"
+              << "  SSE Endpoint: http://" << host << ":" << mcpPort << "/sse\n"
+              << "  HTTP Server: http://" << host << ":" << httpPort << "\n"
+              << "  Events:      http://" << host << ":" << httpPort << "/events\n"
               << "  GUI IPC:     localhost:" << ipcPort << "\n"
               << "\n"
               << "Available Tools:\n"
               << "  - load_slide, get_slide_info\n"
               << "  - pan, center_on, zoom, zoom_at_point, reset_view\n"
-              << "  - capture_snapshot\n"
+              << "  - capture_snapshot, wait_for_events, run_steps\n"
               << "  - load_polygons, query_polygons, set_polygon_visibility\n"
               << "\n"
               << "Press Ctrl+C to stop\n"
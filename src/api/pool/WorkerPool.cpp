@@ -0,0 +1,205 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace pathview {
+namespace pool {
+
+std::string WorkerPool::Add(const std::string& mcpUrl, const std::string& httpUrl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker worker;
+    worker.id = "w" + std::to_string(nextWorker_++);
+    worker.mcpUrl = mcpUrl;
+    worker.httpUrl = httpUrl;
+    workers_.push_back(worker);
+    return worker.id;
+}
+
+WorkerPool::Worker* WorkerPool::Find(const std::string& workerId) {
+    for (Worker& worker : workers_) {
+        if (worker.id == workerId) {
+            return &worker;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkerPool::SetLoad(const std::string& workerId, double queueDepth) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker* worker = Find(workerId);
+    if (!worker) {
+        return false;
+    }
+    worker->queueDepth = std::max(0.0, queueDepth);
+    if (worker->state == State::Starting || worker->state == State::Unreachable) {
+        worker->state = State::Ready;
+    }
+    return true;
+}
+
+void WorkerPool::SetUnreachable(const std::string& workerId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker* worker = Find(workerId);
+    if (worker && worker->state == State::Ready) {
+        worker->state = State::Unreachable;
+    }
+}
+
+bool WorkerPool::RouteSession(const std::string& slideKey, Route& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker* least = nullptr;
+    Worker* warm = nullptr;
+    for (Worker& worker : workers_) {
+        if (worker.state != State::Ready) {
+            continue;
+        }
+        if (!least || Load(worker) < Load(*least)) {
+            least = &worker;
+        }
+        bool hot = std::find(worker.hotSlides.begin(), worker.hotSlides.end(), slideKey) != worker.hotSlides.end();
+        if (hot && (!warm || Load(worker) < Load(*warm))) {
+            warm = &worker;
+        }
+    }
+    if (!least) {
+        return false;
+    }
+
+    Worker* chosen = warm && Load(*warm) <= Load(*least) + affinitySlack_ ? warm : least;
+    chosen->sessions++;
+    auto hot = std::find(chosen->hotSlides.begin(), chosen->hotSlides.end(), slideKey);
+    if (hot != chosen->hotSlides.end()) {
+        chosen->hotSlides.erase(hot);
+    }
+    chosen->hotSlides.insert(chosen->hotSlides.begin(), slideKey);
+    if (chosen->hotSlides.size() > MAX_HOT_SLIDES) {
+        chosen->hotSlides.resize(MAX_HOT_SLIDES);
+    }
+
+    out.session = "s" + std::to_string(nextSession_++);
+    out.worker = chosen->id;
+    out.mcpUrl = chosen->mcpUrl;
+    out.httpUrl = chosen->httpUrl;
+    out.affinity = chosen == warm;
+    sessions_[out.session] = chosen->id;
+    return true;
+}
+
+bool WorkerPool::EndSession(const std::string& sessionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(sessionId);
+    if (it == sessions_.end()) {
+        return false;
+    }
+    Worker* worker = Find(it->second);
+    if (worker && worker->sessions > 0) {
+        worker->sessions--;
+    }
+    sessions_.erase(it);
+    return true;
+}
+
+bool WorkerPool::Drain(const std::string& workerId, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker* worker = Find(workerId);
+    if (!worker || worker->state == State::Stopped) {
+        return false;
+    }
+    if (worker->state != State::Draining) {
+        worker->state = State::Draining;
+        worker->drainStarted = now;
+    }
+    return true;
+}
+
+void WorkerPool::DrainAll(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Worker& worker : workers_) {
+        if (worker.state != State::Stopped && worker.state != State::Draining) {
+            worker.state = State::Draining;
+            worker.drainStarted = now;
+        }
+    }
+}
+
+std::vector<WorkerPool::Worker> WorkerPool::TakeDrained(Clock::time_point now, std::chrono::seconds drainTimeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Worker> drained;
+    for (Worker& worker : workers_) {
+        if (worker.state != State::Draining ||
+            (worker.sessions > 0 && now - worker.drainStarted < drainTimeout)) {
+            continue;
+        }
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            it = it->second == worker.id ? sessions_.erase(it) : std::next(it);
+        }
+        worker.sessions = 0;
+        worker.state = State::Stopped;
+        drained.push_back(worker);
+    }
+    return drained;
+}
+
+std::vector<WorkerPool::Worker> WorkerPool::GetWorkers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workers_;
+}
+
+size_t WorkerPool::GetSessionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+}
+
+bool WorkerPool::AllStopped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::all_of(workers_.begin(), workers_.end(),
+                       [](const Worker& worker) { return worker.state == State::Stopped; });
+}
+
+double WorkerPool::SumMetric(const std::string& text, const std::string& name, bool& found) {
+    found = false;
+    double sum = 0.0;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        // name, name{labels}; not name_suffix or comments
+        if (line.compare(0, name.size(), name) != 0 || line.size() == name.size()) {
+            continue;
+        }
+        size_t valueStart;
+        if (line[name.size()] == '{') {
+            size_t close = line.find('}', name.size());
+            if (close == std::string::npos) {
+                continue;
+            }
+            valueStart = close + 1;
+        } else if (line[name.size()] == ' ') {
+            valueStart = name.size();
+        } else {
+            continue;
+        }
+        const char* begin = line.c_str() + valueStart;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end != begin) {
+            sum += value;
+            found = true;
+        }
+    }
+    return sum;
+}
+
+const char* WorkerPool::StateName(State state) {
+    switch (state) {
+        case State::Starting: return "starting";
+        case State::Ready: return "ready";
+        case State::Unreachable: return "unreachable";
+        case State::Draining: return "draining";
+        case State::Stopped: return "stopped";
+    }
+    return "";
+}
+
+} // namespace pool
+} // namespace pathview
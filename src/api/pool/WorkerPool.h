@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pathview {
+namespace pool {
+
+/**
+ * Which pathview instance each agent session goes to (pathview-pool)
+ *
+ * A worker is one headless pathview with its pathview-mcp, reached at the
+ * MCP server's URL; its HTTP server's /metrics tells how busy it is. A
+ * session is routed by the slide it will work on: to a worker that
+ * opened that slide recently, whose tile caches (memory and disk, both
+ * keyed by the slide's fingerprint) are still warm, unless that worker is
+ * busier than the least busy one by more than affinitySlack; else to the
+ * least busy worker. Busy is the worker's queue depth (IPC requests and
+ * tiles waiting, from its last scrape) plus its sessions, which count
+ * from the moment they are routed rather than from the next scrape.
+ *
+ * Draining a worker stops new sessions going to it; it is stopped once
+ * its sessions end, or once drainTimeout has passed. Thread-safe.
+ */
+class WorkerPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class State {
+        Starting,     // Not scraped yet
+        Ready,        // Takes sessions
+        Unreachable,  // Last scrape failed; takes none until one succeeds
+        Draining,     // Takes none; stopped when its sessions end
+        Stopped
+    };
+
+    struct Worker {
+        std::string id;
+        std::string mcpUrl;   // e.g. http://127.0.0.1:9200
+        std::string httpUrl;  // pathview-mcp's HTTP server, for /metrics
+        State state = State::Starting;
+        size_t sessions = 0;
+        double queueDepth = 0.0;  // From the last successful scrape
+        std::vector<std::string> hotSlides;  // Most recently routed first
+        Clock::time_point drainStarted;
+    };
+
+    struct Route {
+        std::string session;
+        std::string worker;
+        std::string mcpUrl;
+        std::string httpUrl;
+        bool affinity = false;  // The worker had the slide already
+    };
+
+    explicit WorkerPool(double affinitySlack = DEFAULT_AFFINITY_SLACK)
+        : affinitySlack_(affinitySlack) {}
+
+    /**
+     * Add a worker, Starting until SetLoad() is first called for it
+     * @return Its id ("w1", "w2", ...)
+     */
+    std::string Add(const std::string& mcpUrl, const std::string& httpUrl);
+
+    /**
+     * Record a successful scrape: the worker becomes Ready unless draining
+     * @return False if there is no such worker
+     */
+    bool SetLoad(const std::string& workerId, double queueDepth);
+
+    /**
+     * Record a failed scrape: a Ready worker takes no sessions until the
+     * next successful one
+     */
+    void SetUnreachable(const std::string& workerId);
+
+    /**
+     * Pick a worker for a new session on the slide slideKey (its
+     * fingerprint, or its path or URL when it has none)
+     * @return False if no worker is Ready
+     */
+    bool RouteSession(const std::string& slideKey, Route& out);
+
+    /**
+     * End a session routed earlier
+     * @return False if there is no such session
+     */
+    bool EndSession(const std::string& sessionId);
+
+    /**
+     * Stop routing sessions to a worker
+     * @return False if there is no such worker or it is already stopped
+     */
+    bool Drain(const std::string& workerId, Clock::time_point now = Clock::now());
+    void DrainAll(Clock::time_point now = Clock::now());
+
+    /**
+     * Mark Stopped and return the draining workers with no sessions left,
+     * or that drained longer than drainTimeout; their sessions are ended
+     */
+    std::vector<Worker> TakeDrained(Clock::time_point now, std::chrono::seconds drainTimeout);
+
+    std::vector<Worker> GetWorkers() const;
+    size_t GetSessionCount() const;
+    // Every worker is Stopped (or none was added)
+    bool AllStopped() const;
+
+    /**
+     * Sum of the samples of a metric (any labels) in Prometheus text
+     * @param found Set to whether the text has a sample of it
+     */
+    static double SumMetric(const std::string& text, const std::string& name, bool& found);
+
+    static const char* StateName(State state);
+
+    // Slides remembered per worker as warm
+    static constexpr size_t MAX_HOT_SLIDES = 4;
+    static constexpr double DEFAULT_AFFINITY_SLACK = 8.0;
+
+private:
+    double Load(const Worker& worker) const { return worker.queueDepth + static_cast<double>(worker.sessions); }
+    Worker* Find(const std::string& workerId);
+
+    const double affinitySlack_;
+    mutable std::mutex mutex_;
+    std::vector<Worker> workers_;
+    std::map<std::string, std::string> sessions_;  // Session id -> worker id
+    uint64_t nextWorker_ = 1;
+    uint64_t nextSession_ = 1;
+};
+
+} // namespace pool
+} // namespace pathview
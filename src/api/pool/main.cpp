@@ -0,0 +1,462 @@
+/**
+ * PathView pool coordinator (pathview-pool)
+ *
+ * Spreads agent sessions over many headless pathview instances, on this
+ * machine and others, where one viewer and its IPC server would not keep
+ * up.
+ *
+ * Architecture:
+ * - Launches local workers: a headless pathview and a pathview-mcp talking
+ *   to it over its own Unix socket, on consecutive ports from --base-port
+ * - Tracks workers started elsewhere (--worker HOST:MCP_PORT:HTTP_PORT)
+ * - Scrapes each worker's /metrics every second for its queue depth
+ * - Routes sessions (POST /sessions) by slide, see WorkerPool; agents then
+ *   connect to the returned MCP endpoint themselves, so tool calls and
+ *   snapshots never pass through the coordinator
+ * - Drains workers (POST /workers/ID/drain, and every worker on SIGTERM):
+ *   no new sessions, stopped once their sessions end
+ */
+
+#include "WorkerPool.h"
+#include "SlideFingerprint.h"
+#include "../http/Metrics.h"
+#include "httplib.h"  // From cpp-mcp/common/httplib.h
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+using pathview::pool::WorkerPool;
+
+namespace {
+
+std::atomic<bool> g_running(true);
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        g_running = false;
+    }
+}
+
+constexpr auto SCRAPE_INTERVAL = std::chrono::seconds(1);
+constexpr int SCRAPE_TIMEOUT_SECONDS = 2;
+// Tiles waiting count as one queued request per this many: a snapshot
+// waits on about a view's worth of tiles
+constexpr double TILES_PER_QUEUED_REQUEST = 64.0;
+// How long a launched viewer gets to open its IPC socket
+constexpr auto VIEWER_START_TIMEOUT = std::chrono::seconds(30);
+// How long a stopped process gets to exit before it is killed
+constexpr auto PROCESS_EXIT_TIMEOUT = std::chrono::seconds(10);
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 9100;
+    int localWorkers = 0;
+    int basePort = 9200;
+    std::string pathviewPath;
+    std::string mcpPath;
+    std::vector<std::string> viewerArgs;
+    std::vector<std::string> remoteWorkers;
+    int drainTimeoutSeconds = 300;
+    double affinitySlack = WorkerPool::DEFAULT_AFFINITY_SLACK;
+};
+
+void print_usage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --host HOST          Address to listen on, and local workers' address in\n"
+              << "                       routes (default: 127.0.0.1)\n"
+              << "  --port PORT          Coordinator HTTP port (default: 9100)\n"
+              << "  --workers N          Headless pathview instances to launch here (default: 0)\n"
+              << "  --base-port PORT     Local worker i serves MCP on PORT + 2i and HTTP on\n"
+              << "                       PORT + 2i + 1 (default: 9200)\n"
+              << "  --pathview PATH      Viewer to launch (default: pathview next to this binary)\n"
+              << "  --pathview-mcp PATH  MCP server to launch (default: likewise)\n"
+              << "  --viewer-arg ARG     Passed on to every launched viewer (repeatable), e.g.\n"
+              << "                       --viewer-arg --tile-cache-mb --viewer-arg 4096\n"
+              << "  --worker HOST:MCP_PORT:HTTP_PORT\n"
+              << "                       A pathview-mcp started elsewhere (repeatable)\n"
+              << "  --drain-timeout S    Stop a draining worker after S seconds even if sessions\n"
+              << "                       remain (default: 300)\n"
+              << "  --affinity-slack N   Queue depth a worker with the slide warm may exceed the\n"
+              << "                       least busy one by and still get its sessions (default: 8)\n"
+              << "  --help               Show this help message\n"
+              << "\nEndpoints:\n"
+              << "  POST   /sessions          {\"slide\": PATH} -> the worker's MCP endpoint\n"
+              << "  DELETE /sessions/ID       End a session\n"
+              << "  GET    /workers           Worker states, sessions and queue depths\n"
+              << "  POST   /workers/ID/drain  Stop routing to a worker, stop it once idle\n"
+              << "  GET    /metrics           Prometheus metrics\n"
+              << std::endl;
+}
+
+#ifndef _WIN32
+// A launched worker's processes (-1: not running)
+struct LocalProcesses {
+    pid_t viewer = -1;
+    pid_t mcp = -1;
+    std::string socketPath;
+};
+
+pid_t Spawn(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        execv(argv[0], argv.data());
+        std::cerr << "Failed to start " << args[0] << std::endl;
+        _exit(127);
+    }
+    return pid;
+}
+
+// SIGTERM, and SIGKILL if it has not exited after PROCESS_EXIT_TIMEOUT
+void Terminate(pid_t& pid) {
+    if (pid <= 0) {
+        return;
+    }
+    kill(pid, SIGTERM);
+    auto deadline = std::chrono::steady_clock::now() + PROCESS_EXIT_TIMEOUT;
+    while (waitpid(pid, nullptr, WNOHANG) == 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    pid = -1;
+}
+
+// Forget processes that exited on their own (their worker goes
+// unreachable at the next scrape)
+void ReapExited(std::map<std::string, LocalProcesses>& local) {
+    for (auto& [id, processes] : local) {
+        for (pid_t* pid : {&processes.viewer, &processes.mcp}) {
+            if (*pid > 0 && waitpid(*pid, nullptr, WNOHANG) == *pid) {
+                std::cerr << "Worker " << id << ": process " << *pid << " exited" << std::endl;
+                *pid = -1;
+            }
+        }
+    }
+}
+#endif
+
+bool ParseRemoteWorker(const std::string& spec, std::string& mcpUrl, std::string& httpUrl) {
+    size_t second = spec.rfind(':');
+    size_t first = second == std::string::npos || second == 0 ? std::string::npos : spec.rfind(':', second - 1);
+    if (first == std::string::npos || first == 0) {
+        return false;
+    }
+    std::string host = spec.substr(0, first);
+    std::string mcpPort = spec.substr(first + 1, second - first - 1);
+    std::string httpPort = spec.substr(second + 1);
+    if (std::atoi(mcpPort.c_str()) <= 0 || std::atoi(httpPort.c_str()) <= 0) {
+        return false;
+    }
+    mcpUrl = "http://" + host + ":" + mcpPort;
+    httpUrl = "http://" + host + ":" + httpPort;
+    return true;
+}
+
+// Queue depth of a worker from its /metrics, or false if it did not answer
+// or its viewer's metrics have not been forwarded yet
+bool Scrape(const std::string& httpUrl, double& queueDepth) {
+    httplib::Client client(httpUrl);
+    client.set_connection_timeout(SCRAPE_TIMEOUT_SECONDS, 0);
+    client.set_read_timeout(SCRAPE_TIMEOUT_SECONDS, 0);
+    httplib::Result res = client.Get("/metrics");
+    if (!res || res->status != 200) {
+        return false;
+    }
+    bool hasRequests = false;
+    bool hasTiles = false;
+    double requests = WorkerPool::SumMetric(res->body, "pathview_ipc_queued_requests", hasRequests);
+    double tiles = WorkerPool::SumMetric(res->body, "pathview_tile_queue_depth", hasTiles);
+    if (!hasRequests && !hasTiles) {
+        return false;
+    }
+    queueDepth = requests + tiles / TILES_PER_QUEUED_REQUEST;
+    return true;
+}
+
+json WorkerJson(const WorkerPool::Worker& worker) {
+    return {
+        {"id", worker.id},
+        {"state", WorkerPool::StateName(worker.state)},
+        {"mcp_url", worker.mcpUrl},
+        {"http_url", worker.httpUrl},
+        {"sessions", worker.sessions},
+        {"queue_depth", worker.queueDepth},
+        {"hot_slides", worker.hotSlides}
+    };
+}
+
+void UpdateMetrics(pathview::http::Metrics& metrics, const WorkerPool& pool) {
+    std::map<std::string, double> counts;
+    for (WorkerPool::State state : {WorkerPool::State::Starting, WorkerPool::State::Ready,
+                                    WorkerPool::State::Unreachable, WorkerPool::State::Draining,
+                                    WorkerPool::State::Stopped}) {
+        counts[WorkerPool::StateName(state)] = 0.0;
+    }
+    for (const WorkerPool::Worker& worker : pool.GetWorkers()) {
+        counts[WorkerPool::StateName(worker.state)] += 1.0;
+        metrics.Gauge("pathview_pool_worker_queue_depth", "Queue depth of each worker at its last scrape",
+                      "worker", worker.id).Set(worker.queueDepth);
+        metrics.Gauge("pathview_pool_worker_sessions", "Sessions routed to each worker and not ended",
+                      "worker", worker.id).Set(static_cast<double>(worker.sessions));
+    }
+    for (const auto& [state, count] : counts) {
+        metrics.Gauge("pathview_pool_workers", "Workers by state", "state", state).Set(count);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--host" && i + 1 < argc) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.localWorkers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--base-port" && i + 1 < argc) {
+            options.basePort = std::atoi(argv[++i]);
+        } else if (arg == "--pathview" && i + 1 < argc) {
+            options.pathviewPath = argv[++i];
+        } else if (arg == "--pathview-mcp" && i + 1 < argc) {
+            options.mcpPath = argv[++i];
+        } else if (arg == "--viewer-arg" && i + 1 < argc) {
+            options.viewerArgs.push_back(argv[++i]);
+        } else if (arg == "--worker" && i + 1 < argc) {
+            options.remoteWorkers.push_back(argv[++i]);
+        } else if (arg == "--drain-timeout" && i + 1 < argc) {
+            options.drainTimeoutSeconds = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--affinity-slack" && i + 1 < argc) {
+            options.affinitySlack = std::max(0.0, std::atof(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    WorkerPool pool(options.affinitySlack);
+    pathview::http::Metrics metrics;
+
+    for (const std::string& spec : options.remoteWorkers) {
+        std::string mcpUrl;
+        std::string httpUrl;
+        if (!ParseRemoteWorker(spec, mcpUrl, httpUrl)) {
+            std::cerr << "Invalid --worker " << spec << " (expected HOST:MCP_PORT:HTTP_PORT)" << std::endl;
+            return 1;
+        }
+        std::cout << "Worker " << pool.Add(mcpUrl, httpUrl) << ": " << mcpUrl << std::endl;
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+#ifdef _WIN32
+    if (options.localWorkers > 0) {
+        std::cerr << "--workers is not supported on Windows; start workers yourself and pass --worker" << std::endl;
+        return 1;
+    }
+#else
+    // Launch the viewers first, then each one's MCP server once its socket
+    // is there to connect to
+    std::map<std::string, LocalProcesses> local;
+    std::filesystem::path binDir = std::filesystem::absolute(argv[0]).parent_path();
+    std::string pathviewPath = options.pathviewPath.empty() ? (binDir / "pathview").string() : options.pathviewPath;
+    std::string mcpPath = options.mcpPath.empty() ? (binDir / "pathview-mcp").string() : options.mcpPath;
+    std::vector<std::pair<int, LocalProcesses>> launched;
+    for (int i = 0; i < options.localWorkers; ++i) {
+        LocalProcesses processes;
+        processes.socketPath = (std::filesystem::temp_directory_path() /
+                                ("pathview-pool-" + std::to_string(getpid()) + "-" + std::to_string(i) + ".sock"))
+                                   .string();
+        std::vector<std::string> args = {pathviewPath, "--headless", "--ipc-socket", processes.socketPath};
+        args.insert(args.end(), options.viewerArgs.begin(), options.viewerArgs.end());
+        processes.viewer = Spawn(args);
+        launched.emplace_back(i, processes);
+    }
+    for (auto& [i, processes] : launched) {
+        auto deadline = std::chrono::steady_clock::now() + VIEWER_START_TIMEOUT;
+        while (!std::filesystem::exists(processes.socketPath) && std::chrono::steady_clock::now() < deadline &&
+               waitpid(processes.viewer, nullptr, WNOHANG) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        int mcpPort = options.basePort + 2 * i;
+        int httpPort = mcpPort + 1;
+        processes.mcp = Spawn({mcpPath, "--ipc-socket", processes.socketPath, "--host", options.host,
+                               "--mcp-port", std::to_string(mcpPort), "--http-port", std::to_string(httpPort)});
+        std::string id = pool.Add("http://" + options.host + ":" + std::to_string(mcpPort),
+                                  "http://" + options.host + ":" + std::to_string(httpPort));
+        std::cout << "Worker " << id << ": pid " << processes.viewer << ", MCP port " << mcpPort << std::endl;
+        local[id] = processes;
+    }
+#endif
+
+    if (pool.GetWorkers().empty()) {
+        std::cerr << "No workers: pass --workers N and/or --worker HOST:MCP_PORT:HTTP_PORT" << std::endl;
+        return 1;
+    }
+
+    httplib::Server server;
+
+    server.Post("/sessions", [&pool, &metrics](const httplib::Request& req, httplib::Response& res) {
+        json body = json::parse(req.body, nullptr, false);
+        std::string slide = body.is_object() ? body.value("slide", std::string()) : std::string();
+        std::string slideKey = body.is_object() ? body.value("fingerprint", std::string()) : std::string();
+        if (slide.empty() && slideKey.empty()) {
+            res.status = 400;
+            res.set_content(json{{"error", "slide or fingerprint required"}}.dump(), "application/json");
+            return;
+        }
+        // The same file under another path is still warm; remote slides
+        // have no fingerprint and go by their URL
+        if (slideKey.empty()) {
+            slideKey = SlideFingerprint::Compute(slide);
+        }
+        if (slideKey.empty()) {
+            slideKey = slide;
+        }
+
+        WorkerPool::Route route;
+        if (!pool.RouteSession(slideKey, route)) {
+            res.status = 503;
+            res.set_content(json{{"error", "no worker ready"}}.dump(), "application/json");
+            return;
+        }
+        metrics.Counter("pathview_pool_sessions_total", "Sessions routed", "affinity",
+                        route.affinity ? "warm" : "cold").Add(1.0);
+        res.set_content(json{
+            {"session", route.session},
+            {"worker", route.worker},
+            {"mcp_url", route.mcpUrl},
+            {"sse_url", route.mcpUrl + "/sse"},
+            {"http_url", route.httpUrl},
+            {"slide_key", slideKey},
+            {"affinity", route.affinity}
+        }.dump(), "application/json");
+    });
+
+    server.Delete(R"(/sessions/([A-Za-z0-9]+))", [&pool](const httplib::Request& req, httplib::Response& res) {
+        if (!pool.EndSession(req.matches[1])) {
+            res.status = 404;
+            res.set_content(json{{"error", "no such session"}}.dump(), "application/json");
+            return;
+        }
+        res.set_content(json{{"ended", true}}.dump(), "application/json");
+    });
+
+    server.Get("/workers", [&pool](const httplib::Request&, httplib::Response& res) {
+        json workers = json::array();
+        for (const WorkerPool::Worker& worker : pool.GetWorkers()) {
+            workers.push_back(WorkerJson(worker));
+        }
+        res.set_content(json{{"workers", workers}, {"sessions", pool.GetSessionCount()}}.dump(), "application/json");
+    });
+
+    server.Post(R"(/workers/([A-Za-z0-9]+)/drain)", [&pool](const httplib::Request& req, httplib::Response& res) {
+        if (!pool.Drain(req.matches[1])) {
+            res.status = 404;
+            res.set_content(json{{"error", "no such worker, or already stopped"}}.dump(), "application/json");
+            return;
+        }
+        res.set_content(json{{"draining", true}}.dump(), "application/json");
+    });
+
+    server.Get("/metrics", [&metrics](const httplib::Request&, httplib::Response& res) {
+        res.set_content(metrics.Render(), pathview::http::Metrics::CONTENT_TYPE);
+    });
+
+    server.Get("/health", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content(json{{"status", "ok"}}.dump(), "application/json");
+    });
+
+    std::thread serverThread([&server, &options]() {
+        if (!server.listen(options.host.c_str(), options.port)) {
+            std::cerr << "Failed to listen on " << options.host << ":" << options.port << std::endl;
+            g_running = false;
+        }
+    });
+    std::cout << "PathView pool coordinator on http://" << options.host << ":" << options.port << std::endl;
+
+    // Scrape, stop drained workers; on SIGTERM drain them all and exit once
+    // every one has stopped
+    bool shuttingDown = false;
+    while (true) {
+        if (!g_running && !shuttingDown) {
+            std::cout << "\nDraining every worker..." << std::endl;
+            pool.DrainAll();
+            shuttingDown = true;
+        }
+
+        for (const WorkerPool::Worker& worker : pool.GetWorkers()) {
+            if (worker.state == WorkerPool::State::Stopped) {
+                continue;
+            }
+            double queueDepth = 0.0;
+            if (Scrape(worker.httpUrl, queueDepth)) {
+                pool.SetLoad(worker.id, queueDepth);
+            } else {
+                pool.SetUnreachable(worker.id);
+            }
+        }
+
+        for (const WorkerPool::Worker& worker :
+             pool.TakeDrained(WorkerPool::Clock::now(), std::chrono::seconds(options.drainTimeoutSeconds))) {
+            std::cout << "Worker " << worker.id << " drained" << std::endl;
+#ifndef _WIN32
+            auto it = local.find(worker.id);
+            if (it != local.end()) {
+                Terminate(it->second.mcp);
+                Terminate(it->second.viewer);
+            }
+#endif
+        }
+#ifndef _WIN32
+        ReapExited(local);
+#endif
+        UpdateMetrics(metrics, pool);
+
+        if (shuttingDown && pool.AllStopped()) {
+            break;
+        }
+        std::this_thread::sleep_for(SCRAPE_INTERVAL);
+    }
+
+    server.stop();
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+    std::cout << "PathView pool coordinator stopped" << std::endl;
+    return 0;
+}
@@ -1,13 +1,22 @@
 #include "ActionCard.h"
 #include <stdexcept>
+#include <utility>
 
 namespace pathview {
 
 void ActionCard::AppendLog(const std::string& message, const std::string& level) {
-    logEntries.emplace_back(message, level);
+    AppendLogEntry(ActionCardLogEntry(message, level));
     updatedAt = std::chrono::system_clock::now();
 }
 
+void ActionCard::AppendLogEntry(ActionCardLogEntry entry) {
+    logEntries.push_back(std::move(entry));
+    if (logEntries.size() > MAX_LOG_ENTRIES) {
+        logEntries.pop_front();
+        ++droppedLogEntries;
+    }
+}
+
 void ActionCard::UpdateStatus(ActionCardStatus newStatus) {
     status = newStatus;
     updatedAt = std::chrono::system_clock::now();
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <string>
-#include <vector>
+#include <deque>
 #include <chrono>
 
 namespace pathview {
@@ -43,9 +43,14 @@ struct ActionCard {
     std::string reasoning;                             // Optional detailed reasoning (collapsible)
     std::chrono::system_clock::time_point createdAt;   // Creation timestamp
     std::chrono::system_clock::time_point updatedAt;   // Last update timestamp
-    std::vector<ActionCardLogEntry> logEntries;        // Ordered log of events
+    std::deque<ActionCardLogEntry> logEntries;         // Newest MAX_LOG_ENTRIES events, oldest first
+    size_t droppedLogEntries = 0;                      // Older events discarded to stay within it
     std::string ownerUUID;                             // UUID of agent/lock owner who created this
 
+    // Log entries kept per card: a chatty agent costs bounded memory,
+    // journal writes and sidebar work
+    static constexpr size_t MAX_LOG_ENTRIES = 1000;
+
     ActionCard(const std::string& id_, const std::string& title_)
         : id(id_)
         , title(title_)
@@ -53,9 +58,17 @@ struct ActionCard {
         , createdAt(std::chrono::system_clock::now())
         , updatedAt(std::chrono::system_clock::now()) {}
 
-    // Append a log entry and update timestamp
+    // Append a log entry and update timestamp; beyond MAX_LOG_ENTRIES
+    // the oldest entry is dropped
     void AppendLog(const std::string& message, const std::string& level = "info");
 
+    // Append an entry as is (timestamp included), e.g. replayed from the
+    // journal, with the same bound
+    void AppendLogEntry(ActionCardLogEntry entry);
+
+    // Entries ever appended; entry i of them is logEntries[i - droppedLogEntries]
+    size_t GetLogEntryCount() const { return droppedLogEntries + logEntries.size(); }
+
     // Update status and timestamp
     void UpdateStatus(ActionCardStatus newStatus);
 
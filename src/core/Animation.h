@@ -43,6 +43,10 @@ public:
     // Cancel current animation
     void Cancel();
 
+    // Destination of the current (or last) animation
+    Vec2 GetTargetPosition() const { return targetPosition_; }
+    double GetTargetZoom() const { return targetZoom_; }
+
 private:
     bool active_;
     AnimationMode mode_;
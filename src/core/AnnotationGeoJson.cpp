@@ -0,0 +1,113 @@
+#include "AnnotationGeoJson.h"
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Vertices of a ring, without the closing repeat of the first
+std::vector<Vec2> ParseRing(const json& ring) {
+    if (!ring.is_array()) {
+        throw std::runtime_error("GeoJSON ring must be an array of positions");
+    }
+    std::vector<Vec2> vertices;
+    vertices.reserve(ring.size());
+    for (const json& position : ring) {
+        if (!position.is_array() || position.size() < 2 || !position[0].is_number() || !position[1].is_number()) {
+            throw std::runtime_error("GeoJSON position must be an array of [x, y]");
+        }
+        vertices.push_back(Vec2(position[0].get<double>(), position[1].get<double>()));
+    }
+    if (vertices.size() > 1 && vertices.front().x == vertices.back().x &&
+        vertices.front().y == vertices.back().y) {
+        vertices.pop_back();
+    }
+    return vertices;
+}
+
+// Outer ring of a Polygon's coordinates
+void AddPolygon(const json& coordinates, const std::string& name, std::vector<StoredAnnotation>& out) {
+    if (!coordinates.is_array() || coordinates.empty()) {
+        throw std::runtime_error("GeoJSON Polygon must have at least one ring");
+    }
+    StoredAnnotation annotation;
+    annotation.name = name;
+    annotation.vertices = ParseRing(coordinates[0]);
+    out.push_back(std::move(annotation));
+}
+
+void AddGeometry(const json& geometry, const std::string& name, std::vector<StoredAnnotation>& out) {
+    if (!geometry.is_object()) {
+        return;  // A feature without geometry
+    }
+    const std::string type = geometry.value("type", "");
+    if (type == "Polygon") {
+        AddPolygon(geometry.at("coordinates"), name, out);
+    } else if (type == "MultiPolygon") {
+        for (const json& polygon : geometry.at("coordinates")) {
+            AddPolygon(polygon, name, out);
+        }
+    } else if (type == "GeometryCollection") {
+        for (const json& part : geometry.at("geometries")) {
+            AddGeometry(part, name, out);
+        }
+    }
+}
+
+void AddFeature(const json& feature, std::vector<StoredAnnotation>& out) {
+    std::string name;
+    auto properties = feature.find("properties");
+    if (properties != feature.end() && properties->is_object()) {
+        auto nameIt = properties->find("name");
+        if (nameIt != properties->end() && nameIt->is_string()) {
+            name = nameIt->get<std::string>();
+        }
+    }
+    auto geometry = feature.find("geometry");
+    if (geometry != feature.end()) {
+        AddGeometry(*geometry, name, out);
+    }
+}
+
+}  // namespace
+
+json AnnotationGeoJson::Export(const std::vector<StoredAnnotation>& annotations) {
+    json features = json::array();
+    for (const StoredAnnotation& annotation : annotations) {
+        json ring = json::array();
+        for (const Vec2& vertex : annotation.vertices) {
+            ring.push_back({vertex.x, vertex.y});
+        }
+        if (!annotation.vertices.empty()) {
+            ring.push_back({annotation.vertices.front().x, annotation.vertices.front().y});
+        }
+        features.push_back({
+            {"type", "Feature"},
+            {"geometry", {{"type", "Polygon"}, {"coordinates", json::array({std::move(ring)})}}},
+            {"properties", {{"id", annotation.id}, {"name", annotation.name}}}
+        });
+    }
+    return json{{"type", "FeatureCollection"}, {"features", std::move(features)}};
+}
+
+std::vector<StoredAnnotation> AnnotationGeoJson::Import(const json& geojson) {
+    if (!geojson.is_object()) {
+        throw std::runtime_error("GeoJSON must be an object");
+    }
+    std::vector<StoredAnnotation> annotations;
+    try {
+        const std::string type = geojson.value("type", "");
+        if (type == "FeatureCollection") {
+            for (const json& feature : geojson.at("features")) {
+                AddFeature(feature, annotations);
+            }
+        } else if (type == "Feature") {
+            AddFeature(geojson, annotations);
+        } else {
+            AddGeometry(geojson, "", annotations);
+        }
+    } catch (const json::exception& e) {
+        throw std::runtime_error(std::string("Malformed GeoJSON: ") + e.what());
+    }
+    return annotations;
+}
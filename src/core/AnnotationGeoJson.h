@@ -0,0 +1,24 @@
+#pragma once
+
+#include "AnnotationJournal.h"  // For StoredAnnotation
+#include "json.hpp"
+#include <vector>
+
+// GeoJSON form of annotations, for exchange with other tools (QuPath,
+// GIS libraries); the journal is the store, this is import and export.
+//
+// An annotation is a Feature with a Polygon geometry (one ring in level 0
+// slide pixels, closed by repeating its first vertex) and properties "id"
+// and "name".
+class AnnotationGeoJson {
+public:
+    // FeatureCollection of the annotations, in the order given
+    static nlohmann::json Export(const std::vector<StoredAnnotation>& annotations);
+
+    // Annotations of a FeatureCollection, Feature or bare geometry: the
+    // outer ring of each Polygon and of each part of a MultiPolygon, named
+    // by the feature's "name" property (ids are left 0 for the caller to
+    // assign). Features of other geometry types are skipped; malformed
+    // input throws std::runtime_error.
+    static std::vector<StoredAnnotation> Import(const nlohmann::json& geojson);
+};
@@ -0,0 +1,120 @@
+#include "AnnotationIndex.h"
+#include <algorithm>
+#include <cmath>
+
+int AnnotationIndex::LevelFor(const Rect& box) {
+    const double size = std::max(box.width, box.height);
+    double cellSize = BASE_CELL_SIZE;
+    for (int level = 0; level < LEVEL_COUNT; ++level, cellSize *= 2.0) {
+        if (size <= cellSize) {
+            return level;
+        }
+    }
+    return LEVEL_COUNT;
+}
+
+double AnnotationIndex::CellSize(int level) {
+    return std::ldexp(BASE_CELL_SIZE, level);
+}
+
+uint64_t AnnotationIndex::CellKey(int64_t column, int64_t row) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(column)) << 32) |
+           static_cast<uint32_t>(row);
+}
+
+int64_t AnnotationIndex::CellOf(double coordinate, double cellSize) {
+    return static_cast<int64_t>(std::floor(coordinate / cellSize));
+}
+
+void AnnotationIndex::Insert(int id, const Rect& box) {
+    const int level = LevelFor(box);
+    if (level == LEVEL_COUNT) {
+        oversized_.push_back({id, box});
+    } else {
+        const double cellSize = CellSize(level);
+        levels_[level][CellKey(CellOf(box.x, cellSize), CellOf(box.y, cellSize))].push_back({id, box});
+    }
+    ++size_;
+}
+
+bool AnnotationIndex::Remove(int id, const Rect& box) {
+    const int level = LevelFor(box);
+    if (level == LEVEL_COUNT) {
+        if (!Erase(oversized_, id)) {
+            return false;
+        }
+    } else {
+        const double cellSize = CellSize(level);
+        Cells& cells = levels_[level];
+        auto it = cells.find(CellKey(CellOf(box.x, cellSize), CellOf(box.y, cellSize)));
+        if (it == cells.end() || !Erase(it->second, id)) {
+            return false;
+        }
+        if (it->second.empty()) {
+            cells.erase(it);
+        }
+    }
+    --size_;
+    return true;
+}
+
+bool AnnotationIndex::Erase(std::vector<Entry>& entries, int id) {
+    auto it = std::find_if(entries.begin(), entries.end(), [id](const Entry& entry) { return entry.id == id; });
+    if (it == entries.end()) {
+        return false;
+    }
+    *it = entries.back();
+    entries.pop_back();
+    return true;
+}
+
+void AnnotationIndex::Collect(const std::vector<Entry>& entries, const Rect& region, std::vector<int>& outIds) {
+    for (const Entry& entry : entries) {
+        if (entry.box.Intersects(region)) {
+            outIds.push_back(entry.id);
+        }
+    }
+}
+
+void AnnotationIndex::Query(const Rect& region, std::vector<int>& outIds) const {
+    outIds.clear();
+    for (int level = 0; level < LEVEL_COUNT; ++level) {
+        const Cells& cells = levels_[level];
+        if (cells.empty()) {
+            continue;
+        }
+
+        // A box reaches at most one cell right of and below its own
+        const double cellSize = CellSize(level);
+        const int64_t firstColumn = CellOf(region.x, cellSize) - 1;
+        const int64_t lastColumn = CellOf(region.Right(), cellSize);
+        const int64_t firstRow = CellOf(region.y, cellSize) - 1;
+        const int64_t lastRow = CellOf(region.Bottom(), cellSize);
+        const double covered = static_cast<double>(lastColumn - firstColumn + 1) *
+                               static_cast<double>(lastRow - firstRow + 1);
+
+        if (covered > static_cast<double>(cells.size())) {
+            for (const auto& [key, entries] : cells) {
+                Collect(entries, region, outIds);
+            }
+            continue;
+        }
+        for (int64_t row = firstRow; row <= lastRow; ++row) {
+            for (int64_t column = firstColumn; column <= lastColumn; ++column) {
+                auto it = cells.find(CellKey(column, row));
+                if (it != cells.end()) {
+                    Collect(it->second, region, outIds);
+                }
+            }
+        }
+    }
+    Collect(oversized_, region, outIds);
+}
+
+void AnnotationIndex::Clear() {
+    for (Cells& cells : levels_) {
+        cells.clear();
+    }
+    oversized_.clear();
+    size_ = 0;
+}
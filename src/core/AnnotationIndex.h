@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Viewport.h"  // For Rect
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Spatial index over annotation bounding boxes that takes inserts and
+// removals one at a time, for the annotations users draw and agents
+// create and delete by the thousand.
+//
+// A hierarchy of uniform grids: level L has square cells of
+// BASE_CELL_SIZE * 2^L slide pixels, and each box goes into the one cell
+// of the finest level whose cells are at least as large as the box,
+// the cell holding its top-left corner. A box thus overlaps at most that
+// cell's right and lower neighbours, so a query visits on each level the
+// cells it overlaps plus one more column and row. Boxes larger than the
+// coarsest cells are kept in a list every query tests. Where a query
+// covers more cells of a level than the level has cells in use (zoomed
+// far out over fine levels) the level's cells are walked instead.
+class AnnotationIndex {
+public:
+    // Add an annotation's box
+    void Insert(int id, const Rect& box);
+
+    // Remove an annotation; box must be the one it was inserted with.
+    // Returns false if it is not in the index.
+    bool Remove(int id, const Rect& box);
+
+    /**
+     * Annotations whose box intersects a region
+     * @param region Region in slide coordinates
+     * @param outIds Cleared, then filled with the ids, in no set order;
+     *        reuse it across queries to keep its capacity
+     */
+    void Query(const Rect& region, std::vector<int>& outIds) const;
+
+    void Clear();
+    size_t Size() const { return size_; }
+
+    static constexpr double BASE_CELL_SIZE = 256.0;
+    static constexpr int LEVEL_COUNT = 12;  // Coarsest cells 512K pixels wide
+
+private:
+    struct Entry {
+        int id;
+        Rect box;
+    };
+
+    using Cells = std::unordered_map<uint64_t, std::vector<Entry>>;
+
+    // Level for a box, or LEVEL_COUNT if it goes in oversized_
+    static int LevelFor(const Rect& box);
+    static double CellSize(int level);
+    static uint64_t CellKey(int64_t column, int64_t row);
+    static int64_t CellOf(double coordinate, double cellSize);
+
+    static bool Erase(std::vector<Entry>& entries, int id);
+    static void Collect(const std::vector<Entry>& entries, const Rect& region, std::vector<int>& outIds);
+
+    std::array<Cells, LEVEL_COUNT> levels_;
+    std::vector<Entry> oversized_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,512 @@
+#include "AnnotationJournal.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t HEADER_BYTES = 8;  // Magic, version
+constexpr size_t FRAME_BYTES = 8;   // Payload length, checksum
+constexpr uint32_t MAX_PAYLOAD_BYTES = 256u << 20;
+
+// FNV-1a over the payload's bytes
+uint32_t Checksum(const char* data, size_t size) {
+    uint32_t hash = 0x811C9DC5u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x01000193u;
+    }
+    return hash;
+}
+
+// Little-endian encoding of record fields
+class Encoder {
+public:
+    void U8(uint8_t value) { bytes_.push_back(static_cast<char>(value)); }
+    void U32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            bytes_.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+    void U64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            bytes_.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+    void I32(int32_t value) { U32(static_cast<uint32_t>(value)); }
+    void I64(int64_t value) { U64(static_cast<uint64_t>(value)); }
+    void F64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        U64(bits);
+    }
+    void String(const std::string& value) {
+        U32(static_cast<uint32_t>(value.size()));
+        bytes_.append(value);
+    }
+    void Time(std::chrono::system_clock::time_point time) {
+        I64(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count());
+    }
+
+    std::string& Bytes() { return bytes_; }
+
+private:
+    std::string bytes_;
+};
+
+// Bounds-checked decoding; a read past the end sets failed and yields 0
+class Decoder {
+public:
+    Decoder(const char* data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t U8() { return static_cast<uint8_t>(Take(1) ? data_[position_ - 1] : 0); }
+    uint32_t U32() { return static_cast<uint32_t>(Little(4)); }
+    uint64_t U64() { return Little(8); }
+    int32_t I32() { return static_cast<int32_t>(U32()); }
+    int64_t I64() { return static_cast<int64_t>(U64()); }
+    double F64() {
+        uint64_t bits = U64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string String() {
+        uint32_t length = U32();
+        if (!Take(length)) {
+            return std::string();
+        }
+        return std::string(data_ + position_ - length, length);
+    }
+    std::chrono::system_clock::time_point Time() {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(I64())));
+    }
+
+    // Whether count more items of itemBytes each can be read
+    bool Fits(uint64_t count, size_t itemBytes) const {
+        return !failed_ && count <= (size_ - position_) / itemBytes;
+    }
+    bool Ok() const { return !failed_ && position_ == size_; }
+
+private:
+    bool Take(size_t count) {
+        if (failed_ || count > size_ - position_) {
+            failed_ = true;
+            return false;
+        }
+        position_ += count;
+        return true;
+    }
+    uint64_t Little(int count) {
+        if (!Take(count)) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[position_ - count + i])) << (8 * i);
+        }
+        return value;
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t position_ = 0;
+    bool failed_ = false;
+};
+
+void EncodeCard(Encoder& out, const pathview::ActionCard& card) {
+    out.String(card.id);
+    out.String(card.title);
+    out.U8(static_cast<uint8_t>(card.status));
+    out.String(card.summary);
+    out.String(card.reasoning);
+    out.Time(card.createdAt);
+    out.Time(card.updatedAt);
+    out.String(card.ownerUUID);
+    out.U32(static_cast<uint32_t>(card.logEntries.size()));
+    for (const pathview::ActionCardLogEntry& entry : card.logEntries) {
+        out.Time(entry.timestamp);
+        out.String(entry.message);
+        out.String(entry.level);
+    }
+}
+
+pathview::ActionCard DecodeCard(Decoder& in) {
+    std::string id = in.String();
+    std::string title = in.String();
+    pathview::ActionCard card(id, title);
+    uint8_t status = in.U8();
+    card.status = status <= static_cast<uint8_t>(pathview::ActionCardStatus::CANCELLED)
+                      ? static_cast<pathview::ActionCardStatus>(status)
+                      : pathview::ActionCardStatus::PENDING;
+    card.summary = in.String();
+    card.reasoning = in.String();
+    card.createdAt = in.Time();
+    card.updatedAt = in.Time();
+    card.ownerUUID = in.String();
+    uint32_t entryCount = in.U32();
+    if (!in.Fits(entryCount, 16)) {  // Time and two string lengths at least
+        return card;
+    }
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        auto timestamp = in.Time();
+        std::string message = in.String();
+        pathview::ActionCardLogEntry entry(message, in.String());
+        entry.timestamp = timestamp;
+        card.AppendLogEntry(std::move(entry));
+    }
+    return card;
+}
+
+// Payload of a framed record
+Decoder PayloadOf(const std::string& record) {
+    return Decoder(record.data() + FRAME_BYTES, record.size() - FRAME_BYTES);
+}
+
+}  // namespace
+
+AnnotationJournal::~AnnotationJournal() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+std::string AnnotationJournal::DefaultDirectory() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (base) {
+        return (fs::path(base) / "PathView" / "Annotations").string();
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / "Library" / "Application Support" / "PathView" / "Annotations").string();
+    }
+#else
+    // User work, not a cache: under the data directory
+    const char* xdg = std::getenv("XDG_DATA_HOME");
+    if (xdg && *xdg) {
+        return (fs::path(xdg) / "pathview" / "annotations").string();
+    }
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / ".local" / "share" / "pathview" / "annotations").string();
+    }
+#endif
+    std::error_code ec;
+    return (fs::temp_directory_path(ec) / "pathview-annotations").string();
+}
+
+std::string AnnotationJournal::PathFor(const std::string& directory, const std::string& slideIdentity) {
+    return (fs::path(directory) / (slideIdentity + EXTENSION)).generic_string();
+}
+
+std::string AnnotationJournal::Frame(const std::string& payload) {
+    Encoder frame;
+    frame.U32(static_cast<uint32_t>(payload.size()));
+    frame.U32(Checksum(payload.data(), payload.size()));
+    frame.Bytes().append(payload);
+    return std::move(frame.Bytes());
+}
+
+bool AnnotationJournal::Open(const std::string& path, Contents& contents) {
+    contents = Contents();
+    path_ = path;
+
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+    }
+
+    size_t validBytes = Replay(bytes, contents);
+    if (validBytes == 0) {
+        // New, or not a journal of this version: start it over
+        if (!bytes.empty()) {
+            PATHVIEW_LOG_WARNING("Annotation journal " << path << " is unreadable; starting a new one");
+        }
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_) {
+            Encoder header;
+            header.U32(MAGIC);
+            header.U32(VERSION);
+            std::fwrite(header.Bytes().data(), 1, header.Bytes().size(), file_);
+            std::fflush(file_);
+        }
+    } else {
+        if (validBytes < bytes.size()) {
+            // The last session stopped mid-record
+            PATHVIEW_LOG_WARNING("Annotation journal " << path << ": dropped a torn record of "
+                                 << bytes.size() - validBytes << " bytes");
+            fs::resize_file(path, validBytes, ec);
+        }
+        file_ = std::fopen(path.c_str(), "ab");
+    }
+    if (!file_) {
+        PATHVIEW_LOG_ERROR("Cannot open annotation journal " << path);
+        return false;
+    }
+
+    PATHVIEW_LOG_INFO("Annotation journal " << path << ": " << contents.annotations.size()
+                      << " annotations, " << contents.cards.size() << " action cards");
+    open_ = true;
+    writer_ = std::thread(&AnnotationJournal::Run, this);
+    return true;
+}
+
+size_t AnnotationJournal::Replay(const std::string& bytes, Contents& contents) {
+    Decoder header(bytes.data(), std::min(bytes.size(), HEADER_BYTES));
+    if (bytes.size() < HEADER_BYTES || header.U32() != MAGIC || header.U32() != VERSION) {
+        return 0;
+    }
+
+    size_t position = HEADER_BYTES;
+    while (bytes.size() - position >= FRAME_BYTES) {
+        Decoder frame(bytes.data() + position, FRAME_BYTES);
+        const uint32_t length = frame.U32();
+        const uint32_t checksum = frame.U32();
+        if (length == 0 || length > MAX_PAYLOAD_BYTES || length > bytes.size() - position - FRAME_BYTES ||
+            Checksum(bytes.data() + position + FRAME_BYTES, length) != checksum) {
+            break;
+        }
+        std::string record = bytes.substr(position, FRAME_BYTES + length);
+        position += FRAME_BYTES + length;
+        Track(record);
+    }
+
+    // Decode only the live records
+    for (const auto& [id, record] : liveAnnotations_) {
+        Decoder in = PayloadOf(record);
+        in.U8();
+        StoredAnnotation annotation;
+        annotation.id = in.I32();
+        annotation.name = in.String();
+        uint32_t count = in.U32();
+        if (in.Fits(count, 16)) {
+            annotation.vertices.resize(count);
+            for (Vec2& vertex : annotation.vertices) {
+                vertex.x = in.F64();
+                vertex.y = in.F64();
+            }
+        }
+        if (in.Ok()) {
+            contents.annotations.push_back(std::move(annotation));
+        }
+    }
+    for (const std::string& id : cardOrder_) {
+        Decoder in = PayloadOf(liveCards_.at(id));
+        in.U8();
+        pathview::ActionCard card = DecodeCard(in);
+        if (in.Ok()) {
+            contents.cards.push_back(std::move(card));
+        }
+    }
+    return position;
+}
+
+void AnnotationJournal::Track(const std::string& record) {
+    Decoder in = PayloadOf(record);
+    const uint8_t type = in.U8();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++recordCount_;
+    switch (type) {
+        case ANNOTATION_PUT:
+            liveAnnotations_[in.I32()] = record;
+            break;
+        case ANNOTATION_DELETE:
+            liveAnnotations_.erase(in.I32());
+            break;
+        case CARD_PUT: {
+            std::string id = in.String();
+            auto it = liveCards_.find(id);
+            if (it == liveCards_.end()) {
+                cardOrder_.push_back(id);
+                liveCards_.emplace(std::move(id), record);
+            } else {
+                it->second = record;
+            }
+            break;
+        }
+        case CARD_DELETE: {
+            std::string id = in.String();
+            if (liveCards_.erase(id) > 0) {
+                cardOrder_.erase(std::find(cardOrder_.begin(), cardOrder_.end(), id));
+            }
+            break;
+        }
+        default:
+            break;  // From a later version; ignored
+    }
+}
+
+void AnnotationJournal::PutAnnotation(const StoredAnnotation& annotation) {
+    Encoder out;
+    out.U8(ANNOTATION_PUT);
+    out.I32(annotation.id);
+    out.String(annotation.name);
+    out.U32(static_cast<uint32_t>(annotation.vertices.size()));
+    for (const Vec2& vertex : annotation.vertices) {
+        out.F64(vertex.x);
+        out.F64(vertex.y);
+    }
+    Queue(Frame(out.Bytes()));
+}
+
+void AnnotationJournal::DeleteAnnotation(int id) {
+    Encoder out;
+    out.U8(ANNOTATION_DELETE);
+    out.I32(id);
+    Queue(Frame(out.Bytes()));
+}
+
+void AnnotationJournal::PutCard(const pathview::ActionCard& card) {
+    Encoder out;
+    out.U8(CARD_PUT);
+    EncodeCard(out, card);
+    Queue(Frame(out.Bytes()));
+}
+
+void AnnotationJournal::DeleteCard(const std::string& id) {
+    Encoder out;
+    out.U8(CARD_DELETE);
+    out.String(id);
+    Queue(Frame(out.Bytes()));
+}
+
+void AnnotationJournal::Queue(std::string record) {
+    if (!open_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.append(record);
+        ++queuedCount_;
+    }
+    wake_.notify_one();
+}
+
+void AnnotationJournal::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t target = queuedCount_;
+    written_.wait(lock, [&] { return writtenCount_ >= target || !writer_.joinable(); });
+}
+
+size_t AnnotationJournal::GetRecordCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recordCount_;
+}
+
+size_t AnnotationJournal::GetLiveCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return liveAnnotations_.size() + liveCards_.size();
+}
+
+void AnnotationJournal::Run() {
+    std::string batch;
+    for (;;) {
+        uint64_t batchEnd;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+            if (queued_.empty()) {
+                return;  // Stopping, and everything is written
+            }
+            batch.clear();
+            batch.swap(queued_);
+            batchEnd = queuedCount_;
+        }
+
+        // One write and one flush for however many records queued up
+        if (!file_ || std::fwrite(batch.data(), 1, batch.size(), file_) != batch.size() ||
+            std::fflush(file_) != 0) {
+            PATHVIEW_LOG_EVERY_MS(LogLevel::Error, 5000, "Cannot write annotation journal " << path_);
+        }
+        for (size_t position = 0; position < batch.size();) {
+            Decoder frame(batch.data() + position, FRAME_BYTES);
+            const size_t size = FRAME_BYTES + frame.U32();
+            Track(batch.substr(position, size));
+            position += size;
+        }
+
+        size_t records;
+        size_t live;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            records = recordCount_;
+            live = liveAnnotations_.size() + liveCards_.size();
+        }
+        if (file_ && records >= MIN_COMPACT_RECORDS && records - live > live) {
+            Compact();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writtenCount_ = batchEnd;
+        }
+        written_.notify_all();
+    }
+}
+
+bool AnnotationJournal::Compact() {
+    // The live set changes only on this thread, so it is read unlocked
+    std::string tempPath = path_ + ".tmp";
+    std::FILE* temp = std::fopen(tempPath.c_str(), "wb");
+    if (!temp) {
+        return false;
+    }
+    Encoder out;
+    out.U32(MAGIC);
+    out.U32(VERSION);
+    for (const auto& [id, record] : liveAnnotations_) {
+        out.Bytes().append(record);
+    }
+    for (const std::string& id : cardOrder_) {
+        out.Bytes().append(liveCards_.at(id));
+    }
+    const std::string& bytes = out.Bytes();
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), temp) == bytes.size();
+    if (std::fclose(temp) != 0 || !written) {
+        std::error_code ec;
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    std::error_code ec;
+    std::fclose(file_);
+    fs::rename(tempPath, path_, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+    }
+    file_ = std::fopen(path_.c_str(), "ab");
+    if (!file_) {
+        PATHVIEW_LOG_ERROR("Cannot reopen annotation journal " << path_);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    [[maybe_unused]] const size_t before = recordCount_;
+    if (!ec) {
+        recordCount_ = liveAnnotations_.size() + liveCards_.size();
+    }
+    PATHVIEW_LOG_DEBUG("Compacted annotation journal " << path_ << ": " << before << " -> "
+                       << recordCount_ << " records");
+    return !ec;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ActionCard.h"
+#include "Viewport.h"  // For Vec2
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// An annotation as it is saved: what the user or agent gave it (cell
+// counts and boxes are derived again on load)
+struct StoredAnnotation {
+    int id = 0;
+    std::string name;
+    std::vector<Vec2> vertices;
+};
+
+// Crash-safe store of a slide's annotations and action cards: an
+// append-only binary log, one file per slide.
+//
+// Every change (an annotation or card created or changed, or deleted) is
+// encoded by the thread that makes it into a record and queued; a writer
+// thread of the journal's own appends the queued records to the file and
+// flushes it, so the GUI never waits on the disk and a crash loses at most
+// the records still queued. Records are framed by their length and a
+// checksum, so a torn last record (the crash came mid-write) is detected
+// and cut off on the next open.
+//
+// The writer keeps the latest record of every live annotation and card.
+// Once the log holds more superseded records than live ones (and at least
+// MIN_COMPACT_RECORDS), it writes the live records to a temporary file and
+// renames it over the log, so the file stays near the size of what it
+// holds and replays in one pass.
+class AnnotationJournal {
+public:
+    // What a journal held when opened, in creation order
+    struct Contents {
+        std::vector<StoredAnnotation> annotations;
+        std::vector<pathview::ActionCard> cards;
+    };
+
+    AnnotationJournal() = default;
+    ~AnnotationJournal();  // Writes what is queued, then closes
+
+    AnnotationJournal(const AnnotationJournal&) = delete;
+    AnnotationJournal& operator=(const AnnotationJournal&) = delete;
+
+    // Open (or create) the log at path, replay it into contents and start
+    // the writer. False if the file cannot be opened for writing.
+    bool Open(const std::string& path, Contents& contents);
+
+    // Queue a change; cheap, and safe from any thread
+    void PutAnnotation(const StoredAnnotation& annotation);
+    void DeleteAnnotation(int id);
+    void PutCard(const pathview::ActionCard& card);
+    void DeleteCard(const std::string& id);
+
+    // Wait until every change queued so far is in the file
+    void Flush();
+
+    bool IsOpen() const { return open_; }
+    const std::string& GetPath() const { return path_; }
+
+    // Records in the file (written or replayed), and how many are live
+    size_t GetRecordCount();
+    size_t GetLiveCount();
+
+    // Per-user directory for journals, beside DiskTileCache's root
+    static std::string DefaultDirectory();
+
+    // Journal file for a slide identity (DiskTileCache::SlideIdentity)
+    static std::string PathFor(const std::string& directory, const std::string& slideIdentity);
+
+    static constexpr uint32_t MAGIC = 0x4A415650;  // "PVAJ"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* EXTENSION = ".pvjournal";
+    static constexpr size_t MIN_COMPACT_RECORDS = 1024;
+
+private:
+    enum RecordType : uint8_t {
+        ANNOTATION_PUT = 1,
+        ANNOTATION_DELETE = 2,
+        CARD_PUT = 3,
+        CARD_DELETE = 4
+    };
+
+    // A framed record: length, checksum, payload
+    static std::string Frame(const std::string& payload);
+
+    // Decode the file's records into contents; returns the bytes of whole,
+    // valid records (header included)
+    size_t Replay(const std::string& bytes, Contents& contents);
+
+    void Queue(std::string record);
+    void Run();
+
+    // Writer thread: remember a record's effect on the live set, and
+    // rewrite the file from the live set
+    void Track(const std::string& record);
+    bool Compact();
+
+    std::string path_;
+    bool open_ = false;
+    std::FILE* file_ = nullptr;  // Writer thread's once it runs
+    std::thread writer_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::string queued_;  // Framed records not yet handed to the writer
+    uint64_t queuedCount_ = 0;
+    uint64_t writtenCount_ = 0;
+    bool stopping_ = false;
+
+    // Latest record of each live annotation and card (writer thread, and
+    // Open before it starts); cards keep their creation order
+    std::map<int, std::string> liveAnnotations_;
+    std::unordered_map<std::string, std::string> liveCards_;
+    std::vector<std::string> cardOrder_;
+    size_t recordCount_ = 0;  // Guarded by mutex_ once the writer runs
+};
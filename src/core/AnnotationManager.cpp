@@ -1,11 +1,14 @@
 #include "AnnotationManager.h"
+#include "PolygonMask.h"
 #include "PolygonOverlay.h"
 #include "PolygonTriangulator.h"
 #include "Minimap.h"
 #include "imgui.h"
-#include <iostream>
+#include "Log.h"
+#include <algorithm>
 #include <cstring>
 #include <cmath>
+#include <sstream>
 
 
 void AnnotationPolygon::ComputeBoundingBox() {
@@ -43,6 +46,42 @@ bool AnnotationPolygon::ContainsPoint(const Vec2& point) const {
     return inside;
 }
 
+void AnnotationPolygon::BuildGeometry() {
+    triangles = PolygonTriangulator::Triangulate(vertices);
+    lods.clear();
+
+    const double extent = std::max(boundingBox.width, boundingBox.height);
+    std::vector<uint32_t> kept;
+    size_t previous = vertices.size();
+    for (double tolerance = LOD_FIRST_TOLERANCE; previous > LOD_MIN_VERTICES && tolerance < extent;
+         tolerance *= LOD_STEP) {
+        PolygonTriangulator::Simplify(vertices, tolerance, kept);
+        if (kept.size() < 3 || 4 * kept.size() > 3 * previous) {
+            continue;
+        }
+        AnnotationLod lod;
+        lod.tolerance = tolerance;
+        lod.vertices.reserve(kept.size());
+        for (uint32_t vertex : kept) {
+            lod.vertices.push_back(vertices[vertex]);
+        }
+        lod.triangles = PolygonTriangulator::Triangulate(lod.vertices);
+        previous = kept.size();
+        lods.push_back(std::move(lod));
+    }
+}
+
+const AnnotationLod* AnnotationPolygon::GetLod(double maxError) const {
+    const AnnotationLod* chosen = nullptr;
+    for (const AnnotationLod& lod : lods) {
+        if (lod.tolerance > maxError) {
+            break;
+        }
+        chosen = &lod;
+    }
+    return chosen;
+}
+
 // ========== ANNOTATION MANAGER METHODS ==========
 
 AnnotationManager::AnnotationManager(SDL_Renderer* renderer)
@@ -96,6 +135,14 @@ void AnnotationManager::HandleClick(int x, int y, bool isDoubleClick,
         drawingState_.isActive = true;
     }
     drawingState_.currentVertices.push_back(slidePos);
+
+    // Live counts: only the triangle the new vertex adds is visited
+    if (polygonOverlay && polygonOverlay->GetPolygonCount() > 0) {
+        drawingState_.cellCount.Update(drawingState_.currentVertices, &polygonOverlay->GetPolygons(),
+                                       polygonOverlay->GetSpatialIndex());
+    } else {
+        drawingState_.cellCount.Clear();
+    }
 }
 
 void AnnotationManager::HandleKeyPress(SDL_Keycode key, PolygonOverlay* polygonOverlay) {
@@ -123,17 +170,25 @@ void AnnotationManager::CompletePolygon(PolygonOverlay* polygonOverlay) {
     annotation.vertices = drawingState_.currentVertices;
     annotation.ComputeBoundingBox();
 
-    annotations_.push_back(annotation);
+    // The live counts are those of the finished outline unless the cells
+    // changed while drawing; then count it whole
+    const bool liveCountsCurrent = polygonOverlay &&
+        drawingState_.cellCount.IsCurrent(annotation.vertices.size(), &polygonOverlay->GetPolygons());
+    if (liveCountsCurrent) {
+        annotation.cellCounts = drawingState_.cellCount.GetCounts();
+    }
 
-    std::cout << "Created annotation: " << annotation.name
-              << " with " << annotation.vertices.size() << " vertices" << std::endl;
+    PATHVIEW_LOG_INFO("Created annotation: " << annotation.name
+                      << " with " << annotation.vertices.size() << " vertices");
+    JournalAnnotation(annotation);
+    AddAnnotation(std::move(annotation));
 
     // Clear drawing state but keep tool active
     drawingState_.Clear();
     drawingState_.isActive = false;
 
     // Compute cell counts if polygon overlay is loaded
-    if (polygonOverlay) {
+    if (polygonOverlay && !liveCountsCurrent) {
         ComputeCellCounts(annotations_.back(), polygonOverlay);
     }
 }
@@ -158,33 +213,19 @@ void AnnotationManager::ComputeCellCounts(AnnotationPolygon& annotation,
 
     if (!polygonOverlay) return;
 
-    // Get all cell polygons from the overlay
-    const auto& cellPolygons = polygonOverlay->GetPolygons();
-
-    // For each cell polygon, check if its centroid is inside the annotation
-    for (const auto& cellPolygon : cellPolygons) {
-        if (cellPolygon.vertices.empty()) continue;
+    CountCellsInside(annotation.vertices, *polygonOverlay, annotation.cellCounts);
 
-        // Compute centroid of cell polygon
-        Vec2 centroid(0, 0);
-        for (const auto& vertex : cellPolygon.vertices) {
-            centroid.x += vertex.x;
-            centroid.y += vertex.y;
-        }
-        centroid.x /= cellPolygon.vertices.size();
-        centroid.y /= cellPolygon.vertices.size();
-
-        // Check if centroid is inside annotation polygon
-        if (annotation.ContainsPoint(centroid)) {
-            annotation.cellCounts[cellPolygon.classId]++;
-        }
-    }
-
-    std::cout << "Computed cell counts for " << annotation.name << ": ";
+    std::ostringstream line;
+    line << "Computed cell counts for " << annotation.name << ": ";
     for (const auto& [classId, count] : annotation.cellCounts) {
-        std::cout << "Class " << classId << ": " << count << " ";
+        line << "Class " << classId << ": " << count << " ";
     }
-    std::cout << std::endl;
+    PATHVIEW_LOG_INFO(line.str());
+}
+
+void AnnotationManager::CountCellsInside(const std::vector<Vec2>& vertices, const PolygonOverlay& cells,
+                                         std::map<int, int>& counts, float minConfidence) {
+    PolygonMask(vertices).CountCentroids(cells.GetPolygons(), cells.GetSpatialIndex(), counts, minConfidence);
 }
 
 // ========== PROGRAMMATIC ANNOTATION API ==========
@@ -193,7 +234,7 @@ int AnnotationManager::CreateAnnotation(const std::vector<Vec2>& vertices,
                                         const std::string& name,
                                         PolygonOverlay* polygonOverlay) {
     if (!ValidateVertices(vertices)) {
-        std::cerr << "Cannot create annotation: invalid vertices" << std::endl;
+        PATHVIEW_LOG_ERROR("Cannot create annotation: invalid vertices");
         return -1;
     }
 
@@ -214,132 +255,145 @@ int AnnotationManager::CreateAnnotation(const std::vector<Vec2>& vertices,
     }
 
     int newId = annotation.id;
-    annotations_.push_back(annotation);
-
-    std::cout << "Created annotation programmatically: " << annotation.name
-              << " (ID: " << newId << ") with " << annotation.vertices.size()
-              << " vertices" << std::endl;
+    PATHVIEW_LOG_INFO("Created annotation programmatically: " << annotation.name
+                      << " (ID: " << newId << ") with " << annotation.vertices.size()
+                      << " vertices");
+    JournalAnnotation(annotation);
+    AddAnnotation(std::move(annotation));
 
     return newId;
 }
 
-AnnotationPolygon* AnnotationManager::GetAnnotationById(int id) {
-    for (auto& annotation : annotations_) {
-        if (annotation.id == id) {
-            return &annotation;
-        }
+int AnnotationManager::RestoreAnnotation(const StoredAnnotation& stored, PolygonOverlay* polygonOverlay) {
+    if (!ValidateVertices(stored.vertices) || slotById_.count(stored.id) > 0) {
+        return -1;
     }
-    return nullptr;
-}
 
-const AnnotationPolygon* AnnotationManager::GetAnnotationById(int id) const {
-    for (const auto& annotation : annotations_) {
-        if (annotation.id == id) {
-            return &annotation;
-        }
+    AnnotationPolygon annotation(stored.id);
+    annotation.vertices = stored.vertices;
+    annotation.name = stored.name;
+    annotation.ComputeBoundingBox();
+    if (polygonOverlay && polygonOverlay->GetPolygonCount() > 0) {
+        CountCellsInside(annotation.vertices, *polygonOverlay, annotation.cellCounts);
     }
-    return nullptr;
+
+    nextAnnotationId_ = std::max(nextAnnotationId_, stored.id + 1);
+    AddAnnotation(std::move(annotation));
+    return stored.id;
 }
 
-bool AnnotationManager::DeleteAnnotationById(int id) {
-    for (auto it = annotations_.begin(); it != annotations_.end(); ++it) {
-        if (it->id == id) {
-            std::cout << "Deleting annotation by ID: " << it->name
-                     << " (ID: " << id << ")" << std::endl;
-            annotations_.erase(it);
-            return true;
-        }
+void AnnotationManager::Clear() {
+    drawingState_.Clear();
+    annotations_.clear();
+    slotById_.clear();
+    index_.Clear();
+    nextAnnotationId_ = 1;
+    renamingAnnotationIndex_ = -1;
+    ++revision_;
+}
+
+std::vector<StoredAnnotation> AnnotationManager::GetStoredAnnotations() const {
+    std::vector<StoredAnnotation> stored;
+    stored.reserve(annotations_.size());
+    for (const AnnotationPolygon& annotation : annotations_) {
+        stored.push_back(ToStored(annotation));
     }
-    return false;
+    return stored;
 }
 
-AnnotationManager::AnnotationMetrics
-AnnotationManager::ComputeMetricsForVertices(const std::vector<Vec2>& vertices,
-                                             PolygonOverlay* polygonOverlay) const {
-    AnnotationMetrics metrics;
+StoredAnnotation AnnotationManager::ToStored(const AnnotationPolygon& annotation) {
+    StoredAnnotation stored;
+    stored.id = annotation.id;
+    stored.name = annotation.name;
+    stored.vertices = annotation.vertices;
+    return stored;
+}
 
-    if (!ValidateVertices(vertices)) {
-        std::cerr << "Cannot compute metrics: invalid vertices" << std::endl;
-        metrics.boundingBox = Rect{0, 0, 0, 0};
-        metrics.area = 0.0;
-        metrics.perimeter = 0.0;
-        metrics.totalCells = 0;
-        return metrics;
+void AnnotationManager::JournalAnnotation(const AnnotationPolygon& annotation) {
+    if (journal_) {
+        journal_->PutAnnotation(ToStored(annotation));
     }
+}
 
-    // Create temporary annotation to compute metrics
-    AnnotationPolygon tempAnnotation(0);  // Temporary ID
-    tempAnnotation.vertices = vertices;
-    tempAnnotation.ComputeBoundingBox();
+void AnnotationManager::AddAnnotation(AnnotationPolygon&& annotation) {
+    annotation.BuildGeometry();
+    slotById_[annotation.id] = annotations_.size();
+    index_.Insert(annotation.id, annotation.boundingBox);
+    annotations_.push_back(std::move(annotation));
+    ++revision_;
+}
 
-    metrics.boundingBox = tempAnnotation.boundingBox;
-    metrics.area = ComputeArea(vertices);
-    metrics.perimeter = ComputePerimeter(vertices);
+void AnnotationManager::RemoveAnnotation(size_t slot) {
+    const AnnotationPolygon& annotation = annotations_[slot];
+    if (journal_) {
+        journal_->DeleteAnnotation(annotation.id);
+    }
+    index_.Remove(annotation.id, annotation.boundingBox);
+    slotById_.erase(annotation.id);
+    annotations_.erase(annotations_.begin() + static_cast<std::ptrdiff_t>(slot));
 
-    // Compute cell counts if polygon overlay provided
-    if (polygonOverlay) {
-        const auto& cellPolygons = polygonOverlay->GetPolygons();
+    // Keep creation order (the list and annotations.list show it); the
+    // ones after the gap move down by one
+    for (size_t i = slot; i < annotations_.size(); ++i) {
+        slotById_[annotations_[i].id] = i;
+    }
+    ++revision_;
+}
 
-        for (const auto& cellPolygon : cellPolygons) {
-            if (cellPolygon.vertices.empty()) continue;
+AnnotationPolygon* AnnotationManager::GetAnnotationById(int id) {
+    auto it = slotById_.find(id);
+    return it != slotById_.end() ? &annotations_[it->second] : nullptr;
+}
 
-            // Compute centroid of cell polygon
-            Vec2 centroid(0, 0);
-            for (const auto& vertex : cellPolygon.vertices) {
-                centroid.x += vertex.x;
-                centroid.y += vertex.y;
-            }
-            centroid.x /= cellPolygon.vertices.size();
-            centroid.y /= cellPolygon.vertices.size();
+const AnnotationPolygon* AnnotationManager::GetAnnotationById(int id) const {
+    auto it = slotById_.find(id);
+    return it != slotById_.end() ? &annotations_[it->second] : nullptr;
+}
 
-            // Check if centroid is inside the temporary annotation
-            if (tempAnnotation.ContainsPoint(centroid)) {
-                metrics.cellCounts[cellPolygon.classId]++;
-            }
-        }
+bool AnnotationManager::DeleteAnnotationById(int id) {
+    auto it = slotById_.find(id);
+    if (it == slotById_.end()) {
+        return false;
     }
+    PATHVIEW_LOG_INFO("Deleting annotation by ID: " << annotations_[it->second].name
+                      << " (ID: " << id << ")");
+    RemoveAnnotation(it->second);
+    return true;
+}
 
-    // Compute total cells
-    metrics.totalCells = 0;
-    for (const auto& [classId, count] : metrics.cellCounts) {
-        metrics.totalCells += count;
+AnnotationManager::AnnotationMetrics
+AnnotationManager::ComputeMetricsForVertices(const std::vector<Vec2>& vertices,
+                                             PolygonOverlay* polygonOverlay,
+                                             float minConfidence) const {
+    RoiMetrics::Options options;
+    options.minConfidence = minConfidence;
+    return ComputeMetricsForVertices(vertices, polygonOverlay, options);
+}
+
+AnnotationManager::AnnotationMetrics
+AnnotationManager::ComputeMetricsForVertices(const std::vector<Vec2>& vertices,
+                                             PolygonOverlay* polygonOverlay,
+                                             const RoiMetrics::Options& options) const {
+    if (!ValidateVertices(vertices)) {
+        PATHVIEW_LOG_ERROR("Cannot compute metrics: invalid vertices");
+        return AnnotationMetrics();
     }
 
-    return metrics;
+    if (polygonOverlay) {
+        return RoiMetrics::Compute(vertices, &polygonOverlay->GetPolygons(), polygonOverlay->GetSpatialIndex(),
+                                   options);
+    }
+    return RoiMetrics::Compute(vertices, nullptr, nullptr, options);
 }
 
 // ========== GEOMETRY CALCULATION HELPERS ==========
 
 double AnnotationManager::ComputeArea(const std::vector<Vec2>& vertices) {
-    if (vertices.size() < 3) return 0.0;
-
-    // Shoelace formula: Area = 0.5 * |Σ(x_i * y_{i+1} - x_{i+1} * y_i)|
-    double area = 0.0;
-    size_t n = vertices.size();
-
-    for (size_t i = 0; i < n; ++i) {
-        size_t j = (i + 1) % n;
-        area += vertices[i].x * vertices[j].y;
-        area -= vertices[j].x * vertices[i].y;
-    }
-
-    return std::abs(area) / 2.0;
+    return RoiMetrics::Area(vertices);
 }
 
 double AnnotationManager::ComputePerimeter(const std::vector<Vec2>& vertices) {
-    if (vertices.size() < 2) return 0.0;
-
-    double perimeter = 0.0;
-    size_t n = vertices.size();
-
-    for (size_t i = 0; i < n; ++i) {
-        size_t j = (i + 1) % n;
-        double dx = vertices[j].x - vertices[i].x;
-        double dy = vertices[j].y - vertices[i].y;
-        perimeter += std::sqrt(dx * dx + dy * dy);
-    }
-
-    return perimeter;
+    return RoiMetrics::Perimeter(vertices);
 }
 
 bool AnnotationManager::ValidateVertices(const std::vector<Vec2>& vertices) {
@@ -363,59 +417,68 @@ bool AnnotationManager::ValidateVertices(const std::vector<Vec2>& vertices) {
 void AnnotationManager::RenderAnnotations(const Viewport& viewport) {
     if (annotations_.empty()) return;
 
-    SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
-
-    for (const auto& annotation : annotations_) {
-        RenderAnnotationPolygon(annotation, viewport);
+    // Only the annotations in view, drawn in creation order (newest on top)
+    index_.Query(viewport.GetVisibleRegion(), visibleIds_);
+    if (visibleIds_.empty()) return;
+    visibleSlots_.clear();
+    for (int id : visibleIds_) {
+        visibleSlots_.push_back(slotById_.at(id));
     }
-}
-
-void AnnotationManager::RenderAnnotationPolygon(const AnnotationPolygon& annotation,
-                                                 const Viewport& viewport) {
-    if (annotation.vertices.size() < 3) return;
+    std::sort(visibleSlots_.begin(), visibleSlots_.end());
 
-    // Render filled polygon
-    if (annotation.triangleIndices.empty()) {
-        annotation.triangleIndices = PolygonTriangulator::Triangulate(annotation.vertices);
+    batch_.Clear();
+    for (size_t slot : visibleSlots_) {
+        BatchAnnotation(annotations_[slot], viewport);
     }
+    if (batch_.Empty()) return;
 
-    if (!annotation.triangleIndices.empty()) {
-        std::vector<SDL_Vertex> vertices;
-
-        uint8_t alpha = static_cast<uint8_t>(ANNOTATION_OPACITY * 255);
-
-        // Transform vertices to screen space
-        for (const auto& vertex : annotation.vertices) {
-            Vec2 screenPos = viewport.SlideToScreen(vertex);
-            SDL_Vertex sdlVertex;
-            sdlVertex.position = {static_cast<float>(screenPos.x),
-                                 static_cast<float>(screenPos.y)};
-            sdlVertex.color = {ANNOTATION_COLOR.r, ANNOTATION_COLOR.g,
-                              ANNOTATION_COLOR.b, alpha};
-            sdlVertex.tex_coord = {0.0f, 0.0f};
-            vertices.push_back(sdlVertex);
-        }
+    SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+    batch_.Draw(renderer_);
+}
 
-        // Render filled triangles
-        SDL_RenderGeometry(renderer_, nullptr,
-            vertices.data(), static_cast<int>(vertices.size()),
-            annotation.triangleIndices.data(),
-            static_cast<int>(annotation.triangleIndices.size()));
-    }
+void AnnotationManager::BatchAnnotation(const AnnotationPolygon& annotation,
+                                        const Viewport& viewport) {
+    if (annotation.vertices.size() < 3) return;
 
-    // Render outline
-    SDL_SetRenderDrawColor(renderer_, ANNOTATION_OUTLINE_COLOR.r,
-                          ANNOTATION_OUTLINE_COLOR.g,
-                          ANNOTATION_OUTLINE_COLOR.b, 255);
+    // The coarsest outline that stays within LOD_SCREEN_ERROR at this zoom
+    const std::vector<Vec2>* outline = &annotation.vertices;
+    const std::vector<int>* triangles = &annotation.triangles;
+    if (const AnnotationLod* lod = annotation.GetLod(LOD_SCREEN_ERROR / viewport.GetZoom())) {
+        outline = &lod->vertices;
+        triangles = &lod->triangles;
+    }
+
+    // Its vertices in the fill color carry the fill; the outline quads are
+    // built from their screen positions
+    const uint8_t alpha = static_cast<uint8_t>(ANNOTATION_OPACITY * 255);
+    const int base = batch_.AddVertices(outline->data(), outline->size(), viewport,
+                                        SDL_Color{ANNOTATION_COLOR.r, ANNOTATION_COLOR.g, ANNOTATION_COLOR.b, alpha});
+    batch_.AddTriangles(base, triangles->data(), triangles->size());
+    batch_.AddOutline(base, outline->size(), OUTLINE_WIDTH, ANNOTATION_OUTLINE_COLOR);
+}
 
-    for (size_t i = 0; i < annotation.vertices.size(); ++i) {
-        Vec2 v1 = viewport.SlideToScreen(annotation.vertices[i]);
-        Vec2 v2 = viewport.SlideToScreen(
-            annotation.vertices[(i + 1) % annotation.vertices.size()]);
-        SDL_RenderDrawLine(renderer_,
-            static_cast<int>(v1.x), static_cast<int>(v1.y),
-            static_cast<int>(v2.x), static_cast<int>(v2.y));
-    }
+void AnnotationManager::UpdatePreviewPath(const Viewport& viewport) {
+    DrawingState& state = drawingState_;
+    const Vec2 position = viewport.GetPosition();
+    if (viewport.GetZoom() != state.pathZoom || position.x != state.pathPosition.x ||
+        position.y != state.pathPosition.y) {
+        state.path.Clear();
+        state.pathVertices = 0;
+        state.pathZoom = viewport.GetZoom();
+        state.pathPosition = position;
+    }
+
+    const std::vector<Vec2>& drawn = state.currentVertices;
+    if (state.pathVertices == drawn.size()) return;
+
+    // From the last vertex already in the path, for the edge to the first new one
+    const size_t first = state.pathVertices > 0 ? state.pathVertices - 1 : 0;
+    const size_t count = drawn.size() - first;
+    const int base = state.path.AddVertices(&drawn[first], count, viewport, DRAWING_EDGE_COLOR);
+    state.path.AddOutline(base, count, OUTLINE_WIDTH, DRAWING_EDGE_COLOR, false);
+    state.path.AddDiscs(base + static_cast<int>(state.pathVertices - first), drawn.size() - state.pathVertices,
+                        DRAWING_VERTEX_RADIUS, DRAWING_VERTEX_COLOR);
+    state.pathVertices = drawn.size();
 }
 
 void AnnotationManager::RenderDrawingPreview(const Viewport& viewport) {
@@ -423,38 +486,9 @@ void AnnotationManager::RenderDrawingPreview(const Viewport& viewport) {
 
     SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
 
-    // Render vertices as circles
-    SDL_SetRenderDrawColor(renderer_, DRAWING_VERTEX_COLOR.r,
-                          DRAWING_VERTEX_COLOR.g,
-                          DRAWING_VERTEX_COLOR.b, 255);
-
-    for (const auto& vertex : drawingState_.currentVertices) {
-        Vec2 screenPos = viewport.SlideToScreen(vertex);
-        int x = static_cast<int>(screenPos.x);
-        int y = static_cast<int>(screenPos.y);
-
-        // Draw a small circle (5 pixel radius)
-        for (int dy = -5; dy <= 5; ++dy) {
-            for (int dx = -5; dx <= 5; ++dx) {
-                if (dx*dx + dy*dy <= 25) {  // Circle equation
-                    SDL_RenderDrawPoint(renderer_, x + dx, y + dy);
-                }
-            }
-        }
-    }
-
-    // Render edges between vertices
-    SDL_SetRenderDrawColor(renderer_, DRAWING_EDGE_COLOR.r,
-                          DRAWING_EDGE_COLOR.g,
-                          DRAWING_EDGE_COLOR.b, 255);
-
-    for (size_t i = 0; i < drawingState_.currentVertices.size() - 1; ++i) {
-        Vec2 v1 = viewport.SlideToScreen(drawingState_.currentVertices[i]);
-        Vec2 v2 = viewport.SlideToScreen(drawingState_.currentVertices[i + 1]);
-        SDL_RenderDrawLine(renderer_,
-            static_cast<int>(v1.x), static_cast<int>(v1.y),
-            static_cast<int>(v2.x), static_cast<int>(v2.y));
-    }
+    // The path so far in one call; only the edge to the mouse is new each frame
+    UpdatePreviewPath(viewport);
+    drawingState_.path.Draw(renderer_);
 
     // Render preview edge from last vertex to mouse
     if (!drawingState_.currentVertices.empty()) {
@@ -500,6 +534,18 @@ void AnnotationManager::RenderUI(PolygonOverlay* polygonOverlay) {
                           "Drawing mode active");
     }
 
+    // Counts of the outline so far, closed back to its first vertex
+    if (drawingState_.isActive && drawingState_.currentVertices.size() >= 3 &&
+        polygonOverlay && polygonOverlay->GetPolygonCount() > 0) {
+        ImGui::Indent();
+        for (const auto& [classId, count] : drawingState_.cellCount.GetCounts()) {
+            ImGui::BulletText("Class %d: %d", classId, count);
+        }
+        ImGui::TextColored(ImVec4(0.9f, 0.9f, 0.5f, 1.0f), "Drawing: %d cells inside",
+                           drawingState_.cellCount.GetTotal());
+        ImGui::Unindent();
+    }
+
     ImGui::Separator();
 
     if (annotations_.empty()) {
@@ -509,69 +555,75 @@ void AnnotationManager::RenderUI(PolygonOverlay* polygonOverlay) {
         return;
     }
 
-    // List annotations
+    // List annotations, one row each: only the rows in view are drawn,
+    // so thousands of ROIs cost what a screenful does
     ImGui::BeginChild("AnnotationList", ImVec2(0, 0), true);
 
     int deleteIndex = -1;  // Track which to delete outside the loop
+    const bool cellsLoaded = polygonOverlay && polygonOverlay->GetPolygonCount() > 0;
 
-    for (int i = 0; i < static_cast<int>(annotations_.size()); ++i) {
-        ImGui::PushID(i);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(annotations_.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            ImGui::PushID(i);
 
-        auto& annotation = annotations_[i];
+            auto& annotation = annotations_[i];
 
-        // Annotation name (double-click to rename)
-        if (ImGui::Selectable(annotation.name.c_str(), false,
-                             ImGuiSelectableFlags_AllowDoubleClick)) {
-            if (ImGui::IsMouseDoubleClicked(0)) {
-                StartRenaming(i);
+            // Annotation name (double-click to rename)
+            if (ImGui::Selectable(annotation.name.c_str(), false,
+                                 ImGuiSelectableFlags_AllowDoubleClick)) {
+                if (ImGui::IsMouseDoubleClicked(0)) {
+                    StartRenaming(i);
+                }
             }
-        }
 
-        // Delete button
-        ImGui::SameLine();
-        if (ImGui::SmallButton("X")) {
-            deleteIndex = i;
-        }
-
-        // Show vertex count
-        ImGui::SameLine();
-        ImGui::TextDisabled("(%d vertices)",
-                           static_cast<int>(annotation.vertices.size()));
-
-        // Show cell counts if available
-        if (!annotation.cellCounts.empty()) {
-            ImGui::Indent();
-            ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.8f, 1.0f), "Cells inside:");
-
-            int totalCells = 0;
-            for (const auto& [classId, count] : annotation.cellCounts) {
-                totalCells += count;
-                // Get class color from polygon overlay if available
-                SDL_Color classColor = {200, 200, 200, 255};  // Default gray
-                if (polygonOverlay) {
-                    classColor = polygonOverlay->GetClassColor(classId);
+            // Cells inside, by class, on hover
+            if (!annotation.cellCounts.empty() && ImGui::IsItemHovered()) {
+                ImGui::BeginTooltip();
+                ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.8f, 1.0f), "Cells inside:");
+                for (const auto& [classId, count] : annotation.cellCounts) {
+                    // Get class color from polygon overlay if available
+                    SDL_Color classColor = {200, 200, 200, 255};  // Default gray
+                    if (polygonOverlay) {
+                        classColor = polygonOverlay->GetClassColor(classId);
+                    }
+                    ImGui::ColorButton("##color", ImVec4(classColor.r / 255.0f,
+                                                         classColor.g / 255.0f,
+                                                         classColor.b / 255.0f,
+                                                         1.0f),
+                                      ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoPicker,
+                                      ImVec2(12, 12));
+                    ImGui::SameLine();
+                    ImGui::Text("Class %d: %d", classId, count);
                 }
+                ImGui::EndTooltip();
+            }
+
+            // Delete button
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X")) {
+                deleteIndex = i;
+            }
 
-                ImGui::BulletText("Class %d: %d", classId, count);
+            // Show vertex count and total cells
+            ImGui::SameLine();
+            ImGui::TextDisabled("(%d vertices)",
+                               static_cast<int>(annotation.vertices.size()));
+            if (!annotation.cellCounts.empty()) {
+                int totalCells = 0;
+                for (const auto& [classId, count] : annotation.cellCounts) {
+                    totalCells += count;
+                }
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(0.9f, 0.9f, 0.5f, 1.0f), "%d cells", totalCells);
+            } else if (cellsLoaded) {
                 ImGui::SameLine();
-                // Show color indicator
-                ImGui::ColorButton("##color", ImVec4(classColor.r / 255.0f,
-                                                     classColor.g / 255.0f,
-                                                     classColor.b / 255.0f,
-                                                     1.0f),
-                                  ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoPicker,
-                                  ImVec2(12, 12));
+                ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f), "no cells");
             }
 
-            ImGui::TextColored(ImVec4(0.9f, 0.9f, 0.5f, 1.0f), "Total: %d cells", totalCells);
-            ImGui::Unindent();
-        } else if (polygonOverlay && polygonOverlay->GetPolygonCount() > 0) {
-            ImGui::Indent();
-            ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f), "No cells inside");
-            ImGui::Unindent();
+            ImGui::PopID();
         }
-
-        ImGui::PopID();
     }
 
     ImGui::EndChild();
@@ -604,6 +656,8 @@ void AnnotationManager::RenderUI(PolygonOverlay* polygonOverlay) {
             if (renamingAnnotationIndex_ >= 0 &&
                 renamingAnnotationIndex_ < static_cast<int>(annotations_.size())) {
                 annotations_[renamingAnnotationIndex_].name = renameBuffer_;
+                JournalAnnotation(annotations_[renamingAnnotationIndex_]);
+                ++revision_;
             }
             renamingAnnotationIndex_ = -1;
             ImGui::CloseCurrentPopup();
@@ -621,8 +675,8 @@ void AnnotationManager::RenderUI(PolygonOverlay* polygonOverlay) {
 
 void AnnotationManager::DeleteAnnotation(int index) {
     if (index >= 0 && index < static_cast<int>(annotations_.size())) {
-        std::cout << "Deleting annotation: " << annotations_[index].name << std::endl;
-        annotations_.erase(annotations_.begin() + index);
+        PATHVIEW_LOG_INFO("Deleting annotation: " << annotations_[index].name);
+        RemoveAnnotation(static_cast<size_t>(index));
     }
 }
 
@@ -1,32 +1,68 @@
 #pragma once
 
+#include "AnnotationIndex.h"
+#include "AnnotationJournal.h"
+#include "GeometryBatch.h"
+#include "IncrementalCellCount.h"
+#include "RoiMetrics.h"
 #include "Viewport.h"
 #include <SDL2/SDL.h>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 // Forward declarations
 class PolygonOverlay;
 class Minimap;
 
+// An annotation outline simplified for drawing at a coarser scale, with its
+// own fill triangles
+struct AnnotationLod {
+    double tolerance = 0.0;       // Farthest a dropped vertex lies off it (slide pixels)
+    std::vector<Vec2> vertices;
+    std::vector<int> triangles;
+};
+
 // Annotation polygon structure
 struct AnnotationPolygon {
     std::vector<Vec2> vertices;         // Level 0 slide coordinates
     int id;                             // Unique identifier
     std::string name;                   // User-editable name
     Rect boundingBox;                   // Cached for rendering
-    mutable std::vector<int> triangleIndices;  // Lazy triangulation
+    std::vector<int> triangles;         // Fill of the full outline
+    std::vector<AnnotationLod> lods;    // Coarser outlines, finest first
     std::map<int, int> cellCounts;      // classId -> count of cells inside
 
     AnnotationPolygon(int id_) : id(id_), name("Polygon " + std::to_string(id_)) {}
     void ComputeBoundingBox();
     bool ContainsPoint(const Vec2& point) const;
+
+    // Triangulate the outline and build the coarser ones, after the
+    // bounding box; once per edit, so drawing only reads them
+    void BuildGeometry();
+
+    // Coarsest outline off the full one by at most maxError slide pixels,
+    // or null when only the full outline is that close
+    const AnnotationLod* GetLod(double maxError) const;
+
+    // Outlines simplified at LOD_FIRST_TOLERANCE slide pixels, then at
+    // LOD_STEP times the last, until the box's side or LOD_MIN_VERTICES;
+    // one dropping under a quarter of the previous vertices is skipped
+    static constexpr double LOD_FIRST_TOLERANCE = 0.5;
+    static constexpr double LOD_STEP = 4.0;
+    static constexpr size_t LOD_MIN_VERTICES = 16;
 };
 
 /**
  * Manages user-created polygon annotations on slides
  * Handles drawing interaction, rendering, and cell counting
+ *
+ * Annotations are kept in creation order, with a map from id to position
+ * for lookups and an AnnotationIndex over their boxes, so that drawing
+ * thousands of them costs only the ones in view: those are culled by the
+ * index, and their fills and outlines go to the renderer in one batch.
  */
 class AnnotationManager {
 public:
@@ -58,6 +94,8 @@ public:
     void StartRenaming(int index);
     const std::vector<AnnotationPolygon>& GetAnnotations() const { return annotations_; }
     int GetAnnotationCount() const { return static_cast<int>(annotations_.size()); }
+    // Bumped by every change to the list (created, deleted, renamed)
+    uint64_t GetRevision() const { return revision_; }
 
     // Cell counting
     void ComputeCellCounts(AnnotationPolygon& annotation, PolygonOverlay* polygonOverlay);
@@ -67,50 +105,85 @@ public:
                          const std::string& name = "",
                          PolygonOverlay* polygonOverlay = nullptr);
 
-    // Query by ID
+    // Query by ID (the vertices of the result must not be changed: the
+    // spatial index holds its box)
     AnnotationPolygon* GetAnnotationById(int id);
     const AnnotationPolygon* GetAnnotationById(int id) const;
 
     // Delete by ID (returns true if found and deleted)
     bool DeleteAnnotationById(int id);
 
+    // Persistence: every change is queued to the journal (null for none)
+    void SetJournal(AnnotationJournal* journal) { journal_ = journal; }
+
+    // Put back an annotation read from a journal, keeping its id (not
+    // journaled again); returns its id, or -1 if the vertices are invalid
+    int RestoreAnnotation(const StoredAnnotation& stored, PolygonOverlay* polygonOverlay = nullptr);
+
+    // Remove every annotation without journaling it (another slide opens)
+    void Clear();
+
+    // Annotations in the form the journal and GeoJSON export take
+    std::vector<StoredAnnotation> GetStoredAnnotations() const;
+
     // Metrics computation structure
-    struct AnnotationMetrics {
-        Rect boundingBox;
-        double area;
-        double perimeter;
-        std::map<int, int> cellCounts;
-        int totalCells;
-    };
+    using AnnotationMetrics = RoiMetrics;
 
-    // Compute metrics for arbitrary vertices (no persistence - "quick probe")
+    // Compute metrics for arbitrary vertices (no persistence - "quick probe");
+    // cells below minConfidence are left out of the counts
     AnnotationMetrics ComputeMetricsForVertices(
         const std::vector<Vec2>& vertices,
-        PolygonOverlay* polygonOverlay = nullptr) const;
+        PolygonOverlay* polygonOverlay = nullptr,
+        float minConfidence = 0.0f) const;
+    AnnotationMetrics ComputeMetricsForVertices(
+        const std::vector<Vec2>& vertices,
+        PolygonOverlay* polygonOverlay,
+        const RoiMetrics::Options& options) const;
 
     // Geometry calculation helpers (public static for testing)
     static double ComputeArea(const std::vector<Vec2>& vertices);
     static double ComputePerimeter(const std::vector<Vec2>& vertices);
     static bool ValidateVertices(const std::vector<Vec2>& vertices);
 
+    // How finished annotations are drawn (also by region.render)
+    static constexpr SDL_Color ANNOTATION_COLOR = {255, 255, 0, 255};  // Yellow
+    static constexpr float ANNOTATION_OPACITY = 0.3f;
+    static constexpr SDL_Color ANNOTATION_OUTLINE_COLOR = {255, 200, 0, 255};
+
 private:
     // Drawing state structure
     struct DrawingState {
         bool isActive;                      // Currently drawing
         std::vector<Vec2> currentVertices;  // Vertices in slide coords
         Vec2 mouseSlidePos;                 // Current mouse position
+        IncrementalCellCount cellCount;     // Cells inside currentVertices so far
+
+        // Screen geometry of the path so far (edges and vertex markers):
+        // grown by the vertices added since the last frame, rebuilt only
+        // when the view moves
+        GeometryBatch path;
+        size_t pathVertices = 0;            // Leading currentVertices in path
+        double pathZoom = 0.0;              // View path was built for
+        Vec2 pathPosition;
 
         DrawingState() : isActive(false) {}
         void Clear() {
             isActive = false;
             currentVertices.clear();
+            cellCount.Clear();
+            path.Clear();
+            pathVertices = 0;
         }
     };
 
     SDL_Renderer* renderer_;
     DrawingState drawingState_;
     std::vector<AnnotationPolygon> annotations_;
+    std::unordered_map<int, size_t> slotById_;  // id -> position in annotations_
+    AnnotationIndex index_;
     int nextAnnotationId_;
+    uint64_t revision_ = 0;
+    AnnotationJournal* journal_ = nullptr;
     bool toolActive_;
 
     // UI state for renaming
@@ -118,15 +191,38 @@ private:
     bool showRenameDialog_;
     int renamingAnnotationIndex_;
 
+    // Batch of the annotations in view, kept to reuse its capacity
+    std::vector<int> visibleIds_;
+    std::vector<size_t> visibleSlots_;
+    GeometryBatch batch_;
+
     // Helper methods
     void CompletePolygon(PolygonOverlay* polygonOverlay);
     bool IsNearFirstVertex(Vec2 screenPos, const Viewport& viewport) const;
-    void RenderAnnotationPolygon(const AnnotationPolygon& annotation, const Viewport& viewport);
+
+    // Store a finished annotation, or take one out (by position)
+    void AddAnnotation(AnnotationPolygon&& annotation);
+    void RemoveAnnotation(size_t slot);
+
+    // Queue an annotation's current state to the journal, if any
+    void JournalAnnotation(const AnnotationPolygon& annotation);
+    static StoredAnnotation ToStored(const AnnotationPolygon& annotation);
+
+    // Bring the drawing path's geometry up to date with the vertices and view
+    void UpdatePreviewPath(const Viewport& viewport);
+
+    // Append an annotation's fill triangles and outline quads to the batch
+    void BatchAnnotation(const AnnotationPolygon& annotation, const Viewport& viewport);
+
+    // Add to counts the cells (by class) whose centroid lies inside the
+    // outline, visiting only those the overlay's spatial index finds in its box
+    static void CountCellsInside(const std::vector<Vec2>& vertices, const PolygonOverlay& cells,
+                                 std::map<int, int>& counts, float minConfidence = 0.0f);
 
     // Rendering constants
-    static constexpr SDL_Color ANNOTATION_COLOR = {255, 255, 0, 255};  // Yellow
-    static constexpr float ANNOTATION_OPACITY = 0.3f;
-    static constexpr SDL_Color ANNOTATION_OUTLINE_COLOR = {255, 200, 0, 255};
     static constexpr SDL_Color DRAWING_VERTEX_COLOR = {0, 255, 0, 255};  // Green
     static constexpr SDL_Color DRAWING_EDGE_COLOR = {0, 200, 0, 255};
+    static constexpr float DRAWING_VERTEX_RADIUS = 5.0f;  // Screen pixels
+    static constexpr float OUTLINE_WIDTH = 1.0f;  // Screen pixels
+    static constexpr double LOD_SCREEN_ERROR = 0.5;  // Screen pixels an outline may stray when drawn
 };
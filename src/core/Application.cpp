@@ -1,34 +1,225 @@
 #include "Application.h"
 #include "SlideLoader.h"
+#include "SlideMetadata.h"
+#include "SlideOpenTask.h"
+#include "TiffTileReader.h"
+#include "RemoteFile.h"
 #include "TextureManager.h"
+#include "TileCache.h"
+#include "TileLoadThreadPool.h"
 #include "Viewport.h"
 #include "SlideRenderer.h"
+#include "ChannelCompositor.h"
 #include "Minimap.h"
 #include "PolygonOverlay.h"
+#include "HeatmapLayer.h"
+#include "PolygonLoadTask.h"
+#include "PolygonQuery.h"
 #include "AnnotationManager.h"
+#include "AnnotationGeoJson.h"
+#include "RoiMetrics.h"
 #include "NavigationLock.h"
 #include "UIStyle.h"
-#include "PNGEncoder.h"
+#include "PixelConvert.h"
+#include "SnapshotEncoder.h"
 #include "ScreenshotBuffer.h"
+#include "TileService.h"
+#include "CellTileService.h"
+#include "RegionOverlay.h"
+#include "RegionScan.h"
+#include "SlideTranscoder.h"
 #include "../api/ipc/IPCServer.h"
+#include "../api/ipc/CommandExecutor.h"
+#include "../api/ipc/SnapshotRing.h"
+#include "../api/ipc/EventSubscriptions.h"
 #include "../api/ipc/IPCMessage.h"
+#include "../api/http/HTTPServer.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_sdlrenderer2.h"
 #include "IconsFontAwesome6.h"
+#include "Log.h"
 #include <SDL_timer.h>
 #include <nfd.hpp>
-#include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
 #include <limits>
 #include <cfloat>
+#include <cstring>
+#include <cstdio>
 #include <thread>
 #include <random>
 #include <sstream>
 #include <iomanip>
 
+namespace {
+
+// Outline from an IPC array of [x, y] vertices (at least 3)
+std::vector<Vec2> ParseVertices(const pathview::ipc::json& verticesJson) {
+    // Binary connections may send them packed: x0, y0, x1, y1, ...
+    if (verticesJson.is_binary()) {
+        std::vector<double> coordinates = pathview::ipc::UnpackDoubles(verticesJson);
+        if (coordinates.size() % 2 != 0 || coordinates.size() < 6) {
+            throw std::runtime_error("vertices must be an array with at least 3 points");
+        }
+        std::vector<Vec2> vertices;
+        vertices.reserve(coordinates.size() / 2);
+        for (size_t i = 0; i < coordinates.size(); i += 2) {
+            vertices.push_back(Vec2(coordinates[i], coordinates[i + 1]));
+        }
+        return vertices;
+    }
+
+    if (!verticesJson.is_array() || verticesJson.size() < 3) {
+        throw std::runtime_error("vertices must be an array with at least 3 points");
+    }
+
+    std::vector<Vec2> vertices;
+    vertices.reserve(verticesJson.size());
+    for (const auto& vertexJson : verticesJson) {
+        if (!vertexJson.is_array() || vertexJson.size() != 2) {
+            throw std::runtime_error("Each vertex must be an array of [x, y]");
+        }
+        vertices.push_back(Vec2(vertexJson[0].get<double>(),
+                               vertexJson[1].get<double>()));
+    }
+    return vertices;
+}
+
+// Overlap options of annotations.compute_metrics(_batch): "cell_overlap"
+// (centroid, exact, raster or auto) and "tissue" (areas by tissue class,
+// when a tissue map is loaded)
+RoiMetrics::Options ParseMetricsOptions(const pathview::ipc::json& params, const TissueMap* tissueMap) {
+    RoiMetrics::Options options;
+    options.minConfidence = params.value("min_confidence", 0.0f);
+    const std::string overlap = params.value("cell_overlap", "centroid");
+    if (overlap == "centroid") {
+        options.cellOverlap = RoiMetrics::CellOverlap::CENTROID;
+    } else if (overlap == "exact") {
+        options.cellOverlap = RoiMetrics::CellOverlap::EXACT;
+    } else if (overlap == "raster") {
+        options.cellOverlap = RoiMetrics::CellOverlap::RASTER;
+    } else if (overlap == "auto") {
+        options.cellOverlap = RoiMetrics::CellOverlap::AUTO;
+    } else {
+        throw std::runtime_error("cell_overlap must be centroid, exact, raster or auto");
+    }
+    if (params.value("tissue", false)) {
+        if (!tissueMap) {
+            throw std::runtime_error("No tissue map loaded. Load a polygon file with tissue segmentation first.");
+        }
+        options.tissueMap = tissueMap;
+    }
+    return options;
+}
+
+// Reply fields of annotations.compute_metrics (and each batch result)
+pathview::ipc::json MetricsToJson(const RoiMetrics& metrics, const TissueMap* tissueMap = nullptr) {
+    pathview::ipc::json cellCountsJson = pathview::ipc::json::object();
+    for (const auto& [classId, count] : metrics.cellCounts) {
+        cellCountsJson[std::to_string(classId)] = count;
+    }
+    if (!metrics.cellCounts.empty()) {
+        cellCountsJson["total"] = metrics.totalCells;
+    }
+
+    pathview::ipc::json response{
+        {"bounding_box", {
+            {"x", metrics.boundingBox.x},
+            {"y", metrics.boundingBox.y},
+            {"width", metrics.boundingBox.width},
+            {"height", metrics.boundingBox.height}
+        }},
+        {"area", metrics.area},
+        {"perimeter", metrics.perimeter},
+        {"cell_counts", cellCountsJson}
+    };
+    if (!metrics.cellFractions.empty() || !metrics.cellAreas.empty()) {
+        pathview::ipc::json overlapJson = pathview::ipc::json::object();
+        for (const auto& [classId, fraction] : metrics.cellFractions) {
+            overlapJson[std::to_string(classId)] = {
+                {"fractional_count", fraction},
+                {"area", metrics.cellAreas.count(classId) ? metrics.cellAreas.at(classId) : 0.0}
+            };
+        }
+        response["cell_overlap"] = overlapJson;
+    }
+    if (tissueMap) {
+        // Keyed by class name where the polygon file named it
+        pathview::ipc::json tissueJson = pathview::ipc::json::object();
+        for (const auto& [label, area] : metrics.tissueAreas) {
+            auto name = tissueMap->GetClassNames().find(label);
+            const std::string key = name != tissueMap->GetClassNames().end() ? name->second : std::to_string(label);
+            tissueJson[key] = {
+                {"area", area},
+                {"fraction", metrics.area > 0.0 ? area / metrics.area : 0.0}
+            };
+        }
+        response["tissue_areas"] = tissueJson;
+    }
+    return response;
+}
+
+// Fail an IPC request still waiting for a load that was replaced
+void AbandonReply(std::unique_ptr<std::promise<pathview::ipc::json>>& reply, const std::string& reason) {
+    if (reply) {
+        reply->set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+        reply.reset();
+    }
+}
+
+// Copy a latency histogram (microseconds) into a Prometheus one (seconds):
+// each of its buckets counts under the first bound at or above its top
+void ExportLatency(const LatencyHistogram& histogram, pathview::http::Metrics::Series& series) {
+    const std::vector<double>& bounds = series.GetBounds();
+    std::vector<uint64_t> counts(bounds.size() + 1, 0);
+    for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        const uint64_t count = histogram.GetBucketCount(i);
+        if (count == 0) {
+            continue;
+        }
+        const double top = static_cast<double>(LatencyHistogram::BucketLowerBound(i) +
+                                               LatencyHistogram::BucketWidth(i)) / 1e6;
+        counts[std::lower_bound(bounds.begin(), bounds.end(), top) - bounds.begin()] += count;
+    }
+    series.SetBuckets(counts, histogram.GetMean() * static_cast<double>(histogram.GetCount()) / 1e6);
+}
+
+}  // namespace
+
+// The next worklist entry, opened in the background (UpdateWorklistPreload).
+// The renderer, joined to the shared decode pool, goes before the loader
+// and disk cache its workers read.
+struct Application::SlidePreload {
+    std::string path;
+    std::unique_ptr<SlideOpenTask> task;  // Until the slide is open
+    std::unique_ptr<PolygonLoadTask> polygons;
+    std::unique_ptr<SlideLoader> loader;
+    MinimapOverview overview;
+    TissueMask tissueMask;
+    std::unique_ptr<DiskTileCache> diskCache;
+    std::unique_ptr<SlideRenderer> renderer;
+    std::string error;  // Why the open failed, if it did
+};
+
+// region.export's job, shared with its thread until finished
+struct Application::RegionExport {
+    std::string cardId;
+    std::string path;
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> finished{false};
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> total{0};
+    SlideTranscoder::Result result;  // Once finished
+    int reportedPercent = -1;        // On the card
+    std::chrono::steady_clock::time_point started;
+    std::thread thread;
+};
+
 Application::Application()
     : window_(nullptr)
     , renderer_(nullptr)
@@ -44,6 +235,9 @@ Application::Application()
     , navLock_(std::make_unique<NavigationLock>())
     , screenshotBuffer_(std::make_unique<pathview::ScreenshotBuffer>())
 {
+    compareLink_.SetZoomRatio(COMPARE_ZOOM_RATIO);
+    frameSeconds_ = &metrics_->Histogram("pathview_frame_seconds", "Time to update and draw a frame",
+                                         pathview::http::Metrics::FrameBounds());
 }
 
 Application::~Application() {
@@ -63,8 +257,8 @@ bool Application::IsNavigationOwnedByClient(socket_t clientFd) const {
 
 void Application::CheckLockExpiry() {
     if (navLock_->IsLocked() && navLock_->IsExpired()) {
-        std::cout << "Navigation lock expired for owner: "
-                  << navLock_->GetOwnerUUID() << std::endl;
+        PATHVIEW_LOG_INFO("Navigation lock expired for owner: "
+                          << navLock_->GetOwnerUUID());
         navLock_->Reset();
     }
 }
@@ -92,31 +286,394 @@ std::string Application::GenerateUUID() const {
     return ss.str();
 }
 
+void Application::SetDecodeThreads(size_t threads, bool autoScale) {
+    decodeThreads_ = threads;
+    decodeAutoScale_ = autoScale;
+}
+
+void Application::SetWorkerScheduling(bool backgroundPriority, size_t reservedCores) {
+    workerBackgroundPriority_ = backgroundPriority;
+    reservedRenderCores_ = reservedCores;
+}
+
+void Application::SetLevelSelection(LevelSelection mode) {
+    levelSelection_ = mode;
+    if (slideRenderer_) {
+        slideRenderer_->SetLevelSelection(mode);
+        if (channelCompositor_) {
+            channelCompositor_->SetLevelSelection(mode);
+        }
+        InvalidateScene();
+        RequestRedraw();
+    }
+}
+
+void Application::SetMotionLevels(int32_t levels) {
+    motionLevels_ = std::clamp(levels, 0, 2);
+    if (slideRenderer_) {
+        slideRenderer_->SetMotionLevels(motionLevels_);
+        RequestRedraw();
+    }
+}
+
+void Application::SetRenderScale(double still, double moving) {
+    renderScale_ = std::clamp(still, SlideRenderer::MIN_RENDER_SCALE, SlideRenderer::MAX_RENDER_SCALE);
+    movingRenderScale_ = std::clamp(moving, SlideRenderer::MIN_RENDER_SCALE, SlideRenderer::MAX_RENDER_SCALE);
+    if (slideRenderer_) {
+        slideRenderer_->SetRenderScale(renderScale_, movingRenderScale_);
+        if (channelCompositor_) {
+            channelCompositor_->SetRenderScale(renderScale_, movingRenderScale_);
+        }
+        InvalidateScene();
+        RequestRedraw();
+    }
+}
+
+void Application::SetDiskCache(const std::string& rootDir, size_t maxBytes) {
+    diskCacheRoot_ = rootDir;
+    diskCacheMaxBytes_ = maxBytes;
+}
+
+void Application::SetTileEvictionPolicy(TileEvictionPolicy policy, int pinnedCoarseLevels) {
+    tileEvictionPolicy_ = policy;
+    pinnedCoarseLevels_ = std::max(0, pinnedCoarseLevels);
+    PATHVIEW_LOG_INFO("Tile eviction: " << TileCache::EvictionPolicyName(policy)
+                      << (pinnedCoarseLevels_ > 0 ? ", coarsest " + std::to_string(pinnedCoarseLevels_) +
+                                                    " levels pinned" : std::string()));
+}
+
+void Application::SetHugePages(HugePageMode mode) {
+    hugePages_ = mode;
+    if (tileCache_) {
+        tileCache_->GetBufferPool()->SetHugePages(mode);
+    }
+    if (mode != HugePageMode::Off) {
+        PATHVIEW_LOG_INFO("Tile buffers: " << TileBufferPool::HugePageModeName(mode) << " huge pages");
+    }
+}
+
+void Application::SetTileStorage(TileStorage storage) {
+    tileStorage_ = storage;
+    if (tileCache_) {
+        tileCache_->SetStorage(storage);
+    }
+    if (storage != TileStorage::Argb) {
+        PATHVIEW_LOG_INFO("Tile storage: " << TileCache::StorageName(storage));
+    }
+}
+
+void Application::SetSolidTiles(bool enabled) {
+    solidTiles_ = enabled;
+    if (tileCache_) {
+        tileCache_->SetSolidTiles(enabled);
+    }
+}
+
+void Application::SetTextureCompression(TextureCompression compression) {
+    textureCompression_ = compression;
+    if (!textureManager_ || compression == textureManager_->GetCompression()) {
+        return;  // Applied once the texture manager exists
+    }
+    if (!textureManager_->SetCompression(compression)) {
+        textureCompression_ = textureManager_->GetCompression();
+        return;
+    }
+    PATHVIEW_LOG_INFO("Tile textures: " << TextureCompressionName(compression));
+}
+
+void Application::SetTileCacheBudget(size_t maxBytes) {
+    tileCacheBudgetBytes_ = maxBytes;
+    tileCacheTargetBytes_ = maxBytes > 0
+        ? maxBytes : TileCache::AutoSizeMaxMemory(MemoryRegistry::GetPhysicalMemoryBytes());
+    PATHVIEW_LOG_INFO("Tile cache budget: " << (tileCacheTargetBytes_ / (1024 * 1024)) << " MB"
+                      << (maxBytes > 0 ? "" : " (auto)"));
+    if (!compressedCacheConfigured_) {
+        compressedCacheBytes_ = tileCacheTargetBytes_ / 4;
+    }
+    if (slideRenderer_) {
+        slideRenderer_->SetCacheMaxMemory(tileCacheTargetBytes_);
+        slideRenderer_->SetCompressedCacheMaxMemory(compressedCacheBytes_);
+    }
+}
+
+void Application::SetCompressedCacheBudget(size_t maxBytes) {
+    compressedCacheBytes_ = maxBytes;
+    compressedCacheConfigured_ = true;
+    if (slideRenderer_) {
+        slideRenderer_->SetCompressedCacheMaxMemory(compressedCacheBytes_);
+    }
+}
+
+void Application::SetTraceRecording(const std::string& path) {
+    StartTraceRecording(path);
+}
+
+bool Application::StartTraceRecording(const std::string& path) {
+    if (path.empty()) {
+        return false;
+    }
+    traceRecording_.Clear();
+    traceRecordPath_ = path;
+    traceRecordStart_ = std::chrono::steady_clock::now();
+    PATHVIEW_LOG_INFO("Recording viewport trace to " << path);
+    return true;
+}
+
+bool Application::StopTraceRecording() {
+    if (traceRecordPath_.empty()) {
+        return false;
+    }
+    bool saved = traceRecording_.Save(traceRecordPath_);
+    if (saved) {
+        PATHVIEW_LOG_INFO("Saved viewport trace: " << traceRecording_.GetSampleCount() << " samples over "
+                          << traceRecording_.GetDurationMs() / 1000.0 << "s to " << traceRecordPath_);
+    }
+    traceRecordPath_.clear();
+    return saved;
+}
+
+void Application::RecordTraceSample() {
+    if (traceRecordPath_.empty() || !viewport_) {
+        return;
+    }
+    double timeMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - traceRecordStart_).count();
+    Vec2 position = viewport_->GetPosition();
+    traceRecording_.Append({timeMs, position.x, position.y, viewport_->GetZoom(),
+                            viewport_->GetWindowWidth(), viewport_->GetWindowHeight()});
+}
+
+bool Application::StartTraceReplay(const std::string& path) {
+    if (!viewport_ || !traceReplay_.Load(path) || traceReplay_.IsEmpty()) {
+        return false;
+    }
+
+    // Measure the replay on its own: fresh frame and tile stage timings
+    replayFrameTimes_.Reset();
+    if (slideRenderer_) {
+        slideRenderer_->GetPipelineStats().Reset();
+    }
+    replayingTrace_ = true;
+    traceReplayStart_ = std::chrono::steady_clock::now();
+    traceReplaySample_ = traceReplay_.GetSampleCount();  // Nothing applied yet
+    lastReplayFrame_ = {};
+
+    PATHVIEW_LOG_INFO("Replaying viewport trace " << path << ": " << traceReplay_.GetSampleCount()
+                      << " samples over " << traceReplay_.GetDurationMs() / 1000.0 << "s");
+    return true;
+}
+
+void Application::ApplyTraceReplay() {
+    if (!replayingTrace_ || !viewport_) {
+        return;
+    }
+
+    // Done once the last sample has been on screen for a frame
+    const std::vector<ViewportSample>& samples = traceReplay_.GetSamples();
+    if (traceReplaySample_ + 1 == samples.size()) {
+        FinishTraceReplay();
+        return;
+    }
+
+    // The trace's clock starts at its first sample
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - traceReplayStart_).count();
+    size_t index = traceReplay_.SampleIndexAt(samples.front().timeMs + elapsedMs);
+
+    if (index != traceReplaySample_) {
+        ShowTraceSample(samples[index]);
+        traceReplaySample_ = index;
+    }
+}
+
+void Application::ShowTraceSample(const ViewportSample& sample) {
+    if (sample.windowWidth != windowWidth_ || sample.windowHeight != windowHeight_) {
+        SDL_SetWindowSize(window_, sample.windowWidth, sample.windowHeight);  // Resize event follows
+    }
+
+    // Recorded states are already clamped and eased; apply them verbatim
+    viewport_->animation_.Cancel();
+    viewport_->position_ = Vec2(sample.x, sample.y);
+    viewport_->zoom_ = sample.zoom;
+}
+
+void Application::FinishTraceReplay() {
+    replayingTrace_ = false;
+
+    double elapsedSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - traceReplayStart_).count();
+    PATHVIEW_LOG_INFO("Viewport trace replay finished in " << elapsedSeconds << "s: "
+                      << replayFrameTimes_.GetCount() << " frames, frame time p50 "
+                      << replayFrameTimes_.GetPercentile(0.50) / 1000.0 << "ms, p99 "
+                      << replayFrameTimes_.GetPercentile(0.99) / 1000.0 << "ms, max "
+                      << replayFrameTimes_.GetMax() / 1000.0 << "ms");
+}
+
+void Application::StartBenchmark() {
+    const FrameBenchmarkOptions& options = *benchmarkOptions_;
+    ViewportTrace trace;
+    if (!trace.Load(options.tracePath) || trace.IsEmpty()) {
+        FinishBenchmark("Failed to load viewport trace: " + options.tracePath);
+        return;
+    }
+    if (!options.polygonPath.empty()) {
+        LoadPolygons(options.polygonPath);
+        if (polygonLayers_[activePolygonLayer_].path.empty()) {
+            FinishBenchmark("Failed to load polygons: " + options.polygonPath);
+            return;
+        }
+    }
+
+    if (slideRenderer_) {
+        slideRenderer_->GetPipelineStats().Reset();
+    }
+    benchmark_ = std::make_unique<FrameBenchmark>(trace, options);
+    PATHVIEW_LOG_INFO("Benchmarking viewport trace " << options.tracePath << ": " << trace.GetSampleCount()
+                      << " samples, " << (options.warmCache ? "warm" : "cold") << " cache");
+}
+
+void Application::RecordBenchmarkFrame(std::chrono::steady_clock::time_point frameStart,
+                                       std::chrono::steady_clock::time_point frameEnd) {
+    FrameBenchmark::Frame frame;
+    const FrameProfiler::Frame& profiled = frameProfiler_.GetFrame(0);
+    for (const FrameProfiler::Zone& zone : profiled.zones) {
+        if (std::strcmp(zone.name, "Present") == 0) {
+            frame.presentMs += (zone.endUs - zone.startUs) / 1000.0;
+        }
+    }
+    const double frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+    frame.cpuMs = std::max(0.0, frameMs - frame.presentMs);
+    if (slideRenderer_) {
+        frame.visibleTiles = slideRenderer_->GetVisibleTiles().size();
+        frame.displayedTiles = frame.visibleTiles -
+                               std::min(frame.visibleTiles, slideRenderer_->GetUncoveredTileCount());
+        frame.requestedTiles = slideRenderer_->GetRequestedTileCount();
+    }
+
+    // Sharp as await_sharp captures see it, with the overlay's tiles in too
+    const bool sharp = IsViewSharp() && !HasPendingPolygonUploads();
+    const bool warmingUp = !benchmark_->IsMeasuring();
+    benchmark_->EndFrame(frame, sharp, frameEnd);
+
+    if (benchmark_->IsDone()) {
+        FinishBenchmark(std::string());
+    } else if (warmingUp && benchmark_->IsMeasuring() && slideRenderer_) {
+        slideRenderer_->GetPipelineStats().Reset();  // Stage timings of the measured pass only
+    }
+}
+
+void Application::FinishBenchmark(const std::string& error) {
+    using json = pathview::ipc::json;
+    running_ = false;
+    if (!error.empty() || !benchmark_) {
+        PATHVIEW_LOG_ERROR("Benchmark failed: " << error);
+        benchmarkFailed_ = true;
+        benchmark_.reset();
+        return;
+    }
+
+    json stages = json::object();
+    if (slideRenderer_) {
+        const TilePipelineStats& stats = slideRenderer_->GetPipelineStats();
+        for (size_t i = 0; i < TilePipelineStats::STAGE_COUNT; ++i) {
+            const LatencyHistogram& histogram = stats.Get(static_cast<TileStage>(i));
+            stages[TilePipelineStats::StageName(static_cast<TileStage>(i))] = {
+                {"count", histogram.GetCount()},
+                {"p50_ms", histogram.GetPercentile(0.50) / 1000.0},
+                {"p99_ms", histogram.GetPercentile(0.99) / 1000.0}
+            };
+        }
+    }
+    SDL_RendererInfo rendererInfo{};
+    SDL_GetRendererInfo(renderer_, &rendererInfo);
+    const json environment = {
+        {"headless", headless_},
+        {"view_width", windowWidth_},
+        {"view_height", windowHeight_},
+        {"render_backend", renderBackend_ ? renderBackend_->GetName() : ""},
+        {"sdl_renderer", rendererInfo.name ? rendererInfo.name : ""},
+        {"decode_threads", slideRenderer_ ? slideRenderer_->GetWorkerThreadCount() : 0},
+        {"tile_cache_bytes", tileCacheTargetBytes_},
+        {"on_battery", onBattery_},
+        {"prefetch_model", prefetchModelLoaded_ ? prefetchModelPath_ : std::string()},
+        {"tile_stages", stages}
+    };
+    const json report = benchmark_->ToJson(environment);
+    const json& summary = report.at("summary");
+    PATHVIEW_LOG_INFO("Benchmark finished: " << summary.at("frames").get<size_t>() << " frames, cpu p50 "
+                      << summary.at("cpu_ms").at("p50").get<double>() << "ms p99 "
+                      << summary.at("cpu_ms").at("p99").get<double>() << "ms, time to sharp p50 "
+                      << summary.at("time_to_sharp_ms").at("p50").get<double>() << "ms over "
+                      << summary.at("stops").get<size_t>() << " stops");
+    benchmark_.reset();
+
+    const std::string& path = benchmarkOptions_->outputPath;
+    if (path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+        return;
+    }
+    std::ofstream file(path);
+    file << report.dump(2) << '\n';
+    if (!file) {
+        PATHVIEW_LOG_ERROR("Failed to write benchmark report: " << path);
+        benchmarkFailed_ = true;
+        return;
+    }
+    PATHVIEW_LOG_INFO("Wrote benchmark report to " << path);
+}
+
 bool Application::Initialize() {
+    // Headless: no display needed. Hints at normal priority, so the
+    // environment still picks another driver (EGL through "offscreen" with
+    // SDL_RENDER_DRIVER=opengles2, say)
+    if (headless_) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        onDemandRendering_ = true;  // No VSync would pace continuous rendering
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+        PATHVIEW_LOG_ERROR("Failed to initialize SDL: " << SDL_GetError());
         return false;
     }
 
+    // Event used by worker threads to wake the on-demand render loop
+    wakeEventType_ = SDL_RegisterEvents(1);
+    if (wakeEventType_ == static_cast<Uint32>(-1)) {
+        wakeEventType_ = 0;
+        onDemandRendering_ = false;  // Cannot be woken by tile loads
+    }
+    startupTimings_.Mark("SDL init");
+
     window_ = SDL_CreateWindow(
         "PathView - Digital Pathology Viewer",
         SDL_WINDOWPOS_CENTERED,
         SDL_WINDOWPOS_CENTERED,
         windowWidth_,
         windowHeight_,
-        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
+        headless_ ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
     );
 
     if (!window_) {
-        std::cerr << "Failed to create window: " << SDL_GetError() << std::endl;
+        PATHVIEW_LOG_ERROR("Failed to create window: " << SDL_GetError());
         return false;
     }
+    startupTimings_.Mark("window");
+
+#ifdef PATHVIEW_HAS_OPENGL3
+    // The OpenGL 3 tile backend runs on SDL's OpenGL renderer; at normal
+    // priority, so SDL_RENDER_DRIVER still overrides it
+    if (!headless_) {
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
+    }
+#endif
 
     // Create renderer
-    renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    renderer_ = SDL_CreateRenderer(window_, -1,
+                                   headless_ ? 0 : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer_) {
-        std::cerr << "Failed to create renderer: " << SDL_GetError() << std::endl;
+        PATHVIEW_LOG_ERROR("Failed to create renderer: " << SDL_GetError());
         return false;
     }
 
@@ -125,20 +682,168 @@ bool Application::Initialize() {
     int drawableWidth, drawableHeight;
     SDL_GetRendererOutputSize(renderer_, &drawableWidth, &drawableHeight);
     dpiScale_ = static_cast<float>(drawableWidth) / static_cast<float>(windowWidth_);
-    std::cout << "DPI Scale: " << dpiScale_ << " (drawable: " << drawableWidth << "x" << drawableHeight
-              << ", window: " << windowWidth_ << "x" << windowHeight_ << ")" << std::endl;
+    PATHVIEW_LOG_INFO("DPI Scale: " << dpiScale_ << " (drawable: " << drawableWidth << "x" << drawableHeight
+                      << ", window: " << windowWidth_ << "x" << windowHeight_ << ")");
 
     // Set render scale for high-DPI support
     // This makes SDL scale all rendering operations from logical to native resolution
     // Combined with fonts loaded at native resolution, this gives crisp text
     SDL_RenderSetScale(renderer_, dpiScale_, dpiScale_);
+    startupTimings_.Mark("renderer");
+
+    if (!headless_) {
+        if (!InitializeImGui()) {
+            return false;
+        }
+        startupTimings_.Mark("ImGui context");
+    }
+
+    // Create texture manager on the best tile backend for the renderer
+    renderBackend_ = RenderBackend::Create(renderer_);
+    textureManager_ = std::make_unique<TextureManager>(renderBackend_.get(), TEXTURE_CACHE_MAX_MEMORY);
+    SetTextureCompression(textureCompression_);
+    startupTimings_.Mark("texture manager");
+
+    // Create the first polygon layer
+    polygonLayers_.push_back({std::make_unique<PolygonOverlay>(renderer_), std::string()});
+    polygonOverlay_ = polygonLayers_.front().overlay.get();
+    polygonOverlay_->SetProfiler(&frameProfiler_);
+    polygonOverlay_->SetTileReadyCallback([this]() {
+        overlayTileWakes_++;
+        PostWakeEvent();
+    });
+    heatmapLayer_ = std::make_unique<HeatmapLayer>(renderer_);
+    heatmapLayer_->SetTileReadyCallback([this]() { PostWakeEvent(); });
+
+    // Create annotation manager
+    annotationManager_ = std::make_unique<AnnotationManager>(renderer_);
+    startupTimings_.Mark("overlays, annotations");
+
+    RegisterMemoryAccounting();
+
+    // Create IPC server for remote control; its I/O thread wakes the loop
+    // when requests arrive, finished jobs to send their responses
+    commandExecutor_ = std::make_unique<pathview::ipc::CommandExecutor>(0, [this]() { PostWakeEvent(); });
+    renderExecutor_ = std::make_unique<pathview::ipc::CommandExecutor>(0, [this]() { PostWakeEvent(); });
+    ipcServer_ = std::make_unique<pathview::ipc::IPCServer>(
+        [this](const std::string& method, const pathview::ipc::json& params) {
+            // Time on this thread only: a deferred command's worker part is not counted
+            const auto start = std::chrono::steady_clock::now();
+            auto observe = [&]() {
+                metrics_->Histogram("pathview_ipc_request_seconds",
+                                    "Time IPC commands held the GUI thread",
+                                    pathview::http::Metrics::LatencyBounds(), "method", method)
+                    .Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            };
+            try {
+                pathview::ipc::json result = HandleIPCCommand(method, params);
+                observe();
+                return result;
+            } catch (...) {
+                observe();
+                throw;
+            }
+        }
+    );
+    if (ipcMaxClients_ > 0) {
+        ipcServer_->SetMaxClients(ipcMaxClients_);
+    }
+    if (ipcRateLimit_ >= 0.0) {
+        ipcServer_->SetRateLimit(pathview::ipc::RequestPriority::Normal, {ipcRateLimit_, ipcRateLimit_});
+    }
+    if (ipcFrameBudgetMs_ >= 0.0) {
+        ipcServer_->SetFrameBudget(std::chrono::microseconds(static_cast<int64_t>(ipcFrameBudgetMs_ * 1000.0)));
+    }
+    if (ipcSocketPath_) {
+        ipcServer_->SetSocketPath(*ipcSocketPath_);
+    }
+    ipcServer_->SetRequestCallback([this]() { PostWakeEvent(); });
+    eventSubscriptions_ = std::make_unique<pathview::ipc::EventSubscriptions>();
+
+    tileService_ = std::make_unique<TileService>();
+    cellTileService_ = std::make_unique<CellTileService>();
+    startupTimings_.Mark("IPC, tile services");
+
+    // Listeners, fonts and the session wait for the first frame
+    // (FinishStartup)
+    RequestRedraw();
+
+    PATHVIEW_LOG_INFO("PathView initialized successfully" << (headless_ ? " (headless)" : ""));
+    running_ = true;
+    return true;
+}
 
-    // Initialize ImGui
+void Application::FinishStartup() {
+    startupFinished_ = true;
+    startupTimings_.MarkFirstFrame();
+
+    // The next frame draws the UI
+    if (!headless_) {
+        LoadFonts();
+        uiReady_ = true;
+        startupTimings_.Mark("fonts");
+    }
+
+    if (!ipcServer_->Start()) {
+        PATHVIEW_LOG_WARNING("Warning: Failed to start IPC server (non-fatal)");
+        // Non-fatal - GUI works without IPC
+    } else {
+        // Set disconnect callback for lock auto-release
+        ipcServer_->SetDisconnectCallback([this](socket_t clientFd) {
+            eventSubscriptions_->RemoveClient(clientFd);
+            if (navLock_->IsLocked() && navLock_->GetClientFd() == clientFd) {
+                PATHVIEW_LOG_INFO("IPC client disconnected, releasing navigation lock for owner: "
+                                  << navLock_->GetOwnerUUID());
+                navLock_->Reset();
+            }
+        });
+    }
+    startupTimings_.Mark("IPC listener");
+
+    if (tileServerPort_ > 0) {
+        StartTileServer();
+        startupTimings_.Mark("tile server");
+    }
+
+    if (benchmarkOptions_) {
+        LoadSlide(benchmarkOptions_->slidePath);
+        startupTimings_.Mark("benchmark slide");
+    } else {
+        RestoreSession();
+        startupTimings_.Mark("session restore");
+    }
+    RequestRedraw();
+
+    PATHVIEW_LOG_INFO("First frame after " << static_cast<int>(startupTimings_.GetFirstFrameMs()) << " ms");
+    if (printStartupTimings_) {
+        std::cout << startupTimings_.Format() << std::flush;
+    }
+}
+
+bool Application::InitializeImGui() {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
+    UIStyle::ApplyStyle();
+
+    // Initialize ImGui backends
+    if (!ImGui_ImplSDL2_InitForSDLRenderer(window_, renderer_)) {
+        PATHVIEW_LOG_ERROR("Failed to initialize ImGui SDL2 backend");
+        return false;
+    }
+
+    if (!ImGui_ImplSDLRenderer2_Init(renderer_)) {
+        PATHVIEW_LOG_ERROR("Failed to initialize ImGui SDL Renderer backend");
+        return false;
+    }
+
+    return true;
+}
+
+void Application::LoadFonts() {
+    ImGuiIO& io = ImGui::GetIO();
     std::string fontPath = std::string(RESOURCES_DIR) + "/fonts/";
     ImFontConfig config;
     config.OversampleH = 2;
@@ -169,73 +874,138 @@ bool Application::Initialize() {
     // Set font global scale to compensate (ImGui works in logical coordinates)
     // This makes fonts render at native resolution but display at correct logical size
     io.FontGlobalScale = 1.0f / dpiScale_;
+}
 
-    UIStyle::ApplyStyle();
-
-    // Initialize ImGui backends
-    if (!ImGui_ImplSDL2_InitForSDLRenderer(window_, renderer_)) {
-        std::cerr << "Failed to initialize ImGui SDL2 backend" << std::endl;
-        return false;
-    }
+void Application::Run() {
+    lastFrameTime_ = SDL_GetTicks();
 
-    if (!ImGui_ImplSDLRenderer2_Init(renderer_)) {
-        std::cerr << "Failed to initialize ImGui SDL Renderer backend" << std::endl;
-        return false;
-    }
+    while (running_) {
+        // Sleep while nothing on screen would change
+        if (onDemandRendering_ && !NeedsRedraw()) {
+            WaitForActivity();
+        }
 
-    // Create texture manager
-    textureManager_ = std::make_unique<TextureManager>(renderer_);
+        // Calculate delta time
+        uint32_t currentTime = SDL_GetTicks();
+        deltaTime_ = (currentTime - lastFrameTime_) / 1000.0;
+        lastFrameTime_ = currentTime;
 
-    // Create polygon overlay
-    polygonOverlay_ = std::make_unique<PolygonOverlay>(renderer_);
+        // Cap delta time to prevent huge jumps
+        if (deltaTime_ > 0.1) {
+            deltaTime_ = 0.1;
+        }
 
-    // Create annotation manager
-    annotationManager_ = std::make_unique<AnnotationManager>(renderer_);
+        ProcessEvents();
 
-    // Create IPC server for remote control
-    ipcServer_ = std::make_unique<pathview::ipc::IPCServer>(
-        [this](const std::string& method, const pathview::ipc::json& params) {
-            return HandleIPCCommand(method, params);
+        // Woken only to poll IPC, and nothing arrived
+        if (onDemandRendering_ && !NeedsRedraw()) {
+            continue;
         }
-    );
 
-    if (!ipcServer_->Start()) {
-        std::cerr << "Warning: Failed to start IPC server (non-fatal)" << std::endl;
-        // Non-fatal - GUI works without IPC
-    } else {
-        // Set disconnect callback for lock auto-release
-        ipcServer_->SetDisconnectCallback([this](socket_t clientFd) {
-            if (navLock_->IsLocked() && navLock_->GetClientFd() == clientFd) {
-                std::cout << "IPC client disconnected, releasing navigation lock for owner: "
-                          << navLock_->GetOwnerUUID() << std::endl;
-                navLock_->Reset();
-            }
-        });
+        frameProfiler_.BeginFrame();
+        const auto frameStart = std::chrono::steady_clock::now();
+        Update();
+        Render();
+        const auto frameEnd = std::chrono::steady_clock::now();
+        frameSeconds_->Observe(std::chrono::duration<double>(frameEnd - frameStart).count());
+        frameProfiler_.EndFrame();
+        if (benchmark_) {
+            RecordBenchmarkFrame(frameStart, frameEnd);
+        }
+        if (!startupFinished_) {
+            FinishStartup();  // The window is on screen
+        }
+
+        lastRenderTime_ = SDL_GetTicks();
+        if (redrawFrames_ > 0) {
+            redrawFrames_--;
+        }
     }
+}
 
-    std::cout << "PathView initialized successfully" << std::endl;
-    running_ = true;
-    return true;
+void Application::UpdateMinimapDensity() {
+    if (!minimap_ || !polygonOverlay_) {
+        return;
+    }
+    // Colors, visibility and loads all move the overlay's revision
+    const uint64_t revision = polygonOverlay_->GetRevision();
+    if (!minimapDensityDirty_ && revision == minimapDensityRevision_) {
+        return;
+    }
+    minimapDensityDirty_ = false;
+    minimapDensityRevision_ = revision;
+
+    const bool hadDensity = minimap_->HasDensity();
+    std::vector<uint32_t> pixels;
+    if (minimapDensity_ &&
+        polygonOverlay_->RenderDensityOverview(minimap_->GetOverviewWidth(), minimap_->GetOverviewHeight(),
+                                               minimapDensityClass_, pixels)) {
+        minimap_->SetDensity(pixels);
+    } else {
+        minimap_->ClearDensity();
+    }
+    if (hadDensity || minimap_->HasDensity()) {
+        RequestRedraw();
+    }
 }
 
-void Application::Run() {
-    lastFrameTime_ = SDL_GetTicks();
+void Application::RequestRedraw() {
+    redrawFrames_ = headless_ ? 1 : REDRAW_FRAMES_AFTER_ACTIVITY;
+}
 
-    while (running_) {
-        // Calculate delta time
-        uint32_t currentTime = SDL_GetTicks();
-        deltaTime_ = (currentTime - lastFrameTime_) / 1000.0;
-        lastFrameTime_ = currentTime;
+void Application::PostWakeEvent() {
+    // One wake event in the queue at a time, however many tiles land
+    if (wakeEventType_ == 0 || wakePending_.exchange(true)) {
+        return;
+    }
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = wakeEventType_;
+    SDL_PushEvent(&event);
+}
 
-        // Cap delta time to prevent huge jumps
-        if (deltaTime_ > 0.1) {
-            deltaTime_ = 0.1;
+bool Application::NeedsRedraw() const {
+    if (redrawFrames_ > 0) {
+        return true;
+    }
+    if (viewport_ && viewport_->IsAnimating()) {
+        return true;
+    }
+    if (replayingTrace_ || benchmark_) {
+        return true;  // Every frame of a replay is measured
+    }
+    if (slideRenderer_ && slideRenderer_->HasDeferredUploads()) {
+        return true;  // Budgeted uploads still waiting for a frame
+    }
+    if (slideRenderer_ && slideRenderer_->IsMotionCoarsened()) {
+        return true;  // Drawn coarse for motion until it settles and refines
+    }
+    if (HasPendingPolygonUploads()) {
+        return true;
+    }
+    if (heatmapLayer_ && heatmapLayer_->HasPendingUploads()) {
+        return true;
+    }
+    for (const PendingCapture& capture : pendingCaptures_) {
+        if (std::chrono::steady_clock::now() >= capture.deadline) {
+            return true;  // Answered from the next frame, sharp or not
         }
+    }
+    if (!sceneReadbacks_.empty()) {
+        return true;  // Each frame checks whether the copies are done
+    }
+    // Headless nothing animates between changes
+    return !headless_ && SDL_GetTicks() - lastRenderTime_ >= IDLE_REDRAW_INTERVAL_MS;
+}
 
-        ProcessEvents();
-        Update();
-        Render();
+void Application::WaitForActivity() {
+    // Passing nullptr leaves the event queued for ProcessEvents()
+    uint32_t sinceRender = SDL_GetTicks() - lastRenderTime_;
+    uint32_t untilRepaint = sinceRender < IDLE_REDRAW_INTERVAL_MS ? IDLE_REDRAW_INTERVAL_MS - sinceRender : 0;
+    if (headless_) {
+        untilRepaint = IDLE_WAIT_MS;
     }
+    SDL_WaitEventTimeout(nullptr, static_cast<int>(std::min(IDLE_WAIT_MS, untilRepaint)));
 }
 
 void Application::Shutdown() {
@@ -243,14 +1013,55 @@ void Application::Shutdown() {
         return;
     }
 
+    // While the slide and its view are still open; not before the session
+    // was restored, which would save an empty one over it
+    if (startupFinished_) {
+        SaveSession();
+    }
+
+    // Captures still reading back get their pixels while the backend and
+    // the executor are there
+    FinishSceneReadbacks(true);
+
     // Stop IPC server first
     ipcServer_.reset();
-
+    eventSubscriptions_.reset();
+    if (tileService_) {
+        tileService_->ClearSlide();  // Region renders waiting for tiles give up
+    }
+    regionScans_.clear();
+    if (regionExport_) {
+        CancelRegionExport();
+        regionExport_->thread.join();
+        regionExport_.reset();
+    }
+    renderExecutor_.reset();
+    commandExecutor_.reset();
+    StopTileServer();
+    tileService_.reset();
+    cellTileService_.reset();
+
+    StopTraceRecording();
+
+    slideOpenTask_.reset();
+    preload_.reset();
+    slideLibrary_.reset();  // Waits for the thumbnails being made
+    ClearLibraryTextures();
     annotationManager_.reset();
-    polygonOverlay_.reset();
+    annotationJournal_.reset();  // Writes what is still queued
+    StopPolygonReaders();
+    polygonOverlay_ = nullptr;
+    polygonLayers_.clear();
+    heatmapLayer_.reset();
     minimap_.reset();
+    channelCompositor_.reset();
     slideRenderer_.reset();
+    diskTileCache_.reset();
+    retiringSlides_.clear();  // Waits for what they still decode
+    decodePool_.reset();
+    tileCache_.reset();
     textureManager_.reset();
+    renderBackend_.reset();
     viewport_.reset();
     slideLoader_.reset();
 
@@ -258,6 +1069,18 @@ void Application::Shutdown() {
         SDL_DestroyTexture(previewTexture_);
         previewTexture_ = nullptr;
     }
+    for (SDL_Texture** texture : {&sceneTexture_, &sceneSpareTexture_}) {
+        if (*texture) {
+            SDL_DestroyTexture(*texture);
+            *texture = nullptr;
+        }
+    }
+    for (DownscaleTexture& downscale : downscaleTextures_) {
+        if (downscale.texture) {
+            SDL_DestroyTexture(downscale.texture);
+        }
+    }
+    downscaleTextures_.clear();
 
     // Cleanup ImGui (must happen while renderer is still valid)
     if (ImGui::GetCurrentContext()) {
@@ -280,9 +1103,120 @@ void Application::Shutdown() {
     SDL_Quit();
 }
 
+void Application::StartTileServer() {
+    tileServer_ = std::make_unique<pathview::http::HTTPServer>(tileServerPort_, nullptr);
+    tileServer_->SetHost(tileServerHost_);
+    tileServer_->SetTileService(tileService_.get());
+    tileServer_->SetCellTileService(cellTileService_.get());
+    tileServer_->SetMetrics(metrics_.get());
+    tileServerThread_ = std::thread([this]() { tileServer_->Start(); });
+    PATHVIEW_LOG_INFO("Live view at http://" << tileServerHost_ << ":" << tileServerPort_ << "/stream");
+}
+
+void Application::StopTileServer() {
+    if (!tileServer_) {
+        return;
+    }
+    tileService_->ClearSlide();  // Wakes requests waiting for tiles
+    tileServer_->Stop();
+    if (tileServerThread_.joinable()) {
+        tileServerThread_.join();
+    }
+    tileServer_.reset();
+}
+
+void Application::ServeCurrentSlide() {
+    if (!tileService_ || !slideRenderer_) {
+        return;
+    }
+    TileServiceSlide slide;
+    slide.id = TileService::MakeSlideId(currentSlidePath_);
+    slide.width = slideLoader_->GetWidth();
+    slide.height = slideLoader_->GetHeight();
+    slide.pyramid = slideRenderer_->GetPyramid();
+    // The hooks run on HTTP threads; ClearSlide() waits them out before the
+    // renderer goes away
+    SlideRenderer* renderer = slideRenderer_.get();
+    slide.getTile = [renderer](const TileKey& key) { return renderer->GetCachedTile(key); };
+    slide.requestTile = [renderer](const TileKey& key) {
+        renderer->RequestTile(key, TileLoadPriority::VISIBLE);
+    };
+    if (tileServer_) {
+        PATHVIEW_LOG_INFO("Serving tiles at http://" << tileServerHost_ << ":" << tileServerPort_
+                          << "/slides/" << slide.id << "/dzi");
+    }
+    tileService_->SetSlide(std::move(slide));
+}
+
+void Application::ServeCurrentCells() {
+    if (!cellTileService_ || !slideLoader_ || !polygonOverlay_ || polygonOverlay_->IsLoading() ||
+        !polygonOverlay_->GetSpatialIndex() || polygonOverlay_->GetPolygonCount() == 0) {
+        return;
+    }
+    CellTileSource cells;
+    cells.slideId = TileService::MakeSlideId(currentSlidePath_);
+    cells.width = slideLoader_->GetWidth();
+    cells.height = slideLoader_->GetHeight();
+    cells.polygons = &polygonOverlay_->GetPolygons();
+    cells.index = polygonOverlay_->GetSpatialIndex();
+    for (int classId : polygonOverlay_->GetClassIds()) {
+        cells.classNames[classId] = polygonOverlay_->GetClassName(classId);
+    }
+    cells.lod = polygonOverlay_->GetLod();
+    if (tileServer_) {
+        PATHVIEW_LOG_INFO("Serving cells at http://" << tileServerHost_ << ":" << tileServerPort_
+                          << "/slides/" << cells.slideId << "/cells/{level}/{x}_{y}.mvt");
+    }
+    cellTileService_->SetSource(std::move(cells));
+    cellsServed_ = true;
+}
+
+void Application::ApplyCoalescedInput() {
+    if (input_.Empty()) {
+        return;
+    }
+    const InputCoalescer::Frame frame = input_.Take();
+    if (!viewport_) {
+        return;
+    }
+    if (frame.HasPan()) {
+        // Negative: dragging the slide right moves the view left
+        viewport_->Pan(Vec2(-frame.panX / viewport_->GetZoom(), -frame.panY / viewport_->GetZoom()));
+    }
+    if (frame.wheel != 0.0) {
+        viewport_->ZoomAtPoint(Vec2(frame.wheelX, frame.wheelY), InputCoalescer::ZoomFactor(frame.wheel));
+    }
+    if (frame.moved && annotationManager_) {
+        annotationManager_->UpdateMousePosition(viewport_->ScreenToSlide(Vec2(frame.cursorX, frame.cursorY)));
+    }
+}
+
 void Application::ProcessEvents() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
+        // Any input may change what is on screen
+        RequestRedraw();
+
+        // Worker wake-ups carry no payload beyond the redraw request
+        if (wakeEventType_ != 0 && event.type == wakeEventType_) {
+            wakePending_.store(false);
+            continue;
+        }
+
+        // Headless there is no input; SDL turns SIGINT / SIGTERM into quit
+        if (headless_) {
+            if (event.type == SDL_QUIT) {
+                running_ = false;
+            }
+            continue;
+        }
+
+        // Motion and wheel steps are summed over the frame; anything else
+        // sees the view they have moved first
+        if (event.type != SDL_MOUSEMOTION && event.type != SDL_MOUSEWHEEL) {
+            ApplyCoalescedInput();
+        }
+
         // Let ImGui handle events first
         ImGui_ImplSDL2_ProcessEvent(&event);
 
@@ -294,9 +1228,7 @@ void Application::ProcessEvents() {
             if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
                 windowWidth_ = event.window.data1;
                 windowHeight_ = event.window.data2;
-                if (viewport_) {
-                    viewport_->SetWindowSize(windowWidth_, windowHeight_);
-                }
+                LayoutViews();
                 if (minimap_) {
                     int minimapHeight = std::max(0, windowHeight_ - static_cast<int>(STATUS_BAR_HEIGHT));
                     minimap_->SetWindowSize(windowWidth_, minimapHeight);
@@ -320,13 +1252,22 @@ void Application::ProcessEvents() {
 
             // Handle annotation tool keyboard shortcuts
             if (annotationManager_) {
-                annotationManager_->HandleKeyPress(event.key.keysym.sym, polygonOverlay_.get());
+                annotationManager_->HandleKeyPress(event.key.keysym.sym, polygonOverlay_);
             }
 
             // Handle keyboard shortcuts
             if (event.key.keysym.sym == SDLK_r && viewport_) {
                 viewport_->ResetView();
             }
+            if (event.key.keysym.sym == SDLK_F3 && event.key.repeat == 0) {
+                profilerVisible_ = !profilerVisible_;
+            }
+            if (event.key.keysym.sym == SDLK_PAGEDOWN && event.key.repeat == 0) {
+                OpenWorklistEntry(worklist_.GetNextIndex());
+            }
+            if (event.key.keysym.sym == SDLK_PAGEUP && event.key.repeat == 0) {
+                OpenWorklistEntry(worklist_.GetPreviousIndex());
+            }
 
             const SDL_Keymod mods = SDL_GetModState();
             bool shortcutMod = (mods & (KMOD_CTRL | KMOD_GUI)) != 0;
@@ -368,7 +1309,7 @@ void Application::ProcessEvents() {
                     annotationManager_->HandleClick(event.button.x, event.button.y,
                                                     event.button.clicks == 2,
                                                     *viewport_, minimap_.get(),
-                                                    polygonOverlay_.get());
+                                                    polygonOverlay_);
                     continue;  // Don't process panning
                 }
             }
@@ -383,58 +1324,231 @@ void Application::ProcessEvents() {
                         isPanning_ = true;
                         lastMouseX_ = event.button.x;
                         lastMouseY_ = event.button.y;
+                        pressMouseX_ = event.button.x;
+                        pressMouseY_ = event.button.y;
                     }
                 }
             }
             else if (event.type == SDL_MOUSEBUTTONUP) {
                 if (event.button.button == SDL_BUTTON_LEFT || event.button.button == SDL_BUTTON_RIGHT) {
+                    // A left click that did not pan selects the cell under it
+                    // (or clears the selection)
+                    if (isPanning_ && event.button.button == SDL_BUTTON_LEFT && event.button.x == pressMouseX_ &&
+                        event.button.y == pressMouseY_ && viewport_ && polygonOverlay_ &&
+                        polygonOverlay_->IsVisible()) {
+                        selectedPolygon_ = polygonOverlay_->PickPolygon(
+                            viewport_->ScreenToSlide(Vec2(event.button.x, event.button.y)));
+                    }
                     isPanning_ = false;
                 }
             }
             else if (event.type == SDL_MOUSEMOTION && isPanning_ && viewport_) {
-                // Pan: calculate delta in screen space, convert to slide space
-                int deltaX = event.motion.x - lastMouseX_;
-                int deltaY = event.motion.y - lastMouseY_;
-
-                // Convert screen delta to slide delta (negative because we're moving the viewport)
-                Vec2 slideDelta(-deltaX / viewport_->GetZoom(), -deltaY / viewport_->GetZoom());
-                viewport_->Pan(slideDelta);
-
+                // Pan by the screen delta, applied once per frame
+                input_.AddPan(event.motion.x - lastMouseX_, event.motion.y - lastMouseY_);
                 lastMouseX_ = event.motion.x;
                 lastMouseY_ = event.motion.y;
             }
             else if (event.type == SDL_MOUSEWHEEL && viewport_) {
-                // Zoom at cursor position
+                // Zoom at the cursor; precise wheels and trackpads send fractions of a step
                 int mouseX, mouseY;
                 SDL_GetMouseState(&mouseX, &mouseY);
-
-                double zoomFactor = (event.wheel.y > 0) ? 1.1 : 0.9;
-                viewport_->ZoomAtPoint(Vec2(mouseX, mouseY), zoomFactor);
+                input_.AddWheel(event.wheel.preciseY, mouseX, mouseY);
             }
         }
 
         // Track mouse position for drawing preview
-        if (event.type == SDL_MOUSEMOTION && viewport_ && annotationManager_) {
-            int mouseX, mouseY;
-            SDL_GetMouseState(&mouseX, &mouseY);
-            annotationManager_->UpdateMousePosition(viewport_->ScreenToSlide(Vec2(mouseX, mouseY)));
+        if (event.type == SDL_MOUSEMOTION) {
+            input_.AddMotion(event.motion.x, event.motion.y);
         }
     }
+    ApplyCoalescedInput();
 
     // Check if navigation lock has expired
     CheckLockExpiry();
 
-    // Process IPC messages (non-blocking, max 10ms per frame for 60 FPS)
+    // Handle IPC requests the server's I/O thread has queued (it wakes an
+    // idle loop when they arrive, so there is nothing to wait for here)
+    if (ipcServer_ && ipcServer_->ProcessMessages(0)) {
+        InvalidateScene();  // Commands may change anything drawn
+        RequestRedraw();
+    }
+
+    PumpViewerEvents();
+    UpdateMetrics();
+}
+
+void Application::PumpViewerEvents() {
+    using pathview::ipc::EventType;
+    if (!eventSubscriptions_) {
+        return;
+    }
+
+    // Compared every loop (at least every IDLE_WAIT_MS); only changes are
+    // posted, and EventSubscriptions coalesces them per subscriber. The tile
+    // server's /events gets them too.
+    auto post = [this](EventType type, const pathview::ipc::json& payload) {
+        eventSubscriptions_->Post(type, payload);
+        if (tileServer_) {
+            tileServer_->GetEventStream().Publish(pathview::ipc::EventTypeName(type), payload.dump());
+        }
+    };
+    if (viewport_) {
+        const Vec2 position = viewport_->GetPosition();
+        const double zoom = viewport_->GetZoom();
+        const bool moving = viewport_->IsAnimating();
+        if (position.x != reportedState_.x || position.y != reportedState_.y ||
+            zoom != reportedState_.zoom || moving != reportedState_.moving) {
+            reportedState_.x = position.x;
+            reportedState_.y = position.y;
+            reportedState_.zoom = zoom;
+            reportedState_.moving = moving;
+            post(EventType::Viewport, {
+                {"position", {{"x", position.x}, {"y", position.y}}},
+                {"zoom", zoom},
+                {"moving", moving},
+                {"window_width", windowWidth_},
+                {"window_height", windowHeight_}
+            });
+        }
+
+        // Sharp, and nothing left to load
+        const bool settled = slideRenderer_ && IsViewSharp() && slideRenderer_->GetPendingTileCount() == 0;
+        if (settled != reportedState_.tilesSettled) {
+            reportedState_.tilesSettled = settled;
+            if (settled) {
+                post(EventType::TilesSettled, {
+                    {"position", {{"x", position.x}, {"y", position.y}}},
+                    {"zoom", zoom}
+                });
+            }
+        }
+    }
+
+    if (annotationManager_ && annotationManager_->GetRevision() != reportedState_.annotationRevision) {
+        reportedState_.annotationRevision = annotationManager_->GetRevision();
+        post(EventType::Annotations, {
+            {"revision", reportedState_.annotationRevision},
+            {"count", annotationManager_->GetAnnotations().size()}
+        });
+    }
+
+    if (!ipcServer_) {
+        return;
+    }
+    for (auto& event : eventSubscriptions_->TakeDue(std::chrono::steady_clock::now())) {
+        ipcServer_->Notify(event.clientFd, std::string("event.") + pathview::ipc::EventTypeName(event.type),
+                           event.payload);
+    }
+}
+
+void Application::UpdateMetrics() {
+    // Counters the render thread keeps anyway, copied into the registry
+    // once a second; a scrape reads only the registry
+    const auto now = std::chrono::steady_clock::now();
+    if (now - metricsUpdated_ < std::chrono::milliseconds(METRICS_INTERVAL_MS)) {
+        return;
+    }
+    metricsUpdated_ = now;
+    pathview::http::Metrics& metrics = *metrics_;
+
+    if (tileCache_) {
+        metrics.Gauge("pathview_tile_cache_hit_ratio", "Tile cache hits over lookups").Set(tileCache_->GetHitRate());
+        metrics.Gauge("pathview_tile_cache_bytes", "Decoded tile bytes cached")
+            .Set(static_cast<double>(tileCache_->GetMemoryUsage()));
+        metrics.Gauge("pathview_tile_cache_max_bytes", "Tile cache limit")
+            .Set(static_cast<double>(tileCache_->GetMaxMemory()));
+        metrics.Gauge("pathview_tile_cache_tiles", "Tiles cached")
+            .Set(static_cast<double>(tileCache_->GetTileCount()));
+        // Set, not added: the cache keeps the running total
+        metrics.Counter("pathview_tile_cache_evictions_total", "Tiles evicted from the cache")
+            .Set(static_cast<double>(tileCache_->GetEvictionCount()));
+    }
+    if (slideRenderer_) {
+        metrics.Gauge("pathview_tile_queue_depth", "Tiles requested and not yet loaded")
+            .Set(static_cast<double>(slideRenderer_->GetPendingTileCount()));
+        const TilePipelineStats& stats = slideRenderer_->GetPipelineStats();
+        for (size_t i = 0; i < TilePipelineStats::STAGE_COUNT; ++i) {
+            const TileStage stage = static_cast<TileStage>(i);
+            ExportLatency(stats.Get(stage),
+                          metrics.Histogram("pathview_tile_stage_seconds", "Tile pipeline stage latency, this slide",
+                                            pathview::http::Metrics::LatencyBounds(),
+                                            "stage", TilePipelineStats::StageName(stage)));
+        }
+    }
+
     if (ipcServer_) {
-        ipcServer_->ProcessMessages(10);
+        const pathview::ipc::IPCServer::Stats stats = ipcServer_->GetStats();
+        metrics.Gauge("pathview_ipc_queued_requests", "IPC requests received, not yet handled")
+            .Set(static_cast<double>(stats.queued));
+        metrics.Counter("pathview_ipc_throttled_requests_total", "IPC requests a rate limit held back")
+            .Set(static_cast<double>(stats.throttled));
+        metrics.Counter("pathview_ipc_executed_requests_total", "IPC requests handled")
+            .Set(static_cast<double>(stats.executed));
+    }
+
+    for (const MemoryRegistry::Entry& entry : memoryRegistry_.GetEntries()) {
+        metrics.Gauge("pathview_memory_bytes", "Accounted live bytes per subsystem", "subsystem", entry.name)
+            .Set(static_cast<double>(entry.liveBytes));
+    }
+    metrics.Gauge("pathview_memory_budget_bytes", "Accounted memory budget, 0 for none")
+        .Set(static_cast<double>(memoryRegistry_.GetBudget()));
+    metrics.Gauge("pathview_process_resident_bytes", "Resident set size")
+        .Set(static_cast<double>(MemoryRegistry::GetProcessResidentBytes()));
+
+    // pathview-mcp subscribes and serves them at its own /metrics
+    if (eventSubscriptions_ && eventSubscriptions_->HasSubscribers(pathview::ipc::EventType::Metrics)) {
+        eventSubscriptions_->Post(pathview::ipc::EventType::Metrics, {{"text", metrics.Render()}});
     }
 }
 
 void Application::Update() {
+    ProfileZone zone(&frameProfiler_, "Update");
+
+    PollSlideOpen();
+    ReapRetiringSlides();
+    UpdateWorklistPreload();
+    UpdateLibraryTextures();
+    UpdateRegionExport();
+    for (PolygonLayer& layer : polygonLayers_) {
+        if (layer.overlay->UpdateLoading(viewport_.get())) {
+            RequestRedraw();
+        }
+    }
+    UpdateTissueMask();
+    if (polygonLoadReply_ && !polygonOverlay_->IsLoading()) {
+        polygonLoadReply_->set_value(pathview::ipc::json{
+            {"count", polygonOverlay_->GetPolygonCount()},
+            {"classes", polygonOverlay_->GetClassIds()},
+            {"layer", activePolygonLayer_}
+        });
+        polygonLoadReply_.reset();
+    }
+    if (!cellsServed_) {
+        ServeCurrentCells();
+    }
+    UpdateSessionWarmup();
+    memoryRegistry_.Update();
+    UpdateMemoryPressure();
+    UpdatePowerSource();
+
+    // Thumbnail minimaps are redrawn from the pyramid once its tiles are in
+    if (minimap_ && slideRenderer_ && minimap_->Refine(*slideRenderer_)) {
+        minimapDensityDirty_ = true;
+        RequestRedraw();
+    }
+    UpdateMinimapDensity();
+
     // Update viewport animation
     if (viewport_) {
         double currentTimeMs = static_cast<double>(SDL_GetTicks());
         viewport_->UpdateAnimation(currentTimeMs);
+        ApplyTraceReplay();
+        UpdateViewportPlan();
+        if (benchmark_) {
+            benchmark_->BeginFrame(std::chrono::steady_clock::now());
+            ShowTraceSample(benchmark_->GetSample());
+        }
+        RecordTraceSample();
 
         // Track animation completion for tokens
         for (auto& [key, token] : activeAnimations_) {
@@ -462,121 +1576,695 @@ void Application::Update() {
     }
 }
 
-void Application::Render() {
-    // Start ImGui frame
-    ImGui_ImplSDLRenderer2_NewFrame();
-    ImGui_ImplSDL2_NewFrame();
-    ImGui::NewFrame();
+void Application::UpdateViewportPlan() {
+    if (!slideRenderer_) {
+        return;
+    }
+    if (viewportPlan_.GetWaypoints().empty()) {
+        UpdatePredictedViews();
+    } else {
+        // A move in progress has reached its target as far as the plan
+        // goes: the renderer's own prefetch follows the animation there
+        const Rect target = viewport_->GetTargetVisibleRegion();
+        const Vec2 center(target.x + target.width / 2, target.y + target.height / 2);
+        if (viewportPlan_.Update(center, viewport_->GetTargetZoom(), viewport_->GetWindowWidth(),
+                                 viewport_->GetWindowHeight())) {
+            slideRenderer_->SetPlannedViews(viewportPlan_.GetUpcoming());
+        }
+    }
+    slideRenderer_->PrefetchPlannedViews(*viewport_);
+}
 
-    // Build UI
-    RenderUI();
+void Application::UpdatePredictedViews() {
+    if (!prefetchModelLoaded_) {
+        return;
+    }
+    // Predictions hold only for the stop they were made on: while the view
+    // moves, the renderer's velocity prefetch has more to go on
+    const Rect view = viewport_->GetVisibleRegion();
+    const bool moved = viewport_->IsAnimating() || view.x != lastPredictionView_.x ||
+                       view.y != lastPredictionView_.y || view.width != lastPredictionView_.width ||
+                       view.height != lastPredictionView_.height;
+    lastPredictionView_ = view;
+    if (moved) {
+        if (predictedViews_) {
+            slideRenderer_->SetPlannedViews({});
+            predictedViews_ = false;
+        }
+        return;
+    }
+    if (predictedViews_) {
+        return;
+    }
 
-    // Clear screen
-    SDL_SetRenderDrawColor(renderer_, 32, 32, 32, 255);
-    SDL_RenderClear(renderer_);
+    std::vector<ViewportWaypoint> views;
+    for (const PrefetchModel::Prediction& prediction :
+         prefetchModel_.Predict(Vec2(view.x + view.width / 2, view.y + view.height / 2), viewport_->GetZoom(),
+                                viewport_->GetWindowWidth(), viewport_->GetWindowHeight())) {
+        views.push_back(prediction.view);
+    }
+    slideRenderer_->SetPlannedViews(std::move(views));
+    predictedViews_ = true;
+}
 
-    // Render slide using viewport and renderer
-    if (slideLoader_ && viewport_ && slideRenderer_) {
-        slideRenderer_->Render(*viewport_);
+void Application::LoadPrefetchModel(const SlideMetadata& metadata) {
+    prefetchModelLoaded_ = false;
+    predictedViews_ = false;
+    if (prefetchModelPath_.empty()) {
+        return;
     }
-    // Fallback to preview for slides loaded in Phase 2 without viewport
-    else if (slideLoader_ && previewTexture_) {
-        RenderSlidePreview();
+    const std::string type = PrefetchModel::SlideType(metadata.vendor, metadata.objectivePower);
+    prefetchModel_ = PrefetchModel();
+    if (!prefetchModel_.Load(prefetchModelPath_, type) || prefetchModel_.IsEmpty()) {
+        PATHVIEW_LOG_WARNING("No prefetch model for " << type << " slides in " << prefetchModelPath_);
+        return;
     }
+    prefetchModelLoaded_ = true;
+    PATHVIEW_LOG_INFO("Prefetch model for " << type << " slides: " << prefetchModel_.GetTransitionCount()
+                      << " transitions");
+}
 
-    // Render polygon overlays
-    if (polygonOverlay_ && viewport_ && polygonOverlay_->IsVisible()) {
-        polygonOverlay_->Render(*viewport_);
-    }
+void Application::Render() {
+    if (uiReady_) {
+        ProfileZone zone(&frameProfiler_, "UI");
 
-    // Render annotation polygons
-    if (annotationManager_ && viewport_) {
-        annotationManager_->RenderAnnotations(*viewport_);
+        // Start ImGui frame
+        ImGui_ImplSDLRenderer2_NewFrame();
+        ImGui_ImplSDL2_NewFrame();
+        ImGui::NewFrame();
 
-        // Render in-progress polygon drawing
-        if (annotationManager_->IsDrawing()) {
-            annotationManager_->RenderDrawingPreview(*viewport_);
+        // Build UI
+        RenderUI();
+    }
+
+    // Slide and overlay layers, redrawn only when the scene changed
+    if (!EnsureSceneTexture()) {
+        RenderScene();
+    } else {
+        const SceneKey key = MakeSceneKey();
+        int shiftX = 0;
+        int shiftY = 0;
+        if (sceneValid_ && key == sceneKey_) {
+            sceneReuses_++;
+        } else if (GetSceneShift(key, &shiftX, &shiftY) && ScrollScene(shiftX, shiftY)) {
+            sceneKey_ = key;
+            sceneScrolls_++;
+        } else {
+            SDL_SetRenderTarget(renderer_, sceneTexture_);
+            SDL_RenderSetScale(renderer_, dpiScale_, dpiScale_);  // Targets start unscaled
+            RenderScene();
+            SDL_SetRenderTarget(renderer_, nullptr);
+            sceneKey_ = key;
+            sceneValid_ = IsSceneFinal();
+            sceneRedraws_++;
         }
+        SDL_RenderCopy(renderer_, sceneTexture_, nullptr, nullptr);
     }
 
-    // Render minimap overlay
+    // In-progress polygon drawing follows the mouse over the cached scene
+    if (annotationManager_ && viewport_ && annotationManager_->IsDrawing()) {
+        annotationManager_->RenderDrawingPreview(*viewport_);
+    }
+
+    // Render minimap overlay (none headless)
     if (slideLoader_ && viewport_ && minimap_) {
+        ProfileZone zone(&frameProfiler_, "Minimap");
         minimap_->Render(*viewport_, sidebarVisible_, sidebarVisible_ ? SIDEBAR_WIDTH : 0.0f);
     }
 
+    // Snapshot pixels read back since an earlier frame
+    FinishSceneReadbacks(false);
+
     // Capture screenshot if requested
     if (screenshotBuffer_->IsCaptureRequested()) {
+        ProfileZone zone(&frameProfiler_, "Screenshot");
         CaptureScreenshot();
         screenshotBuffer_->ClearCaptureRequest();
     }
 
+    // Captures waiting for a sharp frame, without the UI like the rest
+    ServicePendingCaptures();
+
+    // Live stream frame, without the UI like snapshots
+    PublishStreamFrame();
+
     // Render ImGui
-    ImGui::Render();
-    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer_);
+    if (uiReady_) {
+        ProfileZone zone(&frameProfiler_, "ImGui");
+        ImGui::Render();
+        ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer_);
+    }
+
+    // Present (waits for VSync when enabled)
+    {
+        ProfileZone zone(&frameProfiler_, "Present");
+        SDL_RenderPresent(renderer_);
+    }
 
-    // Present
-    SDL_RenderPresent(renderer_);
+    if (replayingTrace_) {
+        auto now = std::chrono::steady_clock::now();
+        if (lastReplayFrame_ != std::chrono::steady_clock::time_point{}) {
+            replayFrameTimes_.Record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - lastReplayFrame_).count()));
+        }
+        lastReplayFrame_ = now;
+    }
 }
 
-void Application::RenderUI() {
-    RenderMenuBar();
-    RenderToolbar();
-    RenderSidebar();
-    RenderWelcomeOverlay();
+bool Application::SceneKey::operator==(const SceneKey& other) const {
+    return version == other.version && renderer == other.renderer && x == other.x && y == other.y &&
+           zoom == other.zoom && width == other.width && height == other.height &&
+           compare == other.compare && polygons == other.polygons && annotations == other.annotations &&
+           channels == other.channels;
+}
 
-    // Render navigation lock indicator (overlay)
-    if (IsNavigationLocked()) {
-        RenderNavigationLockIndicator();
+Application::SceneKey Application::MakeSceneKey() const {
+    SceneKey key;
+    key.version = sceneVersion_ + overlayTileWakes_.load();
+    key.renderer = slideRenderer_.get();
+    if (viewport_) {
+        key.x = viewport_->GetPosition().x;
+        key.y = viewport_->GetPosition().y;
+        key.zoom = viewport_->GetZoom();
+        key.width = viewport_->GetWindowWidth();
+        key.height = viewport_->GetWindowHeight();
+    }
+    // The compare view follows the main one through compareLink_, which
+    // only IPC changes (a wake-up, so a new version)
+    key.compare = compareViewport_ != nullptr;
+    key.polygons = GetPolygonLayersRevision();
+    if (annotationManager_) {
+        key.annotations = annotationManager_->GetRevision();
     }
+    if (channelCompositor_) {
+        key.channels = channelCompositor_->GetRevision();
+    }
+    return key;
 }
 
-void Application::OpenFileDialog() {
-    // Initialize NFD
-    NFD::Guard nfdGuard;
-
-    // Configure file filters for whole-slide image formats
-    nfdfilteritem_t filters[] = {
-        { "Whole-Slide Images", "svs,tiff,tif,ndpi,vms,vmu,scn,mrxs,bif,svslide" },
-        { "All Files", "*" }
-    };
+bool Application::IsSceneFinal() const {
+    // A slide still opening shows its preview; visible tiles still on their
+    // way (tiles arriving elsewhere change nothing drawn), overlay tiles
+    // and animations change the next frame
+    if (!slideRenderer_ || !viewport_ || viewport_->IsAnimating()) {
+        return false;
+    }
+    if (slideRenderer_->GetUncoveredTileCount() > 0 || slideRenderer_->IsMotionCoarsened()) {
+        return false;
+    }
+    if (channelCompositor_ && channelCompositor_->GetUncoveredTileCount() > 0) {
+        return false;
+    }
+    if (IsLoadingPolygonLayers() || HasPendingPolygonUploads()) {
+        return false;
+    }
+    return true;
+}
 
-    // Open file dialog
-    NFD::UniquePath outPath;
-    nfdresult_t result = NFD::OpenDialog(outPath, filters, 2);
+bool Application::EnsureSceneTexture() {
+    if (!sceneCacheEnabled_) {
+        return false;
+    }
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(renderer_, &width, &height);
+    if (sceneTexture_ && width == sceneTextureWidth_ && height == sceneTextureHeight_) {
+        return true;
+    }
 
-    if (result == NFD_OKAY) {
-        std::cout << "Selected file: " << outPath.get() << std::endl;
-        LoadSlide(outPath.get());
+    for (SDL_Texture** texture : {&sceneTexture_, &sceneSpareTexture_}) {
+        if (*texture) {
+            SDL_DestroyTexture(*texture);
+            *texture = nullptr;
+        }
     }
-    else if (result == NFD_CANCEL) {
-        std::cout << "File dialog cancelled" << std::endl;
+    sceneValid_ = false;
+    if (width <= 0 || height <= 0) {
+        return false;
     }
-    else {
-        std::cerr << "File dialog error: " << NFD::GetError() << std::endl;
+    if (SDL_RenderTargetSupported(renderer_)) {
+        sceneTexture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                          width, height);
+        sceneSpareTexture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                               width, height);
+    }
+    if (!sceneTexture_) {
+        PATHVIEW_LOG_ERROR("Application: no render target for the scene cache, drawing every frame"
+                           << " (" << SDL_GetError() << ")");
+        sceneCacheEnabled_ = false;
+        return false;
+    }
+    SDL_SetTextureBlendMode(sceneTexture_, SDL_BLENDMODE_NONE);
+    if (sceneSpareTexture_) {
+        SDL_SetTextureBlendMode(sceneSpareTexture_, SDL_BLENDMODE_NONE);
     }
+    sceneTextureWidth_ = width;
+    sceneTextureHeight_ = height;
+    return true;
 }
 
-void Application::LoadSlide(const std::string& path) {
-    currentSlidePath_ = path;
-    std::cout << "\n=== Loading Slide ===" << std::endl;
-    std::cout << "Path: " << path << std::endl;
-
-    // Clean up previous preview texture
-    if (previewTexture_) {
-        SDL_DestroyTexture(previewTexture_);
-        previewTexture_ = nullptr;
+bool Application::GetSceneShift(const SceneKey& key, int* shiftX, int* shiftY) const {
+    // Only a final drawing is worth keeping, and the compare panes would
+    // each need their own strips
+    if (!sceneValid_ || !sceneSpareTexture_ || key.compare) {
+        return false;
+    }
+    SceneKey moved = key;
+    moved.x = sceneKey_.x;
+    moved.y = sceneKey_.y;
+    if (!(moved == sceneKey_)) {
+        return false;  // Zoom, resize or content changed
     }
 
-    // Create new slide loader
-    slideLoader_ = std::make_unique<SlideLoader>(path);
+    // Content moves opposite to the viewport, in output pixels; a fraction
+    // of a pixel would resample the kept part
+    const double dx = (sceneKey_.x - key.x) * key.zoom * dpiScale_;
+    const double dy = (sceneKey_.y - key.y) * key.zoom * dpiScale_;
+    const double roundedX = std::round(dx);
+    const double roundedY = std::round(dy);
+    if (std::abs(dx - roundedX) > SCENE_SCROLL_TOLERANCE || std::abs(dy - roundedY) > SCENE_SCROLL_TOLERANCE ||
+        std::abs(roundedX) >= sceneTextureWidth_ || std::abs(roundedY) >= sceneTextureHeight_) {
+        return false;
+    }
+    *shiftX = static_cast<int>(roundedX);
+    *shiftY = static_cast<int>(roundedY);
+    return true;
+}
 
-    if (!slideLoader_->IsValid()) {
-        std::cerr << "Failed to load slide: " << slideLoader_->GetError() << std::endl;
-        slideLoader_.reset();
-        return;
+bool Application::ScrollScene(int shiftX, int shiftY) {
+    // Kept part, shifted, in output pixels (the target starts unscaled)
+    if (SDL_SetRenderTarget(renderer_, sceneSpareTexture_) != 0) {
+        return false;
     }
+    SDL_Rect kept = {shiftX, shiftY, sceneTextureWidth_, sceneTextureHeight_};
+    SDL_RenderCopy(renderer_, sceneTexture_, nullptr, &kept);
 
-    std::cout << "Slide loaded successfully!" << std::endl;
+    // Exposed strips, in window coordinates and a pixel wider than exposed:
+    // the overlap is redrawn identically, and a fractional DPI scale
+    // cannot leave a seam
+    SDL_RenderSetScale(renderer_, dpiScale_, dpiScale_);
+    const int exposedX = static_cast<int>(std::ceil(std::abs(shiftX) / dpiScale_)) + 1;
+    const int exposedY = static_cast<int>(std::ceil(std::abs(shiftY) / dpiScale_)) + 1;
+    std::vector<SDL_Rect> strips;
+    if (shiftX != 0) {
+        strips.push_back({shiftX > 0 ? 0 : windowWidth_ - exposedX, 0, exposedX, windowHeight_});
+    }
+    if (shiftY != 0) {
+        strips.push_back({0, shiftY > 0 ? 0 : windowHeight_ - exposedY, windowWidth_, exposedY});
+    }
+    bool complete = true;
+    for (const SDL_Rect& strip : strips) {
+        RenderScene(&strip);
+        complete = complete && IsSceneFinal();
+    }
+    SDL_SetRenderTarget(renderer_, nullptr);
+
+    std::swap(sceneTexture_, sceneSpareTexture_);
+    sceneValid_ = complete;
+    return true;
+}
+
+void Application::RenderScene(const SDL_Rect* clip) {
+    // Clear screen (or the strip: clearing ignores the clip rectangle)
+    SDL_SetRenderDrawColor(renderer_, 32, 32, 32, 255);
+    if (clip) {
+        SDL_RenderSetClipRect(renderer_, clip);
+        SDL_RenderFillRect(renderer_, nullptr);
+    } else {
+        SDL_RenderClear(renderer_);
+    }
+
+    // Render slide using viewport and renderer
+    if (slideLoader_ && viewport_ && slideRenderer_) {
+        ProfileZone zone(&frameProfiler_, "SlideRenderer");
+        if (compareViewport_) {
+            // Main view on the left, the linked one on the right
+            compareLink_.Apply(*viewport_, *compareViewport_);
+            const int split = viewport_->GetWindowWidth();
+            std::vector<RenderView> views(2);
+            views[0].viewport = viewport_.get();
+            views[0].screenRect = {0, 0, split, windowHeight_};
+            views[1].viewport = compareViewport_.get();
+            views[1].screenRect = {split + COMPARE_DIVIDER_WIDTH, 0, compareViewport_->GetWindowWidth(), windowHeight_};
+            if (channelCompositor_) {
+                channelCompositor_->Render(views);
+            } else {
+                slideRenderer_->Render(views);
+            }
+
+            ApplyColorAdjustment(*viewport_, views[0].screenRect);
+            ApplyColorAdjustment(*compareViewport_, views[1].screenRect);
+
+            SDL_SetRenderDrawColor(renderer_, 90, 90, 90, 255);
+            SDL_Rect divider = {split, 0, COMPARE_DIVIDER_WIDTH, windowHeight_};
+            SDL_RenderFillRect(renderer_, &divider);
+        } else {
+            if (channelCompositor_) {
+                RenderView view;
+                view.viewport = viewport_.get();
+                channelCompositor_->Render({view});
+            } else {
+                slideRenderer_->Render(*viewport_);
+                RecordTileUsage();
+            }
+            ApplyColorAdjustment(*viewport_, SDL_Rect{0, 0, 0, 0});
+        }
+        decodePool_->UpdateScaling();
+    }
+    // First frame of a slide that is still opening
+    else if (previewTexture_) {
+        RenderSlidePreview();
+    }
+
+    // Probability heatmap over the tissue, under the cells
+    if (heatmapLayer_ && viewport_ && heatmapLayer_->HasHeatmap() && heatmapLayer_->IsVisible()) {
+        ProfileZone zone(&frameProfiler_, "Heatmap");
+        heatmapLayer_->Render(*viewport_);
+    }
+
+    // Render the polygon layers, in order, through their shared scratch
+    if (viewport_) {
+        ProfileZone zone(&frameProfiler_, "PolygonOverlay");
+        for (PolygonLayer& layer : polygonLayers_) {
+            if (layer.overlay->IsVisible()) {
+                layer.overlay->Render(*viewport_);
+            }
+        }
+    }
+
+    // Render annotation polygons
+    if (annotationManager_ && viewport_) {
+        ProfileZone zone(&frameProfiler_, "Annotations");
+        annotationManager_->RenderAnnotations(*viewport_);
+    }
+
+    if (clip) {
+        SDL_RenderSetClipRect(renderer_, nullptr);
+    }
+}
+
+void Application::RenderUI() {
+    RenderMenuBar();
+    RenderToolbar();
+    RenderSidebar();
+    RenderWelcomeOverlay();
+    RenderSlideOpenProgress();
+
+    // Render navigation lock indicator (overlay)
+    if (IsNavigationLocked()) {
+        RenderNavigationLockIndicator();
+    }
+
+    if (profilerVisible_) {
+        RenderFrameProfiler();
+    }
+
+    RenderCellTooltip();
+}
+
+void Application::OpenFileDialog() {
+    // Initialize NFD
+    NFD::Guard nfdGuard;
+
+    // Configure file filters for whole-slide image formats
+    nfdfilteritem_t filters[] = {
+        { "Whole-Slide Images", "svs,tiff,tif,ndpi,vms,vmu,scn,mrxs,bif,svslide,dcm,zattrs" },
+        { "All Files", "*" }
+    };
+
+    // Open file dialog
+    NFD::UniquePath outPath;
+    nfdresult_t result = NFD::OpenDialog(outPath, filters, 2);
+
+    if (result == NFD_OKAY) {
+        PATHVIEW_LOG_INFO("Selected file: " << outPath.get());
+        LoadSlide(outPath.get());
+    }
+    else if (result == NFD_CANCEL) {
+        PATHVIEW_LOG_INFO("File dialog cancelled");
+    }
+    else {
+        PATHVIEW_LOG_ERROR("File dialog error: " << NFD::GetError());
+    }
+}
+
+void Application::LoadSlide(const std::string& path) {
+    AbandonReply(slideOpenReply_, "Slide load superseded by " + path);
+    currentSlidePath_ = path;
+    PATHVIEW_LOG_INFO("\n=== Loading Slide ===");
+    PATHVIEW_LOG_INFO("Path: " << path);
+
+    // Clean up previous preview texture
+    if (previewTexture_) {
+        SDL_DestroyTexture(previewTexture_);
+        previewTexture_ = nullptr;
+    }
+
+    // Take the previous slide out of the decode pool without waiting for
+    // its in-flight decodes, and drop its textures for the next slide's.
+    // Its renderer and loader live on until the abandoned decodes are
+    // done. Tile server requests let go of the renderer first.
+    if (tileService_) {
+        tileService_->ClearSlide();
+    }
+    CancelRegionScans();
+    CancelRegionExport();
+    viewportPlan_.Clear();
+    if (cellTileService_) {
+        cellTileService_->ClearSource();  // Served again under the next slide's id
+        cellsServed_ = false;
+    }
+    if (channelCompositor_) {
+        channelCompositor_->Detach();
+    }
+    if (slideRenderer_) {
+        slideRenderer_->Detach();
+    }
+    minimap_.reset();
+    compareViewport_.reset();
+    viewport_.reset();
+    RetiringSlide retiring;
+    retiring.channels = std::move(channelCompositor_);
+    retiring.renderer = std::move(slideRenderer_);
+    retiring.diskCache = std::move(diskTileCache_);
+    retiring.loader = std::move(slideLoader_);
+    retiringSlides_.push_back(std::move(retiring));
+    ReapRetiringSlides();
+    textureManager_->ClearCache();
+    slideOpenError_.clear();
+
+    // The worklist's next entry may be opened already, or on its way
+    if (preload_ && preload_->path == path) {
+        std::unique_ptr<SlidePreload> preload = std::move(preload_);
+        if (preload->task) {
+            slideOpenTask_ = std::move(preload->task);
+            RequestRedraw();
+            return;
+        }
+        if (!preload->loader) {
+            slideOpenError_ = preload->error;
+            PATHVIEW_LOG_ERROR("Failed to load slide: " << slideOpenError_);
+            RequestRedraw();
+            return;
+        }
+        PATHVIEW_LOG_INFO("Slide was preloaded");
+        slideLoader_ = std::move(preload->loader);
+        diskTileCache_ = std::move(preload->diskCache);
+        slideRenderer_ = std::move(preload->renderer);
+        ShowOpenedSlide(preload->overview, std::move(preload->tissueMask));
+        return;
+    }
+
+    // Replacing a task abandons it: it finishes and closes in the background
+    slideOpenTask_ = StartSlideOpenTask(path);
+    RequestRedraw();
+}
+
+std::unique_ptr<SlideOpenTask> Application::StartSlideOpenTask(const std::string& path) {
+    SlideOpenOptions options;
+    options.directTiffRead = directTiffRead_;
+    options.tiffMemoryMap = tiffMemoryMap_;
+    options.hardwareJpegDecode = gpuJpegDecode_;
+    return std::make_unique<SlideOpenTask>(path, options, [this]() { PostWakeEvent(); });
+}
+
+void Application::ReapRetiringSlides() {
+    retiringSlides_.erase(
+        std::remove_if(retiringSlides_.begin(), retiringSlides_.end(), [](const RetiringSlide& slide) {
+            return (!slide.renderer || slide.renderer->IsDetached()) &&
+                   (!slide.channels || slide.channels->IsDetached());
+        }),
+        retiringSlides_.end());
+}
+
+void Application::PollSlideOpen() {
+    if (!slideOpenTask_) {
+        return;
+    }
+
+    SlidePreview preview;
+    if (slideOpenTask_->TakePreview(preview)) {
+        if (previewTexture_) {
+            SDL_DestroyTexture(previewTexture_);
+        }
+        previewTexture_ = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT,
+                                            SDL_TEXTUREACCESS_STATIC,
+                                            static_cast<int>(preview.width),
+                                            static_cast<int>(preview.height));
+        if (previewTexture_ &&
+            SDL_UpdateTexture(previewTexture_, nullptr, preview.pixels.data(),
+                              static_cast<int>(preview.width * sizeof(uint32_t))) == 0) {
+            TextureManager::ApplyPremultipliedBlendMode(previewTexture_);
+            PATHVIEW_LOG_INFO("Showing " << preview.source << " preview after "
+                              << slideOpenTask_->GetElapsedSeconds() << " s");
+        } else if (previewTexture_) {
+            SDL_DestroyTexture(previewTexture_);
+            previewTexture_ = nullptr;
+        }
+        RequestRedraw();
+    }
+
+    if (slideOpenTask_->IsFinished()) {
+        FinishSlideOpen();
+    }
+}
+
+void Application::FinishSlideOpen() {
+    std::unique_ptr<SlideOpenTask> task = std::move(slideOpenTask_);
+    RequestRedraw();
+
+    if (previewTexture_) {
+        SDL_DestroyTexture(previewTexture_);
+        previewTexture_ = nullptr;
+    }
+
+    slideLoader_ = task->TakeLoader();
+    if (!slideLoader_) {
+        slideOpenError_ = task->GetError();
+        PATHVIEW_LOG_ERROR("Failed to load slide: " << slideOpenError_);
+        AbandonReply(slideOpenReply_, "Failed to load slide: " + slideOpenError_);
+        if (benchmarkOptions_) {
+            FinishBenchmark("Failed to load slide: " + slideOpenError_);
+        }
+        return;
+    }
+
+    PATHVIEW_LOG_INFO("Slide loaded successfully!");
+    diskTileCache_ = OpenDiskTileCache(*slideLoader_);
+    slideRenderer_ = CreateSlideRenderer(slideLoader_.get(), diskTileCache_.get());
+    LoadPrefetchModel(*slideLoader_->GetMetadata());
+
+    // Tell glass from tissue on the overview the task read, so background
+    // tiles are never decoded
+    MinimapOverview overview = task->TakeOverview();
+    TissueMask tissueMask = TissueMask::FromOverview(overview.pixels, overview.width, overview.height,
+                                                     static_cast<double>(slideLoader_->GetWidth()),
+                                                     static_cast<double>(slideLoader_->GetHeight()));
+    ShowOpenedSlide(overview, std::move(tissueMask));
+}
+
+std::unique_ptr<DiskTileCache> Application::OpenDiskTileCache(const SlideLoader& loader) const {
+    // Persistent tile tier for this slide, under the fingerprint taken
+    // while it opened
+    if (diskCacheMaxBytes_ == 0) {
+        return nullptr;
+    }
+    std::shared_ptr<const SlideMetadata> metadata = loader.GetMetadata();
+    std::string root = diskCacheRoot_.empty() ? DiskTileCache::DefaultRootDirectory() : diskCacheRoot_;
+    auto diskCache = std::make_unique<DiskTileCache>(root, metadata->path, diskCacheMaxBytes_,
+                                                     metadata->fingerprint);
+    if (!diskCache->IsEnabled()) {
+        return nullptr;
+    }
+    return diskCache;
+}
+
+void Application::OpenAnnotationJournal(const SlideLoader& loader) {
+    // The previous slide's are in its journal (or were never saved)
+    annotationManager_->SetJournal(nullptr);
+    annotationJournal_.reset();
+    annotationManager_->Clear();
+    {
+        std::lock_guard<std::mutex> lock(actionCardsMutex_);
+        actionCards_.clear();
+    }
+    if (annotationDirectory_ == "none") {
+        return;
+    }
+
+    // Keyed like the disk tile cache, so a renamed or moved slide keeps
+    // its annotations
+    std::shared_ptr<const SlideMetadata> metadata = loader.GetMetadata();
+    std::string identity = metadata->fingerprint.empty() ? DiskTileCache::SlideIdentity(metadata->path)
+                                                         : metadata->fingerprint;
+    std::string directory = annotationDirectory_.empty() ? AnnotationJournal::DefaultDirectory()
+                                                         : annotationDirectory_;
+    auto journal = std::make_unique<AnnotationJournal>();
+    AnnotationJournal::Contents contents;
+    if (!journal->Open(AnnotationJournal::PathFor(directory, identity), contents)) {
+        return;
+    }
+
+    for (const StoredAnnotation& annotation : contents.annotations) {
+        annotationManager_->RestoreAnnotation(annotation, polygonOverlay_);
+    }
+    {
+        std::lock_guard<std::mutex> lock(actionCardsMutex_);
+        actionCards_ = std::move(contents.cards);
+    }
+    annotationJournal_ = std::move(journal);
+    annotationManager_->SetJournal(annotationJournal_.get());
+}
+
+std::unique_ptr<SlideRenderer> Application::CreateSlideRenderer(SlideLoader* loader, DiskTileCache* diskCache) {
+    // Decode workers and tile cache, started with the first slide and
+    // kept for the next ones
+    if (!decodePool_) {
+        tileCache_ = std::make_unique<TileCache>();
+        tileCache_->SetEvictionPolicy(tileEvictionPolicy_);
+        tileCache_->SetStorage(tileStorage_);
+        tileCache_->SetSolidTiles(solidTiles_);
+        tileCache_->GetBufferPool()->SetHugePages(hugePages_);
+        decodePool_ = std::make_unique<TileLoadThreadPool>(decodeThreads_);
+        decodePool_->Initialize(tileCache_.get());
+        decodePool_->SetThreadScheduling(workerBackgroundPriority_, reservedRenderCores_);
+        if (decodeAutoScale_) {
+            decodePool_->EnableAutoScaling(SlideRenderer::AUTO_SCALE_MIN_WORKERS);
+        }
+        decodePool_->Start();
+    }
+
+    auto slideRenderer = std::make_unique<SlideRenderer>(
+        loader,
+        textureManager_.get(),
+        decodeThreads_,
+        decodeAutoScale_,
+        diskCache
+    );
+    slideRenderer->SetSharedPipeline(decodePool_.get(), tileCache_.get(), nextSlideId_++);
+    slideRenderer->SetLevelSelection(levelSelection_);
+    slideRenderer->SetMotionLevels(motionLevels_);
+    slideRenderer->SetPrefetchLimit(GetPrefetchLimit());
+    slideRenderer->SetDisplayScale(dpiScale_);
+    slideRenderer->SetRenderScale(renderScale_, movingRenderScale_);
+    slideRenderer->Initialize();  // Join the decode pool
+    if (pinnedCoarseLevels_ > 0) {
+        // The fallback layer: these stay whatever a fling through the
+        // finest level loads
+        tileCache_->PinLevels(slideRenderer->GetSlideId(),
+                              slideRenderer->GetPyramid().GetLevelCount() - pinnedCoarseLevels_);
+    }
+
+    // Interactive viewing jumps around the file: no readahead (prefetch
+    // marks its strips sequential)
+    if (loader->IsDirectTiffReadActive()) {
+        loader->AdviseDirectTiffAccess(TiffAccessPattern::Random);
+    }
+    return slideRenderer;
+}
+
+void Application::ShowOpenedSlide(const MinimapOverview& overview, TissueMask tissueMask) {
+    InvalidateScene();  // A new renderer may reuse the old one's address
 
     // Create viewport for interactive navigation
     viewport_ = std::make_unique<Viewport>(
@@ -585,43 +2273,162 @@ void Application::LoadSlide(const std::string& path) {
         slideLoader_->GetWidth(),
         slideLoader_->GetHeight()
     );
+    if (compareEnabled_) {
+        SetCompareView(true);
+        viewport_->ResetView();  // Fit the narrower pane
+    }
 
-    // Create slide renderer
-    slideRenderer_ = std::make_unique<SlideRenderer>(
-        slideLoader_.get(),
-        renderer_,
-        textureManager_.get()
-    );
-    slideRenderer_->Initialize();  // Start async tile loading threads
+    // A restored session's slide opens where it was left, and its most
+    // viewed tiles are decoded in the background (see UpdateSessionWarmup)
+    tileUsage_.Clear();
+    lastUsageZoom_ = 0.0;
+    warmTiles_.clear();
+    warmNext_ = 0;
+    if (restoredSession_ && restoredSession_->slidePath == currentSlidePath_) {
+        if (restoredSession_->hasView) {
+            viewport_->SetView(restoredSession_->viewCenter, restoredSession_->viewZoom);
+        }
+        warmTiles_ = std::move(restoredSession_->warmTiles);
+    }
+    restoredSession_.reset();
 
-    // Create minimap
-    int minimapHeight = std::max(0, windowHeight_ - static_cast<int>(STATUS_BAR_HEIGHT));
-    minimap_ = std::make_unique<Minimap>(
-        slideLoader_.get(),
-        renderer_,
-        windowWidth_,
-        minimapHeight
-    );
+    slideRenderer_->SetTileReadyCallback([this]() {
+        PostWakeEvent();
+        if (tileService_) {
+            tileService_->OnTileReady();
+        }
+    });
+    slideRenderer_->SetProfiler(&frameProfiler_);
+    if (tileCacheTargetBytes_ > 0) {
+        slideRenderer_->SetCacheMaxMemory(tileCacheTargetBytes_);
+    }
+    slideRenderer_->SetCompressedCacheMaxMemory(compressedCacheBytes_);
+
+    // Fluorescence: one renderer per channel on the same pipeline, no disk
+    // cache (the slide's own renderer keeps it)
+    if (slideLoader_->GetChannelCount() > 0) {
+        channelCompositor_ = std::make_unique<ChannelCompositor>(
+            *slideLoader_, renderer_,
+            [this](SlideLoader* loader) { return CreateSlideRenderer(loader, nullptr); });
+        channelCompositor_->SetTileReadyCallback([this]() { PostWakeEvent(); });
+        channelCompositor_->SetProfiler(&frameProfiler_);
+    }
+    RequestRedraw();
+    ServeCurrentSlide();
+
+    // Page in the opening view's tiles now
+    if (slideLoader_->IsDirectTiffReadActive()) {
+        slideRenderer_->PrewarmViewport(*viewport_);
+    }
 
-    // Set slide dimensions in polygon overlay for spatial indexing
-    if (polygonOverlay_) {
-        polygonOverlay_->SetSlideDimensions(
+    overviewTissueMask_ = std::move(tissueMask);
+    slideRenderer_->SetTissueMask(overviewTissueMask_);
+    tissueMaskSource_ = nullptr;
+    UpdateTissueMask();
+    if (overviewTissueMask_.IsValid()) {
+        PATHVIEW_LOG_INFO("Tissue mask: " << static_cast<int>(overviewTissueMask_.GetBackgroundFraction() * 100)
+                          << "% background");
+    }
+
+    // Minimap from the overview the open read
+    if (!headless_) {
+        int minimapHeight = std::max(0, windowHeight_ - static_cast<int>(STATUS_BAR_HEIGHT));
+        minimap_ = std::make_unique<Minimap>(
+            slideLoader_.get(),
+            renderer_,
+            windowWidth_,
+            minimapHeight,
+            overview
+        );
+        minimapDensityDirty_ = true;
+    }
+
+    OpenAnnotationJournal(*slideLoader_);
+
+    // Set slide dimensions in the polygon layers for spatial indexing
+    for (PolygonLayer& layer : polygonLayers_) {
+        layer.overlay->SetSlideDimensions(
             static_cast<double>(slideLoader_->GetWidth()),
             static_cast<double>(slideLoader_->GetHeight())
         );
     }
 
-    std::cout << "Viewport, renderer, and minimap created" << std::endl;
-    std::cout << "===================\n" << std::endl;
-    std::cout << "Controls:" << std::endl;
-    std::cout << "  - Mouse wheel: Zoom in/out" << std::endl;
-    std::cout << "  - Click + drag: Pan" << std::endl;
-    std::cout << "  - Click on minimap: Jump to location" << std::endl;
-    std::cout << "  - 'R' or View -> Reset View: Reset to fit" << std::endl;
-    std::cout << "===================\n" << std::endl;
+    PATHVIEW_LOG_INFO("Viewport, renderer, and minimap created");
+    PATHVIEW_LOG_INFO("===================\n");
+    PATHVIEW_LOG_INFO("Controls:");
+    PATHVIEW_LOG_INFO("  - Mouse wheel: Zoom in/out");
+    PATHVIEW_LOG_INFO("  - Click + drag: Pan");
+    PATHVIEW_LOG_INFO("  - Click on minimap: Jump to location");
+    PATHVIEW_LOG_INFO("  - 'R' or View -> Reset View: Reset to fit");
+    PATHVIEW_LOG_INFO("===================\n");
+
+    if (slideOpenReply_) {
+        slideOpenReply_->set_value(DescribeOpenSlide());
+        slideOpenReply_.reset();
+    }
+
+    if (!pendingTraceReplay_.empty()) {
+        StartTraceReplay(pendingTraceReplay_);
+        pendingTraceReplay_.clear();
+    }
+    if (benchmarkOptions_ && !benchmark_ && running_) {
+        StartBenchmark();
+    }
+
+    SaveSession();  // A crash later still reopens this slide
 }
 
-void Application::OpenPolygonFileDialog() {
+pathview::ipc::json Application::DescribeOpenSlide() const {
+    using json = pathview::ipc::json;
+    // From the snapshot taken at open: no OpenSlide calls on this thread
+    std::shared_ptr<const SlideMetadata> metadata = slideLoader_->GetMetadata();
+    json levels = json::array();
+    for (const SlideMetadata::Level& level : metadata->levels) {
+        levels.push_back({
+            {"width", level.dimensions.width},
+            {"height", level.dimensions.height},
+            {"downsample", level.downsample},
+            {"tile_width", level.tileSize.width},
+            {"tile_height", level.tileSize.height}
+        });
+    }
+    json associated = json::array();
+    for (const SlideMetadata::AssociatedImage& image : metadata->associatedImages) {
+        associated.push_back({{"name", image.name}, {"width", image.width}, {"height", image.height}});
+    }
+    auto unknownIfZero = [](double value) { return value > 0.0 ? json(value) : json(nullptr); };
+
+    return json{
+        {"width", slideLoader_->GetWidth()},
+        {"height", slideLoader_->GetHeight()},
+        {"levels", slideLoader_->GetLevelCount()},
+        {"path", currentSlidePath_},
+        {"fingerprint", metadata->fingerprint},
+        {"vendor", metadata->vendor},
+        {"mpp_x", unknownIfZero(metadata->mppX)},
+        {"mpp_y", unknownIfZero(metadata->mppY)},
+        {"objective_power", unknownIfZero(metadata->objectivePower)},
+        {"level_info", levels},
+        {"associated_images", associated}
+    };
+}
+
+pathview::ipc::json Application::ReplyWhenSlideOpen() {
+    if (!slideOpenTask_) {
+        if (!slideLoader_) {
+            throw std::runtime_error("Failed to load slide: " + slideOpenError_);
+        }
+        return DescribeOpenSlide();
+    }
+
+    // Answered by FinishSlideOpen(); the GUI keeps drawing the preview
+    // meanwhile
+    slideOpenReply_ = std::make_unique<std::promise<pathview::ipc::json>>();
+    ipcServer_->Defer(slideOpenReply_->get_future());
+    return pathview::ipc::json();
+}
+
+void Application::OpenPolygonFileDialog(bool newLayer) {
     // Initialize NFD
     NFD::Guard nfdGuard;
 
@@ -636,29 +2443,653 @@ void Application::OpenPolygonFileDialog() {
     nfdresult_t result = NFD::OpenDialog(outPath, filters, 2);
 
     if (result == NFD_OKAY) {
-        std::cout << "Selected polygon file: " << outPath.get() << std::endl;
-        LoadPolygons(outPath.get());
+        PATHVIEW_LOG_INFO("Selected polygon file: " << outPath.get());
+        if (newLayer) {
+            AddPolygonLayer();
+        }
+        StartPolygonLoad(outPath.get());
+    }
+    else if (result == NFD_CANCEL) {
+        PATHVIEW_LOG_INFO("Polygon file dialog cancelled");
+    }
+    else {
+        PATHVIEW_LOG_ERROR("Polygon file dialog error: " << NFD::GetError());
+    }
+}
+
+void Application::OpenWorklistFileDialog() {
+    NFD::Guard nfdGuard;
+
+    // One slide path per line, optionally a tab and its polygon file
+    nfdfilteritem_t filters[] = {
+        { "Worklist", "txt,tsv,lst" },
+        { "All Files", "*" }
+    };
+
+    NFD::UniquePath outPath;
+    nfdresult_t result = NFD::OpenDialog(outPath, filters, 2);
+
+    if (result == NFD_OKAY) {
+        Worklist worklist;
+        if (worklist.LoadFile(outPath.get())) {
+            SetWorklist(worklist.GetEntries());
+            OpenWorklistEntry(0);
+        }
+    }
+    else if (result == NFD_CANCEL) {
+        PATHVIEW_LOG_INFO("Worklist file dialog cancelled");
+    }
+    else {
+        PATHVIEW_LOG_ERROR("Worklist file dialog error: " << NFD::GetError());
+    }
+}
+
+void Application::SetWorklist(std::vector<WorklistEntry> entries) {
+    worklist_.SetEntries(std::move(entries));
+    preload_.reset();
+    RequestRedraw();
+}
+
+bool Application::OpenWorklistEntry(size_t index) {
+    if (!worklist_.Select(index)) {
+        return false;
+    }
+    WorklistEntry entry = *worklist_.GetCurrent();
+    PATHVIEW_LOG_INFO("Worklist: Slide " << index + 1 << " of " << worklist_.GetSize());
+
+    // Polygons read alongside the preloaded slide carry on from there
+    std::unique_ptr<PolygonLoadTask> polygons;
+    if (preload_ && preload_->path == entry.slidePath && preload_->polygons &&
+        preload_->polygons->GetPath() == entry.polygonPath) {
+        polygons = std::move(preload_->polygons);
+    }
+
+    LoadSlide(entry.slidePath);
+    if (!entry.polygonPath.empty()) {
+        StartPolygonLoad(entry.polygonPath, std::move(polygons));
+    }
+    return true;
+}
+
+void Application::UpdateWorklistPreload() {
+    // Only the entry after the one shown is preloaded
+    size_t next = worklist_.GetNextIndex();
+    const WorklistEntry* wanted = worklist_.GetCurrent() && next != Worklist::NO_ENTRY
+        ? &worklist_.GetEntries()[next]
+        : nullptr;
+    if (preload_ && (!wanted || preload_->path != wanted->slidePath)) {
+        preload_.reset();
+    }
+
+    // Start once the current slide is up, so its open has the disk to itself
+    if (!wanted || slideOpenTask_ || !slideLoader_) {
+        return;
+    }
+    if (!preload_) {
+        PATHVIEW_LOG_INFO("Worklist: Preloading " << wanted->slidePath);
+        preload_ = std::make_unique<SlidePreload>();
+        preload_->path = wanted->slidePath;
+        preload_->task = StartSlideOpenTask(wanted->slidePath);
+        if (!wanted->polygonPath.empty()) {
+            preload_->polygons = PolygonOverlay::CreateLoadTask(wanted->polygonPath, [this]() { PostWakeEvent(); });
+        }
+        return;
+    }
+    if (!preload_->task || !preload_->task->IsFinished()) {
+        return;
+    }
+
+    std::unique_ptr<SlideOpenTask> task = std::move(preload_->task);
+    preload_->loader = task->TakeLoader();
+    if (!preload_->loader) {
+        preload_->error = task->GetError();
+        PATHVIEW_LOG_ERROR("Worklist: Failed to preload " << preload_->path << ": " << preload_->error);
+        return;
+    }
+
+    // Join the decode pool and queue the opening view's tiles behind the
+    // current slide's, as ShowOpenedSlide() will frame it
+    SlideLoader* loader = preload_->loader.get();
+    preload_->diskCache = OpenDiskTileCache(*loader);
+    preload_->renderer = CreateSlideRenderer(loader, preload_->diskCache.get());
+    preload_->overview = task->TakeOverview();
+    preload_->tissueMask = TissueMask::FromOverview(preload_->overview.pixels, preload_->overview.width,
+                                                    preload_->overview.height,
+                                                    static_cast<double>(loader->GetWidth()),
+                                                    static_cast<double>(loader->GetHeight()));
+    preload_->renderer->SetTissueMask(preload_->tissueMask);
+
+    Viewport opening(windowWidth_, windowHeight_, loader->GetWidth(), loader->GetHeight());
+    if (loader->IsDirectTiffReadActive()) {
+        preload_->renderer->PrewarmViewport(opening);
+    }
+    preload_->renderer->PreloadViewport(opening);
+    PATHVIEW_LOG_INFO("Worklist: Preloaded " << preload_->path);
+}
+
+pathview::ipc::json Application::DescribeWorklist() const {
+    pathview::ipc::json entries = pathview::ipc::json::array();
+    for (const WorklistEntry& entry : worklist_.GetEntries()) {
+        entries.push_back({{"slide", entry.slidePath}, {"polygons", entry.polygonPath}});
+    }
+
+    pathview::ipc::json preload = nullptr;
+    if (preload_) {
+        const char* state = preload_->task ? "opening" : preload_->loader ? "ready" : "failed";
+        preload = {{"path", preload_->path}, {"state", state}};
+    }
+
+    size_t index = worklist_.GetIndex();
+    return pathview::ipc::json{
+        {"entries", entries},
+        {"index", index == Worklist::NO_ENTRY ? pathview::ipc::json(nullptr) : pathview::ipc::json(index)},
+        {"preload", preload}
+    };
+}
+
+void Application::OpenLibraryFolderDialog() {
+    NFD::Guard nfdGuard;
+
+    std::string start = slideLibrary_ ? slideLibrary_->GetRoot() : std::string();
+    if (start.empty() && !currentSlidePath_.empty()) {
+        start = std::filesystem::path(currentSlidePath_).parent_path().string();
+    }
+
+    NFD::UniquePath outPath;
+    nfdresult_t result = NFD::PickFolder(outPath, start.empty() ? nullptr : start.c_str());
+
+    if (result == NFD_OKAY) {
+        ScanLibrary(outPath.get());
     }
     else if (result == NFD_CANCEL) {
-        std::cout << "Polygon file dialog cancelled" << std::endl;
+        PATHVIEW_LOG_INFO("Slide folder dialog cancelled");
     }
     else {
-        std::cerr << "Polygon file dialog error: " << NFD::GetError() << std::endl;
+        PATHVIEW_LOG_ERROR("Slide folder dialog error: " << NFD::GetError());
+    }
+}
+
+bool Application::ScanLibrary(const std::string& directory) {
+    if (!slideLibrary_) {
+        slideLibrary_ = std::make_unique<SlideLibrary>(SlideLibrary::DefaultCacheDirectory(),
+                                                       SlideLibrary::DEFAULT_THREADS,
+                                                       [this]() { PostWakeEvent(); });
     }
+    bool scanned = slideLibrary_->Scan(directory);
+    selectLibraryTab_ = scanned;
+    UpdateLibraryTextures();
+    RequestRedraw();
+    return scanned;
+}
+
+void Application::UpdateLibraryTextures() {
+    if (!slideLibrary_ || slideLibrary_->GetRevision() == libraryRevision_) {
+        return;
+    }
+    libraryRevision_ = slideLibrary_->GetRevision();
+    const uint64_t scan = slideLibrary_->GetScanRevision();
+    if (scan != libraryScanRevision_) {
+        ClearLibraryTextures();
+        libraryScanRevision_ = scan;
+    }
+    libraryEntries_ = slideLibrary_->GetEntries();
+    libraryTextures_.resize(libraryEntries_.size(), nullptr);
+
+    for (size_t i = 0; i < libraryEntries_.size(); ++i) {
+        SlideThumbnail thumbnail;
+        if (libraryTextures_[i] || libraryEntries_[i].state != SlideLibrary::ThumbnailState::Ready ||
+            !slideLibrary_->TakeThumbnail(i, scan, thumbnail)) {
+            continue;
+        }
+        SDL_Texture* texture = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT,
+                                                 SDL_TEXTUREACCESS_STATIC, thumbnail.width, thumbnail.height);
+        if (texture && SDL_UpdateTexture(texture, nullptr, thumbnail.pixels.data(),
+                                         static_cast<int>(thumbnail.width * sizeof(uint32_t))) == 0) {
+            TextureManager::ApplyPremultipliedBlendMode(texture);
+            libraryTextures_[i] = texture;
+        } else if (texture) {
+            SDL_DestroyTexture(texture);
+        }
+    }
+    RequestRedraw();
+}
+
+void Application::ClearLibraryTextures() {
+    for (SDL_Texture* texture : libraryTextures_) {
+        if (texture) {
+            SDL_DestroyTexture(texture);
+        }
+    }
+    libraryTextures_.clear();
+}
+
+pathview::ipc::json Application::DescribeLibrary() const {
+    pathview::ipc::json entries = pathview::ipc::json::array();
+    const char* states[] = {"pending", "ready", "failed"};
+    for (const SlideLibrary::Entry& entry : libraryEntries_) {
+        pathview::ipc::json item = {
+            {"path", entry.path},
+            {"name", entry.name},
+            {"bytes", entry.bytes},
+            {"thumbnail", states[static_cast<int>(entry.state)]},
+            {"from_cache", entry.fromCache}
+        };
+        if (!entry.error.empty()) {
+            item["error"] = entry.error;
+        }
+        entries.push_back(std::move(item));
+    }
+    return pathview::ipc::json{
+        {"root", slideLibrary_ ? slideLibrary_->GetRoot() : std::string()},
+        {"cache_directory", slideLibrary_ ? slideLibrary_->GetCacheDirectory() : SlideLibrary::DefaultCacheDirectory()},
+        {"pending", slideLibrary_ ? slideLibrary_->GetPendingCount() : 0},
+        {"entries", entries}
+    };
 }
 
 void Application::LoadPolygons(const std::string& path) {
     if (!polygonOverlay_) {
-        std::cerr << "Polygon overlay not initialized" << std::endl;
+        PATHVIEW_LOG_ERROR("Polygon overlay not initialized");
         return;
     }
 
+    AbandonReply(polygonLoadReply_, "Polygon load superseded by " + path);
+    StopPolygonReaders();
+    std::string& layerPath = polygonLayers_[activePolygonLayer_].path;
+    layerPath.clear();
     if (polygonOverlay_->LoadPolygons(path)) {
-        std::cout << "Polygons loaded successfully from: " << path << std::endl;
+        layerPath = path;
+        PATHVIEW_LOG_INFO("Polygons loaded successfully from: " << path);
         // Automatically enable visibility after loading
         polygonOverlay_->SetVisible(true);
     } else {
-        std::cerr << "Failed to load polygons from: " << path << std::endl;
+        PATHVIEW_LOG_ERROR("Failed to load polygons from: " << path);
+    }
+}
+
+void Application::StartPolygonLoad(const std::string& path, std::unique_ptr<PolygonLoadTask> preloaded) {
+    if (!polygonOverlay_) {
+        PATHVIEW_LOG_ERROR("Polygon overlay not initialized");
+        return;
+    }
+
+    AbandonReply(polygonLoadReply_, "Polygon load superseded by " + path);
+    StopPolygonReaders();
+    bool started = preloaded
+        ? polygonOverlay_->StartLoadingPolygons(std::move(preloaded))
+        : polygonOverlay_->StartLoadingPolygons(path, [this]() { PostWakeEvent(); });
+    polygonLayers_[activePolygonLayer_].path = started ? path : std::string();
+    if (started) {
+        // Show batches as they arrive
+        polygonOverlay_->SetVisible(true);
+    } else {
+        PATHVIEW_LOG_ERROR("Failed to load polygons from: " << path);
+    }
+}
+
+void Application::CancelRegionScans() {
+    // Their results stay until fetched; the fields left would render
+    // whatever slide is served next
+    for (auto& [token, scan] : regionScans_) {
+        scan->Cancel();
+    }
+}
+
+void Application::CancelRegionExport() {
+    // The job stops before its next tile and is reaped in UpdateRegionExport;
+    // tiles being rendered give up once the slide is cleared
+    if (regionExport_) {
+        regionExport_->cancel = true;
+    }
+}
+
+void Application::UpdateRegionExport() {
+    if (!regionExport_) {
+        return;
+    }
+    RegionExport& job = *regionExport_;
+    const bool finished = job.finished.load();
+    {
+        std::lock_guard<std::mutex> lock(actionCardsMutex_);
+        auto card = std::find_if(actionCards_.begin(), actionCards_.end(),
+            [&job](const pathview::ActionCard& c) { return c.id == job.cardId; });
+        if (card == actionCards_.end()) {
+            job.cancel = true;  // Dropped, e.g. by action_card.clear
+        } else if (!finished) {
+            if (card->status == pathview::ActionCardStatus::CANCELLED) {
+                job.cancel = true;
+            }
+            const size_t done = job.done.load();
+            const size_t total = job.total.load();
+            const int percent = total ? static_cast<int>(done * 100 / total) : 0;
+            if (percent != job.reportedPercent) {
+                card->summary = "Writing tiles: " + std::to_string(done) + " of " + std::to_string(total) + " (" +
+                                std::to_string(percent) + "%)";
+                card->updatedAt = std::chrono::system_clock::now();
+                // The journal and the log hear of every tenth
+                if (percent / 10 != job.reportedPercent / 10 && job.reportedPercent >= 0) {
+                    card->AppendLog(std::to_string(percent / 10 * 10) + "% of tiles written");
+                    if (annotationJournal_) {
+                        annotationJournal_->PutCard(*card);
+                    }
+                }
+                job.reportedPercent = percent;
+            }
+        } else {
+            const SlideTranscoder::Result& result = job.result;
+            if (result.ok) {
+                const double seconds =
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - job.started).count();
+                std::ostringstream log;
+                log << "Wrote " << result.levels << " levels, " << result.tiles << " tiles, " << std::fixed
+                    << std::setprecision(1) << result.bytes / (1024.0 * 1024.0) << " MB in " << seconds << " s";
+                card->summary = "Exported to " + job.path;
+                card->AppendLog(log.str(), "success");
+                card->UpdateStatus(pathview::ActionCardStatus::COMPLETED);
+            } else if (result.cancelled) {
+                card->summary = "Export cancelled";
+                card->AppendLog("Cancelled; the partial file was removed", "warning");
+                card->UpdateStatus(pathview::ActionCardStatus::CANCELLED);
+            } else {
+                card->summary = "Export failed: " + result.error;
+                card->AppendLog(result.error, "error");
+                card->UpdateStatus(pathview::ActionCardStatus::FAILED);
+            }
+            if (annotationJournal_) {
+                annotationJournal_->PutCard(*card);
+            }
+        }
+    }
+    if (!finished) {
+        return;
+    }
+
+    job.thread.join();
+    if (job.result.ok) {
+        PATHVIEW_LOG_INFO("Region export written: " << job.path << " (" << job.result.levels << " levels, "
+                          << job.result.tiles << " tiles)");
+    } else {
+        std::error_code ec;
+        std::filesystem::remove(job.path, ec);
+        PATHVIEW_LOG_WARNING("Region export to " << job.path << " stopped: " << job.result.error);
+    }
+    regionExport_.reset();
+    RequestRedraw();
+}
+
+void Application::StopPolygonReaders() {
+    selectedPolygon_ = PolygonPicker::NO_POLYGON;  // Its index is about to mean another cell
+    for (auto& [token, batch] : roiBatches_) {
+        batch->Cancel();
+    }
+    roiBatches_.clear();
+    if (commandExecutor_) {
+        commandExecutor_->WaitIdle();
+    }
+    if (cellTileService_) {
+        cellTileService_->ClearSource();
+        cellsServed_ = false;
+    }
+}
+
+void Application::AddPolygonLayer() {
+    if (polygonLayers_.empty()) {
+        return;
+    }
+    std::unique_ptr<PolygonOverlay> overlay = polygonLayers_.front().overlay->CreateLayer();
+    overlay->SetTileReadyCallback([this]() {
+        overlayTileWakes_++;
+        PostWakeEvent();
+    });
+    polygonLayers_.push_back({std::move(overlay), std::string()});
+    SelectPolygonLayer(polygonLayers_.size() - 1);
+}
+
+bool Application::SelectPolygonLayer(size_t index) {
+    if (index >= polygonLayers_.size()) {
+        return false;
+    }
+    if (index != activePolygonLayer_) {
+        // The other layers keep their polygons: only what reads the active
+        // one by index moves over
+        selectedPolygon_ = PolygonPicker::NO_POLYGON;
+        if (cellTileService_) {
+            cellTileService_->ClearSource();
+            cellsServed_ = false;
+        }
+        activePolygonLayer_ = index;
+        polygonOverlay_ = polygonLayers_[index].overlay.get();
+        minimapDensityDirty_ = true;
+        ++polygonLayersRevision_;
+        RequestRedraw();
+    }
+    return true;
+}
+
+bool Application::RemovePolygonLayer(size_t index) {
+    if (index >= polygonLayers_.size() || polygonLayers_.size() == 1) {
+        return false;
+    }
+    // ROI batches and IPC jobs may be reading any layer
+    StopPolygonReaders();
+    if (index == activePolygonLayer_) {
+        AbandonReply(polygonLoadReply_, "Polygon layer removed");
+    }
+    polygonLayers_.erase(polygonLayers_.begin() + static_cast<std::ptrdiff_t>(index));
+    if (activePolygonLayer_ >= index && activePolygonLayer_ > 0) {
+        --activePolygonLayer_;
+    }
+    polygonOverlay_ = polygonLayers_[activePolygonLayer_].overlay.get();
+    minimapDensityDirty_ = true;
+    ++polygonLayersRevision_;
+    RequestRedraw();
+    return true;
+}
+
+pathview::ipc::json Application::DescribePolygonLayers() const {
+    pathview::ipc::json layers = pathview::ipc::json::array();
+    for (size_t i = 0; i < polygonLayers_.size(); ++i) {
+        const PolygonOverlay& overlay = *polygonLayers_[i].overlay;
+        layers.push_back({
+            {"index", i},
+            {"path", polygonLayers_[i].path},
+            {"visible", overlay.IsVisible()},
+            {"active", i == activePolygonLayer_},
+            {"loading", overlay.IsLoading()},
+            {"count", overlay.GetPolygonCount()}
+        });
+    }
+    return pathview::ipc::json{{"layers", layers}, {"active", activePolygonLayer_}};
+}
+
+bool Application::IsLoadingPolygonLayers() const {
+    return std::any_of(polygonLayers_.begin(), polygonLayers_.end(),
+                       [](const PolygonLayer& layer) { return layer.overlay->IsLoading(); });
+}
+
+bool Application::HasPendingPolygonUploads() const {
+    return std::any_of(polygonLayers_.begin(), polygonLayers_.end(),
+                       [](const PolygonLayer& layer) { return layer.overlay->HasPendingTileUploads(); });
+}
+
+uint64_t Application::GetPolygonLayersRevision() const {
+    // Revisions only grow, so their sum changes with any of them
+    uint64_t revision = polygonLayersRevision_;
+    for (const PolygonLayer& layer : polygonLayers_) {
+        revision += layer.overlay->GetRevision();
+    }
+    return revision;
+}
+
+size_t Application::SumPolygonLayers(size_t (PolygonOverlay::*usage)() const) const {
+    size_t total = 0;
+    for (const PolygonLayer& layer : polygonLayers_) {
+        total += ((*layer.overlay).*usage)();
+    }
+    return total;
+}
+
+void Application::OpenHeatmapFileDialog() {
+    NFD::Guard nfdGuard;
+
+    // A Zarr array is a directory: pick its .zarray or zarr.json
+    nfdfilteritem_t filters[] = {
+        { "Heatmaps", "npy,zarray,json" },
+        { "All Files", "*" }
+    };
+
+    NFD::UniquePath outPath;
+    nfdresult_t result = NFD::OpenDialog(outPath, filters, 2);
+
+    if (result == NFD_OKAY) {
+        PATHVIEW_LOG_INFO("Selected heatmap: " << outPath.get());
+        LoadHeatmap(outPath.get());
+    }
+    else if (result == NFD_CANCEL) {
+        PATHVIEW_LOG_INFO("Heatmap file dialog cancelled");
+    }
+    else {
+        PATHVIEW_LOG_ERROR("Heatmap file dialog error: " << NFD::GetError());
+    }
+}
+
+bool Application::LoadHeatmap(const std::string& path, double texelSize) {
+    if (!heatmapLayer_) {
+        PATHVIEW_LOG_ERROR("Heatmap layer not initialized");
+        return false;
+    }
+    if (texelSize <= 0.0) {
+        // Stretched over the slide: the grid's columns span its width
+        HeatmapGrid grid(path);
+        texelSize = grid.IsOpen() && slideLoader_ ? double(slideLoader_->GetWidth()) / double(grid.GetWidth())
+                                                  : 1.0;
+    }
+    if (!heatmapLayer_->Load(path, texelSize)) {
+        PATHVIEW_LOG_ERROR("Failed to load heatmap from " << path << ": " << heatmapLayer_->GetError());
+        return false;
+    }
+    heatmapLayer_->SetVisible(true);
+    RequestRedraw();
+    return true;
+}
+
+std::string Application::GetSessionFile() const {
+    if (sessionPath_ == "none" || (sessionPath_.empty() && headless_)) {
+        return std::string();
+    }
+    return sessionPath_.empty() ? Session::DefaultPath() : sessionPath_;
+}
+
+void Application::SaveSession() {
+    std::string path = GetSessionFile();
+    if (path.empty() || (currentSlidePath_.empty() && worklist_.IsEmpty())) {
+        return;  // Nothing opened: keep the last session for next time
+    }
+
+    SessionState state;
+    state.slidePath = currentSlidePath_;
+    if (viewport_) {
+        Vec2 position = viewport_->GetPosition();
+        double zoom = viewport_->GetZoom();
+        state.hasView = true;
+        state.viewCenter = Vec2(position.x + viewport_->GetWindowWidth() / (2.0 * zoom),
+                                position.y + viewport_->GetWindowHeight() / (2.0 * zoom));
+        state.viewZoom = zoom;
+    }
+    state.polygonPath = polygonLayers_.empty() ? std::string() : polygonLayers_[activePolygonLayer_].path;
+    if (heatmapLayer_ && heatmapLayer_->HasHeatmap()) {
+        state.heatmapPath = heatmapLayer_->GetPath();
+        state.heatmapTexelSize = heatmapLayer_->GetPyramid()->GetTexelSize();
+    }
+    state.worklist = worklist_.GetEntries();
+    state.worklistIndex = worklist_.GetIndex();
+    // Right after a restore nothing is counted yet: keep the restored tiles
+    state.warmTiles = tileUsage_.GetTrackedCount() > 0 ? tileUsage_.GetMostUsed(Session::MAX_WARM_TILES)
+                                                       : warmTiles_;
+
+    if (!Session::Save(path, state)) {
+        PATHVIEW_LOG_WARNING("Failed to save session to " << path);
+    }
+}
+
+void Application::RestoreSession() {
+    std::string path = GetSessionFile();
+    SessionState state;
+    if (path.empty() || !Session::Load(path, state) || state.IsEmpty()) {
+        return;
+    }
+    PATHVIEW_LOG_INFO("Restoring session from " << path);
+
+    if (!state.worklist.empty()) {
+        SetWorklist(state.worklist);
+        if (state.worklistIndex != Worklist::NO_ENTRY &&
+            state.worklist[state.worklistIndex].slidePath == state.slidePath) {
+            worklist_.Select(state.worklistIndex);
+        }
+    }
+    if (state.slidePath.empty()) {
+        return;
+    }
+
+    // The view and warm tiles wait for the slide (see ShowOpenedSlide); the
+    // overlays load alongside it
+    restoredSession_ = std::make_unique<SessionState>(state);
+    LoadSlide(state.slidePath);
+    if (!state.polygonPath.empty()) {
+        StartPolygonLoad(state.polygonPath);
+    }
+    if (!state.heatmapPath.empty()) {
+        LoadHeatmap(state.heatmapPath, state.heatmapTexelSize);
+    }
+}
+
+void Application::RecordTileUsage() {
+    // Settled views only, once each: frames redrawn while tiles arrive, and
+    // views passed through, would outweigh the places actually read
+    if (viewport_->IsAnimating() || slideRenderer_->IsMotionCoarsened()) {
+        return;
+    }
+    Vec2 position = viewport_->GetPosition();
+    if (viewport_->GetZoom() == lastUsageZoom_ && position.x == lastUsagePosition_.x &&
+        position.y == lastUsagePosition_.y) {
+        return;
+    }
+    lastUsagePosition_ = position;
+    lastUsageZoom_ = viewport_->GetZoom();
+    tileUsage_.Record(slideRenderer_->GetVisibleTiles());
+}
+
+void Application::UpdateSessionWarmup() {
+    if (warmNext_ >= warmTiles_.size() || !slideRenderer_) {
+        return;
+    }
+    // A few at a time behind what is drawn: a request is dropped if not
+    // resubmitted for long (see TileLoadThreadPool), and the view comes first
+    if (slideRenderer_->GetPendingTileCount() >= WARMUP_PENDING_LIMIT) {
+        return;
+    }
+
+    const PyramidLayout& pyramid = slideRenderer_->GetPyramid();
+    size_t submitted = 0;
+    while (warmNext_ < warmTiles_.size() && submitted < WARMUP_BATCH_TILES) {
+        const TileKey& key = warmTiles_[warmNext_++];
+        // The pyramid may have changed since (another tile size)
+        if (key.level >= pyramid.GetLevelCount()) {
+            continue;
+        }
+        LevelDimensions dimensions = pyramid.GetLevelDimensions(key.level);
+        int64_t tileWidth = pyramid.GetTileWidth(key.level);
+        int64_t tileHeight = pyramid.GetTileHeight(key.level);
+        int64_t columns = (dimensions.width + tileWidth - 1) / tileWidth;
+        int64_t rows = (dimensions.height + tileHeight - 1) / tileHeight;
+        if (key.tileX >= columns || key.tileY >= rows || slideRenderer_->GetCachedTile(key)) {
+            continue;
+        }
+        slideRenderer_->RequestTile(key, TileLoadPriority::ADJACENT);
+        submitted++;
+    }
+    if (warmNext_ >= warmTiles_.size()) {
+        PATHVIEW_LOG_INFO("Session: Warm-up of " << warmTiles_.size() << " tiles queued");
     }
 }
 
@@ -718,6 +3149,167 @@ void Application::RenderNavigationLockIndicator() {
     ImGui::End();
 }
 
+void Application::RenderCellTooltip() {
+    if (!polygonOverlay_ || !viewport_ || !polygonOverlay_->IsVisible() || isPanning_ ||
+        ImGui::GetIO().WantCaptureMouse || (annotationManager_ && annotationManager_->IsToolActive())) {
+        return;
+    }
+    int mouseX, mouseY;
+    SDL_GetMouseState(&mouseX, &mouseY);
+    if (minimap_ && minimap_->Contains(mouseX, mouseY)) {
+        return;
+    }
+
+    // Picked every frame; the overlay answers from its cache while the
+    // cursor rests
+    const uint32_t polygon = polygonOverlay_->PickPolygon(viewport_->ScreenToSlide(Vec2(mouseX, mouseY)));
+    if (polygon == PolygonPicker::NO_POLYGON) {
+        return;
+    }
+    const PolygonStore& polygons = polygonOverlay_->GetPolygons();
+    const Rect box = polygons.GetBoundingBox(polygon);
+    if (std::max(box.width, box.height) * viewport_->GetZoom() < CELL_TOOLTIP_MIN_PIXELS) {
+        return;
+    }
+
+    const int classId = polygons.GetClassId(polygon);
+    ImGui::BeginTooltip();
+    ImGui::Text("Cell %u", polygon);
+    ImGui::Text("Class: %s (%d)", polygonOverlay_->GetClassName(classId).c_str(), classId);
+    ImGui::Text("Confidence: %.3f", polygons.GetConfidence(polygon));
+    ImGui::Text("Area: %.0f px", polygons.GetArea(polygon));
+    ImGui::EndTooltip();
+}
+
+void Application::RenderFrameProfiler() {
+    ImGui::SetNextWindowPos(ImVec2(windowWidth_ - 10.0f, TOOLBAR_HEIGHT + 30.0f), ImGuiCond_FirstUseEver, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.85f);
+
+    if (!ImGui::Begin("Frame Profiler (F3)", &profilerVisible_,
+                      ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings)) {
+        ImGui::End();
+        return;
+    }
+
+    size_t frameCount = frameProfiler_.GetFrameCount();
+    if (frameCount == 0) {
+        ImGui::TextDisabled("No frames recorded yet");
+        ImGui::End();
+        return;
+    }
+
+    // Per top-level zone: colour, last, mean and worst time over the history
+    struct ZoneSummary {
+        const char* name;
+        ImU32 color;
+        double lastMs;
+        double totalMs;
+        double maxMs;
+    };
+    std::vector<ZoneSummary> summaries;
+    auto summaryFor = [&summaries](const char* name) -> ZoneSummary& {
+        for (ZoneSummary& summary : summaries) {
+            if (std::strcmp(summary.name, name) == 0) {
+                return summary;
+            }
+        }
+        // Stable colour per name across frames
+        size_t hash = std::hash<std::string>()(name);
+        float hue = static_cast<float>(hash % 360) / 360.0f;
+        float r, g, b;
+        ImGui::ColorConvertHSVtoRGB(hue, 0.55f, 0.85f, r, g, b);
+        summaries.push_back({name, ImGui::GetColorU32(ImVec4(r, g, b, 1.0f)), 0.0, 0.0, 0.0});
+        return summaries.back();
+    };
+
+    double totalFrameMs = 0.0;
+    double maxFrameMs = 0.0;
+    for (size_t age = 0; age < frameCount; ++age) {
+        const FrameProfiler::Frame& frame = frameProfiler_.GetFrame(age);
+        totalFrameMs += frame.GetDurationMs();
+        maxFrameMs = std::max(maxFrameMs, frame.GetDurationMs());
+        for (const FrameProfiler::Zone& zone : frame.zones) {
+            if (zone.depth != 0) {
+                continue;
+            }
+            ZoneSummary& summary = summaryFor(zone.name);
+            double ms = (zone.endUs - zone.startUs) / 1000.0;
+            if (age == 0) {
+                summary.lastMs += ms;
+            }
+            summary.totalMs += ms;
+            summary.maxMs = std::max(summary.maxMs, ms);
+        }
+    }
+
+    ImGui::Text("Frame: %.2f ms (mean %.2f, max %.2f over %zu frames)",
+                frameProfiler_.GetFrame(0).GetDurationMs(), totalFrameMs / frameCount, maxFrameMs, frameCount);
+
+    // Stacked bars, oldest frame on the left; the line marks a 60 Hz frame
+    const float graphWidth = static_cast<float>(FrameProfiler::HISTORY_FRAMES) * 2.0f;
+    const float graphHeight = 120.0f;
+    const double scaleMs = std::max(PROFILER_GRAPH_MIN_MS, maxFrameMs);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + graphWidth, origin.y + graphHeight), IM_COL32(20, 20, 20, 200));
+
+    float barWidth = graphWidth / FrameProfiler::HISTORY_FRAMES;
+    for (size_t age = 0; age < frameCount; ++age) {
+        const FrameProfiler::Frame& frame = frameProfiler_.GetFrame(age);
+        float x0 = origin.x + graphWidth - (age + 1) * barWidth;
+        float bottom = origin.y + graphHeight;
+        auto heightOf = [&](double ms) { return static_cast<float>(ms / scaleMs * graphHeight); };
+
+        // Untracked frame time in grey, zones stacked on top of it
+        drawList->AddRectFilled(ImVec2(x0, bottom - heightOf(frame.GetDurationMs())), ImVec2(x0 + barWidth, bottom),
+                                IM_COL32(90, 90, 90, 255));
+        float y = bottom;
+        for (const FrameProfiler::Zone& zone : frame.zones) {
+            if (zone.depth != 0) {
+                continue;
+            }
+            float height = heightOf((zone.endUs - zone.startUs) / 1000.0);
+            drawList->AddRectFilled(ImVec2(x0, y - height), ImVec2(x0 + barWidth, y), summaryFor(zone.name).color);
+            y -= height;
+        }
+    }
+    float budgetY = origin.y + graphHeight - static_cast<float>(1000.0 / 60.0 / scaleMs * graphHeight);
+    drawList->AddLine(ImVec2(origin.x, budgetY), ImVec2(origin.x + graphWidth, budgetY), IM_COL32(255, 80, 80, 200));
+    ImGui::Dummy(ImVec2(graphWidth, graphHeight));
+
+    ImGui::Text("%-16s %8s %8s %8s", "zone (ms)", "last", "mean", "max");
+    for (const ZoneSummary& summary : summaries) {
+        ImVec2 swatch = ImGui::GetCursorScreenPos();
+        float size = ImGui::GetTextLineHeight();
+        drawList->AddRectFilled(swatch, ImVec2(swatch.x + size, swatch.y + size), summary.color);
+        ImGui::Dummy(ImVec2(size, size));
+        ImGui::SameLine();
+        ImGui::Text("%-14s %8.2f %8.2f %8.2f", summary.name, summary.lastMs,
+                    summary.totalMs / frameCount, summary.maxMs);
+    }
+
+    // Nested zones of the last frame
+    if (ImGui::TreeNode("Last frame")) {
+        for (const FrameProfiler::Zone& zone : frameProfiler_.GetFrame(0).zones) {
+            ImGui::Text("%*s%s  %.3f ms", static_cast<int>(zone.depth * 2), "", zone.name,
+                        (zone.endUs - zone.startUs) / 1000.0);
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::Button("Export Chrome Trace")) {
+        profileExportStatus_ = frameProfiler_.ExportChromeTrace(PROFILE_EXPORT_PATH)
+            ? std::string("Saved ") + PROFILE_EXPORT_PATH
+            : std::string("Failed to write ") + PROFILE_EXPORT_PATH;
+    }
+    if (!profileExportStatus_.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", profileExportStatus_.c_str());
+    }
+
+    ImGui::End();
+}
+
 void Application::RenderMenuBar() {
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
@@ -727,6 +3319,25 @@ void Application::RenderMenuBar() {
             if (ImGui::MenuItem("Load Polygons...", "Ctrl+P")) {
                 OpenPolygonFileDialog();
             }
+            if (ImGui::MenuItem("Add Polygon Layer...")) {
+                OpenPolygonFileDialog(true);
+            }
+            if (ImGui::MenuItem("Load Heatmap...")) {
+                OpenHeatmapFileDialog();
+            }
+            if (ImGui::MenuItem("Open Worklist...")) {
+                OpenWorklistFileDialog();
+            }
+            if (ImGui::MenuItem("Browse Slide Folder...")) {
+                OpenLibraryFolderDialog();
+            }
+            if (ImGui::MenuItem("Next Slide", "PgDn", false, worklist_.GetNextIndex() != Worklist::NO_ENTRY)) {
+                OpenWorklistEntry(worklist_.GetNextIndex());
+            }
+            if (ImGui::MenuItem("Previous Slide", "PgUp", false,
+                                worklist_.GetPreviousIndex() != Worklist::NO_ENTRY)) {
+                OpenWorklistEntry(worklist_.GetPreviousIndex());
+            }
             ImGui::Separator();
             if (ImGui::MenuItem("Exit", "Ctrl+Q")) {
                 running_ = false;
@@ -738,6 +3349,11 @@ void Application::RenderMenuBar() {
             if (ImGui::MenuItem("Reset View", "R") && viewport_) {
                 viewport_->ResetView();
             }
+            ImGui::MenuItem("Frame Profiler", "F3", &profilerVisible_);
+            bool compare = compareEnabled_;
+            if (ImGui::MenuItem("Compare View", nullptr, &compare)) {
+                SetCompareView(compare);
+            }
             ImGui::EndMenu();
         }
 
@@ -854,14 +3470,28 @@ void Application::RenderSidebar() {
             // Tab 3: Polygon Annotations
             if (ImGui::BeginTabItem("Polygon Annotations")) {
                 if (annotationManager_) {
-                    annotationManager_->RenderUI(polygonOverlay_.get());
+                    annotationManager_->RenderUI(polygonOverlay_);
                 }
                 ImGui::EndTabItem();
             }
 
-            // Tab 4: Action Cards
-            if (ImGui::BeginTabItem("Action Cards")) {
-                RenderActionCardsTab();
+            // Tab 4: Action Cards
+            if (ImGui::BeginTabItem("Action Cards")) {
+                RenderActionCardsTab();
+                ImGui::EndTabItem();
+            }
+
+            // Tab 5: Worklist
+            if (ImGui::BeginTabItem("Worklist")) {
+                RenderWorklistTab();
+                ImGui::EndTabItem();
+            }
+
+            // Tab 6: Slide library, brought forward by a new scan
+            ImGuiTabItemFlags libraryFlags = selectLibraryTab_ ? ImGuiTabItemFlags_SetSelected : 0;
+            selectLibraryTab_ = false;
+            if (ImGui::BeginTabItem("Library", nullptr, libraryFlags)) {
+                RenderLibraryTab();
                 ImGui::EndTabItem();
             }
 
@@ -872,7 +3502,7 @@ void Application::RenderSidebar() {
 }
 
 void Application::RenderWelcomeOverlay() {
-    if (slideLoader_ && slideLoader_->IsValid()) {
+    if ((slideLoader_ && slideLoader_->IsValid()) || slideOpenTask_) {
         return;
     }
 
@@ -895,6 +3525,12 @@ void Application::RenderWelcomeOverlay() {
         ImGui::Text("Welcome to PathView");
         ImGui::Separator();
         ImGui::TextWrapped("Load a whole-slide image to explore it with high-resolution zoom and pan.");
+        if (!slideOpenError_.empty()) {
+            ImGui::Spacing();
+            ImGui::TextWrapped("Could not open %s: %s",
+                               std::filesystem::path(currentSlidePath_).filename().string().c_str(),
+                               slideOpenError_.c_str());
+        }
         ImGui::Spacing();
 
         if (ImGui::Button(ICON_FA_FOLDER_OPEN "  Open Slide (Ctrl+O)", ImVec2(-FLT_MIN, 0.0f))) {
@@ -911,6 +3547,229 @@ void Application::RenderWelcomeOverlay() {
     ImGui::End();
 }
 
+void Application::RenderSlideOpenProgress() {
+    if (!slideOpenTask_) {
+        return;
+    }
+
+    // Bottom centre, clear of the preview
+    ImGui::SetNextWindowPos(
+        ImVec2(windowWidth_ * 0.5f, windowHeight_ - STATUS_BAR_HEIGHT - 16.0f),
+        ImGuiCond_Always,
+        ImVec2(0.5f, 1.0f));
+    ImGui::SetNextWindowBgAlpha(0.85f);
+
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration |
+                             ImGuiWindowFlags_AlwaysAutoResize |
+                             ImGuiWindowFlags_NoMove |
+                             ImGuiWindowFlags_NoSavedSettings |
+                             ImGuiWindowFlags_NoFocusOnAppearing;
+
+    if (ImGui::Begin("##SlideOpenProgress", nullptr, flags)) {
+        ImGui::Text(ICON_FA_SPINNER "  %s: %s... (%.1f s)",
+                    std::filesystem::path(slideOpenTask_->GetPath()).filename().string().c_str(),
+                    SlideOpenStageName(slideOpenTask_->GetStage()),
+                    slideOpenTask_->GetElapsedSeconds());
+    }
+    ImGui::End();
+}
+
+void Application::RegisterMemoryAccounting() {
+    // Subsystems are looked up on every poll since slides replace the
+    // renderer and minimap. Reclaimers run in this order, so free memory
+    // (idle buffers) goes first and compressed tiles, which cost a decode
+    // to get back, go last.
+    memoryRegistry_.Register("Tile buffers (idle)",
+        [this]() { return slideRenderer_ ? slideRenderer_->GetBufferPoolStats().idleBytes : 0; },
+        [this](size_t) { return slideRenderer_ ? slideRenderer_->TrimBufferPool() : 0; });
+    memoryRegistry_.Register("Textures",
+        [this]() { return textureManager_ ? textureManager_->GetMemoryUsage() : 0; },
+        [this](size_t bytes) { return textureManager_ ? textureManager_->Trim(bytes) : 0; });
+    memoryRegistry_.Register("Tile cache",
+        [this]() { return slideRenderer_ ? slideRenderer_->GetCacheMemoryUsage() : 0; },
+        [this](size_t bytes) { return slideRenderer_ ? slideRenderer_->ShrinkCache(bytes) : 0; });
+    memoryRegistry_.Register("Compressed tiles",
+        [this]() {
+            const CompressedTileCache* tier = slideRenderer_ ? slideRenderer_->GetCompressedTier() : nullptr;
+            return tier ? tier->GetMemoryUsage() : 0;
+        },
+        [this](size_t bytes) { return slideRenderer_ ? slideRenderer_->TrimCompressedCache(bytes) : 0; });
+    memoryRegistry_.Register("Polygon vertices",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetVertexMemoryUsage); });
+    memoryRegistry_.Register("Polygon triangles",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetTriangleMemoryUsage); });
+    memoryRegistry_.Register("Spatial index",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetIndexMemoryUsage); });
+    memoryRegistry_.Register("Polygon density",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetDensityMemoryUsage); });
+    memoryRegistry_.Register("Polygon geometry",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetGeometryMemoryUsage); });
+    memoryRegistry_.Register("Polygon tiles",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetTileMemoryUsage); },
+        [this](size_t bytes) {
+            size_t trimmed = 0;
+            for (PolygonLayer& layer : polygonLayers_) {
+                trimmed += layer.overlay->TrimTiles(bytes - std::min(bytes, trimmed));
+            }
+            return trimmed;
+        });
+    memoryRegistry_.Register("Tissue map",
+        [this]() { return SumPolygonLayers(&PolygonOverlay::GetTissueMemoryUsage); });
+    memoryRegistry_.Register("Heatmap",
+        [this]() { return heatmapLayer_ ? heatmapLayer_->GetMemoryUsage() : 0; });
+    memoryRegistry_.Register("Minimap texture",
+        [this]() { return minimap_ ? minimap_->GetTextureMemoryUsage() : 0; });
+    memoryRegistry_.Register("Screenshot buffer",
+        [this]() { return screenshotBuffer_ ? screenshotBuffer_->GetMemoryUsage() : 0; });
+}
+
+void Application::SetCompareView(bool enabled) {
+    compareEnabled_ = enabled;
+    if (!viewport_) {
+        compareViewport_.reset();
+        return;
+    }
+
+    // The main view keeps its center while its width halves or doubles
+    Vec2 center = viewport_->ScreenToSlide(Vec2(viewport_->GetWindowWidth() / 2.0,
+                                                viewport_->GetWindowHeight() / 2.0));
+    if (!enabled) {
+        compareViewport_.reset();
+    } else if (!compareViewport_) {
+        compareViewport_ = std::make_unique<Viewport>(windowWidth_, windowHeight_,
+                                                      viewport_->GetSlideWidth(), viewport_->GetSlideHeight());
+    }
+    LayoutViews();
+    viewport_->SetView(center, viewport_->GetZoom());
+    RequestRedraw();
+}
+
+void Application::LayoutViews() {
+    if (!viewport_) {
+        return;
+    }
+    if (!compareViewport_) {
+        viewport_->SetWindowSize(windowWidth_, windowHeight_);
+        return;
+    }
+    const int split = std::max(1, (windowWidth_ - COMPARE_DIVIDER_WIDTH) / 2);
+    viewport_->SetWindowSize(split, windowHeight_);
+    compareViewport_->SetWindowSize(std::max(1, windowWidth_ - split - COMPARE_DIVIDER_WIDTH), windowHeight_);
+}
+
+pathview::ipc::json Application::DescribeCompareView() const {
+    return pathview::ipc::json{
+        {"enabled", compareEnabled_},
+        {"zoom_ratio", compareLink_.GetZoomRatio()}
+    };
+}
+
+void Application::UpdateTissueMask() {
+    if (!slideRenderer_) {
+        return;
+    }
+    const TissueMap* map = polygonOverlay_ && polygonOverlay_->HasTissueMap()
+        ? polygonOverlay_->GetTissueLayer().GetMap()
+        : nullptr;
+    if (map == tissueMaskSource_) {
+        return;
+    }
+
+    TissueMask mask = overviewTissueMask_;
+    if (map) {
+        mask.ApplyTissueMap(*map);
+    }
+    slideRenderer_->SetTissueMask(std::move(mask));
+    tissueMaskSource_ = map;
+    InvalidateScene();
+    RequestRedraw();
+}
+
+void Application::UpdatePowerSource() {
+    Uint32 now = SDL_GetTicks();
+    if (!batteryThrottling_ || (powerChecked_ && now - lastPowerCheck_ < POWER_CHECK_MS)) {
+        return;
+    }
+    powerChecked_ = true;
+    lastPowerCheck_ = now;
+
+    bool onBattery = SDL_GetPowerInfo(nullptr, nullptr) == SDL_POWERSTATE_ON_BATTERY;
+    if (onBattery == onBattery_) {
+        return;
+    }
+    onBattery_ = onBattery;
+    PATHVIEW_LOG_INFO("Power: " << (onBattery_ ? "on battery, throttling prefetch" : "on AC power, full prefetch"));
+    if (slideRenderer_) {
+        slideRenderer_->SetPrefetchLimit(GetPrefetchLimit());
+    }
+}
+
+size_t Application::GetPrefetchLimit() const {
+    return onBattery_ ? BATTERY_PREFETCH_TILES_PER_FRAME : SIZE_MAX;  // The renderer's own cap
+}
+
+void Application::UpdateMemoryPressure() {
+    Uint32 now = SDL_GetTicks();
+    if (!slideRenderer_ || tileCacheTargetBytes_ == 0 ||
+        now - lastMemoryPressureCheck_ < MEMORY_PRESSURE_CHECK_MS) {
+        return;
+    }
+    lastMemoryPressureCheck_ = now;
+
+    size_t available = MemoryRegistry::GetAvailableMemoryBytes();
+    if (available == 0) {
+        return;  // Not reported on this platform
+    }
+    size_t lowWater = std::max(LOW_MEMORY_MIN_BYTES, MemoryRegistry::GetPhysicalMemoryBytes() / 20);
+    size_t limit = slideRenderer_->GetCacheMaxMemory();
+    bool wasUnderPressure = memoryPressure_;
+    memoryPressure_ = available < lowWater;
+
+    if (memoryPressure_) {
+        // Give back what the OS is short of, at most a quarter of the cache
+        // per check; the renderer evicts it over the next frames
+        size_t shortfall = lowWater - available;
+        slideRenderer_->ShrinkCache(std::min(shortfall, slideRenderer_->GetCacheMemoryUsage() / 4));
+        if (!wasUnderPressure) {
+            PATHVIEW_LOG_INFO("Memory pressure: " << (available / (1024 * 1024))
+                              << " MB available, shrinking tile cache");
+        }
+        return;
+    }
+
+    // Grow back in eighths once there is headroom again, unless that would
+    // run straight into the global memory budget
+    size_t budget = memoryRegistry_.GetBudget();
+    bool nearBudget = budget > 0 && memoryRegistry_.GetTotalBytes() > budget / 10 * 9;
+    if (limit < tileCacheTargetBytes_ && available > 2 * lowWater && !nearBudget) {
+        slideRenderer_->SetCacheMaxMemory(std::min(tileCacheTargetBytes_, limit + tileCacheTargetBytes_ / 8));
+    }
+}
+
+void Application::RenderMemoryInfo() {
+    if (!ImGui::CollapsingHeader("Memory")) {
+        return;
+    }
+
+    constexpr double MB = 1024.0 * 1024.0;
+    ImGui::Text("  %-20s %9s %9s", "subsystem", "live MB", "peak MB");
+    for (const MemoryRegistry::Entry& entry : memoryRegistry_.GetEntries()) {
+        ImGui::Text("  %-20s %9.1f %9.1f", entry.name.c_str(),
+                    entry.liveBytes / MB, entry.peakBytes / MB);
+    }
+    ImGui::Text("  %-20s %9.1f %9.1f", "Total",
+                memoryRegistry_.GetTotalBytes() / MB, memoryRegistry_.GetPeakTotalBytes() / MB);
+    ImGui::Text("  Process resident: %.1f MB", MemoryRegistry::GetProcessResidentBytes() / MB);
+    if (memoryRegistry_.GetBudget() > 0) {
+        ImGui::Text("  Budget: %.0f MB (%.1f MB reclaimed over %zu frames)",
+                    memoryRegistry_.GetBudget() / MB,
+                    memoryRegistry_.GetReclaimedBytes() / MB,
+                    memoryRegistry_.GetPressureEventCount());
+    } else {
+        ImGui::Text("  Budget: unlimited");
+    }
+}
+
 void Application::RenderSlideInfoTab() {
     if (!slideLoader_ || !slideLoader_->IsValid()) {
         ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "No slide loaded");
@@ -924,6 +3783,26 @@ void Application::RenderSlideInfoTab() {
                 slideLoader_->GetWidth(),
                 slideLoader_->GetHeight());
     ImGui::Text("Levels: %d", slideLoader_->GetLevelCount());
+    std::shared_ptr<const SlideMetadata> metadata = slideLoader_->GetMetadata();
+    ImGui::Text("Vendor: %s", metadata->vendor.c_str());
+    if (metadata->mppX > 0.0) {
+        ImGui::Text("Resolution: %.4f x %.4f um/pixel", metadata->mppX, metadata->mppY);
+    }
+    if (metadata->objectivePower > 0.0) {
+        ImGui::Text("Objective: %gx", metadata->objectivePower);
+    }
+    if (!metadata->associatedImages.empty()) {
+        std::string names;
+        for (const SlideMetadata::AssociatedImage& image : metadata->associatedImages) {
+            names += (names.empty() ? "" : ", ") + image.name;
+        }
+        ImGui::Text("Associated images: %s", names.c_str());
+    }
+
+    if (channelCompositor_) {
+        RenderChannelControls();
+    }
+    RenderColorControls();
 
     if (viewport_) {
         ImGui::Separator();
@@ -935,21 +3814,266 @@ void Application::RenderSlideInfoTab() {
     }
 
     if (slideRenderer_) {
+        ImGui::Separator();
+        bool coarser = levelSelection_ == LevelSelection::CoarserOrEqual;
+        if (ImGui::Checkbox("Coarser level + linear filter", &coarser)) {
+            SetLevelSelection(coarser ? LevelSelection::CoarserOrEqual : LevelSelection::Closest);
+        }
+        int motionLevels = motionLevels_;
+        if (ImGui::SliderInt("Coarser levels while moving", &motionLevels, 0, 2)) {
+            SetMotionLevels(motionLevels);
+        }
+        float renderScales[2] = {static_cast<float>(renderScale_), static_cast<float>(movingRenderScale_)};
+        if (ImGui::SliderFloat2("Render scale (still, moving)", renderScales, 0.25f, 2.0f, "%.2fx")) {
+            SetRenderScale(renderScales[0], renderScales[1]);
+        }
+        ImGui::Text("  Decoded: %.2f MB last frame (%.0f MB total)",
+                    slideRenderer_->GetDecodedBytesLastFrame() / (1024.0 * 1024.0),
+                    slideRenderer_->GetDecodedBytesTotal() / (1024.0 * 1024.0));
+
         ImGui::Separator();
         ImGui::Text("Tile Cache:");
-        ImGui::Text("  Tiles: %zu", slideRenderer_->GetCacheTileCount());
-        ImGui::Text("  Memory: %.1f MB",
-                    slideRenderer_->GetCacheMemoryUsage() / (1024.0 * 1024.0));
+        ImGui::Text("  Tiles: %zu (%zu solid, %zu drawn flat)", slideRenderer_->GetCacheTileCount(),
+                    tileCache_ ? tileCache_->GetSolidTileCount() : 0, slideRenderer_->GetSolidTileCount());
+        ImGui::Text("  Memory: %.1f / %.0f MB%s",
+                    slideRenderer_->GetCacheMemoryUsage() / (1024.0 * 1024.0),
+                    slideRenderer_->GetCacheMaxMemory() / (1024.0 * 1024.0),
+                    memoryPressure_ ? " (memory pressure)" : "");
+        if (const CompressedTileCache* tier = slideRenderer_->GetCompressedTier(); tier && tier->IsEnabled()) {
+            size_t tierLookups = tier->GetHitCount() + tier->GetMissCount();
+            ImGui::Text("  Compressed: %zu tiles, %.0f / %.0f MB (%.1fx, %.1f%% hits)",
+                        tier->GetTileCount(),
+                        tier->GetMemoryUsage() / (1024.0 * 1024.0),
+                        tier->GetMaxBytes() / (1024.0 * 1024.0),
+                        tier->GetCompressionRatio(),
+                        tierLookups > 0 ? 100.0 * tier->GetHitCount() / tierLookups : 0.0);
+        }
         ImGui::Text("  Hit rate: %.1f%%",
                     slideRenderer_->GetCacheHitRate() * 100.0);
+        ImGui::Text("  Queued loads: %zu (%zu stale dropped)",
+                    slideRenderer_->GetPendingTileCount(),
+                    slideRenderer_->GetDroppedTileCount());
+        ImGui::Text("  Decoders: %zu / %zu (%.1f ms/tile)",
+                    slideRenderer_->GetActiveWorkerLimit(),
+                    slideRenderer_->GetWorkerThreadCount(),
+                    slideRenderer_->GetAverageDecodeMs());
+        ImGui::Text("  Coalesced reads: %zu (%zu tiles)",
+                    slideRenderer_->GetCoalescedReadCount(),
+                    slideRenderer_->GetCoalescedTileCount());
+        ImGui::Text("  Uploads: %zu this frame (%.1f ms, %zu deferred)",
+                    textureManager_->GetFrameUploadCount(),
+                    textureManager_->GetFrameUploadMs(),
+                    slideRenderer_->GetDeferredUploadCount());
+        ImGui::Text("  Draw calls: %zu for %zu tiles (%zu atlas pages)",
+                    slideRenderer_->GetDrawCallCount(),
+                    slideRenderer_->GetDrawnQuadCount(),
+                    textureManager_->GetAtlasPageCount());
+        ImGui::Text("  Fallbacks: %zu quads (plan built %zu times)",
+                    slideRenderer_->GetFallbackQuadCount(),
+                    slideRenderer_->GetFallbackPlanBuildCount());
+        ImGui::Text("  Scene: drawn %llu times, reused %llu, scrolled %llu",
+                    static_cast<unsigned long long>(sceneRedraws_),
+                    static_cast<unsigned long long>(sceneReuses_),
+                    static_cast<unsigned long long>(sceneScrolls_));
+        if (diskTileCache_) {
+            size_t diskLookups = diskTileCache_->GetHitCount() + diskTileCache_->GetMissCount();
+            ImGui::Text("  Disk cache: %.0f / %.0f MB (%.1f%% hits)",
+                        diskTileCache_->GetDiskUsage() / (1024.0 * 1024.0),
+                        diskTileCache_->GetMaxBytes() / (1024.0 * 1024.0),
+                        diskLookups > 0 ? 100.0 * diskTileCache_->GetHitCount() / diskLookups : 0.0);
+        }
+        if (slideLoader_) {
+            ImGui::Text("  Read handles: %zu (%zu read errors)",
+                        slideLoader_->GetReadHandleCount(),
+                        slideLoader_->GetReadErrorCount());
+            if (slideLoader_->IsDirectTiffReadActive()) {
+                ImGui::Text("  Direct TIFF reads%s: %zu (%zu fell back to OpenSlide, %zu GPU tiles)",
+                            slideLoader_->IsDirectTiffMapped() ? " (mmap)" : "",
+                            slideLoader_->GetDirectReadCount(),
+                            slideLoader_->GetDirectFallbackCount(),
+                            slideLoader_->GetHardwareDecodeCount());
+                if (slideLoader_->GetScaledReadCount() > 0) {
+                    ImGui::Text("  Reduced-resolution decodes: %zu", slideLoader_->GetScaledReadCount());
+                }
+            }
+            if (const RemoteFile* remote = slideLoader_->GetRemoteFile()) {
+                size_t blockLookups = remote->GetBlockHits() + remote->GetBlockMisses();
+                ImGui::Text("  Remote: %zu requests, %.1f MB fetched, %.0f / %.0f MB cached (%.1f%% hits)",
+                            remote->GetRequestCount(),
+                            remote->GetFetchedBytes() / (1024.0 * 1024.0),
+                            remote->GetCachedBytes() / (1024.0 * 1024.0),
+                            remote->GetCacheCapacity() / (1024.0 * 1024.0),
+                            blockLookups > 0 ? 100.0 * remote->GetBlockHits() / blockLookups : 0.0);
+            }
+        }
+
+        TileBufferPool::Stats poolStats = slideRenderer_->GetBufferPoolStats();
+        double poolReuse = poolStats.acquireCount > 0
+            ? static_cast<double>(poolStats.reuseCount) / poolStats.acquireCount : 0.0;
+        ImGui::Text("  Buffers: %.1f MB live, %.1f MB idle",
+                    poolStats.liveBytes / (1024.0 * 1024.0),
+                    poolStats.idleBytes / (1024.0 * 1024.0));
+        if (poolStats.slabBytes > 0) {
+            ImGui::Text("  Buffer slabs: %.1f MB, %.0f%% on huge pages",
+                        poolStats.slabBytes / (1024.0 * 1024.0),
+                        100.0 * poolStats.hugePageBytes / poolStats.slabBytes);
+        }
+        ImGui::Text("  Buffer reuse: %.1f%%", poolReuse * 100.0);
+
+        // Where a slow pan spends its time: queueing (lock/backlog bound),
+        // decoding, or uploading
+        if (ImGui::CollapsingHeader("Tile Pipeline Latency")) {
+            TilePipelineStats& stats = slideRenderer_->GetPipelineStats();
+            ImGui::Text("  %-13s %8s %9s %9s %9s", "stage", "count", "p50 ms", "p99 ms", "max ms");
+            for (size_t i = 0; i < TilePipelineStats::STAGE_COUNT; ++i) {
+                TileStage stage = static_cast<TileStage>(i);
+                const LatencyHistogram& histogram = stats.Get(stage);
+                ImGui::Text("  %-13s %8llu %9.2f %9.2f %9.2f",
+                            TilePipelineStats::StageName(stage),
+                            static_cast<unsigned long long>(histogram.GetCount()),
+                            histogram.GetPercentile(0.50) / 1000.0,
+                            histogram.GetPercentile(0.99) / 1000.0,
+                            histogram.GetMax() / 1000.0);
+            }
+            if (ImGui::SmallButton("Reset latency stats")) {
+                stats.Reset();
+            }
+            const TileScheduler& scheduler = slideRenderer_->GetScheduler();
+            ImGui::Text("  Scheduled: %zu missing, %llu past the %.0f ms deadline",
+                        scheduler.GetDecisions().size(),
+                        static_cast<unsigned long long>(scheduler.GetDeadlineMissCount()),
+                        scheduler.GetDeadlineMs());
+        }
+    }
+
+    if (textureManager_) {
+        ImGui::Separator();
+        ImGui::Text("Texture Cache:");
+        ImGui::Text("  Backend: %s", renderBackend_->GetName());
+        ImGui::Text("  Textures: %zu (%s)", textureManager_->GetCacheSize(),
+                    TextureCompressionName(textureManager_->GetCompression()));
+        ImGui::Text("  VRAM: %.1f / %.0f MB",
+                    textureManager_->GetMemoryUsage() / (1024.0 * 1024.0),
+                    textureManager_->GetMaxMemory() / (1024.0 * 1024.0));
+        ImGui::Text("  Hit rate: %.1f%%",
+                    textureManager_->GetHitRate() * 100.0);
+        ImGui::Text("  Evictions: %zu", textureManager_->GetEvictionCount());
+    }
+
+    RenderMemoryInfo();
+
+    ImGui::Separator();
+    if (slideRenderer_) {
+        // Rendered pyramid, including levels synthesized from finer tiles
+        const PyramidLayout& pyramid = slideRenderer_->GetPyramid();
+        for (int i = 0; i < pyramid.GetLevelCount(); ++i) {
+            auto dims = pyramid.GetLevelDimensions(i);
+            ImGui::Text("  Level %d: %lld x %lld (%.1fx, %dx%d tiles)%s",
+                        i, dims.width, dims.height, pyramid.GetLevelDownsample(i),
+                        pyramid.GetTileWidth(i), pyramid.GetTileHeight(i),
+                        pyramid.IsSynthesized(i) ? " synthesized" : "");
+        }
+    } else {
+        for (int i = 0; i < slideLoader_->GetLevelCount(); ++i) {
+            auto dims = slideLoader_->GetLevelDimensions(i);
+            double downsample = slideLoader_->GetLevelDownsample(i);
+            ImGui::Text("  Level %d: %lld x %lld (%.1fx)",
+                        i, dims.width, dims.height, downsample);
+        }
+    }
+}
+
+void Application::ApplyColorAdjustment(const Viewport& viewport, const SDL_Rect& pane) {
+    if (colorAdjustment_.IsIdentity() || !colorAdjustmentSupported_) {
+        return;
+    }
+
+    // The slide's extent on screen, within the pane
+    Vec2 topLeft = viewport.SlideToScreen(Vec2(0.0, 0.0));
+    Vec2 bottomRight = viewport.SlideToScreen(Vec2(static_cast<double>(slideLoader_->GetWidth()),
+                                                   static_cast<double>(slideLoader_->GetHeight())));
+    int x0 = std::max(0, static_cast<int>(std::floor(topLeft.x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(topLeft.y)));
+    int x1 = std::min(viewport.GetWindowWidth(), static_cast<int>(std::ceil(bottomRight.x)));
+    int y1 = std::min(viewport.GetWindowHeight(), static_cast<int>(std::ceil(bottomRight.y)));
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    bool paned = pane.w > 0 && pane.h > 0;
+    if (paned) {
+        SDL_RenderSetViewport(renderer_, &pane);
+    }
+    SDL_Rect rect = {x0, y0, x1 - x0, y1 - y0};
+    if (!colorAdjustment_.Apply(renderer_, &rect)) {
+        PATHVIEW_LOG_ERROR("Application: Colour adjustment unavailable: the renderer lacks its blend modes");
+        colorAdjustmentSupported_ = false;
+    }
+    if (paned) {
+        SDL_RenderSetViewport(renderer_, nullptr);
+    }
+}
+
+void Application::RenderColorControls() {
+    ImGui::Separator();
+    if (!ImGui::CollapsingHeader("Colour")) {
+        return;
+    }
+    if (!colorAdjustmentSupported_) {
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Not supported by this renderer");
+        return;
+    }
+
+    // Applied to the drawn frame: nothing is decoded or uploaded again
+    bool changed = false;
+    changed |= ImGui::SliderFloat("Brightness", &colorAdjustment_.brightness, -1.0f, 1.0f, "%.2f");
+    changed |= ImGui::SliderFloat("Contrast", &colorAdjustment_.contrast, 0.0f, 4.0f, "%.2f");
+    changed |= ImGui::SliderFloat3("RGB gain", colorAdjustment_.gain, 0.0f, 2.0f, "%.2f");
+    if (ImGui::Button("Reset colour")) {
+        colorAdjustment_ = ColorAdjustment();
+        changed = true;
     }
+    if (changed) {
+        InvalidateScene();
+        RequestRedraw();
+    }
+}
 
+void Application::RenderChannelControls() {
     ImGui::Separator();
-    for (int i = 0; i < slideLoader_->GetLevelCount(); ++i) {
-        auto dims = slideLoader_->GetLevelDimensions(i);
-        double downsample = slideLoader_->GetLevelDownsample(i);
-        ImGui::Text("  Level %d: %lld x %lld (%.1fx)",
-                    i, dims.width, dims.height, downsample);
+    if (!ImGui::CollapsingHeader("Channels", ImGuiTreeNodeFlags_DefaultOpen)) {
+        return;
+    }
+
+    // Every change redraws from the channels' resident textures
+    const uint64_t revision = channelCompositor_->GetRevision();
+    for (size_t i = 0; i < channelCompositor_->GetChannelCount(); ++i) {
+        ImGui::PushID(static_cast<int>(i));
+        bool shown = channelCompositor_->IsVisible(i);
+        if (ImGui::Checkbox("##shown", &shown)) {
+            channelCompositor_->SetVisible(i, shown);
+        }
+        ImGui::SameLine();
+        uint32_t color = channelCompositor_->GetColor(i);
+        float rgb[3] = {((color >> 16) & 0xFF) / 255.0f, ((color >> 8) & 0xFF) / 255.0f, (color & 0xFF) / 255.0f};
+        if (ImGui::ColorEdit3("##color", rgb, ImGuiColorEditFlags_NoInputs)) {
+            channelCompositor_->SetColor(i, (static_cast<uint32_t>(rgb[0] * 255.0f + 0.5f) << 16) |
+                                            (static_cast<uint32_t>(rgb[1] * 255.0f + 0.5f) << 8) |
+                                            static_cast<uint32_t>(rgb[2] * 255.0f + 0.5f));
+        }
+        ImGui::SameLine();
+        float gain = channelCompositor_->GetGain(i);
+        ImGui::SetNextItemWidth(100.0f);
+        if (ImGui::SliderFloat("##gain", &gain, 0.0f, SlideRenderer::MAX_CHANNEL_GAIN, "%.2fx",
+                               ImGuiSliderFlags_Logarithmic)) {
+            channelCompositor_->SetGain(i, gain);
+        }
+        ImGui::SameLine();
+        ImGui::TextUnformatted(channelCompositor_->GetName(i).c_str());
+        ImGui::PopID();
+    }
+    if (channelCompositor_->GetRevision() != revision) {
+        RequestRedraw();
     }
 }
 
@@ -960,6 +4084,35 @@ void Application::RenderPolygonTab() {
         return;
     }
 
+    // Layers: pick the one the controls below act on, show or hide any
+    if (polygonLayers_.size() > 1) {
+        ImGui::Text("Layers");
+        size_t removeLayer = polygonLayers_.size();
+        for (size_t i = 0; i < polygonLayers_.size(); ++i) {
+            PolygonOverlay& overlay = *polygonLayers_[i].overlay;
+            const std::string& path = polygonLayers_[i].path;
+            ImGui::PushID(static_cast<int>(i));
+            bool shown = overlay.IsVisible();
+            if (ImGui::Checkbox("##shown", &shown)) {
+                overlay.SetVisible(shown);
+            }
+            ImGui::SameLine();
+            const std::string name = path.empty() ? "(empty)" : std::filesystem::path(path).filename().string();
+            if (ImGui::RadioButton(name.c_str(), i == activePolygonLayer_)) {
+                SelectPolygonLayer(i);
+            }
+            ImGui::SameLine();
+            if (ImGui::SmallButton("x")) {
+                removeLayer = i;
+            }
+            ImGui::PopID();
+        }
+        if (removeLayer < polygonLayers_.size()) {
+            RemovePolygonLayer(removeLayer);
+        }
+        ImGui::Separator();
+    }
+
     // Visibility checkbox
     bool visible = polygonOverlay_->IsVisible();
     if (ImGui::Checkbox("Show Polygons", &visible)) {
@@ -972,24 +4125,151 @@ void Application::RenderPolygonTab() {
         polygonOverlay_->SetOpacity(opacity);
     }
 
+    // Confidence threshold: cells below it are hidden
+    float minConfidence = polygonOverlay_->GetMinConfidence();
+    if (ImGui::SliderFloat("Min Confidence", &minConfidence, 0.0f, 1.0f, "%.2f")) {
+        polygonOverlay_->SetMinConfidence(minConfidence);
+    }
+
+    // Contours instead of fills, so the stain shows through; widths per
+    // class in the legend
+    bool outlines = polygonOverlay_->IsOutlineMode();
+    if (ImGui::Checkbox("Outlines Only", &outlines)) {
+        polygonOverlay_->SetOutlineMode(outlines);
+    }
+
+    // Hot spots on the minimap, a click away, without zooming the view out
+    if (ImGui::Checkbox("Density on Minimap", &minimapDensity_)) {
+        minimapDensityDirty_ = true;
+    }
+    if (minimapDensity_ && !polygonOverlay_->GetClassIds().empty()) {
+        const std::string preview =
+            minimapDensityClass_ == -1 ? "Visible classes" : polygonOverlay_->GetClassName(minimapDensityClass_);
+        if (ImGui::BeginCombo("Minimap Class", preview.c_str())) {
+            if (ImGui::Selectable("Visible classes", minimapDensityClass_ == -1)) {
+                minimapDensityClass_ = -1;
+                minimapDensityDirty_ = true;
+            }
+            for (int classId : polygonOverlay_->GetClassIds()) {
+                ImGui::PushID(classId);
+                if (ImGui::Selectable(polygonOverlay_->GetClassName(classId).c_str(),
+                                      minimapDensityClass_ == classId)) {
+                    minimapDensityClass_ = classId;
+                    minimapDensityDirty_ = true;
+                }
+                ImGui::PopID();
+            }
+            ImGui::EndCombo();
+        }
+    }
+
+    if (polygonOverlay_->IsLoading()) {
+        ImGui::Separator();
+        ImGui::Text("Loading polygons...");
+        ImGui::ProgressBar(polygonOverlay_->GetLoadProgress());
+    }
+
     // Color controls (only when polygons loaded)
     if (polygonOverlay_->GetPolygonCount() > 0) {
         ImGui::Separator();
         ImGui::Text("Class Colors:");
 
-        for (int classId : polygonOverlay_->GetClassIds()) {
-            SDL_Color color = polygonOverlay_->GetClassColor(classId);
-            ImVec4 imColor(color.r / 255.0f,
-                          color.g / 255.0f,
-                          color.b / 255.0f,
-                          1.0f);
-
-            ImGui::PushID(classId);
-            std::string className = polygonOverlay_->GetClassName(classId);
-            if (ImGui::ColorEdit3(className.c_str(),
-                                  (float*)&imColor,
-                                  ImGuiColorEditFlags_NoInputs)) {
-                polygonOverlay_->SetClassColor(classId, {
+        // Class names change with the overlay's revision only
+        const std::vector<int>& classIds = polygonOverlay_->GetClassIds();
+        if (polygonClassLabelsRevision_ != polygonOverlay_->GetRevision() ||
+            polygonClassLabels_.size() != classIds.size()) {
+            polygonClassLabels_.clear();
+            for (int classId : classIds) {
+                polygonClassLabels_.push_back(polygonOverlay_->GetClassName(classId));
+            }
+            polygonClassLabelsRevision_ = polygonOverlay_->GetRevision();
+        }
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(classIds.size()));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const int classId = classIds[static_cast<size_t>(row)];
+                SDL_Color color = polygonOverlay_->GetClassColor(classId);
+                ImVec4 imColor(color.r / 255.0f,
+                              color.g / 255.0f,
+                              color.b / 255.0f,
+                              1.0f);
+
+                ImGui::PushID(classId);
+                bool shown = polygonOverlay_->IsClassVisible(classId);
+                if (ImGui::Checkbox("##shown", &shown)) {
+                    polygonOverlay_->SetClassVisible(classId, shown);
+                }
+                ImGui::SameLine();
+                if (ImGui::ColorEdit3(polygonClassLabels_[static_cast<size_t>(row)].c_str(),
+                                      (float*)&imColor,
+                                      ImGuiColorEditFlags_NoInputs)) {
+                    polygonOverlay_->SetClassColor(classId, {
+                        static_cast<uint8_t>(imColor.x * 255),
+                        static_cast<uint8_t>(imColor.y * 255),
+                        static_cast<uint8_t>(imColor.z * 255),
+                        255
+                    });
+                }
+                if (outlines) {
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(60.0f);
+                    float width = polygonOverlay_->GetClassOutlineWidth(classId);
+                    if (ImGui::DragFloat("##width", &width, 0.05f, 0.5f, PolygonOverlay::MAX_OUTLINE_WIDTH, "%.1f px")) {
+                        polygonOverlay_->SetClassOutlineWidth(classId, width);
+                    }
+                }
+                ImGui::PopID();
+            }
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Polygons: %d", polygonOverlay_->GetPolygonCount());
+
+        // Cell picked by clicking it on the slide
+        if (selectedPolygon_ < static_cast<uint32_t>(polygonOverlay_->GetPolygonCount())) {
+            const PolygonStore& polygons = polygonOverlay_->GetPolygons();
+            const int classId = polygons.GetClassId(selectedPolygon_);
+            const Vec2 centroid = polygons.GetCentroid(selectedPolygon_);
+            ImGui::Separator();
+            ImGui::Text("Selected cell %u", selectedPolygon_);
+            ImGui::Text("Class: %s (%d)", polygonOverlay_->GetClassName(classId).c_str(), classId);
+            ImGui::Text("Confidence: %.3f", polygons.GetConfidence(selectedPolygon_));
+            ImGui::Text("Area: %.0f px", polygons.GetArea(selectedPolygon_));
+            ImGui::Text("Centroid: (%.0f, %.0f)", centroid.x, centroid.y);
+            if (ImGui::Button("Clear Selection")) {
+                selectedPolygon_ = PolygonPicker::NO_POLYGON;
+            }
+        }
+    }
+
+    // Tissue segmentation under the cells, if the file has one
+    if (polygonOverlay_->HasTissueMap()) {
+        TissueLayer& tissue = polygonOverlay_->GetTissueLayer();
+        ImGui::Separator();
+        bool tissueVisible = polygonOverlay_->IsTissueVisible();
+        if (ImGui::Checkbox("Show Tissue", &tissueVisible)) {
+            polygonOverlay_->SetTissueVisible(tissueVisible);
+        }
+        float tissueOpacity = polygonOverlay_->GetTissueOpacity();
+        if (ImGui::SliderFloat("Tissue Opacity", &tissueOpacity, 0.0f, 1.0f, "%.2f")) {
+            polygonOverlay_->SetTissueOpacity(tissueOpacity);
+        }
+
+        for (int label : tissue.GetClassIds()) {
+            SDL_Color color = tissue.GetClassColor(label);
+            ImVec4 imColor(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, 1.0f);
+
+            ImGui::PushID(1000 + label);
+            bool shown = tissue.IsClassVisible(label);
+            if (ImGui::Checkbox("##shown", &shown)) {
+                tissue.SetClassVisible(label, shown);
+            }
+            ImGui::SameLine();
+            std::string className = tissue.GetClassName(label);
+            if (ImGui::ColorEdit3(className.c_str(), (float*)&imColor, ImGuiColorEditFlags_NoInputs)) {
+                tissue.SetClassColor(label, {
                     static_cast<uint8_t>(imColor.x * 255),
                     static_cast<uint8_t>(imColor.y * 255),
                     static_cast<uint8_t>(imColor.z * 255),
@@ -998,15 +4278,232 @@ void Application::RenderPolygonTab() {
             }
             ImGui::PopID();
         }
+    }
 
-        ImGui::Separator();
-        ImGui::Text("Polygons: %d", polygonOverlay_->GetPolygonCount());
-    } else {
+    if (polygonOverlay_->GetPolygonCount() == 0 && !polygonOverlay_->IsLoading()) {
         ImGui::Separator();
         ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f),
                           "No polygons loaded");
         ImGui::Text("Use File -> Load Polygons...");
     }
+
+    RenderHeatmapControls();
+}
+
+void Application::RenderHeatmapControls() {
+    if (!heatmapLayer_ || !heatmapLayer_->HasHeatmap()) {
+        return;
+    }
+    HeatmapLayer& heatmap = *heatmapLayer_;
+    const HeatmapGrid& grid = heatmap.GetPyramid()->GetGrid();
+    ImGui::Separator();
+    ImGui::Text("Heatmap: %s", std::filesystem::path(heatmap.GetPath()).filename().string().c_str());
+    ImGui::Text("%lld x %lld cells", static_cast<long long>(grid.GetWidth()),
+                static_cast<long long>(grid.GetHeight()));
+
+    bool visible = heatmap.IsVisible();
+    if (ImGui::Checkbox("Show Heatmap", &visible)) {
+        heatmap.SetVisible(visible);
+    }
+    float opacity = heatmap.GetOpacity();
+    if (ImGui::SliderFloat("Heatmap Opacity", &opacity, 0.0f, 1.0f, "%.2f")) {
+        heatmap.SetOpacity(opacity);
+    }
+
+    // Mapping changes re-upload the tiles in view: apply them on release
+    const float naturalMax = grid.GetNaturalMax();
+    float threshold = heatmap.GetThreshold();
+    ImGui::SliderFloat("Threshold", &threshold, 0.0f, naturalMax, "%.2f");
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        heatmap.SetThreshold(threshold);
+    }
+    float range[2] = {heatmap.GetRangeLow(), heatmap.GetRangeHigh()};
+    ImGui::SliderFloat2("Range", range, 0.0f, naturalMax, "%.2f");
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        heatmap.SetRange(std::min(range[0], range[1]), std::max(range[0], range[1]));
+    }
+
+    int colormap = static_cast<int>(heatmap.GetColormap());
+    if (ImGui::BeginCombo("Colormap", HeatmapLayer::GetColormapName(heatmap.GetColormap()))) {
+        for (int i = 0; i < HeatmapLayer::COLORMAP_COUNT; ++i) {
+            const auto option = static_cast<HeatmapLayer::Colormap>(i);
+            if (ImGui::Selectable(HeatmapLayer::GetColormapName(option), i == colormap)) {
+                heatmap.SetColormap(option);
+            }
+        }
+        ImGui::EndCombo();
+    }
+    // Zoomed out, a coarse texel shows the highest (or lowest) cell under it
+    bool showMin = heatmap.GetReduction() == HeatmapLayer::Reduction::Min;
+    if (ImGui::Checkbox("Show Minimum When Zoomed Out", &showMin)) {
+        heatmap.SetReduction(showMin ? HeatmapLayer::Reduction::Min : HeatmapLayer::Reduction::Max);
+    }
+    if (ImGui::Button("Remove Heatmap")) {
+        heatmap.Clear();
+    }
+}
+
+void Application::RenderWorklistTab() {
+    if (worklist_.IsEmpty()) {
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "No worklist");
+        ImGui::Spacing();
+        ImGui::TextWrapped("Open a worklist (File -> Open Worklist...) to read its slides in order. "
+                           "The next slide is opened in the background while you view the current one.");
+        return;
+    }
+
+    const size_t current = worklist_.GetIndex();
+    ImGui::BeginDisabled(worklist_.GetPreviousIndex() == Worklist::NO_ENTRY);
+    if (ImGui::Button("Previous")) {
+        OpenWorklistEntry(worklist_.GetPreviousIndex());
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(worklist_.GetNextIndex() == Worklist::NO_ENTRY);
+    if (ImGui::Button("Next")) {
+        OpenWorklistEntry(worklist_.GetNextIndex());
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (current == Worklist::NO_ENTRY) {
+        ImGui::Text("%zu slides", worklist_.GetSize());
+    } else {
+        ImGui::Text("%zu / %zu", current + 1, worklist_.GetSize());
+    }
+
+    if (preload_) {
+        const char* state = preload_->task ? "Opening" : preload_->loader ? "Ready" : "Failed";
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Next slide: %s", state);
+    }
+    ImGui::Separator();
+
+    // Only the rows in view are drawn
+    const std::vector<WorklistEntry>& entries = worklist_.GetEntries();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(entries.size()));
+    while (clipper.Step()) {
+        for (size_t i = static_cast<size_t>(clipper.DisplayStart); i < static_cast<size_t>(clipper.DisplayEnd); ++i) {
+            ImGui::PushID(static_cast<int>(i));
+            std::string name = std::filesystem::path(entries[i].slidePath).filename().string();
+            if (!entries[i].polygonPath.empty()) {
+                name += " " ICON_FA_DRAW_POLYGON;
+            }
+            if (ImGui::Selectable(name.c_str(), i == current)) {
+                OpenWorklistEntry(i);
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s", entries[i].slidePath.c_str());
+            }
+            ImGui::PopID();
+        }
+    }
+}
+
+void Application::RenderLibraryTab() {
+    const std::string root = slideLibrary_ ? slideLibrary_->GetRoot() : std::string();
+    if (root.empty()) {
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "No slide folder");
+        ImGui::Spacing();
+        ImGui::TextWrapped("Browse a folder (File -> Browse Slide Folder...) to list the slides under it with "
+                           "thumbnails. Thumbnails are made in the background and cached, so the folder "
+                           "shows at once the next time.");
+        if (ImGui::Button("Browse...")) {
+            OpenLibraryFolderDialog();
+        }
+        return;
+    }
+
+    if (ImGui::Button("Browse...")) {
+        OpenLibraryFolderDialog();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Rescan")) {
+        ScanLibrary(root);
+    }
+    ImGui::SameLine();
+    const size_t pending = slideLibrary_->GetPendingCount();
+    if (pending > 0) {
+        ImGui::Text("%zu slides, %zu thumbnails to go", libraryEntries_.size(), pending);
+    } else {
+        ImGui::Text("%zu slides", libraryEntries_.size());
+    }
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "%s", root.c_str());
+    ImGui::Separator();
+
+    // A grid of thumbnails with the file name under each; only the rows in
+    // view are drawn
+    const float cellSize = LIBRARY_THUMBNAIL_SIZE;
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) /
+                                                     (cellSize + style.FramePadding.x * 2 + style.ItemSpacing.x)));
+    const int rows = static_cast<int>((libraryEntries_.size() + columns - 1) / columns);
+    const float rowHeight = cellSize + style.FramePadding.y * 2 + ImGui::GetTextLineHeightWithSpacing() +
+                            style.ItemSpacing.y;
+
+    ImGuiListClipper clipper;
+    clipper.Begin(rows, rowHeight);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                const size_t i = static_cast<size_t>(row) * columns + column;
+                if (i >= libraryEntries_.size()) {
+                    break;
+                }
+                const SlideLibrary::Entry& entry = libraryEntries_[i];
+                if (column > 0) {
+                    ImGui::SameLine();
+                }
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::BeginGroup();
+
+                bool clicked = false;
+                SDL_Texture* texture = i < libraryTextures_.size() ? libraryTextures_[i] : nullptr;
+                int width = 0;
+                int height = 0;
+                if (texture && SDL_QueryTexture(texture, nullptr, nullptr, &width, &height) == 0 &&
+                    width > 0 && height > 0) {
+                    // Fit the thumbnail in the cell, keeping its aspect ratio
+                    const float scale = cellSize / std::max(width, height);
+                    const ImVec2 size(width * scale, height * scale);
+                    const ImVec2 start = ImGui::GetCursorPos();
+                    ImGui::SetCursorPos(ImVec2(start.x + (cellSize - size.x) / 2, start.y + (cellSize - size.y) / 2));
+                    clicked = ImGui::ImageButton("##thumbnail", (ImTextureID)(intptr_t)texture, size);
+                    ImGui::SetCursorPos(ImVec2(start.x, start.y + cellSize + style.FramePadding.y * 2 +
+                                                             style.ItemSpacing.y));
+                } else {
+                    const char* label = entry.state == SlideLibrary::ThumbnailState::Failed
+                        ? ICON_FA_BAN : ICON_FA_SPINNER;
+                    clicked = ImGui::Button(label, ImVec2(cellSize + style.FramePadding.x * 2,
+                                                          cellSize + style.FramePadding.y * 2));
+                }
+                if (entry.path == currentSlidePath_) {
+                    ImGui::GetWindowDrawList()->AddRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax(),
+                                                        ImGui::GetColorU32(ImGuiCol_CheckMark), 0.0f, 0, 2.0f);
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s\n%.1f MB%s%s", entry.name.c_str(), entry.bytes / (1024.0 * 1024.0),
+                                      entry.error.empty() ? "" : "\n", entry.error.c_str());
+                }
+
+                // File name, shortened to the cell
+                std::string name = std::filesystem::path(entry.path).filename().string();
+                const float maxWidth = cellSize + style.FramePadding.x * 2;
+                if (ImGui::CalcTextSize(name.c_str()).x > maxWidth) {
+                    while (!name.empty() && ImGui::CalcTextSize((name + "...").c_str()).x > maxWidth) {
+                        name.pop_back();
+                    }
+                    name += "...";
+                }
+                ImGui::TextUnformatted(name.c_str());
+
+                ImGui::EndGroup();
+                ImGui::PopID();
+                if (clicked) {
+                    LoadSlide(entry.path);
+                }
+            }
+        }
+    }
 }
 
 void Application::RenderActionCardsTab() {
@@ -1055,9 +4552,8 @@ void Application::RenderActionCardsTab() {
                 break;
         }
 
-        // Card container
-        ImGui::BeginChild(("card_" + card.id).c_str(),
-                         ImVec2(0, 0), true,
+        // Card container (scoped by the card's ID above)
+        ImGui::BeginChild("card", ImVec2(0, 0), true,
                          ImGuiWindowFlags_AlwaysAutoResize);
 
         // Title row
@@ -1105,33 +4601,43 @@ void Application::RenderActionCardsTab() {
             ImGui::Separator();
             if (ImGui::CollapsingHeader("Activity Log",
                                        ImGuiTreeNodeFlags_DefaultOpen)) {
-                ImGui::BeginChild(("log_" + card.id).c_str(),
-                                 ImVec2(0, 150), true);
-
-                for (const auto& entry : card.logEntries) {
-                    // Timestamp
-                    auto time_t = std::chrono::system_clock::to_time_t(
-                        entry.timestamp);
-                    struct tm* tm = std::localtime(&time_t);
-                    char timeBuf[32];
-                    strftime(timeBuf, sizeof(timeBuf), "%H:%M:%S", tm);
-
-                    // Level color
-                    ImVec4 levelColor;
-                    if (entry.level == "error") {
-                        levelColor = ImVec4(0.9f, 0.3f, 0.3f, 1.0f);
-                    } else if (entry.level == "warning") {
-                        levelColor = ImVec4(0.9f, 0.7f, 0.2f, 1.0f);
-                    } else if (entry.level == "success") {
-                        levelColor = ImVec4(0.3f, 0.9f, 0.3f, 1.0f);
-                    } else {
-                        levelColor = ImVec4(0.8f, 0.8f, 0.8f, 1.0f);
-                    }
+                ImGui::BeginChild("log", ImVec2(0, 150), true);
 
-                    ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
-                                      "[%s]", timeBuf);
-                    ImGui::SameLine();
-                    ImGui::TextColored(levelColor, "%s", entry.message.c_str());
+                if (card.droppedLogEntries > 0) {
+                    ImGui::TextDisabled("%zu older entries dropped", card.droppedLogEntries);
+                }
+
+                // One line per entry: only the rows in view are drawn
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(card.logEntries.size()));
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                        const auto& entry = card.logEntries[static_cast<size_t>(row)];
+
+                        // Timestamp
+                        auto time_t = std::chrono::system_clock::to_time_t(
+                            entry.timestamp);
+                        struct tm* tm = std::localtime(&time_t);
+                        char timeBuf[32];
+                        strftime(timeBuf, sizeof(timeBuf), "%H:%M:%S", tm);
+
+                        // Level color
+                        ImVec4 levelColor;
+                        if (entry.level == "error") {
+                            levelColor = ImVec4(0.9f, 0.3f, 0.3f, 1.0f);
+                        } else if (entry.level == "warning") {
+                            levelColor = ImVec4(0.9f, 0.7f, 0.2f, 1.0f);
+                        } else if (entry.level == "success") {
+                            levelColor = ImVec4(0.3f, 0.9f, 0.3f, 1.0f);
+                        } else {
+                            levelColor = ImVec4(0.8f, 0.8f, 0.8f, 1.0f);
+                        }
+
+                        ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
+                                          "[%s]", timeBuf);
+                        ImGui::SameLine();
+                        ImGui::TextColored(levelColor, "%s", entry.message.c_str());
+                    }
                 }
 
                 // Auto-scroll to bottom on new entries
@@ -1387,33 +4893,50 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             };
         }
 
+        else if (method == "viewport.compare") {
+            // Transform from main-view slide coordinates to the compare
+            // view's: [a, b, c, d, tx, ty]
+            if (params.contains("transform")) {
+                const json& transform = params.at("transform");
+                if (!transform.is_array() || transform.size() != 6) {
+                    throw std::runtime_error("transform must be [a, b, c, d, tx, ty]");
+                }
+                ViewportLink link(transform[0].get<double>(), transform[1].get<double>(),
+                                  transform[2].get<double>(), transform[3].get<double>(),
+                                  transform[4].get<double>(), transform[5].get<double>());
+                if (!link.IsValid()) {
+                    throw std::runtime_error("transform is singular");
+                }
+                link.SetZoomRatio(compareLink_.GetZoomRatio());
+                compareLink_ = link;
+            }
+            if (params.contains("zoom_ratio")) {
+                double ratio = params.at("zoom_ratio").get<double>();
+                if (ratio <= 0.0) {
+                    throw std::runtime_error("zoom_ratio must be positive");
+                }
+                compareLink_.SetZoomRatio(ratio);
+            }
+            SetCompareView(params.value("enabled", true));
+            return DescribeCompareView();
+        }
+
         // Slide commands
         else if (method == "slide.load") {
             std::string path = params.at("path").get<std::string>();
             LoadSlide(path);
-
-            if (!slideLoader_) {
-                throw std::runtime_error("Failed to load slide");
-            }
-
-            return json{
-                {"width", slideLoader_->GetWidth()},
-                {"height", slideLoader_->GetHeight()},
-                {"levels", slideLoader_->GetLevelCount()},
-                {"path", currentSlidePath_}
-            };
+            return ReplyWhenSlideOpen();
         }
         else if (method == "slide.info") {
             if (!slideLoader_) {
                 throw std::runtime_error("No slide loaded");
             }
 
-            json result = {
-                {"width", slideLoader_->GetWidth()},
-                {"height", slideLoader_->GetHeight()},
-                {"levels", slideLoader_->GetLevelCount()},
-                {"path", currentSlidePath_}
-            };
+            json result = DescribeOpenSlide();
+            // Vendor properties can run to hundreds: only on request
+            if (params.value("properties", false)) {
+                result["properties"] = slideLoader_->GetMetadata()->properties;
+            }
 
             if (viewport_) {
                 result["viewport"] = {
@@ -1430,38 +4953,768 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             return result;
         }
 
+        // Performance commands
+        else if (method == "viewport.plan") {
+            // The views an agent will move through next, as viewport.move
+            // takes them: each waypoint's tiles are prefetched in order
+            // while the ones before it are looked at, within "budget_mb"
+            // of decoded tiles (default a quarter of the tile cache). An
+            // empty list drops the plan; without "waypoints" only its
+            // progress is reported.
+            if (!slideRenderer_ || !viewport_) {
+                throw std::runtime_error("No slide loaded. Use load_slide tool to load a whole-slide image first.");
+            }
+            if (params.contains("waypoints")) {
+                if (!params["waypoints"].is_array() || params["waypoints"].size() > MAX_PLAN_WAYPOINTS) {
+                    throw std::runtime_error("waypoints must be an array of at most " +
+                                             std::to_string(MAX_PLAN_WAYPOINTS) + " {center_x, center_y, zoom}");
+                }
+                std::vector<ViewportWaypoint> waypoints;
+                for (const auto& waypointJson : params["waypoints"]) {
+                    ViewportWaypoint waypoint;
+                    waypoint.center = Vec2(waypointJson.at("center_x").get<double>(),
+                                           waypointJson.at("center_y").get<double>());
+                    waypoint.zoom = waypointJson.at("zoom").get<double>();
+                    if (!std::isfinite(waypoint.center.x) || !std::isfinite(waypoint.center.y) ||
+                        !(waypoint.zoom > 0.0) || !std::isfinite(waypoint.zoom)) {
+                        throw std::runtime_error("Waypoint " + std::to_string(waypoints.size()) +
+                                                 " needs a finite center and a positive zoom");
+                    }
+                    waypoints.push_back(waypoint);
+                }
+                viewportPlan_.Set(std::move(waypoints));
+                slideRenderer_->SetPlanBudget(
+                    static_cast<size_t>(std::max(0.0, params.value("budget_mb", 0.0)) * 1024 * 1024));
+                // The current view may already be the first stop
+                slideRenderer_->SetPlannedViews(viewportPlan_.GetUpcoming());
+                predictedViews_ = false;
+                UpdateViewportPlan();
+                RequestRedraw();
+            }
+            return {
+                {"waypoints", viewportPlan_.GetWaypoints().size()},
+                {"next_waypoint", viewportPlan_.GetNext()},
+                {"done", viewportPlan_.IsDone()},
+                // Not the prefetch model's predictions the renderer may hold
+                {"prefetched_waypoints", predictedViews_ ? 0 : slideRenderer_->GetPlannedViewCount()},
+                {"prefetched_tiles", predictedViews_ ? 0 : slideRenderer_->GetPlannedTileCount()},
+                {"budget_bytes", slideRenderer_->GetPlanBudget()}
+            };
+        }
+        else if (method == "perf.tile_stats") {
+            if (!slideRenderer_) {
+                throw std::runtime_error("No slide loaded");
+            }
+
+            // Microsecond latency percentiles per tile pipeline stage
+            TilePipelineStats& stats = slideRenderer_->GetPipelineStats();
+            json stages = json::object();
+            for (size_t i = 0; i < TilePipelineStats::STAGE_COUNT; ++i) {
+                TileStage stage = static_cast<TileStage>(i);
+                const LatencyHistogram& histogram = stats.Get(stage);
+                stages[TilePipelineStats::StageName(stage)] = {
+                    {"count", histogram.GetCount()},
+                    {"mean_us", histogram.GetMean()},
+                    {"p50_us", histogram.GetPercentile(0.50)},
+                    {"p90_us", histogram.GetPercentile(0.90)},
+                    {"p99_us", histogram.GetPercentile(0.99)},
+                    {"max_us", histogram.GetMax()}
+                };
+            }
+
+            json result = {
+                {"stages", stages},
+                {"pending_tiles", slideRenderer_->GetPendingTileCount()},
+                {"cache_hit_rate", slideRenderer_->GetCacheHitRate()},
+                {"decoded_bytes", slideRenderer_->GetDecodedBytesTotal()}
+            };
+
+            if (params.value("reset", false)) {
+                stats.Reset();
+            }
+            return result;
+        }
+
+        else if (method == "perf.tile_schedule") {
+            if (!slideRenderer_) {
+                throw std::runtime_error("No slide loaded");
+            }
+
+            // Optional {"deadline_ms": N, "weights": {...}} retune first
+            TileScheduler& scheduler = slideRenderer_->GetScheduler();
+            if (params.contains("deadline_ms")) {
+                double deadlineMs = params.at("deadline_ms").get<double>();
+                if (deadlineMs < 0.0) {
+                    throw std::runtime_error("deadline_ms must be >= 0");
+                }
+                scheduler.SetDeadlineMs(deadlineMs);
+            }
+            TileScheduler::Weights weights = scheduler.GetWeights();
+            if (params.contains("weights")) {
+                const json& w = params.at("weights");
+                weights.coverage = w.value("coverage", weights.coverage);
+                weights.centre = w.value("centre", weights.centre);
+                weights.noFallback = w.value("no_fallback", weights.noFallback);
+                weights.levelFit = w.value("level_fit", weights.levelFit);
+                weights.age = w.value("age", weights.age);
+                scheduler.SetWeights(weights);
+            }
+
+            // The last frame's missing tiles, in the order they were scored
+            json decisions = json::array();
+            for (const TileScheduler::Decision& decision : scheduler.GetDecisions()) {
+                decisions.push_back({
+                    {"level", decision.key.level},
+                    {"x", decision.key.tileX},
+                    {"y", decision.key.tileY},
+                    {"score", decision.score},
+                    {"priority", decision.priority == TileLoadPriority::URGENT ? "urgent" : "visible"},
+                    {"coverage", decision.inputs.coverage},
+                    {"centre_distance", decision.inputs.centreDistance},
+                    {"has_fallback", decision.inputs.hasFallback},
+                    {"level_fit", decision.inputs.levelFit},
+                    {"age_ms", decision.inputs.ageMs}
+                });
+            }
+
+            return json{
+                {"deadline_ms", scheduler.GetDeadlineMs()},
+                {"weights", {
+                    {"coverage", weights.coverage},
+                    {"centre", weights.centre},
+                    {"no_fallback", weights.noFallback},
+                    {"level_fit", weights.levelFit},
+                    {"age", weights.age}
+                }},
+                {"deadline_misses", scheduler.GetDeadlineMissCount()},
+                {"decisions", decisions}
+            };
+        }
+
+        else if (method == "perf.render_scale") {
+            // Optional {"still": S, "moving": S, "motion_levels": N} first
+            if (params.contains("still") || params.contains("moving")) {
+                SetRenderScale(params.value("still", renderScale_), params.value("moving", movingRenderScale_));
+            }
+            if (params.contains("motion_levels")) {
+                SetMotionLevels(params.at("motion_levels").get<int32_t>());
+            }
+            return json{
+                {"display_scale", dpiScale_},
+                {"still", renderScale_},
+                {"moving", movingRenderScale_},
+                {"motion_levels", motionLevels_},
+                {"coarsened", slideRenderer_ && slideRenderer_->IsMotionCoarsened()}
+            };
+        }
+
+        else if (method == "perf.memory") {
+            // Optional {"budget_mb": N} sets the budget first (0 = unlimited)
+            if (params.contains("budget_mb")) {
+                double budgetMB = params.at("budget_mb").get<double>();
+                if (budgetMB < 0.0) {
+                    throw std::runtime_error("budget_mb must be >= 0");
+                }
+                memoryRegistry_.SetBudget(static_cast<size_t>(budgetMB * 1024.0 * 1024.0));
+                memoryRegistry_.Update();
+            }
+
+            json subsystems = json::array();
+            for (const MemoryRegistry::Entry& entry : memoryRegistry_.GetEntries()) {
+                subsystems.push_back({
+                    {"name", entry.name},
+                    {"live_bytes", entry.liveBytes},
+                    {"peak_bytes", entry.peakBytes},
+                    {"reclaimable", entry.reclaimable}
+                });
+            }
+            TileBufferPool::Stats bufferStats = tileCache_ ? tileCache_->GetBufferPoolStats() : TileBufferPool::Stats{};
+            return json{
+                {"subsystems", subsystems},
+                {"total_bytes", memoryRegistry_.GetTotalBytes()},
+                {"peak_total_bytes", memoryRegistry_.GetPeakTotalBytes()},
+                {"budget_bytes", memoryRegistry_.GetBudget()},
+                {"reclaimed_bytes", memoryRegistry_.GetReclaimedBytes()},
+                {"pressure_events", memoryRegistry_.GetPressureEventCount()},
+                {"process_resident_bytes", MemoryRegistry::GetProcessResidentBytes()},
+                {"tile_buffers", {
+                    {"huge_pages", TileBufferPool::HugePageModeName(hugePages_)},
+                    {"slab_bytes", bufferStats.slabBytes},
+                    {"huge_page_bytes", bufferStats.hugePageBytes}
+                }}
+            };
+        }
+
+        else if (method == "perf.tile_cache") {
+            // Optional {"budget_mb": N} resizes the cache (0 = auto-size),
+            // {"compressed_mb": N} its compressed tier (0 = disabled),
+            // {"storage": "argb" | "rgb" | "yuv420"} how its tiles are packed,
+            // {"solid_tiles": bool} whether uniform tiles keep only their color,
+            // {"texture_compression": "none" | "bc7" | "bc1"} the GPU textures'
+            // format
+            if (params.contains("budget_mb")) {
+                double budgetMB = params.at("budget_mb").get<double>();
+                if (budgetMB < 0.0) {
+                    throw std::runtime_error("budget_mb must be >= 0");
+                }
+                SetTileCacheBudget(static_cast<size_t>(budgetMB * 1024.0 * 1024.0));
+            }
+            if (params.contains("compressed_mb")) {
+                double compressedMB = params.at("compressed_mb").get<double>();
+                if (compressedMB < 0.0) {
+                    throw std::runtime_error("compressed_mb must be >= 0");
+                }
+                SetCompressedCacheBudget(static_cast<size_t>(compressedMB * 1024.0 * 1024.0));
+            }
+            if (params.contains("storage")) {
+                const std::string name = params.at("storage").get<std::string>();
+                std::optional<TileStorage> storage = TileCache::ParseStorage(name);
+                if (!storage) {
+                    throw std::runtime_error("Unknown storage: " + name);
+                }
+                SetTileStorage(*storage);
+            }
+            if (params.contains("solid_tiles")) {
+                SetSolidTiles(params.at("solid_tiles").get<bool>());
+            }
+            if (params.contains("texture_compression")) {
+                const std::string name = params.at("texture_compression").get<std::string>();
+                std::optional<TextureCompression> compression = ParseTextureCompression(name);
+                if (!compression) {
+                    throw std::runtime_error("Unknown texture_compression: " + name);
+                }
+                if (textureManager_ && !textureManager_->SetCompression(*compression)) {
+                    throw std::runtime_error(std::string(renderBackend_->GetName()) + " cannot sample " + name +
+                                             " textures");
+                }
+                textureCompression_ = *compression;
+            }
+
+            json compressed = {{"max_bytes", compressedCacheBytes_}};
+            if (const CompressedTileCache* tier = slideRenderer_ ? slideRenderer_->GetCompressedTier() : nullptr) {
+                compressed["tiles"] = tier->GetTileCount();
+                compressed["usage_bytes"] = tier->GetMemoryUsage();
+                compressed["raw_bytes"] = tier->GetRawBytes();
+                compressed["hits"] = tier->GetHitCount();
+                compressed["misses"] = tier->GetMissCount();
+            }
+            json textures = {{"compression", TextureCompressionName(textureCompression_)}};
+            if (textureManager_) {
+                textures["compression"] = TextureCompressionName(textureManager_->GetCompression());
+                textures["tiles"] = textureManager_->GetCacheSize();
+                textures["usage_bytes"] = textureManager_->GetMemoryUsage();
+                textures["max_bytes"] = textureManager_->GetMaxMemory();
+            }
+            return json{
+                {"compressed", compressed},
+                {"textures", textures},
+                {"storage", TileCache::StorageName(tileStorage_)},
+                {"packed_tiles", tileCache_ ? tileCache_->GetPackedTileCount() : 0},
+                {"solid_tiles", solidTiles_},
+                {"solid_tile_count", tileCache_ ? tileCache_->GetSolidTileCount() : 0},
+                {"usage_bytes", slideRenderer_ ? slideRenderer_->GetCacheMemoryUsage() : 0},
+                {"max_bytes", slideRenderer_ ? slideRenderer_->GetCacheMaxMemory() : tileCacheTargetBytes_},
+                {"target_bytes", tileCacheTargetBytes_},
+                {"auto_sized", tileCacheBudgetBytes_ == 0},
+                {"physical_bytes", MemoryRegistry::GetPhysicalMemoryBytes()},
+                {"available_bytes", MemoryRegistry::GetAvailableMemoryBytes()},
+                {"memory_pressure", memoryPressure_}
+            };
+        }
+
+        else if (method == "perf.ipc") {
+            // Optional {"frame_budget_ms": N} (0 = unlimited) and
+            // {"rate_limits": {"background": {"requests_per_second", "burst"}}}
+            // change the scheduling first
+            using pathview::ipc::RequestPriority;
+            if (params.contains("frame_budget_ms")) {
+                double budgetMs = params.at("frame_budget_ms").get<double>();
+                if (budgetMs < 0.0) {
+                    throw std::runtime_error("frame_budget_ms must be >= 0");
+                }
+                ipcServer_->SetFrameBudget(std::chrono::microseconds(static_cast<int64_t>(budgetMs * 1000.0)));
+            }
+            if (params.contains("rate_limits")) {
+                for (const auto& [name, limit] : params.at("rate_limits").items()) {
+                    auto priority = pathview::ipc::ParseRequestPriority(name);
+                    if (!priority) {
+                        throw std::runtime_error("Unknown priority: " + name);
+                    }
+                    const double rate = limit.value("requests_per_second", 0.0);
+                    ipcServer_->SetRateLimit(*priority, {rate, limit.value("burst", rate)});
+                }
+            }
+
+            const pathview::ipc::IPCServer::Stats stats = ipcServer_->GetStats();
+            json rateLimits = json::object();
+            for (RequestPriority priority : {RequestPriority::Interactive, RequestPriority::Normal,
+                                             RequestPriority::Background}) {
+                const pathview::ipc::RateLimit limit = ipcServer_->GetRateLimit(priority);
+                rateLimits[pathview::ipc::RequestPriorityName(priority)] = {
+                    {"requests_per_second", limit.requestsPerSecond},
+                    {"burst", limit.burst}
+                };
+            }
+            json sessions = json::array();
+            for (const auto& session : stats.sessions) {
+                sessions.push_back({
+                    {"session", session.session},
+                    {"priority", pathview::ipc::RequestPriorityName(session.priority)},
+                    {"connections", session.connections},
+                    {"queued", session.queued},
+                    {"throttled", session.throttled},
+                    {"executed", session.executed}
+                });
+            }
+            return json{
+                {"frame_budget_ms", ipcServer_->GetFrameBudget().count() / 1000.0},
+                {"rate_limits", rateLimits},
+                {"queued", stats.queued},
+                {"throttled", stats.throttled},
+                {"executed", stats.executed},
+                {"over_budget_frames", stats.overBudget},
+                {"sessions", sessions}
+            };
+        }
+
+        else if (method == "perf.export_profile") {
+            // Last FrameProfiler::HISTORY_FRAMES frames as Chrome trace JSON
+            std::string path = params.value("path", std::string(PROFILE_EXPORT_PATH));
+            if (!frameProfiler_.ExportChromeTrace(path)) {
+                throw std::runtime_error("Failed to write profile: " + path);
+            }
+            return json{{"path", path}, {"frames", frameProfiler_.GetFrameCount()}};
+        }
+
+        // Viewport trace commands
+        else if (method == "trace.start_recording") {
+            std::string path = params.at("path").get<std::string>();
+            if (!StartTraceRecording(path)) {
+                throw std::runtime_error("Invalid trace path");
+            }
+            return json{{"recording", true}, {"path", path}};
+        }
+        else if (method == "trace.stop_recording") {
+            if (traceRecordPath_.empty()) {
+                throw std::runtime_error("Not recording a viewport trace");
+            }
+            std::string path = traceRecordPath_;
+            if (!StopTraceRecording()) {
+                throw std::runtime_error("Failed to write viewport trace: " + path);
+            }
+            return json{
+                {"path", path},
+                {"samples", traceRecording_.GetSampleCount()},
+                {"duration_ms", traceRecording_.GetDurationMs()}
+            };
+        }
+        else if (method == "trace.replay") {
+            if (!viewport_) {
+                throw std::runtime_error("No slide loaded. Use load_slide tool to load a whole-slide image first.");
+            }
+
+            // A replay drives the viewport like viewport.move does
+            socket_t currentClientFd = ipcServer_ ? ipcServer_->GetCurrentClientFd() : INVALID_SOCKET_VALUE;
+            if (!IsNavigationOwnedByClient(currentClientFd)) {
+                throw std::runtime_error(
+                    std::string("Navigation locked by ") + navLock_->GetOwnerUUID() +
+                    ". Use nav_lock tool to acquire control."
+                );
+            }
+
+            std::string path = params.at("path").get<std::string>();
+            if (!StartTraceReplay(path)) {
+                throw std::runtime_error("Failed to load viewport trace: " + path);
+            }
+            return json{
+                {"samples", traceReplay_.GetSampleCount()},
+                {"duration_ms", traceReplay_.GetDurationMs()}
+            };
+        }
+        else if (method == "trace.status") {
+            // Frame times cover the current (or last) replay
+            return json{
+                {"recording", !traceRecordPath_.empty()},
+                {"recorded_samples", traceRecording_.GetSampleCount()},
+                {"replaying", replayingTrace_},
+                {"replay_sample", replayingTrace_ && traceReplaySample_ < traceReplay_.GetSampleCount()
+                    ? traceReplaySample_ + 1 : 0},
+                {"replay_samples", traceReplay_.GetSampleCount()},
+                {"frame_time", {
+                    {"count", replayFrameTimes_.GetCount()},
+                    {"mean_us", replayFrameTimes_.GetMean()},
+                    {"p50_us", replayFrameTimes_.GetPercentile(0.50)},
+                    {"p90_us", replayFrameTimes_.GetPercentile(0.90)},
+                    {"p99_us", replayFrameTimes_.GetPercentile(0.99)},
+                    {"max_us", replayFrameTimes_.GetMax()}
+                }}
+            };
+        }
+
+        // Worklist commands
+        else if (method == "worklist.set") {
+            const json& entriesJson = params.at("entries");
+            if (!entriesJson.is_array()) {
+                throw std::runtime_error("entries must be an array");
+            }
+            std::vector<WorklistEntry> entries;
+            for (const auto& entryJson : entriesJson) {
+                WorklistEntry entry;
+                if (entryJson.is_string()) {
+                    entry.slidePath = entryJson.get<std::string>();
+                } else {
+                    entry.slidePath = entryJson.at("slide").get<std::string>();
+                    entry.polygonPath = entryJson.value("polygons", "");
+                }
+                entries.push_back(std::move(entry));
+            }
+            SetWorklist(std::move(entries));
+
+            // Optionally open an entry right away, answering as slide.load
+            if (params.contains("open")) {
+                if (!OpenWorklistEntry(params.at("open").get<size_t>())) {
+                    throw std::runtime_error("open is out of range");
+                }
+                return ReplyWhenSlideOpen();
+            }
+            return DescribeWorklist();
+        }
+        else if (method == "worklist.get") {
+            return DescribeWorklist();
+        }
+        else if (method == "worklist.open") {
+            if (!OpenWorklistEntry(params.at("index").get<size_t>())) {
+                throw std::runtime_error("index is out of range");
+            }
+            return ReplyWhenSlideOpen();
+        }
+        else if (method == "worklist.next" || method == "worklist.previous") {
+            size_t index = method == "worklist.next" ? worklist_.GetNextIndex() : worklist_.GetPreviousIndex();
+            if (!OpenWorklistEntry(index)) {
+                throw std::runtime_error(method == "worklist.next" ? "No next worklist entry"
+                                                                   : "No previous worklist entry");
+            }
+            return ReplyWhenSlideOpen();
+        }
+
+        // Slide library commands
+        else if (method == "library.scan") {
+            std::string path = params.at("path").get<std::string>();
+            if (!ScanLibrary(path)) {
+                throw std::runtime_error("Not a directory: " + path);
+            }
+            return DescribeLibrary();
+        }
+        else if (method == "library.get") {
+            UpdateLibraryTextures();
+            return DescribeLibrary();
+        }
+        else if (method == "library.open") {
+            UpdateLibraryTextures();
+            size_t index = params.at("index").get<size_t>();
+            if (index >= libraryEntries_.size()) {
+                throw std::runtime_error("index is out of range");
+            }
+            LoadSlide(libraryEntries_[index].path);
+            return ReplyWhenSlideOpen();
+        }
+
         // Polygon commands
         else if (method == "polygons.load") {
             std::string path = params.at("path").get<std::string>();
-            LoadPolygons(path);
-
             if (!polygonOverlay_) {
                 throw std::runtime_error("Failed to load polygons");
             }
+            // Into a layer of its own, keeping the loaded ones
+            if (params.value("new_layer", false)) {
+                AddPolygonLayer();
+            }
+            StartPolygonLoad(path);
 
+            if (!polygonOverlay_->IsLoading()) {
+                return json{
+                    {"count", polygonOverlay_->GetPolygonCount()},
+                    {"classes", polygonOverlay_->GetClassIds()},
+                    {"layer", activePolygonLayer_}
+                };
+            }
+
+            // Streamed in like a file picked in the GUI; Update() answers
+            // once the last batch is in
+            polygonLoadReply_ = std::make_unique<std::promise<json>>();
+            ipcServer_->Defer(polygonLoadReply_->get_future());
+            return json();
+        }
+        else if (method == "heatmap.load") {
+            std::string path = params.at("path").get<std::string>();
+            if (!LoadHeatmap(path, params.value("texel_size", 0.0))) {
+                throw std::runtime_error("Failed to load heatmap: " + heatmapLayer_->GetError());
+            }
+            const HeatmapGrid& grid = heatmapLayer_->GetPyramid()->GetGrid();
+            return json{
+                {"width", grid.GetWidth()},
+                {"height", grid.GetHeight()},
+                {"texel_size", heatmapLayer_->GetPyramid()->GetTexelSize()},
+                {"levels", heatmapLayer_->GetPyramid()->GetLevelCount()}
+            };
+        }
+        else if (method == "heatmap.set") {
+            if (!heatmapLayer_ || !heatmapLayer_->HasHeatmap()) {
+                throw std::runtime_error("No heatmap loaded. Use heatmap.load first.");
+            }
+            HeatmapLayer& heatmap = *heatmapLayer_;
+            heatmap.SetVisible(params.value("visible", heatmap.IsVisible()));
+            heatmap.SetOpacity(params.value("opacity", heatmap.GetOpacity()));
+            heatmap.SetThreshold(params.value("threshold", heatmap.GetThreshold()));
+            heatmap.SetRange(params.value("range_low", heatmap.GetRangeLow()),
+                             params.value("range_high", heatmap.GetRangeHigh()));
+            if (params.contains("colormap")) {
+                const std::string name = params["colormap"].get<std::string>();
+                bool known = false;
+                for (int i = 0; i < HeatmapLayer::COLORMAP_COUNT; ++i) {
+                    const auto colormap = static_cast<HeatmapLayer::Colormap>(i);
+                    if (name == HeatmapLayer::GetColormapName(colormap)) {
+                        heatmap.SetColormap(colormap);
+                        known = true;
+                    }
+                }
+                if (!known) {
+                    throw std::runtime_error("Unknown colormap: " + name);
+                }
+            }
+            RequestRedraw();
             return json{
-                {"count", polygonOverlay_->GetPolygonCount()},
-                {"classes", polygonOverlay_->GetClassIds()}
+                {"visible", heatmap.IsVisible()},
+                {"opacity", heatmap.GetOpacity()},
+                {"threshold", heatmap.GetThreshold()},
+                {"range_low", heatmap.GetRangeLow()},
+                {"range_high", heatmap.GetRangeHigh()},
+                {"colormap", HeatmapLayer::GetColormapName(heatmap.GetColormap())}
             };
         }
+        else if (method == "polygons.layers") {
+            return DescribePolygonLayers();
+        }
+        else if (method == "polygons.set_layer") {
+            // Acts on one layer: show or hide it, make it the active one
+            // (what the other polygons.* methods act on) or remove it
+            const size_t layer = params.at("layer").get<size_t>();
+            if (layer >= polygonLayers_.size()) {
+                throw std::runtime_error("No polygon layer " + std::to_string(layer) + " (" +
+                                         std::to_string(polygonLayers_.size()) + " layers)");
+            }
+            if (params.value("remove", false)) {
+                if (!RemovePolygonLayer(layer)) {
+                    throw std::runtime_error("Cannot remove the only polygon layer");
+                }
+                return DescribePolygonLayers();
+            }
+            if (params.contains("visible")) {
+                polygonLayers_[layer].overlay->SetVisible(params.at("visible").get<bool>());
+            }
+            if (params.value("active", false)) {
+                SelectPolygonLayer(layer);
+            }
+            RequestRedraw();
+            return DescribePolygonLayers();
+        }
         else if (method == "polygons.set_visibility") {
             if (!polygonOverlay_) {
                 throw std::runtime_error("No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
             }
 
+            if (!params.contains("visible") && !params.contains("min_confidence")) {
+                throw std::runtime_error("Missing 'visible' or 'min_confidence' parameter");
+            }
+            if (params.contains("visible")) {
+                polygonOverlay_->SetVisible(params.at("visible").get<bool>());
+            }
+            if (params.contains("min_confidence")) {
+                polygonOverlay_->SetMinConfidence(params.at("min_confidence").get<float>());
+            }
+
+            return json{{"visible", polygonOverlay_->IsVisible()},
+                        {"min_confidence", polygonOverlay_->GetMinConfidence()}};
+        }
+        else if (method == "polygons.set_class_visibility") {
+            if (!polygonOverlay_) {
+                throw std::runtime_error("No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
+            }
+
+            int classId = params.at("class_id").get<int>();
             bool visible = params.at("visible").get<bool>();
-            polygonOverlay_->SetVisible(visible);
+            polygonOverlay_->SetClassVisible(classId, visible);
+
+            return json{{"class_id", classId}, {"visible", polygonOverlay_->IsClassVisible(classId)}};
+        }
+        else if (method == "polygons.set_outline") {
+            if (!polygonOverlay_) {
+                throw std::runtime_error("No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
+            }
+
+            if (params.contains("enabled")) {
+                polygonOverlay_->SetOutlineMode(params.at("enabled").get<bool>());
+            }
+            if (params.contains("width")) {
+                const float width = params.at("width").get<float>();
+                if (params.contains("class_id")) {
+                    polygonOverlay_->SetClassOutlineWidth(params.at("class_id").get<int>(), width);
+                } else {
+                    for (int classId : polygonOverlay_->GetClassIds()) {
+                        polygonOverlay_->SetClassOutlineWidth(classId, width);
+                    }
+                }
+            }
 
-            return json{{"visible", polygonOverlay_->IsVisible()}};
+            json widths = json::object();
+            for (int classId : polygonOverlay_->GetClassIds()) {
+                widths[std::to_string(classId)] = polygonOverlay_->GetClassOutlineWidth(classId);
+            }
+            return json{{"enabled", polygonOverlay_->IsOutlineMode()}, {"widths", widths}};
+        }
+        else if (method == "polygons.set_minimap_density") {
+            if (params.contains("enabled")) {
+                minimapDensity_ = params.at("enabled").get<bool>();
+            }
+            if (params.contains("class_id")) {
+                minimapDensityClass_ = params.at("class_id").get<int>();
+            }
+            minimapDensityDirty_ = true;
+            UpdateMinimapDensity();
+            return json{
+                {"enabled", minimapDensity_},
+                {"class_id", minimapDensityClass_},
+                {"drawn", minimap_ && minimap_->HasDensity()}
+            };
         }
         else if (method == "polygons.query") {
             if (!polygonOverlay_) {
                 throw std::runtime_error("No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
             }
 
-            // TODO: Implement polygon query in PolygonOverlay
-            // For now, return empty list
-            return json{{"polygons", json::array()}};
+            if (polygonOverlay_->IsLoading()) {
+                throw std::runtime_error("Polygons are still loading. Retry once the load completes.");
+            }
+
+            PolygonQuery query;
+            query.region = Rect(params.at("x").get<double>(), params.at("y").get<double>(),
+                                params.at("w").get<double>(), params.at("h").get<double>());
+            query.classes = params.value("classes", std::vector<int>());
+            query.minConfidence = params.value("min_confidence", 0.0f);
+            query.cursor = params.value("cursor", 0u);
+            query.limit = params.value("limit", PolygonQuery::DEFAULT_LIMIT);
+            if (query.limit == 0 || query.limit > PolygonQuery::MAX_LIMIT) {
+                throw std::runtime_error("limit must be between 1 and " + std::to_string(PolygonQuery::MAX_LIMIT));
+            }
+            const std::string geometry = params.value("geometry", "centroid");
+            if (geometry != "centroid" && geometry != "vertices") {
+                throw std::runtime_error("geometry must be \"centroid\" or \"vertices\"");
+            }
+            const bool withVertices = geometry == "vertices";
+
+            const PolygonStore& polygons = polygonOverlay_->GetPolygons();
+            PolygonQuery::Page page = query.Run(polygons, polygonOverlay_->GetSpatialIndex());
+            json response = {
+                {"count", page.polygons.size()},
+                {"total", page.total},
+                {"next_cursor", page.done ? json(nullptr) : json(page.nextCursor)}
+            };
+
+            // Packed columns for binary connections (or on request): a page
+            // of tens of thousands of cells without one JSON value per number
+            const bool packed = params.value(
+                "packed", ipcServer_->GetCurrentEncoding() != pathview::ipc::WireEncoding::Json);
+            if (packed) {
+                std::vector<uint32_t> ids = page.polygons;
+                std::vector<int32_t> classIds;
+                std::vector<float> confidences;
+                std::vector<double> centroids;
+                std::vector<uint32_t> vertexCounts;
+                std::vector<float> vertices;
+                classIds.reserve(ids.size());
+                confidences.reserve(ids.size());
+                centroids.reserve(2 * ids.size());
+                for (uint32_t polygon : page.polygons) {
+                    classIds.push_back(polygons.GetClassId(polygon));
+                    confidences.push_back(polygons.GetConfidence(polygon));
+                    Vec2 centroid = polygons.GetCentroid(polygon);
+                    centroids.push_back(centroid.x);
+                    centroids.push_back(centroid.y);
+                    if (withVertices) {
+                        const uint32_t vertexCount = polygons.GetVertexCount(polygon);
+                        const Vec2f* polygonVertices = polygons.GetVertices(polygon);
+                        vertexCounts.push_back(vertexCount);
+                        for (uint32_t v = 0; v < vertexCount; ++v) {
+                            vertices.push_back(polygonVertices[v].x);
+                            vertices.push_back(polygonVertices[v].y);
+                        }
+                    }
+                }
+                response["packed"] = true;
+                response["ids"] = pathview::ipc::PackUInt32s(ids);
+                response["class_ids"] = pathview::ipc::PackInt32s(classIds);
+                response["confidence"] = pathview::ipc::PackFloats(confidences);
+                response["centroids"] = pathview::ipc::PackDoubles(centroids);
+                if (withVertices) {
+                    response["vertex_counts"] = pathview::ipc::PackUInt32s(vertexCounts);
+                    response["vertices"] = pathview::ipc::PackFloats(vertices);
+                }
+                return response;
+            }
+
+            json polygonsJson = json::array();
+            for (uint32_t polygon : page.polygons) {
+                Vec2 centroid = polygons.GetCentroid(polygon);
+                json polygonJson = {
+                    {"id", polygon},
+                    {"class_id", polygons.GetClassId(polygon)},
+                    {"confidence", polygons.GetConfidence(polygon)},
+                    {"centroid", {centroid.x, centroid.y}}
+                };
+                if (withVertices) {
+                    json verticesJson = json::array();
+                    const Vec2f* polygonVertices = polygons.GetVertices(polygon);
+                    for (uint32_t v = 0; v < polygons.GetVertexCount(polygon); ++v) {
+                        verticesJson.push_back({polygonVertices[v].x, polygonVertices[v].y});
+                    }
+                    polygonJson["vertices"] = std::move(verticesJson);
+                }
+                polygonsJson.push_back(std::move(polygonJson));
+            }
+            response["polygons"] = std::move(polygonsJson);
+            return response;
+        }
+        else if (method == "polygons.summarize") {
+            if (!polygonOverlay_) {
+                throw std::runtime_error("No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
+            }
+            const CellStatsPyramid* stats = polygonOverlay_->GetCellStats();
+            if (!stats) {
+                throw std::runtime_error(polygonOverlay_->IsLoading()
+                    ? "Polygons are still loading. Retry once the load completes."
+                    : "No polygons loaded. Use load_polygons tool to load cell segmentation data first.");
+            }
+
+            // Cells whose centroid lies in the rectangle, from the pyramid's
+            // sums: only the bins along its border visit cells
+            const Rect region(params.at("x").get<double>(), params.at("y").get<double>(),
+                              params.at("w").get<double>(), params.at("h").get<double>());
+            std::map<int, CellStatsPyramid::ClassStats> byClass;
+            stats->Summarize(polygonOverlay_->GetPolygons(), region, byClass);
+
+            json classesJson = json::object();
+            uint64_t total = 0;
+            for (const auto& [classId, classStats] : byClass) {
+                classesJson[std::to_string(classId)] = {
+                    {"name", polygonOverlay_->GetClassName(classId)},
+                    {"count", classStats.count},
+                    {"area", classStats.area},
+                    {"mean_area", classStats.area / classStats.count},
+                    {"mean_confidence", classStats.confidence / classStats.count}
+                };
+                total += classStats.count;
+            }
+            return json{{"classes", classesJson}, {"total", total}};
         }
 
         // Session commands
@@ -1471,9 +5724,9 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             std::string sessionId = params.value("session_id", "");
 
             // Log agent connection
-            std::cout << "Agent connected: " << agentName
-                      << " v" << agentVersion
-                      << " (session: " << sessionId << ")" << std::endl;
+            PATHVIEW_LOG_INFO("Agent connected: " << agentName
+                              << " v" << agentVersion
+                              << " (session: " << sessionId << ")");
 
             // Return session info including lock status
             json result = {
@@ -1486,6 +5739,7 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 {"stream_fps_default", 5},
                 {"stream_fps_max", 30},
                 {"ipc_port", ipcServer_ ? ipcServer_->GetPort() : 0},
+                {"ipc_socket", ipcServer_ ? ipcServer_->GetSocketPath() : ""},
                 {"navigation_locked", IsNavigationLocked()},
                 {"lock_owner", navLock_->IsLocked() ? navLock_->GetOwnerUUID() : ""}
             };
@@ -1503,17 +5757,57 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             }
 
             if (slideLoader_) {
-                result["slide"] = {
-                    {"width", slideLoader_->GetWidth()},
-                    {"height", slideLoader_->GetHeight()},
-                    {"levels", slideLoader_->GetLevelCount()},
-                    {"path", currentSlidePath_}
-                };
+                result["slide"] = DescribeOpenSlide();
             }
 
             return result;
         }
 
+        // Pushed events: notifications "event.viewport", "event.tiles_settled"
+        // and "event.annotations" replace polling viewport / tile state
+        else if (method == "events.subscribe" || method == "events.unsubscribe") {
+            std::vector<pathview::ipc::EventType> types;
+            for (const auto& name : params.value("events", json::array())) {
+                auto type = pathview::ipc::ParseEventType(name.get<std::string>());
+                if (!type) {
+                    throw std::runtime_error("Unknown event: " + name.get<std::string>());
+                }
+                types.push_back(*type);
+            }
+            const socket_t clientFd = ipcServer_->GetCurrentClientFd();
+
+            if (method == "events.unsubscribe") {
+                eventSubscriptions_->Unsubscribe(clientFd, types);
+                return json{{"success", true}};
+            }
+            if (types.empty()) {
+                throw std::runtime_error("Missing 'events' parameter");
+            }
+            const int minIntervalMs = std::clamp(
+                params.value("min_interval_ms",
+                             static_cast<int>(pathview::ipc::EventSubscriptions::DEFAULT_MIN_INTERVAL.count())),
+                0, MAX_EVENT_INTERVAL_MS);
+            eventSubscriptions_->Subscribe(clientFd, types, std::chrono::milliseconds(minIntervalMs));
+
+            // Current state, so the subscriber need not wait for a change
+            json events = json::array();
+            for (auto type : types) {
+                events.push_back(pathview::ipc::EventTypeName(type));
+            }
+            return json{
+                {"success", true},
+                {"events", events},
+                {"min_interval_ms", minIntervalMs},
+                {"viewport", {
+                    {"position", {{"x", reportedState_.x}, {"y", reportedState_.y}}},
+                    {"zoom", reportedState_.zoom},
+                    {"moving", reportedState_.moving}
+                }},
+                {"tiles_settled", reportedState_.tilesSettled},
+                {"annotation_revision", reportedState_.annotationRevision}
+            };
+        }
+
         // Navigation lock commands
         else if (method == "nav.lock") {
             std::string ownerUUID = params.value("owner_uuid", "");
@@ -1551,8 +5845,8 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             navLock_->SetTTL(std::chrono::milliseconds(ttlSeconds * 1000));
             navLock_->SetClientFd(ipcServer_ ? ipcServer_->GetCurrentClientFd() : INVALID_SOCKET_VALUE);
 
-            std::cout << "Navigation lock granted to " << ownerUUID
-                      << " for " << ttlSeconds << "s" << std::endl;
+            PATHVIEW_LOG_INFO("Navigation lock granted to " << ownerUUID
+                              << " for " << ttlSeconds << "s");
 
             return json{
                 {"success", true},
@@ -1586,7 +5880,7 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 }
             }
 
-            std::cout << "Navigation lock released by " << ownerUUID << std::endl;
+            PATHVIEW_LOG_INFO("Navigation lock released by " << ownerUUID);
             navLock_->Reset();
 
             return json{
@@ -1619,69 +5913,419 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             // Note: includeUI and custom width/height not yet implemented
             // Currently captures at window resolution without UI
 
-            // Capture immediately.
-            //
-            // Important: IPC requests are processed on the GUI thread (via IPCServer::ProcessMessages).
-            // Waiting for "next frame" would deadlock rendering, so we read pixels from the last-rendered
-            // frame synchronously.
-            CaptureScreenshot();
+            ImageEncoder encode = MakeImageEncoder(params);
+
+            // "max_dimension" (longer side) / "scale": a smaller image for
+            // vision models, scaled down before it is read back
+            const int maxDimension = params.value("max_dimension", 0);
+            const double scale = params.value("scale", 1.0);
+            if (maxDimension < 0 || !(scale > 0.0 && scale <= 1.0)) {
+                throw std::runtime_error("'max_dimension' must be positive and 'scale' in (0, 1]");
+            }
+
+            // "await_sharp": rather than a frame still made of coarser
+            // fallback tiles right after a move, answer from the first frame
+            // rendered from now on whose visible tiles are all resident, or
+            // at "timeout_ms". The GUI keeps rendering meanwhile; "sharp"
+            // says which it was.
+            if (params.value("await_sharp", false)) {
+                const int timeoutMs = std::clamp(params.value("timeout_ms", DEFAULT_SHARP_TIMEOUT_MS),
+                                                 0, MAX_SHARP_TIMEOUT_MS);
+                PendingCapture capture;
+                capture.reply = std::make_shared<std::promise<json>>();
+                capture.encode = std::move(encode);
+                capture.requested = std::chrono::steady_clock::now();
+                capture.deadline = capture.requested + std::chrono::milliseconds(timeoutMs);
+                capture.maxDimension = maxDimension;
+                capture.scale = scale;
+                capture.trace = ipcServer_->GetCurrentTrace();
+                capture.requestedUs = capture.trace ? pathview::ipc::RequestTrace::NowUs() : 0;
+                ipcServer_->Defer(capture.reply->get_future());
+                pendingCaptures_.push_back(std::move(capture));
+                RequestRedraw();
+                return json();
+            }
 
-            // Get captured data and encode PNG
-            std::vector<uint8_t> pixels;
-            int capturedWidth, capturedHeight;
-            if (!screenshotBuffer_->GetCapture(pixels, capturedWidth, capturedHeight)) {
-                return json{{"error", "Failed to capture screenshot"}};
+            // Read the last-rendered frame (pixels can only be read on this
+            // thread, and waiting for the next frame would stall it): copied
+            // back by the GPU while the next frames render, or read now
+            std::shared_ptr<pathview::ipc::RequestTrace> trace = ipcServer_->GetCurrentTrace();
+            const int64_t readStartUs = trace ? pathview::ipc::RequestTrace::NowUs() : 0;
+            auto reply = std::make_shared<std::promise<json>>();
+            ipcServer_->Defer(reply->get_future());
+            auto answer = [this, reply, encode = std::move(encode), trace, readStartUs](
+                              std::vector<uint8_t>& pixels, int width, int height) {
+                const int64_t submittedUs = trace ? pathview::ipc::RequestTrace::NowUs() : 0;
+                if (trace) {
+                    trace->Add("gui.read_pixels", readStartUs, submittedUs);
+                }
+                commandExecutor_->Submit([reply, encode, pixels = std::move(pixels), width, height, trace,
+                                          submittedUs]() mutable {
+                    if (trace) {
+                        trace->Add("executor.queue", submittedUs, pathview::ipc::RequestTrace::NowUs());
+                    }
+                    try {
+                        reply->set_value(encode(std::move(pixels), width, height));
+                    } catch (...) {
+                        reply->set_exception(std::current_exception());
+                    }
+                    return json();
+                });
+            };
+            RequestSnapshotPixels(maxDimension, scale, std::move(answer));
+            return json();
+        }
+        else if (method == "region.render") {
+            // Any region of the slide at any resolution, composed off screen
+            // from the tile pipeline whatever the window shows: x, y, width,
+            // height in level 0 pixels, clipped to the slide, at "downsample"
+            // (level 0 pixels per output pixel) or fit to "output_width".
+            // "overlays" may list "polygons" and "annotations", drawn as the
+            // viewer draws them. Encoded like snapshot.capture.
+            double x0, y0, x1, y1, downsample;
+            ParseRegionParams(params, x0, y0, x1, y1, downsample);
+            const int64_t outWidth = std::max<int64_t>(1, std::llround((x1 - x0) / downsample));
+            const int64_t outHeight = std::max<int64_t>(1, std::llround((y1 - y0) / downsample));
+            if (outWidth * outHeight > MAX_REGION_PIXELS) {
+                throw std::runtime_error("Region is " + std::to_string(outWidth) + " x " + std::to_string(outHeight) +
+                                         " pixels at this downsample, more than " +
+                                         std::to_string(MAX_REGION_PIXELS) + "; raise the downsample");
             }
 
-            std::vector<uint8_t> pngData = EncodePNG(pixels, capturedWidth, capturedHeight);
-            screenshotBuffer_->MarkAsRead();
+            // Copy the overlays here: the job must not read state this
+            // thread goes on changing
+            json overlayInfo = json::object();
+            std::shared_ptr<RegionOverlay> overlay = BuildRegionOverlay(
+                params.value("overlays", json::array()), Rect(x0, y0, x1 - x0, y1 - y0), MAX_REGION_POLYGONS,
+                overlayInfo);
+
+            ImageEncoder encode = MakeImageEncoder(params);
+            TileService* service = tileService_.get();
+            const int32_t width = static_cast<int32_t>(outWidth);
+            const int32_t height = static_cast<int32_t>(outHeight);
+            ipcServer_->Defer(renderExecutor_->Submit(
+                [service, overlay, encode = std::move(encode), overlayInfo = std::move(overlayInfo),
+                 x0, y0, x1, y1, downsample, width, height]() {
+                    std::vector<uint32_t> argb;
+                    TileServiceStatus status = service->RenderRegion(x0, y0, downsample, width, height, argb);
+                    if (status != TileServiceStatus::Ok) {
+                        throw std::runtime_error("Region render failed: the slide changed or its tiles did not load in time");
+                    }
+                    overlay->Draw(argb.data(), width, height, x0, y0, downsample);
+
+                    // Premultiplied ARGB over white, as RGBA
+                    std::vector<uint8_t> rgba(argb.size() * 4);
+                    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::OverWhite>(
+                        argb.data(), rgba.data(), argb.size());
+                    argb = std::vector<uint32_t>();
+
+                    json result = encode(std::move(rgba), width, height);
+                    result["region"] = {{"x", x0}, {"y", y0}, {"width", x1 - x0}, {"height", y1 - y0}};
+                    result["downsample"] = downsample;
+                    if (!overlayInfo.empty()) {
+                        result["overlays"] = overlayInfo;
+                    }
+                    return result;
+                }));
+            return json();
+        }
+        else if (method == "region.export") {
+            // A region written as a tiled pyramidal TIFF like pathview-convert
+            // writes slides, with "overlays" burned in as region.render draws
+            // them. Tiles are rendered off screen and encoded by a pool of
+            // workers as they stream, each level built from the one below, so
+            // memory is a few tiles per worker whatever the region's size.
+            // Runs in the background: the reply names the action card its
+            // progress goes to, and cancelling that card stops it.
+            double x0, y0, x1, y1, downsample;
+            ParseRegionParams(params, x0, y0, x1, y1, downsample);
+            if (!params.contains("path") || !params["path"].is_string()) {
+                throw std::runtime_error("Missing 'path' parameter");
+            }
+            if (!SlideTranscoder::IsAvailable()) {
+                throw std::runtime_error("Region export needs JPEG encoding, which this build lacks");
+            }
+            if (regionExport_) {
+                throw std::runtime_error("A region export is already running (action card " +
+                                         regionExport_->cardId + ")");
+            }
+            const std::string path = params["path"].get<std::string>();
+            const int64_t outWidth = std::max<int64_t>(1, std::llround((x1 - x0) / downsample));
+            const int64_t outHeight = std::max<int64_t>(1, std::llround((y1 - y0) / downsample));
+
+            json overlayInfo = json::object();
+            std::shared_ptr<RegionOverlay> overlay = BuildRegionOverlay(
+                params.value("overlays", json::array()), Rect(x0, y0, x1 - x0, y1 - y0), MAX_EXPORT_POLYGONS,
+                overlayInfo);
+            // Each tile then draws only the shapes near it
+            overlay->BuildIndex(EXPORT_TILE_SIZE * downsample);
+
+            auto job = std::make_unique<RegionExport>();
+            job->cardId = GenerateUUID();
+            job->path = path;
+            job->started = std::chrono::steady_clock::now();
+            pathview::ActionCard card(job->cardId, "Export region");
+            card.summary = "Writing tiles";
+            card.reasoning = std::to_string(outWidth) + " x " + std::to_string(outHeight) +
+                             " pixels at downsample " + json(downsample).dump() + " to " + path;
+            card.ownerUUID = params.value("owner_uuid", "");
+            card.UpdateStatus(pathview::ActionCardStatus::IN_PROGRESS);
+            AddActionCard(card);
+
+            SlideTranscoder::Options options;
+            options.tileSize = EXPORT_TILE_SIZE;
+            options.quality = std::clamp(params.value("quality", 90), 1, 100);
+            options.backgroundPriority = true;
+            std::shared_ptr<const SlideMetadata> metadata = slideLoader_->GetMetadata();
+            if (metadata && metadata->mppX > 0) {
+                options.mpp = metadata->mppX * downsample;
+            }
+            std::ostringstream description;
+            description << "PathView region export of "
+                        << std::filesystem::path(currentSlidePath_).filename().string() << " x=" << x0
+                        << " y=" << y0 << " width=" << (x1 - x0) << " height=" << (y1 - y0)
+                        << " downsample=" << downsample;
+            options.description = description.str();
+            RegionExport* state = job.get();
+            options.cancelled = [state]() { return state->cancel.load(); };
+            options.progress = [this, state](size_t done, size_t total) {
+                const size_t before = state->done.exchange(done);
+                state->total = total;
+                if (before * 100 / total != done * 100 / total) {
+                    PostWakeEvent();
+                }
+            };
 
-            // Return PNG data as base64 for MCP server to store
-            // Convert to base64
-            static const char* base64_chars =
-                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                "abcdefghijklmnopqrstuvwxyz"
-                "0123456789+/";
+            // The transcoder asks for output pixels; edge tiles reach past
+            // the region and are transparent there
+            TileService* service = tileService_.get();
+            SlideTranscoder::RegionReader reader =
+                [service, overlay, x0, y0, downsample, outWidth, outHeight](
+                    int64_t x, int64_t y, int64_t width, int64_t height, uint32_t* pixels) {
+                    const double originX = x0 + x * downsample;
+                    const double originY = y0 + y * downsample;
+                    const int32_t w = static_cast<int32_t>(width);
+                    const int32_t h = static_cast<int32_t>(height);
+                    std::vector<uint32_t> argb;
+                    if (service->RenderRegion(originX, originY, downsample, w, h, argb) != TileServiceStatus::Ok) {
+                        return false;
+                    }
+                    overlay->Draw(argb.data(), w, h, originX, originY, downsample);
+                    const int64_t inside = std::clamp<int64_t>(outWidth - x, 0, width);
+                    for (int64_t row = 0; row < height; ++row) {
+                        uint32_t* out = pixels + row * width;
+                        const int64_t copied = y + row < outHeight ? inside : 0;
+                        std::copy_n(argb.data() + row * width, copied, out);
+                        std::fill(out + copied, out + width, 0u);
+                    }
+                    return true;
+                };
 
-            std::string base64;
-            int i = 0;
-            unsigned char char_array_3[3];
-            unsigned char char_array_4[4];
+            job->thread = std::thread([this, state, reader = std::move(reader), options = std::move(options),
+                                       path, outWidth, outHeight]() {
+                state->result = SlideTranscoder::Convert(outWidth, outHeight, reader, path, options);
+                state->finished = true;
+                PostWakeEvent();
+            });
+            regionExport_ = std::move(job);
+            PATHVIEW_LOG_INFO("Region export started: " << outWidth << " x " << outHeight << " to " << path);
 
-            for (size_t idx = 0; idx < pngData.size(); idx++) {
-                char_array_3[i++] = pngData[idx];
-                if (i == 3) {
-                    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                    char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-                    char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-                    char_array_4[3] = char_array_3[2] & 0x3f;
+            json result = {
+                {"card_id", regionExport_->cardId},
+                {"path", path},
+                {"width", outWidth},
+                {"height", outHeight},
+                {"levels", SlideTranscoder::LevelCount(outWidth, outHeight, EXPORT_TILE_SIZE)},
+                {"downsample", downsample},
+                {"region", {{"x", x0}, {"y", y0}, {"width", x1 - x0}, {"height", y1 - y0}}}
+            };
+            if (!overlayInfo.empty()) {
+                result["overlays"] = overlayInfo;
+            }
+            return result;
+        }
+        else if (method == "region.scan") {
+            // Many fields of the slide rendered off screen at once, like
+            // region.render without overlays: "regions" lists x, y, width,
+            // height in level 0 pixels, or "grid" tiles x, y, width, height
+            // (default the whole slide) with field_width x field_height
+            // fields sharing "overlap" pixels. At "downsample", or at the
+            // downsample of pyramid "level". Fields run on worker threads
+            // in Hilbert order; region.scan_results hands them out.
+            if (!slideLoader_ || !slideRenderer_) {
+                throw std::runtime_error("No slide loaded. Use load_slide tool to load a whole-slide image first.");
+            }
+            const Rect slide(0.0, 0.0, static_cast<double>(slideLoader_->GetWidth()),
+                             static_cast<double>(slideLoader_->GetHeight()));
+            auto number = [](const json& object, const char* key) {
+                if (!object.contains(key) || !object[key].is_number()) {
+                    throw std::runtime_error(std::string("Missing '") + key + "' parameter");
+                }
+                return object[key].get<double>();
+            };
 
-                    for(i = 0; i < 4; i++)
-                        base64 += base64_chars[char_array_4[i]];
-                    i = 0;
+            std::vector<Rect> fields;
+            if (params.contains("grid")) {
+                const json& grid = params["grid"];
+                const Rect area(grid.value("x", 0.0), grid.value("y", 0.0),
+                                grid.value("width", slide.width), grid.value("height", slide.height));
+                const double fieldWidth = number(grid, "field_width");
+                const double fieldHeight = number(grid, "field_height");
+                const double overlap = grid.value("overlap", 0.0);
+                if (!(fieldWidth > overlap) || !(fieldHeight > overlap) || overlap < 0.0) {
+                    throw std::runtime_error("field_width and field_height must be larger than overlap");
+                }
+                const double columns = std::ceil((std::min(area.Right(), slide.width) - std::max(area.x, 0.0)) /
+                                                 (fieldWidth - overlap));
+                const double rows = std::ceil((std::min(area.Bottom(), slide.height) - std::max(area.y, 0.0)) /
+                                              (fieldHeight - overlap));
+                if (columns * rows > static_cast<double>(MAX_SCAN_FIELDS)) {
+                    throw std::runtime_error("At most " + std::to_string(MAX_SCAN_FIELDS) +
+                                             " fields per scan; use larger fields");
+                }
+                // Only the part of the area on the slide
+                const double x0 = std::max(area.x, 0.0);
+                const double y0 = std::max(area.y, 0.0);
+                fields = RegionScan::Grid(Rect(x0, y0, std::min(area.Right(), slide.width) - x0,
+                                               std::min(area.Bottom(), slide.height) - y0),
+                                          fieldWidth, fieldHeight, overlap);
+            } else if (params.contains("regions") && params["regions"].is_array()) {
+                if (params["regions"].size() > MAX_SCAN_FIELDS) {
+                    throw std::runtime_error("At most " + std::to_string(MAX_SCAN_FIELDS) + " regions per scan");
                 }
+                for (const json& region : params["regions"]) {
+                    const double x = number(region, "x");
+                    const double y = number(region, "y");
+                    const double x0 = std::max(0.0, x);
+                    const double y0 = std::max(0.0, y);
+                    const double x1 = std::min(slide.width, x + number(region, "width"));
+                    const double y1 = std::min(slide.height, y + number(region, "height"));
+                    if (!(x1 > x0) || !(y1 > y0)) {
+                        throw std::runtime_error("Region " + std::to_string(fields.size()) +
+                                                 " does not overlap the slide");
+                    }
+                    fields.emplace_back(x0, y0, x1 - x0, y1 - y0);
+                }
+            } else {
+                throw std::runtime_error("Missing 'regions' or 'grid' parameter");
+            }
+            if (fields.empty()) {
+                throw std::runtime_error("The scan has no field on the slide");
             }
 
-            if (i) {
-                for(int j = i; j < 3; j++)
-                    char_array_3[j] = '\0';
+            double downsample = params.value("downsample", 1.0);
+            if (params.contains("level")) {
+                const int32_t level = params["level"].get<int32_t>();
+                if (level < 0 || level >= slideLoader_->GetLevelCount()) {
+                    throw std::runtime_error("level must be 0 to " + std::to_string(slideLoader_->GetLevelCount() - 1));
+                }
+                downsample = slideLoader_->GetLevelDownsample(level);
+            }
+            if (!(downsample >= MIN_REGION_DOWNSAMPLE)) {
+                throw std::runtime_error("downsample must be at least " + json(MIN_REGION_DOWNSAMPLE).dump());
+            }
+            for (const Rect& field : fields) {
+                const int64_t pixels = std::max<int64_t>(1, std::llround(field.width / downsample)) *
+                                       std::max<int64_t>(1, std::llround(field.height / downsample));
+                if (pixels > MAX_SCAN_FIELD_PIXELS) {
+                    throw std::runtime_error("Fields are at most " + std::to_string(MAX_SCAN_FIELD_PIXELS) +
+                                             " pixels at this downsample; use smaller fields or raise the downsample");
+                }
+            }
 
-                char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-                char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+            // Drop finished scans nobody collected to make room
+            for (auto it = regionScans_.begin(); regionScans_.size() >= MAX_REGION_SCANS && it != regionScans_.end(); ) {
+                it = it->second->IsDone() ? regionScans_.erase(it) : std::next(it);
+            }
+            if (regionScans_.size() >= MAX_REGION_SCANS) {
+                throw std::runtime_error("Too many region scans running. Collect their results or cancel them first.");
+            }
 
-                for (int j = 0; j < i + 1; j++)
-                    base64 += base64_chars[char_array_4[j]];
+            // Encoded on the workers and kept as bytes: how they travel is
+            // up to each region.scan_results
+            ImageEncoder encode = MakeImageEncoder(params, true);
+            TileService* service = tileService_.get();
+            auto render = [service, encode = std::move(encode), downsample](const Rect& field) {
+                const int32_t width = static_cast<int32_t>(std::max<int64_t>(1, std::llround(field.width / downsample)));
+                const int32_t height = static_cast<int32_t>(std::max<int64_t>(1, std::llround(field.height / downsample)));
+                std::vector<uint32_t> argb;
+                if (service->RenderRegion(field.x, field.y, downsample, width, height, argb) != TileServiceStatus::Ok) {
+                    throw std::runtime_error("Region render failed: the slide changed or its tiles did not load in time");
+                }
+                std::vector<uint8_t> rgba(argb.size() * 4);
+                PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::OverWhite>(
+                    argb.data(), rgba.data(), argb.size());
+                argb = std::vector<uint32_t>();
+                return encode(std::move(rgba), width, height);
+            };
 
-                while(i++ < 3)
-                    base64 += '=';
+            // Cells of the curve are output tiles, so consecutive fields
+            // share the pipeline tiles along their edges
+            std::string token = GenerateUUID();
+            const size_t fieldCount = fields.size();
+            regionScans_[token] = std::make_unique<RegionScan>(
+                std::move(fields), TileService::TILE_SIZE * downsample, std::move(render),
+                std::min(params.value("threads", static_cast<size_t>(0)), RegionScan::MAX_THREADS));
+            return {{"token", token}, {"field_count", fieldCount}, {"downsample", downsample}};
+        }
+        else if (method == "region.scan_results") {
+            std::string token = params.at("token").get<std::string>();
+            auto it = regionScans_.find(token);
+            if (it == regionScans_.end()) {
+                throw std::runtime_error("Unknown region scan token: " + token);
             }
-
-            return json{
-                {"png_data", base64},
-                {"width", capturedWidth},
-                {"height", capturedHeight}
+            RegionScan& scan = *it->second;
+
+            // Results stream back in the order they finish; 'since' is the
+            // number already received, whose images are then let go. With
+            // "transport": "shm" at most one result per slot comes back, so
+            // none is overwritten before it is read.
+            const size_t since = params.value("since", static_cast<size_t>(0));
+            bool fdAttached = false;
+            pathview::ipc::SnapshotRing* ring = GetSnapshotRing(params, fdAttached);
+            size_t limit = std::clamp(params.value("limit", SCAN_PAGE_DEFAULT), static_cast<size_t>(1), SCAN_PAGE_MAX);
+            if (ring) {
+                limit = std::min<size_t>(limit, ring->GetSlotCount());
+            }
+            const bool done = scan.IsDone();
+            std::vector<RegionScan::Result> results;
+            const size_t finished = scan.GetResults(since, limit, results);
+
+            json resultsJson = json::array();
+            for (RegionScan::Result& result : results) {
+                const Rect& field = scan.GetFields()[result.field];
+                json resultJson = result.error.empty() ? std::move(result.image) : json{{"error", result.error}};
+                SendImage(resultJson, ring, fdAttached);
+                resultJson["field"] = result.field;
+                resultJson["region"] = {{"x", field.x}, {"y", field.y}, {"width", field.width}, {"height", field.height}};
+                resultsJson.push_back(std::move(resultJson));
+            }
+            json response = {
+                {"completed", finished},
+                {"field_count", scan.GetFieldCount()},
+                {"done", done},
+                {"cancelled", scan.IsCancelled()},
+                {"results", resultsJson}
             };
+
+            // Everything delivered: forget the scan
+            if (done && since + results.size() >= finished) {
+                regionScans_.erase(it);
+            }
+            return response;
+        }
+        else if (method == "region.scan_cancel") {
+            std::string token = params.at("token").get<std::string>();
+            auto it = regionScans_.find(token);
+            if (it == regionScans_.end()) {
+                throw std::runtime_error("Unknown region scan token: " + token);
+            }
+            // Waits for the fields being rendered; the results are dropped
+            it->second->Cancel();
+            std::vector<RegionScan::Result> results;
+            const size_t finished = it->second->GetResults(0, 0, results);
+            regionScans_.erase(it);
+            return {{"cancelled", true}, {"completed", finished}};
         }
         else if (method == "annotations.create") {
             // Check if slide is loaded
@@ -1693,28 +6337,14 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             if (!params.contains("vertices")) {
                 throw std::runtime_error("Missing 'vertices' parameter");
             }
-
-            auto verticesJson = params["vertices"];
-            if (!verticesJson.is_array() || verticesJson.size() < 3) {
-                throw std::runtime_error("vertices must be an array with at least 3 points");
-            }
-
-            // Convert JSON vertices to Vec2 vector
-            std::vector<Vec2> vertices;
-            for (const auto& vertexJson : verticesJson) {
-                if (!vertexJson.is_array() || vertexJson.size() != 2) {
-                    throw std::runtime_error("Each vertex must be an array of [x, y]");
-                }
-                vertices.push_back(Vec2(vertexJson[0].get<double>(),
-                                       vertexJson[1].get<double>()));
-            }
+            std::vector<Vec2> vertices = ParseVertices(params["vertices"]);
 
             // Get optional name
             std::string name = params.value("name", "");
 
             // Create annotation
             int id = annotationManager_->CreateAnnotation(vertices, name,
-                                                         polygonOverlay_.get());
+                                                         polygonOverlay_);
 
             if (id < 0) {
                 throw std::runtime_error("Failed to create annotation (invalid vertices)");
@@ -1827,10 +6457,20 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 throw std::runtime_error("Annotation with id " + std::to_string(id) + " not found");
             }
 
-            // Convert vertices to JSON
+            // Convert vertices to JSON, packed for binary connections
             json verticesJson = json::array();
-            for (const auto& vertex : annotation->vertices) {
-                verticesJson.push_back({vertex.x, vertex.y});
+            if (ipcServer_->GetCurrentEncoding() != pathview::ipc::WireEncoding::Json) {
+                std::vector<double> coordinates;
+                coordinates.reserve(annotation->vertices.size() * 2);
+                for (const auto& vertex : annotation->vertices) {
+                    coordinates.push_back(vertex.x);
+                    coordinates.push_back(vertex.y);
+                }
+                verticesJson = pathview::ipc::PackDoubles(coordinates);
+            } else {
+                for (const auto& vertex : annotation->vertices) {
+                    verticesJson.push_back({vertex.x, vertex.y});
+                }
             }
 
             // Compute metrics
@@ -1887,6 +6527,60 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 {"deleted_id", id}
             };
         }
+        else if (method == "annotations.export") {
+            if (!slideLoader_) {
+                throw std::runtime_error("No slide loaded");
+            }
+
+            // Every annotation in one GeoJSON FeatureCollection, returned or
+            // written to "path"
+            json geojson = AnnotationGeoJson::Export(annotationManager_->GetStoredAnnotations());
+            const size_t count = annotationManager_->GetAnnotations().size();
+            if (params.contains("path")) {
+                std::string path = params["path"].get<std::string>();
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out << geojson.dump();
+                if (!out) {
+                    throw std::runtime_error("Cannot write " + path);
+                }
+                return json{{"path", path}, {"count", count}};
+            }
+            return json{{"geojson", std::move(geojson)}, {"count", count}};
+        }
+        else if (method == "annotations.import") {
+            if (!slideLoader_) {
+                throw std::runtime_error("No slide loaded");
+            }
+
+            // GeoJSON given inline ("geojson") or as a file ("path"); every
+            // polygon becomes an annotation with a new id
+            json geojson;
+            if (params.contains("geojson")) {
+                geojson = params["geojson"];
+            } else if (params.contains("path")) {
+                std::string path = params["path"].get<std::string>();
+                std::ifstream in(path, std::ios::binary);
+                if (!in) {
+                    throw std::runtime_error("Cannot read " + path);
+                }
+                geojson = json::parse(in);
+            } else {
+                throw std::runtime_error("Missing 'geojson' or 'path' parameter");
+            }
+
+            json ids = json::array();
+            size_t skipped = 0;
+            for (const StoredAnnotation& annotation : AnnotationGeoJson::Import(geojson)) {
+                int id = annotationManager_->CreateAnnotation(annotation.vertices, annotation.name,
+                                                              polygonOverlay_);
+                if (id < 0) {
+                    ++skipped;
+                } else {
+                    ids.push_back(id);
+                }
+            }
+            return json{{"ids", ids}, {"count", ids.size()}, {"skipped", skipped}};
+        }
         else if (method == "annotations.compute_metrics") {
             // Check if slide is loaded
             if (!slideLoader_) {
@@ -1897,51 +6591,122 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             if (!params.contains("vertices")) {
                 throw std::runtime_error("Missing 'vertices' parameter");
             }
+            std::vector<Vec2> vertices = ParseVertices(params["vertices"]);
+
+            // Cells the segmentation is less confident about can be left
+            // out; straddling cells and tissue can be weighed by overlap
+            const TissueMap* tissueMap = polygonOverlay_ ? polygonOverlay_->GetTissueLayer().GetMap() : nullptr;
+            RoiMetrics::Options options = ParseMetricsOptions(params, tissueMap);
+            options.cellStats = polygonOverlay_ ? polygonOverlay_->GetCellStats() : nullptr;
+            const bool hasPolygons = polygonOverlay_ && polygonOverlay_->GetPolygonCount() > 0;
+
+            // A streaming load still fills the store on this thread, so
+            // count what is in so far right here (as for nothing to count,
+            // or vertices that yield empty metrics)
+            if (!hasPolygons || polygonOverlay_->IsLoading() ||
+                !AnnotationManager::ValidateVertices(vertices)) {
+                auto metrics = annotationManager_->ComputeMetricsForVertices(vertices,
+                                                                            polygonOverlay_,
+                                                                            options);
+                json response = MetricsToJson(metrics, options.tissueMap);
+                if (!hasPolygons) {
+                    response["warning"] = "No polygons loaded. Cell counts unavailable. Use load_polygons to enable cell counting.";
+                }
+                return response;
+            }
 
-            auto verticesJson = params["vertices"];
-            if (!verticesJson.is_array() || verticesJson.size() < 3) {
-                throw std::runtime_error("vertices must be an array with at least 3 points");
+            // Otherwise count on a worker: the polygons stay put until
+            // StopPolygonReaders() has waited for it
+            const PolygonStore* polygons = &polygonOverlay_->GetPolygons();
+            const PolygonIndex* index = polygonOverlay_->GetSpatialIndex();
+            ipcServer_->Defer(commandExecutor_->Submit(
+                [vertices = std::move(vertices), polygons, index, options]() {
+                    return MetricsToJson(RoiMetrics::Compute(vertices, polygons, index, options),
+                                         options.tissueMap);
+                }));
+            return json();
+        }
+        else if (method == "annotations.compute_metrics_batch") {
+            if (!slideLoader_) {
+                throw std::runtime_error("No slide loaded. Use load_slide tool to load a whole-slide image first.");
+            }
+            if (polygonOverlay_ && polygonOverlay_->IsLoading()) {
+                throw std::runtime_error("Polygons are still loading. Retry once the load completes.");
             }
 
-            // Convert JSON vertices to Vec2 vector
-            std::vector<Vec2> vertices;
-            for (const auto& vertexJson : verticesJson) {
-                if (!vertexJson.is_array() || vertexJson.size() != 2) {
-                    throw std::runtime_error("Each vertex must be an array of [x, y]");
+            if (!params.contains("rois") || !params["rois"].is_array() || params["rois"].empty()) {
+                throw std::runtime_error("rois must be a non-empty array of vertex arrays");
+            }
+            if (params["rois"].size() > MAX_BATCH_ROIS) {
+                throw std::runtime_error("At most " + std::to_string(MAX_BATCH_ROIS) + " rois per batch");
+            }
+            std::vector<std::vector<Vec2>> rois;
+            rois.reserve(params["rois"].size());
+            for (const auto& roiJson : params["rois"]) {
+                rois.push_back(ParseVertices(roiJson));
+                if (!AnnotationManager::ValidateVertices(rois.back())) {
+                    throw std::runtime_error("rois must not contain NaN or infinite coordinates");
                 }
-                vertices.push_back(Vec2(vertexJson[0].get<double>(),
-                                       vertexJson[1].get<double>()));
             }
+            const TissueMap* tissueMap = polygonOverlay_ ? polygonOverlay_->GetTissueLayer().GetMap() : nullptr;
+            RoiMetrics::Options options = ParseMetricsOptions(params, tissueMap);
+            options.cellStats = polygonOverlay_ ? polygonOverlay_->GetCellStats() : nullptr;
 
-            // Compute metrics without creating annotation
-            auto metrics = annotationManager_->ComputeMetricsForVertices(vertices,
-                                                                        polygonOverlay_.get());
+            // Drop finished batches nobody collected to make room
+            for (auto it = roiBatches_.begin(); roiBatches_.size() >= MAX_ROI_BATCHES && it != roiBatches_.end(); ) {
+                it = it->second->IsDone() ? roiBatches_.erase(it) : std::next(it);
+            }
+            if (roiBatches_.size() >= MAX_ROI_BATCHES) {
+                throw std::runtime_error("Too many ROI batches running. Collect their results first.");
+            }
 
-            json cellCountsJson = json::object();
-            for (const auto& [classId, count] : metrics.cellCounts) {
-                cellCountsJson[std::to_string(classId)] = count;
+            // Counted on worker threads; this thread only hands out results
+            const bool hasPolygons = polygonOverlay_ && polygonOverlay_->GetPolygonCount() > 0;
+            std::string token = GenerateUUID();
+            const size_t roiCount = rois.size();
+            roiBatches_[token] = std::make_unique<RoiMetricsBatch>(
+                std::move(rois),
+                hasPolygons ? &polygonOverlay_->GetPolygons() : nullptr,
+                hasPolygons ? polygonOverlay_->GetSpatialIndex() : nullptr,
+                options);
+
+            json response = {{"token", token}, {"roi_count", roiCount}};
+            if (!hasPolygons) {
+                response["warning"] = "No polygons loaded. Cell counts unavailable. Use load_polygons to enable cell counting.";
             }
-            if (!metrics.cellCounts.empty()) {
-                cellCountsJson["total"] = metrics.totalCells;
+            return response;
+        }
+        else if (method == "annotations.batch_results") {
+            std::string token = params.at("token").get<std::string>();
+            auto it = roiBatches_.find(token);
+            if (it == roiBatches_.end()) {
+                throw std::runtime_error("Unknown ROI batch token: " + token);
             }
 
+            // Results stream back in the order they finish; pass the number
+            // already received as 'since' to get only the new ones
+            const size_t since = params.value("since", static_cast<size_t>(0));
+            const bool done = it->second->IsDone();
+            std::vector<RoiMetricsBatch::Result> results;
+            const size_t finished = it->second->GetResults(since, results);
+
+            json resultsJson = json::array();
+            for (const RoiMetricsBatch::Result& result : results) {
+                json resultJson = MetricsToJson(result.metrics, it->second->GetOptions().tissueMap);
+                resultJson["roi"] = result.roi;
+                resultsJson.push_back(std::move(resultJson));
+            }
             json response = {
-                {"bounding_box", {
-                    {"x", metrics.boundingBox.x},
-                    {"y", metrics.boundingBox.y},
-                    {"width", metrics.boundingBox.width},
-                    {"height", metrics.boundingBox.height}
-                }},
-                {"area", metrics.area},
-                {"perimeter", metrics.perimeter},
-                {"cell_counts", cellCountsJson}
+                {"completed", finished},
+                {"roi_count", it->second->GetRoiCount()},
+                {"done", done},
+                {"results", resultsJson}
             };
 
-            // Add warning if polygons not loaded
-            if (!polygonOverlay_ || polygonOverlay_->GetPolygonCount() == 0) {
-                response["warning"] = "No polygons loaded. Cell counts unavailable. Use load_polygons to enable cell counting.";
+            // Everything delivered: forget the batch
+            if (done && since + results.size() >= finished) {
+                roiBatches_.erase(it);
             }
-
             return response;
         }
 
@@ -1961,28 +6726,9 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             card.reasoning = reasoning;
             card.ownerUUID = ownerUUID;
 
-            // Store (thread-safe)
-            {
-                std::lock_guard<std::mutex> lock(actionCardsMutex_);
-
-                // Enforce max cards limit
-                if (actionCards_.size() >= MAX_ACTION_CARDS) {
-                    // Remove oldest completed/failed/cancelled card
-                    auto it = std::find_if(actionCards_.begin(), actionCards_.end(),
-                        [](const pathview::ActionCard& c) {
-                            return c.status == pathview::ActionCardStatus::COMPLETED ||
-                                   c.status == pathview::ActionCardStatus::FAILED ||
-                                   c.status == pathview::ActionCardStatus::CANCELLED;
-                        });
-                    if (it != actionCards_.end()) {
-                        actionCards_.erase(it);
-                    }
-                }
-
-                actionCards_.push_back(card);
-            }
+            AddActionCard(card);
 
-            std::cout << "Action card created: " << title << " (id: " << cardId << ")" << std::endl;
+            PATHVIEW_LOG_INFO("Action card created: " << title << " (id: " << cardId << ")");
 
             return json{
                 {"id", cardId},
@@ -2018,6 +6764,9 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 it->reasoning = params["reasoning"].get<std::string>();
                 it->updatedAt = std::chrono::system_clock::now();
             }
+            if (annotationJournal_) {
+                annotationJournal_->PutCard(*it);
+            }
 
             return json{
                 {"id", it->id},
@@ -2043,10 +6792,13 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
 
             // Append log
             it->AppendLog(message, level);
+            if (annotationJournal_) {
+                annotationJournal_->PutCard(*it);
+            }
 
             return json{
                 {"id", it->id},
-                {"log_count", it->logEntries.size()},
+                {"log_count", it->GetLogEntryCount()},
                 {"updated_at", std::chrono::duration_cast<std::chrono::milliseconds>(
                     it->updatedAt.time_since_epoch()).count()}
             };
@@ -2062,7 +6814,8 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                     {"status", pathview::ActionCard::StatusToString(card.status)},
                     {"summary", card.summary},
                     {"owner_uuid", card.ownerUUID},
-                    {"log_entry_count", card.logEntries.size()},
+                    {"log_entry_count", card.GetLogEntryCount()},
+                    {"log_first_index", card.droppedLogEntries},
                     {"created_at", std::chrono::duration_cast<std::chrono::milliseconds>(
                         card.createdAt.time_since_epoch()).count()},
                     {"updated_at", std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -2075,6 +6828,50 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
                 {"count", actionCards_.size()}
             };
         }
+        else if (method == "action_card.get_log") {
+            // A page of a card's log: {"offset": N} is the index of the
+            // first entry wanted among all ever appended (default: the
+            // oldest kept), {"limit": N} at most LOG_PAGE_MAX of them.
+            // Entries older than log_first_index were dropped.
+            std::string cardId = params.at("id").get<std::string>();
+            int64_t offset = params.value("offset", int64_t{0});
+            int64_t limit = params.value("limit", static_cast<int64_t>(LOG_PAGE_DEFAULT));
+            if (offset < 0 || limit < 0) {
+                throw std::runtime_error("offset and limit must be >= 0");
+            }
+
+            std::lock_guard<std::mutex> lock(actionCardsMutex_);
+
+            auto it = std::find_if(actionCards_.begin(), actionCards_.end(),
+                [&cardId](const pathview::ActionCard& c) { return c.id == cardId; });
+
+            if (it == actionCards_.end()) {
+                throw std::runtime_error("Action card not found: " + cardId);
+            }
+
+            const size_t first = std::max(static_cast<size_t>(offset), it->droppedLogEntries);
+            const size_t end = std::min(it->GetLogEntryCount(),
+                                        first + std::min(static_cast<size_t>(limit), LOG_PAGE_MAX));
+            json entries = json::array();
+            for (size_t index = first; index < end; ++index) {
+                const pathview::ActionCardLogEntry& entry = it->logEntries[index - it->droppedLogEntries];
+                entries.push_back({
+                    {"index", index},
+                    {"timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(
+                        entry.timestamp.time_since_epoch()).count()},
+                    {"level", entry.level},
+                    {"message", entry.message}
+                });
+            }
+
+            return json{
+                {"id", it->id},
+                {"entries", entries},
+                {"log_first_index", it->droppedLogEntries},
+                {"log_count", it->GetLogEntryCount()},
+                {"next_offset", std::max(end, first)}
+            };
+        }
         else if (method == "action_card.delete") {
             std::string cardId = params.at("id").get<std::string>();
 
@@ -2088,6 +6885,9 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
             }
 
             actionCards_.erase(it);
+            if (annotationJournal_) {
+                annotationJournal_->DeleteCard(cardId);
+            }
 
             return json{
                 {"success", true},
@@ -2103,22 +6903,525 @@ pathview::ipc::json Application::HandleIPCCommand(const std::string& method, con
     }
 }
 
-void Application::CaptureScreenshot() {
-    int w = windowWidth_;
-    int h = windowHeight_;
+void Application::AddActionCard(const pathview::ActionCard& card) {
+    std::lock_guard<std::mutex> lock(actionCardsMutex_);
+
+    // Enforce max cards limit
+    if (actionCards_.size() >= MAX_ACTION_CARDS) {
+        // Remove oldest completed/failed/cancelled card
+        auto it = std::find_if(actionCards_.begin(), actionCards_.end(),
+            [](const pathview::ActionCard& c) {
+                return c.status == pathview::ActionCardStatus::COMPLETED ||
+                       c.status == pathview::ActionCardStatus::FAILED ||
+                       c.status == pathview::ActionCardStatus::CANCELLED;
+            });
+        if (it != actionCards_.end()) {
+            if (annotationJournal_) {
+                annotationJournal_->DeleteCard(it->id);
+            }
+            actionCards_.erase(it);
+        }
+    }
+
+    actionCards_.push_back(card);
+    if (annotationJournal_) {
+        annotationJournal_->PutCard(card);
+    }
+}
+
+void Application::ParseRegionParams(const pathview::ipc::json& params, double& x0, double& y0, double& x1,
+                                    double& y1, double& downsample) const {
+    using pathview::ipc::json;
+
+    // x, y, width, height in level 0 pixels, clipped to the slide, at
+    // "downsample" (level 0 pixels per output pixel) or fit to "output_width"
+    if (!slideLoader_ || !slideRenderer_) {
+        throw std::runtime_error("No slide loaded. Use load_slide tool to load a whole-slide image first.");
+    }
+    for (const char* key : {"x", "y", "width", "height"}) {
+        if (!params.contains(key) || !params[key].is_number()) {
+            throw std::runtime_error(std::string("Missing '") + key + "' parameter");
+        }
+    }
+    const double requestX = params["x"].get<double>();
+    const double requestY = params["y"].get<double>();
+    x0 = std::max(0.0, requestX);
+    y0 = std::max(0.0, requestY);
+    x1 = std::min(static_cast<double>(slideLoader_->GetWidth()), requestX + params["width"].get<double>());
+    y1 = std::min(static_cast<double>(slideLoader_->GetHeight()), requestY + params["height"].get<double>());
+    if (x1 <= x0 || y1 <= y0) {
+        throw std::runtime_error("Region does not overlap the slide");
+    }
+
+    downsample = params.value("downsample", 1.0);
+    if (params.contains("output_width")) {
+        downsample = (x1 - x0) / std::max(1, params["output_width"].get<int>());
+    }
+    if (!(downsample >= MIN_REGION_DOWNSAMPLE)) {
+        throw std::runtime_error("downsample must be at least " + json(MIN_REGION_DOWNSAMPLE).dump());
+    }
+}
+
+std::shared_ptr<RegionOverlay> Application::BuildRegionOverlay(const pathview::ipc::json& names, const Rect& region,
+                                                               size_t maxPolygons, pathview::ipc::json& info) {
+    auto overlay = std::make_shared<RegionOverlay>();
+    bool drawPolygons = false;
+    bool drawAnnotations = false;
+    for (const auto& name : names) {
+        const std::string overlayName = name.get<std::string>();
+        if (overlayName == "polygons") {
+            drawPolygons = true;
+        } else if (overlayName == "annotations") {
+            drawAnnotations = true;
+        } else {
+            throw std::runtime_error("Unknown overlay: " + overlayName);
+        }
+    }
+    if (drawPolygons) {
+        const PolygonIndex* index = polygonOverlay_->GetSpatialIndex();
+        const PolygonStore& polygons = polygonOverlay_->GetPolygons();
+        size_t drawn = 0;
+        bool truncated = false;
+        if (index && polygonOverlay_->IsVisible()) {
+            const size_t layer = overlay->AddLayer(polygonOverlay_->GetOpacity());
+            for (uint32_t polygon : index->QueryRegion(region)) {
+                const int classId = polygons.GetClassId(polygon);
+                if (!polygonOverlay_->IsClassVisible(classId)) {
+                    continue;
+                }
+                if (drawn == maxPolygons) {
+                    truncated = true;
+                    break;
+                }
+                const SDL_Color color = polygonOverlay_->GetClassColor(classId);
+                overlay->AddPolygon(layer, polygons.GetVertices(polygon), polygons.GetVertexCount(polygon),
+                                    (uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | color.b);
+                ++drawn;
+            }
+        }
+        info["polygons"] = drawn;
+        if (truncated) {
+            info["polygons_truncated"] = true;
+        }
+    }
+    if (drawAnnotations) {
+        auto rgb = [](SDL_Color color) {
+            return (uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | color.b;
+        };
+        const size_t fill = overlay->AddLayer(AnnotationManager::ANNOTATION_OPACITY);
+        const size_t outline = overlay->AddLayer(1.0f);
+        for (const AnnotationPolygon& annotation : annotationManager_->GetAnnotations()) {
+            overlay->AddPolygon(fill, annotation.vertices, rgb(AnnotationManager::ANNOTATION_COLOR));
+            overlay->AddOutline(outline, annotation.vertices, rgb(AnnotationManager::ANNOTATION_OUTLINE_COLOR),
+                                REGION_OUTLINE_WIDTH);
+        }
+        info["annotations"] = annotationManager_->GetAnnotationCount();
+    }
+    return overlay;
+}
+
+Application::ImageEncoder Application::MakeImageEncoder(const pathview::ipc::json& params, bool keepBytes) {
+    using pathview::ipc::json;
+
+    // "format": png (default), jpeg, webp or qoi; "quality" for the
+    // lossy ones
+    pathview::SnapshotEncoder::Options encoding;
+    if (params.contains("format")) {
+        std::optional<pathview::SnapshotFormat> format =
+            pathview::SnapshotEncoder::ParseFormat(params["format"].get<std::string>());
+        if (!format) {
+            throw std::runtime_error("Unknown snapshot format: " + params["format"].get<std::string>());
+        }
+        encoding.format = *format;
+    }
+    encoding.quality = params.value("quality", encoding.quality);
+
+    bool fdAttached = false;
+    pathview::ipc::SnapshotRing* ring = keepBytes ? nullptr : GetSnapshotRing(params, fdAttached);
+
+    // Encoding the copy runs on a worker; the MCP server stores the
+    // image. "format" is what was written: builds without a codec
+    // send PNG instead. PNG keeps its "png_data" key. Binary
+    // connections get the bytes as they are. "content_hash" keys the
+    // image by its pixels and encoding: a frame seen a moment ago is not
+    // encoded again, and the MCP server keeps one snapshot per hash.
+    if (!encodedImages_) {
+        encodedImages_ = std::make_shared<pathview::EncodedImageCache>();
+    }
+    const bool binaryWire = keepBytes || ipcServer_->GetCurrentEncoding() != pathview::ipc::WireEncoding::Json;
+    return [ring, encoding, binaryWire, fdAttached, cache = encodedImages_, metrics = metrics_,
+            trace = ipcServer_->GetCurrentTrace()](
+               std::vector<uint8_t> pixels, int capturedWidth, int capturedHeight) {
+        using pathview::ipc::RequestTrace;
+        const uint64_t key =
+            pathview::SnapshotEncoder::ContentKey(pixels, capturedWidth, capturedHeight, encoding);
+        std::shared_ptr<const pathview::SnapshotEncoder::Result> image = cache->Find(key);
+        if (!image) {
+            RequestTrace::Scope encodeSpan(trace.get(), "gui.encode");
+            const auto start = std::chrono::steady_clock::now();
+            image = std::make_shared<const pathview::SnapshotEncoder::Result>(
+                pathview::SnapshotEncoder::Encode(pixels, capturedWidth, capturedHeight, encoding));
+            metrics->Histogram("pathview_snapshot_encode_seconds", "Snapshot and region image encode time",
+                               pathview::http::Metrics::LatencyBounds(),
+                               "format", pathview::SnapshotEncoder::FormatName(image->format))
+                .Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            cache->Insert(key, image);
+        }
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(key));
+        json result{{"width", capturedWidth}, {"height", capturedHeight},
+                    {"format", pathview::SnapshotEncoder::FormatName(image->format)},
+                    {"mime_type", pathview::SnapshotEncoder::MimeType(image->format)},
+                    {"content_hash", hash}};
+        pathview::ipc::SnapshotRing::SlotRef slot;
+        RequestTrace::Scope shmSpan(ring ? trace.get() : nullptr, "gui.shm_write");
+        const bool written = ring && ring->Write(image->data.data(), image->data.size(), slot);
+        shmSpan.End();
+        if (written) {
+            result["shm"] = json{
+                {"name", ring->GetName()},
+                {"slot", slot.slot},
+                {"sequence", slot.sequence},
+                {"size", slot.size}
+            };
+            if (fdAttached) {
+                result["shm"]["fd_attached"] = true;
+            }
+        } else {
+            const bool png = image->format == pathview::SnapshotFormat::Png;
+            RequestTrace::Scope base64Span(binaryWire ? nullptr : trace.get(), "gui.base64");
+            result[png ? "png_data" : "image_data"] =
+                binaryWire ? json::binary(image->data)
+                           : json(pathview::ipc::Base64Encode(image->data));
+        }
+        return result;
+    };
+}
+
+pathview::ipc::SnapshotRing* Application::GetSnapshotRing(const pathview::ipc::json& params, bool& fdAttached) {
+    // With "transport": "shm" the image goes into a shared-memory slot
+    // and only its reference is sent; base64 inline otherwise, or
+    // when it cannot (no shared memory, image larger than a slot)
+    fdAttached = false;
+    if (params.value("transport", "") != "shm") {
+        return nullptr;
+    }
+    if (!snapshotRing_ && !snapshotRingFailed_) {
+        snapshotRing_ = pathview::ipc::SnapshotRing::Create(pathview::ipc::SnapshotRing::DefaultName());
+        snapshotRingFailed_ = !snapshotRing_;
+        if (snapshotRingFailed_) {
+            PATHVIEW_LOG_ERROR("Snapshot shared memory unavailable, sending snapshots inline");
+        }
+    }
+    // Over the Unix socket the ring's descriptor comes along, for
+    // clients that cannot open it by name
+    pathview::ipc::SnapshotRing* ring = snapshotRing_.get();
+    fdAttached = ring && ring->GetFd() >= 0 && ipcServer_->CanPassDescriptors() &&
+                 ipcServer_->AttachDescriptor(ring->GetFd());
+    return ring;
+}
+
+void Application::SendImage(pathview::ipc::json& image, pathview::ipc::SnapshotRing* ring, bool fdAttached) {
+    using pathview::ipc::json;
+
+    const char* key = image.contains("png_data") ? "png_data" : "image_data";
+    if (!image.contains(key) || !image[key].is_binary()) {
+        return;
+    }
+    const std::vector<uint8_t>& data = image[key].get_binary();
+    pathview::ipc::SnapshotRing::SlotRef slot;
+    if (ring && ring->Write(data.data(), data.size(), slot)) {
+        image["shm"] = json{
+            {"name", ring->GetName()},
+            {"slot", slot.slot},
+            {"sequence", slot.sequence},
+            {"size", slot.size}
+        };
+        if (fdAttached) {
+            image["shm"]["fd_attached"] = true;
+        }
+        image.erase(key);
+    } else if (ipcServer_->GetCurrentEncoding() == pathview::ipc::WireEncoding::Json) {
+        image[key] = pathview::ipc::Base64Encode(data);
+    }
+}
+
+void Application::ReadRenderPixels(std::vector<uint8_t>& pixels, int& width, int& height) {
+    width = windowWidth_;
+    height = windowHeight_;
 
     // Allocate buffer for RGBA pixels
-    std::vector<uint8_t> pixels(w * h * 4);
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    // Read pixels from renderer (MUST be on render thread). RGBA32 is R, G,
+    // B, A in memory whatever the byte order, as the encoders expect.
+    SDL_RenderReadPixels(renderer_, nullptr, SDL_PIXELFORMAT_RGBA32,
+                        pixels.data(), width * 4);
+}
+
+void Application::ReadSnapshotPixels(int maxDimension, double scale, std::vector<uint8_t>& pixels,
+                                     int& width, int& height) {
+    if (maxDimension <= 0 && scale >= 1.0) {
+        ReadRenderPixels(pixels, width, height);
+        return;
+    }
+
+    // Scaled down on the GPU from the scene, then only the small image is
+    // read back
+    if (sceneTexture_) {
+        pathview::SnapshotEncoder::FitSize(sceneTextureWidth_, sceneTextureHeight_, maxDimension, scale,
+                                           width, height);
+        if ((width != sceneTextureWidth_ || height != sceneTextureHeight_) &&
+            ReadScaledScene(width, height, pixels)) {
+            return;
+        }
+    }
+
+    // No render targets: the whole window, averaged down here
+    int fullWidth, fullHeight;
+    ReadRenderPixels(pixels, fullWidth, fullHeight);
+    pathview::SnapshotEncoder::FitSize(fullWidth, fullHeight, maxDimension, scale, width, height);
+    if (width != fullWidth || height != fullHeight) {
+        pixels = pathview::SnapshotEncoder::Downscale(pixels, fullWidth, fullHeight, width, height);
+    }
+}
+
+bool Application::ReadScaledScene(int width, int height, std::vector<uint8_t>& pixels) {
+    SDL_Texture* scaled = DownscaleScene(width, height);
+    if (!scaled) {
+        return false;
+    }
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    SDL_SetRenderTarget(renderer_, scaled);
+    const bool ok =
+        SDL_RenderReadPixels(renderer_, nullptr, SDL_PIXELFORMAT_RGBA32, pixels.data(), width * 4) == 0;
+    SDL_SetRenderTarget(renderer_, nullptr);
+    if (!ok) {
+        PATHVIEW_LOG_WARNING("Application: GPU snapshot readback failed, scaling on the CPU ("
+                          << SDL_GetError() << ")");
+    }
+    return ok;
+}
+
+SDL_Texture* Application::DownscaleScene(int width, int height) {
+    // Halve with linear filtering (each step averages 2x2 pixels, so none
+    // is skipped) until within twice the size, then one copy to it
+    SDL_ScaleMode sceneScaleMode = SDL_ScaleModeNearest;
+    SDL_GetTextureScaleMode(sceneTexture_, &sceneScaleMode);
+    SDL_Texture* source = sceneTexture_;
+    int sourceWidth = sceneTextureWidth_;
+    int sourceHeight = sceneTextureHeight_;
+    size_t step = 0;
+    bool ok = true;
+    while (ok && (sourceWidth != width || sourceHeight != height)) {
+        int stepWidth = sourceWidth / 2;
+        int stepHeight = sourceHeight / 2;
+        if (stepWidth < width || stepHeight < height) {
+            stepWidth = width;
+            stepHeight = height;
+        }
+        if (step == downscaleTextures_.size()) {
+            downscaleTextures_.push_back({});
+        }
+        DownscaleTexture& target = downscaleTextures_[step++];
+        if (!target.texture || target.width != stepWidth || target.height != stepHeight) {
+            if (target.texture) {
+                SDL_DestroyTexture(target.texture);
+            }
+            target.texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                               stepWidth, stepHeight);
+            target.width = stepWidth;
+            target.height = stepHeight;
+            if (!target.texture) {
+                ok = false;
+                break;
+            }
+            SDL_SetTextureBlendMode(target.texture, SDL_BLENDMODE_NONE);
+        }
+        SDL_SetTextureScaleMode(source, SDL_ScaleModeLinear);
+        ok = SDL_SetRenderTarget(renderer_, target.texture) == 0 &&
+             SDL_RenderCopy(renderer_, source, nullptr, nullptr) == 0;
+        source = target.texture;
+        sourceWidth = stepWidth;
+        sourceHeight = stepHeight;
+    }
+    SDL_SetTextureScaleMode(sceneTexture_, sceneScaleMode);
+    SDL_SetRenderTarget(renderer_, nullptr);
+    if (!ok) {
+        PATHVIEW_LOG_WARNING("Application: GPU snapshot downscale failed, scaling on the CPU ("
+                          << SDL_GetError() << ")");
+        return nullptr;
+    }
+    return source;
+}
+
+void Application::RequestSnapshotPixels(int maxDimension, double scale, ReadbackDone done) {
+    if (renderBackend_ && renderBackend_->HasAsyncReadback() && sceneCacheEnabled_ && sceneTexture_) {
+        int width, height;
+        pathview::SnapshotEncoder::FitSize(sceneTextureWidth_, sceneTextureHeight_, maxDimension, scale,
+                                           width, height);
+        SDL_Texture* source = sceneTexture_;
+        if (width != sceneTextureWidth_ || height != sceneTextureHeight_) {
+            source = DownscaleScene(width, height);
+        }
+        uint64_t ticket = 0;
+        if (source) {
+            SDL_SetRenderTarget(renderer_, source);
+            ticket = renderBackend_->StartReadback(SDL_Rect{0, 0, width, height});
+            SDL_SetRenderTarget(renderer_, nullptr);
+        }
+        if (ticket != 0) {
+            sceneReadbacks_.push_back({ticket, width, height, maxDimension, scale, std::move(done)});
+            return;
+        }
+    }
 
-    // Read pixels from renderer (MUST be on render thread)
-    SDL_RenderReadPixels(renderer_, nullptr, SDL_PIXELFORMAT_RGBA8888,
-                        pixels.data(), w * 4);
+    int width, height;
+    ReadSnapshotPixels(maxDimension, scale, readbackPixels_, width, height);
+    done(readbackPixels_, width, height);
+}
+
+void Application::FinishSceneReadbacks(bool wait) {
+    // Oldest first, so stream frames and answers keep their order
+    while (!sceneReadbacks_.empty() &&
+           renderBackend_->FinishReadback(sceneReadbacks_.front().ticket, &readbackPixels_, wait)) {
+        SceneReadback readback = std::move(sceneReadbacks_.front());
+        sceneReadbacks_.erase(sceneReadbacks_.begin());
+        int width = readback.width;
+        int height = readback.height;
+        if (readbackPixels_.empty()) {
+            // The copy failed: read what is there now
+            ReadSnapshotPixels(readback.maxDimension, readback.scale, readbackPixels_, width, height);
+        }
+        readback.done(readbackPixels_, width, height);
+    }
+}
+
+void Application::CaptureScreenshot(int maxDimension, double scale) {
+    int w, h;
+    ReadSnapshotPixels(maxDimension, scale, captureReadback_, w, h);
+
+    // Store in buffer (thread-safe); the readback buffer comes back holding
+    // the storage of the capture it replaced
+    screenshotBuffer_->StoreCapture(captureReadback_, w, h);
+}
+
+bool Application::IsViewSharp() const {
+    if (!slideRenderer_ || !viewport_) {
+        return true;  // Nothing to wait for
+    }
+    return !viewport_->IsAnimating() && slideRenderer_->GetFallbackQuadCount() == 0 &&
+           !slideRenderer_->HasDeferredUploads() && !slideRenderer_->IsMotionCoarsened();
+}
+
+void Application::ServicePendingCaptures() {
+    if (pendingCaptures_.empty() || !commandExecutor_) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const bool sharp = IsViewSharp();
+
+    // One read serves every capture that is due at the same size; the last
+    // of them takes the pixels, the others a copy
+    std::vector<std::shared_ptr<std::vector<PendingCapture>>> due;
+    for (auto it = pendingCaptures_.begin(); it != pendingCaptures_.end(); ) {
+        if (!sharp && now < it->deadline) {
+            ++it;
+            continue;
+        }
+        auto group = std::find_if(due.begin(), due.end(), [&](const auto& captures) {
+            return captures->front().maxDimension == it->maxDimension && captures->front().scale == it->scale;
+        });
+        if (group == due.end()) {
+            group = due.insert(due.end(), std::make_shared<std::vector<PendingCapture>>());
+        }
+        (*group)->push_back(std::move(*it));
+        it = pendingCaptures_.erase(it);
+    }
 
-    // Store in buffer (thread-safe)
-    screenshotBuffer_->StoreCapture(pixels, w, h);
+    for (std::shared_ptr<std::vector<PendingCapture>>& captures : due) {
+        const int64_t readStartUs = pathview::ipc::RequestTrace::NowUs();
+        auto answer = [this, captures, now, sharp, readStartUs](std::vector<uint8_t>& pixels, int width,
+                                                                int height) {
+            const int64_t readEndUs = pathview::ipc::RequestTrace::NowUs();
+            for (size_t i = 0; i < captures->size(); ++i) {
+                PendingCapture& capture = (*captures)[i];
+                if (capture.trace) {
+                    capture.trace->Add("gui.await_sharp", capture.requestedUs, readStartUs);
+                    capture.trace->Add("gui.read_pixels", readStartUs, readEndUs);
+                }
+                std::vector<uint8_t> own = i + 1 == captures->size() ? std::move(pixels) : pixels;
+                const int64_t waitedMs =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(now - capture.requested).count();
+                commandExecutor_->Submit([capture = std::move(capture), pixels = std::move(own), width, height,
+                                          sharp, waitedMs, submittedUs = readEndUs]() mutable {
+                    if (capture.trace) {
+                        capture.trace->Add("executor.queue", submittedUs, pathview::ipc::RequestTrace::NowUs());
+                    }
+                    try {
+                        pathview::ipc::json result = capture.encode(std::move(pixels), width, height);
+                        result["sharp"] = sharp;
+                        result["waited_ms"] = waitedMs;
+                        capture.reply->set_value(std::move(result));
+                    } catch (...) {
+                        capture.reply->set_exception(std::current_exception());
+                    }
+                    return pathview::ipc::json();
+                });
+            }
+        };
+        ProfileZone zone(&frameProfiler_, "Screenshot");
+        RequestSnapshotPixels(captures->front().maxDimension, captures->front().scale, std::move(answer));
+    }
 }
 
-std::vector<uint8_t> Application::EncodePNG(const std::vector<uint8_t>& pixels,
-                                            int width, int height) {
-    return pathview::PNGEncoder::Encode(pixels, width, height);
+void Application::PublishStreamFrame() {
+    if (!tileServer_ || !commandExecutor_ || streamReadbackPending_) {
+        return;
+    }
+    pathview::http::FrameStream& stream = tileServer_->GetFrameStream();
+    const int fps = stream.GetRequestedFps();
+    const uint32_t now = SDL_GetTicks();
+    if (fps <= 0 || now - lastStreamFrameTime_ < static_cast<uint32_t>(1000 / fps)) {
+        return;
+    }
+    // Still encoding the previous frame: skip this one rather than queue
+    if (streamEncode_.valid()) {
+        if (streamEncode_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        try {
+            streamEncode_.get();
+        } catch (const std::exception& e) {
+            PATHVIEW_LOG_ERROR("Stream frame encoding failed: " << e.what());
+            streamPixels_.clear();  // Never published: send the next one regardless
+        }
+    }
+    lastStreamFrameTime_ = now;
+    ProfileZone zone(&frameProfiler_, "Stream");
+
+    // Swap the frame read with the last published one when they differ:
+    // the encoder reads streamPixels_ in place, untouched until it has
+    // finished (checked above; no read starts while one is in flight)
+    streamReadbackPending_ = true;
+    RequestSnapshotPixels(0, 1.0, [this](std::vector<uint8_t>& pixels, int width, int height) {
+        streamReadbackPending_ = false;
+        if (!tileServer_ || pixels == streamPixels_) {
+            return;  // Redrawn but unchanged: subscribers already have it
+        }
+        streamPixels_.swap(pixels);
+
+        pathview::http::FrameStream& stream = tileServer_->GetFrameStream();
+        streamEncode_ = commandExecutor_->Submit(
+            [&pixels = streamPixels_, width, height, &stream]() {
+                pathview::SnapshotEncoder::Options encoding;
+                encoding.format = pathview::SnapshotFormat::Jpeg;
+                encoding.quality = STREAM_JPEG_QUALITY;
+                pathview::SnapshotEncoder::Result image =
+                    pathview::SnapshotEncoder::Encode(pixels, width, height, encoding);
+                stream.Publish(std::move(image.data), pathview::SnapshotEncoder::MimeType(image.format),
+                               width, height);
+                return pathview::ipc::json();
+            });
+    });
 }
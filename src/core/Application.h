@@ -3,9 +3,13 @@
 #include <SDL2/SDL.h>
 #include <memory>
 #include <string>
+#include <optional>
 #include <chrono>
+#include <future>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <thread>
 
 // Cross-platform socket type (must be defined before NavigationLock.h if not included)
 #ifdef _WIN32
@@ -22,24 +26,47 @@
 
 class SlideLoader;
 class SlideRenderer;
+class ChannelCompositor;
+class TileCache;
+class TileLoadThreadPool;
 class Minimap;
+class SlideOpenTask;
+class PolygonLoadTask;
+struct MinimapOverview;
+struct SlideMetadata;
 class Viewport;
 class TextureManager;
 class PolygonOverlay;
+class HeatmapLayer;
+class AnnotationJournal;
 class AnnotationManager;
+class RoiMetricsBatch;
+class RegionScan;
+class RegionOverlay;
 class NavigationLock;
 struct ImFont;
 
 namespace pathview {
 class ScreenshotBuffer;
+class EncodedImageCache;
 }
 
 // Forward declare IPC types
 namespace pathview {
 namespace ipc {
     class IPCServer;
+    class CommandExecutor;
+    class SnapshotRing;
+    class EventSubscriptions;
+    class RequestTrace;
 }
+namespace http {
+    class HTTPServer;
 }
+}
+
+class TileService;
+class CellTileService;
 
 #include "json.hpp"
 namespace pathview {
@@ -50,6 +77,25 @@ namespace ipc {
 
 #include "AnimationToken.h"
 #include "ActionCard.h"
+#include "DiskTileCache.h"
+#include "SlideRenderer.h"  // For LevelSelection
+#include "TileCache.h"  // For TileEvictionPolicy
+#include "BlockCompressor.h"  // For TextureCompression
+#include "ViewportTrace.h"
+#include "FrameBenchmark.h"
+#include "FrameProfiler.h"
+#include "MemoryRegistry.h"
+#include "Worklist.h"
+#include "SlideLibrary.h"
+#include "Session.h"
+#include "ViewportLink.h"
+#include "PrefetchModel.h"
+#include "ViewportPlan.h"
+#include "ColorAdjustment.h"
+#include "PolygonPicker.h"  // For PolygonPicker::NO_POLYGON
+#include "InputCoalescer.h"
+#include "StartupTimings.h"
+#include "../api/http/Metrics.h"
 
 class Application {
 public:
@@ -60,21 +106,301 @@ public:
     Application(const Application&) = delete;
     Application& operator=(const Application&) = delete;
 
+    // Decode pool sizing, applied to slides loaded afterwards.
+    // threads = 0 sizes the pool from the hardware.
+    void SetDecodeThreads(size_t threads, bool autoScale);
+
+    // OS scheduling of the decode pool's threads (see
+    // TileLoadThreadPool::SetThreadScheduling), applied when it starts
+    void SetWorkerScheduling(bool backgroundPriority, size_t reservedCores);
+
+    // Cut prefetching to BATTERY_PREFETCH_TILES_PER_FRAME while running on
+    // battery power (checked every POWER_CHECK_MS); on by default
+    void SetBatteryThrottling(bool enabled) { batteryThrottling_ = enabled; }
+
+    // Pyramid level strategy (see LevelSelection); switchable at runtime
+    void SetLevelSelection(LevelSelection mode);
+
+    // Levels coarser to draw at while panning fast (see
+    // SlideRenderer::SetMotionLevels); switchable at runtime
+    void SetMotionLevels(int32_t levels);
+
+    // Render scale levels are chosen at, still and while moving (see
+    // SlideRenderer::SetRenderScale); switchable at runtime
+    void SetRenderScale(double still, double moving);
+
+    // Persistent decoded-tile cache; maxBytes = 0 disables it
+    void SetDiskCache(const std::string& rootDir, size_t maxBytes);
+
+    // Where slides' annotation journals are kept (empty = default
+    // location, "none" = not saved)
+    void SetAnnotationDirectory(const std::string& directory) { annotationDirectory_ = directory; }
+
+    // In-memory tile cache limit; maxBytes = 0 sizes it from physical
+    // memory. Applies immediately to a loaded slide.
+    void SetTileCacheBudget(size_t maxBytes);
+
+    // Compressed tier behind the tile cache; maxBytes = 0 disables it.
+    // Unless set, it gets a quarter of the tile cache budget.
+    void SetCompressedCacheBudget(size_t maxBytes);
+
+    // Tile cache eviction order, and how many of each slide's coarsest
+    // levels are never evicted (see TileCache::PinLevels). Apply from the
+    // first slide on.
+    void SetTileEvictionPolicy(TileEvictionPolicy policy, int pinnedCoarseLevels);
+
+    // Keep opaque tiles in the tile cache packed as RGB or YUV 4:2:0 (see
+    // TileCache::SetStorage). Applies to tiles decoded from then on.
+    void SetTileStorage(TileStorage storage);
+
+    // Keep uniform tiles as their one color and draw them flat (see
+    // TileCache::SetSolidTiles). On by default.
+    void SetSolidTiles(bool enabled);
+
+    // Back tile pixel buffers allocated from now on with huge-page slabs
+    // (see TileBufferPool::SetHugePages). Off by default.
+    void SetHugePages(HugePageMode mode);
+
+    // Decode JPEG tiles of SVS / tiled TIFF slides without OpenSlide
+    // (see SlideLoader::SetDirectTiffRead). Applies to the next slide.
+    void SetDirectTiffRead(bool enabled) { directTiffRead_ = enabled; }
+
+    // Batch those direct decodes on the GPU when possible; implies
+    // SetDirectTiffRead. Applies to the next slide.
+    void SetGpuJpegDecode(bool enabled) { gpuJpegDecode_ = enabled; }
+
+    // Memory-map the slide for those direct reads (local disks); implies
+    // SetDirectTiffRead. Applies to the next slide.
+    void SetTiffMemoryMap(bool enabled) { tiffMemoryMap_ = enabled; }
+
+    // Keep tile textures block-compressed on the GPU (see
+    // TextureManager::SetCompression); stays uncompressed where the render
+    // backend cannot sample the format
+    void SetTextureCompression(TextureCompression compression);
+
+    // Redraw only when something changed (default) instead of every VSync
+    void SetOnDemandRendering(bool enabled) { onDemandRendering_ = enabled; }
+
+    // Viewport traces: record every drawn viewport state to path (saved at
+    // shutdown), or replay a recorded trace once the next slide is loaded
+    void SetTraceRecording(const std::string& path);
+    void SetTraceReplay(const std::string& path) { pendingTraceReplay_ = path; }
+
+    // Prefetch model file (pathview-prefetch-model): once the view stops,
+    // the next stops its slide type's model predicts are prefetched like
+    // a viewport.plan tour. Empty for none
+    void SetPrefetchModel(const std::string& path) { prefetchModelPath_ = path; }
+
+    // Budget for the memory accounted in the registry (caches are shrunk
+    // when it is exceeded); 0 = unlimited
+    void SetMemoryBudget(size_t bytes) { memoryRegistry_.SetBudget(bytes); }
+
+    // Serve the open slide as DeepZoom / IIIF tiles over HTTP on host:port
+    // (see TileService); port 0 (default) disables it. Call before
+    // Initialize.
+    void SetTileServer(const std::string& host, int port) {
+        tileServerHost_ = host;
+        tileServerPort_ = port;
+    }
+
+    // Most IPC clients connected at once (agents plus monitoring); 0 keeps
+    // the server's default. Call before Initialize
+    void SetIpcMaxClients(size_t maxClients) { ipcMaxClients_ = maxClients; }
+
+    // Requests per second (and burst) of each normal-priority IPC session,
+    // 0 for unlimited, and the time each frame may spend on IPC requests,
+    // 0 for unlimited; below 0 keeps the server's defaults. Call before
+    // Initialize
+    void SetIpcScheduling(double rateLimit, double frameBudgetMs) {
+        ipcRateLimit_ = rateLimit;
+        ipcFrameBudgetMs_ = frameBudgetMs;
+    }
+
+    // Unix socket the IPC server also listens on; empty for TCP only.
+    // Call before Initialize
+    void SetIpcSocketPath(const std::string& path) { ipcSocketPath_ = path; }
+
+    // File the session (slide, view, overlays, worklist, most viewed
+    // tiles) is saved to at exit and restored from by Initialize: empty
+    // for the per-user default (none when headless), "none" for neither
+    void SetSessionPath(const std::string& path) { sessionPath_ = path; }
+
+    // Run without a window or UI, for batch servers: a hidden window on
+    // SDL's offscreen video driver drawn by the software renderer (the
+    // SDL_VIDEODRIVER / SDL_RENDER_DRIVER environment variables override
+    // both, e.g. for EGL), no ImGui, no minimap; only IPC and HTTP drive
+    // it. width x height is the view snapshots capture. Call before
+    // Initialize
+    void SetHeadless(bool enabled, int width, int height) {
+        headless_ = enabled;
+        windowWidth_ = width;
+        windowHeight_ = height;
+    }
+
+    // Instead of restoring the session, open options.slidePath (and its
+    // polygons), replay options.tracePath frame by frame as a
+    // FrameBenchmark, write its JSON report and quit. Call before
+    // Initialize
+    void SetBenchmark(const FrameBenchmarkOptions& options) { benchmarkOptions_ = options; }
+    // Whether the benchmark could not run or its report not be written
+    bool HasBenchmarkFailed() const { return benchmarkFailed_; }
+
+    // Print the time to first frame phase by phase (StartupTimings) once
+    // the work deferred past it is done
+    void SetStartupTimings(bool print) { printStartupTimings_ = print; }
+
     bool Initialize();
     void Run();
     void Shutdown();
 
 private:
+    // ImGui context, style and backends; skipped headless
+    bool InitializeImGui();
+    // Fonts at dpiScale_, after the first frame: the UI is drawn from then on
+    void LoadFonts();
+    // After the first frame is presented: fonts, the IPC and tile server
+    // listeners, then the session (or benchmark slide)
+    void FinishStartup();
     void ProcessEvents();
+    // Move the view by the motion and wheel input summed since the last call
+    void ApplyCoalescedInput();
+
+    // Redraw the minimap's density layer if it was toggled, its class
+    // changed, or the overlay or the minimap's overview did
+    void UpdateMinimapDensity();
+
+    // Queue viewport / tiles-settled / annotation events for IPC clients
+    // that subscribed (events.subscribe) and send those due
+    void PumpViewerEvents();
+
+    // Copy cache, tile pipeline, IPC and memory counters into metrics_
+    // (every METRICS_INTERVAL_MS) and post them to "metrics" subscribers
+    void UpdateMetrics();
+
+    // On-demand rendering: RequestRedraw() schedules a few frames from the
+    // main thread, PostWakeEvent() does the same from any thread by pushing
+    // an SDL user event, and WaitForActivity() sleeps until either happens
+    // (or IPC needs polling).
+    void RequestRedraw();
+    void PostWakeEvent();
+    bool NeedsRedraw() const;
+    void WaitForActivity();
+
     void Update();
     void Render();
     void RenderUI();
     void RenderSlidePreview();
 
+    // Scene caching: the slide, polygon and annotation layers are drawn
+    // into sceneTexture_ and composited under the UI. Render() redraws
+    // them only when the SceneKey changed or the last drawing was not
+    // final (tiles missing, an animation); otherwise a frame costs one
+    // copy plus the drawing preview, minimap and ImGui on top. A pure pan
+    // by whole pixels from a final drawing scrolls it instead: the old
+    // texture is blitted shifted into the spare one and only the exposed
+    // strips are drawn (clipped). InvalidateScene() covers changes the key
+    // cannot see: IPC commands, overlay tiles arriving, and settings
+    // applied on this thread.
+    struct SceneKey {
+        uint64_t version = 0;
+        const SlideRenderer* renderer = nullptr;
+        double x = 0.0;
+        double y = 0.0;
+        double zoom = 0.0;
+        int width = 0;
+        int height = 0;
+        bool compare = false;
+        uint64_t polygons = 0;
+        uint64_t annotations = 0;
+        uint64_t channels = 0;
+
+        bool operator==(const SceneKey& other) const;
+    };
+    void InvalidateScene() { ++sceneVersion_; }
+    SceneKey MakeSceneKey() const;
+    bool IsSceneFinal() const;
+    bool EnsureSceneTexture();
+    bool GetSceneShift(const SceneKey& key, int* shiftX, int* shiftY) const;
+    bool ScrollScene(int shiftX, int shiftY);
+    void RenderScene(const SDL_Rect* clip = nullptr);
+    // colorAdjustment_ over the part of pane (empty: the window) the slide
+    // covers, before overlays are drawn
+    void ApplyColorAdjustment(const Viewport& viewport, const SDL_Rect& pane);
+
     void OpenFileDialog();
+
+    // Opening runs on a SlideOpenTask: LoadSlide() closes the current
+    // slide and starts it, and PollSlideOpen() (every Update) shows its
+    // preview and finishes the setup on this thread once it is done,
+    // answering a slide.load request waiting for it
     void LoadSlide(const std::string& path);
-    void OpenPolygonFileDialog();
+    std::unique_ptr<SlideOpenTask> StartSlideOpenTask(const std::string& path);
+    void PollSlideOpen();
+    void FinishSlideOpen();
+    // The parts of FinishSlideOpen() a background preload does ahead of
+    // time, and the rest, which shows the slide
+    std::unique_ptr<DiskTileCache> OpenDiskTileCache(const SlideLoader& loader) const;
+    // Swap in the opened slide's annotations and action cards from its
+    // journal, which then records their changes
+    void OpenAnnotationJournal(const SlideLoader& loader);
+    std::unique_ptr<SlideRenderer> CreateSlideRenderer(SlideLoader* loader, DiskTileCache* diskCache);
+    void ShowOpenedSlide(const MinimapOverview& overview, TissueMask tissueMask);
+    pathview::ipc::json DescribeOpenSlide() const;
+    // slide.load's answer: now if the slide opened at once (a preload was
+    // ready), else deferred until FinishSlideOpen()
+    pathview::ipc::json ReplyWhenSlideOpen();
+    void RenderSlideOpenProgress();
+    // newLayer: load the file into a layer of its own instead of the
+    // active one (see AddPolygonLayer)
+    void OpenPolygonFileDialog(bool newLayer = false);
+    // LoadPolygons() blocks until the file is in; StartPolygonLoad()
+    // streams it in the background, filling the overlay around the
+    // viewport first, and answers a polygons.load request once it is done.
+    // A preloaded task for the file is taken over rather than started anew.
     void LoadPolygons(const std::string& path);
+    void StartPolygonLoad(const std::string& path, std::unique_ptr<PolygonLoadTask> preloaded = nullptr);
+    // Stop every ROI metrics batch, wait for the IPC jobs (their workers
+    // read the polygons) and take the polygons off the tile server before
+    // the overlay's polygons change
+    void StopPolygonReaders();
+    // Polygon layers: AddPolygonLayer() appends an empty one sharing the
+    // first's render scratch and makes it active, so the next load fills it
+    // while the others stay; switching the active layer or hiding one does
+    // not reload anything. The last layer cannot be removed.
+    void AddPolygonLayer();
+    bool SelectPolygonLayer(size_t index);
+    bool RemovePolygonLayer(size_t index);
+    pathview::ipc::json DescribePolygonLayers() const;
+    // Any layer loading, or with tiles waiting for upload budget
+    bool IsLoadingPolygonLayers() const;
+    bool HasPendingPolygonUploads() const;
+    // Changes whenever what any layer draws does, or the layers themselves
+    uint64_t GetPolygonLayersRevision() const;
+    size_t SumPolygonLayers(size_t (PolygonOverlay::*usage)() const) const;
+    void OpenHeatmapFileDialog();
+    // Show a probability grid (.npy or Zarr array) over the slide, stretched
+    // to cover it unless texelSize (slide pixels per cell) is given
+    bool LoadHeatmap(const std::string& path, double texelSize = 0.0);
+
+    // Last session (see SetSessionPath). RestoreSession reopens its slide,
+    // overlays and worklist; ShowOpenedSlide then restores the view and
+    // UpdateSessionWarmup queues the slide's most viewed tiles, a batch at
+    // a time while the decode queue is short, from the disk cache or the
+    // decoder. RecordTileUsage counts the tiles of each settled view.
+    std::string GetSessionFile() const;
+    void SaveSession();
+    void RestoreSession();
+    void RecordTileUsage();
+    void UpdateSessionWarmup();
+    std::string sessionPath_;
+    std::unique_ptr<SessionState> restoredSession_;  // Until its slide is shown
+    TileUsage tileUsage_;
+    Vec2 lastUsagePosition_;
+    double lastUsageZoom_ = 0.0;
+    std::vector<TileKey> warmTiles_;
+    size_t warmNext_ = 0;  // Next of warmTiles_ to queue
+    static constexpr size_t WARMUP_PENDING_LIMIT = 16;
+    static constexpr size_t WARMUP_BATCH_TILES = 8;
 
     // IPC command handler
     pathview::ipc::json HandleIPCCommand(const std::string& method, const pathview::ipc::json& params);
@@ -85,9 +411,19 @@ private:
     void RenderSidebar();
     void RenderWelcomeOverlay();
     void RenderSlideInfoTab();
+    void RenderChannelControls();
+    void RenderColorControls();
     void RenderPolygonTab();
+    // RenderPolygonTab's class names, as of the overlay revision
+    std::vector<std::string> polygonClassLabels_;
+    uint64_t polygonClassLabelsRevision_ = 0;
+    void RenderHeatmapControls();
     void RenderActionCardsTab();
+    void RenderWorklistTab();
+    void RenderLibraryTab();
     void RenderNavigationLockIndicator();
+    void RenderFrameProfiler();
+    void RenderCellTooltip();
 
     // Navigation lock helpers
     bool IsNavigationLocked() const;
@@ -95,9 +431,100 @@ private:
     void CheckLockExpiry();
     std::string GenerateUUID() const;
 
+    // Viewport trace recording and replay (see ViewportTrace). Replay
+    // drives the viewport from the trace's timestamps and measures the
+    // frame-to-frame time until the last sample is shown.
+    bool StartTraceRecording(const std::string& path);
+    bool StopTraceRecording();
+    bool StartTraceReplay(const std::string& path);
+    void FinishTraceReplay();
+    void RecordTraceSample();
+    void ApplyTraceReplay();
+    // Shows a recorded state verbatim (resizing the window to its size)
+    void ShowTraceSample(const ViewportSample& sample);
+
+    // Frame benchmark (see SetBenchmark): started once its slide is open,
+    // each frame timed by Run() and reported to it
+    void StartBenchmark();
+    void RecordBenchmarkFrame(std::chrono::steady_clock::time_point frameStart,
+                              std::chrono::steady_clock::time_point frameEnd);
+    void FinishBenchmark(const std::string& error);  // Empty error: write the report
+
     // Screenshot capture
-    void CaptureScreenshot();
-    std::vector<uint8_t> EncodePNG(const std::vector<uint8_t>& pixels, int width, int height);
+    void CaptureScreenshot(int maxDimension = 0, double scale = 1.0);
+    void ReadRenderPixels(std::vector<uint8_t>& pixels, int& width, int& height);
+    // Snapshot pixels at "max_dimension" / "scale" (see SnapshotEncoder::
+    // FitSize): the window as drawn when full size; smaller, the scene
+    // (slide and overlays, without the minimap) scaled down on the GPU by
+    // ReadScaledScene before readback, or the window averaged down on the
+    // CPU where there are no render targets
+    void ReadSnapshotPixels(int maxDimension, double scale, std::vector<uint8_t>& pixels, int& width,
+                            int& height);
+    bool ReadScaledScene(int width, int height, std::vector<uint8_t>& pixels);
+    // The scene scaled to width x height in a cached render target, nullptr
+    // if that failed
+    SDL_Texture* DownscaleScene(int width, int height);
+    struct DownscaleTexture {
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+    std::vector<DownscaleTexture> downscaleTextures_;  // DownscaleScene's halving steps, kept
+    std::vector<uint8_t> captureReadback_;  // Storage of the capture before the last, reused
+
+    // Snapshot pixels for done, without stalling the frame on the GPU where
+    // the backend has fenced readback (RenderBackend::StartReadback): the
+    // scene, scaled down like ReadScaledScene, is copied back while later
+    // frames render and handed over by the FinishSceneReadbacks that finds
+    // it done. Elsewhere (SDL_Renderer backend, no scene texture)
+    // ReadSnapshotPixels reads them and done gets them at once. The scene
+    // has no minimap or drawing preview, even at full size.
+    using ReadbackDone = std::function<void(std::vector<uint8_t>& pixels, int width, int height)>;
+    void RequestSnapshotPixels(int maxDimension, double scale, ReadbackDone done);
+    // Hand finished readbacks to their callbacks, oldest first; with wait
+    // block until all have finished (before the backend goes away)
+    void FinishSceneReadbacks(bool wait);
+    struct SceneReadback {
+        uint64_t ticket = 0;
+        int width = 0;
+        int height = 0;
+        int maxDimension = 0;  // Read synchronously instead if the copy fails
+        double scale = 1.0;
+        ReadbackDone done;
+    };
+    std::vector<SceneReadback> sceneReadbacks_;  // In flight, oldest first
+    std::vector<uint8_t> readbackPixels_;  // The pixels lent to done, storage reused
+
+    // Turns RGBA pixels into an image response on a worker, per the
+    // request's "format", "quality" and "transport" (snapshot.capture,
+    // region.render). Call while handling the request. With keepBytes the
+    // image stays binary in the response whatever the transport, for
+    // region.scan to hand over later with SendImage.
+    using ImageEncoder = std::function<pathview::ipc::json(std::vector<uint8_t>, int, int)>;
+    ImageEncoder MakeImageEncoder(const pathview::ipc::json& params, bool keepBytes = false);
+    // region.render and region.export parameters: the region clipped to
+    // the slide, in level 0 pixels, and its downsample
+    void ParseRegionParams(const pathview::ipc::json& params, double& x0, double& y0, double& x1, double& y1,
+                           double& downsample) const;
+    // Copies of the listed overlays ("polygons", "annotations") over region
+    // for drawing off the GUI thread; info gets what was copied
+    std::shared_ptr<RegionOverlay> BuildRegionOverlay(const pathview::ipc::json& names, const Rect& region,
+                                                      size_t maxPolygons, pathview::ipc::json& info);
+    // The shared-memory slots when params ask for "transport": "shm"
+    // (created on first use), else null; fdAttached tells whether their
+    // descriptor goes with the current response
+    pathview::ipc::SnapshotRing* GetSnapshotRing(const pathview::ipc::json& params, bool& fdAttached);
+    // Moves the bytes of a keepBytes image into a slot of ring, or encodes
+    // them for the current connection when there is none or it is full
+    void SendImage(pathview::ipc::json& image, pathview::ipc::SnapshotRing* ring, bool fdAttached);
+
+    // Every visible tile drawn at the selected level: no coarser fallback,
+    // no upload deferred to a later frame, the view not moving
+    bool IsViewSharp() const;
+
+    // Answer snapshot.capture requests waiting for a sharp frame, from the
+    // frame just rendered (call in Render(), before the UI)
+    void ServicePendingCaptures();
 
     // SDL objects
     SDL_Window* window_;
@@ -112,6 +539,10 @@ private:
     bool isPanning_;
     int lastMouseX_;
     int lastMouseY_;
+    // Where the last pan started: released there, it was a click
+    int pressMouseX_ = 0;
+    int pressMouseY_ = 0;
+    InputCoalescer input_;  // Pan, wheel and cursor input of this frame
     int windowWidth_;
     int windowHeight_;
     float dpiScale_;  // High-DPI scale factor (drawable size / window size)
@@ -120,24 +551,266 @@ private:
     uint32_t lastFrameTime_;
     double deltaTime_;
 
+    bool headless_ = false;
+
+    // Startup: phases timed from construction; listeners, fonts and the
+    // session wait for the first frame
+    StartupTimings startupTimings_;
+    bool printStartupTimings_ = false;
+    bool startupFinished_ = false;
+    bool uiReady_ = false;  // Fonts loaded, ImGui drawn; never headless
+
+    // On-demand rendering state
+    bool onDemandRendering_ = true;
+    int redrawFrames_ = 0;               // Frames still to draw after the last change
+    uint32_t lastRenderTime_ = 0;
+    Uint32 wakeEventType_ = 0;           // SDL user event pushed by worker threads
+    std::atomic<bool> wakePending_{false};
+
+    // Scene cache (see RenderScene)
+    SDL_Texture* sceneTexture_ = nullptr;
+    SDL_Texture* sceneSpareTexture_ = nullptr;  // Scroll destination, swapped in after
+    int sceneTextureWidth_ = 0;
+    int sceneTextureHeight_ = 0;
+    bool sceneCacheEnabled_ = true;      // Off if the renderer has no render targets
+    bool sceneValid_ = false;            // sceneTexture_ holds the final drawing of sceneKey_
+    SceneKey sceneKey_;
+    uint64_t sceneVersion_ = 0;
+    std::atomic<uint64_t> overlayTileWakes_{0};  // Cell tiles rasterized (worker threads)
+    uint64_t sceneRedraws_ = 0;
+    uint64_t sceneReuses_ = 0;
+    uint64_t sceneScrolls_ = 0;
+
+    // Drift a pan may have from whole output pixels and still scroll
+    static constexpr double SCENE_SCROLL_TOLERANCE = 0.01;
+
+    // ImGui needs a couple of frames to settle hover/layout after input
+    static constexpr int REDRAW_FRAMES_AFTER_ACTIVITY = 3;
+    // Longest idle sleep; bounds IPC latency since sockets are polled
+    static constexpr uint32_t IDLE_WAIT_MS = 25;
+    // Periodic repaint for time-based UI (lock countdowns, cursor blink)
+    static constexpr uint32_t IDLE_REDRAW_INTERVAL_MS = 500;
+
     // Components
+    std::unique_ptr<RenderBackend> renderBackend_;  // Draws the slide's tiles, see RenderBackend
     std::unique_ptr<TextureManager> textureManager_;
+    // Decode workers and tile cache shared by the slides opened, under one
+    // budget: each renderer joins them under its own slide id, so opening
+    // another slide keeps the workers and frees only the old slide's tiles
+    std::unique_ptr<TileCache> tileCache_;
+    std::unique_ptr<TileLoadThreadPool> decodePool_;
+    uint32_t nextSlideId_ = 1;
+    std::unique_ptr<SlideOpenTask> slideOpenTask_;  // Slide being opened, if any
+    std::string slideOpenError_;                    // Why the last open failed
     std::unique_ptr<SlideLoader> slideLoader_;
     std::unique_ptr<Viewport> viewport_;
+    std::unique_ptr<DiskTileCache> diskTileCache_;  // Outlives slideRenderer_'s workers
     std::unique_ptr<SlideRenderer> slideRenderer_;
+    // Draws multichannel slides in place of slideRenderer_, which still
+    // serves the tile server and statistics
+    std::unique_ptr<ChannelCompositor> channelCompositor_;
+    // Slides switched away from while their abandoned decodes wind down in
+    // the pool (see SlideRenderer::Detach); ReapRetiringSlides() frees
+    // each once the pool has let go of it
+    struct RetiringSlide {
+        std::unique_ptr<SlideLoader> loader;  // Declared first: destroyed last
+        std::unique_ptr<DiskTileCache> diskCache;
+        std::unique_ptr<SlideRenderer> renderer;
+        std::unique_ptr<ChannelCompositor> channels;
+    };
+    std::vector<RetiringSlide> retiringSlides_;
+    void ReapRetiringSlides();
+    // Brightness, contrast and colour balance of the drawn slide; off if
+    // the renderer lacks its blend modes
+    ColorAdjustment colorAdjustment_;
+    bool colorAdjustmentSupported_ = true;
     std::unique_ptr<Minimap> minimap_;
-    std::unique_ptr<PolygonOverlay> polygonOverlay_;
+    // Cell density over the minimap (see UpdateMinimapDensity)
+    bool minimapDensity_ = false;
+    int minimapDensityClass_ = -1;  // -1: the overlay's visible classes
+    bool minimapDensityDirty_ = false;
+    uint64_t minimapDensityRevision_ = 0;  // Overlay revision last drawn
+    // Polygon layers over the slide, e.g. two models' segmentations of it,
+    // drawn in order in one pass; the active one is what the Polygons tab,
+    // picking, queries and the cell tile server work on
+    struct PolygonLayer {
+        std::unique_ptr<PolygonOverlay> overlay;
+        std::string path;  // Polygon file loaded, or empty
+    };
+    std::vector<PolygonLayer> polygonLayers_;
+    size_t activePolygonLayer_ = 0;
+    PolygonOverlay* polygonOverlay_ = nullptr;  // The active layer's
+    uint64_t polygonLayersRevision_ = 0;        // Bumped on add, remove and select
+    std::unique_ptr<HeatmapLayer> heatmapLayer_;  // Drawn between the slide and the cells
+    uint32_t selectedPolygon_ = PolygonPicker::NO_POLYGON;  // Clicked cell, shown in the Polygons tab
+    // Cells drawn smaller than this get no hover tooltip (they are specks
+    // of the density layer or tiles)
+    static constexpr double CELL_TOOLTIP_MIN_PIXELS = 8.0;
     std::unique_ptr<AnnotationManager> annotationManager_;
+    std::unique_ptr<AnnotationJournal> annotationJournal_;  // Open slide's, if saving
+    std::string annotationDirectory_;
+
+    // GPU texture budget for slide tiles (pixel tier: see SetTileCacheBudget)
+    static constexpr size_t TEXTURE_CACHE_MAX_MEMORY = 256 * 1024 * 1024;
+
+    // Tile cache limit: configured (0 = auto) and resolved. Under OS memory
+    // pressure the renderer's limit is lowered below the resolved one, and
+    // raised back in steps once memory is available again.
+    size_t tileCacheBudgetBytes_ = 0;
+    size_t tileCacheTargetBytes_ = 0;  // 0 until SetTileCacheBudget(): TileCache's default
+    size_t compressedCacheBytes_ = 0;
+    bool compressedCacheConfigured_ = false;
+    TileEvictionPolicy tileEvictionPolicy_ = TileEvictionPolicy::Clock;
+    TileStorage tileStorage_ = TileStorage::Argb;
+    bool solidTiles_ = true;
+    HugePageMode hugePages_ = HugePageMode::Off;
+    int pinnedCoarseLevels_ = 0;
+    bool directTiffRead_ = false;
+    bool gpuJpegDecode_ = false;
+    bool tiffMemoryMap_ = false;
+    TextureCompression textureCompression_ = TextureCompression::None;
+    bool memoryPressure_ = false;
+    Uint32 lastMemoryPressureCheck_ = 0;
+    void UpdateMemoryPressure();
+    static constexpr Uint32 MEMORY_PRESSURE_CHECK_MS = 1000;
+
+    // Power source (see SetBatteryThrottling)
+    bool batteryThrottling_ = true;
+    bool onBattery_ = false;
+    Uint32 lastPowerCheck_ = 0;
+    bool powerChecked_ = false;
+    void UpdatePowerSource();
+    size_t GetPrefetchLimit() const;
+    static constexpr Uint32 POWER_CHECK_MS = 5000;
+    static constexpr size_t BATTERY_PREFETCH_TILES_PER_FRAME = 12;  // A quarter of the default
+
+    // Glass vs. tissue for the tile scheduler: the minimap overview's
+    // threshold, refined by the polygon file's tissue map once one is in
+    // (UpdateTissueMask() follows the overlay's map)
+    TissueMask overviewTissueMask_;
+    const TissueMap* tissueMaskSource_ = nullptr;
+    void UpdateTissueMask();
+    static constexpr size_t LOW_MEMORY_MIN_BYTES = 512ull * 1024 * 1024;  // Or 5% of RAM if larger
+
+    // Tile decode worker pool configuration
+    size_t decodeThreads_ = 0;
+    bool decodeAutoScale_ = false;
+    bool workerBackgroundPriority_ = true;
+    size_t reservedRenderCores_ = 0;
+    LevelSelection levelSelection_ = LevelSelection::Closest;
+    int32_t motionLevels_ = 0;
+    double renderScale_ = 1.0;
+    double movingRenderScale_ = 1.0;
+
+    // Disk tile cache configuration (empty root = default location)
+    std::string diskCacheRoot_;
+    size_t diskCacheMaxBytes_ = DiskTileCache::DEFAULT_MAX_BYTES;
 
-    // IPC server for remote control
+    // Shared-memory slots snapshot.capture hands PNGs over in when the
+    // client asks for it (pathview-mcp); created on first use, outlives
+    // the executor's jobs
+    std::unique_ptr<pathview::ipc::SnapshotRing> snapshotRing_;
+    bool snapshotRingFailed_ = false;
+    // Recent encodes by content key: a capture of an unchanged view reuses
+    // the image. Shared with the encode jobs, which may outlive a request.
+    std::shared_ptr<pathview::EncodedImageCache> encodedImages_;
+
+    // IPC server for remote control. Commands run on this thread; the slow
+    // part of a few (PNG encoding, cell counting) runs on the executor, and
+    // slide.load / polygons.load are answered from Update() once done.
     std::unique_ptr<pathview::ipc::IPCServer> ipcServer_;
+    std::unique_ptr<pathview::ipc::CommandExecutor> commandExecutor_;
+    // Off-screen region renders, which may wait seconds on tile reads: on
+    // their own workers, so snapshots and cell counts do not queue behind
+    std::unique_ptr<pathview::ipc::CommandExecutor> renderExecutor_;
+    std::unique_ptr<std::promise<pathview::ipc::json>> slideOpenReply_;
+    std::unique_ptr<std::promise<pathview::ipc::json>> polygonLoadReply_;
+
+    // Pushed viewer events, and the state last reported through them
+    std::unique_ptr<pathview::ipc::EventSubscriptions> eventSubscriptions_;
+    struct ReportedViewerState {
+        double x = 0.0;
+        double y = 0.0;
+        double zoom = 0.0;
+        bool moving = false;
+        bool tilesSettled = false;
+        uint64_t annotationRevision = 0;
+    } reportedState_;
+    static constexpr int MAX_EVENT_INTERVAL_MS = 60000;
+
+    // Served at the tile server's /metrics and sent to pathview-mcp; shared
+    // with the encode jobs, which record into it. Frame times are recorded
+    // each frame, the rest copied in by UpdateMetrics().
+    std::shared_ptr<pathview::http::Metrics> metrics_ = std::make_shared<pathview::http::Metrics>();
+    pathview::http::Metrics::Series* frameSeconds_ = nullptr;
+    std::chrono::steady_clock::time_point metricsUpdated_;
+    static constexpr int METRICS_INTERVAL_MS = 1000;
+
+    // DeepZoom / IIIF tile server for browser viewers. The tile service
+    // also composes region.render images, so it exists without the server.
+    std::string tileServerHost_ = "127.0.0.1";
+    int tileServerPort_ = 0;
+    size_t ipcMaxClients_ = 0;
+    double ipcRateLimit_ = -1.0;
+    double ipcFrameBudgetMs_ = -1.0;
+    std::optional<std::string> ipcSocketPath_;  // Unset: the server's default
+    std::unique_ptr<TileService> tileService_;
+    std::unique_ptr<CellTileService> cellTileService_;
+    bool cellsServed_ = false;  // Current polygons handed to cellTileService_
+    std::unique_ptr<pathview::http::HTTPServer> tileServer_;
+    std::thread tileServerThread_;
+    void StartTileServer();
+    void StopTileServer();
+    void ServeCurrentSlide();
+    // Serve the polygons as vector tiles once a slide is open and they are
+    // loaded and indexed (checked every Update until then)
+    void ServeCurrentCells();
+
+    // Live view at the tile server's /stream: while anyone watches, each
+    // frame that differs from the last one sent (at most the fastest
+    // requested fps) is JPEG-encoded once on the executor and published
+    void PublishStreamFrame();
+    std::vector<uint8_t> streamPixels_;    // Last frame published
+    bool streamReadbackPending_ = false;   // The next frame is being read back
+    uint32_t lastStreamFrameTime_ = 0;
+    std::future<pathview::ipc::json> streamEncode_;
+    static constexpr int STREAM_JPEG_QUALITY = 80;
 
-    // Preview texture (Phase 2 simple display)
+    // Preview shown while a slide opens (see SlideOpenTask)
     SDL_Texture* previewTexture_;
 
     // Current slide path
     std::string currentSlidePath_;
 
+    // Case list read in order. While one entry is viewed the next is opened
+    // in the background: its loader, overview and polygon file are read and
+    // its opening view decoded into the shared tile cache, so stepping on
+    // shows it at once (see UpdateWorklistPreload)
+    struct SlidePreload;
+    Worklist worklist_;
+    std::unique_ptr<SlidePreload> preload_;
+    void OpenWorklistFileDialog();
+    void SetWorklist(std::vector<WorklistEntry> entries);
+    bool OpenWorklistEntry(size_t index);
+    void UpdateWorklistPreload();
+    pathview::ipc::json DescribeWorklist() const;
+
+    // Slides under a folder, browsed by thumbnail in the sidebar's Library
+    // tab; SlideLibrary makes and caches the thumbnails in the background,
+    // and UpdateLibraryTextures() uploads them as they land
+    std::unique_ptr<SlideLibrary> slideLibrary_;
+    std::vector<SlideLibrary::Entry> libraryEntries_;
+    std::vector<SDL_Texture*> libraryTextures_;  // Per entry; nullptr until its thumbnail is uploaded
+    uint64_t libraryRevision_ = 0;
+    uint64_t libraryScanRevision_ = 0;
+    bool selectLibraryTab_ = false;
+    static constexpr float LIBRARY_THUMBNAIL_SIZE = 96.0f;  // Grid cell, in points
+    void OpenLibraryFolderDialog();
+    bool ScanLibrary(const std::string& directory);
+    void UpdateLibraryTextures();
+    void ClearLibraryTextures();
+    pathview::ipc::json DescribeLibrary() const;
+
     // Sidebar configuration
     static constexpr float SIDEBAR_WIDTH = 350.0f;
     bool sidebarVisible_;
@@ -149,14 +822,130 @@ private:
     std::vector<pathview::ActionCard> actionCards_;
     std::mutex actionCardsMutex_;  // Thread-safe IPC access
     static constexpr int MAX_ACTION_CARDS = 50;
+    // Add a card, making room by dropping the oldest finished one
+    void AddActionCard(const pathview::ActionCard& card);
+    // Entries per action_card.get_log page: default and most
+    static constexpr size_t LOG_PAGE_DEFAULT = 100;
+    static constexpr size_t LOG_PAGE_MAX = 1000;
 
     // Animation tracking for completion detection
     std::map<std::string, pathview::AnimationToken> activeAnimations_;
     static constexpr int MAX_TOKEN_AGE_MS = 60000;  // 60 seconds
 
+    // Tour announced by viewport.plan: followed each Update, its waypoints
+    // still ahead handed to the renderer's prefetch. Cleared with the slide.
+    ViewportPlan viewportPlan_;
+    void UpdateViewportPlan();
+    static constexpr size_t MAX_PLAN_WAYPOINTS = 1000;
+
+    // Learned next stops (see SetPrefetchModel), loaded for each slide's
+    // type; handed to the renderer like a plan's waypoints while the view
+    // stays where they were predicted from and no plan is set
+    std::string prefetchModelPath_;
+    PrefetchModel prefetchModel_;
+    bool prefetchModelLoaded_ = false;
+    bool predictedViews_ = false;  // The renderer's planned views are predictions
+    Rect lastPredictionView_;      // The view at the last Update; predicted from once it stays
+    void LoadPrefetchModel(const SlideMetadata& metadata);
+    void UpdatePredictedViews();
+
+    // ROI metrics batches by token (annotations.compute_metrics_batch),
+    // dropped once their last results are fetched
+    std::map<std::string, std::unique_ptr<RoiMetricsBatch>> roiBatches_;
+    static constexpr size_t MAX_ROI_BATCHES = 8;
+    static constexpr size_t MAX_BATCH_ROIS = 1000;
+
+    // Region scans by token (region.scan), dropped once their last results
+    // are fetched or they are cancelled. A slide change cancels them.
+    std::map<std::string, std::unique_ptr<RegionScan>> regionScans_;
+    void CancelRegionScans();
+    static constexpr size_t MAX_REGION_SCANS = 4;
+    static constexpr size_t MAX_SCAN_FIELDS = 100000;
+    static constexpr int64_t MAX_SCAN_FIELD_PIXELS = 4096 * 4096;
+    // Results per region.scan_results: default (and the most with "shm",
+    // one per shared-memory slot there are at most) and most
+    static constexpr size_t SCAN_PAGE_DEFAULT = 4;
+    static constexpr size_t SCAN_PAGE_MAX = 64;
+
+    // Pyramidal TIFF export of a region (region.export), one at a time on a
+    // thread of its own, its progress shown on an action card. A slide
+    // change cancels it, as does cancelling the card.
+    struct RegionExport;
+    std::unique_ptr<RegionExport> regionExport_;
+    void CancelRegionExport();
+    void UpdateRegionExport();
+    static constexpr size_t MAX_EXPORT_POLYGONS = 2000000;
+    static constexpr int32_t EXPORT_TILE_SIZE = 512;
+
     // Screenshot capture state
     std::unique_ptr<pathview::ScreenshotBuffer> screenshotBuffer_;
 
+    // snapshot.capture with "await_sharp", answered once a frame is sharp
+    // or at the deadline; encode turns the pixels into the response
+    struct PendingCapture {
+        std::shared_ptr<std::promise<pathview::ipc::json>> reply;
+        ImageEncoder encode;
+        std::chrono::steady_clock::time_point requested;
+        std::chrono::steady_clock::time_point deadline;
+        int maxDimension = 0;  // Size, see ReadSnapshotPixels
+        double scale = 1.0;
+        std::shared_ptr<pathview::ipc::RequestTrace> trace;  // Traced requests
+        int64_t requestedUs = 0;                             // RequestTrace::NowUs(), when traced
+    };
+    std::vector<PendingCapture> pendingCaptures_;
+    static constexpr int DEFAULT_SHARP_TIMEOUT_MS = 5000;
+    static constexpr int MAX_SHARP_TIMEOUT_MS = 30000;
+
+    // region.render: output at most MAX_REGION_PIXELS (256 MB of RGBA),
+    // polygons copied for it at most MAX_REGION_POLYGONS
+    static constexpr int64_t MAX_REGION_PIXELS = 64 * 1024 * 1024;
+    static constexpr size_t MAX_REGION_POLYGONS = 200000;
+    static constexpr double MIN_REGION_DOWNSAMPLE = 0.25;
+    static constexpr float REGION_OUTLINE_WIDTH = 2.0f;
+
+    // CPU frame profiler (zones around each subsystem's frame work),
+    // overlaid with F3
+    FrameProfiler frameProfiler_;
+    bool profilerVisible_ = false;
+
+    // Compare view: a second view of the slide in the right half of the
+    // window, following the main one through compareLink_ (a higher
+    // magnification by default). One SlideRenderer draws both, so a tile
+    // both show is requested and decoded once.
+    bool compareEnabled_ = false;
+    std::unique_ptr<Viewport> compareViewport_;
+    ViewportLink compareLink_;
+    void SetCompareView(bool enabled);
+    void LayoutViews();  // Size the views to the window and split
+    pathview::ipc::json DescribeCompareView() const;
+    static constexpr double COMPARE_ZOOM_RATIO = 4.0;
+    static constexpr int COMPARE_DIVIDER_WIDTH = 2;
+    std::string profileExportStatus_;
+    static constexpr double PROFILER_GRAPH_MIN_MS = 33.3;  // Graph shows at least two 60 Hz frames
+    static constexpr const char* PROFILE_EXPORT_PATH = "pathview_profile.json";
+
+    // Live and peak bytes per subsystem, polled once per frame
+    MemoryRegistry memoryRegistry_;
+    void RegisterMemoryAccounting();
+    void RenderMemoryInfo();
+
+    // Viewport trace state
+    ViewportTrace traceRecording_;
+    std::string traceRecordPath_;                         // Non-empty while recording
+    std::chrono::steady_clock::time_point traceRecordStart_;
+    ViewportTrace traceReplay_;
+    std::string pendingTraceReplay_;                      // Started once the next slide is open
+    bool replayingTrace_ = false;
+    std::chrono::steady_clock::time_point traceReplayStart_;
+    size_t traceReplaySample_ = 0;                        // Last sample applied
+    std::chrono::steady_clock::time_point lastReplayFrame_;
+    LatencyHistogram replayFrameTimes_;                   // Frame intervals of the last replay
+
+    // Frame benchmark state
+    std::optional<FrameBenchmarkOptions> benchmarkOptions_;
+    std::unique_ptr<FrameBenchmark> benchmark_;           // Set while replaying
+    bool benchmarkFailed_ = false;
+
     // Toolbar configuration
     static constexpr float TOOLBAR_HEIGHT = 40.0f;
     static constexpr float STATUS_BAR_HEIGHT = 28.0f;
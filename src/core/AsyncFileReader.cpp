@@ -0,0 +1,334 @@
+#include "AsyncFileReader.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+// Reads handed to IO_THREAD_COUNT threads, started on the first batch. The
+// calling thread reads the batch's first request itself.
+class ThreadedFileReader : public AsyncFileReader {
+public:
+    explicit ThreadedFileReader(ReadFunction read) : read_(std::move(read)) {}
+
+    ~ThreadedFileReader() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        queued_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    const char* GetName() const override { return "threads"; }
+
+    bool ReadBatch(const Request* requests, size_t count) override {
+        if (count == 0) {
+            return true;
+        }
+        if (count == 1) {
+            return read_(requests[0].offset, requests[0].data, requests[0].size);
+        }
+
+        Batch batch;
+        batch.remaining = count - 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (threads_.empty()) {
+                for (size_t i = 0; i < IO_THREAD_COUNT; ++i) {
+                    threads_.emplace_back([this] { IoLoop(); });
+                }
+            }
+            for (size_t i = 1; i < count; ++i) {
+                jobs_.push_back({&requests[i], &batch});
+            }
+        }
+        queued_.notify_all();
+
+        bool ok = read_(requests[0].offset, requests[0].data, requests[0].size);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&batch] { return batch.remaining == 0; });
+        return ok && !batch.failed;
+    }
+
+private:
+    struct Batch {
+        size_t remaining = 0;
+        bool failed = false;
+    };
+
+    struct Job {
+        const Request* request;
+        Batch* batch;
+    };
+
+    void IoLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            queued_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            Job job = jobs_.front();
+            jobs_.pop_front();
+            lock.unlock();
+
+            bool ok = read_(job.request->offset, job.request->data, job.request->size);
+
+            lock.lock();
+            job.batch->failed |= !ok;
+            if (--job.batch->remaining == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+
+    ReadFunction read_;
+    std::vector<std::thread> threads_;
+    std::deque<Job> jobs_;
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable done_;
+    bool stopping_ = false;
+};
+
+#ifdef PATHVIEW_HAS_IO_URING
+
+// One io_uring instance driven through the raw system calls (no liburing):
+// its submission and completion rings are mapped from the kernel, and one
+// batch at a time is submitted and reaped with io_uring_enter
+class Ring {
+public:
+    static std::unique_ptr<Ring> Create() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, AsyncFileReader::RING_ENTRIES, &params));
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<Ring> ring(new Ring(fd));
+        // IORING_OP_READ arrived with RW_CUR_POS (Linux 5.6)
+        if (!(params.features & IORING_FEAT_RW_CUR_POS) || !ring->Map(params)) {
+            return nullptr;
+        }
+        return ring;
+    }
+
+    ~Ring() {
+        if (sqes_) {
+            munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ && cqRing_ != sqRing_) {
+            munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_) {
+            munmap(sqRing_, sqRingSize_);
+        }
+        close(fd_);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    unsigned GetEntries() const { return entries_; }
+
+    // Submit count (at most GetEntries()) reads of fileFd and wait for all
+    // of them. Reads the kernel returns short, or cannot do, finish through
+    // read. False if any failed; broken is set if the ring itself failed
+    // and must not be used again.
+    bool Read(int fileFd, const AsyncFileReader::Request* requests, unsigned count,
+              const AsyncFileReader::ReadFunction& read, bool& broken) {
+        const unsigned tail = *sqTail_;
+        for (unsigned i = 0; i < count; ++i) {
+            const unsigned index = (tail + i) & *sqMask_;
+            io_uring_sqe& sqe = sqes_[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fileFd;
+            sqe.off = requests[i].offset;
+            sqe.addr = reinterpret_cast<uint64_t>(requests[i].data);
+            sqe.len = static_cast<uint32_t>(std::min<size_t>(requests[i].size, UINT32_MAX));
+            sqe.user_data = i;
+            sqArray_[index] = index;
+        }
+        __atomic_store_n(sqTail_, tail + count, __ATOMIC_RELEASE);
+
+        bool ok = true;
+        unsigned toSubmit = count;
+        unsigned reaped = 0;
+        while (reaped < count) {
+            int entered = Enter(toSubmit, 1);
+            if (entered < 0) {
+                broken = true;
+                return false;
+            }
+            toSubmit -= std::min(toSubmit, static_cast<unsigned>(entered));
+
+            unsigned head = *cqHead_;
+            const unsigned cqTail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != cqTail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & *cqMask_];
+                const AsyncFileReader::Request& request = requests[cqe.user_data];
+                const size_t done = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+                if (done < request.size) {
+                    // Short reads and -EAGAIN / -EINTR: the rest synchronously
+                    const bool retry = cqe.res >= 0 || cqe.res == -EAGAIN || cqe.res == -EINTR;
+                    ok &= retry && read(request.offset + done, request.data + done, request.size - done);
+                }
+                ++reaped;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+        return ok;
+    }
+
+private:
+    explicit Ring(int fd) : fd_(fd) {}
+
+    bool Map(const io_uring_params& params) {
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = MapRegion(sqRingSize_, IORING_OFF_SQ_RING);
+        cqRing_ = single ? sqRing_ : MapRegion(cqRingSize_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(MapRegion(sqesSize_, IORING_OFF_SQES));
+        if (!sqRing_ || !cqRing_ || !sqes_) {
+            return false;
+        }
+
+        uint8_t* sq = static_cast<uint8_t*>(sqRing_);
+        uint8_t* cq = static_cast<uint8_t*>(cqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        entries_ = params.sq_entries;
+        return true;
+    }
+
+    void* MapRegion(size_t size, off_t offset) {
+        void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return region == MAP_FAILED ? nullptr : region;
+    }
+
+    // Submit and wait for at least minComplete completions; retries EINTR
+    int Enter(unsigned toSubmit, unsigned minComplete) {
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete, IORING_ENTER_GETEVENTS,
+                                  nullptr, 0);
+            if (result >= 0 || errno != EINTR) {
+                return static_cast<int>(result);
+            }
+        }
+    }
+
+    int fd_;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqMask_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned* cqMask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned entries_ = 0;
+};
+
+// A ring per concurrent batch, kept for reuse, so decode workers reading
+// at the same time never wait on each other's submissions
+class UringFileReader : public AsyncFileReader {
+public:
+    UringFileReader(int fd, ReadFunction read, std::unique_ptr<Ring> ring)
+        : fd_(fd), read_(read), fallback_(read)
+    {
+        idleRings_.push_back(std::move(ring));
+    }
+
+    const char* GetName() const override { return "io_uring"; }
+
+    bool ReadBatch(const Request* requests, size_t count) override {
+        std::unique_ptr<Ring> ring = AcquireRing();
+        if (!ring) {
+            return fallback_.ReadBatch(requests, count);
+        }
+
+        bool ok = true;
+        bool broken = false;
+        for (size_t start = 0; start < count && !broken; start += ring->GetEntries()) {
+            const unsigned chunk = static_cast<unsigned>(std::min<size_t>(count - start, ring->GetEntries()));
+            ok &= ring->Read(fd_, requests + start, chunk, read_, broken);
+        }
+        if (!broken) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idleRings_.push_back(std::move(ring));
+        }
+        return ok && !broken;
+    }
+
+private:
+    std::unique_ptr<Ring> AcquireRing() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idleRings_.empty()) {
+                std::unique_ptr<Ring> ring = std::move(idleRings_.back());
+                idleRings_.pop_back();
+                return ring;
+            }
+        }
+        return Ring::Create();
+    }
+
+    int fd_;
+    ReadFunction read_;
+    ThreadedFileReader fallback_;  // When no more rings can be created
+    std::vector<std::unique_ptr<Ring>> idleRings_;
+    std::mutex mutex_;
+};
+
+#endif  // PATHVIEW_HAS_IO_URING
+
+}  // namespace
+
+std::unique_ptr<AsyncFileReader> AsyncFileReader::Create(int fd, ReadFunction read) {
+#ifdef PATHVIEW_HAS_IO_URING
+    if (fd >= 0) {
+        std::unique_ptr<Ring> ring = Ring::Create();
+        if (ring) {
+            return std::make_unique<UringFileReader>(fd, std::move(read), std::move(ring));
+        }
+    }
+#else
+    (void)fd;
+#endif
+    return CreateThreaded(std::move(read));
+}
+
+std::unique_ptr<AsyncFileReader> AsyncFileReader::CreateThreaded(ReadFunction read) {
+    return std::make_unique<ThreadedFileReader>(std::move(read));
+}
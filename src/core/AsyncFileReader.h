@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Batched positional reads of one local file: every read of a batch is in
+// flight at once, so a cold page cache or a network filesystem costs one
+// round of latency per batch instead of one per read.
+//
+// On Linux builds with io_uring (PATHVIEW_HAS_IO_URING) a batch goes to the
+// kernel as one submission. Everywhere else, and where the kernel refuses
+// io_uring (old kernels, seccomp sandboxes), a small pool of I/O threads
+// issues the reads side by side.
+//
+// Thread-safe: concurrent batches proceed independently.
+class AsyncFileReader {
+public:
+    struct Request {
+        uint64_t offset;
+        size_t size;
+        uint8_t* data;  // Receives exactly size bytes
+    };
+
+    // Blocking positional read of exactly size bytes; must be thread-safe
+    using ReadFunction = std::function<bool(uint64_t offset, void* data, size_t size)>;
+
+    virtual ~AsyncFileReader() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Read every request; returns once all are done. False if any read
+    // failed (the others' data is still filled in).
+    virtual bool ReadBatch(const Request* requests, size_t count) = 0;
+
+    // io_uring on fd where available, otherwise I/O threads calling read
+    // (fd may be -1 where there is no descriptor, e.g. on Windows)
+    static std::unique_ptr<AsyncFileReader> Create(int fd, ReadFunction read);
+
+    // The I/O thread pool alone
+    static std::unique_ptr<AsyncFileReader> CreateThreaded(ReadFunction read);
+
+    static constexpr size_t IO_THREAD_COUNT = 4;
+    // Reads one io_uring submission holds; larger batches go in rounds
+    static constexpr unsigned RING_ENTRIES = 64;
+};
@@ -0,0 +1,539 @@
+#include "BlockCompressor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// One block's pixels as R, G, B, A
+using Block = uint8_t[16][4];
+
+void LoadBlock(const uint32_t* pixels, int pitch, int32_t width, int32_t height, int32_t blockX, int32_t blockY,
+               Block& block) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pixels);
+    for (int y = 0; y < 4; ++y) {
+        const int32_t row = std::min(blockY * 4 + y, height - 1);
+        const uint32_t* line = reinterpret_cast<const uint32_t*>(bytes + static_cast<size_t>(row) * pitch);
+        for (int x = 0; x < 4; ++x) {
+            const uint32_t pixel = line[std::min(blockX * 4 + x, width - 1)];
+            uint8_t* out = block[y * 4 + x];
+            out[0] = static_cast<uint8_t>(pixel >> 16);
+            out[1] = static_cast<uint8_t>(pixel >> 8);
+            out[2] = static_cast<uint8_t>(pixel);
+            out[3] = static_cast<uint8_t>(pixel >> 24);
+        }
+    }
+}
+
+uint32_t PackPixel(int r, int g, int b, int a) {
+    return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) |
+           (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+}
+
+// Mean and principal axis (power iteration on the covariance) of the
+// first channels of the pixels selected by use
+template <int Channels>
+void FitLine(const Block& block, const bool* use, float* mean, float* axis) {
+    int count = 0;
+    std::fill(mean, mean + Channels, 0.0f);
+    for (int i = 0; i < 16; ++i) {
+        if (use[i]) {
+            for (int c = 0; c < Channels; ++c) {
+                mean[c] += block[i][c];
+            }
+            ++count;
+        }
+    }
+    for (int c = 0; c < Channels; ++c) {
+        mean[c] /= std::max(count, 1);
+    }
+
+    float covariance[Channels][Channels] = {};
+    float lo[Channels], hi[Channels];
+    std::fill(lo, lo + Channels, 255.0f);
+    std::fill(hi, hi + Channels, 0.0f);
+    for (int i = 0; i < 16; ++i) {
+        if (!use[i]) {
+            continue;
+        }
+        float d[Channels];
+        for (int c = 0; c < Channels; ++c) {
+            d[c] = block[i][c] - mean[c];
+            lo[c] = std::min(lo[c], float(block[i][c]));
+            hi[c] = std::max(hi[c], float(block[i][c]));
+        }
+        for (int a = 0; a < Channels; ++a) {
+            for (int b = a; b < Channels; ++b) {
+                covariance[a][b] += d[a] * d[b];
+            }
+        }
+    }
+    for (int a = 0; a < Channels; ++a) {
+        for (int b = 0; b < a; ++b) {
+            covariance[a][b] = covariance[b][a];
+        }
+    }
+
+    // Start from the bounding box diagonal: close to the axis already
+    for (int c = 0; c < Channels; ++c) {
+        axis[c] = hi[c] - lo[c];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[Channels] = {};
+        float length = 0.0f;
+        for (int a = 0; a < Channels; ++a) {
+            for (int b = 0; b < Channels; ++b) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = std::max(length, std::fabs(next[a]));
+        }
+        if (length <= 0.0f) {
+            break;
+        }
+        for (int c = 0; c < Channels; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+    float norm = 0.0f;
+    for (int c = 0; c < Channels; ++c) {
+        norm += axis[c] * axis[c];
+    }
+    norm = std::sqrt(norm);
+    for (int c = 0; c < Channels; ++c) {
+        axis[c] = norm > 0.0f ? axis[c] / norm : 0.0f;
+    }
+}
+
+// Endpoints: the extremes of the pixels' projections on the line
+template <int Channels>
+void LineExtremes(const Block& block, const bool* use, const float* mean, const float* axis, float* low,
+                  float* high) {
+    float tMin = 0.0f;
+    float tMax = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        if (!use[i]) {
+            continue;
+        }
+        float t = 0.0f;
+        for (int c = 0; c < Channels; ++c) {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < Channels; ++c) {
+        low[c] = std::clamp(mean[c] + tMin * axis[c], 0.0f, 255.0f);
+        high[c] = std::clamp(mean[c] + tMax * axis[c], 0.0f, 255.0f);
+    }
+}
+
+// --- BC1 ---
+
+uint16_t To565(const float* color) {
+    const int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+    const int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+    const int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void From565(uint16_t color, int* out) {
+    const int r = (color >> 11) & 31;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// The four colors (RGBA) of a BC1 block's endpoints
+void Bc1Palette(uint16_t c0, uint16_t c1, int palette[4][4]) {
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    for (int c = 0; c < 3; ++c) {
+        if (c0 > c1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;  // Transparent black
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = c0 > c1 ? 255 : 0;
+}
+
+void CompressBc1(const Block& block, uint8_t* out) {
+    bool opaque[16];
+    bool transparent = false;
+    bool any = false;
+    for (int i = 0; i < 16; ++i) {
+        opaque[i] = block[i][3] >= 128;
+        transparent |= !opaque[i];
+        any |= opaque[i];
+    }
+
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+    if (any) {
+        float mean[3], axis[3], low[3], high[3];
+        FitLine<3>(block, opaque, mean, axis);
+        LineExtremes<3>(block, opaque, mean, axis, low, high);
+        c0 = To565(high);
+        c1 = To565(low);
+    }
+    // Four colors need c0 > c1, three colors and transparent c0 <= c1
+    if (transparent ? c0 > c1 : c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    int palette[4][4];
+    Bc1Palette(c0, c1, palette);
+    const int colors = transparent ? 3 : (c0 == c1 ? 1 : 4);
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 3;
+        if (opaque[i]) {
+            best = 0;
+            int bestError = 1 << 30;
+            for (int p = 0; p < colors; ++p) {
+                int error = 0;
+                for (int c = 0; c < 3; ++c) {
+                    const int d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+        }
+        indices |= static_cast<uint32_t>(best) << (2 * i);
+    }
+
+    out[0] = static_cast<uint8_t>(c0);
+    out[1] = static_cast<uint8_t>(c0 >> 8);
+    out[2] = static_cast<uint8_t>(c1);
+    out[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int b = 0; b < 4; ++b) {
+        out[4 + b] = static_cast<uint8_t>(indices >> (8 * b));
+    }
+}
+
+void DecompressBc1(const uint8_t* in, uint32_t* pixels[4]) {
+    const uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    const uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    const uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+    int palette[4][4];
+    Bc1Palette(c0, c1, palette);
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[(indices >> (2 * i)) & 3];
+        pixels[i / 4][i % 4] = PackPixel(color[0], color[1], color[2], color[3]);
+    }
+}
+
+// --- BC7 mode 6: RGBA endpoints of 7 bits and a shared low bit each, 4-bit indices ---
+
+constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Bc7Endpoint {
+    int value[4];  // 7 bits a channel
+    int pBit;
+};
+
+// Nearest representable endpoint, choosing the low bit that fits best.
+// Opaque blocks keep alpha exactly 255 (low bit 1), or opaque tissue would
+// blend with what is behind it
+Bc7Endpoint QuantizeBc7(const float* color, bool opaque) {
+    Bc7Endpoint best{};
+    float bestError = 1e30f;
+    for (int p = opaque ? 1 : 0; p < 2; ++p) {
+        Bc7Endpoint candidate{};
+        candidate.pBit = p;
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            candidate.value[c] = std::clamp(static_cast<int>(std::lround((color[c] - p) / 2.0f)), 0, 127);
+            if (opaque && c == 3) {
+                candidate.value[c] = 127;
+            }
+            const float d = (candidate.value[c] * 2 + p) - color[c];
+            error += d * d;
+        }
+        if (error < bestError) {
+            bestError = error;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+void Bc7Palette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, int palette[16][4]) {
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            const int a = e0.value[c] * 2 + e0.pBit;
+            const int b = e1.value[c] * 2 + e1.pBit;
+            palette[i][c] = ((64 - BC7_WEIGHTS[i]) * a + BC7_WEIGHTS[i] * b + 32) >> 6;
+        }
+    }
+}
+
+// Indices of the palette entries nearest each pixel: the projection on the
+// endpoints' line, then its neighbors; returns the squared error
+int AssignBc7(const Block& block, const int palette[16][4], int* indices) {
+    float direction[4];
+    float length = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        direction[c] = float(palette[15][c] - palette[0][c]);
+        length += direction[c] * direction[c];
+    }
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        int guess = 0;
+        if (length > 0.0f) {
+            float t = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                t += (block[i][c] - palette[0][c]) * direction[c];
+            }
+            guess = std::clamp(static_cast<int>(std::lround(t / length * 15.0f)), 0, 15);
+        }
+        int best = guess;
+        int bestError = 1 << 30;
+        for (int candidate = std::max(0, guess - 1); candidate <= std::min(15, guess + 1); ++candidate) {
+            int error = 0;
+            for (int c = 0; c < 4; ++c) {
+                const int d = block[i][c] - palette[candidate][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = candidate;
+            }
+        }
+        indices[i] = best;
+        total += bestError;
+    }
+    return total;
+}
+
+// Least-squares endpoints for fixed indices; false if they do not spread
+bool RefitBc7(const Block& block, const int* indices, float* low, float* high) {
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float rhsLow[4] = {}, rhsHigh[4] = {};
+    for (int i = 0; i < 16; ++i) {
+        const float t = BC7_WEIGHTS[indices[i]] / 64.0f;
+        a += (1.0f - t) * (1.0f - t);
+        b += (1.0f - t) * t;
+        c += t * t;
+        for (int ch = 0; ch < 4; ++ch) {
+            rhsLow[ch] += (1.0f - t) * block[i][ch];
+            rhsHigh[ch] += t * block[i][ch];
+        }
+    }
+    const float determinant = a * c - b * b;
+    if (std::fabs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (int ch = 0; ch < 4; ++ch) {
+        low[ch] = std::clamp((c * rhsLow[ch] - b * rhsHigh[ch]) / determinant, 0.0f, 255.0f);
+        high[ch] = std::clamp((a * rhsHigh[ch] - b * rhsLow[ch]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// LSB-first bit packing of a 128-bit block
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : out_(out) { std::memset(out_, 0, 16); }
+    void Put(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position_) {
+            out_[position_ / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (position_ % 8));
+        }
+    }
+
+private:
+    uint8_t* out_;
+    int position_ = 0;
+};
+
+class BitReader {
+public:
+    explicit BitReader(const uint8_t* in) : in_(in) {}
+    uint32_t Get(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; ++i, ++position_) {
+            value |= static_cast<uint32_t>((in_[position_ / 8] >> (position_ % 8)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t* in_;
+    int position_ = 0;
+};
+
+void CompressBc7(const Block& block, uint8_t* out) {
+    bool all[16];
+    std::fill(all, all + 16, true);
+    bool opaque = true;
+    for (int i = 0; i < 16; ++i) {
+        opaque &= block[i][3] == 255;
+    }
+    float mean[4], axis[4], low[4], high[4];
+    FitLine<4>(block, all, mean, axis);
+    LineExtremes<4>(block, all, mean, axis, low, high);
+
+    Bc7Endpoint e0 = QuantizeBc7(low, opaque);
+    Bc7Endpoint e1 = QuantizeBc7(high, opaque);
+    int palette[16][4];
+    int indices[16];
+    Bc7Palette(e0, e1, palette);
+    int error = AssignBc7(block, palette, indices);
+
+    if (error > 0 && RefitBc7(block, indices, low, high)) {
+        const Bc7Endpoint r0 = QuantizeBc7(low, opaque);
+        const Bc7Endpoint r1 = QuantizeBc7(high, opaque);
+        int refitIndices[16];
+        Bc7Palette(r0, r1, palette);
+        const int refitError = AssignBc7(block, palette, refitIndices);
+        if (refitError < error) {
+            e0 = r0;
+            e1 = r1;
+            std::copy(refitIndices, refitIndices + 16, indices);
+        }
+    }
+
+    // The first index is stored without its top bit
+    if (indices[0] >= 8) {
+        std::swap(e0, e1);
+        for (int& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(out);
+    writer.Put(1 << 6, 7);  // Mode 6
+    for (int c = 0; c < 4; ++c) {
+        writer.Put(e0.value[c], 7);
+        writer.Put(e1.value[c], 7);
+    }
+    writer.Put(e0.pBit, 1);
+    writer.Put(e1.pBit, 1);
+    writer.Put(indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.Put(indices[i], 4);
+    }
+}
+
+// Mode 6 blocks only, the ones CompressBc7 writes; others decode black
+void DecompressBc7(const uint8_t* in, uint32_t* pixels[4]) {
+    BitReader reader(in);
+    if (reader.Get(7) != (1u << 6)) {
+        for (int i = 0; i < 16; ++i) {
+            pixels[i / 4][i % 4] = 0;
+        }
+        return;
+    }
+    Bc7Endpoint e0{}, e1{};
+    for (int c = 0; c < 4; ++c) {
+        e0.value[c] = static_cast<int>(reader.Get(7));
+        e1.value[c] = static_cast<int>(reader.Get(7));
+    }
+    e0.pBit = static_cast<int>(reader.Get(1));
+    e1.pBit = static_cast<int>(reader.Get(1));
+    int palette[16][4];
+    Bc7Palette(e0, e1, palette);
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[reader.Get(i == 0 ? 3 : 4)];
+        pixels[i / 4][i % 4] = PackPixel(color[0], color[1], color[2], color[3]);
+    }
+}
+
+}  // namespace
+
+const char* TextureCompressionName(TextureCompression compression) {
+    switch (compression) {
+        case TextureCompression::Bc7: return "bc7";
+        case TextureCompression::Bc1: return "bc1";
+        case TextureCompression::None: break;
+    }
+    return "none";
+}
+
+std::optional<TextureCompression> ParseTextureCompression(const std::string& name) {
+    if (name == "none") return TextureCompression::None;
+    if (name == "bc7") return TextureCompression::Bc7;
+    if (name == "bc1") return TextureCompression::Bc1;
+    return std::nullopt;
+}
+
+size_t BlockCompressor::BlockBytes(TextureCompression compression) {
+    switch (compression) {
+        case TextureCompression::Bc7: return 16;
+        case TextureCompression::Bc1: return 8;
+        case TextureCompression::None: break;
+    }
+    return 0;
+}
+
+size_t BlockCompressor::CompressedSize(TextureCompression compression, int32_t width, int32_t height) {
+    if (compression == TextureCompression::None) {
+        return static_cast<size_t>(width) * height * sizeof(uint32_t);
+    }
+    return static_cast<size_t>(RoundUp(width) / BLOCK_SIZE) * (RoundUp(height) / BLOCK_SIZE) *
+           BlockBytes(compression);
+}
+
+void BlockCompressor::Compress(TextureCompression compression, const uint32_t* pixels, int pitch, int32_t width,
+                               int32_t height, uint8_t* out) {
+    if (compression == TextureCompression::None) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(pixels);
+        const size_t rowBytes = static_cast<size_t>(width) * sizeof(uint32_t);
+        for (int32_t y = 0; y < height; ++y) {
+            std::memcpy(out + y * rowBytes, bytes + static_cast<size_t>(y) * pitch, rowBytes);
+        }
+        return;
+    }
+    const size_t blockBytes = BlockBytes(compression);
+    const int32_t blocksX = RoundUp(width) / BLOCK_SIZE;
+    const int32_t blocksY = RoundUp(height) / BLOCK_SIZE;
+    Block block;
+    for (int32_t by = 0; by < blocksY; ++by) {
+        for (int32_t bx = 0; bx < blocksX; ++bx) {
+            LoadBlock(pixels, pitch, width, height, bx, by, block);
+            uint8_t* blockOut = out + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+            if (compression == TextureCompression::Bc1) {
+                CompressBc1(block, blockOut);
+            } else {
+                CompressBc7(block, blockOut);
+            }
+        }
+    }
+}
+
+void BlockCompressor::Decompress(TextureCompression compression, const uint8_t* blocks, int32_t width,
+                                 int32_t height, uint32_t* pixels) {
+    if (compression == TextureCompression::None) {
+        std::memcpy(pixels, blocks, static_cast<size_t>(width) * height * sizeof(uint32_t));
+        return;
+    }
+    const size_t blockBytes = BlockBytes(compression);
+    const int32_t blocksX = RoundUp(width) / BLOCK_SIZE;
+    const int32_t blocksY = RoundUp(height) / BLOCK_SIZE;
+    uint32_t decoded[4][4];
+    uint32_t* rows[4] = {decoded[0], decoded[1], decoded[2], decoded[3]};
+    for (int32_t by = 0; by < blocksY; ++by) {
+        for (int32_t bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* block = blocks + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+            if (compression == TextureCompression::Bc1) {
+                DecompressBc1(block, rows);
+            } else {
+                DecompressBc7(block, rows);
+            }
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (int x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    pixels[static_cast<size_t>(by * 4 + y) * width + bx * 4 + x] = decoded[y][x];
+                }
+            }
+        }
+    }
+}
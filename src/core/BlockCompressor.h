@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// GPU block-compressed formats tile textures may be kept in, traded
+// against exact pixels (--texture-compression)
+enum class TextureCompression {
+    None,  // RGBA8: exact pixels, for diagnostic reading
+    Bc7,   // 8 bits a pixel, 4x the tiles per byte of VRAM; near lossless
+    Bc1    // 4 bits a pixel, 8x; fine detail blurs a little, for navigation
+};
+
+// "none", "bc7", "bc1"
+const char* TextureCompressionName(TextureCompression compression);
+std::optional<TextureCompression> ParseTextureCompression(const std::string& name);
+
+// CPU encoder (and decoder, for tests and checks) of 4x4 pixel blocks from
+// tile pixels (TextureManager::TILE_PIXEL_FORMAT: 0xAARRGGBB words,
+// premultiplied alpha)
+//
+// BC1 fits each block's colors to the line along their principal axis;
+// transparent pixels (alpha below half) use BC1's transparent black index,
+// exactly what premultiplied transparent pixels are, so a slide's edge
+// stays clean. BC7 uses mode 6 (one RGBA line, 16 levels), with the
+// endpoints refit to the chosen levels once by least squares; opaque blocks
+// stay exactly opaque. Both run on upload worker threads: a 512x512 tile
+// takes some 10 ms (BC1) to 30 ms (BC7) of one core.
+class BlockCompressor {
+public:
+    static constexpr int32_t BLOCK_SIZE = 4;
+
+    // Bytes of one 4x4 block (0 for None)
+    static size_t BlockBytes(TextureCompression compression);
+
+    // Bytes of a width x height image, in whole blocks (4 bytes a pixel for None)
+    static size_t CompressedSize(TextureCompression compression, int32_t width, int32_t height);
+
+    // Round a size up to whole blocks
+    static int32_t RoundUp(int32_t size) { return (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE; }
+
+    // Compress pixels (rows pitch bytes apart) into CompressedSize() bytes
+    // of blocks, block rows top to bottom. Blocks past the right or bottom
+    // edge repeat the last column or row.
+    static void Compress(TextureCompression compression, const uint32_t* pixels, int pitch, int32_t width,
+                         int32_t height, uint8_t* out);
+
+    // Decode blocks back to width x height pixels (tightly packed)
+    static void Decompress(TextureCompression compression, const uint8_t* blocks, int32_t width, int32_t height,
+                           uint32_t* pixels);
+};
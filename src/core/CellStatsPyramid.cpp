@@ -0,0 +1,242 @@
+#include "CellStatsPyramid.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using ClassStats = CellStatsPyramid::ClassStats;
+using Entry = CellStatsPyramid::Entry;
+
+void Add(ClassStats& sum, const ClassStats& stats) {
+    sum.count += stats.count;
+    sum.area += stats.area;
+    sum.confidence += stats.confidence;
+}
+
+// Add to a node's entries; a node holds few classes, so a linear search
+void AddEntry(std::vector<Entry>& node, int classId, const ClassStats& stats) {
+    for (Entry& entry : node) {
+        if (entry.classId == classId) {
+            Add(entry.stats, stats);
+            return;
+        }
+    }
+    node.push_back({classId, stats});
+}
+
+// Append a node's entries to its level, ascending by class
+void CloseNode(std::vector<Entry>& node, CellStatsPyramid::Level& level) {
+    std::sort(node.begin(), node.end(), [](const Entry& a, const Entry& b) { return a.classId < b.classId; });
+    level.entries.insert(level.entries.end(), node.begin(), node.end());
+    level.starts.push_back(static_cast<uint32_t>(level.entries.size()));
+    node.clear();
+}
+
+}  // namespace
+
+void CellStatsPyramid::Build(const PolygonStore& polygons) {
+    auto start = std::chrono::steady_clock::now();
+    Clear();
+
+    double minX = std::numeric_limits<double>::max(), minY = minX;
+    double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+    minConfidence_ = std::numeric_limits<float>::max();
+    const uint32_t polygonCount = static_cast<uint32_t>(polygons.Size());
+    for (uint32_t polygon = 0; polygon < polygonCount; ++polygon) {
+        if (polygons.GetVertexCount(polygon) == 0) {
+            continue;
+        }
+        const Vec2 centroid = polygons.GetCentroid(polygon);
+        minX = std::min(minX, centroid.x);
+        minY = std::min(minY, centroid.y);
+        maxX = std::max(maxX, centroid.x);
+        maxY = std::max(maxY, centroid.y);
+        minConfidence_ = std::min(minConfidence_, polygons.GetConfidence(polygon));
+    }
+    if (minX > maxX) {
+        minConfidence_ = 0.0f;
+        return;
+    }
+
+    // Level 0 from the bin holding the lowest centroid to the one holding
+    // the highest, bins widened until there are not too many
+    int32_t binSize = BIN_SIZE;
+    int64_t columns = 0, rows = 0;
+    while (true) {
+        originX_ = std::floor(minX / binSize) * binSize;
+        originY_ = std::floor(minY / binSize) * binSize;
+        columns = static_cast<int64_t>((maxX - originX_) / binSize) + 1;
+        rows = static_cast<int64_t>((maxY - originY_) / binSize) + 1;
+        if (size_t(columns) * size_t(rows) <= MAX_BINS) {
+            break;
+        }
+        binSize *= 2;
+    }
+
+    auto binOf = [&](uint32_t polygon) {
+        const Vec2 centroid = polygons.GetCentroid(polygon);
+        const int64_t column = std::min<int64_t>(columns - 1, static_cast<int64_t>((centroid.x - originX_) / binSize));
+        const int64_t row = std::min<int64_t>(rows - 1, static_cast<int64_t>((centroid.y - originY_) / binSize));
+        return static_cast<size_t>(row * columns + column);
+    };
+
+    // Cells sorted by bin (counting sort, store order within a bin)
+    const size_t binCount = size_t(columns) * size_t(rows);
+    cellStarts_.assign(binCount + 1, 0);
+    for (uint32_t polygon = 0; polygon < polygonCount; ++polygon) {
+        if (polygons.GetVertexCount(polygon) > 0) {
+            cellStarts_[binOf(polygon) + 1]++;
+        }
+    }
+    for (size_t bin = 0; bin < binCount; ++bin) {
+        cellStarts_[bin + 1] += cellStarts_[bin];
+    }
+    cells_.resize(cellStarts_[binCount]);
+    std::vector<uint32_t> next(cellStarts_.begin(), cellStarts_.end() - 1);
+    for (uint32_t polygon = 0; polygon < polygonCount; ++polygon) {
+        if (polygons.GetVertexCount(polygon) > 0) {
+            cells_[next[binOf(polygon)]++] = polygon;
+        }
+    }
+
+    Level level;
+    level.binSize = binSize;
+    level.columns = static_cast<int32_t>(columns);
+    level.rows = static_cast<int32_t>(rows);
+    level.starts.reserve(binCount + 1);
+    level.starts.push_back(0);
+    std::vector<Entry> node;
+    for (size_t bin = 0; bin < binCount; ++bin) {
+        for (uint32_t i = cellStarts_[bin]; i < cellStarts_[bin + 1]; ++i) {
+            const uint32_t polygon = cells_[i];
+            AddEntry(node, polygons.GetClassId(polygon),
+                     {1, double(polygons.GetArea(polygon)), double(polygons.GetConfidence(polygon))});
+        }
+        CloseNode(node, level);
+    }
+    levels_.push_back(std::move(level));
+
+    // Sum 2x2 nodes into the next level until one covers everything
+    while (levels_.back().columns > 1 || levels_.back().rows > 1) {
+        const Level& below = levels_.back();
+        Level above;
+        above.binSize = below.binSize * 2;
+        above.columns = (below.columns + 1) / 2;
+        above.rows = (below.rows + 1) / 2;
+        above.starts.reserve(size_t(above.columns) * above.rows + 1);
+        above.starts.push_back(0);
+        for (int32_t y = 0; y < above.rows; ++y) {
+            for (int32_t x = 0; x < above.columns; ++x) {
+                for (int32_t childY = 2 * y; childY < std::min(2 * y + 2, below.rows); ++childY) {
+                    for (int32_t childX = 2 * x; childX < std::min(2 * x + 2, below.columns); ++childX) {
+                        const size_t child = size_t(childY) * below.columns + childX;
+                        for (uint32_t i = below.starts[child]; i < below.starts[child + 1]; ++i) {
+                            AddEntry(node, below.entries[i].classId, below.entries[i].stats);
+                        }
+                    }
+                }
+                CloseNode(node, above);
+            }
+        }
+        levels_.push_back(std::move(above));
+    }
+
+    PATHVIEW_LOG_INFO("Cell stats pyramid built: " << levels_.size() << " levels from "
+                      << levels_.front().columns << "x" << levels_.front().rows << " bins of "
+                      << binSize << " px in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms");
+}
+
+void CellStatsPyramid::Clear() {
+    levels_.clear();
+    cellStarts_.clear();
+    cells_.clear();
+    originX_ = 0.0;
+    originY_ = 0.0;
+    minConfidence_ = 0.0f;
+}
+
+template <typename Classify, typename Inside>
+void CellStatsPyramid::Visit(const PolygonStore& polygons, size_t level, int32_t x, int32_t y,
+                             const Classify& classify, const Inside& inside,
+                             std::map<int, ClassStats>& out) const {
+    const Level& nodes = levels_[level];
+    const Rect box(originX_ + double(x) * nodes.binSize, originY_ + double(y) * nodes.binSize,
+                   nodes.binSize, nodes.binSize);
+    const PolygonMask::Overlap overlap = classify(box);
+    if (overlap == PolygonMask::NONE) {
+        return;
+    }
+
+    const size_t node = size_t(y) * nodes.columns + x;
+    if (overlap == PolygonMask::WHOLE) {
+        for (uint32_t i = nodes.starts[node]; i < nodes.starts[node + 1]; ++i) {
+            Add(out[nodes.entries[i].classId], nodes.entries[i].stats);
+        }
+        return;
+    }
+
+    if (level == 0) {
+        for (uint32_t i = cellStarts_[node]; i < cellStarts_[node + 1]; ++i) {
+            const uint32_t polygon = cells_[i];
+            const Vec2 centroid = polygons.GetCentroid(polygon);
+            if (inside(centroid.x, centroid.y)) {
+                Add(out[polygons.GetClassId(polygon)],
+                    {1, double(polygons.GetArea(polygon)), double(polygons.GetConfidence(polygon))});
+            }
+        }
+        return;
+    }
+
+    const Level& below = levels_[level - 1];
+    for (int32_t childY = 2 * y; childY < std::min(2 * y + 2, below.rows); ++childY) {
+        for (int32_t childX = 2 * x; childX < std::min(2 * x + 2, below.columns); ++childX) {
+            Visit(polygons, level - 1, childX, childY, classify, inside, out);
+        }
+    }
+}
+
+void CellStatsPyramid::Summarize(const PolygonStore& polygons, const Rect& region,
+                                 std::map<int, ClassStats>& out) const {
+    if (levels_.empty()) {
+        return;
+    }
+    // A node holds the centroids in [x, x + size), so one ending at the
+    // region's left edge holds none of them
+    auto classify = [&](const Rect& box) {
+        if (box.Right() <= region.x || box.x > region.Right() ||
+            box.Bottom() <= region.y || box.y > region.Bottom()) {
+            return PolygonMask::NONE;
+        }
+        if (box.x >= region.x && box.Right() <= region.Right() &&
+            box.y >= region.y && box.Bottom() <= region.Bottom()) {
+            return PolygonMask::WHOLE;
+        }
+        return PolygonMask::PARTIAL;
+    };
+    auto inside = [&](double x, double y) {
+        return x >= region.x && x <= region.Right() && y >= region.y && y <= region.Bottom();
+    };
+    Visit(polygons, levels_.size() - 1, 0, 0, classify, inside, out);
+}
+
+void CellStatsPyramid::Summarize(const PolygonStore& polygons, const PolygonMask& mask,
+                                 std::map<int, ClassStats>& out) const {
+    if (levels_.empty()) {
+        return;
+    }
+    Visit(polygons, levels_.size() - 1, 0, 0, [&](const Rect& box) { return mask.Classify(box); },
+          [&](double x, double y) { return mask.Contains(x, y); }, out);
+}
+
+size_t CellStatsPyramid::GetMemoryUsage() const {
+    size_t bytes = cellStarts_.capacity() * sizeof(uint32_t) + cells_.capacity() * sizeof(uint32_t);
+    for (const Level& level : levels_) {
+        bytes += level.starts.capacity() * sizeof(uint32_t) + level.entries.capacity() * sizeof(Entry);
+    }
+    return bytes;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "PolygonMask.h"
+#include "PolygonStore.h"
+#include "Viewport.h"  // For Rect
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Per-class cell statistics as a quadtree of sums, so region summaries
+// ("how many lymphocytes in this rectangle") need not visit every cell.
+//
+// Level 0 bins cell centroids in square bins of BIN_SIZE slide pixels
+// (larger for a store spread over an enormous area); each coarser level
+// sums 2x2 nodes of the one below until one node covers every cell. A
+// node keeps, for each class present in it, the count and the sums of
+// area and confidence. A query descends from the root: nodes wholly inside
+// the region add their sums at once, nodes wholly outside are dropped, and
+// only level 0 bins across the region's edge visit their cells. A
+// rectangle thus costs O(log n) nodes plus the cells along its border; an
+// outline is classified through its PolygonMask.
+//
+// Built once a load completes, for that store only; const access is
+// thread-safe.
+class CellStatsPyramid {
+public:
+    struct ClassStats {
+        uint64_t count = 0;
+        double area = 0.0;        // Sum of cell areas (level 0 pixels)
+        double confidence = 0.0;  // Sum of confidences
+    };
+
+    struct Entry {
+        int classId;
+        ClassStats stats;
+    };
+
+    // Nodes of a level, row-major; node i's entries (ascending class ID)
+    // are entries[starts[i]] up to entries[starts[i + 1]]
+    struct Level {
+        int32_t binSize = 0;  // Slide pixels per node side
+        int32_t columns = 0;
+        int32_t rows = 0;
+        std::vector<uint32_t> starts;
+        std::vector<Entry> entries;
+    };
+
+    // Cells without vertices are left out
+    void Build(const PolygonStore& polygons);
+    void Clear();
+
+    bool Empty() const { return levels_.empty(); }
+
+    /**
+     * Add to out (by class) the stats of the cells whose centroid lies in a
+     * rectangle, edges included
+     * @param polygons The store the pyramid was built from
+     */
+    void Summarize(const PolygonStore& polygons, const Rect& region, std::map<int, ClassStats>& out) const;
+
+    // The same for the cells whose centroid lies inside an outline
+    void Summarize(const PolygonStore& polygons, const PolygonMask& mask, std::map<int, ClassStats>& out) const;
+
+    // Lowest confidence of any cell: a confidence threshold no higher
+    // leaves every cell in, so summaries answer for it
+    float GetMinConfidence() const { return minConfidence_; }
+
+    // Slide position of level 0's first bin (a multiple of its bin size)
+    double GetOriginX() const { return originX_; }
+    double GetOriginY() const { return originY_; }
+    size_t GetLevelCount() const { return levels_.size(); }
+    const Level& GetLevel(size_t level) const { return levels_[level]; }
+
+    size_t GetMemoryUsage() const;
+
+    static constexpr int32_t BIN_SIZE = 64;
+    static constexpr size_t MAX_BINS = size_t(1) << 24;  // Level 0 bins before they widen
+
+private:
+    template <typename Classify, typename Inside>
+    void Visit(const PolygonStore& polygons, size_t level, int32_t x, int32_t y, const Classify& classify,
+               const Inside& inside, std::map<int, ClassStats>& out) const;
+
+    std::vector<Level> levels_;  // Finest first
+    double originX_ = 0.0;
+    double originY_ = 0.0;
+    float minConfidence_ = 0.0f;
+
+    // Store indices of the cells of each level 0 bin: cells_[cellStarts_[i]]
+    // up to cells_[cellStarts_[i + 1]]
+    std::vector<uint32_t> cellStarts_;
+    std::vector<uint32_t> cells_;
+};
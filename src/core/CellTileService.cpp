@@ -0,0 +1,467 @@
+#include "CellTileService.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_BYTES = 2;
+constexpr uint32_t WIRE_FIXED32 = 5;
+
+// vector_tile.proto field numbers
+constexpr uint32_t TILE_LAYERS = 3;
+constexpr uint32_t LAYER_NAME_FIELD = 1;
+constexpr uint32_t LAYER_FEATURES = 2;
+constexpr uint32_t LAYER_KEYS = 3;
+constexpr uint32_t LAYER_VALUES = 4;
+constexpr uint32_t LAYER_EXTENT = 5;
+constexpr uint32_t LAYER_VERSION = 15;
+constexpr uint32_t FEATURE_ID = 1;
+constexpr uint32_t FEATURE_TAGS = 2;
+constexpr uint32_t FEATURE_TYPE = 3;
+constexpr uint32_t FEATURE_GEOMETRY = 4;
+constexpr uint32_t VALUE_STRING = 1;
+constexpr uint32_t VALUE_FLOAT = 2;
+constexpr uint32_t VALUE_UINT = 5;
+constexpr uint32_t VALUE_SINT = 6;
+
+constexpr uint32_t GEOMETRY_POINT = 1;
+constexpr uint32_t GEOMETRY_POLYGON = 3;
+
+constexpr uint32_t COMMAND_MOVE_TO = 1;
+constexpr uint32_t COMMAND_LINE_TO = 2;
+constexpr uint32_t COMMAND_CLOSE_PATH = 7;
+
+// Tag keys, in this order
+constexpr uint32_t KEY_CLASS = 0;
+constexpr uint32_t KEY_CLASS_NAME = 1;
+constexpr uint32_t KEY_CONFIDENCE = 2;
+const char* const KEYS[] = {"class", "class_name", "confidence"};
+
+void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutTag(std::vector<uint8_t>& out, uint32_t field, uint32_t wireType) {
+    PutVarint(out, (static_cast<uint64_t>(field) << 3) | wireType);
+}
+
+void PutUint(std::vector<uint8_t>& out, uint32_t field, uint64_t value) {
+    PutTag(out, field, WIRE_VARINT);
+    PutVarint(out, value);
+}
+
+void PutBytes(std::vector<uint8_t>& out, uint32_t field, const void* data, size_t size) {
+    PutTag(out, field, WIRE_BYTES);
+    PutVarint(out, size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void PutString(std::vector<uint8_t>& out, uint32_t field, const std::string& value) {
+    PutBytes(out, field, value.data(), value.size());
+}
+
+void PutFloat(std::vector<uint8_t>& out, uint32_t field, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutTag(out, field, WIRE_FIXED32);
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+void PutPackedUints(std::vector<uint8_t>& out, uint32_t field, const std::vector<uint32_t>& values,
+                    std::vector<uint8_t>& scratch) {
+    scratch.clear();
+    for (uint32_t value : values) {
+        PutVarint(scratch, value);
+    }
+    PutBytes(out, field, scratch.data(), scratch.size());
+}
+
+uint32_t ZigZagEncode(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+uint32_t Command(uint32_t id, uint32_t count) {
+    return (id & 0x7) | (count << 3);
+}
+
+struct TilePoint {
+    int32_t x, y;
+    bool operator==(const TilePoint& other) const { return x == other.x && y == other.y; }
+};
+
+// The layer being written: features, and the value table their tags index
+class LayerWriter {
+public:
+    explicit LayerWriter(const std::map<int, std::string>& classNames) : classNames_(classNames) {}
+
+    bool Empty() const { return features_.empty(); }
+
+    // A point feature, or a polygon one of one exterior ring (at least
+    // three points, positive area in tile coordinates: clockwise, y down)
+    void AddPoint(uint32_t id, int classId, float confidence, TilePoint point) {
+        geometry_.clear();
+        geometry_.push_back(Command(COMMAND_MOVE_TO, 1));
+        geometry_.push_back(ZigZagEncode(point.x));
+        geometry_.push_back(ZigZagEncode(point.y));
+        AddFeature(id, classId, confidence, GEOMETRY_POINT);
+    }
+
+    void AddPolygon(uint32_t id, int classId, float confidence, const std::vector<TilePoint>& ring) {
+        geometry_.clear();
+        geometry_.push_back(Command(COMMAND_MOVE_TO, 1));
+        geometry_.push_back(ZigZagEncode(ring[0].x));
+        geometry_.push_back(ZigZagEncode(ring[0].y));
+        geometry_.push_back(Command(COMMAND_LINE_TO, static_cast<uint32_t>(ring.size() - 1)));
+        for (size_t i = 1; i < ring.size(); ++i) {
+            geometry_.push_back(ZigZagEncode(ring[i].x - ring[i - 1].x));
+            geometry_.push_back(ZigZagEncode(ring[i].y - ring[i - 1].y));
+        }
+        geometry_.push_back(Command(COMMAND_CLOSE_PATH, 1));
+        AddFeature(id, classId, confidence, GEOMETRY_POLYGON);
+    }
+
+    // The whole tile: one layer holding everything added
+    void Finish(std::vector<uint8_t>& out) {
+        std::vector<uint8_t> layer;
+        PutUint(layer, LAYER_VERSION, 2);
+        PutString(layer, LAYER_NAME_FIELD, CellTileService::LAYER_NAME);
+        layer.insert(layer.end(), features_.begin(), features_.end());
+        for (const char* key : KEYS) {
+            PutString(layer, LAYER_KEYS, key);
+        }
+        layer.insert(layer.end(), values_.begin(), values_.end());
+        PutUint(layer, LAYER_EXTENT, CellTileService::EXTENT);
+
+        out.clear();
+        PutBytes(out, TILE_LAYERS, layer.data(), layer.size());
+    }
+
+private:
+    void AddFeature(uint32_t id, int classId, float confidence, uint32_t type) {
+        tags_.clear();
+        tags_.push_back(KEY_CLASS);
+        tags_.push_back(ClassValue(classId));
+        auto name = classNames_.find(classId);
+        if (name != classNames_.end()) {
+            tags_.push_back(KEY_CLASS_NAME);
+            tags_.push_back(NameValue(classId, name->second));
+        }
+        tags_.push_back(KEY_CONFIDENCE);
+        tags_.push_back(ConfidenceValue(confidence));
+
+        feature_.clear();
+        PutUint(feature_, FEATURE_ID, id);
+        PutPackedUints(feature_, FEATURE_TAGS, tags_, scratch_);
+        PutUint(feature_, FEATURE_TYPE, type);
+        PutPackedUints(feature_, FEATURE_GEOMETRY, geometry_, scratch_);
+        PutBytes(features_, LAYER_FEATURES, feature_.data(), feature_.size());
+    }
+
+    uint32_t ClassValue(int classId) {
+        auto it = classValues_.find(classId);
+        if (it != classValues_.end()) {
+            return it->second;
+        }
+        scratch_.clear();
+        if (classId < 0) {
+            PutUint(scratch_, VALUE_SINT, (static_cast<uint64_t>(-int64_t(classId)) << 1) - 1);
+        } else {
+            PutUint(scratch_, VALUE_UINT, static_cast<uint64_t>(classId));
+        }
+        return classValues_[classId] = AddValue();
+    }
+
+    uint32_t NameValue(int classId, const std::string& name) {
+        auto it = nameValues_.find(classId);
+        if (it != nameValues_.end()) {
+            return it->second;
+        }
+        scratch_.clear();
+        PutString(scratch_, VALUE_STRING, name);
+        return nameValues_[classId] = AddValue();
+    }
+
+    uint32_t ConfidenceValue(float confidence) {
+        uint32_t bits;
+        std::memcpy(&bits, &confidence, sizeof(bits));
+        auto it = confidenceValues_.find(bits);
+        if (it != confidenceValues_.end()) {
+            return it->second;
+        }
+        scratch_.clear();
+        PutFloat(scratch_, VALUE_FLOAT, confidence);
+        return confidenceValues_[bits] = AddValue();
+    }
+
+    // Append the value message in scratch_; returns its index
+    uint32_t AddValue() {
+        PutBytes(values_, LAYER_VALUES, scratch_.data(), scratch_.size());
+        return valueCount_++;
+    }
+
+    const std::map<int, std::string>& classNames_;
+    std::vector<uint8_t> features_;
+    std::vector<uint8_t> values_;
+    uint32_t valueCount_ = 0;
+    std::unordered_map<int, uint32_t> classValues_;
+    std::unordered_map<int, uint32_t> nameValues_;
+    std::unordered_map<uint32_t, uint32_t> confidenceValues_;  // By float bits
+
+    std::vector<uint32_t> tags_;
+    std::vector<uint32_t> geometry_;
+    std::vector<uint8_t> feature_;
+    std::vector<uint8_t> scratch_;
+};
+
+// Drop repeated points (rounding merges close vertices) and the closing
+// copy of the first, then orient the ring clockwise. False if nothing
+// with area remains.
+bool CleanRing(std::vector<TilePoint>& ring) {
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    while (ring.size() > 1 && ring.back() == ring.front()) {
+        ring.pop_back();
+    }
+    if (ring.size() < 3) {
+        return false;
+    }
+    int64_t area = 0;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        area += int64_t(ring[j].x) * ring[i].y - int64_t(ring[i].x) * ring[j].y;
+    }
+    if (area == 0) {
+        return false;
+    }
+    if (area < 0) {
+        std::reverse(ring.begin(), ring.end());
+    }
+    return true;
+}
+
+std::string HashBytes(const std::vector<uint8_t>& data) {
+    // FNV-1a, like TileService::MakeSlideId
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : data) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream text;
+    text << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return text.str();
+}
+
+uint64_t CacheKey(int32_t level, int64_t column, int64_t row) {
+    return (static_cast<uint64_t>(level) << 56) | (static_cast<uint64_t>(column) << 28) |
+           static_cast<uint64_t>(row);
+}
+
+}  // namespace
+
+CellTileService::CellTileService(size_t encodedCacheBytes)
+    : capacity_(encodedCacheBytes)
+{
+}
+
+CellTileService::~CellTileService() {
+    ClearSource();
+}
+
+void CellTileService::SetSource(CellTileSource cells) {
+    auto next = std::make_shared<Source>();
+    next->cells = std::move(cells);
+    const PolygonStore& polygons = *next->cells.polygons;
+    for (uint32_t i = 0; i < polygons.Size(); ++i) {
+        next->maxPolygonSize = std::max({next->maxPolygonSize, polygons.GetMaxX(i) - polygons.GetMinX(i),
+                                         polygons.GetMaxY(i) - polygons.GetMinY(i)});
+    }
+
+    uint64_t epoch = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(sourceMutex_);
+        source_ = std::move(next);
+        epoch = ++epoch_;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    encoded_.clear();
+    lru_.clear();
+    cachedBytes_ = 0;
+    cacheEpoch_ = epoch;
+}
+
+void CellTileService::ClearSource() {
+    uint64_t epoch = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(sourceMutex_);
+        source_.reset();
+        epoch = ++epoch_;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    encoded_.clear();
+    lru_.clear();
+    cachedBytes_ = 0;
+    cacheEpoch_ = epoch;
+}
+
+bool CellTileService::HasSource() const {
+    std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+    return source_ != nullptr;
+}
+
+TileServiceStatus CellTileService::GetTile(const std::string& id, int32_t level, int64_t column, int64_t row,
+                                           EncodedTile& out) {
+    // Held until the tile is encoded: ClearSource() waits for it
+    std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+    if (!source_ || source_->cells.slideId != id) {
+        return TileServiceStatus::NotFound;
+    }
+    const CellTileSource& cells = source_->cells;
+    const int32_t maxLevel = TileService::GetMaxLevel(cells.width, cells.height);
+    if (level < 0 || level > maxLevel || column < 0 || row < 0) {
+        return TileServiceStatus::NotFound;
+    }
+    const int64_t span = int64_t{TileService::TILE_SIZE} << (maxLevel - level);
+    // Divided, not multiplied: column and row come from the URL
+    if (column >= (cells.width + span - 1) / span || row >= (cells.height + span - 1) / span) {
+        return TileServiceStatus::NotFound;
+    }
+
+    const uint64_t key = CacheKey(level, column, row);
+    if (LookupEncoded(key, epoch_, out)) {
+        encodedHits_++;
+        return TileServiceStatus::Ok;
+    }
+    encodedMisses_++;
+
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    EncodeTile(*source_, double(column * span), double(row * span), double(span), *data);
+    out.etag = "\"" + cells.slideId + "-cells-" + HashBytes(*data) + "\"";
+    out.mimeType = MIME_TYPE;
+    out.data = std::move(data);
+    StoreEncoded(key, epoch_, out);
+    return TileServiceStatus::Ok;
+}
+
+void CellTileService::EncodeTile(const Source& source, double x0, double y0, double span,
+                                 std::vector<uint8_t>& out) {
+    out.clear();
+    const CellTileSource& cells = source.cells;
+    const double tilePixels = TileService::TILE_SIZE / span;  // Per level 0 pixel
+    if (!cells.index || source.maxPolygonSize * tilePixels < cells.lod.minScreenSizePixels) {
+        return;  // No cell is drawn this coarse
+    }
+
+    std::vector<uint32_t> found;
+    cells.index->QueryRegion(Rect(x0, y0, span, span), found);
+    std::sort(found.begin(), found.end());  // Same bytes, and ETag, whatever the index order
+
+    const PolygonStore& polygons = *cells.polygons;
+    const double scale = EXTENT / span;
+    auto toTile = [&](double x, double y) {
+        return TilePoint{static_cast<int32_t>(std::lround((x - x0) * scale)),
+                         static_cast<int32_t>(std::lround((y - y0) * scale))};
+    };
+
+    LayerWriter layer(cells.classNames);
+    std::vector<TilePoint> ring;
+    std::vector<uint32_t> kept;
+    for (uint32_t polygon : found) {
+        const double screenSize = std::max(polygons.GetMaxX(polygon) - polygons.GetMinX(polygon),
+                                           polygons.GetMaxY(polygon) - polygons.GetMinY(polygon)) * tilePixels;
+        const LODLevel lod = cells.lod.Classify(screenSize);
+        if (lod == LODLevel::SKIP) {
+            continue;
+        }
+        const int classId = polygons.GetClassId(polygon);
+        const float confidence = polygons.GetConfidence(polygon);
+
+        ring.clear();
+        if (lod == LODLevel::BOX) {
+            ring.push_back(toTile(polygons.GetMinX(polygon), polygons.GetMinY(polygon)));
+            ring.push_back(toTile(polygons.GetMaxX(polygon), polygons.GetMinY(polygon)));
+            ring.push_back(toTile(polygons.GetMaxX(polygon), polygons.GetMaxY(polygon)));
+            ring.push_back(toTile(polygons.GetMinX(polygon), polygons.GetMaxY(polygon)));
+        } else if (lod != LODLevel::POINT) {
+            const Vec2f* vertices = polygons.GetVertices(polygon);
+            const uint32_t vertexCount = polygons.GetVertexCount(polygon);
+
+            // The simplified triangles index the vertices Douglas-Peucker
+            // kept; in index order they are the simplified outline
+            kept.clear();
+            if (lod == LODLevel::SIMPLIFIED) {
+                uint32_t count = 0;
+                const uint32_t* triangles = polygons.GetSimplifiedTriangles(polygon, count);
+                kept.assign(triangles, triangles + count);
+                std::sort(kept.begin(), kept.end());
+                kept.erase(std::unique(kept.begin(), kept.end()), kept.end());
+            }
+            if (kept.size() >= 3) {
+                for (uint32_t vertex : kept) {
+                    ring.push_back(toTile(vertices[vertex].x, vertices[vertex].y));
+                }
+            } else {
+                for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+                    ring.push_back(toTile(vertices[vertex].x, vertices[vertex].y));
+                }
+            }
+        }
+
+        if (!ring.empty() && CleanRing(ring)) {
+            layer.AddPolygon(polygon, classId, confidence, ring);
+        } else {
+            // Points, and outlines rounding to nothing
+            const Vec2 centroid = polygons.GetCentroid(polygon);
+            layer.AddPoint(polygon, classId, confidence, toTile(centroid.x, centroid.y));
+        }
+    }
+    if (!layer.Empty()) {
+        layer.Finish(out);
+    }
+}
+
+bool CellTileService::LookupEncoded(uint64_t key, uint64_t epoch, EncodedTile& out) {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (epoch != cacheEpoch_) {
+        return false;
+    }
+    auto it = encoded_.find(key);
+    if (it == encoded_.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    out = it->second.tile;
+    return true;
+}
+
+void CellTileService::StoreEncoded(uint64_t key, uint64_t epoch, const EncodedTile& tile) {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (epoch != cacheEpoch_ || tile.data->size() > capacity_ || encoded_.count(key)) {
+        return;  // Source changed meanwhile, too large, or a concurrent request stored it
+    }
+    lru_.push_front(key);
+    encoded_.emplace(key, CachedTile{tile, lru_.begin()});
+    cachedBytes_ += tile.data->size();
+    while (cachedBytes_ > capacity_ && !lru_.empty()) {
+        auto it = encoded_.find(lru_.back());
+        cachedBytes_ -= it->second.tile.data->size();
+        encoded_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+size_t CellTileService::GetEncodedCacheBytes() const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cachedBytes_;
+}
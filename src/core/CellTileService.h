@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PolygonLod.h"
+#include "TileService.h"  // For EncodedTile and TileServiceStatus
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+class PolygonIndex;
+class PolygonStore;
+
+// The loaded cell polygons as the cell tile service sees them. The store
+// and index are read on HTTP threads: they must not change until
+// CellTileService::ClearSource() has returned.
+struct CellTileSource {
+    std::string slideId;     // Slide id in URLs, see TileService::MakeSlideId
+    int64_t width = 0;       // Level 0
+    int64_t height = 0;
+    const PolygonStore* polygons = nullptr;
+    const PolygonIndex* index = nullptr;
+    std::map<int, std::string> classNames;
+    PolygonLod lod;
+};
+
+// Cell polygons as Mapbox Vector Tiles (MVT 2.1) on the DeepZoom grid of
+// TileService, for browser viewers to draw the cells over the slide tiles.
+//
+// A tile is made on demand from a spatial index query over its area. Each
+// cell is written at the detail PolygonOverlay would draw it with when the
+// tile is shown at its own resolution (PolygonLod): too small ones are
+// left out, then points, boxes, the simplified outline (the vertices
+// PolygonStore's simplified triangulation keeps) and the full outline.
+// Features carry the cell's store index as id and "class", "class_name"
+// and "confidence" tags, in one layer named LAYER_NAME of EXTENT units.
+// Levels too coarse for any cell to reach minScreenSizePixels are empty
+// without a query. Encoded tiles are kept in an LRU cache of
+// ENCODED_CACHE_BYTES; ETags hash the bytes, so a browser revalidates
+// once new polygons are loaded.
+//
+// Thread-safe: HTTP handler threads call GetTile concurrently while the
+// GUI thread swaps the polygons.
+class CellTileService {
+public:
+    explicit CellTileService(size_t encodedCacheBytes = ENCODED_CACHE_BYTES);
+    ~CellTileService();
+
+    CellTileService(const CellTileService&) = delete;
+    CellTileService& operator=(const CellTileService&) = delete;
+
+    // Serve new polygons, or none. ClearSource returns only once no request
+    // is reading the old store and index, so they may change right after.
+    void SetSource(CellTileSource source);
+    void ClearSource();
+    bool HasSource() const;
+
+    // Tile column, row of a DeepZoom level (see TileService::GetTile); an
+    // empty tile has no bytes
+    TileServiceStatus GetTile(const std::string& id, int32_t level, int64_t column, int64_t row,
+                              EncodedTile& out);
+
+    // Statistics
+    size_t GetEncodedCacheBytes() const;
+    size_t GetEncodedHitCount() const { return encodedHits_.load(); }
+    size_t GetEncodedMissCount() const { return encodedMisses_.load(); }
+
+    static constexpr const char* MIME_TYPE = "application/vnd.mapbox-vector-tile";
+    static constexpr const char* LAYER_NAME = "cells";
+    static constexpr uint32_t EXTENT = 4096;
+    static constexpr size_t ENCODED_CACHE_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct Source {
+        CellTileSource cells;
+        float maxPolygonSize = 0.0f;  // Largest box side, level 0 pixels
+    };
+
+    struct CachedTile {
+        EncodedTile tile;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    // Encode the tile covering level 0 [x0, x0 + span) x [y0, y0 + span)
+    static void EncodeTile(const Source& source, double x0, double y0, double span,
+                           std::vector<uint8_t>& out);
+
+    // Encoded cache, keyed by level, column and row of the current source
+    bool LookupEncoded(uint64_t key, uint64_t epoch, EncodedTile& out);
+    void StoreEncoded(uint64_t key, uint64_t epoch, const EncodedTile& tile);
+
+    // Current polygons. Requests hold sourceMutex_ shared while encoding;
+    // swapping them takes it exclusively.
+    mutable std::shared_mutex sourceMutex_;
+    std::shared_ptr<const Source> source_;
+    uint64_t epoch_ = 0;  // Bumped with every source change
+
+    mutable std::mutex cacheMutex_;
+    std::unordered_map<uint64_t, CachedTile> encoded_;
+    std::list<uint64_t> lru_;  // Most recent first
+    uint64_t cacheEpoch_ = 0;
+    size_t cachedBytes_ = 0;
+    size_t capacity_;
+
+    std::atomic<size_t> encodedHits_{0};
+    std::atomic<size_t> encodedMisses_{0};
+};
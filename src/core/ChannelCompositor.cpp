@@ -0,0 +1,111 @@
+#include "ChannelCompositor.h"
+#include "SlideLoader.h"
+#include "Log.h"
+#include <algorithm>
+
+ChannelCompositor::ChannelCompositor(const SlideLoader& slide, SDL_Renderer* renderer,
+                                     const RendererFactory& createRenderer)
+    : renderer_(renderer)
+{
+    for (size_t i = 0; i < slide.GetChannelCount(); ++i) {
+        Channel channel;
+        channel.loader = slide.OpenChannel(i);
+        if (!channel.loader) {
+            PATHVIEW_LOG_ERROR("ChannelCompositor: Cannot open channel " << i);
+            continue;
+        }
+        channel.renderer = createRenderer(channel.loader.get());
+        channel.name = slide.GetChannelName(i);
+        channel.color = slide.GetChannelColor(i);
+        channels_.push_back(std::move(channel));
+    }
+}
+
+ChannelCompositor::~ChannelCompositor() = default;
+
+void ChannelCompositor::SetColor(size_t channel, uint32_t color) {
+    if (channel < channels_.size() && channels_[channel].color != color) {
+        channels_[channel].color = color;
+        revision_++;
+    }
+}
+
+void ChannelCompositor::SetGain(size_t channel, float gain) {
+    gain = std::max(0.0f, std::min(gain, SlideRenderer::MAX_CHANNEL_GAIN));
+    if (channel < channels_.size() && channels_[channel].gain != gain) {
+        channels_[channel].gain = gain;
+        revision_++;
+    }
+}
+
+void ChannelCompositor::SetVisible(size_t channel, bool visible) {
+    if (channel < channels_.size() && channels_[channel].visible != visible) {
+        channels_[channel].visible = visible;
+        revision_++;
+    }
+}
+
+void ChannelCompositor::SetTileReadyCallback(const std::function<void()>& callback) {
+    for (Channel& channel : channels_) {
+        channel.renderer->SetTileReadyCallback(callback);
+    }
+}
+
+void ChannelCompositor::SetProfiler(FrameProfiler* profiler) {
+    for (Channel& channel : channels_) {
+        channel.renderer->SetProfiler(profiler);
+    }
+}
+
+void ChannelCompositor::SetLevelSelection(LevelSelection mode) {
+    for (Channel& channel : channels_) {
+        channel.renderer->SetLevelSelection(mode);
+    }
+}
+
+void ChannelCompositor::SetRenderScale(double still, double moving) {
+    for (Channel& channel : channels_) {
+        channel.renderer->SetRenderScale(still, moving);
+    }
+}
+
+void ChannelCompositor::Detach() {
+    for (Channel& channel : channels_) {
+        channel.renderer->Detach();
+    }
+}
+
+bool ChannelCompositor::IsDetached() const {
+    return std::all_of(channels_.begin(), channels_.end(),
+                       [](const Channel& channel) { return channel.renderer->IsDetached(); });
+}
+
+void ChannelCompositor::Render(const std::vector<RenderView>& views) {
+    // Channels add onto black (the clip rectangle, if any, still applies)
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(renderer_, &r, &g, &b, &a);
+    SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+    for (const RenderView& view : views) {
+        bool pane = view.screenRect.w > 0 && view.screenRect.h > 0;
+        SDL_RenderFillRect(renderer_, pane ? &view.screenRect : nullptr);
+    }
+    SDL_SetRenderDrawColor(renderer_, r, g, b, a);
+
+    for (Channel& channel : channels_) {
+        if (!channel.visible || channel.gain <= 0.0f) {
+            continue;
+        }
+        channel.renderer->SetChannelStyle(channel.color, channel.gain);
+        channel.renderer->Render(views);
+    }
+}
+
+size_t ChannelCompositor::GetUncoveredTileCount() const {
+    size_t uncovered = 0;
+    for (const Channel& channel : channels_) {
+        if (channel.visible && channel.gain > 0.0f) {
+            uncovered += channel.renderer->GetUncoveredTileCount();
+        }
+    }
+    return uncovered;
+}
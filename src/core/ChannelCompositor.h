@@ -0,0 +1,76 @@
+#pragma once
+
+#include "SlideRenderer.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SlideLoader;
+class FrameProfiler;
+
+// Fluorescence view of a multichannel slide. Every channel is a slide of
+// its own (see SlideLoader::OpenChannel) with its own SlideRenderer on the
+// shared decode pool and tile cache, so its tiles are decoded, cached and
+// uploaded once, as grey intensity. Render() adds the visible channels onto
+// black, each tinted its colour and scaled by its gain (see
+// SlideRenderer::SetChannelStyle): changing either redraws from resident
+// textures without decoding or uploading anything again.
+class ChannelCompositor {
+public:
+    // Renderer for one channel's loader, joined to the shared pipeline
+    using RendererFactory = std::function<std::unique_ptr<SlideRenderer>(SlideLoader*)>;
+
+    ChannelCompositor(const SlideLoader& slide, SDL_Renderer* renderer, const RendererFactory& createRenderer);
+    ~ChannelCompositor();
+
+    ChannelCompositor(const ChannelCompositor&) = delete;
+    ChannelCompositor& operator=(const ChannelCompositor&) = delete;
+
+    size_t GetChannelCount() const { return channels_.size(); }
+    const std::string& GetName(size_t channel) const { return channels_[channel].name; }
+
+    // 0xRRGGBB
+    uint32_t GetColor(size_t channel) const { return channels_[channel].color; }
+    void SetColor(size_t channel, uint32_t color);
+
+    // Intensity scale, 0 to SlideRenderer::MAX_CHANNEL_GAIN
+    float GetGain(size_t channel) const { return channels_[channel].gain; }
+    void SetGain(size_t channel, float gain);
+
+    bool IsVisible(size_t channel) const { return channels_[channel].visible; }
+    void SetVisible(size_t channel, bool visible);
+
+    // Bumped by every change to colour, gain or visibility
+    uint64_t GetRevision() const { return revision_; }
+
+    // Forwarded to every channel's renderer
+    void SetTileReadyCallback(const std::function<void()>& callback);
+    void SetProfiler(FrameProfiler* profiler);
+    void SetLevelSelection(LevelSelection mode);
+    void SetRenderScale(double still, double moving);
+    void Detach();
+    bool IsDetached() const;
+
+    void Render(const std::vector<RenderView>& views);
+
+    // Visible tiles of the visible channels the last Render() could not
+    // draw at their own level
+    size_t GetUncoveredTileCount() const;
+
+private:
+    struct Channel {
+        std::unique_ptr<SlideLoader> loader;
+        std::unique_ptr<SlideRenderer> renderer;  // Declared after loader: destroyed first
+        std::string name;
+        uint32_t color = 0xFFFFFF;
+        float gain = 1.0f;
+        bool visible = true;
+    };
+
+    SDL_Renderer* renderer_;
+    std::vector<Channel> channels_;
+    uint64_t revision_ = 0;
+};
@@ -0,0 +1,126 @@
+#include "ClassNameTable.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr size_t MIN_SLOTS = 16;
+
+size_t SlotsFor(size_t count) {
+    size_t slots = MIN_SLOTS;
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+}  // namespace
+
+uint64_t ClassNameTable::Hash(std::string_view name, uint64_t seed) {
+    // FNV-1a from a seeded basis, then a final mix so the low bits (the
+    // slot) depend on every byte
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint32_t ClassNameTable::Intern(std::string_view name) {
+    uint32_t index = Find(name);
+    if (index != NOT_FOUND) {
+        return index;
+    }
+    index = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    if (frozen_ || slots_.size() < SlotsFor(names_.size())) {
+        Rehash(SlotsFor(names_.size()));
+        return index;
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t slot = Hash(name, seed_) & mask;
+    while (slots_[slot] != EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    slots_[slot] = index;
+    return index;
+}
+
+uint32_t ClassNameTable::Find(std::string_view name) const {
+    if (slots_.empty()) {
+        return NOT_FOUND;
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t slot = Hash(name, seed_) & mask;
+    if (frozen_) {
+        const uint32_t index = slots_[slot];
+        return index != EMPTY && names_[index] == name ? index : NOT_FOUND;
+    }
+    for (uint32_t index; (index = slots_[slot]) != EMPTY; slot = (slot + 1) & mask) {
+        if (names_[index] == name) {
+            return index;
+        }
+    }
+    return NOT_FOUND;
+}
+
+bool ClassNameTable::Freeze() {
+    if (frozen_) {
+        return true;
+    }
+    std::vector<uint32_t> slots;
+    for (size_t slotCount = SlotsFor(names_.size()); slotCount <= MAX_FROZEN_SLOTS; slotCount *= 2) {
+        const size_t mask = slotCount - 1;
+        for (uint64_t seed = 1; seed <= SEEDS_PER_SIZE; ++seed) {
+            slots.assign(slotCount, EMPTY);
+            bool collided = false;
+            for (uint32_t i = 0; i < names_.size() && !collided; ++i) {
+                uint32_t& slot = slots[Hash(names_[i], seed) & mask];
+                collided = slot != EMPTY;
+                slot = i;
+            }
+            if (!collided) {
+                slots_ = std::move(slots);
+                seed_ = seed;
+                frozen_ = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<int> ClassNameTable::SortedIds() const {
+    std::vector<uint32_t> order(names_.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return names_[a] < names_[b]; });
+    std::vector<int> ids(names_.size());
+    for (size_t rank = 0; rank < order.size(); ++rank) {
+        ids[order[rank]] = static_cast<int>(rank);
+    }
+    return ids;
+}
+
+void ClassNameTable::Clear() {
+    names_.clear();
+    slots_.clear();
+    seed_ = 0;
+    frozen_ = false;
+}
+
+void ClassNameTable::Rehash(size_t slotCount) {
+    frozen_ = false;
+    seed_ = 0;
+    slots_.assign(slotCount, EMPTY);
+    const size_t mask = slotCount - 1;
+    for (uint32_t i = 0; i < names_.size(); ++i) {
+        size_t slot = Hash(names_[i], seed_) & mask;
+        while (slots_[slot] != EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = i;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Cell type names interned to dense indices, in the order first seen, for
+// loaders that look a type up for every cell of a file.
+//
+// While a file is scanned Intern() adds names to an open-addressed table
+// (linear probing). A file has tens of types and millions of cells, so
+// once they are all known Freeze() searches for a hash seed and a table
+// size that give every name a slot of its own: a perfect hash, with which
+// Find() is one hash, one slot read and one compare, whatever the name.
+// Interning a new name afterwards falls back to probing.
+class ClassNameTable {
+public:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    // Index of name, added after the others if new
+    uint32_t Intern(std::string_view name);
+
+    // Index of name, or NOT_FOUND
+    uint32_t Find(std::string_view name) const;
+
+    /**
+     * Rebuild the slots collision-free for the names interned so far
+     * @return false if no seed was found within MAX_FROZEN_SLOTS (the
+     *         table still works, by probing)
+     */
+    bool Freeze();
+    bool IsFrozen() const { return frozen_; }
+
+    size_t Size() const { return names_.size(); }
+    bool Empty() const { return names_.empty(); }
+    const std::string& GetName(uint32_t index) const { return names_[index]; }
+    const std::vector<std::string>& GetNames() const { return names_; }
+
+    /**
+     * Class ID of each name by index: its rank among the names in sorted
+     * order, the IDs PolygonLoader::BuildClassMapping gives the same set
+     */
+    std::vector<int> SortedIds() const;
+
+    void Clear();
+
+    // Seeds tried per table size before Freeze() doubles it
+    static constexpr uint32_t SEEDS_PER_SIZE = 16;
+    static constexpr size_t MAX_FROZEN_SLOTS = size_t(1) << 20;
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static uint64_t Hash(std::string_view name, uint64_t seed);
+    // Place every name by probing into slots of the given count
+    void Rehash(size_t slotCount);
+
+    std::vector<std::string> names_;
+    std::vector<uint32_t> slots_;  // Name index or EMPTY; a power of two long
+    uint64_t seed_ = 0;
+    bool frozen_ = false;
+};
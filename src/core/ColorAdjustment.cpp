@@ -0,0 +1,128 @@
+#include "ColorAdjustment.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+uint8_t ToByte(float value) {
+    return static_cast<uint8_t>(std::lround(std::max(0.0f, std::min(value, 1.0f)) * 255.0f));
+}
+
+// Push a pass unless every channel's amount rounds to nothing
+void AddPass(std::vector<ColorAdjustment::Pass>& passes, ColorAdjustment::Pass::Op op, const float amount[3],
+             uint8_t identity) {
+    ColorAdjustment::Pass pass{op, {ToByte(amount[0]), ToByte(amount[1]), ToByte(amount[2])}};
+    if (pass.color[0] != identity || pass.color[1] != identity || pass.color[2] != identity) {
+        passes.push_back(pass);
+    }
+}
+
+// Add the positive amounts, subtract the negative ones
+void AddBias(std::vector<ColorAdjustment::Pass>& passes, const float bias[3]) {
+    float positive[3];
+    float negative[3];
+    for (int c = 0; c < 3; ++c) {
+        positive[c] = std::max(0.0f, bias[c]);
+        negative[c] = std::max(0.0f, -bias[c]);
+    }
+    AddPass(passes, ColorAdjustment::Pass::Op::Add, positive, 0);
+    AddPass(passes, ColorAdjustment::Pass::Op::Subtract, negative, 0);
+}
+
+}  // namespace
+
+bool ColorAdjustment::IsIdentity() const {
+    return brightness == 0.0f && contrast == 1.0f && gain[0] == 1.0f && gain[1] == 1.0f && gain[2] == 1.0f;
+}
+
+std::vector<ColorAdjustment::Pass> ColorAdjustment::Plan() const {
+    // out = scale * in + offset per channel
+    float scale[3];
+    float offset[3];
+    for (int c = 0; c < 3; ++c) {
+        scale[c] = std::max(0.0f, std::min(gain[c] * contrast, MAX_SCALE));
+        offset[c] = gain[c] * (0.5f - 0.5f * contrast + brightness);
+    }
+
+    // Scales above 1 take their bias first, as scale * (in + offset /
+    // scale): the multiply saturates exactly where the result would. Scales
+    // up to 1 never saturate, so their bias comes last.
+    float before[3] = {0.0f, 0.0f, 0.0f};
+    float after[3] = {0.0f, 0.0f, 0.0f};
+    float multiply[3] = {1.0f, 1.0f, 1.0f};
+    float remaining[3] = {1.0f, 1.0f, 1.0f};
+    for (int c = 0; c < 3; ++c) {
+        if (scale[c] > 1.0f) {
+            before[c] = offset[c] / scale[c];
+            remaining[c] = scale[c];
+        } else {
+            multiply[c] = scale[c];
+            after[c] = offset[c];
+        }
+    }
+
+    std::vector<Pass> passes;
+    AddBias(passes, before);
+    AddPass(passes, Pass::Op::Multiply, multiply, 255);
+    // At most doubling per pass: the source colour stops at 1
+    while (std::max({remaining[0], remaining[1], remaining[2]}) > 1.0f + 1.0f / 255.0f) {
+        float factor[3];
+        for (int c = 0; c < 3; ++c) {
+            float step = std::min(remaining[c], 2.0f);
+            factor[c] = step - 1.0f;
+            remaining[c] /= step;
+        }
+        AddPass(passes, Pass::Op::Scale, factor, 0);
+    }
+    AddBias(passes, after);
+    return passes;
+}
+
+bool ColorAdjustment::Apply(SDL_Renderer* renderer, const SDL_Rect* rect) const {
+    std::vector<Pass> passes = Plan();
+    if (passes.empty()) {
+        return true;
+    }
+
+    const SDL_BlendMode scaleMode = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_DST_COLOR, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD);
+    const SDL_BlendMode subtractMode = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_REV_SUBTRACT,
+        SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD);
+    auto blendMode = [&](Pass::Op op) {
+        switch (op) {
+            case Pass::Op::Multiply: return SDL_BLENDMODE_MOD;
+            case Pass::Op::Scale: return scaleMode;
+            case Pass::Op::Add: return SDL_BLENDMODE_ADD;
+            case Pass::Op::Subtract: return subtractMode;
+        }
+        return SDL_BLENDMODE_NONE;
+    };
+
+    SDL_BlendMode previousMode = SDL_BLENDMODE_NONE;
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawBlendMode(renderer, &previousMode);
+    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+    // All or nothing: half a plan is further off than none
+    bool supported = true;
+    for (const Pass& pass : passes) {
+        if (SDL_SetRenderDrawBlendMode(renderer, blendMode(pass.op)) != 0) {
+            supported = false;
+            break;
+        }
+    }
+    if (supported) {
+        for (const Pass& pass : passes) {
+            SDL_SetRenderDrawBlendMode(renderer, blendMode(pass.op));
+            SDL_SetRenderDrawColor(renderer, pass.color[0], pass.color[1], pass.color[2], 255);
+            SDL_RenderFillRect(renderer, rect);
+        }
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, previousMode);
+    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    return supported;
+}
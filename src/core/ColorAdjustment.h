@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Brightness, contrast and per-channel gain of the drawn slide, applied to
+// what is already on the render target, once per frame: no tile is decoded
+// or uploaded again when they change. Each channel becomes
+//
+//   out = gain * ((in - 0.5) * contrast + 0.5 + brightness)
+//
+// clamped to [0, 1]. SDL_Renderer has no shader stage, so the affine map is
+// split into blended rectangles (see Plan): multiplies (MOD), scales above
+// 1 (dst * src + dst) and biases (ADD, or a reverse subtract), ordered so
+// the render target's clamping after each pass gives the clamped result.
+class ColorAdjustment {
+public:
+    float brightness = 0.0f;  // -1 to 1, added after contrast
+    float contrast = 1.0f;    // 0 to MAX_SCALE, around mid grey
+    float gain[3] = {1.0f, 1.0f, 1.0f};  // Red, green, blue
+
+    static constexpr float MAX_SCALE = 8.0f;
+
+    bool IsIdentity() const;
+
+    // One blended rectangle: each channel of the target becomes
+    //   Multiply  dst * c
+    //   Scale     dst * (1 + c)
+    //   Add       dst + c
+    //   Subtract  dst - c
+    // with c the pass's 8-bit colour / 255
+    struct Pass {
+        enum class Op : uint8_t { Multiply, Scale, Add, Subtract };
+        Op op;
+        uint8_t color[3];
+    };
+    std::vector<Pass> Plan() const;
+
+    // Draw the plan over rect of the current target (nullptr: all of it).
+    // False if the renderer lacks a blend mode the plan needs (the
+    // software renderer has no custom ones); nothing is drawn then.
+    bool Apply(SDL_Renderer* renderer, const SDL_Rect* rect) const;
+};
@@ -0,0 +1,115 @@
+#include "CompressedTileCache.h"
+#include "TileCodec.h"
+
+CompressedTileCache::CompressedTileCache(size_t maxBytes)
+    : maxBytes_(maxBytes)
+{
+}
+
+void CompressedTileCache::SetMaxBytes(size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxBytes_ = maxBytes;
+    EvictLocked(maxBytes);
+}
+
+bool CompressedTileCache::Load(const TileKey& key, uint32_t* pixels, size_t capacity,
+                               int32_t* outWidth, int32_t* outHeight) {
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            missCount_++;
+            return false;
+        }
+        lruList_.splice(lruList_.begin(), lruList_, it->second.lruIterator);
+        data = it->second.data;
+    }
+
+    if (!TileCodec::Decompress(data->data(), data->size(), pixels, capacity, outWidth, outHeight)) {
+        missCount_++;
+        return false;
+    }
+    hitCount_++;
+    return true;
+}
+
+void CompressedTileCache::Store(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height) {
+    if (!IsEnabled() || !pixels || width <= 0 || height <= 0 || HasTile(key)) {
+        return;
+    }
+
+    // Encode into a per-worker scratch buffer sized for the worst case, then
+    // keep an exact-size copy
+    thread_local std::vector<uint8_t> scratch;
+    TileCodec::Compress(pixels, width, height, scratch);
+    size_t rawBytes = static_cast<size_t>(width) * height * sizeof(uint32_t);
+    if (scratch.size() >= rawBytes) {
+        return;
+    }
+    auto data = std::make_shared<const std::vector<uint8_t>>(scratch.begin(), scratch.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data->size() > maxBytes_ || entries_.count(key)) {
+        return;  // Budget lowered, or another worker stored it meanwhile
+    }
+    EvictLocked(maxBytes_ - data->size());
+
+    lruList_.push_front(key);
+    memoryUsage_ += data->size();
+    rawBytes_ += rawBytes;
+    entries_.emplace(key, Entry{std::move(data), rawBytes, lruList_.begin()});
+}
+
+bool CompressedTileCache::HasTile(const TileKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(key) > 0;
+}
+
+void CompressedTileCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lruList_.clear();
+    memoryUsage_ = 0;
+    rawBytes_ = 0;
+}
+
+size_t CompressedTileCache::RemoveSlide(uint32_t slide) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t before = memoryUsage_;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->first.slide != slide) {
+            ++it;
+            continue;
+        }
+        memoryUsage_ -= it->second.data->size();
+        rawBytes_ -= it->second.rawBytes;
+        lruList_.erase(it->second.lruIterator);
+        it = entries_.erase(it);
+    }
+    return before - memoryUsage_;
+}
+
+size_t CompressedTileCache::Trim(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t before = memoryUsage_;
+    EvictLocked(before > bytes ? before - bytes : 0);
+    return before - memoryUsage_;
+}
+
+size_t CompressedTileCache::GetTileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void CompressedTileCache::EvictLocked(size_t targetBytes) {
+    while (!lruList_.empty() && memoryUsage_ > targetBytes) {
+        auto it = entries_.find(lruList_.back());
+        if (it != entries_.end()) {
+            memoryUsage_ -= it->second.data->size();
+            rawBytes_ -= it->second.rawBytes;
+            entries_.erase(it);
+        }
+        lruList_.pop_back();
+    }
+}
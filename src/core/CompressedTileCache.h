@@ -0,0 +1,86 @@
+#pragma once
+
+#include "FlatTileMap.h"
+#include "TextureManager.h"  // For TileKey
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// In-RAM tier behind TileCache that holds tiles compressed with TileCodec.
+//
+// Decode workers store every tile they build here (write-through, as with
+// DiskTileCache), so a tile the pixel tier evicts is still a quick
+// decompress away instead of a JPEG decode when the review comes back to
+// it. Compressed tiles cost a fraction of their 4 bytes per pixel, which
+// multiplies the number of tiles kept in RAM for the same budget.
+//
+// Thread-safe. Compression and decompression run outside the lock, on the
+// calling worker; the lock only covers the index and LRU list. A budget of
+// 0 disables the tier.
+class CompressedTileCache {
+public:
+    explicit CompressedTileCache(size_t maxBytes = 0);
+
+    CompressedTileCache(const CompressedTileCache&) = delete;
+    CompressedTileCache& operator=(const CompressedTileCache&) = delete;
+
+    bool IsEnabled() const { return maxBytes_ > 0; }
+
+    // Evicts least recently used tiles over a lower budget
+    void SetMaxBytes(size_t maxBytes);
+
+    // Decompress a tile into pixels (capacity in pixels). Returns false on
+    // miss or if the tile does not fit.
+    bool Load(const TileKey& key, uint32_t* pixels, size_t capacity,
+              int32_t* outWidth, int32_t* outHeight);
+
+    // Compress and keep a tile unless it is already held; tiles that do
+    // not shrink are skipped
+    void Store(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height);
+
+    bool HasTile(const TileKey& key) const;
+    void Clear();
+
+    // Drop every tile of one slide (TileKey::slide). Returns the bytes freed.
+    size_t RemoveSlide(uint32_t slide);
+
+    // Evict least recently used tiles until at least bytes are freed.
+    // Returns the bytes freed.
+    size_t Trim(size_t bytes);
+
+    // Statistics
+    size_t GetTileCount() const;
+    size_t GetMemoryUsage() const { return memoryUsage_.load(); }
+    size_t GetRawBytes() const { return rawBytes_.load(); }  // Held tiles' decoded size
+    size_t GetMaxBytes() const { return maxBytes_; }
+    size_t GetHitCount() const { return hitCount_.load(); }
+    size_t GetMissCount() const { return missCount_.load(); }
+    double GetCompressionRatio() const {
+        size_t usage = memoryUsage_.load();
+        return usage > 0 ? static_cast<double>(rawBytes_.load()) / usage : 0.0;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const std::vector<uint8_t>> data;  // Shared so Load decodes unlocked
+        size_t rawBytes;
+        std::list<TileKey>::iterator lruIterator;
+    };
+
+    // Requires mutex_ to be held
+    void EvictLocked(size_t targetBytes);
+
+    std::atomic<size_t> maxBytes_;
+
+    mutable std::mutex mutex_;
+    FlatTileMap<Entry> entries_;
+    std::list<TileKey> lruList_;  // Front = most recent
+
+    std::atomic<size_t> memoryUsage_{0};
+    std::atomic<size_t> rawBytes_{0};
+    std::atomic<size_t> hitCount_{0};
+    std::atomic<size_t> missCount_{0};
+};
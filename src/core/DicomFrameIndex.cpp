@@ -0,0 +1,522 @@
+#include "DicomFrameIndex.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+constexpr uint32_t Tag(uint16_t group, uint16_t element) {
+    return (static_cast<uint32_t>(group) << 16) | element;
+}
+
+constexpr uint32_t TAG_TRANSFER_SYNTAX = Tag(0x0002, 0x0010);
+constexpr uint32_t TAG_IMAGE_TYPE = Tag(0x0008, 0x0008);
+constexpr uint32_t TAG_SERIES_UID = Tag(0x0020, 0x000E);
+constexpr uint32_t TAG_DIMENSION_ORGANIZATION = Tag(0x0020, 0x9311);
+constexpr uint32_t TAG_SAMPLES_PER_PIXEL = Tag(0x0028, 0x0002);
+constexpr uint32_t TAG_PHOTOMETRIC = Tag(0x0028, 0x0004);
+constexpr uint32_t TAG_NUMBER_OF_FRAMES = Tag(0x0028, 0x0008);
+constexpr uint32_t TAG_ROWS = Tag(0x0028, 0x0010);
+constexpr uint32_t TAG_COLUMNS = Tag(0x0028, 0x0011);
+constexpr uint32_t TAG_BITS_ALLOCATED = Tag(0x0028, 0x0100);
+constexpr uint32_t TAG_IMAGED_WIDTH = Tag(0x0048, 0x0001);
+constexpr uint32_t TAG_IMAGED_HEIGHT = Tag(0x0048, 0x0002);
+constexpr uint32_t TAG_TOTAL_COLUMNS = Tag(0x0048, 0x0006);
+constexpr uint32_t TAG_TOTAL_ROWS = Tag(0x0048, 0x0007);
+constexpr uint32_t TAG_EXTENDED_OFFSET_TABLE = Tag(0x7FE0, 0x0001);
+constexpr uint32_t TAG_EXTENDED_OFFSET_LENGTHS = Tag(0x7FE0, 0x0002);
+constexpr uint32_t TAG_PIXEL_DATA = Tag(0x7FE0, 0x0010);
+constexpr uint32_t TAG_ITEM = Tag(0xFFFE, 0xE000);
+constexpr uint32_t TAG_ITEM_DELIMITER = Tag(0xFFFE, 0xE00D);
+constexpr uint32_t TAG_SEQUENCE_DELIMITER = Tag(0xFFFE, 0xE0DD);
+
+constexpr uint32_t UNDEFINED_LENGTH = 0xFFFFFFFF;
+constexpr size_t PREAMBLE_BYTES = 128;
+constexpr uint32_t ITEM_HEADER_BYTES = 8;
+
+// Guards against corrupt or hostile files
+constexpr uint32_t MAX_VALUE_BYTES = 64 * 1024;  // Text and numbers kept
+constexpr int MAX_NESTING = 16;
+
+const char* const JPEG_BASELINE = "1.2.840.10008.1.2.4.50";
+// Encodings the parser does not read
+const char* const IMPLICIT_VR_LITTLE_ENDIAN = "1.2.840.10008.1.2";
+const char* const EXPLICIT_VR_BIG_ENDIAN = "1.2.840.10008.1.2.2";
+const char* const DEFLATED_EXPLICIT_VR = "1.2.840.10008.1.2.1.99";
+
+class DicomStream {
+public:
+    explicit DicomStream(const std::string& path) : file_(path, std::ios::binary) {}
+
+    bool IsOpen() const { return file_.is_open(); }
+    bool Read(void* data, size_t size) {
+        file_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        return static_cast<size_t>(file_.gcount()) == size;
+    }
+    bool Skip(uint64_t size) {
+        file_.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+        return static_cast<bool>(file_);
+    }
+    bool Seek(uint64_t offset) {
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(offset));
+        return static_cast<bool>(file_);
+    }
+    uint64_t Tell() { return static_cast<uint64_t>(file_.tellg()); }
+
+    bool Read16(uint16_t& value) {
+        uint8_t bytes[2];
+        if (!Read(bytes, sizeof(bytes))) {
+            return false;
+        }
+        value = static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+        return true;
+    }
+    bool Read32(uint32_t& value) {
+        uint8_t bytes[4];
+        if (!Read(bytes, sizeof(bytes))) {
+            return false;
+        }
+        value = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        return true;
+    }
+
+private:
+    std::ifstream file_;
+};
+
+struct Element {
+    uint32_t tag = 0;
+    char vr[2] = {' ', ' '};
+    uint32_t length = 0;
+
+    bool IsVr(const char* name) const { return vr[0] == name[0] && vr[1] == name[1]; }
+};
+
+// VRs with a 2-byte reserved field and a 4-byte length in explicit VR
+bool HasLongLength(const Element& element) {
+    static const char* const LONG_VRS[] = {"OB", "OD", "OF", "OL", "OV", "OW", "SQ", "SV", "UC", "UN", "UR", "UT", "UV"};
+    return std::any_of(std::begin(LONG_VRS), std::end(LONG_VRS),
+                       [&element](const char* vr) { return element.IsVr(vr); });
+}
+
+bool ReadElementHeader(DicomStream& stream, Element& element) {
+    uint16_t group = 0;
+    uint16_t number = 0;
+    if (!stream.Read16(group) || !stream.Read16(number)) {
+        return false;
+    }
+    element.tag = Tag(group, number);
+    // Items and delimiters have no VR
+    if (group == 0xFFFE) {
+        element.vr[0] = element.vr[1] = ' ';
+        return stream.Read32(element.length);
+    }
+    if (!stream.Read(element.vr, 2)) {
+        return false;
+    }
+    if (HasLongLength(element)) {
+        uint16_t reserved = 0;
+        return stream.Read16(reserved) && stream.Read32(element.length);
+    }
+    uint16_t length = 0;
+    if (!stream.Read16(length)) {
+        return false;
+    }
+    element.length = length;
+    return true;
+}
+
+bool SkipValue(DicomStream& stream, const Element& element, int depth);
+
+// Items of an undefined-length sequence, through its delimiter
+bool SkipItems(DicomStream& stream, int depth) {
+    if (depth > MAX_NESTING) {
+        return false;
+    }
+    for (;;) {
+        Element item;
+        if (!ReadElementHeader(stream, item)) {
+            return false;
+        }
+        if (item.tag == TAG_SEQUENCE_DELIMITER) {
+            return true;
+        }
+        if (item.tag != TAG_ITEM) {
+            return false;
+        }
+        if (item.length != UNDEFINED_LENGTH) {
+            if (!stream.Skip(item.length)) {
+                return false;
+            }
+            continue;
+        }
+        for (;;) {
+            Element element;
+            if (!ReadElementHeader(stream, element)) {
+                return false;
+            }
+            if (element.tag == TAG_ITEM_DELIMITER) {
+                break;
+            }
+            if (!SkipValue(stream, element, depth + 1)) {
+                return false;
+            }
+        }
+    }
+}
+
+bool SkipValue(DicomStream& stream, const Element& element, int depth) {
+    if (element.length != UNDEFINED_LENGTH) {
+        return stream.Skip(element.length);
+    }
+    // An undefined-length UN holds implicit VR data, which is not parsed
+    return element.IsVr("SQ") && SkipItems(stream, depth);
+}
+
+// Text value without DICOM's trailing padding
+std::string TextValue(const std::vector<uint8_t>& value) {
+    std::string text(value.begin(), value.end());
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\0')) {
+        text.pop_back();
+    }
+    while (!text.empty() && text.front() == ' ') {
+        text.erase(text.begin());
+    }
+    return text;
+}
+
+uint64_t IntegerValue(const std::vector<uint8_t>& value, size_t offset, size_t bytes) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < bytes && offset + i < value.size(); ++i) {
+        result |= static_cast<uint64_t>(value[offset + i]) << (8 * i);
+    }
+    return result;
+}
+
+double FloatValue(const std::vector<uint8_t>& value) {
+    if (value.size() < sizeof(float)) {
+        return 0.0;
+    }
+    uint32_t bits = static_cast<uint32_t>(IntegerValue(value, 0, 4));
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+std::vector<uint64_t> Integer64Values(const std::vector<uint8_t>& value) {
+    std::vector<uint64_t> values(value.size() / 8);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = IntegerValue(value, i * 8, 8);
+    }
+    return values;
+}
+
+bool IsDicomFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char header[PREAMBLE_BYTES + 4];
+    return file.read(header, sizeof(header)) && std::memcmp(header + PREAMBLE_BYTES, "DICM", 4) == 0;
+}
+
+// Fill in frame offsets and sizes from the encapsulated pixel data, read
+// from just past its element header
+bool IndexFrames(DicomStream& stream, uint64_t fileSize, const std::vector<uint64_t>& extendedOffsets,
+                 const std::vector<uint64_t>& extendedLengths, DicomFrameIndex& index) {
+    const int64_t frames = index.frameCount;
+    if (frames <= 0 || frames > DicomFrameIndex::MAX_FRAMES) {
+        return false;
+    }
+
+    // The first item is the Basic Offset Table, possibly empty
+    Element table;
+    if (!ReadElementHeader(stream, table) || table.tag != TAG_ITEM || table.length == UNDEFINED_LENGTH ||
+        table.length % 4 != 0 || table.length / 4 > static_cast<uint64_t>(frames)) {
+        return false;
+    }
+    std::vector<uint32_t> basicOffsets(table.length / 4);
+    for (uint32_t& offset : basicOffsets) {
+        if (!stream.Read32(offset)) {
+            return false;
+        }
+    }
+    // Table offsets count from the first fragment's item tag
+    const uint64_t firstFragment = stream.Tell();
+
+    std::vector<uint64_t>& offsets = index.frameOffsets;
+    std::vector<uint64_t>& sizes = index.frameSizes;
+    offsets.assign(static_cast<size_t>(frames), 0);
+    sizes.assign(static_cast<size_t>(frames), 0);
+    if (extendedOffsets.size() == static_cast<size_t>(frames) &&
+        extendedLengths.size() == static_cast<size_t>(frames)) {
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            offsets[i] = firstFragment + extendedOffsets[i] + ITEM_HEADER_BYTES;
+            sizes[i] = extendedLengths[i];
+        }
+        index.offsetSource = DicomFrameIndex::OffsetSource::ExtendedTable;
+    } else if (basicOffsets.size() == static_cast<size_t>(frames)) {
+        // One fragment per frame: each ends where the next frame's item
+        // starts. The first and last items' own lengths confirm it.
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            offsets[i] = firstFragment + basicOffsets[i] + ITEM_HEADER_BYTES;
+            if (i + 1 < offsets.size()) {
+                if (basicOffsets[i + 1] < static_cast<uint64_t>(basicOffsets[i]) + ITEM_HEADER_BYTES) {
+                    return false;
+                }
+                sizes[i] = basicOffsets[i + 1] - basicOffsets[i] - ITEM_HEADER_BYTES;
+            }
+        }
+        Element first, last;
+        if (!stream.Seek(firstFragment + basicOffsets.back()) || !ReadElementHeader(stream, last) ||
+            last.tag != TAG_ITEM || last.length == UNDEFINED_LENGTH) {
+            return false;
+        }
+        sizes.back() = last.length;
+        if (!stream.Seek(firstFragment + basicOffsets.front()) || !ReadElementHeader(stream, first) ||
+            first.tag != TAG_ITEM || first.length != sizes.front()) {
+            return false;
+        }
+        index.offsetSource = DicomFrameIndex::OffsetSource::BasicTable;
+    } else if (basicOffsets.empty()) {
+        // No table: walk the item headers, skipping the frame data
+        size_t found = 0;
+        for (;;) {
+            Element item;
+            if (!ReadElementHeader(stream, item)) {
+                return false;
+            }
+            if (item.tag == TAG_SEQUENCE_DELIMITER) {
+                break;
+            }
+            if (item.tag != TAG_ITEM || item.length == UNDEFINED_LENGTH || found == offsets.size()) {
+                return false;  // More fragments than frames
+            }
+            offsets[found] = stream.Tell();
+            sizes[found] = item.length;
+            found++;
+            if (!stream.Skip(item.length)) {
+                return false;
+            }
+        }
+        if (found != offsets.size()) {
+            return false;
+        }
+        index.offsetSource = DicomFrameIndex::OffsetSource::ItemScan;
+    } else {
+        return false;
+    }
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        if (sizes[i] == 0 || offsets[i] > fileSize || sizes[i] > fileSize - offsets[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool DicomFrameIndex::IsTiledJpegVolume() const {
+    const int64_t tiles = TilesAcross() * TilesDown();
+    const bool tiledFull = dimensionOrganization == "TILED_FULL" ||
+                           (dimensionOrganization.empty() && frameCount == tiles);
+    return imageType == "VOLUME" && transferSyntax == JPEG_BASELINE &&
+           samplesPerPixel == 3 && bitsAllocated == 8 &&
+           width > 0 && height > 0 && tileWidth > 0 && tileHeight > 0 && tiledFull &&
+           tiles > 0 && static_cast<int64_t>(frameOffsets.size()) >= tiles &&
+           frameSizes.size() == frameOffsets.size();
+}
+
+const char* DicomFrameIndex::OffsetSourceName(OffsetSource source) {
+    switch (source) {
+        case OffsetSource::ExtendedTable: return "extended offset table";
+        case OffsetSource::BasicTable: return "basic offset table";
+        case OffsetSource::ItemScan: break;
+    }
+    return "item scan";
+}
+
+bool DicomFrameIndex::IsDicomPath(const std::string& path) {
+    std::error_code error;
+    return std::filesystem::is_directory(path, error) || IsDicomFile(path);
+}
+
+std::optional<DicomFrameIndex> DicomFrameIndex::Read(const std::string& path) {
+    DicomStream stream(path);
+    std::error_code error;
+    const uint64_t fileSize = std::filesystem::file_size(path, error);
+    char header[PREAMBLE_BYTES + 4];
+    if (!stream.IsOpen() || error || !stream.Read(header, sizeof(header)) ||
+        std::memcmp(header + PREAMBLE_BYTES, "DICM", 4) != 0) {
+        return std::nullopt;
+    }
+
+    DicomFrameIndex index;
+    index.path = path;
+
+    // File meta information: explicit VR little endian, whatever the
+    // dataset's encoding
+    std::vector<uint8_t> value;
+    for (;;) {
+        const uint64_t start = stream.Tell();
+        Element element;
+        if (!ReadElementHeader(stream, element)) {
+            return std::nullopt;
+        }
+        if ((element.tag >> 16) != 0x0002) {
+            if (!stream.Seek(start)) {
+                return std::nullopt;
+            }
+            break;
+        }
+        if (element.tag == TAG_TRANSFER_SYNTAX && element.length <= MAX_VALUE_BYTES) {
+            value.resize(element.length);
+            if (!stream.Read(value.data(), value.size())) {
+                return std::nullopt;
+            }
+            index.transferSyntax = TextValue(value);
+        } else if (!SkipValue(stream, element, 0)) {
+            return std::nullopt;
+        }
+    }
+    if (index.transferSyntax == IMPLICIT_VR_LITTLE_ENDIAN || index.transferSyntax == EXPLICIT_VR_BIG_ENDIAN ||
+        index.transferSyntax == DEFLATED_EXPLICIT_VR) {
+        return std::nullopt;
+    }
+
+    // Top-level elements up to the pixel data; sequences (functional
+    // groups, optical paths, ...) are skipped whole
+    std::vector<uint64_t> extendedOffsets, extendedLengths;
+    for (;;) {
+        Element element;
+        if (!ReadElementHeader(stream, element)) {
+            return std::nullopt;
+        }
+        if (element.tag == TAG_PIXEL_DATA) {
+            // Native (unencapsulated) pixel data has a defined length and
+            // is not indexed
+            if (element.length == UNDEFINED_LENGTH &&
+                !IndexFrames(stream, fileSize, extendedOffsets, extendedLengths, index)) {
+                index.frameOffsets.clear();
+                index.frameSizes.clear();
+            }
+            return index;
+        }
+
+        const bool offsetTable = element.tag == TAG_EXTENDED_OFFSET_TABLE ||
+                                 element.tag == TAG_EXTENDED_OFFSET_LENGTHS;
+        const bool wanted = element.tag == TAG_IMAGE_TYPE || element.tag == TAG_SERIES_UID ||
+                            element.tag == TAG_DIMENSION_ORGANIZATION || element.tag == TAG_SAMPLES_PER_PIXEL ||
+                            element.tag == TAG_PHOTOMETRIC || element.tag == TAG_NUMBER_OF_FRAMES ||
+                            element.tag == TAG_ROWS || element.tag == TAG_COLUMNS ||
+                            element.tag == TAG_BITS_ALLOCATED || element.tag == TAG_IMAGED_WIDTH ||
+                            element.tag == TAG_IMAGED_HEIGHT || element.tag == TAG_TOTAL_COLUMNS ||
+                            element.tag == TAG_TOTAL_ROWS;
+        const uint64_t maxBytes = offsetTable ? static_cast<uint64_t>(MAX_FRAMES) * 8 : MAX_VALUE_BYTES;
+        if (!(wanted || offsetTable) || element.length == UNDEFINED_LENGTH || element.length > maxBytes) {
+            if (!SkipValue(stream, element, 0)) {
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        value.resize(element.length);
+        if (!stream.Read(value.data(), value.size())) {
+            return std::nullopt;
+        }
+        switch (element.tag) {
+            case TAG_IMAGE_TYPE: {
+                // ORIGINAL\PRIMARY\VOLUME\NONE
+                std::string text = TextValue(value);
+                size_t first = text.find('\\');
+                size_t second = first == std::string::npos ? first : text.find('\\', first + 1);
+                if (second != std::string::npos) {
+                    size_t end = text.find('\\', second + 1);
+                    index.imageType = text.substr(second + 1, end == std::string::npos ? end : end - second - 1);
+                }
+                break;
+            }
+            case TAG_SERIES_UID: index.seriesUid = TextValue(value); break;
+            case TAG_DIMENSION_ORGANIZATION: index.dimensionOrganization = TextValue(value); break;
+            case TAG_PHOTOMETRIC: index.photometric = TextValue(value); break;
+            case TAG_SAMPLES_PER_PIXEL: index.samplesPerPixel = static_cast<uint32_t>(IntegerValue(value, 0, 2)); break;
+            case TAG_BITS_ALLOCATED: index.bitsAllocated = static_cast<uint32_t>(IntegerValue(value, 0, 2)); break;
+            case TAG_ROWS: index.tileHeight = static_cast<int64_t>(IntegerValue(value, 0, 2)); break;
+            case TAG_COLUMNS: index.tileWidth = static_cast<int64_t>(IntegerValue(value, 0, 2)); break;
+            case TAG_NUMBER_OF_FRAMES: index.frameCount = std::strtoll(TextValue(value).c_str(), nullptr, 10); break;
+            case TAG_TOTAL_COLUMNS: index.width = static_cast<int64_t>(IntegerValue(value, 0, 4)); break;
+            case TAG_TOTAL_ROWS: index.height = static_cast<int64_t>(IntegerValue(value, 0, 4)); break;
+            case TAG_IMAGED_WIDTH: index.imagedWidthMm = FloatValue(value); break;
+            case TAG_IMAGED_HEIGHT: index.imagedHeightMm = FloatValue(value); break;
+            case TAG_EXTENDED_OFFSET_TABLE: extendedOffsets = Integer64Values(value); break;
+            case TAG_EXTENDED_OFFSET_LENGTHS: extendedLengths = Integer64Values(value); break;
+            default: break;
+        }
+    }
+}
+
+std::vector<DicomFrameIndex> DicomFrameIndex::FindPyramid(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    const bool directory = fs::is_directory(path, error);
+    fs::path folder = directory ? fs::path(path) : fs::path(path).parent_path();
+    if (folder.empty()) {
+        folder = ".";
+    }
+
+    std::string series;
+    if (!directory) {
+        std::optional<DicomFrameIndex> self = Read(path);
+        if (!self) {
+            return {};
+        }
+        series = self->seriesUid;
+    }
+
+    std::vector<std::string> files;
+    for (fs::directory_iterator it(folder, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(error)) {
+            files.push_back(it->path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<DicomFrameIndex> levels;
+    for (const std::string& file : files) {
+        if (!IsDicomFile(file)) {
+            continue;
+        }
+        std::optional<DicomFrameIndex> index = Read(file);
+        if (!index || index->imageType != "VOLUME") {
+            continue;
+        }
+        if (series.empty()) {
+            series = index->seriesUid;
+        }
+        if (index->seriesUid != series) {
+            continue;
+        }
+        if (!index->IsTiledJpegVolume()) {
+            PATHVIEW_LOG_INFO("DICOM: " << file << " is not a tiled JPEG volume (transfer syntax "
+                              << index->transferSyntax << ", " << index->frameOffsets.size() << " of "
+                              << index->frameCount << " frames indexed)");
+            continue;
+        }
+        levels.push_back(std::move(*index));
+    }
+
+    // Largest first; another instance of a size already taken is a
+    // further focal plane or optical path
+    std::stable_sort(levels.begin(), levels.end(), [](const DicomFrameIndex& a, const DicomFrameIndex& b) {
+        return a.width * a.height > b.width * b.height;
+    });
+    levels.erase(std::unique(levels.begin(), levels.end(),
+                             [](const DicomFrameIndex& a, const DicomFrameIndex& b) {
+                                 return a.width == b.width && a.height == b.height;
+                             }),
+                 levels.end());
+    return levels;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Frame index of one DICOM whole-slide image instance (a Part 10 file of
+// the VL Whole Slide Microscopy Image IOD). Each instance holds one
+// pyramid level, or an associated image, as encapsulated frames: every
+// frame is one tile of the total pixel matrix.
+//
+// Read() parses the dataset up to the pixel data and records where each
+// frame's bytes sit in the file, so frames are then read by offset like
+// TIFF tiles (see TiffTileReader's DICOM constructor). The offsets come
+// from the Extended Offset Table (7FE0,0001) if the file has one, else
+// from the Basic Offset Table; only files with neither have their item
+// headers walked, which reads 8 bytes per frame but none of the frame
+// data. Frames split over several fragments are not indexed.
+//
+// Only explicit VR little endian encodings are parsed, as the standard
+// requires of encapsulated pixel data.
+struct DicomFrameIndex {
+    // Where the frame offsets came from
+    enum class OffsetSource {
+        ExtendedTable,
+        BasicTable,
+        ItemScan
+    };
+
+    std::string path;
+    std::string seriesUid;               // (0020,000E)
+    std::string imageType;               // Third value of (0008,0008): VOLUME, LABEL, OVERVIEW, ...
+    std::string transferSyntax;          // (0002,0010)
+    std::string photometric;             // (0028,0004): YBR_FULL_422, RGB, ...
+    std::string dimensionOrganization;   // (0020,9311): TILED_FULL, TILED_SPARSE or empty
+    int64_t width = 0;                   // Total pixel matrix columns (0048,0006)
+    int64_t height = 0;                  // Total pixel matrix rows (0048,0007)
+    int64_t tileWidth = 0;               // Columns (0028,0011)
+    int64_t tileHeight = 0;              // Rows (0028,0010)
+    uint32_t samplesPerPixel = 0;
+    uint32_t bitsAllocated = 0;
+    int64_t frameCount = 0;              // Number of frames (0028,0008)
+    double imagedWidthMm = 0.0;          // Imaged volume width (0048,0001)
+    double imagedHeightMm = 0.0;
+    OffsetSource offsetSource = OffsetSource::ItemScan;
+
+    // File offset and size of each frame's compressed bytes
+    std::vector<uint64_t> frameOffsets;
+    std::vector<uint64_t> frameSizes;
+
+    int64_t TilesAcross() const { return tileWidth > 0 ? (width + tileWidth - 1) / tileWidth : 0; }
+    int64_t TilesDown() const { return tileHeight > 0 ? (height + tileHeight - 1) / tileHeight : 0; }
+
+    // A pyramid level TiffTileReader can serve: a VOLUME of baseline JPEG
+    // (8-bit, 3-sample) frames tiling the matrix row by row (TILED_FULL),
+    // with every frame indexed. Further focal planes or optical paths
+    // follow the first one's frames and are ignored.
+    bool IsTiledJpegVolume() const;
+
+    // "extended offset table", "basic offset table", "item scan"
+    static const char* OffsetSourceName(OffsetSource source);
+
+    // Whether path is a directory or a file starting with the DICOM
+    // preamble and "DICM"
+    static bool IsDicomPath(const std::string& path);
+
+    // Parse one instance; std::nullopt if it is not a readable DICOM file
+    static std::optional<DicomFrameIndex> Read(const std::string& path);
+
+    // The pyramid of a series: path is one of its files, or a directory
+    // holding them (the first series with a VOLUME in file name order).
+    // Instances that pass IsTiledJpegVolume, one per size, largest first.
+    static std::vector<DicomFrameIndex> FindPyramid(const std::string& path);
+
+    static constexpr int64_t MAX_FRAMES = 16 * 1024 * 1024;
+};
@@ -0,0 +1,279 @@
+#include "DiskTileCache.h"
+#include "SlideFingerprint.h"
+#include "Log.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// On-disk tile header, followed by width * height ARGB pixels
+struct TileFileHeader {
+    uint32_t magic;
+    int32_t width;
+    int32_t height;
+    uint32_t reserved;
+};
+
+// Version 2: levels index the synthesized pyramid (PyramidLayout), not the
+// slide. Version 3: tile indices follow each level's native-aligned grid.
+// Older files are treated as foreign and replaced.
+constexpr uint32_t TILE_FILE_MAGIC = 0x33545650;  // "PVT3"
+constexpr const char* TILE_FILE_EXTENSION = ".tile";
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    // FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+}  // namespace
+
+DiskTileCache::DiskTileCache(const std::string& rootDir, const std::string& slidePath, size_t maxBytes,
+                             const std::string& slideIdentity)
+    : rootDir_(rootDir)
+    , maxBytes_(maxBytes)
+{
+    slideDir_ = (fs::path(rootDir_) / (slideIdentity.empty() ? SlideIdentity(slidePath) : slideIdentity)).string();
+
+    std::error_code ec;
+    fs::create_directories(slideDir_, ec);
+    if (ec) {
+        PATHVIEW_LOG_ERROR("DiskTileCache: Cannot create " << slideDir_ << ": " << ec.message());
+        return;
+    }
+    enabled_ = true;
+
+    ScanRoot();
+
+    PATHVIEW_LOG_INFO("DiskTileCache: " << index_.size() << " tiles ("
+                      << (diskUsage_.load() / (1024 * 1024)) << " / " << (maxBytes_ / (1024 * 1024))
+                      << "MB) in " << rootDir_);
+}
+
+std::string DiskTileCache::SlideIdentity(const std::string& slidePath) {
+    std::string fingerprint = SlideFingerprint::Compute(slidePath);
+    if (!fingerprint.empty()) {
+        return fingerprint;
+    }
+
+    // Remote slides: only the URL names them
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = HashBytes(hash, slidePath.data(), slidePath.size());
+
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+std::string DiskTileCache::DefaultRootDirectory() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (base) {
+        return (fs::path(base) / "PathView" / "TileCache").string();
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / "Library" / "Caches" / "PathView" / "Tiles").string();
+    }
+#else
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        return (fs::path(xdg) / "pathview" / "tiles").string();
+    }
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / ".cache" / "pathview" / "tiles").string();
+    }
+#endif
+    std::error_code ec;
+    return (fs::temp_directory_path(ec) / "pathview-tiles").string();
+}
+
+std::string DiskTileCache::TilePath(const TileKey& key) const {
+    std::string name = "L" + std::to_string(key.level) + "_" + std::to_string(key.tileX) +
+                       "_" + std::to_string(key.tileY) + TILE_FILE_EXTENSION;
+    return (fs::path(slideDir_) / name).generic_string();
+}
+
+void DiskTileCache::ScanRoot() {
+    struct Found {
+        fs::file_time_type mtime;
+        std::string path;
+        size_t bytes;
+    };
+    std::vector<Found> found;
+
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(rootDir_, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        const fs::path& path = it->path();
+        if (path.extension() == TILE_FILE_EXTENSION) {
+            found.push_back({it->last_write_time(ec), path.generic_string(), static_cast<size_t>(it->file_size(ec))});
+        } else if (path.extension() == ".tmp") {
+            fs::remove(path, ec);  // Interrupted write from an earlier session
+        }
+    }
+
+    std::sort(found.begin(), found.end(),
+              [](const Found& a, const Found& b) { return a.mtime < b.mtime; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Found& f : found) {
+        lruList_.push_front(f.path);
+        index_[f.path] = {f.path, f.bytes, lruList_.begin()};
+        diskUsage_ += f.bytes;
+    }
+    EvictToFit(0);
+}
+
+bool DiskTileCache::Load(const TileKey& key, uint32_t* pixels, size_t capacity,
+                         int32_t* outWidth, int32_t* outHeight) {
+    if (!enabled_) {
+        return false;
+    }
+
+    std::string path = TilePath(key);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_.find(path) == index_.end()) {
+            missCount_++;
+            return false;
+        }
+    }
+
+    // Read outside the lock so workers load in parallel
+    std::ifstream file(path, std::ios::binary);
+    TileFileHeader header{};
+    bool ok = file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+              header.magic == TILE_FILE_MAGIC &&
+              header.width > 0 && header.height > 0;
+    if (ok && static_cast<size_t>(header.width) * header.height > capacity) {
+        missCount_++;
+        return false;  // Valid tile, caller's buffer is just too small
+    }
+    ok = ok && file.read(reinterpret_cast<char*>(pixels),
+                         static_cast<std::streamsize>(header.width) * header.height * sizeof(uint32_t));
+    file.close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(path);
+    if (!ok) {
+        // Truncated or foreign file: forget it
+        if (it != index_.end()) {
+            diskUsage_ -= it->second.bytes;
+            lruList_.erase(it->second.lruIterator);
+            index_.erase(it);
+        }
+        std::error_code ec;
+        fs::remove(path, ec);
+        missCount_++;
+        return false;
+    }
+
+    if (it != index_.end()) {
+        Touch(it->second);
+    }
+    hitCount_++;
+    *outWidth = header.width;
+    *outHeight = header.height;
+    return true;
+}
+
+void DiskTileCache::Store(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height) {
+    if (!enabled_ || !pixels || width <= 0 || height <= 0) {
+        return;
+    }
+
+    std::string path = TilePath(key);
+    size_t pixelBytes = static_cast<size_t>(width) * height * sizeof(uint32_t);
+    size_t bytes = sizeof(TileFileHeader) + pixelBytes;
+    if (bytes > maxBytes_) {
+        return;
+    }
+
+    // Write to a unique temporary file, then rename into place, so readers
+    // (and later sessions) never see a partial tile
+    static std::atomic<uint64_t> tempCounter{0};
+    std::string tempPath = path + "." + std::to_string(tempCounter++) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        TileFileHeader header{TILE_FILE_MAGIC, width, height, 0};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(pixelBytes));
+        if (!file) {
+            file.close();
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return;
+    }
+
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+        diskUsage_ -= it->second.bytes;
+        lruList_.erase(it->second.lruIterator);
+        index_.erase(it);
+    }
+
+    EvictToFit(bytes);
+
+    lruList_.push_front(path);
+    index_[path] = {path, bytes, lruList_.begin()};
+    diskUsage_ += bytes;
+}
+
+bool DiskTileCache::HasTile(const TileKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.count(TilePath(key)) > 0;
+}
+
+size_t DiskTileCache::GetTileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+void DiskTileCache::Touch(IndexEntry& entry) {
+    lruList_.splice(lruList_.begin(), lruList_, entry.lruIterator);
+
+    // Persist recency for the next session's scan
+    std::error_code ec;
+    fs::last_write_time(entry.path, fs::file_time_type::clock::now(), ec);
+}
+
+void DiskTileCache::EvictToFit(size_t incomingBytes) {
+    while (!lruList_.empty() && diskUsage_.load() + incomingBytes > maxBytes_) {
+        auto it = index_.find(lruList_.back());
+        lruList_.pop_back();
+        if (it == index_.end()) {
+            continue;
+        }
+
+        std::error_code ec;
+        fs::remove(it->second.path, ec);
+        diskUsage_ -= it->second.bytes;
+        index_.erase(it);
+    }
+}
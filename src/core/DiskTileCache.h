@@ -0,0 +1,93 @@
+#pragma once
+
+#include "TextureManager.h"  // For TileKey
+#include <cstdint>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+// Second-tier tile cache that persists decoded tiles across sessions.
+//
+// Tiles are written by the decode workers as raw premultiplied ARGB files
+// (a small header plus the pixels) under <root>/<slide id>/, where the
+// slide id is the slide's SlideFingerprint, so an edited or replaced file
+// never serves stale tiles and a renamed or moved one keeps its tiles. Raw pixels are read
+// back far faster than OpenSlide can decode JPEG/JP2K, and need no extra
+// codec dependency.
+//
+// The size cap applies to the whole root directory (all slides) and is
+// enforced with LRU eviction. Recency survives restarts through file
+// modification times, which are refreshed on every hit.
+class DiskTileCache {
+public:
+    // slideIdentity: SlideIdentity(slidePath) if empty; pass the one the
+    // slide's metadata holds to skip reading the file again
+    DiskTileCache(const std::string& rootDir, const std::string& slidePath,
+                  size_t maxBytes = DEFAULT_MAX_BYTES, const std::string& slideIdentity = "");
+
+    DiskTileCache(const DiskTileCache&) = delete;
+    DiskTileCache& operator=(const DiskTileCache&) = delete;
+
+    // False if the cache directory could not be created; all calls are
+    // then no-ops
+    bool IsEnabled() const { return enabled_; }
+
+    // Read a tile into pixels (capacity in pixels). Returns false on miss,
+    // on a corrupt file, or if the tile does not fit.
+    bool Load(const TileKey& key, uint32_t* pixels, size_t capacity,
+              int32_t* outWidth, int32_t* outHeight);
+
+    // Write a decoded tile, evicting least recently used tiles over the cap.
+    // Safe to call from several workers at once.
+    void Store(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height);
+
+    bool HasTile(const TileKey& key) const;
+
+    // Statistics
+    size_t GetTileCount() const;
+    size_t GetDiskUsage() const { return diskUsage_.load(); }
+    size_t GetMaxBytes() const { return maxBytes_; }
+    size_t GetHitCount() const { return hitCount_.load(); }
+    size_t GetMissCount() const { return missCount_.load(); }
+
+    // Stable identity for a slide file's current contents: its
+    // SlideFingerprint, or a hash of the path if the file cannot be read
+    static std::string SlideIdentity(const std::string& slidePath);
+
+    // Per-user cache location (e.g. ~/.cache/pathview/tiles)
+    static std::string DefaultRootDirectory();
+
+    static constexpr size_t DEFAULT_MAX_BYTES = 2048ull * 1024 * 1024;  // 2GB
+
+private:
+    struct IndexEntry {
+        std::string path;
+        size_t bytes;
+        std::list<std::string>::iterator lruIterator;
+    };
+
+    std::string TilePath(const TileKey& key) const;
+
+    // Rebuild the LRU index from every tile file under the root (oldest first)
+    void ScanRoot();
+
+    // Both require mutex_ to be held
+    void Touch(IndexEntry& entry);
+    void EvictToFit(size_t incomingBytes);
+
+    std::string rootDir_;
+    std::string slideDir_;
+    size_t maxBytes_;
+    bool enabled_ = false;
+
+    // Index over all slides' tiles, keyed by file path (front = most recent)
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, IndexEntry> index_;
+    std::list<std::string> lruList_;
+
+    std::atomic<size_t> diskUsage_{0};
+    std::atomic<size_t> hitCount_{0};
+    std::atomic<size_t> missCount_{0};
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "TileKey.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Open-addressing hash map from TileKey to Value, the tile subsystem's
+// replacement for std::unordered_map<TileKey, Value, TileKeyHash>: one
+// flat array of slots probed linearly from TileKeyHash's low bits, with a
+// control byte per slot carrying 7 more hash bits so a probe compares keys
+// only on a likely match. No node allocation per tile, and a lookup
+// touches one or two cache lines.
+//
+// Mirrors the unordered_map calls the tile code uses. Unlike
+// unordered_map, an insert that grows the table moves every entry, so
+// references and iterators are only stable until the next insert. Erase
+// never moves entries: erasing while iterating (it = map.erase(it)), or
+// holding an iterator past the erased one, is fine.
+template <typename Value>
+class FlatTileMap {
+    // Storage for one entry, constructed in place only while its slot is full
+    union Slot {
+        Slot() {}
+        ~Slot() {}
+        std::pair<const TileKey, Value> value;
+    };
+
+public:
+    using key_type = TileKey;
+    using mapped_type = Value;
+    using value_type = std::pair<const TileKey, Value>;
+    using size_type = size_t;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatTileMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() = default;
+
+        // iterator -> const_iterator
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other)
+            : control_(other.control_), end_(other.end_), slot_(other.slot_) {}
+
+        reference operator*() const { return slot_->value; }
+        pointer operator->() const { return &slot_->value; }
+
+        Iterator& operator++() {
+            ++control_;
+            ++slot_;
+            SkipFree();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return control_ == other.control_; }
+        bool operator!=(const Iterator& other) const { return control_ != other.control_; }
+
+    private:
+        friend class FlatTileMap;
+        template <bool>
+        friend class Iterator;
+
+        // Tagged so a braced TileKey never converts to an iterator
+        struct At {};
+
+        Iterator(At, const uint8_t* control, const uint8_t* end, Slot* slot)
+            : control_(control), end_(end), slot_(slot) {
+            SkipFree();
+        }
+
+        void SkipFree() {
+            while (control_ != end_ && !IsFull(*control_)) {
+                ++control_;
+                ++slot_;
+            }
+        }
+
+        const uint8_t* control_ = nullptr;
+        const uint8_t* end_ = nullptr;
+        Slot* slot_ = nullptr;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatTileMap() = default;
+
+    FlatTileMap(const FlatTileMap& other) {
+        reserve(other.size_);
+        for (const value_type& entry : other) {
+            try_emplace(entry.first, entry.second);
+        }
+    }
+
+    FlatTileMap(FlatTileMap&& other) noexcept { Swap(other); }
+
+    FlatTileMap& operator=(const FlatTileMap& other) {
+        if (this != &other) {
+            FlatTileMap copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    FlatTileMap& operator=(FlatTileMap&& other) noexcept {
+        if (this != &other) {
+            FlatTileMap moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    ~FlatTileMap() { DestroyAll(); }
+
+    iterator begin() { return MakeIterator(0); }
+    iterator end() { return MakeIterator(capacity_); }
+    const_iterator begin() const { return MakeIterator(0); }
+    const_iterator end() const { return MakeIterator(capacity_); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Slots allocated, for statistics
+    size_t capacity() const { return capacity_; }
+
+    iterator find(const TileKey& key) { return MakeIterator(FindIndex(key, TileKeyHash{}(key))); }
+    const_iterator find(const TileKey& key) const { return MakeIterator(FindIndex(key, TileKeyHash{}(key))); }
+    size_t count(const TileKey& key) const { return FindIndex(key, TileKeyHash{}(key)) != capacity_ ? 1 : 0; }
+
+    Value& at(const TileKey& key) {
+        size_t index = FindIndex(key, TileKeyHash{}(key));
+        if (index == capacity_) {
+            throw std::out_of_range("FlatTileMap::at: no such tile");
+        }
+        return slots_[index].value.second;
+    }
+
+    const Value& at(const TileKey& key) const { return const_cast<FlatTileMap*>(this)->at(key); }
+
+    Value& operator[](const TileKey& key) { return try_emplace(key).first->second; }
+
+    // Construct Value from args unless key is present; the iterator points
+    // at key's entry either way
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const TileKey& key, Args&&... args) {
+        size_t hash = TileKeyHash{}(key);
+        size_t index = FindIndex(key, hash);
+        if (index != capacity_) {
+            return {MakeIterator(index), false};
+        }
+
+        if ((size_ + tombstones_ + 1) * MAX_LOAD_DENOMINATOR > capacity_ * MAX_LOAD_NUMERATOR) {
+            // Grows, or just sweeps the tombstones out at the same size
+            size_t capacity = CapacityFor(size_ + 1);
+            Rehash(capacity > capacity_ ? capacity : capacity_);
+        }
+        index = FreeIndex(hash);
+        new (&slots_[index].value) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                              std::forward_as_tuple(std::forward<Args>(args)...));
+        if (control_[index] == DELETED) {
+            tombstones_--;
+        }
+        control_[index] = Tag(hash);
+        size_++;
+        return {MakeIterator(index), true};
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> emplace(const TileKey& key, V&& value) {
+        return try_emplace(key, std::forward<V>(value));
+    }
+
+    // Returns the entry after pos
+    iterator erase(const_iterator pos) {
+        size_t index = static_cast<size_t>(pos.control_ - control_.get());
+        EraseIndex(index);
+        return MakeIterator(index + 1);
+    }
+
+    size_t erase(const TileKey& key) {
+        size_t index = FindIndex(key, TileKeyHash{}(key));
+        if (index == capacity_) {
+            return 0;
+        }
+        EraseIndex(index);
+        return 1;
+    }
+
+    // Entries are destroyed; the slots are kept
+    void clear() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (IsFull(control_[i])) {
+                slots_[i].value.~value_type();
+            }
+        }
+        if (capacity_ > 0) {
+            std::memset(control_.get(), EMPTY, capacity_);
+        }
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+    // Room for count entries without growing
+    void reserve(size_t count) {
+        size_t capacity = CapacityFor(count);
+        if (capacity > capacity_) {
+            Rehash(capacity);
+        }
+    }
+
+    static constexpr size_t MIN_CAPACITY = 16;
+    // Grows once full and deleted slots pass 3/4 of the table
+    static constexpr size_t MAX_LOAD_NUMERATOR = 3;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+
+private:
+    static constexpr uint8_t EMPTY = 0x00;
+    static constexpr uint8_t DELETED = 0x01;
+    static constexpr uint8_t FULL = 0x80;  // | the hash's top 7 bits
+
+    static bool IsFull(uint8_t control) { return (control & FULL) != 0; }
+
+    static uint8_t Tag(size_t hash) {
+        return static_cast<uint8_t>(FULL | (hash >> (sizeof(size_t) * 8 - 7)));
+    }
+
+    static size_t CapacityFor(size_t count) {
+        size_t capacity = MIN_CAPACITY;
+        while (count * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    iterator MakeIterator(size_t index) {
+        return iterator({}, control_.get() + index, control_.get() + capacity_, slots_.get() + index);
+    }
+
+    const_iterator MakeIterator(size_t index) const {
+        return const_iterator({}, control_.get() + index, control_.get() + capacity_, slots_.get() + index);
+    }
+
+    // Slot holding key, or capacity_ if absent. The load limit guarantees
+    // an empty slot, which ends every probe.
+    size_t FindIndex(const TileKey& key, size_t hash) const {
+        if (size_ == 0) {
+            return capacity_;
+        }
+        const size_t mask = capacity_ - 1;
+        const uint8_t tag = Tag(hash);
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            uint8_t control = control_[index];
+            if (control == EMPTY) {
+                return capacity_;
+            }
+            if (control == tag && slots_[index].value.first == key) {
+                return index;
+            }
+        }
+    }
+
+    // First empty or deleted slot on hash's probe sequence
+    size_t FreeIndex(size_t hash) const {
+        const size_t mask = capacity_ - 1;
+        size_t index = hash & mask;
+        while (IsFull(control_[index])) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void EraseIndex(size_t index) {
+        slots_[index].value.~value_type();
+        // A probe that reached this slot would stop at an empty successor
+        // anyway, so no tombstone is needed before one
+        if (control_[(index + 1) & (capacity_ - 1)] == EMPTY) {
+            control_[index] = EMPTY;
+        } else {
+            control_[index] = DELETED;
+            tombstones_++;
+        }
+        size_--;
+    }
+
+    // Move every entry into a fresh table of capacity slots (a power of
+    // two), dropping tombstones
+    void Rehash(size_t capacity) {
+        std::unique_ptr<uint8_t[]> control(new uint8_t[capacity]);
+        std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+        std::memset(control.get(), EMPTY, capacity);
+
+        const size_t mask = capacity - 1;
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (!IsFull(control_[i])) {
+                continue;
+            }
+            value_type& entry = slots_[i].value;
+            size_t hash = TileKeyHash{}(entry.first);
+            size_t index = hash & mask;
+            while (control[index] != EMPTY) {
+                index = (index + 1) & mask;
+            }
+            new (&slots[index].value) value_type(entry.first, std::move(entry.second));
+            control[index] = Tag(hash);
+            entry.~value_type();
+        }
+
+        control_ = std::move(control);
+        slots_ = std::move(slots);
+        capacity_ = capacity;
+        tombstones_ = 0;
+    }
+
+    void DestroyAll() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (IsFull(control_[i])) {
+                slots_[i].value.~value_type();
+            }
+        }
+    }
+
+    void Swap(FlatTileMap& other) noexcept {
+        std::swap(control_, other.control_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(tombstones_, other.tombstones_);
+    }
+
+    std::unique_ptr<uint8_t[]> control_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t tombstones_ = 0;
+};
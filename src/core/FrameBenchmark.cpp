@@ -0,0 +1,154 @@
+#include "FrameBenchmark.h"
+#include <algorithm>
+
+namespace {
+
+double Milliseconds(FrameBenchmark::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Mean, p50, p99 and max of values (nearest rank), zeros when empty
+nlohmann::json Summarize(std::vector<double> values) {
+    if (values.empty()) {
+        return {{"mean", 0.0}, {"p50", 0.0}, {"p99", 0.0}, {"max", 0.0}};
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    auto percentile = [&](double fraction) {
+        size_t rank = static_cast<size_t>(fraction * static_cast<double>(values.size()) + 0.5);
+        return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+    return {
+        {"mean", sum / static_cast<double>(values.size())},
+        {"p50", percentile(0.50)},
+        {"p99", percentile(0.99)},
+        {"max", values.back()}
+    };
+}
+
+}  // namespace
+
+FrameBenchmark::FrameBenchmark(const ViewportTrace& trace, const FrameBenchmarkOptions& options)
+    : trace_(trace)
+    , options_(options)
+    , isStop_(FindStops(trace, options.stopHoldMs))
+    , passes_(options.warmCache ? 2 : 1)
+    , done_(trace.IsEmpty())
+{
+}
+
+std::vector<bool> FrameBenchmark::FindStops(const ViewportTrace& trace, double stopHoldMs) {
+    const std::vector<ViewportSample>& samples = trace.GetSamples();
+    std::vector<bool> stops(samples.size(), false);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        stops[i] = i + 1 == samples.size() || samples[i + 1].timeMs - samples[i].timeMs >= stopHoldMs;
+    }
+    return stops;
+}
+
+void FrameBenchmark::BeginFrame(Clock::time_point now) {
+    if (IsMeasuring() && sample_ == 0 && stopFrames_ == 0 && frames_.empty()) {
+        measureStart_ = now;
+    }
+    if (isStop_[sample_] && stopFrames_ == 0) {
+        stopStart_ = now;
+    }
+}
+
+void FrameBenchmark::EndFrame(Frame frame, bool sharp, Clock::time_point now) {
+    if (done_) {
+        return;
+    }
+    frame.sample = sample_;
+    frame.settling = stopFrames_ > 0;
+    if (IsMeasuring()) {
+        frames_.push_back(frame);
+    }
+
+    if (isStop_[sample_]) {
+        ++stopFrames_;
+        const double elapsedMs = Milliseconds(now - stopStart_);
+        const bool timedOut = !sharp && elapsedMs >= options_.sharpTimeoutMs;
+        if (!sharp && !timedOut) {
+            return;  // Draw the stop again
+        }
+        if (IsMeasuring()) {
+            stops_.push_back({sample_, elapsedMs, stopFrames_, timedOut});
+        }
+        stopFrames_ = 0;
+    }
+
+    if (++sample_ < trace_.GetSampleCount()) {
+        return;
+    }
+    sample_ = 0;
+    if (++pass_ == passes_) {
+        done_ = true;
+        measureEnd_ = now;
+    }
+}
+
+FrameBenchmark::json FrameBenchmark::ToJson(const json& environment) const {
+    json frames = json::array();
+    std::vector<double> cpuMs;
+    std::vector<double> presentMs;
+    size_t requested = 0;
+    for (const Frame& frame : frames_) {
+        frames.push_back({
+            {"sample", frame.sample},
+            {"cpu_ms", frame.cpuMs},
+            {"present_ms", frame.presentMs},
+            {"tiles_visible", frame.visibleTiles},
+            {"tiles_displayed", frame.displayedTiles},
+            {"tiles_requested", frame.requestedTiles},
+            {"settling", frame.settling}
+        });
+        cpuMs.push_back(frame.cpuMs);
+        presentMs.push_back(frame.presentMs);
+        requested += frame.requestedTiles;
+    }
+
+    json stops = json::array();
+    std::vector<double> timeToSharpMs;
+    size_t timedOut = 0;
+    for (const Stop& stop : stops_) {
+        const ViewportSample& sample = trace_.GetSamples()[stop.sample];
+        stops.push_back({
+            {"sample", stop.sample},
+            {"x", sample.x},
+            {"y", sample.y},
+            {"zoom", sample.zoom},
+            {"time_to_sharp_ms", stop.timeToSharpMs},
+            {"frames", stop.frames},
+            {"timed_out", stop.timedOut}
+        });
+        timeToSharpMs.push_back(stop.timeToSharpMs);
+        timedOut += stop.timedOut ? 1 : 0;
+    }
+
+    return {
+        {"trace", options_.tracePath},
+        {"slide", options_.slidePath},
+        {"polygons", options_.polygonPath},
+        {"cache", options_.warmCache ? "warm" : "cold"},
+        {"stop_hold_ms", options_.stopHoldMs},
+        {"sharp_timeout_ms", options_.sharpTimeoutMs},
+        {"samples", trace_.GetSampleCount()},
+        {"environment", environment},
+        {"summary", {
+            {"frames", frames_.size()},
+            {"wall_ms", done_ ? Milliseconds(measureEnd_ - measureStart_) : 0.0},
+            {"cpu_ms", Summarize(cpuMs)},
+            {"present_ms", Summarize(presentMs)},
+            {"tiles_requested", requested},
+            {"stops", stops_.size()},
+            {"stops_timed_out", timedOut},
+            {"time_to_sharp_ms", Summarize(timeToSharpMs)}
+        }},
+        {"frames", frames},
+        {"stops", stops}
+    };
+}
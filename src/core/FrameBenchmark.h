@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ViewportTrace.h"
+#include "json.hpp"
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// What pathview --bench-trace replays, against what, and where the report goes
+struct FrameBenchmarkOptions {
+    std::string tracePath;
+    std::string slidePath = "synthetic://100000x80000";
+    std::string polygonPath;   // Empty: no overlay
+    bool warmCache = false;    // Replay once unmeasured before the measured pass
+    std::string outputPath;    // Empty: standard output
+    double stopHoldMs = 250.0;        // A recorded view held this long is a stop
+    double sharpTimeoutMs = 10000.0;  // Give up on a stop after this long
+};
+
+// Frame-by-frame benchmark of a ViewportTrace replay.
+//
+// Unlike a timed replay (Application::StartTraceReplay), every recorded
+// sample is shown for exactly one frame, so every build draws the same
+// sequence of views whatever its frame rate. Samples the recording held
+// for at least stopHoldMs (and the last one) are stops: the replay stays
+// on them, drawing frames, until the view is sharp or sharpTimeoutMs has
+// passed, and the time from the stop's first frame to its first sharp one
+// is its time to sharp. A warm run replays the trace once unmeasured
+// first, so the measured pass starts with its tiles cached.
+//
+// The caller shows GetSample() each frame and reports the frame through
+// BeginFrame / EndFrame; ToJson() is the report.
+class FrameBenchmark {
+public:
+    using Clock = std::chrono::steady_clock;
+    using json = nlohmann::json;
+
+    struct Frame {
+        size_t sample = 0;
+        double cpuMs = 0.0;       // Update and Render, without Present
+        double presentMs = 0.0;   // SDL_RenderPresent: where the GPU or driver takes the frame
+        size_t visibleTiles = 0;  // Tiles of the view at its level
+        size_t displayedTiles = 0;  // Of those, drawn at their own level
+        size_t requestedTiles = 0;  // Submitted to the decode pool
+        bool settling = false;    // A repeated frame of a stop
+    };
+
+    struct Stop {
+        size_t sample = 0;
+        double timeToSharpMs = 0.0;
+        size_t frames = 0;
+        bool timedOut = false;
+    };
+
+    FrameBenchmark(const ViewportTrace& trace, const FrameBenchmarkOptions& options);
+
+    // Whether each sample of trace is a stop
+    static std::vector<bool> FindStops(const ViewportTrace& trace, double stopHoldMs);
+
+    const ViewportSample& GetSample() const { return trace_.GetSamples()[sample_]; }
+    bool IsMeasuring() const { return pass_ + 1 == passes_; }
+    bool IsDone() const { return done_; }
+
+    void BeginFrame(Clock::time_point now);
+    // Records the frame just drawn (unless warming up) and moves to the
+    // next sample, or stays on a stop that is not yet sharp
+    void EndFrame(Frame frame, bool sharp, Clock::time_point now);
+
+    const std::vector<Frame>& GetFrames() const { return frames_; }
+    const std::vector<Stop>& GetStops() const { return stops_; }
+
+    // Options, every measured frame and stop, and their summary;
+    // environment (slide, renderer, view size, ...) is included as is
+    json ToJson(const json& environment) const;
+
+private:
+    ViewportTrace trace_;
+    FrameBenchmarkOptions options_;
+    std::vector<bool> isStop_;
+    size_t sample_ = 0;
+    size_t pass_ = 0;
+    size_t passes_;
+    bool done_ = false;
+
+    Clock::time_point stopStart_;
+    Clock::time_point measureStart_;
+    Clock::time_point measureEnd_;
+    size_t stopFrames_ = 0;  // Frames drawn on the current stop so far
+
+    std::vector<Frame> frames_;
+    std::vector<Stop> stops_;
+};
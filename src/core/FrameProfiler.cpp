@@ -0,0 +1,123 @@
+#include "FrameProfiler.h"
+#include "Log.h"
+#include <fstream>
+
+namespace {
+
+void WriteJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+void WriteCompleteEvent(std::ostream& out, const char* name, uint64_t startUs, uint64_t endUs, bool& first) {
+    out << (first ? "\n" : ",\n") << "  {\"name\": ";
+    WriteJsonString(out, name);
+    out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << startUs
+        << ", \"dur\": " << (endUs - startUs) << "}";
+    first = false;
+}
+
+}  // namespace
+
+FrameProfiler::FrameProfiler()
+    : origin_(std::chrono::steady_clock::now())
+{
+    openZones_.reserve(MAX_DEPTH);
+}
+
+uint64_t FrameProfiler::NowUs() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin_).count());
+}
+
+void FrameProfiler::BeginFrame() {
+    if (inFrame_) {
+        EndFrame();
+    }
+    Frame& frame = frames_[current_];
+    frame.index = nextIndex_++;
+    frame.startUs = NowUs();
+    frame.endUs = frame.startUs;
+    frame.zones.clear();  // Keeps capacity
+    openZones_.clear();
+    ignoredDepth_ = 0;
+    inFrame_ = true;
+}
+
+void FrameProfiler::EndFrame() {
+    if (!inFrame_) {
+        return;
+    }
+    Frame& frame = frames_[current_];
+    frame.endUs = NowUs();
+    for (size_t index : openZones_) {
+        frame.zones[index].endUs = frame.endUs;
+    }
+    openZones_.clear();
+    inFrame_ = false;
+
+    current_ = (current_ + 1) % HISTORY_FRAMES;
+    if (frameCount_ < HISTORY_FRAMES) {
+        frameCount_++;
+    }
+}
+
+void FrameProfiler::BeginZone(const char* name) {
+    if (!inFrame_) {
+        return;
+    }
+    if (openZones_.size() >= MAX_DEPTH || ignoredDepth_ > 0) {
+        ignoredDepth_++;
+        return;
+    }
+    Frame& frame = frames_[current_];
+    uint64_t now = NowUs();
+    frame.zones.push_back({name, now, now, static_cast<uint32_t>(openZones_.size())});
+    openZones_.push_back(frame.zones.size() - 1);
+}
+
+void FrameProfiler::EndZone() {
+    if (!inFrame_) {
+        return;
+    }
+    if (ignoredDepth_ > 0) {
+        ignoredDepth_--;
+        return;
+    }
+    if (openZones_.empty()) {
+        return;
+    }
+    frames_[current_].zones[openZones_.back()].endUs = NowUs();
+    openZones_.pop_back();
+}
+
+const FrameProfiler::Frame& FrameProfiler::GetFrame(size_t age) const {
+    return frames_[(current_ + HISTORY_FRAMES - 1 - age) % HISTORY_FRAMES];
+}
+
+bool FrameProfiler::ExportChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        PATHVIEW_LOG_ERROR("FrameProfiler: Cannot write " << path);
+        return false;
+    }
+
+    // Complete ("X") events nest by time, so the viewer rebuilds the zone stacks
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (size_t age = frameCount_; age-- > 0; ) {
+        const Frame& frame = GetFrame(age);
+        WriteCompleteEvent(file, "Frame", frame.startUs, frame.endUs, first);
+        for (const Zone& zone : frame.zones) {
+            WriteCompleteEvent(file, zone.name, zone.startUs, zone.endUs, first);
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU frame profiler for the render thread.
+//
+// Each frame collects nested named zones (see ProfileZone) into a slot of a
+// ring buffer holding the last HISTORY_FRAMES frames. Slots keep their zone
+// storage, so after warm-up recording allocates nothing. Zone names must be
+// string literals (or otherwise outlive the profiler). Not thread-safe:
+// frames and zones are opened and closed on the render thread only.
+class FrameProfiler {
+public:
+    struct Zone {
+        const char* name;
+        uint64_t startUs;   // Since the profiler was created
+        uint64_t endUs;
+        uint32_t depth;     // 0 = directly inside the frame
+    };
+
+    struct Frame {
+        uint64_t index = 0;
+        uint64_t startUs = 0;
+        uint64_t endUs = 0;
+        std::vector<Zone> zones;  // In opening order
+
+        double GetDurationMs() const { return (endUs - startUs) / 1000.0; }
+    };
+
+    FrameProfiler();
+
+    void BeginFrame();
+    void EndFrame();  // Also closes zones left open
+
+    // Zones opened outside a frame, or nested deeper than MAX_DEPTH, are ignored
+    void BeginZone(const char* name);
+    void EndZone();
+
+    // Completed frames held, and one of them by age (0 = most recent)
+    size_t GetFrameCount() const { return frameCount_; }
+    const Frame& GetFrame(size_t age) const;
+
+    // Chrome trace event JSON (chrome://tracing, Perfetto) of every held frame
+    bool ExportChromeTrace(const std::string& path) const;
+
+    static constexpr size_t HISTORY_FRAMES = 240;
+    static constexpr uint32_t MAX_DEPTH = 16;
+
+private:
+    uint64_t NowUs() const;
+
+    std::chrono::steady_clock::time_point origin_;
+    std::array<Frame, HISTORY_FRAMES> frames_;
+    size_t current_ = 0;       // Slot being recorded
+    size_t frameCount_ = 0;
+    uint64_t nextIndex_ = 0;
+    bool inFrame_ = false;
+    std::vector<size_t> openZones_;  // Indices into the current frame's zones
+    uint32_t ignoredDepth_ = 0;      // Zones past MAX_DEPTH still to close
+};
+
+// Times its scope as a zone of the current frame; a null profiler records nothing
+class ProfileZone {
+public:
+    ProfileZone(FrameProfiler* profiler, const char* name)
+        : profiler_(profiler)
+    {
+        if (profiler_) {
+            profiler_->BeginZone(name);
+        }
+    }
+
+    ~ProfileZone() {
+        if (profiler_) {
+            profiler_->EndZone();
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    FrameProfiler* profiler_;
+};
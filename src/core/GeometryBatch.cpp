@@ -0,0 +1,95 @@
+#include "GeometryBatch.h"
+#include <cmath>
+
+void GeometryBatch::Clear() {
+    positions_.clear();
+    colors_.clear();
+    indices_.clear();
+}
+
+int GeometryBatch::AddVertices(const Vec2* points, size_t n, const Viewport& viewport, SDL_Color color) {
+    const int base = static_cast<int>(colors_.size());
+    positions_.resize(positions_.size() + 2 * n);
+    viewport.TransformToScreen(points, n, positions_.data() + 2 * size_t(base));
+    colors_.insert(colors_.end(), n, color);
+    return base;
+}
+
+int GeometryBatch::AddVertices(const float* xy, size_t n, const Viewport& viewport, SDL_Color color,
+                               double originX, double originY) {
+    const int base = static_cast<int>(colors_.size());
+    positions_.resize(positions_.size() + 2 * n);
+    viewport.TransformToScreen(xy, n, positions_.data() + 2 * size_t(base), originX, originY);
+    colors_.insert(colors_.end(), n, color);
+    return base;
+}
+
+void GeometryBatch::AddOutline(int base, size_t count, float width, SDL_Color color, bool closed) {
+    const float halfWidth = 0.5f * width;
+    const size_t edges = closed || count == 0 ? count : count - 1;
+    for (size_t i = 0; i < edges; ++i) {
+        // Read through the index: appending the quad may move the buffer
+        const size_t from = 2 * (size_t(base) + i);
+        const size_t to = 2 * (size_t(base) + (i + 1) % count);
+        AddEdge(positions_[from], positions_[from + 1], positions_[to], positions_[to + 1], halfWidth, color);
+    }
+}
+
+void GeometryBatch::AddOutline(const float* xy, size_t count, float width, SDL_Color color, bool closed) {
+    const float halfWidth = 0.5f * width;
+    const size_t edges = closed || count == 0 ? count : count - 1;
+    for (size_t i = 0; i < edges; ++i) {
+        const size_t to = 2 * ((i + 1) % count);
+        AddEdge(xy[2 * i], xy[2 * i + 1], xy[to], xy[to + 1], halfWidth, color);
+    }
+}
+
+void GeometryBatch::AddEdge(float x0, float y0, float x1, float y1, float halfWidth, SDL_Color color) {
+    const float length = std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    if (length <= 0.0f) return;
+    const float nx = -(y1 - y0) / length * halfWidth;
+    const float ny = (x1 - x0) / length * halfWidth;
+
+    const int first = static_cast<int>(colors_.size());
+    positions_.insert(positions_.end(), {x0 + nx, y0 + ny, x1 + nx, y1 + ny,
+                                         x0 - nx, y0 - ny, x1 - nx, y1 - ny});
+    colors_.insert(colors_.end(), 4, color);
+    indices_.insert(indices_.end(), {first, first + 1, first + 2, first + 1, first + 3, first + 2});
+}
+
+void GeometryBatch::AddDiscs(int base, size_t count, float radius, SDL_Color color) {
+    // The rim around the origin, once per call
+    constexpr float TWO_PI = 6.28318531f;
+    float ring[2 * DISC_SEGMENTS];
+    for (int i = 0; i < DISC_SEGMENTS; ++i) {
+        const float angle = TWO_PI * float(i) / DISC_SEGMENTS;
+        ring[2 * i] = radius * std::cos(angle);
+        ring[2 * i + 1] = radius * std::sin(angle);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const size_t center = 2 * (size_t(base) + i);
+        const float x = positions_[center];
+        const float y = positions_[center + 1];
+
+        const int first = static_cast<int>(colors_.size());
+        positions_.insert(positions_.end(), {x, y});
+        for (int j = 0; j < DISC_SEGMENTS; ++j) {
+            positions_.insert(positions_.end(), {x + ring[2 * j], y + ring[2 * j + 1]});
+        }
+        colors_.insert(colors_.end(), DISC_SEGMENTS + 1, color);
+        for (int j = 0; j < DISC_SEGMENTS; ++j) {
+            indices_.insert(indices_.end(), {first, first + 1 + j, first + 1 + (j + 1) % DISC_SEGMENTS});
+        }
+    }
+}
+
+void GeometryBatch::Draw(SDL_Renderer* renderer) const {
+    if (indices_.empty()) return;
+    SDL_RenderGeometryRaw(renderer, nullptr,
+                          positions_.data(), static_cast<int>(2 * sizeof(float)),
+                          colors_.data(), static_cast<int>(sizeof(SDL_Color)),
+                          nullptr, 0,
+                          static_cast<int>(colors_.size()),
+                          indices_.data(), static_cast<int>(indices_.size()),
+                          static_cast<int>(sizeof(int)));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Viewport.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Colored triangles gathered in screen space and drawn with one
+ * SDL_RenderGeometryRaw call
+ *
+ * Layers that draw many shapes a frame (cell polygons, annotations) append
+ * each shape's vertices, transformed by the viewport in one batch, then
+ * their fill triangles and outline quads. The buffers keep their capacity
+ * from frame to frame, so a steady view allocates nothing.
+ */
+class GeometryBatch {
+public:
+    void Clear();
+    bool Empty() const { return indices_.empty(); }
+    size_t GetVertexCount() const { return colors_.size(); }
+    size_t GetIndexCount() const { return indices_.size(); }
+
+    /**
+     * Append vertices in one color, transformed to screen space
+     * @return Batch index of the first, the base of the triangles over them
+     */
+    int AddVertices(const Vec2* points, size_t n, const Viewport& viewport, SDL_Color color);
+    // Interleaved x, y pairs stored relative to an origin (PolygonStore vertices)
+    int AddVertices(const float* xy, size_t n, const Viewport& viewport, SDL_Color color,
+                    double originX = 0.0, double originY = 0.0);
+
+    // Triangles over vertices added at base; indices count from base
+    template <typename Index>
+    void AddTriangles(int base, const Index* indices, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            indices_.push_back(base + static_cast<int>(indices[i]));
+        }
+    }
+
+    // Outline through count vertices added at base, closed unless a path:
+    // each edge a quad width screen pixels wide
+    void AddOutline(int base, size_t count, float width, SDL_Color color, bool closed = true);
+    // The same through count screen positions (x, y pairs) held elsewhere,
+    // e.g. kept geometry already mapped to the screen
+    void AddOutline(const float* xy, size_t count, float width, SDL_Color color, bool closed = true);
+
+    // A disc of radius screen pixels at each of count vertices added at
+    // base (vertex markers), a fan of DISC_SEGMENTS triangles
+    void AddDiscs(int base, size_t count, float radius, SDL_Color color);
+
+    void Draw(SDL_Renderer* renderer) const;
+
+    static constexpr int DISC_SEGMENTS = 12;
+
+private:
+    // One edge's quad, halfWidth either side (the coordinates are copies:
+    // appending may move positions_)
+    void AddEdge(float x0, float y0, float x1, float y1, float halfWidth, SDL_Color color);
+
+    std::vector<float> positions_;  // Interleaved screen x, y
+    std::vector<SDL_Color> colors_;
+    std::vector<int> indices_;
+};
@@ -0,0 +1,536 @@
+#include "HeatmapGrid.h"
+#include "json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <zlib.h>
+
+#ifdef PATHVIEW_HAS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PATHVIEW_HAS_BLOSC
+#include <blosc.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// Guards against corrupt or hostile metadata
+constexpr uint64_t MAX_CHUNK_BYTES = 256 * 1024 * 1024;
+constexpr uint32_t MAX_NPY_HEADER = 1024 * 1024;
+
+const uint8_t NPY_MAGIC[] = {0x93, 'N', 'U', 'M', 'P', 'Y'};
+
+const float NO_VALUE = std::numeric_limits<float>::quiet_NaN();
+
+bool ReadFileBytes(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamoff size = file.tellg();
+    if (size < 0 || static_cast<uint64_t>(size) > MAX_CHUNK_BYTES) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return file.read(reinterpret_cast<char*>(out.data()), size).good() || size == 0;
+}
+
+std::optional<json> ReadJson(const fs::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    json value = json::parse(file, nullptr, false);
+    if (value.is_discarded() || !value.is_object()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Inflate a zlib or gzip stream into exactly raw.size() bytes
+bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& raw) {
+    z_stream stream{};
+    if (inflateInit2(&stream, 32 + MAX_WBITS) != Z_OK) {  // Either header
+        return false;
+    }
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = raw.data();
+    stream.avail_out = static_cast<uInt>(raw.size());
+    const int result = inflate(&stream, Z_FINISH);
+    const size_t produced = stream.total_out;
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && produced == raw.size();
+}
+
+float HalfToFloat(uint16_t half) {
+    const uint32_t sign = uint32_t(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1Fu;
+    const uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0) {
+        // Zero or subnormal
+        const float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000u | (mantissa << 13);  // Inf or NaN
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+// Bytes of one stored value in host order
+template <size_t N>
+void LoadValue(const uint8_t* bytes, bool swap, uint8_t (&out)[N]) {
+    std::memcpy(out, bytes, N);
+    if (swap) {
+        std::reverse(out, out + N);
+    }
+}
+
+// Convert count stored values to float
+void ConvertValues(const uint8_t* bytes, size_t count, HeatmapGrid::Type type, bool bigEndian, float* out) {
+    const bool swap = bigEndian;  // Hosts are little-endian
+    switch (type) {
+        case HeatmapGrid::Type::Uint8:
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = bytes[i];
+            }
+            return;
+        case HeatmapGrid::Type::Float16:
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t value[2];
+                LoadValue(bytes + i * 2, swap, value);
+                out[i] = HalfToFloat(static_cast<uint16_t>(value[0] | (value[1] << 8)));
+            }
+            return;
+        case HeatmapGrid::Type::Float32:
+            if (!swap) {
+                std::memcpy(out, bytes, count * 4);
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t value[4];
+                LoadValue(bytes + i * 4, swap, value);
+                std::memcpy(out + i, value, 4);
+            }
+            return;
+        case HeatmapGrid::Type::Float64:
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t value[8];
+                LoadValue(bytes + i * 8, swap, value);
+                double wide;
+                std::memcpy(&wide, value, 8);
+                out[i] = static_cast<float>(wide);
+            }
+            return;
+    }
+}
+
+// The quoted value after a key of an .npy header dictionary
+std::string HeaderString(const std::string& header, const std::string& key) {
+    size_t position = header.find("'" + key + "'");
+    if (position == std::string::npos) {
+        return "";
+    }
+    position = header.find_first_of("'\"", position + key.size() + 2);
+    if (position == std::string::npos) {
+        return "";
+    }
+    const size_t end = header.find(header[position], position + 1);
+    return end == std::string::npos ? "" : header.substr(position + 1, end - position - 1);
+}
+
+std::string ToLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+// A Zarr fill value: a number, "NaN" / "Infinity", or null (no value)
+float ParseFillValue(const json& value) {
+    if (value.is_number()) {
+        return value.get<float>();
+    }
+    if (value.is_string()) {
+        const std::string text = value.get<std::string>();
+        if (text == "Infinity") return std::numeric_limits<float>::infinity();
+        if (text == "-Infinity") return -std::numeric_limits<float>::infinity();
+    }
+    return NO_VALUE;
+}
+
+}  // namespace
+
+HeatmapGrid::HeatmapGrid(const std::string& path) {
+    fs::path root(path);
+    const std::string name = root.filename().string();
+    if (name == ".zarray" || name == "zarr.json") {
+        root = root.parent_path();
+    }
+    std::error_code error;
+    bool opened = false;
+    if (fs::is_directory(root, error)) {
+        try {
+            opened = OpenZarr(root.string());
+        } catch (const json::exception& e) {
+            error_ = std::string("Invalid Zarr metadata: ") + e.what();
+        }
+    } else {
+        opened = OpenNpy(path);
+    }
+    if (!opened) {
+        width_ = 0;
+        height_ = 0;
+        file_.reset();
+        values_ = nullptr;
+    }
+}
+
+HeatmapGrid::~HeatmapGrid() = default;
+
+bool HeatmapGrid::IsHeatmapPath(const std::string& path) {
+    std::error_code error;
+    const fs::path root(path);
+    const std::string name = root.filename().string();
+    if (ToLower(root.extension().string()) == ".npy" || name == ".zarray") {
+        return fs::is_regular_file(root, error);
+    }
+    const fs::path directory = name == "zarr.json" ? root.parent_path() : root;
+    if (!fs::is_directory(directory, error)) {
+        return false;
+    }
+    if (fs::exists(directory / ".zarray", error)) {
+        return true;
+    }
+    std::optional<json> metadata = ReadJson(directory / "zarr.json");
+    return metadata && metadata->value("node_type", "") == "array";
+}
+
+float HeatmapGrid::GetNaturalMax() const {
+    return type_ == Type::Uint8 ? 255.0f : 1.0f;
+}
+
+bool HeatmapGrid::ParseTypeString(const std::string& text) {
+    // Byte order, kind, size: "<f4", ">f8", "|u1"
+    if (text.size() != 3 || (text[0] != '<' && text[0] != '>' && text[0] != '|' && text[0] != '=')) {
+        return false;
+    }
+    bigEndian_ = text[0] == '>';
+    const std::string kind = text.substr(1);
+    if (kind == "u1") {
+        type_ = Type::Uint8;
+    } else if (kind == "f2") {
+        type_ = Type::Float16;
+    } else if (kind == "f4") {
+        type_ = Type::Float32;
+    } else if (kind == "f8") {
+        type_ = Type::Float64;
+    } else {
+        return false;
+    }
+    bytesPerValue_ = static_cast<size_t>(text[2] - '0');
+    return true;
+}
+
+bool HeatmapGrid::OpenNpy(const std::string& path) {
+    file_ = std::make_unique<MappedFile>(path, MappedFile::Access::Random);
+    const uint8_t* data = file_->Data();
+    const uint64_t size = file_->Size();
+    if (!data) {
+        error_ = "Cannot open " + path;
+        return false;
+    }
+
+    // Magic, version, then the header length: 2 bytes in version 1, 4 after
+    if (size < 10 || std::memcmp(data, NPY_MAGIC, sizeof(NPY_MAGIC)) != 0 || data[6] < 1 || data[6] > 3) {
+        error_ = "Not a NumPy .npy file";
+        return false;
+    }
+    const uint32_t headerStart = data[6] == 1 ? 10 : 12;
+    if (size < headerStart) {
+        error_ = "Truncated .npy header";
+        return false;
+    }
+    const uint32_t headerLength = data[6] == 1
+        ? uint32_t(data[8]) | uint32_t(data[9]) << 8
+        : uint32_t(data[8]) | uint32_t(data[9]) << 8 | uint32_t(data[10]) << 16 | uint32_t(data[11]) << 24;
+    if (headerLength > MAX_NPY_HEADER || size < uint64_t(headerStart) + headerLength) {
+        error_ = "Truncated .npy header";
+        return false;
+    }
+    const std::string header(reinterpret_cast<const char*>(data + headerStart), headerLength);
+
+    if (!ParseTypeString(HeaderString(header, "descr"))) {
+        error_ = "Unsupported .npy type \"" + HeaderString(header, "descr") + "\" (need f2, f4, f8 or u1)";
+        return false;
+    }
+    size_t fortran = header.find("'fortran_order'");
+    fortran = fortran == std::string::npos ? fortran : header.find_first_not_of(" :", fortran + 15);
+    if (fortran != std::string::npos && header.compare(fortran, 4, "True") == 0) {
+        error_ = "Fortran-order .npy arrays are not supported";
+        return false;
+    }
+
+    // 'shape': (rows, columns)
+    size_t open = header.find("'shape'");
+    open = open == std::string::npos ? open : header.find('(', open);
+    const size_t close = open == std::string::npos ? open : header.find(')', open);
+    if (close == std::string::npos) {
+        error_ = "No shape in the .npy header";
+        return false;
+    }
+    std::vector<int64_t> shape;
+    const std::string dimensions = header.substr(open + 1, close - open - 1);
+    size_t position = 0;
+    while (position < dimensions.size()) {
+        const size_t digit = dimensions.find_first_of("0123456789", position);
+        if (digit == std::string::npos) {
+            break;
+        }
+        int64_t dimension = 0;
+        const char* first = dimensions.data() + digit;
+        const auto [end, ec] = std::from_chars(first, dimensions.data() + dimensions.size(), dimension);
+        if (ec != std::errc()) {
+            error_ = "Bad shape in the .npy header";
+            return false;
+        }
+        shape.push_back(dimension);
+        position = digit + static_cast<size_t>(end - first);
+    }
+    if (shape.size() != 2 || shape[0] <= 0 || shape[1] <= 0) {
+        error_ = "The .npy array is not a 2-D grid";
+        return false;
+    }
+
+    const uint64_t dataStart = uint64_t(headerStart) + headerLength;
+    // Divided rather than multiplied: a forged shape's product can wrap
+    if (static_cast<uint64_t>(shape[1]) > (size - dataStart) / bytesPerValue_ / static_cast<uint64_t>(shape[0])) {
+        error_ = "Truncated .npy data";
+        return false;
+    }
+    values_ = data + dataStart;
+    height_ = shape[0];
+    width_ = shape[1];
+    return true;
+}
+
+bool HeatmapGrid::OpenZarr(const std::string& directory) {
+    const fs::path root(directory);
+    directory_ = directory;
+
+    std::string codecName;
+    std::vector<int64_t> shape;
+    std::vector<int64_t> chunks;
+    json fillValue;
+    if (std::optional<json> metadata = ReadJson(root / "zarr.json")) {
+        if (metadata->value("node_type", "") != "array") {
+            error_ = directory + " is not a Zarr array";
+            return false;
+        }
+        const std::string dataType = metadata->value("data_type", "");
+        const std::string typeString = dataType == "uint8" ? "|u1" : dataType == "float16" ? "<f2"
+                                     : dataType == "float32" ? "<f4" : dataType == "float64" ? "<f8" : "";
+        if (!ParseTypeString(typeString)) {
+            error_ = "Unsupported Zarr data type \"" + dataType + "\"";
+            return false;
+        }
+        if (metadata->contains("chunk_grid") && (*metadata)["chunk_grid"].is_object()) {
+            const json& grid = (*metadata)["chunk_grid"];
+            if (grid.value("name", "") == "regular" && grid.contains("configuration")) {
+                chunks = grid["configuration"].value("chunk_shape", std::vector<int64_t>());
+            }
+        }
+        keyPrefix_ = "c";
+        separator_ = '/';
+        if (metadata->contains("chunk_key_encoding") && (*metadata)["chunk_key_encoding"].is_object()) {
+            const json& encoding = (*metadata)["chunk_key_encoding"];
+            if (encoding.value("name", "default") == "v2") {
+                keyPrefix_.clear();
+                separator_ = '.';
+            }
+            if (encoding.contains("configuration") && encoding["configuration"].is_object()) {
+                const std::string separator = encoding["configuration"].value("separator", "");
+                if (separator == "." || separator == "/") {
+                    separator_ = separator[0];
+                }
+            }
+        }
+        if (!keyPrefix_.empty()) {
+            keyPrefix_ += separator_;
+        }
+        for (const json& codec : metadata->value("codecs", json::array())) {
+            const std::string name = codec.is_object() ? codec.value("name", "") : "";
+            if (name == "bytes") {
+                if (codec.contains("configuration") && codec["configuration"].is_object()) {
+                    bigEndian_ = codec["configuration"].value("endian", "little") == "big";
+                }
+            } else if (codecName.empty()) {
+                codecName = name;
+            } else {
+                error_ = "Zarr array chains the codecs \"" + codecName + "\" and \"" + name + "\"";
+                return false;
+            }
+        }
+        fillValue = metadata->value("fill_value", json());
+        shape = metadata->value("shape", std::vector<int64_t>());
+    } else if (std::optional<json> metadata = ReadJson(root / ".zarray")) {
+        if (metadata->value("order", "C") != "C" ||
+            (metadata->contains("filters") && !(*metadata)["filters"].is_null())) {
+            error_ = "Zarr array uses F order or filters";
+            return false;
+        }
+        const std::string dtype = metadata->value("dtype", "");
+        if (!ParseTypeString(dtype)) {
+            error_ = "Unsupported Zarr dtype \"" + dtype + "\" (need f2, f4, f8 or u1)";
+            return false;
+        }
+        if (metadata->contains("compressor") && (*metadata)["compressor"].is_object()) {
+            codecName = (*metadata)["compressor"].value("id", "");
+        }
+        separator_ = metadata->value("dimension_separator", ".") == "/" ? '/' : '.';
+        fillValue = metadata->value("fill_value", json());
+        shape = metadata->value("shape", std::vector<int64_t>());
+        chunks = metadata->value("chunks", std::vector<int64_t>());
+    } else {
+        error_ = "No Zarr array metadata in " + directory;
+        return false;
+    }
+
+    if (codecName.empty()) {
+        codec_ = Codec::None;
+    } else if (codecName == "zlib") {
+        codec_ = Codec::Zlib;
+    } else if (codecName == "gzip") {
+        codec_ = Codec::Gzip;
+#ifdef PATHVIEW_HAS_ZSTD
+    } else if (codecName == "zstd") {
+        codec_ = Codec::Zstd;
+#endif
+#ifdef PATHVIEW_HAS_BLOSC
+    } else if (codecName == "blosc") {
+        codec_ = Codec::Blosc;
+#endif
+    } else {
+        error_ = "Zarr array uses the unsupported codec \"" + codecName + "\"";
+        return false;
+    }
+    fillValue_ = ParseFillValue(fillValue);
+
+    if (shape.size() != 2 || chunks.size() != 2 || shape[0] <= 0 || shape[1] <= 0 || chunks[0] <= 0 ||
+        chunks[1] <= 0 || uint64_t(chunks[0]) * uint64_t(chunks[1]) > MAX_CHUNK_BYTES / bytesPerValue_) {
+        error_ = "Zarr array is not a 2-D grid with a valid chunk shape";
+        return false;
+    }
+    height_ = shape[0];
+    width_ = shape[1];
+    chunkHeight_ = chunks[0];
+    chunkWidth_ = chunks[1];
+    return true;
+}
+
+bool HeatmapGrid::ReadChunk(int64_t row, int64_t column, std::vector<uint8_t>& raw) const {
+    thread_local std::vector<uint8_t> stored;
+    const std::string key = keyPrefix_ + std::to_string(row) + separator_ + std::to_string(column);
+    const std::string path = (fs::path(directory_) / key).string();
+    std::error_code error;
+    if (!fs::exists(path, error)) {
+        raw.clear();
+        return true;
+    }
+    if (!ReadFileBytes(path, stored)) {
+        return false;
+    }
+    chunkReadCount_++;
+
+    raw.resize(static_cast<size_t>(chunkWidth_ * chunkHeight_) * bytesPerValue_);
+    switch (codec_) {
+        case Codec::None:
+            if (stored.size() < raw.size()) {
+                return false;
+            }
+            std::memcpy(raw.data(), stored.data(), raw.size());
+            return true;
+        case Codec::Zlib:
+        case Codec::Gzip:
+            return Inflate(stored.data(), stored.size(), raw);
+        case Codec::Zstd:
+#ifdef PATHVIEW_HAS_ZSTD
+        {
+            const size_t size = ZSTD_decompress(raw.data(), raw.size(), stored.data(), stored.size());
+            return !ZSTD_isError(size) && size == raw.size();
+        }
+#else
+            return false;
+#endif
+        case Codec::Blosc:
+#ifdef PATHVIEW_HAS_BLOSC
+            return blosc_decompress_ctx(stored.data(), raw.data(), raw.size(), 1) ==
+                   static_cast<int>(raw.size());
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool HeatmapGrid::ReadRegion(int64_t x, int64_t y, int64_t width, int64_t height, float* values) const {
+    if (!IsOpen() || width <= 0 || height <= 0 || !values) {
+        return false;
+    }
+    std::fill(values, values + width * height, NO_VALUE);
+    const int64_t x0 = std::max<int64_t>(x, 0);
+    const int64_t y0 = std::max<int64_t>(y, 0);
+    const int64_t x1 = std::min(x + width, width_);
+    const int64_t y1 = std::min(y + height, height_);
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    // Mapped .npy: convert the covered part of each row where it lies
+    if (values_) {
+        const size_t count = static_cast<size_t>(x1 - x0);
+        for (int64_t row = y0; row < y1; ++row) {
+            const uint8_t* bytes = values_ + (static_cast<uint64_t>(row) * width_ + x0) * bytesPerValue_;
+            ConvertValues(bytes, count, type_, bigEndian_, values + (row - y) * width + (x0 - x));
+        }
+        return true;
+    }
+
+    thread_local std::vector<uint8_t> raw;
+    for (int64_t row = y0 / chunkHeight_; row * chunkHeight_ < y1; ++row) {
+        for (int64_t column = x0 / chunkWidth_; column * chunkWidth_ < x1; ++column) {
+            if (!ReadChunk(row, column, raw)) {
+                return false;
+            }
+            const int64_t chunkX = column * chunkWidth_;
+            const int64_t chunkY = row * chunkHeight_;
+            const int64_t copyX0 = std::max(chunkX, x0);
+            const int64_t copyX1 = std::min(chunkX + chunkWidth_, x1);
+            const size_t count = static_cast<size_t>(copyX1 - copyX0);
+            for (int64_t py = std::max(chunkY, y0); py < std::min(chunkY + chunkHeight_, y1); ++py) {
+                float* out = values + (py - y) * width + (copyX0 - x);
+                if (raw.empty()) {
+                    std::fill(out, out + count, fillValue_);
+                    continue;
+                }
+                const size_t element = static_cast<size_t>((py - chunkY) * chunkWidth_ + (copyX0 - chunkX));
+                ConvertValues(raw.data() + element * bytesPerValue_, count, type_, bigEndian_, out);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A 2-D grid of scalar values over a slide (model probabilities, scores),
+// read in place from a NumPy .npy file or a Zarr array on local disk.
+//
+// An .npy file is memory-mapped and read where it lies: a region read
+// converts just the rows it covers, so the grid costs address space, not
+// memory, however large it is. A Zarr array (v2 .zarray or v3 zarr.json)
+// decodes the chunks a region overlaps, a missing chunk reading as the
+// array's fill value. Chunks may be uncompressed, zlib or gzip; zstd and
+// blosc when the build has them (PATHVIEW_HAS_ZSTD, PATHVIEW_HAS_BLOSC).
+//
+// Values may be float16, float32, float64 or uint8, in either byte order;
+// arrays must be 2-D (rows, columns) in C order. Values are read as float,
+// NaN meaning no value.
+//
+// Thread-safe after construction.
+class HeatmapGrid {
+public:
+    explicit HeatmapGrid(const std::string& path);
+    ~HeatmapGrid();
+
+    HeatmapGrid(const HeatmapGrid&) = delete;
+    HeatmapGrid& operator=(const HeatmapGrid&) = delete;
+
+    // Whether path is an .npy file, or a directory holding Zarr array
+    // metadata or one of those metadata files
+    static bool IsHeatmapPath(const std::string& path);
+
+    bool IsOpen() const { return width_ > 0; }
+    // Why the grid could not be opened
+    const std::string& GetError() const { return error_; }
+
+    int64_t GetWidth() const { return width_; }
+    int64_t GetHeight() const { return height_; }
+    // Largest value the data type is meant to hold: 255 for uint8, else 1
+    // (probabilities)
+    float GetNaturalMax() const;
+
+    // Read a region into width * height values; cells outside the grid are
+    // NaN. Returns false on any failure; the values are then undefined.
+    bool ReadRegion(int64_t x, int64_t y, int64_t width, int64_t height, float* values) const;
+
+    size_t GetChunkReadCount() const { return chunkReadCount_.load(); }
+
+    enum class Type { Uint8, Float16, Float32, Float64 };
+
+private:
+    enum class Codec { None, Zlib, Gzip, Zstd, Blosc };
+
+    bool OpenNpy(const std::string& path);
+    bool OpenZarr(const std::string& directory);
+    // Type and byte order from a NumPy type string ("<f4", "|u1")
+    bool ParseTypeString(const std::string& text);
+
+    // One chunk decompressed into raw (C order); a missing chunk gives an
+    // empty raw
+    bool ReadChunk(int64_t row, int64_t column, std::vector<uint8_t>& raw) const;
+
+    std::string error_;
+    int64_t width_ = 0;
+    int64_t height_ = 0;
+    Type type_ = Type::Float32;
+    bool bigEndian_ = false;
+    size_t bytesPerValue_ = 4;
+
+    // .npy: the mapping and where its values start
+    std::unique_ptr<MappedFile> file_;
+    const uint8_t* values_ = nullptr;
+
+    // Zarr: chunk grid and how chunks are stored
+    std::string directory_;
+    int64_t chunkWidth_ = 0;
+    int64_t chunkHeight_ = 0;
+    Codec codec_ = Codec::None;
+    std::string keyPrefix_;
+    char separator_ = '.';
+    float fillValue_ = 0.0f;
+
+    mutable std::atomic<size_t> chunkReadCount_{0};
+};
@@ -0,0 +1,336 @@
+#include "HeatmapLayer.h"
+#include "TextureManager.h"
+#include "Viewport.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Nine evenly spaced stops of each colormap (0xRRGGBB), interpolated
+const uint32_t VIRIDIS_STOPS[9] = {
+    0x440154, 0x472D7B, 0x3B528B, 0x2C728E, 0x21918C, 0x28AE80, 0x5EC962, 0xADDC30, 0xFDE725,
+};
+const uint32_t MAGMA_STOPS[9] = {
+    0x000004, 0x1C1044, 0x4F127B, 0x812581, 0xB5367A, 0xE55964, 0xFB8761, 0xFEC287, 0xFCFDBF,
+};
+const uint32_t TURBO_STOPS[9] = {
+    0x30123B, 0x4662D7, 0x36AAF9, 0x1AE4B6, 0x72FE5E, 0xC8EF34, 0xFABA39, 0xF66B19, 0x7A0403,
+};
+const uint32_t GRAY_STOPS[9] = {
+    0x000000, 0x202020, 0x404040, 0x606060, 0x808080, 0x9F9F9F, 0xBFBFBF, 0xDFDFDF, 0xFFFFFF,
+};
+
+const uint32_t* ColormapStops(HeatmapLayer::Colormap colormap) {
+    switch (colormap) {
+        case HeatmapLayer::Colormap::Magma: return MAGMA_STOPS;
+        case HeatmapLayer::Colormap::Turbo: return TURBO_STOPS;
+        case HeatmapLayer::Colormap::Gray: return GRAY_STOPS;
+        case HeatmapLayer::Colormap::Viridis: break;
+    }
+    return VIRIDIS_STOPS;
+}
+
+}  // namespace
+
+const char* HeatmapLayer::GetColormapName(Colormap colormap) {
+    switch (colormap) {
+        case Colormap::Viridis: return "Viridis";
+        case Colormap::Magma: return "Magma";
+        case Colormap::Turbo: return "Turbo";
+        case Colormap::Gray: return "Gray";
+    }
+    return "Viridis";
+}
+
+HeatmapLayer::HeatmapLayer(SDL_Renderer* renderer, size_t maxTextures)
+    : renderer_(renderer)
+    , maxTextures_(std::max<size_t>(1, maxTextures)) {
+    BuildLookup();
+}
+
+HeatmapLayer::~HeatmapLayer() {
+    StopWorker();
+    DropTextures();
+}
+
+bool HeatmapLayer::Load(const std::string& path, double texelSize) {
+    auto grid = std::make_unique<HeatmapGrid>(path);
+    if (!grid->IsOpen()) {
+        error_ = grid->GetError();
+        return false;
+    }
+
+    Clear();
+    const float naturalMax = grid->GetNaturalMax();
+    PATHVIEW_LOG_INFO("Heatmap " << path << ": " << grid->GetWidth() << " x " << grid->GetHeight()
+                      << " cells, " << texelSize << " slide pixels each");
+    pyramid_ = std::make_unique<HeatmapPyramid>(std::move(grid), texelSize);
+    path_ = path;
+    rangeLow_ = 0.0f;
+    rangeHigh_ = naturalMax;
+    threshold_ = DEFAULT_THRESHOLD * naturalMax;
+    StartWorker();
+    return true;
+}
+
+void HeatmapLayer::Clear() {
+    StopWorker();
+    DropTextures();
+    pyramid_.reset();
+    path_.clear();
+    error_.clear();
+    pendingUploads_ = false;
+}
+
+void HeatmapLayer::SetRange(float low, float high) {
+    if (low == rangeLow_ && high == rangeHigh_) {
+        return;
+    }
+    rangeLow_ = low;
+    rangeHigh_ = high;
+    DropTextures();
+}
+
+void HeatmapLayer::SetThreshold(float threshold) {
+    if (threshold == threshold_) {
+        return;
+    }
+    threshold_ = threshold;
+    DropTextures();
+}
+
+void HeatmapLayer::SetColormap(Colormap colormap) {
+    if (colormap == colormap_) {
+        return;
+    }
+    colormap_ = colormap;
+    BuildLookup();
+    DropTextures();
+}
+
+void HeatmapLayer::SetReduction(Reduction reduction) {
+    if (reduction == reduction_) {
+        return;
+    }
+    reduction_ = reduction;
+    DropTextures();
+}
+
+void HeatmapLayer::BuildLookup() {
+    const uint32_t* stops = ColormapStops(colormap_);
+    for (int i = 0; i < 256; ++i) {
+        const float position = i / 255.0f * 8.0f;
+        const int stop = std::min(7, static_cast<int>(position));
+        const float t = position - stop;
+        uint32_t pixel = 0xFF000000u;  // Opaque: opacity comes at compositing
+        for (int shift = 0; shift <= 16; shift += 8) {
+            const float a = static_cast<float>((stops[stop] >> shift) & 0xFF);
+            const float b = static_cast<float>((stops[stop + 1] >> shift) & 0xFF);
+            pixel |= static_cast<uint32_t>(a + (b - a) * t + 0.5f) << shift;
+        }
+        lookup_[i] = pixel;
+    }
+}
+
+uint32_t HeatmapLayer::MapValue(float value) const {
+    if (std::isnan(value) || value < threshold_) {
+        return 0;
+    }
+    const float span = rangeHigh_ - rangeLow_;
+    const float t = span > 0.0f ? (value - rangeLow_) / span : (value >= rangeHigh_ ? 1.0f : 0.0f);
+    const int index = static_cast<int>(std::max(0.0f, std::min(1.0f, t)) * 255.0f + 0.5f);
+    return lookup_[index];
+}
+
+void HeatmapLayer::DropTextures() {
+    for (auto& pair : textures_) {
+        SDL_DestroyTexture(pair.second.texture);
+    }
+    textures_.clear();
+    lru_.clear();
+}
+
+void HeatmapLayer::Touch(Resident& resident, const TileKey& key) {
+    lru_.erase(resident.lruPosition);
+    lru_.push_front(key);
+    resident.lruPosition = lru_.begin();
+}
+
+SDL_Texture* HeatmapLayer::Upload(const TileKey& key, const HeatmapPyramid::Tile& tile) {
+    // Make room: the least recently drawn go first
+    while (textures_.size() >= maxTextures_ && !lru_.empty()) {
+        auto it = textures_.find(lru_.back());
+        SDL_DestroyTexture(it->second.texture);
+        textures_.erase(it);
+        lru_.pop_back();
+    }
+
+    const float* values = reduction_ == Reduction::Max ? tile.Max() : tile.Min();
+    pixels_.resize(HeatmapPyramid::TILE_TEXELS);
+    for (size_t i = 0; i < HeatmapPyramid::TILE_TEXELS; ++i) {
+        pixels_[i] = MapValue(values[i]);
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT, SDL_TEXTUREACCESS_STATIC,
+                                             HeatmapPyramid::TILE_SIZE, HeatmapPyramid::TILE_SIZE);
+    if (!texture) {
+        PATHVIEW_LOG_ERROR("Failed to create heatmap tile texture: " << SDL_GetError());
+        return nullptr;
+    }
+    const int pitch = HeatmapPyramid::TILE_SIZE * static_cast<int>(sizeof(uint32_t));
+    if (SDL_UpdateTexture(texture, nullptr, pixels_.data(), pitch) != 0) {
+        PATHVIEW_LOG_ERROR("Failed to upload heatmap tile: " << SDL_GetError());
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    TextureManager::ApplyPremultipliedBlendMode(texture);
+    // Each texel is one cell (or its bound): show them as they are
+    SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+
+    lru_.push_front(key);
+    textures_.emplace(key, Resident{texture, lru_.begin()});
+    return texture;
+}
+
+SDL_Texture* HeatmapLayer::Acquire(const TileKey& key, bool upload) {
+    auto it = textures_.find(key);
+    if (it != textures_.end()) {
+        Touch(it->second, key);
+        return it->second.texture;
+    }
+    if (!upload) {
+        return nullptr;
+    }
+    std::shared_ptr<const HeatmapPyramid::Tile> tile = pyramid_->FindTile(key.level, key.tileX, key.tileY);
+    if (!tile) {
+        wanted_.push_back(key);
+        return nullptr;
+    }
+    if (tile->Empty()) {
+        return nullptr;
+    }
+    if (uploadsThisFrame_ >= MAX_UPLOADS_PER_FRAME) {
+        pendingUploads_ = true;
+        return nullptr;
+    }
+    ++uploadsThisFrame_;
+    return Upload(key, *tile);
+}
+
+void HeatmapLayer::Render(const Viewport& viewport) {
+    uploadsThisFrame_ = 0;
+    pendingUploads_ = false;
+    wanted_.clear();
+    if (!pyramid_) {
+        return;
+    }
+
+    const int32_t level = pyramid_->ChooseLevel(viewport.GetZoom());
+    const Rect visible = viewport.GetVisibleRegion();
+    pyramid_->GetTilesInRegion(level, visible, visibleTiles_);
+
+    // Nearest the view center first, so the worker and a budget-limited
+    // frame fill the middle
+    const double span = pyramid_->GetTexelSize(level) * HeatmapPyramid::TILE_SIZE;
+    const double centerX = (visible.x + visible.width * 0.5) / span - 0.5;
+    const double centerY = (visible.y + visible.height * 0.5) / span - 0.5;
+    std::sort(visibleTiles_.begin(), visibleTiles_.end(),
+              [centerX, centerY](const HeatmapPyramid::TileCoord& a, const HeatmapPyramid::TileCoord& b) {
+                  const double da = (a.x - centerX) * (a.x - centerX) + (a.y - centerY) * (a.y - centerY);
+                  const double db = (b.x - centerX) * (b.x - centerX) + (b.y - centerY) * (b.y - centerY);
+                  return da < db;
+              });
+
+    const Uint8 alpha = static_cast<Uint8>(std::max(0.0f, std::min(1.0f, opacity_)) * 255);
+    auto draw = [&](SDL_Texture* texture, const SDL_Rect* part, const HeatmapPyramid::TileCoord& tile) {
+        const Rect bounds = pyramid_->GetTileBounds(level, tile.x, tile.y);
+        const Vec2 topLeft = viewport.SlideToScreen(Vec2(bounds.Left(), bounds.Top()));
+        const Vec2 bottomRight = viewport.SlideToScreen(Vec2(bounds.Right(), bounds.Bottom()));
+        const SDL_FRect destination = {
+            static_cast<float>(topLeft.x), static_cast<float>(topLeft.y),
+            static_cast<float>(bottomRight.x - topLeft.x), static_cast<float>(bottomRight.y - topLeft.y)
+        };
+        // Premultiplied pixels: opacity scales color and alpha alike
+        SDL_SetTextureColorMod(texture, alpha, alpha, alpha);
+        SDL_SetTextureAlphaMod(texture, alpha);
+        SDL_RenderCopyF(renderer_, texture, part, &destination);
+    };
+
+    for (const HeatmapPyramid::TileCoord& tile : visibleTiles_) {
+        if (SDL_Texture* texture = Acquire({level, tile.x, tile.y}, true)) {
+            draw(texture, nullptr, tile);
+            continue;
+        }
+
+        // Not made or uploaded yet: stretch the part of a resident coarser tile
+        for (int32_t up = 1; up <= MAX_FALLBACK_LEVELS && level + up < pyramid_->GetLevelCount(); ++up) {
+            const TileKey parent = {level + up, tile.x >> up, tile.y >> up};
+            SDL_Texture* texture = Acquire(parent, false);
+            if (texture) {
+                const int32_t partSpan = HeatmapPyramid::TILE_SIZE >> up;
+                const int32_t mask = (1 << up) - 1;
+                const SDL_Rect part = {(tile.x & mask) * partSpan, (tile.y & mask) * partSpan, partSpan, partSpan};
+                draw(texture, &part, tile);
+                break;
+            }
+        }
+    }
+
+    // The worker makes what is missing, replacing the last frame's wishes
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    requests_.swap(wanted_);
+    if (!requests_.empty()) {
+        requestReady_.notify_one();
+    }
+}
+
+void HeatmapLayer::StartWorker() {
+    stopWorker_ = false;
+    worker_ = std::thread(&HeatmapLayer::WorkerLoop, this);
+}
+
+void HeatmapLayer::StopWorker() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        stopWorker_ = true;
+        requests_.clear();
+    }
+    requestReady_.notify_one();
+    worker_.join();
+}
+
+void HeatmapLayer::WorkerLoop() {
+    bool reportedFailure = false;
+    while (true) {
+        TileKey key{};
+        {
+            std::unique_lock<std::mutex> lock(requestMutex_);
+            requestReady_.wait(lock, [this]() { return stopWorker_ || !requests_.empty(); });
+            if (stopWorker_) {
+                return;
+            }
+            key = requests_.front();
+            requests_.erase(requests_.begin());
+        }
+
+        // A coarse tile may read a large part of the grid
+        if (pyramid_->GetTile(key.level, key.tileX, key.tileY)) {
+            if (tileReadyCallback_) {
+                tileReadyCallback_();
+            }
+        } else if (!reportedFailure) {
+            PATHVIEW_LOG_ERROR("Failed to read heatmap tile " << key.ToString() << " of " << path_);
+            reportedFailure = true;
+        }
+    }
+}
+
+size_t HeatmapLayer::GetMemoryUsage() const {
+    const size_t textureBytes = HeatmapPyramid::TILE_TEXELS * sizeof(uint32_t);
+    return (pyramid_ ? pyramid_->GetMemoryUsage() : 0) + textures_.size() * textureBytes +
+           pixels_.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "HeatmapPyramid.h"
+#include <SDL2/SDL.h>
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Viewport;
+
+// Draws a probability heatmap (HeatmapGrid: .npy or Zarr) over the slide,
+// next to the cell overlay: the pyramid tiles in view at the level that
+// matches the zoom, colored through a colormap.
+//
+// Tiles are made on a worker thread, the ones in view nearest the center
+// first, and drawn once made; meanwhile a resident coarser tile stands in.
+// The CPU side keeps float values in the pyramid's bounded cache.
+// SDL_Renderer has no float textures or shaders, so the colormap, value
+// range and threshold are applied through a 256-entry lookup as a tile is
+// uploaded; only the tiles drawn recently are resident, at most
+// maxTextures of them, and a change to the mapping drops them all so the
+// tiles in view are uploaded again. Opacity is applied when compositing.
+class HeatmapLayer {
+public:
+    enum class Colormap { Viridis, Magma, Turbo, Gray };
+    // Which bound of a coarse texel is drawn
+    enum class Reduction { Max, Min };
+
+    static constexpr int COLORMAP_COUNT = 4;
+    static const char* GetColormapName(Colormap colormap);
+
+    explicit HeatmapLayer(SDL_Renderer* renderer, size_t maxTextures = DEFAULT_MAX_TEXTURES);
+    ~HeatmapLayer();
+
+    HeatmapLayer(const HeatmapLayer&) = delete;
+    HeatmapLayer& operator=(const HeatmapLayer&) = delete;
+
+    /**
+     * Open a heatmap and show it; the value range resets to the data
+     * type's (0 to 1 for floats)
+     * @param texelSize Slide pixels per grid cell
+     * @return false (see GetError()) if the grid cannot be opened
+     */
+    bool Load(const std::string& path, double texelSize);
+    void Clear();
+    bool HasHeatmap() const { return pyramid_ != nullptr; }
+    const HeatmapPyramid* GetPyramid() const { return pyramid_.get(); }
+    const std::string& GetPath() const { return path_; }
+    const std::string& GetError() const { return error_; }
+
+    // Called on the worker thread whenever a tile in view is made
+    void SetTileReadyCallback(std::function<void()> callback) { tileReadyCallback_ = std::move(callback); }
+
+    void SetVisible(bool visible) { visible_ = visible; }
+    bool IsVisible() const { return visible_; }
+    void SetOpacity(float opacity) { opacity_ = opacity; }
+    float GetOpacity() const { return opacity_; }
+
+    // Values from low to high span the colormap
+    void SetRange(float low, float high);
+    float GetRangeLow() const { return rangeLow_; }
+    float GetRangeHigh() const { return rangeHigh_; }
+    // Values below are not drawn
+    void SetThreshold(float threshold);
+    float GetThreshold() const { return threshold_; }
+    void SetColormap(Colormap colormap);
+    Colormap GetColormap() const { return colormap_; }
+    void SetReduction(Reduction reduction);
+    Reduction GetReduction() const { return reduction_; }
+
+    // Color of a value under the current mapping (premultiplied
+    // TILE_PIXEL_FORMAT, 0 when not drawn)
+    uint32_t MapValue(float value) const;
+
+    // Queue the tiles in view that are not made, upload the made ones
+    // missing (within the upload budget) and draw them
+    void Render(const Viewport& viewport);
+
+    // Made tiles in view are waiting for upload budget: another frame is
+    // needed (tiles still being made call the tile ready callback instead)
+    bool HasPendingUploads() const { return pendingUploads_; }
+
+    // Pyramid cache plus resident textures
+    size_t GetMemoryUsage() const;
+
+    static constexpr size_t DEFAULT_MAX_TEXTURES = 256;  // 64 MB of RGBA tiles
+    static constexpr int MAX_UPLOADS_PER_FRAME = 8;
+    static constexpr int32_t MAX_FALLBACK_LEVELS = 3;
+    // A new heatmap leaves out the lowest tenth of its range (background)
+    static constexpr float DEFAULT_THRESHOLD = 0.1f;
+
+private:
+    struct Resident {
+        SDL_Texture* texture;
+        std::list<TileKey>::iterator lruPosition;
+    };
+
+    void BuildLookup();
+    // The texture of a tile, uploading it if made and the budget allows;
+    // null if not resident (yet) or nothing to draw
+    SDL_Texture* Acquire(const TileKey& key, bool upload);
+    SDL_Texture* Upload(const TileKey& key, const HeatmapPyramid::Tile& tile);
+    void Touch(Resident& resident, const TileKey& key);
+    void DropTextures();
+
+    void StartWorker();
+    void StopWorker();
+    void WorkerLoop();
+
+    SDL_Renderer* renderer_;
+    size_t maxTextures_;
+    std::unique_ptr<HeatmapPyramid> pyramid_;
+    std::string path_;
+    std::string error_;
+
+    bool visible_ = true;
+    float opacity_ = 0.6f;
+    float rangeLow_ = 0.0f;
+    float rangeHigh_ = 1.0f;
+    float threshold_ = 0.0f;
+    Colormap colormap_ = Colormap::Viridis;
+    Reduction reduction_ = Reduction::Max;
+    std::array<uint32_t, 256> lookup_;  // Colormap, premultiplied
+
+    std::unordered_map<TileKey, Resident, TileKeyHash> textures_;
+    std::list<TileKey> lru_;  // Most recently drawn first
+    std::vector<uint32_t> pixels_;  // Reused upload buffer
+    std::vector<HeatmapPyramid::TileCoord> visibleTiles_;
+    std::vector<TileKey> wanted_;  // In view but not made, this frame
+    int uploadsThisFrame_ = 0;
+    bool pendingUploads_ = false;
+
+    // Tiles the last frame wanted made, in order; the worker takes the first
+    std::thread worker_;
+    mutable std::mutex requestMutex_;
+    std::condition_variable requestReady_;
+    std::vector<TileKey> requests_;
+    bool stopWorker_ = false;
+    std::function<void()> tileReadyCallback_;
+};
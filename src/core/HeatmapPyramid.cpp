@@ -0,0 +1,174 @@
+#include "HeatmapPyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int32_t HALF_TILE = HeatmapPyramid::TILE_SIZE / 2;
+
+// Bookkeeping of a cached tile beyond its values
+constexpr size_t TILE_OVERHEAD = sizeof(HeatmapPyramid::Tile) + sizeof(TileKey) * 2 + 64;
+
+int32_t TilesAcross(int64_t cells, int32_t level) {
+    const int64_t span = int64_t(HeatmapPyramid::TILE_SIZE) << level;
+    return static_cast<int32_t>((cells + span - 1) / span);
+}
+
+}  // namespace
+
+HeatmapPyramid::HeatmapPyramid(std::unique_ptr<HeatmapGrid> grid, double texelSize, size_t maxCacheBytes)
+    : grid_(std::move(grid))
+    , texelSize_(texelSize > 0.0 ? texelSize : 1.0)
+    , maxCacheBytes_(maxCacheBytes) {
+    while (levelCount_ < 31 && (GetTileColumns(levelCount_ - 1) > 1 || GetTileRows(levelCount_ - 1) > 1)) {
+        ++levelCount_;
+    }
+}
+
+int32_t HeatmapPyramid::GetTileColumns(int32_t level) const {
+    return TilesAcross(grid_->GetWidth(), level);
+}
+
+int32_t HeatmapPyramid::GetTileRows(int32_t level) const {
+    return TilesAcross(grid_->GetHeight(), level);
+}
+
+int32_t HeatmapPyramid::ChooseLevel(double zoom) const {
+    int32_t level = 0;
+    while (level + 1 < GetLevelCount() && GetTexelSize(level + 1) * zoom <= 1.0) {
+        ++level;
+    }
+    return level;
+}
+
+void HeatmapPyramid::GetTilesInRegion(int32_t level, const Rect& region, std::vector<TileCoord>& out) const {
+    out.clear();
+    if (level < 0 || level >= GetLevelCount()) {
+        return;
+    }
+    const double tileSpan = GetTexelSize(level) * TILE_SIZE;
+    const int32_t firstX = std::max(0, static_cast<int32_t>(std::floor(region.Left() / tileSpan)));
+    const int32_t lastX = std::min(GetTileColumns(level) - 1,
+                                   static_cast<int32_t>(std::floor(region.Right() / tileSpan)));
+    const int32_t firstY = std::max(0, static_cast<int32_t>(std::floor(region.Top() / tileSpan)));
+    const int32_t lastY = std::min(GetTileRows(level) - 1,
+                                   static_cast<int32_t>(std::floor(region.Bottom() / tileSpan)));
+    for (int32_t y = firstY; y <= lastY; ++y) {
+        for (int32_t x = firstX; x <= lastX; ++x) {
+            out.push_back({x, y});
+        }
+    }
+}
+
+Rect HeatmapPyramid::GetTileBounds(int32_t level, int32_t x, int32_t y) const {
+    const double tileSpan = GetTexelSize(level) * TILE_SIZE;
+    return Rect(x * tileSpan, y * tileSpan, tileSpan, tileSpan);
+}
+
+std::shared_ptr<const HeatmapPyramid::Tile> HeatmapPyramid::FindTile(int32_t level, int32_t x, int32_t y) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tiles_.find({level, x, y});
+    if (it == tiles_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lruPosition);
+    return it->second.tile;
+}
+
+std::shared_ptr<const HeatmapPyramid::Tile> HeatmapPyramid::GetTile(int32_t level, int32_t x, int32_t y) {
+    if (level < 0 || level >= GetLevelCount() || x < 0 || y < 0 || x >= GetTileColumns(level) ||
+        y >= GetTileRows(level)) {
+        return nullptr;
+    }
+    if (std::shared_ptr<const Tile> tile = FindTile(level, x, y)) {
+        return tile;
+    }
+    std::shared_ptr<const Tile> tile = MakeTile(level, x, y);
+    if (tile) {
+        Insert({level, x, y}, tile);
+    }
+    return tile;
+}
+
+std::shared_ptr<const HeatmapPyramid::Tile> HeatmapPyramid::MakeTile(int32_t level, int32_t x, int32_t y) {
+    auto tile = std::make_shared<Tile>();
+    const float none = std::numeric_limits<float>::quiet_NaN();
+
+    if (level == 0) {
+        tile->min.resize(TILE_TEXELS);
+        if (!grid_->ReadRegion(int64_t(x) * TILE_SIZE, int64_t(y) * TILE_SIZE, TILE_SIZE, TILE_SIZE,
+                               tile->min.data())) {
+            return nullptr;
+        }
+        if (std::all_of(tile->min.begin(), tile->min.end(), [](float value) { return std::isnan(value); })) {
+            tile->min = std::vector<float>();
+        }
+        return tile;
+    }
+
+    // Each child fills a quadrant, 2x2 of its texels to one
+    bool empty = true;
+    for (int32_t dy = 0; dy < 2; ++dy) {
+        for (int32_t dx = 0; dx < 2; ++dx) {
+            const int32_t childX = x * 2 + dx;
+            const int32_t childY = y * 2 + dy;
+            if (childX >= GetTileColumns(level - 1) || childY >= GetTileRows(level - 1)) {
+                continue;
+            }
+            std::shared_ptr<const Tile> child = GetTile(level - 1, childX, childY);
+            if (!child) {
+                return nullptr;
+            }
+            if (child->Empty()) {
+                continue;
+            }
+            if (empty) {
+                tile->min.assign(TILE_TEXELS, none);
+                tile->max.assign(TILE_TEXELS, none);
+                empty = false;
+            }
+            const float* childMin = child->Min();
+            const float* childMax = child->Max();
+            for (int32_t row = 0; row < HALF_TILE; ++row) {
+                const size_t out = size_t(dy * HALF_TILE + row) * TILE_SIZE + size_t(dx * HALF_TILE);
+                const size_t in = size_t(row * 2) * TILE_SIZE;
+                for (int32_t column = 0; column < HALF_TILE; ++column) {
+                    const size_t a = in + size_t(column * 2);
+                    const size_t b = a + TILE_SIZE;
+                    // fmin / fmax pass over NaN
+                    tile->min[out + column] = std::fmin(std::fmin(childMin[a], childMin[a + 1]),
+                                                        std::fmin(childMin[b], childMin[b + 1]));
+                    tile->max[out + column] = std::fmax(std::fmax(childMax[a], childMax[a + 1]),
+                                                        std::fmax(childMax[b], childMax[b + 1]));
+                }
+            }
+        }
+    }
+    return tile;
+}
+
+void HeatmapPyramid::Insert(const TileKey& key, std::shared_ptr<const Tile> tile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++tilesMade_;
+    if (tiles_.count(key)) {
+        return;  // Made meanwhile on another thread
+    }
+    const size_t bytes = tile->GetMemoryUsage() + TILE_OVERHEAD;
+
+    // Make room: the least recently used go first
+    while (cacheBytes_ + bytes > maxCacheBytes_ && !lru_.empty()) {
+        auto it = tiles_.find(lru_.back());
+        cacheBytes_ -= it->second.tile->GetMemoryUsage() + TILE_OVERHEAD;
+        tiles_.erase(it);
+        lru_.pop_back();
+    }
+    lru_.push_front(key);
+    tiles_.emplace(key, Entry{std::move(tile), lru_.begin()});
+    cacheBytes_ += bytes;
+}
+
+size_t HeatmapPyramid::GetMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cacheBytes_;
+}
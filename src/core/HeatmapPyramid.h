@@ -0,0 +1,106 @@
+#pragma once
+
+#include "HeatmapGrid.h"
+#include "TileKey.h"
+#include "Viewport.h"  // For Rect
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Min/max mip pyramid of a HeatmapGrid, built lazily one tile at a time.
+//
+// Level 0 is the grid itself cut into TILE_SIZE x TILE_SIZE tiles, the grid
+// anchored at the slide origin with texelSize slide pixels (level 0) per
+// cell. Every further level halves the resolution until the grid fits one
+// tile; each of its texels keeps the least and the greatest value of the
+// 2x2 below it, so a hot spot of a single cell survives to the coarsest
+// level when drawn by maximum (and a cold one by minimum). NaN cells are
+// skipped; a texel over nothing but NaN is NaN.
+//
+// A tile is made when first asked for: level 0 from a grid read, a coarser
+// one from its four children, made the same way. Made tiles are kept in an
+// LRU bounded by maxCacheBytes, so only what the view has touched costs
+// memory; a whole-grid overview reads the grid once and keeps the coarse
+// levels.
+//
+// Thread-safe: tiles may be made on one thread and looked up on another.
+class HeatmapPyramid {
+public:
+    static constexpr int32_t TILE_SIZE = 256;
+    static constexpr size_t TILE_TEXELS = size_t(TILE_SIZE) * TILE_SIZE;
+    static constexpr size_t DEFAULT_CACHE_BYTES = size_t(256) * 1024 * 1024;
+
+    struct TileCoord {
+        int32_t x;
+        int32_t y;
+    };
+
+    // TILE_TEXELS lowest and highest values, row-major; both empty when
+    // every texel is NaN. A level 0 tile keeps its values once, in min.
+    struct Tile {
+        std::vector<float> min;
+        std::vector<float> max;
+
+        bool Empty() const { return min.empty(); }
+        const float* Min() const { return min.data(); }
+        const float* Max() const { return max.empty() ? min.data() : max.data(); }
+        size_t GetMemoryUsage() const { return (min.capacity() + max.capacity()) * sizeof(float); }
+    };
+
+    /**
+     * @param grid An open grid
+     * @param texelSize Slide pixels per grid cell at level 0
+     */
+    HeatmapPyramid(std::unique_ptr<HeatmapGrid> grid, double texelSize,
+                   size_t maxCacheBytes = DEFAULT_CACHE_BYTES);
+
+    const HeatmapGrid& GetGrid() const { return *grid_; }
+
+    double GetTexelSize(int32_t level = 0) const { return texelSize_ * double(int64_t(1) << level); }
+    int32_t GetLevelCount() const { return levelCount_; }
+    int32_t GetTileColumns(int32_t level) const;
+    int32_t GetTileRows(int32_t level) const;
+
+    // Coarsest level whose texels are still no larger than a screen pixel
+    // at this zoom (screen pixels per slide pixel)
+    int32_t ChooseLevel(double zoom) const;
+
+    // Tiles of a level overlapping a slide region
+    void GetTilesInRegion(int32_t level, const Rect& region, std::vector<TileCoord>& out) const;
+
+    // Slide area of a tile
+    Rect GetTileBounds(int32_t level, int32_t x, int32_t y) const;
+
+    // A tile already made, or null; never reads
+    std::shared_ptr<const Tile> FindTile(int32_t level, int32_t x, int32_t y) const;
+
+    // A tile, made (with the finer tiles it needs) if not cached; null if
+    // out of range or the grid cannot be read
+    std::shared_ptr<const Tile> GetTile(int32_t level, int32_t x, int32_t y);
+
+    size_t GetMemoryUsage() const;
+    size_t GetTilesMade() const { return tilesMade_; }
+
+private:
+    struct Entry {
+        std::shared_ptr<const Tile> tile;
+        std::list<TileKey>::iterator lruPosition;
+    };
+
+    std::shared_ptr<const Tile> MakeTile(int32_t level, int32_t x, int32_t y);
+    void Insert(const TileKey& key, std::shared_ptr<const Tile> tile);
+
+    std::unique_ptr<HeatmapGrid> grid_;
+    double texelSize_;
+    int32_t levelCount_ = 1;
+    size_t maxCacheBytes_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<TileKey, Entry, TileKeyHash> tiles_;
+    mutable std::list<TileKey> lru_;  // Most recently used first
+    size_t cacheBytes_ = 0;
+    size_t tilesMade_ = 0;
+};
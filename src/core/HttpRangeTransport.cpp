@@ -0,0 +1,111 @@
+#include "HttpRangeTransport.h"
+#include "httplib.h"  // From cpp-mcp/common/httplib.h
+#include "Log.h"
+#include <cstdlib>
+#include <cstring>
+
+HttpRangeTransport::HttpRangeTransport(const std::string& url) {
+    size_t schemeEnd = url.find("://");
+    size_t pathStart = schemeEnd == std::string::npos ? std::string::npos : url.find('/', schemeEnd + 3);
+    origin_ = url.substr(0, pathStart);
+    target_ = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+}
+
+HttpRangeTransport::~HttpRangeTransport() = default;
+
+bool HttpRangeTransport::IsUrl(const std::string& path) {
+    return path.rfind("http://", 0) == 0 || path.rfind("https://", 0) == 0;
+}
+
+std::unique_ptr<httplib::Client> HttpRangeTransport::AcquireClient() {
+    {
+        std::lock_guard<std::mutex> lock(clientMutex_);
+        if (!idleClients_.empty()) {
+            std::unique_ptr<httplib::Client> client = std::move(idleClients_.back());
+            idleClients_.pop_back();
+            return client;
+        }
+    }
+
+    auto client = std::make_unique<httplib::Client>(origin_);
+    if (!client->is_valid()) {
+        PATHVIEW_LOG_ERROR("HttpRangeTransport: unsupported URL " << origin_ << target_);
+        return nullptr;
+    }
+    client->set_keep_alive(true);
+    client->set_follow_location(true);
+    client->set_connection_timeout(CONNECT_TIMEOUT_SECONDS, 0);
+    client->set_read_timeout(READ_TIMEOUT_SECONDS, 0);
+    return client;
+}
+
+void HttpRangeTransport::ReleaseClient(std::unique_ptr<httplib::Client> client) {
+    std::lock_guard<std::mutex> lock(clientMutex_);
+    idleClients_.push_back(std::move(client));
+}
+
+bool HttpRangeTransport::GetRange(uint64_t first, uint64_t last, std::string& body, uint64_t* totalSize) {
+    // Offsets are into the stored bytes, never a compressed encoding
+    httplib::Headers headers = {
+        {"Range", "bytes=" + std::to_string(first) + "-" + std::to_string(last)},
+        {"Accept-Encoding", "identity"}
+    };
+
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        std::unique_ptr<httplib::Client> client = AcquireClient();
+        if (!client) {
+            return false;
+        }
+
+        auto result = client->Get(target_, headers);
+        if (!result) {
+            // Connection-level failure: drop the connection and retry
+            PATHVIEW_LOG_ERROR("HttpRangeTransport: request failed (error "
+                               << static_cast<int>(result.error()) << ")");
+            continue;
+        }
+
+        // A 200 means the server ignored Range and is sending the whole file
+        if (result->status != 206) {
+            PATHVIEW_LOG_ERROR("HttpRangeTransport: expected 206 for a range request, got "
+                               << result->status);
+            return false;
+        }
+
+        if (totalSize) {
+            // Content-Range: bytes first-last/total
+            std::string contentRange = result->get_header_value("Content-Range");
+            size_t slash = contentRange.find('/');
+            *totalSize = slash == std::string::npos
+                ? 0 : std::strtoull(contentRange.c_str() + slash + 1, nullptr, 10);
+        }
+        body = std::move(result->body);
+        ReleaseClient(std::move(client));
+        return true;
+    }
+    return false;
+}
+
+bool HttpRangeTransport::GetSize(uint64_t& size) {
+    // A one-byte ranged GET rather than HEAD: it checks that ranges are
+    // served, and presigned object-storage URLs are often signed for GET only
+    std::string body;
+    uint64_t total = 0;
+    if (!GetRange(0, 0, body, &total) || total == 0) {
+        return false;
+    }
+    size = total;
+    return true;
+}
+
+bool HttpRangeTransport::Fetch(uint64_t offset, uint64_t size, uint8_t* out) {
+    if (size == 0) {
+        return true;
+    }
+    std::string body;
+    if (!GetRange(offset, offset + size - 1, body, nullptr) || body.size() != size) {
+        return false;
+    }
+    std::memcpy(out, body.data(), body.size());
+    return true;
+}
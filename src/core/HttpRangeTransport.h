@@ -0,0 +1,49 @@
+#pragma once
+
+#include "RemoteFile.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Forward declare httplib::Client
+namespace httplib {
+    class Client;
+}
+
+// RangeTransport over HTTP range requests (object storage, any server
+// that answers Range with 206), using cpp-httplib's client. https:// needs
+// a build with OpenSSL (CPPHTTPLIB_OPENSSL_SUPPORT).
+//
+// Each concurrent fetch borrows a keep-alive connection from a pool that
+// grows to the peak number of concurrent readers, like SlideLoader's
+// OpenSlide read handles.
+class HttpRangeTransport : public RangeTransport {
+public:
+    explicit HttpRangeTransport(const std::string& url);
+    ~HttpRangeTransport() override;
+
+    // Whether a slide path names a remote slide
+    static bool IsUrl(const std::string& path);
+
+    bool GetSize(uint64_t& size) override;
+    bool Fetch(uint64_t offset, uint64_t size, uint8_t* out) override;
+
+private:
+    std::unique_ptr<httplib::Client> AcquireClient();
+    void ReleaseClient(std::unique_ptr<httplib::Client> client);
+
+    // Ranged GET of [first, last]; fills body and the total size reported
+    // by Content-Range
+    bool GetRange(uint64_t first, uint64_t last, std::string& body, uint64_t* totalSize);
+
+    std::string origin_;  // scheme://host[:port]
+    std::string target_;  // Path and query
+
+    std::mutex clientMutex_;
+    std::vector<std::unique_ptr<httplib::Client>> idleClients_;
+
+    static constexpr int CONNECT_TIMEOUT_SECONDS = 10;
+    static constexpr int READ_TIMEOUT_SECONDS = 30;
+    static constexpr int MAX_ATTEMPTS = 2;  // Retry once: keep-alive connections get dropped
+};
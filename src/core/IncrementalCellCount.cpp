@@ -0,0 +1,107 @@
+#include "IncrementalCellCount.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+
+namespace {
+
+// Whether the edge from -> to crosses the ray from (x, y) towards +x, with
+// the operands in the order ray casting the outline uses them, so each
+// edge answers the same both ways
+bool Crosses(const Vec2& from, const Vec2& to, double x, double y) {
+    return ((to.y > y) != (from.y > y)) &&
+           (x < (from.x - to.x) * (y - to.y) / (from.y - to.y) + to.x);
+}
+
+}  // namespace
+
+void IncrementalCellCount::Clear() {
+    polygons_ = nullptr;
+    polygonCount_ = 0;
+    vertexCount_ = 0;
+    inside_.clear();
+    counts_.clear();
+    total_ = 0;
+}
+
+void IncrementalCellCount::Update(const std::vector<Vec2>& outline, const PolygonStore* polygons,
+                                  const PolygonIndex* index) {
+    if (!polygons) {
+        Clear();
+        return;
+    }
+    if (polygons != polygons_ || polygons->Size() != polygonCount_ || outline.size() < vertexCount_) {
+        Clear();
+        polygons_ = polygons;
+        polygonCount_ = polygons->Size();
+        inside_.assign(polygonCount_, false);
+    }
+    if (index && index->Size() != polygonCount_) {
+        index = nullptr;  // Still filling: scan instead
+    }
+
+    // Up to two vertices contain nothing; the third adds the first triangle
+    for (size_t last = std::max<size_t>(vertexCount_, 2); last < outline.size(); ++last) {
+        ToggleTriangle(outline, last, index);
+    }
+    vertexCount_ = outline.size();
+}
+
+bool IncrementalCellCount::IsCurrent(size_t vertexCount, const PolygonStore* polygons) const {
+    return polygons && polygons == polygons_ && polygons->Size() == polygonCount_ && vertexCount == vertexCount_;
+}
+
+void IncrementalCellCount::ToggleTriangle(const std::vector<Vec2>& outline, size_t last, const PolygonIndex* index) {
+    const Vec2& first = outline[0];
+    const Vec2& previous = outline[last - 1];
+    const Vec2& added = outline[last];
+
+    const double minX = std::min({first.x, previous.x, added.x});
+    const double maxX = std::max({first.x, previous.x, added.x});
+    const double minY = std::min({first.y, previous.y, added.y});
+    const double maxY = std::max({first.y, previous.y, added.y});
+    const Rect bounds(minX, minY, maxX - minX, maxY - minY);
+
+    // The new edges, and the closing edge they replace
+    auto flips = [&](uint32_t polygon) {
+        if (polygons_->GetVertexCount(polygon) == 0 || !polygons_->Intersects(polygon, bounds)) {
+            return false;
+        }
+        const Vec2 centroid = polygons_->GetCentroid(polygon);
+        // Parity of the three crossings
+        return (Crosses(previous, added, centroid.x, centroid.y) != Crosses(added, first, centroid.x, centroid.y)) !=
+               Crosses(previous, first, centroid.x, centroid.y);
+    };
+
+    if (index) {
+        index->QueryRegion(bounds, candidates_);
+        for (uint32_t polygon : candidates_) {
+            if (flips(polygon)) {
+                Toggle(polygon, polygons_->GetClassId(polygon));
+            }
+        }
+        return;
+    }
+
+    const uint32_t polygonCount = static_cast<uint32_t>(polygonCount_);
+    for (uint32_t polygon = 0; polygon < polygonCount; ++polygon) {
+        if (flips(polygon)) {
+            Toggle(polygon, polygons_->GetClassId(polygon));
+        }
+    }
+}
+
+void IncrementalCellCount::Toggle(uint32_t polygon, int classId) {
+    if (inside_[polygon]) {
+        inside_[polygon] = false;
+        --total_;
+        auto it = counts_.find(classId);
+        if (--it->second == 0) {
+            counts_.erase(it);
+        }
+    } else {
+        inside_[polygon] = true;
+        ++total_;
+        ++counts_[classId];
+    }
+}
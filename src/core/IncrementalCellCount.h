@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Viewport.h"  // For Vec2
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class PolygonIndex;
+class PolygonStore;
+
+// Cell counts of an outline being drawn, kept current as vertices are
+// appended, e.g. for live counts while an annotation is drawn.
+//
+// Appending v_n to the closed outline v_0..v_n-1 swaps the closing edge
+// (v_n-1, v_0) for (v_n-1, v_n) and (v_n, v_0). Under the even-odd rule a
+// point is inside the new outline exactly when its inside-ness flips
+// within the triangle (v_0, v_n-1, v_n), so only the cells the spatial index
+// finds around that triangle are visited. Their centroids are tested with
+// the same edge crossings as ray casting the whole outline, so the counts
+// are the same as counting the finished outline (see PolygonMask).
+class IncrementalCellCount {
+public:
+    // Forget the outline and the counts
+    void Clear();
+
+    /**
+     * Bring the counts up to date with the outline
+     * @param outline Vertices so far; those beyond the ones already counted
+     *        are added. A shorter outline, or a store that changed since
+     *        (another pointer or size), is counted again from the start.
+     * @param polygons Cells to count; null clears the counts
+     * @param index Spatial index over polygons, or null to scan them
+     */
+    void Update(const std::vector<Vec2>& outline, const PolygonStore* polygons, const PolygonIndex* index);
+
+    // The counts are those of the first vertexCount vertices of an outline
+    // over this store
+    bool IsCurrent(size_t vertexCount, const PolygonStore* polygons) const;
+
+    // Class ID -> cells whose centroid is inside (classes without cells left out)
+    const std::map<int, int>& GetCounts() const { return counts_; }
+    int GetTotal() const { return total_; }
+
+private:
+    // Flip the cells whose centroid is inside the triangle (v_0, v_last-1, v_last)
+    void ToggleTriangle(const std::vector<Vec2>& outline, size_t last, const PolygonIndex* index);
+    void Toggle(uint32_t polygon, int classId);
+
+    const PolygonStore* polygons_ = nullptr;
+    size_t polygonCount_ = 0;
+    size_t vertexCount_ = 0;
+    std::vector<bool> inside_;  // By store index
+    std::map<int, int> counts_;
+    int total_ = 0;
+
+    // Reused between triangles
+    std::vector<uint32_t> candidates_;
+};
@@ -0,0 +1,29 @@
+#include "InputCoalescer.h"
+#include <cmath>
+
+void InputCoalescer::AddPan(int deltaX, int deltaY) {
+    pending_.panX += deltaX;
+    pending_.panY += deltaY;
+}
+
+void InputCoalescer::AddWheel(double steps, int cursorX, int cursorY) {
+    pending_.wheel += steps;
+    pending_.wheelX = cursorX;
+    pending_.wheelY = cursorY;
+}
+
+void InputCoalescer::AddMotion(int x, int y) {
+    pending_.moved = true;
+    pending_.cursorX = x;
+    pending_.cursorY = y;
+}
+
+InputCoalescer::Frame InputCoalescer::Take() {
+    Frame frame = pending_;
+    pending_ = Frame();
+    return frame;
+}
+
+double InputCoalescer::ZoomFactor(double steps) {
+    return std::pow(WHEEL_ZOOM_STEP, steps);
+}
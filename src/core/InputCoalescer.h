@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * Mouse input gathered over one pass of the event queue, so the view
+ * moves once per frame however many events arrive
+ *
+ * High polling rate mice send several motion events a frame and trackpads
+ * a stream of fractional wheel steps; applied one by one, each would move
+ * the viewport (and the set of tiles it wants) again. Motion while panning
+ * is summed in screen pixels and wheel steps are summed as given, then
+ * Take() hands the frame's totals over at once. Events that depend on
+ * where the view is (clicks, keys) take the pending input first, so the
+ * order of effects is the order of events.
+ */
+class InputCoalescer {
+public:
+    struct Frame {
+        int panX = 0;         // Screen pixels dragged
+        int panY = 0;
+        double wheel = 0.0;   // Wheel steps, positive away from the user
+        int wheelX = 0;       // Cursor at the last wheel step
+        int wheelY = 0;
+        bool moved = false;   // Cursor moved; at cursorX, cursorY
+        int cursorX = 0;
+        int cursorY = 0;
+
+        bool HasPan() const { return panX != 0 || panY != 0; }
+    };
+
+    void AddPan(int deltaX, int deltaY);
+    void AddWheel(double steps, int cursorX, int cursorY);
+    void AddMotion(int x, int y);
+
+    bool Empty() const { return !pending_.HasPan() && pending_.wheel == 0.0 && !pending_.moved; }
+
+    // The input gathered since the last call
+    Frame Take();
+
+    // Zoom for a number of wheel steps: WHEEL_ZOOM_STEP per step, so steps
+    // summed over a frame zoom as far as taken one at a time
+    static double ZoomFactor(double steps);
+
+    static constexpr double WHEEL_ZOOM_STEP = 1.1;
+
+private:
+    Frame pending_;
+};
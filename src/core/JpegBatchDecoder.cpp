@@ -0,0 +1,176 @@
+#include "JpegBatchDecoder.h"
+
+#ifdef PATHVIEW_HAS_NVJPEG
+
+#include "PixelConvert.h"
+#include "Log.h"
+#include <cuda_runtime_api.h>
+#include <nvjpeg.h>
+#include <mutex>
+
+namespace {
+
+// nvJPEG batched decode into interleaved BGR in device memory, copied back
+// through a pinned staging buffer and widened to ARGB on the way out.
+// SDL_Renderer offers no CUDA interop, so the pixels still pass through
+// host memory; the entropy decode, IDCT and colour conversion move to the
+// GPU.
+class NvJpegBatchDecoder : public JpegBatchDecoder {
+public:
+    static std::unique_ptr<JpegBatchDecoder> Create() {
+        int deviceCount = 0;
+        if (cudaGetDeviceCount(&deviceCount) != cudaSuccess || deviceCount == 0) {
+            return nullptr;
+        }
+        std::unique_ptr<NvJpegBatchDecoder> decoder(new NvJpegBatchDecoder());
+        if (nvjpegCreateSimple(&decoder->handle_) != NVJPEG_STATUS_SUCCESS) {
+            decoder->handle_ = nullptr;
+            return nullptr;
+        }
+        if (nvjpegJpegStateCreate(decoder->handle_, &decoder->state_) != NVJPEG_STATUS_SUCCESS) {
+            decoder->state_ = nullptr;
+            return nullptr;
+        }
+        if (cudaStreamCreateWithFlags(&decoder->stream_, cudaStreamNonBlocking) != cudaSuccess) {
+            decoder->stream_ = nullptr;
+            return nullptr;
+        }
+        return decoder;
+    }
+
+    ~NvJpegBatchDecoder() override {
+        if (deviceBuffer_) {
+            cudaFree(deviceBuffer_);
+        }
+        if (hostBuffer_) {
+            cudaFreeHost(hostBuffer_);
+        }
+        if (stream_) {
+            cudaStreamDestroy(stream_);
+        }
+        if (state_) {
+            nvjpegJpegStateDestroy(state_);
+        }
+        if (handle_) {
+            nvjpegDestroy(handle_);
+        }
+    }
+
+    const char* GetName() const override { return "nvJPEG"; }
+
+    void DecodeBatch(std::vector<JpegDecodeJob>& jobs) override {
+        // One device state and staging buffer: batches are serialized,
+        // which also keeps the GPU from thrashing between workers
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::vector<size_t> accepted;
+        std::vector<size_t> offsets;
+        size_t totalBytes = 0;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const JpegDecodeJob& job = jobs[i];
+            int components = 0;
+            nvjpegChromaSubsampling_t subsampling;
+            int widths[NVJPEG_MAX_COMPONENT];
+            int heights[NVJPEG_MAX_COMPONENT];
+            if (nvjpegGetImageInfo(handle_, job.data, job.size, &components, &subsampling,
+                                   widths, heights) != NVJPEG_STATUS_SUCCESS ||
+                components != 3 || widths[0] != job.width || heights[0] != job.height) {
+                continue;
+            }
+            accepted.push_back(i);
+            offsets.push_back(totalBytes);
+            totalBytes += static_cast<size_t>(job.width * job.height) * 3;
+        }
+        if (accepted.empty() || !Reserve(totalBytes)) {
+            return;
+        }
+
+        int batchSize = static_cast<int>(accepted.size());
+        if (nvjpegDecodeBatchedInitialize(handle_, state_, batchSize, 1, NVJPEG_OUTPUT_BGRI) !=
+            NVJPEG_STATUS_SUCCESS) {
+            return;
+        }
+        std::vector<const unsigned char*> data(accepted.size());
+        std::vector<size_t> lengths(accepted.size());
+        std::vector<nvjpegImage_t> outputs(accepted.size());
+        for (size_t k = 0; k < accepted.size(); ++k) {
+            const JpegDecodeJob& job = jobs[accepted[k]];
+            data[k] = job.data;
+            lengths[k] = job.size;
+            outputs[k] = nvjpegImage_t{};
+            outputs[k].channel[0] = deviceBuffer_ + offsets[k];
+            outputs[k].pitch[0] = static_cast<size_t>(job.width) * 3;
+        }
+        if (nvjpegDecodeBatched(handle_, state_, data.data(), lengths.data(), outputs.data(), stream_) !=
+                NVJPEG_STATUS_SUCCESS ||
+            cudaMemcpyAsync(hostBuffer_, deviceBuffer_, totalBytes, cudaMemcpyDeviceToHost, stream_) !=
+                cudaSuccess ||
+            cudaStreamSynchronize(stream_) != cudaSuccess) {
+            return;
+        }
+
+        for (size_t k = 0; k < accepted.size(); ++k) {
+            JpegDecodeJob& job = jobs[accepted[k]];
+            const uint8_t* src = hostBuffer_ + offsets[k];
+            for (int64_t y = 0; y < job.rowCount; ++y) {
+                PixelConvert::ConvertRow<PixelLayout::BGR24, PixelLayout::ARGB32, AlphaMode::Keep>(
+                    src + y * job.width * 3, job.pixels + y * job.stride, static_cast<size_t>(job.width));
+            }
+            job.decoded = true;
+        }
+    }
+
+private:
+    NvJpegBatchDecoder() = default;
+
+    bool Reserve(size_t bytes) {
+        if (bytes <= capacity_) {
+            return true;
+        }
+        if (deviceBuffer_) {
+            cudaFree(deviceBuffer_);
+            deviceBuffer_ = nullptr;
+        }
+        if (hostBuffer_) {
+            cudaFreeHost(hostBuffer_);
+            hostBuffer_ = nullptr;
+        }
+        capacity_ = 0;
+        if (cudaMalloc(reinterpret_cast<void**>(&deviceBuffer_), bytes) != cudaSuccess) {
+            deviceBuffer_ = nullptr;
+            return false;
+        }
+        if (cudaMallocHost(reinterpret_cast<void**>(&hostBuffer_), bytes) != cudaSuccess) {
+            hostBuffer_ = nullptr;
+            return false;
+        }
+        capacity_ = bytes;
+        return true;
+    }
+
+    std::mutex mutex_;
+    nvjpegHandle_t handle_ = nullptr;
+    nvjpegJpegState_t state_ = nullptr;
+    cudaStream_t stream_ = nullptr;
+    uint8_t* deviceBuffer_ = nullptr;
+    uint8_t* hostBuffer_ = nullptr;  // Pinned
+    size_t capacity_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<JpegBatchDecoder> JpegBatchDecoder::CreateHardware() {
+    std::unique_ptr<JpegBatchDecoder> decoder = NvJpegBatchDecoder::Create();
+    if (!decoder) {
+        PATHVIEW_LOG_INFO("nvJPEG: no usable CUDA device");
+    }
+    return decoder;
+}
+
+#else
+
+std::unique_ptr<JpegBatchDecoder> JpegBatchDecoder::CreateHardware() {
+    return nullptr;
+}
+
+#endif  // PATHVIEW_HAS_NVJPEG
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One tile for a JpegBatchDecoder: a complete JPEG stream (tables
+// included) and where its pixels go
+struct JpegDecodeJob {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint32_t* pixels = nullptr;  // Native ARGB words, as OpenSlide returns
+    int64_t stride = 0;          // In pixels
+    int64_t width = 0;           // Expected decoded size
+    int64_t height = 0;
+    int64_t rowCount = 0;        // Rows to keep; the rest are dropped
+    bool decoded = false;        // Set by the decoder
+};
+
+// Decode backend that takes a batch of tiles at once, for hardware
+// decoders whose per-call overhead only pays off across many tiles.
+//
+// TiffTileReader hands it the in-place tiles of each region read and
+// decodes whatever it leaves undecoded with libjpeg-turbo, so a backend
+// may skip any job (unsupported sampling, unexpected size, device error).
+class JpegBatchDecoder {
+public:
+    virtual ~JpegBatchDecoder() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Decode what it can, setting decoded on each finished job.
+    // Must be thread-safe.
+    virtual void DecodeBatch(std::vector<JpegDecodeJob>& jobs) = 0;
+
+    // Hardware backend for this build and machine (nvJPEG on NVIDIA GPUs
+    // with PATHVIEW_HAS_NVJPEG), or nullptr if there is none
+    static std::unique_ptr<JpegBatchDecoder> CreateHardware();
+};
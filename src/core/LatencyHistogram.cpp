@@ -0,0 +1,120 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+
+namespace {
+
+int HighestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    int exponent = HighestBit(micros) - SUB_BUCKET_BITS;
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    uint64_t mantissa = (micros >> exponent) - SUB_BUCKETS;
+    return static_cast<size_t>(SUB_BUCKETS * (exponent + 1) + mantissa);
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / SUB_BUCKETS) - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << exponent;
+}
+
+uint64_t LatencyHistogram::BucketWidth(size_t index) {
+    return index < SUB_BUCKETS ? 1 : 1ull << (index / SUB_BUCKETS - 1);
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+    buckets_[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t previous = max_.load(std::memory_order_relaxed);
+    while (micros > previous && !max_.compare_exchange_weak(previous, micros, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::GetPercentile(double fraction) const {
+    uint64_t total = GetCount();
+    if (total == 0) {
+        return 0;
+    }
+
+    // Rank of the sample we want (1-based), at least the first
+    uint64_t rank = static_cast<uint64_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total) + 0.5);
+    rank = std::max<uint64_t>(1, rank);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t midpoint = BucketLowerBound(i) + BucketWidth(i) / 2;
+            return std::min(midpoint, GetMax());
+        }
+    }
+    return GetMax();  // Racing writers: count ran ahead of the buckets
+}
+
+double LatencyHistogram::GetMean() const {
+    uint64_t count = GetCount();
+    return count > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(count) : 0.0;
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+void TilePipelineStats::RecordSince(TileStage stage, Clock::time_point start) {
+    if (start == Clock::time_point{}) {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    Record(stage, static_cast<uint64_t>(std::max<int64_t>(0, elapsed)));
+}
+
+void TilePipelineStats::Reset() {
+    for (auto& stage : stages_) {
+        stage.Reset();
+    }
+}
+
+const char* TilePipelineStats::StageName(TileStage stage) {
+    switch (stage) {
+        case TileStage::Submit:      return "submit";
+        case TileStage::QueueWait:   return "queue_wait";
+        case TileStage::Fetch:       return "fetch";
+        case TileStage::Decompress:  return "decompress";
+        case TileStage::DiskRead:    return "disk_read";
+        case TileStage::Decode:      return "decode";
+        case TileStage::Synthesize:  return "synthesize";
+        case TileStage::Compress:    return "compress";
+        case TileStage::CacheInsert: return "cache_insert";
+        case TileStage::Upload:      return "upload";
+        case TileStage::FirstDraw:   return "first_draw";
+        default:                     return "unknown";
+    }
+}
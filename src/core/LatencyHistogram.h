@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free log-linear latency histogram (HDR-style), in microseconds.
+//
+// Values below 2^SUB_BUCKET_BITS get exact buckets; above that each power
+// of two is split into 2^SUB_BUCKET_BITS equal buckets, so every recorded
+// value is known to within 1/16 (about 6%) up to ~19 hours. Record() is a
+// few relaxed atomic adds and may be called from any thread; readers see a
+// consistent-enough snapshot for reporting.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t micros);
+
+    // Value at or below which the given fraction (0..1) of samples fall,
+    // as the midpoint of its bucket; 0 when empty
+    uint64_t GetPercentile(double fraction) const;
+
+    uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t GetMax() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t GetBucketCount(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    double GetMean() const;
+
+    void Reset();
+
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 32;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS * (MAX_EXPONENT + 2);
+
+    // Bucket for a value, and the range of values that bucket holds
+    static size_t BucketIndex(uint64_t micros);
+    static uint64_t BucketLowerBound(size_t index);
+    static uint64_t BucketWidth(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Stages of a tile's life, each timed into its own histogram
+enum class TileStage : size_t {
+    Submit,       // Render thread: one frame's SubmitRequests call
+    QueueWait,    // Submitted -> picked up by a worker (or the read-ahead stage)
+    Fetch,        // Read-ahead of a batch's tile bytes (SlideLoader::FetchRegion)
+    Decompress,   // CompressedTileCache::Load hit
+    DiskRead,     // DiskTileCache::Load hit
+    Decode,       // openslide_read_region (one per tile or coalesced region)
+    Synthesize,   // Building a synthesized level's tile from its children
+    Compress,     // CompressedTileCache::Store of a freshly built tile
+    CacheInsert,  // TileCache::InsertTile
+    Upload,       // Texture upload on the render thread
+    FirstDraw,    // Submitted -> first drawn (time to first pixel)
+    Count
+};
+
+// Pipeline-wide stage histograms, shared by the renderer and its workers
+class TilePipelineStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void Record(TileStage stage, uint64_t micros) { Get(stage).Record(micros); }
+
+    // Records the time elapsed since start; an unset start is skipped
+    void RecordSince(TileStage stage, Clock::time_point start);
+
+    LatencyHistogram& Get(TileStage stage) { return stages_[static_cast<size_t>(stage)]; }
+    const LatencyHistogram& Get(TileStage stage) const { return stages_[static_cast<size_t>(stage)]; }
+
+    void Reset();
+
+    // Short snake_case name used by the UI and the perf.tile_stats IPC method
+    static const char* StageName(TileStage stage);
+
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(TileStage::Count);
+
+private:
+    std::array<LatencyHistogram, STAGE_COUNT> stages_;
+};
@@ -0,0 +1,146 @@
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+Log& Log::Instance() {
+    static Log* log = new Log();
+    return *log;
+}
+
+Log::Log() : slots_(new Slot[CAPACITY]) {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    // Outlives main(); lines queued by then are flushed at exit
+    std::thread(&Log::Run, this).detach();
+    std::atexit([] { Log::Instance().Flush(); });
+}
+
+void Log::Write(LogLevel level, const std::string& line) {
+    // Claim the slot at the enqueue position: free once its sequence has
+    // come round to the position, still unread a lap behind (full)
+    size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots_[position & (CAPACITY - 1)];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (lag == 0) {
+            if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = enqueuePosition_.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t length = std::min(line.size(), MAX_LINE_BYTES);
+    std::memcpy(slot->text, line.data(), length);
+    slot->length = static_cast<uint16_t>(length);
+    slot->level = level;
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    if (sleeping_.load()) {
+        wake_.notify_one();
+    }
+}
+
+bool Log::Dequeue(LogLevel& level, std::string& line) {
+    Slot& slot = slots_[dequeuePosition_ & (CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) {
+        return false;
+    }
+    level = slot.level;
+    line.assign(slot.text, slot.length);
+    slot.sequence.store(dequeuePosition_ + CAPACITY, std::memory_order_release);
+    ++dequeuePosition_;
+    return true;
+}
+
+void Log::Flush() {
+    const size_t target = enqueuePosition_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.notify_one();
+    // A claimed slot is published a moment later; waiting on the sink's
+    // count rather than the ring covers both
+    flushed_.wait(lock, [&] { return written_ >= target; });
+}
+
+void Log::SetSink(Sink sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = std::move(sink);
+}
+
+void Log::Run() {
+    uint64_t reportedDropped = 0;
+    std::string line;
+    LogLevel level;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t taken = 0;
+        bool wroteOut = false;
+        bool wroteErr = false;
+        while (Dequeue(level, line)) {
+            const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reportedDropped) {
+                const std::string notice = "[log] " + std::to_string(dropped - reportedDropped) +
+                                           " lines dropped (log ring full)";
+                reportedDropped = dropped;
+                if (sink_) {
+                    sink_(LogLevel::Warning, notice);
+                } else {
+                    std::cerr << notice << '\n';
+                    wroteErr = true;
+                }
+            }
+
+            if (sink_) {
+                sink_(level, line);
+            } else if (level >= LogLevel::Warning) {
+                std::cerr << line << '\n';
+                wroteErr = true;
+            } else {
+                std::cout << line << '\n';
+                wroteOut = true;
+            }
+            ++taken;
+        }
+        // One flush per batch instead of one per line
+        if (wroteOut) {
+            std::cout.flush();
+        }
+        if (wroteErr) {
+            std::cerr.flush();
+        }
+
+        if (taken > 0) {
+            written_ += taken;
+            flushed_.notify_all();
+            continue;  // More may have arrived while writing
+        }
+
+        sleeping_.store(true);
+        wake_.wait_for(lock, std::chrono::milliseconds(WAKE_INTERVAL_MS));
+        sleeping_.store(false);
+    }
+}
+
+bool LogRateLimit::Allow(uint64_t& suppressed) {
+    const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t nextMs = nextMs_.load(std::memory_order_relaxed);
+    if (nowMs < nextMs || !nextMs_.compare_exchange_strong(nextMs, nowMs + intervalMs_, std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
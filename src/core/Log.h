@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+// Lowest level compiled in: 0 Debug, 1 Info, 2 Warning, 3 Error. Lines
+// below it are not compiled at all, arguments included. Debug builds set
+// 0 (see CMakeLists.txt).
+#ifndef PATHVIEW_LOG_MIN_LEVEL
+#define PATHVIEW_LOG_MIN_LEVEL 1
+#endif
+
+// The process's log, written on a thread of its own.
+//
+// A line is formatted by the thread that logs it, then copied into a
+// fixed ring of slots (a bounded multi-producer queue: a compare-and-swap
+// claims a slot, the slot's sequence number publishes it) and written to
+// stdout, or stderr for warnings and errors, by the sink thread. Logging
+// thus never takes a lock, flushes a stream or waits on a slow terminal
+// or redirected file: a render or loader thread pays for the formatting
+// and a copy. If the ring is full the line is dropped and counted, and
+// the sink reports how many were lost with the next line it writes.
+//
+// Log through the macros below rather than Write(), so that disabled
+// levels cost nothing.
+class Log {
+public:
+    using Sink = std::function<void(LogLevel level, const std::string& line)>;
+
+    static Log& Instance();
+
+    // Queue a line (without its newline); longer than MAX_LINE_BYTES is cut
+    void Write(LogLevel level, const std::string& line);
+
+    // Wait until every line queued so far is written (exit, tests)
+    void Flush();
+
+    // Runtime threshold, above the compiled-in one
+    void SetLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel GetLevel() const { return level_.load(std::memory_order_relaxed); }
+    bool IsEnabled(LogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
+
+    // Where the sink thread writes; null restores stdout and stderr
+    void SetSink(Sink sink);
+
+    // Lines lost to a full ring since startup
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static constexpr size_t CAPACITY = 1024;  // Lines queued at most (a power of two)
+    static constexpr size_t MAX_LINE_BYTES = 500;
+
+private:
+    Log();  // Never destroyed: lines may be logged while statics are torn down
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint16_t length;
+        char text[MAX_LINE_BYTES];
+    };
+
+    // Take the oldest published line; sink thread only
+    bool Dequeue(LogLevel& level, std::string& line);
+    void Run();
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> enqueuePosition_{0};
+    alignas(64) size_t dequeuePosition_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<LogLevel> level_{static_cast<LogLevel>(PATHVIEW_LOG_MIN_LEVEL)};
+
+    // The sink thread sleeps while the ring is empty: a producer wakes it
+    // only if it is asleep, and it looks again every WAKE_INTERVAL_MS
+    // anyway, so a wake-up lost to a race delays a line, never loses it
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::atomic<bool> sleeping_{false};
+    size_t written_ = 0;  // Lines taken off the ring (guarded by mutex_)
+    Sink sink_;           // Guarded by mutex_
+
+    static constexpr int WAKE_INTERVAL_MS = 100;
+};
+
+// Lets one line through per interval from a call site; see
+// PATHVIEW_LOG_EVERY_MS
+class LogRateLimit {
+public:
+    explicit LogRateLimit(uint32_t intervalMs) : intervalMs_(intervalMs) {}
+
+    // Whether to log now; if so, suppressed is set to the lines held back
+    // since the last one let through
+    bool Allow(uint64_t& suppressed);
+
+private:
+    const uint32_t intervalMs_;
+    std::atomic<int64_t> nextMs_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+// Log a line built with <<, e.g. PATHVIEW_LOG_INFO("Loaded " << count << " tiles")
+// (variadic only so that commas in template arguments pass through)
+#define PATHVIEW_LOG(level, ...)                                             \
+    do {                                                                     \
+        if (static_cast<int>(level) >= PATHVIEW_LOG_MIN_LEVEL &&             \
+            Log::Instance().IsEnabled(level)) {                              \
+            std::ostringstream pathviewLogLine;                              \
+            pathviewLogLine << __VA_ARGS__;                                  \
+            Log::Instance().Write(level, pathviewLogLine.str());             \
+        }                                                                    \
+    } while (0)
+
+// At most one line per intervalMs from this call site, for per-frame or
+// per-tile code; the next line let through says how many were held back
+#define PATHVIEW_LOG_EVERY_MS(level, intervalMs, ...)                        \
+    do {                                                                     \
+        static LogRateLimit pathviewLogLimit(intervalMs);                    \
+        uint64_t pathviewLogSuppressed = 0;                                  \
+        if (static_cast<int>(level) >= PATHVIEW_LOG_MIN_LEVEL &&             \
+            Log::Instance().IsEnabled(level) &&                              \
+            pathviewLogLimit.Allow(pathviewLogSuppressed)) {                 \
+            std::ostringstream pathviewLogLine;                              \
+            pathviewLogLine << __VA_ARGS__;                                  \
+            if (pathviewLogSuppressed > 0) {                                 \
+                pathviewLogLine << " (" << pathviewLogSuppressed             \
+                                << " similar suppressed)";                   \
+            }                                                                \
+            Log::Instance().Write(level, pathviewLogLine.str());             \
+        }                                                                    \
+    } while (0)
+
+#if PATHVIEW_LOG_MIN_LEVEL <= 0
+#define PATHVIEW_LOG_DEBUG(...) PATHVIEW_LOG(LogLevel::Debug, __VA_ARGS__)
+#else
+#define PATHVIEW_LOG_DEBUG(...) do {} while (0)
+#endif
+
+#if PATHVIEW_LOG_MIN_LEVEL <= 1
+#define PATHVIEW_LOG_INFO(...) PATHVIEW_LOG(LogLevel::Info, __VA_ARGS__)
+#else
+#define PATHVIEW_LOG_INFO(...) do {} while (0)
+#endif
+
+#if PATHVIEW_LOG_MIN_LEVEL <= 2
+#define PATHVIEW_LOG_WARNING(...) PATHVIEW_LOG(LogLevel::Warning, __VA_ARGS__)
+#else
+#define PATHVIEW_LOG_WARNING(...) do {} while (0)
+#endif
+
+#define PATHVIEW_LOG_ERROR(...) PATHVIEW_LOG(LogLevel::Error, __VA_ARGS__)
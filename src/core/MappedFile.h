@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file, so parsers and readers use the
+// bytes in place instead of through an istream copy. The kernel is told how
+// the file will be read: front to back (read ahead, drop behind) or in
+// places (no read-ahead past what is touched). Data() is null if the file
+// cannot be opened or is empty.
+class MappedFile {
+public:
+    enum class Access { Sequential, Random };
+
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* Data() const { return data_; }
+    uint64_t Size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;  // File mapping HANDLE
+#endif
+};
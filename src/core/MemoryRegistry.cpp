@@ -0,0 +1,146 @@
+#include "MemoryRegistry.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/sysctl.h>
+#else
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#endif
+
+void MemoryRegistry::Register(const std::string& name, UsageFn usage, ReclaimFn reclaim) {
+    Entry entry;
+    entry.name = name;
+    entry.reclaimable = static_cast<bool>(reclaim);
+    entries_.push_back(entry);
+    usage_.push_back(std::move(usage));
+    reclaim_.push_back(std::move(reclaim));
+}
+
+void MemoryRegistry::Poll() {
+    totalBytes_ = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        entries_[i].liveBytes = usage_[i] ? usage_[i]() : 0;
+        totalBytes_ += entries_[i].liveBytes;
+    }
+}
+
+void MemoryRegistry::Update() {
+    Poll();
+
+    // High-water marks are taken before enforcement, so they show what the
+    // workload asked for rather than what the budget allowed
+    for (Entry& entry : entries_) {
+        entry.peakBytes = std::max(entry.peakBytes, entry.liveBytes);
+    }
+    peakTotalBytes_ = std::max(peakTotalBytes_, totalBytes_);
+
+    if (budgetBytes_ == 0 || totalBytes_ <= budgetBytes_) {
+        return;
+    }
+
+    // Re-poll after each reclaim: freeing one subsystem can grow another
+    // (evicted tiles park their buffers in the pool)
+    size_t before = totalBytes_;
+    for (size_t i = 0; i < entries_.size() && totalBytes_ > budgetBytes_; ++i) {
+        if (!reclaim_[i]) {
+            continue;
+        }
+        reclaim_[i](totalBytes_ - budgetBytes_);
+        Poll();
+    }
+    if (totalBytes_ < before) {
+        reclaimedBytes_ += before - totalBytes_;
+    }
+    pressureEventCount_++;
+}
+
+size_t MemoryRegistry::GetProcessResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return static_cast<size_t>(info.resident_size);
+    }
+    return 0;
+#else
+    // Second field of statm is the resident page count
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    unsigned long totalPages = 0;
+    unsigned long residentPages = 0;
+    int fields = std::fscanf(file, "%lu %lu", &totalPages, &residentPages);
+    std::fclose(file);
+    if (fields != 2) {
+        return 0;
+    }
+    return static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+size_t MemoryRegistry::GetPhysicalMemoryBytes() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<size_t>(status.ullTotalPhys) : 0;
+#elif defined(__APPLE__)
+    uint64_t bytes = 0;
+    size_t length = sizeof(bytes);
+    return sysctlbyname("hw.memsize", &bytes, &length, nullptr, 0) == 0 ? static_cast<size_t>(bytes) : 0;
+#else
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    return pages > 0 && pageSize > 0 ? static_cast<size_t>(pages) * static_cast<size_t>(pageSize) : 0;
+#endif
+}
+
+size_t MemoryRegistry::GetAvailableMemoryBytes() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<size_t>(status.ullAvailPhys) : 0;
+#elif defined(__APPLE__)
+    // Free and inactive pages are reclaimable without swapping
+    vm_statistics64_data_t stats{};
+    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+    vm_size_t pageSize = 0;
+    if (host_page_size(mach_host_self(), &pageSize) != KERN_SUCCESS ||
+        host_statistics64(mach_host_self(), HOST_VM_INFO64,
+                          reinterpret_cast<host_info64_t>(&stats), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<size_t>(stats.free_count + stats.inactive_count) * pageSize;
+#else
+    // MemAvailable already counts reclaimable page cache
+    FILE* file = std::fopen("/proc/meminfo", "r");
+    if (!file) {
+        return 0;
+    }
+    char line[256];
+    size_t availableKB = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        unsigned long value = 0;
+        if (std::strncmp(line, "MemAvailable:", 13) == 0 &&
+            std::sscanf(line + 13, "%lu", &value) == 1) {
+            availableKB = value;
+            break;
+        }
+    }
+    std::fclose(file);
+    return availableKB * 1024;
+#endif
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Central account of the memory each subsystem holds.
+//
+// Subsystems register a usage callback (bytes held right now) and, if they
+// can give memory back, a reclaim callback. Update() polls every entry,
+// tracks live bytes and high-water marks, and while a budget is set and the
+// accounted total exceeds it, asks the reclaimable entries in registration
+// order to free the excess. The budget covers accounted bytes, not the
+// process RSS, which also holds libraries and allocator slack that no cache
+// can give back. Not thread-safe: registration, Update() and the callbacks
+// all run on the render thread.
+class MemoryRegistry {
+public:
+    using UsageFn = std::function<size_t()>;
+    // Frees up to the requested bytes; registered entries are re-polled
+    // afterwards, so the return value is informational
+    using ReclaimFn = std::function<size_t(size_t bytes)>;
+
+    struct Entry {
+        std::string name;
+        size_t liveBytes = 0;
+        size_t peakBytes = 0;
+        bool reclaimable = false;
+    };
+
+    void Register(const std::string& name, UsageFn usage, ReclaimFn reclaim = nullptr);
+
+    // Polls every entry and enforces the budget; call once per frame
+    void Update();
+
+    // Entries in registration order, as of the last Update()
+    const std::vector<Entry>& GetEntries() const { return entries_; }
+    size_t GetTotalBytes() const { return totalBytes_; }
+    size_t GetPeakTotalBytes() const { return peakTotalBytes_; }
+
+    // 0 = unlimited (default)
+    void SetBudget(size_t bytes) { budgetBytes_ = bytes; }
+    size_t GetBudget() const { return budgetBytes_; }
+
+    // Bytes freed by budget enforcement, and how many Update() calls needed to
+    size_t GetReclaimedBytes() const { return reclaimedBytes_; }
+    size_t GetPressureEventCount() const { return pressureEventCount_; }
+
+    // Resident set size of this process, the machine's physical memory and
+    // how much of it the OS could hand out without swapping (0 where
+    // unsupported)
+    static size_t GetProcessResidentBytes();
+    static size_t GetPhysicalMemoryBytes();
+    static size_t GetAvailableMemoryBytes();
+
+private:
+    // Re-reads every entry's live bytes and the total
+    void Poll();
+
+    std::vector<Entry> entries_;
+    std::vector<UsageFn> usage_;
+    std::vector<ReclaimFn> reclaim_;
+    size_t totalBytes_ = 0;
+    size_t peakTotalBytes_ = 0;
+    size_t budgetBytes_ = 0;
+    size_t reclaimedBytes_ = 0;
+    size_t pressureEventCount_ = 0;
+};
@@ -1,10 +1,33 @@
 #include "Minimap.h"
 #include "SlideLoader.h"
 #include "Viewport.h"
-#include <iostream>
+#include "TextureManager.h"
+#include "PyramidLayout.h"
+#include "SlideRenderer.h"
+#include "TileCache.h"
+#include "Log.h"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Scale width x height to fit maxSize on the longer side, never enlarging
+void FitSize(int64_t width, int64_t height, int64_t maxSize, int64_t& fitWidth, int64_t& fitHeight) {
+    double scale = std::min(1.0, static_cast<double>(maxSize) / std::max<int64_t>(1, std::max(width, height)));
+    fitWidth = std::max<int64_t>(1, std::llround(width * scale));
+    fitHeight = std::max<int64_t>(1, std::llround(height * scale));
+}
+
+}  // namespace
 
 Minimap::Minimap(SlideLoader* loader, SDL_Renderer* renderer, int windowWidth, int windowHeight)
+    : Minimap(loader, renderer, windowWidth, windowHeight, MinimapOverview())
+{
+}
+
+Minimap::Minimap(SlideLoader* loader, SDL_Renderer* renderer, int windowWidth, int windowHeight,
+                 const MinimapOverview& overview)
     : loader_(loader)
     , renderer_(renderer)
     , overviewTexture_(nullptr)
@@ -14,7 +37,15 @@ Minimap::Minimap(SlideLoader* loader, SDL_Renderer* renderer, int windowWidth, i
     , windowHeight_(windowHeight)
 {
     minimapRect_ = {0, 0, 0, 0};
-    Initialize();
+    if (!overview.pixels.empty()) {
+        Initialize(overview);
+        return;
+    }
+
+    MinimapOverview read;
+    if (ReadOverview(loader_, read)) {
+        Initialize(read);
+    }
 }
 
 Minimap::~Minimap() {
@@ -22,62 +53,300 @@ Minimap::~Minimap() {
         SDL_DestroyTexture(overviewTexture_);
         overviewTexture_ = nullptr;
     }
+    ClearDensity();
 }
 
-void Minimap::Initialize() {
-    if (!loader_ || !loader_->IsValid()) {
-        std::cerr << "Minimap: Invalid slide loader" << std::endl;
-        return;
+bool Minimap::ReadOverview(SlideLoader* loader, MinimapOverview& overview) {
+    if (!loader || !loader->IsValid()) {
+        PATHVIEW_LOG_ERROR("Minimap: Invalid slide loader");
+        return false;
     }
 
-    // Use the lowest resolution level for overview
-    int32_t lowestLevel = loader_->GetLevelCount() - 1;
-    auto dims = loader_->GetLevelDimensions(lowestLevel);
+    // The scanner's thumbnail is usually a fraction of the cost of even the
+    // lowest level; Refine() swaps in the pyramid's pixels later
+    std::vector<uint32_t> thumbnail;
+    int64_t width = 0;
+    int64_t height = 0;
+    if (loader->ReadAssociatedImage("thumbnail", thumbnail, width, height) &&
+        OverviewFromImage(thumbnail, width, height, loader->GetWidth(), loader->GetHeight(), overview)) {
+        PATHVIEW_LOG_INFO("Minimap: Overview from the " << width << "x" << height << " thumbnail");
+        return true;
+    }
+    return ReadPyramidOverview(loader, MINIMAP_MAX_SIZE, overview);
+}
 
-    std::cout << "Minimap: Loading overview from level " << lowestLevel
-              << " (" << dims.width << "x" << dims.height << ")" << std::endl;
+bool Minimap::ReadPyramidOverview(SlideLoader* loader, int64_t maxSize, MinimapOverview& overview) {
+    if (!loader || !loader->IsValid()) {
+        PATHVIEW_LOG_ERROR("Minimap: Invalid slide loader");
+        return false;
+    }
 
-    // Read the entire level (it's small enough to fit in memory)
-    uint32_t* pixels = loader_->ReadRegion(lowestLevel, 0, 0, dims.width, dims.height);
+    int64_t width = 0;
+    int64_t height = 0;
+    FitSize(loader->GetWidth(), loader->GetHeight(), maxSize, width, height);
 
-    if (!pixels) {
-        std::cerr << "Minimap: Failed to read overview region" << std::endl;
-        return;
+    // Coarsest level at least as large as the overview, so it only shrinks
+    int32_t level = 0;
+    for (int32_t i = 0; i < loader->GetLevelCount(); ++i) {
+        LevelDimensions dims = loader->GetLevelDimensions(i);
+        if (dims.width >= width && dims.height >= height) {
+            level = i;
+        }
+    }
+    LevelDimensions dims = loader->GetLevelDimensions(level);
+    double downsample = loader->GetLevelDownsample(level);
+
+    PATHVIEW_LOG_INFO("Minimap: Loading " << width << "x" << height << " overview from level " << level
+                      << " (" << dims.width << "x" << dims.height << ")");
+
+    // Bands of overview rows (narrower blocks on very wide levels) whose
+    // source regions stay within OVERVIEW_BLOCK_PIXELS, bar a single
+    // overview pixel's on huge levels
+    int64_t sourcePerPixel = ((dims.width + width - 1) / width) * ((dims.height + height - 1) / height);
+    int64_t blockWidth = std::min(width, std::max<int64_t>(1, OVERVIEW_BLOCK_PIXELS / sourcePerPixel));
+    int64_t blockHeight = std::min(height, std::max<int64_t>(1, OVERVIEW_BLOCK_PIXELS / (sourcePerPixel * blockWidth)));
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(width * height));
+    std::vector<uint32_t> block;
+    for (int64_t row = 0; row < height; row += blockHeight) {
+        int64_t rowEnd = std::min(height, row + blockHeight);
+        int64_t y0 = row * dims.height / height;
+        int64_t y1 = std::max(y0 + 1, rowEnd * dims.height / height);
+        for (int64_t column = 0; column < width; column += blockWidth) {
+            int64_t columnEnd = std::min(width, column + blockWidth);
+            int64_t x0 = column * dims.width / width;
+            int64_t x1 = std::max(x0 + 1, columnEnd * dims.width / width);
+            block.resize(static_cast<size_t>((x1 - x0) * (y1 - y0)));
+            if (!loader->ReadRegionInto(level, std::llround(x0 * downsample), std::llround(y0 * downsample),
+                                        x1 - x0, y1 - y0, block.data())) {
+                PATHVIEW_LOG_ERROR("Minimap: Failed to read overview region");
+                return false;
+            }
+            ResampleBox(block.data(), x1 - x0, y1 - y0, static_cast<size_t>(x1 - x0),
+                        pixels.data() + row * width + column, columnEnd - column, rowEnd - row,
+                        static_cast<size_t>(width));
+        }
+    }
+
+    overview.pixels = std::move(pixels);
+    overview.width = width;
+    overview.height = height;
+    overview.exact = true;
+    return true;
+}
+
+bool Minimap::OverviewFromImage(const std::vector<uint32_t>& pixels, int64_t width, int64_t height,
+                                int64_t slideWidth, int64_t slideHeight, MinimapOverview& overview) {
+    if (width <= 0 || height <= 0 || slideWidth <= 0 || slideHeight <= 0 ||
+        pixels.size() < static_cast<size_t>(width * height)) {
+        return false;
+    }
+    double aspect = static_cast<double>(width) / height;
+    double slideAspect = static_cast<double>(slideWidth) / slideHeight;
+    if (std::abs(aspect / slideAspect - 1.0) > THUMBNAIL_ASPECT_TOLERANCE) {
+        return false;
+    }
+
+    int64_t fitWidth = 0;
+    int64_t fitHeight = 0;
+    FitSize(width, height, MINIMAP_MAX_SIZE, fitWidth, fitHeight);
+    overview.pixels.resize(static_cast<size_t>(fitWidth * fitHeight));
+    ResampleBox(pixels.data(), width, height, static_cast<size_t>(width),
+                overview.pixels.data(), fitWidth, fitHeight, static_cast<size_t>(fitWidth));
+    overview.width = fitWidth;
+    overview.height = fitHeight;
+    overview.exact = false;
+    return true;
+}
+
+void Minimap::ResampleBox(const uint32_t* src, int64_t srcWidth, int64_t srcHeight, size_t srcStride,
+                          uint32_t* dst, int64_t dstWidth, int64_t dstHeight, size_t dstStride) {
+    for (int64_t j = 0; j < dstHeight; ++j) {
+        int64_t y0 = j * srcHeight / dstHeight;
+        int64_t y1 = std::max(y0 + 1, (j + 1) * srcHeight / dstHeight);
+        for (int64_t i = 0; i < dstWidth; ++i) {
+            int64_t x0 = i * srcWidth / dstWidth;
+            int64_t x1 = std::max(x0 + 1, (i + 1) * srcWidth / dstWidth);
+            // Premultiplied channels average independently
+            uint64_t sums[4] = {0, 0, 0, 0};
+            for (int64_t y = y0; y < y1; ++y) {
+                const uint32_t* row = src + y * srcStride;
+                for (int64_t x = x0; x < x1; ++x) {
+                    uint32_t pixel = row[x];
+                    sums[0] += pixel >> 24;
+                    sums[1] += (pixel >> 16) & 0xFF;
+                    sums[2] += (pixel >> 8) & 0xFF;
+                    sums[3] += pixel & 0xFF;
+                }
+            }
+            uint64_t count = static_cast<uint64_t>((x1 - x0) * (y1 - y0));
+            uint32_t average = 0;
+            for (uint64_t sum : sums) {
+                average = (average << 8) | static_cast<uint32_t>((sum + count / 2) / count);
+            }
+            dst[j * dstStride + i] = average;
+        }
+    }
+}
+
+bool Minimap::Refine(SlideRenderer& renderer) {
+    if (refined_ || !loader_) {
+        return false;
+    }
+
+    int64_t width = 0;
+    int64_t height = 0;
+    FitSize(loader_->GetWidth(), loader_->GetHeight(), MINIMAP_MAX_SIZE, width, height);
+
+    // Coarsest pipeline level at least as large as the minimap; the
+    // synthesized levels reach down to a single tile, so this is a handful
+    const PyramidLayout& pyramid = renderer.GetPyramid();
+    if (pyramid.GetLevelCount() == 0) {
+        return false;
+    }
+    int32_t level = 0;
+    for (int32_t i = 0; i < pyramid.GetLevelCount(); ++i) {
+        LevelDimensions dims = pyramid.GetLevelDimensions(i);
+        if (dims.width >= width && dims.height >= height) {
+            level = i;
+        }
+    }
+    LevelDimensions dims = pyramid.GetLevelDimensions(level);
+    int64_t tileWidth = pyramid.GetTileWidth(level);
+    int64_t tileHeight = pyramid.GetTileHeight(level);
+    int64_t columns = (dims.width + tileWidth - 1) / tileWidth;
+    int64_t rows = (dims.height + tileHeight - 1) / tileHeight;
+    if (columns * rows > MAX_REFINE_TILES) {
+        refined_ = true;
+        return false;
+    }
+
+    // Queue what is missing (again every REFINE_REQUEST_INTERVAL_MS, so the
+    // renderer does not retire the requests) and wait for the rest
+    Uint32 now = SDL_GetTicks();
+    bool request = now - lastRefineRequest_ >= REFINE_REQUEST_INTERVAL_MS;
+    std::vector<TileHandle> tiles;
+    bool complete = true;
+    for (int64_t row = 0; row < rows; ++row) {
+        for (int64_t column = 0; column < columns; ++column) {
+            TileKey key{level, static_cast<int32_t>(column), static_cast<int32_t>(row)};
+            TileHandle tile = renderer.GetCachedTile(key);
+            if (!tile) {
+                complete = false;
+                if (request) {
+                    renderer.RequestTile(key, TileLoadPriority::ADJACENT);
+                }
+            }
+            tiles.push_back(std::move(tile));
+        }
+    }
+    if (request) {
+        lastRefineRequest_ = now;
+    }
+    if (!complete) {
+        return false;
+    }
+
+    std::vector<uint32_t> image(static_cast<size_t>(dims.width * dims.height), 0);
+    std::vector<uint32_t> unpacked;
+    for (int64_t row = 0; row < rows; ++row) {
+        for (int64_t column = 0; column < columns; ++column) {
+            const TileData& tile = *tiles[static_cast<size_t>(row * columns + column)];
+            const uint32_t* pixels = tile.GetArgb(unpacked);
+            int64_t copyWidth = std::min<int64_t>(tile.width, dims.width - column * tileWidth);
+            int64_t copyHeight = std::min<int64_t>(tile.height, dims.height - row * tileHeight);
+            for (int64_t y = 0; y < copyHeight; ++y) {
+                std::memcpy(image.data() + (row * tileHeight + y) * dims.width + column * tileWidth,
+                            pixels + y * tile.width, static_cast<size_t>(copyWidth) * sizeof(uint32_t));
+            }
+        }
+    }
+
+    MinimapOverview overview;
+    overview.pixels.resize(static_cast<size_t>(width * height));
+    ResampleBox(image.data(), dims.width, dims.height, static_cast<size_t>(dims.width),
+                overview.pixels.data(), width, height, static_cast<size_t>(width));
+    overview.width = width;
+    overview.height = height;
+    overview.exact = true;
+    Initialize(overview);
+    refined_ = true;
+    PATHVIEW_LOG_INFO("Minimap: Refined from level " << level << " tiles");
+    return true;
+}
+
+void Minimap::Initialize(const MinimapOverview& overview) {
+    refined_ = overview.exact;
+    if (overviewTexture_) {
+        SDL_DestroyTexture(overviewTexture_);
+        overviewTexture_ = nullptr;
     }
 
     // Create texture
     overviewTexture_ = SDL_CreateTexture(
         renderer_,
-        SDL_PIXELFORMAT_RGBA32,
+        TextureManager::TILE_PIXEL_FORMAT,
         SDL_TEXTUREACCESS_STATIC,
-        dims.width,
-        dims.height
+        static_cast<int>(overview.width),
+        static_cast<int>(overview.height)
     );
 
     if (!overviewTexture_) {
-        std::cerr << "Minimap: Failed to create texture: " << SDL_GetError() << std::endl;
-        delete[] pixels;
+        PATHVIEW_LOG_ERROR("Minimap: Failed to create texture: " << SDL_GetError());
         return;
     }
 
     // Upload pixel data
-    int pitch = dims.width * sizeof(uint32_t);
-    if (SDL_UpdateTexture(overviewTexture_, nullptr, pixels, pitch) != 0) {
-        std::cerr << "Minimap: Failed to update texture: " << SDL_GetError() << std::endl;
+    int pitch = static_cast<int>(overview.width * sizeof(uint32_t));
+    if (SDL_UpdateTexture(overviewTexture_, nullptr, overview.pixels.data(), pitch) != 0) {
+        PATHVIEW_LOG_ERROR("Minimap: Failed to update texture: " << SDL_GetError());
         SDL_DestroyTexture(overviewTexture_);
         overviewTexture_ = nullptr;
-        delete[] pixels;
         return;
     }
 
-    delete[] pixels;
+    TextureManager::ApplyPremultipliedBlendMode(overviewTexture_);
 
-    overviewWidth_ = dims.width;
-    overviewHeight_ = dims.height;
+    // Density of another size no longer fits; the owner sets it again
+    if (overview.width != overviewWidth_ || overview.height != overviewHeight_) {
+        ClearDensity();
+    }
+    overviewWidth_ = static_cast<int>(overview.width);
+    overviewHeight_ = static_cast<int>(overview.height);
 
     CalculateMinimapRect();
 
-    std::cout << "Minimap: Overview texture created successfully" << std::endl;
+    PATHVIEW_LOG_INFO("Minimap: Overview texture created successfully");
+}
+
+bool Minimap::SetDensity(const std::vector<uint32_t>& pixels) {
+    if (overviewWidth_ <= 0 || overviewHeight_ <= 0 ||
+        pixels.size() != static_cast<size_t>(overviewWidth_) * overviewHeight_) {
+        return false;
+    }
+    if (!densityTexture_) {
+        densityTexture_ = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT, SDL_TEXTUREACCESS_STATIC,
+                                            overviewWidth_, overviewHeight_);
+        if (!densityTexture_) {
+            PATHVIEW_LOG_ERROR("Minimap: Failed to create density texture: " << SDL_GetError());
+            return false;
+        }
+        TextureManager::ApplyPremultipliedBlendMode(densityTexture_);
+    }
+    if (SDL_UpdateTexture(densityTexture_, nullptr, pixels.data(),
+                          overviewWidth_ * static_cast<int>(sizeof(uint32_t))) != 0) {
+        PATHVIEW_LOG_ERROR("Minimap: Failed to update density texture: " << SDL_GetError());
+        ClearDensity();
+        return false;
+    }
+    return true;
+}
+
+void Minimap::ClearDensity() {
+    if (densityTexture_) {
+        SDL_DestroyTexture(densityTexture_);
+        densityTexture_ = nullptr;
+    }
 }
 
 void Minimap::CalculateMinimapRect() {
@@ -153,8 +422,11 @@ void Minimap::Render(const Viewport& viewport, bool sidebarVisible, float sideba
     SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 128);
     SDL_RenderFillRect(renderer_, &minimapRect_);
 
-    // Draw overview texture
+    // Draw overview texture, and the cell density over it
     SDL_RenderCopy(renderer_, overviewTexture_, nullptr, &minimapRect_);
+    if (densityTexture_) {
+        SDL_RenderCopy(renderer_, densityTexture_, nullptr, &minimapRect_);
+    }
 
     // Draw border around minimap
     SDL_SetRenderDrawColor(renderer_, 200, 200, 200, 255);
@@ -231,5 +503,5 @@ void Minimap::HandleClick(int x, int y, Viewport& viewport) {
     // Center viewport on clicked position
     viewport.CenterOn({slideX, slideY});
 
-    std::cout << "Minimap: Jumped to position (" << slideX << ", " << slideY << ")" << std::endl;
+    PATHVIEW_LOG_INFO("Minimap: Jumped to position (" << slideX << ", " << slideY << ")");
 }
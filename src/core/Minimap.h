@@ -1,15 +1,30 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 class SlideLoader;
+class SlideRenderer;
 class Viewport;
 struct Rect;
 
+// Overview pixels for the minimap, at most Minimap::MINIMAP_MAX_SIZE: the
+// slide's associated thumbnail, or a box-filtered read of the pyramid
+struct MinimapOverview {
+    std::vector<uint32_t> pixels;
+    int64_t width = 0;
+    int64_t height = 0;
+    bool exact = false;  // Read from the pyramid (thumbnails are refined later)
+};
+
 class Minimap {
 public:
+    // Reads the overview itself, or uploads one read beforehand
     Minimap(SlideLoader* loader, SDL_Renderer* renderer, int windowWidth, int windowHeight);
+    Minimap(SlideLoader* loader, SDL_Renderer* renderer, int windowWidth, int windowHeight,
+            const MinimapOverview& overview);
     ~Minimap();
 
     void Render(const Viewport& viewport, bool sidebarVisible = false, float sidebarWidth = 0.0f);
@@ -17,8 +32,56 @@ public:
     void HandleClick(int x, int y, Viewport& viewport);
     void SetWindowSize(int width, int height);
 
+    // Replace a thumbnail-based overview with one composed from the
+    // renderer's cached tiles, once they are all in; missing tiles are
+    // queued at prefetch priority. Cheap to call every frame. Returns true
+    // when the minimap changed.
+    bool Refine(SlideRenderer& renderer);
+
+    // Cell density drawn over the overview (PolygonOverlay::
+    // RenderDensityOverview): GetOverviewWidth() x GetOverviewHeight()
+    // premultiplied pixels, uploaded once into a texture of that size.
+    // Returns false if they are the wrong size or the upload fails
+    bool SetDensity(const std::vector<uint32_t>& pixels);
+    void ClearDensity();
+    bool HasDensity() const { return densityTexture_ != nullptr; }
+    int GetOverviewWidth() const { return overviewWidth_; }
+    int GetOverviewHeight() const { return overviewHeight_; }
+
+    // Read the overview pixels: the associated thumbnail if its shape
+    // matches the slide, else ReadPyramidOverview. Makes no SDL calls, so
+    // it can run off the GUI thread while a slide opens. Returns false if
+    // the read fails.
+    static bool ReadOverview(SlideLoader* loader, MinimapOverview& overview);
+
+    // Box-filter the coarsest level at least maxSize pixels on the slide's
+    // longer side down to exactly that size. The level is read in blocks
+    // of at most OVERVIEW_BLOCK_PIXELS, never whole.
+    static bool ReadPyramidOverview(SlideLoader* loader, int64_t maxSize, MinimapOverview& overview);
+
+    // Overview from an image of the whole slide (a thumbnail), shrunk to
+    // fit MINIMAP_MAX_SIZE. Returns false if its aspect ratio is off from
+    // the slide's by more than THUMBNAIL_ASPECT_TOLERANCE (a macro photo
+    // of the whole glass, say).
+    static bool OverviewFromImage(const std::vector<uint32_t>& pixels, int64_t width, int64_t height,
+                                  int64_t slideWidth, int64_t slideHeight, MinimapOverview& overview);
+
+    // Resample premultiplied ARGB with a box filter: each destination pixel
+    // averages the source pixels it covers (or repeats the nearest one when
+    // enlarging). Strides are in pixels.
+    static void ResampleBox(const uint32_t* src, int64_t srcWidth, int64_t srcHeight, size_t srcStride,
+                            uint32_t* dst, int64_t dstWidth, int64_t dstHeight, size_t dstStride);
+
+    static constexpr int MINIMAP_MAX_SIZE = 250;  // Maximum width/height
+
+    // Bytes of the overview and density textures (0 if none could be created)
+    size_t GetTextureMemoryUsage() const {
+        const size_t bytes = static_cast<size_t>(overviewWidth_) * overviewHeight_ * sizeof(uint32_t);
+        return (overviewTexture_ ? bytes : 0) + (densityTexture_ ? bytes : 0);
+    }
+
 private:
-    void Initialize();
+    void Initialize(const MinimapOverview& overview);
     void CalculateMinimapRect();
     SDL_Rect CalculateViewportRect(const Viewport& viewport) const;
 
@@ -28,15 +91,23 @@ private:
     SDL_Texture* overviewTexture_;
     int overviewWidth_;
     int overviewHeight_;
+    SDL_Texture* densityTexture_ = nullptr;  // Overview sized (see SetDensity)
 
     // Minimap position and size on screen
     SDL_Rect minimapRect_;
 
+    // Refinement from cached tiles (see Refine)
+    bool refined_ = false;
+    Uint32 lastRefineRequest_ = 0;
+
     // Window dimensions
     int windowWidth_;
     int windowHeight_;
 
     // Minimap settings
     static constexpr int MINIMAP_MARGIN = 10;     // Margin from window edge
-    static constexpr int MINIMAP_MAX_SIZE = 250;  // Maximum width/height
+    static constexpr int64_t OVERVIEW_BLOCK_PIXELS = 4 * 1024 * 1024;
+    static constexpr double THUMBNAIL_ASPECT_TOLERANCE = 0.02;
+    static constexpr Uint32 REFINE_REQUEST_INTERVAL_MS = 250;  // Resubmit missing tiles this often
+    static constexpr int32_t MAX_REFINE_TILES = 16;           // Give up on larger tile grids
 };
@@ -1,18 +1,72 @@
 #include "PNGEncoder.h"
-#include <png.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <stdexcept>
+#include <thread>
 
 namespace pathview {
 
-// libpng write callback - writes PNG data to std::vector
-static void PNGWriteCallback(png_structp png_ptr, png_bytep data, png_size_t length) {
-    auto* vec = reinterpret_cast<std::vector<uint8_t>*>(png_get_io_ptr(png_ptr));
-    vec->insert(vec->end(), data, data + length);
+namespace {
+
+constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+constexpr uint8_t FILTER_UP = 2;
+constexpr size_t DICTIONARY_BYTES = 32 * 1024;  // Deflate window
+constexpr uint8_t ZLIB_HEADER[2] = {0x78, 0x01};  // 32KB window, no preset dictionary
+
+void PutBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Length, type, data, CRC of type and data
+void WriteChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size,
+                const uint8_t* tail = nullptr, size_t tailSize = 0) {
+    PutBigEndian32(out, static_cast<uint32_t>(size + tailSize));
+    const size_t typeAt = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    if (tail) {
+        out.insert(out.end(), tail, tail + tailSize);
+    }
+    const uLong crc = crc32(0L, out.data() + typeAt, static_cast<uInt>(out.size() - typeAt));
+    PutBigEndian32(out, static_cast<uint32_t>(crc));
 }
 
+// Filter rows [firstRow, lastRow) into out: a filter byte, then each byte
+// minus the one above (Up)
+void FilterRows(const uint8_t* pixels, size_t rowBytes, int firstRow, int lastRow, uint8_t* out) {
+    for (int y = firstRow; y < lastRow; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * rowBytes;
+        *out++ = FILTER_UP;
+        if (y == 0) {
+            std::memcpy(out, row, rowBytes);
+        } else {
+            const uint8_t* above = row - rowBytes;
+            for (size_t i = 0; i < rowBytes; ++i) {
+                out[i] = static_cast<uint8_t>(row[i] - above[i]);
+            }
+        }
+        out += rowBytes;
+    }
+}
+
+struct Strip {
+    int firstRow = 0;
+    int lastRow = 0;
+    std::vector<uint8_t> deflated;
+    uLong adler = 1;
+    size_t filteredBytes = 0;
+    bool ok = false;
+};
+
+}  // namespace
+
 std::vector<uint8_t> PNGEncoder::Encode(const std::vector<uint8_t>& pixels,
-                                        int width, int height) {
+                                        int width, int height, int level, size_t threads) {
     // Validate input
     if (width <= 0 || height <= 0) {
         throw std::runtime_error("Invalid image dimensions");
@@ -22,57 +76,115 @@ std::vector<uint8_t> PNGEncoder::Encode(const std::vector<uint8_t>& pixels,
     if (pixels.size() != expectedSize) {
         throw std::runtime_error("Pixel data size mismatch");
     }
-
-    std::vector<uint8_t> pngData;
-    pngData.reserve(expectedSize / 2);  // Estimate compressed size
-
-    // Create libpng write structure
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING,
-                                               nullptr, nullptr, nullptr);
-    if (!png) {
-        throw std::runtime_error("Failed to create PNG write struct");
+    level = std::max(1, std::min(9, level));
+
+    // The whole filtered image is built up front: each strip's dictionary
+    // is the filtered data just before it
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t filteredRowBytes = rowBytes + 1;
+    std::vector<uint8_t> filtered(filteredRowBytes * height);
+
+    const int rowsPerStrip = static_cast<int>(std::max<size_t>(1, STRIP_BYTES / filteredRowBytes));
+    std::vector<Strip> strips((height + rowsPerStrip - 1) / rowsPerStrip);
+    for (size_t i = 0; i < strips.size(); ++i) {
+        strips[i].firstRow = static_cast<int>(i) * rowsPerStrip;
+        strips[i].lastRow = std::min(height, strips[i].firstRow + rowsPerStrip);
     }
 
-    // Create libpng info structure
-    png_infop info = png_create_info_struct(png);
-    if (!info) {
-        png_destroy_write_struct(&png, nullptr);
-        throw std::runtime_error("Failed to create PNG info struct");
+    // Filter every strip first (workers hand them out in order), then
+    // deflate them: a strip's dictionary must be filtered before it starts
+    auto runParallel = [&](size_t workerCount, const auto& work) {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < strips.size(); i = next++) {
+                work(strips[i]);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < workerCount; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    };
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
     }
+    const size_t workerCount = std::min({threads, MAX_THREADS, strips.size()});
+
+    runParallel(workerCount, [&](Strip& strip) {
+        FilterRows(pixels.data(), rowBytes, strip.firstRow, strip.lastRow,
+                   filtered.data() + static_cast<size_t>(strip.firstRow) * filteredRowBytes);
+    });
+
+    const Strip* lastStrip = &strips.back();
+    runParallel(workerCount, [&](Strip& strip) {
+        const uint8_t* begin = filtered.data() + static_cast<size_t>(strip.firstRow) * filteredRowBytes;
+        strip.filteredBytes = static_cast<size_t>(strip.lastRow - strip.firstRow) * filteredRowBytes;
+        strip.adler = adler32(1L, begin, static_cast<uInt>(strip.filteredBytes));
+
+        z_stream stream{};
+        if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return;
+        }
+        const size_t offset = static_cast<size_t>(begin - filtered.data());
+        if (offset > 0) {
+            const size_t dictionary = std::min(offset, DICTIONARY_BYTES);
+            deflateSetDictionary(&stream, begin - dictionary, static_cast<uInt>(dictionary));
+        }
+
+        // The zlib header leads the first strip. Non-final strips end in a
+        // sync flush: byte-aligned, not the last block.
+        const size_t headerBytes = offset == 0 ? sizeof(ZLIB_HEADER) : 0;
+        strip.deflated.resize(headerBytes + deflateBound(&stream, static_cast<uLong>(strip.filteredBytes)) + 16);
+        std::memcpy(strip.deflated.data(), ZLIB_HEADER, headerBytes);
+        stream.next_in = const_cast<Bytef*>(begin);
+        stream.avail_in = static_cast<uInt>(strip.filteredBytes);
+        stream.next_out = strip.deflated.data() + headerBytes;
+        stream.avail_out = static_cast<uInt>(strip.deflated.size() - headerBytes);
+        const int flush = &strip == lastStrip ? Z_FINISH : Z_SYNC_FLUSH;
+        const int result = deflate(&stream, flush);
+        strip.ok = flush == Z_FINISH ? result == Z_STREAM_END : (result == Z_OK && stream.avail_in == 0);
+        strip.deflated.resize(headerBytes + stream.total_out);
+        deflateEnd(&stream);
+    });
 
-    // Set up error handling (libpng uses longjmp)
-    if (setjmp(png_jmpbuf(png))) {
-        png_destroy_write_struct(&png, &info);
-        throw std::runtime_error("PNG encoding error");
+    std::vector<uint8_t> pngData;
+    size_t deflatedBytes = 0;
+    for (const Strip& strip : strips) {
+        if (!strip.ok) {
+            throw std::runtime_error("PNG encoding error");
+        }
+        deflatedBytes += strip.deflated.size();
     }
-
-    // Set custom write function to write to std::vector
-    png_set_write_fn(png, &pngData, PNGWriteCallback, nullptr);
-
-    // Set image parameters
-    // RGBA format, 8 bits per channel, no interlacing
-    png_set_IHDR(png, info, width, height, 8,
-                 PNG_COLOR_TYPE_RGBA,
-                 PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT,
-                 PNG_FILTER_TYPE_DEFAULT);
-
-    // Write PNG header
-    png_write_info(png, info);
-
-    // Write image data row by row
-    std::vector<png_bytep> rows(height);
-    for (int y = 0; y < height; y++) {
-        rows[y] = const_cast<png_bytep>(&pixels[y * width * 4]);
+    pngData.reserve(deflatedBytes + strips.size() * 12 + 64);
+
+    // Signature and header: RGBA, 8 bits per channel, no interlacing
+    pngData.insert(pngData.end(), PNG_SIGNATURE, PNG_SIGNATURE + sizeof(PNG_SIGNATURE));
+    std::vector<uint8_t> header;
+    PutBigEndian32(header, static_cast<uint32_t>(width));
+    PutBigEndian32(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+    WriteChunk(pngData, "IHDR", header.data(), header.size());
+
+    // One IDAT per strip, the checksum of every strip combined trailing
+    // the last
+    uLong adler = 1;
+    for (const Strip& strip : strips) {
+        adler = adler32_combine(adler, strip.adler, static_cast<z_off_t>(strip.filteredBytes));
+    }
+    const uint8_t adlerBytes[4] = {static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+                                   static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)};
+    for (size_t i = 0; i < strips.size(); ++i) {
+        const bool last = i + 1 == strips.size();
+        WriteChunk(pngData, "IDAT", strips[i].deflated.data(), strips[i].deflated.size(),
+                   last ? adlerBytes : nullptr, last ? 4 : 0);
     }
-    png_write_image(png, rows.data());
-
-    // Finish writing
-    png_write_end(png, nullptr);
-
-    // Cleanup
-    png_destroy_write_struct(&png, &info);
 
+    WriteChunk(pngData, "IEND", nullptr, 0);
     return pngData;
 }
 
@@ -0,0 +1,63 @@
+#include "ParallelSort.h"
+#include <algorithm>
+#include <thread>
+
+size_t ParallelSort::BlockCount(size_t count, size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(threadCount, count / MIN_BLOCK_SIZE));
+}
+
+void ParallelSort::For(size_t count, size_t threadCount,
+                       const std::function<void(size_t block, size_t begin, size_t end)>& body) {
+    const size_t blockCount = BlockCount(count, threadCount);
+    auto work = [&](size_t block) {
+        body(block, count * block / blockCount, count * (block + 1) / blockCount);
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t block = 1; block < blockCount; ++block) {
+        workers.emplace_back(work, block);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ParallelSort::RadixSort(std::vector<uint64_t>& keys, size_t threadCount) {
+    if (keys.size() < MIN_RADIX_SORT) {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+
+    // Bits set in every key and in any key; a digit where they agree
+    // orders nothing
+    const size_t blockCount = BlockCount(keys.size(), threadCount);
+    std::vector<uint64_t> allBits(blockCount, ~uint64_t(0));
+    std::vector<uint64_t> anyBits(blockCount, 0);
+    For(keys.size(), threadCount, [&](size_t block, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            allBits[block] &= keys[i];
+            anyBits[block] |= keys[i];
+        }
+    });
+    uint64_t all = ~uint64_t(0), any = 0;
+    for (size_t block = 0; block < blockCount; ++block) {
+        all &= allBits[block];
+        any |= anyBits[block];
+    }
+    const uint64_t varying = any & ~all;
+
+    constexpr uint64_t DIGIT_MASK = (uint64_t(1) << RADIX_BITS) - 1;
+    std::vector<uint64_t> scratch;
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        if (((varying >> shift) & DIGIT_MASK) == 0) {
+            continue;
+        }
+        Scatter(keys, scratch, size_t(1) << RADIX_BITS,
+                [shift](uint64_t key) { return size_t((key >> shift) & DIGIT_MASK); }, threadCount);
+        keys.swap(scratch);
+    }
+}
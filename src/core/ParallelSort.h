@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Data-parallel steps of bulk index builds (PolygonIndex)
+ *
+ * Work is split into contiguous blocks, one per thread, the calling thread
+ * taking the first. A stable counting scatter runs in two passes over the
+ * same blocks: each block counts its keys per bucket, then writes them
+ * from its own offsets, so the output never depends on the thread count.
+ * The radix sort is a scatter per digit, least significant first.
+ */
+class ParallelSort {
+public:
+    /**
+     * Number of blocks For() splits count items into: one per thread
+     * (threadCount 0 for the hardware threads), but none smaller than
+     * MIN_BLOCK_SIZE
+     */
+    static size_t BlockCount(size_t count, size_t threadCount);
+
+    /**
+     * Run body(block, begin, end) over the BlockCount() blocks of
+     * [0, count), each on a thread of its own
+     */
+    static void For(size_t count, size_t threadCount,
+                    const std::function<void(size_t block, size_t begin, size_t end)>& body);
+
+    /**
+     * Stable scatter of keys into buckets
+     * @param in Keys to scatter
+     * @param out Resized to in, then filled bucket after bucket, each in
+     *        the order of in
+     * @param bucketCount Number of buckets
+     * @param bucketOf Bucket of a key, below bucketCount; called twice per key
+     * @param threadCount Threads to use, 0 for the hardware threads
+     * @return Start of each bucket in out, then out's size
+     */
+    template <typename BucketOf>
+    static std::vector<size_t> Scatter(const std::vector<uint64_t>& in, std::vector<uint64_t>& out,
+                                       size_t bucketCount, const BucketOf& bucketOf, size_t threadCount);
+
+    /**
+     * Sort keys ascending: LSD radix, RADIX_BITS a pass, skipping the
+     * digits every key shares
+     * @param keys Keys to sort
+     * @param threadCount Threads to use, 0 for the hardware threads
+     */
+    static void RadixSort(std::vector<uint64_t>& keys, size_t threadCount = 0);
+
+    static constexpr size_t MIN_BLOCK_SIZE = 1 << 15;
+    static constexpr int RADIX_BITS = 11;
+
+    // Below this std::sort beats histogram passes
+    static constexpr size_t MIN_RADIX_SORT = 1024;
+};
+
+template <typename BucketOf>
+std::vector<size_t> ParallelSort::Scatter(const std::vector<uint64_t>& in, std::vector<uint64_t>& out,
+                                          size_t bucketCount, const BucketOf& bucketOf, size_t threadCount) {
+    const size_t blockCount = BlockCount(in.size(), threadCount);
+    out.resize(in.size());
+
+    // Count per block and bucket, then turn the counts into each block's
+    // first position in each bucket: bucket by bucket, block by block
+    std::vector<size_t> offsets(blockCount * bucketCount, 0);
+    For(in.size(), threadCount, [&](size_t block, size_t begin, size_t end) {
+        size_t* counts = offsets.data() + block * bucketCount;
+        for (size_t i = begin; i < end; ++i) {
+            ++counts[bucketOf(in[i])];
+        }
+    });
+    std::vector<size_t> starts(bucketCount + 1);
+    size_t position = 0;
+    for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        starts[bucket] = position;
+        for (size_t block = 0; block < blockCount; ++block) {
+            size_t& offset = offsets[block * bucketCount + bucket];
+            const size_t count = offset;
+            offset = position;
+            position += count;
+        }
+    }
+    starts[bucketCount] = position;
+
+    For(in.size(), threadCount, [&](size_t block, size_t begin, size_t end) {
+        size_t* next = offsets.data() + block * bucketCount;
+        for (size_t i = begin; i < end; ++i) {
+            out[next[bucketOf(in[i])]++] = in[i];
+        }
+    });
+    return starts;
+}
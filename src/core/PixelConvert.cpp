@@ -0,0 +1,115 @@
+#include "PixelConvert.h"
+
+namespace {
+
+constexpr size_t LAYOUT_COUNT = 5;
+constexpr size_t OUTPUT_LAYOUT_COUNT = 4;  // All but Gray8
+constexpr size_t ALPHA_MODE_COUNT = 3;
+
+template <PixelLayout Src, PixelLayout Dst>
+struct AlphaModes {
+    static constexpr RowConverter table[ALPHA_MODE_COUNT] = {
+        &PixelConvert::ConvertRow<Src, Dst, AlphaMode::Keep>,
+        &PixelConvert::ConvertRow<Src, Dst, AlphaMode::Opaque>,
+        &PixelConvert::ConvertRow<Src, Dst, AlphaMode::OverWhite>,
+    };
+};
+
+template <PixelLayout Src>
+struct Outputs {
+    static constexpr const RowConverter* table[OUTPUT_LAYOUT_COUNT] = {
+        AlphaModes<Src, PixelLayout::ARGB32>::table,
+        AlphaModes<Src, PixelLayout::RGBA8>::table,
+        AlphaModes<Src, PixelLayout::RGB24>::table,
+        AlphaModes<Src, PixelLayout::BGR24>::table,
+    };
+};
+
+// Indexed by the enum values: [src][dst][alpha]
+constexpr const RowConverter* const* CONVERTERS[LAYOUT_COUNT] = {
+    Outputs<PixelLayout::ARGB32>::table,
+    Outputs<PixelLayout::RGBA8>::table,
+    Outputs<PixelLayout::RGB24>::table,
+    Outputs<PixelLayout::BGR24>::table,
+    Outputs<PixelLayout::Gray8>::table,
+};
+
+}  // namespace
+
+RowConverter PixelConvert::Get(PixelLayout src, PixelLayout dst, AlphaMode alpha) {
+    const size_t srcIndex = static_cast<size_t>(src);
+    const size_t dstIndex = static_cast<size_t>(dst);
+    const size_t alphaIndex = static_cast<size_t>(alpha);
+    if (srcIndex >= LAYOUT_COUNT || dstIndex >= OUTPUT_LAYOUT_COUNT || alphaIndex >= ALPHA_MODE_COUNT) {
+        return nullptr;
+    }
+    return CONVERTERS[srcIndex][dstIndex][alphaIndex];
+}
+
+// 16-bit fixed point BT.601 full range: Y = 0.299 R + 0.587 G + 0.114 B,
+// Cb = 128 + 0.564 (B - Y), Cr = 128 + 0.713 (R - Y)
+void PixelConvert::ArgbToYuv420(const uint32_t* src, int32_t width, int32_t height, size_t srcStride,
+                                uint8_t* dst) {
+    const int32_t chromaWidth = (width + 1) / 2;
+    const int32_t chromaHeight = (height + 1) / 2;
+    uint8_t* luma = dst;
+    uint8_t* cb = dst + static_cast<size_t>(width) * height;
+    uint8_t* cr = cb + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    for (int32_t y = 0; y < height; ++y) {
+        const uint32_t* row = src + y * srcStride;
+        uint8_t* out = luma + static_cast<size_t>(y) * width;
+        for (int32_t x = 0; x < width; ++x) {
+            const uint32_t p = row[x];
+            const uint32_t r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+            out[x] = static_cast<uint8_t>((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+        }
+    }
+
+    // Chroma of each 2x2 block's mean colour
+    for (int32_t cy = 0; cy < chromaHeight; ++cy) {
+        const uint32_t* top = src + static_cast<size_t>(cy * 2) * srcStride;
+        const uint32_t* bottom = cy * 2 + 1 < height ? top + srcStride : top;
+        for (int32_t cx = 0; cx < chromaWidth; ++cx) {
+            const int32_t x0 = cx * 2;
+            const int32_t x1 = x0 + 1 < width ? x0 + 1 : x0;
+            int32_t r = 0, g = 0, b = 0;
+            const uint32_t block[4] = {top[x0], top[x1], bottom[x0], bottom[x1]};
+            for (uint32_t p : block) {
+                r += (p >> 16) & 0xFF;
+                g += (p >> 8) & 0xFF;
+                b += p & 0xFF;
+            }
+            // Sums of four: the /4 folds into the shift
+            const size_t i = static_cast<size_t>(cy) * chromaWidth + cx;
+            cb[i] = static_cast<uint8_t>((-11056 * r - 21712 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18);
+            cr[i] = static_cast<uint8_t>((32768 * r - 27440 * g - 5328 * b + (128 << 18) + (1 << 17)) >> 18);
+        }
+    }
+}
+
+void PixelConvert::Yuv420ToArgb(const uint8_t* src, int32_t width, int32_t height, uint32_t* dst,
+                                size_t dstStride) {
+    const int32_t chromaWidth = (width + 1) / 2;
+    const int32_t chromaHeight = (height + 1) / 2;
+    const uint8_t* luma = src;
+    const uint8_t* cb = src + static_cast<size_t>(width) * height;
+    const uint8_t* cr = cb + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    auto clamp = [](int32_t v) { return static_cast<uint32_t>(v < 0 ? 0 : (v > 255 ? 255 : v)); };
+    for (int32_t y = 0; y < height; ++y) {
+        const uint8_t* lumaRow = luma + static_cast<size_t>(y) * width;
+        const uint8_t* cbRow = cb + static_cast<size_t>(y / 2) * chromaWidth;
+        const uint8_t* crRow = cr + static_cast<size_t>(y / 2) * chromaWidth;
+        uint32_t* out = dst + y * dstStride;
+        for (int32_t x = 0; x < width; ++x) {
+            const int32_t l = lumaRow[x];
+            const int32_t u = cbRow[x / 2] - 128;
+            const int32_t v = crRow[x / 2] - 128;
+            const uint32_t r = clamp(l + ((91881 * v + 32768) >> 16));
+            const uint32_t g = clamp(l - ((22554 * u + 46802 * v + 32768) >> 16));
+            const uint32_t b = clamp(l + ((116130 * u + 32768) >> 16));
+            out[x] = 0xFF000000u | (r << 16) | (g << 8) | b;
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Row conversion between the pixel layouts tiles and images pass through.
+//
+//   ARGB32  native 0xAARRGGBB words, premultiplied (tiles, OpenSlide)
+//   RGBA8   bytes R, G, B, A (snapshot, PNG and WebP input)
+//   RGB24   bytes R, G, B (JPEG input)
+//   BGR24   bytes B, G, R (nvJPEG interleaved output)
+//   Gray8   one byte per pixel (single-channel images)
+//
+// Each kernel is a template over source layout, destination layout, alpha
+// handling and block width, so every combination compiles to its own
+// straight-line loop: a fixed-width block the compiler vectorizes, then a
+// scalar tail. Callers that know both layouts call ConvertRow directly;
+// Get() picks the instantiation from a table when the layout is only
+// known at runtime.
+enum class PixelLayout : uint8_t {
+    ARGB32,
+    RGBA8,
+    RGB24,
+    BGR24,
+    Gray8,
+};
+
+enum class AlphaMode : uint8_t {
+    Keep,       // Alpha copied through (255 for layouts without one)
+    Opaque,     // Alpha dropped, the result is opaque
+    OverWhite,  // Premultiplied colour composited onto white
+};
+
+using RowConverter = void (*)(const void* src, void* dst, size_t count);
+
+class PixelConvert {
+public:
+    // Pixels per block of the vectorized loop
+    static constexpr size_t BLOCK_PIXELS = 8;
+
+    static constexpr size_t BytesPerPixel(PixelLayout layout) {
+        switch (layout) {
+            case PixelLayout::ARGB32:
+            case PixelLayout::RGBA8:
+                return 4;
+            case PixelLayout::RGB24:
+            case PixelLayout::BGR24:
+                return 3;
+            case PixelLayout::Gray8:
+                return 1;
+        }
+        return 0;
+    }
+
+    // Converts count pixels from src to dst (which must not overlap)
+    template <PixelLayout Src, PixelLayout Dst, AlphaMode Alpha, size_t Block = BLOCK_PIXELS>
+    static void ConvertRow(const void* src, void* dst, size_t count);
+
+    // The ConvertRow instantiation for these layouts, or nullptr when dst
+    // is Gray8 (not an output layout)
+    static RowConverter Get(PixelLayout src, PixelLayout dst, AlphaMode alpha);
+
+    // Planar YUV 4:2:0 images (BT.601 full range, as in JPEG): a luma byte
+    // per pixel, then Cb and Cr planes of a byte per 2x2 block, the last
+    // column and row of blocks covering what is left of odd sizes. Alpha
+    // is dropped: only for opaque pixels, and the way back is opaque.
+    static size_t Yuv420Bytes(int32_t width, int32_t height) {
+        const size_t chroma = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+        return static_cast<size_t>(width) * height + 2 * chroma;
+    }
+    // src rows are srcStride pixels apart; dst holds Yuv420Bytes()
+    static void ArgbToYuv420(const uint32_t* src, int32_t width, int32_t height, size_t srcStride,
+                             uint8_t* dst);
+    // dst rows are dstStride pixels apart
+    static void Yuv420ToArgb(const uint8_t* src, int32_t width, int32_t height, uint32_t* dst,
+                             size_t dstStride);
+
+private:
+    struct Pixel {
+        uint32_t r, g, b, a;
+    };
+
+    template <PixelLayout Layout>
+    static Pixel Load(const uint8_t* in);
+
+    template <PixelLayout Layout>
+    static void Store(uint8_t* out, const Pixel& pixel);
+
+    template <AlphaMode Alpha>
+    static Pixel Apply(Pixel pixel) {
+        if (Alpha == AlphaMode::OverWhite) {
+            // Premultiplied, so each channel is at most alpha; the min only
+            // guards malformed input
+            const uint32_t background = 255 - pixel.a;
+            pixel.r = pixel.r + background > 255 ? 255 : pixel.r + background;
+            pixel.g = pixel.g + background > 255 ? 255 : pixel.g + background;
+            pixel.b = pixel.b + background > 255 ? 255 : pixel.b + background;
+            pixel.a = 255;
+        } else if (Alpha == AlphaMode::Opaque) {
+            pixel.a = 255;
+        }
+        return pixel;
+    }
+};
+
+template <>
+inline PixelConvert::Pixel PixelConvert::Load<PixelLayout::ARGB32>(const uint8_t* in) {
+    uint32_t word;
+    std::memcpy(&word, in, sizeof(word));
+    return {(word >> 16) & 0xFF, (word >> 8) & 0xFF, word & 0xFF, word >> 24};
+}
+
+template <>
+inline PixelConvert::Pixel PixelConvert::Load<PixelLayout::RGBA8>(const uint8_t* in) {
+    return {in[0], in[1], in[2], in[3]};
+}
+
+template <>
+inline PixelConvert::Pixel PixelConvert::Load<PixelLayout::RGB24>(const uint8_t* in) {
+    return {in[0], in[1], in[2], 255};
+}
+
+template <>
+inline PixelConvert::Pixel PixelConvert::Load<PixelLayout::BGR24>(const uint8_t* in) {
+    return {in[2], in[1], in[0], 255};
+}
+
+template <>
+inline PixelConvert::Pixel PixelConvert::Load<PixelLayout::Gray8>(const uint8_t* in) {
+    return {in[0], in[0], in[0], 255};
+}
+
+template <>
+inline void PixelConvert::Store<PixelLayout::ARGB32>(uint8_t* out, const Pixel& pixel) {
+    const uint32_t word = (pixel.a << 24) | (pixel.r << 16) | (pixel.g << 8) | pixel.b;
+    std::memcpy(out, &word, sizeof(word));
+}
+
+template <>
+inline void PixelConvert::Store<PixelLayout::RGBA8>(uint8_t* out, const Pixel& pixel) {
+    out[0] = static_cast<uint8_t>(pixel.r);
+    out[1] = static_cast<uint8_t>(pixel.g);
+    out[2] = static_cast<uint8_t>(pixel.b);
+    out[3] = static_cast<uint8_t>(pixel.a);
+}
+
+template <>
+inline void PixelConvert::Store<PixelLayout::RGB24>(uint8_t* out, const Pixel& pixel) {
+    out[0] = static_cast<uint8_t>(pixel.r);
+    out[1] = static_cast<uint8_t>(pixel.g);
+    out[2] = static_cast<uint8_t>(pixel.b);
+}
+
+template <>
+inline void PixelConvert::Store<PixelLayout::BGR24>(uint8_t* out, const Pixel& pixel) {
+    out[0] = static_cast<uint8_t>(pixel.b);
+    out[1] = static_cast<uint8_t>(pixel.g);
+    out[2] = static_cast<uint8_t>(pixel.r);
+}
+
+template <PixelLayout Src, PixelLayout Dst, AlphaMode Alpha, size_t Block>
+void PixelConvert::ConvertRow(const void* src, void* dst, size_t count) {
+    static_assert(Dst != PixelLayout::Gray8, "Gray8 is an input layout only");
+    static_assert(Block > 0, "Block must hold at least one pixel");
+    constexpr size_t IN = BytesPerPixel(Src);
+    constexpr size_t OUT = BytesPerPixel(Dst);
+
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    size_t i = 0;
+    for (; i + Block <= count; i += Block) {
+        // Fixed trip count, no aliasing between pixels: unrolled and
+        // vectorized at -O2 and above
+        for (size_t k = 0; k < Block; ++k) {
+            Store<Dst>(out + (i + k) * OUT, Apply<Alpha>(Load<Src>(in + (i + k) * IN)));
+        }
+    }
+    for (; i < count; ++i) {
+        Store<Dst>(out + i * OUT, Apply<Alpha>(Load<Src>(in + i * IN)));
+    }
+}
@@ -0,0 +1,472 @@
+#include "PolygonCache.h"
+#include "MappedFile.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include "TissueMap.h"
+#include "Log.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'P', 'V', 'P', 'O', 'L', 'Y', 'C', '\0'};
+
+enum Section : uint32_t {
+    SECTION_VERTICES,
+    SECTION_VERTEX_OFFSETS,
+    SECTION_VERTEX_COUNTS,
+    SECTION_CLASS_IDS,
+    SECTION_MIN_X,
+    SECTION_MIN_Y,
+    SECTION_MAX_X,
+    SECTION_MAX_Y,
+    SECTION_CENTROID_X,
+    SECTION_CENTROID_Y,
+    SECTION_CONFIDENCE,
+    SECTION_AREA,
+    SECTION_TRIANGLES,
+    SECTION_TRIANGLE_OFFSETS,
+    SECTION_TRIANGLE_COUNTS,
+    SECTION_SIMPLIFIED_OFFSETS,  // Simplified triangle lists, also in SECTION_TRIANGLES
+    SECTION_SIMPLIFIED_COUNTS,
+    SECTION_CLASSES,        // Per class: int32 ID, RGBA, uint32 name length, name
+    SECTION_INDEX_BOXES,    // Spatial index node boxes, leaves first
+    SECTION_INDEX_ENTRIES,  // Spatial index node entries
+    SECTION_TISSUE_MAP,     // TissueMap::Serialize(), empty without one
+    SECTION_COUNT
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t sourceSize;
+    int64_t sourceModified;  // Source's file_time_type ticks
+    uint64_t polygonCount;
+    uint64_t checksum;       // Over everything after the section table
+    int32_t indexNodeSize;   // 0 without a spatial index
+    uint32_t indexedCount;   // Leaves of the spatial index
+};
+
+struct SectionEntry {
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+static_assert(sizeof(FileHeader) == 56, "FileHeader layout is part of the format");
+static_assert(sizeof(SectionEntry) == 16, "SectionEntry layout is part of the format");
+static_assert(sizeof(Vec2f) == 8, "Vec2f layout is part of the format");
+
+constexpr uint64_t SECTION_ALIGNMENT = 8;
+constexpr uint64_t DATA_START = sizeof(FileHeader) + SECTION_COUNT * sizeof(SectionEntry);
+static_assert(DATA_START % SECTION_ALIGNMENT == 0, "Sections start aligned");
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// The columns are written as they are in memory; a big-endian host
+// neither writes nor reads sidecars
+bool IsLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first = 0;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// FNV-1a over 64-bit words, cheap enough to verify on every open. Every
+// section is zero-padded to whole words.
+constexpr uint64_t CHECKSUM_SEED = 0xCBF29CE484222325ull;
+
+uint64_t HashWords(uint64_t hash, const void* data, uint64_t bytes) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        hash ^= word;
+        hash *= 0x100000001B3ull;
+    }
+    if (i < bytes) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, static_cast<size_t>(bytes - i));
+        hash ^= word;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool SourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& modified) {
+    std::error_code ec;
+    size = static_cast<uint64_t>(fs::file_size(sourcePath, ec));
+    if (ec) {
+        return false;
+    }
+    auto time = fs::last_write_time(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+template <typename T>
+void AppendBytes(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+std::vector<uint8_t> EncodeClasses(const std::map<int, SDL_Color>& classColors,
+                                   const std::map<int, std::string>& classNames) {
+    // Every class with a color or a name
+    std::map<int, bool> classIds;
+    for (const auto& pair : classColors) {
+        classIds[pair.first] = true;
+    }
+    for (const auto& pair : classNames) {
+        classIds[pair.first] = true;
+    }
+
+    std::vector<uint8_t> out;
+    for (const auto& pair : classIds) {
+        auto color = classColors.find(pair.first);
+        SDL_Color rgba = color != classColors.end() ? color->second : SDL_Color{128, 128, 128, 255};
+        auto name = classNames.find(pair.first);
+        std::string text = name != classNames.end() ? name->second : std::string();
+
+        AppendBytes(out, static_cast<int32_t>(pair.first));
+        out.push_back(rgba.r);
+        out.push_back(rgba.g);
+        out.push_back(rgba.b);
+        out.push_back(rgba.a);
+        AppendBytes(out, static_cast<uint32_t>(text.size()));
+        out.insert(out.end(), text.begin(), text.end());
+    }
+    return out;
+}
+
+bool DecodeClasses(const uint8_t* data, uint64_t bytes,
+                   std::map<int, SDL_Color>& classColors,
+                   std::map<int, std::string>& classNames) {
+    uint64_t pos = 0;
+    while (pos < bytes) {
+        int32_t classId;
+        uint32_t nameLength;
+        if (bytes - pos < sizeof(classId) + 4 + sizeof(nameLength)) {
+            return false;
+        }
+        std::memcpy(&classId, data + pos, sizeof(classId));
+        pos += sizeof(classId);
+        SDL_Color color{data[pos], data[pos + 1], data[pos + 2], data[pos + 3]};
+        pos += 4;
+        std::memcpy(&nameLength, data + pos, sizeof(nameLength));
+        pos += sizeof(nameLength);
+        if (bytes - pos < nameLength) {
+            return false;
+        }
+
+        classColors[classId] = color;
+        if (nameLength > 0) {
+            classNames[classId] = std::string(reinterpret_cast<const char*>(data + pos), nameLength);
+        }
+        pos += nameLength;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string PolygonCache::SidecarPath(const std::string& sourcePath) {
+    return sourcePath + EXTENSION;
+}
+
+bool PolygonCache::IsFresh(const std::string& sourcePath) {
+    if (!IsLittleEndian()) {
+        return false;
+    }
+
+    std::ifstream file(SidecarPath(sourcePath), std::ios::binary);
+    FileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != VERSION) {
+        return false;
+    }
+
+    uint64_t sourceSize = 0;
+    int64_t sourceModified = 0;
+    return SourceStamp(sourcePath, sourceSize, sourceModified) &&
+           header.sourceSize == sourceSize && header.sourceModified == sourceModified;
+}
+
+bool PolygonCache::Write(const std::string& sourcePath, PolygonStore& polygons, const PolygonIndex* index,
+                         const std::map<int, SDL_Color>& classColors,
+                         const std::map<int, std::string>& classNames,
+                         const TissueMap* tissueMap) {
+    auto start = std::chrono::steady_clock::now();
+
+    FileHeader header{};
+    if (!IsLittleEndian() || !SourceStamp(sourcePath, header.sourceSize, header.sourceModified)) {
+        return false;
+    }
+
+    // Normally done at load already; a cached slide then skips it
+    polygons.TriangulateAll();
+
+    std::vector<uint8_t> classBytes = EncodeClasses(classColors, classNames);
+    std::vector<uint8_t> tissueBytes = tissueMap ? tissueMap->Serialize() : std::vector<uint8_t>();
+
+    // The packed tree as it is; one with polygons awaiting a pack is left
+    // out and rebuilt by the reader
+    static_assert(sizeof(PolygonIndex::Box) == 16, "Index node layout is part of the format");
+    static const std::vector<PolygonIndex::Box> noBoxes;
+    static const std::vector<uint32_t> noEntries;
+    const bool withIndex = index && index->pending_.empty() && index->itemCount_ == polygons.Size();
+    if (withIndex) {
+        header.indexNodeSize = index->nodeSize_;
+        header.indexedCount = static_cast<uint32_t>(index->itemCount_);
+    }
+
+    struct Span {
+        const void* data;
+        uint64_t bytes;
+    };
+    auto bytesOf = [](const auto& column) {
+        return Span{column.data(), column.size() * sizeof(column[0])};
+    };
+    const Span spans[SECTION_COUNT] = {
+        bytesOf(polygons.vertices_),
+        bytesOf(polygons.vertexOffsets_),
+        bytesOf(polygons.vertexCounts_),
+        bytesOf(polygons.classIds_),
+        bytesOf(polygons.minX_),
+        bytesOf(polygons.minY_),
+        bytesOf(polygons.maxX_),
+        bytesOf(polygons.maxY_),
+        bytesOf(polygons.centroidX_),
+        bytesOf(polygons.centroidY_),
+        bytesOf(polygons.confidence_),
+        bytesOf(polygons.area_),
+        bytesOf(polygons.triangles_),
+        bytesOf(polygons.triangleOffsets_),
+        bytesOf(polygons.triangleCounts_),
+        bytesOf(polygons.simplifiedOffsets_),
+        bytesOf(polygons.simplifiedCounts_),
+        bytesOf(classBytes),
+        bytesOf(withIndex ? index->boxes_ : noBoxes),
+        bytesOf(withIndex ? index->entries_ : noEntries),
+        bytesOf(tissueBytes),
+    };
+
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = VERSION;
+    header.sectionCount = SECTION_COUNT;
+    header.polygonCount = polygons.Size();
+    header.checksum = CHECKSUM_SEED;
+
+    SectionEntry sections[SECTION_COUNT];
+    uint64_t offset = DATA_START;
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        sections[s] = {offset, spans[s].bytes};
+        offset += AlignUp(spans[s].bytes);
+        header.checksum = HashWords(header.checksum, spans[s].data, spans[s].bytes);
+    }
+
+    // Unique per writer: the same file may be cached twice at once
+    static std::atomic<uint32_t> writeCounter{0};
+    const std::string cachePath = SidecarPath(sourcePath);
+    const std::string tempPath = cachePath + ".tmp" + std::to_string(writeCounter++);
+
+    bool written;
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+        const char padding[SECTION_ALIGNMENT] = {};
+        for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+            if (spans[s].bytes > 0) {
+                file.write(static_cast<const char*>(spans[s].data), static_cast<std::streamsize>(spans[s].bytes));
+            }
+            file.write(padding, static_cast<std::streamsize>(AlignUp(spans[s].bytes) - spans[s].bytes));
+        }
+        file.flush();
+        written = file.good();
+    }
+
+    std::error_code ec;
+    if (written) {
+        fs::rename(tempPath, cachePath, ec);
+    }
+    if (!written || ec) {
+        fs::remove(tempPath, ec);
+        PATHVIEW_LOG_ERROR("Cannot write polygon cache: " << cachePath);
+        return false;
+    }
+
+    PATHVIEW_LOG_INFO("Polygon cache written: " << cachePath << " (" << (offset / (1024 * 1024)) << " MB) in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms");
+    return true;
+}
+
+void PolygonCache::WriteInBackground(const std::string& sourcePath, PolygonStore polygons,
+                                     std::unique_ptr<PolygonIndex> index,
+                                     std::map<int, SDL_Color> classColors,
+                                     std::map<int, std::string> classNames,
+                                     std::unique_ptr<TissueMap> tissueMap) {
+    std::thread([sourcePath, polygons = std::move(polygons), index = std::move(index),
+                 classColors = std::move(classColors), classNames = std::move(classNames),
+                 tissueMap = std::move(tissueMap)]() mutable {
+        Write(sourcePath, polygons, index.get(), classColors, classNames, tissueMap.get());
+    }).detach();
+}
+
+bool PolygonCache::Read(const std::string& sourcePath, PolygonStore& polygons,
+                        std::unique_ptr<PolygonIndex>& index,
+                        std::map<int, SDL_Color>& classColors,
+                        std::map<int, std::string>& classNames,
+                        std::unique_ptr<TissueMap>& tissueMap) {
+    auto start = std::chrono::steady_clock::now();
+    if (!IsLittleEndian()) {
+        return false;
+    }
+
+    const std::string cachePath = SidecarPath(sourcePath);
+    MappedFile file(cachePath);
+    const uint8_t* data = file.Data();
+    const uint64_t size = file.Size();
+    if (!data || size < DATA_START) {
+        return false;
+    }
+
+    FileHeader header;
+    SectionEntry sections[SECTION_COUNT];
+    std::memcpy(&header, data, sizeof(header));
+    std::memcpy(sections, data + sizeof(header), sizeof(sections));
+
+    auto corrupt = [&cachePath](const char* reason) {
+        PATHVIEW_LOG_ERROR("Ignoring polygon cache " << cachePath << ": " << reason);
+        return false;
+    };
+
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != VERSION ||
+        header.sectionCount != SECTION_COUNT) {
+        return corrupt("unknown format or version");
+    }
+    if ((size - DATA_START) % SECTION_ALIGNMENT != 0) {
+        return corrupt("truncated");
+    }
+    for (const SectionEntry& section : sections) {
+        if (section.offset % SECTION_ALIGNMENT != 0 || section.offset < DATA_START ||
+            section.offset > size || section.bytes > size - section.offset) {
+            return corrupt("truncated");
+        }
+    }
+    if (HashWords(CHECKSUM_SEED, data + DATA_START, size - DATA_START) != header.checksum) {
+        return corrupt("checksum mismatch");
+    }
+
+    // Copy a section into a column; perPolygon columns hold one value per polygon
+    PolygonStore store;
+    bool sized = true;
+    auto copy = [&](Section s, auto& column, bool perPolygon) {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        const SectionEntry& section = sections[s];
+        if (section.bytes % sizeof(T) != 0 || (perPolygon && section.bytes / sizeof(T) != header.polygonCount)) {
+            sized = false;
+            return;
+        }
+        column.resize(static_cast<size_t>(section.bytes / sizeof(T)));
+        if (section.bytes > 0) {
+            std::memcpy(column.data(), data + section.offset, static_cast<size_t>(section.bytes));
+        }
+    };
+    copy(SECTION_VERTICES, store.vertices_, false);
+    copy(SECTION_VERTEX_OFFSETS, store.vertexOffsets_, true);
+    copy(SECTION_VERTEX_COUNTS, store.vertexCounts_, true);
+    copy(SECTION_CLASS_IDS, store.classIds_, true);
+    copy(SECTION_MIN_X, store.minX_, true);
+    copy(SECTION_MIN_Y, store.minY_, true);
+    copy(SECTION_MAX_X, store.maxX_, true);
+    copy(SECTION_MAX_Y, store.maxY_, true);
+    copy(SECTION_CENTROID_X, store.centroidX_, true);
+    copy(SECTION_CENTROID_Y, store.centroidY_, true);
+    copy(SECTION_CONFIDENCE, store.confidence_, true);
+    copy(SECTION_AREA, store.area_, true);
+    copy(SECTION_TRIANGLES, store.triangles_, false);
+    copy(SECTION_TRIANGLE_OFFSETS, store.triangleOffsets_, true);
+    copy(SECTION_TRIANGLE_COUNTS, store.triangleCounts_, true);
+    copy(SECTION_SIMPLIFIED_OFFSETS, store.simplifiedOffsets_, true);
+    copy(SECTION_SIMPLIFIED_COUNTS, store.simplifiedCounts_, true);
+    if (!sized) {
+        return corrupt("column sizes disagree");
+    }
+
+    // Offsets must stay inside the shared buffers
+    for (size_t polygon = 0; polygon < store.classIds_.size(); ++polygon) {
+        if (uint64_t(store.vertexOffsets_[polygon]) + store.vertexCounts_[polygon] > store.vertices_.size()) {
+            return corrupt("vertex range out of bounds");
+        }
+        uint32_t triangles = store.triangleCounts_[polygon];
+        if (triangles != PolygonStore::NOT_TRIANGULATED &&
+            (uint64_t(store.triangleOffsets_[polygon]) + triangles > store.triangles_.size() ||
+             uint64_t(store.simplifiedOffsets_[polygon]) + store.simplifiedCounts_[polygon] >
+                 store.triangles_.size())) {
+            return corrupt("triangle range out of bounds");
+        }
+    }
+
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    if (!DecodeClasses(data + sections[SECTION_CLASSES].offset, sections[SECTION_CLASSES].bytes, colors, names)) {
+        return corrupt("bad class table");
+    }
+
+    std::unique_ptr<PolygonIndex> tree;
+    if (header.indexNodeSize > 0) {
+        tree = std::make_unique<PolygonIndex>(header.indexNodeSize);
+        tree->itemCount_ = header.indexedCount;
+        tree->levelEnds_ = PolygonIndex::ComputeLevelEnds(tree->itemCount_, tree->nodeSize_);
+        copy(SECTION_INDEX_BOXES, tree->boxes_, false);
+        copy(SECTION_INDEX_ENTRIES, tree->entries_, false);
+        if (!sized || tree->nodeSize_ != header.indexNodeSize || tree->itemCount_ != header.polygonCount ||
+            !tree->HasValidLayout(static_cast<size_t>(header.polygonCount))) {
+            return corrupt("bad spatial index");
+        }
+    }
+
+    std::unique_ptr<TissueMap> tissue;
+    const SectionEntry& tissueSection = sections[SECTION_TISSUE_MAP];
+    if (tissueSection.bytes > 0) {
+        tissue = TissueMap::Deserialize(data + tissueSection.offset, tissueSection.bytes);
+        if (!tissue) {
+            return corrupt("bad tissue map");
+        }
+    }
+
+    polygons = std::move(store);
+    classColors = std::move(colors);
+    classNames = std::move(names);
+    tissueMap = std::move(tissue);
+
+    index = std::move(tree);
+    if (index) {
+        index->polygons_ = &polygons;
+        index->BuildClassMasks();
+        index->UpdateMemoryUsage();
+    }
+
+    PATHVIEW_LOG_INFO("Polygon cache read: " << polygons.Size() << " polygons from " << cachePath << " in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms");
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+class PolygonIndex;
+class PolygonStore;
+class TissueMap;
+
+// Binary sidecar written next to a polygon file after its first load
+// (<file>.pvcache), so reopening the file skips parsing altogether.
+//
+// The sidecar holds the PolygonStore columns as they are in memory (packed
+// vertices, class IDs, bounding boxes and the full and simplified
+// triangulations of every polygon), the class tables, the packed spatial
+// index tree if one was built (leaves in class order; its class masks are
+// rebuilt on read) and the tissue map if the file has one. Layout: a fixed
+// header, a table of section offsets, then 8-byte aligned little-endian
+// sections covered by a checksum. Reading maps the file and copies each
+// section into place with one memcpy.
+//
+// A sidecar is used only while its source keeps the size and modification
+// time recorded in it. It is written to a temporary file and renamed, so a
+// reader never sees a partial one.
+class PolygonCache {
+public:
+    static std::string SidecarPath(const std::string& sourcePath);
+
+    // True if sourcePath has a sidecar of this version written for its
+    // current contents
+    static bool IsFresh(const std::string& sourcePath);
+
+    // Write the sidecar of sourcePath, triangulating every polygon that is
+    // not yet. index and tissueMap may be null.
+    static bool Write(const std::string& sourcePath, PolygonStore& polygons, const PolygonIndex* index,
+                      const std::map<int, SDL_Color>& classColors,
+                      const std::map<int, std::string>& classNames,
+                      const TissueMap* tissueMap);
+
+    // Write() on a detached thread, from copies handed over by the caller
+    static void WriteInBackground(const std::string& sourcePath, PolygonStore polygons,
+                                  std::unique_ptr<PolygonIndex> index,
+                                  std::map<int, SDL_Color> classColors,
+                                  std::map<int, std::string> classNames,
+                                  std::unique_ptr<TissueMap> tissueMap);
+
+    // Read the sidecar of sourcePath (freshness is the caller's check).
+    // index receives the cached tree, bound to polygons, or null if the
+    // sidecar has none; likewise tissueMap. Leaves the outputs untouched on
+    // failure.
+    static bool Read(const std::string& sourcePath, PolygonStore& polygons,
+                     std::unique_ptr<PolygonIndex>& index,
+                     std::map<int, SDL_Color>& classColors,
+                     std::map<int, std::string>& classNames,
+                     std::unique_ptr<TissueMap>& tissueMap);
+
+    static constexpr const char* EXTENSION = ".pvcache";
+    static constexpr uint32_t VERSION = 7;
+};
@@ -0,0 +1,336 @@
+#include "PolygonClip.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+using Point = PolygonClip::Point;
+
+struct Edge {
+    Point a, b;
+};
+
+int64_t Snap(double v) {
+    v = std::max(-PolygonClip::MAX_COORDINATE, std::min(v, PolygonClip::MAX_COORDINATE));
+    return std::llround(v * PolygonClip::SNAP_SCALE);
+}
+
+int64_t Cross(int64_t ax, int64_t ay, int64_t bx, int64_t by) {
+    return ax * by - ay * bx;
+}
+
+// Twice the signed area, about the first vertex so small polygons far
+// from the origin keep their precision
+double TwiceArea(const std::vector<Point>& points) {
+    double twice = 0.0;
+    for (size_t i = 1; i + 1 < points.size(); ++i) {
+        twice += double(Cross(points[i].x - points[0].x, points[i].y - points[0].y,
+                              points[i + 1].x - points[0].x, points[i + 1].y - points[0].y));
+    }
+    return twice;
+}
+
+// Drop repeated vertices and turn the outline counterclockwise; empties
+// an outline without area
+void Prepare(std::vector<Point>& points) {
+    auto same = [](const Point& a, const Point& b) { return a.x == b.x && a.y == b.y; };
+    points.erase(std::unique(points.begin(), points.end(), same), points.end());
+    while (points.size() > 1 && same(points.front(), points.back())) {
+        points.pop_back();
+    }
+    const double twice = points.size() < 3 ? 0.0 : TwiceArea(points);
+    if (twice == 0.0) {
+        points.clear();
+    } else if (twice < 0.0) {
+        std::reverse(points.begin(), points.end());
+    }
+}
+
+std::vector<Point> SnapOutline(const std::vector<Vec2>& vertices) {
+    std::vector<Point> points;
+    points.reserve(vertices.size());
+    for (const Vec2& v : vertices) {
+        points.push_back({Snap(v.x), Snap(v.y)});
+    }
+    Prepare(points);
+    return points;
+}
+
+std::vector<Vec2> Unsnap(const std::vector<Point>& points) {
+    std::vector<Vec2> vertices;
+    vertices.reserve(points.size());
+    for (const Point& p : points) {
+        vertices.push_back(Vec2(p.x / PolygonClip::SNAP_SCALE, p.y / PolygonClip::SNAP_SCALE));
+    }
+    return vertices;
+}
+
+// Parameters along e (strictly between its ends) where the other edges
+// cross or touch it, or where a collinear one begins or ends
+void AddSplits(const Edge& e, const std::vector<Edge>& others, std::vector<double>& ts) {
+    const int64_t rx = e.b.x - e.a.x, ry = e.b.y - e.a.y;
+    for (const Edge& g : others) {
+        const int64_t sx = g.b.x - g.a.x, sy = g.b.y - g.a.y;
+        const int64_t qx = g.a.x - e.a.x, qy = g.a.y - e.a.y;
+        int64_t denom = Cross(rx, ry, sx, sy);
+        if (denom != 0) {
+            int64_t tn = Cross(qx, qy, sx, sy);
+            int64_t un = Cross(qx, qy, rx, ry);
+            if (denom < 0) {
+                denom = -denom;
+                tn = -tn;
+                un = -un;
+            }
+            if (tn > 0 && tn < denom && un >= 0 && un <= denom) {
+                ts.push_back(double(tn) / double(denom));
+            }
+        } else if (Cross(qx, qy, rx, ry) == 0) {
+            const int64_t rr = rx * rx + ry * ry;
+            for (const Point& w : {g.a, g.b}) {
+                const int64_t tn = (w.x - e.a.x) * rx + (w.y - e.a.y) * ry;
+                if (tn > 0 && tn < rr) {
+                    ts.push_back(double(tn) / double(rr));
+                }
+            }
+        }
+    }
+}
+
+// Whether the point (on e) lies within one of the other edges collinear
+// with e; same tells whether that edge runs the same way
+bool OnCollinearEdge(const Edge& e, double mx, double my, const std::vector<Edge>& others, bool& same) {
+    const int64_t rx = e.b.x - e.a.x, ry = e.b.y - e.a.y;
+    for (const Edge& g : others) {
+        const int64_t sx = g.b.x - g.a.x, sy = g.b.y - g.a.y;
+        if (Cross(rx, ry, sx, sy) != 0 || Cross(g.a.x - e.a.x, g.a.y - e.a.y, rx, ry) != 0) {
+            continue;
+        }
+        const double u = ((mx - g.a.x) * sx + (my - g.a.y) * sy) / double(sx * sx + sy * sy);
+        if (u > 0.0 && u < 1.0) {
+            same = rx * sx + ry * sy > 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RayCast(const std::vector<Point>& points, double x, double y) {
+    bool inside = false;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+        const double ax = double(points[j].x), ay = double(points[j].y);
+        const double bx = double(points[i].x), by = double(points[i].y);
+        if (((by > y) != (ay > y)) && (x < (ax - bx) * (y - by) / (ay - by) + bx)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Add twice the signed area swept by the pieces of edges inside the
+// other outline (as decided by inside), about an origin
+template <typename Inside>
+double IntegratePieces(const std::vector<Edge>& edges, const std::vector<Edge>& others, bool keepShared,
+                       const Point& origin, Inside inside) {
+    double twice = 0.0;
+    std::vector<double> ts;
+    for (const Edge& e : edges) {
+        ts.assign({0.0, 1.0});
+        AddSplits(e, others, ts);
+        std::sort(ts.begin(), ts.end());
+
+        const double rx = double(e.b.x - e.a.x), ry = double(e.b.y - e.a.y);
+        const double px = double(e.a.x - origin.x), py = double(e.a.y - origin.y);
+        for (size_t i = 0; i + 1 < ts.size(); ++i) {
+            const double t0 = ts[i], t1 = ts[i + 1];
+            if (!(t1 > t0)) {
+                continue;
+            }
+            const double tm = 0.5 * (t0 + t1);
+            const double mx = e.a.x + tm * rx, my = e.a.y + tm * ry;
+            bool same = false;
+            const bool keep = OnCollinearEdge(e, mx, my, others, same) ? keepShared && same : inside(mx, my);
+            if (keep) {
+                const double x0 = px + t0 * rx, y0 = py + t0 * ry;
+                const double x1 = px + t1 * rx, y1 = py + t1 * ry;
+                twice += x0 * y1 - x1 * y0;
+            }
+        }
+    }
+    return twice;
+}
+
+}  // namespace
+
+PolygonClip::PolygonClip(const std::vector<Vec2>& region)
+    : region_(SnapOutline(region))
+    , mask_(Unsnap(region_))
+{
+    if (region_.empty()) {
+        return;
+    }
+    area_ = TwiceArea(region_) / (2.0 * SNAP_SCALE * SNAP_SCALE);
+
+    int64_t maxX = region_[0].x, maxY = region_[0].y;
+    originX_ = maxX;
+    originY_ = maxY;
+    for (const Point& p : region_) {
+        originX_ = std::min(originX_, p.x);
+        originY_ = std::min(originY_, p.y);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+    }
+    const int64_t side = std::max(maxX - originX_, maxY - originY_);
+    bucketSize_ = std::max<int64_t>(1, (side + BUCKET_GRID - 1) / BUCKET_GRID);
+    columns_ = static_cast<int32_t>(std::min<int64_t>(BUCKET_GRID, (maxX - originX_) / bucketSize_ + 1));
+    rows_ = static_cast<int32_t>(std::min<int64_t>(BUCKET_GRID, (maxY - originY_) / bucketSize_ + 1));
+
+    auto clampCell = [](double cell, int32_t count) {
+        return static_cast<int32_t>(std::max(0.0, std::min(std::floor(cell), double(count - 1))));
+    };
+
+    // (bucket, edge) for the cells each edge passes through, row by row,
+    // then counted into row-major lists
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    const double size = double(bucketSize_);
+    for (size_t i = 0; i < region_.size(); ++i) {
+        const Point& a = region_[i];
+        const Point& b = region_[(i + 1) % region_.size()];
+        const double ax = double(a.x - originX_), ay = double(a.y - originY_);
+        const double bx = double(b.x - originX_), by = double(b.y - originY_);
+        const double low = std::min(ay, by), high = std::max(ay, by);
+
+        const int32_t lastRow = clampCell(high / size, rows_);
+        for (int32_t row = clampCell(low / size, rows_); row <= lastRow; ++row) {
+            double x0 = std::min(ax, bx), x1 = std::max(ax, bx);
+            if (ay != by) {
+                const double t0 = (std::max(low, row * size) - ay) / (by - ay);
+                const double t1 = (std::min(high, (row + 1) * size) - ay) / (by - ay);
+                x0 = ax + t0 * (bx - ax);
+                x1 = ax + t1 * (bx - ax);
+                if (x0 > x1) {
+                    std::swap(x0, x1);
+                }
+            }
+            // A grid step of slack either way absorbs the rounding
+            const int32_t lastColumn = clampCell((x1 + 1.0) / size, columns_);
+            for (int32_t column = clampCell((x0 - 1.0) / size, columns_); column <= lastColumn; ++column) {
+                entries.push_back({uint32_t(row) * uint32_t(columns_) + uint32_t(column), uint32_t(i)});
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    bucketStarts_.assign(size_t(columns_) * rows_ + 1, 0);
+    bucketEdges_.reserve(entries.size());
+    for (const auto& [bucket, edge] : entries) {
+        bucketStarts_[bucket + 1]++;
+        bucketEdges_.push_back(edge);
+    }
+    for (size_t i = 1; i < bucketStarts_.size(); ++i) {
+        bucketStarts_[i] += bucketStarts_[i - 1];
+    }
+}
+
+double PolygonClip::OverlapArea(const Vec2f* vertices, uint32_t count) const {
+    std::vector<Point> polygon;
+    polygon.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        polygon.push_back({Snap(vertices[i].x), Snap(vertices[i].y)});
+    }
+    return Overlap(polygon);
+}
+
+double PolygonClip::OverlapArea(const std::vector<Vec2>& polygon) const {
+    std::vector<Point> points = SnapOutline(polygon);
+    return Overlap(points);
+}
+
+double PolygonClip::OverlapArea(const Rect& box) const {
+    std::vector<Point> polygon = {
+        {Snap(box.x), Snap(box.y)}, {Snap(box.Right()), Snap(box.y)},
+        {Snap(box.Right()), Snap(box.Bottom())}, {Snap(box.x), Snap(box.Bottom())}
+    };
+    return Overlap(polygon);
+}
+
+PolygonMask::Overlap PolygonClip::Classify(const Rect& box) const {
+    // Widened by a grid step: the box's snapped corners may move that far
+    const double step = 1.0 / SNAP_SCALE;
+    return mask_.Classify(Rect(box.x - step, box.y - step, box.width + 2 * step, box.height + 2 * step));
+}
+
+double PolygonClip::Overlap(std::vector<Point>& polygon) const {
+    Prepare(polygon);
+    if (polygon.empty() || region_.empty()) {
+        return 0.0;
+    }
+
+    Point low = polygon[0], high = polygon[0];
+    for (const Point& p : polygon) {
+        low = {std::min(low.x, p.x), std::min(low.y, p.y)};
+        high = {std::max(high.x, p.x), std::max(high.y, p.y)};
+    }
+
+    // Region edges from the buckets the polygon's box reaches, kept if
+    // their own box meets it
+    const int32_t firstColumn = static_cast<int32_t>(std::max<int64_t>(0, (low.x - originX_) / bucketSize_));
+    const int32_t firstRow = static_cast<int32_t>(std::max<int64_t>(0, (low.y - originY_) / bucketSize_));
+    const int64_t lastColumn = std::min<int64_t>(columns_ - 1, (high.x - originX_) / bucketSize_);
+    const int64_t lastRow = std::min<int64_t>(rows_ - 1, (high.y - originY_) / bucketSize_);
+    std::vector<uint32_t> ids;
+    for (int64_t row = firstRow; row <= lastRow; ++row) {
+        for (int64_t column = firstColumn; column <= lastColumn; ++column) {
+            const size_t bucket = size_t(row) * columns_ + size_t(column);
+            ids.insert(ids.end(), bucketEdges_.begin() + bucketStarts_[bucket],
+                       bucketEdges_.begin() + bucketStarts_[bucket + 1]);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<Edge> regionEdges;
+    for (uint32_t id : ids) {
+        const Point& a = region_[id];
+        const Point& b = region_[(id + 1) % region_.size()];
+        if (std::max(a.x, b.x) >= low.x && std::min(a.x, b.x) <= high.x &&
+            std::max(a.y, b.y) >= low.y && std::min(a.y, b.y) <= high.y) {
+            regionEdges.push_back({a, b});
+        }
+    }
+    std::vector<Edge> polygonEdges;
+    polygonEdges.reserve(polygon.size());
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        polygonEdges.push_back({polygon[i], polygon[(i + 1) % polygon.size()]});
+    }
+
+    const Point& origin = polygon[0];
+    const double twicePolygon = TwiceArea(polygon);
+    if (regionEdges.empty()) {
+        // No crossing: wholly inside or wholly outside
+        const double x = double(polygon[0].x) / SNAP_SCALE, y = double(polygon[0].y) / SNAP_SCALE;
+        return mask_.Contains(x, y) ? twicePolygon / (2.0 * SNAP_SCALE * SNAP_SCALE) : 0.0;
+    }
+
+    // The polygon's edges inside the region keep a shared edge running the
+    // same way; the region's edges inside the polygon never do
+    double twice = IntegratePieces(polygonEdges, regionEdges, true, origin, [&](double x, double y) {
+        return mask_.Contains(x / SNAP_SCALE, y / SNAP_SCALE);
+    });
+    twice += IntegratePieces(regionEdges, polygonEdges, false, origin, [&](double x, double y) {
+        return RayCast(polygon, x, y);
+    });
+    return std::max(0.0, std::min(twice, twicePolygon)) / (2.0 * SNAP_SCALE * SNAP_SCALE);
+}
+
+double PolygonClip::IntersectionArea(const std::vector<Vec2>& a, const std::vector<Vec2>& b) {
+    return PolygonClip(b).OverlapArea(a);
+}
+
+double PolygonClip::UnionArea(const std::vector<Vec2>& a, const std::vector<Vec2>& b) {
+    PolygonClip clip(b);
+    return PolygonClip(a).GetArea() + clip.GetArea() - clip.OverlapArea(a);
+}
+
+double PolygonClip::DifferenceArea(const std::vector<Vec2>& a, const std::vector<Vec2>& b) {
+    return std::max(0.0, PolygonClip(a).GetArea() - IntersectionArea(a, b));
+}
@@ -0,0 +1,301 @@
+#include "PolygonDensity.h"
+#include "CellStatsPyramid.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Cells in a bin and the sums of their class colors
+struct Bin {
+    uint32_t count = 0;
+    uint32_t red = 0;
+    uint32_t green = 0;
+    uint32_t blue = 0;
+};
+
+constexpr double FULL_ALPHA_PERCENTILE = 0.95;
+
+void ToPixels(const std::vector<Bin>& bins, DensityLevel& level) {
+    std::vector<uint32_t> counts;
+    for (const Bin& bin : bins) {
+        if (bin.count > 0) {
+            counts.push_back(bin.count);
+        }
+    }
+    uint32_t fullCount = 1;
+    if (!counts.empty()) {
+        auto percentile = counts.begin() + static_cast<ptrdiff_t>((counts.size() - 1) * FULL_ALPHA_PERCENTILE);
+        std::nth_element(counts.begin(), percentile, counts.end());
+        fullCount = std::max<uint32_t>(1, *percentile);
+    }
+
+    level.pixels.assign(bins.size(), 0);
+    for (size_t i = 0; i < bins.size(); ++i) {
+        const Bin& bin = bins[i];
+        if (bin.count == 0) {
+            continue;
+        }
+        // Premultiplied: the mean color scaled by alpha
+        const double alpha = std::min(1.0, static_cast<double>(bin.count) / fullCount);
+        const double scale = alpha / bin.count;
+        const uint32_t a = static_cast<uint32_t>(std::lround(alpha * 255.0));
+        const uint32_t r = static_cast<uint32_t>(std::lround(bin.red * scale));
+        const uint32_t g = static_cast<uint32_t>(std::lround(bin.green * scale));
+        const uint32_t b = static_cast<uint32_t>(std::lround(bin.blue * scale));
+        level.pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+// Color the bins, then sum 2x2 bins into each coarser level until one
+// bin covers them all
+void BuildLevels(std::vector<Bin> bins, int32_t columns, int32_t rows, std::vector<DensityLevel>& levels) {
+    int32_t binSize = PolygonDensity::BIN_SIZE;
+    while (true) {
+        DensityLevel level;
+        level.binSize = binSize;
+        level.columns = columns;
+        level.rows = rows;
+        ToPixels(bins, level);
+        levels.push_back(std::move(level));
+        if (columns == 1 && rows == 1) {
+            break;
+        }
+
+        // Sum 2x2 bins into the next level
+        int32_t nextColumns = (columns + 1) / 2;
+        int32_t nextRows = (rows + 1) / 2;
+        std::vector<Bin> next(static_cast<size_t>(nextColumns) * nextRows);
+        for (int32_t row = 0; row < rows; ++row) {
+            for (int32_t column = 0; column < columns; ++column) {
+                const Bin& bin = bins[static_cast<size_t>(row) * columns + column];
+                Bin& sum = next[static_cast<size_t>(row / 2) * nextColumns + column / 2];
+                sum.count += bin.count;
+                sum.red += bin.red;
+                sum.green += bin.green;
+                sum.blue += bin.blue;
+            }
+        }
+        bins = std::move(next);
+        columns = nextColumns;
+        rows = nextRows;
+        binSize *= 2;
+    }
+}
+
+}  // namespace
+
+void PolygonDensity::Build(const PolygonStore& polygons, const std::map<int, SDL_Color>& classColors,
+                           const ClassVisibility& visibility, float minConfidence) {
+    auto start = std::chrono::steady_clock::now();
+    Clear();
+    if (polygons.Empty()) {
+        return;
+    }
+
+    // Level 0 spans the farthest center from the slide origin
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        maxX = std::max(maxX, (polygons.GetMinX(polygon) + polygons.GetMaxX(polygon)) * 0.5f);
+        maxY = std::max(maxY, (polygons.GetMinY(polygon) + polygons.GetMaxY(polygon)) * 0.5f);
+    }
+
+    int32_t columns = static_cast<int32_t>(maxX / BIN_SIZE) + 1;
+    int32_t rows = static_cast<int32_t>(maxY / BIN_SIZE) + 1;
+    std::vector<Bin> bins(static_cast<size_t>(columns) * rows);
+
+    const SDL_Color fallback = {128, 128, 128, 255};
+    int lastClassId = 0;
+    SDL_Color color = fallback;
+    bool haveColor = false;
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        if (polygons.GetConfidence(polygon) < minConfidence) {
+            continue;
+        }
+        float centerX = (polygons.GetMinX(polygon) + polygons.GetMaxX(polygon)) * 0.5f;
+        float centerY = (polygons.GetMinY(polygon) + polygons.GetMaxY(polygon)) * 0.5f;
+        int32_t column = std::max(0, static_cast<int32_t>(centerX / BIN_SIZE));
+        int32_t row = std::max(0, static_cast<int32_t>(centerY / BIN_SIZE));
+
+        // Neighbouring polygons mostly share a class
+        int classId = polygons.GetClassId(polygon);
+        if (!haveColor || classId != lastClassId) {
+            if (!visibility.IsVisible(classId)) {
+                continue;
+            }
+            auto it = classColors.find(classId);
+            color = it != classColors.end() ? it->second : fallback;
+            lastClassId = classId;
+            haveColor = true;
+        }
+
+        Bin& bin = bins[static_cast<size_t>(row) * columns + column];
+        ++bin.count;
+        bin.red += color.r;
+        bin.green += color.g;
+        bin.blue += color.b;
+    }
+
+    BuildLevels(std::move(bins), columns, rows, levels_);
+
+    PATHVIEW_LOG_INFO("Polygon density built: " << levels_.size() << " levels from "
+                      << levels_.front().columns << "x" << levels_.front().rows << " bins in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms");
+}
+
+bool PolygonDensity::Build(const CellStatsPyramid& stats, const std::map<int, SDL_Color>& classColors,
+                           const ClassVisibility& visibility) {
+    if (stats.Empty() || stats.GetLevel(0).binSize != BIN_SIZE) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    Clear();
+
+    // The pyramid's level 0 bins are these, offset by its origin; bins
+    // left of or above the slide origin fold into the first column or row
+    const CellStatsPyramid::Level& cells = stats.GetLevel(0);
+    const int32_t offsetX = static_cast<int32_t>(stats.GetOriginX() / BIN_SIZE);
+    const int32_t offsetY = static_cast<int32_t>(stats.GetOriginY() / BIN_SIZE);
+    const int32_t columns = std::max(1, offsetX + cells.columns);
+    const int32_t rows = std::max(1, offsetY + cells.rows);
+    std::vector<Bin> bins(static_cast<size_t>(columns) * rows);
+
+    const SDL_Color fallback = {128, 128, 128, 255};
+    for (int32_t y = 0; y < cells.rows; ++y) {
+        for (int32_t x = 0; x < cells.columns; ++x) {
+            const size_t node = static_cast<size_t>(y) * cells.columns + x;
+            if (cells.starts[node] == cells.starts[node + 1]) {
+                continue;
+            }
+            Bin& bin = bins[static_cast<size_t>(std::max(0, offsetY + y)) * columns + std::max(0, offsetX + x)];
+            for (uint32_t i = cells.starts[node]; i < cells.starts[node + 1]; ++i) {
+                const CellStatsPyramid::Entry& entry = cells.entries[i];
+                if (!visibility.IsVisible(entry.classId)) {
+                    continue;
+                }
+                auto it = classColors.find(entry.classId);
+                const SDL_Color color = it != classColors.end() ? it->second : fallback;
+                const uint32_t count = static_cast<uint32_t>(entry.stats.count);
+                bin.count += count;
+                bin.red += color.r * count;
+                bin.green += color.g * count;
+                bin.blue += color.b * count;
+            }
+        }
+    }
+
+    BuildLevels(std::move(bins), columns, rows, levels_);
+
+    PATHVIEW_LOG_INFO("Polygon density built from cell stats: " << levels_.size() << " levels from "
+                      << levels_.front().columns << "x" << levels_.front().rows << " bins in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms");
+    return true;
+}
+
+bool PolygonDensity::RenderOverview(const CellStatsPyramid& stats, const std::map<int, SDL_Color>& classColors,
+                                    const ClassVisibility& visibility, double slideWidth, double slideHeight,
+                                    int width, int height, std::vector<uint32_t>& pixels) {
+    if (stats.Empty() || width <= 0 || height <= 0 || slideWidth <= 0.0 || slideHeight <= 0.0) {
+        return false;
+    }
+
+    // Coarsest level with bins no larger than a pixel, else the finest
+    const double pixelWidth = slideWidth / width;
+    const double pixelHeight = slideHeight / height;
+    const double pixelSize = std::max(pixelWidth, pixelHeight);
+    size_t levelIndex = 0;
+    while (levelIndex + 1 < stats.GetLevelCount() && stats.GetLevel(levelIndex + 1).binSize <= pixelSize) {
+        ++levelIndex;
+    }
+    const CellStatsPyramid::Level& cells = stats.GetLevel(levelIndex);
+    const double binSize = cells.binSize;
+
+    // A node's visible classes as one bin
+    const SDL_Color fallback = {128, 128, 128, 255};
+    auto addNode = [&](size_t node, Bin& bin) {
+        for (uint32_t i = cells.starts[node]; i < cells.starts[node + 1]; ++i) {
+            const CellStatsPyramid::Entry& entry = cells.entries[i];
+            if (!visibility.IsVisible(entry.classId)) {
+                continue;
+            }
+            auto it = classColors.find(entry.classId);
+            const SDL_Color color = it != classColors.end() ? it->second : fallback;
+            const uint32_t count = static_cast<uint32_t>(entry.stats.count);
+            bin.count += count;
+            bin.red += color.r * count;
+            bin.green += color.g * count;
+            bin.blue += color.b * count;
+        }
+    };
+
+    std::vector<Bin> bins(static_cast<size_t>(width) * height);
+    if (binSize <= pixelSize) {
+        for (int32_t y = 0; y < cells.rows; ++y) {
+            const double centerY = stats.GetOriginY() + (y + 0.5) * binSize;
+            const int row = static_cast<int>(std::floor(centerY / pixelHeight));
+            if (row < 0 || row >= height) {
+                continue;
+            }
+            for (int32_t x = 0; x < cells.columns; ++x) {
+                const double centerX = stats.GetOriginX() + (x + 0.5) * binSize;
+                const int column = static_cast<int>(std::floor(centerX / pixelWidth));
+                if (column >= 0 && column < width) {
+                    addNode(static_cast<size_t>(y) * cells.columns + x,
+                            bins[static_cast<size_t>(row) * width + column]);
+                }
+            }
+        }
+    } else {
+        for (int row = 0; row < height; ++row) {
+            const double slideY = (row + 0.5) * pixelHeight - stats.GetOriginY();
+            const int32_t y = static_cast<int32_t>(std::floor(slideY / binSize));
+            if (y < 0 || y >= cells.rows) {
+                continue;
+            }
+            for (int column = 0; column < width; ++column) {
+                const double slideX = (column + 0.5) * pixelWidth - stats.GetOriginX();
+                const int32_t x = static_cast<int32_t>(std::floor(slideX / binSize));
+                if (x >= 0 && x < cells.columns) {
+                    addNode(static_cast<size_t>(y) * cells.columns + x,
+                            bins[static_cast<size_t>(row) * width + column]);
+                }
+            }
+        }
+    }
+
+    DensityLevel image;
+    ToPixels(bins, image);
+    pixels = std::move(image.pixels);
+    return true;
+}
+
+void PolygonDensity::Clear() {
+    levels_.clear();
+}
+
+void PolygonDensity::ReleasePixels() {
+    for (DensityLevel& level : levels_) {
+        std::vector<uint32_t>().swap(level.pixels);
+    }
+}
+
+size_t PolygonDensity::SelectLevel(double zoom, double minBinScreenPixels) const {
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].binSize * zoom >= minBinScreenPixels) {
+            return level;
+        }
+    }
+    return levels_.empty() ? 0 : levels_.size() - 1;
+}
+
+size_t PolygonDensity::GetMemoryUsage() const {
+    size_t bytes = 0;
+    for (const DensityLevel& level : levels_) {
+        bytes += level.pixels.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "PolygonStore.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class CellStatsPyramid;
+
+// One level of the density pyramid: a bin per pixel, covering slide
+// [0, columns * binSize) x [0, rows * binSize)
+struct DensityLevel {
+    int32_t binSize = 0;  // Slide pixels per bin side
+    int32_t columns = 0;
+    int32_t rows = 0;
+    std::vector<uint32_t> pixels;  // Premultiplied TILE_PIXEL_FORMAT (ARGB8888), row-major
+};
+
+// Precomputed cell density for zoomed-out views, so those frames cost
+// O(screen pixels) instead of O(cells).
+//
+// Polygon centers are counted in BIN_SIZE x BIN_SIZE slide pixel bins, and
+// each coarser level sums 2x2 bins of the one below until one bin covers
+// every polygon; hidden classes and cells below a confidence threshold are
+// left out. A bin's color is the mix of
+// its cells' class colors; its alpha grows with the count, reaching 1 at
+// the level's 95th percentile of non-empty bins so a few crowded bins do
+// not wash out the rest.
+class PolygonDensity {
+public:
+    void Build(const PolygonStore& polygons, const std::map<int, SDL_Color>& classColors,
+               const ClassVisibility& visibility = ClassVisibility(), float minConfidence = 0.0f);
+
+    // The same from a pyramid's level 0 class counts (binned by centroid
+    // instead of box center, no confidence threshold), without visiting
+    // the cells again; false,
+    // leaving the levels alone, if its bins are not BIN_SIZE
+    bool Build(const CellStatsPyramid& stats, const std::map<int, SDL_Color>& classColors,
+               const ClassVisibility& visibility = ClassVisibility());
+
+    /**
+     * The density of a whole slide as one small image (the minimap's), from
+     * the pyramid level nearest a pixel per bin: finer bins are summed into
+     * the pixel holding their center, coarser ones fill the pixels centered
+     * in them. Colored like a level, alpha from that image's percentile
+     * @param slideWidth, slideHeight Slide size the image spans
+     * @param pixels width x height premultiplied ARGB8888, row-major
+     * @return False, pixels untouched, for an empty pyramid or image
+     */
+    static bool RenderOverview(const CellStatsPyramid& stats, const std::map<int, SDL_Color>& classColors,
+                               const ClassVisibility& visibility, double slideWidth, double slideHeight,
+                               int width, int height, std::vector<uint32_t>& pixels);
+    void Clear();
+
+    // Drop the pixels once uploaded; the level geometry stays
+    void ReleasePixels();
+
+    bool Empty() const { return levels_.empty(); }
+    size_t GetLevelCount() const { return levels_.size(); }
+    const DensityLevel& GetLevel(size_t level) const { return levels_[level]; }
+
+    // The finest level whose bins cover at least minBinScreenPixels at this
+    // zoom (the coarsest if none do)
+    size_t SelectLevel(double zoom, double minBinScreenPixels) const;
+
+    // Bytes of the pixels held for upload
+    size_t GetMemoryUsage() const;
+
+    static constexpr int32_t BIN_SIZE = 64;
+
+private:
+    std::vector<DensityLevel> levels_;  // Finest first
+};
@@ -0,0 +1,293 @@
+#include "PolygonGeometryCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+void PolygonGeometryCache::Build(const PolygonStore& polygons) {
+    Clear();
+    if (polygons.Empty()) {
+        return;
+    }
+
+    // Chunk grid spans the farthest center from the slide origin
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        maxX = std::max(maxX, (polygons.GetMinX(polygon) + polygons.GetMaxX(polygon)) * 0.5f);
+        maxY = std::max(maxY, (polygons.GetMinY(polygon) + polygons.GetMaxY(polygon)) * 0.5f);
+    }
+    columns_ = static_cast<int32_t>(maxX / CHUNK_SIZE) + 1;
+    rows_ = static_cast<int32_t>(maxY / CHUNK_SIZE) + 1;
+    const size_t chunkCount = static_cast<size_t>(columns_) * rows_;
+
+    auto chunkOf = [&polygons, this](uint32_t polygon) {
+        float centerX = (polygons.GetMinX(polygon) + polygons.GetMaxX(polygon)) * 0.5f;
+        float centerY = (polygons.GetMinY(polygon) + polygons.GetMaxY(polygon)) * 0.5f;
+        int32_t column = std::max(0, static_cast<int32_t>(centerX / CHUNK_SIZE));
+        int32_t row = std::max(0, static_cast<int32_t>(centerY / CHUNK_SIZE));
+        return static_cast<size_t>(row) * columns_ + column;
+    };
+
+    // Counting sort into CSR; store order is kept within a chunk
+    chunkStarts_.assign(chunkCount + 1, 0);
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        ++chunkStarts_[chunkOf(polygon) + 1];
+    }
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        chunkStarts_[chunk + 1] += chunkStarts_[chunk];
+    }
+    chunkPolygons_.resize(polygons.Size());
+    std::vector<uint32_t> next(chunkStarts_.begin(), chunkStarts_.end() - 1);
+    const float inf = std::numeric_limits<float>::infinity();
+    chunkBounds_.assign(chunkCount, Bounds{inf, inf, -inf, -inf});
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        const size_t chunk = chunkOf(polygon);
+        chunkPolygons_[next[chunk]++] = polygon;
+
+        Bounds& bounds = chunkBounds_[chunk];
+        bounds.minX = std::min(bounds.minX, polygons.GetMinX(polygon));
+        bounds.minY = std::min(bounds.minY, polygons.GetMinY(polygon));
+        bounds.maxX = std::max(bounds.maxX, polygons.GetMaxX(polygon));
+        bounds.maxY = std::max(bounds.maxY, polygons.GetMaxY(polygon));
+        overhang_ = std::max({overhang_, polygons.GetMaxX(polygon) - polygons.GetMinX(polygon),
+                              polygons.GetMaxY(polygon) - polygons.GetMinY(polygon)});
+    }
+    geometry_.resize(chunkCount);
+}
+
+void PolygonGeometryCache::Clear() {
+    ++geometryVersion_;
+    columns_ = 0;
+    rows_ = 0;
+    overhang_ = 0.0f;
+    std::vector<uint32_t>().swap(chunkStarts_);
+    std::vector<uint32_t>().swap(chunkPolygons_);
+    std::vector<Bounds>().swap(chunkBounds_);
+    std::vector<PolygonChunkGeometry>().swap(geometry_);
+    geometryBytes_ = 0;
+}
+
+void PolygonGeometryCache::SetStyle(std::function<SDL_Color(int)> colorOf) {
+    colorOf_ = std::move(colorOf);
+    ++styleVersion_;
+}
+
+void PolygonGeometryCache::SetMinConfidence(float minConfidence) {
+    if (minConfidence != minConfidence_) {
+        minConfidence_ = minConfidence;
+        ++styleVersion_;
+    }
+}
+
+void PolygonGeometryCache::SetVisibility(const ClassVisibility& visibility) {
+    visibility_ = visibility;
+    ++geometryVersion_;
+    for (PolygonChunkGeometry& geometry : geometry_) {
+        geometry = PolygonChunkGeometry();
+    }
+    geometryBytes_ = 0;
+}
+
+void PolygonGeometryCache::QueryChunks(const Rect& region, std::vector<uint32_t>& outChunks) const {
+    outChunks.clear();
+    if (Empty()) {
+        return;
+    }
+
+    // A polygon's center lies within overhang_ of any point of its box
+    auto clampColumn = [this](double x) {
+        return static_cast<int32_t>(std::max(0.0, std::min(std::floor(x / CHUNK_SIZE), columns_ - 1.0)));
+    };
+    auto clampRow = [this](double y) {
+        return static_cast<int32_t>(std::max(0.0, std::min(std::floor(y / CHUNK_SIZE), rows_ - 1.0)));
+    };
+    const int32_t firstColumn = clampColumn(region.x - overhang_);
+    const int32_t lastColumn = clampColumn(region.x + region.width + overhang_);
+    const int32_t firstRow = clampRow(region.y - overhang_);
+    const int32_t lastRow = clampRow(region.y + region.height + overhang_);
+
+    for (int32_t row = firstRow; row <= lastRow; ++row) {
+        for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+            const uint32_t chunk = static_cast<uint32_t>(row * columns_ + column);
+            const Bounds& bounds = chunkBounds_[chunk];
+            if (chunkStarts_[chunk] == chunkStarts_[chunk + 1] ||
+                bounds.maxX < region.x || bounds.minX > region.x + region.width ||
+                bounds.maxY < region.y || bounds.minY > region.y + region.height) {
+                continue;
+            }
+            outChunks.push_back(chunk);
+        }
+    }
+}
+
+const PolygonChunkGeometry& PolygonGeometryCache::GetGeometry(uint32_t chunk, const PolygonStore& polygons) {
+    PolygonChunkGeometry& geometry = geometry_[chunk];
+    if (!geometry.built) {
+        geometryBytes_ += BuildGeometry(chunk, polygons, geometry);
+    }
+    if (geometry.styleVersion != styleVersion_) {
+        FillColors(geometry);
+        geometry.styleVersion = styleVersion_;
+    }
+    return geometry;
+}
+
+void PolygonGeometryCache::Prepare(const std::vector<uint32_t>& chunks, const PolygonStore& polygons,
+                                   const std::function<void(size_t, const PolygonChunkGeometry&)>& perChunk,
+                                   size_t threadCount) {
+    size_t unbuilt = 0;
+    size_t vertices = 0;
+    for (uint32_t chunk : chunks) {
+        if (geometry_[chunk].built) {
+            vertices += geometry_[chunk].xy.size() / 2;
+        } else {
+            ++unbuilt;
+        }
+    }
+
+    std::atomic<size_t> nextSlot{0};
+    std::atomic<size_t> builtBytes{0};
+    auto work = [&]() {
+        size_t bytes = 0;
+        for (size_t slot = nextSlot++; slot < chunks.size(); slot = nextSlot++) {
+            PolygonChunkGeometry& geometry = geometry_[chunks[slot]];
+            if (!geometry.built) {
+                bytes += BuildGeometry(chunks[slot], polygons, geometry);
+            }
+            if (geometry.styleVersion != styleVersion_) {
+                FillColors(geometry);
+                geometry.styleVersion = styleVersion_;
+            }
+            if (perChunk) {
+                perChunk(slot, geometry);
+            }
+        }
+        builtBytes += bytes;
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min({threadCount, MAX_THREADS, chunks.size()});
+    if (unbuilt < 2 && vertices < PARALLEL_MIN_VERTICES) {
+        threadCount = 1;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threadCount; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    geometryBytes_ += builtBytes.load();
+}
+
+size_t PolygonGeometryCache::BuildGeometry(uint32_t chunk, const PolygonStore& polygons,
+                                           PolygonChunkGeometry& geometry) const {
+    // Smallest first, so the simplified polygons of a frame are a prefix
+    std::vector<uint32_t> order(chunkPolygons_.begin() + chunkStarts_[chunk],
+                                chunkPolygons_.begin() + chunkStarts_[chunk + 1]);
+    auto sizeOf = [&polygons](uint32_t polygon) {
+        return std::max(polygons.GetMaxX(polygon) - polygons.GetMinX(polygon),
+                        polygons.GetMaxY(polygon) - polygons.GetMinY(polygon));
+    };
+    std::stable_sort(order.begin(), order.end(),
+                     [&sizeOf](uint32_t a, uint32_t b) { return sizeOf(a) < sizeOf(b); });
+
+    const float originX = GetOriginX(chunk);
+    const float originY = GetOriginY(chunk);
+    std::vector<int> fullIndices;
+    std::vector<uint32_t> fullEnds;
+    for (uint32_t polygon : order) {
+        const uint32_t vertexCount = polygons.GetVertexCount(polygon);
+        if (vertexCount < 3 || !visibility_.IsVisible(polygons.GetClassId(polygon))) {
+            continue;
+        }
+        uint32_t triangleCount = 0;
+        const uint32_t* triangles = polygons.GetTriangles(polygon, triangleCount);
+        if (triangleCount == 0) {
+            continue;
+        }
+        uint32_t simplifiedCount = 0;
+        const uint32_t* simplified = polygons.GetSimplifiedTriangles(polygon, simplifiedCount);
+
+        const int baseIndex = static_cast<int>(geometry.xy.size() / 2);
+        const Vec2f* vertices = polygons.GetVertices(polygon);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            geometry.xy.push_back(vertices[v].x - originX);
+            geometry.xy.push_back(vertices[v].y - originY);
+        }
+        geometry.simplifiedStarts.push_back(static_cast<uint32_t>(geometry.indices.size()));
+        for (uint32_t t = 0; t < simplifiedCount; ++t) {
+            geometry.indices.push_back(baseIndex + static_cast<int>(simplified[t]));
+        }
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            fullIndices.push_back(baseIndex + static_cast<int>(triangles[t]));
+        }
+        fullEnds.push_back(static_cast<uint32_t>(fullIndices.size()));
+        geometry.sizes.push_back(sizeOf(polygon));
+        geometry.confidences.push_back(polygons.GetConfidence(polygon));
+        geometry.vertexStarts.push_back(static_cast<uint32_t>(baseIndex));
+
+        const int classId = polygons.GetClassId(polygon);
+        if (geometry.runs.empty() || geometry.runs.back().classId != classId) {
+            geometry.runs.push_back({classId, 0});
+        }
+        geometry.runs.back().vertexCount += vertexCount;
+    }
+
+    // Full triangles follow the simplified ones
+    const uint32_t fullBegin = static_cast<uint32_t>(geometry.indices.size());
+    geometry.simplifiedStarts.push_back(fullBegin);
+    geometry.fullStarts.push_back(fullBegin);
+    for (uint32_t end : fullEnds) {
+        geometry.fullStarts.push_back(fullBegin + end);
+    }
+    geometry.indices.insert(geometry.indices.end(), fullIndices.begin(), fullIndices.end());
+    geometry.vertexStarts.push_back(static_cast<uint32_t>(geometry.xy.size() / 2));
+
+    geometry.xy.shrink_to_fit();
+    geometry.indices.shrink_to_fit();
+    geometry.sizes.shrink_to_fit();
+    geometry.simplifiedStarts.shrink_to_fit();
+    geometry.fullStarts.shrink_to_fit();
+    geometry.runs.shrink_to_fit();
+    geometry.confidences.shrink_to_fit();
+    geometry.vertexStarts.shrink_to_fit();
+
+    geometry.colors.resize(geometry.xy.size() / 2);
+    geometry.built = true;
+    return geometry.xy.capacity() * sizeof(float) + geometry.colors.capacity() * sizeof(SDL_Color) +
+           geometry.indices.capacity() * sizeof(int) + geometry.sizes.capacity() * sizeof(float) +
+           (geometry.simplifiedStarts.capacity() + geometry.fullStarts.capacity() +
+            geometry.vertexStarts.capacity()) * sizeof(uint32_t) +
+           geometry.confidences.capacity() * sizeof(float) +
+           geometry.runs.capacity() * sizeof(PolygonChunkGeometry::ClassRun);
+}
+
+void PolygonGeometryCache::FillColors(PolygonChunkGeometry& geometry) const {
+    auto vertex = geometry.colors.begin();
+    for (const PolygonChunkGeometry::ClassRun& run : geometry.runs) {
+        const SDL_Color color = colorOf_ ? colorOf_(run.classId) : SDL_Color{128, 128, 128, 255};
+        vertex = std::fill_n(vertex, run.vertexCount, color);
+    }
+    if (minConfidence_ <= 0.0f) {
+        return;
+    }
+    for (size_t polygon = 0; polygon < geometry.confidences.size(); ++polygon) {
+        if (geometry.confidences[polygon] < minConfidence_) {
+            for (uint32_t v = geometry.vertexStarts[polygon]; v < geometry.vertexStarts[polygon + 1]; ++v) {
+                geometry.colors[v].a = 0;
+            }
+        }
+    }
+}
+
+size_t PolygonGeometryCache::GetMemoryUsage() const {
+    return chunkStarts_.capacity() * sizeof(uint32_t) + chunkPolygons_.capacity() * sizeof(uint32_t) +
+           chunkBounds_.capacity() * sizeof(Bounds) + geometry_.capacity() * sizeof(PolygonChunkGeometry) +
+           geometryBytes_;
+}
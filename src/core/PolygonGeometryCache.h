@@ -0,0 +1,143 @@
+#pragma once
+
+#include "PolygonStore.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Ready-to-draw triangles of one chunk, in slide coordinates relative to
+// the chunk's origin so float positions stay exact far into the slide
+struct PolygonChunkGeometry {
+    // Consecutive vertices of one class
+    struct ClassRun {
+        int classId;
+        uint32_t vertexCount;
+    };
+
+    std::vector<float> xy;          // x, y per vertex
+    std::vector<SDL_Color> colors;  // Per vertex, with the overlay's alpha
+    std::vector<ClassRun> runs;     // In vertex order
+
+    // Per polygon, in vertex order: its segmentation confidence and first
+    // vertex (one more entry, the vertex count), so a confidence threshold
+    // is applied when colors are filled rather than by rebuilding
+    std::vector<float> confidences;
+    std::vector<uint32_t> vertexStarts;
+
+    // Three per triangle: the simplified triangles of every polygon, then
+    // the full ones. Polygons are in ascending size order, so drawing the k
+    // smallest simplified is indices [0, simplifiedStarts[k]) plus
+    // [fullStarts[k], end). Both start tables have a polygon count + 1 entry.
+    std::vector<int> indices;
+    std::vector<float> sizes;  // Larger box side in slide pixels, ascending
+    std::vector<uint32_t> simplifiedStarts;
+    std::vector<uint32_t> fullStarts;
+
+    uint64_t styleVersion = 0;      // Style the colors were filled with
+    bool built = false;
+};
+
+// Persistent polygon geometry for close-up views, built once per chunk
+// instead of per frame.
+//
+// Polygons are bucketed by bounding-box center into CHUNK_SIZE slide pixel
+// chunks. A chunk's vertices, colors and triangle indices are assembled
+// the first time it is drawn and kept; a frame then only maps the kept
+// positions to the screen (one multiply-add per coordinate) and submits
+// each visible chunk as two SDL_RenderGeometryRaw() calls, one for the
+// polygons small enough to draw simplified and one for the rest. A style
+// change refills the colors of chunks as they are next drawn; hiding or
+// showing a class drops the kept geometry, which leaves hidden classes out
+// as it is rebuilt. A confidence threshold is part of the style: cells
+// below it keep their triangles but get alpha 0, so dragging it only
+// refills colors.
+//
+// Prepare() builds a frame's new chunks and runs the caller's per-chunk
+// work (the screen transform) across threads, each chunk into its own
+// buffers, so the render thread is left with submitting them in order.
+class PolygonGeometryCache {
+public:
+    // Bucket the store's polygons; geometry is built lazily by GetGeometry()
+    void Build(const PolygonStore& polygons);
+    void Clear();
+    bool Empty() const { return chunkBounds_.empty(); }
+    size_t GetChunkCount() const { return chunkBounds_.size(); }
+
+    // Color (alpha included) of each class from now on
+    void SetStyle(std::function<SDL_Color(int)> colorOf);
+
+    // Cells with a lower confidence are drawn transparent from now on
+    void SetMinConfidence(float minConfidence);
+    float GetMinConfidence() const { return minConfidence_; }
+
+    // Changes with every SetStyle() / SetMinConfidence(): colors filled
+    // under an older one are refilled on next use
+    uint64_t GetStyleVersion() const { return styleVersion_; }
+
+    // Classes to include from now on; chunks are rebuilt on next use
+    void SetVisibility(const ClassVisibility& visibility);
+
+    // Chunks whose polygons may intersect the region, into a reused buffer
+    void QueryChunks(const Rect& region, std::vector<uint32_t>& outChunks) const;
+
+    // Slide position of a chunk's geometry origin
+    float GetOriginX(uint32_t chunk) const { return static_cast<float>((chunk % columns_) * CHUNK_SIZE); }
+    float GetOriginY(uint32_t chunk) const { return static_cast<float>((chunk / columns_) * CHUNK_SIZE); }
+
+    // A chunk's geometry, assembled from the store's triangulations on
+    // first use; its colors are refilled after a style change
+    const PolygonChunkGeometry& GetGeometry(uint32_t chunk, const PolygonStore& polygons);
+
+    // GetGeometry() for every listed chunk, then perChunk(slot, geometry)
+    // with slot the chunk's index in chunks. Spread over up to threadCount
+    // threads (0: the hardware's) when chunks need building or hold
+    // PARALLEL_MIN_VERTICES, so perChunk must only write its own slot's
+    // state. Afterwards GetGeometry() of these chunks is a lookup.
+    void Prepare(const std::vector<uint32_t>& chunks, const PolygonStore& polygons,
+                 const std::function<void(size_t, const PolygonChunkGeometry&)>& perChunk = nullptr,
+                 size_t threadCount = 0);
+
+    // Bytes of the chunk table and the geometry built so far
+    size_t GetMemoryUsage() const;
+
+    // Changes whenever kept positions may change (Build, Clear,
+    // SetVisibility), so screen positions mapped from them can be reused
+    // while it does not
+    uint64_t GetGeometryVersion() const { return geometryVersion_; }
+
+    static constexpr int32_t CHUNK_SIZE = 512;
+    // Below this many kept vertices (and with at most one chunk to build)
+    // starting threads costs more than Prepare() saves
+    static constexpr size_t PARALLEL_MIN_VERTICES = 256 * 1024;
+    static constexpr size_t MAX_THREADS = 8;
+
+private:
+    struct Bounds {
+        float minX, minY, maxX, maxY;
+    };
+
+    int32_t columns_ = 0;
+    int32_t rows_ = 0;
+    float overhang_ = 0.0f;  // Farthest a polygon reaches outside its chunk
+
+    // Chunk polygons, CSR: chunk c holds chunkPolygons_[chunkStarts_[c] ..
+    // chunkStarts_[c + 1]), ordered by store index
+    std::vector<uint32_t> chunkStarts_;
+    std::vector<uint32_t> chunkPolygons_;
+    std::vector<Bounds> chunkBounds_;  // Union of the chunk's polygon boxes
+    std::vector<PolygonChunkGeometry> geometry_;
+    size_t geometryBytes_ = 0;
+
+    std::function<SDL_Color(int)> colorOf_;
+    float minConfidence_ = 0.0f;
+    uint64_t styleVersion_ = 1;
+    uint64_t geometryVersion_ = 1;
+    ClassVisibility visibility_;
+
+    // Assembles an unbuilt chunk's geometry, returning its bytes. Touches
+    // no other chunk, so chunks build concurrently.
+    size_t BuildGeometry(uint32_t chunk, const PolygonStore& polygons, PolygonChunkGeometry& geometry) const;
+    void FillColors(PolygonChunkGeometry& geometry) const;
+};
@@ -1,139 +1,543 @@
 #include "PolygonIndex.h"
-#include <iostream>
+#include "Log.h"
+#include "ParallelSort.h"
 #include <algorithm>
-#include <set>
+#include <chrono>
+#include <limits>
+#include <queue>
+#include <utility>
 
-PolygonIndex::PolygonIndex(int gridWidth, int gridHeight,
-                           double slideWidth, double slideHeight)
-    : gridWidth_(gridWidth)
-    , gridHeight_(gridHeight) {
+namespace {
 
-    // Calculate cell dimensions
-    cellWidth_ = slideWidth / gridWidth;
-    cellHeight_ = slideHeight / gridHeight;
+// Hilbert curve through a 2^16 x 2^16 grid
+constexpr uint32_t HILBERT_SIDE = 1u << 16;
 
-    // Initialize grid
-    grid_.resize(gridHeight_);
-    for (auto& row : grid_) {
-        row.resize(gridWidth_);
+uint32_t HilbertIndex(uint32_t x, uint32_t y) {
+    uint32_t index = 0;
+    for (uint32_t s = HILBERT_SIDE / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        index += s * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = HILBERT_SIDE - 1 - x;
+                y = HILBERT_SIDE - 1 - y;
+            }
+            std::swap(x, y);
+        }
     }
+    return index;
+}
+
+template <typename Box>
+bool Overlaps(const Box& box, const Rect& region) {
+    return !(box.maxX < region.x || region.x + region.width < box.minX ||
+             box.maxY < region.y || region.y + region.height < box.minY);
+}
+
+template <typename Box>
+bool Contains(const Rect& region, const Box& box) {
+    return region.x <= box.minX && box.maxX <= region.x + region.width &&
+           region.y <= box.minY && box.maxY <= region.y + region.height;
+}
+
+double DistanceSquared(const Vec2& point, double minX, double minY, double maxX, double maxY) {
+    double dx = std::max({minX - point.x, 0.0, point.x - maxX});
+    double dy = std::max({minY - point.y, 0.0, point.y - maxY});
+    return dx * dx + dy * dy;
+}
+
+}  // namespace
 
-    std::cout << "PolygonIndex created: " << gridWidth_ << "x" << gridHeight_
-              << " grid, cell size: " << cellWidth_ << "x" << cellHeight_ << std::endl;
+PolygonIndex::PolygonIndex(int nodeSize)
+    : nodeSize_(std::max(2, nodeSize)) {
 }
 
-void PolygonIndex::Build(std::vector<Polygon>& polygons) {
-    // Clear existing index
+void PolygonIndex::Build(const PolygonStore& polygons, size_t threadCount) {
+    [[maybe_unused]] auto start = std::chrono::steady_clock::now();  // Debug builds log the build time
+
+    // Clear existing index, then pack every polygon
     Clear();
+    polygons_ = &polygons;
 
-    // Insert each polygon into overlapping grid cells
-    for (auto& polygon : polygons) {
-        std::vector<std::pair<int, int>> cells;
-        GetIntersectingCells(polygon.boundingBox, cells);
+    std::vector<uint32_t> all(polygons.Size());
+    for (uint32_t polygon = 0; polygon < all.size(); ++polygon) {
+        all[polygon] = polygon;
+    }
+    BuildTree(all, threadCount);
+    UpdateMemoryUsage();
 
-        for (const auto& cellCoord : cells) {
-            int cellX = cellCoord.first;
-            int cellY = cellCoord.second;
-            grid_[cellY][cellX].polygons.push_back(&polygon);
-        }
+    PATHVIEW_LOG_DEBUG("Spatial index built: " << itemCount_ << " polygons, "
+                       << levelEnds_.size() << " levels of " << nodeSize_ << "-child nodes, "
+                       << (memoryUsage_ / 1024) << " KB in "
+                       << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                       << " ms");
+}
+
+void PolygonIndex::Insert(const PolygonStore& polygons, uint32_t begin, uint32_t end) {
+    polygons_ = &polygons;
+    for (uint32_t polygon = begin; polygon < end; ++polygon) {
+        pending_.push_back(polygon);
+    }
+
+    // Repack once the linear part is a fair share of the tree, so a
+    // streaming load repacks a logarithmic number of times
+    if (pending_.size() >= std::max(MIN_PENDING_TO_PACK, itemCount_ / 4)) {
+        Pack();
+    }
+    UpdateMemoryUsage();
+}
+
+void PolygonIndex::Pack() {
+    if (pending_.empty() || !polygons_) {
+        return;
     }
 
-    // Print statistics
-    size_t totalEntries = 0;
-    size_t maxPerCell = 0;
-    size_t nonEmptyCells = 0;
+    std::vector<uint32_t> all(entries_.begin(), entries_.begin() + itemCount_);
+    all.insert(all.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+    pending_.shrink_to_fit();
 
-    for (const auto& row : grid_) {
-        for (const auto& cell : row) {
-            size_t count = cell.polygons.size();
-            if (count > 0) {
-                ++nonEmptyCells;
-                totalEntries += count;
-                maxPerCell = std::max(maxPerCell, count);
+    BuildTree(all);
+    UpdateMemoryUsage();
+}
+
+void PolygonIndex::BuildTree(const std::vector<uint32_t>& polygons, size_t threadCount) {
+    boxes_.clear();
+    entries_.clear();
+    levelEnds_.clear();
+    itemCount_ = polygons.size();
+    if (itemCount_ == 0) {
+        return;
+    }
+
+    // Hilbert order of the box centers, scaled to the curve's grid. Blocks
+    // of polygons find their bounds and classes in parallel.
+    struct BlockSummary {
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest();
+        float maxY = std::numeric_limits<float>::lowest();
+        std::vector<int> classIds;
+    };
+    std::vector<BlockSummary> summaries(ParallelSort::BlockCount(itemCount_, threadCount));
+    ParallelSort::For(itemCount_, threadCount, [&](size_t block, size_t begin, size_t end) {
+        BlockSummary& summary = summaries[block];
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t polygon = polygons[i];
+            float centerX = (polygons_->GetMinX(polygon) + polygons_->GetMaxX(polygon)) * 0.5f;
+            float centerY = (polygons_->GetMinY(polygon) + polygons_->GetMaxY(polygon)) * 0.5f;
+            summary.minX = std::min(summary.minX, centerX);
+            summary.minY = std::min(summary.minY, centerY);
+            summary.maxX = std::max(summary.maxX, centerX);
+            summary.maxY = std::max(summary.maxY, centerY);
+            const int classId = polygons_->GetClassId(polygon);
+            if (summary.classIds.empty() || summary.classIds.back() != classId) {
+                summary.classIds.push_back(classId);
             }
         }
+    });
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    std::vector<int> classIds;
+    for (const BlockSummary& summary : summaries) {
+        minX = std::min(minX, summary.minX);
+        minY = std::min(minY, summary.minY);
+        maxX = std::max(maxX, summary.maxX);
+        maxY = std::max(maxY, summary.maxY);
+        classIds.insert(classIds.end(), summary.classIds.begin(), summary.classIds.end());
     }
+    std::sort(classIds.begin(), classIds.end());
+    classIds.erase(std::unique(classIds.begin(), classIds.end()), classIds.end());
+    const double scaleX = maxX > minX ? (HILBERT_SIDE - 1) / (double(maxX) - minX) : 0.0;
+    const double scaleY = maxY > minY ? (HILBERT_SIDE - 1) / (double(maxY) - minY) : 0.0;
 
-    double avgPerCell = nonEmptyCells > 0 ?
-                        static_cast<double>(totalEntries) / nonEmptyCells : 0.0;
+    // Curve position in the high half, store index in the low half
+    std::vector<uint64_t> keys(itemCount_);
+    ParallelSort::For(itemCount_, threadCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t polygon = polygons[i];
+            double centerX = (polygons_->GetMinX(polygon) + polygons_->GetMaxX(polygon)) * 0.5;
+            double centerY = (polygons_->GetMinY(polygon) + polygons_->GetMaxY(polygon)) * 0.5;
+            uint32_t x = static_cast<uint32_t>((centerX - minX) * scaleX);
+            uint32_t y = static_cast<uint32_t>((centerY - minY) * scaleY);
+            keys[i] = (uint64_t(HilbertIndex(x, y)) << 32) | polygon;
+        }
+    });
+    ParallelSort::RadixSort(keys, threadCount);
+
+    // Leaves go class by class: a stable scatter keeps each class in curve
+    // order
+    if (classIds.size() > 1) {
+        std::vector<uint64_t> byClass;
+        ParallelSort::Scatter(keys, byClass, classIds.size(), [&](uint64_t key) {
+            const int classId = polygons_->GetClassId(static_cast<uint32_t>(key));
+            return size_t(std::lower_bound(classIds.begin(), classIds.end(), classId) - classIds.begin());
+        }, threadCount);
+        keys.swap(byClass);
+    }
 
-    std::cout << "Spatial index built: "
-              << nonEmptyCells << " / " << (gridWidth_ * gridHeight_) << " cells occupied"
-              << ", avg " << avgPerCell << " polygons/cell"
-              << ", max " << maxPerCell << " polygons/cell" << std::endl;
+    levelEnds_ = ComputeLevelEnds(itemCount_, nodeSize_);
+    boxes_.resize(levelEnds_.back());
+    entries_.resize(levelEnds_.back());
+
+    ParallelSort::For(itemCount_, threadCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t polygon = static_cast<uint32_t>(keys[i]);
+            entries_[i] = polygon;
+            boxes_[i] = {polygons_->GetMinX(polygon), polygons_->GetMinY(polygon),
+                         polygons_->GetMaxX(polygon), polygons_->GetMaxY(polygon)};
+        }
+    });
+
+    // Each level groups nodeSize consecutive nodes of the one below
+    size_t position = itemCount_;
+    size_t levelStart = 0;
+    for (size_t level = 0; level + 1 < levelEnds_.size(); ++level) {
+        const size_t levelEnd = levelEnds_[level];
+        for (size_t child = levelStart; child < levelEnd; child += nodeSize_) {
+            const size_t last = std::min(child + nodeSize_, levelEnd);
+            Box box = boxes_[child];
+            for (size_t sibling = child + 1; sibling < last; ++sibling) {
+                box.minX = std::min(box.minX, boxes_[sibling].minX);
+                box.minY = std::min(box.minY, boxes_[sibling].minY);
+                box.maxX = std::max(box.maxX, boxes_[sibling].maxX);
+                box.maxY = std::max(box.maxY, boxes_[sibling].maxY);
+            }
+            boxes_[position] = box;
+            entries_[position] = static_cast<uint32_t>(child);
+            ++position;
+        }
+        levelStart = levelEnd;
+    }
+
+    BuildClassMasks(threadCount);
 }
 
-std::vector<Polygon*> PolygonIndex::QueryRegion(const Rect& region) {
-    // Get all cells intersecting the query region
-    std::vector<std::pair<int, int>> cells;
-    GetIntersectingCells(region, cells);
+void PolygonIndex::BuildClassMasks(size_t threadCount) {
+    classIds_.clear();
+    classMasks_.assign(boxes_.size(), 0);
+    if (itemCount_ == 0) {
+        return;
+    }
 
-    // Phase 1: Use vector + sort + unique instead of set (faster for large N)
-    std::vector<Polygon*> candidatePolygons;
-    candidatePolygons.reserve(cells.size() * 50);  // Estimate: 50 polygons per cell
+    for (size_t leaf = 0; leaf < itemCount_; ++leaf) {
+        const int classId = polygons_->GetClassId(entries_[leaf]);
+        if (classIds_.empty() || classIds_.back() != classId) {
+            classIds_.push_back(classId);
+        }
+    }
+    std::sort(classIds_.begin(), classIds_.end());
+    classIds_.erase(std::unique(classIds_.begin(), classIds_.end()), classIds_.end());
 
-    // Collect all polygons from intersecting cells
-    for (const auto& cellCoord : cells) {
-        int cellX = cellCoord.first;
-        int cellY = cellCoord.second;
-        const GridCell& cell = grid_[cellY][cellX];
+    ParallelSort::For(itemCount_, threadCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t leaf = begin; leaf < end; ++leaf) {
+            classMasks_[leaf] = ClassBit(polygons_->GetClassId(entries_[leaf]));
+        }
+    });
+    size_t position = itemCount_;
+    for (size_t level = 0; level + 1 < levelEnds_.size(); ++level) {
+        for (; position < levelEnds_[level + 1]; ++position) {
+            const size_t first = entries_[position];
+            const size_t end = std::min(first + nodeSize_, levelEnds_[level]);
+            for (size_t child = first; child < end; ++child) {
+                classMasks_[position] |= classMasks_[child];
+            }
+        }
+    }
+}
+
+uint64_t PolygonIndex::ClassBit(int classId) const {
+    const size_t slot = std::lower_bound(classIds_.begin(), classIds_.end(), classId) - classIds_.begin();
+    return uint64_t(1) << std::min<size_t>(slot, 63);
+}
 
-        for (Polygon* polygon : cell.polygons) {
-            candidatePolygons.push_back(polygon);
+PolygonIndex::ClassFilter PolygonIndex::MakeFilter(const ClassVisibility* visibility) const {
+    ClassFilter filter = {~uint64_t(0), nullptr, false};
+    if (!visibility || visibility->AllVisible()) {
+        return filter;
+    }
+
+    filter.visibleMask = 0;
+    filter.visibility = visibility;
+    for (size_t slot = 0; slot < classIds_.size(); ++slot) {
+        if (visibility->IsVisible(classIds_[slot])) {
+            filter.visibleMask |= uint64_t(1) << std::min<size_t>(slot, 63);
+        } else if (slot >= 63) {
+            filter.leafCheck = true;
         }
     }
+    return filter;
+}
 
-    // Deduplicate: sort + unique is faster than set for large vectors
-    std::sort(candidatePolygons.begin(), candidatePolygons.end());
-    candidatePolygons.erase(
-        std::unique(candidatePolygons.begin(), candidatePolygons.end()),
-        candidatePolygons.end()
-    );
+std::vector<size_t> PolygonIndex::ComputeLevelEnds(size_t itemCount, int nodeSize) {
+    std::vector<size_t> levelEnds;
+    if (itemCount == 0) {
+        return levelEnds;
+    }
 
-    // Filter by actual intersection (eliminate false positives from grid quantization)
-    std::vector<Polygon*> result;
-    result.reserve(candidatePolygons.size());
+    // Always at least one node above the leaves, so the root is never a leaf
+    size_t levelCount = itemCount;
+    size_t nodeCount = itemCount;
+    levelEnds.push_back(nodeCount);
+    do {
+        levelCount = (levelCount + nodeSize - 1) / nodeSize;
+        nodeCount += levelCount;
+        levelEnds.push_back(nodeCount);
+    } while (levelCount != 1);
+    return levelEnds;
+}
+
+bool PolygonIndex::HasValidLayout(size_t polygonCount) const {
+    if (levelEnds_ != ComputeLevelEnds(itemCount_, nodeSize_)) {
+        return false;
+    }
+    const size_t nodeCount = levelEnds_.empty() ? 0 : levelEnds_.back();
+    if (boxes_.size() != nodeCount || entries_.size() != nodeCount) {
+        return false;
+    }
 
-    for (Polygon* polygon : candidatePolygons) {
-        if (polygon->boundingBox.Intersects(region)) {
-            result.push_back(polygon);
+    for (size_t leaf = 0; leaf < itemCount_; ++leaf) {
+        if (entries_[leaf] >= polygonCount) {
+            return false;
         }
     }
+    size_t position = itemCount_;
+    size_t levelStart = 0;
+    for (size_t level = 0; level + 1 < levelEnds_.size(); ++level) {
+        for (size_t child = levelStart; child < levelEnds_[level]; child += nodeSize_) {
+            if (entries_[position++] != child) {
+                return false;
+            }
+        }
+        levelStart = levelEnds_[level];
+    }
+    return true;
+}
+
+void PolygonIndex::UpdateMemoryUsage() {
+    memoryUsage_ = boxes_.capacity() * sizeof(Box) +
+                   entries_.capacity() * sizeof(uint32_t) +
+                   classMasks_.capacity() * sizeof(uint64_t) +
+                   classIds_.capacity() * sizeof(int) +
+                   levelEnds_.capacity() * sizeof(size_t) +
+                   pending_.capacity() * sizeof(uint32_t);
+}
+
+void PolygonIndex::QueryRegion(const Rect& region, std::vector<uint32_t>& outPolygons) const {
+    outPolygons.clear();
+    Collect(region, MakeFilter(nullptr), outPolygons);
+}
+
+std::vector<uint32_t> PolygonIndex::QueryRegion(const Rect& region) const {
+    std::vector<uint32_t> result;
+    QueryRegion(region, result);
+    if (polygons_) {
+        SortResults(result);
+    }
+    return result;
+}
 
+std::vector<uint32_t> PolygonIndex::QueryRegion(const Rect& region, const ClassVisibility& visibility) const {
+    std::vector<uint32_t> result;
+    Collect(region, MakeFilter(&visibility), result);
+    if (polygons_) {
+        SortResults(result);
+    }
     return result;
 }
 
-void PolygonIndex::Clear() {
-    for (auto& row : grid_) {
-        for (auto& cell : row) {
-            cell.polygons.clear();
+void PolygonIndex::QueryRegion(const Rect& region, const ClassVisibility& visibility,
+                               std::vector<uint32_t>& outPolygons, std::vector<ClassRun>& outRuns) const {
+    outPolygons.clear();
+    outRuns.clear();
+    const size_t fromTree = Collect(region, MakeFilter(&visibility), outPolygons);
+    if (outPolygons.empty()) {
+        return;
+    }
+
+    // The tree's results are already in class order; pending polygons
+    // (during a streaming load) are merged in by class
+    if (fromTree < outPolygons.size()) {
+        auto byClass = [this](uint32_t a, uint32_t b) {
+            return polygons_->GetClassId(a) < polygons_->GetClassId(b);
+        };
+        std::stable_sort(outPolygons.begin() + fromTree, outPolygons.end(), byClass);
+        std::inplace_merge(outPolygons.begin(), outPolygons.begin() + fromTree, outPolygons.end(), byClass);
+    }
+
+    for (uint32_t i = 0; i < outPolygons.size(); ++i) {
+        const int classId = polygons_->GetClassId(outPolygons[i]);
+        if (outRuns.empty() || outRuns.back().classId != classId) {
+            outRuns.push_back({classId, i, i});
         }
+        outRuns.back().end = i + 1;
     }
 }
 
-void PolygonIndex::SlideToGridCell(double x, double y, int& outCellX, int& outCellY) const {
-    outCellX = static_cast<int>(x / cellWidth_);
-    outCellY = static_cast<int>(y / cellHeight_);
+size_t PolygonIndex::Collect(const Rect& region, const ClassFilter& filter,
+                             std::vector<uint32_t>& outPolygons) const {
+    if (!polygons_) {
+        return 0;
+    }
+
+    if (itemCount_ > 0) {
+        const size_t root = levelEnds_.back() - 1;
+        const size_t rootLevel = levelEnds_.size() - 1;
+        const uint64_t mask = classMasks_[root];
+        if (Contains(region, boxes_[root]) && (mask & ~filter.visibleMask) == 0 &&
+            !(filter.leafCheck && (mask >> 63))) {
+            AppendSubtree(root, rootLevel, outPolygons);
+        } else if (Overlaps(boxes_[root], region) && (mask & filter.visibleMask) != 0) {
+            SearchNode(root, rootLevel, region, filter, outPolygons);
+        }
+    }
+    const size_t fromTree = outPolygons.size();
+
+    for (uint32_t polygon : pending_) {
+        if (polygons_->Intersects(polygon, region) &&
+            (!filter.visibility || filter.visibility->IsVisible(polygons_->GetClassId(polygon)))) {
+            outPolygons.push_back(polygon);
+        }
+    }
+    return fromTree;
+}
+
+std::vector<uint32_t> PolygonIndex::QueryPoint(const Vec2& point) const {
+    return QueryRegion(Rect(point.x, point.y, 0.0, 0.0));
+}
+
+void PolygonIndex::QueryPoint(const Vec2& point, const ClassVisibility& visibility,
+                              std::vector<uint32_t>& outPolygons) const {
+    outPolygons.clear();
+    Collect(Rect(point.x, point.y, 0.0, 0.0), MakeFilter(&visibility), outPolygons);
+}
+
+std::vector<uint32_t> PolygonIndex::QueryNearest(const Vec2& point, size_t count) const {
+    std::vector<uint32_t> result;
+    if (!polygons_ || count == 0) {
+        return result;
+    }
+
+    // Best-first search: a node comes off the queue before anything farther
+    // than its box. level < 0 marks a polygon (id is its store index),
+    // otherwise id is a node position.
+    struct Candidate {
+        double distance;
+        uint32_t id;
+        int level;
+        bool operator>(const Candidate& other) const {
+            return distance != other.distance ? distance > other.distance : id > other.id;
+        }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+
+    if (itemCount_ > 0) {
+        const size_t root = levelEnds_.back() - 1;
+        const Box& box = boxes_[root];
+        queue.push({DistanceSquared(point, box.minX, box.minY, box.maxX, box.maxY),
+                    static_cast<uint32_t>(root), static_cast<int>(levelEnds_.size() - 1)});
+    }
+    for (uint32_t polygon : pending_) {
+        queue.push({DistanceSquared(point, polygons_->GetMinX(polygon), polygons_->GetMinY(polygon),
+                                    polygons_->GetMaxX(polygon), polygons_->GetMaxY(polygon)),
+                    polygon, -1});
+    }
+
+    while (!queue.empty() && result.size() < count) {
+        const Candidate candidate = queue.top();
+        queue.pop();
+        if (candidate.level < 0) {
+            result.push_back(candidate.id);
+            continue;
+        }
+
+        const int childLevel = candidate.level - 1;
+        const size_t first = entries_[candidate.id];
+        const size_t end = std::min(first + nodeSize_, levelEnds_[childLevel]);
+        for (size_t child = first; child < end; ++child) {
+            const Box& box = boxes_[child];
+            const double distance = DistanceSquared(point, box.minX, box.minY, box.maxX, box.maxY);
+            if (childLevel == 0) {
+                queue.push({distance, entries_[child], -1});
+            } else {
+                queue.push({distance, static_cast<uint32_t>(child), childLevel});
+            }
+        }
+    }
 
-    // Clamp to grid bounds
-    outCellX = std::max(0, std::min(outCellX, gridWidth_ - 1));
-    outCellY = std::max(0, std::min(outCellY, gridHeight_ - 1));
+    return result;
 }
 
-void PolygonIndex::GetIntersectingCells(const Rect& bbox,
-                                        std::vector<std::pair<int, int>>& outCells) const {
-    outCells.clear();
+void PolygonIndex::Clear() {
+    boxes_.clear();
+    entries_.clear();
+    classMasks_.clear();
+    classIds_.clear();
+    levelEnds_.clear();
+    itemCount_ = 0;
+    pending_.clear();
+    polygons_ = nullptr;
+}
 
-    // Get grid cell range that intersects the bounding box
-    int minCellX, minCellY, maxCellX, maxCellY;
+void PolygonIndex::SearchNode(size_t position, size_t level, const Rect& region,
+                               const ClassFilter& filter, std::vector<uint32_t>& outPolygons) const {
+    // Recursion depth is the tree height, so no stack to allocate
+    const size_t childLevel = level - 1;
+    const size_t first = entries_[position];
+    const size_t end = std::min(first + nodeSize_, levelEnds_[childLevel]);
+    for (size_t child = first; child < end; ++child) {
+        const uint64_t mask = classMasks_[child];
+        if ((mask & filter.visibleMask) == 0 || !Overlaps(boxes_[child], region)) {
+            continue;
+        }
+        if (childLevel == 0) {
+            if (!filter.leafCheck || filter.visibility->IsVisible(polygons_->GetClassId(entries_[child]))) {
+                outPolygons.push_back(entries_[child]);
+            }
+        } else if (Contains(region, boxes_[child]) && (mask & ~filter.visibleMask) == 0 &&
+                   !(filter.leafCheck && (mask >> 63))) {
+            // Whole subtree inside and visible: no need to test its nodes
+            AppendSubtree(child, childLevel, outPolygons);
+        } else {
+            SearchNode(child, childLevel, region, filter, outPolygons);
+        }
+    }
+}
+
+void PolygonIndex::AppendSubtree(size_t position, size_t level,
+                                 std::vector<uint32_t>& outPolygons) const {
+    // A subtree's leaves are contiguous: follow its first and last child down
+    size_t first = position;
+    size_t last = position;
+    for (; level > 0; --level) {
+        first = entries_[first];
+        last = std::min<size_t>(entries_[last] + nodeSize_, levelEnds_[level - 1]) - 1;
+    }
+    outPolygons.insert(outPolygons.end(), entries_.begin() + first, entries_.begin() + last + 1);
+}
 
-    SlideToGridCell(bbox.x, bbox.y, minCellX, minCellY);
-    SlideToGridCell(bbox.x + bbox.width, bbox.y + bbox.height, maxCellX, maxCellY);
+void PolygonIndex::SortResults(std::vector<uint32_t>& polygons) const {
+    // A large share of the store (zoomed out) is cheaper to order by
+    // marking than by sorting
+    const size_t storeSize = polygons_->Size();
+    if (polygons.size() * 8 < storeSize) {
+        std::sort(polygons.begin(), polygons.end());
+        return;
+    }
 
-    // Collect all cells in the range
-    for (int cellY = minCellY; cellY <= maxCellY; ++cellY) {
-        for (int cellX = minCellX; cellX <= maxCellX; ++cellX) {
-            outCells.push_back({cellX, cellY});
+    std::vector<uint8_t> marked(storeSize, 0);
+    for (uint32_t polygon : polygons) {
+        marked[polygon] = 1;
+    }
+    size_t out = 0;
+    for (uint32_t polygon = 0; polygon < storeSize; ++polygon) {
+        if (marked[polygon]) {
+            polygons[out++] = polygon;
         }
     }
 }
@@ -1,67 +1,246 @@
 #pragma once
 
-#include "PolygonOverlay.h"
+#include "PolygonStore.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 /**
  * Spatial index for efficient polygon queries
- * Uses a simple grid-based structure for O(k) lookups
- * where k is the average number of polygons per cell
+ * A packed Hilbert R-tree over the polygons' bounding boxes: polygons are
+ * sorted along a Hilbert curve through their box centers and grouped
+ * nodeSize at a time, level by level, into one flat array of node boxes.
+ * Queries touch O(log n + k) nodes, and a node's children are adjacent in
+ * memory.
+ *
+ * Leaves are packed class by class (ascending class ID), each class in
+ * Hilbert order, and every node carries a bit mask of the classes below
+ * it. A query for some classes skips the subtrees of hidden ones, and its
+ * results come out already grouped by class.
  */
 class PolygonIndex {
 public:
+    // Consecutive query results of one class: [begin, end)
+    struct ClassRun {
+        int classId;
+        uint32_t begin;
+        uint32_t end;
+    };
+
     /**
      * Constructor
-     * @param gridWidth Number of grid cells horizontally
-     * @param gridHeight Number of grid cells vertically
-     * @param slideWidth Width of the slide in pixels (level 0)
-     * @param slideHeight Height of the slide in pixels (level 0)
+     * @param nodeSize Children per tree node
+     */
+    explicit PolygonIndex(int nodeSize = DEFAULT_NODE_SIZE);
+
+    /**
+     * Build the spatial index from a polygon store
+     * @param polygons Polygons to index; must outlive the index (or the next Build)
+     * @param threadCount Threads computing keys, sorting and filling the
+     *        leaves, 0 for the hardware threads; the tree is the same for any
+     */
+    void Build(const PolygonStore& polygons, size_t threadCount = 0);
+
+    /**
+     * Add polygons [begin, end) of a store to the index, e.g. the ones
+     * appended by a streaming load since the last call. They are searched
+     * linearly until enough accumulate to repack the tree with them.
+     * @param polygons Store being indexed; must be the one given to Build()
+     *        if the index was built
+     * @param begin First store index to add
+     * @param end One past the last store index to add
+     */
+    void Insert(const PolygonStore& polygons, uint32_t begin, uint32_t end);
+
+    /**
+     * Repack the tree with every polygon added by Insert() since the last
+     * pack, e.g. once a streaming load finishes
      */
-    PolygonIndex(int gridWidth, int gridHeight, double slideWidth, double slideHeight);
+    void Pack();
 
     /**
-     * Build the spatial index from a vector of polygons
-     * @param polygons Vector of polygons to index
+     * Query polygons that intersect a given region, each reported once
+     * @param region The bounding rectangle to query
+     * @param outPolygons Cleared, then filled with the store indices of the
+     *        polygons intersecting the region, in index order; reuse it
+     *        across queries to keep its capacity
      */
-    void Build(std::vector<Polygon>& polygons);
+    void QueryRegion(const Rect& region, std::vector<uint32_t>& outPolygons) const;
 
     /**
      * Query polygons that intersect a given region
      * @param region The bounding rectangle to query
-     * @return Vector of pointers to polygons intersecting the region
+     * @return Ascending store indices of the polygons intersecting the region
      */
-    std::vector<Polygon*> QueryRegion(const Rect& region);
+    std::vector<uint32_t> QueryRegion(const Rect& region) const;
+
+    /**
+     * Query polygons of visible classes that intersect a region
+     * @param region The bounding rectangle to query
+     * @param visibility Classes to report; hidden ones cost nothing
+     * @return Ascending store indices of the polygons intersecting the region
+     */
+    std::vector<uint32_t> QueryRegion(const Rect& region, const ClassVisibility& visibility) const;
+
+    /**
+     * Query polygons of visible classes that intersect a region, bucketed
+     * by class
+     * @param region The bounding rectangle to query
+     * @param visibility Classes to report; hidden ones cost nothing
+     * @param outPolygons Cleared, then filled with the store indices of the
+     *        polygons intersecting the region, one class after another
+     * @param outRuns Cleared, then filled with each reported class's range
+     *        of outPolygons, in ascending class order
+     */
+    void QueryRegion(const Rect& region, const ClassVisibility& visibility,
+                     std::vector<uint32_t>& outPolygons, std::vector<ClassRun>& outRuns) const;
+
+    /**
+     * Query polygons whose bounding box contains a point
+     * @param point Point in slide coordinates
+     * @return Ascending store indices of the polygons under the point
+     */
+    std::vector<uint32_t> QueryPoint(const Vec2& point) const;
+
+    /**
+     * Query polygons of visible classes whose bounding box contains a
+     * point, descending only into nodes whose box holds it
+     * @param point Point in slide coordinates
+     * @param visibility Classes to report
+     * @param outPolygons Cleared, then filled with the store indices of the
+     *        polygons under the point, in index order
+     */
+    void QueryPoint(const Vec2& point, const ClassVisibility& visibility,
+                    std::vector<uint32_t>& outPolygons) const;
+
+    /**
+     * Query the polygons nearest to a point
+     * @param point Point in slide coordinates
+     * @param count Maximum number of polygons to return
+     * @return Store indices ordered by the distance from the point to their
+     *         bounding box (0 inside it), nearest first
+     */
+    std::vector<uint32_t> QueryNearest(const Vec2& point, size_t count) const;
 
     /**
      * Clear the index
      */
     void Clear();
 
+    /**
+     * Number of polygons indexed
+     */
+    size_t Size() const { return itemCount_ + pending_.size(); }
+
+    /**
+     * Bytes held by the tree and the polygons awaiting a pack
+     */
+    size_t GetMemoryUsage() const { return memoryUsage_; }
+
+    static constexpr int DEFAULT_NODE_SIZE = 16;
+
 private:
-    struct GridCell {
-        std::vector<Polygon*> polygons;
+    friend class PolygonCache;  // Serializes the packed tree
+
+    struct Box {
+        float minX, minY, maxX, maxY;
     };
 
-    std::vector<std::vector<GridCell>> grid_;
-    int gridWidth_;
-    int gridHeight_;
-    double cellWidth_;
-    double cellHeight_;
+    // What a search reports: nodes whose class mask misses visibleMask are
+    // skipped. Classes past the 63rd share the last bit; if some of those
+    // are hidden, leafCheck is set and their leaves are tested one by one.
+    // visibility is null when every class is visible.
+    struct ClassFilter {
+        uint64_t visibleMask;
+        const ClassVisibility* visibility;
+        bool leafCheck;
+    };
+
+    const PolygonStore* polygons_ = nullptr;
+    int nodeSize_;
+
+    // Nodes of every level, leaves (one per polygon, in Hilbert order)
+    // first and the root last. A leaf's entry is its polygon's store
+    // index; any other node's entry is the position of its first child.
+    std::vector<Box> boxes_;
+    std::vector<uint32_t> entries_;
+    std::vector<size_t> levelEnds_;  // One past the last node of each level
+    size_t itemCount_ = 0;
+
+    // Bit per class below each node (bit min(i, 63) for the i-th class of
+    // classIds_), rebuilt with the tree and never serialized
+    std::vector<uint64_t> classMasks_;
+    std::vector<int> classIds_;  // Ascending classes of the packed polygons
+
+    // Inserted since the last pack
+    std::vector<uint32_t> pending_;
+
+    size_t memoryUsage_ = 0;
+
+    static constexpr size_t MIN_PENDING_TO_PACK = 4096;
+
+    void UpdateMemoryUsage();
+
+    /**
+     * Rebuild the tree over the given store indices on threadCount threads
+     */
+    void BuildTree(const std::vector<uint32_t>& polygons, size_t threadCount = 0);
+
+    /**
+     * Fill classIds_ and classMasks_ for the packed tree
+     */
+    void BuildClassMasks(size_t threadCount = 0);
+
+    /**
+     * Class mask bit of a class of the packed tree
+     */
+    uint64_t ClassBit(int classId) const;
+
+    /**
+     * Filter reporting the visible classes of the packed tree
+     */
+    ClassFilter MakeFilter(const ClassVisibility* visibility) const;
+
+    /**
+     * Append the polygons intersecting the region: those of the tree in
+     * leaf order, then the visible pending ones
+     * @return Number of results from the tree
+     */
+    size_t Collect(const Rect& region, const ClassFilter& filter,
+                   std::vector<uint32_t>& outPolygons) const;
+
+    /**
+     * Level ends of a tree over itemCount leaves, root level last
+     */
+    static std::vector<size_t> ComputeLevelEnds(size_t itemCount, int nodeSize);
+
+    /**
+     * Whether the node and entry arrays form the tree BuildTree() would
+     * lay out over polygonCount polygons (e.g. one read back from a cache)
+     */
+    bool HasValidLayout(size_t polygonCount) const;
+
+    /**
+     * Append the polygons under a node that overlaps the region
+     * @param position Node position
+     * @param level Level of the node (at least 1)
+     * @param region Query region
+     * @param filter Classes to report
+     * @param outPolygons Output store indices
+     */
+    void SearchNode(size_t position, size_t level, const Rect& region,
+                    const ClassFilter& filter, std::vector<uint32_t>& outPolygons) const;
 
     /**
-     * Convert slide coordinates to grid cell indices
-     * @param x Slide X coordinate
-     * @param y Slide Y coordinate
-     * @param outCellX Output grid cell X index
-     * @param outCellY Output grid cell Y index
+     * Append the polygons of the subtree under a node
+     * @param position Node position
+     * @param level Level of the node (0 for leaves)
+     * @param outPolygons Output store indices
      */
-    void SlideToGridCell(double x, double y, int& outCellX, int& outCellY) const;
+    void AppendSubtree(size_t position, size_t level, std::vector<uint32_t>& outPolygons) const;
 
     /**
-     * Get all grid cells that intersect with a given bounding box
-     * @param bbox Bounding box in slide coordinates
-     * @param outCells Output vector of (cellX, cellY) pairs
+     * Sort query results into ascending store order
      */
-    void GetIntersectingCells(const Rect& bbox,
-                              std::vector<std::pair<int, int>>& outCells) const;
+    void SortResults(std::vector<uint32_t>& polygons) const;
 };
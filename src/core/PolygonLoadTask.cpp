@@ -0,0 +1,145 @@
+#include "PolygonLoadTask.h"
+#include "PolygonLoader.h"
+#include "TissueMap.h"
+#include "Log.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+struct PolygonLoadTask::State {
+    std::string path;
+    std::chrono::steady_clock::time_point start;
+
+    mutable std::mutex mutex;
+    std::function<void()> onProgress;  // Cleared when the task is abandoned
+    bool abandoned = false;
+    Vec2 focus;
+    bool hasFocus = false;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    bool classesReady = false;
+    std::unique_ptr<TissueMap> tissueMap;
+    std::vector<PolygonStore> batches;
+    float progress = 0.0f;
+    bool finished = false;
+    bool succeeded = false;
+
+    void Notify() {
+        if (onProgress) {
+            onProgress();
+        }
+    }
+};
+
+PolygonLoadTask::PolygonLoadTask(std::unique_ptr<PolygonLoader> loader, const std::string& path,
+                                 std::function<void()> onProgress)
+    : path_(path)
+    , state_(std::make_shared<State>())
+{
+    state_->path = path;
+    state_->start = std::chrono::steady_clock::now();
+    state_->onProgress = std::move(onProgress);
+    std::thread(Run, state_, std::move(loader)).detach();
+}
+
+PolygonLoadTask::~PolygonLoadTask() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->onProgress = nullptr;
+    state_->abandoned = true;
+}
+
+void PolygonLoadTask::SetFocus(const Vec2& slidePoint) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->focus = slidePoint;
+    state_->hasFocus = true;
+}
+
+bool PolygonLoadTask::TakeClasses(std::map<int, SDL_Color>& classColors,
+                                  std::map<int, std::string>& classNames) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->classesReady) {
+        return false;
+    }
+    classColors = std::move(state_->classColors);
+    classNames = std::move(state_->classNames);
+    state_->classesReady = false;
+    return true;
+}
+
+std::unique_ptr<TissueMap> PolygonLoadTask::TakeTissueMap() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return std::move(state_->tissueMap);
+}
+
+std::vector<PolygonStore> PolygonLoadTask::TakeBatches() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    std::vector<PolygonStore> batches = std::move(state_->batches);
+    state_->batches.clear();
+    return batches;
+}
+
+bool PolygonLoadTask::IsFinished() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->finished;
+}
+
+bool PolygonLoadTask::Succeeded() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->succeeded;
+}
+
+float PolygonLoadTask::GetProgress() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->progress;
+}
+
+double PolygonLoadTask::GetElapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - state_->start).count();
+}
+
+void PolygonLoadTask::Run(std::shared_ptr<State> state, std::unique_ptr<PolygonLoader> loader) {
+    PolygonStreamCallbacks callbacks;
+    callbacks.onClasses = [&state](const std::map<int, SDL_Color>& classColors,
+                                   const std::map<int, std::string>& classNames) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->classColors = classColors;
+        state->classNames = classNames;
+        state->classesReady = true;
+        state->Notify();
+    };
+    callbacks.onTissueMap = [&state](std::unique_ptr<TissueMap> tissueMap) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->tissueMap = std::move(tissueMap);
+        state->Notify();
+    };
+    // Until the GUI thread sets a focus, load from the slide origin
+    callbacks.focus = [&state]() {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->hasFocus ? state->focus : Vec2(0, 0);
+    };
+    // Batches arrive triangulated, so the GUI thread never triangulates
+    callbacks.onBatch = [&state](PolygonStore&& batch, float progress) {
+        batch.TriangulateAll();
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->abandoned) {
+            return false;
+        }
+        state->batches.push_back(std::move(batch));
+        state->progress = progress;
+        state->Notify();
+        return true;
+    };
+
+    bool succeeded = loader->LoadStreaming(state->path, callbacks);
+
+    PATHVIEW_LOG_INFO("Polygons " << (succeeded ? "streamed" : "not loaded") << " from " << state->path
+                      << " in " << std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - state->start).count()
+                      << " s");
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->finished = true;
+    state->succeeded = succeeded;
+    state->Notify();
+}
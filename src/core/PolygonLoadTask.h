@@ -0,0 +1,62 @@
+#pragma once
+
+#include "PolygonStore.h"
+#include <SDL2/SDL.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PolygonLoader;
+class TissueMap;
+
+// Loads a polygon file on a background thread with
+// PolygonLoader::LoadStreaming, handing the GUI thread the class tables
+// first and then batches of converted, triangulated polygons, nearest the
+// focus first.
+// The GUI thread polls the task, appends the batches to its store and
+// indexes them, so the overlay fills in while the file is still loading.
+class PolygonLoadTask {
+public:
+    // Starts loading immediately. onProgress runs on the task's thread
+    // whenever there is something new to take.
+    PolygonLoadTask(std::unique_ptr<PolygonLoader> loader, const std::string& path,
+                    std::function<void()> onProgress = nullptr);
+
+    // Does not wait: an abandoned load stops at its next batch, in the
+    // background, without calling onProgress again
+    ~PolygonLoadTask();
+
+    PolygonLoadTask(const PolygonLoadTask&) = delete;
+    PolygonLoadTask& operator=(const PolygonLoadTask&) = delete;
+
+    const std::string& GetPath() const { return path_; }
+
+    // Slide point (level 0) the remaining tiles are loaded around
+    void SetFocus(const Vec2& slidePoint);
+
+    // Hands over the class tables once known; false before that and after
+    // they have been taken
+    bool TakeClasses(std::map<int, SDL_Color>& classColors, std::map<int, std::string>& classNames);
+
+    // Hands over the file's tissue map once known; null before that, after
+    // it has been taken and for files without one
+    std::unique_ptr<TissueMap> TakeTissueMap();
+
+    // Hands over the batches converted since the last call (oldest first)
+    std::vector<PolygonStore> TakeBatches();
+
+    bool IsFinished() const;
+    bool Succeeded() const;  // Once finished
+    float GetProgress() const;  // Fraction of the file's tiles converted
+    double GetElapsedSeconds() const;
+
+private:
+    struct State;  // Shared with the worker thread, which may outlive the task
+
+    static void Run(std::shared_ptr<State> state, std::unique_ptr<PolygonLoader> loader);
+
+    std::string path_;
+    std::shared_ptr<State> state_;
+};
@@ -1,7 +1,11 @@
 #include "PolygonLoader.h"
-#include <iostream>
+#include "PolygonIndex.h"
+#include "TissueMap.h"
+#include "Log.h"
 #include <set>
 #include <map>
+#include <algorithm>
+#include <thread>
 
 void PolygonLoader::BuildClassMapping(const std::set<std::string>& cellTypes,
                                       std::map<std::string, int>& outMapping) {
@@ -13,6 +17,16 @@ void PolygonLoader::BuildClassMapping(const std::set<std::string>& cellTypes,
     }
 }
 
+std::vector<int> PolygonLoader::BuildClassMapping(const ClassNameTable& cellTypes,
+                                                  std::map<std::string, int>& outMapping) {
+    std::vector<int> classIds = cellTypes.SortedIds();
+    outMapping.clear();
+    for (uint32_t i = 0; i < cellTypes.Size(); ++i) {
+        outMapping[cellTypes.GetName(i)] = classIds[i];
+    }
+    return classIds;
+}
+
 // Cell type color map - maps cell type names to RGB colors
 static const std::map<std::string, SDL_Color> CELL_TYPE_COLORS = {
     {"Background",         {0, 0, 0, 255}},         // Black
@@ -73,16 +87,120 @@ void PolygonLoader::GenerateColorsFromClassNames(
         auto colorIt = CELL_TYPE_COLORS.find(className);
         if (colorIt != CELL_TYPE_COLORS.end()) {
             outColors[classId] = colorIt->second;
-            std::cout << "  Color for '" << className << "' (ID " << classId << "): "
-                      << "RGB(" << (int)colorIt->second.r << ", "
-                      << (int)colorIt->second.g << ", "
-                      << (int)colorIt->second.b << ")" << std::endl;
+            PATHVIEW_LOG_INFO("  Color for '" << className << "' (ID " << classId << "): "
+                              << "RGB(" << (int)colorIt->second.r << ", "
+                              << (int)colorIt->second.g << ", "
+                              << (int)colorIt->second.b << ")");
         } else {
             // Use fallback color for unknown cell types
             outColors[classId] = FALLBACK_COLORS[fallbackIndex % NUM_FALLBACK_COLORS];
-            std::cout << "  Unknown cell type '" << className << "' (ID " << classId
-                      << "), using fallback color" << std::endl;
+            PATHVIEW_LOG_INFO("  Unknown cell type '" << className << "' (ID " << classId
+                              << "), using fallback color");
             ++fallbackIndex;
         }
     }
 }
+
+bool PolygonLoader::LoadStreaming(const std::string& filepath,
+                                  const PolygonStreamCallbacks& callbacks) {
+    PolygonStore polygons;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    if (!Load(filepath, polygons, classColors, classNames)) {
+        return false;
+    }
+
+    if (callbacks.onClasses) {
+        callbacks.onClasses(classColors, classNames);
+    }
+    std::unique_ptr<TissueMap> tissueMap = TakeTissueMap();
+    if (tissueMap && callbacks.onTissueMap) {
+        callbacks.onTissueMap(std::move(tissueMap));
+    }
+    return !callbacks.onBatch || callbacks.onBatch(std::move(polygons), 1.0f);
+}
+
+std::unique_ptr<PolygonIndex> PolygonLoader::TakeSpatialIndex() {
+    return nullptr;
+}
+
+std::unique_ptr<TissueMap> PolygonLoader::TakeTissueMap() {
+    return nullptr;
+}
+
+int PolygonLoader::ConvertInParallel(size_t itemCount, size_t totalPolygons, size_t totalVertices,
+                                     const std::function<void(size_t begin, size_t end, PolygonStore& out)>& convertItems,
+                                     PolygonStore& outPolygons, size_t minItemsPerWorker) {
+    size_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+    workerCount = std::max<size_t>(1, std::min(workerCount, itemCount / std::max<size_t>(1, minItemsPerWorker)));
+
+    std::vector<PolygonStore> parts(workerCount);
+    if (workerCount == 1) {
+        parts[0].Reserve(totalPolygons, totalVertices);
+        convertItems(0, itemCount, parts[0]);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (size_t w = 0; w < workerCount; ++w) {
+            size_t begin = itemCount * w / workerCount;
+            size_t end = itemCount * (w + 1) / workerCount;
+            workers.emplace_back(convertItems, begin, end, std::ref(parts[w]));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    if (workerCount == 1) {
+        outPolygons = std::move(parts[0]);
+    } else {
+        outPolygons.Reserve(totalPolygons, totalVertices);
+        for (auto& part : parts) {
+            outPolygons.Append(part);
+            part = PolygonStore();
+        }
+    }
+    return static_cast<int>(workerCount);
+}
+
+bool PolygonLoader::StreamTiles(const std::vector<Rect>& tileBounds,
+                                const std::function<void(size_t tile, PolygonStore& out)>& convertTile,
+                                const PolygonStreamCallbacks& callbacks) {
+    // Tiles still to convert; the next batch is taken from the back
+    std::vector<size_t> remaining(tileBounds.size());
+    for (size_t i = 0; i < remaining.size(); ++i) {
+        remaining[i] = remaining.size() - 1 - i;
+    }
+
+    // Squared distance from a point to a tile (0 inside it)
+    auto distance = [&tileBounds](size_t tile, const Vec2& point) {
+        const Rect& bounds = tileBounds[tile];
+        double dx = std::max({bounds.x - point.x, 0.0, point.x - bounds.Right()});
+        double dy = std::max({bounds.y - point.y, 0.0, point.y - bounds.Bottom()});
+        return dx * dx + dy * dy;
+    };
+
+    size_t done = 0;
+    while (!remaining.empty()) {
+        // Move the tiles nearest the focus to the back
+        size_t batchSize = std::min(STREAM_BATCH_TILES, remaining.size());
+        if (callbacks.focus && batchSize < remaining.size()) {
+            Vec2 focus = callbacks.focus();
+            std::nth_element(remaining.begin(), remaining.end() - batchSize, remaining.end(),
+                             [&](size_t a, size_t b) { return distance(a, focus) > distance(b, focus); });
+        }
+
+        PolygonStore batch;
+        for (size_t i = 0; i < batchSize; ++i) {
+            convertTile(remaining.back(), batch);
+            remaining.pop_back();
+        }
+        done += batchSize;
+
+        float progress = static_cast<float>(done) / static_cast<float>(tileBounds.size());
+        if (callbacks.onBatch && !callbacks.onBatch(std::move(batch), progress)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,12 +1,40 @@
 #pragma once
 
-#include "PolygonOverlay.h"
+#include "ClassNameTable.h"
+#include "PolygonStore.h"
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 #include <SDL2/SDL.h>
 
+class PolygonIndex;
+class TissueMap;
+
+/**
+ * Callbacks of a streaming load (see PolygonLoader::LoadStreaming).
+ * All run on the loading thread.
+ */
+struct PolygonStreamCallbacks {
+    // Class tables, once, before the first batch
+    std::function<void(const std::map<int, SDL_Color>& classColors,
+                       const std::map<int, std::string>& classNames)> onClasses;
+
+    // Tissue segmentation of the slide, once before the first batch, if
+    // the file has one
+    std::function<void(std::unique_ptr<TissueMap> tissueMap)> onTissueMap;
+
+    // Slide point (level 0) to load around first; asked before every batch.
+    // Empty: file order.
+    std::function<Vec2()> focus;
+
+    // One batch of converted polygons and the fraction of the file done;
+    // return false to cancel the load
+    std::function<bool(PolygonStore&& batch, float progress)> onBatch;
+};
+
 /**
  * Base class of Polygon File Loader
  *
@@ -21,17 +49,76 @@ public:
     /**
      * Defines a base interface for loading polygon files
      * @param filepath Path to the polygon file
-     * @param outPolygons Output vector of polygons
+     * @param outPolygons Output polygon store
      * @param outClassColors Output map of class ID to color
      * @param outClassNames Output map of class ID to class name
      * @return true if successful, false otherwise
      */
     virtual bool Load(const std::string& filepath,
-                     std::vector<Polygon>& outPolygons,
+                     PolygonStore& outPolygons,
                      std::map<int, SDL_Color>& outClassColors,
                      std::map<int, std::string>& outClassNames) = 0;
 
+    /**
+     * Load a polygon file batch by batch, the source tiles nearest the
+     * focus point first, so a viewer can draw polygons while the rest are
+     * still being converted.
+     * The default converts the whole file with Load() and hands it over as
+     * a single batch, after its tissue map if it has one.
+     * @param filepath Path to the polygon file
+     * @param callbacks Receivers of the class tables and batches
+     * @return true if the whole file was loaded, false on error or cancel
+     */
+    virtual bool LoadStreaming(const std::string& filepath,
+                               const PolygonStreamCallbacks& callbacks);
+
+    /**
+     * Spatial index read along with the polygons of the last Load(), for
+     * formats that store one (bound to that Load's store)
+     * @return The index, or nullptr (the default) to build one
+     */
+    virtual std::unique_ptr<PolygonIndex> TakeSpatialIndex();
+
+    /**
+     * Tissue segmentation map read along with the polygons of the last
+     * Load(), for formats that carry one
+     * @return The map, or nullptr (the default) if there is none
+     */
+    virtual std::unique_ptr<TissueMap> TakeTissueMap();
+
 protected:
+    // Source tiles converted per streamed batch
+    static constexpr size_t STREAM_BATCH_TILES = 256;
+
+    /**
+     * Drive a streaming load over a file's source tiles: repeatedly picks
+     * the STREAM_BATCH_TILES unconverted tiles nearest the focus, converts
+     * them with convertTile and hands the batch to callbacks.onBatch
+     * @param tileBounds Slide-space (level 0) bounds of each source tile
+     * @param convertTile Appends the polygons of one tile to a store
+     * @param callbacks Stream receivers (onClasses is not called here)
+     * @return false if onBatch cancelled the load
+     */
+    static bool StreamTiles(const std::vector<Rect>& tileBounds,
+                            const std::function<void(size_t tile, PolygonStore& out)>& convertTile,
+                            const PolygonStreamCallbacks& callbacks);
+
+    /**
+     * Convert contiguous ranges of a file's items (tiles, features) on
+     * worker threads, each range into its own store, then concatenate the
+     * stores in item order into outPolygons
+     * @param itemCount Items to convert
+     * @param totalPolygons Polygons expected, reserved in the final store
+     * @param totalVertices Vertices expected, reserved in the final store
+     * @param convertItems Appends the polygons of items [begin, end) to a store
+     * @param outPolygons Output polygon store (replaced)
+     * @param minItemsPerWorker Items per thread at minimum; fewer stay on one
+     * @return Number of threads used
+     */
+    static int ConvertInParallel(size_t itemCount, size_t totalPolygons, size_t totalVertices,
+                                 const std::function<void(size_t begin, size_t end, PolygonStore& out)>& convertItems,
+                                 PolygonStore& outPolygons, size_t minItemsPerWorker = 16);
+
     /**
      * Build class name to ID mapping from unique cell types
      * @param cellTypes Set of unique cell type strings
@@ -40,6 +127,15 @@ protected:
     static void BuildClassMapping(const std::set<std::string>& cellTypes,
                                   std::map<std::string, int>& outMapping);
 
+    /**
+     * The same for interned cell types
+     * @param cellTypes Unique cell types, interned
+     * @param outMapping Output map of class name to ID
+     * @return Class ID of each interned type, by index
+     */
+    static std::vector<int> BuildClassMapping(const ClassNameTable& cellTypes,
+                                              std::map<std::string, int>& outMapping);
+
     /**
      * Generate default colors for classes (fallback)
      * @param numClasses Number of classes
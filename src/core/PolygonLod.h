@@ -0,0 +1,28 @@
+#pragma once
+
+// Phase 2: Level-of-detail (LOD) enum
+enum class LODLevel {
+    SKIP,       // < 2 pixels - don't render
+    POINT,      // 2-4 pixels - single pixel
+    BOX,        // 4-10 pixels - bounding box rectangle
+    SIMPLIFIED, // 10-30 pixels - Douglas-Peucker outline (see PolygonStore)
+    FULL        // 30+ pixels - full detail
+};
+
+// How a polygon is drawn by its larger box side in output pixels. Shared
+// by PolygonOverlay and the vector tiles of CellTileService, so a browser
+// sees cells at the detail the viewer draws them with.
+struct PolygonLod {
+    double minScreenSizePixels = 2.0;  // Skip polygons smaller than this
+    double pointThreshold = 4.0;
+    double boxThreshold = 10.0;
+    double simplifiedThreshold = 30.0;
+
+    LODLevel Classify(double screenSize) const {
+        if (screenSize < minScreenSizePixels) return LODLevel::SKIP;
+        if (screenSize < pointThreshold) return LODLevel::POINT;
+        if (screenSize < boxThreshold) return LODLevel::BOX;
+        if (screenSize < simplifiedThreshold) return LODLevel::SIMPLIFIED;
+        return LODLevel::FULL;
+    }
+};
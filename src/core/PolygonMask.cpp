@@ -0,0 +1,228 @@
+#include "PolygonMask.h"
+#include "ParallelSort.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+namespace {
+
+// Widening of an edge's reach, in cells, so rounding cannot hide an edge
+// from a cell it touches
+constexpr double SLACK = 1e-6;
+
+int32_t ClampCell(double cell, int32_t count) {
+    return static_cast<int32_t>(std::max(0.0, std::min(std::floor(cell), double(count - 1))));
+}
+
+}  // namespace
+
+PolygonMask::PolygonMask(const std::vector<Vec2>& vertices, int32_t gridSize)
+    : vertices_(vertices), gridSize_(std::max(1, gridSize)) {
+    if (vertices_.size() < 3) {
+        return;
+    }
+
+    double minX = vertices_[0].x, maxX = minX;
+    double minY = vertices_[0].y, maxY = minY;
+    for (const Vec2& v : vertices_) {
+        minX = std::min(minX, v.x);
+        maxX = std::max(maxX, v.x);
+        minY = std::min(minY, v.y);
+        maxY = std::max(maxY, v.y);
+    }
+    bounds_ = Rect(minX, minY, maxX - minX, maxY - minY);
+    const double side = std::max(bounds_.width, bounds_.height);
+    if (!(side > 0.0)) {
+        return;
+    }
+    cellSize_ = side / gridSize_;
+    columns_ = std::max(1, std::min(gridSize_, static_cast<int32_t>(std::ceil(bounds_.width / cellSize_))));
+    rows_ = std::max(1, std::min(gridSize_, static_cast<int32_t>(std::ceil(bounds_.height / cellSize_))));
+    cells_.assign(size_t(columns_) * rows_, OUTSIDE);
+
+    // Mark the cells each edge passes through, row by row, and note where
+    // it crosses each row's center line (by RayCast()'s rule)
+    std::vector<std::pair<int32_t, double>> crossings;
+    for (size_t i = 0, j = vertices_.size() - 1; i < vertices_.size(); j = i++) {
+        const Vec2& a = vertices_[j];
+        const Vec2& b = vertices_[i];
+        const double ax = (a.x - minX) / cellSize_, ay = (a.y - minY) / cellSize_;
+        const double bx = (b.x - minX) / cellSize_, by = (b.y - minY) / cellSize_;
+        const double low = std::min(ay, by), high = std::max(ay, by);
+
+        const int32_t lastRow = ClampCell(high + SLACK, rows_);
+        for (int32_t row = ClampCell(low - SLACK, rows_); row <= lastRow; ++row) {
+            // Columns the part of the edge within this row reaches
+            double x0 = std::min(ax, bx), x1 = std::max(ax, bx);
+            if (ay != by) {
+                const double t0 = (std::max(low, row - SLACK) - ay) / (by - ay);
+                const double t1 = (std::min(high, row + 1 + SLACK) - ay) / (by - ay);
+                x0 = ax + t0 * (bx - ax);
+                x1 = ax + t1 * (bx - ax);
+                if (x0 > x1) {
+                    std::swap(x0, x1);
+                }
+            }
+            Cell* rowCells = cells_.data() + size_t(row) * columns_;
+            const int32_t lastColumn = ClampCell(x1 + SLACK, columns_);
+            for (int32_t column = ClampCell(x0 - SLACK, columns_); column <= lastColumn; ++column) {
+                rowCells[column] = BOUNDARY;
+            }
+
+            const double centerY = minY + (row + 0.5) * cellSize_;
+            if ((b.y > centerY) != (a.y > centerY)) {
+                crossings.push_back({row, (a.x - b.x) * (centerY - b.y) / (a.y - b.y) + b.x});
+            }
+        }
+    }
+
+    // A cell no edge reaches is inside when an odd number of its row's
+    // crossings lie to the right of its center
+    std::sort(crossings.begin(), crossings.end());
+    size_t rowBegin = 0;
+    for (int32_t row = 0; row < rows_; ++row) {
+        size_t rowEnd = rowBegin;
+        while (rowEnd < crossings.size() && crossings[rowEnd].first == row) {
+            ++rowEnd;
+        }
+        size_t left = rowBegin;  // First crossing right of the center
+        Cell* rowCells = cells_.data() + size_t(row) * columns_;
+        for (int32_t column = 0; column < columns_; ++column) {
+            const double centerX = minX + (column + 0.5) * cellSize_;
+            while (left < rowEnd && crossings[left].second <= centerX) {
+                ++left;
+            }
+            if (rowCells[column] != BOUNDARY && (rowEnd - left) % 2 == 1) {
+                rowCells[column] = INSIDE;
+            }
+        }
+        rowBegin = rowEnd;
+    }
+}
+
+bool PolygonMask::Contains(double x, double y) const {
+    if (cells_.empty() || !(x >= bounds_.x && x <= bounds_.Right() && y >= bounds_.y && y <= bounds_.Bottom())) {
+        return false;
+    }
+    const int32_t column = ClampCell((x - bounds_.x) / cellSize_, columns_);
+    const int32_t row = ClampCell((y - bounds_.y) / cellSize_, rows_);
+    const Cell cell = cells_[size_t(row) * columns_ + column];
+    return cell == BOUNDARY ? RayCast(x, y) : cell == INSIDE;
+}
+
+PolygonMask::Overlap PolygonMask::Classify(const Rect& box) const {
+    if (cells_.empty() || box.Right() < bounds_.x || box.x > bounds_.Right() ||
+        box.Bottom() < bounds_.y || box.y > bounds_.Bottom()) {
+        return NONE;
+    }
+    // Part of the box beyond the grid is outside
+    bool outside = box.x < bounds_.x || box.Right() > bounds_.Right() ||
+                   box.y < bounds_.y || box.Bottom() > bounds_.Bottom();
+    bool inside = false;
+    const int32_t firstColumn = ClampCell((box.x - bounds_.x) / cellSize_, columns_);
+    const int32_t lastColumn = ClampCell((box.Right() - bounds_.x) / cellSize_, columns_);
+    const int32_t firstRow = ClampCell((box.y - bounds_.y) / cellSize_, rows_);
+    const int32_t lastRow = ClampCell((box.Bottom() - bounds_.y) / cellSize_, rows_);
+    for (int32_t row = firstRow; row <= lastRow; ++row) {
+        const Cell* rowCells = cells_.data() + size_t(row) * columns_;
+        for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+            if (rowCells[column] == BOUNDARY) {
+                return PARTIAL;
+            }
+            inside |= rowCells[column] == INSIDE;
+            outside |= rowCells[column] == OUTSIDE;
+        }
+    }
+    return inside ? (outside ? PARTIAL : WHOLE) : NONE;
+}
+
+bool PolygonMask::RayCast(double x, double y) const {
+    bool inside = false;
+    for (size_t i = 0, j = vertices_.size() - 1; i < vertices_.size(); j = i++) {
+        const Vec2& a = vertices_[j];
+        const Vec2& b = vertices_[i];
+        if (((b.y > y) != (a.y > y)) && (x < (a.x - b.x) * (y - b.y) / (a.y - b.y) + b.x)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+void PolygonMask::CountCentroids(const PolygonStore& polygons, const PolygonIndex* index,
+                                 std::map<int, int>& counts, float minConfidence, size_t threadCount) const {
+    if (cells_.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> candidates;
+    std::vector<PolygonIndex::ClassRun> runs;
+    const bool indexed = index && index->Size() == polygons.Size();
+    if (indexed) {
+        index->QueryRegion(bounds_, ClassVisibility(), candidates, runs);
+    }
+    const size_t candidateCount = indexed ? candidates.size() : polygons.Size();
+
+    // Many candidates: a finer grid leaves fewer of them in boundary cells
+    std::optional<PolygonMask> finer;
+    const int32_t gridSize = GridSizeFor(candidateCount);
+    const PolygonMask& mask = gridSize > gridSize_ ? finer.emplace(vertices_, gridSize) : *this;
+
+    auto inside = [&](uint32_t polygon) {
+        // A centroid lies within its polygon's box, so empty polygons and
+        // boxes missing the mask's are skipped without a lookup
+        if (polygons.GetVertexCount(polygon) == 0 || polygons.GetConfidence(polygon) < minConfidence ||
+            !polygons.Intersects(polygon, bounds_)) {
+            return false;
+        }
+        const Vec2 centroid = polygons.GetCentroid(polygon);
+        return mask.Contains(centroid.x, centroid.y);
+    };
+
+    // Each block of candidates counts by class on its own thread, summed
+    // after
+    const size_t blockCount = ParallelSort::BlockCount(candidateCount, threadCount);
+    std::vector<std::map<int, int>> blockCounts(blockCount);
+    if (indexed) {
+        ParallelSort::For(candidateCount, threadCount, [&](size_t block, size_t begin, size_t end) {
+            auto run = std::upper_bound(runs.begin(), runs.end(), begin,
+                                        [](size_t i, const PolygonIndex::ClassRun& r) { return i < r.end; });
+            for (; run != runs.end() && run->begin < end; ++run) {
+                int count = 0;
+                for (size_t i = std::max<size_t>(begin, run->begin); i < std::min<size_t>(end, run->end); ++i) {
+                    count += inside(candidates[i]) ? 1 : 0;
+                }
+                if (count > 0) {
+                    blockCounts[block][run->classId] += count;
+                }
+            }
+        });
+    } else {
+        ParallelSort::For(candidateCount, threadCount, [&](size_t block, size_t begin, size_t end) {
+            for (size_t polygon = begin; polygon < end; ++polygon) {
+                if (inside(static_cast<uint32_t>(polygon))) {
+                    blockCounts[block][polygons.GetClassId(static_cast<uint32_t>(polygon))]++;
+                }
+            }
+        });
+    }
+    for (const std::map<int, int>& block : blockCounts) {
+        for (const auto& [classId, count] : block) {
+            counts[classId] += count;
+        }
+    }
+}
+
+int32_t PolygonMask::GridSizeFor(size_t pointCount) {
+    int32_t gridSize = GRID_SIZE;
+    while (gridSize < MAX_GRID_SIZE && size_t(gridSize) * gridSize < pointCount) {
+        gridSize *= 2;
+    }
+    return gridSize;
+}
+
+size_t PolygonMask::GetBoundaryCellCount() const {
+    return static_cast<size_t>(std::count(cells_.begin(), cells_.end(), BOUNDARY));
+}
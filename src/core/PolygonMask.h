@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Viewport.h"  // For Vec2, Rect
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class PolygonIndex;
+class PolygonStore;
+
+// Point-in-polygon tests against one polygon for many points, e.g. cell
+// centroids against an annotation.
+//
+// A grid of up to GRID_SIZE x GRID_SIZE square cells covers the polygon's
+// bounding box. Cells an edge passes through are boundary cells; the rest
+// are wholly inside or outside, decided once from the crossings along
+// their row. Only points in boundary cells are ray cast against the edges,
+// so a test is O(1) for most points instead of O(vertices).
+//
+// Counting many centroids refines the grid to their number (GridSizeFor),
+// keeping the share left to ray casting small, and splits them across
+// threads.
+class PolygonMask {
+public:
+    // vertices: outline in order (either winding); fewer than 3 contain nothing.
+    // gridSize: cells along the longer side of the bounding box
+    explicit PolygonMask(const std::vector<Vec2>& vertices, int32_t gridSize = GRID_SIZE);
+
+    // Same answer as ray casting against the outline
+    bool Contains(double x, double y) const;
+
+    // How a box lies against the outline: NONE and WHOLE are certain,
+    // PARTIAL means the outline may cross it
+    enum Overlap : uint8_t { NONE, WHOLE, PARTIAL };
+    Overlap Classify(const Rect& box) const;
+
+    /**
+     * Add to counts (by class) the polygons whose centroid lies inside
+     * @param polygons Store to count
+     * @param index Spatial index over polygons, used to visit only those
+     *        reaching into the bounding box; null (or not covering the
+     *        whole store) scans every box instead
+     * @param counts Class ID -> count, added to
+     * @param minConfidence Polygons with a lower confidence are not counted
+     * @param threadCount Threads testing centroids, 0 for the hardware
+     *        threads; few candidates take one whatever it is
+     */
+    void CountCentroids(const PolygonStore& polygons, const PolygonIndex* index,
+                        std::map<int, int>& counts, float minConfidence = 0.0f,
+                        size_t threadCount = 0) const;
+
+    // Grid size for testing pointCount points: about one point a cell,
+    // between GRID_SIZE and MAX_GRID_SIZE
+    static int32_t GridSizeFor(size_t pointCount);
+
+    const Rect& GetBounds() const { return bounds_; }
+    int32_t GetColumns() const { return columns_; }
+    int32_t GetRows() const { return rows_; }
+    size_t GetBoundaryCellCount() const;
+
+    static constexpr int32_t GRID_SIZE = 256;
+    static constexpr int32_t MAX_GRID_SIZE = 2048;
+
+private:
+    enum Cell : uint8_t { OUTSIDE, INSIDE, BOUNDARY };
+
+    bool RayCast(double x, double y) const;
+
+    std::vector<Vec2> vertices_;
+    int32_t gridSize_;
+    Rect bounds_;
+    double cellSize_ = 0.0;
+    int32_t columns_ = 0;
+    int32_t rows_ = 0;
+    std::vector<Cell> cells_;  // Row-major
+};
@@ -1,12 +1,17 @@
 #include "PolygonOverlay.h"
 #include "PolygonLoader.h"
 #include "PolygonLoaderFactory.h"
+#include "PolygonCache.h"
 #include "PolygonIndex.h"
-#include "PolygonTriangulator.h"
+#include "PolygonLoadTask.h"
+#include "FrameProfiler.h"
+#include "TextureManager.h"
+#include "TissueMap.h"
 #include "Viewport.h"
-#include <iostream>
+#include "Log.h"
 #include <set>
 #include <algorithm>
+#include <cmath>
 
 // Default color palette for < 10 classes
 static const SDL_Color DEFAULT_COLORS[] = {
@@ -24,36 +29,79 @@ static const SDL_Color DEFAULT_COLORS[] = {
 
 static constexpr size_t NUM_DEFAULT_COLORS = sizeof(DEFAULT_COLORS) / sizeof(DEFAULT_COLORS[0]);
 
-PolygonOverlay::PolygonOverlay(SDL_Renderer* renderer)
+struct PolygonOverlay::RenderScratch {
+    // Query results
+    std::vector<uint32_t> visiblePolygons;
+    std::vector<PolygonIndex::ClassRun> visibleClassRuns;
+    // A class batch's polygons by LOD level (indexed by LODLevel)
+    std::array<std::vector<uint32_t>, 5> lodGroups;
+
+    // POINT and BOX LOD buffers; boxIndices is the same six indices per
+    // box, extended as batches grow
+    std::vector<SDL_FPoint> lodPoints;
+    std::vector<float> lodXs;
+    std::vector<float> lodYs;
+    std::vector<float> lodPositions;
+    std::vector<SDL_Color> lodColors;
+    std::vector<int> boxIndices;
+
+    GeometryBatch fillBatch;  // Full-detail cells
+};
+
+PolygonOverlay::PolygonOverlay(SDL_Renderer* renderer, std::shared_ptr<RenderScratch> scratch)
     : renderer_(renderer)
     , visible_(false)  // Start hidden
     , opacity_(0.5f)   // 50% opacity by default
     , slideWidth_(0)
-    , slideHeight_(0) {
+    , slideHeight_(0)
+    , tileLayer_(std::make_unique<PolygonTileLayer>(renderer))
+    , tissueLayer_(std::make_unique<TissueLayer>(renderer)) {
+    scratch_ = scratch ? std::move(scratch) : std::make_shared<RenderScratch>();
+}
+
+std::unique_ptr<PolygonOverlay> PolygonOverlay::CreateLayer() const {
+    auto layer = std::make_unique<PolygonOverlay>(renderer_, scratch_);
+    layer->SetProfiler(profiler_);
+    layer->slideWidth_ = slideWidth_;
+    layer->slideHeight_ = slideHeight_;
+    return layer;
 }
 
 PolygonOverlay::~PolygonOverlay() {
+    DestroyDensityTextures();
 }
 
 void PolygonOverlay::SetSlideDimensions(double width, double height) {
     slideWidth_ = width;
     slideHeight_ = height;
+    ++revision_;
 
-    // Rebuild spatial index if polygons are already loaded
-    BuildSpatialIndex();
+    // The index does not depend on the slide size; build it if polygons
+    // were loaded before the slide
+    if (!spatialIndex_) {
+        BuildSpatialIndex();
+    }
 }
 
 bool PolygonOverlay::LoadPolygons(const std::string& filepath) {
-    std::cout << "\n=== Loading Polygons ===" << std::endl;
-    std::cout << "File: " << filepath << std::endl;
+    PATHVIEW_LOG_INFO("\n=== Loading Polygons ===");
+    PATHVIEW_LOG_INFO("File: " << filepath);
 
-    // Select the polygon loader based on the file extension
+    // Select the polygon loader based on the file extension (or its cache)
     std::unique_ptr<PolygonLoader> polygonLoader = PolygonLoaderFactory::CreateLoader(filepath);
     if (!polygonLoader) {
-        std::cerr << "Could not find a loader to load the polygon data." << std::endl;
+        PATHVIEW_LOG_ERROR("Could not find a loader to load the polygon data.");
         return false;
     }
 
+    // A synchronous load replaces any streaming one
+    ++revision_;
+    loadTask_.reset();
+    tileLayer_->Reset();
+    geometry_.Clear();
+    screenChunks_.clear();
+    cellStats_.Clear();
+
     // Load polygons
     std::map<int, SDL_Color> loadedColors;
     std::map<int, std::string> loadedClassNames;
@@ -61,128 +109,290 @@ bool PolygonOverlay::LoadPolygons(const std::string& filepath) {
         return false;
     }
 
-    // Store class names
-    classNames_ = loadedClassNames;
+    polygons_.TriangulateAll();
+    polygons_.ShrinkToFit();
+    SetClasses(loadedColors, loadedClassNames);
+    tissueLayer_->SetMap(polygonLoader->TakeTissueMap());
 
-    // Use loaded colors or initialize defaults
-    if (!loadedColors.empty()) {
-        classColors_ = loadedColors;
+    // Use an index loaded with the polygons, else build spatial index
+    std::unique_ptr<PolygonIndex> loadedIndex = polygonLoader->TakeSpatialIndex();
+    if (loadedIndex) {
+        spatialIndex_ = std::move(loadedIndex);
     } else {
-        InitializeDefaultColors();
+        BuildSpatialIndex();
     }
 
-    // Build list of class IDs
-    classIds_.clear();
-    for (const auto& pair : classColors_) {
-        classIds_.push_back(pair.first);
+    cellStats_.Build(polygons_);
+
+    StartCacheWrite(filepath, loadedColors, loadedClassNames);
+
+    PATHVIEW_LOG_INFO("Polygon overlay ready with " << polygons_.Size() << " polygons");
+    PATHVIEW_LOG_INFO("Classes: " << classIds_.size());
+    PATHVIEW_LOG_INFO("===================");
+
+    return true;
+}
+
+std::unique_ptr<PolygonLoadTask> PolygonOverlay::CreateLoadTask(const std::string& filepath,
+                                                               std::function<void()> onProgress) {
+    PATHVIEW_LOG_INFO("\n=== Streaming Polygons ===");
+    PATHVIEW_LOG_INFO("File: " << filepath);
+
+    std::unique_ptr<PolygonLoader> polygonLoader = PolygonLoaderFactory::CreateLoader(filepath);
+    if (!polygonLoader) {
+        PATHVIEW_LOG_ERROR("Could not find a loader to load the polygon data.");
+        return nullptr;
     }
+    return std::make_unique<PolygonLoadTask>(std::move(polygonLoader), filepath, std::move(onProgress));
+}
 
-    // Build spatial index if we have slide dimensions
-    BuildSpatialIndex();
+bool PolygonOverlay::StartLoadingPolygons(const std::string& filepath, std::function<void()> onProgress) {
+    return StartLoadingPolygons(CreateLoadTask(filepath, std::move(onProgress)));
+}
+
+bool PolygonOverlay::StartLoadingPolygons(std::unique_ptr<PolygonLoadTask> task) {
+    if (!task) {
+        return false;
+    }
 
-    std::cout << "Polygon overlay ready with " << polygons_.size() << " polygons" << std::endl;
-    std::cout << "Classes: " << classIds_.size() << std::endl;
-    std::cout << "===================" << std::endl;
+    // Drop the current polygons; the index is built from the first batch
+    // and extended with each later one
+    ++revision_;
+    loadTask_.reset();
+    tileLayer_->Reset();
+    geometry_.Clear();
+    screenChunks_.clear();
+    polygons_.Clear();
+    cellStats_.Clear();
+    density_.Clear();
+    DestroyDensityTextures();
+    densityDirty_ = false;
+    classNames_.clear();
+    classColors_.clear();
+    classIds_.clear();
+    tissueLayer_->SetMap(nullptr);
+    BuildSpatialIndex();
 
+    loadTask_ = std::move(task);
     return true;
 }
 
+bool PolygonOverlay::UpdateLoading(const Viewport* viewport) {
+    if (!loadTask_) {
+        return false;
+    }
+
+    if (viewport) {
+        Rect visible = viewport->GetVisibleRegion();
+        loadTask_->SetFocus(Vec2(visible.x + visible.width * 0.5, visible.y + visible.height * 0.5));
+    }
+
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedClassNames;
+    if (loadTask_->TakeClasses(loadedColors, loadedClassNames)) {
+        SetClasses(loadedColors, loadedClassNames);
+        ++revision_;
+    }
+    if (std::unique_ptr<TissueMap> tissueMap = loadTask_->TakeTissueMap()) {
+        tissueLayer_->SetMap(std::move(tissueMap));
+        ++revision_;
+    }
+
+    // Checked before taking batches: none can arrive after the finish
+    const bool finished = loadTask_->IsFinished();
+
+    bool changed = false;
+    for (PolygonStore& batch : loadTask_->TakeBatches()) {
+        uint32_t begin = static_cast<uint32_t>(polygons_.Size());
+        if (polygons_.Empty()) {
+            // Taken whole: keeps the triangulations of a cached file
+            polygons_ = std::move(batch);
+        } else {
+            polygons_.Append(batch);
+        }
+        densityDirty_ = true;
+        if (!spatialIndex_) {
+            BuildSpatialIndex();
+        } else {
+            spatialIndex_->Insert(polygons_, begin, static_cast<uint32_t>(polygons_.Size()));
+        }
+        changed = true;
+    }
+
+    if (finished) {
+        polygons_.ShrinkToFit();
+        if (spatialIndex_) {
+            spatialIndex_->Pack();
+        }
+        cellStats_.Build(polygons_);
+        if (loadTask_->Succeeded()) {
+            PATHVIEW_LOG_INFO("Polygon overlay ready with " << polygons_.Size() << " polygons after "
+                              << loadTask_->GetElapsedSeconds() << " s");
+            StartCacheWrite(loadTask_->GetPath(), classColors_, classNames_);
+        } else {
+            PATHVIEW_LOG_ERROR("Failed to load polygons from: " << loadTask_->GetPath());
+        }
+        loadTask_.reset();
+        changed = true;
+    }
+
+    if (changed) {
+        ++revision_;
+    }
+    return changed;
+}
+
+float PolygonOverlay::GetLoadProgress() const {
+    return loadTask_ ? loadTask_->GetProgress() : 1.0f;
+}
+
 void PolygonOverlay::Render(const Viewport& viewport) {
-    if (!visible_ || polygons_.empty()) {
+    if (!visible_) {
+        return;
+    }
+    if (tissueVisible_ && tissueLayer_->HasMap()) {
+        ProfileZone zone(profiler_, "Tissue");
+        tissueLayer_->Render(viewport, tissueOpacity_);
+    }
+    if (polygons_.Empty()) {
         return;
     }
 
     // Get visible region for culling
     Rect visibleRegion = viewport.GetVisibleRegion();
 
-    // Debug output (print once per 60 frames to avoid spam)
-    static int frameCount = 0;
-    if (frameCount++ % 60 == 0) {
-        std::cout << "[PolygonOverlay] Rendering - Total polygons: " << polygons_.size()
-                  << ", Visible region: [" << visibleRegion.x << ", " << visibleRegion.y
-                  << ", " << visibleRegion.width << ", " << visibleRegion.height << "]" << std::endl;
-        if (!polygons_.empty()) {
-            std::cout << "[PolygonOverlay] Sample polygon bbox: ["
-                      << polygons_[0].boundingBox.x << ", " << polygons_[0].boundingBox.y
-                      << ", " << polygons_[0].boundingBox.width << ", " << polygons_[0].boundingBox.height << "]" << std::endl;
+    PATHVIEW_LOG_EVERY_MS(LogLevel::Debug, 1000,
+                          "[PolygonOverlay] Rendering - Total polygons: " << polygons_.Size()
+                          << ", Visible region: [" << visibleRegion.x << ", " << visibleRegion.y
+                          << ", " << visibleRegion.width << ", " << visibleRegion.height << "]");
+
+    // Zoomed out: the density layer stands in for the cells (rebuilt once
+    // a load completes, not for every streamed batch)
+    if (!loadTask_ && PolygonDensity::BIN_SIZE * viewport.GetZoom() <= densityBinScreenPixels_) {
+        ProfileZone zone(profiler_, "Density");
+        if (densityDirty_) {
+            BuildDensityTextures();
+        }
+        if (!density_.Empty()) {
+            RenderDensity(viewport);
+            return;
         }
     }
 
-    // Query spatial index for visible polygons
-    std::vector<Polygon*> visiblePolygons;
-    if (spatialIndex_) {
-        visiblePolygons = spatialIndex_->QueryRegion(visibleRegion);
-    } else {
-        // Fallback: brute force culling (less efficient)
-        for (auto& polygon : polygons_) {
-            if (polygon.boundingBox.Intersects(visibleRegion)) {
-                visiblePolygons.push_back(&polygon);
-            }
+    // Up to tileMaxZoom_, cells are drawn from tiles rasterized off the
+    // render thread (once loaded: the workers read the store unlocked)
+    if (!loadTask_ && spatialIndex_ && viewport.GetZoom() <= tileMaxZoom_) {
+        ProfileZone zone(profiler_, "Tiles");
+        if (!tileLayer_->HasPolygons()) {
+            tileLayer_->SetPolygons(&polygons_, spatialIndex_.get());
+            tileLayer_->SetStyle(MakeTileStyle(), {});
         }
+        tileLayer_->Render(viewport, opacity_);
+        return;
     }
 
-    // Phase 1: Size-based culling to skip tiny polygons
-    const double zoom = viewport.GetZoom();
-    std::vector<Polygon*> lodFilteredPolygons;
-    lodFilteredPolygons.reserve(visiblePolygons.size());
-
-    for (auto* polygon : visiblePolygons) {
-        double screenSize = std::max(
-            polygon->boundingBox.width * zoom,
-            polygon->boundingBox.height * zoom
-        );
-
-        if (screenSize >= minScreenSizePixels_) {
-            lodFilteredPolygons.push_back(polygon);
+    // Closer in, chunks of cells are drawn from geometry kept across frames
+    // (built as each chunk first comes into view); a streaming load keeps
+    // assembling it per frame below
+    if (!loadTask_) {
+        ProfileZone zone(profiler_, "Chunks");
+        if (geometry_.Empty()) {
+            geometry_.Build(polygons_);
+            RestyleGeometry();
         }
+        RenderChunks(viewport);
+        return;
     }
 
-    visiblePolygons = std::move(lodFilteredPolygons);
+    // Query spatial index for the visible polygons of shown classes,
+    // bucketed by class, into the buffers kept from the last frame
+    std::vector<uint32_t>& visiblePolygons = scratch_->visiblePolygons;
+    std::vector<PolygonIndex::ClassRun>& classRuns = scratch_->visibleClassRuns;
+    {
+        ProfileZone zone(profiler_, "Query");
+        if (spatialIndex_) {
+            spatialIndex_->QueryRegion(visibleRegion, classVisibility_, visiblePolygons, classRuns);
+        } else {
+            visiblePolygons.clear();
+            classRuns.clear();
+
+            // Fallback: brute force culling (less efficient)
+            const uint32_t count = static_cast<uint32_t>(polygons_.Size());
+            for (uint32_t polygon = 0; polygon < count; ++polygon) {
+                if (polygons_.Intersects(polygon, visibleRegion) &&
+                    classVisibility_.IsVisible(polygons_.GetClassId(polygon))) {
+                    visiblePolygons.push_back(polygon);
+                }
+            }
+            std::stable_sort(visiblePolygons.begin(), visiblePolygons.end(), [this](uint32_t a, uint32_t b) {
+                return polygons_.GetClassId(a) < polygons_.GetClassId(b);
+            });
+            for (uint32_t i = 0; i < visiblePolygons.size(); ++i) {
+                const int classId = polygons_.GetClassId(visiblePolygons[i]);
+                if (classRuns.empty() || classRuns.back().classId != classId) {
+                    classRuns.push_back({classId, i, i});
+                }
+                classRuns.back().end = i + 1;
+            }
+        }
+    }
 
-    if (frameCount % 60 == 1) {
-        std::cout << "[PolygonOverlay] Visible polygons: " << visiblePolygons.size() << std::endl;
+    // Phase 1: Size-based culling to skip tiny polygons, and those below
+    // the confidence threshold (in place, class by class)
+    const double zoom = viewport.GetZoom();
+    uint32_t kept = 0;
+    for (PolygonIndex::ClassRun& run : classRuns) {
+        const uint32_t begin = kept;
+        for (uint32_t i = run.begin; i < run.end; ++i) {
+            const uint32_t polygon = visiblePolygons[i];
+            double screenSize = std::max(
+                (polygons_.GetMaxX(polygon) - polygons_.GetMinX(polygon)) * zoom,
+                (polygons_.GetMaxY(polygon) - polygons_.GetMinY(polygon)) * zoom
+            );
+
+            if (screenSize >= lod_.minScreenSizePixels && polygons_.GetConfidence(polygon) >= minConfidence_) {
+                visiblePolygons[kept++] = polygon;
+            }
+        }
+        run.begin = begin;
+        run.end = kept;
     }
+    visiblePolygons.resize(kept);
+
+    PATHVIEW_LOG_EVERY_MS(LogLevel::Debug, 1000, "[PolygonOverlay] Visible polygons: " << visiblePolygons.size());
 
     if (visiblePolygons.empty()) {
         return;
     }
 
-    // Group polygons by class for batching
-    std::map<int, std::vector<Polygon*>> batchesByClass;
-    for (auto* polygon : visiblePolygons) {
-        batchesByClass[polygon->classId].push_back(polygon);
-    }
-
     // Set blend mode for opacity
     SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
 
     // Render each class batch
-    for (const auto& pair : batchesByClass) {
-        int classId = pair.first;
-        const std::vector<Polygon*>& batch = pair.second;
-        RenderPolygonBatch(batch, classId, viewport);
+    ProfileZone zone(profiler_, "Draw");
+    for (const PolygonIndex::ClassRun& run : classRuns) {
+        if (run.end > run.begin) {
+            RenderPolygonBatch(visiblePolygons.data() + run.begin, run.end - run.begin, run.classId, viewport);
+        }
     }
 }
 
-void PolygonOverlay::RenderPolygonBatch(const std::vector<Polygon*>& batch,
+void PolygonOverlay::RenderPolygonBatch(const uint32_t* batch, size_t count,
                                         int classId,
                                         const Viewport& viewport) {
     // Phase 2: Group polygons by LOD level
-    std::vector<Polygon*> pointPolygons;
-    std::vector<Polygon*> boxPolygons;
-    std::vector<Polygon*> simplifiedPolygons;
-    std::vector<Polygon*> fullPolygons;
-
-    for (auto* polygon : batch) {
-        LODLevel lod = DeterminePolygonLOD(polygon, viewport);
-        switch (lod) {
-            case LODLevel::SKIP: break;
-            case LODLevel::POINT: pointPolygons.push_back(polygon); break;
-            case LODLevel::BOX: boxPolygons.push_back(polygon); break;
-            case LODLevel::SIMPLIFIED: simplifiedPolygons.push_back(polygon); break;
-            case LODLevel::FULL: fullPolygons.push_back(polygon); break;
-        }
+    std::array<std::vector<uint32_t>, 5>& lodGroups = scratch_->lodGroups;
+    for (std::vector<uint32_t>& group : lodGroups) {
+        group.clear();
     }
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t polygon = batch[i];
+        lodGroups[static_cast<size_t>(DeterminePolygonLOD(polygon, viewport))].push_back(polygon);
+    }
+    const std::vector<uint32_t>& pointPolygons = lodGroups[static_cast<size_t>(LODLevel::POINT)];
+    const std::vector<uint32_t>& boxPolygons = lodGroups[static_cast<size_t>(LODLevel::BOX)];
+    const std::vector<uint32_t>& simplifiedPolygons = lodGroups[static_cast<size_t>(LODLevel::SIMPLIFIED)];
+    const std::vector<uint32_t>& fullPolygons = lodGroups[static_cast<size_t>(LODLevel::FULL)];
 
     SDL_Color color = GetClassColor(classId);
     uint8_t alpha = static_cast<uint8_t>(opacity_ * 255);
@@ -190,141 +400,247 @@ void PolygonOverlay::RenderPolygonBatch(const std::vector<Polygon*>& batch,
     // Render each LOD group with optimized method
     if (!pointPolygons.empty()) RenderAsPoints(pointPolygons, color, alpha, viewport);
     if (!boxPolygons.empty()) RenderAsBoxes(boxPolygons, color, alpha, viewport);
-    if (!simplifiedPolygons.empty()) RenderFull(simplifiedPolygons, color, alpha, viewport); // Simplified = full for now
+    if (!simplifiedPolygons.empty()) RenderFull(simplifiedPolygons, color, alpha, viewport, true);
     if (!fullPolygons.empty()) RenderFull(fullPolygons, color, alpha, viewport);
 }
 
 // Phase 2: Determine appropriate LOD level based on screen size
 LODLevel PolygonOverlay::DeterminePolygonLOD(
-    const Polygon* polygon,
+    uint32_t polygon,
     const Viewport& viewport) const {
 
     const double zoom = viewport.GetZoom();
     const double screenSize = std::max(
-        polygon->boundingBox.width * zoom,
-        polygon->boundingBox.height * zoom
+        (polygons_.GetMaxX(polygon) - polygons_.GetMinX(polygon)) * zoom,
+        (polygons_.GetMaxY(polygon) - polygons_.GetMinY(polygon)) * zoom
     );
 
-    if (screenSize < minScreenSizePixels_) return LODLevel::SKIP;
-    if (screenSize < lodPointThreshold_) return LODLevel::POINT;
-    if (screenSize < lodBoxThreshold_) return LODLevel::BOX;
-    if (screenSize < lodSimplifiedThreshold_) return LODLevel::SIMPLIFIED;
-    return LODLevel::FULL;
+    return lod_.Classify(screenSize);
 }
 
-// Phase 2.4.3: Render polygons at full geometric detail
+// Phase 2.4.3: Render polygons at full geometric detail, or their
+// simplified outlines
 void PolygonOverlay::RenderFull(
-    const std::vector<Polygon*>& polygons,
+    const std::vector<uint32_t>& polygons,
     SDL_Color color, uint8_t alpha,
-    const Viewport& viewport) {
-
-    std::vector<SDL_Vertex> vertices;
-    std::vector<int> indices;
-    vertices.reserve(polygons.size() * 20);
-    indices.reserve(polygons.size() * 54);
-
-    for (auto* polygon : polygons) {
-        if (polygon->vertices.size() < 3) continue;
-
-        // Triangulate if not cached
-        if (polygon->triangleIndices.empty()) {
-            polygon->triangleIndices = PolygonTriangulator::Triangulate(polygon->vertices);
-        }
-        if (polygon->triangleIndices.empty()) continue;
-
-        int baseIndex = static_cast<int>(vertices.size());
-
-        // Transform vertices to screen space
-        for (const auto& vertex : polygon->vertices) {
-            Vec2 screenPos = viewport.SlideToScreen(vertex);
-            SDL_Vertex sdlVertex;
-            sdlVertex.position = {static_cast<float>(screenPos.x), static_cast<float>(screenPos.y)};
-            sdlVertex.color = {color.r, color.g, color.b, alpha};
-            sdlVertex.tex_coord = {0.0f, 0.0f};
-            vertices.push_back(sdlVertex);
-        }
-
-        // Add indices with offset
-        for (int idx : polygon->triangleIndices) {
-            indices.push_back(baseIndex + idx);
+    const Viewport& viewport,
+    bool simplified) {
+
+    const SDL_Color fill{color.r, color.g, color.b, alpha};
+    GeometryBatch& batch = scratch_->fillBatch;
+    batch.Clear();
+    for (uint32_t polygon : polygons) {
+        const uint32_t vertexCount = polygons_.GetVertexCount(polygon);
+        if (vertexCount < 3) continue;
+
+        // Triangulated when loaded
+        uint32_t triangleCount = 0;
+        const uint32_t* triangles = simplified ? polygons_.GetSimplifiedTriangles(polygon, triangleCount)
+                                               : polygons_.GetTriangles(polygon, triangleCount);
+        if (triangleCount == 0) continue;
+
+        // Vertices to screen space in one batch, then the triangles over
+        // them, or the quads along their edges in outline mode
+        const Vec2f* polygonVertices = polygons_.GetVertices(polygon);
+        const int base = batch.AddVertices(&polygonVertices[0].x, vertexCount, viewport, fill);
+        if (outlineMode_) {
+            batch.AddOutline(base, vertexCount, GetClassOutlineWidth(polygons_.GetClassId(polygon)), fill);
+        } else {
+            batch.AddTriangles(base, triangles, triangleCount);
         }
     }
-
-    if (!vertices.empty() && !indices.empty()) {
-        SDL_RenderGeometry(renderer_, nullptr,
-            vertices.data(), static_cast<int>(vertices.size()),
-            indices.data(), static_cast<int>(indices.size()));
-    }
+    batch.Draw(renderer_);
 }
 
-// Phase 2.4.1: Render polygons as single points (ultra-fast for tiny polygons)
+// Phase 2.4.1: Render polygons as single points (ultra-fast for tiny
+// polygons): every center of the batch in one draw call
 void PolygonOverlay::RenderAsPoints(
-    const std::vector<Polygon*>& polygons,
+    const std::vector<uint32_t>& polygons,
     SDL_Color color, uint8_t alpha,
     const Viewport& viewport) {
 
+    if (polygons.empty()) {
+        return;
+    }
     SDL_SetRenderDrawColor(renderer_, color.r, color.g, color.b, alpha);
 
-    for (auto* polygon : polygons) {
-        // Render center point
-        Vec2 center(
-            polygon->boundingBox.x + polygon->boundingBox.width * 0.5,
-            polygon->boundingBox.y + polygon->boundingBox.height * 0.5
-        );
-        Vec2 screenPos = viewport.SlideToScreen(center);
-        SDL_RenderDrawPoint(renderer_,
-            static_cast<int>(screenPos.x),
-            static_cast<int>(screenPos.y));
+    // Center points, transformed to screen space in place
+    std::vector<SDL_FPoint>& points = scratch_->lodPoints;
+    points.resize(polygons.size());
+    float* centers = &points[0].x;
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        centers[2 * i] = (polygons_.GetMinX(polygons[i]) + polygons_.GetMaxX(polygons[i])) * 0.5f;
+        centers[2 * i + 1] = (polygons_.GetMinY(polygons[i]) + polygons_.GetMaxY(polygons[i])) * 0.5f;
     }
+    viewport.TransformToScreen(centers, polygons.size(), centers);
+
+    SDL_RenderDrawPointsF(renderer_, points.data(), static_cast<int>(points.size()));
 }
 
-// Phase 2.4.2: Render polygons as bounding box rectangles (fast for small polygons)
+// Phase 2.4.2: Render polygons as bounding box rectangles (fast for small
+// polygons): four corners per box, one shared index pattern, one draw call
 void PolygonOverlay::RenderAsBoxes(
-    const std::vector<Polygon*>& polygons,
+    const std::vector<uint32_t>& polygons,
     SDL_Color color, uint8_t alpha,
     const Viewport& viewport) {
 
-    std::vector<SDL_Vertex> vertices;
-    vertices.reserve(polygons.size() * 6);  // 2 triangles = 6 vertices per box
+    RenderScratch& scratch = *scratch_;
+
+    // Corners TL, TR, BL, BR of each box, gathered from the store's bounds
+    // columns and transformed in one batch
+    const size_t count = polygons.size();
+    scratch.lodXs.resize(4 * count);
+    scratch.lodYs.resize(4 * count);
+    for (size_t i = 0; i < count; ++i) {
+        const float left = polygons_.GetMinX(polygons[i]);
+        const float top = polygons_.GetMinY(polygons[i]);
+        const float right = polygons_.GetMaxX(polygons[i]);
+        const float bottom = polygons_.GetMaxY(polygons[i]);
+        float* xs = scratch.lodXs.data() + 4 * i;
+        float* ys = scratch.lodYs.data() + 4 * i;
+        xs[0] = left;
+        xs[1] = right;
+        xs[2] = left;
+        xs[3] = right;
+        ys[0] = top;
+        ys[1] = top;
+        ys[2] = bottom;
+        ys[3] = bottom;
+    }
+    scratch.lodPositions.resize(8 * count);
+    viewport.TransformToScreen(scratch.lodXs.data(), scratch.lodYs.data(), 4 * count, scratch.lodPositions.data());
+    scratch.lodColors.assign(4 * count, SDL_Color{color.r, color.g, color.b, alpha});
+
+    // Triangles TL, TR, BL and TR, BR, BL of every box, built once and
+    // grown as needed
+    for (size_t box = scratch.boxIndices.size() / 6; box < count; ++box) {
+        const int first = static_cast<int>(4 * box);
+        scratch.boxIndices.insert(scratch.boxIndices.end(),
+                                  {first, first + 1, first + 2, first + 1, first + 3, first + 2});
+    }
+
+    if (count > 0) {
+        SDL_RenderGeometryRaw(renderer_, nullptr,
+                              scratch.lodPositions.data(), static_cast<int>(2 * sizeof(float)),
+                              scratch.lodColors.data(), static_cast<int>(sizeof(SDL_Color)),
+                              nullptr, 0,
+                              static_cast<int>(scratch.lodColors.size()),
+                              scratch.boxIndices.data(), static_cast<int>(6 * count),
+                              static_cast<int>(sizeof(int)));
+    }
+}
 
-    for (auto* polygon : polygons) {
-        const Rect& bbox = polygon->boundingBox;
+void PolygonOverlay::SetOpacity(float opacity) {
+    opacity = std::max(0.0f, std::min(1.0f, opacity));
+    if (opacity != opacity_) {
+        opacity_ = opacity;
+        ++revision_;
+        RestyleGeometry();
+    }
+}
 
-        // Transform 4 corners to screen space
-        Vec2 tl = viewport.SlideToScreen(Vec2(bbox.x, bbox.y));
-        Vec2 tr = viewport.SlideToScreen(Vec2(bbox.x + bbox.width, bbox.y));
-        Vec2 bl = viewport.SlideToScreen(Vec2(bbox.x, bbox.y + bbox.height));
-        Vec2 br = viewport.SlideToScreen(Vec2(bbox.x + bbox.width, bbox.y + bbox.height));
+void PolygonOverlay::SetClassColor(int classId, SDL_Color color) {
+    SDL_Color& current = classColors_[classId];
+    if (current.r != color.r || current.g != color.g || current.b != color.b || current.a != color.a) {
+        current = color;
+        densityDirty_ = true;
+        ++revision_;
+        if (tileLayer_->HasPolygons()) {
+            tileLayer_->SetStyle(MakeTileStyle(), {classId});
+        }
+        RestyleGeometry();
+    }
+}
+
+void PolygonOverlay::SetClassVisible(int classId, bool visible) {
+    if (classVisibility_.IsVisible(classId) == visible) {
+        return;
+    }
+    classVisibility_.SetVisible(classId, visible);
+    densityDirty_ = true;
+    ++revision_;
+
+    // Tiles only know the classes they drew, so showing a class redraws
+    // every tile; hiding one redraws the tiles holding it
+    if (tileLayer_->HasPolygons()) {
+        tileLayer_->SetStyle(MakeTileStyle(), visible ? std::vector<int>() : std::vector<int>{classId});
+    }
+    geometry_.SetVisibility(classVisibility_);
+}
 
-        SDL_Vertex v0 = {{(float)tl.x, (float)tl.y}, {color.r, color.g, color.b, alpha}, {0,0}};
-        SDL_Vertex v1 = {{(float)tr.x, (float)tr.y}, {color.r, color.g, color.b, alpha}, {0,0}};
-        SDL_Vertex v2 = {{(float)bl.x, (float)bl.y}, {color.r, color.g, color.b, alpha}, {0,0}};
-        SDL_Vertex v3 = {{(float)br.x, (float)br.y}, {color.r, color.g, color.b, alpha}, {0,0}};
+void PolygonOverlay::SetMinConfidence(float minConfidence) {
+    minConfidence = std::max(0.0f, std::min(1.0f, minConfidence));
+    if (minConfidence == minConfidence_) {
+        return;
+    }
+    minConfidence_ = minConfidence;
+    densityDirty_ = true;
+    ++revision_;
 
-        // Triangle 1: TL, TR, BL
-        vertices.push_back(v0);
-        vertices.push_back(v1);
-        vertices.push_back(v2);
+    // Raising it hides cells of any class, lowering it shows them
+    if (tileLayer_->HasPolygons()) {
+        tileLayer_->SetStyle(MakeTileStyle(), {});
+    }
+    geometry_.SetMinConfidence(minConfidence_);
+}
 
-        // Triangle 2: TR, BR, BL
-        vertices.push_back(v1);
-        vertices.push_back(v3);
-        vertices.push_back(v2);
+void PolygonOverlay::SetOutlineMode(bool outlines) {
+    if (outlines == outlineMode_) {
+        return;
+    }
+    outlineMode_ = outlines;
+    ++revision_;
+    if (tileLayer_->HasPolygons()) {
+        tileLayer_->SetStyle(MakeTileStyle(), {});
+    }
+    if (!outlineMode_) {
+        for (ScreenChunk& screen : screenChunks_) {
+            screen.outlines = GeometryBatch();
+        }
     }
+    RestyleGeometry();
+}
 
-    if (!vertices.empty()) {
-        SDL_RenderGeometry(renderer_, nullptr,
-            vertices.data(), static_cast<int>(vertices.size()),
-            nullptr, 0);
+void PolygonOverlay::SetClassOutlineWidth(int classId, float width) {
+    width = std::max(0.5f, std::min(MAX_OUTLINE_WIDTH, width));
+    if (width == GetClassOutlineWidth(classId)) {
+        return;
+    }
+    outlineWidths_[classId] = width;
+    if (!outlineMode_) {
+        return;
+    }
+    ++revision_;
+    if (tileLayer_->HasPolygons()) {
+        tileLayer_->SetStyle(MakeTileStyle(), {classId});
     }
+    RestyleGeometry();
 }
 
-void PolygonOverlay::SetOpacity(float opacity) {
-    opacity_ = std::max(0.0f, std::min(1.0f, opacity));
+float PolygonOverlay::GetClassOutlineWidth(int classId) const {
+    auto it = outlineWidths_.find(classId);
+    return it != outlineWidths_.end() ? it->second : DEFAULT_OUTLINE_WIDTH;
 }
 
-void PolygonOverlay::SetClassColor(int classId, SDL_Color color) {
-    classColors_[classId] = color;
+void PolygonOverlay::SetTileReadyCallback(std::function<void()> onTileReady) {
+    tileLayer_->SetTileReadyCallback(std::move(onTileReady));
+}
+
+PolygonTileStyle PolygonOverlay::MakeTileStyle() const {
+    PolygonTileStyle style;
+    style.classColors = classColors_;
+    style.visibility = classVisibility_;
+    style.minConfidence = minConfidence_;
+    if (outlineMode_) {
+        style.outlineWidths = outlineWidths_;
+        style.defaultOutlineWidth = DEFAULT_OUTLINE_WIDTH;
+        style.outlines = true;
+    }
+    style.fallbackColors.assign(DEFAULT_COLORS, DEFAULT_COLORS + NUM_DEFAULT_COLORS);
+    style.minSizePixels = lod_.minScreenSizePixels;
+    style.pointThreshold = lod_.pointThreshold;
+    style.boxThreshold = lod_.boxThreshold;
+    return style;
 }
 
 SDL_Color PolygonOverlay::GetClassColor(int classId) const {
@@ -352,8 +668,8 @@ void PolygonOverlay::InitializeDefaultColors() {
 
     // Assign default colors to classes found in polygons
     std::set<int> uniqueClasses;
-    for (const auto& polygon : polygons_) {
-        uniqueClasses.insert(polygon.classId);
+    for (uint32_t polygon = 0; polygon < polygons_.Size(); ++polygon) {
+        uniqueClasses.insert(polygons_.GetClassId(polygon));
     }
 
     size_t colorIndex = 0;
@@ -363,18 +679,305 @@ void PolygonOverlay::InitializeDefaultColors() {
     }
 }
 
+void PolygonOverlay::StartCacheWrite(const std::string& filepath,
+                                     const std::map<int, SDL_Color>& loadedColors,
+                                     const std::map<int, std::string>& loadedClassNames) {
+    if (polygons_.Empty() || PolygonCache::IsFresh(filepath)) {
+        return;
+    }
+
+    // The writer triangulates every polygon, so it works on copies, off the
+    // GUI thread
+    std::unique_ptr<PolygonIndex> index;
+    if (spatialIndex_) {
+        index = std::make_unique<PolygonIndex>(*spatialIndex_);
+    }
+    std::unique_ptr<TissueMap> tissueMap;
+    if (tissueLayer_->HasMap()) {
+        tissueMap = std::make_unique<TissueMap>(*tissueLayer_->GetMap());
+    }
+    PolygonCache::WriteInBackground(filepath, polygons_, std::move(index), loadedColors, loadedClassNames,
+                                    std::move(tissueMap));
+}
+
+void PolygonOverlay::SetClasses(const std::map<int, SDL_Color>& loadedColors,
+                                const std::map<int, std::string>& loadedClassNames) {
+    // Store class names
+    classNames_ = loadedClassNames;
+    densityDirty_ = true;
+
+    // Use loaded colors or initialize defaults
+    if (!loadedColors.empty()) {
+        classColors_ = loadedColors;
+    } else {
+        InitializeDefaultColors();
+    }
+
+    RestyleGeometry();
+
+    // Build list of class IDs
+    classIds_.clear();
+    for (const auto& pair : classColors_) {
+        classIds_.push_back(pair.first);
+    }
+}
+
+size_t PolygonOverlay::GetIndexMemoryUsage() const {
+    return (spatialIndex_ ? spatialIndex_->GetMemoryUsage() : 0) + cellStats_.GetMemoryUsage();
+}
+
+bool PolygonOverlay::RenderDensityOverview(int width, int height, int classId,
+                                           std::vector<uint32_t>& pixels) const {
+    if (slideWidth_ <= 0.0 || slideHeight_ <= 0.0) {
+        return false;
+    }
+    ClassVisibility visibility = classVisibility_;
+    if (classId != -1) {
+        for (int id : classIds_) {
+            visibility.SetVisible(id, id == classId);
+        }
+    }
+    return PolygonDensity::RenderOverview(cellStats_, classColors_, visibility, slideWidth_, slideHeight_, width,
+                                          height, pixels);
+}
+
+size_t PolygonOverlay::GetDensityMemoryUsage() const {
+    size_t bytes = density_.GetMemoryUsage();
+    for (size_t level = 0; level < densityTextures_.size(); ++level) {
+        if (densityTextures_[level]) {
+            const DensityLevel& geometry = density_.GetLevel(level);
+            bytes += static_cast<size_t>(geometry.columns) * geometry.rows * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+void PolygonOverlay::BuildDensityTextures() {
+    densityDirty_ = false;
+    DestroyDensityTextures();
+    // The pyramid's counts know nothing of confidence
+    if (minConfidence_ > 0.0f || !density_.Build(cellStats_, classColors_, classVisibility_)) {
+        density_.Build(polygons_, classColors_, classVisibility_, minConfidence_);
+    }
+
+    // Levels beyond the renderer's texture size limit (0 = unlimited) stay
+    // null; a coarser one is drawn instead
+    int maxWidth = 0;
+    int maxHeight = 0;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer_, &info) == 0) {
+        maxWidth = info.max_texture_width;
+        maxHeight = info.max_texture_height;
+    }
+
+    for (size_t level = 0; level < density_.GetLevelCount(); ++level) {
+        const DensityLevel& geometry = density_.GetLevel(level);
+        SDL_Texture* texture = nullptr;
+        if ((maxWidth == 0 || geometry.columns <= maxWidth) && (maxHeight == 0 || geometry.rows <= maxHeight)) {
+            texture = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT, SDL_TEXTUREACCESS_STATIC,
+                                        geometry.columns, geometry.rows);
+        }
+        if (texture &&
+            SDL_UpdateTexture(texture, nullptr, geometry.pixels.data(),
+                              geometry.columns * static_cast<int>(sizeof(uint32_t))) != 0) {
+            PATHVIEW_LOG_ERROR("Failed to upload polygon density level " << level << ": " << SDL_GetError());
+            SDL_DestroyTexture(texture);
+            texture = nullptr;
+        }
+        if (texture) {
+            TextureManager::ApplyPremultipliedBlendMode(texture);
+            SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+        }
+        densityTextures_.push_back(texture);
+    }
+    density_.ReleasePixels();
+}
+
+void PolygonOverlay::DestroyDensityTextures() {
+    for (SDL_Texture* texture : densityTextures_) {
+        if (texture) {
+            SDL_DestroyTexture(texture);
+        }
+    }
+    densityTextures_.clear();
+}
+
+void PolygonOverlay::RenderDensity(const Viewport& viewport) {
+    // Finest level whose bins cover a screen pixel, or the next one uploaded
+    size_t levelIndex = density_.SelectLevel(viewport.GetZoom(), 1.0);
+    while (levelIndex < densityTextures_.size() && !densityTextures_[levelIndex]) {
+        ++levelIndex;
+    }
+    if (levelIndex >= densityTextures_.size()) {
+        return;
+    }
+    const DensityLevel& level = density_.GetLevel(levelIndex);
+    SDL_Texture* texture = densityTextures_[levelIndex];
+
+    // Only the bins in view, whole, so their edges land where they belong
+    const Rect visible = viewport.GetVisibleRegion();
+    const double binSize = level.binSize;
+    const int firstColumn = std::max(0, static_cast<int>(std::floor(visible.x / binSize)));
+    const int firstRow = std::max(0, static_cast<int>(std::floor(visible.y / binSize)));
+    const int endColumn = std::min(level.columns, static_cast<int>(std::ceil((visible.x + visible.width) / binSize)));
+    const int endRow = std::min(level.rows, static_cast<int>(std::ceil((visible.y + visible.height) / binSize)));
+    if (firstColumn >= endColumn || firstRow >= endRow) {
+        return;
+    }
+
+    SDL_Rect source = {firstColumn, firstRow, endColumn - firstColumn, endRow - firstRow};
+    Vec2 topLeft = viewport.SlideToScreen(Vec2(firstColumn * binSize, firstRow * binSize));
+    Vec2 bottomRight = viewport.SlideToScreen(Vec2(endColumn * binSize, endRow * binSize));
+    SDL_FRect destination = {
+        static_cast<float>(topLeft.x), static_cast<float>(topLeft.y),
+        static_cast<float>(bottomRight.x - topLeft.x), static_cast<float>(bottomRight.y - topLeft.y)
+    };
+
+    // Premultiplied pixels: opacity scales color and alpha alike
+    const Uint8 opacity = static_cast<Uint8>(opacity_ * 255);
+    SDL_SetTextureColorMod(texture, opacity, opacity, opacity);
+    SDL_SetTextureAlphaMod(texture, opacity);
+    SDL_RenderCopyF(renderer_, texture, &source, &destination);
+}
+
+void PolygonOverlay::RestyleGeometry() {
+    const Uint8 alpha = static_cast<Uint8>(opacity_ * 255);
+    geometry_.SetStyle([this, alpha](int classId) {
+        SDL_Color color = GetClassColor(classId);
+        color.a = alpha;
+        return color;
+    });
+}
+
+void PolygonOverlay::RenderChunks(const Viewport& viewport) {
+    geometry_.QueryChunks(viewport.GetVisibleRegion(), visibleChunks_);
+    if (visibleChunks_.empty()) {
+        return;
+    }
+
+    // Carry over the screen positions of chunks still in view (both lists
+    // ascend); chunks that left it are dropped with theirs
+    const double zoom = viewport.GetZoom();
+    const Vec2 position = viewport.GetPosition();
+    const uint64_t geometryVersion = geometry_.GetGeometryVersion();
+    const uint64_t outlineStyle = outlineMode_ ? geometry_.GetStyleVersion() : 0;
+    screenChunks_.swap(previousScreenChunks_);
+    screenChunks_.clear();
+    bool unchanged = true;
+    size_t previous = 0;
+    for (uint32_t chunk : visibleChunks_) {
+        while (previous < previousScreenChunks_.size() && previousScreenChunks_[previous].chunk < chunk) {
+            ++previous;
+        }
+        if (previous < previousScreenChunks_.size() && previousScreenChunks_[previous].chunk == chunk) {
+            screenChunks_.push_back(std::move(previousScreenChunks_[previous++]));
+        } else {
+            screenChunks_.emplace_back();
+            screenChunks_.back().chunk = chunk;
+        }
+        const ScreenChunk& screen = screenChunks_.back();
+        unchanged = unchanged && screen.zoom == zoom && screen.positionX == position.x &&
+                    screen.positionY == position.y && screen.geometryVersion == geometryVersion &&
+                    screen.outlineStyle == outlineStyle;
+    }
+
+    // Chunks coming into view are built, and the positions of every chunk
+    // the view moved over mapped to the screen (one multiply-add per
+    // coordinate), by the Prepare() workers, each into its own buffer; in
+    // outline mode they expand the edges into quads as well. A still view
+    // skips this.
+    if (!unchanged) {
+        ProfileZone zone(profiler_, "Prepare");
+        geometry_.Prepare(visibleChunks_, polygons_,
+                          [&](size_t slot, const PolygonChunkGeometry& geometry) {
+            ScreenChunk& screen = screenChunks_[slot];
+            const bool mapped = screen.zoom == zoom && screen.positionX == position.x &&
+                                screen.positionY == position.y && screen.geometryVersion == geometryVersion;
+            if (!mapped) {
+                screen.positions.resize(geometry.xy.size());
+                viewport.TransformToScreen(geometry.xy.data(), geometry.xy.size() / 2, screen.positions.data(),
+                                           geometry_.GetOriginX(screen.chunk), geometry_.GetOriginY(screen.chunk));
+                screen.zoom = zoom;
+                screen.positionX = position.x;
+                screen.positionY = position.y;
+                screen.geometryVersion = geometryVersion;
+            }
+            if (outlineMode_ && (!mapped || screen.outlineStyle != outlineStyle)) {
+                BuildChunkOutlines(geometry, screen);
+            }
+            screen.outlineStyle = outlineStyle;
+        });
+    }
+
+    // The render thread only submits, in chunk order
+    SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+    for (size_t slot = 0; slot < visibleChunks_.size(); ++slot) {
+        const PolygonChunkGeometry& geometry = geometry_.GetGeometry(visibleChunks_[slot], polygons_);
+        if (geometry.indices.empty()) {
+            continue;
+        }
+        if (outlineMode_) {
+            screenChunks_[slot].outlines.Draw(renderer_);
+            continue;
+        }
+        const std::vector<float>& screen = screenChunks_[slot].positions;
+
+        // Polygons below the SIMPLIFIED threshold on screen form a prefix
+        const size_t simplifiedPolygons = static_cast<size_t>(
+            std::lower_bound(geometry.sizes.begin(), geometry.sizes.end(),
+                             static_cast<float>(lod_.simplifiedThreshold / zoom)) - geometry.sizes.begin());
+        const int ranges[2][2] = {
+            {0, static_cast<int>(geometry.simplifiedStarts[simplifiedPolygons])},
+            {static_cast<int>(geometry.fullStarts[simplifiedPolygons]), static_cast<int>(geometry.indices.size())},
+        };
+        for (const auto& range : ranges) {
+            if (range[1] > range[0]) {
+                SDL_RenderGeometryRaw(renderer_, nullptr,
+                                      screen.data(), static_cast<int>(2 * sizeof(float)),
+                                      geometry.colors.data(), static_cast<int>(sizeof(SDL_Color)),
+                                      nullptr, 0,
+                                      static_cast<int>(geometry.colors.size()),
+                                      geometry.indices.data() + range[0], range[1] - range[0],
+                                      static_cast<int>(sizeof(int)));
+            }
+        }
+    }
+}
+
+void PolygonOverlay::BuildChunkOutlines(const PolygonChunkGeometry& geometry, ScreenChunk& screen) const {
+    screen.outlines.Clear();
+    size_t polygon = 0;
+    uint32_t runEnd = 0;
+    for (const PolygonChunkGeometry::ClassRun& run : geometry.runs) {
+        const float width = GetClassOutlineWidth(run.classId);
+        runEnd += run.vertexCount;
+        for (; polygon + 1 < geometry.vertexStarts.size() && geometry.vertexStarts[polygon] < runEnd; ++polygon) {
+            const uint32_t first = geometry.vertexStarts[polygon];
+            // Transparent: below the confidence threshold
+            const SDL_Color color = geometry.colors[first];
+            if (color.a == 0) {
+                continue;
+            }
+            screen.outlines.AddOutline(screen.positions.data() + 2 * size_t(first),
+                                       geometry.vertexStarts[polygon + 1] - first, width, color);
+        }
+    }
+}
+
 void PolygonOverlay::BuildSpatialIndex() {
-    // Clear any existing index if we cannot build a new one yet
-    if (slideWidth_ <= 0.0 || slideHeight_ <= 0.0 || polygons_.empty()) {
+    // The tile workers may be reading the index being replaced
+    tileLayer_->Reset();
+
+    // Clear any existing index if there is nothing to index
+    if (polygons_.Empty()) {
         spatialIndex_.reset();
         return;
     }
 
-    std::cout << "Building spatial index..." << std::endl;
+    PATHVIEW_LOG_INFO("Building spatial index...");
 
-    // Create spatial index with a fixed grid for now
-    spatialIndex_ = std::make_unique<PolygonIndex>(DEFAULT_GRID_SIZE, DEFAULT_GRID_SIZE, slideWidth_, slideHeight_);
+    spatialIndex_ = std::make_unique<PolygonIndex>();
     spatialIndex_->Build(polygons_);
 
-    std::cout << "Spatial index built successfully" << std::endl;
+    PATHVIEW_LOG_INFO("Spatial index built successfully");
 }
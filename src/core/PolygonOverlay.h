@@ -1,62 +1,46 @@
 #pragma once
 
 #include "Viewport.h"  // For Vec2 and Rect
+#include "PolygonStore.h"
+#include "CellStatsPyramid.h"
+#include "GeometryBatch.h"
+#include "PolygonDensity.h"
+#include "PolygonTileLayer.h"
+#include "PolygonGeometryCache.h"
+#include "PolygonIndex.h"
+#include "PolygonLod.h"
+#include "PolygonPicker.h"
+#include "TissueLayer.h"
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <map>
+#include <functional>
 #include <memory>
 #include <string>
 
 // Forward declarations
-class PolygonIndex;
-
-// Phase 2: Level-of-detail (LOD) enum
-enum class LODLevel {
-    SKIP,       // < 2 pixels - don't render
-    POINT,      // 2-4 pixels - single pixel
-    BOX,        // 4-10 pixels - bounding box rectangle
-    SIMPLIFIED, // 10-30 pixels - reduced vertices (future enhancement)
-    FULL        // 30+ pixels - full detail
-};
-
-// Polygon structure
-struct Polygon {
-    std::vector<Vec2> vertices;  // Slide coordinates (level 0)
-    int classId;                 // Cell class identifier
-
-    // Cached for performance
-    Rect boundingBox;                          // For quick culling
-    mutable std::vector<int> triangleIndices;  // Lazy triangulation
-
-    Polygon() : classId(0) {}
-
-    // Calculate bounding box from vertices
-    void ComputeBoundingBox() {
-        if (vertices.empty()) {
-            boundingBox = Rect(0, 0, 0, 0);
-            return;
-        }
-
-        double minX = vertices[0].x, maxX = vertices[0].x;
-        double minY = vertices[0].y, maxY = vertices[0].y;
-
-        for (const auto& v : vertices) {
-            if (v.x < minX) minX = v.x;
-            if (v.x > maxX) maxX = v.x;
-            if (v.y < minY) minY = v.y;
-            if (v.y > maxY) maxY = v.y;
-        }
-
-        boundingBox = Rect(minX, minY, maxX - minX, maxY - minY);
-    }
-};
+class PolygonLoadTask;
+class FrameProfiler;
 
 // Main polygon overlay class
 class PolygonOverlay {
 public:
-    explicit PolygonOverlay(SDL_Renderer* renderer);
+    // Per-frame buffers of Render(): the visible cells, their LOD groups,
+    // point and box vertices and the full-detail batch. Refilled by every
+    // Render(), so overlays drawn one after another can share one set.
+    struct RenderScratch;
+
+    explicit PolygonOverlay(SDL_Renderer* renderer, std::shared_ptr<RenderScratch> scratch = nullptr);
     ~PolygonOverlay();
 
+    // Another, empty overlay over the same slide (a second segmentation,
+    // say), sharing this one's render scratch: each layer keeps its own
+    // polygons, index and style, while the buffers a frame draws through
+    // grow once for the largest of them
+    std::unique_ptr<PolygonOverlay> CreateLayer() const;
+
     // Delete copy constructor and assignment
     PolygonOverlay(const PolygonOverlay&) = delete;
     PolygonOverlay& operator=(const PolygonOverlay&) = delete;
@@ -64,69 +48,265 @@ public:
     // Load polygons from binary file
     bool LoadPolygons(const std::string& filepath);
 
+    // Load polygons on a background thread, showing them as they arrive
+    // (see PolygonLoadTask). Replaces the current polygons. onProgress runs
+    // on the loading thread when UpdateLoading() has something to take.
+    bool StartLoadingPolygons(const std::string& filepath, std::function<void()> onProgress = nullptr);
+
+    // The same in two steps: start reading a file without an overlay (to
+    // preload it, say), then have an overlay take the task over along with
+    // whatever it has read so far. CreateLoadTask returns null if no loader
+    // handles the file.
+    static std::unique_ptr<PolygonLoadTask> CreateLoadTask(const std::string& filepath,
+                                                           std::function<void()> onProgress = nullptr);
+    bool StartLoadingPolygons(std::unique_ptr<PolygonLoadTask> task);
+
+    // Take what the background load produced: class tables, then polygon
+    // batches, indexed as they come. The viewport (may be nullptr) steers
+    // the rest of the load to its center. Returns true if polygons were
+    // added or the load finished.
+    bool UpdateLoading(const Viewport* viewport);
+
+    bool IsLoading() const { return loadTask_ != nullptr; }
+    float GetLoadProgress() const;
+
     // Render polygons for current viewport
     void Render(const Viewport& viewport);
 
+    // Optional render-thread profiler for the query/draw split of Render()
+    void SetProfiler(FrameProfiler* profiler) { profiler_ = profiler; }
+
+    // Runs on a worker thread whenever a cell tile is rasterized
+    void SetTileReadyCallback(std::function<void()> onTileReady);
+
+    // Bumped by every change to what Render() draws other than the viewport
+    // and arriving cell tiles: polygons, classes, style, visibility
+    uint64_t GetRevision() const { return revision_; }
+
+    // Rasterized cell or tissue tiles are waiting for upload budget
+    bool HasPendingTileUploads() const {
+        return tileLayer_->HasPendingUploads() || tissueLayer_->HasPendingUploads();
+    }
+
     // Visibility control
-    void SetVisible(bool visible) { visible_ = visible; }
+    void SetVisible(bool visible) {
+        if (visible != visible_) {
+            visible_ = visible;
+            ++revision_;
+        }
+    }
     bool IsVisible() const { return visible_; }
 
     // Opacity control (0.0 - 1.0)
     void SetOpacity(float opacity);
     float GetOpacity() const { return opacity_; }
 
-    // Color management
+    // Color management (the density layer follows on the next frame, cell
+    // tiles holding the class as they are redrawn)
     void SetClassColor(int classId, SDL_Color color);
     SDL_Color GetClassColor(int classId) const;
 
+    // Per-class visibility: hidden classes are skipped inside the spatial
+    // index and left out of the density layer, tiles and kept geometry
+    void SetClassVisible(int classId, bool visible);
+    bool IsClassVisible(int classId) const { return classVisibility_.IsVisible(classId); }
+
+    // Confidence slider (0 - 1): less confident cells are not drawn or
+    // picked. The overlay draws through SDL_Renderer (only tiles go through
+    // the RenderBackend), which takes vertex colors but no per-cell data,
+    // so kept geometry gives those cells' vertices alpha 0 from its
+    // per-cell confidences: changing it neither re-queries nor rebuilds.
+    // Tiles are redrawn and the density layer is binned from the cells
+    // instead of the cell stats pyramid while it is above 0.
+    void SetMinConfidence(float minConfidence);
+    float GetMinConfidence() const { return minConfidence_; }
+
+    // Outline mode: cells drawn as their contours in the class color, each
+    // class's width in screen pixels, so the stain shows through. The
+    // overlay draws triangles through SDL_Renderer, so kept geometry
+    // expands every edge into a quad on the Prepare() workers and draws
+    // each chunk's outlines in one call; tiles stroke the outlines instead
+    // of filling them.
+    void SetOutlineMode(bool outlines);
+    bool IsOutlineMode() const { return outlineMode_; }
+    void SetClassOutlineWidth(int classId, float width);
+    float GetClassOutlineWidth(int classId) const;
+
+    static constexpr float DEFAULT_OUTLINE_WIDTH = 1.5f;
+    static constexpr float MAX_OUTLINE_WIDTH = 8.0f;
+
     // Get class information for UI legend
     const std::vector<int>& GetClassIds() const { return classIds_; }
     std::string GetClassName(int classId) const;
-    int GetPolygonCount() const { return static_cast<int>(polygons_.size()); }
-    const std::vector<Polygon>& GetPolygons() const { return polygons_; }
+    int GetPolygonCount() const { return static_cast<int>(polygons_.Size()); }
+    const PolygonStore& GetPolygons() const { return polygons_; }
+    const PolygonIndex* GetSpatialIndex() const { return spatialIndex_.get(); }
+    const PolygonLod& GetLod() const { return lod_; }
+
+    // Per-class sums for region summaries, or null until a load completes
+    const CellStatsPyramid* GetCellStats() const { return cellStats_.Empty() ? nullptr : &cellStats_; }
+
+    // The whole slide's density as a width x height image for the minimap
+    // (PolygonDensity::RenderOverview), from the cell stats pyramid: the
+    // visible classes, or classId alone unless it is -1. False until a load
+    // completes and the slide dimensions are set
+    bool RenderDensityOverview(int width, int height, int classId, std::vector<uint32_t>& pixels) const;
+
+    // Store index of the visible cell under a slide point, or
+    // PolygonPicker::NO_POLYGON; asking again for the same point is free
+    uint32_t PickPolygon(const Vec2& point) {
+        return picker_.Pick(polygons_, spatialIndex_.get(), classVisibility_, point, revision_, minConfidence_);
+    }
+
+    // Tissue segmentation of the loaded file, drawn under the cells while
+    // the overlay is visible (see TissueLayer)
+    bool HasTissueMap() const { return tissueLayer_->HasMap(); }
+    TissueLayer& GetTissueLayer() { return *tissueLayer_; }
+    void SetTissueVisible(bool visible) {
+        if (visible != tissueVisible_) {
+            tissueVisible_ = visible;
+            ++revision_;
+        }
+    }
+    bool IsTissueVisible() const { return tissueVisible_; }
+    void SetTissueOpacity(float opacity) {
+        tissueOpacity_ = std::max(0.0f, std::min(1.0f, opacity));
+        ++revision_;
+    }
+    float GetTissueOpacity() const { return tissueOpacity_; }
 
     // Get slide dimensions (for spatial index)
     void SetSlideDimensions(double width, double height);
 
+    // Bytes held for the loaded polygons: vertices (with the polygon
+    // columns), triangulations cached so far, the spatial index (with the
+    // cell stats pyramid), and the
+    // density layer's textures, the cell tiles and the kept close-up
+    // geometry, and the tissue map with its resident tiles
+    size_t GetVertexMemoryUsage() const { return polygons_.GetVertexMemoryUsage(); }
+    size_t GetTriangleMemoryUsage() const { return polygons_.GetTriangleMemoryUsage(); }
+    size_t GetIndexMemoryUsage() const;
+    size_t GetDensityMemoryUsage() const;
+    size_t GetTileMemoryUsage() const { return tileLayer_->GetMemoryUsage(); }
+    size_t TrimTiles(size_t bytes) { return tileLayer_->Trim(bytes); }
+    size_t GetGeometryMemoryUsage() const { return geometry_.GetMemoryUsage(); }
+    size_t GetTissueMemoryUsage() const { return tissueLayer_->GetMemoryUsage(); }
+
 private:
     SDL_Renderer* renderer_;
-    std::vector<Polygon> polygons_;
+    FrameProfiler* profiler_ = nullptr;
+    PolygonStore polygons_;
     std::unique_ptr<PolygonIndex> spatialIndex_;
+    CellStatsPyramid cellStats_;  // Built when a load completes
+    std::unique_ptr<PolygonLoadTask> loadTask_;  // Streaming load, if any
     std::map<int, SDL_Color> classColors_;
     std::map<int, std::string> classNames_;  // Map of class ID to class name
     std::vector<int> classIds_;  // Ordered list of class IDs
+    ClassVisibility classVisibility_;
+    float minConfidence_ = 0.0f;
+    bool outlineMode_ = false;
+    std::map<int, float> outlineWidths_;  // Classes without one: DEFAULT_OUTLINE_WIDTH
     bool visible_;
     float opacity_;
+    uint64_t revision_ = 0;
     double slideWidth_;
     double slideHeight_;
 
-    // Phase 1: LOD configuration
-    double minScreenSizePixels_ = 2.0;  // Skip polygons smaller than this
+    PolygonPicker picker_;
+
+    // Per-frame buffers, kept to reuse their capacity; shared with the
+    // layers created from this one
+    std::shared_ptr<RenderScratch> scratch_;
+
+    // Density layer drawn instead of cells when zoomed out: built lazily
+    // once a load completes, one texture per level (null if too large for
+    // the renderer)
+    PolygonDensity density_;
+    std::vector<SDL_Texture*> densityTextures_;
+    bool densityDirty_ = false;
+    double densityBinScreenPixels_ = 2.0;  // Draw density once a finest bin covers at most this
+
+    // Cells rasterized into tiles on worker threads, drawn instead of
+    // geometry from the density layer up to tileMaxZoom_. Bound to the
+    // store and index once a load completes, reset before either changes;
+    // declared after them so its workers stop first.
+    std::unique_ptr<PolygonTileLayer> tileLayer_;
+    double tileMaxZoom_ = 1.0;
+
+    // Tissue labels under the cells, at every zoom
+    std::unique_ptr<TissueLayer> tissueLayer_;
+    bool tissueVisible_ = true;
+    float tissueOpacity_ = 0.35f;
+
+    // Closer in, once loaded: triangles kept per chunk across frames
+    PolygonGeometryCache geometry_;
+    std::vector<uint32_t> visibleChunks_;
+
+    // Screen positions of a visible chunk and the view and geometry they
+    // were mapped under: reused while none of them change, e.g. while
+    // tiles stream in under a still view. In outline mode, the edge quads
+    // expanded from them, and the style they were colored with.
+    struct ScreenChunk {
+        uint32_t chunk = 0;
+        double zoom = 0.0;
+        double positionX = 0.0;
+        double positionY = 0.0;
+        uint64_t geometryVersion = 0;
+        std::vector<float> positions;
+        uint64_t outlineStyle = 0;
+        GeometryBatch outlines;
+    };
+    std::vector<ScreenChunk> screenChunks_;  // Parallel to visibleChunks_
+    std::vector<ScreenChunk> previousScreenChunks_;
 
     // Phase 2: LOD thresholds (configurable)
-    double lodPointThreshold_ = 4.0;
-    double lodBoxThreshold_ = 10.0;
-    double lodSimplifiedThreshold_ = 30.0;
+    PolygonLod lod_;
 
     // Rendering helpers
-    void RenderPolygonBatch(const std::vector<Polygon*>& batch,
+    void RenderPolygonBatch(const uint32_t* batch, size_t count,
                            int classId,
                            const Viewport& viewport);
 
     // Phase 2: LOD-specific rendering methods
-    LODLevel DeterminePolygonLOD(const Polygon* polygon, const Viewport& viewport) const;
-    void RenderAsPoints(const std::vector<Polygon*>& polygons,
+    LODLevel DeterminePolygonLOD(uint32_t polygon, const Viewport& viewport) const;
+    void RenderAsPoints(const std::vector<uint32_t>& polygons,
                         SDL_Color color, uint8_t alpha, const Viewport& viewport);
-    void RenderAsBoxes(const std::vector<Polygon*>& polygons,
+    void RenderAsBoxes(const std::vector<uint32_t>& polygons,
                        SDL_Color color, uint8_t alpha, const Viewport& viewport);
-    void RenderFull(const std::vector<Polygon*>& polygons,
-                    SDL_Color color, uint8_t alpha, const Viewport& viewport);
+    void RenderFull(const std::vector<uint32_t>& polygons,
+                    SDL_Color color, uint8_t alpha, const Viewport& viewport,
+                    bool simplified = false);
 
     // Initialize default colors
     void InitializeDefaultColors();
 
+    // Write the binary cache of a loaded file in the background, unless a
+    // fresh one exists (see PolygonCache)
+    void StartCacheWrite(const std::string& filepath,
+                         const std::map<int, SDL_Color>& loadedColors,
+                         const std::map<int, std::string>& loadedClassNames);
+
+    // Adopt loaded class tables (defaults if colors are empty)
+    void SetClasses(const std::map<int, SDL_Color>& loadedColors,
+                    const std::map<int, std::string>& loadedClassNames);
+
     // Spatial index maintenance
     void BuildSpatialIndex();
 
-    static constexpr size_t DEFAULT_GRID_SIZE = 100;
+    // Density layer: rebuild and upload, release, draw
+    void BuildDensityTextures();
+    void DestroyDensityTextures();
+    void RenderDensity(const Viewport& viewport);
+
+    // Colors and LOD thresholds for the cell tiles
+    PolygonTileStyle MakeTileStyle() const;
+
+    // Kept geometry: build and transform the visible chunks across threads,
+    // then draw them in order; refill colors after a class color or
+    // opacity change
+    void RenderChunks(const Viewport& viewport);
+    void RestyleGeometry();
+
+    // A chunk's outline quads from its screen positions (worker threads)
+    void BuildChunkOutlines(const PolygonChunkGeometry& geometry, ScreenChunk& screen) const;
 };
@@ -0,0 +1,42 @@
+#include "PolygonPicker.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+
+uint32_t PolygonPicker::Pick(const PolygonStore& polygons, const PolygonIndex* index,
+                             const ClassVisibility& visibility, const Vec2& point, uint64_t revision,
+                             float minConfidence) {
+    if (cached_ && point.x == point_.x && point.y == point_.y && revision == revision_ &&
+        polygons.Size() == polygonCount_) {
+        return picked_;
+    }
+
+    if (index) {
+        index->QueryPoint(point, visibility, candidates_);
+    } else {
+        candidates_.clear();
+        const Rect region(point.x, point.y, 0.0, 0.0);
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            if (polygons.Intersects(polygon, region) && visibility.IsVisible(polygons.GetClassId(polygon))) {
+                candidates_.push_back(polygon);
+            }
+        }
+    }
+
+    picked_ = NO_POLYGON;
+    for (uint32_t polygon : candidates_) {
+        if (polygons.GetConfidence(polygon) < minConfidence || !polygons.Contains(polygon, point.x, point.y)) {
+            continue;
+        }
+        // Smallest first, then lowest index, whatever order the index reports
+        if (picked_ == NO_POLYGON || polygons.GetArea(polygon) < polygons.GetArea(picked_) ||
+            (polygons.GetArea(polygon) == polygons.GetArea(picked_) && polygon < picked_)) {
+            picked_ = polygon;
+        }
+    }
+
+    cached_ = true;
+    point_ = point;
+    revision_ = revision;
+    polygonCount_ = polygons.Size();
+    return picked_;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Viewport.h"  // For Vec2
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ClassVisibility;
+class PolygonIndex;
+class PolygonStore;
+
+// The cell under a point, for hover tooltips and click selection.
+//
+// The spatial index narrows millions of cells to the few whose bounding
+// box holds the point, and only those are ray cast against their stored
+// outlines. Where outlines overlap, the smallest cell wins (the one nested
+// inside the other). The last answer is kept: a tooltip asks every frame
+// while the cursor rests, and those frames cost a comparison until the
+// point or the polygons change.
+class PolygonPicker {
+public:
+    /**
+     * Store index of the visible cell under a point, or NO_POLYGON
+     * @param polygons Cells to pick from
+     * @param index Spatial index over polygons, or null to scan them
+     * @param visibility Classes that can be picked
+     * @param point Point in slide coordinates
+     * @param revision Changes whenever polygons, index, visibility or
+     *        minConfidence do (PolygonOverlay::GetRevision); the cached
+     *        answer is kept only while it and the point stay the same
+     * @param minConfidence Less confident cells cannot be picked
+     */
+    uint32_t Pick(const PolygonStore& polygons, const PolygonIndex* index, const ClassVisibility& visibility,
+                  const Vec2& point, uint64_t revision, float minConfidence = 0.0f);
+
+    // Forget the cached answer
+    void Reset() { cached_ = false; }
+
+    static constexpr uint32_t NO_POLYGON = UINT32_MAX;
+
+private:
+    bool cached_ = false;
+    Vec2 point_;
+    uint64_t revision_ = 0;
+    size_t polygonCount_ = 0;  // Streaming loads add cells between revisions
+    uint32_t picked_ = NO_POLYGON;
+
+    std::vector<uint32_t> candidates_;  // Kept to reuse its capacity
+};
@@ -0,0 +1,45 @@
+#include "PolygonQuery.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+
+PolygonQuery::Page PolygonQuery::Run(const PolygonStore& polygons, const PolygonIndex* index) const {
+    std::vector<uint32_t> candidates;
+    if (index) {
+        // In the index's spatial order; pages follow store order
+        index->QueryRegion(region, candidates);
+        std::sort(candidates.begin(), candidates.end());
+    } else {
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            if (polygons.Intersects(polygon, region)) {
+                candidates.push_back(polygon);
+            }
+        }
+    }
+
+    std::vector<int> wanted = classes;
+    std::sort(wanted.begin(), wanted.end());
+    auto matches = [&](uint32_t polygon) {
+        return polygons.GetConfidence(polygon) >= minConfidence &&
+               (wanted.empty() || std::binary_search(wanted.begin(), wanted.end(), polygons.GetClassId(polygon)));
+    };
+
+    Page page;
+    const size_t pageSize = std::min(std::max<size_t>(limit, 1), MAX_LIMIT);
+    for (uint32_t polygon : candidates) {
+        if (!matches(polygon)) {
+            continue;
+        }
+        ++page.total;
+        if (polygon < cursor) {
+            continue;
+        }
+        if (page.polygons.size() < pageSize) {
+            page.polygons.push_back(polygon);
+        } else if (page.done) {
+            page.done = false;
+            page.nextCursor = page.polygons.back() + 1;
+        }
+    }
+    return page;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Viewport.h"  // For Rect
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PolygonIndex;
+class PolygonStore;
+
+// One page of the cells in a region, for polygons.query.
+//
+// Matches are the polygons whose bounding box meets the region, of the
+// requested classes and at least the minimum confidence, in store index
+// order. That order is stable while the store is, so a page is resumed
+// from a cursor (the store index after the previous page's last match)
+// without the server keeping any state between pages, and every page
+// costs one index query whatever the page number.
+struct PolygonQuery {
+    Rect region;
+    std::vector<int> classes;  // Empty: every class
+    float minConfidence = 0.0f;
+    uint32_t cursor = 0;       // First store index to consider
+    size_t limit = DEFAULT_LIMIT;
+
+    struct Page {
+        std::vector<uint32_t> polygons;  // Store indices, ascending
+        size_t total = 0;                // Matches in the whole region, before the cursor too
+        bool done = true;                // No matches past this page
+        uint32_t nextCursor = 0;         // Cursor of the next page, if not done
+    };
+
+    /**
+     * Run the query
+     * @param index Spatial index over polygons, or null to scan them
+     */
+    Page Run(const PolygonStore& polygons, const PolygonIndex* index) const;
+
+    static constexpr size_t DEFAULT_LIMIT = 1000;
+    static constexpr size_t MAX_LIMIT = 50000;
+};
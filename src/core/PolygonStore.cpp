@@ -0,0 +1,309 @@
+#include "PolygonStore.h"
+#include "PolygonTriangulator.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+void PolygonStore::Reserve(size_t polygonCount, size_t vertexCount) {
+    vertices_.reserve(vertexCount);
+    vertexOffsets_.reserve(polygonCount);
+    vertexCounts_.reserve(polygonCount);
+    classIds_.reserve(polygonCount);
+    minX_.reserve(polygonCount);
+    minY_.reserve(polygonCount);
+    maxX_.reserve(polygonCount);
+    maxY_.reserve(polygonCount);
+    centroidX_.reserve(polygonCount);
+    centroidY_.reserve(polygonCount);
+    confidence_.reserve(polygonCount);
+    area_.reserve(polygonCount);
+    triangleOffsets_.reserve(polygonCount);
+    triangleCounts_.reserve(polygonCount);
+    simplifiedOffsets_.reserve(polygonCount);
+    simplifiedCounts_.reserve(polygonCount);
+}
+
+uint32_t PolygonStore::Add(int classId, const Vec2* vertices, size_t vertexCount) {
+    BeginPolygon(classId);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        AddVertex(vertices[i].x, vertices[i].y);
+    }
+    return EndPolygon();
+}
+
+void PolygonStore::BeginPolygon(int classId) {
+    pendingClassId_ = classId;
+    pendingOffset_ = static_cast<uint32_t>(vertices_.size());
+}
+
+void PolygonStore::AddVertex(double x, double y) {
+    vertices_.push_back({static_cast<float>(x), static_cast<float>(y)});
+}
+
+uint32_t PolygonStore::EndPolygon() {
+    const uint32_t count = static_cast<uint32_t>(vertices_.size()) - pendingOffset_;
+
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+    double sumX = 0.0, sumY = 0.0;
+    double area = 0.0;  // Shoelace sum, twice the signed area
+    if (count > 0) {
+        const Vec2f* v = vertices_.data() + pendingOffset_;
+        minX = maxX = v[0].x;
+        minY = maxY = v[0].y;
+        for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+            minX = std::min(minX, v[i].x);
+            maxX = std::max(maxX, v[i].x);
+            minY = std::min(minY, v[i].y);
+            maxY = std::max(maxY, v[i].y);
+            sumX += v[i].x;
+            sumY += v[i].y;
+            area += double(v[j].x) * v[i].y - double(v[i].x) * v[j].y;
+        }
+        sumX /= count;
+        sumY /= count;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(classIds_.size());
+    vertexOffsets_.push_back(pendingOffset_);
+    vertexCounts_.push_back(count);
+    classIds_.push_back(pendingClassId_);
+    minX_.push_back(minX);
+    minY_.push_back(minY);
+    maxX_.push_back(maxX);
+    maxY_.push_back(maxY);
+    centroidX_.push_back(static_cast<float>(sumX));
+    centroidY_.push_back(static_cast<float>(sumY));
+    confidence_.push_back(1.0f);
+    area_.push_back(static_cast<float>(std::abs(area) / 2.0));
+    triangleOffsets_.push_back(0);
+    triangleCounts_.push_back(NOT_TRIANGULATED);
+    simplifiedOffsets_.push_back(0);
+    simplifiedCounts_.push_back(0);
+    return index;
+}
+
+void PolygonStore::SetCentroid(uint32_t index, double x, double y) {
+    if (vertexCounts_[index] > 0 && x >= minX_[index] && x <= maxX_[index] && y >= minY_[index] &&
+        y <= maxY_[index]) {
+        centroidX_[index] = static_cast<float>(x);
+        centroidY_[index] = static_cast<float>(y);
+    }
+}
+
+bool PolygonStore::Contains(uint32_t index, double x, double y) const {
+    const uint32_t count = vertexCounts_[index];
+    if (count < 3 || x < minX_[index] || x > maxX_[index] || y < minY_[index] || y > maxY_[index]) {
+        return false;
+    }
+    const Vec2f* vertices = vertices_.data() + vertexOffsets_[index];
+    bool inside = false;
+    for (uint32_t i = 0, j = count - 1; i < count; j = i++) {
+        const double xi = vertices[i].x, yi = vertices[i].y;
+        const double xj = vertices[j].x, yj = vertices[j].y;
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+void PolygonStore::Append(const PolygonStore& other) {
+    const uint32_t vertexBase = static_cast<uint32_t>(vertices_.size());
+    vertices_.insert(vertices_.end(), other.vertices_.begin(), other.vertices_.end());
+    for (uint32_t offset : other.vertexOffsets_) {
+        vertexOffsets_.push_back(vertexBase + offset);
+    }
+    vertexCounts_.insert(vertexCounts_.end(), other.vertexCounts_.begin(), other.vertexCounts_.end());
+    classIds_.insert(classIds_.end(), other.classIds_.begin(), other.classIds_.end());
+    minX_.insert(minX_.end(), other.minX_.begin(), other.minX_.end());
+    minY_.insert(minY_.end(), other.minY_.begin(), other.minY_.end());
+    maxX_.insert(maxX_.end(), other.maxX_.begin(), other.maxX_.end());
+    maxY_.insert(maxY_.end(), other.maxY_.begin(), other.maxY_.end());
+    centroidX_.insert(centroidX_.end(), other.centroidX_.begin(), other.centroidX_.end());
+    centroidY_.insert(centroidY_.end(), other.centroidY_.begin(), other.centroidY_.end());
+    confidence_.insert(confidence_.end(), other.confidence_.begin(), other.confidence_.end());
+    area_.insert(area_.end(), other.area_.begin(), other.area_.end());
+
+    const uint32_t triangleBase = static_cast<uint32_t>(triangles_.size());
+    triangles_.insert(triangles_.end(), other.triangles_.begin(), other.triangles_.end());
+    for (size_t polygon = 0; polygon < other.Size(); ++polygon) {
+        triangleOffsets_.push_back(triangleBase + other.triangleOffsets_[polygon]);
+        simplifiedOffsets_.push_back(triangleBase + other.simplifiedOffsets_[polygon]);
+    }
+    triangleCounts_.insert(triangleCounts_.end(), other.triangleCounts_.begin(), other.triangleCounts_.end());
+    simplifiedCounts_.insert(simplifiedCounts_.end(), other.simplifiedCounts_.begin(),
+                             other.simplifiedCounts_.end());
+}
+
+void PolygonStore::RemapClassIds(const std::vector<int>& classIds) {
+    for (int32_t& classId : classIds_) {
+        classId = classIds[classId];
+    }
+}
+
+void PolygonStore::Clear() {
+    vertices_.clear();
+    vertexOffsets_.clear();
+    vertexCounts_.clear();
+    classIds_.clear();
+    minX_.clear();
+    minY_.clear();
+    maxX_.clear();
+    maxY_.clear();
+    centroidX_.clear();
+    centroidY_.clear();
+    confidence_.clear();
+    area_.clear();
+    triangles_.clear();
+    triangleOffsets_.clear();
+    triangleCounts_.clear();
+    simplifiedOffsets_.clear();
+    simplifiedCounts_.clear();
+}
+
+void PolygonStore::ShrinkToFit() {
+    vertices_.shrink_to_fit();
+    vertexOffsets_.shrink_to_fit();
+    vertexCounts_.shrink_to_fit();
+    classIds_.shrink_to_fit();
+    minX_.shrink_to_fit();
+    minY_.shrink_to_fit();
+    maxX_.shrink_to_fit();
+    maxY_.shrink_to_fit();
+    centroidX_.shrink_to_fit();
+    centroidY_.shrink_to_fit();
+    confidence_.shrink_to_fit();
+    area_.shrink_to_fit();
+    triangleOffsets_.shrink_to_fit();
+    triangleCounts_.shrink_to_fit();
+    simplifiedOffsets_.shrink_to_fit();
+    simplifiedCounts_.shrink_to_fit();
+}
+
+PolygonStore::TriangleRanges PolygonStore::Triangulate(uint32_t index, TriangulateScratch& scratch,
+                                                       std::vector<uint32_t>& triangles) const {
+    const Vec2f* v = GetVertices(index);
+    const uint32_t vertexCount = vertexCounts_[index];
+    scratch.outline.clear();
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        scratch.outline.emplace_back(v[i].x, v[i].y);
+    }
+
+    std::vector<int> indices = PolygonTriangulator::Triangulate(scratch.outline);
+    TriangleRanges ranges;
+    ranges.offset = static_cast<uint32_t>(triangles.size());
+    ranges.count = static_cast<uint32_t>(indices.size());
+    triangles.insert(triangles.end(), indices.begin(), indices.end());
+
+    // The simplified list shares the full one unless vertices can go
+    ranges.simplifiedOffset = ranges.offset;
+    ranges.simplifiedCount = ranges.count;
+    if (vertexCount <= 4 || indices.empty()) {
+        return ranges;
+    }
+    const double extent = std::max(maxX_[index] - minX_[index], maxY_[index] - minY_[index]);
+    PolygonTriangulator::Simplify(scratch.outline, extent * SIMPLIFY_TOLERANCE, scratch.kept);
+    if (scratch.kept.size() < 3 || scratch.kept.size() == vertexCount) {
+        return ranges;
+    }
+
+    scratch.simplified.clear();
+    for (uint32_t vertex : scratch.kept) {
+        scratch.simplified.push_back(scratch.outline[vertex]);
+    }
+    std::vector<int> simplified = PolygonTriangulator::Triangulate(scratch.simplified);
+    if (simplified.empty()) {
+        return ranges;
+    }
+    ranges.simplifiedOffset = static_cast<uint32_t>(triangles.size());
+    ranges.simplifiedCount = static_cast<uint32_t>(simplified.size());
+    for (int vertex : simplified) {
+        triangles.push_back(scratch.kept[vertex]);
+    }
+    return ranges;
+}
+
+void PolygonStore::TriangulateAll(size_t threadCount) {
+    std::vector<uint32_t> pending;
+    for (uint32_t polygon = 0; polygon < classIds_.size(); ++polygon) {
+        if (triangleCounts_[polygon] == NOT_TRIANGULATED) {
+            pending.push_back(polygon);
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // Workers take blocks in turn, each triangulated into a buffer of its
+    // own; appending the buffers in block order keeps the result
+    // independent of the thread count
+    struct Block {
+        std::vector<uint32_t> triangles;
+        std::vector<TriangleRanges> ranges;
+    };
+    const size_t blockCount = (pending.size() + TRIANGULATE_BLOCK_SIZE - 1) / TRIANGULATE_BLOCK_SIZE;
+    std::vector<Block> blocks(blockCount);
+    std::atomic<size_t> nextBlock{0};
+    auto work = [&]() {
+        TriangulateScratch scratch;
+        for (size_t b = nextBlock++; b < blockCount; b = nextBlock++) {
+            const size_t end = std::min(pending.size(), (b + 1) * TRIANGULATE_BLOCK_SIZE);
+            for (size_t i = b * TRIANGULATE_BLOCK_SIZE; i < end; ++i) {
+                blocks[b].ranges.push_back(Triangulate(pending[i], scratch, blocks[b].triangles));
+            }
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min(threadCount, blockCount);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threadCount; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t triangleCount = triangles_.size();
+    for (const Block& block : blocks) {
+        triangleCount += block.triangles.size();
+    }
+    triangles_.reserve(triangleCount);
+    size_t i = 0;
+    for (const Block& block : blocks) {
+        const uint32_t base = static_cast<uint32_t>(triangles_.size());
+        triangles_.insert(triangles_.end(), block.triangles.begin(), block.triangles.end());
+        for (const TriangleRanges& ranges : block.ranges) {
+            const uint32_t polygon = pending[i++];
+            triangleOffsets_[polygon] = base + ranges.offset;
+            triangleCounts_[polygon] = ranges.count;
+            simplifiedOffsets_[polygon] = base + ranges.simplifiedOffset;
+            simplifiedCounts_[polygon] = ranges.simplifiedCount;
+        }
+    }
+}
+
+const uint32_t* PolygonStore::GetTriangles(uint32_t index, uint32_t& count) const {
+    count = triangleCounts_[index] == NOT_TRIANGULATED ? 0 : triangleCounts_[index];
+    return triangles_.data() + triangleOffsets_[index];
+}
+
+const uint32_t* PolygonStore::GetSimplifiedTriangles(uint32_t index, uint32_t& count) const {
+    count = simplifiedCounts_[index];
+    return triangles_.data() + simplifiedOffsets_[index];
+}
+
+size_t PolygonStore::GetVertexMemoryUsage() const {
+    return vertices_.capacity() * sizeof(Vec2f) +
+           (vertexOffsets_.capacity() + vertexCounts_.capacity() +
+            triangleOffsets_.capacity() + triangleCounts_.capacity() +
+            simplifiedOffsets_.capacity() + simplifiedCounts_.capacity()) * sizeof(uint32_t) +
+           classIds_.capacity() * sizeof(int32_t) +
+           (minX_.capacity() + minY_.capacity() + maxX_.capacity() + maxY_.capacity() +
+            centroidX_.capacity() + centroidY_.capacity() + confidence_.capacity() + area_.capacity()) *
+               sizeof(float);
+}
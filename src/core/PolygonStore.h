@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Viewport.h"  // For Vec2 and Rect
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vertex as stored: float is ~1/64 pixel at 200k pixel slide coordinates,
+// far below what a cell outline needs
+struct Vec2f {
+    float x, y;
+};
+
+// Which polygon classes are shown: every class unless hidden
+class ClassVisibility {
+public:
+    void SetVisible(int classId, bool visible) {
+        auto it = std::lower_bound(hidden_.begin(), hidden_.end(), classId);
+        const bool hidden = it != hidden_.end() && *it == classId;
+        if (visible && hidden) {
+            hidden_.erase(it);
+        } else if (!visible && !hidden) {
+            hidden_.insert(it, classId);
+        }
+    }
+    bool IsVisible(int classId) const {
+        return hidden_.empty() || !std::binary_search(hidden_.begin(), hidden_.end(), classId);
+    }
+    bool AllVisible() const { return hidden_.empty(); }
+
+private:
+    std::vector<int> hidden_;  // Ascending
+};
+
+// Packed storage for the cell polygons of a slide (millions of them).
+//
+// All vertices live in one contiguous float buffer; a polygon is an index
+// into structure-of-arrays columns holding its vertex offset / count,
+// class and bounding box. Triangulations are computed once loading is done
+// (TriangulateAll, in parallel) into one shared index buffer, so drawing
+// never triangulates. A loaded slide thus costs a handful of allocations
+// instead of three per polygon, and culling loops walk the bounding box
+// columns without touching vertices.
+//
+// Each polygon is triangulated twice at once: its full outline and the
+// Douglas-Peucker simplification of it that mid-zoom LODs draw. Both
+// triangle lists index the polygon's own vertices and share one buffer.
+//
+// Const access is thread-safe; filling the store is not.
+class PolygonStore {
+public:
+    PolygonStore() = default;
+
+    // Reserve room for polygonCount polygons of vertexCount vertices total
+    void Reserve(size_t polygonCount, size_t vertexCount);
+
+    // Append a polygon; returns its index
+    uint32_t Add(int classId, const Vec2* vertices, size_t vertexCount);
+    uint32_t Add(int classId, const std::vector<Vec2>& vertices) {
+        return Add(classId, vertices.data(), vertices.size());
+    }
+
+    // Streaming form of Add() for loaders: BeginPolygon, AddVertex for
+    // each vertex, then EndPolygon (returns the index)
+    void BeginPolygon(int classId);
+    void AddVertex(double x, double y);
+    uint32_t EndPolygon();
+
+    // Attributes a loader reads with a polygon instead of deriving them.
+    // A centroid outside the polygon's box is ignored (the vertex mean
+    // stays); confidence is 1 unless set.
+    void SetCentroid(uint32_t index, double x, double y);
+    void SetConfidence(uint32_t index, float confidence) { confidence_[index] = confidence; }
+
+    // Append every polygon of other, in order, with its triangulations
+    void Append(const PolygonStore& other);
+
+    // Replace every class ID c with classIds[c], for loaders that number
+    // classes provisionally while converting (IDs must index classIds)
+    void RemapClassIds(const std::vector<int>& classIds);
+
+    void Clear();
+
+    // Release spare capacity once loading is done
+    void ShrinkToFit();
+
+    size_t Size() const { return classIds_.size(); }
+    bool Empty() const { return classIds_.empty(); }
+    size_t GetTotalVertexCount() const { return vertices_.size(); }
+
+    int GetClassId(uint32_t index) const { return classIds_[index]; }
+    uint32_t GetVertexCount(uint32_t index) const { return vertexCounts_[index]; }
+    const Vec2f* GetVertices(uint32_t index) const { return vertices_.data() + vertexOffsets_[index]; }
+
+    // Axis-aligned bounds (all zero for a polygon without vertices)
+    float GetMinX(uint32_t index) const { return minX_[index]; }
+    float GetMinY(uint32_t index) const { return minY_[index]; }
+    float GetMaxX(uint32_t index) const { return maxX_[index]; }
+    float GetMaxY(uint32_t index) const { return maxY_[index]; }
+    Rect GetBoundingBox(uint32_t index) const {
+        return Rect(minX_[index], minY_[index], maxX_[index] - minX_[index], maxY_[index] - minY_[index]);
+    }
+    bool Intersects(uint32_t index, const Rect& region) const {
+        return !(maxX_[index] < region.x || region.x + region.width < minX_[index] ||
+                 maxY_[index] < region.y || region.y + region.height < minY_[index]);
+    }
+
+    // Whether a point lies inside a polygon's outline (even-odd, either
+    // winding): the box first, then a ray cast over the stored vertices
+    bool Contains(uint32_t index, double x, double y) const;
+
+    // Mean of the vertices, or the loader's centroid, kept with the bounds
+    // (zero without vertices)
+    Vec2 GetCentroid(uint32_t index) const { return Vec2(centroidX_[index], centroidY_[index]); }
+
+    // Segmentation confidence (1 unless the loader read one) and enclosed
+    // area in level 0 pixels
+    float GetConfidence(uint32_t index) const { return confidence_[index]; }
+    float GetArea(uint32_t index) const { return area_[index]; }
+
+    // Triangulate every polygon that is not yet on threadCount threads
+    // (0: one per core). The result does not depend on the thread count.
+    void TriangulateAll(size_t threadCount = 0);
+
+    // Triangle list of a polygon (indices into GetVertices(index), three per
+    // triangle). Sets count to 0 for a polygon that cannot be triangulated
+    // or has not been by TriangulateAll().
+    const uint32_t* GetTriangles(uint32_t index, uint32_t& count) const;
+
+    // Triangle list of the simplified outline: the vertices Douglas-Peucker
+    // keeps at SIMPLIFY_TOLERANCE of the polygon's larger box side (also
+    // indices into GetVertices(index)). The full list when nothing can be
+    // dropped.
+    const uint32_t* GetSimplifiedTriangles(uint32_t index, uint32_t& count) const;
+
+    // Outline error allowed by the simplification, as a fraction of the
+    // box: half a pixel for a polygon drawn 30 pixels wide
+    static constexpr double SIMPLIFY_TOLERANCE = 1.0 / 60.0;
+
+    // Bytes held: vertices with the per-polygon columns, and triangulations
+    size_t GetVertexMemoryUsage() const;
+    size_t GetTriangleMemoryUsage() const { return triangles_.capacity() * sizeof(uint32_t); }
+
+private:
+    friend class PolygonCache;  // Serializes the columns as they are
+
+    static constexpr uint32_t NOT_TRIANGULATED = UINT32_MAX;
+
+    // Polygons handed to a TriangulateAll() worker at a time
+    static constexpr size_t TRIANGULATE_BLOCK_SIZE = 1024;
+
+    std::vector<Vec2f> vertices_;
+    std::vector<uint32_t> vertexOffsets_;
+    std::vector<uint32_t> vertexCounts_;
+    std::vector<int32_t> classIds_;
+    std::vector<float> minX_, minY_, maxX_, maxY_;
+    std::vector<float> centroidX_, centroidY_;
+    std::vector<float> confidence_;
+    std::vector<float> area_;
+
+    std::vector<uint32_t> triangles_;
+    std::vector<uint32_t> triangleOffsets_;
+    std::vector<uint32_t> triangleCounts_;  // NOT_TRIANGULATED until TriangulateAll()
+    std::vector<uint32_t> simplifiedOffsets_;  // Into triangles_, set with the full list
+    std::vector<uint32_t> simplifiedCounts_;
+
+    // Polygon being streamed by BeginPolygon / AddVertex
+    int32_t pendingClassId_ = 0;
+    uint32_t pendingOffset_ = 0;
+
+    // Buffers of one triangulating thread
+    struct TriangulateScratch {
+        std::vector<Vec2> outline;  // Double vertices for PolygonTriangulator
+        std::vector<Vec2> simplified;
+        std::vector<uint32_t> kept;
+    };
+
+    // A polygon's two triangle lists, as offsets into a triangle buffer
+    struct TriangleRanges {
+        uint32_t offset, count;
+        uint32_t simplifiedOffset, simplifiedCount;
+    };
+
+    // Append both triangle lists of a polygon to triangles
+    TriangleRanges Triangulate(uint32_t index, TriangulateScratch& scratch,
+                               std::vector<uint32_t>& triangles) const;
+};
@@ -0,0 +1,489 @@
+#include "PolygonTileLayer.h"
+#include "PolygonIndex.h"
+#include "SdlRenderBackend.h"
+#include "Viewport.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int32_t MAX_LEVEL = 24;
+
+// Pixels whose centers lie in [begin, end), in texels, clipped to the tile
+void CenterSpan(double begin, double end, int32_t& first, int32_t& last) {
+    const double limit = PolygonTileLayer::TILE_SIZE;
+    first = static_cast<int32_t>(std::clamp(std::ceil(begin - 0.5), 0.0, limit));
+    last = static_cast<int32_t>(std::clamp(std::ceil(end - 0.5), 0.0, limit));
+}
+
+double OutlineWidth(const PolygonTileStyle& style, int classId) {
+    auto it = style.outlineWidths.find(classId);
+    return it != style.outlineWidths.end() ? it->second : style.defaultOutlineWidth;
+}
+
+// Even-odd scanline fill sampled at pixel centers, like the GPU's
+// rasterization of the polygon's triangles
+void FillPolygon(const std::vector<double>& xs, const std::vector<double>& ys, uint32_t color,
+                 std::vector<double>& crossings, uint32_t* pixels) {
+    const size_t count = xs.size();
+    const double minY = *std::min_element(ys.begin(), ys.end());
+    const double maxY = *std::max_element(ys.begin(), ys.end());
+    int32_t firstRow, endRow;
+    CenterSpan(minY, maxY, firstRow, endRow);
+
+    for (int32_t row = firstRow; row < endRow; ++row) {
+        const double y = row + 0.5;
+        crossings.clear();
+        for (size_t i = 0, j = count - 1; i < count; j = i++) {
+            if ((ys[i] <= y) != (ys[j] <= y)) {
+                crossings.push_back(xs[i] + (y - ys[i]) * (xs[j] - xs[i]) / (ys[j] - ys[i]));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        uint32_t* line = pixels + static_cast<size_t>(row) * PolygonTileLayer::TILE_SIZE;
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            int32_t first, end;
+            CenterSpan(crossings[k], crossings[k + 1], first, end);
+            std::fill(line + first, line + std::max(first, end), color);
+        }
+    }
+}
+
+// The closed outline, width texels wide: a width-square stamped every half
+// texel along each edge, the texel-grid counterpart of the edge quads
+// PolygonOverlay draws kept geometry's outlines with
+void StrokePolygon(const std::vector<double>& xs, const std::vector<double>& ys, double width, uint32_t color,
+                   uint32_t* pixels) {
+    const size_t count = xs.size();
+    const double half = 0.5 * width;
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        const double dx = xs[i] - xs[j];
+        const double dy = ys[i] - ys[j];
+        const int steps = static_cast<int>(std::ceil(2.0 * std::max(std::abs(dx), std::abs(dy))));
+        for (int step = 0; step <= steps; ++step) {
+            const double t = steps > 0 ? static_cast<double>(step) / steps : 0.0;
+            const double x = xs[j] + dx * t;
+            const double y = ys[j] + dy * t;
+            int32_t firstColumn, endColumn, firstRow, endRow;
+            CenterSpan(x - half, x + half, firstColumn, endColumn);
+            CenterSpan(y - half, y + half, firstRow, endRow);
+            for (int32_t row = firstRow; row < endRow; ++row) {
+                uint32_t* line = pixels + static_cast<size_t>(row) * PolygonTileLayer::TILE_SIZE;
+                std::fill(line + firstColumn, line + std::max(firstColumn, endColumn), color);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+PolygonTileLayer::PolygonTileLayer(SDL_Renderer* renderer, size_t maxMemoryBytes, size_t numThreads)
+    : renderer_(renderer)
+    , textures_(renderer, maxMemoryBytes)
+    , numThreads_(numThreads > 0 ? numThreads : DefaultThreadCount()) {
+}
+
+PolygonTileLayer::~PolygonTileLayer() {
+    StopWorkers();
+}
+
+size_t PolygonTileLayer::DefaultThreadCount() {
+    size_t hardware = std::thread::hardware_concurrency();
+    return std::max<size_t>(1, std::min(MAX_THREADS, hardware / 2));
+}
+
+void PolygonTileLayer::SetPolygons(const PolygonStore* polygons, const PolygonIndex* index) {
+    if (polygons == polygons_ && index == index_) {
+        return;
+    }
+    Reset();
+    polygons_ = polygons;
+    index_ = index;
+    if (polygons_ && index_) {
+        StartWorkers();
+    }
+}
+
+void PolygonTileLayer::Reset() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_.clear();
+        idleCondition_.wait(lock, [this]() { return running_.empty(); });
+        finished_.clear();
+    }
+    polygons_ = nullptr;
+    index_ = nullptr;
+    uploads_.clear();
+    tiles_.clear();
+    textures_.ClearCache();
+}
+
+void PolygonTileLayer::SetStyle(const PolygonTileStyle& style, const std::vector<int>& changedClasses) {
+    style_ = std::make_shared<const PolygonTileStyle>(style);
+    const uint64_t previous = styleVersion_++;
+    if (changedClasses.empty()) {
+        return;
+    }
+
+    // Tiles current before the change and without a changed class stay so
+    std::vector<int> changed = changedClasses;
+    std::sort(changed.begin(), changed.end());
+    for (auto& pair : tiles_) {
+        TileState& state = pair.second;
+        if (state.version != previous) {
+            continue;
+        }
+        bool affected = false;
+        for (int classId : state.classes) {
+            if (std::binary_search(changed.begin(), changed.end(), classId)) {
+                affected = true;
+                break;
+            }
+        }
+        if (!affected) {
+            state.version = styleVersion_;
+        }
+    }
+}
+
+void PolygonTileLayer::SetTileReadyCallback(std::function<void()> onTileReady) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    onTileReady_ = std::move(onTileReady);
+}
+
+bool PolygonTileLayer::IsTileCurrent(const TileKey& key) const {
+    auto it = tiles_.find(key);
+    return it != tiles_.end() && it->second.version == styleVersion_;
+}
+
+int32_t PolygonTileLayer::SelectLevel(double zoom) {
+    if (zoom >= 1.0 || zoom <= 0.0) {
+        return 0;
+    }
+    int32_t level = static_cast<int32_t>(std::floor(std::log2(1.0 / zoom) + 1e-9));
+    return std::min(level, MAX_LEVEL);
+}
+
+void PolygonTileLayer::StartWorkers() {
+    if (!workers_.empty()) {
+        return;
+    }
+    stopping_ = false;
+    for (size_t i = 0; i < numThreads_; ++i) {
+        workers_.emplace_back(&PolygonTileLayer::WorkerLoop, this);
+    }
+}
+
+void PolygonTileLayer::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    workCondition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void PolygonTileLayer::WorkerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workCondition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            running_.insert(job.key);
+        }
+
+        Result result{job.key, job.version, {}, {}, false};
+        result.empty = !RasterizeTile(*polygons_, *index_, *job.style, job.key, result.pixels, result.classes);
+        if (result.empty) {
+            std::vector<uint32_t>().swap(result.pixels);
+        }
+
+        std::function<void()> onTileReady;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(job.key);
+            finished_.push_back(std::move(result));
+            onTileReady = onTileReady_;
+        }
+        idleCondition_.notify_all();
+        if (onTileReady) {
+            onTileReady();
+        }
+    }
+}
+
+bool PolygonTileLayer::RasterizeTile(const PolygonStore& polygons, const PolygonIndex& index,
+                                     const PolygonTileStyle& style, const TileKey& key,
+                                     std::vector<uint32_t>& pixels, std::vector<int>& classes) {
+    pixels.assign(static_cast<size_t>(TILE_SIZE) * TILE_SIZE, 0);
+    classes.clear();
+
+    // Texel (column, row) of the tile samples slide point
+    // ((originX + column + 0.5) * texel, (originY + row + 0.5) * texel)
+    const double texel = static_cast<double>(int64_t(1) << key.level);
+    const double originX = static_cast<double>(key.tileX) * TILE_SIZE;
+    const double originY = static_cast<double>(key.tileY) * TILE_SIZE;
+    const std::vector<uint32_t> candidates =
+        index.QueryRegion(Rect(originX * texel, originY * texel, TILE_SIZE * texel, TILE_SIZE * texel),
+                          style.visibility);
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> crossings;
+    auto markDrawn = [&classes](int classId) {
+        if (classes.empty() || classes.back() != classId) {
+            classes.push_back(classId);
+        }
+    };
+    int lastClassId = 0;
+    uint32_t color = 0;
+    bool haveColor = false;
+    for (uint32_t polygon : candidates) {
+        const double minX = polygons.GetMinX(polygon) / texel - originX;
+        const double minY = polygons.GetMinY(polygon) / texel - originY;
+        const double maxX = polygons.GetMaxX(polygon) / texel - originX;
+        const double maxY = polygons.GetMaxY(polygon) / texel - originY;
+        const double size = std::max(maxX - minX, maxY - minY);
+        if (size < style.minSizePixels || polygons.GetConfidence(polygon) < style.minConfidence) {
+            continue;
+        }
+
+        // Neighbouring polygons mostly share a class
+        const int classId = polygons.GetClassId(polygon);
+        if (!haveColor || classId != lastClassId) {
+            SDL_Color classColor = {128, 128, 128, 255};
+            auto it = style.classColors.find(classId);
+            if (it != style.classColors.end()) {
+                classColor = it->second;
+            } else if (!style.fallbackColors.empty()) {
+                classColor = style.fallbackColors[static_cast<size_t>(std::abs(classId)) % style.fallbackColors.size()];
+            }
+            color = 0xFF000000u | (uint32_t(classColor.r) << 16) | (uint32_t(classColor.g) << 8) | classColor.b;
+            lastClassId = classId;
+            haveColor = true;
+        }
+
+        if (size < style.pointThreshold) {
+            const double column = std::floor((minX + maxX) * 0.5);
+            const double row = std::floor((minY + maxY) * 0.5);
+            if (column >= 0.0 && column < TILE_SIZE && row >= 0.0 && row < TILE_SIZE) {
+                pixels[static_cast<size_t>(row) * TILE_SIZE + static_cast<size_t>(column)] = color;
+                markDrawn(classId);
+            }
+        } else if (size < style.boxThreshold && style.outlines) {
+            xs.assign({minX, maxX, maxX, minX});
+            ys.assign({minY, minY, maxY, maxY});
+            StrokePolygon(xs, ys, OutlineWidth(style, classId), color, pixels.data());
+            markDrawn(classId);
+        } else if (size < style.boxThreshold) {
+            int32_t firstColumn, endColumn, firstRow, endRow;
+            CenterSpan(minX, maxX, firstColumn, endColumn);
+            CenterSpan(minY, maxY, firstRow, endRow);
+            for (int32_t row = firstRow; row < endRow; ++row) {
+                uint32_t* line = pixels.data() + static_cast<size_t>(row) * TILE_SIZE;
+                std::fill(line + firstColumn, line + std::max(firstColumn, endColumn), color);
+            }
+            if (firstColumn < endColumn && firstRow < endRow) {
+                markDrawn(classId);
+            }
+        } else {
+            const uint32_t vertexCount = polygons.GetVertexCount(polygon);
+            if (vertexCount < 3) {
+                continue;
+            }
+            const Vec2f* vertices = polygons.GetVertices(polygon);
+            xs.resize(vertexCount);
+            ys.resize(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; ++i) {
+                xs[i] = vertices[i].x / texel - originX;
+                ys[i] = vertices[i].y / texel - originY;
+            }
+            if (style.outlines) {
+                StrokePolygon(xs, ys, OutlineWidth(style, classId), color, pixels.data());
+            } else {
+                FillPolygon(xs, ys, color, crossings, pixels.data());
+            }
+            markDrawn(classId);
+        }
+    }
+
+    std::sort(classes.begin(), classes.end());
+    classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+    return !classes.empty();
+}
+
+void PolygonTileLayer::CollectResults() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Result& result : finished_) {
+            uploads_.push_back(std::move(result));
+        }
+        finished_.clear();
+    }
+
+    const size_t tileBytes = static_cast<size_t>(TILE_SIZE) * TILE_SIZE * sizeof(uint32_t);
+    size_t kept = 0;
+    for (size_t i = 0; i < uploads_.size(); ++i) {
+        Result& result = uploads_[i];
+
+        // A newer version may have landed first
+        auto it = tiles_.find(result.key);
+        if (it != tiles_.end() && it->second.version > result.version) {
+            continue;
+        }
+
+        if (!result.empty) {
+            if (!textures_.HasUploadBudget(tileBytes)) {
+                if (kept != i) {
+                    uploads_[kept] = std::move(result);
+                }
+                ++kept;
+                continue;
+            }
+            textures_.RemoveTexture(result.key);
+            if (!textures_.GetOrCreateTexture(result.key, result.pixels.data(), TILE_SIZE, TILE_SIZE)) {
+                tiles_.erase(result.key);
+                continue;
+            }
+        } else {
+            textures_.RemoveTexture(result.key);
+        }
+
+        TileState& state = tiles_[result.key];
+        state.version = result.version;
+        state.classes = std::move(result.classes);
+        state.empty = result.empty;
+    }
+    uploads_.erase(uploads_.begin() + static_cast<ptrdiff_t>(kept), uploads_.end());
+}
+
+SDL_Rect PolygonTileLayer::TileScreenRect(const TileKey& key, const Viewport& viewport) const {
+    const double span = static_cast<double>(TILE_SIZE) * static_cast<double>(int64_t(1) << key.level);
+    Vec2 topLeft = viewport.SlideToScreen(Vec2(key.tileX * span, key.tileY * span));
+    Vec2 bottomRight = viewport.SlideToScreen(Vec2((key.tileX + 1) * span, (key.tileY + 1) * span));
+
+    // floor()/ceil() as for slide tiles: overlap by a pixel rather than gap
+    int x0 = static_cast<int>(std::floor(topLeft.x));
+    int y0 = static_cast<int>(std::floor(topLeft.y));
+    int x1 = static_cast<int>(std::ceil(bottomRight.x));
+    int y1 = static_cast<int>(std::ceil(bottomRight.y));
+    return SDL_Rect{x0, y0, x1 - x0, y1 - y0};
+}
+
+bool PolygonTileLayer::DrawTile(const TileKey& key, const SDL_Rect& destination, const SDL_Rect* part) {
+    SDL_Rect source;
+    // textures_ runs on an SdlRenderBackend of its own
+    SDL_Texture* texture = SdlRenderBackend::ToSdl(textures_.GetTexture(key, nullptr, nullptr, &source));
+    if (!texture) {
+        return false;
+    }
+    if (part) {
+        source = {source.x + part->x, source.y + part->y, part->w, part->h};
+    }
+
+    // Premultiplied pixels: opacity scales color and alpha alike
+    SDL_SetTextureColorMod(texture, opacity_, opacity_, opacity_);
+    SDL_SetTextureAlphaMod(texture, opacity_);
+    SDL_RenderCopy(renderer_, texture, &source, &destination);
+    return true;
+}
+
+void PolygonTileLayer::DrawFallback(const TileKey& key, const SDL_Rect& destination) {
+    for (int32_t up = 1; up <= MAX_FALLBACK_LEVELS && key.level + up <= MAX_LEVEL; ++up) {
+        const TileKey parent = {key.level + up, key.tileX >> up, key.tileY >> up};
+        auto it = tiles_.find(parent);
+        if (it == tiles_.end() || it->second.empty) {
+            continue;  // Small cells are skipped at coarse levels: look further
+        }
+        const int32_t span = TILE_SIZE >> up;
+        const int32_t mask = (1 << up) - 1;
+        const SDL_Rect part = {(key.tileX & mask) * span, (key.tileY & mask) * span, span, span};
+        if (DrawTile(parent, destination, &part)) {
+            return;
+        }
+    }
+}
+
+void PolygonTileLayer::Render(const Viewport& viewport, float opacity) {
+    textures_.BeginFrame();
+    opacity_ = static_cast<Uint8>(std::max(0.0f, std::min(1.0f, opacity)) * 255);
+    CollectResults();
+    if (!polygons_ || !index_ || !style_) {
+        return;
+    }
+
+    const int32_t level = SelectLevel(viewport.GetZoom());
+    const double span = static_cast<double>(TILE_SIZE) * static_cast<double>(int64_t(1) << level);
+    const Rect visible = viewport.GetVisibleRegion();
+    if (visible.Right() < 0.0 || visible.Bottom() < 0.0) {
+        return;
+    }
+    const int32_t firstX = static_cast<int32_t>(std::max(0.0, std::floor(visible.x / span)));
+    const int32_t firstY = static_cast<int32_t>(std::max(0.0, std::floor(visible.y / span)));
+    const int32_t lastX = static_cast<int32_t>(std::floor(visible.Right() / span));
+    const int32_t lastY = static_cast<int32_t>(std::floor(visible.Bottom() / span));
+
+    std::vector<TileKey> wanted;
+    for (int32_t tileY = firstY; tileY <= lastY; ++tileY) {
+        for (int32_t tileX = firstX; tileX <= lastX; ++tileX) {
+            const TileKey key = {level, tileX, tileY};
+            const SDL_Rect destination = TileScreenRect(key, viewport);
+
+            // Current or stale, a resident tile is drawn; one whose texture
+            // was evicted is forgotten
+            bool drawn = false;
+            bool current = false;
+            auto it = tiles_.find(key);
+            if (it != tiles_.end()) {
+                drawn = it->second.empty || DrawTile(key, destination, nullptr);
+                current = it->second.version == styleVersion_;
+                if (!drawn) {
+                    tiles_.erase(it);
+                    current = false;
+                }
+            }
+            if (!drawn) {
+                DrawFallback(key, destination);
+            }
+            if (!current) {
+                wanted.push_back(key);
+            }
+        }
+    }
+
+    // Rasterize from the center of the view out
+    const double centerX = (visible.x + visible.width * 0.5) / span - 0.5;
+    const double centerY = (visible.y + visible.height * 0.5) / span - 0.5;
+    std::sort(wanted.begin(), wanted.end(), [centerX, centerY](const TileKey& a, const TileKey& b) {
+        const double da = (a.tileX - centerX) * (a.tileX - centerX) + (a.tileY - centerY) * (a.tileY - centerY);
+        const double db = (b.tileX - centerX) * (b.tileX - centerX) + (b.tileY - centerY) * (b.tileY - centerY);
+        return da < db;
+    });
+
+    auto isReady = [this](const std::vector<Result>& results, const TileKey& key) {
+        return std::any_of(results.begin(), results.end(), [this, &key](const Result& result) {
+            return result.key == key && result.version == styleVersion_;
+        });
+    };
+
+    // The queue only ever holds the tiles this frame still needs
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        for (const TileKey& key : wanted) {
+            if (running_.count(key) == 0 && !isReady(finished_, key) && !isReady(uploads_, key)) {
+                queue_.push_back({key, styleVersion_, style_});
+            }
+        }
+    }
+    workCondition_.notify_all();
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "PolygonStore.h"
+#include "TextureManager.h"
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class PolygonIndex;
+class Viewport;
+
+// How cells are drawn into tiles: class colors and visibility, the
+// confidence threshold, filled or outlined, plus the overlay's LOD
+// thresholds, in texels
+struct PolygonTileStyle {
+    std::map<int, SDL_Color> classColors;
+    ClassVisibility visibility;             // Hidden classes are skipped by the index query
+    float minConfidence = 0.0f;             // Skip cells less confident than this
+    std::vector<SDL_Color> fallbackColors;  // classId % size for classes without a color
+    double minSizePixels = 2.0;             // Skip cells smaller than this
+    double pointThreshold = 4.0;            // Below: one texel
+    double boxThreshold = 10.0;             // Below: bounding box; else the outline
+    bool outlines = false;                  // Stroke boxes and outlines instead of filling them
+    std::map<int, float> outlineWidths;     // Stroke width per class, in texels
+    float defaultOutlineWidth = 1.5f;       // For classes without one
+};
+
+// The polygon overlay rasterized into TILE_SIZE tiles on worker threads and
+// composited like slide tiles, so a still or panning view costs a few
+// texture copies instead of re-transforming every visible vertex.
+//
+// Level L tiles cover TILE_SIZE << L slide pixels at one texel per 2^L. Each
+// tile remembers the style version it was drawn with and the classes in
+// it: a style change only invalidates tiles holding a changed class, and
+// those keep showing until their replacement arrives. Opacity is applied
+// when compositing and never invalidates anything.
+class PolygonTileLayer {
+public:
+    // numThreads = 0 picks DefaultThreadCount(); workers start on the
+    // first SetPolygons()
+    explicit PolygonTileLayer(SDL_Renderer* renderer, size_t maxMemoryBytes = DEFAULT_MAX_MEMORY,
+                              size_t numThreads = 0);
+    ~PolygonTileLayer();
+
+    PolygonTileLayer(const PolygonTileLayer&) = delete;
+    PolygonTileLayer& operator=(const PolygonTileLayer&) = delete;
+
+    // Rasterize from these polygons. Workers read them unlocked, so neither
+    // may change until Reset().
+    void SetPolygons(const PolygonStore* polygons, const PolygonIndex* index);
+    bool HasPolygons() const { return polygons_ != nullptr; }
+
+    // Forget the polygons: drops queued work, waits for running tiles and
+    // releases every tile. Call before the store or index is modified.
+    void Reset();
+
+    // New colors or thresholds. Tiles without a polygon of changedClasses
+    // stay current; an empty list invalidates every tile.
+    void SetStyle(const PolygonTileStyle& style, const std::vector<int>& changedClasses);
+
+    // Runs on a worker thread whenever a tile is finished
+    void SetTileReadyCallback(std::function<void()> onTileReady);
+
+    // Upload finished tiles (within the upload budget), draw the tiles
+    // covering the viewport and queue the missing or outdated ones. Tiles
+    // not ready yet show a stale version or a coarser tile if one is
+    // resident.
+    void Render(const Viewport& viewport, float opacity);
+
+    // Finished tiles waiting for upload budget: another frame is needed
+    bool HasPendingUploads() const { return !uploads_.empty(); }
+
+    // Whether a tile is resident (or known empty) for the current style
+    bool IsTileCurrent(const TileKey& key) const;
+
+    size_t GetMemoryUsage() const { return textures_.GetMemoryUsage(); }
+    size_t Trim(size_t bytes) { return textures_.Trim(bytes); }
+
+    // Finest level whose texels cover at most one screen pixel at this zoom
+    static int32_t SelectLevel(double zoom);
+
+    // Draw the polygons overlapping a tile into pixels (TILE_SIZE^2,
+    // premultiplied TILE_PIXEL_FORMAT), later store indices on top. Fills
+    // classes with the sorted class IDs drawn; returns false if the tile
+    // is empty.
+    static bool RasterizeTile(const PolygonStore& polygons, const PolygonIndex& index,
+                              const PolygonTileStyle& style, const TileKey& key,
+                              std::vector<uint32_t>& pixels, std::vector<int>& classes);
+
+    // Half the hardware threads (the slide's tile workers need the rest),
+    // at least one and at most MAX_THREADS
+    static size_t DefaultThreadCount();
+
+    static constexpr int32_t TILE_SIZE = TextureManager::ATLAS_SLOT_SIZE;
+    static constexpr size_t DEFAULT_MAX_MEMORY = 128 * 1024 * 1024;
+    static constexpr size_t MAX_THREADS = 4;
+    // Coarser levels tried for a tile that is not resident
+    static constexpr int32_t MAX_FALLBACK_LEVELS = 3;
+
+private:
+    struct TileState {
+        uint64_t version = 0;     // Style version the resident tile is current for
+        std::vector<int> classes; // Classes drawn in it
+        bool empty = false;       // Nothing to draw: no texture
+    };
+
+    struct Job {
+        TileKey key;
+        uint64_t version;
+        std::shared_ptr<const PolygonTileStyle> style;
+    };
+
+    struct Result {
+        TileKey key;
+        uint64_t version;
+        std::vector<uint32_t> pixels;
+        std::vector<int> classes;
+        bool empty;
+    };
+
+    void StartWorkers();
+    void StopWorkers();
+    void WorkerLoop();
+
+    // Take finished tiles into tiles_, uploading as the budget allows
+    void CollectResults();
+
+    // Draw a resident tile (or part of it) to a screen rectangle; false if
+    // it has no texture
+    bool DrawTile(const TileKey& key, const SDL_Rect& destination, const SDL_Rect* part);
+
+    // Draw the best coarser resident tile over a missing one
+    void DrawFallback(const TileKey& key, const SDL_Rect& destination);
+
+    SDL_Rect TileScreenRect(const TileKey& key, const Viewport& viewport) const;
+
+    SDL_Renderer* renderer_;
+    TextureManager textures_;
+    size_t numThreads_;
+
+    // Only changed while no tile is queued or running
+    const PolygonStore* polygons_ = nullptr;
+    const PolygonIndex* index_ = nullptr;
+
+    // Render thread only
+    std::shared_ptr<const PolygonTileStyle> style_;
+    uint64_t styleVersion_ = 1;
+    std::unordered_map<TileKey, TileState, TileKeyHash> tiles_;
+    std::vector<Result> uploads_;  // Finished, waiting for upload budget
+    Uint8 opacity_ = 255;  // This frame's
+
+    // Shared with the workers
+    mutable std::mutex mutex_;
+    std::condition_variable workCondition_;
+    std::condition_variable idleCondition_;
+    std::deque<Job> queue_;
+    std::unordered_set<TileKey, TileKeyHash> running_;
+    std::vector<Result> finished_;
+    std::function<void()> onTileReady_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
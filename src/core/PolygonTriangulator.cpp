@@ -1,132 +1,640 @@
 #include "PolygonTriangulator.h"
-#include <cmath>
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
 
-std::vector<int> PolygonTriangulator::Triangulate(const std::vector<Vec2>& vertices) {
-    std::vector<int> triangles;
+namespace {
 
-    if (vertices.size() < 3) {
-        return triangles;  // Not enough vertices
-    }
+// Ring vertex; prev / next walk the ring, prevZ / nextZ the z-order list
+struct Node {
+    Node(int index, double x, double y) : i(index), x(x), y(y) {}
 
-    if (vertices.size() == 3) {
-        // Triangle - already triangulated
-        triangles = {0, 1, 2};
+    int i;
+    double x;
+    double y;
+    Node* prev = nullptr;
+    Node* next = nullptr;
+    int32_t z = -1;
+    Node* prevZ = nullptr;
+    Node* nextZ = nullptr;
+    bool steiner = false;  // A one-vertex hole, kept by FilterPoints
+};
+
+// Twice the signed area of pqr: negative for a convex (ear) corner of the
+// rings as built
+double Area(const Node* p, const Node* q, const Node* r) {
+    return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+bool Equals(const Node* a, const Node* b) {
+    return a->x == b->x && a->y == b->y;
+}
+
+int Sign(double value) {
+    return (value > 0.0) - (value < 0.0);
+}
+
+bool PointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py) {
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+           (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+// q on segment pr, given the three are collinear
+bool OnSegment(const Node* p, const Node* q, const Node* r) {
+    return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) &&
+           q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+}
+
+bool Intersects(const Node* p1, const Node* q1, const Node* p2, const Node* q2) {
+    const int o1 = Sign(Area(p1, q1, p2));
+    const int o2 = Sign(Area(p1, q1, q2));
+    const int o3 = Sign(Area(p2, q2, p1));
+    const int o4 = Sign(Area(p2, q2, q1));
+    if (o1 != o2 && o3 != o4) return true;
+    if (o1 == 0 && OnSegment(p1, p2, q1)) return true;
+    if (o2 == 0 && OnSegment(p1, q2, q1)) return true;
+    if (o3 == 0 && OnSegment(p2, p1, q2)) return true;
+    if (o4 == 0 && OnSegment(p2, q1, q2)) return true;
+    return false;
+}
+
+// Segment ab crosses an edge of a's ring
+bool IntersectsPolygon(const Node* a, const Node* b) {
+    const Node* p = a;
+    do {
+        if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i &&
+            Intersects(p, p->next, a, b)) {
+            return true;
+        }
+        p = p->next;
+    } while (p != a);
+    return false;
+}
+
+// Diagonal ab starts into the polygon's interior at a
+bool LocallyInside(const Node* a, const Node* b) {
+    return Area(a->prev, a, a->next) < 0.0
+        ? Area(a, b, a->next) >= 0.0 && Area(a, a->prev, b) >= 0.0
+        : Area(a, b, a->prev) < 0.0 || Area(a, a->next, b) < 0.0;
+}
+
+// Midpoint of ab inside the polygon (even-odd)
+bool MiddleInside(const Node* a, const Node* b) {
+    const Node* p = a;
+    bool inside = false;
+    const double px = (a->x + b->x) / 2.0;
+    const double py = (a->y + b->y) / 2.0;
+    do {
+        if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+            (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) {
+            inside = !inside;
+        }
+        p = p->next;
+    } while (p != a);
+    return inside;
+}
+
+bool IsValidDiagonal(const Node* a, const Node* b) {
+    return a->next->i != b->i && a->prev->i != b->i && !IntersectsPolygon(a, b) &&
+           ((LocallyInside(a, b) && LocallyInside(b, a) && MiddleInside(a, b) &&
+             (Area(a->prev, a, b->prev) != 0.0 || Area(a, b->prev, b) != 0.0)) ||
+            (Equals(a, b) && Area(a->prev, a, a->next) > 0.0 && Area(b->prev, b, b->next) > 0.0));
+}
+
+void RemoveNode(Node* p) {
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+    if (p->prevZ) p->prevZ->nextZ = p->nextZ;
+    if (p->nextZ) p->nextZ->prevZ = p->prevZ;
+}
+
+Node* GetLeftmost(Node* start) {
+    Node* p = start;
+    Node* leftmost = start;
+    do {
+        if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) {
+            leftmost = p;
+        }
+        p = p->next;
+    } while (p != start);
+    return leftmost;
+}
+
+// Interleave the bits of x and y, scaled to 15 bits each
+int32_t ZOrder(double px, double py, double minX, double minY, double invSize) {
+    uint32_t x = static_cast<uint32_t>((px - minX) * invSize);
+    uint32_t y = static_cast<uint32_t>((py - minY) * invSize);
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    y = (y | (y << 8)) & 0x00FF00FF;
+    y = (y | (y << 4)) & 0x0F0F0F0F;
+    y = (y | (y << 2)) & 0x33333333;
+    y = (y | (y << 1)) & 0x55555555;
+    return static_cast<int32_t>(x | (y << 1));
+}
+
+// One triangulation: owns the ring nodes (a deque, so they never move)
+class Earcut {
+public:
+    std::vector<int> Run(const std::vector<Vec2>& outer, const std::vector<std::vector<Vec2>>& holes) {
+        std::vector<int> triangles;
+        size_t vertexCount = outer.size();
+        for (const auto& hole : holes) {
+            vertexCount += hole.size();
+        }
+        triangles.reserve((vertexCount + 2 * holes.size()) * 3);
+
+        Node* outerNode = LinkedList(outer, 0, true);
+        if (!outerNode || outerNode->next == outerNode->prev) {
+            return triangles;
+        }
+        if (!holes.empty()) {
+            outerNode = EliminateHoles(holes, static_cast<int>(outer.size()), outerNode);
+        }
+
+        // Larger rings get the z-order index, over the outer ring's box
+        if (vertexCount > PolygonTriangulator::HASH_THRESHOLD) {
+            minX_ = maxX_ = outer[0].x;
+            minY_ = maxY_ = outer[0].y;
+            for (const Vec2& v : outer) {
+                minX_ = std::min(minX_, v.x);
+                minY_ = std::min(minY_, v.y);
+                maxX_ = std::max(maxX_, v.x);
+                maxY_ = std::max(maxY_, v.y);
+            }
+            const double size = std::max(maxX_ - minX_, maxY_ - minY_);
+            invSize_ = size != 0.0 ? 32767.0 / size : 0.0;
+        }
+
+        EarcutLinked(outerNode, triangles, 0);
         return triangles;
     }
 
-    // Create list of active vertex indices
-    std::vector<int> indices;
-    indices.reserve(vertices.size());
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        indices.push_back(static_cast<int>(i));
+private:
+    std::deque<Node> nodes_;
+    double minX_ = 0.0, minY_ = 0.0, maxX_ = 0.0, maxY_ = 0.0;
+    double invSize_ = 0.0;  // Non-zero: the z-order index is in use
+
+    Node* InsertNode(int i, const Vec2& v, Node* last) {
+        nodes_.emplace_back(i, v.x, v.y);
+        Node* p = &nodes_.back();
+        if (!last) {
+            p->prev = p;
+            p->next = p;
+        } else {
+            p->next = last->next;
+            p->prev = last;
+            last->next->prev = p;
+            last->next = p;
+        }
+        return p;
     }
 
-    // Ear clipping algorithm
-    int iterations = 0;
-    const int maxIterations = static_cast<int>(vertices.size()) * 2;  // Safety limit
+    // Ring of ring's vertices (numbered from firstIndex), in the winding
+    // the clipper expects of an outer ring (clockwise) or a hole
+    Node* LinkedList(const std::vector<Vec2>& ring, int firstIndex, bool clockwise) {
+        if (ring.empty()) {
+            return nullptr;
+        }
+        double sum = 0.0;
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            sum += (ring[j].x - ring[i].x) * (ring[i].y + ring[j].y);
+        }
 
-    while (indices.size() > 3 && iterations < maxIterations) {
-        bool earFound = false;
+        Node* last = nullptr;
+        const int count = static_cast<int>(ring.size());
+        if (clockwise == (sum > 0.0)) {
+            for (int i = 0; i < count; ++i) {
+                last = InsertNode(firstIndex + i, ring[i], last);
+            }
+        } else {
+            for (int i = count - 1; i >= 0; --i) {
+                last = InsertNode(firstIndex + i, ring[i], last);
+            }
+        }
+        if (last && Equals(last, last->next)) {
+            RemoveNode(last);
+            last = last->next;
+        }
+        return last;
+    }
 
-        for (size_t i = 0; i < indices.size(); ++i) {
-            if (IsEar(vertices, indices, static_cast<int>(i))) {
-                // Found an ear - add triangle and remove the ear vertex
-                int prevIdx = (i == 0) ? static_cast<int>(indices.size() - 1) : static_cast<int>(i - 1);
-                int nextIdx = (i == indices.size() - 1) ? 0 : static_cast<int>(i + 1);
+    // Drop duplicate and collinear vertices between start and end
+    Node* FilterPoints(Node* start, Node* end = nullptr) {
+        if (!start) {
+            return start;
+        }
+        if (!end) {
+            end = start;
+        }
+        Node* p = start;
+        bool again;
+        do {
+            again = false;
+            if (!p->steiner && (Equals(p, p->next) || Area(p->prev, p, p->next) == 0.0)) {
+                RemoveNode(p);
+                p = end = p->prev;
+                if (p == p->next) {
+                    break;
+                }
+                again = true;
+            } else {
+                p = p->next;
+            }
+        } while (again || p != end);
+        return end;
+    }
 
-                triangles.push_back(indices[prevIdx]);
-                triangles.push_back(indices[i]);
-                triangles.push_back(indices[nextIdx]);
+    // Clip ears off the ring. When a full turn finds none: pass 1 filters
+    // the ring, pass 2 cures self-intersections, then the ring is split.
+    void EarcutLinked(Node* ear, std::vector<int>& triangles, int pass) {
+        if (!ear) {
+            return;
+        }
+        if (pass == 0 && invSize_ != 0.0) {
+            IndexCurve(ear);
+        }
 
-                // Remove the ear vertex from active list
-                indices.erase(indices.begin() + i);
+        Node* stop = ear;
+        while (ear->prev != ear->next) {
+            Node* prev = ear->prev;
+            Node* next = ear->next;
+            if (invSize_ != 0.0 ? IsEarHashed(ear) : IsEar(ear)) {
+                triangles.push_back(prev->i);
+                triangles.push_back(ear->i);
+                triangles.push_back(next->i);
+                RemoveNode(ear);
+                ear = next->next;
+                stop = next->next;
+                continue;
+            }
 
-                earFound = true;
+            ear = next;
+            if (ear == stop) {
+                if (pass == 0) {
+                    EarcutLinked(FilterPoints(ear), triangles, 1);
+                } else if (pass == 1) {
+                    ear = CureLocalIntersections(FilterPoints(ear), triangles);
+                    EarcutLinked(ear, triangles, 2);
+                } else {
+                    SplitEarcut(ear, triangles);
+                }
                 break;
             }
         }
+    }
+
+    // Convex corner with no other vertex in its triangle
+    bool IsEar(const Node* ear) const {
+        const Node* a = ear->prev;
+        const Node* b = ear;
+        const Node* c = ear->next;
+        if (Area(a, b, c) >= 0.0) {
+            return false;
+        }
 
-        if (!earFound) {
-            // No ear found - polygon might be degenerate or self-intersecting
-            // Fall back to simple fan triangulation
-            for (size_t i = 1; i + 1 < indices.size(); ++i) {
-                triangles.push_back(indices[0]);
-                triangles.push_back(indices[i]);
-                triangles.push_back(indices[i + 1]);
+        const double x0 = std::min({a->x, b->x, c->x});
+        const double y0 = std::min({a->y, b->y, c->y});
+        const double x1 = std::max({a->x, b->x, c->x});
+        const double y1 = std::max({a->y, b->y, c->y});
+        for (const Node* p = c->next; p != a; p = p->next) {
+            if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+                PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                Area(p->prev, p, p->next) >= 0.0) {
+                return false;
             }
-            break;
         }
+        return true;
+    }
 
-        ++iterations;
+    // IsEar() visiting only vertices whose z-order falls in the triangle's box
+    bool IsEarHashed(const Node* ear) const {
+        const Node* a = ear->prev;
+        const Node* b = ear;
+        const Node* c = ear->next;
+        if (Area(a, b, c) >= 0.0) {
+            return false;
+        }
+
+        const double x0 = std::min({a->x, b->x, c->x});
+        const double y0 = std::min({a->y, b->y, c->y});
+        const double x1 = std::max({a->x, b->x, c->x});
+        const double y1 = std::max({a->y, b->y, c->y});
+        const int32_t minZ = ZOrder(x0, y0, minX_, minY_, invSize_);
+        const int32_t maxZ = ZOrder(x1, y1, minX_, minY_, invSize_);
+
+        auto blocks = [&](const Node* p) {
+            return p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c &&
+                   PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                   Area(p->prev, p, p->next) >= 0.0;
+        };
+
+        // Both directions along the curve at once, then what remains of each
+        const Node* p = ear->prevZ;
+        const Node* n = ear->nextZ;
+        while (p && p->z >= minZ && n && n->z <= maxZ) {
+            if (blocks(p)) return false;
+            p = p->prevZ;
+            if (blocks(n)) return false;
+            n = n->nextZ;
+        }
+        for (; p && p->z >= minZ; p = p->prevZ) {
+            if (blocks(p)) return false;
+        }
+        for (; n && n->z <= maxZ; n = n->nextZ) {
+            if (blocks(n)) return false;
+        }
+        return true;
     }
 
-    // Add final triangle
-    if (indices.size() == 3) {
-        triangles.push_back(indices[0]);
-        triangles.push_back(indices[1]);
-        triangles.push_back(indices[2]);
+    // Clip the triangle around each local self-intersection
+    Node* CureLocalIntersections(Node* start, std::vector<int>& triangles) {
+        Node* p = start;
+        do {
+            Node* a = p->prev;
+            Node* b = p->next->next;
+            if (!Equals(a, b) && Intersects(a, p, p->next, b) && LocallyInside(a, b) && LocallyInside(b, a)) {
+                triangles.push_back(a->i);
+                triangles.push_back(p->i);
+                triangles.push_back(b->i);
+                RemoveNode(p);
+                RemoveNode(p->next);
+                p = start = b;
+            }
+            p = p->next;
+        } while (p != start);
+        return FilterPoints(p);
     }
 
-    return triangles;
-}
+    // Split the ring along a valid diagonal and clip both halves
+    void SplitEarcut(Node* start, std::vector<int>& triangles) {
+        Node* a = start;
+        do {
+            for (Node* b = a->next->next; b != a->prev; b = b->next) {
+                if (a->i != b->i && IsValidDiagonal(a, b)) {
+                    Node* c = SplitPolygon(a, b);
+                    a = FilterPoints(a, a->next);
+                    c = FilterPoints(c, c->next);
+                    EarcutLinked(a, triangles, 0);
+                    EarcutLinked(c, triangles, 0);
+                    return;
+                }
+            }
+            a = a->next;
+        } while (a != start);
+    }
 
-bool PolygonTriangulator::IsEar(const std::vector<Vec2>& vertices,
-                                const std::vector<int>& indices,
-                                int i) {
-    int n = static_cast<int>(indices.size());
-    int prevIdx = (i == 0) ? n - 1 : i - 1;
-    int nextIdx = (i == n - 1) ? 0 : i + 1;
+    // Link a and b with a diagonal. a keeps the ring through b; the
+    // returned copy of b starts the other ring.
+    Node* SplitPolygon(Node* a, Node* b) {
+        nodes_.emplace_back(a->i, a->x, a->y);
+        Node* a2 = &nodes_.back();
+        nodes_.emplace_back(b->i, b->x, b->y);
+        Node* b2 = &nodes_.back();
+        Node* an = a->next;
+        Node* bp = b->prev;
 
-    const Vec2& prev = vertices[indices[prevIdx]];
-    const Vec2& curr = vertices[indices[i]];
-    const Vec2& next = vertices[indices[nextIdx]];
+        a->next = b;
+        b->prev = a;
+        a2->next = an;
+        an->prev = a2;
+        b2->next = a2;
+        a2->prev = b2;
+        bp->next = b2;
+        b2->prev = bp;
+        return b2;
+    }
+
+    // Bridge every hole into the outer ring, leftmost hole first
+    Node* EliminateHoles(const std::vector<std::vector<Vec2>>& holes, int firstIndex, Node* outerNode) {
+        std::vector<Node*> queue;
+        for (const auto& hole : holes) {
+            Node* list = LinkedList(hole, firstIndex, false);
+            firstIndex += static_cast<int>(hole.size());
+            if (!list) {
+                continue;
+            }
+            if (list == list->next) {
+                list->steiner = true;
+            }
+            queue.push_back(GetLeftmost(list));
+        }
+        std::sort(queue.begin(), queue.end(), [](const Node* a, const Node* b) { return a->x < b->x; });
 
-    // Check if triangle is convex
-    if (!IsConvex(prev, curr, next)) {
-        return false;
+        for (Node* hole : queue) {
+            outerNode = EliminateHole(hole, outerNode);
+        }
+        return outerNode;
     }
 
-    // Check if any other vertex is inside this triangle
-    for (int j = 0; j < n; ++j) {
-        if (j == prevIdx || j == i || j == nextIdx) {
-            continue;
+    Node* EliminateHole(Node* hole, Node* outerNode) {
+        Node* bridge = FindHoleBridge(hole, outerNode);
+        if (!bridge) {
+            return outerNode;
         }
+        Node* bridgeReverse = SplitPolygon(bridge, hole);
+        FilterPoints(bridgeReverse, bridgeReverse->next);
+        return FilterPoints(bridge, bridge->next);
+    }
 
-        const Vec2& p = vertices[indices[j]];
-        if (PointInTriangle(p, prev, curr, next)) {
-            return false;
+    // Outer ring vertex visible from the hole's leftmost vertex (David
+    // Eberly's ray cast to the left)
+    Node* FindHoleBridge(Node* hole, Node* outerNode) {
+        Node* p = outerNode;
+        const double hx = hole->x;
+        const double hy = hole->y;
+        double qx = -std::numeric_limits<double>::infinity();
+        Node* m = nullptr;
+
+        // Nearest edge crossed by the ray; m is its endpoint with the lower x
+        do {
+            if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+                const double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+                if (x <= hx && x > qx) {
+                    qx = x;
+                    m = p->x < p->next->x ? p : p->next;
+                    if (x == hx) {
+                        return m;  // The hole touches the outer segment
+                    }
+                }
+            }
+            p = p->next;
+        } while (p != outerNode);
+        if (!m) {
+            return nullptr;
         }
+
+        // A reflex vertex inside the triangle (hole, crossing, m) would block
+        // the bridge; take the one at the smallest angle to the ray instead
+        const Node* stop = m;
+        const double mx = m->x;
+        const double my = m->y;
+        double tanMin = std::numeric_limits<double>::infinity();
+        p = m;
+        do {
+            if (hx >= p->x && p->x >= mx && hx != p->x &&
+                PointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+                const double tan = std::abs(hy - p->y) / (hx - p->x);
+                if (LocallyInside(p, hole) &&
+                    (tan < tanMin || (tan == tanMin && (p->x > m->x || (p->x == m->x && SectorContainsSector(m, p)))))) {
+                    m = p;
+                    tanMin = tan;
+                }
+            }
+            p = p->next;
+        } while (p != stop);
+        return m;
     }
 
-    return true;
-}
+    static bool SectorContainsSector(const Node* m, const Node* p) {
+        return Area(m->prev, m, p->prev) < 0.0 && Area(p->next, m, m->next) < 0.0;
+    }
 
-bool PolygonTriangulator::IsConvex(const Vec2& a, const Vec2& b, const Vec2& c) {
-    // Compute cross product of vectors (b-a) and (c-b)
-    double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
-    return cross > 0;  // Positive cross product means counter-clockwise turn (convex)
-}
+    // Thread the ring onto a z-order sorted list
+    void IndexCurve(Node* start) {
+        Node* p = start;
+        do {
+            if (p->z < 0) {
+                p->z = ZOrder(p->x, p->y, minX_, minY_, invSize_);
+            }
+            p->prevZ = p->prev;
+            p->nextZ = p->next;
+            p = p->next;
+        } while (p != start);
+        p->prevZ->nextZ = nullptr;
+        p->prevZ = nullptr;
+        SortLinked(p);
+    }
 
-bool PolygonTriangulator::PointInTriangle(const Vec2& p,
-                                         const Vec2& a,
-                                         const Vec2& b,
-                                         const Vec2& c) {
-    // Use barycentric coordinates
-    double d1 = SignedArea(p, a, b);
-    double d2 = SignedArea(p, b, c);
-    double d3 = SignedArea(p, c, a);
+    // Bottom-up merge sort of the z list (Simon Tatham's)
+    static Node* SortLinked(Node* list) {
+        int inSize = 1;
+        int numMerges;
+        do {
+            Node* p = list;
+            list = nullptr;
+            Node* tail = nullptr;
+            numMerges = 0;
 
-    bool hasNeg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-    bool hasPos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+            while (p) {
+                ++numMerges;
+                Node* q = p;
+                int pSize = 0;
+                for (int i = 0; i < inSize && q; ++i) {
+                    ++pSize;
+                    q = q->nextZ;
+                }
+                int qSize = inSize;
 
-    return !(hasNeg && hasPos);  // Point is inside if all same sign
+                while (pSize > 0 || (qSize > 0 && q)) {
+                    Node* e;
+                    if (pSize != 0 && (qSize == 0 || !q || p->z <= q->z)) {
+                        e = p;
+                        p = p->nextZ;
+                        --pSize;
+                    } else {
+                        e = q;
+                        q = q->nextZ;
+                        --qSize;
+                    }
+                    if (tail) {
+                        tail->nextZ = e;
+                    } else {
+                        list = e;
+                    }
+                    e->prevZ = tail;
+                    tail = e;
+                }
+                p = q;
+            }
+            tail->nextZ = nullptr;
+            inSize *= 2;
+        } while (numMerges > 1);
+        return list;
+    }
+};
+
+// Distance from p to the segment ab
+double SegmentDistance(const Vec2& p, const Vec2& a, const Vec2& b) {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double lengthSquared = dx * dx + dy * dy;
+    double t = lengthSquared > 0.0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+    return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
 }
 
-double PolygonTriangulator::Cross(const Vec2& a, const Vec2& b) {
-    return a.x * b.y - a.y * b.x;
+}  // namespace
+
+std::vector<int> PolygonTriangulator::Triangulate(const std::vector<Vec2>& vertices) {
+    if (vertices.size() < 3) {
+        return {};  // Not enough vertices
+    }
+    if (vertices.size() == 3) {
+        return {0, 1, 2};  // Triangle - already triangulated
+    }
+    return Earcut().Run(vertices, {});
 }
 
-double PolygonTriangulator::SignedArea(const Vec2& a, const Vec2& b, const Vec2& c) {
-    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+std::vector<int> PolygonTriangulator::Triangulate(const std::vector<Vec2>& outer,
+                                                  const std::vector<std::vector<Vec2>>& holes) {
+    if (outer.size() < 3) {
+        return {};
+    }
+    return Earcut().Run(outer, holes);
+}
+
+void PolygonTriangulator::Simplify(const std::vector<Vec2>& outline, double tolerance,
+                                   std::vector<uint32_t>& kept) {
+    const uint32_t count = static_cast<uint32_t>(outline.size());
+    if (count == 0) {
+        kept.clear();
+        return;
+    }
+    std::vector<char> keep(count, 0);
+    uint32_t farthest = 0;
+    double farthestDistance = -1.0;
+    for (uint32_t i = 1; i < count; ++i) {
+        double distance = std::hypot(outline[i].x - outline[0].x, outline[i].y - outline[0].y);
+        if (distance > farthestDistance) {
+            farthestDistance = distance;
+            farthest = i;
+        }
+    }
+    keep[0] = 1;
+    keep[farthest] = 1;
+
+    // Chains [first, last], where last == count stands for vertex 0
+    std::vector<std::pair<uint32_t, uint32_t>> chains = {{0, farthest}, {farthest, count}};
+    while (!chains.empty()) {
+        const auto chain = chains.back();
+        chains.pop_back();
+        const Vec2& a = outline[chain.first];
+        const Vec2& b = outline[chain.second % count];
+        uint32_t worst = 0;
+        double worstDistance = tolerance;
+        for (uint32_t i = chain.first + 1; i < chain.second; ++i) {
+            double distance = SegmentDistance(outline[i], a, b);
+            if (distance > worstDistance) {
+                worstDistance = distance;
+                worst = i;
+            }
+        }
+        if (worst != 0) {
+            keep[worst] = 1;
+            chains.push_back({chain.first, worst});
+            chains.push_back({worst, chain.second});
+        }
+    }
+
+    kept.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (keep[i]) {
+            kept.push_back(i);
+        }
+    }
 }
@@ -1,11 +1,21 @@
 #pragma once
 
-#include "PolygonOverlay.h"
+#include "Viewport.h"  // For Vec2
+#include <cstdint>
 #include <vector>
 
 /**
- * Polygon triangulation using ear-clipping algorithm
- * Works for simple (non-self-intersecting) polygons
+ * Polygon triangulation by ear clipping (the earcut algorithm)
+ *
+ * Vertices form a doubly linked ring. Rings of more than 80 vertices are
+ * also sorted along a z-order curve, so testing an ear only visits the
+ * vertices near its bounding box instead of the whole ring. This is
+ * O(n log n) in practice for traced annotations with thousands of
+ * vertices; cells of a few dozen vertices take the plain scan. Holes are
+ * bridged into the outer ring before clipping.
+ *
+ * Works for simple polygons. Self-intersecting or degenerate rings are
+ * cured locally or split, so they still yield triangles.
  */
 class PolygonTriangulator {
 public:
@@ -16,52 +26,25 @@ public:
      */
     static std::vector<int> Triangulate(const std::vector<Vec2>& vertices);
 
-private:
     /**
-     * Check if a triangle formed by three consecutive vertices is an "ear"
-     * (i.e., can be safely removed without creating intersections)
-     * @param vertices All polygon vertices
-     * @param indices Current active vertex indices
-     * @param i Index in the indices array to check
-     * @return true if the triangle is an ear
+     * Triangulate a polygon with holes
+     * @param outer Outer ring vertices in order (CCW or CW)
+     * @param holes Hole rings, each in order (either winding)
+     * @return Triangle indices into the outer ring's vertices followed by
+     *         each hole's, in the order given
      */
-    static bool IsEar(const std::vector<Vec2>& vertices,
-                     const std::vector<int>& indices,
-                     int i);
+    static std::vector<int> Triangulate(const std::vector<Vec2>& outer,
+                                        const std::vector<std::vector<Vec2>>& holes);
 
     /**
-     * Check if three points form a convex angle (turn right)
-     * @param a First point
-     * @param b Middle point (vertex of the angle)
-     * @param c Third point
-     * @return true if angle is convex (< 180 degrees)
+     * Douglas-Peucker over a closed outline, split at vertex 0 and the
+     * vertex farthest from it
+     * @param tolerance Farthest a dropped vertex may lie from the
+     *        simplified outline, in the outline's units
+     * @param kept Receives the ascending indices of the vertices that stay
      */
-    static bool IsConvex(const Vec2& a, const Vec2& b, const Vec2& c);
+    static void Simplify(const std::vector<Vec2>& outline, double tolerance, std::vector<uint32_t>& kept);
 
-    /**
-     * Check if a point is inside a triangle
-     * @param p Point to check
-     * @param a Triangle vertex 1
-     * @param b Triangle vertex 2
-     * @param c Triangle vertex 3
-     * @return true if point is inside the triangle
-     */
-    static bool PointInTriangle(const Vec2& p, const Vec2& a, const Vec2& b, const Vec2& c);
-
-    /**
-     * Compute cross product of two 2D vectors
-     * @param a First vector
-     * @param b Second vector
-     * @return Cross product (z-component, since z=0 for 2D vectors)
-     */
-    static double Cross(const Vec2& a, const Vec2& b);
-
-    /**
-     * Calculate signed area of a triangle (half of cross product)
-     * @param a First vertex
-     * @param b Second vertex
-     * @param c Third vertex
-     * @return Signed area (positive if CCW, negative if CW)
-     */
-    static double SignedArea(const Vec2& a, const Vec2& b, const Vec2& c);
+    // Rings with more vertices than this use the z-order index
+    static constexpr size_t HASH_THRESHOLD = 80;
 };
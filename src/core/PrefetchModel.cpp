@@ -0,0 +1,234 @@
+#include "PrefetchModel.h"
+#include "FrameBenchmark.h"  // For FindStops
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+template <size_t N>
+double Sum(const std::array<double, N>& counts) {
+    return std::accumulate(counts.begin(), counts.end(), 0.0);
+}
+
+template <size_t N>
+bool ReadCounts(const nlohmann::json& values, std::array<double, N>& counts) {
+    if (!values.is_array() || values.size() != N) {
+        return false;
+    }
+    for (size_t i = 0; i < N; ++i) {
+        if (!values[i].is_number() || values[i].get<double>() < 0.0) {
+            return false;
+        }
+        counts[i] = values[i].get<double>();
+    }
+    return true;
+}
+
+}  // namespace
+
+size_t PrefetchModel::Octave(double zoom) {
+    if (!(zoom > 0.0)) {
+        return 0;
+    }
+    const long octave = std::lround(std::log2(zoom)) - MIN_OCTAVE;
+    return static_cast<size_t>(std::clamp<long>(octave, 0, static_cast<long>(OCTAVES) - 1));
+}
+
+void PrefetchModel::Learn(const ViewportTrace& trace, double stopHoldMs) {
+    const std::vector<ViewportSample>& samples = trace.GetSamples();
+    const std::vector<bool> isStop = FrameBenchmark::FindStops(trace, stopHoldMs);
+    const ViewportSample* from = nullptr;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!isStop[i]) {
+            continue;
+        }
+        const ViewportSample& to = samples[i];
+        if (from && from->zoom > 0.0 && to.zoom > 0.0) {
+            const double width = from->windowWidth / from->zoom;
+            const double height = from->windowHeight / from->zoom;
+            // The next stop's centre in the view stopped on, 0 to 1 inside it
+            const double toX = (to.x + to.windowWidth / to.zoom / 2 - from->x) / width;
+            const double toY = (to.y + to.windowHeight / to.zoom / 2 - from->y) / height;
+
+            const size_t octave = Octave(from->zoom);
+            const size_t next = Octave(to.zoom);
+            OctaveStats& stats = octaves_[octave];
+            stats.next[next] += 1.0;
+            if (next > octave) {
+                const size_t cellX = static_cast<size_t>(std::clamp(toX * CELLS, 0.0, CELLS - 1.0));
+                const size_t cellY = static_cast<size_t>(std::clamp(toY * CELLS, 0.0, CELLS - 1.0));
+                stats.zoomInCells[cellY * CELLS + cellX] += 1.0;
+            } else if (next == octave) {
+                const double dx = toX - 0.5;
+                const double dy = toY - 0.5;
+                const double length = std::hypot(dx, dy);
+                if (length >= MIN_PAN) {
+                    const long sector = std::lround(std::atan2(dy, dx) / (2 * PI / DIRECTIONS));
+                    stats.panDirections[static_cast<size_t>((sector + DIRECTIONS) % DIRECTIONS)] += 1.0;
+                    stats.panViews += length;
+                }
+            }
+        }
+        from = &to;
+    }
+}
+
+std::vector<PrefetchModel::Prediction> PrefetchModel::Predict(Vec2 center, double zoom, int windowWidth,
+                                                              int windowHeight, size_t maxViews,
+                                                              double minProbability) const {
+    std::vector<Prediction> predictions;
+    if (!(zoom > 0.0) || maxViews == 0) {
+        return predictions;
+    }
+    const size_t octave = Octave(zoom);
+    const OctaveStats& stats = octaves_[octave];
+    const double transitions = Sum(stats.next);
+    if (transitions < MIN_TRANSITIONS) {
+        return predictions;
+    }
+
+    const double width = windowWidth / zoom;
+    const double height = windowHeight / zoom;
+    const double zoomIns = Sum(stats.zoomInCells);
+    const double pans = Sum(stats.panDirections);
+    for (size_t next = 0; next < OCTAVES; ++next) {
+        const double levelProbability = stats.next[next] / transitions;
+        if (levelProbability < minProbability) {
+            continue;
+        }
+        const double nextZoom = zoom * std::exp2(static_cast<double>(next) - static_cast<double>(octave));
+        if (next > octave && zoomIns > 0.0) {
+            for (size_t cell = 0; cell < CELLS * CELLS; ++cell) {
+                const double x = center.x + ((cell % CELLS + 0.5) / CELLS - 0.5) * width;
+                const double y = center.y + ((cell / CELLS + 0.5) / CELLS - 0.5) * height;
+                predictions.push_back({{Vec2(x, y), nextZoom}, levelProbability * stats.zoomInCells[cell] / zoomIns});
+            }
+        } else if (next == octave && pans > 0.0) {
+            // Pans of the mean length, in each direction taken
+            const double length = stats.panViews / pans;
+            for (size_t direction = 0; direction < DIRECTIONS; ++direction) {
+                const double angle = direction * 2 * PI / DIRECTIONS;
+                const Vec2 step(std::cos(angle) * length * width, std::sin(angle) * length * height);
+                predictions.push_back({{center + step, zoom}, levelProbability * stats.panDirections[direction] / pans});
+            }
+        } else if (next < octave) {
+            predictions.push_back({{center, nextZoom}, levelProbability});
+        }
+    }
+
+    std::stable_sort(predictions.begin(), predictions.end(),
+                     [](const Prediction& a, const Prediction& b) { return a.probability > b.probability; });
+    predictions.erase(std::remove_if(predictions.begin(), predictions.end(),
+                                     [minProbability](const Prediction& p) { return p.probability < minProbability; }),
+                      predictions.end());
+    if (predictions.size() > maxViews) {
+        predictions.resize(maxViews);
+    }
+    return predictions;
+}
+
+double PrefetchModel::GetTransitionCount() const {
+    double count = 0.0;
+    for (const OctaveStats& stats : octaves_) {
+        count += Sum(stats.next);
+    }
+    return count;
+}
+
+PrefetchModel::json PrefetchModel::ToJson() const {
+    json next = json::array();
+    json zoomInCells = json::array();
+    json panDirections = json::array();
+    json panViews = json::array();
+    for (const OctaveStats& stats : octaves_) {
+        next.push_back(stats.next);
+        zoomInCells.push_back(stats.zoomInCells);
+        panDirections.push_back(stats.panDirections);
+        panViews.push_back(stats.panViews);
+    }
+    return {
+        {"min_octave", MIN_OCTAVE},
+        {"next", next},
+        {"zoom_in_cells", zoomInCells},
+        {"pan_directions", panDirections},
+        {"pan_views", panViews}
+    };
+}
+
+bool PrefetchModel::FromJson(const json& model) {
+    if (!model.is_object() || model.value("min_octave", 0) != MIN_OCTAVE) {
+        return false;
+    }
+    const json& next = model.value("next", json());
+    const json& zoomInCells = model.value("zoom_in_cells", json());
+    const json& panDirections = model.value("pan_directions", json());
+    std::array<double, OCTAVES> panViews{};
+    if (!next.is_array() || next.size() != OCTAVES || !zoomInCells.is_array() || zoomInCells.size() != OCTAVES ||
+        !panDirections.is_array() || panDirections.size() != OCTAVES ||
+        !ReadCounts(model.value("pan_views", json()), panViews)) {
+        return false;
+    }
+    std::array<OctaveStats, OCTAVES> octaves{};
+    for (size_t i = 0; i < OCTAVES; ++i) {
+        if (!ReadCounts(next[i], octaves[i].next) || !ReadCounts(zoomInCells[i], octaves[i].zoomInCells) ||
+            !ReadCounts(panDirections[i], octaves[i].panDirections)) {
+            return false;
+        }
+        octaves[i].panViews = panViews[i];
+    }
+    octaves_ = octaves;
+    return true;
+}
+
+bool PrefetchModel::Load(const std::string& path, const std::string& slideType) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    const json models = json::parse(file, nullptr, false);
+    if (!models.is_object() || !models.contains("types") || !models["types"].is_object()) {
+        return false;
+    }
+    const json& types = models["types"];
+    for (const std::string& type : {slideType, std::string("default")}) {
+        if (types.contains(type)) {
+            return FromJson(types[type]);
+        }
+    }
+    return false;
+}
+
+bool PrefetchModel::Save(const std::string& path, const std::string& slideType) const {
+    json models = json::object();
+    {
+        std::ifstream existing(path);
+        if (existing) {
+            models = json::parse(existing, nullptr, false);
+            if (!models.is_object()) {
+                models = json::object();
+            }
+        }
+    }
+    if (!models.contains("types") || !models["types"].is_object()) {
+        models["types"] = json::object();
+    }
+    models["types"][slideType] = ToJson();
+
+    std::ofstream file(path);
+    file << models.dump(2) << '\n';
+    return static_cast<bool>(file);
+}
+
+std::string PrefetchModel::SlideType(const std::string& vendor, double objectivePower) {
+    if (vendor.empty()) {
+        return "default";
+    }
+    if (objectivePower <= 0.0) {
+        return vendor;
+    }
+    return vendor + "-" + std::to_string(std::lround(objectivePower)) + "x";
+}
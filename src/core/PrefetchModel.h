@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ViewportPlan.h"  // For ViewportWaypoint
+#include "ViewportTrace.h"
+#include "json.hpp"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Where reviewers go next from a view they stopped on, learned from
+// recorded review sessions (ViewportTrace) of one type of slide, for
+// prefetching the next stop's tiles while the current one is looked at.
+//
+// Velocity extrapolation (SlideRenderer::PrefetchTiles) has nothing to go
+// on once the view stops, yet that is when reviews change level: a
+// low-power sweep, then a zoom into part of the view. The model counts,
+// per zoom octave, the transitions between the stops of a trace (samples
+// held at least stopHoldMs, as FrameBenchmark finds them): which octave
+// the next stop is at, which ninth of the view a zoom-in lands in (the
+// dwell regions), and the direction and length of pans that stay at the
+// same octave. Predict() turns the counts for the current view into the
+// next views most likely to be stopped on.
+//
+// Models are saved per slide type (SlideType(): vendor and objective) in
+// one JSON file; a type without one of its own uses "default".
+class PrefetchModel {
+public:
+    using json = nlohmann::json;
+
+    struct Prediction {
+        ViewportWaypoint view;
+        double probability = 0.0;
+    };
+
+    // Add the stop-to-stop transitions of a recorded session
+    void Learn(const ViewportTrace& trace, double stopHoldMs = DEFAULT_STOP_HOLD_MS);
+
+    /**
+     * Next stops from a view, most likely first
+     * @param center, zoom The view stopped on
+     * @param windowWidth, windowHeight Its size in screen pixels
+     * @param maxViews Predictions returned at most
+     * @param minProbability Less likely ones are left out
+     */
+    std::vector<Prediction> Predict(Vec2 center, double zoom, int windowWidth, int windowHeight,
+                                    size_t maxViews = DEFAULT_MAX_VIEWS,
+                                    double minProbability = DEFAULT_MIN_PROBABILITY) const;
+
+    // Transitions learned; an empty model predicts nothing
+    double GetTransitionCount() const;
+    bool IsEmpty() const { return GetTransitionCount() == 0.0; }
+
+    json ToJson() const;
+    // False (and the model unchanged) on a malformed object
+    bool FromJson(const json& model);
+
+    /**
+     * Read slideType's model from a model file, else its "default" one
+     * @return False if the file has neither
+     */
+    bool Load(const std::string& path, const std::string& slideType);
+    // Write this model as slideType's, keeping the file's other types
+    bool Save(const std::string& path, const std::string& slideType) const;
+
+    // "aperio-40x", "hamamatsu" without an objective, "default" without a vendor
+    static std::string SlideType(const std::string& vendor, double objectivePower);
+
+    // Zoom octave: log2(zoom) rounded, from MIN_OCTAVE, clamped
+    static size_t Octave(double zoom);
+
+    static constexpr int MIN_OCTAVE = -10;  // 1/1024: a whole slide in a window
+    static constexpr size_t OCTAVES = 12;   // Up to 2x
+    static constexpr size_t CELLS = 3;      // Zoom-ins land in one of CELLS x CELLS
+    static constexpr size_t DIRECTIONS = 8;
+    // A pan shorter than this fraction of the view is not a pan
+    static constexpr double MIN_PAN = 0.05;
+    // Transitions from an octave needed before it predicts anything
+    static constexpr double MIN_TRANSITIONS = 5.0;
+
+    static constexpr double DEFAULT_STOP_HOLD_MS = 250.0;
+    static constexpr size_t DEFAULT_MAX_VIEWS = 4;
+    static constexpr double DEFAULT_MIN_PROBABILITY = 0.05;
+
+private:
+    struct OctaveStats {
+        std::array<double, OCTAVES> next{};  // Stops that followed, by octave
+        std::array<double, CELLS * CELLS> zoomInCells{};
+        std::array<double, DIRECTIONS> panDirections{};
+        double panViews = 0.0;  // Summed length of those pans, in view widths / heights
+    };
+
+    std::array<OctaveStats, OCTAVES> octaves_{};
+};
@@ -0,0 +1,111 @@
+#include "PyramidLayout.h"
+#include <algorithm>
+
+namespace {
+
+PyramidLevel HalfOf(const PyramidLevel& finer) {
+    return {finer.downsample * 2.0,
+            {(finer.dimensions.width + 1) / 2, (finer.dimensions.height + 1) / 2},
+            -1, finer.tileWidth, finer.tileHeight};
+}
+
+// Per-channel average of four ARGB words, rounded to nearest
+inline uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    const uint32_t mask = 0x00FF00FF;
+    uint32_t evenLanes = (a & mask) + (b & mask) + (c & mask) + (d & mask);
+    uint32_t oddLanes = ((a >> 8) & mask) + ((b >> 8) & mask) + ((c >> 8) & mask) + ((d >> 8) & mask);
+    evenLanes = ((evenLanes + 0x00020002) >> 2) & mask;
+    oddLanes = ((oddLanes + 0x00020002) >> 2) & mask;
+    return evenLanes | (oddLanes << 8);
+}
+
+}  // namespace
+
+PyramidLayout::PyramidLayout(const std::vector<double>& downsamples, const std::vector<LevelDimensions>& dimensions,
+                             int32_t tileSize, bool synthesize,
+                             const std::vector<LevelDimensions>& nativeTileSizes) {
+    size_t count = std::min(downsamples.size(), dimensions.size());
+    size_t synthesized = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Fill the gap down to this slide level
+        while (synthesize && !levels_.empty() && synthesized < MAX_SYNTHESIZED_LEVELS &&
+               downsamples[i] > levels_.back().downsample * SYNTHESIZE_GAP_RATIO) {
+            levels_.push_back(HalfOf(levels_.back()));
+            synthesized++;
+        }
+        LevelDimensions native = i < nativeTileSizes.size() ? nativeTileSizes[i] : LevelDimensions{0, 0};
+        levels_.push_back({downsamples[i], dimensions[i], static_cast<int32_t>(i),
+                           AlignTileSize(native.width, tileSize), AlignTileSize(native.height, tileSize)});
+    }
+
+    // Continue past the coarsest level until the whole slide is one tile
+    while (synthesize && !levels_.empty() && synthesized < MAX_SYNTHESIZED_LEVELS &&
+           (levels_.back().dimensions.width > levels_.back().tileWidth ||
+            levels_.back().dimensions.height > levels_.back().tileHeight)) {
+        levels_.push_back(HalfOf(levels_.back()));
+        synthesized++;
+    }
+}
+
+PyramidLayout PyramidLayout::FromSlide(const SlideLoader& loader, int32_t tileSize, bool synthesize) {
+    std::vector<double> downsamples;
+    std::vector<LevelDimensions> dimensions;
+    std::vector<LevelDimensions> nativeTileSizes;
+    for (int32_t i = 0; i < loader.GetLevelCount(); ++i) {
+        downsamples.push_back(loader.GetLevelDownsample(i));
+        dimensions.push_back(loader.GetLevelDimensions(i));
+        nativeTileSizes.push_back(loader.GetNativeTileSize(i));
+    }
+    return PyramidLayout(downsamples, dimensions, tileSize, synthesize, nativeTileSizes);
+}
+
+int32_t PyramidLayout::AlignTileSize(int64_t native, int32_t preferred) {
+    if (native <= 0 || native > MAX_TILE_SIZE) {
+        return preferred;
+    }
+    int32_t nativeSize = static_cast<int32_t>(native);
+    int32_t multiple = std::max(1, (preferred + nativeSize / 2) / nativeSize);
+    int32_t size = nativeSize * multiple;
+    if (size % 2 != 0) {
+        size += nativeSize;
+    }
+    return size;
+}
+
+size_t PyramidLayout::GetSynthesizedLevelCount() const {
+    return static_cast<size_t>(std::count_if(levels_.begin(), levels_.end(),
+                                             [](const PyramidLevel& level) { return level.sourceLevel < 0; }));
+}
+
+std::vector<double> PyramidLayout::GetDownsamples() const {
+    std::vector<double> downsamples;
+    downsamples.reserve(levels_.size());
+    for (const auto& level : levels_) {
+        downsamples.push_back(level.downsample);
+    }
+    return downsamples;
+}
+
+void PyramidLayout::Downsample2x(const uint32_t* src, int32_t srcWidth, int32_t srcHeight, size_t srcStride,
+                                 uint32_t* dst, size_t dstStride) {
+    int32_t dstWidth = (srcWidth + 1) / 2;
+    int32_t dstHeight = (srcHeight + 1) / 2;
+    int32_t evenWidth = srcWidth / 2;  // Output columns with two source columns
+
+    for (int32_t y = 0; y < dstHeight; ++y) {
+        const uint32_t* row0 = src + static_cast<size_t>(2 * y) * srcStride;
+        const uint32_t* row1 = (2 * y + 1 < srcHeight) ? row0 + srcStride : row0;
+        uint32_t* out = dst + static_cast<size_t>(y) * dstStride;
+
+        // Branch-free inner loop the compiler can vectorize
+        for (int32_t x = 0; x < evenWidth; ++x) {
+            out[x] = Average4(row0[2 * x], row0[2 * x + 1], row1[2 * x], row1[2 * x + 1]);
+        }
+        if (dstWidth > evenWidth) {
+            uint32_t a = row0[srcWidth - 1];
+            uint32_t b = row1[srcWidth - 1];
+            out[dstWidth - 1] = Average4(a, a, b, b);
+        }
+    }
+}
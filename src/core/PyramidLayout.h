@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SlideLoader.h"  // For LevelDimensions
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// One level of the pyramid the renderer works with
+struct PyramidLevel {
+    double downsample;
+    LevelDimensions dimensions;
+    int32_t sourceLevel;  // Slide level decoded by OpenSlide, or -1 if synthesized
+    int32_t tileWidth;    // Tile grid of this level, in its own pixels
+    int32_t tileHeight;
+};
+
+// The pyramid as seen by the tile pipeline: the slide's own levels plus
+// virtual levels filling gaps wider than 2x (e.g. 1x/4x/16x scans gain
+// 2x and 8x) and continuing below the coarsest level until the slide fits
+// one tile. A synthesized tile is the 2x box-downsample of its 2x2 children
+// on the next finer level, so TileKey::level indexes this layout, not the
+// slide, everywhere past SlideLoader.
+//
+// Each level has its own tile grid: the preferred tile size rounded to a
+// multiple of the slide's native tile size (e.g. 240 -> 480, 2048x8 strips
+// -> 2048x512), so a tile read never straddles native tiles OpenSlide must
+// decode in full. Synthesized levels share the grid of the level they are
+// built from, which keeps their 2x2 children aligned.
+class PyramidLayout {
+public:
+    PyramidLayout() = default;
+
+    // downsamples/dimensions describe the slide's levels (finest first).
+    // With synthesize = false the layout mirrors the slide.
+    // nativeTileSizes gives each slide level's native tile size ({0, 0} or
+    // missing if unknown, which keeps tileSize).
+    PyramidLayout(const std::vector<double>& downsamples, const std::vector<LevelDimensions>& dimensions,
+                  int32_t tileSize, bool synthesize = true,
+                  const std::vector<LevelDimensions>& nativeTileSizes = {});
+
+    static PyramidLayout FromSlide(const SlideLoader& loader, int32_t tileSize, bool synthesize = true);
+
+    int32_t GetLevelCount() const { return static_cast<int32_t>(levels_.size()); }
+    const PyramidLevel& GetLevel(int32_t level) const { return levels_[level]; }
+    double GetLevelDownsample(int32_t level) const { return levels_[level].downsample; }
+    LevelDimensions GetLevelDimensions(int32_t level) const { return levels_[level].dimensions; }
+    bool IsSynthesized(int32_t level) const { return levels_[level].sourceLevel < 0; }
+    int32_t GetTileWidth(int32_t level) const { return levels_[level].tileWidth; }
+    int32_t GetTileHeight(int32_t level) const { return levels_[level].tileHeight; }
+    size_t GetSynthesizedLevelCount() const;
+    std::vector<double> GetDownsamples() const;
+
+    // Halve a premultiplied ARGB image with a 2x2 box filter into
+    // ceil(srcWidth / 2) x ceil(srcHeight / 2) pixels; odd edges repeat
+    // the last row/column. Strides are in pixels. Averages all four
+    // channels at once in two 16-bit lanes per word, exactly rounded.
+    static void Downsample2x(const uint32_t* src, int32_t srcWidth, int32_t srcHeight, size_t srcStride,
+                             uint32_t* dst, size_t dstStride);
+
+    // Tile edge for a level whose native tiles are native pixels wide: the
+    // multiple of native nearest to preferred (rounded up to even, so
+    // synthesized parents split it in half). Unknown (<= 0) or
+    // larger-than-MAX_TILE_SIZE native tiles keep preferred.
+    static int32_t AlignTileSize(int64_t native, int32_t preferred);
+
+    static constexpr int32_t MAX_TILE_SIZE = 2048;
+
+    // Insert 2x levels while the next slide level is more than this much coarser
+    static constexpr double SYNTHESIZE_GAP_RATIO = 3.0;
+    static constexpr size_t MAX_SYNTHESIZED_LEVELS = 8;
+
+private:
+    std::vector<PyramidLevel> levels_;
+};
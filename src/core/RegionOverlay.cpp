@@ -0,0 +1,294 @@
+#include "RegionOverlay.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Pixels whose centers lie in [begin, end), clipped to [0, limit)
+void CenterSpan(double begin, double end, int32_t limit, int32_t& first, int32_t& last) {
+    first = static_cast<int32_t>(std::clamp(std::ceil(begin - 0.5), 0.0, static_cast<double>(limit)));
+    last = static_cast<int32_t>(std::clamp(std::ceil(end - 0.5), 0.0, static_cast<double>(limit)));
+}
+
+// Even-odd scanline fill sampled at pixel centers, as PolygonTileLayer
+// draws its tiles
+void FillPolygon(const std::vector<double>& xs, const std::vector<double>& ys, uint32_t color,
+                 std::vector<double>& crossings, uint32_t* pixels, int32_t width, int32_t height) {
+    const size_t count = xs.size();
+    const double minY = *std::min_element(ys.begin(), ys.end());
+    const double maxY = *std::max_element(ys.begin(), ys.end());
+    int32_t firstRow, endRow;
+    CenterSpan(minY, maxY, height, firstRow, endRow);
+
+    for (int32_t row = firstRow; row < endRow; ++row) {
+        const double y = row + 0.5;
+        crossings.clear();
+        for (size_t i = 0, j = count - 1; i < count; j = i++) {
+            if ((ys[i] <= y) != (ys[j] <= y)) {
+                crossings.push_back(xs[i] + (y - ys[i]) * (xs[j] - xs[i]) / (ys[j] - ys[i]));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        uint32_t* line = pixels + static_cast<size_t>(row) * width;
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            int32_t first, end;
+            CenterSpan(crossings[k], crossings[k + 1], width, first, end);
+            std::fill(line + first, line + std::max(first, end), color);
+        }
+    }
+}
+
+// Blend an opaque layer pixel over a premultiplied one at alpha / 255
+uint32_t Blend(uint32_t source, uint32_t destination, uint32_t alpha) {
+    const uint32_t inverse = 255 - alpha;
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t top = shift == 24 ? 255 : (source >> shift) & 0xFF;
+        const uint32_t bottom = (destination >> shift) & 0xFF;
+        result |= ((top * alpha + bottom * inverse + 127) / 255) << shift;
+    }
+    return result;
+}
+
+}  // namespace
+
+size_t RegionOverlay::AddLayer(float opacity) {
+    Layer layer;
+    layer.opacity = std::clamp(opacity, 0.0f, 1.0f);
+    layers_.push_back(std::move(layer));
+    return layers_.size() - 1;
+}
+
+void RegionOverlay::AddPolygon(size_t layer, const Vec2f* vertices, size_t count, uint32_t color) {
+    if (count < 3) {
+        return;
+    }
+    Shape shape;
+    shape.first = vertices_.size();
+    shape.count = count;
+    shape.color = color;
+    vertices_.insert(vertices_.end(), vertices, vertices + count);
+    AddShape(layer, shape);
+}
+
+void RegionOverlay::AddPolygon(size_t layer, const std::vector<Vec2>& vertices, uint32_t color) {
+    if (vertices.size() < 3) {
+        return;
+    }
+    Shape shape;
+    shape.first = vertices_.size();
+    shape.count = vertices.size();
+    shape.color = color;
+    for (const Vec2& vertex : vertices) {
+        vertices_.push_back({static_cast<float>(vertex.x), static_cast<float>(vertex.y)});
+    }
+    AddShape(layer, shape);
+}
+
+void RegionOverlay::AddOutline(size_t layer, const std::vector<Vec2>& vertices, uint32_t color, float width) {
+    if (vertices.size() < 2 || width <= 0.0f) {
+        return;
+    }
+    Shape shape;
+    shape.first = vertices_.size();
+    shape.count = vertices.size();
+    shape.color = color;
+    shape.width = width;
+    for (const Vec2& vertex : vertices) {
+        vertices_.push_back({static_cast<float>(vertex.x), static_cast<float>(vertex.y)});
+    }
+    AddShape(layer, shape);
+}
+
+void RegionOverlay::AddShape(size_t layer, Shape shape) {
+    if (layer >= layers_.size()) {
+        vertices_.resize(shape.first);
+        return;
+    }
+    const Vec2f* vertices = vertices_.data() + shape.first;
+    shape.minX = shape.maxX = vertices[0].x;
+    shape.minY = shape.maxY = vertices[0].y;
+    for (size_t i = 1; i < shape.count; ++i) {
+        shape.minX = std::min(shape.minX, vertices[i].x);
+        shape.maxX = std::max(shape.maxX, vertices[i].x);
+        shape.minY = std::min(shape.minY, vertices[i].y);
+        shape.maxY = std::max(shape.maxY, vertices[i].y);
+    }
+    Layer& target = layers_[layer];
+    target.shapes.push_back(shape);
+    target.maxWidth = std::max(target.maxWidth, shape.width);
+    target.cellStarts.clear();
+    target.cellShapes.clear();
+    ++shapes_;
+}
+
+void RegionOverlay::BuildIndex(double cellSize) {
+    if (!(cellSize > 0.0)) {
+        return;
+    }
+    for (Layer& layer : layers_) {
+        layer.cellStarts.clear();
+        layer.cellShapes.clear();
+        if (layer.shapes.empty()) {
+            continue;
+        }
+        double minX = layer.shapes[0].minX, minY = layer.shapes[0].minY;
+        double maxX = layer.shapes[0].maxX, maxY = layer.shapes[0].maxY;
+        for (const Shape& shape : layer.shapes) {
+            minX = std::min<double>(minX, shape.minX);
+            minY = std::min<double>(minY, shape.minY);
+            maxX = std::max<double>(maxX, shape.maxX);
+            maxY = std::max<double>(maxY, shape.maxY);
+        }
+        double size = cellSize;
+        auto cellsAlong = [&](double extent) { return static_cast<int64_t>(extent / size) + 1; };
+        while (cellsAlong(maxX - minX) * cellsAlong(maxY - minY) > MAX_INDEX_CELLS) {
+            size *= 2.0;
+        }
+        layer.originX = minX;
+        layer.originY = minY;
+        layer.cellSize = size;
+        layer.across = cellsAlong(maxX - minX);
+        layer.down = cellsAlong(maxY - minY);
+
+        // Count, then fill in shape order, so each cell lists its shapes
+        // in drawing order
+        auto forEachCell = [&layer](const Shape& shape, auto&& visit) {
+            const int64_t firstColumn = static_cast<int64_t>((shape.minX - layer.originX) / layer.cellSize);
+            const int64_t lastColumn = static_cast<int64_t>((shape.maxX - layer.originX) / layer.cellSize);
+            const int64_t firstRow = static_cast<int64_t>((shape.minY - layer.originY) / layer.cellSize);
+            const int64_t lastRow = static_cast<int64_t>((shape.maxY - layer.originY) / layer.cellSize);
+            for (int64_t row = firstRow; row <= std::min(lastRow, layer.down - 1); ++row) {
+                for (int64_t column = firstColumn; column <= std::min(lastColumn, layer.across - 1); ++column) {
+                    visit(static_cast<size_t>(row * layer.across + column));
+                }
+            }
+        };
+        std::vector<uint32_t> fill(static_cast<size_t>(layer.across * layer.down) + 1, 0);
+        for (const Shape& shape : layer.shapes) {
+            forEachCell(shape, [&](size_t cell) { ++fill[cell + 1]; });
+        }
+        for (size_t cell = 1; cell < fill.size(); ++cell) {
+            fill[cell] += fill[cell - 1];
+        }
+        layer.cellStarts = fill;
+        layer.cellShapes.resize(fill.back());
+        for (uint32_t index = 0; index < layer.shapes.size(); ++index) {
+            forEachCell(layer.shapes[index], [&](size_t cell) { layer.cellShapes[fill[cell]++] = index; });
+        }
+    }
+}
+
+void RegionOverlay::Draw(uint32_t* pixels, int32_t width, int32_t height, double originX, double originY,
+                         double downsample) const {
+    if (shapes_ == 0 || width <= 0 || height <= 0 || downsample <= 0.0) {
+        return;
+    }
+    std::vector<uint32_t> band(static_cast<size_t>(width) * std::min(height, BAND_ROWS));
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> crossings;
+    std::vector<uint32_t> candidates;
+    const double endX = originX + width * downsample;
+
+    for (const Layer& layer : layers_) {
+        const uint32_t alpha = static_cast<uint32_t>(std::lround(layer.opacity * 255.0f));
+        if (alpha == 0 || layer.shapes.empty()) {
+            continue;
+        }
+        for (int32_t bandTop = 0; bandTop < height; bandTop += BAND_ROWS) {
+            const int32_t rows = std::min(BAND_ROWS, height - bandTop);
+            const double bandY = originY + bandTop * downsample;
+            const double bandEndY = bandY + rows * downsample;
+            bool drawn = false;
+
+            // With an index, the shapes of the cells the band touches, in
+            // drawing order
+            const bool indexed = !layer.cellStarts.empty();
+            if (indexed) {
+                candidates.clear();
+                const double margin = layer.maxWidth * downsample;
+                auto cellOf = [&layer](double position, double origin, int64_t count) {
+                    return std::clamp<int64_t>(static_cast<int64_t>(std::floor((position - origin) / layer.cellSize)),
+                                               0, count - 1);
+                };
+                const int64_t firstColumn = cellOf(originX - margin, layer.originX, layer.across);
+                const int64_t lastColumn = cellOf(endX + margin, layer.originX, layer.across);
+                const int64_t firstRow = cellOf(bandY - margin, layer.originY, layer.down);
+                const int64_t lastRow = cellOf(bandEndY + margin, layer.originY, layer.down);
+                for (int64_t row = firstRow; row <= lastRow; ++row) {
+                    for (int64_t column = firstColumn; column <= lastColumn; ++column) {
+                        const size_t cell = static_cast<size_t>(row * layer.across + column);
+                        candidates.insert(candidates.end(), layer.cellShapes.begin() + layer.cellStarts[cell],
+                                          layer.cellShapes.begin() + layer.cellStarts[cell + 1]);
+                    }
+                }
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            }
+            const size_t shapeCount = indexed ? candidates.size() : layer.shapes.size();
+
+            for (size_t k = 0; k < shapeCount; ++k) {
+                const Shape& shape = layer.shapes[indexed ? candidates[k] : k];
+                const double margin = shape.width * downsample;
+                if (shape.maxX + margin < originX || shape.minX - margin > endX ||
+                    shape.maxY + margin < bandY || shape.minY - margin > bandEndY) {
+                    continue;
+                }
+                if (!drawn) {
+                    std::fill(band.begin(), band.begin() + static_cast<size_t>(width) * rows, 0u);
+                    drawn = true;
+                }
+
+                // In band pixels
+                const Vec2f* vertices = vertices_.data() + shape.first;
+                auto toBandX = [&](float x) { return (x - originX) / downsample; };
+                auto toBandY = [&](float y) { return (y - bandY) / downsample; };
+                const uint32_t color = 0xFF000000u | (shape.color & 0xFFFFFFu);
+                if (shape.width == 0.0f) {
+                    xs.resize(shape.count);
+                    ys.resize(shape.count);
+                    for (size_t i = 0; i < shape.count; ++i) {
+                        xs[i] = toBandX(vertices[i].x);
+                        ys[i] = toBandY(vertices[i].y);
+                    }
+                    FillPolygon(xs, ys, color, crossings, band.data(), width, rows);
+                    continue;
+                }
+
+                // Each edge as a rectangle, extended by half the width at
+                // both ends so corners join
+                const double half = shape.width * 0.5;
+                for (size_t i = 0; i < shape.count; ++i) {
+                    const Vec2f& from = vertices[i];
+                    const Vec2f& to = vertices[(i + 1) % shape.count];
+                    const double ax = toBandX(from.x), ay = toBandY(from.y);
+                    const double bx = toBandX(to.x), by = toBandY(to.y);
+                    const double length = std::hypot(bx - ax, by - ay);
+                    if (length == 0.0) {
+                        continue;
+                    }
+                    const double dx = (bx - ax) / length * half;
+                    const double dy = (by - ay) / length * half;
+                    xs = {ax - dx - dy, bx + dx - dy, bx + dx + dy, ax - dx + dy};
+                    ys = {ay - dy + dx, by + dy + dx, by + dy - dx, ay - dy - dx};
+                    FillPolygon(xs, ys, color, crossings, band.data(), width, rows);
+                }
+            }
+
+            if (!drawn) {
+                continue;
+            }
+            for (int32_t row = 0; row < rows; ++row) {
+                const uint32_t* source = band.data() + static_cast<size_t>(row) * width;
+                uint32_t* destination = pixels + static_cast<size_t>(bandTop + row) * width;
+                for (int32_t column = 0; column < width; ++column) {
+                    if (source[column] != 0) {
+                        destination[column] =
+                            alpha == 255 ? source[column] : Blend(source[column], destination[column], alpha);
+                    }
+                }
+            }
+        }
+    }
+}
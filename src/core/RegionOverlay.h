@@ -0,0 +1,81 @@
+#pragma once
+
+#include "PolygonStore.h"  // For Vec2f, Vec2
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Polygon and annotation overlays drawn on the CPU over an off-screen
+// region render (region.render), at whatever resolution it is made.
+//
+// Shapes are copied in level 0 coordinates on the GUI thread, so Draw()
+// can run on a worker while the viewer goes on changing its overlays.
+// Shapes go in layers: a layer's shapes are drawn opaque, later over
+// earlier, then blended at the layer's opacity, as the viewer composites
+// its polygon tiles, so overlapping cells do not darken each other.
+// Layers are drawn in a band of BAND_ROWS rows at a time, so the scratch
+// buffer stays small however large the image. An overlay drawn many times
+// a small part at a time (region.export's tiles) is indexed first, so
+// each draw visits only the shapes near its part.
+class RegionOverlay {
+public:
+    // New layer on top of the earlier ones; returns its index
+    size_t AddLayer(float opacity);
+
+    // Filled polygon (color 0xRRGGBB); fewer than 3 vertices draw nothing
+    void AddPolygon(size_t layer, const Vec2f* vertices, size_t count, uint32_t color);
+    void AddPolygon(size_t layer, const std::vector<Vec2>& vertices, uint32_t color);
+
+    // Closed outline width output pixels wide, whatever the downsample
+    void AddOutline(size_t layer, const std::vector<Vec2>& vertices, uint32_t color, float width);
+
+    /**
+     * Bucket each layer's shapes into a grid of cellSize level 0 pixels,
+     * for Draw() of parts much smaller than the overlay. Shapes keep their
+     * order. Adding a shape to a layer drops its index.
+     */
+    void BuildIndex(double cellSize);
+
+    size_t GetShapeCount() const { return shapes_; }
+    bool IsEmpty() const { return shapes_ == 0; }
+
+    /**
+     * Draw onto premultiplied ARGB pixels
+     * Pixel (column, row) covers level 0 from (originX + column * downsample,
+     * originY + row * downsample), a downsample wide, sampled at its center.
+     */
+    void Draw(uint32_t* pixels, int32_t width, int32_t height, double originX, double originY,
+              double downsample) const;
+
+    static constexpr int32_t BAND_ROWS = 256;
+    // Cells per layer index at most; larger overlays get larger cells
+    static constexpr int64_t MAX_INDEX_CELLS = int64_t(1) << 20;
+
+private:
+    struct Shape {
+        size_t first = 0;  // In vertices_
+        size_t count = 0;
+        uint32_t color = 0;
+        float width = 0.0f;  // Outline width in output pixels; 0: filled
+        float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;  // Level 0 bounds
+    };
+
+    struct Layer {
+        float opacity = 1.0f;
+        std::vector<Shape> shapes;
+        float maxWidth = 0.0f;  // Widest outline
+
+        // Grid index (BuildIndex): the shapes overlapping cell c are
+        // cellShapes[cellStarts[c], cellStarts[c + 1]); empty if not built
+        double originX = 0.0, originY = 0.0, cellSize = 0.0;
+        int64_t across = 0, down = 0;
+        std::vector<uint32_t> cellStarts;
+        std::vector<uint32_t> cellShapes;
+    };
+
+    void AddShape(size_t layer, Shape shape);
+
+    std::vector<Layer> layers_;
+    std::vector<Vec2f> vertices_;
+    size_t shapes_ = 0;
+};
@@ -0,0 +1,170 @@
+#include "RegionScan.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <numeric>
+#include <utility>
+
+RegionScan::RegionScan(std::vector<Rect> fields, double cellSize, RenderFunction render, size_t threadCount,
+                       size_t maxPending)
+    : fields_(std::move(fields))
+    , order_(HilbertOrder(fields_, cellSize))
+    , render_(std::move(render))
+    , maxPending_(std::max<size_t>(maxPending, 1))
+{
+    if (threadCount == 0) {
+        threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()) - 1, MAX_THREADS);
+    }
+    threadCount = std::min(std::max<size_t>(threadCount, 1), fields_.size());
+    results_.reserve(fields_.size());
+
+    runningWorkers_.store(threadCount, std::memory_order_release);
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&RegionScan::Work, this);
+    }
+}
+
+RegionScan::~RegionScan() {
+    Cancel();
+}
+
+void RegionScan::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex_);
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+    acknowledged_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t RegionScan::GetResults(size_t since, size_t limit, std::vector<Result>& out) {
+    std::lock_guard<std::mutex> lock(resultsMutex_);
+    since = std::min(since, results_.size());
+    if (since > received_) {
+        for (size_t i = received_; i < since; ++i) {
+            results_[i].image = json();
+        }
+        received_ = since;
+        acknowledged_.notify_all();
+    }
+    for (size_t i = since; i < results_.size() && i - since < limit; ++i) {
+        out.push_back(results_[i]);
+    }
+    return results_.size();
+}
+
+void RegionScan::Work() {
+    for (;;) {
+        size_t field = 0;
+        {
+            // Rendering and unacknowledged results together stay within maxPending_
+            std::unique_lock<std::mutex> lock(resultsMutex_);
+            acknowledged_.wait(lock, [this]() {
+                return cancelled_.load(std::memory_order_relaxed) || nextField_ >= order_.size() ||
+                       results_.size() + rendering_ < received_ + maxPending_;
+            });
+            if (cancelled_.load(std::memory_order_relaxed) || nextField_ >= order_.size()) {
+                break;
+            }
+            field = order_[nextField_++];
+            ++rendering_;
+        }
+
+        Result result{field, json(), std::string()};
+        try {
+            result.image = render_(fields_[field]);
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        } catch (...) {
+            result.error = "Render failed";
+        }
+        std::lock_guard<std::mutex> lock(resultsMutex_);
+        --rendering_;
+        results_.push_back(std::move(result));
+    }
+    runningWorkers_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+std::vector<Rect> RegionScan::Grid(const Rect& area, double fieldWidth, double fieldHeight, double overlap) {
+    std::vector<Rect> fields;
+    const double stepX = fieldWidth - overlap;
+    const double stepY = fieldHeight - overlap;
+    if (!(stepX > 0.0) || !(stepY > 0.0) || !(area.width > 0.0) || !(area.height > 0.0)) {
+        return fields;
+    }
+    // A field whose step reaches the far edge is the last of its row or column
+    const size_t columns = static_cast<size_t>(std::max(1.0, std::ceil((area.width - overlap) / stepX)));
+    const size_t rows = static_cast<size_t>(std::max(1.0, std::ceil((area.height - overlap) / stepY)));
+    fields.reserve(columns * rows);
+    for (size_t row = 0; row < rows; ++row) {
+        const double y = area.y + static_cast<double>(row) * stepY;
+        for (size_t column = 0; column < columns; ++column) {
+            const double x = area.x + static_cast<double>(column) * stepX;
+            fields.emplace_back(x, y, std::min(fieldWidth, area.Right() - x), std::min(fieldHeight, area.Bottom() - y));
+        }
+    }
+    return fields;
+}
+
+std::vector<size_t> RegionScan::HilbertOrder(const std::vector<Rect>& fields, double cellSize) {
+    std::vector<size_t> order(fields.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    if (fields.size() < 2 || !(cellSize > 0.0)) {
+        return order;
+    }
+
+    // Centre cells relative to the top left one, on the smallest curve
+    // covering them all
+    double minX = fields[0].x + fields[0].width / 2;
+    double minY = fields[0].y + fields[0].height / 2;
+    for (const Rect& field : fields) {
+        minX = std::min(minX, field.x + field.width / 2);
+        minY = std::min(minY, field.y + field.height / 2);
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> cells(fields.size());
+    uint32_t extent = 0;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        auto cell = [cellSize](double offset) {
+            return static_cast<uint32_t>(std::min(std::floor(offset / cellSize), double(UINT32_MAX >> 1)));
+        };
+        cells[i] = {cell(fields[i].x + fields[i].width / 2 - minX), cell(fields[i].y + fields[i].height / 2 - minY)};
+        extent = std::max({extent, cells[i].first, cells[i].second});
+    }
+    uint32_t curveOrder = 1;
+    while (curveOrder < 31 && (extent >> curveOrder) != 0) {
+        ++curveOrder;
+    }
+
+    std::vector<uint64_t> keys(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+        keys[i] = HilbertIndex(cells[i].first, cells[i].second, curveOrder);
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    return order;
+}
+
+uint64_t RegionScan::HilbertIndex(uint32_t x, uint32_t y, uint32_t order) {
+    const uint64_t size = uint64_t(1) << order;
+    uint64_t cx = x;
+    uint64_t cy = y;
+    uint64_t index = 0;
+    for (uint64_t half = size / 2; half > 0; half /= 2) {
+        const uint64_t rx = (cx & half) ? 1 : 0;
+        const uint64_t ry = (cy & half) ? 1 : 0;
+        index += half * half * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it starts where it enters
+        if (ry == 0) {
+            if (rx == 1) {
+                cx = size - 1 - cx;
+                cy = size - 1 - cy;
+            }
+            std::swap(cx, cy);
+        }
+    }
+    return index;
+}
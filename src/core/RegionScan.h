@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Viewport.h"  // For Rect
+#include "json.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Off-screen renders of many fields of a slide (region.scan), for agents
+// that screen a whole slide rather than stepping the view field by field.
+//
+// Fields are rendered on worker threads in Hilbert order of their centres
+// rather than in the order given: neighbouring fields share the pipeline
+// tiles along their edges, and workers on fields next to each other find
+// those tiles cached instead of decoding them twice. Results are collected
+// as they finish, like RoiMetricsBatch's, and hold their encoded image
+// until the caller acknowledges them; at most maxPending wait at once, so
+// a caller that falls behind pauses the workers rather than piling up
+// images.
+class RegionScan {
+public:
+    using json = nlohmann::json;
+
+    // Renders and encodes one field; an exception fails only that field
+    using RenderFunction = std::function<json(const Rect& field)>;
+
+    struct Result {
+        size_t field;       // Position of the field in the scan
+        json image;         // What render returned; empty once acknowledged
+        std::string error;  // Set instead when the field failed
+    };
+
+    /**
+     * Start rendering every field
+     * @param cellSize Level 0 pixels of the Hilbert curve's grid cells,
+     *        e.g. the footprint of a tile at the scan's resolution
+     * @param threadCount Worker threads (0: one per core but one, at most
+     *        MAX_THREADS); never more than there are fields
+     * @param maxPending Finished results not yet acknowledged at most
+     */
+    RegionScan(std::vector<Rect> fields, double cellSize, RenderFunction render, size_t threadCount = 0,
+               size_t maxPending = DEFAULT_MAX_PENDING);
+    ~RegionScan();
+
+    RegionScan(const RegionScan&) = delete;
+    RegionScan& operator=(const RegionScan&) = delete;
+
+    // Skip the fields not started yet and wait for the running ones
+    void Cancel();
+
+    /**
+     * Results finished so far, in the order they finished
+     * @param since Results already received: their images are released
+     *        and workers held back by maxPending resume
+     * @param limit Results appended at most
+     * @param out Receives up to limit results after the first since
+     * @return Number of results finished so far
+     */
+    size_t GetResults(size_t since, size_t limit, std::vector<Result>& out);
+
+    size_t GetFieldCount() const { return fields_.size(); }
+    const std::vector<Rect>& GetFields() const { return fields_; }
+    // Field indices in the order workers take them
+    const std::vector<size_t>& GetOrder() const { return order_; }
+
+    // Every worker has stopped: all fields finished, or the scan was cancelled
+    bool IsDone() const { return runningWorkers_.load(std::memory_order_acquire) == 0; }
+    bool IsCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Fields of fieldWidth x fieldHeight covering area row by row, the
+     * last ones in a row or column cut off at its edge
+     * @param overlap Level 0 pixels each field shares with the next
+     */
+    static std::vector<Rect> Grid(const Rect& area, double fieldWidth, double fieldHeight, double overlap = 0.0);
+
+    // Field indices sorted by the Hilbert index of their centres on a grid
+    // of cellSize cells (ties keep their order)
+    static std::vector<size_t> HilbertOrder(const std::vector<Rect>& fields, double cellSize);
+
+    // Distance of cell (x, y) along the Hilbert curve filling 2^order x
+    // 2^order cells
+    static uint64_t HilbertIndex(uint32_t x, uint32_t y, uint32_t order);
+
+    static constexpr size_t MAX_THREADS = 4;
+    static constexpr size_t DEFAULT_MAX_PENDING = 16;
+
+private:
+    void Work();
+
+    const std::vector<Rect> fields_;
+    const std::vector<size_t> order_;
+    const RenderFunction render_;
+    const size_t maxPending_;
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<size_t> runningWorkers_{0};
+    std::mutex resultsMutex_;
+    std::condition_variable acknowledged_;  // Signalled when received_ grows or on Cancel
+    size_t nextField_ = 0;  // Into order_
+    size_t rendering_ = 0;  // Fields taken but not finished
+    std::vector<Result> results_;
+    size_t received_ = 0;  // Results the caller has acknowledged
+    std::vector<std::thread> workers_;
+};
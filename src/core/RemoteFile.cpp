@@ -0,0 +1,252 @@
+#include "RemoteFile.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+
+RemoteFile::RemoteFile(std::unique_ptr<RangeTransport> transport, size_t cacheBytes)
+    : transport_(std::move(transport))
+    , capacity_(cacheBytes)
+{
+    if (!transport_ || !transport_->GetSize(size_)) {
+        size_ = 0;
+        PATHVIEW_LOG_ERROR("RemoteFile: cannot determine the remote file size");
+    }
+}
+
+RemoteFile::~RemoteFile() {
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        stopping_ = true;
+    }
+    prefetchWake_.notify_all();
+    if (prefetchThread_.joinable()) {
+        prefetchThread_.join();
+    }
+}
+
+uint64_t RemoteFile::BlockBytes(uint64_t index) const {
+    uint64_t start = index * BLOCK_SIZE;
+    return std::min(BLOCK_SIZE, size_ - start);
+}
+
+size_t RemoteFile::GetCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cachedBytes_;
+}
+
+bool RemoteFile::ReadAt(uint64_t offset, void* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    if (offset > size_ || size > size_ - offset) {
+        return false;
+    }
+
+    uint64_t first = offset / BLOCK_SIZE;
+    uint64_t last = (offset + size - 1) / BLOCK_SIZE;
+
+    // A second attempt covers blocks evicted between loading and copying
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!Load({{offset, offset + size}})) {
+            return false;
+        }
+
+        std::vector<std::shared_ptr<Block>> held;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (uint64_t index = first; index <= last; ++index) {
+                auto it = blocks_.find(index);
+                if (it == blocks_.end() || !it->second->ready) {
+                    break;
+                }
+                held.push_back(it->second);
+            }
+        }
+        if (held.size() != last - first + 1) {
+            continue;
+        }
+
+        // Ready blocks never change, so the copy needs no lock
+        uint8_t* out = static_cast<uint8_t*>(data);
+        uint64_t position = offset;
+        uint64_t end = offset + size;
+        for (const std::shared_ptr<Block>& block : held) {
+            uint64_t blockStart = (position / BLOCK_SIZE) * BLOCK_SIZE;
+            uint64_t blockEnd = std::min(blockStart + block->data.size(), end);
+            std::memcpy(out, block->data.data() + (position - blockStart),
+                        static_cast<size_t>(blockEnd - position));
+            out += blockEnd - position;
+            position = blockEnd;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool RemoteFile::Load(const std::vector<std::pair<uint64_t, uint64_t>>& ranges) {
+    if (!IsOpen()) {
+        return false;
+    }
+
+    std::vector<uint64_t> needed;
+    for (const auto& range : ranges) {
+        uint64_t end = std::min(range.second, size_);
+        if (range.first >= end) {
+            continue;
+        }
+        for (uint64_t index = range.first / BLOCK_SIZE; index <= (end - 1) / BLOCK_SIZE; ++index) {
+            needed.push_back(index);
+        }
+    }
+    std::sort(needed.begin(), needed.end());
+    needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+    std::vector<uint64_t> claimed;  // Fetched by this call
+    std::vector<uint64_t> waiting;  // In flight in another call
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t index : needed) {
+            auto it = blocks_.find(index);
+            if (it == blocks_.end()) {
+                blocks_.emplace(index, std::make_shared<Block>());
+                claimed.push_back(index);
+                blockMisses_++;
+            } else if (it->second->ready) {
+                lru_.splice(lru_.begin(), lru_, it->second->lru);
+                blockHits_++;
+            } else {
+                waiting.push_back(index);
+            }
+        }
+
+        // Claim small gaps between missing blocks too, so each run goes out
+        // as one request
+        std::vector<uint64_t> bridged;
+        for (size_t i = 0; i < claimed.size(); ++i) {
+            bridged.push_back(claimed[i]);
+            if (i + 1 == claimed.size()) {
+                break;
+            }
+            uint64_t gap = claimed[i + 1] - claimed[i] - 1;
+            if (gap == 0 || gap > COALESCE_GAP_BLOCKS) {
+                continue;
+            }
+            bool free = true;
+            for (uint64_t index = claimed[i] + 1; index < claimed[i + 1]; ++index) {
+                free = free && blocks_.find(index) == blocks_.end();
+            }
+            if (free) {
+                for (uint64_t index = claimed[i] + 1; index < claimed[i + 1]; ++index) {
+                    blocks_.emplace(index, std::make_shared<Block>());
+                    bridged.push_back(index);
+                }
+            }
+        }
+        claimed.swap(bridged);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < claimed.size();) {
+        size_t j = i;
+        while (j + 1 < claimed.size() && claimed[j + 1] == claimed[j] + 1 &&
+               claimed[j + 1] - claimed[i] < MAX_REQUEST_BLOCKS) {
+            ++j;
+        }
+        ok = FetchRun(claimed[i], claimed[j]) && ok;
+        i = j + 1;
+    }
+
+    // A block that is gone afterwards failed in the other call or was
+    // evicted already; ReadAt notices and loads it again itself
+    if (!waiting.empty()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (uint64_t index : waiting) {
+            blockReady_.wait(lock, [this, index]() {
+                auto it = blocks_.find(index);
+                return it == blocks_.end() || it->second->ready;
+            });
+        }
+    }
+    return ok;
+}
+
+bool RemoteFile::FetchRun(uint64_t first, uint64_t last) {
+    uint64_t offset = first * BLOCK_SIZE;
+    uint64_t end = std::min((last + 1) * BLOCK_SIZE, size_);
+    std::vector<uint8_t> buffer(static_cast<size_t>(end - offset));
+    bool ok = transport_->Fetch(offset, buffer.size(), buffer.data());
+    requestCount_++;
+    if (ok) {
+        fetchedBytes_ += buffer.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t index = first; index <= last; ++index) {
+            auto it = blocks_.find(index);
+            if (it == blocks_.end()) {
+                continue;
+            }
+            if (!ok) {
+                blocks_.erase(it);
+                continue;
+            }
+            Block& block = *it->second;
+            auto start = buffer.begin() + static_cast<std::ptrdiff_t>(index * BLOCK_SIZE - offset);
+            block.data.assign(start, start + static_cast<std::ptrdiff_t>(BlockBytes(index)));
+            block.ready = true;
+            lru_.push_front(index);
+            block.lru = lru_.begin();
+            cachedBytes_ += block.data.size();
+        }
+        EvictLocked();
+    }
+    blockReady_.notify_all();
+    return ok;
+}
+
+void RemoteFile::EvictLocked() {
+    while (cachedBytes_ > capacity_ && !lru_.empty()) {
+        uint64_t index = lru_.back();
+        lru_.pop_back();
+        auto it = blocks_.find(index);
+        cachedBytes_ -= it->second->data.size();
+        blocks_.erase(it);
+    }
+}
+
+void RemoteFile::Prefetch(uint64_t offset, uint64_t size) {
+    if (!IsOpen() || size == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        if (stopping_) {
+            return;
+        }
+        if (!prefetchThread_.joinable()) {
+            prefetchThread_ = std::thread(&RemoteFile::PrefetchLoop, this);
+        }
+        prefetchQueue_.emplace_back(offset, offset + size);
+        while (prefetchQueue_.size() > MAX_PREFETCH_QUEUE) {
+            prefetchQueue_.pop_front();
+        }
+    }
+    prefetchWake_.notify_one();
+}
+
+void RemoteFile::PrefetchLoop() {
+    for (;;) {
+        std::pair<uint64_t, uint64_t> range;
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex_);
+            prefetchWake_.wait(lock, [this]() { return stopping_ || !prefetchQueue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            range = prefetchQueue_.front();
+            prefetchQueue_.pop_front();
+        }
+        Load({range});
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Byte-range reads of a remote file (HTTP range requests: see
+// HttpRangeTransport)
+class RangeTransport {
+public:
+    virtual ~RangeTransport() = default;
+
+    // Total file size; false if the remote cannot tell or serve ranges
+    virtual bool GetSize(uint64_t& size) = 0;
+
+    // Exactly size bytes at offset into out. Must be thread-safe.
+    virtual bool Fetch(uint64_t offset, uint64_t size, uint8_t* out) = 0;
+};
+
+// A remote slide file read through an LRU cache of fixed-size blocks.
+//
+// Reads are rounded out to BLOCK_SIZE blocks. Missing blocks are fetched
+// in runs - neighbouring missing blocks, and small gaps between them, go
+// out as one request of up to MAX_REQUEST_BLOCKS - and concurrent readers
+// of a block in flight wait for that fetch instead of issuing their own.
+// Load() does the same for several ranges at once (a region's tiles), and
+// Prefetch() queues ranges for a background thread so the renderer's
+// prefetch ring is already resident when its tiles are decoded.
+//
+// Thread-safe.
+class RemoteFile {
+public:
+    static constexpr uint64_t BLOCK_SIZE = 256 * 1024;
+    static constexpr size_t DEFAULT_CACHE_BYTES = 256 * 1024 * 1024;
+
+    explicit RemoteFile(std::unique_ptr<RangeTransport> transport,
+                        size_t cacheBytes = DEFAULT_CACHE_BYTES);
+    ~RemoteFile();
+
+    RemoteFile(const RemoteFile&) = delete;
+    RemoteFile& operator=(const RemoteFile&) = delete;
+
+    // True once the remote reported its size
+    bool IsOpen() const { return size_ > 0; }
+    uint64_t GetSize() const { return size_; }
+
+    // Exactly size bytes at offset; false past the end or on a failed fetch
+    bool ReadAt(uint64_t offset, void* data, size_t size);
+
+    // Make the blocks behind [offset, end) ranges resident, with as few
+    // requests as possible. Returns false if any of its fetches failed.
+    bool Load(const std::vector<std::pair<uint64_t, uint64_t>>& ranges);
+
+    // Load a range on the prefetch thread (returns at once). The queue
+    // keeps the most recent MAX_PREFETCH_QUEUE ranges.
+    void Prefetch(uint64_t offset, uint64_t size);
+
+    // Statistics
+    size_t GetRequestCount() const { return requestCount_.load(); }
+    size_t GetFetchedBytes() const { return fetchedBytes_.load(); }
+    size_t GetBlockHits() const { return blockHits_.load(); }
+    size_t GetBlockMisses() const { return blockMisses_.load(); }
+    size_t GetCachedBytes() const;
+    size_t GetCacheCapacity() const { return capacity_; }
+
+private:
+    struct Block {
+        std::vector<uint8_t> data;
+        bool ready = false;                  // False while its fetch is in flight
+        std::list<uint64_t>::iterator lru;   // Valid once ready
+    };
+
+    uint64_t BlockBytes(uint64_t index) const;
+
+    // Fetch blocks [first, last] with one request and publish them
+    bool FetchRun(uint64_t first, uint64_t last);
+    void EvictLocked();
+    void PrefetchLoop();
+
+    std::unique_ptr<RangeTransport> transport_;
+    uint64_t size_ = 0;
+    size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable blockReady_;
+    std::unordered_map<uint64_t, std::shared_ptr<Block>> blocks_;
+    std::list<uint64_t> lru_;                // Ready blocks, most recent first
+    size_t cachedBytes_ = 0;
+
+    // Prefetch thread, started by the first Prefetch()
+    std::mutex prefetchMutex_;
+    std::condition_variable prefetchWake_;
+    std::deque<std::pair<uint64_t, uint64_t>> prefetchQueue_;
+    std::thread prefetchThread_;
+    bool stopping_ = false;
+
+    std::atomic<size_t> requestCount_{0};
+    std::atomic<size_t> fetchedBytes_{0};
+    std::atomic<size_t> blockHits_{0};
+    std::atomic<size_t> blockMisses_{0};
+
+    // Missing blocks at most this far apart are fetched together (the gap
+    // rides along and is cached)
+    static constexpr uint64_t COALESCE_GAP_BLOCKS = 1;
+    static constexpr uint64_t MAX_REQUEST_BLOCKS = 16;
+    static constexpr size_t MAX_PREFETCH_QUEUE = 64;
+};
@@ -0,0 +1,1181 @@
+#include "RenderBackend.h"
+#include "SdlRenderBackend.h"
+#include "Log.h"
+
+#ifdef PATHVIEW_HAS_OPENGL3
+
+#include <SDL2/SDL_opengl.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Entry points past OpenGL 1.1, loaded from the SDL_Renderer's context
+#define PATHVIEW_GL_FUNCTIONS(X)                                  \
+    X(PFNGLACTIVETEXTUREPROC, glActiveTexture)                    \
+    X(PFNGLCOMPRESSEDTEXIMAGE2DPROC, glCompressedTexImage2D)      \
+    X(PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC, glCompressedTexSubImage2D) \
+    X(PFNGLBLENDEQUATIONSEPARATEPROC, glBlendEquationSeparate)    \
+    X(PFNGLBLENDFUNCSEPARATEPROC, glBlendFuncSeparate)            \
+    X(PFNGLGENBUFFERSPROC, glGenBuffers)                          \
+    X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers)                    \
+    X(PFNGLBINDBUFFERPROC, glBindBuffer)                          \
+    X(PFNGLBUFFERDATAPROC, glBufferData)                          \
+    X(PFNGLMAPBUFFERRANGEPROC, glMapBufferRange)                  \
+    X(PFNGLUNMAPBUFFERPROC, glUnmapBuffer)                        \
+    X(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays)                \
+    X(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays)          \
+    X(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray)                \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer)        \
+    X(PFNGLCREATESHADERPROC, glCreateShader)                      \
+    X(PFNGLSHADERSOURCEPROC, glShaderSource)                      \
+    X(PFNGLCOMPILESHADERPROC, glCompileShader)                    \
+    X(PFNGLGETSHADERIVPROC, glGetShaderiv)                        \
+    X(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog)              \
+    X(PFNGLDELETESHADERPROC, glDeleteShader)                      \
+    X(PFNGLCREATEPROGRAMPROC, glCreateProgram)                    \
+    X(PFNGLATTACHSHADERPROC, glAttachShader)                      \
+    X(PFNGLBINDATTRIBLOCATIONPROC, glBindAttribLocation)          \
+    X(PFNGLLINKPROGRAMPROC, glLinkProgram)                        \
+    X(PFNGLGETPROGRAMIVPROC, glGetProgramiv)                      \
+    X(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog)            \
+    X(PFNGLDELETEPROGRAMPROC, glDeleteProgram)                    \
+    X(PFNGLUSEPROGRAMPROC, glUseProgram)                          \
+    X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation)          \
+    X(PFNGLUNIFORM1IPROC, glUniform1i)                            \
+    X(PFNGLUNIFORM4FPROC, glUniform4f)                            \
+    X(PFNGLFENCESYNCPROC, glFenceSync)                            \
+    X(PFNGLCLIENTWAITSYNCPROC, glClientWaitSync)                  \
+    X(PFNGLDELETESYNCPROC, glDeleteSync)
+
+struct GlFunctions {
+#define PATHVIEW_GL_MEMBER(type, name) type name = nullptr;
+    PATHVIEW_GL_FUNCTIONS(PATHVIEW_GL_MEMBER)
+#undef PATHVIEW_GL_MEMBER
+
+    bool Load() {
+#define PATHVIEW_GL_LOAD(type, name)                                          \
+        name = reinterpret_cast<type>(SDL_GL_GetProcAddress(#name));          \
+        if (!name) {                                                          \
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Missing " #name);            \
+            return false;                                                     \
+        }
+        PATHVIEW_GL_FUNCTIONS(PATHVIEW_GL_LOAD)
+#undef PATHVIEW_GL_LOAD
+        return true;
+    }
+};
+
+#undef PATHVIEW_GL_FUNCTIONS
+
+const char* VERTEX_SHADER = R"(#version 130
+uniform vec4 u_transform;  // Render coordinates to clip space: xy scale, zw offset
+in vec2 a_position;
+in vec4 a_color;
+in vec2 a_texCoord;
+out vec4 v_color;
+out vec2 v_texCoord;
+void main() {
+    v_color = a_color;
+    v_texCoord = a_texCoord;
+    gl_Position = vec4(a_position * u_transform.xy + u_transform.zw, 0.0, 1.0);
+}
+)";
+
+const char* FRAGMENT_SHADER = R"(#version 130
+uniform sampler2D u_texture;
+in vec4 v_color;
+in vec2 v_texCoord;
+out vec4 o_color;
+void main() {
+    o_color = texture(u_texture, v_texCoord) * v_color;
+}
+)";
+
+enum Attribute : GLuint { POSITION = 0, COLOR = 1, TEX_COORD = 2 };
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+GLenum CompressedFormat(TextureCompression compression) {
+    return compression == TextureCompression::Bc7 ? GL_COMPRESSED_RGBA_BPTC_UNORM
+                                                  : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+}
+
+struct GlTexture {
+    GLuint id = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    TextureCompression compression = TextureCompression::None;
+};
+
+// The blocks an update of rect writes: whole blocks, except at the
+// texture's right and bottom edges
+SDL_Rect BlockRect(const GlTexture* texture, const SDL_Rect& rect) {
+    return {rect.x, rect.y,
+            std::min(BlockCompressor::RoundUp(rect.w), texture->width - rect.x),
+            std::min(BlockCompressor::RoundUp(rect.h), texture->height - rect.y)};
+}
+
+GlTexture* ToGl(RenderTexture* texture) {
+    return reinterpret_cast<GlTexture*>(texture);
+}
+
+// Everything the backend's draws and uploads change, captured after
+// flushing SDL's queued commands and put back afterwards: SDL_Renderer
+// caches its GL state and would otherwise draw with ours
+class GlStateGuard {
+public:
+    GlStateGuard(const GlFunctions& gl, SDL_Renderer* renderer) : gl_(gl) {
+        SDL_RenderFlush(renderer);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture_);
+        gl_.glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture_);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program_);
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer_);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray_);
+        glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer_);
+        glGetIntegerv(GL_UNPACK_ROW_LENGTH, &unpackRowLength_);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment_);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer_);
+        glGetIntegerv(GL_PACK_ROW_LENGTH, &packRowLength_);
+        glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment_);
+        glGetIntegerv(GL_VIEWPORT, viewport_);
+        glGetIntegerv(GL_SCISSOR_BOX, scissor_);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb_);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb_);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha_);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha_);
+        glGetIntegerv(GL_BLEND_EQUATION_RGB, &blendEquationRgb_);
+        glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &blendEquationAlpha_);
+        blend_ = glIsEnabled(GL_BLEND);
+        scissorTest_ = glIsEnabled(GL_SCISSOR_TEST);
+        cullFace_ = glIsEnabled(GL_CULL_FACE);
+        depthTest_ = glIsEnabled(GL_DEPTH_TEST);
+        stencilTest_ = glIsEnabled(GL_STENCIL_TEST);
+    }
+
+    ~GlStateGuard() {
+        SetEnabled(GL_BLEND, blend_);
+        SetEnabled(GL_SCISSOR_TEST, scissorTest_);
+        SetEnabled(GL_CULL_FACE, cullFace_);
+        SetEnabled(GL_DEPTH_TEST, depthTest_);
+        SetEnabled(GL_STENCIL_TEST, stencilTest_);
+        gl_.glBlendEquationSeparate(blendEquationRgb_, blendEquationAlpha_);
+        gl_.glBlendFuncSeparate(blendSrcRgb_, blendDstRgb_, blendSrcAlpha_, blendDstAlpha_);
+        glScissor(scissor_[0], scissor_[1], scissor_[2], scissor_[3]);
+        glViewport(viewport_[0], viewport_[1], viewport_[2], viewport_[3]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment_);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, unpackRowLength_);
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer_);
+        glPixelStorei(GL_PACK_ALIGNMENT, packAlignment_);
+        glPixelStorei(GL_PACK_ROW_LENGTH, packRowLength_);
+        gl_.glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer_);
+        gl_.glBindVertexArray(vertexArray_);
+        gl_.glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer_);
+        gl_.glUseProgram(program_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        gl_.glActiveTexture(activeTexture_);
+    }
+
+    GlStateGuard(const GlStateGuard&) = delete;
+    GlStateGuard& operator=(const GlStateGuard&) = delete;
+
+private:
+    static void SetEnabled(GLenum cap, GLboolean enabled) {
+        if (enabled) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+    }
+
+    const GlFunctions& gl_;
+    GLint activeTexture_ = 0;
+    GLint texture_ = 0;
+    GLint program_ = 0;
+    GLint arrayBuffer_ = 0;
+    GLint vertexArray_ = 0;
+    GLint unpackBuffer_ = 0;
+    GLint unpackRowLength_ = 0;
+    GLint unpackAlignment_ = 4;
+    GLint packBuffer_ = 0;
+    GLint packRowLength_ = 0;
+    GLint packAlignment_ = 4;
+    GLint viewport_[4] = {};
+    GLint scissor_[4] = {};
+    GLint blendSrcRgb_ = GL_ONE;
+    GLint blendDstRgb_ = GL_ZERO;
+    GLint blendSrcAlpha_ = GL_ONE;
+    GLint blendDstAlpha_ = GL_ZERO;
+    GLint blendEquationRgb_ = GL_FUNC_ADD;
+    GLint blendEquationAlpha_ = GL_FUNC_ADD;
+    GLboolean blend_ = GL_FALSE;
+    GLboolean scissorTest_ = GL_FALSE;
+    GLboolean cullFace_ = GL_FALSE;
+    GLboolean depthTest_ = GL_FALSE;
+    GLboolean stencilTest_ = GL_FALSE;
+};
+
+// RenderBackend on the OpenGL (3.2+) context of SDL's "opengl" renderer.
+// Tiles upload through a ring of pixel buffer objects: UpdateTexture only
+// copies into mapped buffer memory and the driver transfers it to the
+// texture while the frame goes on, instead of SDL_UpdateTexture's
+// synchronous glTexSubImage2D from client memory. A buffer the GPU may
+// still be reading is orphaned rather than waited on.
+//
+// With persistent buffer mapping (OpenGL 4.4 or ARB_buffer_storage) tiles
+// can also upload asynchronously: QueueUpload hands the pixels to an
+// upload thread that copies them into a slot of a persistently mapped
+// staging buffer, and PollUploads issues the copied slots' transfers in
+// queue order. The render thread never touches the pixels, and a slot is
+// reused once its fence signals.
+//
+// Compressed textures (BC1 with EXT_texture_compression_s3tc, BC7 with
+// OpenGL 4.2 or ARB_texture_compression_bptc) take the same pixels: they
+// are block-compressed into the upload buffer or staging slot instead of
+// copied, and once the first such texture exists, more threads run the
+// copy loop, as compressing takes far longer than a copy.
+//
+// Readbacks copy the render target into a pixel pack buffer and fence it,
+// so glReadPixels returns without waiting for the frame to finish; the
+// buffer is mapped once the fence signals, a frame or so later.
+//
+// Draws go straight to SDL_Renderer's current render target with the
+// viewport, scale and clip rectangle it would use, after flushing its
+// queued commands, and leave its GL state as they found it.
+class GlRenderBackend : public RenderBackend {
+public:
+    static std::unique_ptr<RenderBackend> Create(SDL_Renderer* renderer) {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) != 0 || std::strcmp(info.name, "opengl") != 0 ||
+            !SDL_GL_GetCurrentContext()) {
+            return nullptr;
+        }
+
+        // GL_MAJOR_VERSION is 3.0+: older contexts leave major at 0
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        while (glGetError() != GL_NO_ERROR) {
+        }
+        if (major * 10 + minor < 32) {
+            PATHVIEW_LOG_INFO("GlRenderBackend: OpenGL " << major << "." << minor
+                              << " context, 3.2 needed");
+            return nullptr;
+        }
+
+        GlFunctions gl;
+        if (!gl.Load()) {
+            return nullptr;
+        }
+        std::unique_ptr<GlRenderBackend> backend(new GlRenderBackend(renderer, gl));
+        if (!backend->Initialize()) {
+            return nullptr;
+        }
+        return backend;
+    }
+
+    ~GlRenderBackend() override {
+        if (uploadThread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(stagingMutex_);
+                stopping_ = true;
+            }
+            copyQueued_.notify_all();
+            uploadThread_.join();
+            for (std::thread& thread : compressThreads_) {
+                thread.join();
+            }
+        }
+
+        GlStateGuard guard(gl_, renderer_);
+        for (StagingSlot& slot : stagingSlots_) {
+            if (slot.fence) {
+                gl_.glDeleteSync(slot.fence);
+            }
+        }
+        if (stagingBuffer_) {
+            gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer_);
+            gl_.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            gl_.glDeleteBuffers(1, &stagingBuffer_);
+        }
+        for (UploadBuffer& buffer : uploadBuffers_) {
+            if (buffer.fence) {
+                gl_.glDeleteSync(buffer.fence);
+            }
+            if (buffer.id) {
+                gl_.glDeleteBuffers(1, &buffer.id);
+            }
+        }
+        for (ReadbackBuffer& buffer : readbackBuffers_) {
+            if (buffer.fence) {
+                gl_.glDeleteSync(buffer.fence);
+            }
+            if (buffer.id) {
+                gl_.glDeleteBuffers(1, &buffer.id);
+            }
+        }
+        DestroyTexture(whiteTexture_);
+        if (vertexArray_) {
+            gl_.glDeleteVertexArrays(1, &vertexArray_);
+        }
+        GLuint buffers[2] = {vertexBuffer_, indexBuffer_};
+        gl_.glDeleteBuffers(2, buffers);
+        if (program_) {
+            gl_.glDeleteProgram(program_);
+        }
+    }
+
+    const char* GetName() const override { return "OpenGL 3"; }
+    int32_t GetMaxTextureSize() const override { return maxTextureSize_; }
+
+    RenderTexture* CreateTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode) override {
+        if (width <= 0 || height <= 0 || width > maxTextureSize_ || height > maxTextureSize_) {
+            return nullptr;
+        }
+        GlStateGuard guard(gl_, renderer_);
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GlTexture* texture = new GlTexture{0, width, height};
+        glGenTextures(1, &texture->id);
+        glBindTexture(GL_TEXTURE_2D, texture->id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        ApplyScaleMode(scaleMode);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+                     nullptr);
+        if (glGetError() != GL_NO_ERROR) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot create " << width << "x" << height << " texture");
+            glDeleteTextures(1, &texture->id);
+            delete texture;
+            return nullptr;
+        }
+        return reinterpret_cast<RenderTexture*>(texture);
+    }
+
+    bool SupportsCompression(TextureCompression compression) const override {
+        switch (compression) {
+            case TextureCompression::Bc7: return hasBc7_;
+            case TextureCompression::Bc1: return hasBc1_;
+            case TextureCompression::None: break;
+        }
+        return true;
+    }
+
+    RenderTexture* CreateCompressedTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode,
+                                           TextureCompression compression) override {
+        if (compression == TextureCompression::None) {
+            return CreateTexture(width, height, scaleMode);
+        }
+        if (!SupportsCompression(compression) || width <= 0 || height <= 0 || width > maxTextureSize_ ||
+            height > maxTextureSize_) {
+            return nullptr;
+        }
+        GlStateGuard guard(gl_, renderer_);
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GlTexture* texture = new GlTexture{0, width, height, compression};
+        glGenTextures(1, &texture->id);
+        glBindTexture(GL_TEXTURE_2D, texture->id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        ApplyScaleMode(scaleMode);
+        gl_.glCompressedTexImage2D(GL_TEXTURE_2D, 0, CompressedFormat(compression), width, height, 0,
+                                   static_cast<GLsizei>(BlockCompressor::CompressedSize(compression, width, height)),
+                                   nullptr);
+        if (glGetError() != GL_NO_ERROR) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot create " << width << "x" << height << " "
+                               << TextureCompressionName(compression) << " texture");
+            glDeleteTextures(1, &texture->id);
+            delete texture;
+            return nullptr;
+        }
+
+        if (uploadThread_.joinable() && compressThreads_.empty()) {
+            const unsigned threads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+            for (unsigned i = 1; i < threads; ++i) {
+                compressThreads_.emplace_back([this] { CopyLoop(); });
+            }
+        }
+        return reinterpret_cast<RenderTexture*>(texture);
+    }
+
+    void DestroyTexture(RenderTexture* texture) override {
+        if (!texture) {
+            return;
+        }
+        if (uploadThread_.joinable()) {
+            CancelUploads(ToGl(texture));
+        }
+        glDeleteTextures(1, &ToGl(texture)->id);
+        delete ToGl(texture);
+    }
+
+    bool GetTextureSize(RenderTexture* texture, int32_t* width, int32_t* height) const override {
+        if (!texture) {
+            return false;
+        }
+        *width = ToGl(texture)->width;
+        *height = ToGl(texture)->height;
+        return true;
+    }
+
+    void SetTextureScaleMode(RenderTexture* texture, SDL_ScaleMode mode) override {
+        GlStateGuard guard(gl_, renderer_);
+        glBindTexture(GL_TEXTURE_2D, ToGl(texture)->id);
+        ApplyScaleMode(mode);
+    }
+
+    bool UpdateTexture(RenderTexture* texture, const SDL_Rect* rect, const uint32_t* pixels, int pitch) override {
+        GlTexture* glTexture = ToGl(texture);
+        SDL_Rect area = rect ? *rect : SDL_Rect{0, 0, glTexture->width, glTexture->height};
+        if (area.w <= 0 || area.h <= 0) {
+            return true;
+        }
+        const TextureCompression compression = glTexture->compression;
+        const size_t rowBytes = static_cast<size_t>(area.w) * sizeof(uint32_t);
+        const size_t bytes = BlockCompressor::CompressedSize(compression, area.w, area.h);
+        if (uploadThread_.joinable()) {
+            IssueUploadsBefore(glTexture, area);
+        }
+
+        GlStateGuard guard(gl_, renderer_);
+        UploadBuffer& buffer = uploadBuffers_[nextUpload_];
+        nextUpload_ = (nextUpload_ + 1) % UPLOAD_BUFFER_COUNT;
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+
+        bool busy = false;
+        if (buffer.fence) {
+            GLenum status = gl_.glClientWaitSync(buffer.fence, 0, 0);
+            busy = status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED;
+            gl_.glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
+        }
+        if (busy || buffer.size < bytes) {
+            buffer.size = std::max(buffer.size, bytes);
+            gl_.glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(buffer.size), nullptr, GL_STREAM_DRAW);
+        }
+
+        void* mapped = gl_.glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                            GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!mapped) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot map upload buffer");
+            return false;
+        }
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(pixels);
+        uint8_t* dest = static_cast<uint8_t*>(mapped);
+        if (compression != TextureCompression::None) {
+            BlockCompressor::Compress(compression, pixels, pitch, area.w, area.h, dest);
+        } else if (static_cast<size_t>(pitch) == rowBytes) {
+            std::memcpy(dest, source, bytes);
+        } else {
+            for (int y = 0; y < area.h; ++y) {
+                std::memcpy(dest + y * rowBytes, source + static_cast<size_t>(y) * pitch, rowBytes);
+            }
+        }
+        if (gl_.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) != GL_TRUE) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Upload buffer lost");
+            return false;
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, glTexture->id);
+        if (compression != TextureCompression::None) {
+            const SDL_Rect blocks = BlockRect(glTexture, area);
+            gl_.glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, blocks.x, blocks.y, blocks.w, blocks.h,
+                                          CompressedFormat(compression), static_cast<GLsizei>(bytes), nullptr);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, area.x, area.y, area.w, area.h, GL_BGRA,
+                            GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+        }
+        buffer.fence = gl_.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return true;
+    }
+
+    bool HasAsyncUploads() const override { return uploadThread_.joinable(); }
+
+    bool QueueUpload(RenderTexture* texture, const SDL_Rect& rect, std::shared_ptr<const void> owner,
+                     const uint32_t* pixels, int pitch, uint64_t ticket) override {
+        if (!uploadThread_.joinable() || !texture || rect.w <= 0 || rect.h <= 0 ||
+            BlockCompressor::CompressedSize(ToGl(texture)->compression, rect.w, rect.h) > STAGING_SLOT_BYTES) {
+            return false;
+        }
+        ReclaimStagingSlots();
+
+        std::lock_guard<std::mutex> lock(stagingMutex_);
+        for (size_t i = 0; i < STAGING_SLOT_COUNT; ++i) {
+            StagingSlot& slot = stagingSlots_[i];
+            if (slot.state != StagingSlot::State::Free) {
+                continue;
+            }
+            slot.state = StagingSlot::State::Copying;
+            slot.texture = ToGl(texture);
+            slot.compression = slot.texture->compression;
+            slot.rect = rect;
+            slot.owner = std::move(owner);
+            slot.pixels = pixels;
+            slot.pitch = pitch;
+            slot.ticket = ticket;
+            slot.cancelled = false;
+            stagingOrder_.push_back(i);
+            copyJobs_.push_back(i);
+            copyQueued_.notify_one();
+            return true;
+        }
+        return false;
+    }
+
+    void PollUploads(std::vector<uint64_t>* completed) override {
+        if (!uploadThread_.joinable()) {
+            return;
+        }
+        ReclaimStagingSlots();
+
+        // Copied slots at the front of the queue, in order: a slot still
+        // copying holds back everything queued after it
+        std::vector<size_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(stagingMutex_);
+            while (!stagingOrder_.empty() &&
+                   stagingSlots_[stagingOrder_.front()].state == StagingSlot::State::Copied) {
+                ready.push_back(stagingOrder_.front());
+                stagingOrder_.pop_front();
+            }
+        }
+        IssueStagingSlots(ready);
+        completed->insert(completed->end(), issuedTickets_.begin(), issuedTickets_.end());
+        issuedTickets_.clear();
+    }
+
+    bool HasAsyncReadback() const override { return true; }
+
+    uint64_t StartReadback(const SDL_Rect& rect) override {
+        if (rect.w <= 0 || rect.h <= 0) {
+            return 0;
+        }
+        ReadbackBuffer* buffer = nullptr;
+        for (ReadbackBuffer& candidate : readbackBuffers_) {
+            if (candidate.ticket == 0) {
+                buffer = &candidate;
+                break;
+            }
+        }
+        if (!buffer) {
+            return 0;
+        }
+
+        // Render targets are stored bottom-up, the window top-down
+        int outputHeight = 0;
+        SDL_Texture* target = SDL_GetRenderTarget(renderer_);
+        if (target) {
+            SDL_QueryTexture(target, nullptr, nullptr, nullptr, &outputHeight);
+        } else {
+            SDL_GetRendererOutputSize(renderer_, nullptr, &outputHeight);
+        }
+
+        GlStateGuard guard(gl_, renderer_);
+        while (glGetError() != GL_NO_ERROR) {
+        }
+        const size_t bytes = static_cast<size_t>(rect.w) * rect.h * 4;
+        if (!buffer->id) {
+            gl_.glGenBuffers(1, &buffer->id);
+        }
+        gl_.glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->id);
+        if (buffer->size < bytes) {
+            buffer->size = bytes;
+            gl_.glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+        }
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(rect.x, target ? rect.y : outputHeight - rect.y - rect.h, rect.w, rect.h, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+        if (glGetError() != GL_NO_ERROR) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot read back " << rect.w << "x" << rect.h << " pixels");
+            return 0;
+        }
+        buffer->fence = gl_.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        buffer->width = rect.w;
+        buffer->height = rect.h;
+        buffer->flip = !target;
+        buffer->ticket = nextReadbackTicket_++;
+        return buffer->ticket;
+    }
+
+    bool FinishReadback(uint64_t ticket, std::vector<uint8_t>* pixels, bool wait) override {
+        pixels->clear();
+        ReadbackBuffer* buffer = nullptr;
+        for (ReadbackBuffer& candidate : readbackBuffers_) {
+            if (ticket != 0 && candidate.ticket == ticket) {
+                buffer = &candidate;
+                break;
+            }
+        }
+        if (!buffer) {
+            return true;
+        }
+        // The flush makes sure the fence reaches the GPU while we poll
+        GLenum status = gl_.glClientWaitSync(buffer->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                             wait ? READBACK_WAIT_NS : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait) {
+            return false;
+        }
+        gl_.glDeleteSync(buffer->fence);
+        buffer->fence = nullptr;
+        buffer->ticket = 0;
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Readback did not finish");
+            return true;
+        }
+
+        GlStateGuard guard(gl_, renderer_);
+        const size_t rowBytes = static_cast<size_t>(buffer->width) * 4;
+        const size_t bytes = rowBytes * buffer->height;
+        gl_.glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->id);
+        const void* mapped = gl_.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                                  GL_MAP_READ_BIT);
+        if (!mapped) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot map readback buffer");
+            return true;
+        }
+        const uint8_t* source = static_cast<const uint8_t*>(mapped);
+        pixels->resize(bytes);
+        if (!buffer->flip) {
+            std::memcpy(pixels->data(), source, bytes);
+        } else {
+            for (int y = 0; y < buffer->height; ++y) {
+                std::memcpy(pixels->data() + y * rowBytes, source + (buffer->height - 1 - y) * rowBytes, rowBytes);
+            }
+        }
+        if (gl_.glUnmapBuffer(GL_PIXEL_PACK_BUFFER) != GL_TRUE) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Readback buffer lost");
+            pixels->clear();
+        }
+        return true;
+    }
+
+    bool DrawGeometry(RenderTexture* texture, const SDL_Vertex* vertices, int vertexCount,
+                      const int* indices, int indexCount, SDL_BlendMode blendMode) override {
+        if (!texture || vertexCount <= 0 || indexCount <= 0) {
+            return false;
+        }
+        GlStateGuard guard(gl_, renderer_);
+        if (!BeginDraw(blendMode)) {
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, ToGl(texture)->id);
+        gl_.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexCount * sizeof(SDL_Vertex)), vertices,
+                         GL_STREAM_DRAW);
+        gl_.glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexCount * sizeof(int)), indices,
+                         GL_STREAM_DRAW);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+        return true;
+    }
+
+    void FillRects(const SDL_Rect* rects, int count, SDL_Color color) override {
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+        vertices.reserve(count * 4);
+        indices.reserve(count * 6);
+        color.a = 0xFF;
+        for (int i = 0; i < count; ++i) {
+            float x0 = static_cast<float>(rects[i].x);
+            float y0 = static_cast<float>(rects[i].y);
+            float x1 = x0 + rects[i].w;
+            float y1 = y0 + rects[i].h;
+            int base = static_cast<int>(vertices.size());
+            vertices.push_back({{x0, y0}, color, {0.5f, 0.5f}});
+            vertices.push_back({{x1, y0}, color, {0.5f, 0.5f}});
+            vertices.push_back({{x1, y1}, color, {0.5f, 0.5f}});
+            vertices.push_back({{x0, y1}, color, {0.5f, 0.5f}});
+            for (int index : {0, 1, 2, 0, 2, 3}) {
+                indices.push_back(base + index);
+            }
+        }
+        DrawGeometry(whiteTexture_, vertices.data(), static_cast<int>(vertices.size()),
+                     indices.data(), static_cast<int>(indices.size()), SDL_BLENDMODE_NONE);
+    }
+
+    void SetViewport(const SDL_Rect* rect) override {
+        // Kept by SDL_Renderer, so its own draws see the same pane
+        SDL_RenderSetViewport(renderer_, rect);
+    }
+
+private:
+    static constexpr size_t UPLOAD_BUFFER_COUNT = 4;
+    // A capture of each size and the stream frame in flight at once
+    static constexpr size_t READBACK_BUFFER_COUNT = 4;
+    // FinishReadback's wait before it gives a copy up
+    static constexpr GLuint64 READBACK_WAIT_NS = 1000000000;
+    // Room for 32 queued 512x512 tiles
+    static constexpr size_t STAGING_SLOT_COUNT = 32;
+    static constexpr size_t STAGING_SLOT_BYTES = 512 * 512 * sizeof(uint32_t);
+
+    struct UploadBuffer {
+        GLuint id = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;  // Set while the GPU may read the buffer
+    };
+
+    struct ReadbackBuffer {
+        GLuint id = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;  // Set while the GPU may write the buffer
+        uint64_t ticket = 0;     // 0: free
+        int width = 0;
+        int height = 0;
+        bool flip = false;       // Read from the window: bottom row first
+    };
+
+    // One queued upload. Free -> Copying (QueueUpload) -> Copied (upload
+    // thread) -> InFlight (transfer issued) -> Free (fence signalled).
+    // Only the upload thread moves Copying slots, under stagingMutex_.
+    struct StagingSlot {
+        enum class State { Free, Copying, Copied, InFlight };
+        State state = State::Free;
+        GlTexture* texture = nullptr;
+        TextureCompression compression = TextureCompression::None;
+        SDL_Rect rect{0, 0, 0, 0};
+        std::shared_ptr<const void> owner;  // Keeps pixels alive until copied
+        const uint32_t* pixels = nullptr;
+        int pitch = 0;
+        uint64_t ticket = 0;
+        bool cancelled = false;  // Texture destroyed: copy, but never issue
+        GLsync fence = nullptr;
+    };
+
+    GlRenderBackend(SDL_Renderer* renderer, const GlFunctions& gl) : renderer_(renderer), gl_(gl) {}
+
+    bool Initialize() {
+        GlStateGuard guard(gl_, renderer_);
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize_);
+
+        GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, VERTEX_SHADER);
+        GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+        if (vertexShader && fragmentShader) {
+            program_ = gl_.glCreateProgram();
+            gl_.glAttachShader(program_, vertexShader);
+            gl_.glAttachShader(program_, fragmentShader);
+            gl_.glBindAttribLocation(program_, POSITION, "a_position");
+            gl_.glBindAttribLocation(program_, COLOR, "a_color");
+            gl_.glBindAttribLocation(program_, TEX_COORD, "a_texCoord");
+            gl_.glLinkProgram(program_);
+        }
+        if (vertexShader) {
+            gl_.glDeleteShader(vertexShader);
+        }
+        if (fragmentShader) {
+            gl_.glDeleteShader(fragmentShader);
+        }
+        GLint linked = GL_FALSE;
+        if (program_) {
+            gl_.glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+        }
+        if (!linked) {
+            char log[512] = {};
+            if (program_) {
+                gl_.glGetProgramInfoLog(program_, sizeof(log), nullptr, log);
+            }
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot link shader: " << log);
+            return false;
+        }
+        transformLocation_ = gl_.glGetUniformLocation(program_, "u_transform");
+        gl_.glUseProgram(program_);
+        gl_.glUniform1i(gl_.glGetUniformLocation(program_, "u_texture"), 0);
+
+        // Vertices are SDL_Vertex as TileBatch builds them
+        GLuint buffers[2] = {};
+        gl_.glGenBuffers(2, buffers);
+        vertexBuffer_ = buffers[0];
+        indexBuffer_ = buffers[1];
+        gl_.glGenVertexArrays(1, &vertexArray_);
+        gl_.glBindVertexArray(vertexArray_);
+        gl_.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+        gl_.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+        gl_.glEnableVertexAttribArray(POSITION);
+        gl_.glEnableVertexAttribArray(COLOR);
+        gl_.glEnableVertexAttribArray(TEX_COORD);
+        gl_.glVertexAttribPointer(POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(SDL_Vertex),
+                                  reinterpret_cast<const void*>(offsetof(SDL_Vertex, position)));
+        gl_.glVertexAttribPointer(COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SDL_Vertex),
+                                  reinterpret_cast<const void*>(offsetof(SDL_Vertex, color)));
+        gl_.glVertexAttribPointer(TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(SDL_Vertex),
+                                  reinterpret_cast<const void*>(offsetof(SDL_Vertex, tex_coord)));
+        gl_.glBindVertexArray(0);
+
+        for (UploadBuffer& buffer : uploadBuffers_) {
+            gl_.glGenBuffers(1, &buffer.id);
+        }
+
+        // FillRects draws through the same program
+        whiteTexture_ = CreateTexture(1, 1, SDL_ScaleModeNearest);
+        const uint32_t white = 0xFFFFFFFF;
+        if (!whiteTexture_ || !UpdateTexture(whiteTexture_, nullptr, &white, sizeof(white))) {
+            return false;
+        }
+        if (glGetError() != GL_NO_ERROR) {
+            return false;
+        }
+
+        hasBc1_ = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc");
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        hasBc7_ = major * 10 + minor >= 42 || SDL_GL_ExtensionSupported("GL_ARB_texture_compression_bptc");
+
+        // Optional: without it every upload is synchronous
+        if (InitializeStaging()) {
+            uploadThread_ = std::thread([this] { CopyLoop(); });
+        }
+        return true;
+    }
+
+    bool InitializeStaging() {
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major * 10 + minor < 44 && !SDL_GL_ExtensionSupported("GL_ARB_buffer_storage")) {
+            return false;
+        }
+        auto bufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(SDL_GL_GetProcAddress("glBufferStorage"));
+        if (!bufferStorage) {
+            return false;
+        }
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(STAGING_SLOT_COUNT * STAGING_SLOT_BYTES);
+        gl_.glGenBuffers(1, &stagingBuffer_);
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer_);
+        bufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        stagingMemory_ = static_cast<uint8_t*>(gl_.glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+        if (!stagingMemory_ || glGetError() != GL_NO_ERROR) {
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot map staging buffer, uploads stay synchronous");
+            if (stagingMemory_) {
+                gl_.glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                stagingMemory_ = nullptr;
+            }
+            gl_.glDeleteBuffers(1, &stagingBuffer_);
+            stagingBuffer_ = 0;
+            return false;
+        }
+        return true;
+    }
+
+    // Upload threads: copy (or compress) queued pixels into their staging
+    // slots
+    void CopyLoop() {
+        std::unique_lock<std::mutex> lock(stagingMutex_);
+        while (true) {
+            copyQueued_.wait(lock, [this] { return stopping_ || !copyJobs_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            const size_t index = copyJobs_.front();
+            copyJobs_.pop_front();
+            StagingSlot& slot = stagingSlots_[index];
+            const SDL_Rect rect = slot.rect;
+            const TextureCompression compression = slot.compression;
+            const uint8_t* source = reinterpret_cast<const uint8_t*>(slot.pixels);
+            const size_t pitch = static_cast<size_t>(slot.pitch);
+            lock.unlock();
+
+            const size_t rowBytes = static_cast<size_t>(rect.w) * sizeof(uint32_t);
+            uint8_t* dest = stagingMemory_ + index * STAGING_SLOT_BYTES;
+            if (compression != TextureCompression::None) {
+                BlockCompressor::Compress(compression, reinterpret_cast<const uint32_t*>(source),
+                                          static_cast<int>(pitch), rect.w, rect.h, dest);
+            } else if (pitch == rowBytes) {
+                std::memcpy(dest, source, rowBytes * rect.h);
+            } else {
+                for (int y = 0; y < rect.h; ++y) {
+                    std::memcpy(dest + y * rowBytes, source + y * pitch, rowBytes);
+                }
+            }
+
+            lock.lock();
+            slot.state = StagingSlot::State::Copied;
+            slot.owner.reset();
+            slot.pixels = nullptr;
+            copyDone_.notify_all();
+        }
+    }
+
+    // glTexSubImage2D (or its compressed form) from the staging buffer for
+    // each slot, in order
+    void IssueStagingSlots(const std::vector<size_t>& slots) {
+        if (slots.empty()) {
+            return;
+        }
+        GlStateGuard guard(gl_, renderer_);
+        gl_.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer_);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (size_t index : slots) {
+            StagingSlot& slot = stagingSlots_[index];
+            if (slot.cancelled) {
+                std::lock_guard<std::mutex> lock(stagingMutex_);
+                slot = StagingSlot();
+                continue;
+            }
+            glBindTexture(GL_TEXTURE_2D, slot.texture->id);
+            const void* offset = reinterpret_cast<const void*>(index * STAGING_SLOT_BYTES);
+            if (slot.compression != TextureCompression::None) {
+                const SDL_Rect blocks = BlockRect(slot.texture, slot.rect);
+                const size_t bytes = BlockCompressor::CompressedSize(slot.compression, slot.rect.w, slot.rect.h);
+                gl_.glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, blocks.x, blocks.y, blocks.w, blocks.h,
+                                              CompressedFormat(slot.compression), static_cast<GLsizei>(bytes),
+                                              offset);
+            } else {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, slot.rect.x, slot.rect.y, slot.rect.w, slot.rect.h, GL_BGRA,
+                                GL_UNSIGNED_INT_8_8_8_8_REV, offset);
+            }
+            slot.fence = gl_.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            issuedTickets_.push_back(slot.ticket);
+            std::lock_guard<std::mutex> lock(stagingMutex_);
+            slot.state = StagingSlot::State::InFlight;
+            slot.texture = nullptr;
+        }
+    }
+
+    // Free the slots whose transfers the GPU has finished
+    void ReclaimStagingSlots() {
+        for (StagingSlot& slot : stagingSlots_) {
+            {
+                std::lock_guard<std::mutex> lock(stagingMutex_);
+                if (slot.state != StagingSlot::State::InFlight) {
+                    continue;
+                }
+            }
+            GLenum status = gl_.glClientWaitSync(slot.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                continue;
+            }
+            gl_.glDeleteSync(slot.fence);
+            std::lock_guard<std::mutex> lock(stagingMutex_);
+            slot = StagingSlot();
+        }
+    }
+
+    // Before a synchronous update of area: issue the queued uploads into
+    // the texture that overlap it, waiting for their copies, so the update
+    // lands last
+    void IssueUploadsBefore(GlTexture* texture, const SDL_Rect& area) {
+        std::vector<size_t> ready;
+        {
+            std::unique_lock<std::mutex> lock(stagingMutex_);
+            auto overlaps = [&](size_t index) {
+                const StagingSlot& slot = stagingSlots_[index];
+                return slot.texture == texture && !slot.cancelled && SDL_HasIntersection(&slot.rect, &area);
+            };
+            copyDone_.wait(lock, [&] {
+                return std::none_of(stagingOrder_.begin(), stagingOrder_.end(), [&](size_t index) {
+                    return overlaps(index) && stagingSlots_[index].state == StagingSlot::State::Copying;
+                });
+            });
+            for (auto it = stagingOrder_.begin(); it != stagingOrder_.end();) {
+                if (overlaps(*it)) {
+                    ready.push_back(*it);
+                    it = stagingOrder_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        IssueStagingSlots(ready);
+    }
+
+    // Drop the queued uploads into a texture about to be destroyed
+    void CancelUploads(GlTexture* texture) {
+        std::lock_guard<std::mutex> lock(stagingMutex_);
+        for (auto it = stagingOrder_.begin(); it != stagingOrder_.end();) {
+            StagingSlot& slot = stagingSlots_[*it];
+            if (slot.texture != texture) {
+                ++it;
+            } else if (slot.state == StagingSlot::State::Copying) {
+                // The upload thread may be reading the pixels right now
+                slot.cancelled = true;
+                slot.texture = nullptr;
+                ++it;
+            } else {
+                slot = StagingSlot();
+                it = stagingOrder_.erase(it);
+            }
+        }
+    }
+
+    GLuint CompileShader(GLenum type, const char* source) {
+        GLuint shader = gl_.glCreateShader(type);
+        gl_.glShaderSource(shader, 1, &source, nullptr);
+        gl_.glCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        gl_.glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char log[512] = {};
+            gl_.glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            PATHVIEW_LOG_ERROR("GlRenderBackend: Cannot compile shader: " << log);
+            gl_.glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static void ApplyScaleMode(SDL_ScaleMode mode) {
+        GLint filter = mode == SDL_ScaleModeNearest ? GL_NEAREST : GL_LINEAR;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+
+    // SDL_Renderer's blend modes, as its OpenGL renderer sets them
+    bool ApplyBlendMode(SDL_BlendMode mode) {
+        if (mode == SDL_BLENDMODE_NONE) {
+            glDisable(GL_BLEND);
+            return true;
+        }
+        GLenum factors[4];
+        switch (mode) {
+            case SDL_BLENDMODE_INVALID:  // Premultiplied
+                factors[0] = GL_ONE; factors[1] = GL_ONE_MINUS_SRC_ALPHA;
+                factors[2] = GL_ONE; factors[3] = GL_ONE_MINUS_SRC_ALPHA;
+                break;
+            case SDL_BLENDMODE_BLEND:
+                factors[0] = GL_SRC_ALPHA; factors[1] = GL_ONE_MINUS_SRC_ALPHA;
+                factors[2] = GL_ONE; factors[3] = GL_ONE_MINUS_SRC_ALPHA;
+                break;
+            case SDL_BLENDMODE_ADD:
+                factors[0] = GL_SRC_ALPHA; factors[1] = GL_ONE;
+                factors[2] = GL_ZERO; factors[3] = GL_ONE;
+                break;
+            case SDL_BLENDMODE_MOD:
+                factors[0] = GL_ZERO; factors[1] = GL_SRC_COLOR;
+                factors[2] = GL_ZERO; factors[3] = GL_ONE;
+                break;
+            default:
+                return false;
+        }
+        glEnable(GL_BLEND);
+        gl_.glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+        gl_.glBlendFuncSeparate(factors[0], factors[1], factors[2], factors[3]);
+        return true;
+    }
+
+    // Program, vertex arrays, blending, viewport and clip rectangle for a
+    // draw in SDL_Renderer's current render coordinates. False if there is
+    // nothing to draw into.
+    bool BeginDraw(SDL_BlendMode blendMode) {
+        SDL_Rect viewport;
+        float scaleX = 1.0f;
+        float scaleY = 1.0f;
+        SDL_RenderGetViewport(renderer_, &viewport);
+        SDL_RenderGetScale(renderer_, &scaleX, &scaleY);
+
+        // Render targets are stored bottom-up, the window top-down
+        int outputWidth = 0;
+        int outputHeight = 0;
+        SDL_Texture* target = SDL_GetRenderTarget(renderer_);
+        if (target) {
+            SDL_QueryTexture(target, nullptr, nullptr, &outputWidth, &outputHeight);
+        } else {
+            SDL_GetRendererOutputSize(renderer_, &outputWidth, &outputHeight);
+        }
+        const int x = static_cast<int>(std::lround(viewport.x * scaleX));
+        const int y = static_cast<int>(std::lround(viewport.y * scaleY));
+        const int w = static_cast<int>(std::lround(viewport.w * scaleX));
+        const int h = static_cast<int>(std::lround(viewport.h * scaleY));
+        if (w <= 0 || h <= 0 || !ApplyBlendMode(blendMode)) {
+            return false;
+        }
+        glViewport(x, target ? y : outputHeight - y - h, w, h);
+
+        if (SDL_RenderIsClipEnabled(renderer_)) {
+            SDL_Rect clip;
+            SDL_RenderGetClipRect(renderer_, &clip);
+            const int clipX = x + static_cast<int>(std::lround(clip.x * scaleX));
+            const int clipY = y + static_cast<int>(std::lround(clip.y * scaleY));
+            const int clipW = static_cast<int>(std::lround(clip.w * scaleX));
+            const int clipH = static_cast<int>(std::lround(clip.h * scaleY));
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(clipX, target ? clipY : outputHeight - clipY - clipH, clipW, clipH);
+        } else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_STENCIL_TEST);
+
+        gl_.glUseProgram(program_);
+        const float sx = 2.0f * scaleX / w;
+        const float sy = 2.0f * scaleY / h;
+        if (target) {
+            gl_.glUniform4f(transformLocation_, sx, sy, -1.0f, -1.0f);
+        } else {
+            gl_.glUniform4f(transformLocation_, sx, -sy, -1.0f, 1.0f);
+        }
+        gl_.glBindVertexArray(vertexArray_);
+        gl_.glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+        return true;
+    }
+
+    SDL_Renderer* renderer_;
+    GlFunctions gl_;
+    GLint maxTextureSize_ = 0;
+    GLuint program_ = 0;
+    GLint transformLocation_ = -1;
+    GLuint vertexArray_ = 0;
+    GLuint vertexBuffer_ = 0;
+    GLuint indexBuffer_ = 0;
+    UploadBuffer uploadBuffers_[UPLOAD_BUFFER_COUNT];
+    size_t nextUpload_ = 0;
+    ReadbackBuffer readbackBuffers_[READBACK_BUFFER_COUNT];
+    uint64_t nextReadbackTicket_ = 1;
+    RenderTexture* whiteTexture_ = nullptr;
+    bool hasBc1_ = false;
+    bool hasBc7_ = false;
+
+    // Asynchronous uploads, when uploadThread_ runs
+    GLuint stagingBuffer_ = 0;
+    uint8_t* stagingMemory_ = nullptr;
+    StagingSlot stagingSlots_[STAGING_SLOT_COUNT];
+    std::deque<size_t> stagingOrder_;  // Copying and Copied slots, oldest first
+    std::deque<size_t> copyJobs_;
+    std::vector<uint64_t> issuedTickets_;
+    std::mutex stagingMutex_;
+    std::condition_variable copyQueued_;
+    std::condition_variable copyDone_;
+    bool stopping_ = false;
+    std::thread uploadThread_;
+    std::vector<std::thread> compressThreads_;  // More copy loops, once textures are compressed
+};
+
+}  // namespace
+
+std::unique_ptr<RenderBackend> RenderBackend::Create(SDL_Renderer* renderer) {
+    std::unique_ptr<RenderBackend> backend = GlRenderBackend::Create(renderer);
+    if (!backend) {
+        backend = std::make_unique<SdlRenderBackend>(renderer);
+    }
+    PATHVIEW_LOG_INFO("Render backend: " << backend->GetName());
+    return backend;
+}
+
+#else
+
+std::unique_ptr<RenderBackend> RenderBackend::Create(SDL_Renderer* renderer) {
+    return std::make_unique<SdlRenderBackend>(renderer);
+}
+
+#endif  // PATHVIEW_HAS_OPENGL3
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "BlockCompressor.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Texture of a RenderBackend, opaque outside it
+struct RenderTexture;
+
+// GPU operations of the slide's tile path (TextureManager, TileBatch,
+// SlideRenderer): textures of premultiplied TILE_PIXEL_FORMAT pixels,
+// batched textured triangles and flat rectangles. Draws use the render
+// coordinates of the SDL_Renderer the backend was created for: its render
+// target, viewport, scale and clip rectangle all apply, so tiles interleave
+// with everything drawn through the SDL_Renderer directly (overlays, the
+// minimap, ImGui).
+//
+// SdlRenderBackend draws through SDL_Renderer and works everywhere.
+// GlRenderBackend draws with its own shader, streamed uploads and fenced
+// readbacks on the SDL_Renderer's OpenGL context, where there is one.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // Largest texture width and height, 0 if unknown
+    virtual int32_t GetMaxTextureSize() const = 0;
+
+    // Texture for width x height premultiplied pixels, contents undefined
+    // until updated; nullptr on failure
+    virtual RenderTexture* CreateTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode) = 0;
+
+    // Block-compressed textures (BlockCompressor), for backends that can
+    // sample them. UpdateTexture and QueueUpload take the same pixels as
+    // for any texture and compress them on the way: rect corners must lie
+    // on the 4x4 block grid, or the texture's right and bottom edges.
+    virtual bool SupportsCompression(TextureCompression compression) const {
+        return compression == TextureCompression::None;
+    }
+    virtual RenderTexture* CreateCompressedTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode,
+                                                   TextureCompression compression) {
+        return compression == TextureCompression::None ? CreateTexture(width, height, scaleMode) : nullptr;
+    }
+    virtual void DestroyTexture(RenderTexture* texture) = 0;
+    virtual bool GetTextureSize(RenderTexture* texture, int32_t* width, int32_t* height) const = 0;
+    virtual void SetTextureScaleMode(RenderTexture* texture, SDL_ScaleMode mode) = 0;
+
+    // Copy pixels (rows pitch bytes apart) into rect of the texture
+    // (nullptr: all of it). pixels may be reused once this returns; the
+    // transfer itself may still be in flight.
+    virtual bool UpdateTexture(RenderTexture* texture, const SDL_Rect* rect, const uint32_t* pixels,
+                               int pitch) = 0;
+
+    // Asynchronous uploads, for backends with staging memory an upload
+    // thread can fill. QueueUpload returns at once: the pixels (kept alive
+    // by owner until copied) go to rect of the texture off the render
+    // thread, and a later PollUploads() reports ticket once the texture may
+    // be drawn with them. Uploads into a texture land in the order queued,
+    // before any later UpdateTexture of it. False if the upload was not
+    // queued (unsupported, too large, staging full): use UpdateTexture.
+    virtual bool HasAsyncUploads() const = 0;
+    virtual bool QueueUpload(RenderTexture* texture, const SDL_Rect& rect, std::shared_ptr<const void> owner,
+                             const uint32_t* pixels, int pitch, uint64_t ticket) = 0;
+
+    // Append the tickets of queued uploads that became drawable since the
+    // last call. Called once per frame.
+    virtual void PollUploads(std::vector<uint64_t>* completed) = 0;
+
+    // Asynchronous readback, for backends with fences. StartReadback
+    // queues a copy of rect of the SDL_Renderer's current render target
+    // (its pixels: viewport and scale do not apply) into GPU memory and
+    // returns a ticket at once; 0 if it cannot (unsupported, every buffer
+    // in flight): use SDL_RenderReadPixels. FinishReadback is false while
+    // the copy is in flight, or blocks until it is done with wait; then it
+    // fills pixels with rect's RGBA32 pixels, top row first, or leaves
+    // them empty if the copy failed, and the ticket is spent.
+    virtual bool HasAsyncReadback() const { return false; }
+    virtual uint64_t StartReadback(const SDL_Rect& rect) {
+        (void)rect;
+        return 0;
+    }
+    virtual bool FinishReadback(uint64_t ticket, std::vector<uint8_t>* pixels, bool wait) {
+        (void)ticket;
+        (void)wait;
+        pixels->clear();
+        return true;
+    }
+
+    // Indexed triangles with normalized texture coordinates, their texels
+    // multiplied by the vertex colors. SDL_BLENDMODE_INVALID blends
+    // premultiplied: out = src + dst * (1 - srcAlpha).
+    virtual bool DrawGeometry(RenderTexture* texture, const SDL_Vertex* vertices, int vertexCount,
+                              const int* indices, int indexCount, SDL_BlendMode blendMode) = 0;
+
+    // Opaque rectangles of one color
+    virtual void FillRects(const SDL_Rect* rects, int count, SDL_Color color) = 0;
+
+    // Pane later draws are relative to (nullptr: the whole render target)
+    virtual void SetViewport(const SDL_Rect* rect) = 0;
+
+    // OpenGL 3 where this build has it (PATHVIEW_HAS_OPENGL3) and renderer
+    // runs on a context that supports it, SDL_Renderer otherwise
+    static std::unique_ptr<RenderBackend> Create(SDL_Renderer* renderer);
+};
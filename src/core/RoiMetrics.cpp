@@ -0,0 +1,281 @@
+#include "RoiMetrics.h"
+#include "CellStatsPyramid.h"
+#include "PolygonClip.h"
+#include "PolygonIndex.h"
+#include "PolygonMask.h"
+#include "TissueMap.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+constexpr int SAMPLES = RoiMetrics::RASTER_SAMPLES;
+
+// Fraction of a cell inside the outline, from a grid of points over its box
+double SampleCell(const PolygonClip& clip, const PolygonStore& polygons, uint32_t polygon) {
+    const Rect box = polygons.GetBoundingBox(polygon);
+    int inCell = 0, inBoth = 0;
+    for (int sy = 0; sy < SAMPLES; ++sy) {
+        const double y = box.y + (sy + 0.5) * box.height / SAMPLES;
+        for (int sx = 0; sx < SAMPLES; ++sx) {
+            const double x = box.x + (sx + 0.5) * box.width / SAMPLES;
+            if (polygons.Contains(polygon, x, y)) {
+                ++inCell;
+                inBoth += clip.Contains(x, y) ? 1 : 0;
+            }
+        }
+    }
+    return inCell > 0 ? double(inBoth) / inCell : 0.0;
+}
+
+// Fraction of a box inside the outline, the same way
+double SampleBox(const PolygonClip& clip, const Rect& box) {
+    int inside = 0;
+    for (int sy = 0; sy < SAMPLES; ++sy) {
+        const double y = box.y + (sy + 0.5) * box.height / SAMPLES;
+        for (int sx = 0; sx < SAMPLES; ++sx) {
+            inside += clip.Contains(box.x + (sx + 0.5) * box.width / SAMPLES, y) ? 1 : 0;
+        }
+    }
+    return double(inside) / (SAMPLES * SAMPLES);
+}
+
+// Cells wholly inside count whole, straddling ones by their part inside
+void AddCellOverlap(const PolygonClip& clip, const PolygonStore& polygons, const PolygonIndex* index,
+                    const RoiMetrics::Options& options, RoiMetrics& metrics) {
+    std::vector<uint32_t> candidates;
+    if (index && index->Size() == polygons.Size()) {
+        index->QueryRegion(clip.GetBounds(), candidates);
+    } else {
+        const uint32_t polygonCount = static_cast<uint32_t>(polygons.Size());
+        for (uint32_t polygon = 0; polygon < polygonCount; ++polygon) {
+            if (polygons.Intersects(polygon, clip.GetBounds())) {
+                candidates.push_back(polygon);
+            }
+        }
+    }
+    const bool raster = options.cellOverlap == RoiMetrics::CellOverlap::RASTER ||
+                        (options.cellOverlap == RoiMetrics::CellOverlap::AUTO &&
+                         candidates.size() > RoiMetrics::AUTO_EXACT_CELLS);
+
+    for (uint32_t polygon : candidates) {
+        const double cellArea = polygons.GetArea(polygon);
+        if (polygons.GetVertexCount(polygon) == 0 || polygons.GetConfidence(polygon) < options.minConfidence ||
+            !(cellArea > 0.0)) {
+            continue;
+        }
+        double inside = 0.0;
+        switch (clip.Classify(polygons.GetBoundingBox(polygon))) {
+            case PolygonMask::NONE:
+                continue;
+            case PolygonMask::WHOLE:
+                inside = cellArea;
+                break;
+            case PolygonMask::PARTIAL:
+                inside = raster ? SampleCell(clip, polygons, polygon) * cellArea
+                                : clip.OverlapArea(polygons.GetVertices(polygon), polygons.GetVertexCount(polygon));
+                break;
+        }
+        if (inside > 0.0) {
+            const int classId = polygons.GetClassId(polygon);
+            metrics.cellFractions[classId] += std::min(1.0, inside / cellArea);
+            metrics.cellAreas[classId] += std::min(inside, cellArea);
+        }
+    }
+}
+
+// Level 0 texels inside count whole, those on the outline by their part inside
+void AddTissueAreas(const PolygonClip& clip, const TissueMap& map, bool raster, std::map<int, double>& areas) {
+    const Rect& bounds = clip.GetBounds();
+    std::vector<TissueMap::TileCoord> tiles;
+    map.GetTilesInRegion(0, bounds, tiles);
+
+    const double texel = map.GetTexelSize(0);
+    const uint8_t emptyLabel = map.GetEmptyLabel();
+    std::array<double, 256> byLabel{};
+    auto texelRange = [&](double from, double to, double origin, int32_t& first, int32_t& last) {
+        first = static_cast<int32_t>(std::max(0.0, std::floor((from - origin) / texel)));
+        last = static_cast<int32_t>(std::min(double(TissueMap::TILE_SIZE - 1), std::floor((to - origin) / texel)));
+    };
+    for (const TissueMap::TileCoord& tile : tiles) {
+        const uint8_t* labels = map.GetTile(0, tile.x, tile.y);
+        if (!labels) {
+            continue;
+        }
+        const Rect tileBounds = map.GetTileBounds(0, tile.x, tile.y);
+        int32_t firstColumn, lastColumn, firstRow, lastRow;
+        texelRange(bounds.x, bounds.Right(), tileBounds.x, firstColumn, lastColumn);
+        texelRange(bounds.y, bounds.Bottom(), tileBounds.y, firstRow, lastRow);
+        for (int32_t row = firstRow; row <= lastRow; ++row) {
+            for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+                const uint8_t label = labels[size_t(row) * TissueMap::TILE_SIZE + column];
+                if (label == emptyLabel) {
+                    continue;
+                }
+                const Rect box(tileBounds.x + column * texel, tileBounds.y + row * texel, texel, texel);
+                switch (clip.Classify(box)) {
+                    case PolygonMask::NONE:
+                        break;
+                    case PolygonMask::WHOLE:
+                        byLabel[label] += texel * texel;
+                        break;
+                    case PolygonMask::PARTIAL:
+                        byLabel[label] += raster ? SampleBox(clip, box) * texel * texel : clip.OverlapArea(box);
+                        break;
+                }
+            }
+        }
+    }
+    for (size_t label = 0; label < byLabel.size(); ++label) {
+        if (byLabel[label] > 0.0) {
+            areas[int(label)] += byLabel[label];
+        }
+    }
+}
+
+}  // namespace
+
+RoiMetrics RoiMetrics::Compute(const std::vector<Vec2>& vertices, const PolygonStore* polygons,
+                               const PolygonIndex* index, float minConfidence) {
+    Options options;
+    options.minConfidence = minConfidence;
+    return Compute(vertices, polygons, index, options);
+}
+
+RoiMetrics RoiMetrics::Compute(const std::vector<Vec2>& vertices, const PolygonStore* polygons,
+                               const PolygonIndex* index, const Options& options) {
+    RoiMetrics metrics;
+    if (vertices.empty()) {
+        return metrics;
+    }
+
+    double minX = vertices[0].x, maxX = minX;
+    double minY = vertices[0].y, maxY = minY;
+    for (const Vec2& v : vertices) {
+        minX = std::min(minX, v.x);
+        maxX = std::max(maxX, v.x);
+        minY = std::min(minY, v.y);
+        maxY = std::max(maxY, v.y);
+    }
+    metrics.boundingBox = Rect(minX, minY, maxX - minX, maxY - minY);
+    metrics.area = Area(vertices);
+    metrics.perimeter = Perimeter(vertices);
+
+    if (polygons && options.cellStats && options.minConfidence <= options.cellStats->GetMinConfidence()) {
+        std::map<int, CellStatsPyramid::ClassStats> stats;
+        options.cellStats->Summarize(*polygons, PolygonMask(vertices), stats);
+        for (const auto& [classId, classStats] : stats) {
+            metrics.cellCounts[classId] = static_cast<int>(classStats.count);
+        }
+    } else if (polygons) {
+        PolygonMask(vertices).CountCentroids(*polygons, index, metrics.cellCounts, options.minConfidence,
+                                             options.threadCount);
+    }
+    for (const auto& [classId, count] : metrics.cellCounts) {
+        metrics.totalCells += count;
+    }
+
+    const bool overlap = polygons && options.cellOverlap != CellOverlap::CENTROID;
+    if (overlap || options.tissueMap) {
+        PolygonClip clip(vertices);
+        if (overlap) {
+            AddCellOverlap(clip, *polygons, index, options, metrics);
+        }
+        if (options.tissueMap) {
+            AddTissueAreas(clip, *options.tissueMap, options.cellOverlap == CellOverlap::RASTER,
+                           metrics.tissueAreas);
+        }
+    }
+    return metrics;
+}
+
+double RoiMetrics::Area(const std::vector<Vec2>& vertices) {
+    if (vertices.size() < 3) return 0.0;
+
+    // Shoelace formula: Area = 0.5 * |Σ(x_i * y_{i+1} - x_{i+1} * y_i)|
+    double area = 0.0;
+    size_t n = vertices.size();
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        area += vertices[i].x * vertices[j].y;
+        area -= vertices[j].x * vertices[i].y;
+    }
+
+    return std::abs(area) / 2.0;
+}
+
+double RoiMetrics::Perimeter(const std::vector<Vec2>& vertices) {
+    if (vertices.size() < 2) return 0.0;
+
+    double perimeter = 0.0;
+    size_t n = vertices.size();
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = (i + 1) % n;
+        double dx = vertices[j].x - vertices[i].x;
+        double dy = vertices[j].y - vertices[i].y;
+        perimeter += std::sqrt(dx * dx + dy * dy);
+    }
+
+    return perimeter;
+}
+
+RoiMetricsBatch::RoiMetricsBatch(std::vector<std::vector<Vec2>> rois, const PolygonStore* polygons,
+                                 const PolygonIndex* index, const RoiMetrics::Options& options,
+                                 size_t threadCount)
+    : rois_(std::move(rois))
+    , polygons_(polygons)
+    , index_(index)
+    , options_(options)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    }
+    threadCount = std::min(std::max<size_t>(threadCount, 1), rois_.size());
+    results_.reserve(rois_.size());
+
+    runningWorkers_.store(threadCount, std::memory_order_release);
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&RoiMetricsBatch::Work, this);
+    }
+}
+
+RoiMetricsBatch::~RoiMetricsBatch() {
+    Cancel();
+}
+
+void RoiMetricsBatch::Cancel() {
+    cancelled_.store(true, std::memory_order_relaxed);
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t RoiMetricsBatch::GetResults(size_t since, std::vector<Result>& out) const {
+    std::lock_guard<std::mutex> lock(resultsMutex_);
+    for (size_t i = since; i < results_.size(); ++i) {
+        out.push_back(results_[i]);
+    }
+    return results_.size();
+}
+
+void RoiMetricsBatch::Work() {
+    // The batch already keeps the cores busy, one outline each
+    RoiMetrics::Options options = options_;
+    options.threadCount = 1;
+    while (!cancelled_.load(std::memory_order_relaxed)) {
+        const size_t roi = nextRoi_.fetch_add(1, std::memory_order_relaxed);
+        if (roi >= rois_.size()) {
+            break;
+        }
+        RoiMetrics metrics = RoiMetrics::Compute(rois_[roi], polygons_, index_, options);
+        std::lock_guard<std::mutex> lock(resultsMutex_);
+        results_.push_back({roi, std::move(metrics)});
+    }
+    runningWorkers_.fetch_sub(1, std::memory_order_acq_rel);
+}
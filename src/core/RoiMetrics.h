@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Viewport.h"  // For Vec2, Rect
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CellStatsPyramid;
+class PolygonIndex;
+class PolygonStore;
+class TissueMap;
+
+// Area, perimeter and cell counts of a region of interest outline
+struct RoiMetrics {
+    Rect boundingBox;
+    double area = 0.0;
+    double perimeter = 0.0;
+    std::map<int, int> cellCounts;  // Class ID -> cells whose centroid is inside
+    int totalCells = 0;
+
+    // With a cell overlap other than CENTROID, per class: the fractions of
+    // the cells' areas inside, summed (a fractional count), and that area
+    std::map<int, double> cellFractions;
+    std::map<int, double> cellAreas;
+
+    // With a tissue map: tissue label -> area inside (empty label left out)
+    std::map<int, double> tissueAreas;
+
+    // How cells straddling the outline are counted besides by centroid
+    enum class CellOverlap {
+        CENTROID,  // Not at all: only cellCounts
+        EXACT,     // Clipped against the outline (PolygonClip)
+        RASTER,    // Estimated from RASTER_SAMPLES^2 sample points
+        AUTO       // EXACT up to AUTO_EXACT_CELLS candidate cells, RASTER beyond
+    };
+
+    struct Options {
+        float minConfidence = 0.0f;  // Cells with a lower confidence are not counted
+        CellOverlap cellOverlap = CellOverlap::CENTROID;
+        const TissueMap* tissueMap = nullptr;  // Fills tissueAreas when set
+        // Built over polygons: counts from its sums (only bins across the
+        // outline visit cells) when minConfidence leaves every cell in
+        const CellStatsPyramid* cellStats = nullptr;
+        // Threads counting centroids, 0 for the hardware threads
+        size_t threadCount = 0;
+    };
+
+    /**
+     * Metrics of an outline of at least 3 vertices
+     * @param polygons Cells to count; null leaves the counts empty
+     * @param index Spatial index over polygons, or null to scan them
+     * @param minConfidence Cells with a lower confidence are not counted
+     */
+    static RoiMetrics Compute(const std::vector<Vec2>& vertices, const PolygonStore* polygons,
+                              const PolygonIndex* index, float minConfidence = 0.0f);
+    static RoiMetrics Compute(const std::vector<Vec2>& vertices, const PolygonStore* polygons,
+                              const PolygonIndex* index, const Options& options);
+
+    // Shoelace area and closed perimeter of an outline
+    static double Area(const std::vector<Vec2>& vertices);
+    static double Perimeter(const std::vector<Vec2>& vertices);
+
+    static constexpr int RASTER_SAMPLES = 8;
+    static constexpr size_t AUTO_EXACT_CELLS = 50000;
+};
+
+// RoiMetrics of many outlines computed on worker threads, for agents that
+// probe dozens of candidate regions at once. Results are collected as they
+// finish, so a caller can poll them without waiting for the whole batch.
+//
+// Workers read the store, index and tissue map unlocked: the owner must
+// Cancel() (or destroy) the batch before any of them changes.
+class RoiMetricsBatch {
+public:
+    struct Result {
+        size_t roi;  // Position of the outline in the batch
+        RoiMetrics metrics;
+    };
+
+    /**
+     * Start computing every outline
+     * @param rois Outlines, each of at least 3 vertices
+     * @param threadCount Worker threads (0: one per core but one, leaving
+     *        the GUI thread its own); never more than there are outlines
+     */
+    RoiMetricsBatch(std::vector<std::vector<Vec2>> rois, const PolygonStore* polygons,
+                    const PolygonIndex* index, const RoiMetrics::Options& options, size_t threadCount = 0);
+    ~RoiMetricsBatch();
+
+    RoiMetricsBatch(const RoiMetricsBatch&) = delete;
+    RoiMetricsBatch& operator=(const RoiMetricsBatch&) = delete;
+
+    // Skip the outlines not started yet and wait for the running ones; no
+    // worker touches the store afterwards
+    void Cancel();
+
+    /**
+     * Results finished so far, in the order they finished
+     * @param since Results already taken; only later ones are appended
+     * @param out Receives the results after the first since
+     * @return Number of results finished so far
+     */
+    size_t GetResults(size_t since, std::vector<Result>& out) const;
+
+    size_t GetRoiCount() const { return rois_.size(); }
+    const RoiMetrics::Options& GetOptions() const { return options_; }
+
+    // Every worker has stopped: all outlines finished, or the batch was cancelled
+    bool IsDone() const { return runningWorkers_.load(std::memory_order_acquire) == 0; }
+
+private:
+    void Work();
+
+    const std::vector<std::vector<Vec2>> rois_;
+    const PolygonStore* polygons_;
+    const PolygonIndex* index_;
+    const RoiMetrics::Options options_;
+
+    std::atomic<size_t> nextRoi_{0};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<size_t> runningWorkers_{0};
+    mutable std::mutex resultsMutex_;
+    std::vector<Result> results_;
+    std::vector<std::thread> workers_;
+};
@@ -27,30 +27,31 @@ bool ScreenshotBuffer::IsReady() const {
     return ready_;
 }
 
-void ScreenshotBuffer::StoreCapture(const std::vector<uint8_t>& pixels, int width, int height) {
+void ScreenshotBuffer::StoreCapture(std::vector<uint8_t>& pixels, int width, int height) {
     std::lock_guard<std::mutex> lock(mutex_);
-    pixels_ = pixels;
+    pixels_.swap(pixels);
     width_ = width;
     height_ = height;
     ready_ = true;
 }
 
-bool ScreenshotBuffer::GetCapture(std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight) {
+size_t ScreenshotBuffer::GetMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pixels_.capacity();
+}
+
+bool ScreenshotBuffer::TakeCapture(std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     if (!ready_) {
         return false;
     }
 
-    outPixels = pixels_;
+    outPixels.swap(pixels_);
     outWidth = width_;
     outHeight = height_;
-    return true;
-}
-
-void ScreenshotBuffer::MarkAsRead() {
-    std::lock_guard<std::mutex> lock(mutex_);
     ready_ = false;
+    return true;
 }
 
 } // namespace pathview
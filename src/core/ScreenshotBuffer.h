@@ -13,6 +13,10 @@ namespace pathview {
  * This class manages a buffer for capturing screenshots from the renderer.
  * It provides thread-safe access for the rendering thread to write pixel data
  * and for the IPC handler thread to read and encode the captured data.
+ *
+ * Pixels change hands by swapping vectors, never by copying: a store hands
+ * the writer back the storage of the capture it replaces, to read the next
+ * one into, and a read takes the capture out.
  */
 class ScreenshotBuffer {
 public:
@@ -47,25 +51,27 @@ public:
 
     /**
      * Store captured pixel data (called by rendering thread)
-     * @param pixels RGBA pixel data
+     * @param pixels RGBA pixel data; swapped with the buffer's, so it
+     *        returns holding the previous capture's storage for reuse
      * @param width Image width
      * @param height Image height
      */
-    void StoreCapture(const std::vector<uint8_t>& pixels, int width, int height);
+    void StoreCapture(std::vector<uint8_t>& pixels, int width, int height);
 
     /**
-     * Get captured pixel data (thread-safe)
-     * @param outPixels Output vector for pixel data
+     * Take the captured pixel data out (thread-safe); marks it read
+     * @param outPixels Output vector for pixel data, swapped with the
+     *        buffer's (whatever it held becomes the buffer's spare storage)
      * @param outWidth Output width
      * @param outHeight Output height
      * @return true if data was available, false otherwise
      */
-    bool GetCapture(std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight);
+    bool TakeCapture(std::vector<uint8_t>& outPixels, int& outWidth, int& outHeight);
 
     /**
-     * Mark the buffer as read (clears ready flag)
+     * Bytes held by the last capture (thread-safe)
      */
-    void MarkAsRead();
+    size_t GetMemoryUsage() const;
 
 private:
     std::vector<uint8_t> pixels_;
@@ -0,0 +1,100 @@
+#include "SdlRenderBackend.h"
+#include "TextureManager.h"
+#include "Log.h"
+#include <algorithm>
+
+SdlRenderBackend::SdlRenderBackend(SDL_Renderer* renderer)
+    : renderer_(renderer)
+{
+}
+
+int32_t SdlRenderBackend::GetMaxTextureSize() const {
+    // 0 from the renderer means no limit
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer_, &info) != 0) {
+        return 0;
+    }
+    if (info.max_texture_width > 0 && info.max_texture_height > 0) {
+        return std::min(info.max_texture_width, info.max_texture_height);
+    }
+    return std::max(info.max_texture_width, info.max_texture_height);
+}
+
+RenderTexture* SdlRenderBackend::CreateTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT,
+                                             SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) {
+        PATHVIEW_LOG_ERROR("SdlRenderBackend: Cannot create texture: " << SDL_GetError());
+        return nullptr;
+    }
+    TextureManager::ApplyPremultipliedBlendMode(texture);
+    SDL_SetTextureScaleMode(texture, scaleMode);
+    return reinterpret_cast<RenderTexture*>(texture);
+}
+
+void SdlRenderBackend::DestroyTexture(RenderTexture* texture) {
+    if (texture) {
+        SDL_DestroyTexture(ToSdl(texture));
+    }
+}
+
+bool SdlRenderBackend::GetTextureSize(RenderTexture* texture, int32_t* width, int32_t* height) const {
+    int w = 0;
+    int h = 0;
+    if (!texture || SDL_QueryTexture(ToSdl(texture), nullptr, nullptr, &w, &h) != 0) {
+        return false;
+    }
+    *width = w;
+    *height = h;
+    return true;
+}
+
+void SdlRenderBackend::SetTextureScaleMode(RenderTexture* texture, SDL_ScaleMode mode) {
+    SDL_SetTextureScaleMode(ToSdl(texture), mode);
+}
+
+bool SdlRenderBackend::UpdateTexture(RenderTexture* texture, const SDL_Rect* rect, const uint32_t* pixels,
+                                     int pitch) {
+    if (SDL_UpdateTexture(ToSdl(texture), rect, pixels, pitch) != 0) {
+        PATHVIEW_LOG_ERROR("SdlRenderBackend: Cannot update texture: " << SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+bool SdlRenderBackend::QueueUpload(RenderTexture*, const SDL_Rect&, std::shared_ptr<const void>, const uint32_t*,
+                                   int, uint64_t) {
+    return false;
+}
+
+void SdlRenderBackend::PollUploads(std::vector<uint64_t>*) {
+}
+
+bool SdlRenderBackend::DrawGeometry(RenderTexture* texture, const SDL_Vertex* vertices, int vertexCount,
+                                    const int* indices, int indexCount, SDL_BlendMode blendMode) {
+    // Override the texture's premultiplied mode for this draw only
+    SDL_Texture* sdlTexture = ToSdl(texture);
+    SDL_BlendMode textureMode = SDL_BLENDMODE_NONE;
+    const bool overrideMode = blendMode != SDL_BLENDMODE_INVALID &&
+                              SDL_GetTextureBlendMode(sdlTexture, &textureMode) == 0;
+    if (overrideMode) {
+        SDL_SetTextureBlendMode(sdlTexture, blendMode);
+    }
+    bool drawn = SDL_RenderGeometry(renderer_, sdlTexture, vertices, vertexCount, indices, indexCount) == 0;
+    if (overrideMode) {
+        SDL_SetTextureBlendMode(sdlTexture, textureMode);
+    }
+    return drawn;
+}
+
+void SdlRenderBackend::FillRects(const SDL_Rect* rects, int count, SDL_Color color) {
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(renderer_, &r, &g, &b, &a);
+    SDL_SetRenderDrawColor(renderer_, color.r, color.g, color.b, 0xFF);
+    SDL_RenderFillRects(renderer_, rects, count);
+    SDL_SetRenderDrawColor(renderer_, r, g, b, a);
+}
+
+void SdlRenderBackend::SetViewport(const SDL_Rect* rect) {
+    SDL_RenderSetViewport(renderer_, rect);
+}
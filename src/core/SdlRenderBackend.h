@@ -0,0 +1,37 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// RenderBackend on SDL_Renderer: every RenderTexture is an SDL_Texture
+// with the premultiplied blend mode (see
+// TextureManager::ApplyPremultipliedBlendMode). The fallback for every
+// renderer, software included.
+class SdlRenderBackend : public RenderBackend {
+public:
+    explicit SdlRenderBackend(SDL_Renderer* renderer);
+
+    const char* GetName() const override { return "SDL_Renderer"; }
+    int32_t GetMaxTextureSize() const override;
+
+    RenderTexture* CreateTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode) override;
+    void DestroyTexture(RenderTexture* texture) override;
+    bool GetTextureSize(RenderTexture* texture, int32_t* width, int32_t* height) const override;
+    void SetTextureScaleMode(RenderTexture* texture, SDL_ScaleMode mode) override;
+    bool UpdateTexture(RenderTexture* texture, const SDL_Rect* rect, const uint32_t* pixels, int pitch) override;
+
+    // SDL_UpdateTexture only: nothing is ever queued
+    bool HasAsyncUploads() const override { return false; }
+    bool QueueUpload(RenderTexture* texture, const SDL_Rect& rect, std::shared_ptr<const void> owner,
+                     const uint32_t* pixels, int pitch, uint64_t ticket) override;
+    void PollUploads(std::vector<uint64_t>* completed) override;
+
+    bool DrawGeometry(RenderTexture* texture, const SDL_Vertex* vertices, int vertexCount,
+                      const int* indices, int indexCount, SDL_BlendMode blendMode) override;
+    void FillRects(const SDL_Rect* rects, int count, SDL_Color color) override;
+    void SetViewport(const SDL_Rect* rect) override;
+
+    static SDL_Texture* ToSdl(RenderTexture* texture) { return reinterpret_cast<SDL_Texture*>(texture); }
+
+private:
+    SDL_Renderer* renderer_;
+};
@@ -0,0 +1,214 @@
+#include "Session.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* MAGIC = "pathview-session";
+constexpr int VERSION = 1;
+
+}  // namespace
+
+namespace Session {
+
+bool Save(const std::string& path, const SessionState& state) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << std::setprecision(17);
+        out << MAGIC << " " << VERSION << "\n";
+        if (!state.slidePath.empty()) {
+            out << "slide " << state.slidePath << "\n";
+        }
+        if (state.hasView) {
+            out << "view " << state.viewCenter.x << " " << state.viewCenter.y << " " << state.viewZoom << "\n";
+        }
+        if (!state.polygonPath.empty()) {
+            out << "polygons " << state.polygonPath << "\n";
+        }
+        if (!state.heatmapPath.empty()) {
+            // The texel size goes first: the path runs to the end of the line
+            out << "heatmap " << state.heatmapTexelSize << " " << state.heatmapPath << "\n";
+        }
+        if (!state.worklist.empty()) {
+            if (state.worklistIndex != Worklist::NO_ENTRY) {
+                out << "worklist " << state.worklistIndex << "\n";
+            }
+            for (const WorklistEntry& entry : state.worklist) {
+                out << "entry " << entry.slidePath;
+                if (!entry.polygonPath.empty()) {
+                    out << "\t" << entry.polygonPath;
+                }
+                out << "\n";
+            }
+        }
+        const size_t tiles = std::min(state.warmTiles.size(), MAX_WARM_TILES);
+        for (size_t i = 0; i < tiles; ++i) {
+            const TileKey& key = state.warmTiles[i];
+            out << "tile " << key.level << " " << key.tileX << " " << key.tileY << "\n";
+        }
+        out.flush();
+        if (!out) {
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool Load(const std::string& path, SessionState& state) {
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        return false;
+    }
+    {
+        std::istringstream header(line);
+        std::string magic;
+        int version = 0;
+        if (!(header >> magic >> version) || magic != MAGIC || version != VERSION) {
+            return false;
+        }
+    }
+
+    state = SessionState();
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const size_t space = line.find(' ');
+        if (space == std::string::npos) {
+            continue;
+        }
+        const std::string key = line.substr(0, space);
+        const std::string value = line.substr(space + 1);
+        std::istringstream fields(value);
+
+        if (key == "slide") {
+            state.slidePath = value;
+        } else if (key == "view") {
+            double x = 0.0;
+            double y = 0.0;
+            double zoom = 0.0;
+            if (fields >> x >> y >> zoom && zoom > 0.0) {
+                state.viewCenter = Vec2(x, y);
+                state.viewZoom = zoom;
+                state.hasView = true;
+            }
+        } else if (key == "polygons") {
+            state.polygonPath = value;
+        } else if (key == "heatmap") {
+            double texelSize = 0.0;
+            if (fields >> texelSize) {
+                std::string rest;
+                std::getline(fields >> std::ws, rest);
+                state.heatmapTexelSize = texelSize;
+                state.heatmapPath = rest;
+            }
+        } else if (key == "worklist") {
+            size_t index = 0;
+            if (fields >> index) {
+                state.worklistIndex = index;
+            }
+        } else if (key == "entry") {
+            WorklistEntry entry;
+            const size_t tab = value.find('\t');
+            entry.slidePath = value.substr(0, tab);
+            if (tab != std::string::npos) {
+                entry.polygonPath = value.substr(tab + 1);
+            }
+            state.worklist.push_back(std::move(entry));
+        } else if (key == "tile") {
+            TileKey tile{0, 0, 0};
+            if (fields >> tile.level >> tile.tileX >> tile.tileY && tile.level >= 0 && tile.tileX >= 0 &&
+                tile.tileY >= 0 && state.warmTiles.size() < MAX_WARM_TILES) {
+                state.warmTiles.push_back(tile);
+            }
+        }
+    }
+    if (state.worklistIndex != Worklist::NO_ENTRY && state.worklistIndex >= state.worklist.size()) {
+        state.worklistIndex = Worklist::NO_ENTRY;
+    }
+    return true;
+}
+
+std::string DefaultPath() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (base) {
+        return (fs::path(base) / "PathView" / "session.txt").string();
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / "Library" / "Application Support" / "PathView" / "session.txt").string();
+    }
+#else
+    // Where the user left off: state, not configuration or data
+    const char* xdg = std::getenv("XDG_STATE_HOME");
+    if (xdg && *xdg) {
+        return (fs::path(xdg) / "pathview" / "session.txt").string();
+    }
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / ".local" / "state" / "pathview" / "session.txt").string();
+    }
+#endif
+    std::error_code ec;
+    return (fs::temp_directory_path(ec) / "pathview-session.txt").string();
+}
+
+}  // namespace Session
+
+void TileUsage::Record(const std::vector<TileKey>& tiles) {
+    for (TileKey key : tiles) {
+        key.slide = 0;
+        ++counts_[key];
+    }
+    if (counts_.size() <= TRACKED_TILES) {
+        return;
+    }
+    for (auto it = counts_.begin(); it != counts_.end();) {
+        it->second /= 2;
+        it = it->second == 0 ? counts_.erase(it) : std::next(it);
+    }
+}
+
+std::vector<TileKey> TileUsage::GetMostUsed(size_t count) const {
+    std::vector<std::pair<TileKey, uint32_t>> tiles(counts_.begin(), counts_.end());
+    auto order = [](const std::pair<TileKey, uint32_t>& a, const std::pair<TileKey, uint32_t>& b) {
+        if (a.second != b.second) {
+            return a.second > b.second;
+        }
+        if (a.first.level != b.first.level) {
+            return a.first.level > b.first.level;  // Coarsest first: they stand in for the rest
+        }
+        return a.first < b.first;
+    };
+    count = std::min(count, tiles.size());
+    std::partial_sort(tiles.begin(), tiles.begin() + static_cast<std::ptrdiff_t>(count), tiles.end(), order);
+    std::vector<TileKey> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(tiles[i].first);
+    }
+    return result;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "TileKey.h"
+#include "Viewport.h"  // For Vec2
+#include "Worklist.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What the viewer had open when it last saved its session. Annotations are
+// not part of it: each slide's journal (AnnotationJournal) brings them back
+// when the slide is opened again.
+struct SessionState {
+    std::string slidePath;         // Empty: no slide open
+    bool hasView = false;
+    Vec2 viewCenter;               // Level 0 pixels
+    double viewZoom = 0.0;
+    std::string polygonPath;       // Empty: no polygons loaded
+    std::string heatmapPath;       // Likewise
+    double heatmapTexelSize = 0.0;
+    std::vector<WorklistEntry> worklist;
+    size_t worklistIndex = Worklist::NO_ENTRY;
+    std::vector<TileKey> warmTiles;  // Slide's most used tiles, first first (slide 0)
+
+    bool IsEmpty() const { return slidePath.empty() && worklist.empty(); }
+};
+
+// Text file of a SessionState, one "key value" line per item (paths run to
+// the end of the line), so it can be read and edited by hand:
+//   pathview-session 1
+//   slide /data/case1.svs
+//   view 51200 38400 0.25
+//   polygons /data/case1.pb
+//   heatmap /data/case1.npy 16
+//   worklist 0
+//   entry /data/case1.svs<TAB>/data/case1.pb
+//   tile 3 12 7
+// Unknown keys are skipped, so newer files still load.
+namespace Session {
+
+// Write to a temporary file renamed over path (a crash mid-save keeps the
+// previous session); creates the directory
+bool Save(const std::string& path, const SessionState& state);
+
+// False if the file is missing or not a session
+bool Load(const std::string& path, SessionState& state);
+
+// Per-user state directory's pathview/session.txt
+std::string DefaultPath();
+
+// Tiles kept for warm-up: 64 MB of 256 px ARGB tiles
+constexpr size_t MAX_WARM_TILES = 256;
+
+}  // namespace Session
+
+// How often each tile of a slide was in a settled view (the frames drawn
+// while the view did not move), to pick the tiles a restored session
+// prefetches. Bounded: once TRACKED_TILES are counted the counts halve and
+// tiles left at zero are forgotten, so old views fade.
+class TileUsage {
+public:
+    // One settled frame showing these tiles (TileKey::slide is ignored)
+    void Record(const std::vector<TileKey>& tiles);
+    void Clear() { counts_.clear(); }
+    size_t GetTrackedCount() const { return counts_.size(); }
+
+    // At most count tiles, the most viewed first (ties coarsest level first)
+    std::vector<TileKey> GetMostUsed(size_t count) const;
+
+    static constexpr size_t TRACKED_TILES = 16384;
+
+private:
+    std::unordered_map<TileKey, uint32_t, TileKeyHash> counts_;
+};
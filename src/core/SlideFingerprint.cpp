@@ -0,0 +1,121 @@
+#include "SlideFingerprint.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    // FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Reads size bytes at offset (fewer at the end of the file)
+bool ReadAt(std::ifstream& file, uint64_t offset, size_t size, std::vector<uint8_t>& out) {
+    out.resize(size);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(size));
+    out.resize(static_cast<size_t>(file.gcount()));
+    return !out.empty();
+}
+
+uint64_t ReadUnsigned(const uint8_t* bytes, size_t size, bool bigEndian) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        size_t shift = 8 * (bigEndian ? size - 1 - i : i);
+        value |= static_cast<uint64_t>(bytes[i]) << shift;
+    }
+    return value;
+}
+
+// Hashes every directory of the main IFD chain; leaves hash unchanged for
+// files that are not TIFF
+uint64_t HashTiffDirectories(uint64_t hash, std::ifstream& file, uint64_t fileSize,
+                             const std::vector<uint8_t>& header) {
+    if (header.size() < 16 || header[0] != header[1] || (header[0] != 'I' && header[0] != 'M')) {
+        return hash;
+    }
+    const bool bigEndian = header[0] == 'M';
+    const uint64_t magic = ReadUnsigned(&header[2], 2, bigEndian);
+    if (magic != 42 && magic != 43) {
+        return hash;
+    }
+    const bool bigTiff = magic == 43;
+    const size_t countSize = bigTiff ? 8 : 2;
+    const size_t entrySize = bigTiff ? 20 : 12;
+    const size_t offsetSize = bigTiff ? 8 : 4;
+
+    uint64_t offset = ReadUnsigned(&header[bigTiff ? 8 : 4], offsetSize, bigEndian);
+    std::unordered_set<uint64_t> visited;  // Corrupt chains may loop
+    std::vector<uint8_t> bytes;
+    while (offset != 0 && offset < fileSize && visited.size() < SlideFingerprint::MAX_DIRECTORIES &&
+           visited.insert(offset).second) {
+        if (!ReadAt(file, offset, countSize, bytes) || bytes.size() < countSize) {
+            break;
+        }
+        uint64_t count = std::min(ReadUnsigned(bytes.data(), countSize, bigEndian),
+                                  SlideFingerprint::MAX_DIRECTORY_ENTRIES);
+        size_t size = static_cast<size_t>(count) * entrySize + offsetSize;
+        if (!ReadAt(file, offset + countSize, size, bytes) || bytes.size() < size) {
+            break;
+        }
+        hash = HashBytes(hash, bytes.data(), bytes.size());
+        offset = ReadUnsigned(&bytes[size - offsetSize], offsetSize, bigEndian);
+    }
+    return hash;
+}
+
+}  // namespace
+
+std::string SlideFingerprint::Compute(const std::string& path) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(path, ec);
+    if (ec) {
+        return {};
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return {};
+    }
+
+    // Size and mtime change whenever the file is rewritten, and a rename
+    // or move keeps both
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = HashBytes(hash, &size, sizeof(size));
+    auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (!ec) {
+        hash = HashBytes(hash, &mtime, sizeof(mtime));
+    }
+
+    std::vector<uint8_t> header;
+    if (ReadAt(file, 0, HEADER_BYTES, header)) {
+        hash = HashBytes(hash, header.data(), header.size());
+    }
+    hash = HashTiffDirectories(hash, file, size, header);
+
+    // Spread over the file, past the header
+    std::vector<uint8_t> sample;
+    if (size > HEADER_BYTES) {
+        for (size_t i = 1; i <= SAMPLE_COUNT; ++i) {
+            uint64_t offset = HEADER_BYTES + (size - HEADER_BYTES) / (SAMPLE_COUNT + 1) * i;
+            if (ReadAt(file, offset, SAMPLE_BYTES, sample)) {
+                hash = HashBytes(hash, sample.data(), sample.size());
+            }
+        }
+    }
+
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
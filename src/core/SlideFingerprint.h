@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Identity of a slide file's contents that survives renames and moves,
+// for keying caches (DiskTileCache directories, slide.info's fingerprint).
+//
+// Hashing a multi-gigabyte slide is far too slow, so the fingerprint
+// covers only what tells slides apart: the file size and modification
+// time, the first HEADER_BYTES (TIFF header and, for most formats, the
+// first directories), every TIFF directory in the main chain (dimensions,
+// compression, where the tile tables and descriptions sit), and SAMPLE_COUNT
+// blocks of SAMPLE_BYTES spread evenly over the file, which land in tile
+// data. About 130KB is read whatever the slide's size.
+class SlideFingerprint {
+public:
+    // 16 hex digits, or empty if the file cannot be read (remote slides)
+    static std::string Compute(const std::string& path);
+
+    static constexpr size_t HEADER_BYTES = 64 * 1024;
+    static constexpr size_t SAMPLE_COUNT = 16;
+    static constexpr size_t SAMPLE_BYTES = 4096;
+    // Directories hashed at most, and entries read from each (pyramids
+    // have a few dozen directories of a few dozen entries)
+    static constexpr size_t MAX_DIRECTORIES = 256;
+    static constexpr uint64_t MAX_DIRECTORY_ENTRIES = 4096;
+};
@@ -0,0 +1,334 @@
+#include "SlideLibrary.h"
+#include "Minimap.h"
+#include "PyramidLayout.h"
+#include "SlideFingerprint.h"
+#include "SlideLoader.h"
+#include "ThreadScheduling.h"
+#include "TileCodec.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t THUMBNAIL_FILE_MAGIC = 0x48545650;  // "PVTH"
+
+// Single-file formats OpenFileDialog offers
+constexpr const char* SLIDE_EXTENSIONS[] = {
+    ".svs", ".tif", ".tiff", ".ndpi", ".vms", ".vmu", ".scn", ".mrxs", ".bif", ".svslide"
+};
+
+}  // namespace
+
+SlideLibrary::SlideLibrary(std::string cacheDirectory, size_t threadCount, std::function<void()> onThumbnail)
+    : cacheDirectory_(std::move(cacheDirectory))
+    , onThumbnail_(std::move(onThumbnail)) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&SlideLibrary::WorkerLoop, this);
+    }
+}
+
+SlideLibrary::~SlideLibrary() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    queueChanged_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool SlideLibrary::Scan(const std::string& root) {
+    std::error_code ec;
+    const bool isDirectory = fs::is_directory(root, ec);
+    std::vector<std::string> paths = isDirectory ? FindSlides(root) : std::vector<std::string>();
+
+    std::vector<Slot> slots(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        Entry& entry = slots[i].entry;
+        entry.path = paths[i];
+        entry.name = fs::path(paths[i]).lexically_relative(root).generic_string();
+        entry.bytes = fs::file_size(paths[i], ec);
+        if (ec) {
+            entry.bytes = 0;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        root_ = isDirectory ? root : std::string();
+        slots_ = std::move(slots);
+        queue_.clear();
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            queue_.push_back(i);
+        }
+        ++scanRevision_;
+        ++revision_;
+    }
+    queueChanged_.notify_all();
+    PATHVIEW_LOG_INFO("Slide library: " << paths.size() << " slides under " << root);
+    return isDirectory;
+}
+
+std::string SlideLibrary::GetRoot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return root_;
+}
+
+std::vector<SlideLibrary::Entry> SlideLibrary::GetEntries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> entries;
+    entries.reserve(slots_.size());
+    for (const Slot& slot : slots_) {
+        entries.push_back(slot.entry);
+    }
+    return entries;
+}
+
+size_t SlideLibrary::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + inFlight_;
+}
+
+uint64_t SlideLibrary::GetRevision() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return revision_;
+}
+
+uint64_t SlideLibrary::GetScanRevision() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scanRevision_;
+}
+
+bool SlideLibrary::TakeThumbnail(size_t index, uint64_t scanRevision, SlideThumbnail& thumbnail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (scanRevision != scanRevision_ || index >= slots_.size()) {
+        return false;
+    }
+    Slot& slot = slots_[index];
+    if (slot.entry.state != ThumbnailState::Ready || slot.taken) {
+        return false;
+    }
+    thumbnail = std::move(slot.thumbnail);
+    slot.thumbnail = SlideThumbnail();
+    slot.taken = true;
+    return true;
+}
+
+void SlideLibrary::WorkerLoop() {
+    ThreadScheduling::LowerCurrentThreadPriority();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queueChanged_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        const size_t index = queue_.front();
+        queue_.pop_front();
+        const uint64_t scanRevision = scanRevision_;
+        Slot result;
+        result.entry = slots_[index].entry;
+        ++inFlight_;
+        lock.unlock();
+
+        Process(result.entry.path, result);
+
+        lock.lock();
+        --inFlight_;
+        // A rescan while this one was made replaced the slots
+        if (scanRevision == scanRevision_) {
+            slots_[index] = std::move(result);
+            ++revision_;
+        }
+        if (onThumbnail_) {
+            lock.unlock();
+            onThumbnail_();
+            lock.lock();
+        }
+    }
+}
+
+void SlideLibrary::Process(const std::string& path, Slot& result) const {
+    Entry& entry = result.entry;
+    entry.fingerprint = SlideFingerprint::Compute(path);
+    std::string cacheFile;
+    if (!entry.fingerprint.empty() && !cacheDirectory_.empty()) {
+        cacheFile = (fs::path(cacheDirectory_) / (entry.fingerprint + CACHE_FILE_EXTENSION)).string();
+        if (ReadCachedThumbnail(cacheFile, result.thumbnail)) {
+            entry.state = ThumbnailState::Ready;
+            entry.fromCache = true;
+            return;
+        }
+    }
+
+    if (!MakeThumbnail(path, result.thumbnail, &entry.error)) {
+        entry.state = ThumbnailState::Failed;
+        PATHVIEW_LOG_WARNING("Slide library: no thumbnail for " << path << ": " << entry.error);
+        return;
+    }
+    entry.state = ThumbnailState::Ready;
+    if (!cacheFile.empty()) {
+        std::error_code ec;
+        fs::create_directories(cacheDirectory_, ec);
+        WriteCachedThumbnail(cacheFile, result.thumbnail);
+    }
+}
+
+std::vector<std::string> SlideLibrary::FindSlides(const std::string& root) {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    for (fs::recursive_directory_iterator end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && IsSlideFile(it->path().string())) {
+            paths.push_back(it->path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool SlideLibrary::IsSlideFile(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find_if(std::begin(SLIDE_EXTENSIONS), std::end(SLIDE_EXTENSIONS),
+                        [&](const char* known) { return extension == known; }) != std::end(SLIDE_EXTENSIONS);
+}
+
+bool SlideLibrary::MakeThumbnail(const std::string& path, SlideThumbnail& thumbnail, std::string* error) {
+    SlideLoader loader(path);
+    if (!loader.IsValid()) {
+        if (error) {
+            *error = loader.GetError();
+        }
+        return false;
+    }
+
+    std::vector<uint32_t> pixels;
+    int64_t width = 0;
+    int64_t height = 0;
+    if (!loader.ReadAssociatedImage("thumbnail", pixels, width, height)) {
+        MinimapOverview overview;
+        if (!Minimap::ReadPyramidOverview(&loader, THUMBNAIL_SIZE, overview)) {
+            if (error) {
+                *error = "cannot read the lowest level";
+            }
+            return false;
+        }
+        pixels = std::move(overview.pixels);
+        width = overview.width;
+        height = overview.height;
+    }
+
+    while (std::max(width, height) > THUMBNAIL_SIZE) {
+        const int64_t halfWidth = (width + 1) / 2;
+        const int64_t halfHeight = (height + 1) / 2;
+        std::vector<uint32_t> half(static_cast<size_t>(halfWidth * halfHeight));
+        PyramidLayout::Downsample2x(pixels.data(), static_cast<int32_t>(width), static_cast<int32_t>(height),
+                                    static_cast<size_t>(width), half.data(), static_cast<size_t>(halfWidth));
+        pixels.swap(half);
+        width = halfWidth;
+        height = halfHeight;
+    }
+    thumbnail.pixels = std::move(pixels);
+    thumbnail.width = static_cast<int32_t>(width);
+    thumbnail.height = static_cast<int32_t>(height);
+    return true;
+}
+
+bool SlideLibrary::ReadCachedThumbnail(const std::string& file, SlideThumbnail& thumbnail) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    uint32_t magic = 0;
+    if (data.size() < sizeof(magic)) {
+        return false;
+    }
+    std::memcpy(&magic, data.data(), sizeof(magic));
+    if (magic != THUMBNAIL_FILE_MAGIC) {
+        return false;
+    }
+    std::vector<uint32_t> pixels(static_cast<size_t>(THUMBNAIL_SIZE) * THUMBNAIL_SIZE);
+    int32_t width = 0;
+    int32_t height = 0;
+    if (!TileCodec::Decompress(data.data() + sizeof(magic), data.size() - sizeof(magic), pixels.data(),
+                               pixels.size(), &width, &height) ||
+        width <= 0 || height <= 0) {
+        return false;
+    }
+    pixels.resize(static_cast<size_t>(width) * height);
+    thumbnail.pixels = std::move(pixels);
+    thumbnail.width = width;
+    thumbnail.height = height;
+    return true;
+}
+
+bool SlideLibrary::WriteCachedThumbnail(const std::string& file, const SlideThumbnail& thumbnail) {
+    if (thumbnail.width <= 0 || thumbnail.height <= 0 ||
+        std::max(thumbnail.width, thumbnail.height) > THUMBNAIL_SIZE) {
+        return false;
+    }
+    std::vector<uint8_t> encoded;
+    TileCodec::Compress(thumbnail.pixels.data(), thumbnail.width, thumbnail.height, encoded);
+
+    // Temporary file then rename, as DiskTileCache does, so a concurrent
+    // scan never reads half a thumbnail
+    static std::atomic<uint64_t> tempCounter{0};
+    const std::string tempPath = file + "." + std::to_string(tempCounter++) + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&THUMBNAIL_FILE_MAGIC), sizeof(THUMBNAIL_FILE_MAGIC));
+        out.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+        if (!out) {
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, file, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::string SlideLibrary::DefaultCacheDirectory() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    if (base) {
+        return (fs::path(base) / "PathView" / "Thumbnails").string();
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / "Library" / "Caches" / "PathView" / "Thumbnails").string();
+    }
+#else
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        return (fs::path(xdg) / "pathview" / "thumbnails").string();
+    }
+    const char* home = std::getenv("HOME");
+    if (home) {
+        return (fs::path(home) / ".cache" / "pathview" / "thumbnails").string();
+    }
+#endif
+    std::error_code ec;
+    return (fs::temp_directory_path(ec) / "pathview-thumbnails").string();
+}
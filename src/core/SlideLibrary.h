@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A thumbnail of a whole slide, at most SlideLibrary::THUMBNAIL_SIZE on a side
+struct SlideThumbnail {
+    std::vector<uint32_t> pixels;  // Premultiplied ARGB, like SlideLoader reads
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+// The slides under a directory tree, for browsing before opening one.
+//
+// Scan() lists the slide files and queues their thumbnails for a small
+// pool of threads run below the render thread. A thumbnail is the slide's
+// associated "thumbnail" image, or for slides without one a read of the
+// pyramid's lowest level, halved down to THUMBNAIL_SIZE. Each is written
+// to <cache directory>/<fingerprint>.thumb (see SlideFingerprint), so
+// after the first scan a slide costs a fingerprint and a small file read,
+// and a renamed or moved slide keeps its thumbnail. Thumbnails are a few
+// tens of KB each and are not evicted.
+class SlideLibrary {
+public:
+    enum class ThumbnailState { Pending, Ready, Failed };
+
+    struct Entry {
+        std::string path;
+        std::string name;          // Path relative to the scanned directory
+        uint64_t bytes = 0;
+        ThumbnailState state = ThumbnailState::Pending;
+        bool fromCache = false;    // Thumbnail read from the disk cache
+        std::string fingerprint;   // Once the thumbnail is ready or failed
+        std::string error;         // Why it failed
+    };
+
+    // onThumbnail runs on a worker thread after each thumbnail is ready
+    // or has failed
+    explicit SlideLibrary(std::string cacheDirectory = DefaultCacheDirectory(),
+                          size_t threadCount = DEFAULT_THREADS, std::function<void()> onThumbnail = nullptr);
+
+    // Waits for the thumbnails being made, dropping the queued ones
+    ~SlideLibrary();
+
+    SlideLibrary(const SlideLibrary&) = delete;
+    SlideLibrary& operator=(const SlideLibrary&) = delete;
+
+    /**
+     * Replace the entries with the slides under root, sorted by name, and
+     * queue their thumbnails (dropping those of the previous scan)
+     * @return false if root is not a directory (the entries are cleared)
+     */
+    bool Scan(const std::string& root);
+
+    std::string GetRoot() const;
+    std::vector<Entry> GetEntries() const;
+    size_t GetPendingCount() const;
+    // Bumped by every scan and every thumbnail made, for pollers
+    uint64_t GetRevision() const;
+    const std::string& GetCacheDirectory() const { return cacheDirectory_; }
+
+    // Hands over entry index's thumbnail once it is ready; false before
+    // that, after it has been taken, and for entries of an older scan
+    bool TakeThumbnail(size_t index, uint64_t scanRevision, SlideThumbnail& thumbnail);
+    uint64_t GetScanRevision() const;
+
+    // Slide files under root, recursively, by extension. Directory formats
+    // (DICOM, Zarr) are not listed; MIRAX data directories hold no .mrxs.
+    static std::vector<std::string> FindSlides(const std::string& root);
+    static bool IsSlideFile(const std::string& path);
+
+    // Read the thumbnail of the slide at path, without the cache
+    static bool MakeThumbnail(const std::string& path, SlideThumbnail& thumbnail, std::string* error = nullptr);
+
+    // Thumbnail cache files: a magic number, then the TileCodec stream
+    static bool ReadCachedThumbnail(const std::string& file, SlideThumbnail& thumbnail);
+    static bool WriteCachedThumbnail(const std::string& file, const SlideThumbnail& thumbnail);
+
+    // Platform cache directory (next to DiskTileCache's), created on first write
+    static std::string DefaultCacheDirectory();
+
+    static constexpr int32_t THUMBNAIL_SIZE = 256;
+    static constexpr size_t DEFAULT_THREADS = 2;
+    static constexpr const char* CACHE_FILE_EXTENSION = ".thumb";
+
+private:
+    struct Slot {
+        Entry entry;
+        SlideThumbnail thumbnail;  // Until taken
+        bool taken = false;
+    };
+
+    void WorkerLoop();
+    // Fingerprint, cache lookup, and on a miss MakeThumbnail and a cache write
+    void Process(const std::string& path, Slot& result) const;
+
+    const std::string cacheDirectory_;
+    std::function<void()> onThumbnail_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queueChanged_;
+    std::string root_;
+    std::vector<Slot> slots_;
+    std::deque<size_t> queue_;  // Slot indices of the current scan
+    size_t inFlight_ = 0;
+    uint64_t scanRevision_ = 0;
+    uint64_t revision_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
@@ -1,27 +1,107 @@
 #include "SlideLoader.h"
-#include <iostream>
+#include "SlideMetadata.h"
+#include "SlideFingerprint.h"
+#include "DicomFrameIndex.h"
+#include "ZarrPyramid.h"
+#include "SyntheticSlide.h"
+#include "TiffTileReader.h"
+#include "JpegBatchDecoder.h"
+#include "RemoteFile.h"
+#include "HttpRangeTransport.h"
+#include "PixelConvert.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+int64_t ReadIntProperty(const SlideMetadata& metadata, const std::string& name) {
+    const std::string* value = metadata.FindProperty(name);
+    return value ? std::strtoll(value->c_str(), nullptr, 10) : 0;
+}
+
+// Default channel colours (0xRRGGBB), in the order fluorescence panels
+// usually list their stains: nuclear counterstain first
+constexpr uint32_t CHANNEL_COLORS[] = {
+    0x0000FF, 0x00FF00, 0xFF0000, 0xFFFF00, 0xFF00FF, 0x00FFFF, 0xFF8000, 0xFFFFFF,
+};
+
+// As OpenSlide derives downsamples for generic TIFF
+double TiffDownsample(const LevelDimensions& base, const LevelDimensions& level) {
+    return (static_cast<double>(base.width) / level.width +
+            static_cast<double>(base.height) / level.height) / 2.0;
+}
+
+LevelDimensions ReadNativeTileSize(const SlideMetadata& metadata, int32_t level) {
+    std::string prefix = "openslide.level[" + std::to_string(level) + "].";
+    LevelDimensions size{ReadIntProperty(metadata, prefix + "tile-width"),
+                         ReadIntProperty(metadata, prefix + "tile-height")};
+    if (size.width <= 0 || size.height <= 0) {
+        return {0, 0};
+    }
+    return size;
+}
+
+}  // namespace
 
 SlideLoader::SlideLoader(const std::string& path)
     : slide_(nullptr)
     , path_(path)
     , errorMessage_("")
 {
+    auto metadata = std::make_shared<SlideMetadata>();
+    Open(*metadata);
+    PublishMetadata(std::move(metadata));
+}
+
+void SlideLoader::Open(SlideMetadata& metadata) {
+    const std::string& path = path_;
+    if (HttpRangeTransport::IsUrl(path)) {
+        OpenRemote();
+        return;
+    }
+
+    if (ZarrPyramid::IsZarrPath(path)) {
+        OpenZarr(metadata);
+        return;
+    }
+
+    if (SyntheticSlide::IsSyntheticPath(path)) {
+        OpenSynthetic(metadata);
+        return;
+    }
+
+    // A DICOM series OpenSlide can still try if it is not a tiled JPEG
+    // pyramid
+    if (DicomFrameIndex::IsDicomPath(path) && OpenDicom(metadata)) {
+        return;
+    }
+
     // Detect if file is a valid slide
     const char* vendor = openslide_detect_vendor(path.c_str());
+
+    // Fluorescence TIFFs OpenSlide cannot read, or would show as one grey
+    // channel
+    if ((!vendor || std::strcmp(vendor, "generic-tiff") == 0) && OpenChannels(vendor ? 2 : 1)) {
+        return;
+    }
     if (!vendor) {
         errorMessage_ = "File is not a valid whole-slide image";
-        std::cerr << "SlideLoader: " << errorMessage_ << ": " << path << std::endl;
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path);
         return;
     }
 
-    std::cout << "Detected slide vendor: " << vendor << std::endl;
+    PATHVIEW_LOG_INFO("Detected slide vendor: " << vendor);
+    vendor_ = vendor;
 
     // Open the slide
     slide_ = openslide_open(path.c_str());
     if (!slide_) {
         errorMessage_ = "Failed to open slide";
-        std::cerr << "SlideLoader: " << errorMessage_ << ": " << path << std::endl;
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path);
         return;
     }
 
@@ -31,13 +111,18 @@ SlideLoader::SlideLoader(const std::string& path)
         return;
     }
 
+    // Every property and associated image in one pass; nothing after
+    // opening asks OpenSlide for them again
+    ReadProperties(metadata);
+
     // Get number of levels
     int32_t levelCount = openslide_get_level_count(slide_);
-    std::cout << "Slide has " << levelCount << " pyramid levels" << std::endl;
+    PATHVIEW_LOG_INFO("Slide has " << levelCount << " pyramid levels");
 
     // Cache level dimensions and downsample factors
     levelDimensions_.reserve(levelCount);
     levelDownsamples_.reserve(levelCount);
+    levelTileSizes_.reserve(levelCount);
 
     for (int32_t i = 0; i < levelCount; ++i) {
         int64_t w, h;
@@ -47,41 +132,384 @@ SlideLoader::SlideLoader(const std::string& path)
         double downsample = openslide_get_level_downsample(slide_, i);
         levelDownsamples_.push_back(downsample);
 
-        std::cout << "  Level " << i << ": " << w << "x" << h
-                  << " (downsample: " << downsample << "x)" << std::endl;
+        LevelDimensions tileSize = ReadNativeTileSize(metadata, i);
+        levelTileSizes_.push_back(tileSize);
+
+        std::ostringstream line;
+        line << "  Level " << i << ": " << w << "x" << h << " (downsample: " << downsample << "x";
+        if (tileSize.width > 0 && tileSize.height > 0) {
+            line << ", tiles: " << tileSize.width << "x" << tileSize.height;
+        }
+        PATHVIEW_LOG_INFO(line.str() << ")");
+    }
+
+    PATHVIEW_LOG_INFO("SlideLoader initialized successfully");
+}
+
+void SlideLoader::ReadProperties(SlideMetadata& metadata) {
+    for (const char* const* names = openslide_get_property_names(slide_); *names; ++names) {
+        if (const char* value = openslide_get_property_value(slide_, *names)) {
+            metadata.properties.emplace(*names, value);
+        }
+    }
+    for (const char* const* names = openslide_get_associated_image_names(slide_); *names; ++names) {
+        int64_t width = 0;
+        int64_t height = 0;
+        openslide_get_associated_image_dimensions(slide_, *names, &width, &height);
+        metadata.associatedImages.push_back({*names, width, height});
+    }
+    metadata.ParseStandardProperties();
+}
+
+void SlideLoader::PublishMetadata(std::shared_ptr<SlideMetadata> metadata) {
+    metadata->path = path_;
+    if (IsValid() && !remoteFile_ && !synthetic_) {
+        metadata->fingerprint = SlideFingerprint::Compute(fingerprintPath_.empty() ? path_ : fingerprintPath_);
+    }
+    metadata->vendor = vendor_;
+    for (size_t i = 0; i < levelDimensions_.size(); ++i) {
+        metadata->levels.push_back({levelDimensions_[i], levelDownsamples_[i], levelTileSizes_[i]});
+    }
+    for (const Channel& channel : channels_) {
+        metadata->channelNames.push_back(channel.name);
+    }
+    metadata_ = std::move(metadata);
+}
+
+void SlideLoader::OpenRemote() {
+    vendor_ = "remote-tiff";
+    if (!TiffTileReader::IsDecodeAvailable()) {
+        errorMessage_ = "Remote slides need a build with libjpeg";
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_);
+        return;
+    }
+
+    remoteFile_ = std::make_shared<RemoteFile>(std::make_unique<HttpRangeTransport>(path_));
+    if (!remoteFile_->IsOpen()) {
+        errorMessage_ = "Failed to open remote slide";
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path_);
+        return;
+    }
+
+    tiffReader_ = std::make_unique<TiffTileReader>(remoteFile_);
+    std::vector<LevelDimensions> levels = tiffReader_->GetPyramidLevels();
+    if (levels.empty() || tiffReader_->BindLevels(levels) != levels.size()) {
+        errorMessage_ = "Remote slide is not a tiled JPEG TIFF";
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path_);
+        return;
+    }
+
+    PATHVIEW_LOG_INFO("Remote slide: " << remoteFile_->GetSize() << " bytes, "
+                      << levels.size() << " pyramid levels");
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        double downsample = TiffDownsample(levels[0], levels[i]);
+        LevelDimensions tileSize = tiffReader_->GetTileSize(static_cast<int32_t>(i));
+        levelDimensions_.push_back(levels[i]);
+        levelDownsamples_.push_back(downsample);
+        levelTileSizes_.push_back(tileSize);
+
+        PATHVIEW_LOG_INFO("  Level " << i << ": " << levels[i].width << "x" << levels[i].height
+                          << " (downsample: " << downsample << "x, tiles: "
+                          << tileSize.width << "x" << tileSize.height << ")");
+    }
+    directRead_ = true;
+}
+
+void SlideLoader::OpenZarr(SlideMetadata& metadata) {
+    auto zarr = std::make_shared<ZarrPyramid>(path_);
+    if (!zarr->IsOpen()) {
+        errorMessage_ = "Failed to open OME-Zarr image: " + zarr->GetError();
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path_);
+        return;
+    }
+
+    vendor_ = "ome-zarr";
+    zarr_ = std::move(zarr);
+    fingerprintPath_ = zarr_->GetMetadataPath();
+    std::vector<LevelDimensions> levels = zarr_->GetLevels();
+    PATHVIEW_LOG_INFO("OME-Zarr image: Zarr v" << zarr_->GetZarrFormat() << ", " << zarr_->GetChannelCount()
+                      << " channels, " << levels.size() << " pyramid levels, " << zarr_->GetCodecName()
+                      << " chunks");
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const LevelDimensions chunk = zarr_->GetChunkSize(static_cast<int32_t>(i));
+        levelDimensions_.push_back(levels[i]);
+        levelDownsamples_.push_back(TiffDownsample(levels[0], levels[i]));
+        levelTileSizes_.push_back(chunk);
+        PATHVIEW_LOG_INFO("  Level " << i << ": " << levels[i].width << "x" << levels[i].height
+                          << " (downsample: " << levelDownsamples_.back() << "x, chunks: "
+                          << chunk.width << "x" << chunk.height << ")");
+    }
+
+    const size_t channelCount = zarr_->GetChannelCount();
+    for (size_t channel = 0; channel < channelCount; ++channel) {
+        // A lone channel without a colour is a greyscale image
+        uint32_t color = zarr_->GetChannelColor(channel);
+        if (color == ZarrPyramid::NO_COLOR) {
+            color = channelCount == 1 ? 0xFFFFFF
+                                      : CHANNEL_COLORS[channel % (sizeof(CHANNEL_COLORS) / sizeof(CHANNEL_COLORS[0]))];
+        }
+        channels_.push_back({zarr_->GetChannelName(channel), color, 0, 0});
+        MeasureChannelWindow(channel);
+        PATHVIEW_LOG_INFO("  Channel " << channel << ": " << channels_[channel].name << " ("
+                          << zarr_->GetChannelBits(channel) << "-bit, window "
+                          << channels_[channel].windowLow << "-" << channels_[channel].windowHigh << ")");
+    }
+
+    if (zarr_->GetPixelSizeX() > 0.0 && zarr_->GetPixelSizeY() > 0.0) {
+        metadata.properties.emplace("openslide.mpp-x", std::to_string(zarr_->GetPixelSizeX()));
+        metadata.properties.emplace("openslide.mpp-y", std::to_string(zarr_->GetPixelSizeY()));
+    }
+    metadata.ParseStandardProperties();
+}
+
+void SlideLoader::OpenSynthetic(SlideMetadata& metadata) {
+    SyntheticSlideSpec spec;
+    std::string error;
+    if (!SyntheticSlideSpec::Parse(path_, spec, error)) {
+        errorMessage_ = error;
+        PATHVIEW_LOG_ERROR("SlideLoader: " << errorMessage_ << ": " << path_);
+        return;
+    }
+
+    vendor_ = "synthetic";
+    synthetic_ = std::make_shared<SyntheticSlide>(spec);
+    std::vector<LevelDimensions> levels = synthetic_->GetLevels();
+    PATHVIEW_LOG_INFO("Synthetic slide: " << levels.size() << " pyramid levels, seed " << spec.seed << ", "
+                      << spec.latencyUs << " us per tile read");
+    for (size_t i = 0; i < levels.size(); ++i) {
+        levelDimensions_.push_back(levels[i]);
+        levelDownsamples_.push_back(synthetic_->GetLevelDownsample(static_cast<int32_t>(i)));
+        levelTileSizes_.push_back({spec.tileSize, spec.tileSize});
+        PATHVIEW_LOG_INFO("  Level " << i << ": " << levels[i].width << "x" << levels[i].height
+                          << " (downsample: " << levelDownsamples_.back() << "x, tiles: "
+                          << spec.tileSize << "x" << spec.tileSize << ")");
+    }
+
+    const std::string mpp = std::to_string(SyntheticSlide::MICRONS_PER_PIXEL);
+    metadata.properties.emplace("openslide.mpp-x", mpp);
+    metadata.properties.emplace("openslide.mpp-y", mpp);
+    metadata.ParseStandardProperties();
+}
+
+bool SlideLoader::OpenDicom(SlideMetadata& metadata) {
+    if (!TiffTileReader::IsDecodeAvailable()) {
+        return false;
+    }
+    std::vector<DicomFrameIndex> instances = DicomFrameIndex::FindPyramid(path_);
+    if (instances.empty()) {
+        return false;
+    }
+
+    std::vector<std::shared_ptr<TiffTileReader>> readers;
+    for (const DicomFrameIndex& instance : instances) {
+        auto reader = std::make_shared<TiffTileReader>(instance);
+        if (!reader->IsOpen() || reader->BindLevels({{instance.width, instance.height}}) != 1) {
+            break;  // Coarser levels would leave a gap in the pyramid
+        }
+        readers.push_back(std::move(reader));
+    }
+    if (readers.empty()) {
+        return false;
+    }
+
+    vendor_ = "dicom";
+    dicomReaders_ = std::move(readers);
+    fingerprintPath_ = instances[0].path;
+    PATHVIEW_LOG_INFO("DICOM slide: series " << instances[0].seriesUid << ", "
+                      << dicomReaders_.size() << " pyramid levels");
+
+    const LevelDimensions base{instances[0].width, instances[0].height};
+    for (size_t i = 0; i < dicomReaders_.size(); ++i) {
+        const DicomFrameIndex& instance = instances[i];
+        const LevelDimensions dims{instance.width, instance.height};
+        double downsample = TiffDownsample(base, dims);
+        levelDimensions_.push_back(dims);
+        levelDownsamples_.push_back(downsample);
+        levelTileSizes_.push_back({instance.tileWidth, instance.tileHeight});
+
+        PATHVIEW_LOG_INFO("  Level " << i << ": " << dims.width << "x" << dims.height
+                          << " (downsample: " << downsample << "x, tiles: " << instance.tileWidth << "x"
+                          << instance.tileHeight << ", " << instance.frameCount << " frames from the "
+                          << DicomFrameIndex::OffsetSourceName(instance.offsetSource) << ")");
+    }
+
+    // Pixel spacing as OpenSlide's DICOM support reports it
+    metadata.properties.emplace("dicom.series-uid", instances[0].seriesUid);
+    if (instances[0].imagedWidthMm > 0.0 && instances[0].imagedHeightMm > 0.0) {
+        metadata.properties.emplace("openslide.mpp-x",
+                                    std::to_string(instances[0].imagedWidthMm * 1000.0 / base.width));
+        metadata.properties.emplace("openslide.mpp-y",
+                                    std::to_string(instances[0].imagedHeightMm * 1000.0 / base.height));
+    }
+    metadata.ParseStandardProperties();
+    directRead_ = true;
+    return true;
+}
+
+bool SlideLoader::OpenChannels(size_t minChannels) {
+    auto reader = std::make_shared<TiffTileReader>(path_);
+    if (!reader->IsOpen() || reader->BindChannels() < minChannels) {
+        return false;
+    }
+
+    vendor_ = "multichannel-tiff";
+    tiffReader_ = std::move(reader);
+    std::vector<LevelDimensions> levels = tiffReader_->GetChannelLevels();
+    PATHVIEW_LOG_INFO("Multichannel slide: " << tiffReader_->GetChannelCount() << " channels, "
+                      << levels.size() << " pyramid levels");
+    for (size_t i = 0; i < levels.size(); ++i) {
+        levelDimensions_.push_back(levels[i]);
+        levelDownsamples_.push_back(TiffDownsample(levels[0], levels[i]));
+        levelTileSizes_.push_back(tiffReader_->GetChannelTileSize(static_cast<int32_t>(i)));
+    }
+
+    for (size_t channel = 0; channel < tiffReader_->GetChannelCount(); ++channel) {
+        const uint32_t color = CHANNEL_COLORS[channel % (sizeof(CHANNEL_COLORS) / sizeof(CHANNEL_COLORS[0]))];
+        channels_.push_back({tiffReader_->GetChannelName(channel), color, 0, 0});
+        MeasureChannelWindow(channel);
+        PATHVIEW_LOG_INFO("  Channel " << channel << ": " << channels_[channel].name << " ("
+                          << tiffReader_->GetChannelBits(channel) << "-bit, window "
+                          << channels_[channel].windowLow << "-" << channels_[channel].windowHigh << ")");
+    }
+    return true;
+}
+
+void SlideLoader::MeasureChannelWindow(size_t channel) {
+    Channel& info = channels_[channel];
+    const uint32_t maxValue = GetChannelBits(channel) == 16 ? 0xFFFF : 0xFF;
+    info.windowLow = 0;
+    info.windowHigh = static_cast<uint16_t>(maxValue);
+
+    // The middle of the coarsest level
+    const int32_t level = static_cast<int32_t>(levelDimensions_.size()) - 1;
+    const LevelDimensions dims = levelDimensions_[level];
+    const int64_t width = std::min(dims.width, WINDOW_SAMPLE_SIZE);
+    const int64_t height = std::min(dims.height, WINDOW_SAMPLE_SIZE);
+    std::vector<uint16_t> samples(static_cast<size_t>(width * height));
+    if (!ReadChannelSamples(channel, level, (dims.width - width) / 2, (dims.height - height) / 2,
+                            width, height, samples.data())) {
+        return;
+    }
+
+    std::vector<uint32_t> histogram(maxValue + 1, 0);
+    for (uint16_t sample : samples) {
+        histogram[std::min<uint32_t>(sample, maxValue)]++;
+    }
+    const uint64_t lowRank = static_cast<uint64_t>(samples.size() * WINDOW_LOW_FRACTION);
+    const uint64_t highRank = static_cast<uint64_t>(samples.size() * WINDOW_HIGH_FRACTION);
+    uint64_t seen = 0;
+    bool lowFound = false;
+    for (uint32_t value = 0; value <= maxValue; ++value) {
+        seen += histogram[value];
+        if (!lowFound && seen > lowRank) {
+            info.windowLow = static_cast<uint16_t>(value);
+            lowFound = true;
+        }
+        if (seen > highRank) {
+            info.windowHigh = static_cast<uint16_t>(value);
+            break;
+        }
+    }
+    if (info.windowHigh <= info.windowLow) {
+        info.windowHigh = static_cast<uint16_t>(std::min<uint32_t>(info.windowLow + 1u, maxValue));
+        info.windowLow = static_cast<uint16_t>(info.windowHigh - 1);
     }
+}
+
+SlideLoader::SlideLoader(const SlideLoader& slide, int32_t channel)
+    : slide_(nullptr)
+    , path_(slide.path_)
+    , vendor_(slide.vendor_)
+    , levelDimensions_(slide.levelDimensions_)
+    , levelDownsamples_(slide.levelDownsamples_)
+    , levelTileSizes_(slide.levelTileSizes_)
+    , tiffReader_(slide.tiffReader_)
+    , zarr_(slide.zarr_)
+    , synthetic_(slide.synthetic_)
+    , channels_(slide.channels_)
+    , channel_(channel)
+    , metadata_(slide.metadata_)
+{
+}
 
-    std::cout << "SlideLoader initialized successfully" << std::endl;
+std::unique_ptr<SlideLoader> SlideLoader::OpenChannel(size_t channel) const {
+    if (channel >= channels_.size()) {
+        return nullptr;
+    }
+    return std::unique_ptr<SlideLoader>(new SlideLoader(*this, static_cast<int32_t>(channel)));
 }
 
 SlideLoader::~SlideLoader() {
+    CloseReadHandles();
+
     if (slide_) {
         openslide_close(slide_);
         slide_ = nullptr;
     }
 }
 
+// Moves must not race with readers of either loader
 SlideLoader::SlideLoader(SlideLoader&& other) noexcept
     : slide_(other.slide_)
     , path_(std::move(other.path_))
-    , errorMessage_(std::move(other.errorMessage_))
+    , vendor_(std::move(other.vendor_))
+    , errorMessage_(other.GetError())
     , levelDimensions_(std::move(other.levelDimensions_))
     , levelDownsamples_(std::move(other.levelDownsamples_))
+    , levelTileSizes_(std::move(other.levelTileSizes_))
+    , remoteFile_(std::move(other.remoteFile_))
+    , tiffReader_(std::move(other.tiffReader_))
+    , zarr_(std::move(other.zarr_))
+    , synthetic_(std::move(other.synthetic_))
+    , dicomReaders_(std::move(other.dicomReaders_))
+    , fingerprintPath_(std::move(other.fingerprintPath_))
+    , directRead_(other.directRead_)
+    , channels_(std::move(other.channels_))
+    , channel_(other.channel_)
+    , metadata_(std::move(other.metadata_))
 {
+    other.directRead_ = false;
+    std::lock_guard<std::mutex> lock(other.handleMutex_);
+    idleHandles_ = std::move(other.idleHandles_);
+    other.idleHandles_.clear();
+    readHandleCount_.store(other.readHandleCount_.exchange(0));
     other.slide_ = nullptr;
 }
 
 SlideLoader& SlideLoader::operator=(SlideLoader&& other) noexcept {
     if (this != &other) {
+        CloseReadHandles();
         if (slide_) {
             openslide_close(slide_);
         }
 
         slide_ = other.slide_;
         path_ = std::move(other.path_);
-        errorMessage_ = std::move(other.errorMessage_);
+        vendor_ = std::move(other.vendor_);
+        SetError(other.GetError());
         levelDimensions_ = std::move(other.levelDimensions_);
         levelDownsamples_ = std::move(other.levelDownsamples_);
+        levelTileSizes_ = std::move(other.levelTileSizes_);
+        remoteFile_ = std::move(other.remoteFile_);
+        tiffReader_ = std::move(other.tiffReader_);
+        zarr_ = std::move(other.zarr_);
+        synthetic_ = std::move(other.synthetic_);
+        dicomReaders_ = std::move(other.dicomReaders_);
+        fingerprintPath_ = std::move(other.fingerprintPath_);
+        directRead_ = other.directRead_;
+        other.directRead_ = false;
+        channels_ = std::move(other.channels_);
+        channel_ = other.channel_;
+        metadata_ = std::move(other.metadata_);
+
+        {
+            std::lock_guard<std::mutex> lock(other.handleMutex_);
+            std::lock_guard<std::mutex> ownLock(handleMutex_);
+            idleHandles_ = std::move(other.idleHandles_);
+            other.idleHandles_.clear();
+            readHandleCount_.store(other.readHandleCount_.exchange(0));
+        }
 
         other.slide_ = nullptr;
     }
@@ -89,8 +517,11 @@ SlideLoader& SlideLoader::operator=(SlideLoader&& other) noexcept {
 }
 
 bool SlideLoader::IsValid() const {
+    if (remoteFile_ || synthetic_ || !channels_.empty() || !dicomReaders_.empty()) {
+        return !levelDimensions_.empty();
+    }
     if (!slide_) {
-        std::cerr << "SlideLoader: Invalid slide" << std::endl;
+        PATHVIEW_LOG_ERROR("SlideLoader: Invalid slide");
         return false;
     }
 
@@ -98,12 +529,18 @@ bool SlideLoader::IsValid() const {
     return error == nullptr;
 }
 
-const std::string& SlideLoader::GetError() const {
+std::string SlideLoader::GetError() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
     return errorMessage_;
 }
 
+void SlideLoader::SetError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    errorMessage_ = message;
+}
+
 int32_t SlideLoader::GetLevelCount() const {
-    if (!slide_) return 0;
+    if (!slide_ && !remoteFile_ && !synthetic_ && channels_.empty() && dicomReaders_.empty()) return 0;
     return static_cast<int32_t>(levelDimensions_.size());
 }
 
@@ -121,6 +558,13 @@ double SlideLoader::GetLevelDownsample(int32_t level) const {
     return levelDownsamples_[level];
 }
 
+LevelDimensions SlideLoader::GetNativeTileSize(int32_t level) const {
+    if (level < 0 || level >= static_cast<int32_t>(levelTileSizes_.size())) {
+        return {0, 0};
+    }
+    return levelTileSizes_[level];
+}
+
 int64_t SlideLoader::GetWidth() const {
     if (levelDimensions_.empty()) {
         return 0;
@@ -136,50 +580,399 @@ int64_t SlideLoader::GetHeight() const {
 }
 
 uint32_t* SlideLoader::ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height) {
-    if (!IsValid()) {
-        std::cerr << "Cannot read region: slide is not valid" << std::endl;
+    // Allocate buffer for pixels
+    int64_t pixelCount = width * height;
+    uint32_t* pixels = new uint32_t[pixelCount];
+
+    if (!ReadRegionInto(level, x, y, width, height, pixels)) {
+        delete[] pixels;
         return nullptr;
     }
 
+    return pixels;
+}
+
+bool SlideLoader::ReadRegionInto(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                 uint32_t* pixels) {
+    if (!IsValid()) {
+        PATHVIEW_LOG_ERROR("Cannot read region: slide is not valid");
+        return false;
+    }
+
     if (level < 0 || level >= GetLevelCount()) {
-        std::cerr << "Invalid level: " << level << std::endl;
-        return nullptr;
+        PATHVIEW_LOG_ERROR("Invalid level: " << level);
+        return false;
     }
 
-    // Allocate buffer for pixels
-    int64_t pixelCount = width * height;
-    uint32_t* pixels = new uint32_t[pixelCount];
+    if (!channels_.empty()) {
+        return ReadChannelsInto(level, x, y, width, height, pixels);
+    }
+
+    if (synthetic_) {
+        double downsample = levelDownsamples_[level];
+        synthetic_->ReadRegion(level, std::llround(static_cast<double>(x) / downsample),
+                               std::llround(static_cast<double>(y) / downsample), width, height, pixels);
+        return true;
+    }
+
+    int32_t readerLevel = 0;
+    if (TiffTileReader* reader = DirectReader(level, readerLevel)) {
+        // Nearest level pixel: OpenSlide would resample a sub-pixel offset,
+        // which tile-aligned requests never have
+        double downsample = levelDownsamples_[level];
+        int64_t levelX = std::llround(static_cast<double>(x) / downsample);
+        int64_t levelY = std::llround(static_cast<double>(y) / downsample);
+        if (reader->ReadRegion(readerLevel, levelX, levelY, width, height, pixels)) {
+            directReadCount_++;
+            return true;
+        }
+        directFallbackCount_++;
+    }
+
+    if (remoteFile_ || !dicomReaders_.empty()) {
+        SetError(remoteFile_ ? "Remote tile read failed" : "DICOM frame read failed");
+        readErrorCount_++;
+        return false;
+    }
+
+    openslide_t* handle = AcquireReadHandle();
+    if (!handle) {
+        return false;
+    }
 
     // Read region from OpenSlide
-    // OpenSlide returns ARGB data (pre-multiplied alpha)
-    openslide_read_region(slide_, pixels, x, y, level, width, height);
+    // OpenSlide returns ARGB data (pre-multiplied alpha), which is uploaded
+    // as-is (see TextureManager::TILE_PIXEL_FORMAT)
+    openslide_read_region(handle, pixels, x, y, level, width, height);
 
     // Check for errors
-    CheckError();
-    if (!IsValid()) {
-        delete[] pixels;
+    const char* error = openslide_get_error(handle);
+    bool ok = error == nullptr;
+    if (!ok) {
+        SetError(error);
+        readErrorCount_++;
+        PATHVIEW_LOG_ERROR("OpenSlide read error: " << error);
+    }
+
+    ReleaseReadHandle(handle);
+    return ok;
+}
+
+bool SlideLoader::ReadChannelsInto(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                   uint32_t* pixels) {
+    double downsample = levelDownsamples_[level];
+    int64_t levelX = std::llround(static_cast<double>(x) / downsample);
+    int64_t levelY = std::llround(static_cast<double>(y) / downsample);
+    const size_t count = static_cast<size_t>(width * height);
+    thread_local std::vector<uint8_t> intensity;
+    intensity.resize(count);
+
+    if (channel_ >= 0) {
+        if (!ReadChannelIntensity(static_cast<size_t>(channel_), level, levelX, levelY, width, height,
+                                  intensity.data())) {
+            return false;
+        }
+        PixelConvert::ConvertRow<PixelLayout::Gray8, PixelLayout::ARGB32, AlphaMode::Keep>(
+            intensity.data(), pixels, count);
+        return true;
+    }
+
+    // Every channel added up in its colour, as ChannelCompositor draws
+    // them at gain 1
+    thread_local std::vector<uint16_t> sum;
+    sum.assign(count * 3, 0);
+    for (size_t channel = 0; channel < channels_.size(); ++channel) {
+        if (!ReadChannelIntensity(channel, level, levelX, levelY, width, height, intensity.data())) {
+            return false;
+        }
+        const uint32_t color = channels_[channel].color;
+        const uint32_t r = (color >> 16) & 0xFF;
+        const uint32_t g = (color >> 8) & 0xFF;
+        const uint32_t b = color & 0xFF;
+        for (size_t i = 0; i < count; ++i) {
+            sum[i * 3] = static_cast<uint16_t>(sum[i * 3] + (intensity[i] * r + 127) / 255);
+            sum[i * 3 + 1] = static_cast<uint16_t>(sum[i * 3 + 1] + (intensity[i] * g + 127) / 255);
+            sum[i * 3 + 2] = static_cast<uint16_t>(sum[i * 3 + 2] + (intensity[i] * b + 127) / 255);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        pixels[i] = 0xFF000000u |
+                    (static_cast<uint32_t>(std::min<uint16_t>(sum[i * 3], 255)) << 16) |
+                    (static_cast<uint32_t>(std::min<uint16_t>(sum[i * 3 + 1], 255)) << 8) |
+                    std::min<uint16_t>(sum[i * 3 + 2], 255);
+    }
+    return true;
+}
+
+bool SlideLoader::ReadChannelIntensity(size_t channel, int32_t level, int64_t x, int64_t y, int64_t width,
+                                       int64_t height, uint8_t* intensity) {
+    thread_local std::vector<uint16_t> samples;
+    samples.resize(static_cast<size_t>(width * height));
+    if (!ReadChannelSamples(channel, level, x, y, width, height, samples.data())) {
+        SetError("Channel tile read failed");
+        readErrorCount_++;
+        return false;
+    }
+
+    const uint32_t low = channels_[channel].windowLow;
+    const uint32_t range = channels_[channel].windowHigh - low;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const uint32_t value = samples[i] > low ? std::min<uint32_t>(samples[i] - low, range) : 0;
+        intensity[i] = static_cast<uint8_t>((value * 255 + range / 2) / range);
+    }
+    return true;
+}
+
+bool SlideLoader::ReadChannelSamples(size_t channel, int32_t level, int64_t x, int64_t y, int64_t width,
+                                     int64_t height, uint16_t* samples) const {
+    return zarr_ ? zarr_->ReadChannelRegion(level, channel, x, y, width, height, samples)
+                 : tiffReader_->ReadChannelRegion(level, channel, x, y, width, height, samples);
+}
+
+uint32_t SlideLoader::GetChannelBits(size_t channel) const {
+    return zarr_ ? zarr_->GetChannelBits(channel) : tiffReader_->GetChannelBits(channel);
+}
+
+bool SlideLoader::ReadAssociatedImage(const std::string& name, std::vector<uint32_t>& pixels,
+                                      int64_t& width, int64_t& height) {
+    // Names and sizes come from the metadata, so an image the slide lacks
+    // or that is too large is turned away without borrowing a handle
+    const SlideMetadata::AssociatedImage* image = metadata_ ? metadata_->FindAssociatedImage(name) : nullptr;
+    bool ok = false;
+    if (slide_ && image && image->width > 0 && image->height > 0 &&
+        image->width * image->height <= MAX_ASSOCIATED_IMAGE_PIXELS) {
+        // A read handle rather than the metadata one: a failed read leaves
+        // its handle in a sticky error state, which would invalidate the slide
+        if (openslide_t* handle = AcquireReadHandle()) {
+            width = image->width;
+            height = image->height;
+            pixels.resize(static_cast<size_t>(width * height));
+            openslide_read_associated_image(handle, name.c_str(), pixels.data());
+            const char* error = openslide_get_error(handle);
+            ok = error == nullptr;
+            if (!ok) {
+                PATHVIEW_LOG_ERROR("OpenSlide associated image error: " << error);
+            }
+            ReleaseReadHandle(handle);
+        }
+    }
+
+    if (!ok) {
+        pixels.clear();
+        width = 0;
+        height = 0;
+    }
+    return ok;
+}
+
+bool SlideLoader::SetDirectTiffRead(bool enabled, bool memoryMap) {
+    // Remote and DICOM slides have no other read path
+    if (remoteFile_ || !dicomReaders_.empty()) {
+        return directRead_;
+    }
+    directRead_ = false;
+    if (!enabled || !slide_) {
+        return false;
+    }
+    if (!TiffTileReader::IsDecodeAvailable()) {
+        PATHVIEW_LOG_INFO("Direct TIFF reads unavailable: built without libjpeg");
+        return false;
+    }
+    // Other TIFF-based formats (NDPI, Philips, Ventana) use strips, sparse
+    // tiles or overlapping tiles that only OpenSlide composites correctly
+    if (vendor_ != "aperio" && vendor_ != "generic-tiff") {
+        return false;
+    }
+
+    if (!tiffReader_ || tiffReader_->IsMapped() != memoryMap) {
+        tiffReader_ = std::make_unique<TiffTileReader>(path_, memoryMap);
+        tiffReader_->BindLevels(levelDimensions_);
+    }
+    int32_t directLevels = 0;
+    for (int32_t level = 0; level < GetLevelCount(); ++level) {
+        if (tiffReader_->HasLevel(level)) {
+            directLevels++;
+        }
+    }
+    directRead_ = directLevels > 0;
+    std::ostringstream line;
+    line << "Direct TIFF reads: " << directLevels << " of " << GetLevelCount() << " levels";
+    if (tiffReader_->IsMapped()) {
+        line << " (memory-mapped)";
+    } else if (tiffReader_->GetBatchReadName()) {
+        line << " (batched through " << tiffReader_->GetBatchReadName() << ")";
+    }
+    PATHVIEW_LOG_INFO(line.str());
+    return directRead_;
+}
+
+bool SlideLoader::SetHardwareJpegDecode(bool enabled) {
+    const std::vector<TiffTileReader*> readers = DirectReaders();
+    if (!directRead_ || readers.empty()) {
+        return false;
+    }
+    if (!enabled) {
+        for (TiffTileReader* reader : readers) {
+            reader->SetBatchDecoder(nullptr);
+        }
+        return false;
+    }
+    std::shared_ptr<JpegBatchDecoder> decoder = JpegBatchDecoder::CreateHardware();
+    if (!decoder) {
+        PATHVIEW_LOG_INFO("Hardware JPEG decode unavailable, decoding on the CPU");
+        return false;
+    }
+    PATHVIEW_LOG_INFO("Hardware JPEG decode: " << decoder->GetName());
+    for (TiffTileReader* reader : readers) {
+        reader->SetBatchDecoder(decoder);
+    }
+    return true;
+}
+
+size_t SlideLoader::GetHardwareDecodeCount() const {
+    size_t count = 0;
+    for (TiffTileReader* reader : DirectReaders()) {
+        count += reader->GetBatchDecodedCount();
+    }
+    return count;
+}
+
+bool SlideLoader::IsDirectTiffMapped() const {
+    const std::vector<TiffTileReader*> readers = DirectReaders();
+    return directRead_ && !readers.empty() && readers[0]->IsMapped();
+}
+
+void SlideLoader::AdviseDirectTiffAccess(TiffAccessPattern pattern) {
+    if (!directRead_) {
+        return;
+    }
+    for (TiffTileReader* reader : DirectReaders()) {
+        reader->Advise(pattern);
+    }
+}
+
+size_t SlideLoader::PrewarmRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                  bool sequential) const {
+    int32_t readerLevel = 0;
+    TiffTileReader* reader = DirectReader(level, readerLevel);
+    if (!reader) {
+        return 0;
+    }
+    double downsample = levelDownsamples_[level];
+    return reader->Prewarm(readerLevel,
+                           static_cast<int64_t>(std::floor(x / downsample)),
+                           static_cast<int64_t>(std::floor(y / downsample)),
+                           static_cast<int64_t>(std::ceil(width / downsample)) + 1,
+                           static_cast<int64_t>(std::ceil(height / downsample)) + 1,
+                           sequential);
+}
+
+size_t SlideLoader::FetchRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height) const {
+    int32_t readerLevel = 0;
+    TiffTileReader* reader = DirectReader(level, readerLevel);
+    if (!reader) {
+        return 0;
+    }
+    double downsample = levelDownsamples_[level];
+    return reader->Fetch(readerLevel,
+                         static_cast<int64_t>(std::floor(x / downsample)),
+                         static_cast<int64_t>(std::floor(y / downsample)),
+                         static_cast<int64_t>(std::ceil(width / downsample)) + 1,
+                         static_cast<int64_t>(std::ceil(height / downsample)) + 1);
+}
+
+bool SlideLoader::CanReadScaled(int32_t level, int32_t scale) const {
+    int32_t readerLevel = 0;
+    TiffTileReader* reader = channels_.empty() ? DirectReader(level, readerLevel) : nullptr;
+    return reader && reader->CanScale(readerLevel, scale);
+}
+
+bool SlideLoader::ReadRegionScaled(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                   int32_t scale, uint32_t* pixels) {
+    if (!IsValid() || level < 0 || level >= GetLevelCount() || !CanReadScaled(level, scale)) {
+        return false;
+    }
+    double downsample = levelDownsamples_[level] * scale;
+    int64_t scaledX = std::llround(static_cast<double>(x) / downsample);
+    int64_t scaledY = std::llround(static_cast<double>(y) / downsample);
+    int32_t readerLevel = 0;
+    TiffTileReader* reader = DirectReader(level, readerLevel);
+    if (!reader->ReadRegionScaled(readerLevel, scaledX, scaledY, width, height, scale, pixels)) {
+        return false;
+    }
+    scaledReadCount_++;
+    return true;
+}
+
+bool SlideLoader::IsDirectTiffLevel(int32_t level) const {
+    int32_t readerLevel = 0;
+    return DirectReader(level, readerLevel) != nullptr;
+}
+
+TiffTileReader* SlideLoader::DirectReader(int32_t level, int32_t& readerLevel) const {
+    if (!directRead_) {
         return nullptr;
     }
+    if (!dicomReaders_.empty()) {
+        readerLevel = 0;
+        return level >= 0 && level < static_cast<int32_t>(dicomReaders_.size()) ? dicomReaders_[level].get()
+                                                                                 : nullptr;
+    }
+    readerLevel = level;
+    return tiffReader_ && tiffReader_->HasLevel(level) ? tiffReader_.get() : nullptr;
+}
 
-    // Convert ARGB to RGBA for SDL
-    ConvertARGBtoRGBA(pixels, pixelCount);
+std::vector<TiffTileReader*> SlideLoader::DirectReaders() const {
+    std::vector<TiffTileReader*> readers;
+    for (const std::shared_ptr<TiffTileReader>& reader : dicomReaders_) {
+        readers.push_back(reader.get());
+    }
+    if (tiffReader_) {
+        readers.push_back(tiffReader_.get());
+    }
+    return readers;
+}
 
-    return pixels;
+openslide_t* SlideLoader::AcquireReadHandle() {
+    {
+        std::lock_guard<std::mutex> lock(handleMutex_);
+        if (!idleHandles_.empty()) {
+            openslide_t* handle = idleHandles_.back();
+            idleHandles_.pop_back();
+            return handle;
+        }
+    }
+
+    // Open outside the lock: opening parses the slide's header and can be slow
+    openslide_t* handle = openslide_open(path_.c_str());
+    if (!handle) {
+        SetError("Failed to open read handle");
+        PATHVIEW_LOG_ERROR("SlideLoader: Failed to open read handle: " << path_);
+        return nullptr;
+    }
+
+    readHandleCount_++;
+    return handle;
 }
 
-void SlideLoader::ConvertARGBtoRGBA(uint32_t* pixels, int64_t count) {
-    for (int64_t i = 0; i < count; ++i) {
-        uint32_t argb = pixels[i];
+void SlideLoader::ReleaseReadHandle(openslide_t* handle) {
+    if (openslide_get_error(handle)) {
+        openslide_close(handle);
+        readHandleCount_--;
+        return;
+    }
 
-        // Extract components
-        uint8_t a = (argb >> 24) & 0xFF;
-        uint8_t r = (argb >> 16) & 0xFF;
-        uint8_t g = (argb >> 8) & 0xFF;
-        uint8_t b = argb & 0xFF;
+    std::lock_guard<std::mutex> lock(handleMutex_);
+    idleHandles_.push_back(handle);
+}
 
-        // Repack as RGBA
-        pixels[i] = (r << 0) | (g << 8) | (b << 16) | (a << 24);
+void SlideLoader::CloseReadHandles() {
+    std::lock_guard<std::mutex> lock(handleMutex_);
+    for (openslide_t* handle : idleHandles_) {
+        openslide_close(handle);
     }
+    idleHandles_.clear();
+    readHandleCount_.store(0);
 }
 
 void SlideLoader::CheckError() {
@@ -187,7 +980,7 @@ void SlideLoader::CheckError() {
 
     const char* error = openslide_get_error(slide_);
     if (error) {
-        errorMessage_ = std::string(error);
-        std::cerr << "OpenSlide error: " << errorMessage_ << std::endl;
+        SetError(error);
+        PATHVIEW_LOG_ERROR("OpenSlide error: " << error);
     }
 }
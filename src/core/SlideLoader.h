@@ -3,13 +3,33 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include <openslide/openslide.h>
 
+class TiffTileReader;
+class ZarrPyramid;
+class SyntheticSlide;
+class RemoteFile;
+struct SlideMetadata;
+enum class TiffAccessPattern;
+
 struct LevelDimensions {
     int64_t width;
     int64_t height;
 };
 
+// Opens a slide through OpenSlide, or - for an http(s):// path - as a
+// remote tiled TIFF / SVS streamed with range requests (see RemoteFile).
+// Remote slides are read only through TiffTileReader: their levels come
+// from the TIFF directories and they have no associated images. So are
+// multichannel fluorescence slides (see GetChannelCount), OME-Zarr images
+// (read as multichannel slides through ZarrPyramid), and DICOM WSI
+// series (a directory of instances, or one of its files): each pyramid
+// level is one instance whose frames a TiffTileReader reads by offset
+// (see DicomFrameIndex). A synthetic:// path opens a procedural slide for
+// benchmarks (see SyntheticSlide).
 class SlideLoader {
 public:
     explicit SlideLoader(const std::string& path);
@@ -23,30 +43,212 @@ public:
 
     // Query slide properties
     bool IsValid() const;
-    const std::string& GetError() const;
+
+    // Most recent error, including errors hit by worker read handles.
+    // Returned by value since workers may update it concurrently.
+    std::string GetError() const;
     int32_t GetLevelCount() const;
     LevelDimensions GetLevelDimensions(int32_t level) const;
     double GetLevelDownsample(int32_t level) const;
 
+    // Size of the tiles a level is stored in (openslide.level[N].tile-width
+    // and -height), or {0, 0} if the format does not report it
+    LevelDimensions GetNativeTileSize(int32_t level) const;
+
     // Get level 0 dimensions (full resolution)
     int64_t GetWidth() const;
     int64_t GetHeight() const;
 
     // Read a region from the slide
-    // Returns RGBA pixel data (caller must delete[])
+    // Returns premultiplied ARGB pixel data (caller must delete[])
     // x, y are in level 0 coordinates
     uint32_t* ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height);
 
+    // Same as ReadRegion, but decodes into a caller-owned buffer of at
+    // least width * height pixels. Returns false on error.
+    // Thread-safe: each concurrent caller reads through its own OpenSlide
+    // handle (see AcquireReadHandle), so decoders never share OpenSlide's
+    // per-handle lock and cache.
+    bool ReadRegionInto(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                        uint32_t* pixels);
+
+    // Reduced-resolution read of a direct level (see
+    // TiffTileReader::ReadRegionScaled): width x height pixels at 1/scale
+    // of the level's resolution, starting at level 0 coordinates x, y.
+    // False for levels read through OpenSlide, which has no reduced decode
+    // (JPEG 2000 slides included), or scales the tiles don't allow; the
+    // caller then builds the pixels another way. Thread-safe.
+    bool ReadRegionScaled(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height, int32_t scale,
+                          uint32_t* pixels);
+    bool CanReadScaled(int32_t level, int32_t scale) const;
+    size_t GetScaledReadCount() const { return scaledReadCount_.load(); }
+
+    // Read an associated image ("thumbnail", "macro", "label", ...) as
+    // premultiplied ARGB into pixels. Returns false if the slide has no
+    // image by that name or it cannot be read. Thread-safe like
+    // ReadRegionInto.
+    bool ReadAssociatedImage(const std::string& name, std::vector<uint32_t>& pixels,
+                             int64_t& width, int64_t& height);
+
+    // Read handle statistics
+    size_t GetReadHandleCount() const { return readHandleCount_.load(); }
+    size_t GetReadErrorCount() const { return readErrorCount_.load(); }
+
+    // Decode JPEG tiles of Aperio / generic tiled TIFF levels directly
+    // (see TiffTileReader) instead of through OpenSlide. Reads on other
+    // levels or formats, and any direct read that fails, use OpenSlide.
+    // Returns whether any level is served directly. With memoryMap the
+    // file is mapped (see TiffTileReader). Not thread-safe: call before
+    // reads start.
+    bool SetDirectTiffRead(bool enabled, bool memoryMap = false);
+    bool IsDirectTiffReadActive() const { return directRead_; }
+    bool IsDirectTiffMapped() const;
+    bool IsDirectTiffLevel(int32_t level) const;
+    size_t GetDirectReadCount() const { return directReadCount_.load(); }
+    size_t GetDirectFallbackCount() const { return directFallbackCount_.load(); }
+
+    // Batch the direct reads' JPEG decodes on the GPU when a hardware
+    // decoder is available (JpegBatchDecoder::CreateHardware). Requires
+    // SetDirectTiffRead; returns whether a hardware decoder is in use.
+    bool SetHardwareJpegDecode(bool enabled);
+    size_t GetHardwareDecodeCount() const;
+
+    // OS access hints for direct reads (no-ops otherwise). PrewarmRegion
+    // takes level 0 coordinates like ReadRegion, returns immediately and
+    // is safe to call from any thread; it returns the bytes hinted.
+    void AdviseDirectTiffAccess(TiffAccessPattern pattern);
+    size_t PrewarmRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                         bool sequential = false) const;
+
+    // Blocking read of the tile bytes behind a region (level 0
+    // coordinates) of a direct level, so that a ReadRegionInto of it soon
+    // after does no I/O of its own (see TiffTileReader::Fetch). Returns
+    // the bytes read; 0 for levels read through OpenSlide. Thread-safe.
+    size_t FetchRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height) const;
+
+    // Multichannel (fluorescence) slides: a QPTIFF / OME-TIFF style file
+    // of single-sample channels (see TiffTileReader::BindChannels) that
+    // OpenSlide cannot read, or would show as one grey channel, or an
+    // OME-Zarr image (see ZarrPyramid) with its omero colours. 0 for RGB
+    // slides. Each channel's 8- or 16-bit samples are windowed to 8 bits
+    // between the 0.1th and 99.9th percentile of its coarsest level,
+    // measured on open. Reads through the slide itself are composited on
+    // the CPU, every channel added up in its default colour: that is what
+    // the minimap, exports and tile server see. OpenChannel gives a loader
+    // reading one channel as grey intensity for the GPU composite (see
+    // ChannelCompositor).
+    size_t GetChannelCount() const { return channels_.size(); }
+    const std::string& GetChannelName(size_t channel) const { return channels_[channel].name; }
+    uint32_t GetChannelColor(size_t channel) const { return channels_[channel].color; }  // 0xRRGGBB
+    std::unique_ptr<SlideLoader> OpenChannel(size_t channel) const;
+    // Channel a loader from OpenChannel reads, -1 for the slide itself
+    int32_t GetChannel() const { return channel_; }
+
+    // Remote slides (http:// or https:// path). Their direct reads are
+    // always on; nullptr for local slides.
+    bool IsRemote() const { return remoteFile_ != nullptr; }
+    const RemoteFile* GetRemoteFile() const { return remoteFile_.get(); }
+
     // Get slide path
     const std::string& GetPath() const { return path_; }
 
+    // Properties, levels and associated images, read once while opening
+    // (see SlideMetadata). Never null, and never changes: safe to keep and
+    // read from any thread, also after the loader is gone.
+    std::shared_ptr<const SlideMetadata> GetMetadata() const { return metadata_; }
+
 private:
-    void ConvertARGBtoRGBA(uint32_t* pixels, int64_t count);
+    struct Channel {
+        std::string name;
+        uint32_t color;
+        uint16_t windowLow;
+        uint16_t windowHigh;
+    };
+
+    // View of one of slide's channels (see OpenChannel)
+    SlideLoader(const SlideLoader& slide, int32_t channel);
+
+    // Opening: the OpenSlide path fills metadata's properties and
+    // associated images, then PublishMetadata adds the levels
+    void Open(SlideMetadata& metadata);
+    void ReadProperties(SlideMetadata& metadata);
+    void PublishMetadata(std::shared_ptr<SlideMetadata> metadata);
+    void OpenRemote();
+    void OpenZarr(SlideMetadata& metadata);
+    void OpenSynthetic(SlideMetadata& metadata);
+    // Open as a DICOM WSI series; false if path holds no tiled JPEG pyramid
+    bool OpenDicom(SlideMetadata& metadata);
+    // Reader serving a slide level directly and its level there, or
+    // nullptr if the level is read through OpenSlide
+    TiffTileReader* DirectReader(int32_t level, int32_t& readerLevel) const;
+    // Every reader direct reads go through
+    std::vector<TiffTileReader*> DirectReaders() const;
+    // Open as a multichannel slide if the file has at least minChannels
+    bool OpenChannels(size_t minChannels);
+    void MeasureChannelWindow(size_t channel);
+    // One channel of a region in level coordinates as stored, from the
+    // TIFF or the Zarr image
+    bool ReadChannelSamples(size_t channel, int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                            uint16_t* samples) const;
+    uint32_t GetChannelBits(size_t channel) const;
+    bool ReadChannelsInto(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                          uint32_t* pixels);
+    // One channel of a region in level coordinates, windowed to 8 bits
+    bool ReadChannelIntensity(size_t channel, int32_t level, int64_t x, int64_t y, int64_t width,
+                              int64_t height, uint8_t* intensity);
     void CheckError();
+    void SetError(const std::string& message);
 
-    openslide_t* slide_;
+    // Borrow an idle read handle, opening a new one if all are in use.
+    // Returns nullptr if the slide cannot be reopened.
+    openslide_t* AcquireReadHandle();
+    // Return a handle; handles in an error state are closed, since
+    // OpenSlide errors are sticky for the lifetime of a handle.
+    void ReleaseReadHandle(openslide_t* handle);
+    void CloseReadHandles();
+
+    openslide_t* slide_;   // Metadata handle (main thread)
     std::string path_;
+    std::string vendor_;
+
+    mutable std::mutex errorMutex_;
     std::string errorMessage_;
+
+    // Idle per-reader handles. The pool grows to the peak number of
+    // concurrent readers (normally the decode worker count).
+    std::mutex handleMutex_;
+    std::vector<openslide_t*> idleHandles_;
+    std::atomic<size_t> readHandleCount_{0};
+    std::atomic<size_t> readErrorCount_{0};
+
     std::vector<LevelDimensions> levelDimensions_;
     std::vector<double> levelDownsamples_;
+    std::vector<LevelDimensions> levelTileSizes_;
+
+    // Larger associated images (whole-slide macros of some scanners) are
+    // refused rather than decoded
+    static constexpr int64_t MAX_ASSOCIATED_IMAGE_PIXELS = 64ll * 1024 * 1024;
+
+    std::shared_ptr<RemoteFile> remoteFile_;
+    std::shared_ptr<TiffTileReader> tiffReader_;  // Shared with channel views
+    std::shared_ptr<ZarrPyramid> zarr_;  // Shared with channel views
+    std::shared_ptr<SyntheticSlide> synthetic_;
+    std::vector<std::shared_ptr<TiffTileReader>> dicomReaders_;  // One per level
+    // File fingerprinted for a slide whose path is a directory (the level 0
+    // DICOM instance, the Zarr group metadata)
+    std::string fingerprintPath_;
+    bool directRead_ = false;
+    std::atomic<size_t> directReadCount_{0};
+    std::atomic<size_t> scaledReadCount_{0};
+    std::atomic<size_t> directFallbackCount_{0};
+
+    std::vector<Channel> channels_;
+    int32_t channel_ = -1;
+
+    std::shared_ptr<const SlideMetadata> metadata_;
+
+    // Window measurements read at most this much of the coarsest level
+    static constexpr int64_t WINDOW_SAMPLE_SIZE = 2048;
+    static constexpr double WINDOW_LOW_FRACTION = 0.001;
+    static constexpr double WINDOW_HIGH_FRACTION = 0.999;
 };
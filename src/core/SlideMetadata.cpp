@@ -0,0 +1,45 @@
+#include "SlideMetadata.h"
+#include <cstdlib>
+
+namespace {
+
+// Positive number the property holds, or 0
+double ParsePositive(const SlideMetadata& metadata, const char* name) {
+    const std::string* value = metadata.FindProperty(name);
+    if (!value) {
+        return 0.0;
+    }
+    char* end = nullptr;
+    double number = std::strtod(value->c_str(), &end);
+    return end != value->c_str() && number > 0.0 ? number : 0.0;
+}
+
+}  // namespace
+
+const std::string* SlideMetadata::FindProperty(const std::string& name) const {
+    auto it = properties.find(name);
+    return it != properties.end() ? &it->second : nullptr;
+}
+
+const SlideMetadata::AssociatedImage* SlideMetadata::FindAssociatedImage(const std::string& name) const {
+    for (const AssociatedImage& image : associatedImages) {
+        if (image.name == name) {
+            return &image;
+        }
+    }
+    return nullptr;
+}
+
+void SlideMetadata::ParseStandardProperties() {
+    mppX = ParsePositive(*this, "openslide.mpp-x");
+    mppY = ParsePositive(*this, "openslide.mpp-y");
+    if (mppX <= 0.0 || mppY <= 0.0) {
+        // Square pixels
+        mppX = mppY = ParsePositive(*this, "aperio.MPP");
+    }
+
+    objectivePower = ParsePositive(*this, "openslide.objective-power");
+    if (objectivePower <= 0.0) {
+        objectivePower = ParsePositive(*this, "aperio.AppMag");
+    }
+}
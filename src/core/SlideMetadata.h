@@ -0,0 +1,50 @@
+#pragma once
+
+#include "SlideLoader.h"  // For LevelDimensions
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Everything about an open slide that cannot change: its levels, scan
+// resolution, associated images and vendor properties. SlideLoader reads
+// it once while opening (on the opening thread) and hands out shared
+// pointers to the finished snapshot, so the UI, IPC handlers and workers
+// read it concurrently without locks and without calling into OpenSlide.
+struct SlideMetadata {
+    struct Level {
+        LevelDimensions dimensions;
+        double downsample;
+        LevelDimensions tileSize;  // {0, 0} if the format does not report it
+    };
+
+    struct AssociatedImage {
+        std::string name;  // "thumbnail", "macro", "label", ...
+        int64_t width;
+        int64_t height;
+    };
+
+    std::string path;
+    std::string fingerprint;  // SlideFingerprint::Compute, empty for remote slides
+    std::string vendor;  // OpenSlide's, or "remote-tiff" / "multichannel-tiff" / "ome-zarr" / "dicom"
+    std::vector<Level> levels;
+
+    // Microns per level 0 pixel and scanning objective, 0 if unknown
+    double mppX = 0.0;
+    double mppY = 0.0;
+    double objectivePower = 0.0;
+
+    std::vector<AssociatedImage> associatedImages;
+    std::vector<std::string> channelNames;  // Multichannel slides only
+
+    // Every property OpenSlide reports, by name
+    std::map<std::string, std::string> properties;
+
+    // Value of a property, or nullptr
+    const std::string* FindProperty(const std::string& name) const;
+    const AssociatedImage* FindAssociatedImage(const std::string& name) const;
+
+    // Fill mppX, mppY and objectivePower from properties: OpenSlide's
+    // normalized ones, else the vendor's own (Aperio's MPP and AppMag)
+    void ParseStandardProperties();
+};
@@ -0,0 +1,202 @@
+#include "SlideOpenTask.h"
+#include "SlideLoader.h"
+#include "PyramidLayout.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+const char* SlideOpenStageName(SlideOpenStage stage) {
+    switch (stage) {
+        case SlideOpenStage::Opening: return "Opening slide";
+        case SlideOpenStage::ReadingThumbnail: return "Reading thumbnail";
+        case SlideOpenStage::ReadingOverview: return "Reading overview";
+        case SlideOpenStage::Ready: return "Ready";
+        case SlideOpenStage::Failed: return "Failed";
+    }
+    return "Unknown";
+}
+
+struct SlideOpenTask::State {
+    std::string path;
+    SlideOpenOptions options;
+    std::chrono::steady_clock::time_point start;
+
+    mutable std::mutex mutex;
+    mutable std::condition_variable finished;
+    std::function<void()> onProgress;  // Cleared when the task is abandoned
+    SlideOpenStage stage = SlideOpenStage::Opening;
+    SlidePreview preview;
+    bool previewReady = false;
+    std::unique_ptr<SlideLoader> loader;
+    MinimapOverview overview;
+    std::string error;
+
+    void SetStage(SlideOpenStage next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stage = next;
+        if (next == SlideOpenStage::Ready || next == SlideOpenStage::Failed) {
+            finished.notify_all();
+        }
+        if (onProgress) {
+            onProgress();
+        }
+    }
+
+    void SetPreview(SlidePreview image) {
+        std::lock_guard<std::mutex> lock(mutex);
+        preview = std::move(image);
+        previewReady = true;
+        if (onProgress) {
+            onProgress();
+        }
+    }
+};
+
+SlideOpenTask::SlideOpenTask(const std::string& path, const SlideOpenOptions& options,
+                             std::function<void()> onProgress)
+    : path_(path)
+    , state_(std::make_shared<State>())
+{
+    state_->path = path;
+    state_->options = options;
+    state_->start = std::chrono::steady_clock::now();
+    state_->onProgress = std::move(onProgress);
+    std::thread(Run, state_).detach();
+}
+
+SlideOpenTask::~SlideOpenTask() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->onProgress = nullptr;
+}
+
+SlideOpenStage SlideOpenTask::GetStage() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->stage;
+}
+
+bool SlideOpenTask::IsFinished() const {
+    SlideOpenStage stage = GetStage();
+    return stage == SlideOpenStage::Ready || stage == SlideOpenStage::Failed;
+}
+
+void SlideOpenTask::Wait() const {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->finished.wait(lock, [this]() {
+        return state_->stage == SlideOpenStage::Ready || state_->stage == SlideOpenStage::Failed;
+    });
+}
+
+double SlideOpenTask::GetElapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - state_->start).count();
+}
+
+bool SlideOpenTask::TakePreview(SlidePreview& preview) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!state_->previewReady) {
+        return false;
+    }
+    preview = std::move(state_->preview);
+    state_->preview = SlidePreview();
+    state_->previewReady = false;
+    return true;
+}
+
+std::unique_ptr<SlideLoader> SlideOpenTask::TakeLoader() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return std::move(state_->loader);
+}
+
+MinimapOverview SlideOpenTask::TakeOverview() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    MinimapOverview overview = std::move(state_->overview);
+    state_->overview = MinimapOverview();
+    return overview;
+}
+
+std::string SlideOpenTask::GetError() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->error;
+}
+
+void SlideOpenTask::Run(std::shared_ptr<State> state) {
+    // The loader stays private to this thread until Ready is published
+    auto loader = std::make_unique<SlideLoader>(state->path);
+    if (!loader->IsValid()) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->error = loader->GetError();
+        }
+        state->SetStage(SlideOpenStage::Failed);
+        return;
+    }
+
+    const SlideOpenOptions& options = state->options;
+    if (options.directTiffRead || options.hardwareJpegDecode || options.tiffMemoryMap) {
+        if (loader->SetDirectTiffRead(true, options.tiffMemoryMap) && options.hardwareJpegDecode) {
+            loader->SetHardwareJpegDecode(true);
+        }
+    }
+
+    // First frame: the scanner's thumbnail is usually far cheaper to read
+    // than even the lowest pyramid level. It makes the minimap overview too
+    // (the minimap refines it from tiles later).
+    state->SetStage(SlideOpenStage::ReadingThumbnail);
+    SlidePreview preview;
+    MinimapOverview overview;
+    bool hasOverview = false;
+    bool hasPreview = loader->ReadAssociatedImage("thumbnail", preview.pixels, preview.width, preview.height);
+    if (hasPreview) {
+        hasOverview = Minimap::OverviewFromImage(preview.pixels, preview.width, preview.height,
+                                                 loader->GetWidth(), loader->GetHeight(), overview);
+        while (std::max(preview.width, preview.height) > PREVIEW_MAX_SIZE) {
+            int64_t halfWidth = (preview.width + 1) / 2;
+            int64_t halfHeight = (preview.height + 1) / 2;
+            std::vector<uint32_t> half(static_cast<size_t>(halfWidth * halfHeight));
+            PyramidLayout::Downsample2x(preview.pixels.data(), static_cast<int32_t>(preview.width),
+                                        static_cast<int32_t>(preview.height),
+                                        static_cast<size_t>(preview.width), half.data(),
+                                        static_cast<size_t>(halfWidth));
+            preview.pixels.swap(half);
+            preview.width = halfWidth;
+            preview.height = halfHeight;
+        }
+        preview.source = "thumbnail";
+        state->SetPreview(std::move(preview));
+    }
+
+    if (!hasOverview) {
+        state->SetStage(SlideOpenStage::ReadingOverview);
+        if (hasPreview) {
+            Minimap::ReadPyramidOverview(loader.get(), Minimap::MINIMAP_MAX_SIZE, overview);
+        } else {
+            // Without a thumbnail one pyramid read serves both, at the
+            // preview's larger size
+            MinimapOverview large;
+            if (Minimap::ReadPyramidOverview(loader.get(), OVERVIEW_PREVIEW_SIZE, large)) {
+                Minimap::OverviewFromImage(large.pixels, large.width, large.height,
+                                           large.width, large.height, overview);
+                overview.exact = true;
+                SlidePreview fallback;
+                fallback.pixels = std::move(large.pixels);
+                fallback.width = large.width;
+                fallback.height = large.height;
+                fallback.source = "overview";
+                state->SetPreview(std::move(fallback));
+            }
+        }
+    }
+
+    PATHVIEW_LOG_INFO("Slide opened in background in " << std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - state->start).count()
+                      << " s");
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->loader = std::move(loader);
+        state->overview = std::move(overview);
+    }
+    state->SetStage(SlideOpenStage::Ready);
+}
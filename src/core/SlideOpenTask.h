@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Minimap.h"  // MinimapOverview
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SlideLoader;
+
+enum class SlideOpenStage {
+    Opening,           // openslide_open and header parsing
+    ReadingThumbnail,  // Associated thumbnail, for the first frame
+    ReadingOverview,   // Downsampled pyramid read, for the minimap
+    Ready,
+    Failed
+};
+
+const char* SlideOpenStageName(SlideOpenStage stage);
+
+// Image shown while the rest of a slide opens: the associated thumbnail,
+// or the overview if the slide has none
+struct SlidePreview {
+    std::vector<uint32_t> pixels;  // Premultiplied ARGB, like SlideLoader reads
+    int64_t width = 0;
+    int64_t height = 0;
+    std::string source;            // "thumbnail" or "overview"
+};
+
+struct SlideOpenOptions {
+    bool directTiffRead = false;   // See SlideLoader::SetDirectTiffRead
+    bool tiffMemoryMap = false;
+    bool hardwareJpegDecode = false;
+};
+
+// Opens a slide on a background thread: constructs the SlideLoader, sets
+// up direct TIFF reads, then reads a preview and the minimap overview
+// (both from the thumbnail when the slide has one).
+// Everything that needs the SDL renderer (SlideRenderer, textures) is left
+// to the GUI thread, which polls the task and finishes the setup once it
+// is finished.
+class SlideOpenTask {
+public:
+    // Starts opening immediately. onProgress runs on the task's thread
+    // after every stage change and once the preview is available.
+    SlideOpenTask(const std::string& path, const SlideOpenOptions& options,
+                  std::function<void()> onProgress = nullptr);
+
+    // Does not wait: an abandoned open runs to completion in the
+    // background and its slide is closed there, without calling
+    // onProgress again
+    ~SlideOpenTask();
+
+    SlideOpenTask(const SlideOpenTask&) = delete;
+    SlideOpenTask& operator=(const SlideOpenTask&) = delete;
+
+    const std::string& GetPath() const { return path_; }
+    SlideOpenStage GetStage() const;
+    bool IsFinished() const;  // Ready or Failed
+    void Wait() const;
+    double GetElapsedSeconds() const;
+
+    // Hands over the preview once it is available; false before that and
+    // after it has been taken
+    bool TakePreview(SlidePreview& preview);
+
+    // Results, once finished. The loader is nullptr if the open failed.
+    std::unique_ptr<SlideLoader> TakeLoader();
+    MinimapOverview TakeOverview();
+    std::string GetError() const;
+
+private:
+    struct State;  // Shared with the worker thread, which may outlive the task
+
+    static void Run(std::shared_ptr<State> state);
+
+    std::string path_;
+    std::shared_ptr<State> state_;
+
+    // Previews are halved down to this (thumbnails can exceed the GPU's
+    // texture size limit)
+    static constexpr int64_t PREVIEW_MAX_SIZE = 2048;
+    // Previews read from the pyramid (slides without a thumbnail) are this
+    // size; the minimap overview is shrunk from the same read
+    static constexpr int64_t OVERVIEW_PREVIEW_SIZE = 1024;
+};
@@ -5,52 +5,263 @@
 #include "TileCache.h"
 #include "TileLoadThreadPool.h"
 #include "TileLoadRequest.h"
-#include <iostream>
+#include "FrameProfiler.h"
+#include "FlatTileMap.h"
+#include "Log.h"
 #include <cmath>
 #include <algorithm>
+#include <set>
+#include <map>
 
-static const int32_t NUM_WORKER_THREADS = 4;
-
-SlideRenderer::SlideRenderer(SlideLoader* loader, SDL_Renderer* renderer, TextureManager* textureManager)
+SlideRenderer::SlideRenderer(SlideLoader* loader, TextureManager* textureManager,
+                             size_t workerThreads, bool autoScaleWorkers,
+                             DiskTileCache* diskCache)
     : loader_(loader)
-    , renderer_(renderer)
     , textureManager_(textureManager)
-    , tileCache_(std::make_unique<TileCache>())
+    , backend_(textureManager->GetBackend())
+    , ownedCache_(std::make_unique<TileCache>())
+    , tileCache_(ownedCache_.get())
+    , workerThreads_(workerThreads)
+    , autoScaleWorkers_(autoScaleWorkers)
+    , diskCache_(diskCache)
 {
+    if (loader_ && loader_->IsValid()) {
+        pyramid_ = PyramidLayout::FromSlide(*loader_, TILE_SIZE);
+        if (pyramid_.GetSynthesizedLevelCount() > 0) {
+            PATHVIEW_LOG_INFO("SlideRenderer: Synthesizing " << pyramid_.GetSynthesizedLevelCount()
+                              << " pyramid levels (" << pyramid_.GetLevelCount() << " total)");
+        }
+    }
 }
 
 SlideRenderer::~SlideRenderer() {
     Shutdown();
 }
 
+void SlideRenderer::SetSharedPipeline(TileLoadThreadPool* pool, TileCache* cache, uint32_t slideId) {
+    sharedPool_ = pool;
+    tileCache_ = cache;
+    ownedCache_.reset();
+    slideId_ = slideId;
+}
+
 void SlideRenderer::Initialize() {
-    if (!threadPool_) {
-        threadPool_ = std::make_unique<TileLoadThreadPool>(NUM_WORKER_THREADS);
-        threadPool_->Initialize(loader_, tileCache_.get(),
-            [this](const TileKey& key) { OnTileReady(key); });
-        threadPool_->Start();
-        std::cout << "SlideRenderer: Async tile loading initialized" << std::endl;
+    if (threadPool_) {
+        return;
     }
+
+    if (sharedPool_) {
+        TileLoadThreadPool::SlideSource source;
+        source.loader = loader_;
+        source.pyramid = &pyramid_;
+        source.diskCache = diskCache_;
+        source.stats = &pipelineStats_;
+        source.onTileReady = [this](const TileKey& key) { OnTileReady(key); };
+        if (!sharedPool_->AddSlide(slideId_, std::move(source))) {
+            PATHVIEW_LOG_ERROR("SlideRenderer: Slide " << slideId_ << " is already in the decode pool");
+            return;
+        }
+        threadPool_ = sharedPool_;
+        PATHVIEW_LOG_INFO("SlideRenderer: Joined the shared decode pool as slide " << slideId_);
+        return;
+    }
+
+    ownedPool_ = std::make_unique<TileLoadThreadPool>(workerThreads_);
+    ownedPool_->Initialize(loader_, tileCache_,
+        [this](const TileKey& key) { OnTileReady(key); });
+    ownedPool_->SetDiskCache(diskCache_);
+    ownedPool_->SetPyramid(&pyramid_);
+    ownedPool_->SetStats(&pipelineStats_);
+    if (autoScaleWorkers_) {
+        ownedPool_->EnableAutoScaling(AUTO_SCALE_MIN_WORKERS);
+    }
+    ownedPool_->Start();
+    threadPool_ = ownedPool_.get();
+    PATHVIEW_LOG_INFO("SlideRenderer: Async tile loading initialized");
 }
 
 void SlideRenderer::Shutdown() {
-    if (threadPool_) {
-        threadPool_->Stop();
-        threadPool_.reset();
-        std::cout << "SlideRenderer: Async tile loading shutdown" << std::endl;
+    if (detaching_) {
+        // Wait out abandoned decodes still running, and drop any tile one
+        // inserted just before it noticed
+        detaching_ = false;
+        sharedPool_->RemoveSlide(slideId_);
+        tileCache_->RemoveSlide(slideId_);
+        return;
+    }
+    if (!threadPool_) {
+        return;
     }
+    threadPool_ = nullptr;
+    if (ownedPool_) {
+        ownedPool_->Stop();
+        ownedPool_.reset();
+        PATHVIEW_LOG_INFO("SlideRenderer: Async tile loading shutdown");
+        return;
+    }
+
+    // The other slides keep the pool; hand this one's share of the cache back
+    sharedPool_->RemoveSlide(slideId_);
+    size_t freed = tileCache_->RemoveSlide(slideId_);
+    PATHVIEW_LOG_INFO("SlideRenderer: Left the shared decode pool, freeing "
+                      << (freed / (1024 * 1024)) << " MB of cached tiles");
+}
+
+void SlideRenderer::Detach() {
+    if (!threadPool_ || ownedPool_) {
+        Shutdown();
+        return;
+    }
+    threadPool_ = nullptr;
+    detaching_ = true;
+    sharedPool_->RemoveSlide(slideId_, false);
+    size_t freed = tileCache_->RemoveSlide(slideId_);
+    PATHVIEW_LOG_INFO("SlideRenderer: Leaving the shared decode pool, freeing "
+                      << (freed / (1024 * 1024)) << " MB of cached tiles");
+}
+
+bool SlideRenderer::IsDetached() const {
+    return !threadPool_ && (!detaching_ || !sharedPool_->HasSlide(slideId_));
 }
 
 void SlideRenderer::Render(const Viewport& viewport) {
-    if (!loader_ || !loader_->IsValid()) {
+    singleView_[0] = RenderView();
+    singleView_[0].viewport = &viewport;
+    Render(singleView_);
+}
+
+void SlideRenderer::Render(const std::vector<RenderView>& views) {
+    if (!loader_ || !loader_->IsValid() || pyramid_.GetLevelCount() == 0 || views.empty()) {
         return;
     }
 
-    // Select appropriate level based on zoom
-    int32_t level = SelectLevel(viewport.GetZoom());
+    // Textures drawn from here on are pinned against eviction for this frame
+    textureManager_->BeginFrame();
+
+    // Decode volume since the previous frame, to compare level strategies
+    if (threadPool_) {
+        uint64_t decoded = threadPool_->GetDecodedBytes();
+        decodedBytesLastFrame_ = decoded - lastDecodedBytes_;
+        lastDecodedBytes_ = decoded;
+    }
+
+    // New render pass: requests not resubmitted in this generation are stale
+    generation_++;
+    deferredUploads_ = 0;
+    lastUncoveredTiles_ = 0;
+    lastBackgroundTiles_ = 0;
+    lastSolidTiles_ = 0;
+    lastDrawCalls_ = 0;
+    lastDrawnQuads_ = 0;
+    lastRequestedTiles_ = 0;
+    frameRequests_.clear();
+    scheduler_.BeginFrame(TileScheduler::Clock::now());
+    fallbackPlans_.resize(views.size());
+    viewLevels_.resize(views.size());
+
+    bool overlappingRequests = views.size() > 1;  // May ask for a tile twice
+    for (size_t i = 0; i < views.size(); ++i) {
+        const RenderView& view = views[i];
+        bool pane = view.screenRect.w > 0 && view.screenRect.h > 0;
+        if (pane) {
+            backend_->SetViewport(&view.screenRect);
+        }
 
-    // Render using tiles
-    RenderTiled(viewport, level);
+        // Select appropriate level based on zoom, and render using tiles
+        fallbackPlan_ = &fallbackPlans_[i];
+        if (i == 0) {
+            UpdateMotionState(*view.viewport);
+        }
+        int32_t level = SelectViewLevel(*view.viewport, i);
+        if (i == 0) {
+            level = CoarsenForMotion(level);
+        }
+        RenderTiled(*view.viewport, level, i);
+        if (view.viewport->IsAnimating()) {
+            RequestAnimationTarget(*view.viewport);
+            overlappingRequests = true;
+        }
+
+        if (pane) {
+            backend_->SetViewport(nullptr);
+        }
+    }
+    scheduler_.EndFrame();
+
+    if (threadPool_) {
+        // One round of requests for every view: shared tiles once, at the
+        // most urgent priority any view gave them
+        if (!frameRequests_.empty()) {
+            ProfileZone zone(profiler_, "Requests");
+            auto submitStart = TilePipelineStats::Clock::now();
+            if (overlappingRequests) {
+                MergeRequests(frameRequests_);
+            }
+            lastRequestedTiles_ = frameRequests_.size();
+            // Best first: each band is served in submission order
+            std::sort(frameRequests_.begin(), frameRequests_.end(),
+                      [](const TileLoadRequest& a, const TileLoadRequest& b) { return b < a; });
+            threadPool_->SubmitRequests(frameRequests_.data(), frameRequests_.size());
+            pipelineStats_.RecordSince(TileStage::Submit, submitStart);
+        }
+
+        // Demote or drop requests for tiles that scrolled off screen
+        threadPool_->RetireStaleSlideRequests(slideId_, generation_);
+    }
+
+    // Resize the decode pool to this frame's backlog (a shared pool's
+    // owner does that once for all its slides)
+    if (ownedPool_) {
+        ownedPool_->UpdateScaling();
+    }
+
+    // Work off a lowered cache limit a few tiles per frame
+    tileCache_->EvictLRU(CACHE_EVICTIONS_PER_FRAME);
+}
+
+void SlideRenderer::MergeRequests(std::vector<TileLoadRequest>& requests) {
+    std::sort(requests.begin(), requests.end(), [](const TileLoadRequest& a, const TileLoadRequest& b) {
+        if (a.key == b.key) {
+            return static_cast<int32_t>(a.priority) > static_cast<int32_t>(b.priority);
+        }
+        return a.key < b.key;
+    });
+    requests.erase(std::unique(requests.begin(), requests.end(),
+                               [](const TileLoadRequest& a, const TileLoadRequest& b) { return a.key == b.key; }),
+                   requests.end());
+}
+
+size_t SlideRenderer::GetFallbackQuadCount() const {
+    size_t quads = 0;
+    for (const FallbackPlan& plan : fallbackPlans_) {
+        quads += plan.quads.size();
+    }
+    return quads;
+}
+
+void SlideRenderer::SetLevelSelection(LevelSelection mode) {
+    levelSelection_ = mode;
+
+    // Coarser levels are drawn magnified; linear sampling hides the blockiness
+    textureManager_->SetScaleMode(mode == LevelSelection::CoarserOrEqual
+        ? SDL_ScaleModeLinear : SDL_ScaleModeNearest);
+}
+
+TileHandle SlideRenderer::GetCachedTile(const TileKey& key) const {
+    if (!tileCache_) {
+        return TileHandle();
+    }
+    TileKey slideKey = key;
+    slideKey.slide = slideId_;
+    return tileCache_->GetTile(slideKey);
+}
+
+void SlideRenderer::RequestTile(const TileKey& key, TileLoadPriority priority) {
+    if (threadPool_) {
+        TileKey slideKey = key;
+        slideKey.slide = slideId_;
+        threadPool_->SubmitRequest(TileLoadRequest(slideKey, priority, generation_.load()));
+    }
 }
 
 size_t SlideRenderer::GetCacheTileCount() const {
@@ -65,36 +276,253 @@ double SlideRenderer::GetCacheHitRate() const {
     return tileCache_ ? tileCache_->GetHitRate() : 0.0;
 }
 
+TileBufferPool::Stats SlideRenderer::GetBufferPoolStats() const {
+    return tileCache_ ? tileCache_->GetBufferPoolStats() : TileBufferPool::Stats{};
+}
+
+void SlideRenderer::SetCacheMaxMemory(size_t maxBytes) {
+    if (tileCache_) {
+        tileCache_->SetMaxMemory(maxBytes);
+    }
+}
+
+size_t SlideRenderer::GetCacheMaxMemory() const {
+    return tileCache_ ? tileCache_->GetMaxMemory() : 0;
+}
+
+void SlideRenderer::SetCompressedCacheMaxMemory(size_t maxBytes) {
+    if (tileCache_) {
+        tileCache_->GetCompressedTier().SetMaxBytes(maxBytes);
+    }
+}
+
+const CompressedTileCache* SlideRenderer::GetCompressedTier() const {
+    return tileCache_ ? &tileCache_->GetCompressedTier() : nullptr;
+}
+
+size_t SlideRenderer::TrimCompressedCache(size_t bytes) {
+    return tileCache_ ? tileCache_->GetCompressedTier().Trim(bytes) : 0;
+}
+
+size_t SlideRenderer::ShrinkCache(size_t bytes) {
+    if (!tileCache_) {
+        return 0;
+    }
+    size_t usage = tileCache_->GetMemoryUsage();
+    size_t target = usage > bytes ? usage - bytes : 0;
+    // Only ever lowers the limit: an earlier shrink or a smaller configured
+    // budget (--tile-cache-mb) may be below usage while eviction catches up
+    tileCache_->SetMaxMemory(std::min(tileCache_->GetMaxMemory(), std::max(target, MIN_CACHE_BYTES)));
+    tileCache_->EvictLRU(CACHE_EVICTIONS_PER_FRAME);
+
+    // Evicted tiles park their buffers in the pool; only freeing those
+    // actually lowers the footprint
+    return TrimBufferPool();
+}
+
+size_t SlideRenderer::TrimBufferPool() {
+    if (!tileCache_) {
+        return 0;
+    }
+    size_t idleBefore = tileCache_->GetBufferPoolStats().idleBytes;
+    tileCache_->GetBufferPool()->Trim();
+    size_t idleAfter = tileCache_->GetBufferPoolStats().idleBytes;
+    return idleBefore > idleAfter ? idleBefore - idleAfter : 0;
+}
+
 size_t SlideRenderer::GetPendingTileCount() const {
-    return threadPool_ ? threadPool_->GetPendingCount() : 0;
+    return threadPool_ ? threadPool_->GetPendingCount(slideId_) : 0;
+}
+
+size_t SlideRenderer::GetDroppedTileCount() const {
+    return threadPool_ ? threadPool_->GetDroppedCount() : 0;
+}
+
+size_t SlideRenderer::GetWorkerThreadCount() const {
+    return threadPool_ ? threadPool_->GetThreadCount() : 0;
 }
 
-void SlideRenderer::OnTileReady(const TileKey& key) {
-    // Called from background thread when a tile finishes loading
-    // Remove from our pending set
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    pendingTiles_.erase(key);
-    // The tile is now in cache and will be picked up on next render frame
+size_t SlideRenderer::GetActiveWorkerLimit() const {
+    return threadPool_ ? threadPool_->GetWorkerLimit() : 0;
+}
+
+double SlideRenderer::GetAverageDecodeMs() const {
+    return threadPool_ ? threadPool_->GetAverageDecodeMs() : 0.0;
+}
+
+size_t SlideRenderer::GetCoalescedReadCount() const {
+    return threadPool_ ? threadPool_->GetCoalescedReadCount() : 0;
+}
+
+size_t SlideRenderer::GetCoalescedTileCount() const {
+    return threadPool_ ? threadPool_->GetCoalescedTileCount() : 0;
+}
+
+void SlideRenderer::OnTileReady(const TileKey& /*key*/) {
+    // Called from background thread when a tile finishes loading.
+    // Pending state lives in the thread pool; the tile is now in cache and
+    // will be picked up on next render frame, which the callback requests.
+    tileArrivals_++;  // Invalidates the fallback plan
+    if (tileReadyCallback_) {
+        tileReadyCallback_();
+    }
 }
 
 int32_t SlideRenderer::SelectLevel(double zoom) const {
+    return SelectLevel(pyramid_.GetDownsamples(), zoom * levelZoomScale_, levelSelection_);
+}
+
+void SlideRenderer::SetDisplayScale(double scale) {
+    displayScale_ = std::clamp(scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    levelZoomScale_ = displayScale_ * renderScale_;
+}
+
+void SlideRenderer::SetRenderScale(double still, double moving) {
+    renderScale_ = std::clamp(still, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    movingRenderScale_ = std::clamp(moving, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+    levelZoomScale_ = displayScale_ * renderScale_;
+}
+
+int32_t SlideRenderer::SelectViewLevel(const Viewport& viewport, size_t viewIndex) {
+    ViewLevel& state = viewLevels_[viewIndex];
+    if (!viewport.IsAnimating()) {
+        state.held = -1;
+        const int32_t level = SelectLevel(pyramid_.GetDownsamples(), viewport.GetZoom() * levelZoomScale_,
+                                          levelSelection_, state.shown);
+        state.shown = PreferResidentLevel(viewport, level);
+        return state.shown;
+    }
+
+    // Chosen when the animation starts, and again when a new one retargets
+    // it (wheel zooms in a row), never finer than what is on screen
+    const double targetZoom = viewport.GetTargetZoom();
+    if (state.held < 0 || targetZoom != state.targetZoom) {
+        const int32_t shown = state.shown >= 0 ? state.shown : SelectLevel(viewport.GetZoom());
+        state.held = std::max(shown, SelectLevel(targetZoom));
+        state.targetZoom = targetZoom;
+    }
+    state.shown = state.held;
+    return state.held;
+}
+
+bool SlideRenderer::IsLevelResident(const Viewport& viewport, int32_t level) {
+    std::vector<TileKey>& tiles = scratch_.residency;
+    tiles.clear();
+    EnumerateVisibleTiles(viewport, level, tiles);
+    for (const TileKey& key : tiles) {
+        if (!textureManager_->HasTexture(key) && !IsBackgroundTile(key) && !tileCache_->HasTile(key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t SlideRenderer::PreferResidentLevel(const Viewport& viewport, int32_t level) {
+    if (!tileCache_ || IsLevelResident(viewport, level)) {
+        return level;
+    }
+    const double targetDownsample = 1.0 / (viewport.GetZoom() * levelZoomScale_);
+    const int32_t coarser = level + 1;
+    if (coarser < pyramid_.GetLevelCount() &&
+        pyramid_.GetLevelDownsample(coarser) <= targetDownsample * MAX_RESIDENT_BLUR &&
+        IsLevelResident(viewport, coarser)) {
+        return coarser;
+    }
+    const int32_t finer = level - 1;
+    if (finer >= 0 && levelSelection_ == LevelSelection::Closest && IsLevelResident(viewport, finer)) {
+        return finer;
+    }
+    return level;
+}
+
+void SlideRenderer::UpdateMotionState(const Viewport& viewport) {
+    // panVelocity_ is last pass's estimate, in slide units a millisecond
+    const double screenSpeed = std::hypot(panVelocity_.x, panVelocity_.y) * viewport.GetZoom();
+    const uint32_t now = SDL_GetTicks();
+    if (screenSpeed >= MOTION_SPEED) {
+        moving_ = true;
+        motionBias_ = std::max(motionBias_, MotionBias(screenSpeed, motionLevels_));
+        lastFastTicks_ = now;
+    } else if (now - lastFastTicks_ >= MOTION_SETTLE_MS) {
+        // Settled: the proper level's tiles are requested this pass, the
+        // scheduler ranking them from the centre out over the coarse
+        // fallbacks, and stale coarse requests retire
+        moving_ = false;
+        motionBias_ = 0;
+    }
+    motionBias_ = std::min(motionBias_, motionLevels_);
+
+    const bool moving = moving_ || viewport.IsAnimating();
+    levelZoomScale_ = displayScale_ * (moving ? movingRenderScale_ : renderScale_);
+    motionCoarsened_ = motionBias_ > 0 || (moving_ && movingRenderScale_ < renderScale_);
+}
+
+int32_t SlideRenderer::CoarsenForMotion(int32_t level) const {
+    return std::min(level + motionBias_, pyramid_.GetLevelCount() - 1);
+}
+
+int32_t SlideRenderer::MotionBias(double screenSpeed, int32_t maxLevels) {
+    int32_t bias = 0;
+    if (screenSpeed >= 2.0 * MOTION_SPEED) {
+        bias = 2;
+    } else if (screenSpeed >= MOTION_SPEED) {
+        bias = 1;
+    }
+    return std::min(bias, maxLevels);
+}
+
+void SlideRenderer::RequestAnimationTarget(const Viewport& viewport) {
+    if (!threadPool_) {
+        return;
+    }
+    // At the still render scale: the view lands there
+    const int32_t level = SelectLevel(pyramid_.GetDownsamples(),
+                                      viewport.GetTargetZoom() * displayScale_ * renderScale_, levelSelection_);
+    std::vector<TileKey>& tiles = scratch_.animationTarget;
+    tiles.clear();
+    EnumerateTilesInRegion(viewport.GetTargetVisibleRegion(), level, tiles);
+    for (const TileKey& key : tiles) {
+        if (textureManager_->HasTexture(key) || IsBackgroundTile(key)) {
+            continue;
+        }
+        frameRequests_.emplace_back(key, TileLoadPriority::VISIBLE, generation_);
+    }
+}
+
+int32_t SlideRenderer::SelectLevel(const std::vector<double>& downsamples, double zoom, LevelSelection mode) {
     // Goal: Select level where downsample ≈ 1/zoom
     // At 100% zoom (1.0), we want level 0 (downsample 1)
     // At 50% zoom (0.5), we want a level with downsample ~2
     // At 25% zoom (0.25), we want a level with downsample ~4
 
     double targetDownsample = 1.0 / zoom;
-    int32_t levelCount = loader_->GetLevelCount();
+    int32_t levelCount = static_cast<int32_t>(downsamples.size());
+    if (levelCount == 0) {
+        return 0;
+    }
+
+    if (mode == LevelSelection::CoarserOrEqual) {
+        // Never fetch more pixels than the screen shows: take the finest
+        // level whose downsample is at least the target (within rounding,
+        // since real pyramids have downsamples like 3.99987), or the
+        // coarsest one when zoomed out past it
+        for (int32_t i = 0; i < levelCount; ++i) {
+            if (downsamples[i] >= targetDownsample * (1.0 - DOWNSAMPLE_TOLERANCE)) {
+                return i;
+            }
+        }
+        return levelCount - 1;
+    }
 
     int32_t bestLevel = 0;
-    double bestDiff = std::abs(loader_->GetLevelDownsample(0) - targetDownsample);
+    double bestDiff = std::abs(downsamples[0] - targetDownsample);
 
     for (int32_t i = 1; i < levelCount; ++i) {
-        double downsample = loader_->GetLevelDownsample(i);
+        double downsample = downsamples[i];
         double diff = std::abs(downsample - targetDownsample);
 
         // Prefer higher resolution when between two levels to avoid pixelation
-        if (diff < bestDiff || (diff == bestDiff && downsample < loader_->GetLevelDownsample(bestLevel))) {
+        if (diff < bestDiff || (diff == bestDiff && downsample < downsamples[bestLevel])) {
             bestDiff = diff;
             bestLevel = i;
         }
@@ -103,24 +531,194 @@ int32_t SlideRenderer::SelectLevel(double zoom) const {
     return bestLevel;
 }
 
-void SlideRenderer::RenderTiled(const Viewport& viewport, int32_t level) {
+int32_t SlideRenderer::SelectLevel(const std::vector<double>& downsamples, double zoom, LevelSelection mode,
+                                   int32_t current) {
+    const int32_t level = SelectLevel(downsamples, zoom, mode);
+    if (current < 0 || current >= static_cast<int32_t>(downsamples.size()) || std::abs(current - level) != 1) {
+        return level;
+    }
+    // Level choice falls as zoom rises, so current is kept while either
+    // end of the band around zoom still picks it
+    if (SelectLevel(downsamples, zoom * (1.0 + LEVEL_HYSTERESIS), mode) == current ||
+        SelectLevel(downsamples, zoom / (1.0 + LEVEL_HYSTERESIS), mode) == current) {
+        return current;
+    }
+    return level;
+}
+
+void SlideRenderer::RenderTiled(const Viewport& viewport, int32_t level, size_t viewIndex) {
     // Enumerate visible tiles
-    std::vector<TileKey> visibleTiles = EnumerateVisibleTiles(viewport, level);
+    std::vector<TileKey>& visibleTiles = scratch_.visible;
+    visibleTiles.clear();
+    EnumerateVisibleTiles(viewport, level, visibleTiles);
 
-    // Load and render each visible tile
-    for (const auto& tileKey : visibleTiles) {
-        LoadAndRenderTile(tileKey, viewport, level);
+    // 1. Draw tiles already on the GPU, and sort out which of the rest have
+    // decoded pixels waiting for upload
+    std::vector<PendingUpload>& uploads = scratch_.uploads;
+    std::vector<TileKey>& missing = scratch_.missing;
+    std::vector<TileKey>& uncovered = scratch_.uncovered;
+    std::vector<TileKey>& background = scratch_.background;
+    std::vector<SolidTile>& solid = scratch_.solid;
+    uploads.clear();
+    missing.clear();
+    uncovered.clear();
+    background.clear();
+    solid.clear();
+    {
+        ProfileZone zone(profiler_, "Resident tiles");
+        for (const auto& tileKey : visibleTiles) {
+            // Glass: nothing to decode, upload or fall back on
+            if (IsBackgroundTile(tileKey)) {
+                background.push_back(tileKey);
+                continue;
+            }
+
+            int32_t width = 0;
+            int32_t height = 0;
+            SDL_Rect source;
+            RenderTexture* texture = textureManager_->GetTexture(tileKey, &width, &height, &source);
+            if (texture) {
+                RenderTileToScreen(tileKey, texture, source, width, height, viewport, level);
+                continue;
+            }
+
+            // Queued on an earlier frame and still on its way to the GPU
+            if (textureManager_->IsUploadPending(tileKey)) {
+                deferredUploads_++;
+                uncovered.push_back(tileKey);
+                continue;
+            }
+
+            // The handle pins the pixels while they are uploaded, even if a
+            // worker evicts the tile meanwhile
+            TileHandle tile = tileCache_->GetTile(tileKey);
+            if (!tile) {
+                missing.push_back(tileKey);
+                continue;
+            }
+
+            // One color: drawn flat, never uploaded. Channel passes add
+            // tinted texels, which a flat fill can't do.
+            if (tile->storage == TileStorage::Solid && !IsChannelStyled()) {
+                solid.push_back({tileKey, tile->width, tile->height, tile->solidColor});
+                continue;
+            }
+
+            SDL_Rect rect = TileScreenRect(tileKey, tile->width, tile->height, viewport, level);
+            int64_t visibleW = std::min(rect.x + rect.w, viewport.GetWindowWidth()) - std::max(rect.x, 0);
+            int64_t visibleH = std::min(rect.y + rect.h, viewport.GetWindowHeight()) - std::max(rect.y, 0);
+            uploads.push_back({tileKey, std::move(tile), std::max<int64_t>(0, visibleW) * std::max<int64_t>(0, visibleH)});
+        }
     }
-}
 
-std::vector<TileKey> SlideRenderer::EnumerateVisibleTiles(const Viewport& viewport, int32_t level) const {
-    std::vector<TileKey> tiles;
+    // 2. Upload within this frame's budget, largest screen coverage first.
+    // Tiles over budget keep showing their fallback until a later frame.
+    {
+        ProfileZone zone(profiler_, "Upload");
+        std::stable_sort(uploads.begin(), uploads.end(),
+                         [](const PendingUpload& a, const PendingUpload& b) { return a.coverage > b.coverage; });
+        for (const auto& upload : uploads) {
+            const TileData& tile = *upload.tile;
+            size_t bytes = static_cast<size_t>(tile.width) * tile.height * sizeof(uint32_t);
+            if (textureManager_->HasUploadBudget(bytes)) {
+                // Asynchronous where the backend can: drawn from a later
+                // frame, and the handle keeps the pixels until copied.
+                // Packed tiles (TileCache::SetStorage) upload an unpacked
+                // copy, which it keeps instead.
+                auto uploadStart = TilePipelineStats::Clock::now();
+                std::shared_ptr<const void> owner = upload.tile;
+                const uint32_t* pixels = tile.GetArgb(unpackBuffer_);
+                if (tile.storage != TileStorage::Argb && textureManager_->HasAsyncUploads()) {
+                    auto unpacked = std::make_shared<std::vector<uint32_t>>(std::move(unpackBuffer_));
+                    pixels = unpacked->data();
+                    owner = std::move(unpacked);
+                }
+                if (textureManager_->QueueTexture(upload.key, std::move(owner), pixels, tile.width, tile.height)) {
+                    pipelineStats_.RecordSince(TileStage::Upload, uploadStart);
+                    RecordFirstDraw(tile);
+                    deferredUploads_++;
+                    uncovered.push_back(upload.key);
+                    continue;
+                }
 
-    // Get visible region in slide coordinates (level 0)
-    Rect visibleRegion = viewport.GetVisibleRegion();
+                SDL_Rect source;
+                RenderTexture* texture = textureManager_->GetOrCreateTexture(upload.key, pixels,
+                                                                             tile.width, tile.height, &source);
+                if (texture) {
+                    pipelineStats_.RecordSince(TileStage::Upload, uploadStart);
+                    RenderTileToScreen(upload.key, texture, source, tile.width, tile.height, viewport, level);
+                    RecordFirstDraw(tile);
+                    continue;
+                }
+            }
+            deferredUploads_++;
+            uncovered.push_back(upload.key);
+        }
+        uploads.clear();
+    }
 
+    // 3. Coarser stand-ins for everything not drawn above, then load
+    // requests for tiles not decoded yet. This happens every frame the tile
+    // is missing: the pool dedupes it and refreshes its generation, which
+    // is what keeps it from being retired as stale.
+    uncovered.insert(uncovered.end(), missing.begin(), missing.end());
+    std::sort(uncovered.begin(), uncovered.end());
+    lastUncoveredTiles_ += uncovered.size();
+    {
+        ProfileZone zone(profiler_, "Fallbacks");
+        RenderFallbacks(uncovered, viewport, level);
+    }
+
+    // Submitted by Render() once every view is drawn. Without a fallback
+    // showing a tile is URGENT, and so is one blurry past the scheduler's
+    // deadline; the rest are VISIBLE, ranked by the scheduler's score.
+    if (threadPool_) {
+        const int32_t viewWidth = viewport.GetWindowWidth();
+        const int32_t viewHeight = viewport.GetWindowHeight();
+        const double levelFit = TileScheduler::LevelFit(pyramid_.GetLevelDownsample(level),
+                                                        1.0 / (viewport.GetZoom() * levelZoomScale_));
+        for (const auto& tileKey : missing) {
+            SDL_Rect rect = TileScreenRect(tileKey, pyramid_.GetTileWidth(level), pyramid_.GetTileHeight(level),
+                                           viewport, level);
+            TileScheduler::Inputs inputs;
+            inputs.coverage = TileScheduler::Coverage(rect, viewWidth, viewHeight);
+            inputs.centreDistance = TileScheduler::CentreDistance(rect, viewWidth, viewHeight);
+            inputs.hasFallback = std::binary_search(fallbackPlan_->covered.begin(),
+                                                    fallbackPlan_->covered.end(), tileKey);
+            inputs.levelFit = levelFit;
+            frameRequests_.push_back(scheduler_.Schedule(tileKey, inputs, generation_));
+        }
+    }
+
+    // Tiles and fallbacks never overlap, so one draw per page keeps the
+    // picture identical. Every upload of this pass happened above, so no
+    // page changes after its quads are queued.
+    {
+        ProfileZone zone(profiler_, "Draw");
+        RenderBackgroundTiles(background, viewport, level);
+        RenderSolidTiles(solid, viewport, level);
+        lastDrawnQuads_ += batch_.GetQuadCount();
+        lastDrawCalls_ += batch_.Flush(*backend_);
+    }
+
+    // Queue low-priority loads for where the viewport is heading next
+    if (viewIndex == 0) {
+        ProfileZone zone(profiler_, "Prefetch");
+        UpdateMotionEstimate(viewport);
+        PrefetchTiles(viewport, level, visibleTiles);
+    }
+}
+
+void SlideRenderer::EnumerateVisibleTiles(const Viewport& viewport, int32_t level,
+                                          std::vector<TileKey>& tiles) const {
+    // Visible region in slide coordinates (level 0)
+    EnumerateTilesInRegion(viewport.GetVisibleRegion(), level, tiles);
+}
+
+void SlideRenderer::EnumerateTilesInRegion(const Rect& visibleRegion, int32_t level,
+                                           std::vector<TileKey>& tiles) const {
     // Get downsample factor for this level
-    double downsample = loader_->GetLevelDownsample(level);
+    double downsample = pyramid_.GetLevelDownsample(level);
 
     // Convert visible region to level coordinates
     int64_t levelLeft = static_cast<int64_t>(visibleRegion.x / downsample);
@@ -129,7 +727,7 @@ std::vector<TileKey> SlideRenderer::EnumerateVisibleTiles(const Viewport& viewpo
     int64_t levelBottom = static_cast<int64_t>((visibleRegion.y + visibleRegion.height) / downsample);
 
     // Get level dimensions
-    auto levelDims = loader_->GetLevelDimensions(level);
+    auto levelDims = pyramid_.GetLevelDimensions(level);
 
     // Clamp to level bounds
     levelLeft = std::max<int64_t>(0, levelLeft);
@@ -137,172 +735,540 @@ std::vector<TileKey> SlideRenderer::EnumerateVisibleTiles(const Viewport& viewpo
     levelRight = std::min(levelDims.width, levelRight);
     levelBottom = std::min(levelDims.height, levelBottom);
 
-    // Calculate tile indices
-    int32_t startTileX = static_cast<int32_t>(levelLeft / TILE_SIZE);
-    int32_t startTileY = static_cast<int32_t>(levelTop / TILE_SIZE);
-    int32_t endTileX = static_cast<int32_t>(levelRight / TILE_SIZE);
-    int32_t endTileY = static_cast<int32_t>(levelBottom / TILE_SIZE);
+    // Calculate tile indices on this level's grid
+    int32_t tileWidth = pyramid_.GetTileWidth(level);
+    int32_t tileHeight = pyramid_.GetTileHeight(level);
+    int32_t startTileX = static_cast<int32_t>(levelLeft / tileWidth);
+    int32_t startTileY = static_cast<int32_t>(levelTop / tileHeight);
+    int32_t endTileX = static_cast<int32_t>(levelRight / tileWidth);
+    int32_t endTileY = static_cast<int32_t>(levelBottom / tileHeight);
+
+    if (levelRight < levelLeft || levelBottom < levelTop) {
+        return;  // Region lies entirely outside the slide
+    }
 
     // Enumerate all visible tiles
     for (int32_t ty = startTileY; ty <= endTileY; ++ty) {
         for (int32_t tx = startTileX; tx <= endTileX; ++tx) {
-            tiles.push_back({level, tx, ty});
+            tiles.push_back({level, tx, ty, slideId_});
         }
     }
+}
+
+void SlideRenderer::UpdateMotionEstimate(const Viewport& viewport) {
+    uint32_t now = SDL_GetTicks();
+    Vec2 position = viewport.GetPosition();
+    double zoom = viewport.GetZoom();
+
+    if (hasLastFrame_ && now > lastFrameTicks_) {
+        double dt = static_cast<double>(now - lastFrameTicks_);
+        Vec2 instantVelocity = (position - lastPosition_) / dt;
+
+        // Exponential smoothing so one jittery frame doesn't swing the prediction
+        panVelocity_ = panVelocity_ * (1.0 - VELOCITY_SMOOTHING) + instantVelocity * VELOCITY_SMOOTHING;
+    }
+
+    // Zoom direction: a running animation knows where it ends; otherwise
+    // infer it from the frame-to-frame change
+    double zoomReference = viewport.IsAnimating() ? viewport.GetTargetZoom() : zoom;
+    double zoomBase = viewport.IsAnimating() ? zoom : lastZoom_;
+    if (zoomReference > zoomBase * 1.001) {
+        zoomDirection_ = 1;
+    } else if (zoomReference < zoomBase * 0.999) {
+        zoomDirection_ = -1;
+    } else {
+        zoomDirection_ = 0;
+    }
 
-    return tiles;
+    lastFrameTicks_ = now;
+    lastPosition_ = position;
+    lastZoom_ = zoom;
+    hasLastFrame_ = true;
 }
 
-void SlideRenderer::LoadAndRenderTile(const TileKey& key, const Viewport& viewport, int32_t level) {
-    // 1. Check cache - if hit, render immediately
-    const TileData* cachedTile = tileCache_->GetTile(key);
-    if (cachedTile) {
-        RenderTileToScreen(key, cachedTile, viewport, level);
+void SlideRenderer::PrefetchTiles(const Viewport& viewport, int32_t level,
+                                  const std::vector<TileKey>& visibleTiles) {
+    if (!threadPool_ || prefetchLimit_ == 0) {
         return;
     }
 
-    // 2. Cache miss - find and render fallback from coarser pyramid level
-    TileKey fallbackKey;
-    const TileData* fallbackTile = FindBestFallback(key, &fallbackKey);
-    if (fallbackTile) {
-        RenderFallbackTile(key, fallbackKey, fallbackTile, viewport, level);
+    // Predict the next viewport: the animation target when viewport.move or
+    // a smooth zoom is running, otherwise extrapolate the current pan velocity
+    Rect predicted = viewport.GetTargetVisibleRegion();
+    if (!viewport.IsAnimating()) {
+        predicted.x += panVelocity_.x * PREFETCH_LOOKAHEAD_MS;
+        predicted.y += panVelocity_.y * PREFETCH_LOOKAHEAD_MS;
     }
 
-    // 3. Submit async load request if thread pool is available and tile not already pending
-    if (threadPool_) {
-        bool alreadyPending = false;
-        {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            alreadyPending = pendingTiles_.find(key) != pendingTiles_.end();
-            if (!alreadyPending) {
-                pendingTiles_.insert(key);
+    // Ring of one tile around both the current and the predicted region.
+    // Background tiles are left out below, so the per-frame cap is spent
+    // on tissue alone.
+    double margin = std::max(pyramid_.GetTileWidth(level), pyramid_.GetTileHeight(level)) *
+                    pyramid_.GetLevelDownsample(level);
+    Rect visible = viewport.GetVisibleRegion();
+    Rect currentRing(visible.x - margin, visible.y - margin,
+                     visible.width + 2 * margin, visible.height + 2 * margin);
+    Rect predictedRing(predicted.x - margin, predicted.y - margin,
+                       predicted.width + 2 * margin, predicted.height + 2 * margin);
+
+    // Candidates in the order they should be loaded
+    std::vector<TileKey>& candidates = scratch_.prefetchCandidates;
+    candidates.clear();
+    EnumerateTilesInRegion(predictedRing, level, candidates);
+    EnumerateTilesInRegion(currentRing, level, candidates);
+
+    // Next pyramid level in the zoom direction. When steady, warm the coarser
+    // level: it is cheap and serves as fallback if panning outruns the ring.
+    int32_t levelCount = pyramid_.GetLevelCount();
+    int32_t nextLevel = zoomDirection_ > 0 ? level - 1 : level + 1;
+    if (nextLevel >= 0 && nextLevel < levelCount) {
+        EnumerateTilesInRegion(zoomDirection_ > 0 ? predicted : predictedRing, nextLevel, candidates);
+    }
+
+    // Visible tiles were already submitted at higher priority this pass
+    FlatTileMap<bool>& skip = scratch_.prefetchSkip;
+    skip.clear();
+    skip.reserve(visibleTiles.size() + candidates.size());
+    for (const auto& key : visibleTiles) {
+        skip.try_emplace(key, true);
+    }
+
+    // Already-queued candidates are always resubmitted so their generation
+    // stays current; only new submissions count against the per-frame cap
+    std::vector<TileLoadRequest>& requests = scratch_.prefetchRequests;
+    requests.clear();
+    for (const auto& key : candidates) {
+        if (!skip.try_emplace(key, true).second) {
+            continue;  // Visible or duplicate candidate
+        }
+        if (textureManager_->HasTexture(key) || IsBackgroundTile(key)) {
+            continue;
+        }
+        requests.emplace_back(key, TileLoadPriority::ADJACENT, generation_);
+    }
+    threadPool_->SubmitRequests(requests.data(), requests.size(), prefetchLimit_);
+
+    // While moving, stream the strip ahead into the page cache too
+    if (viewport.IsAnimating() || panVelocity_.x != 0.0 || panVelocity_.y != 0.0) {
+        PrewarmRegion(predictedRing, level, true);
+    }
+}
+
+void SlideRenderer::PrefetchPlannedViews(const Viewport& viewport) {
+    plannedViewsCovered_ = 0;
+    plannedTiles_ = 0;
+    if (!threadPool_ || prefetchLimit_ == 0 || plannedViews_.empty() || pyramid_.GetLevelCount() == 0) {
+        return;
+    }
+
+    // Nearest view first, each whole or not at all, within the budget.
+    // Tiles the last pass showed were requested by it.
+    const size_t budget = GetPlanBudget();
+    size_t plannedBytes = 0;
+    std::vector<TileKey>& candidates = scratch_.prefetchCandidates;
+    FlatTileMap<bool>& skip = scratch_.prefetchSkip;
+    skip.clear();
+    for (const TileKey& key : scratch_.visible) {
+        skip.try_emplace(key, true);
+    }
+    std::vector<TileLoadRequest>& requests = scratch_.prefetchRequests;
+    requests.clear();
+    for (const ViewportWaypoint& view : plannedViews_) {
+        if (view.zoom <= 0.0) {
+            continue;
+        }
+        const int32_t level = SelectLevel(view.zoom);
+        const double width = viewport.GetWindowWidth() / view.zoom;
+        const double height = viewport.GetWindowHeight() / view.zoom;
+        candidates.clear();
+        EnumerateTilesInRegion(Rect(view.center.x - width / 2, view.center.y - height / 2, width, height),
+                               level, candidates);
+        const size_t tileBytes = static_cast<size_t>(pyramid_.GetTileWidth(level)) *
+                                 pyramid_.GetTileHeight(level) * sizeof(uint32_t);
+        if (plannedBytes + candidates.size() * tileBytes > budget) {
+            break;
+        }
+        plannedBytes += candidates.size() * tileBytes;
+        ++plannedViewsCovered_;
+        for (const TileKey& key : candidates) {
+            if (!skip.try_emplace(key, true).second || IsBackgroundTile(key)) {
+                continue;
+            }
+            ++plannedTiles_;
+            if (!textureManager_->HasTexture(key)) {
+                requests.emplace_back(key, TileLoadPriority::ADJACENT, generation_);
             }
         }
+    }
+    // Queued ones are resubmitted, keeping their generation current
+    threadPool_->SubmitRequests(requests.data(), requests.size(), prefetchLimit_);
+}
+
+size_t SlideRenderer::GetPlanBudget() const {
+    return planBudget_ > 0 ? planBudget_ : GetCacheMaxMemory() / PLAN_CACHE_FRACTION;
+}
+
+void SlideRenderer::PrewarmViewport(const Viewport& viewport) {
+    if (pyramid_.GetLevelCount() == 0) {
+        return;
+    }
+    int32_t level = SelectLevel(viewport.GetZoom());
+    double margin = std::max(pyramid_.GetTileWidth(level), pyramid_.GetTileHeight(level)) *
+                    pyramid_.GetLevelDownsample(level);
+    Rect visible = viewport.GetVisibleRegion();
+    PrewarmRegion(Rect(visible.x - margin, visible.y - margin,
+                       visible.width + 2 * margin, visible.height + 2 * margin),
+                  level, false);
+}
 
-        if (!alreadyPending) {
-            TileLoadPriority priority = fallbackTile
-                ? TileLoadPriority::VISIBLE    // Has fallback showing
-                : TileLoadPriority::URGENT;    // No fallback, high priority
-            threadPool_->SubmitRequest(TileLoadRequest(key, priority));
+void SlideRenderer::PreloadViewport(const Viewport& viewport) {
+    if (!threadPool_ || pyramid_.GetLevelCount() == 0) {
+        return;
+    }
+    int32_t level = SelectLevel(viewport.GetZoom());
+    int32_t coarsest = pyramid_.GetLevelCount() - 1;
+    std::vector<TileLoadRequest> requests;
+    for (int32_t preloadLevel : {coarsest, level}) {
+        std::vector<TileKey> tiles;
+        EnumerateVisibleTiles(viewport, preloadLevel, tiles);
+        for (const TileKey& key : tiles) {
+            if (!IsBackgroundTile(key)) {
+                requests.emplace_back(key, TileLoadPriority::ADJACENT, generation_);
+            }
         }
+        if (preloadLevel == level) {
+            break;
+        }
+    }
+    threadPool_->SubmitRequests(requests.data(), requests.size());
+}
+
+void SlideRenderer::PrewarmRegion(const Rect& region, int32_t level, bool sequential) {
+    if (!loader_ || !loader_->IsDirectTiffReadActive() || pyramid_.IsSynthesized(level)) {
+        return;
     }
+    loader_->PrewarmRegion(pyramid_.GetLevel(level).sourceLevel,
+                           static_cast<int64_t>(region.x), static_cast<int64_t>(region.y),
+                           static_cast<int64_t>(region.width), static_cast<int64_t>(region.height),
+                           sequential);
 }
 
-const TileData* SlideRenderer::FindBestFallback(const TileKey& key, TileKey* outFallbackKey) {
-    // Search from next coarser level down to lowest resolution
-    int32_t levelCount = loader_->GetLevelCount();
-    double targetDownsample = loader_->GetLevelDownsample(key.level);
+RenderTexture* SlideRenderer::AcquireTexture(const TileKey& key, int32_t* outWidth, int32_t* outHeight,
+                                             SDL_Rect* outSource) {
+    RenderTexture* texture = textureManager_->GetTexture(key, outWidth, outHeight, outSource);
+    if (texture) {
+        return texture;
+    }
 
-    for (int32_t l = key.level + 1; l < levelCount; ++l) {
-        double fallbackDownsample = loader_->GetLevelDownsample(l);
-        double ratio = fallbackDownsample / targetDownsample;
+    // The handle pins the pixels while they are uploaded, even if a worker
+    // evicts the tile meanwhile
+    TileHandle tile = tileCache_->GetTile(key);
+    if (!tile) {
+        return nullptr;
+    }
 
-        // Calculate equivalent tile position at coarser level
-        int32_t fallbackTileX = static_cast<int32_t>(key.tileX / ratio);
-        int32_t fallbackTileY = static_cast<int32_t>(key.tileY / ratio);
+    texture = textureManager_->GetOrCreateTexture(key, tile->GetArgb(unpackBuffer_), tile->width, tile->height,
+                                                  outSource);
+    if (texture) {
+        *outWidth = tile->width;
+        *outHeight = tile->height;
+    }
+    return texture;
+}
 
-        TileKey fallbackKey{l, fallbackTileX, fallbackTileY};
+void SlideRenderer::RecordFirstDraw(const TileData& tile) {
+    if (!tile.firstDrawn.exchange(true, std::memory_order_relaxed)) {
+        pipelineStats_.RecordSince(TileStage::FirstDraw, tile.requestTime);
+    }
+}
 
-        const TileData* tile = tileCache_->GetTile(fallbackKey);
-        if (tile) {
-            *outFallbackKey = fallbackKey;
-            return tile;
+void SlideRenderer::RenderFallbacks(const std::vector<TileKey>& uncovered, const Viewport& viewport,
+                                    int32_t level) {
+    // The plan is in slide space, so panning and zooming within a level
+    // reuse it; only a change in what is uncovered or resident rebuilds it
+    uint64_t arrivals = tileArrivals_.load();
+    bool stale = !fallbackPlan_->valid || fallbackPlan_->level != level ||
+                 fallbackPlan_->arrivals != arrivals || fallbackPlan_->uncovered != uncovered;
+    if (stale) {
+        BuildFallbackPlan(uncovered, level);
+        fallbackPlan_->arrivals = arrivals;
+    }
+
+    // Resolve every texture before queuing anything: if one was evicted
+    // since the plan was built, rebuild rather than draw half a plan
+    std::vector<FallbackDraw>& draws = scratch_.fallbackDraws;
+    if (!ResolveFallbackPlan(&draws)) {
+        BuildFallbackPlan(uncovered, level);
+        fallbackPlan_->arrivals = arrivals;
+        if (!ResolveFallbackPlan(&draws)) {
+            return;
         }
     }
 
-    return nullptr;  // No fallback available
+    bool linear = textureManager_->GetScaleMode() == SDL_ScaleModeLinear;
+    for (size_t i = 0; i < draws.size(); ++i) {
+        const FallbackQuad& quad = fallbackPlan_->quads[i];
+        const FallbackDraw& draw = draws[i];
+        double downsample = pyramid_.GetLevelDownsample(quad.coarseKey.level);
+        double originX = quad.coarseKey.tileX * pyramid_.GetTileWidth(quad.coarseKey.level) * downsample;
+        double originY = quad.coarseKey.tileY * pyramid_.GetTileHeight(quad.coarseKey.level) * downsample;
+
+        // Source rect within the coarse tile (in its pixel coords)
+        double srcX0 = (quad.slideX0 - originX) / downsample;
+        double srcY0 = (quad.slideY0 - originY) / downsample;
+        double srcX1 = (quad.slideX1 - originX) / downsample;
+        double srcY1 = (quad.slideY1 - originY) / downsample;
+
+        // Keep linear sampling from reaching into neighbouring atlas slots
+        if (linear) {
+            double maxX = std::max(0.5, draw.width - 0.5);
+            double maxY = std::max(0.5, draw.height - 0.5);
+            srcX0 = std::max(0.5, std::min(srcX0, maxX));
+            srcY0 = std::max(0.5, std::min(srcY0, maxY));
+            srcX1 = std::max(srcX0, std::min(srcX1, maxX));
+            srcY1 = std::max(srcY0, std::min(srcY1, maxY));
+        }
+
+        // Offset into the fallback's atlas slot
+        SDL_FRect srcRect = {
+            static_cast<float>(draw.source.x + srcX0),
+            static_cast<float>(draw.source.y + srcY0),
+            static_cast<float>(srcX1 - srcX0),
+            static_cast<float>(srcY1 - srcY0)
+        };
+
+        // Use floor() for start and ceil() for end to eliminate gaps between
+        // tiles, except where overlaps would add up (see SetChannelStyle)
+        Vec2 topLeft = viewport.SlideToScreen(Vec2(quad.slideX0, quad.slideY0));
+        Vec2 bottomRight = viewport.SlideToScreen(Vec2(quad.slideX1, quad.slideY1));
+        float x0 = static_cast<float>(topLeft.x);
+        float y0 = static_cast<float>(topLeft.y);
+        float x1 = static_cast<float>(bottomRight.x);
+        float y1 = static_cast<float>(bottomRight.y);
+        if (!IsChannelStyled()) {
+            x0 = std::floor(x0);
+            y0 = std::floor(y0);
+            x1 = std::ceil(x1);
+            y1 = std::ceil(y1);
+        }
+
+        QueueQuad(draw.texture, srcRect, SDL_FRect{x0, y0, x1 - x0, y1 - y0});
+    }
 }
 
-void SlideRenderer::RenderFallbackTile(const TileKey& targetKey, const TileKey& fallbackKey,
-                                        const TileData* fallbackTile, const Viewport& viewport,
-                                        int32_t targetLevel) {
-    // We have a coarser tile and need to render a portion of it scaled up
-    // to cover where the target high-res tile would be
+bool SlideRenderer::ResolveFallbackPlan(std::vector<FallbackDraw>* outDraws) {
+    outDraws->clear();
+    outDraws->reserve(fallbackPlan_->quads.size());
+    for (const auto& quad : fallbackPlan_->quads) {
+        FallbackDraw draw{};
+        draw.texture = textureManager_->GetTexture(quad.coarseKey, &draw.width, &draw.height, &draw.source);
+        if (!draw.texture) {
+            return false;
+        }
+        outDraws->push_back(draw);
+    }
+    return true;
+}
 
-    double targetDownsample = loader_->GetLevelDownsample(targetLevel);
-    double fallbackDownsample = loader_->GetLevelDownsample(fallbackKey.level);
+void SlideRenderer::BuildFallbackPlan(const std::vector<TileKey>& uncovered, int32_t level) {
+    fallbackPlan_->valid = true;
+    fallbackPlan_->level = level;
+    fallbackPlan_->uncovered = uncovered;
+    fallbackPlan_->covered.clear();
+    fallbackPlan_->quads.clear();
+    fallbackPlanBuilds_++;
+
+    // Assign each uncovered tile to the finest coarser level whose tiles
+    // over it are all resident (levels' grids need not nest, so there may
+    // be several), probing every candidate coarse tile only once
+    struct Candidate {
+        bool resident;
+        int32_t width;
+        int32_t height;
+    };
+    FlatTileMap<Candidate> probed;
+    std::map<TileKey, std::set<std::pair<int32_t, int32_t>>> byCoarse;  // Fine tiles as (y, x)
 
-    // Calculate the target tile's position in slide coordinates (level 0)
-    double targetX0 = targetKey.tileX * TILE_SIZE * targetDownsample;
-    double targetY0 = targetKey.tileY * TILE_SIZE * targetDownsample;
-    double targetX1 = targetX0 + TILE_SIZE * targetDownsample;
-    double targetY1 = targetY0 + TILE_SIZE * targetDownsample;
+    // Never draw past the slide's edge
+    LevelDimensions slideDims = pyramid_.GetLevelDimensions(0);
+    int32_t levelCount = pyramid_.GetLevelCount();
+    double targetDownsample = pyramid_.GetLevelDownsample(level);
+    double tileExtentX = pyramid_.GetTileWidth(level) * targetDownsample;
+    double tileExtentY = pyramid_.GetTileHeight(level) * targetDownsample;
 
-    // Calculate the fallback tile's position in slide coordinates (level 0)
-    double fallbackX0 = fallbackKey.tileX * TILE_SIZE * fallbackDownsample;
-    double fallbackY0 = fallbackKey.tileY * TILE_SIZE * fallbackDownsample;
+    std::vector<TileKey> coarseKeys;
+    for (const auto& key : uncovered) {
+        double fineX0 = key.tileX * tileExtentX;
+        double fineY0 = key.tileY * tileExtentY;
+        double fineX1 = std::min((key.tileX + 1) * tileExtentX, static_cast<double>(slideDims.width));
+        double fineY1 = std::min((key.tileY + 1) * tileExtentY, static_cast<double>(slideDims.height));
 
-    // Calculate source rect within the fallback tile (in fallback tile pixel coords)
-    double srcX0 = (targetX0 - fallbackX0) / fallbackDownsample;
-    double srcY0 = (targetY0 - fallbackY0) / fallbackDownsample;
-    double srcX1 = (targetX1 - fallbackX0) / fallbackDownsample;
-    double srcY1 = (targetY1 - fallbackY0) / fallbackDownsample;
+        for (int32_t l = level + 1; l < levelCount; ++l) {
+            double coarseExtentX = pyramid_.GetTileWidth(l) * pyramid_.GetLevelDownsample(l);
+            double coarseExtentY = pyramid_.GetTileHeight(l) * pyramid_.GetLevelDownsample(l);
 
-    // Clamp source rect to fallback tile bounds
-    srcX0 = std::max(0.0, std::min(srcX0, static_cast<double>(fallbackTile->width)));
-    srcY0 = std::max(0.0, std::min(srcY0, static_cast<double>(fallbackTile->height)));
-    srcX1 = std::max(0.0, std::min(srcX1, static_cast<double>(fallbackTile->width)));
-    srcY1 = std::max(0.0, std::min(srcY1, static_cast<double>(fallbackTile->height)));
+            // Calculate the coarser level's tiles over this one
+            int32_t cx0 = static_cast<int32_t>(fineX0 / coarseExtentX);
+            int32_t cy0 = static_cast<int32_t>(fineY0 / coarseExtentY);
+            int32_t cx1 = std::max(cx0, static_cast<int32_t>(std::ceil(fineX1 / coarseExtentX)) - 1);
+            int32_t cy1 = std::max(cy0, static_cast<int32_t>(std::ceil(fineY1 / coarseExtentY)) - 1);
 
-    if (srcX1 <= srcX0 || srcY1 <= srcY0) {
-        return;  // No valid source region
+            coarseKeys.clear();
+            bool allResident = true;
+            for (int32_t cy = cy0; cy <= cy1 && allResident; ++cy) {
+                for (int32_t cx = cx0; cx <= cx1 && allResident; ++cx) {
+                    TileKey coarseKey{l, cx, cy, slideId_};
+                    auto it = probed.find(coarseKey);
+                    if (it == probed.end()) {
+                        Candidate candidate{false, 0, 0};
+                        SDL_Rect source;
+                        candidate.resident =
+                            AcquireTexture(coarseKey, &candidate.width, &candidate.height, &source) != nullptr;
+                        it = probed.emplace(coarseKey, candidate).first;
+                    }
+                    allResident = it->second.resident;
+                    coarseKeys.push_back(coarseKey);
+                }
+            }
+            if (allResident) {
+                for (const auto& coarseKey : coarseKeys) {
+                    byCoarse[coarseKey].insert({key.tileY, key.tileX});
+                }
+                fallbackPlan_->covered.push_back(key);
+                break;
+            }
+        }
     }
+    std::sort(fallbackPlan_->covered.begin(), fallbackPlan_->covered.end());
 
-    SDL_Rect srcRect = {
-        static_cast<int>(srcX0),
-        static_cast<int>(srcY0),
-        static_cast<int>(srcX1 - srcX0),
-        static_cast<int>(srcY1 - srcY0)
-    };
+    std::vector<TileRange> ranges;
+    for (auto& entry : byCoarse) {
+        const TileKey& coarseKey = entry.first;
+        std::set<std::pair<int32_t, int32_t>>& fine = entry.second;
+        const Candidate& candidate = probed[coarseKey];
 
-    // Get or create texture for the fallback tile
-    SDL_Texture* texture = textureManager_->GetOrCreateTexture(
-        fallbackKey,
-        fallbackTile->pixels,
-        fallbackTile->width,
-        fallbackTile->height
-    );
+        double coarseDownsample = pyramid_.GetLevelDownsample(coarseKey.level);
+        double coarseX0 = coarseKey.tileX * pyramid_.GetTileWidth(coarseKey.level) * coarseDownsample;
+        double coarseY0 = coarseKey.tileY * pyramid_.GetTileHeight(coarseKey.level) * coarseDownsample;
+        double coarseX1 = std::min(coarseX0 + candidate.width * coarseDownsample, static_cast<double>(slideDims.width));
+        double coarseY1 = std::min(coarseY0 + candidate.height * coarseDownsample, static_cast<double>(slideDims.height));
 
-    if (!texture) {
-        return;
+        ranges.clear();
+        MergeTileRanges(fine, &ranges);
+        for (const TileRange& range : ranges) {
+            FallbackQuad quad{coarseKey,
+                              std::max(range.x0 * tileExtentX, coarseX0),
+                              std::max(range.y0 * tileExtentY, coarseY0),
+                              std::min((range.x1 + 1) * tileExtentX, coarseX1),
+                              std::min((range.y1 + 1) * tileExtentY, coarseY1)};
+            if (quad.slideX1 > quad.slideX0 && quad.slideY1 > quad.slideY0) {
+                fallbackPlan_->quads.push_back(quad);
+            }
+        }
     }
+}
 
-    // Calculate destination rect in screen coordinates
-    Vec2 topLeft = viewport.SlideToScreen(Vec2(targetX0, targetY0));
-    Vec2 bottomRight = viewport.SlideToScreen(Vec2(targetX1, targetY1));
+void SlideRenderer::MergeTileRanges(std::set<std::pair<int32_t, int32_t>>& tiles, std::vector<TileRange>* out) {
+    while (!tiles.empty()) {
+        int32_t y0 = tiles.begin()->first;
+        int32_t x0 = tiles.begin()->second;
+        int32_t x1 = x0;
+        while (tiles.count({y0, x1 + 1})) {
+            x1++;
+        }
+        int32_t y1 = y0;
+        for (bool fullRow = true; fullRow; ) {
+            for (int32_t x = x0; x <= x1 && fullRow; ++x) {
+                fullRow = tiles.count({y1 + 1, x}) > 0;
+            }
+            if (fullRow) {
+                y1++;
+            }
+        }
+        for (int32_t y = y0; y <= y1; ++y) {
+            for (int32_t x = x0; x <= x1; ++x) {
+                tiles.erase({y, x});
+            }
+        }
+        out->push_back({x0, y0, x1, y1});
+    }
+}
 
-    // Use floor() for start and ceil() for end to eliminate gaps between tiles
-    int x0 = static_cast<int>(std::floor(topLeft.x));
-    int y0 = static_cast<int>(std::floor(topLeft.y));
-    int x1 = static_cast<int>(std::ceil(bottomRight.x));
-    int y1 = static_cast<int>(std::ceil(bottomRight.y));
+bool SlideRenderer::IsBackgroundTile(const TileKey& key) const {
+    if (!tissueMask_.IsValid()) {
+        return false;
+    }
+    // Edge tiles stop at the level's edge
+    double downsample = pyramid_.GetLevelDownsample(key.level);
+    auto levelDims = pyramid_.GetLevelDimensions(key.level);
+    int64_t x0 = static_cast<int64_t>(key.tileX) * pyramid_.GetTileWidth(key.level);
+    int64_t y0 = static_cast<int64_t>(key.tileY) * pyramid_.GetTileHeight(key.level);
+    int64_t x1 = std::min(levelDims.width, x0 + pyramid_.GetTileWidth(key.level));
+    int64_t y1 = std::min(levelDims.height, y0 + pyramid_.GetTileHeight(key.level));
+    return tissueMask_.IsBackground(Rect(x0 * downsample, y0 * downsample,
+                                         (x1 - x0) * downsample, (y1 - y0) * downsample));
+}
 
-    SDL_Rect dstRect = {x0, y0, x1 - x0, y1 - y0};
+void SlideRenderer::RenderBackgroundTiles(const std::vector<TileKey>& tiles, const Viewport& viewport,
+                                          int32_t level) {
+    lastBackgroundTiles_ += tiles.size();
+    if (tiles.empty()) {
+        return;
+    }
 
-    // Render the fallback tile portion scaled up
-    SDL_RenderCopy(renderer_, texture, &srcRect, &dstRect);
+    auto levelDims = pyramid_.GetLevelDimensions(level);
+    std::vector<SDL_Rect>& rects = scratch_.backgroundRects;
+    rects.clear();
+    for (const auto& key : tiles) {
+        int64_t x0 = static_cast<int64_t>(key.tileX) * pyramid_.GetTileWidth(level);
+        int64_t y0 = static_cast<int64_t>(key.tileY) * pyramid_.GetTileHeight(level);
+        int32_t width = static_cast<int32_t>(std::min<int64_t>(pyramid_.GetTileWidth(level), levelDims.width - x0));
+        int32_t height = static_cast<int32_t>(std::min<int64_t>(pyramid_.GetTileHeight(level), levelDims.height - y0));
+        rects.push_back(TileScreenRect(key, width, height, viewport, level));
+    }
+
+    uint32_t color = tissueMask_.GetBackgroundColor();
+    backend_->FillRects(rects.data(), static_cast<int>(rects.size()),
+                        SDL_Color{static_cast<Uint8>((color >> 16) & 0xFF), static_cast<Uint8>((color >> 8) & 0xFF),
+                                  static_cast<Uint8>(color & 0xFF), 0xFF});
 }
 
-void SlideRenderer::RenderTileToScreen(const TileKey& key, const TileData* tileData,
-                                        const Viewport& viewport, int32_t level) {
-    // Create or get SDL texture
-    SDL_Texture* texture = textureManager_->GetOrCreateTexture(
-        key,
-        tileData->pixels,
-        tileData->width,
-        tileData->height
-    );
-
-    if (!texture) {
+void SlideRenderer::RenderSolidTiles(std::vector<SolidTile>& tiles, const Viewport& viewport, int32_t level) {
+    lastSolidTiles_ += tiles.size();
+    if (tiles.empty()) {
         return;
     }
 
+    // Mostly one glass color, so this is usually a single fill
+    std::sort(tiles.begin(), tiles.end(),
+              [](const SolidTile& a, const SolidTile& b) { return a.color < b.color; });
+    std::vector<SDL_Rect>& rects = scratch_.backgroundRects;
+    for (size_t start = 0; start < tiles.size();) {
+        const uint32_t color = tiles[start].color;
+        rects.clear();
+        size_t end = start;
+        for (; end < tiles.size() && tiles[end].color == color; ++end) {
+            rects.push_back(TileScreenRect(tiles[end].key, tiles[end].width, tiles[end].height, viewport, level));
+        }
+        // Fully transparent tiles (outside the slide) draw nothing
+        if ((color >> 24) != 0) {
+            backend_->FillRects(rects.data(), static_cast<int>(rects.size()),
+                                SDL_Color{static_cast<Uint8>((color >> 16) & 0xFF),
+                                          static_cast<Uint8>((color >> 8) & 0xFF),
+                                          static_cast<Uint8>(color & 0xFF), 0xFF});
+        }
+        start = end;
+    }
+}
+
+SDL_Rect SlideRenderer::TileScreenRect(const TileKey& key, int32_t width, int32_t height,
+                                      const Viewport& viewport, int32_t level) const {
     // Calculate tile position in slide coordinates (level 0)
-    double downsample = loader_->GetLevelDownsample(level);
-    double tileX0 = key.tileX * TILE_SIZE * downsample;
-    double tileY0 = key.tileY * TILE_SIZE * downsample;
-    double tileX1 = tileX0 + tileData->width * downsample;
-    double tileY1 = tileY0 + tileData->height * downsample;
+    double downsample = pyramid_.GetLevelDownsample(level);
+    double tileX0 = key.tileX * pyramid_.GetTileWidth(level) * downsample;
+    double tileY0 = key.tileY * pyramid_.GetTileHeight(level) * downsample;
+    double tileX1 = tileX0 + width * downsample;
+    double tileY1 = tileY0 + height * downsample;
 
     // Convert to screen coordinates
     Vec2 topLeft = viewport.SlideToScreen(Vec2(tileX0, tileY0));
@@ -316,8 +1282,59 @@ void SlideRenderer::RenderTileToScreen(const TileKey& key, const TileData* tileD
     int x1 = static_cast<int>(std::ceil(bottomRight.x));
     int y1 = static_cast<int>(std::ceil(bottomRight.y));
 
-    SDL_Rect dstRect = {x0, y0, x1 - x0, y1 - y0};
+    return SDL_Rect{x0, y0, x1 - x0, y1 - y0};
+}
+
+SDL_FRect SlideRenderer::TileDrawRect(const TileKey& key, int32_t width, int32_t height,
+                                     const Viewport& viewport, int32_t level) const {
+    if (!IsChannelStyled()) {
+        SDL_Rect rect = TileScreenRect(key, width, height, viewport, level);
+        return SDL_FRect{static_cast<float>(rect.x), static_cast<float>(rect.y),
+                         static_cast<float>(rect.w), static_cast<float>(rect.h)};
+    }
+
+    double downsample = pyramid_.GetLevelDownsample(level);
+    double tileX0 = key.tileX * pyramid_.GetTileWidth(level) * downsample;
+    double tileY0 = key.tileY * pyramid_.GetTileHeight(level) * downsample;
+    Vec2 topLeft = viewport.SlideToScreen(Vec2(tileX0, tileY0));
+    Vec2 bottomRight = viewport.SlideToScreen(Vec2(tileX0 + width * downsample, tileY0 + height * downsample));
+    return SDL_FRect{static_cast<float>(topLeft.x), static_cast<float>(topLeft.y),
+                     static_cast<float>(bottomRight.x - topLeft.x), static_cast<float>(bottomRight.y - topLeft.y)};
+}
+
+void SlideRenderer::SetChannelStyle(uint32_t color, float gain) {
+    gain = std::max(0.0f, std::min(gain, MAX_CHANNEL_GAIN));
+    channelPasses_ = std::max(1, static_cast<int32_t>(std::ceil(gain)));
+    float scale = gain / channelPasses_;
+    channelTint_ = {static_cast<Uint8>(std::lround(((color >> 16) & 0xFF) * scale)),
+                    static_cast<Uint8>(std::lround(((color >> 8) & 0xFF) * scale)),
+                    static_cast<Uint8>(std::lround((color & 0xFF) * scale)),
+                    255};
+    batch_.SetBlendMode(SDL_BLENDMODE_ADD);
+}
+
+void SlideRenderer::QueueQuad(RenderTexture* texture, const SDL_FRect& source, const SDL_FRect& dest) {
+    if (!IsChannelStyled()) {
+        batch_.AddQuad(texture, source, dest);
+        return;
+    }
+    for (int32_t pass = 0; pass < channelPasses_; ++pass) {
+        batch_.AddQuad(texture, source, dest, channelTint_);
+    }
+}
+
+void SlideRenderer::RenderTileToScreen(const TileKey& key, RenderTexture* texture, const SDL_Rect& source,
+                                        int32_t width, int32_t height,
+                                        const Viewport& viewport, int32_t level) {
+    SDL_FRect srcRect = {static_cast<float>(source.x), static_cast<float>(source.y),
+                         static_cast<float>(source.w), static_cast<float>(source.h)};
+
+    // Keep linear sampling from reaching into neighbouring atlas slots
+    if (textureManager_->GetScaleMode() == SDL_ScaleModeLinear && source.w > 1 && source.h > 1) {
+        srcRect = {srcRect.x + 0.5f, srcRect.y + 0.5f, srcRect.w - 1.0f, srcRect.h - 1.0f};
+    }
+    SDL_FRect dstRect = TileDrawRect(key, width, height, viewport, level);
 
     // Render tile
-    SDL_RenderCopy(renderer_, texture, nullptr, &dstRect);
+    QueueQuad(texture, srcRect, dstRect);
 }
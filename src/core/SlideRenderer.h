@@ -4,64 +4,562 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <atomic>
+#include <algorithm>
 #include <set>
-#include <mutex>
+#include <utility>
+#include "Animation.h"  // For Vec2
+#include "TileBufferPool.h"
+#include "TileBatch.h"
+#include "PyramidLayout.h"
+#include "LatencyHistogram.h"
+#include "TextureManager.h"  // For TileKey
+#include "TileLoadRequest.h"  // For TileLoadPriority
+#include "TileScheduler.h"
+#include "TissueMask.h"
+#include "ViewportPlan.h"  // For ViewportWaypoint
 
 class SlideLoader;
 class Viewport;
-class TextureManager;
 class TileCache;
+class CompressedTileCache;
 class TileLoadThreadPool;
-struct TileKey;
+class DiskTileCache;
+class FrameProfiler;
 struct TileData;
+struct Rect;
+
+// How SelectLevel() maps a zoom onto the pyramid
+enum class LevelSelection {
+    Closest,         // Downsample nearest to 1/zoom (may decode up to 4x the screen's pixels)
+    CoarserOrEqual   // Finest level not sharper than the screen, magnified with linear filtering
+};
+
+// One of several views of the slide drawn in a frame: a viewport whose
+// window size is that of its pane, drawn at screenRect (empty: the whole
+// render target)
+struct RenderView {
+    const Viewport* viewport = nullptr;
+    SDL_Rect screenRect = {0, 0, 0, 0};
+};
 
 class SlideRenderer {
 public:
-    SlideRenderer(SlideLoader* loader, SDL_Renderer* renderer, TextureManager* textureManager);
+    // workerThreads = 0 sizes the decode pool from the hardware; with
+    // autoScaleWorkers the pool grows and shrinks with the load backlog.
+    // diskCache (optional, not owned) must outlive the renderer. Tiles are
+    // drawn through textureManager's RenderBackend.
+    SlideRenderer(SlideLoader* loader, TextureManager* textureManager,
+                  size_t workerThreads = 0, bool autoScaleWorkers = false,
+                  DiskTileCache* diskCache = nullptr);
     ~SlideRenderer();
 
+    // Invoked from a worker thread whenever a tile lands in the cache, so an
+    // idle render loop can wake up. Must be set before Initialize().
+    void SetTileReadyCallback(std::function<void()> callback) { tileReadyCallback_ = std::move(callback); }
+
+    // Optional render-thread profiler; Render() splits its frame time into
+    // zones (resident draws, uploads, fallbacks, requests, flush, prefetch)
+    void SetProfiler(FrameProfiler* profiler) { profiler_ = profiler; }
+
+    // Share a decode pool and tile cache with the other open slides instead
+    // of owning them, so every slide draws on one worker pool and one
+    // memory budget. slideId tags this slide's tiles (TileKey::slide) and
+    // must be unique among them. The pool must be initialized and both must
+    // outlive the renderer. Must be called before Initialize().
+    void SetSharedPipeline(TileLoadThreadPool* pool, TileCache* cache, uint32_t slideId);
+    uint32_t GetSlideId() const { return slideId_; }
+
     // Lifecycle management for async loading
     void Initialize();
     void Shutdown();
 
+    // Leave the shared decode pool without waiting for this slide's
+    // in-flight decodes, which are abandoned and discarded (see
+    // TileLoadThreadPool::RemoveSlide). The renderer, its loader and disk
+    // cache stay in use until IsDetached(); destroying them earlier waits
+    // for the decodes as Shutdown() does.
+    void Detach();
+    bool IsDetached() const;
+
     void Render(const Viewport& viewport);
 
+    // Several views in one frame (side-by-side magnifications, say). They
+    // share the frame's upload budget and one round of load requests: a
+    // tile wanted by two views is requested once, at the higher of their
+    // priorities, and decoded once. Prefetch follows the first view only.
+    void Render(const std::vector<RenderView>& views);
+
+    // Collapse requests for the same tile into one at the highest priority
+    // asked for (the order of the result is unspecified)
+    static void MergeRequests(std::vector<TileLoadRequest>& requests);
+
+    // Tiles x0..x1, y0..y1 of one level, inclusive
+    struct TileRange {
+        int32_t x0, y0, x1, y1;
+    };
+
+    // Greedily merge tiles, given as (y, x), into rectangles: extend a run
+    // to the right, then downwards while the whole run is in the set.
+    // Empties tiles; the ranges cover it exactly, without overlap.
+    static void MergeTileRanges(std::set<std::pair<int32_t, int32_t>>& tiles, std::vector<TileRange>* out);
+
+    // Switching also sets the texture sampling the strategy relies on
+    void SetLevelSelection(LevelSelection mode);
+    LevelSelection GetLevelSelection() const { return levelSelection_; }
+
+    // Level for zoom given each level's downsample (ascending)
+    static int32_t SelectLevel(const std::vector<double>& downsamples, double zoom, LevelSelection mode);
+
+    // The same with hysteresis: an adjacent current level (-1: none) is
+    // kept until the zoom is LEVEL_HYSTERESIS past the boundary, so a
+    // trackpad wobbling across it doesn't swap levels and request both
+    static int32_t SelectLevel(const std::vector<double>& downsamples, double zoom, LevelSelection mode,
+                               int32_t current);
+
+    static constexpr double LEVEL_HYSTERESIS = 0.15;
+
+    // An adjacent level whose visible tiles are all resident is drawn
+    // instead of decoding the chosen one's: a finer one always (Closest
+    // only), a coarser one if its downsample is within this factor of the
+    // screen's
+    static constexpr double MAX_RESIDENT_BLUR = 1.5;
+
+    // Motion-adaptive resolution: while the first view pans faster than
+    // MOTION_SPEED screen pixels a millisecond it is drawn up to levels
+    // coarser (see MotionBias), so a drag decodes a fraction of the tiles
+    // that would scroll away unfinished. Once it has been still for
+    // MOTION_SETTLE_MS the next pass refines to its own level, the coarse
+    // tiles standing in meanwhile. 0 (the default) disables it.
+    void SetMotionLevels(int32_t levels) { motionLevels_ = std::clamp(levels, 0, 2); }
+    int32_t GetMotionLevels() const { return motionLevels_; }
+
+    // Whether the last Render() drew the first view coarsened for motion
+    // (motion levels or a lower moving render scale): frames must keep
+    // coming until it settles and refines
+    bool IsMotionCoarsened() const { return motionCoarsened_; }
+
+    // New prefetch (ADJACENT) tiles submitted per frame, at most
+    // MAX_PREFETCH_TILES_PER_FRAME (the default); lowered on battery
+    // power, 0 stops prefetching. Visible tiles are never limited.
+    void SetPrefetchLimit(size_t tilesPerFrame) {
+        prefetchLimit_ = std::min(tilesPerFrame, MAX_PREFETCH_TILES_PER_FRAME);
+    }
+    size_t GetPrefetchLimit() const { return prefetchLimit_; }
+
+    // Views an agent announced it will visit next (viewport.plan), in
+    // order, sized like viewport. PrefetchPlannedViews queues their tiles
+    // at ADJACENT priority, at the level each would be drawn at, nearest
+    // view first until the planned tiles, cached or not, add up to the
+    // plan budget: tiles for far waypoints never push out the ones for
+    // near waypoints. Call it every loop, drawn frame or not: arriving
+    // tiles wake the loop, so the queue refills while the view is still.
+    void SetPlannedViews(std::vector<ViewportWaypoint> views) { plannedViews_ = std::move(views); }
+    void PrefetchPlannedViews(const Viewport& viewport);
+    // Bytes of decoded tiles the plan may take; 0 (the default) is
+    // 1/PLAN_CACHE_FRACTION of the tile cache limit
+    void SetPlanBudget(size_t bytes) { planBudget_ = bytes; }
+    size_t GetPlanBudget() const;
+    // Planned views and their tissue tiles the last PrefetchPlannedViews
+    // covered within the budget
+    size_t GetPlannedViewCount() const { return plannedViewsCovered_; }
+    size_t GetPlannedTileCount() const { return plannedTiles_; }
+
+    static constexpr size_t PLAN_CACHE_FRACTION = 4;
+
+    // Levels are chosen for drawable pixels, not logical ones: a view's
+    // zoom is multiplied by the display scale (drawable over window size,
+    // 2 on Retina) and by the render scale, the still one or, while the
+    // first view animates or pans past MOTION_SPEED until it settles, the
+    // moving one. Below 1 picks coarser levels, trading sharpness for
+    // decode work: 0.5 decodes about a quarter of the pixels.
+    void SetDisplayScale(double scale);
+    void SetRenderScale(double still, double moving);
+    double GetDisplayScale() const { return displayScale_; }
+    double GetRenderScale() const { return renderScale_; }
+    double GetMovingRenderScale() const { return movingRenderScale_; }
+
+    static constexpr double MIN_RENDER_SCALE = 0.125;
+    static constexpr double MAX_RENDER_SCALE = 4.0;
+
+    // Levels to coarsen by at a screen speed (pixels per millisecond): one
+    // from MOTION_SPEED, two from twice that, at most maxLevels
+    static int32_t MotionBias(double screenSpeed, int32_t maxLevels);
+
+    static constexpr double MOTION_SPEED = 1.5;
+    static constexpr uint32_t MOTION_SETTLE_MS = 150;
+
     // Get cache statistics
     size_t GetCacheTileCount() const;
     size_t GetCacheMemoryUsage() const;
     double GetCacheHitRate() const;
+    TileBufferPool::Stats GetBufferPoolStats() const;
+
+    // Tile cache limit, resizable at any time. A lower limit is reached
+    // over the following frames (see TileCache::EvictLRU).
+    void SetCacheMaxMemory(size_t maxBytes);
+    size_t GetCacheMaxMemory() const;
+
+    // Memory pressure: lower the cache limit to bytes below its usage (not
+    // under MIN_CACHE_BYTES, nor ever above the current limit, which may
+    // already be lower), or free the idle pixel buffers. Both return the
+    // bytes given back to the system so far.
+    size_t ShrinkCache(size_t bytes);
+    size_t TrimBufferPool();
+
+    static constexpr size_t MIN_CACHE_BYTES = 128ull * 1024 * 1024;
+
+    // Workers kept taking requests when auto-scaling has shrunk the pool
+    static constexpr size_t AUTO_SCALE_MIN_WORKERS = 2;
+
+    // Compressed in-RAM tier behind the tile cache; 0 disables it
+    void SetCompressedCacheMaxMemory(size_t maxBytes);
+    const CompressedTileCache* GetCompressedTier() const;
+    size_t TrimCompressedCache(size_t bytes);
+
+    const PyramidLayout& GetPyramid() const { return pyramid_; }
+
+    // Tiles over background only (see TissueMask) are drawn in the glass
+    // color and never requested, prefetched or cached; an invalid mask
+    // (the default) treats every tile as tissue
+    void SetTissueMask(TissueMask mask) { tissueMask_ = std::move(mask); }
+    const TissueMask& GetTissueMask() const { return tissueMask_; }
+
+    // Draw as one channel of a composite (see ChannelCompositor): tiles are
+    // added onto the frame, tinted color (0xRRGGBB) and scaled by gain (up
+    // to MAX_CHANNEL_GAIN). Quads keep their exact screen edges instead of
+    // overlapping by a pixel, which would add twice along tile seams.
+    void SetChannelStyle(uint32_t color, float gain);
+    bool IsChannelStyled() const { return channelPasses_ > 0; }
+
+    static constexpr float MAX_CHANNEL_GAIN = 8.0f;
+
+    // Visible tiles drawn flat by the last Render(): predicted glass, and
+    // tiles decoded to a single color
+    size_t GetBackgroundTileCount() const { return lastBackgroundTiles_; }
+    size_t GetSolidTileCount() const { return lastSolidTiles_; }
+
+    // Tiles of the last Render()'s last view, at the level it was drawn at
+    const std::vector<TileKey>& GetVisibleTiles() const { return scratch_.visible; }
+
+    // Pipeline access for consumers other than the viewport (the HTTP tile
+    // server): a tile's cached pixels, or queue a missing tile in the
+    // current render generation (resubmit it until it arrives, as Render()
+    // does). Thread-safe; TileKey::level indexes GetPyramid(), and
+    // TileKey::slide is set to this slide's.
+    std::shared_ptr<const TileData> GetCachedTile(const TileKey& key) const;
+    void RequestTile(const TileKey& key, TileLoadPriority priority);
+
+    // Have the OS page in the slide bytes for the viewport and a tile ring
+    // around it (direct TIFF reads only, see SlideLoader::PrewarmRegion)
+    void PrewarmViewport(const Viewport& viewport);
+
+    // Queue the tiles a first Render() of the viewport would need, and the
+    // coarsest level under them, at ADJACENT priority: a slide opened in the
+    // background has its first frame decoded before it is shown
+    void PreloadViewport(const Viewport& viewport);
 
     // Get thread pool statistics
     size_t GetPendingTileCount() const;
+    size_t GetDroppedTileCount() const;
+    size_t GetWorkerThreadCount() const;
+    size_t GetActiveWorkerLimit() const;
+    double GetAverageDecodeMs() const;
+    size_t GetCoalescedReadCount() const;
+    size_t GetCoalescedTileCount() const;
+
+    // Per-stage latency histograms across the tile lifecycle (submit,
+    // queue wait, disk read, decode, cache insert, upload, first draw)
+    TilePipelineStats& GetPipelineStats() { return pipelineStats_; }
+    const TilePipelineStats& GetPipelineStats() const { return pipelineStats_; }
+
+    // Ranks each frame's missing visible tiles (weights, "time to sharp"
+    // deadline, the last frame's decisions)
+    TileScheduler& GetScheduler() { return scheduler_; }
+    const TileScheduler& GetScheduler() const { return scheduler_; }
+
+    // Bytes OpenSlide decoded between the last two Render() calls, and in total
+    uint64_t GetDecodedBytesLastFrame() const { return decodedBytesLastFrame_; }
+    uint64_t GetDecodedBytesTotal() const { return lastDecodedBytes_; }
+
+    // Tiles whose pixels were ready but whose upload was pushed to a later
+    // frame by the texture upload budget, or is still in flight on a
+    // backend with asynchronous uploads (fallback drawn meanwhile)
+    size_t GetDeferredUploadCount() const { return deferredUploads_; }
+    bool HasDeferredUploads() const { return deferredUploads_ > 0; }
+
+    // Slide draw calls and tile quads issued by the last Render()
+    size_t GetDrawCallCount() const { return lastDrawCalls_; }
+    size_t GetDrawnQuadCount() const { return lastDrawnQuads_; }
+
+    // Tiles the last Render() submitted to the decode pool: visible ones
+    // missing at their level, resubmitted each frame until they arrive
+    size_t GetRequestedTileCount() const { return lastRequestedTiles_; }
+
+    // Coarser-level quads standing in for missing tiles in the last
+    // Render(), and how often that plan has been rebuilt
+    size_t GetFallbackQuadCount() const;
+    size_t GetFallbackPlanBuildCount() const { return fallbackPlanBuilds_; }
+
+    // Visible tiles the last Render() could not draw at their own level
+    // (missing, or waiting for upload budget); zero means the picture is
+    // final until the view changes
+    size_t GetUncoveredTileCount() const { return lastUncoveredTiles_; }
 
 private:
+    // For zoom times levelZoomScale_ (see SetRenderScale)
     int32_t SelectLevel(double zoom) const;
-    void RenderTiled(const Viewport& viewport, int32_t level);
-    std::vector<TileKey> EnumerateVisibleTiles(const Viewport& viewport, int32_t level) const;
-    void LoadAndRenderTile(const TileKey& key, const Viewport& viewport, int32_t level);
 
-    // Progressive rendering: find and render fallback from coarser level
-    const TileData* FindBestFallback(const TileKey& key, TileKey* outFallbackKey);
-    void RenderFallbackTile(const TileKey& targetKey, const TileKey& fallbackKey,
-                            const TileData* fallbackTile, const Viewport& viewport, int32_t targetLevel);
+    // Level a view is drawn at: SelectLevel() with hysteresis against the
+    // level shown, or an adjacent one already resident (see
+    // MAX_RESIDENT_BLUR). While it animates the level is held: the
+    // one on screen when the animation started scales with the zoom, or
+    // the destination's if that is coarser (a zoom out never draws more
+    // tiles than its end state), so intermediate zooms request nothing.
+    int32_t SelectViewLevel(const Viewport& viewport, size_t viewIndex);
+
+    // Whether every visible tile of a level is on the GPU, in the tile
+    // cache or over background
+    bool IsLevelResident(const Viewport& viewport, int32_t level);
+    int32_t PreferResidentLevel(const Viewport& viewport, int32_t level);
+
+    // Once a pass, from the first view: whether it is moving, the motion
+    // level bias and the render scale levels are chosen at
+    void UpdateMotionState(const Viewport& viewport);
+    // Level to draw the first view at while it moves (see SetMotionLevels)
+    int32_t CoarsenForMotion(int32_t level) const;
+
+    // Queue the visible tiles of an animation's end state at its own level
+    // (VISIBLE priority) so they are in by the time it lands
+    void RequestAnimationTarget(const Viewport& viewport);
+    void RenderTiled(const Viewport& viewport, int32_t level, size_t viewIndex);
+    // Both append to tiles
+    void EnumerateVisibleTiles(const Viewport& viewport, int32_t level, std::vector<TileKey>& tiles) const;
+    void EnumerateTilesInRegion(const Rect& region, int32_t level, std::vector<TileKey>& tiles) const;
+    // Resolve a tile to a GPU texture: texture tier first, then pixel tier
+    // (uploading on demand). Returns nullptr if neither tier has the tile.
+    // Used for fallbacks, which skip the upload budget: one coarse texture
+    // stands in for many target tiles.
+    RenderTexture* AcquireTexture(const TileKey& key, int32_t* outWidth, int32_t* outHeight,
+                                  SDL_Rect* outSource);
+
+    // FirstDraw for a tile's first upload, synchronous or queued; later
+    // re-uploads of the same loaded tile (after texture eviction) are skipped
+    void RecordFirstDraw(const TileData& tile);
+
+    // Progressive rendering: cover every uncovered tile of this pass with
+    // the finest resident coarser tile. Reuses the last frame's plan until
+    // the uncovered set changes or a tile arrives.
+    void RenderFallbacks(const std::vector<TileKey>& uncovered, const Viewport& viewport, int32_t level);
+    void BuildFallbackPlan(const std::vector<TileKey>& uncovered, int32_t level);
+
+    // Look up every plan texture; false if any has been evicted since
+    struct FallbackDraw {
+        RenderTexture* texture;
+        SDL_Rect source;
+        int32_t width;
+        int32_t height;
+    };
+    bool ResolveFallbackPlan(std::vector<FallbackDraw>* outDraws);
+
+    // Whether the mask puts a tile over background only
+    bool IsBackgroundTile(const TileKey& key) const;
+
+    // Draw background tiles as flat quads of the glass color
+    void RenderBackgroundTiles(const std::vector<TileKey>& tiles, const Viewport& viewport, int32_t level);
+
+    // A visible tile cached as one color (TileStorage::Solid)
+    struct SolidTile {
+        TileKey key;
+        int32_t width;
+        int32_t height;
+        uint32_t color;
+    };
+    // Draw solid tiles as flat quads, one fill per color
+    void RenderSolidTiles(std::vector<SolidTile>& tiles, const Viewport& viewport, int32_t level);
+
+    // Screen rectangle covered by a tile of the given pixel size
+    SDL_Rect TileScreenRect(const TileKey& key, int32_t width, int32_t height,
+                            const Viewport& viewport, int32_t level) const;
+
+    // Where a tile is drawn: TileScreenRect, or its exact edges when
+    // channel styled
+    SDL_FRect TileDrawRect(const TileKey& key, int32_t width, int32_t height,
+                           const Viewport& viewport, int32_t level) const;
 
-    // Render a cached tile to screen
-    void RenderTileToScreen(const TileKey& key, const TileData* tileData,
+    // Queue a quad in the channel style, if any
+    void QueueQuad(RenderTexture* texture, const SDL_FRect& source, const SDL_FRect& dest);
+
+    // Queue a resident tile texture (source within it) for drawing
+    void RenderTileToScreen(const TileKey& key, RenderTexture* texture, const SDL_Rect& source,
+                            int32_t width, int32_t height,
                             const Viewport& viewport, int32_t level);
 
+    // Prefetch: predict where the viewport is heading and queue tiles around
+    // it at ADJACENT priority so they are decoded before they become visible
+    void UpdateMotionEstimate(const Viewport& viewport);
+    void PrefetchTiles(const Viewport& viewport, int32_t level, const std::vector<TileKey>& visibleTiles);
+    // Slide-space region at a pyramid level; synthesized levels are skipped
+    void PrewarmRegion(const Rect& region, int32_t level, bool sequential);
+
     // Callback when background thread finishes loading a tile
     void OnTileReady(const TileKey& key);
 
     SlideLoader* loader_;
-    SDL_Renderer* renderer_;
     TextureManager* textureManager_;
-    std::unique_ptr<TileCache> tileCache_;
-    std::unique_ptr<TileLoadThreadPool> threadPool_;
+    RenderBackend* backend_;
+    // Either owned or shared with other slides (see SetSharedPipeline)
+    std::unique_ptr<TileCache> ownedCache_;
+    TileCache* tileCache_;
+    std::unique_ptr<TileLoadThreadPool> ownedPool_;
+    TileLoadThreadPool* sharedPool_ = nullptr;
+    TileLoadThreadPool* threadPool_ = nullptr;  // Set while initialized
+    uint32_t slideId_ = 0;
+    bool detaching_ = false;  // Detach() called, the pool may still hold the slide
+    size_t workerThreads_;
+    bool autoScaleWorkers_;
+    DiskTileCache* diskCache_;
+
+    // Slide levels plus synthesized ones; TileKey::level indexes this
+    PyramidLayout pyramid_;
+    std::function<void()> tileReadyCallback_;
+    FrameProfiler* profiler_ = nullptr;
+    TilePipelineStats pipelineStats_;  // Also written by workers (stopped in Shutdown)
+    LevelSelection levelSelection_ = LevelSelection::Closest;
+
+    // Decode volume accounting (see GetDecodedBytesLastFrame)
+    uint64_t lastDecodedBytes_ = 0;
+    uint64_t decodedBytesLastFrame_ = 0;
+
+    // Render pass counter used to tag load requests (see RetireStaleRequests);
+    // RequestTile reads it from other threads
+    std::atomic<uint64_t> generation_{0};
+
+    // Uploads deferred by the texture upload budget in the last render pass
+    size_t deferredUploads_ = 0;
+    size_t lastUncoveredTiles_ = 0;
+
+    // Pixels of a packed tile (TileCache::SetStorage) being uploaded
+    std::vector<uint32_t> unpackBuffer_;
+
+    // Load requests of the current pass, merged across its views
+    std::vector<TileLoadRequest> frameRequests_;
+    TileScheduler scheduler_;
+
+    // A visible tile whose pixels are decoded but not yet on the GPU
+    struct PendingUpload {
+        TileKey key;
+        std::shared_ptr<const TileData> tile;  // TileHandle
+        int64_t coverage;  // Visible screen area in pixels
+    };
+    // Temporaries of a pass, cleared rather than freed: they keep their
+    // capacity from frame to frame, so a steady view allocates nothing
+    struct PassScratch {
+        std::vector<TileKey> visible;
+        std::vector<PendingUpload> uploads;  // Emptied once uploaded: they pin pixels
+        std::vector<TileKey> missing;
+        std::vector<TileKey> uncovered;
+        std::vector<TileKey> background;
+        std::vector<SolidTile> solid;
+        std::vector<FallbackDraw> fallbackDraws;
+        std::vector<SDL_Rect> backgroundRects;
+        std::vector<TileKey> prefetchCandidates;
+        std::vector<TileLoadRequest> prefetchRequests;
+        FlatTileMap<bool> prefetchSkip;
+        std::vector<TileKey> animationTarget;
+        std::vector<TileKey> residency;
+    };
+    PassScratch scratch_;
+    std::vector<RenderView> singleView_{1};  // Render(const Viewport&)
+
+    // Coarse tiles standing in for missing ones. Each quad is the union of
+    // adjacent uncovered tiles sharing a coarse tile, in level-0 slide
+    // coordinates, so every coarse tile is drawn once per region rather
+    // than once per missing tile.
+    struct FallbackQuad {
+        TileKey coarseKey;
+        double slideX0, slideY0, slideX1, slideY1;
+    };
+    struct FallbackPlan {
+        bool valid = false;
+        int32_t level = 0;
+        uint64_t arrivals = 0;            // tileArrivals_ when built
+        std::vector<TileKey> uncovered;   // Sorted
+        std::vector<TileKey> covered;     // Sorted subset with a fallback
+        std::vector<FallbackQuad> quads;
+    };
+    // Pyramid level per view (see SelectViewLevel)
+    struct ViewLevel {
+        int32_t shown = -1;        // Drawn by the last pass
+        int32_t held = -1;         // Held while the view animates, else -1
+        double targetZoom = 0.0;   // Animation end the hold was chosen for
+    };
+    std::vector<ViewLevel> viewLevels_{1};
 
-    // Track tiles that have been submitted for async loading
-    std::set<TileKey> pendingTiles_;
-    std::mutex pendingMutex_;
+    std::vector<FallbackPlan> fallbackPlans_{1};  // One per view
+    FallbackPlan* fallbackPlan_ = &fallbackPlans_[0];  // The view being drawn
+    size_t fallbackPlanBuilds_ = 0;
+    std::atomic<uint64_t> tileArrivals_{0};  // Bumped by OnTileReady (worker threads)
 
-    // Tile size (512x512 is standard)
+    // Glass vs. tissue (see SetTissueMask)
+    TissueMask tissueMask_;
+    size_t lastBackgroundTiles_ = 0;
+    size_t lastSolidTiles_ = 0;
+
+    // Tile and fallback quads of the current pass, drawn per atlas page
+    TileBatch batch_;
+    size_t lastDrawCalls_ = 0;
+    size_t lastDrawnQuads_ = 0;
+    size_t lastRequestedTiles_ = 0;
+
+    // Channel style (see SetChannelStyle): each quad is added this many
+    // times in channelTint_, so gains above 1 survive the 8-bit vertex
+    // colour; 0 draws normally
+    int32_t channelPasses_ = 0;
+    SDL_Color channelTint_ = {255, 255, 255, 255};
+
+    // Motion estimate for prefetching (slide units per millisecond)
+    bool hasLastFrame_ = false;
+    uint32_t lastFrameTicks_ = 0;
+    Vec2 lastPosition_;
+    double lastZoom_ = 1.0;
+    Vec2 panVelocity_;
+    int32_t zoomDirection_ = 0;  // +1 zooming in, -1 zooming out, 0 steady
+    size_t prefetchLimit_ = MAX_PREFETCH_TILES_PER_FRAME;  // See SetPrefetchLimit
+
+    // Announced views (see SetPlannedViews) and what the last prefetch
+    // queued of them
+    std::vector<ViewportWaypoint> plannedViews_;
+    size_t planBudget_ = 0;
+    size_t plannedViewsCovered_ = 0;
+    size_t plannedTiles_ = 0;
+
+    // Motion-adaptive resolution (see SetMotionLevels). The bias only
+    // grows during a motion, so tiles already asked for stay wanted.
+    int32_t motionLevels_ = 0;
+    int32_t motionBias_ = 0;
+    uint32_t lastFastTicks_ = 0;  // Last pass above MOTION_SPEED
+    bool moving_ = false;         // Above MOTION_SPEED, not yet settled
+    bool motionCoarsened_ = false;
+
+    // Drawable pixels per logical pixel, times the render scale in use
+    // (see SetRenderScale): what SelectLevel() multiplies zooms by
+    double displayScale_ = 1.0;
+    double renderScale_ = 1.0;
+    double movingRenderScale_ = 1.0;
+    double levelZoomScale_ = 1.0;
+
+    // Preferred tile size; each level rounds it to a multiple of its native
+    // tile size (see PyramidLayout::AlignTileSize)
     static constexpr int32_t TILE_SIZE = 512;
+
+    // Relative slack when comparing a level's downsample with 1/zoom
+    static constexpr double DOWNSAMPLE_TOLERANCE = 0.01;
+
+    // Prefetch tuning
+    static constexpr double PREFETCH_LOOKAHEAD_MS = 250.0;      // How far ahead to extrapolate panning
+    static constexpr double VELOCITY_SMOOTHING = 0.3;           // EMA weight of the newest frame
+    static constexpr size_t MAX_PREFETCH_TILES_PER_FRAME = 48;  // Cap on new ADJACENT submissions
+    static constexpr size_t CACHE_EVICTIONS_PER_FRAME = 64;     // Shrink step after a lower cache limit
 };
@@ -0,0 +1,380 @@
+#include "SlideTranscoder.h"
+#include "TiffPyramidWriter.h"
+#include "PixelConvert.h"
+#include "ThreadScheduling.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <csetjmp>
+#include <cstdio>  // jpeglib.h needs FILE
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+struct LevelGrid {
+    int64_t width;
+    int64_t height;
+    int64_t across;
+    int64_t down;
+};
+
+std::vector<LevelGrid> BuildGrids(int64_t width, int64_t height, int32_t tileSize) {
+    std::vector<LevelGrid> grids;
+    while (true) {
+        LevelGrid grid{width, height, (width + tileSize - 1) / tileSize, (height + tileSize - 1) / tileSize};
+        grids.push_back(grid);
+        if (grid.across <= 1 && grid.down <= 1) {
+            return grids;
+        }
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+struct JpegErrorManager {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+void JpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegErrorManager*>(info->err)->jump, 1);
+}
+
+// width x height of premultiplied ARGB rows stride pixels apart, composited
+// over white (slide background) and stored as YCbCr 4:2:0, libjpeg's default
+bool EncodeJpeg(const uint32_t* pixels, size_t stride, int width, int height, int quality,
+                std::vector<uint8_t>& out) {
+    // Nothing below setjmp may need unwinding: the output buffer is malloc'd,
+    // and the row buffer is sized before it
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+
+    jpeg_compress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = JpegErrorExit;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_compress(&info);
+        std::free(buffer);
+        return false;
+    }
+    jpeg_create_compress(&info);
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, quality, TRUE);
+    jpeg_start_compress(&info, TRUE);
+    while (info.next_scanline < info.image_height) {
+        PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGB24, AlphaMode::OverWhite>(
+            pixels + static_cast<size_t>(info.next_scanline) * stride, row.data(), static_cast<size_t>(width));
+        JSAMPROW scanline = row.data();
+        jpeg_write_scanlines(&info, &scanline, 1);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    out.assign(buffer, buffer + size);
+    std::free(buffer);
+    return true;
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+// Average of four premultiplied ARGB pixels, all four channels at once in
+// two 16-bit lanes each
+inline uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    constexpr uint32_t MASK = 0x00FF00FF;
+    constexpr uint32_t ROUND = 0x00020002;
+    uint32_t low = (a & MASK) + (b & MASK) + (c & MASK) + (d & MASK) + ROUND;
+    uint32_t high = ((a >> 8) & MASK) + ((b >> 8) & MASK) + ((c >> 8) & MASK) + ((d >> 8) & MASK) + ROUND;
+    return ((low >> 2) & MASK) | (((high >> 2) & MASK) << 8);
+}
+
+// 2x2 box filter of four child tiles (top-left, top-right, bottom-left,
+// bottom-right; nullptr outside the level, read as transparent) into one
+void Downsample(const std::vector<uint32_t>* children[4], int32_t tileSize, std::vector<uint32_t>& out) {
+    size_t size = static_cast<size_t>(tileSize);
+    size_t half = size / 2;
+    out.assign(size * size, 0);
+    for (size_t quadrant = 0; quadrant < 4; ++quadrant) {
+        const std::vector<uint32_t>* child = children[quadrant];
+        if (!child) {
+            continue;
+        }
+        uint32_t* target = out.data() + (quadrant >> 1) * half * size + (quadrant & 1) * half;
+        for (size_t y = 0; y < half; ++y) {
+            const uint32_t* top = child->data() + 2 * y * size;
+            const uint32_t* bottom = top + size;
+            uint32_t* row = target + y * size;
+            for (size_t x = 0; x < half; ++x) {
+                row[x] = Average4(top[2 * x], top[2 * x + 1], bottom[2 * x], bottom[2 * x + 1]);
+            }
+        }
+    }
+}
+
+// Level 0 tiles in Z (Morton) order, so the four children of every parent
+// finish close together and few tiles wait for their siblings
+std::vector<std::pair<int64_t, int64_t>> ZOrder(int64_t across, int64_t down) {
+    int64_t side = 1;
+    while (side < std::max(across, down)) {
+        side *= 2;
+    }
+    std::vector<std::pair<int64_t, int64_t>> order;
+    order.reserve(static_cast<size_t>(across * down));
+    for (uint64_t index = 0; index < static_cast<uint64_t>(side * side); ++index) {
+        int64_t column = 0;
+        int64_t row = 0;
+        for (int bit = 0; bit < 32; ++bit) {
+            column |= static_cast<int64_t>((index >> (2 * bit)) & 1) << bit;
+            row |= static_cast<int64_t>((index >> (2 * bit + 1)) & 1) << bit;
+        }
+        if (column < across && row < down) {
+            order.emplace_back(column, row);
+        }
+    }
+    return order;
+}
+
+class Pipeline {
+public:
+    Pipeline(const SlideTranscoder::RegionReader& read, const SlideTranscoder::Options& options,
+             std::vector<LevelGrid> grids, TiffPyramidWriter& writer)
+        : read_(read), options_(options), grids_(std::move(grids)), writer_(writer) {
+        for (const LevelGrid& grid : grids_) {
+            total_ += static_cast<size_t>(grid.across * grid.down);
+        }
+    }
+
+    void Run(size_t threads) {
+        order_ = ZOrder(grids_[0].across, grids_[0].down);
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { Work(); });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    bool Failed() const { return failed_.load(); }
+    const std::string& GetError() const { return error_; }
+    size_t GetTotal() const { return total_; }
+    size_t GetPeakPending() const { return peakPending_; }
+    const std::vector<uint32_t>& GetTop() const { return top_; }
+
+private:
+    using Key = std::tuple<int32_t, int64_t, int64_t>;
+
+    void Fail(const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!failed_.exchange(true)) {
+            error_ = error;
+        }
+    }
+
+    void Work() {
+        if (options_.backgroundPriority) {
+            ThreadScheduling::LowerCurrentThreadPriority();
+        }
+        size_t tileSize = static_cast<size_t>(options_.tileSize);
+        while (!failed_.load()) {
+            if (options_.cancelled && options_.cancelled()) {
+                Fail("Cancelled");
+                return;
+            }
+            size_t index = next_.fetch_add(1);
+            if (index >= order_.size()) {
+                return;
+            }
+            auto [column, row] = order_[index];
+            std::vector<uint32_t> pixels(tileSize * tileSize);
+            if (!read_(column * options_.tileSize, row * options_.tileSize, options_.tileSize, options_.tileSize,
+                       pixels.data())) {
+                Fail("Failed to read level 0 tile " + std::to_string(column) + "," + std::to_string(row));
+                return;
+            }
+            if (!Emit(0, column, row, pixels)) {
+                return;
+            }
+            Complete(0, column, row, std::move(pixels));
+        }
+    }
+
+    bool Emit(int32_t level, int64_t column, int64_t row, const std::vector<uint32_t>& pixels) {
+        std::vector<uint8_t> jpeg;
+#ifdef PATHVIEW_HAS_LIBJPEG
+        if (!EncodeJpeg(pixels.data(), static_cast<size_t>(options_.tileSize), options_.tileSize,
+                        options_.tileSize, options_.quality, jpeg)) {
+            Fail("JPEG encoding error");
+            return false;
+        }
+#else
+        (void)pixels;
+#endif
+        if (!writer_.WriteTile(level, column, row, jpeg)) {
+            Fail("Failed to write the output file");
+            return false;
+        }
+        size_t done = done_.fetch_add(1) + 1;
+        if (options_.progress) {
+            options_.progress(done, total_);
+        }
+        return true;
+    }
+
+    // Park a written tile until its siblings are done, then build and
+    // write the parent, and so on up while this worker completes families
+    void Complete(int32_t level, int64_t column, int64_t row, std::vector<uint32_t> pixels) {
+        while (!failed_.load()) {
+            if (level + 1 == static_cast<int32_t>(grids_.size())) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                top_ = std::move(pixels);
+                return;
+            }
+            const LevelGrid& grid = grids_[static_cast<size_t>(level)];
+            int64_t parentColumn = column / 2;
+            int64_t parentRow = row / 2;
+            std::vector<uint32_t> children[4];
+            const std::vector<uint32_t>* present[4] = {};
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_[Key{level, column, row}] = std::move(pixels);
+                peakPending_ = std::max(peakPending_, pending_.size());
+                for (int quadrant = 0; quadrant < 4; ++quadrant) {
+                    int64_t childColumn = parentColumn * 2 + (quadrant & 1);
+                    int64_t childRow = parentRow * 2 + (quadrant >> 1);
+                    if (childColumn < grid.across && childRow < grid.down &&
+                        pending_.find(Key{level, childColumn, childRow}) == pending_.end()) {
+                        return;
+                    }
+                }
+                for (int quadrant = 0; quadrant < 4; ++quadrant) {
+                    auto it = pending_.find(Key{level, parentColumn * 2 + (quadrant & 1), parentRow * 2 + (quadrant >> 1)});
+                    if (it != pending_.end()) {
+                        children[quadrant] = std::move(it->second);
+                        present[quadrant] = &children[quadrant];
+                        pending_.erase(it);
+                    }
+                }
+            }
+            std::vector<uint32_t> parent;
+            Downsample(present, options_.tileSize, parent);
+            if (!Emit(level + 1, parentColumn, parentRow, parent)) {
+                return;
+            }
+            level += 1;
+            column = parentColumn;
+            row = parentRow;
+            pixels = std::move(parent);
+        }
+    }
+
+    const SlideTranscoder::RegionReader& read_;
+    const SlideTranscoder::Options& options_;
+    std::vector<LevelGrid> grids_;
+    TiffPyramidWriter& writer_;
+    std::vector<std::pair<int64_t, int64_t>> order_;
+    size_t total_ = 0;
+
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> done_{0};
+    std::atomic<bool> failed_{false};
+
+    std::mutex mutex_;
+    std::map<Key, std::vector<uint32_t>> pending_;
+    size_t peakPending_ = 0;
+    std::vector<uint32_t> top_;
+    std::string error_;
+};
+
+}  // namespace
+
+bool SlideTranscoder::IsAvailable() {
+#ifdef PATHVIEW_HAS_LIBJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+int32_t SlideTranscoder::LevelCount(int64_t width, int64_t height, int32_t tileSize) {
+    return static_cast<int32_t>(BuildGrids(width, height, tileSize).size());
+}
+
+SlideTranscoder::Result SlideTranscoder::Convert(int64_t width, int64_t height, const RegionReader& read,
+                                                 const std::string& outputPath, const Options& options) {
+    Result result;
+    if (!IsAvailable()) {
+        result.error = "JPEG encoding is not available in this build";
+        return result;
+    }
+    // Even, so every parent pixel covers whole child pixels; a multiple of
+    // 16 keeps JPEG blocks and chroma subsampling whole
+    if (width <= 0 || height <= 0 || options.tileSize <= 0 || options.tileSize % 16 != 0) {
+        result.error = "Invalid slide or tile size";
+        return result;
+    }
+
+    TiffPyramidWriter writer(outputPath);
+    if (!writer.IsOpen()) {
+        result.error = "Cannot create " + outputPath;
+        return result;
+    }
+    std::vector<LevelGrid> grids = BuildGrids(width, height, options.tileSize);
+    double mpp = options.mpp;
+    for (size_t i = 0; i < grids.size(); ++i) {
+        writer.AddLevel(grids[i].width, grids[i].height, options.tileSize, mpp,
+                        i == 0 ? options.description : std::string());
+        mpp *= 2.0;
+    }
+
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    Pipeline pipeline(read, options, grids, writer);
+    pipeline.Run(threads);
+    if (pipeline.Failed()) {
+        result.error = pipeline.GetError();
+        result.cancelled = options.cancelled && options.cancelled();
+        return result;
+    }
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+    // The single top tile, cropped to the level
+    const LevelGrid& top = grids.back();
+    std::vector<uint8_t> thumbnail;
+    if (!EncodeJpeg(pipeline.GetTop().data(), static_cast<size_t>(options.tileSize), static_cast<int>(top.width),
+                    static_cast<int>(top.height), options.quality, thumbnail) ||
+        !writer.WriteThumbnail(top.width, top.height, thumbnail)) {
+        result.error = "Failed to write the thumbnail";
+        return result;
+    }
+#endif
+    if (!writer.Finish()) {
+        result.error = "Failed to write the output file";
+        return result;
+    }
+
+    result.ok = true;
+    result.levels = static_cast<int32_t>(grids.size());
+    result.tiles = pipeline.GetTotal();
+    result.bytes = writer.GetBytesWritten();
+    result.peakPendingTiles = pipeline.GetPeakPending();
+    return result;
+}
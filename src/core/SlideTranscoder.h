@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Rewrites a slide as a viewer-optimised pyramid (pathview-convert): a
+// TiffPyramidWriter BigTIFF whose tiles are square JPEGs on the renderer's
+// tile grid, with a level at every power-of-two downsample down to a single
+// tile and that last tile as the thumbnail. Every level is then one the
+// direct TIFF path serves, each view tile is one stored tile, and no level
+// is ever synthesised at view time.
+//
+// Only level 0 is read from the source. Its tiles are visited in Z order
+// by a pool of workers, each reading, encoding and writing a tile; the
+// worker that completes the fourth child of a parent box-downsamples the
+// four into it and carries on up the pyramid. A tile's pixels are freed as
+// soon as its parent is built, so memory is a few tiles per worker and
+// level, whatever the slide size.
+class SlideTranscoder {
+public:
+    // Level 0 region as premultiplied ARGB, pixels outside the slide
+    // transparent (SlideLoader::ReadRegionInto at level 0). Called from
+    // several threads at once.
+    using RegionReader =
+        std::function<bool(int64_t x, int64_t y, int64_t width, int64_t height, uint32_t* pixels)>;
+
+    struct Options {
+        int32_t tileSize = 512;  // SlideRenderer::TILE_SIZE
+        int quality = 90;        // JPEG, 1-100
+        size_t threads = 0;      // 0: hardware concurrency
+        double mpp = 0.0;        // Level 0 pixel size, written as the resolution
+        std::string description; // Level 0 ImageDescription
+        // Tiles written so far of the total; called from the workers
+        std::function<void(size_t done, size_t total)> progress;
+        // Polled before each level 0 tile; true stops the conversion
+        std::function<bool()> cancelled;
+        // Run the workers below the render thread (ThreadScheduling), for
+        // conversions inside the viewer (region.export)
+        bool backgroundPriority = false;
+    };
+
+    struct Result {
+        bool ok = false;
+        bool cancelled = false;
+        std::string error;
+        int32_t levels = 0;
+        size_t tiles = 0;
+        uint64_t bytes = 0;
+        size_t peakPendingTiles = 0;  // Most decoded tiles held at once
+    };
+
+    // Whether this build can encode JPEG tiles (libjpeg-turbo found)
+    static bool IsAvailable();
+
+    // Number of levels for a slide: halving until one tile covers it
+    static int32_t LevelCount(int64_t width, int64_t height, int32_t tileSize);
+
+    static Result Convert(int64_t width, int64_t height, const RegionReader& read, const std::string& outputPath,
+                          const Options& options);
+};
@@ -0,0 +1,388 @@
+#include "SnapshotEncoder.h"
+#include "PNGEncoder.h"
+#include "PixelConvert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <csetjmp>
+#include <cstdio>  // jpeglib.h needs FILE
+#include <jpeglib.h>
+#endif
+
+#ifdef PATHVIEW_HAS_LIBWEBP
+#include <webp/encode.h>
+#endif
+
+namespace pathview {
+
+namespace {
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+struct JpegErrorManager {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+void JpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegErrorManager*>(info->err)->jump, 1);
+}
+
+bool EncodeJpeg(const std::vector<uint8_t>& pixels, int width, int height, int quality,
+                std::vector<uint8_t>& out) {
+    // Nothing below setjmp may need unwinding: the output buffer is malloc'd,
+    // and the row buffer is sized before it
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+#ifndef JCS_EXTENSIONS
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);  // libjpeg-turbo reads RGBA rows directly
+#endif
+
+    jpeg_compress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = JpegErrorExit;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_compress(&info);
+        std::free(buffer);
+        return false;
+    }
+    jpeg_create_compress(&info);
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+#ifdef JCS_EXTENSIONS
+    info.input_components = 4;
+    info.in_color_space = JCS_EXT_RGBA;
+#else
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+#endif
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, quality, TRUE);
+    jpeg_start_compress(&info, TRUE);
+    while (info.next_scanline < info.image_height) {
+        const uint8_t* rgba = pixels.data() + static_cast<size_t>(info.next_scanline) * width * 4;
+#ifdef JCS_EXTENSIONS
+        JSAMPROW scanline = const_cast<JSAMPROW>(rgba);
+#else
+        PixelConvert::ConvertRow<PixelLayout::RGBA8, PixelLayout::RGB24, AlphaMode::Opaque>(
+            rgba, row.data(), static_cast<size_t>(width));
+        JSAMPROW scanline = row.data();
+#endif
+        jpeg_write_scanlines(&info, &scanline, 1);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    out.assign(buffer, buffer + size);
+    std::free(buffer);
+    return true;
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+#ifdef PATHVIEW_HAS_LIBWEBP
+
+bool EncodeWebP(const std::vector<uint8_t>& pixels, int width, int height, int quality,
+                std::vector<uint8_t>& out) {
+    uint8_t* buffer = nullptr;
+    const int stride = width * 4;
+    const size_t size = quality >= 100
+        ? WebPEncodeLosslessRGBA(pixels.data(), width, height, stride, &buffer)
+        : WebPEncodeRGBA(pixels.data(), width, height, stride, static_cast<float>(quality), &buffer);
+    if (size == 0) {
+        WebPFree(buffer);
+        return false;
+    }
+    out.assign(buffer, buffer + size);
+    WebPFree(buffer);
+    return true;
+}
+
+#endif  // PATHVIEW_HAS_LIBWEBP
+
+// QOI opcodes
+constexpr uint8_t QOI_OP_INDEX = 0x00;
+constexpr uint8_t QOI_OP_DIFF = 0x40;
+constexpr uint8_t QOI_OP_LUMA = 0x80;
+constexpr uint8_t QOI_OP_RUN = 0xC0;
+constexpr uint8_t QOI_OP_RGB = 0xFE;
+constexpr uint8_t QOI_OP_RGBA = 0xFF;
+constexpr int QOI_MAX_RUN = 62;
+constexpr uint8_t QOI_END[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+void PutBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+}  // namespace
+
+SnapshotEncoder::Result SnapshotEncoder::Encode(const std::vector<uint8_t>& pixels, int width, int height,
+                                                const Options& options) {
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("Invalid image dimensions");
+    }
+    if (pixels.size() != static_cast<size_t>(width) * height * 4) {
+        throw std::runtime_error("Pixel data size mismatch");
+    }
+    const int quality = std::max(1, std::min(100, options.quality));
+
+    Result result;
+    result.format = options.format;
+    switch (options.format) {
+        case SnapshotFormat::Jpeg:
+#ifdef PATHVIEW_HAS_LIBJPEG
+            if (!EncodeJpeg(pixels, width, height, quality, result.data)) {
+                throw std::runtime_error("JPEG encoding error");
+            }
+            return result;
+#else
+            break;
+#endif
+        case SnapshotFormat::WebP:
+#ifdef PATHVIEW_HAS_LIBWEBP
+            if (!EncodeWebP(pixels, width, height, quality, result.data)) {
+                throw std::runtime_error("WebP encoding error");
+            }
+            return result;
+#else
+            break;
+#endif
+        case SnapshotFormat::Qoi:
+            result.data = EncodeQoi(pixels, width, height);
+            return result;
+        case SnapshotFormat::Png:
+            break;
+    }
+
+    (void)quality;
+    result.format = SnapshotFormat::Png;
+    result.data = PNGEncoder::Encode(pixels, width, height, PNGEncoder::FAST_LEVEL, options.threads);
+    return result;
+}
+
+bool SnapshotEncoder::IsSupported(SnapshotFormat format) {
+    switch (format) {
+        case SnapshotFormat::Jpeg:
+#ifdef PATHVIEW_HAS_LIBJPEG
+            return true;
+#else
+            return false;
+#endif
+        case SnapshotFormat::WebP:
+#ifdef PATHVIEW_HAS_LIBWEBP
+            return true;
+#else
+            return false;
+#endif
+        case SnapshotFormat::Png:
+        case SnapshotFormat::Qoi:
+            return true;
+    }
+    return false;
+}
+
+std::optional<SnapshotFormat> SnapshotEncoder::ParseFormat(const std::string& name) {
+    if (name == "png") return SnapshotFormat::Png;
+    if (name == "jpeg" || name == "jpg") return SnapshotFormat::Jpeg;
+    if (name == "webp") return SnapshotFormat::WebP;
+    if (name == "qoi") return SnapshotFormat::Qoi;
+    return std::nullopt;
+}
+
+const char* SnapshotEncoder::FormatName(SnapshotFormat format) {
+    switch (format) {
+        case SnapshotFormat::Png: return "png";
+        case SnapshotFormat::Jpeg: return "jpeg";
+        case SnapshotFormat::WebP: return "webp";
+        case SnapshotFormat::Qoi: return "qoi";
+    }
+    return "png";
+}
+
+const char* SnapshotEncoder::MimeType(SnapshotFormat format) {
+    switch (format) {
+        case SnapshotFormat::Png: return "image/png";
+        case SnapshotFormat::Jpeg: return "image/jpeg";
+        case SnapshotFormat::WebP: return "image/webp";
+        case SnapshotFormat::Qoi: return "image/qoi";
+    }
+    return "image/png";
+}
+
+void SnapshotEncoder::FitSize(int width, int height, int maxDimension, double scale,
+                              int& outWidth, int& outHeight) {
+    double factor = std::min(1.0, scale);
+    const int longer = std::max(width, height);
+    if (maxDimension > 0 && longer > 0) {
+        factor = std::min(factor, double(maxDimension) / longer);
+    }
+    outWidth = std::max(1, static_cast<int>(std::lround(width * factor)));
+    outHeight = std::max(1, static_cast<int>(std::lround(height * factor)));
+    outWidth = std::min(outWidth, std::max(width, 1));
+    outHeight = std::min(outHeight, std::max(height, 1));
+}
+
+std::vector<uint8_t> SnapshotEncoder::Downscale(const std::vector<uint8_t>& pixels, int width, int height,
+                                                int outWidth, int outHeight) {
+    if (width <= 0 || height <= 0 || outWidth <= 0 || outHeight <= 0 ||
+        pixels.size() < static_cast<size_t>(width) * height * 4) {
+        throw std::runtime_error("Invalid snapshot dimensions");
+    }
+    std::vector<uint8_t> out(static_cast<size_t>(outWidth) * outHeight * 4);
+    for (int y = 0; y < outHeight; ++y) {
+        const int y0 = static_cast<int>(int64_t(y) * height / outHeight);
+        const int y1 = std::max(y0 + 1, static_cast<int>(int64_t(y + 1) * height / outHeight));
+        for (int x = 0; x < outWidth; ++x) {
+            const int x0 = static_cast<int>(int64_t(x) * width / outWidth);
+            const int x1 = std::max(x0 + 1, static_cast<int>(int64_t(x + 1) * width / outWidth));
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int sy = y0; sy < y1; ++sy) {
+                const uint8_t* row = pixels.data() + (static_cast<size_t>(sy) * width + x0) * 4;
+                for (int sx = x0; sx < x1; ++sx, row += 4) {
+                    sum[0] += row[0];
+                    sum[1] += row[1];
+                    sum[2] += row[2];
+                    sum[3] += row[3];
+                }
+            }
+            const uint32_t count = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+            uint8_t* target = out.data() + (static_cast<size_t>(y) * outWidth + x) * 4;
+            for (int c = 0; c < 4; ++c) {
+                target[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> SnapshotEncoder::EncodeQoi(const std::vector<uint8_t>& pixels, int width, int height) {
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    if (width <= 0 || height <= 0 || pixels.size() != pixelCount * 4) {
+        throw std::runtime_error("Invalid QOI input");
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(14 + pixelCount * 2 + sizeof(QOI_END));  // Typical; RGBA ops can reach 5 bytes
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    PutBigEndian32(out, static_cast<uint32_t>(width));
+    PutBigEndian32(out, static_cast<uint32_t>(height));
+    out.push_back(4);  // Channels
+    out.push_back(0);  // sRGB with linear alpha
+
+    uint8_t index[64][4] = {};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint8_t* px = &pixels[i * 4];
+        if (std::memcmp(px, prev, 4) == 0) {
+            ++run;
+            if (run == QOI_MAX_RUN || i + 1 == pixelCount) {
+                out.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (std::memcmp(index[hash], px, 4) == 0) {
+            out.push_back(static_cast<uint8_t>(QOI_OP_INDEX | hash));
+        } else {
+            std::memcpy(index[hash], px, 4);
+            if (px[3] == prev[3]) {
+                // Channel differences wrap, as the decoder adds them mod 256
+                const int dr = static_cast<int8_t>(px[0] - prev[0]);
+                const int dg = static_cast<int8_t>(px[1] - prev[1]);
+                const int db = static_cast<int8_t>(px[2] - prev[2]);
+                const int drg = dr - dg;
+                const int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back(static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                } else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7) {
+                    out.push_back(static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32)));
+                    out.push_back(static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8)));
+                } else {
+                    out.insert(out.end(), {QOI_OP_RGB, px[0], px[1], px[2]});
+                }
+            } else {
+                out.insert(out.end(), {QOI_OP_RGBA, px[0], px[1], px[2], px[3]});
+            }
+        }
+        std::memcpy(prev, px, 4);
+    }
+
+    out.insert(out.end(), QOI_END, QOI_END + sizeof(QOI_END));
+    return out;
+}
+
+uint64_t SnapshotEncoder::ContentKey(const std::vector<uint8_t>& pixels, int width, int height,
+                                     const Options& options) {
+    constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    auto rotate = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+    auto round = [&](uint64_t lane, uint64_t word) { return rotate(lane + word * PRIME2, 31) * PRIME1; };
+
+    uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+    const uint8_t* p = pixels.data();
+    const size_t size = pixels.size();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, p + i + 8 * lane, 8);
+            lanes[lane] = round(lanes[lane], word);
+        }
+    }
+    for (; i < size; i += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, std::min<size_t>(8, size - i));
+        lanes[0] = round(lanes[0], word);
+    }
+
+    uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+    for (uint64_t value : {uint64_t(size), uint64_t(uint32_t(width)) << 32 | uint32_t(height),
+                           uint64_t(options.format) << 32 | uint32_t(std::max(1, std::min(100, options.quality)))}) {
+        hash = rotate(hash ^ round(0, value), 27) * PRIME1 + PRIME2;
+    }
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::shared_ptr<const SnapshotEncoder::Result> EncodedImageCache::Find(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = images_.begin(); it != images_.end(); ++it) {
+        if (it->first == key) {
+            images_.splice(images_.begin(), images_, it);
+            return images_.front().second;
+        }
+    }
+    return nullptr;
+}
+
+void EncodedImageCache::Insert(uint64_t key, std::shared_ptr<const SnapshotEncoder::Result> image) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_.remove_if([key](const auto& entry) { return entry.first == key; });
+    images_.emplace_front(key, std::move(image));
+    if (images_.size() > CAPACITY) {
+        images_.pop_back();
+    }
+}
+
+} // namespace pathview
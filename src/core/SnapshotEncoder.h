@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pathview {
+
+enum class SnapshotFormat {
+    Png,   // Lossless, PNGEncoder at its fast level
+    Jpeg,  // libjpeg-turbo
+    WebP,  // libwebp, lossless at quality 100
+    Qoi    // "Quite OK Image": lossless, no compression library at all
+};
+
+/**
+ * SnapshotEncoder - Encodes captured frames for snapshot.capture
+ *
+ * Snapshots are latency-bound (an agent waits on each one), so the default
+ * is PNG at zlib level 1 on several threads rather than a small file.
+ * Lossy formats trade exactness for size where that matters more. JPEG
+ * and WebP need their (optional) libraries; builds without one write PNG
+ * instead and say so in the result.
+ */
+class SnapshotEncoder {
+public:
+    struct Options {
+        SnapshotFormat format = SnapshotFormat::Png;
+        int quality = 90;    // JPEG / WebP, 1-100
+        size_t threads = 0;  // PNG compression threads, 0: automatic
+    };
+
+    struct Result {
+        std::vector<uint8_t> data;
+        SnapshotFormat format = SnapshotFormat::Png;  // What was actually written
+    };
+
+    /**
+     * Encode RGBA pixels (4 bytes per pixel, row-major, top to bottom)
+     * @throws std::runtime_error on invalid input or a failed encode
+     */
+    static Result Encode(const std::vector<uint8_t>& pixels, int width, int height, const Options& options);
+
+    /**
+     * Formats this build can write (PNG and QOI always)
+     */
+    static bool IsSupported(SnapshotFormat format);
+
+    /**
+     * "png", "jpeg"/"jpg", "webp" or "qoi", case-sensitive
+     */
+    static std::optional<SnapshotFormat> ParseFormat(const std::string& name);
+    static const char* FormatName(SnapshotFormat format);
+    static const char* MimeType(SnapshotFormat format);
+
+    /**
+     * Size a width x height capture is sent at: scale in (0, 1], then fit
+     * within maxDimension on its longer side (0: no limit). Never larger
+     * than the capture, at least 1x1, aspect kept.
+     */
+    static void FitSize(int width, int height, int maxDimension, double scale, int& outWidth, int& outHeight);
+
+    /**
+     * Scale RGBA pixels down by averaging the block of source pixels under
+     * each output pixel (the CPU path, where no GPU downscale is available)
+     */
+    static std::vector<uint8_t> Downscale(const std::vector<uint8_t>& pixels, int width, int height,
+                                          int outWidth, int outHeight);
+
+    /**
+     * QOI encoder (https://qoiformat.org), 4 channels, sRGB
+     */
+    static std::vector<uint8_t> EncodeQoi(const std::vector<uint8_t>& pixels, int width, int height);
+
+    /**
+     * Content key of the image Encode() would write: a 64-bit hash of the
+     * pixels (four independent multiply-rotate lanes over 8-byte words, so
+     * it runs near memory speed) mixed with the size, format and quality.
+     * Equal frames encoded alike get equal keys.
+     */
+    static uint64_t ContentKey(const std::vector<uint8_t>& pixels, int width, int height, const Options& options);
+};
+
+/**
+ * The last few encoded images by content key, so an unchanged frame (a
+ * repeated capture of the same view) is not encoded again. Thread-safe:
+ * encoders on several workers share one.
+ */
+class EncodedImageCache {
+public:
+    std::shared_ptr<const SnapshotEncoder::Result> Find(uint64_t key);
+    void Insert(uint64_t key, std::shared_ptr<const SnapshotEncoder::Result> image);
+
+    static constexpr size_t CAPACITY = 4;
+
+private:
+    std::mutex mutex_;
+    // Most recent first
+    std::list<std::pair<uint64_t, std::shared_ptr<const SnapshotEncoder::Result>>> images_;
+};
+
+} // namespace pathview
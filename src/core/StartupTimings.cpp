@@ -0,0 +1,56 @@
+#include "StartupTimings.h"
+#include <cstdio>
+
+namespace {
+
+double Ms(StartupTimings::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void AppendLine(std::string& out, const std::string& name, double ms) {
+    char line[96];
+    std::snprintf(line, sizeof(line), "  %-28s %8.1f ms\n", name.c_str(), ms);
+    out += line;
+}
+
+}  // namespace
+
+StartupTimings::StartupTimings(Clock::time_point start)
+    : start_(start)
+    , last_(start) {
+}
+
+void StartupTimings::Mark(const std::string& phase, Clock::time_point now) {
+    phases_.push_back({phase, Ms(now - last_), HasFirstFrame()});
+    last_ = now;
+}
+
+void StartupTimings::MarkFirstFrame(Clock::time_point now) {
+    if (HasFirstFrame()) {
+        return;
+    }
+    Mark("first frame", now);
+    firstFrameMs_ = Ms(now - start_);
+}
+
+double StartupTimings::GetTotalMs() const {
+    return Ms(last_ - start_);
+}
+
+std::string StartupTimings::Format() const {
+    std::string out = "Startup timings:\n";
+    bool deferred = false;
+    for (const Phase& phase : phases_) {
+        if (phase.deferred && !deferred) {
+            AppendLine(out, "= time to first frame", firstFrameMs_);
+            out += "  after the first frame:\n";
+            deferred = true;
+        }
+        AppendLine(out, phase.name, phase.ms);
+    }
+    if (!deferred && HasFirstFrame()) {
+        AppendLine(out, "= time to first frame", firstFrameMs_);
+    }
+    AppendLine(out, "= total", GetTotalMs());
+    return out;
+}
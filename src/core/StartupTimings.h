@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Time to first frame, phase by phase, for pathview --timings.
+//
+// Each Mark() ends the phase running since the previous mark (or since
+// the timings were created). MarkFirstFrame() notes the moment the first
+// frame was presented: phases marked after it are the work deferred until
+// the window was on screen, reported apart from the time to first frame.
+class StartupTimings {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        double ms = 0.0;
+        bool deferred = false;  // Ran after the first frame
+    };
+
+    explicit StartupTimings(Clock::time_point start = Clock::now());
+
+    void Mark(const std::string& phase, Clock::time_point now = Clock::now());
+    // Ends the phase before it as "first frame"; only the first call counts
+    void MarkFirstFrame(Clock::time_point now = Clock::now());
+
+    const std::vector<Phase>& GetPhases() const { return phases_; }
+    bool HasFirstFrame() const { return firstFrameMs_ >= 0.0; }
+    // From creation to the first frame; -1 before it
+    double GetFirstFrameMs() const { return firstFrameMs_; }
+    // From creation to the last mark
+    double GetTotalMs() const;
+
+    // One line per phase, the time to first frame, then the deferred phases
+    std::string Format() const;
+
+private:
+    Clock::time_point start_;
+    Clock::time_point last_;
+    std::vector<Phase> phases_;
+    double firstFrameMs_ = -1.0;
+};
@@ -0,0 +1,379 @@
+#include "SyntheticSlide.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Salts keeping the texture's noise layers and the cells on separate streams
+constexpr uint64_t TISSUE_SALT = 0x7469737375650001ull;
+constexpr uint64_t DETAIL_SALT = 0x7469737375650002ull;
+constexpr uint64_t GRAIN_SALT = 0x677261696E000003ull;
+constexpr uint64_t NUCLEUS_SALT = 0x6E75636C65750004ull;
+constexpr uint64_t CELL_SALT = 0x63656C6C73000005ull;
+
+// Level 0 pixels between nuclei of the texture
+constexpr double NUCLEUS_PITCH = 28.0;
+
+// splitmix64's finalizer
+uint64_t Mix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t Hash(uint64_t seed, int64_t a, int64_t b) {
+    return Mix(seed ^ Mix(static_cast<uint64_t>(a) ^ Mix(static_cast<uint64_t>(b))));
+}
+
+// [0, 1) from the top 53 bits
+double Unit(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SmoothStep(double edge0, double edge1, double x) {
+    double t = std::clamp((x - edge0) / (edge1 - edge0), 0.0, 1.0);
+    return t * t * (3.0 - 2.0 * t);
+}
+
+// Smoothly interpolated lattice of hashed values in [0, 1), x and y in
+// lattice units
+double ValueNoise(uint64_t seed, double x, double y) {
+    double fx = std::floor(x);
+    double fy = std::floor(y);
+    int64_t ix = static_cast<int64_t>(fx);
+    int64_t iy = static_cast<int64_t>(fy);
+    double tx = SmoothStep(0.0, 1.0, x - fx);
+    double ty = SmoothStep(0.0, 1.0, y - fy);
+    double v00 = Unit(Hash(seed, ix, iy));
+    double v10 = Unit(Hash(seed, ix + 1, iy));
+    double v01 = Unit(Hash(seed, ix, iy + 1));
+    double v11 = Unit(Hash(seed, ix + 1, iy + 1));
+    double top = v00 + (v10 - v00) * tx;
+    double bottom = v01 + (v11 - v01) * tx;
+    return top + (bottom - top) * ty;
+}
+
+// splitmix64 stream for the cells of one tile
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    double Next() {
+        state_ += 0x9E3779B97F4A7C15ull;
+        return Unit(Mix(state_));
+    }
+
+private:
+    uint64_t state_;
+};
+
+bool ParseInt(const std::string& text, int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (*end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+uint8_t Channel(double value) {
+    return static_cast<uint8_t>(std::clamp(value, 0.0, 255.0) + 0.5);
+}
+
+}  // namespace
+
+bool SyntheticSlideSpec::Parse(const std::string& path, SyntheticSlideSpec& spec, std::string& error) {
+    if (!SyntheticSlide::IsSyntheticPath(path)) {
+        error = "Not a synthetic:// path";
+        return false;
+    }
+    spec = SyntheticSlideSpec();
+    std::string rest = path.substr(std::string(SyntheticSlide::PREFIX).size());
+    const size_t question = rest.find('?');
+    const std::string size = rest.substr(0, question);
+    const std::string query = question == std::string::npos ? std::string() : rest.substr(question + 1);
+
+    if (!size.empty()) {
+        const size_t x = size.find('x');
+        if (x == std::string::npos || !ParseInt(size.substr(0, x), spec.width) ||
+            !ParseInt(size.substr(x + 1), spec.height) || spec.width < 1 || spec.height < 1 ||
+            spec.width > MAX_DIMENSION || spec.height > MAX_DIMENSION) {
+            error = "Invalid synthetic slide size: " + size;
+            return false;
+        }
+    }
+
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        const std::string pair = query.substr(start, end - start);
+        start = end + 1;
+        if (pair.empty()) {
+            continue;
+        }
+        const size_t equals = pair.find('=');
+        const std::string key = pair.substr(0, equals);
+        const std::string text = equals == std::string::npos ? std::string() : pair.substr(equals + 1);
+        int64_t value = 0;
+        bool ok = ParseInt(text, value);
+        if (key == "levels") {
+            ok = ok && value >= 0 && value <= MAX_LEVELS;
+            spec.levels = static_cast<int32_t>(value);
+        } else if (key == "tile") {
+            ok = ok && value >= MIN_TILE_SIZE && value <= MAX_TILE_SIZE;
+            spec.tileSize = static_cast<int32_t>(value);
+        } else if (key == "latency_us") {
+            ok = ok && value >= 0 && value <= MAX_LATENCY_US;
+            spec.latencyUs = value;
+        } else if (key == "seed") {
+            ok = ok && value >= 0;
+            spec.seed = static_cast<uint64_t>(value);
+        } else {
+            error = "Unknown synthetic slide parameter: " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "Invalid synthetic slide parameter: " + pair;
+            return false;
+        }
+    }
+    return true;
+}
+
+
+SyntheticSlide::SyntheticSlide(const SyntheticSlideSpec& spec)
+    : spec_(spec)
+    , tissueScale_(std::max(64.0, static_cast<double>(std::max(spec.width, spec.height)) / 5.0))
+{
+    LevelDimensions level{spec_.width, spec_.height};
+    const int32_t maxLevels = spec_.levels > 0 ? spec_.levels : SyntheticSlideSpec::MAX_LEVELS;
+    for (int32_t i = 0; i < maxLevels; ++i) {
+        levels_.push_back(level);
+        if (spec_.levels == 0 && level.width <= spec_.tileSize && level.height <= spec_.tileSize) {
+            break;
+        }
+        level = {(level.width + 1) / 2, (level.height + 1) / 2};
+    }
+}
+
+bool SyntheticSlide::IsSyntheticPath(const std::string& path) {
+    return path.rfind(PREFIX, 0) == 0;
+}
+
+double SyntheticSlide::GetLevelDownsample(int32_t level) const {
+    return std::ldexp(1.0, level);
+}
+
+double SyntheticSlide::GetTissueDensity(double x, double y) const {
+    if (x < 0 || y < 0 || x >= spec_.width || y >= spec_.height) {
+        return 0.0;
+    }
+    const double u = x / tissueScale_;
+    const double v = y / tissueScale_;
+    const double noise = 0.7 * ValueNoise(spec_.seed ^ TISSUE_SALT, u, v) +
+                         0.3 * ValueNoise(spec_.seed ^ DETAIL_SALT, u * 4.0, v * 4.0);
+
+    // Glass margin around the section
+    const double margin = 0.04 * static_cast<double>(std::min(spec_.width, spec_.height));
+    const double edge = std::min({x, y, spec_.width - x, spec_.height - y});
+    return SmoothStep(0.45, 0.55, noise) * SmoothStep(0.0, margin, edge);
+}
+
+uint32_t SyntheticSlide::ShadePixel(double x, double y) const {
+    const double tissue = GetTissueDensity(x, y);
+    const double grain = Unit(Hash(spec_.seed ^ GRAIN_SALT, static_cast<int64_t>(std::floor(x / 3.0)),
+                                   static_cast<int64_t>(std::floor(y / 3.0))));
+
+    // Glass to eosin, with a fibrous grain in the tissue
+    double r = 244.0 + (232.0 - 40.0 * grain - 244.0) * tissue;
+    double g = 243.0 + (158.0 - 35.0 * grain - 243.0) * tissue;
+    double b = 247.0 + (196.0 - 20.0 * grain - 247.0) * tissue;
+
+    // At most one nucleus per grid cell, kept inside it so only this
+    // cell's needs checking
+    const int64_t cellX = static_cast<int64_t>(std::floor(x / NUCLEUS_PITCH));
+    const int64_t cellY = static_cast<int64_t>(std::floor(y / NUCLEUS_PITCH));
+    const uint64_t h = Hash(spec_.seed ^ NUCLEUS_SALT, cellX, cellY);
+    if (Unit(h) < 0.8 * tissue) {
+        const double cx = (cellX + 0.25 + 0.5 * Unit(Mix(h + 1))) * NUCLEUS_PITCH;
+        const double cy = (cellY + 0.25 + 0.5 * Unit(Mix(h + 2))) * NUCLEUS_PITCH;
+        const double radius = (0.14 + 0.1 * Unit(Mix(h + 3))) * NUCLEUS_PITCH;
+        const double dx = x - cx;
+        const double dy = y - cy;
+        const double d = (dx * dx + dy * dy) / (radius * radius);
+        if (d < 1.0) {
+            const double ink = 0.9 - 0.3 * d;  // Paler at the membrane
+            r += (78.0 - r) * ink;
+            g += (52.0 - g) * ink;
+            b += (138.0 - b) * ink;
+        }
+    }
+    return 0xFF000000u | (static_cast<uint32_t>(Channel(r)) << 16) |
+           (static_cast<uint32_t>(Channel(g)) << 8) | Channel(b);
+}
+
+void SyntheticSlide::ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                uint32_t* pixels) const {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    std::fill(pixels, pixels + width * height, 0u);
+    if (level < 0 || level >= static_cast<int32_t>(levels_.size())) {
+        return;
+    }
+    const LevelDimensions& dims = levels_[level];
+    const int64_t x0 = std::max<int64_t>(x, 0);
+    const int64_t y0 = std::max<int64_t>(y, 0);
+    const int64_t x1 = std::min(x + width, dims.width);
+    const int64_t y1 = std::min(y + height, dims.height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    const double downsample = GetLevelDownsample(level);
+    for (int64_t py = y0; py < y1; ++py) {
+        uint32_t* row = pixels + (py - y) * width;
+        const double sy = (py + 0.5) * downsample;
+        for (int64_t px = x0; px < x1; ++px) {
+            row[px - x] = ShadePixel((px + 0.5) * downsample, sy);
+        }
+    }
+
+    const int64_t tile = spec_.tileSize;
+    const size_t tiles = static_cast<size_t>(((x1 - 1) / tile - x0 / tile + 1) * ((y1 - 1) / tile - y0 / tile + 1));
+    tileReadCount_ += tiles;
+    if (spec_.latencyUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(spec_.latencyUs * static_cast<int64_t>(tiles)));
+    }
+}
+
+SyntheticCells::SyntheticCells(const SyntheticSlide& slide, size_t cellCount)
+    : slide_(slide)
+{
+    const SyntheticSlideSpec& spec = slide.GetSpec();
+    columns_ = (spec.width + TILE_SIZE - 1) / TILE_SIZE;
+    rows_ = (spec.height + TILE_SIZE - 1) / TILE_SIZE;
+
+    // Weigh each tile by the tissue on a 4x4 grid of samples over its part
+    // of the slide
+    constexpr int32_t SAMPLES = 4;
+    std::vector<double> weights(static_cast<size_t>(columns_ * rows_));
+    double total = 0.0;
+    for (int64_t row = 0; row < rows_; ++row) {
+        for (int64_t column = 0; column < columns_; ++column) {
+            const double left = static_cast<double>(column * TILE_SIZE);
+            const double top = static_cast<double>(row * TILE_SIZE);
+            const double w = std::min<double>(TILE_SIZE, spec.width - left);
+            const double h = std::min<double>(TILE_SIZE, spec.height - top);
+            double density = 0.0;
+            for (int32_t j = 0; j < SAMPLES; ++j) {
+                for (int32_t i = 0; i < SAMPLES; ++i) {
+                    density += slide.GetTissueDensity(left + (i + 0.5) * w / SAMPLES, top + (j + 0.5) * h / SAMPLES);
+                }
+            }
+            const double weight = density * w * h;
+            weights[row * columns_ + column] = weight;
+            total += weight;
+        }
+    }
+
+    // Round the running total so the counts add up to cellCount exactly;
+    // all glass spreads them by area instead
+    tileCounts_.assign(weights.size(), 0);
+    if (total <= 0.0) {
+        for (int64_t row = 0; row < rows_; ++row) {
+            for (int64_t column = 0; column < columns_; ++column) {
+                weights[row * columns_ + column] =
+                    std::min<double>(TILE_SIZE, spec.width - column * TILE_SIZE) *
+                    std::min<double>(TILE_SIZE, spec.height - row * TILE_SIZE);
+                total += weights[row * columns_ + column];
+            }
+        }
+    }
+    double running = 0.0;
+    size_t assigned = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        running += weights[i];
+        const size_t target = i + 1 == weights.size()
+            ? cellCount
+            : std::min(cellCount, static_cast<size_t>(std::llround(running / total * static_cast<double>(cellCount))));
+        tileCounts_[i] = static_cast<uint32_t>(target - std::min(target, assigned));
+        assigned = std::max(assigned, target);
+    }
+}
+
+void SyntheticCells::Generate(int64_t column, int64_t row, std::vector<Cell>& cells, std::vector<float>& xy) const {
+    cells.clear();
+    xy.clear();
+    const size_t count = GetCellCount(column, row);
+    if (count == 0) {
+        return;
+    }
+    const SyntheticSlideSpec& spec = slide_.GetSpec();
+    const double left = static_cast<double>(column * TILE_SIZE);
+    const double top = static_cast<double>(row * TILE_SIZE);
+    const double w = std::min<double>(TILE_SIZE, spec.width - left);
+    const double h = std::min<double>(TILE_SIZE, spec.height - top);
+    Random random(Hash(spec.seed ^ CELL_SALT, column, row));
+
+    cells.reserve(count);
+    xy.reserve(count * 2 * 11);
+    for (size_t k = 0; k < count; ++k) {
+        // Rejection sampling towards dense tissue; the last try stands
+        // when none is accepted
+        double cx = 0.0;
+        double cy = 0.0;
+        for (int32_t attempt = 0; attempt < 8; ++attempt) {
+            cx = left + random.Next() * w;
+            cy = top + random.Next() * h;
+            if (random.Next() < slide_.GetTissueDensity(cx, cy)) {
+                break;
+            }
+        }
+
+        const uint32_t vertices = 8 + static_cast<uint32_t>(random.Next() * 7.0);
+        const double radius = 5.0 + 7.0 * random.Next();
+        const double aspect = 0.7 + 0.3 * random.Next();
+        const double angle = random.Next() * 2.0 * PI;
+        const double cosAngle = std::cos(angle);
+        const double sinAngle = std::sin(angle);
+
+        Cell cell;
+        cell.firstVertex = static_cast<uint32_t>(xy.size() / 2);
+        cell.vertexCount = vertices;
+        for (uint32_t i = 0; i < vertices; ++i) {
+            const double theta = 2.0 * PI * i / vertices;
+            const double r = radius * (0.85 + 0.3 * random.Next());
+            const double ex = r * std::cos(theta);
+            const double ey = r * aspect * std::sin(theta);
+            const double vx = std::clamp(cx + ex * cosAngle - ey * sinAngle, 0.0, static_cast<double>(spec.width));
+            const double vy = std::clamp(cy + ex * sinAngle + ey * cosAngle, 0.0, static_cast<double>(spec.height));
+            xy.push_back(static_cast<float>(vx - left));
+            xy.push_back(static_cast<float>(vy - top));
+        }
+        cell.centroidX = static_cast<float>(cx - left);
+        cell.centroidY = static_cast<float>(cy - top);
+
+        const double pick = random.Next();
+        cell.classId = pick < 0.40 ? 0 : pick < 0.65 ? 1 : pick < 0.85 ? 2 : pick < 0.90 ? 3 : 4;
+        cell.confidence = static_cast<float>(0.5 + 0.5 * random.Next());
+        cells.push_back(cell);
+    }
+}
+
+const char* SyntheticCells::GetClassName(int32_t classId) {
+    static const char* const NAMES[CLASS_COUNT] = {"Tumor", "Lymphocyte", "Stroma", "Necrosis", "Other"};
+    return classId >= 0 && classId < CLASS_COUNT ? NAMES[classId] : "Unknown";
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SlideLoader.h"  // For LevelDimensions
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a synthetic:// path asks for:
+//   synthetic://WIDTHxHEIGHT?levels=N&tile=T&latency_us=U&seed=S
+// Every query key is optional. levels = 0 halves the slide until it fits
+// one tile.
+struct SyntheticSlideSpec {
+    int64_t width = 100000;
+    int64_t height = 80000;
+    int32_t levels = 0;
+    int32_t tileSize = 256;
+    int64_t latencyUs = 0;  // Per tile read
+    uint64_t seed = 1;
+
+    // False with error set if path is not a well-formed synthetic:// path
+    static bool Parse(const std::string& path, SyntheticSlideSpec& spec, std::string& error);
+
+    static constexpr int64_t MAX_DIMENSION = 4000000;
+    static constexpr int32_t MAX_LEVELS = 24;
+    static constexpr int32_t MIN_TILE_SIZE = 16;
+    static constexpr int32_t MAX_TILE_SIZE = 4096;
+    static constexpr int64_t MAX_LATENCY_US = 10000000;
+};
+
+// A procedural slide for benchmarks and tests, where patient slides
+// cannot go: an H&E-like texture (pink tissue in a few blobs of value
+// noise, purple nuclei on a jittered grid, white glass elsewhere) that is
+// a pure function of the level 0 position and the seed, so every run and
+// every machine reads the same pixels. Levels halve the slide exactly;
+// each pixel samples the texture at its centre.
+//
+// A read sleeps latency_us for each native tile it touches, standing in
+// for the fetch and decode time of a real format.
+//
+// Thread-safe after construction.
+class SyntheticSlide {
+public:
+    explicit SyntheticSlide(const SyntheticSlideSpec& spec);
+
+    // Whether path starts with PREFIX
+    static bool IsSyntheticPath(const std::string& path);
+
+    const SyntheticSlideSpec& GetSpec() const { return spec_; }
+    std::vector<LevelDimensions> GetLevels() const { return levels_; }
+    double GetLevelDownsample(int32_t level) const;
+
+    // Premultiplied ARGB of a region in level coordinates; pixels outside
+    // the level are transparent
+    void ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height, uint32_t* pixels) const;
+
+    // How much tissue covers level 0 point x, y, 0 (glass) to 1; what the
+    // texture and SyntheticCells place tissue by
+    double GetTissueDensity(double x, double y) const;
+
+    size_t GetTileReadCount() const { return tileReadCount_.load(); }
+
+    static constexpr const char* PREFIX = "synthetic://";
+    // Nominal scan resolution reported as the slide's mpp
+    static constexpr double MICRONS_PER_PIXEL = 0.25;
+
+private:
+    uint32_t ShadePixel(double x, double y) const;
+
+    SyntheticSlideSpec spec_;
+    std::vector<LevelDimensions> levels_;
+    double tissueScale_;  // Level 0 pixels between the coarse noise lattice points
+    mutable std::atomic<size_t> tileReadCount_{0};
+};
+
+// Cell outlines that go with a SyntheticSlide: cellCount nuclei-sized
+// polygons of 8-14 vertices, spread over its tissue in proportion to the
+// tissue density, with a class and a confidence each. Generated one tile
+// of a TILE_SIZE grid at a time, each tile from its own random stream, so
+// millions are written without holding them and every tile is the same
+// whatever else is generated.
+class SyntheticCells {
+public:
+    struct Cell {
+        int32_t classId;
+        float confidence;
+        float centroidX;       // Tile-local, like the vertices
+        float centroidY;
+        uint32_t firstVertex;  // Index of its first x, y pair
+        uint32_t vertexCount;
+    };
+
+    SyntheticCells(const SyntheticSlide& slide, size_t cellCount);
+
+    int64_t GetColumns() const { return columns_; }
+    int64_t GetRows() const { return rows_; }
+    size_t GetCellCount(int64_t column, int64_t row) const { return tileCounts_[row * columns_ + column]; }
+
+    // The cells of one tile; xy receives their x, y pairs in tile pixels
+    // (the tile's origin is column, row times TILE_SIZE)
+    void Generate(int64_t column, int64_t row, std::vector<Cell>& cells, std::vector<float>& xy) const;
+
+    static const char* GetClassName(int32_t classId);
+
+    static constexpr int32_t TILE_SIZE = 2048;
+    static constexpr int32_t CLASS_COUNT = 5;
+
+private:
+    const SyntheticSlide& slide_;
+    int64_t columns_;
+    int64_t rows_;
+    std::vector<uint32_t> tileCounts_;
+};
@@ -1,18 +1,47 @@
 #include "TextureManager.h"
-#include <iostream>
+#include "SdlRenderBackend.h"
+#include "Log.h"
 #include <sstream>
+#include <algorithm>
 
 std::string TileKey::ToString() const {
     std::ostringstream oss;
+    if (slide != 0) {
+        oss << "S" << slide << "_";
+    }
     oss << "L" << level << "_X" << tileX << "_Y" << tileY;
     return oss.str();
 }
 
-TextureManager::TextureManager(SDL_Renderer* renderer)
-    : renderer_(renderer)
+TextureManager::TextureManager(SDL_Renderer* renderer, size_t maxMemoryBytes)
+    : TextureManager(renderer ? new SdlRenderBackend(renderer) : nullptr, maxMemoryBytes)
+{
+    ownedBackend_.reset(backend_);
+}
+
+TextureManager::TextureManager(RenderBackend* backend, size_t maxMemoryBytes)
+    : backend_(backend)
+    , maxMemoryBytes_(maxMemoryBytes)
+    , currentMemoryUsage_(0)
+    , currentFrame_(0)
+    , hitCount_(0)
+    , missCount_(0)
+    , evictionCount_(0)
 {
-    if (!renderer_) {
-        std::cerr << "TextureManager: renderer is null" << std::endl;
+    if (!backend_) {
+        PATHVIEW_LOG_ERROR("TextureManager: backend is null");
+        return;
+    }
+
+    // Atlas pages must fit the backend's texture size limit (0 = unlimited)
+    atlasPageSize_ = ATLAS_PAGE_SIZE;
+    int32_t maxTextureSize = backend_->GetMaxTextureSize();
+    if (maxTextureSize > 0) {
+        atlasPageSize_ = std::min(atlasPageSize_, maxTextureSize);
+    }
+    atlasSlotsPerRow_ = atlasPageSize_ / ATLAS_SLOT_SIZE;
+    if (atlasSlotsPerRow_ == 0) {
+        atlasPageSize_ = 0;
     }
 }
 
@@ -20,82 +49,425 @@ TextureManager::~TextureManager() {
     ClearCache();
 }
 
-SDL_Texture* TextureManager::CreateTexture(const uint32_t* pixels, int32_t width, int32_t height) {
-    if (!renderer_) {
-        std::cerr << "TextureManager: renderer is null" << std::endl;
+RenderTexture* TextureManager::CreateTexture(const uint32_t* pixels, int32_t width, int32_t height) {
+    if (!backend_) {
+        PATHVIEW_LOG_ERROR("TextureManager: backend is null");
         return nullptr;
     }
 
     if (!pixels) {
-        std::cerr << "TextureManager: pixel data is null" << std::endl;
+        PATHVIEW_LOG_ERROR("TextureManager: pixel data is null");
         return nullptr;
     }
 
-    // Create SDL texture
-    SDL_Texture* texture = SDL_CreateTexture(
-        renderer_,
-        SDL_PIXELFORMAT_RGBA32,
-        SDL_TEXTUREACCESS_STATIC,
-        width,
-        height
-    );
-
+    RenderTexture* texture = backend_->CreateTexture(width, height, scaleMode_);
     if (!texture) {
-        std::cerr << "Failed to create texture: " << SDL_GetError() << std::endl;
         return nullptr;
     }
 
     // Upload pixel data
     int pitch = width * sizeof(uint32_t);
-    if (SDL_UpdateTexture(texture, nullptr, pixels, pitch) != 0) {
-        std::cerr << "Failed to update texture: " << SDL_GetError() << std::endl;
-        SDL_DestroyTexture(texture);
+    if (!backend_->UpdateTexture(texture, nullptr, pixels, pitch)) {
+        backend_->DestroyTexture(texture);
         return nullptr;
     }
 
     return texture;
 }
 
-SDL_Texture* TextureManager::GetOrCreateTexture(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height) {
+void TextureManager::ApplyPremultipliedBlendMode(SDL_Texture* texture) {
+    // out = src + dst * (1 - srcAlpha), for both color and alpha
+    static const SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+
+    if (SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+}
+
+void TextureManager::SetScaleMode(SDL_ScaleMode mode) {
+    scaleMode_ = mode;
+    for (const auto& page : atlasPages_) {
+        if (page.texture) {
+            backend_->SetTextureScaleMode(page.texture, mode);
+        }
+    }
+    for (const auto& pair : textureCache_) {
+        if (pair.second.atlasPage < 0) {
+            backend_->SetTextureScaleMode(pair.second.texture, mode);
+        }
+    }
+}
+
+bool TextureManager::SetCompression(TextureCompression compression) {
+    if (!backend_ || !backend_->SupportsCompression(compression)) {
+        PATHVIEW_LOG_WARNING("TextureManager: " << (backend_ ? backend_->GetName() : "no backend")
+                          << " cannot sample " << TextureCompressionName(compression) << " textures");
+        return false;
+    }
+    if (compression != compression_) {
+        ClearCache();
+        compression_ = compression;
+    }
+    return true;
+}
+
+size_t TextureManager::TileMemorySize(int32_t width, int32_t height) const {
+    if (atlasPageSize_ > 0 && width <= ATLAS_SLOT_SIZE && height <= ATLAS_SLOT_SIZE) {
+        return BlockCompressor::CompressedSize(compression_, width, height);
+    }
+    return static_cast<size_t>(width) * height * sizeof(uint32_t);
+}
+
+RenderTexture* TextureManager::GetTexture(const TileKey& key, int32_t* outWidth, int32_t* outHeight,
+                                         SDL_Rect* outSource) {
+    auto it = textureCache_.find(key);
+    if (it == textureCache_.end() || it->second.pendingTicket != 0) {
+        return nullptr;
+    }
+
+    hitCount_++;
+    Touch(it->second);
+
+    if (outWidth) *outWidth = it->second.width;
+    if (outHeight) *outHeight = it->second.height;
+    if (outSource) *outSource = it->second.source;
+    return it->second.texture;
+}
+
+RenderTexture* TextureManager::GetOrCreateTexture(const TileKey& key, const uint32_t* pixels, int32_t width,
+                                                  int32_t height, SDL_Rect* outSource) {
     // Check if texture already exists in cache
     auto it = textureCache_.find(key);
     if (it != textureCache_.end()) {
-        return it->second;
+        if (it->second.pendingTicket != 0) {
+            return nullptr;
+        }
+        hitCount_++;
+        Touch(it->second);
+        if (outSource) *outSource = it->second.source;
+        return it->second.texture;
     }
 
-    // Create new texture
-    SDL_Texture* texture = CreateTexture(pixels, width, height);
-    if (!texture) {
+    missCount_++;
+
+    if (!pixels) {
+        PATHVIEW_LOG_ERROR("TextureManager: pixel data is null");
         return nullptr;
     }
 
-    // Add to cache
-    textureCache_[key] = texture;
+    // Make room before uploading so peak VRAM stays within budget. This
+    // also frees atlas slots for the new tile.
+    size_t textureMemory = TileMemorySize(width, height);
+    EvictToBudget(textureMemory);
 
-    return texture;
+    // Upload, charging the time to this frame's upload budget
+    TextureEntry entry{nullptr, -1, -1, SDL_Rect{0, 0, width, height}, width, height,
+                       textureMemory, currentFrame_, {}};
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!UploadToAtlas(pixels, width, height, entry)) {
+        entry.texture = CreateTexture(pixels, width, height);
+    }
+    frameUploadMs_ += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    frameUploadCount_++;
+    if (!entry.texture) {
+        return nullptr;
+    }
+    if (entry.atlasPage < 0) {
+        textureMemory = entry.memorySize = static_cast<size_t>(width) * height * sizeof(uint32_t);
+    }
+    frameUploadBytes_ += textureMemory;
+
+    // Add to front of LRU list (most recent)
+    lruList_.push_front(key);
+    entry.lruIterator = lruList_.begin();
+    textureCache_.emplace(key, entry);
+    currentMemoryUsage_ += textureMemory;
+
+    if (outSource) *outSource = entry.source;
+    return entry.texture;
+}
+
+bool TextureManager::QueueTexture(const TileKey& key, std::shared_ptr<const void> owner, const uint32_t* pixels,
+                                  int32_t width, int32_t height) {
+    if (!HasAsyncUploads() || !pixels) {
+        return false;
+    }
+    if (textureCache_.count(key) > 0) {
+        return true;
+    }
+
+    size_t textureMemory = TileMemorySize(width, height);
+    EvictToBudget(textureMemory);
+
+    TextureEntry entry{nullptr, -1, -1, SDL_Rect{0, 0, width, height}, width, height,
+                       textureMemory, currentFrame_, {}};
+    if (!AllocateAtlasSlot(width, height, entry)) {
+        return false;
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    uint64_t ticket = ++lastUploadTicket_;
+    bool queued = backend_->QueueUpload(entry.texture, entry.source, std::move(owner), pixels,
+                                        width * sizeof(uint32_t), ticket);
+    frameUploadMs_ += (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (!queued) {
+        ReleaseEntry(entry);
+        return false;
+    }
+    frameUploadCount_++;
+    frameUploadBytes_ += textureMemory;
+
+    entry.pendingTicket = ticket;
+    pendingUploads_.emplace(ticket, key);
+    lruList_.push_front(key);
+    entry.lruIterator = lruList_.begin();
+    textureCache_.emplace(key, entry);
+    currentMemoryUsage_ += textureMemory;
+    return true;
+}
+
+bool TextureManager::IsUploadPending(const TileKey& key) const {
+    auto it = textureCache_.find(key);
+    return it != textureCache_.end() && it->second.pendingTicket != 0;
+}
+
+bool TextureManager::UploadToAtlas(const uint32_t* pixels, int32_t width, int32_t height, TextureEntry& entry) {
+    if (!AllocateAtlasSlot(width, height, entry)) {
+        return false;
+    }
+
+    int pitch = width * sizeof(uint32_t);
+    if (!backend_->UpdateTexture(entry.texture, &entry.source, pixels, pitch)) {
+        ReleaseEntry(entry);
+        entry.texture = nullptr;
+        entry.atlasPage = -1;
+        entry.atlasSlot = -1;
+        return false;
+    }
+    return true;
+}
+
+bool TextureManager::AllocateAtlasSlot(int32_t width, int32_t height, TextureEntry& entry) {
+    if (atlasPageSize_ == 0 || width > ATLAS_SLOT_SIZE || height > ATLAS_SLOT_SIZE) {
+        return false;
+    }
+
+    // First page with a free slot, reusing released page indices
+    int32_t pageIndex = -1;
+    int32_t emptyIndex = -1;
+    for (size_t i = 0; i < atlasPages_.size(); ++i) {
+        if (atlasPages_[i].texture && !atlasPages_[i].freeSlots.empty()) {
+            pageIndex = static_cast<int32_t>(i);
+            break;
+        }
+        if (!atlasPages_[i].texture && emptyIndex < 0) {
+            emptyIndex = static_cast<int32_t>(i);
+        }
+    }
+
+    if (pageIndex < 0) {
+        RenderTexture* texture = backend_->CreateCompressedTexture(atlasPageSize_, atlasPageSize_, scaleMode_,
+                                                                   compression_);
+        if (!texture) {
+            PATHVIEW_LOG_ERROR("TextureManager: Cannot create atlas page, using per-tile textures");
+            atlasPageSize_ = 0;
+            return false;
+        }
+
+        if (emptyIndex < 0) {
+            emptyIndex = static_cast<int32_t>(atlasPages_.size());
+            atlasPages_.emplace_back();
+        }
+        pageIndex = emptyIndex;
+
+        // Hand out slots from the top-left
+        AtlasPage& page = atlasPages_[pageIndex];
+        page.texture = texture;
+        page.freeSlots.clear();
+        for (int32_t slot = atlasSlotsPerRow_ * atlasSlotsPerRow_ - 1; slot >= 0; --slot) {
+            page.freeSlots.push_back(slot);
+        }
+    }
+
+    AtlasPage& page = atlasPages_[pageIndex];
+    int32_t slot = page.freeSlots.back();
+    SDL_Rect rect = {(slot % atlasSlotsPerRow_) * ATLAS_SLOT_SIZE,
+                     (slot / atlasSlotsPerRow_) * ATLAS_SLOT_SIZE,
+                     width, height};
+    page.freeSlots.pop_back();
+    entry.texture = page.texture;
+    entry.atlasPage = pageIndex;
+    entry.atlasSlot = slot;
+    entry.source = rect;
+    return true;
+}
+
+void TextureManager::ReleaseEntry(const TextureEntry& entry) {
+    if (entry.pendingTicket != 0) {
+        pendingUploads_.erase(entry.pendingTicket);
+    }
+    if (entry.atlasPage < 0) {
+        backend_->DestroyTexture(entry.texture);
+        return;
+    }
+
+    AtlasPage& page = atlasPages_[entry.atlasPage];
+    page.freeSlots.push_back(entry.atlasSlot);
+
+    // Return the VRAM of pages nothing lives in any more
+    if (page.freeSlots.size() == static_cast<size_t>(atlasSlotsPerRow_ * atlasSlotsPerRow_)) {
+        backend_->DestroyTexture(page.texture);
+        page.texture = nullptr;
+        page.freeSlots.clear();
+    }
+}
+
+size_t TextureManager::GetAtlasPageCount() const {
+    return static_cast<size_t>(std::count_if(atlasPages_.begin(), atlasPages_.end(),
+                                             [](const AtlasPage& page) { return page.texture != nullptr; }));
 }
 
-void TextureManager::DestroyTexture(SDL_Texture* texture) {
+void TextureManager::RemoveTexture(const TileKey& key) {
+    auto it = textureCache_.find(key);
+    if (it == textureCache_.end()) {
+        return;
+    }
+
+    currentMemoryUsage_ -= it->second.memorySize;
+    lruList_.erase(it->second.lruIterator);
+    TextureEntry entry = it->second;
+    textureCache_.erase(it);
+    ReleaseEntry(entry);
+}
+
+void TextureManager::DestroyTexture(RenderTexture* texture) {
     if (!texture) {
         return;
     }
 
-    // Remove from cache if present
-    for (auto it = textureCache_.begin(); it != textureCache_.end(); ++it) {
-        if (it->second == texture) {
-            textureCache_.erase(it);
-            break;
+    // Remove every tile stored in it; the last one destroys an atlas page
+    bool cached = false;
+    for (auto it = textureCache_.begin(); it != textureCache_.end();) {
+        if (it->second.texture != texture) {
+            ++it;
+            continue;
         }
+        cached = true;
+        currentMemoryUsage_ -= it->second.memorySize;
+        lruList_.erase(it->second.lruIterator);
+        TextureEntry entry = it->second;
+        it = textureCache_.erase(it);
+        ReleaseEntry(entry);
     }
 
-    SDL_DestroyTexture(texture);
+    if (!cached) {
+        backend_->DestroyTexture(texture);
+    }
 }
 
 void TextureManager::ClearCache() {
     for (auto& pair : textureCache_) {
-        if (pair.second) {
-            SDL_DestroyTexture(pair.second);
+        if (pair.second.texture && pair.second.atlasPage < 0) {
+            backend_->DestroyTexture(pair.second.texture);
         }
     }
+    for (auto& page : atlasPages_) {
+        if (page.texture) {
+            backend_->DestroyTexture(page.texture);
+        }
+    }
+    atlasPages_.clear();
     textureCache_.clear();
+    lruList_.clear();
+    pendingUploads_.clear();
+    currentMemoryUsage_ = 0;
+}
+
+void TextureManager::BeginFrame() {
+    currentFrame_++;
+    frameUploadCount_ = 0;
+    frameUploadBytes_ = 0;
+    frameUploadMs_ = 0.0;
+
+    // Always polled: the backend also retires uploads of evicted tiles here
+    if (HasAsyncUploads()) {
+        std::vector<uint64_t> completed;
+        backend_->PollUploads(&completed);
+        for (uint64_t ticket : completed) {
+            auto pending = pendingUploads_.find(ticket);
+            if (pending == pendingUploads_.end()) {
+                continue;
+            }
+            auto it = textureCache_.find(pending->second);
+            if (it != textureCache_.end() && it->second.pendingTicket == ticket) {
+                it->second.pendingTicket = 0;
+            }
+            pendingUploads_.erase(pending);
+        }
+    }
+
+    // Trim any overshoot left by a frame that needed more than the budget
+    EvictToBudget(0);
+}
+
+void TextureManager::SetMaxMemory(size_t maxMemoryBytes) {
+    maxMemoryBytes_ = maxMemoryBytes;
+    EvictToBudget(0);
+}
+
+void TextureManager::SetUploadBudget(size_t maxBytesPerFrame, double maxMsPerFrame) {
+    uploadBudgetBytes_ = maxBytesPerFrame;
+    uploadBudgetMs_ = maxMsPerFrame;
+}
+
+bool TextureManager::HasUploadBudget(size_t incomingBytes) const {
+    if (frameUploadCount_ == 0) {
+        return true;
+    }
+    if (uploadBudgetBytes_ > 0 && frameUploadBytes_ + incomingBytes > uploadBudgetBytes_) {
+        return false;
+    }
+    if (uploadBudgetMs_ > 0.0 && frameUploadMs_ >= uploadBudgetMs_) {
+        return false;
+    }
+    return true;
+}
+
+size_t TextureManager::Trim(size_t bytes) {
+    size_t before = currentMemoryUsage_;
+    EvictDownTo(before > bytes ? before - bytes : 0);
+    return before - currentMemoryUsage_;
+}
+
+void TextureManager::EvictToBudget(size_t incomingBytes) {
+    EvictDownTo(maxMemoryBytes_ > incomingBytes ? maxMemoryBytes_ - incomingBytes : 0);
+}
+
+void TextureManager::EvictDownTo(size_t targetBytes) {
+    while (!lruList_.empty() && currentMemoryUsage_ > targetBytes) {
+        const TileKey& lruKey = lruList_.back();
+        auto it = textureCache_.find(lruKey);
+
+        if (it == textureCache_.end()) {
+            lruList_.pop_back();
+            continue;
+        }
+
+        // Everything older has already been evicted; the rest is on screen
+        if (it->second.lastUsedFrame == currentFrame_) {
+            break;
+        }
+
+        ReleaseEntry(it->second);
+        currentMemoryUsage_ -= it->second.memorySize;
+        textureCache_.erase(it);
+        lruList_.pop_back();
+        evictionCount_++;
+    }
+}
+
+void TextureManager::Touch(TextureEntry& entry) {
+    entry.lastUsedFrame = currentFrame_;
+    lruList_.splice(lruList_.begin(), lruList_, entry.lruIterator);
 }
@@ -1,60 +1,214 @@
 #pragma once
 
+#include "FlatTileMap.h"
+#include "RenderBackend.h"
+#include "TileKey.h"
 #include <SDL2/SDL.h>
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <list>
+#include <vector>
 #include <string>
 
-struct TileKey {
-    int32_t level;
-    int32_t tileX;
-    int32_t tileY;
-
-    bool operator==(const TileKey& other) const {
-        return level == other.level && tileX == other.tileX && tileY == other.tileY;
-    }
-
-    bool operator<(const TileKey& other) const {
-        if (level != other.level) return level < other.level;
-        if (tileX != other.tileX) return tileX < other.tileX;
-        return tileY < other.tileY;
-    }
-
-    std::string ToString() const;
-};
-
-// Hash function for TileKey
-struct TileKeyHash {
-    size_t operator()(const TileKey& k) const {
-        return ((size_t)k.level << 48) | ((size_t)k.tileX << 24) | (size_t)k.tileY;
-    }
+// GPU texture cache entry with LRU metadata
+struct TextureEntry {
+    RenderTexture* texture;                       // Atlas page, or the tile's own texture
+    int32_t atlasPage;                            // Page index, -1 if the tile owns its texture
+    int32_t atlasSlot;
+    SDL_Rect source;                              // Tile pixels within texture
+    int32_t width;
+    int32_t height;
+    size_t memorySize;                            // Estimated VRAM usage in bytes
+    uint64_t lastUsedFrame;                       // Frame in which the texture was last drawn
+    std::list<TileKey>::iterator lruIterator;
+    uint64_t pendingTicket = 0;                   // Queued upload not drawable yet, 0 once it is
 };
 
 class TextureManager {
 public:
-    explicit TextureManager(SDL_Renderer* renderer);
+    // Textures live in backend (not owned), which must outlive the manager
+    explicit TextureManager(RenderBackend* backend,
+                            size_t maxMemoryBytes = 256 * 1024 * 1024); // Default: 256MB VRAM
+    // On an SdlRenderBackend of its own
+    explicit TextureManager(SDL_Renderer* renderer,
+                            size_t maxMemoryBytes = 256 * 1024 * 1024);
     ~TextureManager();
 
     // Delete copy, allow move
     TextureManager(const TextureManager&) = delete;
     TextureManager& operator=(const TextureManager&) = delete;
 
-    // Create texture from RGBA pixel data
-    SDL_Texture* CreateTexture(const uint32_t* pixels, int32_t width, int32_t height);
+    // Tile pixels are kept exactly as OpenSlide decodes them: native-endian
+    // 0xAARRGGBB words with premultiplied alpha. Uploading in this format
+    // means no per-pixel conversion on the worker threads.
+    static constexpr Uint32 TILE_PIXEL_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+
+    // Blend a texture holding premultiplied alpha correctly. Falls back to
+    // standard alpha blending on renderers without custom blend modes.
+    static void ApplyPremultipliedBlendMode(SDL_Texture* texture);
+
+    // Sampling used when tiles are drawn scaled (SDL_ScaleModeNearest by
+    // default). Applies to resident and future tile textures.
+    void SetScaleMode(SDL_ScaleMode mode);
+    SDL_ScaleMode GetScaleMode() const { return scaleMode_; }
+
+    // Keep atlas tiles block-compressed on the GPU: BC7 fits 4x the tiles
+    // in the same VRAM budget, BC1 8x, at the cost of compressing each tile
+    // on upload (on the backend's upload threads where it has them). Tiles
+    // too large for an atlas slot stay uncompressed. False, leaving the
+    // setting as it was, if the backend cannot sample the format; a change
+    // drops every cached texture.
+    bool SetCompression(TextureCompression compression);
+    TextureCompression GetCompression() const { return compression_; }
+
+    // Backend the textures belong to; draw them through it
+    RenderBackend* GetBackend() const { return backend_; }
+
+    // Create texture from TILE_PIXEL_FORMAT pixel data (not tracked by the
+    // cache; free with the backend's DestroyTexture)
+    RenderTexture* CreateTexture(const uint32_t* pixels, int32_t width, int32_t height);
+
+    // Tiles are packed into shared atlas pages so a frame's tiles can be
+    // drawn with one DrawGeometry call per page. The texture returned
+    // for a tile is therefore usually a page: draw only its outSource rect.
+    // Tiles larger than a slot get a texture of their own.
+
+    // Look up a cached tile texture without uploading anything.
+    // Returns nullptr on miss; on hit, marks the texture as used this frame.
+    RenderTexture* GetTexture(const TileKey& key, int32_t* outWidth = nullptr, int32_t* outHeight = nullptr,
+                              SDL_Rect* outSource = nullptr);
 
     // Get or create texture for a tile
-    SDL_Texture* GetOrCreateTexture(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height);
+    RenderTexture* GetOrCreateTexture(const TileKey& key, const uint32_t* pixels, int32_t width, int32_t height,
+                                      SDL_Rect* outSource = nullptr);
+
+    bool HasTexture(const TileKey& key) const { return textureCache_.count(key) > 0; }
+
+    // Asynchronous uploads (RenderBackend::HasAsyncUploads): QueueTexture
+    // reserves an atlas slot for the tile and hands its pixels to the
+    // backend without waiting for the copy. owner keeps the pixels alive
+    // until then. The tile stays pending, and GetTexture() and
+    // GetOrCreateTexture() return nullptr for it, until a BeginFrame()
+    // finds the upload done. False if the backend could not queue it; the
+    // tile is then not cached and GetOrCreateTexture() uploads it.
+    bool HasAsyncUploads() const { return backend_ && backend_->HasAsyncUploads(); }
+    bool QueueTexture(const TileKey& key, std::shared_ptr<const void> owner, const uint32_t* pixels,
+                      int32_t width, int32_t height);
+    bool IsUploadPending(const TileKey& key) const;
+
+    // Drop one tile's texture (freeing its atlas slot)
+    void RemoveTexture(const TileKey& key);
 
-    // Destroy a specific texture
-    void DestroyTexture(SDL_Texture* texture);
+    // Destroy a texture and every cached tile that lives in it
+    void DestroyTexture(RenderTexture* texture);
 
     // Clear all cached textures
     void ClearCache();
 
+    // Mark the start of a render frame. Textures drawn in the current frame
+    // are never evicted, so a viewport larger than the budget still renders
+    // completely; the overshoot is trimmed on the following frames. Also
+    // makes the tiles whose queued uploads finished drawable.
+    void BeginFrame();
+
+    // VRAM budget
+    void SetMaxMemory(size_t maxMemoryBytes);
+
+    // Evict least recently used textures until at least bytes are freed,
+    // sparing those drawn in the current frame. Returns the bytes freed.
+    size_t Trim(size_t bytes);
+
+    // Per-frame upload budget, so a burst of newly decoded tiles is spread
+    // over several frames instead of stalling one. Either limit may be 0 to
+    // disable it. GetOrCreateTexture() always uploads; callers check
+    // HasUploadBudget() first for uploads that can wait a frame.
+    void SetUploadBudget(size_t maxBytesPerFrame, double maxMsPerFrame);
+
+    // True if an upload of incomingBytes fits what is left of this frame's
+    // budget. The first upload of a frame always fits, so progress is made
+    // even when a single tile exceeds the budget.
+    bool HasUploadBudget(size_t incomingBytes) const;
+
+    size_t GetFrameUploadCount() const { return frameUploadCount_; }
+    size_t GetFrameUploadBytes() const { return frameUploadBytes_; }
+    double GetFrameUploadMs() const { return frameUploadMs_; }
+
+    static constexpr size_t DEFAULT_UPLOAD_BYTES_PER_FRAME = 8 * 1024 * 1024;  // 8 full 512x512 tiles
+    static constexpr double DEFAULT_UPLOAD_MS_PER_FRAME = 4.0;
+
+    // Atlas geometry: pages of ATLAS_PAGE_SIZE^2 (smaller if the renderer
+    // caps texture size) split into slots of one full slide tile each.
+    // Slots have no gutter: with linear sampling, callers keep texture
+    // coordinates half a texel inside the slot.
+    static constexpr int32_t ATLAS_PAGE_SIZE = 4096;
+    static constexpr int32_t ATLAS_SLOT_SIZE = 512;
+
     // Get cache statistics
     size_t GetCacheSize() const { return textureCache_.size(); }
+    size_t GetMemoryUsage() const { return currentMemoryUsage_; }
+    size_t GetMaxMemory() const { return maxMemoryBytes_; }
+    size_t GetHitCount() const { return hitCount_; }
+    size_t GetMissCount() const { return missCount_; }
+    size_t GetEvictionCount() const { return evictionCount_; }
+    size_t GetAtlasPageCount() const;
+    double GetHitRate() const {
+        size_t total = hitCount_ + missCount_;
+        return total > 0 ? static_cast<double>(hitCount_) / total : 0.0;
+    }
 
 private:
-    SDL_Renderer* renderer_;
-    std::unordered_map<TileKey, SDL_Texture*, TileKeyHash> textureCache_;
+    // Evict least recently used textures until usage fits the budget.
+    // Stops early if only textures drawn in the current frame remain.
+    void EvictToBudget(size_t incomingBytes);
+    void EvictDownTo(size_t targetBytes);
+    void Touch(TextureEntry& entry);
+
+    // VRAM a tile will take: compressed in an atlas slot, RGBA otherwise
+    size_t TileMemorySize(int32_t width, int32_t height) const;
+
+    // Place a tile in a free atlas slot (creating a page if all are full)
+    // and upload its pixels. Returns false if the tile does not fit a slot
+    // or no page could be created.
+    bool UploadToAtlas(const uint32_t* pixels, int32_t width, int32_t height, TextureEntry& entry);
+
+    // The slot part of UploadToAtlas: fills entry's texture, page, slot
+    // and source without uploading anything
+    bool AllocateAtlasSlot(int32_t width, int32_t height, TextureEntry& entry);
+
+    // Free the entry's slot or texture; a page is destroyed once empty
+    void ReleaseEntry(const TextureEntry& entry);
+
+    struct AtlasPage {
+        RenderTexture* texture = nullptr;         // nullptr once released
+        std::vector<int32_t> freeSlots;
+    };
+
+    std::unique_ptr<RenderBackend> ownedBackend_;
+    RenderBackend* backend_;
+    std::vector<AtlasPage> atlasPages_;
+    int32_t atlasPageSize_ = 0;                   // 0 disables the atlas
+    int32_t atlasSlotsPerRow_ = 0;
+    SDL_ScaleMode scaleMode_ = SDL_ScaleModeNearest;
+    TextureCompression compression_ = TextureCompression::None;
+    FlatTileMap<TextureEntry> textureCache_;
+    std::list<TileKey> lruList_;  // Front = most recent, back = least recent
+    std::unordered_map<uint64_t, TileKey> pendingUploads_;  // Ticket -> tile
+    uint64_t lastUploadTicket_ = 0;
+
+    size_t maxMemoryBytes_;
+    size_t currentMemoryUsage_;
+    uint64_t currentFrame_;
+
+    // Upload budget and this frame's usage of it
+    size_t uploadBudgetBytes_ = DEFAULT_UPLOAD_BYTES_PER_FRAME;
+    double uploadBudgetMs_ = DEFAULT_UPLOAD_MS_PER_FRAME;
+    size_t frameUploadCount_ = 0;
+    size_t frameUploadBytes_ = 0;
+    double frameUploadMs_ = 0.0;
+
+    // Statistics (render thread only)
+    size_t hitCount_;
+    size_t missCount_;
+    size_t evictionCount_;
 };
@@ -0,0 +1,96 @@
+#include "ThreadScheduling.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#else
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool ThreadScheduling::LowerCurrentThreadPriority() {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL) != 0;
+#elif defined(__APPLE__)
+    return pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0) == 0;
+#else
+    // Both are per thread on Linux. SCHED_BATCH tells the scheduler the
+    // thread is throughput work it may preempt less eagerly for; the nice
+    // value is what keeps it behind the render thread.
+    sched_param param{};
+    bool batch = sched_setscheduler(0, SCHED_BATCH, &param) == 0;
+    // Never raises a thread the user already niced further
+    id_t thread = static_cast<id_t>(syscall(SYS_gettid));
+    errno = 0;
+    int current = getpriority(PRIO_PROCESS, thread);
+    bool niced = errno == 0 && setpriority(PRIO_PROCESS, thread, std::max(current, BACKGROUND_NICE)) == 0;
+    return batch || niced;
+#endif
+}
+
+std::vector<size_t> ThreadScheduling::WorkerCores(const std::vector<size_t>& allowed, size_t reservedCores) {
+    if (reservedCores >= allowed.size()) {
+        return {};
+    }
+    return std::vector<size_t>(allowed.begin() + static_cast<std::ptrdiff_t>(reservedCores), allowed.end());
+}
+
+bool ThreadScheduling::ReserveCoresFromCurrentThread(size_t reservedCores) {
+    if (reservedCores == 0) {
+        return true;
+    }
+#ifdef _WIN32
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        return false;
+    }
+    std::vector<size_t> allowed;
+    for (size_t core = 0; core < sizeof(DWORD_PTR) * 8; ++core) {
+        if (processMask & (static_cast<DWORD_PTR>(1) << core)) {
+            allowed.push_back(core);
+        }
+    }
+    std::vector<size_t> cores = WorkerCores(allowed, reservedCores);
+    if (cores.empty()) {
+        return false;
+    }
+    DWORD_PTR mask = 0;
+    for (size_t core : cores) {
+        mask |= static_cast<DWORD_PTR>(1) << core;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__APPLE__)
+    // Affinity tags are only hints, and Apple silicon ignores them
+    return false;
+#else
+    cpu_set_t current;
+    CPU_ZERO(&current);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(current), &current) != 0) {
+        return false;
+    }
+    std::vector<size_t> allowed;
+    for (size_t core = 0; core < CPU_SETSIZE; ++core) {
+        if (CPU_ISSET(core, &current)) {
+            allowed.push_back(core);
+        }
+    }
+    std::vector<size_t> cores = WorkerCores(allowed, reservedCores);
+    if (cores.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t core : cores) {
+        CPU_SET(core, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
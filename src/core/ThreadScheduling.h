@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// OS scheduling of background threads (tile decode and read-ahead), so
+// decode bursts yield to the render thread on machines with few cores.
+//
+// Each call applies to the calling thread only, so a pool calls them at
+// the top of its thread functions. Failures are not fatal: the thread
+// keeps running with the scheduling it had.
+class ThreadScheduling {
+public:
+    // Run the calling thread below the render thread: QoS utility on
+    // macOS, SCHED_BATCH at nice BACKGROUND_NICE on Linux, below normal on
+    // Windows. False if the OS refused.
+    static bool LowerCurrentThreadPriority();
+
+    // Keep the calling thread off the first reservedCores of the cores the
+    // process may run on, leaving them to the render thread. False where
+    // threads have no affinity (macOS) or no core would be left.
+    static bool ReserveCoresFromCurrentThread(size_t reservedCores);
+
+    // The cores a thread restricted by ReserveCoresFromCurrentThread runs
+    // on: allowed without its first reservedCores, or empty if that
+    // leaves none (the thread is then left unrestricted)
+    static std::vector<size_t> WorkerCores(const std::vector<size_t>& allowed, size_t reservedCores);
+
+    static constexpr int BACKGROUND_NICE = 10;
+};
@@ -0,0 +1,258 @@
+#include "TiffPyramidWriter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr uint16_t TYPE_ASCII = 2;
+constexpr uint16_t TYPE_SHORT = 3;
+constexpr uint16_t TYPE_LONG = 4;
+constexpr uint16_t TYPE_RATIONAL = 5;
+constexpr uint16_t TYPE_LONG8 = 16;
+
+constexpr uint16_t TAG_NEW_SUBFILE_TYPE = 254;
+constexpr uint16_t TAG_IMAGE_WIDTH = 256;
+constexpr uint16_t TAG_IMAGE_LENGTH = 257;
+constexpr uint16_t TAG_BITS_PER_SAMPLE = 258;
+constexpr uint16_t TAG_COMPRESSION = 259;
+constexpr uint16_t TAG_PHOTOMETRIC = 262;
+constexpr uint16_t TAG_IMAGE_DESCRIPTION = 270;
+constexpr uint16_t TAG_STRIP_OFFSETS = 273;
+constexpr uint16_t TAG_SAMPLES_PER_PIXEL = 277;
+constexpr uint16_t TAG_ROWS_PER_STRIP = 278;
+constexpr uint16_t TAG_STRIP_BYTE_COUNTS = 279;
+constexpr uint16_t TAG_X_RESOLUTION = 282;
+constexpr uint16_t TAG_Y_RESOLUTION = 283;
+constexpr uint16_t TAG_PLANAR_CONFIG = 284;
+constexpr uint16_t TAG_RESOLUTION_UNIT = 296;
+constexpr uint16_t TAG_TILE_WIDTH = 322;
+constexpr uint16_t TAG_TILE_LENGTH = 323;
+constexpr uint16_t TAG_TILE_OFFSETS = 324;
+constexpr uint16_t TAG_TILE_BYTE_COUNTS = 325;
+constexpr uint16_t TAG_YCBCR_SUBSAMPLING = 530;
+
+constexpr uint32_t COMPRESSION_JPEG = 7;
+constexpr uint32_t PHOTOMETRIC_YCBCR = 6;
+constexpr uint32_t SUBFILE_REDUCED = 1;
+constexpr uint32_t RESOLUTION_UNIT_CENTIMETER = 3;
+
+// BigTIFF: a value of up to 8 bytes sits in the entry itself
+constexpr size_t INLINE_BYTES = 8;
+constexpr size_t ENTRY_BYTES = 20;
+
+struct Entry {
+    uint16_t tag;
+    uint16_t type;
+    uint64_t count;
+    std::vector<uint8_t> data;  // Little-endian values
+    uint64_t offset = 0;        // Where data lives if it does not fit inline
+};
+
+void PutLE(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+Entry Shorts(uint16_t tag, std::initializer_list<uint32_t> values) {
+    Entry entry{tag, TYPE_SHORT, values.size(), {}};
+    for (uint32_t value : values) PutLE(entry.data, value, 2);
+    return entry;
+}
+
+Entry Long(uint16_t tag, uint64_t value) {
+    Entry entry{tag, TYPE_LONG, 1, {}};
+    PutLE(entry.data, value, 4);
+    return entry;
+}
+
+Entry Long8s(uint16_t tag, const std::vector<uint64_t>& values) {
+    Entry entry{tag, TYPE_LONG8, values.size(), {}};
+    entry.data.reserve(values.size() * 8);
+    for (uint64_t value : values) PutLE(entry.data, value, 8);
+    return entry;
+}
+
+Entry Ascii(uint16_t tag, const std::string& text) {
+    Entry entry{tag, TYPE_ASCII, text.size() + 1, {text.begin(), text.end()}};
+    entry.data.push_back(0);
+    return entry;
+}
+
+// Pixels per centimetre, to a thousandth
+Entry Resolution(uint16_t tag, double mpp) {
+    Entry entry{tag, TYPE_RATIONAL, 1, {}};
+    PutLE(entry.data, static_cast<uint64_t>(std::llround(10000.0 / mpp * 1000.0)), 4);
+    PutLE(entry.data, 1000, 4);
+    return entry;
+}
+
+// Tags every directory shares: 8-bit YCbCr JPEG, 2x2 chroma subsampling
+// as libjpeg writes by default
+void AddImageEntries(std::vector<Entry>& entries, uint32_t subfileType, int64_t width, int64_t height) {
+    entries.push_back(Long(TAG_NEW_SUBFILE_TYPE, subfileType));
+    entries.push_back(Long(TAG_IMAGE_WIDTH, static_cast<uint64_t>(width)));
+    entries.push_back(Long(TAG_IMAGE_LENGTH, static_cast<uint64_t>(height)));
+    entries.push_back(Shorts(TAG_BITS_PER_SAMPLE, {8, 8, 8}));
+    entries.push_back(Shorts(TAG_COMPRESSION, {COMPRESSION_JPEG}));
+    entries.push_back(Shorts(TAG_PHOTOMETRIC, {PHOTOMETRIC_YCBCR}));
+    entries.push_back(Shorts(TAG_SAMPLES_PER_PIXEL, {3}));
+    entries.push_back(Shorts(TAG_PLANAR_CONFIG, {1}));
+    entries.push_back(Shorts(TAG_YCBCR_SUBSAMPLING, {2, 2}));
+}
+
+}  // namespace
+
+TiffPyramidWriter::TiffPyramidWriter(const std::string& path)
+    : file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_.is_open()) {
+        return;
+    }
+    // BigTIFF header; the first directory offset is patched by Finish()
+    std::vector<uint8_t> header = {'I', 'I'};
+    PutLE(header, 43, 2);
+    PutLE(header, 8, 2);
+    PutLE(header, 0, 2);
+    PutLE(header, 0, 8);
+    Append(header.data(), header.size());
+}
+
+TiffPyramidWriter::~TiffPyramidWriter() = default;
+
+int32_t TiffPyramidWriter::AddLevel(int64_t width, int64_t height, int32_t tileSize, double mpp,
+                                    const std::string& description) {
+    Level level;
+    level.width = width;
+    level.height = height;
+    level.tileSize = tileSize;
+    level.tilesAcross = (width + tileSize - 1) / tileSize;
+    level.mpp = mpp;
+    level.description = description;
+    size_t tiles = static_cast<size_t>(level.tilesAcross * ((height + tileSize - 1) / tileSize));
+    level.offsets.assign(tiles, 0);
+    level.byteCounts.assign(tiles, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    levels_.push_back(std::move(level));
+    return static_cast<int32_t>(levels_.size() - 1);
+}
+
+uint64_t TiffPyramidWriter::Append(const void* data, size_t size) {
+    uint64_t offset = end_;
+    if (!file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+        failed_ = true;
+    }
+    end_ += size;
+    return offset;
+}
+
+bool TiffPyramidWriter::WriteTile(int32_t level, int64_t column, int64_t row, const std::vector<uint8_t>& jpeg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_ || level < 0 || level >= static_cast<int32_t>(levels_.size())) {
+        return false;
+    }
+    Level& target = levels_[static_cast<size_t>(level)];
+    size_t index = static_cast<size_t>(row * target.tilesAcross + column);
+    if (column < 0 || column >= target.tilesAcross || row < 0 || index >= target.offsets.size()) {
+        return false;
+    }
+    target.offsets[index] = Append(jpeg.data(), jpeg.size());
+    target.byteCounts[index] = jpeg.size();
+    return !failed_;
+}
+
+bool TiffPyramidWriter::WriteThumbnail(int64_t width, int64_t height, const std::vector<uint8_t>& jpeg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thumbnailWidth_ = width;
+    thumbnailHeight_ = height;
+    thumbnailOffset_ = Append(jpeg.data(), jpeg.size());
+    thumbnailSize_ = jpeg.size();
+    return !failed_;
+}
+
+bool TiffPyramidWriter::Finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open() || failed_ || levels_.empty()) {
+        return false;
+    }
+
+    // Entries of every directory, in ascending tag order
+    std::vector<std::vector<Entry>> directories;
+    for (size_t i = 0; i < levels_.size(); ++i) {
+        const Level& level = levels_[i];
+        std::vector<Entry> entries;
+        AddImageEntries(entries, i == 0 ? 0 : SUBFILE_REDUCED, level.width, level.height);
+        if (!level.description.empty()) {
+            entries.push_back(Ascii(TAG_IMAGE_DESCRIPTION, level.description));
+        }
+        if (level.mpp > 0.0) {
+            entries.push_back(Resolution(TAG_X_RESOLUTION, level.mpp));
+            entries.push_back(Resolution(TAG_Y_RESOLUTION, level.mpp));
+            entries.push_back(Shorts(TAG_RESOLUTION_UNIT, {RESOLUTION_UNIT_CENTIMETER}));
+        }
+        entries.push_back(Long(TAG_TILE_WIDTH, static_cast<uint64_t>(level.tileSize)));
+        entries.push_back(Long(TAG_TILE_LENGTH, static_cast<uint64_t>(level.tileSize)));
+        entries.push_back(Long8s(TAG_TILE_OFFSETS, level.offsets));
+        entries.push_back(Long8s(TAG_TILE_BYTE_COUNTS, level.byteCounts));
+        directories.push_back(std::move(entries));
+    }
+    if (thumbnailSize_ > 0) {
+        std::vector<Entry> entries;
+        AddImageEntries(entries, SUBFILE_REDUCED, thumbnailWidth_, thumbnailHeight_);
+        entries.push_back(Long8s(TAG_STRIP_OFFSETS, {thumbnailOffset_}));
+        entries.push_back(Long(TAG_ROWS_PER_STRIP, static_cast<uint64_t>(thumbnailHeight_)));
+        entries.push_back(Long8s(TAG_STRIP_BYTE_COUNTS, {thumbnailSize_}));
+        directories.push_back(std::move(entries));
+    }
+
+    // Out-of-line values first, then the directories back to back (on a
+    // word boundary) so each one's next offset is known when it is written
+    for (auto& entries : directories) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+        for (Entry& entry : entries) {
+            if (entry.data.size() > INLINE_BYTES) {
+                if (end_ % 2 != 0) {
+                    uint8_t pad = 0;
+                    Append(&pad, 1);
+                }
+                entry.offset = Append(entry.data.data(), entry.data.size());
+            }
+        }
+    }
+    if (end_ % 2 != 0) {
+        uint8_t pad = 0;
+        Append(&pad, 1);
+    }
+    uint64_t firstDirectory = end_;
+    uint64_t next = firstDirectory;
+    for (size_t i = 0; i < directories.size(); ++i) {
+        const auto& entries = directories[i];
+        next += 8 + entries.size() * ENTRY_BYTES + 8;
+        std::vector<uint8_t> bytes;
+        PutLE(bytes, entries.size(), 8);
+        for (const Entry& entry : entries) {
+            PutLE(bytes, entry.tag, 2);
+            PutLE(bytes, entry.type, 2);
+            PutLE(bytes, entry.count, 8);
+            if (entry.data.size() > INLINE_BYTES) {
+                PutLE(bytes, entry.offset, 8);
+            } else {
+                bytes.insert(bytes.end(), entry.data.begin(), entry.data.end());
+                bytes.resize(bytes.size() + INLINE_BYTES - entry.data.size(), 0);
+            }
+        }
+        PutLE(bytes, i + 1 < directories.size() ? next : 0, 8);
+        Append(bytes.data(), bytes.size());
+    }
+
+    std::vector<uint8_t> pointer;
+    PutLE(pointer, firstDirectory, 8);
+    file_.seekp(8);
+    file_.write(reinterpret_cast<const char*>(pointer.data()), static_cast<std::streamsize>(pointer.size()));
+    file_.close();
+    if (file_.fail()) {
+        failed_ = true;
+    }
+    return !failed_;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Writes a tiled pyramidal BigTIFF the way TiffTileReader and OpenSlide's
+// generic-tiff driver read it: one tiled JPEG (YCbCr 4:2:0) directory per
+// level, largest first, then an optional single-strip thumbnail directory
+// that neither counts as a level.
+//
+// Levels are declared up front; tiles are then appended in any order as
+// they are encoded, from any thread, and only their offsets are kept, so
+// memory stays at a few bytes per tile whatever the slide size. Finish()
+// writes the directories after the tile data and links them from the
+// header. Tiles never written read as empty.
+class TiffPyramidWriter {
+public:
+    explicit TiffPyramidWriter(const std::string& path);
+    ~TiffPyramidWriter();
+
+    TiffPyramidWriter(const TiffPyramidWriter&) = delete;
+    TiffPyramidWriter& operator=(const TiffPyramidWriter&) = delete;
+
+    bool IsOpen() const { return file_.is_open() && !failed_; }
+
+    // Declare the next level and return its index. The description goes
+    // in ImageDescription; mpp (0: unknown) becomes the resolution tags.
+    int32_t AddLevel(int64_t width, int64_t height, int32_t tileSize, double mpp = 0.0,
+                     const std::string& description = {});
+
+    // Append one JPEG tile (a complete stream, tables included).
+    // Thread-safe. Returns false if the file cannot be written.
+    bool WriteTile(int32_t level, int64_t column, int64_t row, const std::vector<uint8_t>& jpeg);
+
+    // JPEG of the whole image at width x height, written as a stripped
+    // reduced-resolution directory after the levels
+    bool WriteThumbnail(int64_t width, int64_t height, const std::vector<uint8_t>& jpeg);
+
+    // Write the directories and close the file
+    bool Finish();
+
+    uint64_t GetBytesWritten() const { return end_; }
+
+private:
+    struct Level {
+        int64_t width = 0;
+        int64_t height = 0;
+        int32_t tileSize = 0;
+        int64_t tilesAcross = 0;
+        double mpp = 0.0;
+        std::string description;
+        std::vector<uint64_t> offsets;
+        std::vector<uint64_t> byteCounts;
+    };
+
+    // Data at the end of the file; returns its offset
+    uint64_t Append(const void* data, size_t size);
+
+    std::ofstream file_;
+    std::mutex mutex_;
+    std::vector<Level> levels_;
+    int64_t thumbnailWidth_ = 0;
+    int64_t thumbnailHeight_ = 0;
+    uint64_t thumbnailOffset_ = 0;
+    uint64_t thumbnailSize_ = 0;
+    uint64_t end_ = 0;
+    bool failed_ = false;
+};
@@ -0,0 +1,1513 @@
+#include "TiffTileReader.h"
+#include "AsyncFileReader.h"
+#include "DicomFrameIndex.h"
+#include "JpegBatchDecoder.h"
+#include "RemoteFile.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <csetjmp>
+#include <cstdio>  // jpeglib.h needs FILE
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+// Baseline TIFF and TIFF 6.0 tags
+constexpr uint16_t TAG_IMAGE_WIDTH = 256;
+constexpr uint16_t TAG_IMAGE_LENGTH = 257;
+constexpr uint16_t TAG_BITS_PER_SAMPLE = 258;
+constexpr uint16_t TAG_COMPRESSION = 259;
+constexpr uint16_t TAG_PHOTOMETRIC = 262;
+constexpr uint16_t TAG_IMAGE_DESCRIPTION = 270;
+constexpr uint16_t TAG_SAMPLES_PER_PIXEL = 277;
+constexpr uint16_t TAG_PLANAR_CONFIG = 284;
+constexpr uint16_t TAG_PREDICTOR = 317;
+constexpr uint16_t TAG_TILE_WIDTH = 322;
+constexpr uint16_t TAG_TILE_LENGTH = 323;
+constexpr uint16_t TAG_TILE_OFFSETS = 324;
+constexpr uint16_t TAG_TILE_BYTE_COUNTS = 325;
+constexpr uint16_t TAG_SUB_IFDS = 330;
+constexpr uint16_t TAG_JPEG_TABLES = 347;
+
+constexpr uint32_t COMPRESSION_NONE = 1;
+constexpr uint32_t COMPRESSION_JPEG = 7;
+constexpr uint32_t COMPRESSION_DEFLATE = 8;
+constexpr uint32_t COMPRESSION_ADOBE_DEFLATE = 32946;
+constexpr uint32_t PHOTOMETRIC_RGB = 2;
+constexpr uint32_t PHOTOMETRIC_YCBCR = 6;
+constexpr uint32_t PREDICTOR_HORIZONTAL = 2;
+
+// Hinted ranges closer than this are merged into one call
+constexpr uint64_t PREWARM_MERGE_GAP = 64 * 1024;
+
+// Tile bytes LoadRegionTiles read in one batch for the region read in
+// progress on this thread; ReadAt serves them while a StagedRegion lives
+struct StagedTile {
+    uint64_t offset = 0;
+    std::vector<uint8_t> bytes;
+};
+thread_local std::vector<StagedTile> stagedTiles;
+thread_local size_t stagedCount = 0;
+
+class StagedRegion {
+public:
+    StagedRegion() = default;
+    ~StagedRegion() { stagedCount = 0; }
+    StagedRegion(const StagedRegion&) = delete;
+    StagedRegion& operator=(const StagedRegion&) = delete;
+};
+
+// Guards against corrupt or hostile files
+constexpr size_t MAX_DIRECTORIES = 256;
+constexpr uint64_t MAX_DIRECTORY_ENTRIES = 4096;
+constexpr size_t MAX_ENTRY_BYTES = 256 * 1024 * 1024;
+constexpr uint64_t MAX_TILE_BYTES = 64 * 1024 * 1024;
+constexpr int64_t MAX_TILE_DIMENSION = 8192;
+constexpr size_t MAX_DESCRIPTION_BYTES = 4 * 1024 * 1024;  // OME-XML of large plates
+
+size_t TypeSize(uint16_t type) {
+    switch (type) {
+        case 1:   // BYTE
+        case 2:   // ASCII
+        case 6:   // SBYTE
+        case 7:   // UNDEFINED
+            return 1;
+        case 3:   // SHORT
+        case 8:   // SSHORT
+            return 2;
+        case 4:   // LONG
+        case 9:   // SLONG
+        case 11:  // FLOAT
+        case 13:  // IFD
+            return 4;
+        case 5:   // RATIONAL
+        case 10:  // SRATIONAL
+        case 12:  // DOUBLE
+        case 16:  // LONG8
+        case 17:  // SLONG8
+        case 18:  // IFD8
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Text of the first <element>...</element> in xml, or empty
+std::string XmlElementText(const std::string& xml, const std::string& element) {
+    const std::string open = "<" + element + ">";
+    size_t start = xml.find(open);
+    if (start == std::string::npos) {
+        return {};
+    }
+    start += open.size();
+    size_t end = xml.find("</" + element + ">", start);
+    return end == std::string::npos ? std::string() : xml.substr(start, end - start);
+}
+
+// Name attribute of the index-th <Channel> element of OME-XML, or empty
+std::string OmeChannelName(const std::string& xml, size_t index) {
+    size_t position = 0;
+    for (size_t i = 0; ; ++i) {
+        position = xml.find("<Channel ", position);
+        if (position == std::string::npos) {
+            return {};
+        }
+        if (i == index) {
+            break;
+        }
+        position++;
+    }
+    size_t tagEnd = xml.find('>', position);
+    size_t name = xml.find(" Name=\"", position);
+    if (name == std::string::npos || name > tagEnd) {
+        return {};
+    }
+    name += 7;
+    size_t end = xml.find('"', name);
+    return end == std::string::npos ? std::string() : xml.substr(name, end - name);
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+struct JpegErrorManager {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+void JpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegErrorManager*>(info->err)->jump, 1);
+}
+
+void JpegOutputMessage(j_common_ptr) {
+    // Corrupt-data warnings are common in scanner output; stay quiet
+}
+
+// libjpeg-turbo's BGRA byte order is an ARGB word on little-endian hosts
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr J_COLOR_SPACE OUTPUT_COLOR_SPACE = JCS_EXT_ARGB;
+#else
+constexpr J_COLOR_SPACE OUTPUT_COLOR_SPACE = JCS_EXT_BGRA;
+#endif
+
+constexpr int SCANLINES_PER_READ = 16;
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+}  // namespace
+
+bool TiffTileReader::Directory::IsTiledJpeg() const {
+    size_t tileCount = tileWidth > 0 && tileHeight > 0
+        ? static_cast<size_t>(TilesAcross() * TilesDown()) : 0;
+    return width > 0 && height > 0 &&
+           tileWidth > 0 && tileWidth <= MAX_TILE_DIMENSION &&
+           tileHeight > 0 && tileHeight <= MAX_TILE_DIMENSION &&
+           compression == COMPRESSION_JPEG && samplesPerPixel == 3 &&
+           bitsPerSample == 8 && planarConfig == 1 &&
+           tileOffsets.size() >= tileCount && tileByteCounts.size() >= tileCount;
+}
+
+bool TiffTileReader::Directory::IsTiledChannel() const {
+    size_t tileCount = tileWidth > 0 && tileHeight > 0
+        ? static_cast<size_t>(TilesAcross() * TilesDown()) : 0;
+    bool codec = compression == COMPRESSION_NONE || compression == COMPRESSION_DEFLATE ||
+                 compression == COMPRESSION_ADOBE_DEFLATE;
+    return width > 0 && height > 0 &&
+           tileWidth > 0 && tileWidth <= MAX_TILE_DIMENSION &&
+           tileHeight > 0 && tileHeight <= MAX_TILE_DIMENSION &&
+           codec && samplesPerPixel == 1 && (bitsPerSample == 8 || bitsPerSample == 16) &&
+           planarConfig == 1 && (predictor == 1 || predictor == PREDICTOR_HORIZONTAL) &&
+           tileOffsets.size() >= tileCount && tileByteCounts.size() >= tileCount;
+}
+
+TiffTileReader::TiffTileReader(const std::string& path, bool memoryMap)
+    : path_(path)
+{
+    if (!OpenFile(memoryMap)) {
+        return;
+    }
+    if (!ParseHeader()) {
+        CloseFile();
+        return;
+    }
+    ParseDirectories();
+    CreateBatchReader();
+}
+
+TiffTileReader::TiffTileReader(const DicomFrameIndex& frames, bool memoryMap)
+    : path_(frames.path)
+{
+    if (!OpenFile(memoryMap)) {
+        return;
+    }
+    // The instance's frames as the tiles of one JPEG directory; each frame
+    // is a complete JPEG stream, so there are no shared tables
+    Directory directory;
+    directory.width = frames.width;
+    directory.height = frames.height;
+    directory.tileWidth = frames.tileWidth;
+    directory.tileHeight = frames.tileHeight;
+    directory.compression = COMPRESSION_JPEG;
+    directory.photometric = frames.photometric == "RGB" ? PHOTOMETRIC_RGB : PHOTOMETRIC_YCBCR;
+    directory.samplesPerPixel = frames.samplesPerPixel;
+    directory.bitsPerSample = frames.bitsAllocated;
+    directory.tileOffsets = frames.frameOffsets;
+    directory.tileByteCounts = frames.frameSizes;
+    directories_.push_back(std::move(directory));
+    mainDirectoryCount_ = directories_.size();
+    CreateBatchReader();
+}
+
+bool TiffTileReader::OpenFile(bool memoryMap) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    file_ = handle == INVALID_HANDLE_VALUE ? nullptr : handle;
+#else
+    file_ = open(path_.c_str(), O_RDONLY);
+#endif
+    if (!IsOpen()) {
+        return false;
+    }
+    if (memoryMap && !MapFile()) {
+        PATHVIEW_LOG_INFO("TiffTileReader: cannot map " << path_ << ", using positional reads");
+    }
+    return true;
+}
+
+void TiffTileReader::CloseFile() {
+    UnmapFile();
+#ifdef _WIN32
+    if (file_) {
+        CloseHandle(static_cast<HANDLE>(file_));
+        file_ = nullptr;
+    }
+#else
+    if (file_ >= 0) {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+}
+
+void TiffTileReader::CreateBatchReader() {
+    if (map_) {
+        return;
+    }
+#ifdef _WIN32
+    int fd = -1;
+#else
+    int fd = file_;
+#endif
+    batchReader_ = AsyncFileReader::Create(fd, [this](uint64_t offset, void* data, size_t size) {
+        return ReadFromFile(offset, data, size);
+    });
+}
+
+TiffTileReader::TiffTileReader(std::shared_ptr<RemoteFile> remote)
+    : remote_(std::move(remote))
+{
+    if (!IsOpen()) {
+        return;
+    }
+    if (!ParseHeader()) {
+        remote_.reset();
+        return;
+    }
+    ParseDirectories();
+}
+
+void TiffTileReader::ParseDirectories() {
+    // Walk the main directory chain; a corrupt directory ends it but keeps
+    // the levels found before it
+    uint64_t offset = firstDirectoryOffset_;
+    std::vector<uint64_t> visited;
+    while (offset != 0 && directories_.size() < MAX_DIRECTORIES &&
+           std::find(visited.begin(), visited.end(), offset) == visited.end()) {
+        visited.push_back(offset);
+        Directory directory;
+        uint64_t next = 0;
+        if (!ParseDirectory(offset, directory, next)) {
+            break;
+        }
+        directories_.push_back(std::move(directory));
+        offset = next;
+    }
+    mainDirectoryCount_ = directories_.size();
+
+    // SubIFDs (OME-TIFF keeps reduced levels there) go after the chain
+    for (size_t i = 0; i < mainDirectoryCount_; ++i) {
+        std::vector<uint64_t> offsets = directories_[i].subDirectoryOffsets;
+        for (uint64_t subOffset : offsets) {
+            if (directories_.size() >= MAX_DIRECTORIES) {
+                return;
+            }
+            Directory directory;
+            uint64_t next = 0;
+            if (!ParseDirectory(subOffset, directory, next)) {
+                break;
+            }
+            directories_[i].subDirectories.push_back(static_cast<int32_t>(directories_.size()));
+            directories_.push_back(std::move(directory));
+        }
+    }
+}
+
+TiffTileReader::~TiffTileReader() {
+    batchReader_.reset();
+    CloseFile();
+}
+
+bool TiffTileReader::IsOpen() const {
+    if (remote_) {
+        return remote_->IsOpen();
+    }
+#ifdef _WIN32
+    return file_ != nullptr;
+#else
+    return file_ >= 0;
+#endif
+}
+
+const char* TiffTileReader::GetBatchReadName() const {
+    return batchReader_ ? batchReader_->GetName() : nullptr;
+}
+
+bool TiffTileReader::IsDecodeAvailable() {
+#ifdef PATHVIEW_HAS_LIBJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t TiffTileReader::BindLevels(const std::vector<LevelDimensions>& levels) {
+    levelDirectories_.assign(levels.size(), -1);
+    std::vector<bool> used(directories_.size(), false);
+    size_t bound = 0;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        for (size_t i = 0; i < directories_.size(); ++i) {
+            const Directory& directory = directories_[i];
+            if (!used[i] && directory.IsTiledJpeg() &&
+                directory.width == levels[level].width && directory.height == levels[level].height) {
+                levelDirectories_[level] = static_cast<int32_t>(i);
+                used[i] = true;
+                bound++;
+                break;
+            }
+        }
+    }
+    return bound;
+}
+
+std::vector<LevelDimensions> TiffTileReader::GetPyramidLevels() const {
+    // Associated images (thumbnail, label, macro) are stripped or smaller
+    // than the level they follow; reduced-resolution levels keep shrinking
+    std::vector<LevelDimensions> levels;
+    for (const Directory& directory : directories_) {
+        if (!directory.IsTiledJpeg()) {
+            continue;
+        }
+        if (!levels.empty() &&
+            (directory.width >= levels.back().width || directory.height >= levels.back().height)) {
+            continue;
+        }
+        levels.push_back({directory.width, directory.height});
+    }
+    return levels;
+}
+
+bool TiffTileReader::HasLevel(int32_t level) const {
+    return level >= 0 && level < static_cast<int32_t>(levelDirectories_.size()) &&
+           levelDirectories_[level] >= 0;
+}
+
+LevelDimensions TiffTileReader::GetTileSize(int32_t level) const {
+    if (!HasLevel(level)) {
+        return {0, 0};
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    return {directory.tileWidth, directory.tileHeight};
+}
+
+bool TiffTileReader::ReadRawTile(int32_t level, int64_t column, int64_t row, std::vector<uint8_t>& out) const {
+    if (!HasLevel(level)) {
+        return false;
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    if (column < 0 || row < 0 || column >= directory.TilesAcross() || row >= directory.TilesDown()) {
+        return false;
+    }
+    return ReadTileBytes(directory, column, row, out);
+}
+
+size_t TiffTileReader::BindChannels() {
+    channelDirectories_.clear();
+    channelNames_.clear();
+
+    // Runs of consecutive, equal-sized channel directories in the main
+    // chain; associated images and RGB thumbnails break them
+    std::vector<std::vector<int32_t>> runs;
+    bool continuing = false;
+    for (size_t i = 0; i < mainDirectoryCount_; ++i) {
+        const Directory& directory = directories_[i];
+        if (!directory.IsTiledChannel()) {
+            continuing = false;
+            continue;
+        }
+        if (continuing) {
+            const Directory& first = directories_[runs.back().front()];
+            if (first.width == directory.width && first.height == directory.height) {
+                runs.back().push_back(static_cast<int32_t>(i));
+                continue;
+            }
+        }
+        runs.push_back({static_cast<int32_t>(i)});
+        continuing = true;
+    }
+    if (runs.empty()) {
+        return 0;
+    }
+
+    const std::vector<int32_t>& base = runs.front();
+    channelDirectories_.push_back(base);
+    auto shrinks = [this](const std::vector<int32_t>& level) {
+        const Directory& previous = directories_[channelDirectories_.back().front()];
+        for (int32_t index : level) {
+            const Directory& directory = directories_[index];
+            if (!directory.IsTiledChannel() ||
+                directory.width != directories_[level.front()].width ||
+                directory.height != directories_[level.front()].height) {
+                return false;
+            }
+        }
+        const Directory& first = directories_[level.front()];
+        return first.width < previous.width && first.height < previous.height;
+    };
+
+    // The k-th SubIFD of every channel forms level k + 1
+    size_t subLevels = SIZE_MAX;
+    for (int32_t index : base) {
+        subLevels = std::min(subLevels, directories_[index].subDirectories.size());
+    }
+    for (size_t k = 0; k < subLevels; ++k) {
+        std::vector<int32_t> level;
+        for (int32_t index : base) {
+            level.push_back(directories_[index].subDirectories[k]);
+        }
+        if (!shrinks(level)) {
+            break;
+        }
+        channelDirectories_.push_back(std::move(level));
+    }
+
+    // Otherwise reduced levels follow in the main chain
+    if (channelDirectories_.size() == 1) {
+        for (size_t r = 1; r < runs.size(); ++r) {
+            if (runs[r].size() == base.size() && shrinks(runs[r])) {
+                channelDirectories_.push_back(runs[r]);
+            }
+        }
+    }
+
+    ReadChannelNames(base);
+    return channelNames_.size();
+}
+
+void TiffTileReader::ReadChannelNames(const std::vector<int32_t>& directories) {
+    const std::string& ome = directories_.front().description;
+    bool isOme = ome.find("<OME") != std::string::npos;
+    for (size_t channel = 0; channel < directories.size(); ++channel) {
+        std::string name = XmlElementText(directories_[directories[channel]].description, "Name");
+        if (name.empty() && isOme) {
+            name = OmeChannelName(ome, channel);
+        }
+        if (name.empty()) {
+            name = "Channel " + std::to_string(channel + 1);
+        }
+        channelNames_.push_back(std::move(name));
+    }
+}
+
+std::vector<LevelDimensions> TiffTileReader::GetChannelLevels() const {
+    std::vector<LevelDimensions> levels;
+    for (const auto& level : channelDirectories_) {
+        const Directory& directory = directories_[level.front()];
+        levels.push_back({directory.width, directory.height});
+    }
+    return levels;
+}
+
+LevelDimensions TiffTileReader::GetChannelTileSize(int32_t level) const {
+    if (level < 0 || level >= static_cast<int32_t>(channelDirectories_.size())) {
+        return {0, 0};
+    }
+    const Directory& directory = directories_[channelDirectories_[level].front()];
+    return {directory.tileWidth, directory.tileHeight};
+}
+
+uint32_t TiffTileReader::GetChannelBits(size_t channel) const {
+    if (channelDirectories_.empty() || channel >= channelDirectories_.front().size()) {
+        return 0;
+    }
+    return directories_[channelDirectories_.front()[channel]].bitsPerSample;
+}
+
+bool TiffTileReader::TileRange(const Directory& directory, int64_t column, int64_t row,
+                               uint64_t& offset, uint64_t& size) const {
+    size_t index = static_cast<size_t>(row * directory.TilesAcross() + column);
+    offset = directory.tileOffsets[index];
+    size = directory.tileByteCounts[index];
+    return size > 0 && size <= MAX_TILE_BYTES && offset != 0;
+}
+
+void TiffTileReader::RegionTileRanges(const Directory& directory, int64_t x0, int64_t y0, int64_t x1, int64_t y1,
+                                      std::vector<std::pair<uint64_t, uint64_t>>& ranges) const {
+    for (int64_t row = y0 / directory.tileHeight; row * directory.tileHeight < y1; ++row) {
+        for (int64_t column = x0 / directory.tileWidth; column * directory.tileWidth < x1; ++column) {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            if (TileRange(directory, column, row, offset, size)) {
+                ranges.emplace_back(offset, offset + size);
+            }
+        }
+    }
+}
+
+void TiffTileReader::LoadRegionTiles(const Directory& directory, int64_t x0, int64_t y0, int64_t x1,
+                                     int64_t y1) const {
+    if (!remote_ && !batchReader_) {
+        return;
+    }
+    thread_local std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    ranges.clear();
+    RegionTileRanges(directory, x0, y0, x1, y1, ranges);
+
+    // Remote tiles: neighbouring tiles share requests instead of one round
+    // trip each
+    if (remote_) {
+        remote_->Load(ranges);
+        return;
+    }
+
+    // Local tiles: every read in flight at once. A lone tile gains nothing.
+    if (ranges.size() < 2) {
+        return;
+    }
+    thread_local std::vector<AsyncFileReader::Request> requests;
+    requests.clear();
+    if (stagedTiles.size() < ranges.size()) {
+        stagedTiles.resize(ranges.size());
+    }
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        StagedTile& tile = stagedTiles[i];
+        tile.offset = ranges[i].first;
+        tile.bytes.resize(static_cast<size_t>(ranges[i].second - ranges[i].first));
+        requests.push_back({tile.offset, tile.bytes.size(), tile.bytes.data()});
+    }
+    if (batchReader_->ReadBatch(requests.data(), requests.size())) {
+        stagedCount = ranges.size();
+    }
+}
+
+bool TiffTileReader::ReadTileBytes(const Directory& directory, int64_t column, int64_t row,
+                                   std::vector<uint8_t>& out) const {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    if (!TileRange(directory, column, row, offset, size)) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    return ReadAt(offset, out.data(), out.size());
+}
+
+bool TiffTileReader::ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                uint32_t* pixels) const {
+    if (!IsDecodeAvailable() || !HasLevel(level) || width <= 0 || height <= 0 || !pixels) {
+        return false;
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    const int64_t tw = directory.tileWidth;
+    const int64_t th = directory.tileHeight;
+
+    // Part of the region inside the level
+    int64_t x0 = std::max<int64_t>(x, 0);
+    int64_t y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = std::min(x + width, directory.width);
+    int64_t y1 = std::min(y + height, directory.height);
+
+    if (x0 < x1 && y0 < y1) {
+        StagedRegion staged;
+        LoadRegionTiles(directory, x0, y0, x1, y1);
+
+        thread_local std::vector<uint32_t> tilePixels;
+        thread_local std::vector<JpegDecodeJob> jobs;
+        thread_local std::vector<std::vector<uint8_t>> streams;
+        jobs.clear();
+
+        // The batch decoder relies on the stream's own colour markers, so
+        // RGB-coded tiles (see DecodeJpeg) stay on the CPU
+        bool batch = batchDecoder_ && directory.photometric != PHOTOMETRIC_RGB;
+
+        for (int64_t row = y0 / th; row * th < y1; ++row) {
+            for (int64_t column = x0 / tw; column * tw < x1; ++column) {
+                int64_t tileX = column * tw;
+                int64_t tileY = row * th;
+
+                // Tiles that start inside the region and fit across it are
+                // decoded in place (batched if possible); edge tiles go
+                // through scratch
+                if (tileX >= x && tileX + tw <= x + width && tileY >= y) {
+                    uint32_t* dst = pixels + (tileY - y) * width + (tileX - x);
+                    int64_t rowCount = std::min(th, y + height - tileY);
+                    if (batch) {
+                        if (streams.size() <= jobs.size()) {
+                            streams.resize(jobs.size() + 1);
+                        }
+                        std::vector<uint8_t>& stream = streams[jobs.size()];
+                        if (!ReadCompleteStream(directory, column, row, stream)) {
+                            return false;
+                        }
+                        JpegDecodeJob job;
+                        job.data = stream.data();
+                        job.size = stream.size();
+                        job.pixels = dst;
+                        job.stride = width;
+                        job.width = tw;
+                        job.height = th;
+                        job.rowCount = rowCount;
+                        jobs.push_back(job);
+                        continue;
+                    }
+                    if (!DecodeTile(directory, column, row, dst, width, rowCount)) {
+                        return false;
+                    }
+                    continue;
+                }
+
+                tilePixels.resize(static_cast<size_t>(tw * th));
+                if (!DecodeTile(directory, column, row, tilePixels.data(), tw, th)) {
+                    return false;
+                }
+                int64_t copyX0 = std::max(tileX, x0);
+                int64_t copyX1 = std::min(tileX + tw, x1);
+                int64_t copyY0 = std::max(tileY, y0);
+                int64_t copyY1 = std::min(tileY + th, y1);
+                for (int64_t py = copyY0; py < copyY1; ++py) {
+                    std::memcpy(pixels + (py - y) * width + (copyX0 - x),
+                                tilePixels.data() + (py - tileY) * tw + (copyX0 - tileX),
+                                static_cast<size_t>(copyX1 - copyX0) * sizeof(uint32_t));
+                }
+            }
+        }
+
+        if (!jobs.empty()) {
+            batchDecoder_->DecodeBatch(jobs);
+            for (const JpegDecodeJob& job : jobs) {
+                if (job.decoded) {
+                    batchDecodedCount_++;
+                } else if (!DecodeJpeg(directory, job.data, job.size, false,
+                                       job.pixels, job.stride, job.rowCount)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Clear everything outside the level, including the padding that
+    // in-place decodes of edge tiles wrote there
+    for (int64_t py = 0; py < height; ++py) {
+        uint32_t* line = pixels + py * width;
+        int64_t levelY = y + py;
+        if (levelY < y0 || levelY >= y1 || x0 >= x1) {
+            std::memset(line, 0, static_cast<size_t>(width) * sizeof(uint32_t));
+            continue;
+        }
+        if (x0 > x) {
+            std::memset(line, 0, static_cast<size_t>(x0 - x) * sizeof(uint32_t));
+        }
+        if (x1 < x + width) {
+            std::memset(line + (x1 - x), 0, static_cast<size_t>(x + width - x1) * sizeof(uint32_t));
+        }
+    }
+    return true;
+}
+
+bool TiffTileReader::CanScale(int32_t level, int32_t scale) const {
+    if (!HasLevel(level) || (scale != 1 && scale != 2 && scale != 4 && scale != 8)) {
+        return false;
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    return directory.tileWidth % scale == 0 && directory.tileHeight % scale == 0;
+}
+
+bool TiffTileReader::ReadRegionScaled(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                      int32_t scale, uint32_t* pixels) const {
+    if (scale == 1) {
+        return ReadRegion(level, x, y, width, height, pixels);
+    }
+    if (!IsDecodeAvailable() || !CanScale(level, scale) || width <= 0 || height <= 0 || !pixels) {
+        return false;
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    const int64_t tw = directory.tileWidth / scale;
+    const int64_t th = directory.tileHeight / scale;
+    const int64_t levelWidth = (directory.width + scale - 1) / scale;
+    const int64_t levelHeight = (directory.height + scale - 1) / scale;
+
+    // Part of the region inside the (reduced) level
+    int64_t x0 = std::max<int64_t>(x, 0);
+    int64_t y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = std::min(x + width, levelWidth);
+    int64_t y1 = std::min(y + height, levelHeight);
+
+    if (x0 < x1 && y0 < y1) {
+        StagedRegion staged;
+        LoadRegionTiles(directory, x0 * scale, y0 * scale, std::min(x1 * scale, directory.width),
+                        std::min(y1 * scale, directory.height));
+
+        // Reduced tiles are small: always decoded through scratch
+        thread_local std::vector<uint32_t> tilePixels;
+        tilePixels.resize(static_cast<size_t>(tw * th));
+        for (int64_t row = y0 / th; row * th < y1; ++row) {
+            for (int64_t column = x0 / tw; column * tw < x1; ++column) {
+                if (!DecodeTile(directory, column, row, tilePixels.data(), tw, th, scale)) {
+                    return false;
+                }
+                int64_t tileX = column * tw;
+                int64_t tileY = row * th;
+                int64_t copyX0 = std::max(tileX, x0);
+                int64_t copyX1 = std::min(tileX + tw, x1);
+                int64_t copyY0 = std::max(tileY, y0);
+                int64_t copyY1 = std::min(tileY + th, y1);
+                for (int64_t py = copyY0; py < copyY1; ++py) {
+                    std::memcpy(pixels + (py - y) * width + (copyX0 - x),
+                                tilePixels.data() + (py - tileY) * tw + (copyX0 - tileX),
+                                static_cast<size_t>(copyX1 - copyX0) * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+
+    // Clear everything outside the level
+    for (int64_t py = 0; py < height; ++py) {
+        uint32_t* line = pixels + py * width;
+        int64_t levelY = y + py;
+        if (levelY < y0 || levelY >= y1 || x0 >= x1) {
+            std::memset(line, 0, static_cast<size_t>(width) * sizeof(uint32_t));
+            continue;
+        }
+        if (x0 > x) {
+            std::memset(line, 0, static_cast<size_t>(x0 - x) * sizeof(uint32_t));
+        }
+        if (x1 < x + width) {
+            std::memset(line + (x1 - x), 0, static_cast<size_t>(x + width - x1) * sizeof(uint32_t));
+        }
+    }
+    return true;
+}
+
+void TiffTileReader::SetBatchDecoder(std::shared_ptr<JpegBatchDecoder> decoder) {
+    batchDecoder_ = std::move(decoder);
+}
+
+bool TiffTileReader::ReadCompleteStream(const Directory& directory, int64_t column, int64_t row,
+                                        std::vector<uint8_t>& out) const {
+    thread_local std::vector<uint8_t> tile;
+    if (!ReadTileBytes(directory, column, row, tile)) {
+        return false;
+    }
+    const std::vector<uint8_t>& tables = directory.jpegTables;
+    bool abbreviated = tables.size() >= 4 && tile.size() >= 2 &&
+                       tables[tables.size() - 2] == 0xFF && tables[tables.size() - 1] == 0xD9 &&
+                       tile[0] == 0xFF && tile[1] == 0xD8;
+    if (!abbreviated) {
+        out = tile;
+        return true;
+    }
+    // Tables stream without its EOI, then the tile without its SOI
+    out.assign(tables.begin(), tables.end() - 2);
+    out.insert(out.end(), tile.begin() + 2, tile.end());
+    return true;
+}
+
+const uint8_t* TiffTileReader::TileBytes(const Directory& directory, int64_t column, int64_t row,
+                                         std::vector<uint8_t>& scratch, size_t& size) const {
+    // Mapped files decode straight from the page cache
+    if (map_) {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        const uint8_t* bytes = TileRange(directory, column, row, offset, length) ? MappedBytes(offset, length) : nullptr;
+        size = static_cast<size_t>(length);
+        return bytes;
+    }
+
+    if (!ReadTileBytes(directory, column, row, scratch)) {
+        return nullptr;
+    }
+    size = scratch.size();
+    return scratch.data();
+}
+
+bool TiffTileReader::DecodeTile(const Directory& directory, int64_t column, int64_t row,
+                                uint32_t* pixels, int64_t stride, int64_t rowCount, int32_t scale) const {
+    thread_local std::vector<uint8_t> data;
+    size_t size = 0;
+    const uint8_t* bytes = TileBytes(directory, column, row, data, size);
+    return bytes && DecodeJpeg(directory, bytes, size, true, pixels, stride, rowCount, scale);
+}
+
+bool TiffTileReader::ReadChannelRegion(int32_t level, size_t channel, int64_t x, int64_t y,
+                                       int64_t width, int64_t height, uint16_t* samples) const {
+    if (level < 0 || level >= static_cast<int32_t>(channelDirectories_.size()) ||
+        channel >= channelNames_.size() || width <= 0 || height <= 0 || !samples) {
+        return false;
+    }
+    const Directory& directory = directories_[channelDirectories_[level][channel]];
+    const int64_t tw = directory.tileWidth;
+    const int64_t th = directory.tileHeight;
+
+    std::fill(samples, samples + width * height, uint16_t{0});
+    int64_t x0 = std::max<int64_t>(x, 0);
+    int64_t y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = std::min(x + width, directory.width);
+    int64_t y1 = std::min(y + height, directory.height);
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    StagedRegion staged;
+    LoadRegionTiles(directory, x0, y0, x1, y1);
+
+    thread_local std::vector<uint16_t> tileSamples;
+    tileSamples.resize(static_cast<size_t>(tw * th));
+    for (int64_t row = y0 / th; row * th < y1; ++row) {
+        for (int64_t column = x0 / tw; column * tw < x1; ++column) {
+            if (!DecodeChannelTile(directory, column, row, tileSamples.data())) {
+                return false;
+            }
+            int64_t tileX = column * tw;
+            int64_t tileY = row * th;
+            int64_t copyX0 = std::max(tileX, x0);
+            int64_t copyX1 = std::min(tileX + tw, x1);
+            for (int64_t py = std::max(tileY, y0); py < std::min(tileY + th, y1); ++py) {
+                std::memcpy(samples + (py - y) * width + (copyX0 - x),
+                            tileSamples.data() + (py - tileY) * tw + (copyX0 - tileX),
+                            static_cast<size_t>(copyX1 - copyX0) * sizeof(uint16_t));
+            }
+        }
+    }
+    return true;
+}
+
+bool TiffTileReader::DecodeChannelTile(const Directory& directory, int64_t column, int64_t row,
+                                       uint16_t* samples) const {
+    thread_local std::vector<uint8_t> stored;
+    thread_local std::vector<uint8_t> raw;
+    size_t size = 0;
+    const uint8_t* data = TileBytes(directory, column, row, stored, size);
+    if (!data) {
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(directory.tileWidth * directory.tileHeight);
+    const size_t rawSize = count * (directory.bitsPerSample / 8);
+    if (directory.compression == COMPRESSION_NONE) {
+        if (size < rawSize) {
+            return false;
+        }
+        raw.assign(data, data + rawSize);
+    } else {
+        raw.resize(rawSize);
+        uLongf length = static_cast<uLongf>(rawSize);
+        if (uncompress(raw.data(), &length, data, static_cast<uLong>(size)) != Z_OK || length != rawSize) {
+            return false;
+        }
+    }
+
+    if (directory.bitsPerSample == 8) {
+        std::copy(raw.begin(), raw.end(), samples);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t value;
+            std::memcpy(&value, raw.data() + i * 2, sizeof(value));
+            samples[i] = ToHost16(value);
+        }
+    }
+
+    // Horizontal differencing: each sample stored as the change from its
+    // left neighbour, wrapping at the sample width
+    if (directory.predictor == PREDICTOR_HORIZONTAL) {
+        const uint16_t mask = directory.bitsPerSample == 8 ? 0xFF : 0xFFFF;
+        for (int64_t y = 0; y < directory.tileHeight; ++y) {
+            uint16_t* line = samples + y * directory.tileWidth;
+            for (int64_t x = 1; x < directory.tileWidth; ++x) {
+                line[x] = static_cast<uint16_t>((line[x] + line[x - 1]) & mask);
+            }
+        }
+    }
+    return true;
+}
+
+bool TiffTileReader::DecodeJpeg(const Directory& directory, const uint8_t* data, size_t size,
+                                bool sharedTables, uint32_t* pixels, int64_t stride, int64_t rowCount,
+                                int32_t scale) const {
+#ifdef PATHVIEW_HAS_LIBJPEG
+    // Scratch is prepared before setjmp: nothing below may need unwinding
+    thread_local std::vector<uint32_t> droppedRows;
+    droppedRows.resize(static_cast<size_t>(directory.tileWidth * SCANLINES_PER_READ));
+
+    jpeg_decompress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = JpegErrorExit;
+    error.manager.output_message = JpegOutputMessage;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_create_decompress(&info);
+
+    // Aperio and most pyramidal TIFFs store abbreviated tile streams that
+    // share one set of tables
+    if (sharedTables && !directory.jpegTables.empty()) {
+        jpeg_mem_src(&info, const_cast<unsigned char*>(directory.jpegTables.data()),
+                     static_cast<unsigned long>(directory.jpegTables.size()));
+        if (jpeg_read_header(&info, FALSE) != JPEG_HEADER_TABLES_ONLY) {
+            jpeg_destroy_decompress(&info);
+            return false;
+        }
+    }
+
+    jpeg_mem_src(&info, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    if (jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    // RGB tiles carry no marker saying so; libjpeg would assume YCbCr
+    if (directory.photometric == PHOTOMETRIC_RGB) {
+        info.jpeg_color_space = JCS_RGB;
+    }
+    info.out_color_space = OUTPUT_COLOR_SPACE;
+    if (scale > 1) {
+        // DCT scaling: each 8x8 block is inverse transformed straight to
+        // 8/scale pixels square
+        info.scale_num = 1;
+        info.scale_denom = static_cast<unsigned int>(scale);
+    }
+
+    jpeg_start_decompress(&info);
+    if (static_cast<int64_t>(info.output_width) != directory.tileWidth / scale ||
+        static_cast<int64_t>(info.output_height) != directory.tileHeight / scale) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+
+    JSAMPROW rows[SCANLINES_PER_READ];
+    while (info.output_scanline < info.output_height) {
+        int64_t first = info.output_scanline;
+        int count = static_cast<int>(std::min<int64_t>(SCANLINES_PER_READ, info.output_height - first));
+        for (int i = 0; i < count; ++i) {
+            int64_t line = first + i;
+            uint32_t* target = line < rowCount
+                ? pixels + line * stride
+                : droppedRows.data() + static_cast<size_t>(i) * directory.tileWidth;
+            rows[i] = reinterpret_cast<JSAMPROW>(target);
+        }
+        jpeg_read_scanlines(&info, rows, static_cast<JDIMENSION>(count));
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+#else
+    (void)directory;
+    (void)data;
+    (void)size;
+    (void)sharedTables;
+    (void)pixels;
+    (void)stride;
+    (void)rowCount;
+    (void)scale;
+    return false;
+#endif
+}
+
+bool TiffTileReader::ParseHeader() {
+    uint8_t header[16];
+    if (!ReadAt(0, header, 8)) {
+        return false;
+    }
+    if (header[0] == 'I' && header[1] == 'I') {
+        bigEndian_ = false;
+    } else if (header[0] == 'M' && header[1] == 'M') {
+        bigEndian_ = true;
+    } else {
+        return false;
+    }
+
+    uint16_t version;
+    std::memcpy(&version, header + 2, sizeof(version));
+    version = ToHost16(version);
+    if (version == 42) {
+        uint32_t offset;
+        std::memcpy(&offset, header + 4, sizeof(offset));
+        firstDirectoryOffset_ = ToHost32(offset);
+        return true;
+    }
+    if (version == 43) {
+        // BigTIFF: offset size (8), reserved (0), then an 8-byte offset
+        if (!ReadAt(0, header, 16)) {
+            return false;
+        }
+        uint16_t offsetSize;
+        std::memcpy(&offsetSize, header + 4, sizeof(offsetSize));
+        if (ToHost16(offsetSize) != 8) {
+            return false;
+        }
+        uint64_t offset;
+        std::memcpy(&offset, header + 8, sizeof(offset));
+        bigTiff_ = true;
+        firstDirectoryOffset_ = ToHost64(offset);
+        return true;
+    }
+    return false;
+}
+
+bool TiffTileReader::ParseDirectory(uint64_t offset, Directory& directory, uint64_t& nextOffset) {
+    uint64_t entryCount = 0;
+    size_t countSize = bigTiff_ ? 8 : 2;
+    size_t entrySize = bigTiff_ ? 20 : 12;
+    if (bigTiff_) {
+        uint64_t count;
+        if (!ReadAt(offset, &count, sizeof(count))) {
+            return false;
+        }
+        entryCount = ToHost64(count);
+    } else {
+        uint16_t count;
+        if (!ReadAt(offset, &count, sizeof(count))) {
+            return false;
+        }
+        entryCount = ToHost16(count);
+    }
+    if (entryCount == 0 || entryCount > MAX_DIRECTORY_ENTRIES) {
+        return false;
+    }
+
+    // Entries and the next-directory offset in one read
+    size_t offsetSize = bigTiff_ ? 8 : 4;
+    std::vector<uint8_t> block(static_cast<size_t>(entryCount) * entrySize + offsetSize);
+    if (!ReadAt(offset + countSize, block.data(), block.size())) {
+        return false;
+    }
+
+    std::vector<uint8_t> values;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        uint16_t tag = 0;
+        uint16_t type = 0;
+        if (!ReadEntry(block.data() + i * entrySize, tag, type, values)) {
+            continue;  // Unknown type or unreadable values: not one we use
+        }
+        size_t count = values.size() / TypeSize(type);
+        if (count == 0) {
+            continue;
+        }
+        switch (tag) {
+            case TAG_IMAGE_WIDTH: directory.width = static_cast<int64_t>(EntryValue(values, type, 0)); break;
+            case TAG_IMAGE_LENGTH: directory.height = static_cast<int64_t>(EntryValue(values, type, 0)); break;
+            case TAG_BITS_PER_SAMPLE: directory.bitsPerSample = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_COMPRESSION: directory.compression = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_PHOTOMETRIC: directory.photometric = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_SAMPLES_PER_PIXEL: directory.samplesPerPixel = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_PLANAR_CONFIG: directory.planarConfig = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_TILE_WIDTH: directory.tileWidth = static_cast<int64_t>(EntryValue(values, type, 0)); break;
+            case TAG_TILE_LENGTH: directory.tileHeight = static_cast<int64_t>(EntryValue(values, type, 0)); break;
+            case TAG_TILE_OFFSETS:
+                directory.tileOffsets.resize(count);
+                for (size_t k = 0; k < count; ++k) {
+                    directory.tileOffsets[k] = EntryValue(values, type, k);
+                }
+                break;
+            case TAG_TILE_BYTE_COUNTS:
+                directory.tileByteCounts.resize(count);
+                for (size_t k = 0; k < count; ++k) {
+                    directory.tileByteCounts[k] = EntryValue(values, type, k);
+                }
+                break;
+            case TAG_JPEG_TABLES:
+                directory.jpegTables = values;
+                break;
+            case TAG_IMAGE_DESCRIPTION:
+                if (values.size() <= MAX_DESCRIPTION_BYTES) {
+                    directory.description.assign(values.begin(), std::find(values.begin(), values.end(), 0));
+                }
+                break;
+            case TAG_PREDICTOR: directory.predictor = static_cast<uint32_t>(EntryValue(values, type, 0)); break;
+            case TAG_SUB_IFDS:
+                directory.subDirectoryOffsets.resize(std::min<size_t>(count, MAX_DIRECTORIES));
+                for (size_t k = 0; k < directory.subDirectoryOffsets.size(); ++k) {
+                    directory.subDirectoryOffsets[k] = EntryValue(values, type, k);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    const uint8_t* next = block.data() + entryCount * entrySize;
+    if (bigTiff_) {
+        uint64_t value;
+        std::memcpy(&value, next, sizeof(value));
+        nextOffset = ToHost64(value);
+    } else {
+        uint32_t value;
+        std::memcpy(&value, next, sizeof(value));
+        nextOffset = ToHost32(value);
+    }
+    return true;
+}
+
+bool TiffTileReader::ReadEntry(const uint8_t* entry, uint16_t& tag, uint16_t& type,
+                               std::vector<uint8_t>& values) const {
+    std::memcpy(&tag, entry, sizeof(tag));
+    std::memcpy(&type, entry + 2, sizeof(type));
+    tag = ToHost16(tag);
+    type = ToHost16(type);
+
+    size_t typeSize = TypeSize(type);
+    if (typeSize == 0) {
+        return false;
+    }
+
+    uint64_t count = 0;
+    const uint8_t* field = nullptr;
+    size_t fieldSize = 0;
+    if (bigTiff_) {
+        std::memcpy(&count, entry + 4, sizeof(count));
+        count = ToHost64(count);
+        field = entry + 12;
+        fieldSize = 8;
+    } else {
+        uint32_t count32;
+        std::memcpy(&count32, entry + 4, sizeof(count32));
+        count = ToHost32(count32);
+        field = entry + 8;
+        fieldSize = 4;
+    }
+    if (count > MAX_ENTRY_BYTES / typeSize) {
+        return false;
+    }
+
+    size_t total = static_cast<size_t>(count) * typeSize;
+    values.resize(total);
+    if (total <= fieldSize) {
+        std::memcpy(values.data(), field, total);
+        return true;
+    }
+
+    uint64_t offset = 0;
+    if (bigTiff_) {
+        std::memcpy(&offset, field, sizeof(offset));
+        offset = ToHost64(offset);
+    } else {
+        uint32_t offset32;
+        std::memcpy(&offset32, field, sizeof(offset32));
+        offset = ToHost32(offset32);
+    }
+    return ReadAt(offset, values.data(), total);
+}
+
+uint64_t TiffTileReader::EntryValue(const std::vector<uint8_t>& values, uint16_t type, size_t index) const {
+    const uint8_t* value = values.data() + index * TypeSize(type);
+    switch (TypeSize(type)) {
+        case 1:
+            return *value;
+        case 2: {
+            uint16_t v;
+            std::memcpy(&v, value, sizeof(v));
+            return ToHost16(v);
+        }
+        case 4: {
+            uint32_t v;
+            std::memcpy(&v, value, sizeof(v));
+            return ToHost32(v);
+        }
+        default: {
+            uint64_t v;
+            std::memcpy(&v, value, sizeof(v));
+            return ToHost64(v);
+        }
+    }
+}
+
+void TiffTileReader::Advise(TiffAccessPattern pattern) const {
+    if (!IsOpen() || remote_) {
+        return;
+    }
+#ifdef _WIN32
+    (void)pattern;  // No per-file hint; Prewarm() still prefetches mapped ranges
+#else
+    if (map_) {
+        int advice = pattern == TiffAccessPattern::Random ? MADV_RANDOM
+                   : pattern == TiffAccessPattern::Sequential ? MADV_SEQUENTIAL : MADV_NORMAL;
+        madvise(const_cast<uint8_t*>(map_), static_cast<size_t>(mapSize_), advice);
+        return;
+    }
+#ifdef __APPLE__
+    fcntl(file_, F_RDAHEAD, pattern == TiffAccessPattern::Random ? 0 : 1);
+#else
+    int advice = pattern == TiffAccessPattern::Random ? POSIX_FADV_RANDOM
+               : pattern == TiffAccessPattern::Sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_NORMAL;
+    posix_fadvise(file_, 0, 0, advice);
+#endif
+#endif
+}
+
+size_t TiffTileReader::Prewarm(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                               bool sequential) const {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;  // Offset, end
+    LevelTileRanges(level, x, y, width, height, ranges);
+    if (ranges.empty()) {
+        return 0;
+    }
+
+    // Tiles are usually stored row by row, so a region collapses to one
+    // range per tile row
+    std::sort(ranges.begin(), ranges.end());
+    size_t hinted = 0;
+    uint64_t start = ranges[0].first;
+    uint64_t end = ranges[0].second;
+    for (size_t i = 1; i <= ranges.size(); ++i) {
+        if (i < ranges.size() && ranges[i].first <= end + PREWARM_MERGE_GAP) {
+            end = std::max(end, ranges[i].second);
+            continue;
+        }
+        AdviseRange(start, end - start, sequential);
+        hinted += static_cast<size_t>(end - start);
+        if (i < ranges.size()) {
+            start = ranges[i].first;
+            end = ranges[i].second;
+        }
+    }
+    return hinted;
+}
+
+size_t TiffTileReader::Fetch(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height) const {
+    thread_local std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    LevelTileRanges(level, x, y, width, height, ranges);
+    if (ranges.empty()) {
+        return 0;
+    }
+    size_t fetched = 0;
+    for (const auto& range : ranges) {
+        fetched += static_cast<size_t>(range.second - range.first);
+    }
+
+    if (remote_) {
+        return remote_->Load(ranges) ? fetched : 0;
+    }
+
+    // Mapped: fault every page in now, one byte each
+    if (map_) {
+        uint64_t pageSize = 4096;
+#ifndef _WIN32
+        pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+        uint8_t sum = 0;
+        for (const auto& range : ranges) {
+            const uint8_t* bytes = MappedBytes(range.first, range.second - range.first);
+            if (!bytes) {
+                return 0;
+            }
+            for (uint64_t offset = 0; offset < range.second - range.first; offset += pageSize) {
+                sum ^= *static_cast<const volatile uint8_t*>(bytes + offset);
+            }
+        }
+        (void)sum;
+        return fetched;
+    }
+
+    // Positional: one batch into scratch buffers, leaving the bytes in the
+    // page cache for the region read that follows
+    thread_local std::vector<std::vector<uint8_t>> scratch;
+    thread_local std::vector<AsyncFileReader::Request> requests;
+    if (scratch.size() < ranges.size()) {
+        scratch.resize(ranges.size());
+    }
+    requests.clear();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        scratch[i].resize(static_cast<size_t>(ranges[i].second - ranges[i].first));
+        requests.push_back({ranges[i].first, scratch[i].size(), scratch[i].data()});
+    }
+    if (batchReader_) {
+        return batchReader_->ReadBatch(requests.data(), requests.size()) ? fetched : 0;
+    }
+    for (const auto& request : requests) {
+        if (!ReadFromFile(request.offset, request.data, request.size)) {
+            return 0;
+        }
+    }
+    return fetched;
+}
+
+void TiffTileReader::LevelTileRanges(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                                     std::vector<std::pair<uint64_t, uint64_t>>& ranges) const {
+    ranges.clear();
+    if (!HasLevel(level) || width <= 0 || height <= 0) {
+        return;
+    }
+    const Directory& directory = directories_[levelDirectories_[level]];
+    int64_t x0 = std::max<int64_t>(x, 0);
+    int64_t y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = std::min(x + width, directory.width);
+    int64_t y1 = std::min(y + height, directory.height);
+    if (x0 < x1 && y0 < y1) {
+        RegionTileRanges(directory, x0, y0, x1, y1, ranges);
+    }
+}
+
+void TiffTileReader::AdviseRange(uint64_t offset, uint64_t size, bool sequential) const {
+    if (remote_) {
+        remote_->Prefetch(offset, size);
+        return;
+    }
+#ifdef _WIN32
+    (void)sequential;
+    const uint8_t* bytes = MappedBytes(offset, size);
+    if (bytes) {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(bytes), static_cast<SIZE_T>(size)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    if (map_) {
+        if (!MappedBytes(offset, size)) {
+            return;
+        }
+        // madvise wants a page-aligned start
+        uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t alignedOffset = offset - offset % pageSize;
+        void* start = const_cast<uint8_t*>(map_ + alignedOffset);
+        size_t length = static_cast<size_t>(offset + size - alignedOffset);
+        if (sequential) {
+            madvise(start, length, MADV_SEQUENTIAL);
+        }
+        madvise(start, length, MADV_WILLNEED);
+        return;
+    }
+#ifdef __APPLE__
+    (void)sequential;
+    radvisory advice{};
+    advice.ra_offset = static_cast<off_t>(offset);
+    advice.ra_count = static_cast<int>(std::min<uint64_t>(size, INT32_MAX));
+    fcntl(file_, F_RDADVISE, &advice);
+#else
+    if (sequential) {
+        posix_fadvise(file_, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_SEQUENTIAL);
+    }
+    posix_fadvise(file_, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+#endif
+}
+
+bool TiffTileReader::MapFile() {
+#ifdef _WIN32
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(static_cast<HANDLE>(file_), &fileSize) || fileSize.QuadPart <= 0) {
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(static_cast<HANDLE>(file_), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    map_ = static_cast<const uint8_t*>(view);
+    mapSize_ = static_cast<uint64_t>(fileSize.QuadPart);
+    return true;
+#else
+    struct stat info{};
+    if (fstat(file_, &info) != 0 || info.st_size <= 0) {
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, file_, 0);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(view);
+    mapSize_ = static_cast<uint64_t>(info.st_size);
+    return true;
+#endif
+}
+
+void TiffTileReader::UnmapFile() {
+    if (!map_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(map_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    mapping_ = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(map_), static_cast<size_t>(mapSize_));
+#endif
+    map_ = nullptr;
+    mapSize_ = 0;
+}
+
+const uint8_t* TiffTileReader::MappedBytes(uint64_t offset, uint64_t size) const {
+    if (!map_ || offset > mapSize_ || size > mapSize_ - offset) {
+        return nullptr;
+    }
+    return map_ + offset;
+}
+
+bool TiffTileReader::ReadAt(uint64_t offset, void* data, size_t size) const {
+    if (remote_) {
+        return remote_->ReadAt(offset, data, size);
+    }
+    if (map_) {
+        const uint8_t* bytes = MappedBytes(offset, size);
+        if (!bytes) {
+            return false;
+        }
+        std::memcpy(data, bytes, size);
+        return true;
+    }
+    for (size_t i = 0; i < stagedCount; ++i) {
+        const StagedTile& tile = stagedTiles[i];
+        if (offset >= tile.offset && offset + size <= tile.offset + tile.bytes.size()) {
+            std::memcpy(data, tile.bytes.data() + (offset - tile.offset), size);
+            return true;
+        }
+    }
+    return ReadFromFile(offset, data, size);
+}
+
+bool TiffTileReader::ReadFromFile(uint64_t offset, void* data, size_t size) const {
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD read = 0;
+        if (!ReadFile(static_cast<HANDLE>(file_), dst, chunk, &read, &overlapped) || read == 0) {
+            return false;
+        }
+#else
+        ssize_t read = pread(file_, dst, size, static_cast<off_t>(offset));
+        if (read <= 0) {
+            return false;
+        }
+#endif
+        dst += read;
+        offset += static_cast<uint64_t>(read);
+        size -= static_cast<size_t>(read);
+    }
+    return true;
+}
+
+uint16_t TiffTileReader::ToHost16(uint16_t value) const {
+    uint8_t bytes[2];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    return bigEndian_ ? static_cast<uint16_t>((bytes[0] << 8) | bytes[1])
+                      : static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t TiffTileReader::ToHost32(uint32_t value) const {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+        result |= static_cast<uint32_t>(bytes[bigEndian_ ? i : 3 - i]) << (8 * (3 - i));
+    }
+    return result;
+}
+
+uint64_t TiffTileReader::ToHost64(uint64_t value) const {
+    uint8_t bytes[8];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    uint64_t result = 0;
+    for (int i = 0; i < 8; ++i) {
+        result |= static_cast<uint64_t>(bytes[bigEndian_ ? i : 7 - i]) << (8 * (7 - i));
+    }
+    return result;
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "SlideLoader.h"  // For LevelDimensions
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class AsyncFileReader;
+struct DicomFrameIndex;
+class JpegBatchDecoder;
+class RemoteFile;
+
+// Access hints for the slide file (madvise / posix_fadvise)
+enum class TiffAccessPattern {
+    Normal,
+    Random,      // Interactive viewing: no readahead beyond the tile
+    Sequential,  // Streaming through rows: aggressive readahead
+};
+
+// Direct reader for the JPEG-compressed tiles of a tiled TIFF (Aperio SVS,
+// generic pyramidal TIFF).
+//
+// Parses the TIFF / BigTIFF directory chain itself to find each level's
+// tile offsets and shared JPEG tables, reads the compressed bytes with
+// positional reads and decodes them with libjpeg-turbo straight into the
+// caller's buffer as BGRA, which is the native-endian ARGB word layout
+// OpenSlide returns. That skips OpenSlide's per-handle tile cache and its
+// cairo region compositing.
+//
+// Only levels whose directory is tiled, 8-bit, 3-sample, contiguous JPEG
+// are served; SlideLoader falls back to OpenSlide for everything else (and
+// for any read that fails here). Without libjpeg at build time the
+// directory is still parsed, but ReadRegion always reports failure.
+//
+// The file is either read with positional reads or, with memoryMap, mapped
+// read-only so tile reads are page-cache hits decoded straight from the
+// mapping without a read() copy (falling back to positional reads if the
+// map fails). Prewarm() and Advise() pass access hints to the OS in both
+// modes. Positional reads of a region's tiles go out as one batch through
+// an AsyncFileReader (io_uring where available) before any is decoded, so
+// a cold page cache or a network filesystem costs one round trip per
+// region rather than one per tile.
+//
+// A remote slide is read through a RemoteFile instead: each region read
+// first loads all of its tiles' byte ranges in one coalesced batch, and
+// Prewarm() queues them on the RemoteFile's prefetch thread.
+//
+// Multichannel (fluorescence) files are read too: see BindChannels. So
+// are DICOM WSI instances, whose frames DicomFrameIndex locates in place
+// of a TIFF directory.
+//
+// Thread-safe after construction: reads are positional and every decode
+// uses its own libjpeg state.
+class TiffTileReader {
+public:
+    explicit TiffTileReader(const std::string& path, bool memoryMap = false);
+    explicit TiffTileReader(std::shared_ptr<RemoteFile> remote);
+    // One DICOM WSI instance, its frames served as the tiles of a single
+    // JPEG directory (bind it as level 0, or to the slide level it is)
+    explicit TiffTileReader(const DicomFrameIndex& frames, bool memoryMap = false);
+    ~TiffTileReader();
+
+    TiffTileReader(const TiffTileReader&) = delete;
+    TiffTileReader& operator=(const TiffTileReader&) = delete;
+
+    // True if the file is a readable TIFF
+    bool IsOpen() const;
+    bool IsMapped() const { return map_ != nullptr; }
+    bool IsRemote() const { return remote_ != nullptr; }
+    // How positional region reads are batched ("io_uring", "threads"), or
+    // nullptr for mapped and remote files
+    const char* GetBatchReadName() const;
+
+    // Whether this build can decode JPEG tiles (libjpeg-turbo found)
+    static bool IsDecodeAvailable();
+
+    // Map slide levels to TIFF directories with the same dimensions.
+    // Returns the number of levels the reader can serve.
+    size_t BindLevels(const std::vector<LevelDimensions>& levels);
+
+    // Dimensions of the tiled JPEG directories that form a pyramid (each
+    // smaller than the one before, in file order), for slides that are
+    // not opened through OpenSlide
+    std::vector<LevelDimensions> GetPyramidLevels() const;
+
+    bool HasLevel(int32_t level) const;
+    LevelDimensions GetTileSize(int32_t level) const;
+
+    // Compressed bytes of one tile exactly as stored (without the shared
+    // JPEG tables). Returns false for a missing or empty tile.
+    bool ReadRawTile(int32_t level, int64_t column, int64_t row, std::vector<uint8_t>& out) const;
+
+    // Decode a region in level coordinates into a buffer of width * height
+    // pixels. Pixels outside the level are transparent, as with OpenSlide.
+    // Returns false on any failure; the buffer contents are then undefined.
+    bool ReadRegion(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                    uint32_t* pixels) const;
+
+    // ReadRegion at 1/scale of the level's resolution (scale 1, 2, 4 or 8;
+    // the level's tile size must divide by it): x, y, width and height are
+    // in those reduced pixels. libjpeg-turbo's DCT scaling decodes each
+    // tile straight to the smaller size, skipping most of the IDCT and
+    // colour conversion work, so a coarse tile costs a fraction of the
+    // full-resolution decode. Always on the CPU.
+    bool ReadRegionScaled(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height, int32_t scale,
+                          uint32_t* pixels) const;
+
+    // Whether ReadRegionScaled can serve a level at this scale
+    bool CanScale(int32_t level, int32_t scale) const;
+
+    // Multichannel images as QPTIFF and OME-TIFF store them: each level a
+    // run of single-sample, 8- or 16-bit tiled directories of equal size,
+    // one per channel. Reduced levels follow in the main chain, or sit in
+    // each channel directory's SubIFDs. Binds those levels and returns the
+    // channel count, 0 if the file has no such run. Uncompressed and
+    // deflate tiles are decoded, with or without horizontal differencing;
+    // no libjpeg is needed. Not thread-safe: call before reads start.
+    size_t BindChannels();
+    size_t GetChannelCount() const { return channelNames_.size(); }
+    std::vector<LevelDimensions> GetChannelLevels() const;
+    LevelDimensions GetChannelTileSize(int32_t level) const;
+    // Bits per sample (8 or 16) and name of a channel. Names come from the
+    // QPTIFF <Name> or OME-XML Channel Name, else "Channel N".
+    uint32_t GetChannelBits(size_t channel) const;
+    const std::string& GetChannelName(size_t channel) const { return channelNames_[channel]; }
+
+    // Decode one channel of a region in level coordinates into width *
+    // height samples. Samples outside the level are 0. Returns false on any
+    // failure; the samples are then undefined.
+    bool ReadChannelRegion(int32_t level, size_t channel, int64_t x, int64_t y, int64_t width, int64_t height,
+                           uint16_t* samples) const;
+
+    // Offload the in-place tiles of each region read to a batch decoder
+    // (e.g. JpegBatchDecoder::CreateHardware()); tiles it leaves undecoded
+    // use libjpeg-turbo. nullptr restores CPU decoding. Not thread-safe:
+    // call before reads start.
+    void SetBatchDecoder(std::shared_ptr<JpegBatchDecoder> decoder);
+
+    // Hint how the whole file will be read
+    void Advise(TiffAccessPattern pattern) const;
+
+    // Ask the OS to start paging in the tiles behind a region in level
+    // coordinates (asynchronous; returns at once), or queue them for a
+    // remote file's prefetch thread. sequential also marks the range for
+    // streaming readahead. Returns the bytes hinted.
+    size_t Prewarm(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                   bool sequential = false) const;
+
+    // Read the tiles behind a region in level coordinates now, blocking,
+    // so a ReadRegion of it soon after finds their bytes in memory: the
+    // page cache (positional reads, batched), the mapping (every page
+    // touched) or the RemoteFile's block cache. Nothing is decoded.
+    // Returns the bytes fetched, 0 on failure or outside the level.
+    size_t Fetch(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height) const;
+    bool HasBatchDecoder() const { return batchDecoder_ != nullptr; }
+    size_t GetBatchDecodedCount() const { return batchDecodedCount_.load(); }
+
+private:
+    struct Directory {
+        int64_t width = 0;
+        int64_t height = 0;
+        int64_t tileWidth = 0;
+        int64_t tileHeight = 0;
+        uint32_t compression = 0;
+        uint32_t photometric = 0;
+        uint32_t samplesPerPixel = 1;
+        uint32_t bitsPerSample = 1;
+        uint32_t planarConfig = 1;
+        uint32_t predictor = 1;
+        std::string description;
+        std::vector<uint64_t> subDirectoryOffsets;
+        std::vector<int32_t> subDirectories;  // Parsed SubIFDs, as indices
+        std::vector<uint64_t> tileOffsets;
+        std::vector<uint64_t> tileByteCounts;
+        std::vector<uint8_t> jpegTables;
+
+        bool IsTiledJpeg() const;
+        bool IsTiledChannel() const;
+        int64_t TilesAcross() const { return (width + tileWidth - 1) / tileWidth; }
+        int64_t TilesDown() const { return (height + tileHeight - 1) / tileHeight; }
+    };
+
+    // Open path_ (mapping it if asked), close it, and set up batched
+    // positional reads when it is not mapped
+    bool OpenFile(bool memoryMap);
+    void CloseFile();
+    void CreateBatchReader();
+
+    bool ParseHeader();
+    void ParseDirectories();
+    bool ParseDirectory(uint64_t offset, Directory& directory, uint64_t& nextOffset);
+
+    // Positional read of exactly size bytes (from the region's staged
+    // tiles if LoadRegionTiles read them)
+    bool ReadAt(uint64_t offset, void* data, size_t size) const;
+    bool ReadFromFile(uint64_t offset, void* data, size_t size) const;
+
+    // Fetch every tile of [x0, x1) x [y0, y1) before a region read decodes
+    // them: one coalesced load for a remote file, one batch of positional
+    // reads staged for ReadAt (until the StagedRegion in scope ends) for a
+    // local one. A failure shows up as a failed tile read later.
+    void LoadRegionTiles(const Directory& directory, int64_t x0, int64_t y0, int64_t x1, int64_t y1) const;
+
+    bool MapFile();
+    void UnmapFile();
+    // Bytes at offset inside the mapping, or nullptr if unmapped / out of range
+    const uint8_t* MappedBytes(uint64_t offset, uint64_t size) const;
+    void AdviseRange(uint64_t offset, uint64_t size, bool sequential) const;
+
+    uint16_t ToHost16(uint16_t value) const;
+    uint32_t ToHost32(uint32_t value) const;
+    uint64_t ToHost64(uint64_t value) const;
+
+    // Raw bytes of one directory entry's values, inline or at their offset
+    bool ReadEntry(const uint8_t* entry, uint16_t& tag, uint16_t& type, std::vector<uint8_t>& values) const;
+    uint64_t EntryValue(const std::vector<uint8_t>& values, uint16_t type, size_t index) const;
+
+    // File range of an in-range tile; false if the tile is missing
+    bool TileRange(const Directory& directory, int64_t column, int64_t row,
+                   uint64_t& offset, uint64_t& size) const;
+
+    // File ranges (offset, end) of the tiles overlapping [x0, x1) x [y0, y1),
+    // which must lie inside the level
+    void RegionTileRanges(const Directory& directory, int64_t x0, int64_t y0, int64_t x1, int64_t y1,
+                          std::vector<std::pair<uint64_t, uint64_t>>& ranges) const;
+
+    // RegionTileRanges of a region of a slide level, clipped to the level
+    // (empty if it misses the level or the level is not served)
+    void LevelTileRanges(int32_t level, int64_t x, int64_t y, int64_t width, int64_t height,
+                         std::vector<std::pair<uint64_t, uint64_t>>& ranges) const;
+
+    // Stored bytes of an in-range tile; false if the tile is missing
+    bool ReadTileBytes(const Directory& directory, int64_t column, int64_t row,
+                       std::vector<uint8_t>& out) const;
+
+    // A tile as a self-contained JPEG stream: shared tables spliced in
+    bool ReadCompleteStream(const Directory& directory, int64_t column, int64_t row,
+                            std::vector<uint8_t>& out) const;
+
+    // Decode one whole tile into rows of stride pixels. Only the first
+    // rowCount rows are kept; the rest are decoded into scratch.
+    // With scale > 1 the tile decodes at 1/scale of its size (DCT scaling)
+    bool DecodeTile(const Directory& directory, int64_t column, int64_t row,
+                    uint32_t* pixels, int64_t stride, int64_t rowCount, int32_t scale = 1) const;
+    bool DecodeJpeg(const Directory& directory, const uint8_t* data, size_t size, bool sharedTables,
+                    uint32_t* pixels, int64_t stride, int64_t rowCount, int32_t scale = 1) const;
+
+    // Decode one whole channel tile into tileWidth * tileHeight samples
+    bool DecodeChannelTile(const Directory& directory, int64_t column, int64_t row, uint16_t* samples) const;
+    // Bytes of one tile as stored, from the mapping or read into scratch
+    const uint8_t* TileBytes(const Directory& directory, int64_t column, int64_t row,
+                             std::vector<uint8_t>& scratch, size_t& size) const;
+    // Channel names from the level 0 directories' descriptions
+    void ReadChannelNames(const std::vector<int32_t>& directories);
+
+    std::string path_;
+#ifdef _WIN32
+    void* file_ = nullptr;     // HANDLE
+    void* mapping_ = nullptr;  // File mapping HANDLE
+#else
+    int file_ = -1;
+#endif
+    std::shared_ptr<RemoteFile> remote_;
+    std::unique_ptr<AsyncFileReader> batchReader_;  // Positional reads only
+    const uint8_t* map_ = nullptr;
+    uint64_t mapSize_ = 0;
+    bool bigEndian_ = false;
+    bool bigTiff_ = false;
+    uint64_t firstDirectoryOffset_ = 0;
+
+    std::vector<Directory> directories_;  // Main chain, then SubIFDs
+    size_t mainDirectoryCount_ = 0;
+    std::vector<int32_t> levelDirectories_;  // Slide level -> directory, or -1
+    std::vector<std::vector<int32_t>> channelDirectories_;  // [level][channel] -> directory
+    std::vector<std::string> channelNames_;
+
+    std::shared_ptr<JpegBatchDecoder> batchDecoder_;
+    mutable std::atomic<size_t> batchDecodedCount_{0};
+};
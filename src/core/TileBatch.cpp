@@ -0,0 +1,77 @@
+#include "TileBatch.h"
+#include "Log.h"
+
+void TileBatch::AddQuad(RenderTexture* texture, const SDL_FRect& source, const SDL_FRect& dest,
+                        SDL_Color color) {
+    if (!texture) {
+        return;
+    }
+
+    // Few distinct textures per frame, so a linear search beats a map
+    Group* group = nullptr;
+    for (auto& g : groups_) {
+        if (g.texture == texture) {
+            group = &g;
+            break;
+        }
+    }
+    if (!group) {
+        groups_.push_back({texture, {}, {}});
+        group = &groups_.back();
+    }
+
+    float u0 = source.x;
+    float v0 = source.y;
+    float u1 = source.x + source.w;
+    float v1 = source.y + source.h;
+
+    float x0 = dest.x;
+    float y0 = dest.y;
+    float x1 = dest.x + dest.w;
+    float y1 = dest.y + dest.h;
+
+    int base = static_cast<int>(group->vertices.size());
+    group->vertices.push_back({{x0, y0}, color, {u0, v0}});
+    group->vertices.push_back({{x1, y0}, color, {u1, v0}});
+    group->vertices.push_back({{x1, y1}, color, {u1, v1}});
+    group->vertices.push_back({{x0, y1}, color, {u0, v1}});
+
+    // Two triangles per quad
+    const int quadIndices[6] = {0, 1, 2, 0, 2, 3};
+    for (int index : quadIndices) {
+        group->indices.push_back(base + index);
+    }
+
+    quadCount_++;
+}
+
+size_t TileBatch::Flush(RenderBackend& backend) {
+    size_t drawCalls = 0;
+    for (auto& group : groups_) {
+        if (group.indices.empty()) {
+            continue;
+        }
+        int32_t width = 0;
+        int32_t height = 0;
+        if (!backend.GetTextureSize(group.texture, &width, &height) || width <= 0 || height <= 0) {
+            PATHVIEW_LOG_ERROR("TileBatch: Cannot query texture size");
+            continue;
+        }
+
+        // Texel to normalized texture coordinates
+        const float invWidth = 1.0f / width;
+        const float invHeight = 1.0f / height;
+        for (SDL_Vertex& vertex : group.vertices) {
+            vertex.tex_coord.x *= invWidth;
+            vertex.tex_coord.y *= invHeight;
+        }
+        backend.DrawGeometry(group.texture,
+            group.vertices.data(), static_cast<int>(group.vertices.size()),
+            group.indices.data(), static_cast<int>(group.indices.size()), blendMode_);
+        drawCalls++;
+    }
+
+    groups_.clear();
+    quadCount_ = 0;
+    return drawCalls;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <vector>
+
+// Collects a frame's textured quads and draws them with one
+// RenderBackend::DrawGeometry call per texture. With tiles packed into atlas pages
+// (see TextureManager), a whole viewport costs a handful of draw calls
+// instead of one SDL_RenderCopy per tile and fallback.
+class TileBatch {
+public:
+    // Queue source (texels of texture) to be drawn at dest (screen pixels),
+    // its texels multiplied by color. Quads are drawn in the order their
+    // texture was first queued.
+    void AddQuad(RenderTexture* texture, const SDL_FRect& source, const SDL_FRect& dest,
+                 SDL_Color color = {255, 255, 255, 255});
+
+    // Blend mode for the next Flush instead of the textures' premultiplied
+    // one. SDL_BLENDMODE_INVALID (the default) keeps the textures'.
+    void SetBlendMode(SDL_BlendMode blendMode) { blendMode_ = blendMode; }
+
+    // Draw and clear everything queued. Returns the number of draw calls.
+    size_t Flush(RenderBackend& backend);
+
+    size_t GetQuadCount() const { return quadCount_; }
+    bool IsEmpty() const { return quadCount_ == 0; }
+
+private:
+    struct Group {
+        RenderTexture* texture;
+        std::vector<SDL_Vertex> vertices;  // Texture coordinates in texels until Flush
+        std::vector<int> indices;
+    };
+
+    std::vector<Group> groups_;
+    size_t quadCount_ = 0;
+    SDL_BlendMode blendMode_ = SDL_BLENDMODE_INVALID;
+};
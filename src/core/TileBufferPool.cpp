@@ -0,0 +1,321 @@
+#include "TileBufferPool.h"
+#include "Log.h"
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+TileBufferPool::TileBufferPool(size_t maxIdleBytes)
+    : maxIdleBytes_(maxIdleBytes)
+    , idleBytes_(0)
+    , liveBytes_(0)
+    , acquireCount_(0)
+    , reuseCount_(0)
+{
+}
+
+TileBufferPool::~TileBufferPool() {
+    // Every buffer is back by now: TileData keeps the pool alive
+    Trim();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!slabs_.empty()) {
+        UnmapSlab(slabs_.begin());
+    }
+}
+
+size_t TileBufferPool::ClassIndex(size_t pixelCount) {
+    size_t index = 0;
+    size_t classPixels = MIN_CLASS_PIXELS;
+    while (classPixels < pixelCount && index < NUM_CLASSES) {
+        classPixels <<= 1;
+        index++;
+    }
+    return index;
+}
+
+uint32_t* TileBufferPool::AllocateAligned(size_t pixelCount) {
+    return static_cast<uint32_t*>(
+        ::operator new(pixelCount * sizeof(uint32_t), std::align_val_t(ALIGNMENT)));
+}
+
+void TileBufferPool::FreeAligned(uint32_t* pixels) {
+    ::operator delete(pixels, std::align_val_t(ALIGNMENT));
+}
+
+std::optional<HugePageMode> TileBufferPool::ParseHugePageMode(const std::string& name) {
+    if (name == "off") {
+        return HugePageMode::Off;
+    }
+    if (name == "transparent") {
+        return HugePageMode::Transparent;
+    }
+    if (name == "explicit") {
+        return HugePageMode::Explicit;
+    }
+    return std::nullopt;
+}
+
+const char* TileBufferPool::HugePageModeName(HugePageMode mode) {
+    switch (mode) {
+        case HugePageMode::Transparent: return "transparent";
+        case HugePageMode::Explicit: return "explicit";
+        case HugePageMode::Off: break;
+    }
+    return "off";
+}
+
+void TileBufferPool::SetHugePages(HugePageMode mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hugePages_ = mode;
+}
+
+HugePageMode TileBufferPool::GetHugePages() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hugePages_;
+}
+
+#ifdef _WIN32
+namespace {
+
+// Large pages need SeLockMemoryPrivilege, which must be held and enabled
+bool EnableLockMemoryPrivilege() {
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+    TOKEN_PRIVILEGES privileges{};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                   AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                   GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return enabled;
+}
+
+}  // namespace
+#endif
+
+uint8_t* TileBufferPool::MapSlab(HugePageMode mode, HugePageMode* outBacking) {
+    *outBacking = HugePageMode::Off;
+#ifdef _WIN32
+    if (mode == HugePageMode::Explicit) {
+        static const bool privileged = EnableLockMemoryPrivilege();
+        SIZE_T largePage = GetLargePageMinimum();
+        if (privileged && largePage > 0 && SLAB_BYTES % largePage == 0) {
+            void* base = VirtualAlloc(nullptr, SLAB_BYTES, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                      PAGE_READWRITE);
+            if (base) {
+                *outBacking = HugePageMode::Explicit;
+                return static_cast<uint8_t*>(base);
+            }
+        }
+    }
+    // Windows has no transparent huge pages
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, SLAB_BYTES, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+#ifdef MAP_HUGETLB
+    if (mode == HugePageMode::Explicit) {
+        void* base = mmap(nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            *outBacking = HugePageMode::Explicit;
+            return static_cast<uint8_t*>(base);
+        }
+    }
+#endif
+    // Over-map and trim to a SLAB_BYTES boundary: the kernel only backs
+    // aligned ranges with transparent huge pages
+    void* mapping = mmap(nullptr, 2 * SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned = (start + SLAB_BYTES - 1) & ~static_cast<uintptr_t>(SLAB_BYTES - 1);
+    if (aligned > start) {
+        munmap(mapping, aligned - start);
+    }
+    if (aligned + SLAB_BYTES < start + 2 * SLAB_BYTES) {
+        munmap(reinterpret_cast<void*>(aligned + SLAB_BYTES), start + 2 * SLAB_BYTES - (aligned + SLAB_BYTES));
+    }
+    uint8_t* base = reinterpret_cast<uint8_t*>(aligned);
+#ifdef MADV_HUGEPAGE
+    if (mode != HugePageMode::Off && madvise(base, SLAB_BYTES, MADV_HUGEPAGE) == 0) {
+        *outBacking = HugePageMode::Transparent;
+    }
+#endif
+    return base;
+#endif
+}
+
+void TileBufferPool::ReleaseSlab(uint8_t* base) {
+#ifdef _WIN32
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, SLAB_BYTES);
+#endif
+}
+
+uint32_t* TileBufferPool::CarveSlab(size_t classIndex) {
+    HugePageMode mode = hugePages_ == HugePageMode::Explicit && explicitUnavailable_
+        ? HugePageMode::Transparent : hugePages_;
+    HugePageMode backing = HugePageMode::Off;
+    uint8_t* base = MapSlab(mode, &backing);
+    if (!base) {
+        return nullptr;
+    }
+    if (mode == HugePageMode::Explicit && backing != HugePageMode::Explicit) {
+        explicitUnavailable_ = true;
+        PATHVIEW_LOG_WARNING("TileBufferPool: No explicit huge pages available, "
+                             << (backing == HugePageMode::Transparent ? "using transparent ones" : "using normal pages"));
+    }
+
+    size_t classBytes = ClassPixels(classIndex) * sizeof(uint32_t);
+    Slab slab;
+    slab.classIndex = classIndex;
+    slab.buffers = SLAB_BYTES / classBytes;
+    slab.idleBuffers = slab.buffers - 1;
+    slab.huge = backing != HugePageMode::Off;
+    slabs_.emplace(reinterpret_cast<uintptr_t>(base), slab);
+    slabBytes_ += SLAB_BYTES;
+    hugePageBytes_ += slab.huge ? SLAB_BYTES : 0;
+
+    // Handed out back to front, so the first buffer goes last
+    auto& freeList = freeLists_[classIndex];
+    for (size_t i = slab.buffers - 1; i > 0; --i) {
+        freeList.push_back(reinterpret_cast<uint32_t*>(base + i * classBytes));
+    }
+    idleBytes_ += slab.idleBuffers * classBytes;
+    return reinterpret_cast<uint32_t*>(base);
+}
+
+std::map<uintptr_t, TileBufferPool::Slab>::iterator TileBufferPool::FindSlab(const uint32_t* pixels) {
+    if (slabs_.empty()) {
+        return slabs_.end();
+    }
+    uintptr_t address = reinterpret_cast<uintptr_t>(pixels);
+    auto it = slabs_.upper_bound(address);
+    if (it == slabs_.begin()) {
+        return slabs_.end();
+    }
+    --it;
+    return address < it->first + SLAB_BYTES ? it : slabs_.end();
+}
+
+void TileBufferPool::UnmapSlab(std::map<uintptr_t, Slab>::iterator slab) {
+    uintptr_t base = slab->first;
+    size_t classBytes = ClassPixels(slab->second.classIndex) * sizeof(uint32_t);
+    auto& freeList = freeLists_[slab->second.classIndex];
+    freeList.erase(std::remove_if(freeList.begin(), freeList.end(), [&](uint32_t* pixels) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(pixels);
+        return address >= base && address < base + SLAB_BYTES;
+    }), freeList.end());
+    idleBytes_ -= slab->second.idleBuffers * classBytes;
+    slabBytes_ -= SLAB_BYTES;
+    hugePageBytes_ -= slab->second.huge ? SLAB_BYTES : 0;
+    ReleaseSlab(reinterpret_cast<uint8_t*>(base));
+    slabs_.erase(slab);
+}
+
+uint32_t* TileBufferPool::Acquire(size_t pixelCount, size_t* outCapacity) {
+    acquireCount_++;
+    size_t index = ClassIndex(pixelCount);
+
+    // Oversized request: exact-size allocation, never pooled
+    if (index >= NUM_CLASSES) {
+        *outCapacity = pixelCount;
+        liveBytes_ += pixelCount * sizeof(uint32_t);
+        return AllocateAligned(pixelCount);
+    }
+
+    size_t capacity = ClassPixels(index);
+    *outCapacity = capacity;
+    liveBytes_ += capacity * sizeof(uint32_t);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& freeList = freeLists_[index];
+        if (!freeList.empty()) {
+            uint32_t* pixels = freeList.back();
+            freeList.pop_back();
+            idleBytes_ -= capacity * sizeof(uint32_t);
+            auto slab = FindSlab(pixels);
+            if (slab != slabs_.end()) {
+                slab->second.idleBuffers--;
+            }
+            reuseCount_++;
+            return pixels;
+        }
+        if (hugePages_ != HugePageMode::Off) {
+            if (uint32_t* pixels = CarveSlab(index)) {
+                return pixels;
+            }
+        }
+    }
+
+    return AllocateAligned(capacity);
+}
+
+void TileBufferPool::Release(uint32_t* pixels, size_t capacity) {
+    if (!pixels) {
+        return;
+    }
+
+    size_t bytes = capacity * sizeof(uint32_t);
+    liveBytes_ -= bytes;
+
+    size_t index = ClassIndex(capacity);
+    if (index < NUM_CLASSES && ClassPixels(index) == capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto slab = FindSlab(pixels);
+        if (slab != slabs_.end()) {
+            // Slab buffers can't go back to the OS one by one: park it, and
+            // give the whole slab back once it is idle and over the cap
+            freeLists_[index].push_back(pixels);
+            idleBytes_ += bytes;
+            if (++slab->second.idleBuffers == slab->second.buffers && idleBytes_ > maxIdleBytes_) {
+                UnmapSlab(slab);
+            }
+            return;
+        }
+        if (idleBytes_ + bytes <= maxIdleBytes_) {
+            freeLists_[index].push_back(pixels);
+            idleBytes_ += bytes;
+            return;
+        }
+    }
+
+    FreeAligned(pixels);
+}
+
+void TileBufferPool::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t index = 0; index < NUM_CLASSES; ++index) {
+        // Heap buffers go; slab buffers stay until their slab is all idle
+        auto& freeList = freeLists_[index];
+        auto kept = std::remove_if(freeList.begin(), freeList.end(), [this](uint32_t* pixels) {
+            if (FindSlab(pixels) != slabs_.end()) {
+                return false;
+            }
+            FreeAligned(pixels);
+            return true;
+        });
+        idleBytes_ -= static_cast<size_t>(freeList.end() - kept) * ClassPixels(index) * sizeof(uint32_t);
+        freeList.erase(kept, freeList.end());
+    }
+    for (auto it = slabs_.begin(); it != slabs_.end(); ) {
+        auto slab = it++;
+        if (slab->second.idleBuffers == slab->second.buffers) {
+            UnmapSlab(slab);
+        }
+    }
+}
+
+TileBufferPool::Stats TileBufferPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {liveBytes_.load(), idleBytes_, acquireCount_.load(), reuseCount_.load(), slabBytes_, hugePageBytes_};
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// Where TileBufferPool gets class-sized buffers the free lists can't serve
+enum class HugePageMode {
+    Off,          // The heap, one buffer at a time (default)
+    Transparent,  // SLAB_BYTES slabs advised for transparent huge pages (Linux)
+    Explicit      // Slabs of reserved huge pages (Linux MAP_HUGETLB, Windows
+                  // large pages), else Transparent
+};
+
+// Recycling allocator for tile pixel buffers.
+//
+// Buffers are grouped into power-of-two size classes (16KB .. 1MB, i.e. up
+// to one full 512x512 ARGB tile) and are 64-byte aligned for SIMD kernels.
+// Released buffers go back onto their class's free list instead of the
+// heap, so steady-state panning reuses the same memory rather than churning
+// new[]/delete[]. Requests larger than the biggest class bypass the pool.
+//
+// With huge pages on (SetHugePages), class buffers are carved out of
+// SLAB_BYTES slabs mapped from the OS instead, so a multi-GB cache spans
+// a few thousand TLB entries rather than half a million, which conversion,
+// downsampling and upload walking whole tiles feel. A slab holds buffers
+// of one class and goes back to the OS only once all of them are idle;
+// until then its idle buffers stay on the free list whatever the idle cap.
+class TileBufferPool {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct Stats {
+        size_t liveBytes;      // Capacity currently handed out
+        size_t idleBytes;      // Capacity parked on free lists
+        size_t acquireCount;   // Total Acquire() calls
+        size_t reuseCount;     // Acquires served from a free list
+        size_t slabBytes;      // Mapped in slabs (see SetHugePages)
+        size_t hugePageBytes;  // Of those, on explicit huge pages or advised
+                               // for transparent ones
+    };
+
+    static constexpr size_t SLAB_BYTES = 2 * 1024 * 1024;  // One x86-64 / ARM64 huge page
+
+    // maxIdleBytes caps memory retained on free lists; beyond it released
+    // buffers are returned to the heap
+    explicit TileBufferPool(size_t maxIdleBytes = 64 * 1024 * 1024); // Default: 64MB
+    ~TileBufferPool();
+
+    TileBufferPool(const TileBufferPool&) = delete;
+    TileBufferPool& operator=(const TileBufferPool&) = delete;
+
+    // Get a buffer holding at least pixelCount pixels.
+    // outCapacity receives the real capacity, which must be passed to Release().
+    uint32_t* Acquire(size_t pixelCount, size_t* outCapacity);
+
+    // Return a buffer obtained from Acquire()
+    void Release(uint32_t* pixels, size_t capacity);
+
+    // Free every idle heap buffer and every slab with no live buffer
+    void Trim();
+
+    // Back class buffers allocated from now on with huge-page slabs (or
+    // the heap again, for Off). Buffers already handed out keep their
+    // backing. Falls back a step, logging once, when the OS has no huge
+    // pages to give.
+    void SetHugePages(HugePageMode mode);
+    HugePageMode GetHugePages() const;
+
+    static std::optional<HugePageMode> ParseHugePageMode(const std::string& name);
+    static const char* HugePageModeName(HugePageMode mode);
+
+    Stats GetStats() const;
+
+private:
+    static constexpr size_t MIN_CLASS_PIXELS = 4 * 1024;     // 16KB
+    static constexpr size_t MAX_CLASS_PIXELS = 256 * 1024;   // 1MB (512x512)
+    static constexpr size_t NUM_CLASSES = 7;                 // 4K, 8K, ..., 256K pixels
+
+    // Index of the smallest class that fits, or NUM_CLASSES if none does
+    static size_t ClassIndex(size_t pixelCount);
+    static size_t ClassPixels(size_t classIndex) { return MIN_CLASS_PIXELS << classIndex; }
+
+    static uint32_t* AllocateAligned(size_t pixelCount);
+    static void FreeAligned(uint32_t* pixels);
+
+    // A SLAB_BYTES mapping carved into buffers of one class
+    struct Slab {
+        size_t classIndex;
+        size_t buffers;       // SLAB_BYTES / class bytes
+        size_t idleBuffers;   // On the free list
+        bool huge;
+    };
+
+    // All require mutex_ to be held
+    // Map a slab for classIndex, put all but its first buffer on the free
+    // list and return that one; nullptr if the OS has no memory to map
+    uint32_t* CarveSlab(size_t classIndex);
+    // The slab pixels lies in, or slabs_.end() for a heap buffer
+    std::map<uintptr_t, Slab>::iterator FindSlab(const uint32_t* pixels);
+    // Take the slab's idle buffers off the free list and unmap it
+    void UnmapSlab(std::map<uintptr_t, Slab>::iterator slab);
+
+    // Platform mapping of SLAB_BYTES, SLAB_BYTES aligned where it can be:
+    // explicit huge pages, else transparent, else plain pages, no better
+    // than mode. *outBacking is what it got (Off: plain pages).
+    static uint8_t* MapSlab(HugePageMode mode, HugePageMode* outBacking);
+    static void ReleaseSlab(uint8_t* base);
+
+    std::array<std::vector<uint32_t*>, NUM_CLASSES> freeLists_;
+    mutable std::mutex mutex_;
+
+    HugePageMode hugePages_ = HugePageMode::Off;
+    bool explicitUnavailable_ = false;  // An Explicit slab fell back once
+    std::map<uintptr_t, Slab> slabs_;   // By base address
+    size_t slabBytes_ = 0;
+    size_t hugePageBytes_ = 0;
+
+    size_t maxIdleBytes_;
+    size_t idleBytes_;
+    std::atomic<size_t> liveBytes_;
+    std::atomic<size_t> acquireCount_;
+    std::atomic<size_t> reuseCount_;
+};
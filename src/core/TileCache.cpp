@@ -1,38 +1,81 @@
 #include "TileCache.h"
-#include <iostream>
-#include <mutex>
+#include "PixelConvert.h"
+#include "Log.h"
+#include <algorithm>
+
+const uint32_t* TileData::GetArgb(std::vector<uint32_t>& scratch) const {
+    if (storage == TileStorage::Argb) {
+        return pixels;
+    }
+    const size_t count = static_cast<size_t>(width) * height;
+    scratch.resize(count);
+    if (storage == TileStorage::Solid) {
+        std::fill(scratch.begin(), scratch.end(), solidColor);
+    } else if (storage == TileStorage::Rgb) {
+        PixelConvert::ConvertRow<PixelLayout::RGB24, PixelLayout::ARGB32, AlphaMode::Keep>(
+            pixels, scratch.data(), count);
+    } else {
+        PixelConvert::Yuv420ToArgb(reinterpret_cast<const uint8_t*>(pixels), width, height, scratch.data(),
+                                   static_cast<size_t>(width));
+    }
+    return scratch.data();
+}
+
+size_t TileData::StorageBytes(TileStorage storage, int32_t width, int32_t height) {
+    const size_t count = static_cast<size_t>(width) * height;
+    switch (storage) {
+        case TileStorage::Rgb: return count * 3;
+        case TileStorage::Yuv420: return PixelConvert::Yuv420Bytes(width, height);
+        case TileStorage::Solid: return 0;
+        case TileStorage::Argb: break;
+    }
+    return count * sizeof(uint32_t);
+}
 
 TileCache::TileCache(size_t maxMemoryBytes)
-    : maxMemoryBytes_(maxMemoryBytes)
+    : bufferPool_(std::make_shared<TileBufferPool>())
+    , maxMemoryBytes_(maxMemoryBytes)
     , currentMemoryUsage_(0)
+    , tileCount_(0)
     , hitCount_(0)
     , missCount_(0)
 {
-    std::cout << "TileCache initialized with " << (maxMemoryBytes_ / (1024 * 1024))
-              << "MB max memory" << std::endl;
+    PATHVIEW_LOG_INFO("TileCache initialized with " << (maxMemoryBytes_.load() / (1024 * 1024))
+                      << "MB max memory");
 }
 
 TileCache::~TileCache() {
     Clear();
 
-    std::cout << "TileCache statistics:" << std::endl;
-    std::cout << "  Total requests: " << (hitCount_ + missCount_) << std::endl;
-    std::cout << "  Cache hits: " << hitCount_ << std::endl;
-    std::cout << "  Cache misses: " << missCount_ << std::endl;
-    std::cout << "  Hit rate: " << (GetHitRate() * 100.0) << "%" << std::endl;
+    PATHVIEW_LOG_INFO("TileCache statistics:");
+    PATHVIEW_LOG_INFO("  Total requests: " << (hitCount_ + missCount_));
+    PATHVIEW_LOG_INFO("  Cache hits: " << hitCount_);
+    PATHVIEW_LOG_INFO("  Cache misses: " << missCount_);
+    PATHVIEW_LOG_INFO("  Hit rate: " << (GetHitRate() * 100.0) << "%");
 }
 
-const TileData* TileCache::GetTile(const TileKey& key) {
-    // Use unique_lock because TouchTile modifies LRU list on hit
-    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+TileCache::Shard& TileCache::ShardFor(const TileKey& key) {
+    // Mix the key hash so neighbouring tiles land in different shards
+    uint64_t h = static_cast<uint64_t>(TileKeyHash{}(key)) * 0x9E3779B97F4A7C15ull;
+    return shards_[(h >> 32) % NUM_SHARDS];
+}
 
-    auto it = cache_.find(key);
+const TileCache::Shard& TileCache::ShardFor(const TileKey& key) const {
+    return const_cast<TileCache*>(this)->ShardFor(key);
+}
 
-    if (it != cache_.end()) {
+TileHandle TileCache::GetTile(const TileKey& key) {
+    // Shared lock only: a hit just sets the entry's reference bit
+    Shard& shard = ShardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+
+    if (it != shard.entries.end()) {
         // Cache hit
         hitCount_++;
-        TouchTile(key);
-        return &it->second.data;
+        it->second.Reference();
+        return it->second.data;
     }
 
     // Cache miss
@@ -41,67 +84,313 @@ const TileData* TileCache::GetTile(const TileKey& key) {
 }
 
 void TileCache::InsertTile(const TileKey& key, TileData&& data) {
-    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    // Before any lock: packing reads every pixel
+    Pack(data);
+
+    // Serializes writers with each other, never with readers
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    Shard& shard = ShardFor(key);
 
     // Check if already in cache
-    if (cache_.find(key) != cache_.end()) {
-        // Already cached, just touch it
-        TouchTile(key);
-        return;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            // Already cached, just touch it
+            it->second.Reference();
+            return;
+        }
     }
 
     size_t tileMemory = data.memorySize;
+    const TileStorage storage = data.storage;
 
-    // Evict LRU tiles if necessary to make room
-    while (currentMemoryUsage_ + tileMemory > maxMemoryBytes_ && !lruList_.empty()) {
-        EvictLRU();
+    // Evict tiles if necessary to make room, but no more than the tile
+    // needs: after a shrink, the backlog is left to EvictLRU()
+    size_t usageBefore = currentMemoryUsage_;
+    while (currentMemoryUsage_ + tileMemory > maxMemoryBytes_ &&
+           usageBefore - currentMemoryUsage_ < tileMemory && EvictOne()) {
     }
 
-    // Add to front of LRU list (most recent)
-    lruList_.push_front(key);
-    auto lruIt = lruList_.begin();
-
-    // Insert into cache
-    cache_.emplace(key, CacheEntry(std::move(data), lruIt));
+    // Insert into its shard, then at the back of the CLOCK queue (newest),
+    // or of probation
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        CacheEntry& entry = shard.entries.try_emplace(key, std::move(data)).first->second;
+        if (!TryPin(key, entry)) {
+            (policy_ == TileEvictionPolicy::ScanResistant ? probationQueue_ : clockQueue_).push_back(key);
+        }
+    }
 
     currentMemoryUsage_ += tileMemory;
+    tileCount_++;
+    CountStorage(storage, true);
 }
 
 bool TileCache::HasTile(const TileKey& key) const {
-    std::shared_lock<std::shared_mutex> lock(cacheMutex_);
-    return cache_.find(key) != cache_.end();
+    const Shard& shard = ShardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.entries.find(key) != shard.entries.end();
 }
 
 void TileCache::Clear() {
-    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
-    cache_.clear();
-    lruList_.clear();
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    for (auto& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+    clockQueue_.clear();
+    probationQueue_.clear();
     currentMemoryUsage_ = 0;
+    pinnedMemory_ = 0;
+    tileCount_ = 0;
+    packedTileCount_ = 0;
+    solidTileCount_ = 0;
+    compressedTier_.Clear();
 }
 
-void TileCache::EvictLRU() {
-    if (lruList_.empty()) {
+size_t TileCache::RemoveSlide(uint32_t slide) {
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    size_t before = currentMemoryUsage_;
+    for (auto& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if (it->first.slide != slide) {
+                ++it;
+                continue;
+            }
+            currentMemoryUsage_ -= it->second.data->memorySize;
+            if (it->second.pinned) {
+                pinnedMemory_ -= it->second.data->memorySize;
+            }
+            tileCount_--;
+            CountStorage(it->second.data->storage, false);
+            it = shard.entries.erase(it);
+        }
+    }
+    pinnedLevels_.erase(slide);
+
+    // The sweep skips keys that are gone, but a large slide would leave
+    // the queues long until then
+    for (std::deque<TileKey>* queue : {&clockQueue_, &probationQueue_}) {
+        queue->erase(std::remove_if(queue->begin(), queue->end(),
+                                    [slide](const TileKey& key) { return key.slide == slide; }),
+                     queue->end());
+    }
+    compressedTier_.RemoveSlide(slide);
+    return before - currentMemoryUsage_;
+}
+
+size_t TileCache::EvictLRU(size_t maxTiles) {
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    size_t before = currentMemoryUsage_;
+    for (size_t i = 0; i < maxTiles && currentMemoryUsage_ > maxMemoryBytes_ && EvictOne(); ++i) {
+    }
+    return before - currentMemoryUsage_;
+}
+
+void TileCache::SetEvictionPolicy(TileEvictionPolicy policy) {
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    policy_ = policy;
+    clockQueue_.insert(clockQueue_.end(), probationQueue_.begin(), probationQueue_.end());
+    probationQueue_.clear();
+}
+
+void TileCache::PinLevels(uint32_t slide, int32_t firstLevel) {
+    std::lock_guard<std::mutex> evictionLock(evictionMutex_);
+    auto pin = pinnedLevels_.find(slide);
+    const bool fewer = pin != pinnedLevels_.end() && firstLevel > pin->second;
+    pinnedLevels_[slide] = firstLevel;
+
+    // Tiles of newly pinned levels are pinned as the hand reaches them;
+    // those of levels no longer pinned go back into the CLOCK now
+    if (!fewer) {
         return;
     }
+    for (auto& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (auto& [key, entry] : shard.entries) {
+            if (entry.pinned && key.slide == slide && key.level < firstLevel) {
+                entry.pinned = false;
+                pinnedMemory_ -= entry.data->memorySize;
+                clockQueue_.push_back(key);
+            }
+        }
+    }
+}
 
-    // Get least recently used tile (back of list)
-    TileKey lruKey = lruList_.back();
-    lruList_.pop_back();
+std::optional<TileEvictionPolicy> TileCache::ParseEvictionPolicy(const std::string& name) {
+    if (name == "clock") return TileEvictionPolicy::Clock;
+    if (name == "scan-resistant") return TileEvictionPolicy::ScanResistant;
+    return std::nullopt;
+}
+
+const char* TileCache::EvictionPolicyName(TileEvictionPolicy policy) {
+    return policy == TileEvictionPolicy::ScanResistant ? "scan-resistant" : "clock";
+}
 
-    // Find and remove from cache
-    auto it = cache_.find(lruKey);
-    if (it != cache_.end()) {
-        currentMemoryUsage_ -= it->second.data.memorySize;
-        cache_.erase(it);
+std::optional<TileStorage> TileCache::ParseStorage(const std::string& name) {
+    if (name == "argb") return TileStorage::Argb;
+    if (name == "rgb") return TileStorage::Rgb;
+    if (name == "yuv420") return TileStorage::Yuv420;
+    return std::nullopt;
+}
+
+const char* TileCache::StorageName(TileStorage storage) {
+    switch (storage) {
+        case TileStorage::Rgb: return "rgb";
+        case TileStorage::Yuv420: return "yuv420";
+        case TileStorage::Solid: return "solid";
+        case TileStorage::Argb: break;
+    }
+    return "argb";
+}
+
+bool TileCache::FindSolidColor(const uint32_t* pixels, size_t count, uint32_t* outColor) {
+    if (count == 0) {
+        return false;
+    }
+    // Differences are OR-ed over blocks without branching, which the
+    // compiler vectorizes; tissue differs within the first block or two
+    constexpr size_t BLOCK = 64;
+    const uint32_t color = pixels[0];
+    for (size_t start = 0; start < count; start += BLOCK) {
+        const size_t end = std::min(count, start + BLOCK);
+        uint32_t diff = 0;
+        for (size_t i = start; i < end; ++i) {
+            diff |= pixels[i] ^ color;
+        }
+        if (diff != 0) {
+            return false;
+        }
+    }
+    *outColor = color;
+    return true;
+}
+
+void TileCache::CountStorage(TileStorage storage, bool added) {
+    std::atomic<size_t>* counter = storage == TileStorage::Solid ? &solidTileCount_
+                                 : storage != TileStorage::Argb  ? &packedTileCount_ : nullptr;
+    if (counter) {
+        added ? (*counter)++ : (*counter)--;
     }
 }
 
-void TileCache::TouchTile(const TileKey& key) {
-    auto it = cache_.find(key);
-    if (it == cache_.end()) {
+void TileCache::Pack(TileData& data) const {
+    if (data.storage != TileStorage::Argb || !data.pixels) {
         return;
     }
+    const size_t count = static_cast<size_t>(data.width) * data.height;
+
+    // Uniform tiles keep just their color; partly transparent ones would
+    // need blending to draw flat, so they are left alone
+    uint32_t color = 0;
+    if (solidTiles_.load(std::memory_order_relaxed) && FindSolidColor(data.pixels, count, &color) &&
+        ((color >> 24) == 0xFF || color == 0)) {
+        TileData result(nullptr, data.width, data.height);
+        result.memorySize = 0;
+        result.storage = TileStorage::Solid;
+        result.solidColor = color;
+        result.requestTime = data.requestTime;
+        data = std::move(result);  // Hands the ARGB buffer back to its pool
+        return;
+    }
+
+    const TileStorage storage = storage_.load(std::memory_order_relaxed);
+    if (storage == TileStorage::Argb) {
+        return;
+    }
+    uint32_t alpha = 0xFF000000u;
+    for (size_t i = 0; i < count; ++i) {
+        alpha &= data.pixels[i];
+    }
+    if (alpha != 0xFF000000u) {
+        return;  // Transparent pixels need their alpha
+    }
+
+    // Exactly sized, off the pool: its size classes are powers of two
+    const size_t bytes = TileData::StorageBytes(storage, data.width, data.height);
+    uint32_t* packed = new uint32_t[(bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
+    if (storage == TileStorage::Rgb) {
+        PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGB24, AlphaMode::Opaque>(
+            data.pixels, packed, count);
+    } else {
+        PixelConvert::ArgbToYuv420(data.pixels, data.width, data.height, static_cast<size_t>(data.width),
+                                   reinterpret_cast<uint8_t*>(packed));
+    }
+    TileData result(packed, data.width, data.height);
+    result.memorySize = bytes;
+    result.storage = storage;
+    result.requestTime = data.requestTime;
+    data = std::move(result);  // Hands the ARGB buffer back to its pool
+}
+
+size_t TileCache::AutoSizeMaxMemory(size_t physicalBytes) {
+    if (physicalBytes == 0) {
+        return DEFAULT_MAX_MEMORY;
+    }
+    return std::clamp(physicalBytes / 8, MIN_AUTO_MEMORY, MAX_AUTO_MEMORY);
+}
+
+bool TileCache::TryPin(const TileKey& key, CacheEntry& entry) {
+    auto pin = pinnedLevels_.find(key.slide);
+    if (pin == pinnedLevels_.end() || key.level < pin->second) {
+        return false;
+    }
+    const size_t size = entry.data->memorySize;
+    if (pinnedMemory_ + size > static_cast<size_t>(maxMemoryBytes_ * MAX_PINNED_FRACTION)) {
+        return false;
+    }
+    entry.pinned = true;
+    pinnedMemory_ += size;
+    return true;
+}
+
+bool TileCache::EvictOne() {
+    // CLOCK sweep: the oldest tile is evicted unless it was read since the
+    // hand last passed it, in which case it gets a second chance at the back.
+    // Terminates because every pass clears the bits it skips over and uses
+    // up the chances of the unread. Under ScanResistant, probation is swept
+    // first while over its share: a tile read again since its first draw
+    // moves on to the CLOCK, any other is evicted.
+    while (!clockQueue_.empty() || !probationQueue_.empty()) {
+        const size_t queued = clockQueue_.size() + probationQueue_.size();
+        const bool probation = !probationQueue_.empty() &&
+                               (clockQueue_.empty() || probationQueue_.size() > queued * PROBATION_FRACTION);
+        std::deque<TileKey>& queue = probation ? probationQueue_ : clockQueue_;
+        TileKey key = queue.front();
+        queue.pop_front();
+
+        Shard& shard = ShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end() || TryPin(key, it->second)) {
+            continue;
+        }
+
+        CacheEntry& entry = it->second;
+        const uint8_t references = entry.references.exchange(0, std::memory_order_relaxed);
+        if (probation ? references >= 2 : references > 0) {
+            entry.chances = policy_ == TileEvictionPolicy::ScanResistant
+                ? static_cast<uint8_t>(std::clamp<int32_t>(key.level, 0, MAX_LEVEL_CHANCES)) : 0;
+            clockQueue_.push_back(key);
+            continue;
+        }
+        if (!probation && entry.chances > 0) {
+            entry.chances--;
+            clockQueue_.push_back(key);
+            continue;
+        }
+
+        // Outstanding handles keep the pixels alive past this point
+        currentMemoryUsage_ -= entry.data->memorySize;
+        tileCount_--;
+        CountStorage(entry.data->storage, false);
+        evictionCount_++;
+        shard.entries.erase(it);
+        return true;
+    }
 
-    // Move to front of LRU list (most recent)
-    lruList_.splice(lruList_.begin(), lruList_, it->second.lruIterator);
+    return false;
 }
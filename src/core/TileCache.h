@@ -1,46 +1,86 @@
 #pragma once
 
 #include "TextureManager.h"
-#include <unordered_map>
-#include <list>
+#include "FlatTileMap.h"
+#include "TileBufferPool.h"
+#include "CompressedTileCache.h"
+#include <array>
+#include <deque>
+#include <mutex>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <shared_mutex>
+#include <string>
+#include <unordered_map>
 #include <functional>
 #include <atomic>
+#include <chrono>
+#include <vector>
+
+// How a cached tile's pixels are laid out (see TileCache::SetStorage)
+enum class TileStorage : uint8_t {
+    Argb,    // 4 bytes a pixel, as decoded (TextureManager::TILE_PIXEL_FORMAT)
+    Rgb,     // 3 bytes, exact: alpha dropped
+    Yuv420,  // 1.5 bytes, lossy: chroma per 2x2 pixels (PixelConvert::ArgbToYuv420)
+    Solid    // No pixels: every one is solidColor (TileCache::SetSolidTiles)
+};
 
 // Tile data storage
 struct TileData {
-    uint32_t* pixels;    // RGBA pixel data
+    uint32_t* pixels;    // Premultiplied ARGB pixel data, or packed as storage says
     int32_t width;
     int32_t height;
     size_t memorySize;   // Memory usage in bytes
+    TileStorage storage = TileStorage::Argb;
+    uint32_t solidColor = 0;  // Solid tiles: the one pixel value
+
+    // Set when pixels came from a TileBufferPool; the buffer is handed back
+    // to the pool instead of delete[]. Shared so a tile handle may safely
+    // outlive the cache that owns the pool.
+    std::shared_ptr<TileBufferPool> pool;
+    size_t capacity;     // Pool capacity in pixels (0 for new[] buffers)
+
+    // When the tile was first requested (unset if unknown), for measuring
+    // time to first pixel
+    std::chrono::steady_clock::time_point requestTime;
+    // Set by the renderer once FirstDraw is recorded; fresh tiles start clear
+    mutable std::atomic<bool> firstDrawn{false};
 
-    TileData() : pixels(nullptr), width(0), height(0), memorySize(0) {}
+    TileData() : pixels(nullptr), width(0), height(0), memorySize(0), capacity(0) {}
 
     TileData(uint32_t* p, int32_t w, int32_t h)
-        : pixels(p), width(w), height(h), memorySize(w * h * sizeof(uint32_t)) {}
+        : pixels(p), width(w), height(h), memorySize(w * h * sizeof(uint32_t)), capacity(0) {}
+
+    TileData(uint32_t* p, int32_t w, int32_t h, std::shared_ptr<TileBufferPool> bufferPool, size_t cap)
+        : pixels(p), width(w), height(h), memorySize(w * h * sizeof(uint32_t))
+        , pool(std::move(bufferPool)), capacity(cap) {}
 
     ~TileData() {
-        if (pixels) {
-            delete[] pixels;
-            pixels = nullptr;
-        }
+        Free();
     }
 
     // Move semantics
     TileData(TileData&& other) noexcept
-        : pixels(other.pixels), width(other.width), height(other.height), memorySize(other.memorySize) {
+        : pixels(other.pixels), width(other.width), height(other.height), memorySize(other.memorySize)
+        , storage(other.storage), solidColor(other.solidColor), pool(std::move(other.pool)), capacity(other.capacity)
+        , requestTime(other.requestTime), firstDrawn(other.firstDrawn.load(std::memory_order_relaxed)) {
         other.pixels = nullptr;
     }
 
     TileData& operator=(TileData&& other) noexcept {
         if (this != &other) {
-            if (pixels) delete[] pixels;
+            Free();
             pixels = other.pixels;
             width = other.width;
             height = other.height;
             memorySize = other.memorySize;
+            storage = other.storage;
+            solidColor = other.solidColor;
+            pool = std::move(other.pool);
+            capacity = other.capacity;
+            requestTime = other.requestTime;
+            firstDrawn.store(other.firstDrawn.load(std::memory_order_relaxed), std::memory_order_relaxed);
             other.pixels = nullptr;
         }
         return *this;
@@ -49,24 +89,84 @@ struct TileData {
     // Delete copy
     TileData(const TileData&) = delete;
     TileData& operator=(const TileData&) = delete;
+
+    // The pixels as TILE_PIXEL_FORMAT: pixels itself for Argb tiles, else
+    // unpacked into scratch (resized to fit)
+    const uint32_t* GetArgb(std::vector<uint32_t>& scratch) const;
+
+    // Bytes of a width x height tile stored as storage
+    static size_t StorageBytes(TileStorage storage, int32_t width, int32_t height);
+
+private:
+    void Free() {
+        if (pixels) {
+            if (pool) {
+                pool->Release(pixels, capacity);
+            } else {
+                delete[] pixels;
+            }
+            pixels = nullptr;
+        }
+    }
 };
 
-// Cache entry with LRU metadata
+// Pinned, shared-ownership handle to cached tile data.
+// Eviction only drops the cache's reference: pixels stay valid until the
+// last handle is released, so readers may use a tile after the shard lock
+// is gone without racing a worker's InsertTile.
+using TileHandle = std::shared_ptr<const TileData>;
+
+// Cache entry with CLOCK (second-chance) metadata.
+// Reads are counted by readers under a shared lock, so cache hits never
+// contend with each other or wait on the eviction sweep. The rest is only
+// touched by writers, under the cache's eviction mutex.
 struct CacheEntry {
-    TileData data;
-    std::list<TileKey>::iterator lruIterator;
+    TileHandle data;
+    std::atomic<uint8_t> references;  // Reads since the hand last passed, saturating
+    uint8_t chances = 0;              // Unread sweeps left (level weighting)
+    bool pinned = false;              // Out of the queues, never evicted
+
+    explicit CacheEntry(TileData&& d)
+        : data(std::make_shared<const TileData>(std::move(d))), references(0) {}
+
+    // For FlatTileMap growth, under the shard's exclusive lock
+    CacheEntry(CacheEntry&& other) noexcept
+        : data(std::move(other.data)), references(other.references.load(std::memory_order_relaxed))
+        , chances(other.chances), pinned(other.pinned) {}
+
+    void Reference() {
+        // Lost increments between racing readers do not matter
+        uint8_t count = references.load(std::memory_order_relaxed);
+        if (count < MAX_REFERENCES) {
+            references.store(count + 1, std::memory_order_relaxed);
+        }
+    }
 
-    CacheEntry(TileData&& d, std::list<TileKey>::iterator it)
-        : data(std::move(d)), lruIterator(it) {}
+    static constexpr uint8_t MAX_REFERENCES = 3;
+};
+
+// How TileCache picks the tile to evict
+enum class TileEvictionPolicy {
+    // CLOCK: the oldest tile not read since the hand last passed it
+    Clock,
+    // 2Q on CLOCK, level weighted. New tiles wait in a probation FIFO and
+    // only enter the main CLOCK once read again after their first draw, so
+    // a fast fling through level 0 cycles through probation instead of
+    // flushing the tiles that are in use. In the main CLOCK a tile of
+    // level L survives up to L extra sweeps unread (at most
+    // MAX_LEVEL_CHANCES): coarse tiles cover more of the slide and are
+    // the fallback under every finer one.
+    ScanResistant
 };
 
 class TileCache {
 public:
-    explicit TileCache(size_t maxMemoryBytes = 512 * 1024 * 1024); // Default: 512MB
+    explicit TileCache(size_t maxMemoryBytes = DEFAULT_MAX_MEMORY);
     ~TileCache();
 
-    // Get tile data (returns nullptr if not in cache)
-    const TileData* GetTile(const TileKey& key);
+    // Get tile data (returns an empty handle if not in cache).
+    // Hold the handle for as long as the pixels are in use.
+    TileHandle GetTile(const TileKey& key);
 
     // Insert tile data (takes ownership of pixels)
     void InsertTile(const TileKey& key, TileData&& data);
@@ -74,33 +174,156 @@ public:
     // Check if tile is cached
     bool HasTile(const TileKey& key) const;
 
-    // Clear all cached tiles
+    // Clear all cached tiles (both tiers)
     void Clear();
 
+    // Drop every tile of one slide (TileKey::slide) from both tiers, once
+    // it is closed, so the slides still open get the whole budget back.
+    // Returns the pixel tier bytes freed.
+    size_t RemoveSlide(uint32_t slide);
+
+    // Second tier of compressed tiles, kept in RAM after the pixel tier
+    // evicts them; disabled (0 bytes) until given a budget. Decode workers
+    // fill and read it, see TileLoadThreadPool.
+    CompressedTileCache& GetCompressedTier() { return compressedTier_; }
+    const CompressedTileCache& GetCompressedTier() const { return compressedTier_; }
+
+    // Resize at runtime. Shrinking evicts nothing by itself: inserts only
+    // evict enough for the incoming tile, and EvictLRU() works off the rest
+    // a few tiles at a time, so readers and workers never stall on a
+    // large shrink.
+    void SetMaxMemory(size_t maxMemoryBytes) { maxMemoryBytes_ = maxMemoryBytes; }
+
+    // Evict up to maxTiles tiles (CLOCK order) while usage is over the
+    // limit. Returns the bytes freed.
+    size_t EvictLRU(size_t maxTiles);
+
+    // Eviction order (Clock by default). Switching keeps every tile;
+    // those on probation join the main CLOCK.
+    void SetEvictionPolicy(TileEvictionPolicy policy);
+    TileEvictionPolicy GetEvictionPolicy() const { return policy_; }
+
+    // Never evict tiles of slide at firstLevel and coarser (higher level
+    // indices): the fallback drawn under everything that is still loading.
+    // Pinned tiles count towards the limit but take at most
+    // MAX_PINNED_FRACTION of it; past that they are evicted as usual.
+    // Dropped with the slide's tiles by RemoveSlide().
+    void PinLevels(uint32_t slide, int32_t firstLevel);
+    size_t GetPinnedMemory() const { return pinnedMemory_; }
+
+    static std::optional<TileEvictionPolicy> ParseEvictionPolicy(const std::string& name);
+    static const char* EvictionPolicyName(TileEvictionPolicy policy);
+
+    // Keep opaque tiles packed as RGB (3/4 of the memory, exact) or YUV
+    // 4:2:0 (3/8, lossy) instead of ARGB, so the same budget holds a third
+    // to 2.7x more of them. Workers pack on insert, readers unpack with
+    // TileData::GetArgb() (the render thread right before upload); tiles
+    // with any transparency, as at a slide's edge, stay ARGB. Applies to
+    // tiles inserted from now on.
+    void SetStorage(TileStorage storage) { storage_ = storage; }
+    TileStorage GetStorage() const { return storage_; }
+    size_t GetPackedTileCount() const { return packedTileCount_; }
+
+    // Keep uniform tiles (glass, blank margins) as their one color
+    // (TileStorage::Solid) instead of pixels: workers check every tile
+    // on insert, and the buffer goes back to the pool straight away. The
+    // renderer draws them as filled rectangles without a texture, so they
+    // cost neither the pixel budget nor VRAM. Only opaque or fully
+    // transparent colors qualify. Applies to tiles inserted from now on.
+    void SetSolidTiles(bool enabled) { solidTiles_ = enabled; }
+    bool GetSolidTiles() const { return solidTiles_; }
+    size_t GetSolidTileCount() const { return solidTileCount_; }
+
+    // Whether every pixel has the same value, and if so which
+    static bool FindSolidColor(const uint32_t* pixels, size_t count, uint32_t* outColor);
+
+    // "argb", "rgb", "yuv420"
+    static std::optional<TileStorage> ParseStorage(const std::string& name);
+    static const char* StorageName(TileStorage storage);
+
+    static constexpr uint8_t MAX_LEVEL_CHANCES = 3;
+    static constexpr double PROBATION_FRACTION = 0.25;  // Of the queued tiles
+    static constexpr double MAX_PINNED_FRACTION = 0.25;
+
+    // Limit for a machine with physicalBytes of RAM (0 = unknown): an
+    // eighth of it within [MIN_AUTO_MEMORY, MAX_AUTO_MEMORY]
+    static size_t AutoSizeMaxMemory(size_t physicalBytes);
+
+    static constexpr size_t DEFAULT_MAX_MEMORY = 512ull * 1024 * 1024;
+    static constexpr size_t MIN_AUTO_MEMORY = 256ull * 1024 * 1024;
+    static constexpr size_t MAX_AUTO_MEMORY = 32ull * 1024 * 1024 * 1024;
+
+    // Allocator for tile pixel buffers; evicted tiles return their
+    // buffers here for reuse by the next load
+    std::shared_ptr<TileBufferPool> GetBufferPool() const { return bufferPool_; }
+
     // Cache statistics
-    size_t GetTileCount() const { return cache_.size(); }
+    size_t GetTileCount() const { return tileCount_; }
     size_t GetMemoryUsage() const { return currentMemoryUsage_; }
     size_t GetMaxMemory() const { return maxMemoryBytes_; }
+    TileBufferPool::Stats GetBufferPoolStats() const { return bufferPool_->GetStats(); }
     size_t GetHitCount() const { return hitCount_; }
     size_t GetMissCount() const { return missCount_; }
+    size_t GetEvictionCount() const { return evictionCount_; }
     double GetHitRate() const {
         size_t total = hitCount_ + missCount_;
         return total > 0 ? static_cast<double>(hitCount_) / total : 0.0;
     }
 
+    // Number of independently locked shards
+    static constexpr size_t NUM_SHARDS = 16;
+
 private:
-    void EvictLRU();
-    void TouchTile(const TileKey& key);
+    // Each shard owns a slice of the key space with its own lock, so the
+    // render thread's lookups only ever share a lock with readers of the
+    // same shard and with brief insert/erase sections.
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        FlatTileMap<CacheEntry> entries;
+    };
+
+    Shard& ShardFor(const TileKey& key);
+    const Shard& ShardFor(const TileKey& key) const;
+
+    // Repack an ARGB tile as Solid if it is uniform, else as storage_ if
+    // it is opaque
+    void Pack(TileData& data) const;
+
+    // Keep packedTileCount_ and solidTileCount_ as a tile comes or goes
+    void CountStorage(TileStorage storage, bool added);
+
+    // Evict one tile using the CLOCK sweep (requires evictionMutex_).
+    // Returns false if nothing is left to evict.
+    bool EvictOne();
+
+    // Under evictionMutex_: whether the tile goes out of the queues for
+    // good, and if so pin it (its shard locked exclusively)
+    bool TryPin(const TileKey& key, CacheEntry& entry);
+
+    std::array<Shard, NUM_SHARDS> shards_;
 
-    mutable std::shared_mutex cacheMutex_;  // Thread safety: read/write lock
+    // Global CLOCK queue in insertion order (front = oldest). Only writers
+    // touch it, under evictionMutex_, which is always taken before a shard lock.
+    std::mutex evictionMutex_;
+    std::deque<TileKey> clockQueue_;
+    std::deque<TileKey> probationQueue_;  // ScanResistant only, FIFO
+    TileEvictionPolicy policy_ = TileEvictionPolicy::Clock;
+    std::unordered_map<uint32_t, int32_t> pinnedLevels_;  // Slide: first pinned level
+    std::atomic<size_t> pinnedMemory_{0};
 
-    std::unordered_map<TileKey, CacheEntry, TileKeyHash> cache_;
-    std::list<TileKey> lruList_;  // Front = most recent, back = least recent
+    std::shared_ptr<TileBufferPool> bufferPool_;
+    CompressedTileCache compressedTier_;
+    std::atomic<TileStorage> storage_{TileStorage::Argb};
+    std::atomic<size_t> packedTileCount_{0};
+    std::atomic<bool> solidTiles_{false};
+    std::atomic<size_t> solidTileCount_{0};
 
-    size_t maxMemoryBytes_;
-    size_t currentMemoryUsage_;
+    std::atomic<size_t> maxMemoryBytes_;
+    std::atomic<size_t> currentMemoryUsage_;
+    std::atomic<size_t> tileCount_;
 
     // Statistics (atomic for thread-safe reads)
     std::atomic<size_t> hitCount_;
     std::atomic<size_t> missCount_;
+    std::atomic<size_t> evictionCount_{0};
 };
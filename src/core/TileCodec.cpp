@@ -0,0 +1,181 @@
+#include "TileCodec.h"
+#include <cstring>
+
+namespace {
+
+struct TileCodecHeader {
+    uint32_t magic;
+    int32_t width;
+    int32_t height;
+};
+
+constexpr uint32_t TILE_CODEC_MAGIC = 0x43545650;  // "PVTC"
+
+// Op tags. The 2-bit tags share the top bits with the 8-bit ones, so runs
+// stop at 62 (run lengths 63 and 64 would read as OP_RGB / OP_ARGB).
+constexpr uint8_t OP_INDEX = 0x00;  // 00iiiiii: colour table entry i
+constexpr uint8_t OP_DIFF = 0x40;   // 01rrggbb: each channel -2..1 from previous
+constexpr uint8_t OP_LUMA = 0x80;   // 10gggggg rrrrbbbb: green -32..31, red/blue -8..7 relative to it
+constexpr uint8_t OP_RUN = 0xc0;    // 11llllll: previous pixel repeated l + 1 times
+constexpr uint8_t OP_RGB = 0xfe;    // r, g, b follow; alpha as previous
+constexpr uint8_t OP_ARGB = 0xff;   // a, r, g, b follow
+constexpr uint8_t MASK_2 = 0xc0;
+constexpr int MAX_RUN = 62;
+
+constexpr uint32_t INITIAL_PIXEL = 0xFF000000;  // Opaque black
+
+inline uint8_t Alpha(uint32_t p) { return static_cast<uint8_t>(p >> 24); }
+inline uint8_t Red(uint32_t p) { return static_cast<uint8_t>(p >> 16); }
+inline uint8_t Green(uint32_t p) { return static_cast<uint8_t>(p >> 8); }
+inline uint8_t Blue(uint32_t p) { return static_cast<uint8_t>(p); }
+
+inline uint32_t Pack(uint8_t a, uint8_t r, uint8_t g, uint8_t b) {
+    return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) |
+           (static_cast<uint32_t>(g) << 8) | b;
+}
+
+inline size_t Hash(uint32_t p) {
+    return (Red(p) * 3 + Green(p) * 5 + Blue(p) * 7 + Alpha(p) * 11) % 64;
+}
+
+}  // namespace
+
+void TileCodec::Compress(const uint32_t* pixels, int32_t width, int32_t height,
+                         std::vector<uint8_t>& out) {
+    size_t count = (width > 0 && height > 0) ? static_cast<size_t>(width) * height : 0;
+
+    // Worst case is a literal per pixel; write through a raw pointer and
+    // shrink once at the end
+    out.resize(sizeof(TileCodecHeader) + count * 5);
+    TileCodecHeader header{TILE_CODEC_MAGIC, width, height};
+    std::memcpy(out.data(), &header, sizeof(header));
+    uint8_t* dst = out.data() + sizeof(header);
+
+    uint32_t index[64] = {};
+    uint32_t prev = INITIAL_PIXEL;
+    int run = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t p = pixels[i];
+        if (p == prev) {
+            if (++run == MAX_RUN) {
+                *dst++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *dst++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        size_t slot = Hash(p);
+        if (index[slot] == p) {
+            *dst++ = static_cast<uint8_t>(OP_INDEX | slot);
+        } else {
+            index[slot] = p;
+            if (Alpha(p) == Alpha(prev)) {
+                int8_t dr = static_cast<int8_t>(Red(p) - Red(prev));
+                int8_t dg = static_cast<int8_t>(Green(p) - Green(prev));
+                int8_t db = static_cast<int8_t>(Blue(p) - Blue(prev));
+                int drg = dr - dg;
+                int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *dst++ = static_cast<uint8_t>(OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    *dst++ = static_cast<uint8_t>(OP_LUMA | (dg + 32));
+                    *dst++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+                } else {
+                    *dst++ = OP_RGB;
+                    *dst++ = Red(p);
+                    *dst++ = Green(p);
+                    *dst++ = Blue(p);
+                }
+            } else {
+                *dst++ = OP_ARGB;
+                *dst++ = Alpha(p);
+                *dst++ = Red(p);
+                *dst++ = Green(p);
+                *dst++ = Blue(p);
+            }
+        }
+        prev = p;
+    }
+    if (run > 0) {
+        *dst++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+    }
+
+    out.resize(static_cast<size_t>(dst - out.data()));
+}
+
+bool TileCodec::Decompress(const uint8_t* data, size_t size, uint32_t* pixels, size_t capacity,
+                           int32_t* outWidth, int32_t* outHeight) {
+    TileCodecHeader header{};
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != TILE_CODEC_MAGIC || header.width < 0 || header.height < 0) {
+        return false;
+    }
+    size_t count = static_cast<size_t>(header.width) * header.height;
+    if (count > capacity) {
+        return false;
+    }
+
+    const uint8_t* src = data + sizeof(header);
+    const uint8_t* end = data + size;
+    uint32_t index[64] = {};
+    uint32_t p = INITIAL_PIXEL;
+    size_t i = 0;
+    while (i < count) {
+        if (src >= end) {
+            return false;
+        }
+        uint8_t op = *src++;
+        if (op == OP_RGB) {
+            if (end - src < 3) {
+                return false;
+            }
+            p = Pack(Alpha(p), src[0], src[1], src[2]);
+            src += 3;
+        } else if (op == OP_ARGB) {
+            if (end - src < 4) {
+                return false;
+            }
+            p = Pack(src[0], src[1], src[2], src[3]);
+            src += 4;
+        } else if ((op & MASK_2) == OP_RUN) {
+            size_t run = static_cast<size_t>(op & 0x3f) + 1;
+            if (run > count - i) {
+                return false;
+            }
+            for (size_t k = 0; k < run; ++k) {
+                pixels[i++] = p;
+            }
+            continue;  // Runs repeat an indexed pixel; the table is unchanged
+        } else if ((op & MASK_2) == OP_INDEX) {
+            p = index[op & 0x3f];
+        } else if ((op & MASK_2) == OP_DIFF) {
+            p = Pack(Alpha(p),
+                     static_cast<uint8_t>(Red(p) + ((op >> 4) & 0x03) - 2),
+                     static_cast<uint8_t>(Green(p) + ((op >> 2) & 0x03) - 2),
+                     static_cast<uint8_t>(Blue(p) + (op & 0x03) - 2));
+        } else {  // OP_LUMA
+            if (src >= end) {
+                return false;
+            }
+            int dg = (op & 0x3f) - 32;
+            uint8_t second = *src++;
+            p = Pack(Alpha(p),
+                     static_cast<uint8_t>(Red(p) + dg + ((second >> 4) & 0x0f) - 8),
+                     static_cast<uint8_t>(Green(p) + dg),
+                     static_cast<uint8_t>(Blue(p) + dg + (second & 0x0f) - 8));
+        }
+        index[Hash(p)] = p;
+        pixels[i++] = p;
+    }
+
+    *outWidth = header.width;
+    *outHeight = header.height;
+    return true;
+}
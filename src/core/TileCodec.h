@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fast lossless codec for tile pixels held in RAM.
+//
+// A QOI-style byte stream over the native ARGB words: runs of repeated
+// pixels, a 64-entry table of recently seen colours, and small per-channel
+// deltas from the previous pixel, with literal pixels as the fallback.
+// Slide background collapses to runs and tissue to one- and two-byte
+// deltas, so tiles typically shrink 3-10x. Both directions are a single
+// pass that is much cheaper than the JPEG decode it saves: no codec
+// dependency is needed.
+class TileCodec {
+public:
+    // Replaces out with the encoded tile
+    static void Compress(const uint32_t* pixels, int32_t width, int32_t height,
+                         std::vector<uint8_t>& out);
+
+    // Decodes into pixels (capacity in pixels). Returns false on a corrupt
+    // or truncated stream, or if the tile does not fit.
+    static bool Decompress(const uint8_t* data, size_t size, uint32_t* pixels, size_t capacity,
+                           int32_t* outWidth, int32_t* outHeight);
+};
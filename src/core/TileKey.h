@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct TileKey {
+    int32_t level;
+    int32_t tileX;
+    int32_t tileY;
+    // Open slide the tile belongs to, so slides can share one cache and
+    // decode pool (see TileLoadThreadPool::AddSlide); 0 for a lone slide
+    uint32_t slide = 0;
+
+    bool operator==(const TileKey& other) const {
+        return level == other.level && tileX == other.tileX && tileY == other.tileY &&
+               slide == other.slide;
+    }
+
+    bool operator!=(const TileKey& other) const { return !(*this == other); }
+
+    bool operator<(const TileKey& other) const {
+        if (slide != other.slide) return slide < other.slide;
+        if (level != other.level) return level < other.level;
+        if (tileX != other.tileX) return tileX < other.tileX;
+        return tileY < other.tileY;
+    }
+
+    std::string ToString() const;  // Defined in TextureManager.cpp
+};
+
+// Hash function for TileKey. All four fields go in whole, two 64-bit
+// words folded by a multiply and scrambled by a multiply-xorshift, so
+// negative or very large coordinates never alias other fields and
+// FlatTileMap may take its slot from the low bits and its tag from the
+// high ones.
+struct TileKeyHash {
+    size_t operator()(const TileKey& k) const {
+        uint64_t a = (static_cast<uint64_t>(static_cast<uint32_t>(k.level)) << 32) |
+                     static_cast<uint32_t>(k.tileX);
+        uint64_t b = (static_cast<uint64_t>(k.slide) << 32) | static_cast<uint32_t>(k.tileY);
+        uint64_t h = a * 0x9E3779B97F4A7C15ull + b;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+};
@@ -7,25 +7,31 @@
 enum class TileLoadPriority : int32_t {
     URGENT = 1000,    // Currently visible, no fallback available
     VISIBLE = 500,    // Currently visible, has fallback showing
-    ADJACENT = 100    // Adjacent to viewport (for future prefetch)
+    ADJACENT = 100    // Adjacent to / ahead of viewport (prefetch)
 };
 
 // Request for loading a tile in background
 struct TileLoadRequest {
     TileKey key;
     TileLoadPriority priority;
+    uint64_t generation;  // Render pass that last wanted this tile (0 = untagged)
     std::chrono::steady_clock::time_point requestTime;
+    double score;  // TileScheduler rank within its priority (0 = unscored)
 
     TileLoadRequest()
         : key{0, 0, 0}
         , priority(TileLoadPriority::VISIBLE)
+        , generation(0)
         , requestTime(std::chrono::steady_clock::now())
+        , score(0.0)
     {}
 
-    TileLoadRequest(const TileKey& k, TileLoadPriority p)
+    TileLoadRequest(const TileKey& k, TileLoadPriority p, uint64_t gen = 0)
         : key(k)
         , priority(p)
+        , generation(gen)
         , requestTime(std::chrono::steady_clock::now())
+        , score(0.0)
     {}
 
     // For priority queue: higher priority values should come first
@@ -35,7 +41,10 @@ struct TileLoadRequest {
         if (static_cast<int32_t>(priority) != static_cast<int32_t>(other.priority)) {
             return static_cast<int32_t>(priority) < static_cast<int32_t>(other.priority);
         }
-        // Same priority: older requests first (FIFO within priority)
+        // Same priority: higher score, then older requests first
+        if (score != other.score) {
+            return score < other.score;
+        }
         return requestTime > other.requestTime;
     }
 };
@@ -1,20 +1,114 @@
 #include "TileLoadThreadPool.h"
+#include "PyramidLayout.h"
 #include "SlideLoader.h"
-#include <iostream>
+#include "DiskTileCache.h"
+#include "ThreadScheduling.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
 
 TileLoadThreadPool::TileLoadThreadPool(size_t numThreads)
-    : numThreads_(numThreads)
+    : numThreads_(numThreads > 0 ? numThreads : DefaultThreadCount())
+    , workerLimit_(numThreads_)
 {
 }
 
+size_t TileLoadThreadPool::DefaultThreadCount() {
+    size_t hardware = std::thread::hardware_concurrency();
+    if (hardware == 0) {
+        return 4;  // Unknown: keep the historical default
+    }
+    return hardware > DEFAULT_HEADROOM_THREADS ? hardware - DEFAULT_HEADROOM_THREADS : 1;
+}
+
 TileLoadThreadPool::~TileLoadThreadPool() {
     Stop();
 }
 
 void TileLoadThreadPool::Initialize(SlideLoader* loader, TileCache* cache, TileReadyCallback onTileReady) {
-    loader_ = loader;
     cache_ = cache;
-    onTileReady_ = std::move(onTileReady);
+    SlideSource source;
+    source.loader = loader;
+    source.onTileReady = std::move(onTileReady);
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    Slide& slide = slides_[0];
+    slide.source = std::move(source);
+    slide.source.cancelled = &slide.cancelled;
+}
+
+void TileLoadThreadPool::Initialize(TileCache* cache) {
+    cache_ = cache;
+}
+
+bool TileLoadThreadPool::AddSlide(uint32_t slide, SlideSource source) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    auto inserted = slides_.try_emplace(slide);
+    if (!inserted.second) {
+        return false;
+    }
+    Slide& added = inserted.first->second;
+    added.id = slide;
+    added.source = std::move(source);
+    added.source.cancelled = &added.cancelled;
+    return true;
+}
+
+void TileLoadThreadPool::RemoveSlide(uint32_t slide, bool wait) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    auto it = slides_.find(slide);
+    if (it == slides_.end()) {
+        return;
+    }
+    Slide& removed = it->second;
+    if (!removed.removing) {
+        ClearQueued(removed);
+        DropFetched(removed);
+        removed.removing = true;
+        removed.cancelled.store(true);
+    }
+    if (removed.inFlight == 0) {
+        slides_.erase(it);
+        return;
+    }
+    removed.detached = !wait;
+    if (!wait) {
+        return;  // Erased by FinishInFlight
+    }
+    slideIdleCondition_.wait(lock, [&removed]() { return removed.inFlight == 0; });
+    slides_.erase(it);
+}
+
+bool TileLoadThreadPool::HasSlide(uint32_t slide) const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return slides_.count(slide) > 0;
+}
+
+size_t TileLoadThreadPool::GetSlideCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return slides_.size();
+}
+
+void TileLoadThreadPool::SetDiskCache(DiskTileCache* diskCache) {
+    auto it = slides_.find(0);
+    if (it != slides_.end()) {
+        it->second.source.diskCache = diskCache;
+    }
+}
+
+void TileLoadThreadPool::SetPyramid(const PyramidLayout* pyramid) {
+    auto it = slides_.find(0);
+    if (it != slides_.end()) {
+        it->second.source.pyramid = pyramid;
+    }
+}
+
+void TileLoadThreadPool::SetStats(TilePipelineStats* stats) {
+    auto it = slides_.find(0);
+    if (it != slides_.end()) {
+        it->second.source.stats = stats;
+    }
 }
 
 void TileLoadThreadPool::Start() {
@@ -22,8 +116,8 @@ void TileLoadThreadPool::Start() {
         return;  // Already running
     }
 
-    if (!loader_ || !cache_) {
-        std::cerr << "TileLoadThreadPool: Cannot start without loader and cache" << std::endl;
+    if (!cache_) {
+        PATHVIEW_LOG_ERROR("TileLoadThreadPool: Cannot start without a cache");
         return;
     }
 
@@ -32,10 +126,28 @@ void TileLoadThreadPool::Start() {
     // Create worker threads
     workers_.reserve(numThreads_);
     for (size_t i = 0; i < numThreads_; ++i) {
-        workers_.emplace_back(&TileLoadThreadPool::WorkerLoop, this);
+        workers_.emplace_back(&TileLoadThreadPool::WorkerLoop, this, i);
+    }
+    ioWorkers_.reserve(ioThreads_);
+    for (size_t i = 0; i < ioThreads_; ++i) {
+        ioWorkers_.emplace_back(&TileLoadThreadPool::ReadAheadLoop, this);
     }
 
-    std::cout << "TileLoadThreadPool: Started " << numThreads_ << " worker threads" << std::endl;
+    std::ostringstream line;
+    line << "TileLoadThreadPool: Started " << numThreads_ << " worker threads";
+    if (autoScaling_) {
+        line << " (auto-scaling from " << workerLimit_.load() << ")";
+    }
+    if (ioThreads_ > 0) {
+        line << " and " << ioThreads_ << " read-ahead threads";
+    }
+    if (backgroundPriority_) {
+        line << " at background priority";
+    }
+    if (reservedCores_ > 0) {
+        line << ", off " << reservedCores_ << " reserved core(s)";
+    }
+    PATHVIEW_LOG_INFO(line.str());
 }
 
 void TileLoadThreadPool::Stop() {
@@ -48,6 +160,7 @@ void TileLoadThreadPool::Stop() {
 
     // Wake up all waiting threads
     queueCondition_.notify_all();
+    readAheadCondition_.notify_all();
 
     // Join all threads
     for (auto& worker : workers_) {
@@ -56,177 +169,914 @@ void TileLoadThreadPool::Stop() {
         }
     }
     workers_.clear();
+    for (auto& worker : ioWorkers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    ioWorkers_.clear();
 
     // Clear pending requests
     {
         std::lock_guard<std::mutex> lock(queueMutex_);
-        while (!requestQueue_.empty()) {
-            requestQueue_.pop();
+        for (auto& entry : slides_) {
+            for (auto& band : entry.second.bands) {
+                band.clear();
+            }
+            entry.second.queued = 0;
+            entry.second.inFlight = 0;
         }
+        pending_.clear();
+        queuedCount_ = 0;
+        fetched_.clear();
+        readAheadTiles_ = 0;
     }
+
+    PATHVIEW_LOG_INFO("TileLoadThreadPool: Stopped");
+}
+
+bool TileLoadThreadPool::SubmitRequest(const TileLoadRequest& request) {
+    return SubmitRequests(&request, 1) > 0;
+}
+
+size_t TileLoadThreadPool::SubmitRequests(const TileLoadRequest* requests, size_t count, size_t maxNew) {
+    size_t queued = 0;
     {
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        pendingKeys_.clear();
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        for (size_t i = 0; i < count; ++i) {
+            if (Enqueue(requests[i], queued < maxNew)) {
+                queued++;
+            }
+        }
+    }
+    if (queued == 0) {
+        return 0;
     }
 
-    std::cout << "TileLoadThreadPool: Stopped" << std::endl;
+    WakeWorkers(queued);
+    readAheadCondition_.notify_all();
+    return queued;
 }
 
-void TileLoadThreadPool::SubmitRequest(const TileLoadRequest& request) {
-    // Check if already pending
-    {
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        if (pendingKeys_.find(request.key) != pendingKeys_.end()) {
-            return;  // Already in queue
+void TileLoadThreadPool::WakeWorkers(size_t count) {
+    // While some are parked, notify_one could pick a parked worker that
+    // goes straight back to sleep, so wake them all
+    if (count > 1 || workerLimit_.load() < numThreads_) {
+        queueCondition_.notify_all();
+    } else {
+        queueCondition_.notify_one();
+    }
+}
+
+bool TileLoadThreadPool::Enqueue(const TileLoadRequest& request, bool allowNew) {
+    // One lookup decides everything: in flight, queued, or new
+    auto it = pending_.find(request.key);
+    if (it != pending_.end()) {
+        // Already being fetched or decoded - nothing to do but raise the
+        // priority a fetched batch waits with
+        if (it->second.inFlight) {
+            if (static_cast<int32_t>(request.priority) > static_cast<int32_t>(it->second.priority)) {
+                it->second.priority = request.priority;
+            }
+            return false;
+        }
+
+        // Already queued - refresh generation and promote if needed.
+        // Scored requests come best first (see TileScheduler), so moving
+        // each to the back of its band keeps the band in the latest score
+        // order.
+        it->second.generation = std::max(it->second.generation, request.generation);
+        if (static_cast<int32_t>(request.priority) > static_cast<int32_t>(it->second.priority) ||
+            (request.score > 0.0 && request.priority == it->second.priority)) {
+            Reprioritize(it, request.priority);
         }
-        pendingKeys_.insert(request.key);
+        return false;
     }
 
-    // Check if already in cache
-    if (cache_ && cache_->HasTile(request.key)) {
-        // Already cached, remove from pending
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        pendingKeys_.erase(request.key);
-        return;
+    if (!allowNew) {
+        return false;
     }
 
-    // Add to queue
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        requestQueue_.push(request);
+    auto slide = slides_.find(request.key.slide);
+    if (slide == slides_.end() || slide->second.removing) {
+        return false;
+    }
+
+    // Check if already in cache. Only a shared shard lock, nested inside
+    // the queue mutex; workers never take the two in the other order.
+    if (cache_ && cache_->HasTile(request.key)) {
+        return false;
     }
 
-    // Wake up a worker
-    queueCondition_.notify_one();
+    Band& band = slide->second.bands[BandOf(request.priority)];
+    band.push_back(request.key);
+    pending_.emplace(request.key,
+                     PendingRequest{false, request.priority, request.generation, std::prev(band.end()),
+                                    request.requestTime, &slide->second});
+    slide->second.queued++;
+    queuedCount_++;
+    return true;
 }
 
 void TileLoadThreadPool::CancelRequest(const TileKey& key) {
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    pendingKeys_.erase(key);
-    // Note: Request may still be in queue, but will be skipped when processed
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    auto it = pending_.find(key);
+    if (it != pending_.end() && !it->second.inFlight) {
+        EraseQueued(it);
+    }
+    // Note: A request already in flight runs to completion
 }
 
 void TileLoadThreadPool::CancelAllRequests() {
-    // Clear the queue
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        while (!requestQueue_.empty()) {
-            requestQueue_.pop();
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    for (auto& entry : slides_) {
+        ClearQueued(entry.second);
+    }
+}
+
+void TileLoadThreadPool::ClearQueued(Slide& slide) {
+    for (auto& band : slide.bands) {
+        for (const auto& key : band) {
+            pending_.erase(key);
         }
+        queuedCount_ -= band.size();
+        band.clear();
     }
+    slide.queued = 0;
+}
 
-    // Clear pending set
-    {
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        pendingKeys_.clear();
+void TileLoadThreadPool::RetireStaleRequests(uint64_t currentGeneration) {
+    RetireStale(currentGeneration, std::nullopt);
+}
+
+void TileLoadThreadPool::RetireStaleSlideRequests(uint32_t slide, uint64_t currentGeneration) {
+    RetireStale(currentGeneration, slide);
+}
+
+void TileLoadThreadPool::RetireStale(uint64_t currentGeneration, std::optional<uint32_t> slide) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        const PendingRequest& queued = it->second;
+
+        if (queued.inFlight || queued.generation >= currentGeneration ||
+            (slide && it->first.slide != *slide)) {
+            ++it;  // Still wanted this frame, or another slide's
+            continue;
+        }
+
+        if (queued.generation + STALE_DROP_GENERATIONS < currentGeneration) {
+            auto next = std::next(it);
+            EraseQueued(it);
+            droppedCount_++;
+            it = next;
+            continue;
+        }
+
+        // Scrolled off screen recently: let visible work overtake it, but keep
+        // it around briefly in case the user pans back
+        if (static_cast<int32_t>(queued.priority) > static_cast<int32_t>(TileLoadPriority::ADJACENT)) {
+            Reprioritize(it, TileLoadPriority::ADJACENT);
+        }
+        ++it;
     }
 }
 
 bool TileLoadThreadPool::IsPending(const TileKey& key) const {
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    return pendingKeys_.find(key) != pendingKeys_.end();
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return pending_.count(key) > 0;
 }
 
 size_t TileLoadThreadPool::GetPendingCount() const {
     std::lock_guard<std::mutex> lock(queueMutex_);
-    return requestQueue_.size();
+    return queuedCount_;
 }
 
-void TileLoadThreadPool::WorkerLoop() {
-    while (running_.load()) {
-        TileLoadRequest request;
+size_t TileLoadThreadPool::GetPendingCount(uint32_t slide) const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    auto it = slides_.find(slide);
+    return it != slides_.end() ? it->second.queued : 0;
+}
 
-        if (!PopNextRequest(request)) {
-            continue;  // No work or shutting down
+void TileLoadThreadPool::EnableAutoScaling(size_t minThreads) {
+    autoScaling_ = true;
+    minThreads_ = std::max<size_t>(1, std::min(minThreads, numThreads_));
+    workerLimit_.store(minThreads_);
+    idleFrames_ = 0;
+}
+
+void TileLoadThreadPool::UpdateScaling() {
+    if (!autoScaling_) {
+        return;
+    }
+
+    size_t queued = GetPendingCount();
+    size_t limit = workerLimit_.load();
+    size_t newLimit = limit;
+
+    if (queued == 0) {
+        // Park one worker at a time after a sustained idle period
+        if (++idleFrames_ >= SCALE_DOWN_IDLE_FRAMES && limit > minThreads_) {
+            newLimit = limit - 1;
+            idleFrames_ = 0;
         }
+    } else {
+        idleFrames_ = 0;
 
-        // Check if request was cancelled
+        // Until a tile has been timed, any backlog counts as too slow
+        double decodeMs = averageDecodeMs_.load();
+        double drainMs = decodeMs > 0.0
+            ? decodeMs * static_cast<double>(queued) / static_cast<double>(limit)
+            : SCALE_UP_BACKLOG_MS + 1.0;
+        if (drainMs > SCALE_UP_BACKLOG_MS && limit < numThreads_) {
+            newLimit = limit + 1;
+        }
+    }
+
+    if (newLimit != limit) {
         {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            if (pendingKeys_.find(request.key) == pendingKeys_.end()) {
-                continue;  // Cancelled
-            }
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            workerLimit_.store(newLimit);
+        }
+        // Unpark newly allowed workers (parked ones re-check their index)
+        queueCondition_.notify_all();
+    }
+}
+
+void TileLoadThreadPool::EraseQueued(PendingMap::iterator it) {
+    Slide* slide = it->second.slide;
+    slide->bands[BandOf(it->second.priority)].erase(it->second.position);
+    slide->queued--;
+    pending_.erase(it);
+    queuedCount_--;
+}
+
+void TileLoadThreadPool::StartLoading(PendingMap::iterator it) {
+    Slide* slide = it->second.slide;
+    slide->bands[BandOf(it->second.priority)].erase(it->second.position);
+    slide->queued--;
+    slide->inFlight++;
+    it->second.inFlight = true;
+    queuedCount_--;
+}
+
+void TileLoadThreadPool::Reprioritize(PendingMap::iterator it, TileLoadPriority priority) {
+    // Joins the back of its new band, like a fresh request at that priority
+    Slide* slide = it->second.slide;
+    Band& from = slide->bands[BandOf(it->second.priority)];
+    Band& to = slide->bands[BandOf(priority)];
+    to.splice(to.end(), from, it->second.position);
+    it->second.priority = priority;
+}
+
+void TileLoadThreadPool::RecordStage(const SlideSource& source, TileStage stage,
+                                     TilePipelineStats::Clock::time_point start) {
+    if (source.stats) {
+        source.stats->RecordSince(stage, start);
+    }
+}
+
+void TileLoadThreadPool::StoreCompressed(const SlideSource& source, const TileKey& key, const uint32_t* pixels,
+                                         int64_t width, int64_t height) {
+    CompressedTileCache& compressedTier = cache_->GetCompressedTier();
+    if (!compressedTier.IsEnabled()) {
+        return;
+    }
+    auto compressStart = TilePipelineStats::Clock::now();
+    compressedTier.Store(key, pixels, static_cast<int32_t>(width), static_cast<int32_t>(height));
+    RecordStage(source, TileStage::Compress, compressStart);
+}
+
+size_t TileLoadThreadPool::BandOf(TileLoadPriority priority) {
+    switch (priority) {
+        case TileLoadPriority::URGENT:
+            return 0;
+        case TileLoadPriority::VISIBLE:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+void TileLoadThreadPool::ApplyThreadScheduling() {
+    bool lowered = !backgroundPriority_ || ThreadScheduling::LowerCurrentThreadPriority();
+    bool reserved = reservedCores_ == 0 || ThreadScheduling::ReserveCoresFromCurrentThread(reservedCores_);
+    if ((!lowered || !reserved) && !schedulingWarned_.exchange(true)) {
+        PATHVIEW_LOG_WARNING("TileLoadThreadPool: Could not "
+                             << (!lowered ? "lower the workers' priority" : "keep the workers off the reserved cores")
+                             << "; they run with the default scheduling");
+    }
+}
+
+void TileLoadThreadPool::WorkerLoop(size_t workerIndex) {
+    ApplyThreadScheduling();
+    std::vector<TileLoadRequest> batch;
+    while (running_.load()) {
+        // The slide stays registered while it has tiles in flight
+        Slide* slide = PopNextBatch(workerIndex, batch);
+        if (!slide) {
+            continue;  // No work or shutting down
         }
 
-        // Process the request
+        // Process the request(s)
         activeCount_++;
-        ProcessRequest(request);
+        auto start = std::chrono::steady_clock::now();
+        if (batch.size() == 1) {
+            ProcessRequest(slide->source, batch.front());
+        } else {
+            ProcessBatch(slide->source, batch);
+        }
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() / static_cast<double>(batch.size());
         activeCount_--;
 
-        // Remove from pending set
+        // Feed the decode latency estimate used by UpdateScaling()
+        double previous = averageDecodeMs_.load();
+        averageDecodeMs_.store(previous > 0.0 ? previous * 0.9 + elapsedMs * 0.1 : elapsedMs);
+
+        // No longer in flight
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        FinishInFlight(*slide, batch);
+    }
+}
+
+void TileLoadThreadPool::FinishInFlight(Slide& slide, const std::vector<TileLoadRequest>& batch) {
+    for (const auto& request : batch) {
+        pending_.erase(request.key);
+    }
+    slide.inFlight -= batch.size();
+    if (slide.inFlight == 0 && slide.removing) {
+        if (slide.detached) {
+            slides_.erase(slide.id);  // Invalidates slide
+        } else {
+            slideIdleCondition_.notify_all();
+        }
+    }
+}
+
+TileLoadThreadPool::Slide* TileLoadThreadPool::PopNextBatch(size_t workerIndex,
+                                                             std::vector<TileLoadRequest>& outBatch) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+
+    // Wait for work or shutdown; parked workers wait until scaled back up
+    queueCondition_.wait(lock, [this, workerIndex]() {
+        return ((queuedCount_ > 0 || !fetched_.empty()) && workerIndex < workerLimit_.load()) ||
+               !running_.load();
+    });
+
+    if (!running_.load() || (queuedCount_ == 0 && fetched_.empty())) {
+        return nullptr;  // Shutting down
+    }
+
+    // Queued work only if it outranks every fetched batch: on a tie the
+    // fetched one was picked up first
+    size_t fetchedBand = PRIORITY_BANDS;
+    auto fetched = BestFetched(&fetchedBand);
+    size_t band = 0;
+    auto next = SelectSlide(0, fetchedBand, false, &band);
+    if (next != slides_.end()) {
+        lastServedSlide_ = next->first;
+        TakeBatch(next->second, next->second.bands[band], outBatch);
+        return &next->second;
+    }
+
+    Slide* slide = fetched->slide;
+    outBatch = std::move(fetched->batch);
+    fetched_.erase(fetched);
+    readAheadTiles_ -= outBatch.size();
+    fetchedTiles_ += outBatch.size();
+    lock.unlock();
+    readAheadCondition_.notify_one();  // Room to read ahead again
+    return slide;
+}
+
+std::map<uint32_t, TileLoadThreadPool::Slide>::iterator TileLoadThreadPool::SelectSlide(
+    size_t firstBand, size_t bandLimit, bool readAheadOnly, size_t* outBand) {
+    // Highest non-empty band across slides. Slides with work in it take
+    // turns: the first one after the slide served last, wrapping around.
+    for (size_t b = firstBand; b < bandLimit; ++b) {
+        auto next = slides_.end();
+        auto first = slides_.end();
+        for (auto entry = slides_.begin(); entry != slides_.end(); ++entry) {
+            if (entry->second.bands[b].empty()) {
+                continue;
+            }
+            if (readAheadOnly &&
+                !(entry->second.source.loader && entry->second.source.loader->IsDirectTiffReadActive())) {
+                continue;
+            }
+            if (first == slides_.end()) {
+                first = entry;
+            }
+            if (entry->first > lastServedSlide_) {
+                next = entry;
+                break;
+            }
+        }
+        if (next == slides_.end()) {
+            next = first;
+        }
+        if (next != slides_.end()) {
+            *outBand = b;
+            return next;
+        }
+    }
+    return slides_.end();
+}
+
+void TileLoadThreadPool::TakeBatch(Slide& slide, Band& band, std::vector<TileLoadRequest>& outBatch) {
+    const SlideSource& source = slide.source;
+
+    // Move its oldest request from queued to in flight
+    auto it = pending_.find(band.front());
+    TileKey head = it->first;
+    TileLoadPriority priority = it->second.priority;
+    outBatch.clear();
+    outBatch.emplace_back(head, priority, it->second.generation);
+    outBatch.back().requestTime = it->second.requestTime;
+    RecordStage(source, TileStage::QueueWait, it->second.requestTime);
+    StartLoading(it);
+
+    // Let queued neighbours of the same priority ride along in one read.
+    // URGENT tiles go alone: a bigger read would only delay the tile the
+    // user is waiting for. Synthesized tiles have no region to read.
+    bool synthesized = source.pyramid && source.pyramid->IsSynthesized(head.level);
+    if (!coalescing_ || priority == TileLoadPriority::URGENT || synthesized) {
+        return;
+    }
+
+    std::vector<TileKey> block = CoalesceBlock(head, [this, priority](const TileKey& key) {
+        auto queued = pending_.find(key);
+        return queued != pending_.end() && !queued->second.inFlight && queued->second.priority == priority;
+    });
+    for (size_t i = 1; i < block.size(); ++i) {
+        auto queued = pending_.find(block[i]);
+        outBatch.emplace_back(block[i], priority, queued->second.generation);
+        outBatch.back().requestTime = queued->second.requestTime;
+        RecordStage(source, TileStage::QueueWait, queued->second.requestTime);
+        StartLoading(queued);
+    }
+}
+
+std::list<TileLoadThreadPool::FetchedBatch>::iterator TileLoadThreadPool::BestFetched(size_t* outBand) {
+    // Oldest batch of the best band; a tile promoted while in flight
+    // lifts its whole batch
+    auto best = fetched_.end();
+    *outBand = PRIORITY_BANDS;
+    for (auto it = fetched_.begin(); it != fetched_.end(); ++it) {
+        size_t band = PRIORITY_BANDS;
+        for (const auto& request : it->batch) {
+            band = std::min(band, BandOf(pending_.at(request.key).priority));
+        }
+        if (band < *outBand) {
+            best = it;
+            *outBand = band;
+        }
+    }
+    return best;
+}
+
+void TileLoadThreadPool::DropFetched(Slide& slide) {
+    for (auto it = fetched_.begin(); it != fetched_.end();) {
+        if (it->slide != &slide) {
+            ++it;
+            continue;
+        }
+        readAheadTiles_ -= it->batch.size();
+        FinishInFlight(slide, it->batch);
+        it = fetched_.erase(it);
+    }
+}
+
+void TileLoadThreadPool::ReadAheadLoop() {
+    ApplyThreadScheduling();
+    std::vector<TileLoadRequest> batch;
+    while (running_.load()) {
+        Slide* slide = PopReadAheadBatch(batch);
+        if (!slide) {
+            continue;  // Shutting down
+        }
+
+        FetchBatch(slide->source, batch);
+
         {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            pendingKeys_.erase(request.key);
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (slide->removing || !running_.load()) {
+                // Nobody will decode it
+                readAheadTiles_ -= batch.size();
+                FinishInFlight(*slide, batch);
+                continue;
+            }
+            fetched_.push_back({slide, batch});
         }
+        WakeWorkers(1);
     }
 }
 
-bool TileLoadThreadPool::PopNextRequest(TileLoadRequest& outRequest) {
+TileLoadThreadPool::Slide* TileLoadThreadPool::PopReadAheadBatch(std::vector<TileLoadRequest>& outBatch) {
     std::unique_lock<std::mutex> lock(queueMutex_);
 
-    // Wait for work or shutdown
-    queueCondition_.wait(lock, [this]() {
-        return !requestQueue_.empty() || !running_.load();
+    // URGENT tiles are left to the workers: one tile gains nothing from
+    // a hand-off, and the user is waiting for it
+    auto next = slides_.end();
+    size_t band = 0;
+    readAheadCondition_.wait(lock, [&]() {
+        if (!running_.load()) {
+            return true;
+        }
+        if (queuedCount_ == 0 || readAheadTiles_ >= READ_AHEAD_TILES) {
+            return false;
+        }
+        next = SelectSlide(BandOf(TileLoadPriority::VISIBLE), PRIORITY_BANDS, true, &band);
+        return next != slides_.end();
     });
 
-    if (!running_.load() && requestQueue_.empty()) {
-        return false;  // Shutting down
+    if (!running_.load()) {
+        return nullptr;
     }
+    lastServedSlide_ = next->first;
+    TakeBatch(next->second, next->second.bands[band], outBatch);
+    readAheadTiles_ += outBatch.size();
+    return &next->second;
+}
 
-    if (requestQueue_.empty()) {
-        return false;
+void TileLoadThreadPool::FetchBatch(const SlideSource& source, const std::vector<TileLoadRequest>& batch) {
+    if (!source.loader || !cache_ || IsCancelled(source)) {
+        return;
     }
 
-    outRequest = requestQueue_.top();
-    requestQueue_.pop();
-    return true;
+    // Nothing to read if every tile is held by a cache tier already, or
+    // for synthesized tiles, which are built from other tiles
+    bool anyMissing = std::any_of(batch.begin(), batch.end(), [&](const TileLoadRequest& request) {
+        return !IsCachedAnywhere(source, request.key);
+    });
+    TileRect first = GetTileRect(source, batch.front().key);
+    if (!anyMissing || first.sourceLevel < 0) {
+        return;
+    }
+
+    // The batch is a rectangle of tiles (see CoalesceBlock)
+    int64_t regionX = first.levelX, regionY = first.levelY;
+    int64_t regionRight = first.levelX + first.width, regionBottom = first.levelY + first.height;
+    for (size_t i = 1; i < batch.size(); ++i) {
+        TileRect rect = GetTileRect(source, batch[i].key);
+        regionX = std::min(regionX, rect.levelX);
+        regionY = std::min(regionY, rect.levelY);
+        regionRight = std::max(regionRight, rect.levelX + rect.width);
+        regionBottom = std::max(regionBottom, rect.levelY + rect.height);
+    }
+    if (regionRight <= regionX || regionBottom <= regionY) {
+        return;
+    }
+
+    auto fetchStart = TilePipelineStats::Clock::now();
+    size_t bytes = source.loader->FetchRegion(first.sourceLevel,
+                                              static_cast<int64_t>(regionX * first.downsample),
+                                              static_cast<int64_t>(regionY * first.downsample),
+                                              static_cast<int64_t>((regionRight - regionX) * first.downsample),
+                                              static_cast<int64_t>((regionBottom - regionY) * first.downsample));
+    if (bytes > 0) {
+        RecordStage(source, TileStage::Fetch, fetchStart);
+        fetchedBytes_ += bytes;
+    }
+}
+
+std::vector<TileKey> TileLoadThreadPool::CoalesceBlock(const TileKey& head,
+                                                       const std::function<bool(const TileKey&)>& canJoin) {
+    // Aligned block containing head, so neighbouring workers pick disjoint
+    // blocks rather than overlapping ones
+    int32_t blockX = head.tileX - head.tileX % COALESCE_BLOCK;
+    int32_t blockY = head.tileY - head.tileY % COALESCE_BLOCK;
+
+    // Largest rectangle within the block that contains head and whose
+    // other tiles can all join (a region read must be rectangular)
+    int32_t bestX0 = head.tileX, bestY0 = head.tileY, bestX1 = head.tileX, bestY1 = head.tileY;
+    int32_t bestArea = 1;
+    for (int32_t x0 = blockX; x0 <= head.tileX; ++x0) {
+        for (int32_t x1 = head.tileX; x1 < blockX + COALESCE_BLOCK; ++x1) {
+            for (int32_t y0 = blockY; y0 <= head.tileY; ++y0) {
+                for (int32_t y1 = head.tileY; y1 < blockY + COALESCE_BLOCK; ++y1) {
+                    int32_t area = (x1 - x0 + 1) * (y1 - y0 + 1);
+                    if (area <= bestArea) {
+                        continue;
+                    }
+                    bool joinable = true;
+                    for (int32_t y = y0; y <= y1 && joinable; ++y) {
+                        for (int32_t x = x0; x <= x1 && joinable; ++x) {
+                            TileKey key{head.level, x, y, head.slide};
+                            joinable = key == head || canJoin(key);
+                        }
+                    }
+                    if (joinable) {
+                        bestX0 = x0, bestY0 = y0, bestX1 = x1, bestY1 = y1;
+                        bestArea = area;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<TileKey> block{head};
+    for (int32_t y = bestY0; y <= bestY1; ++y) {
+        for (int32_t x = bestX0; x <= bestX1; ++x) {
+            TileKey key{head.level, x, y, head.slide};
+            if (!(key == head)) {
+                block.push_back(key);
+            }
+        }
+    }
+    return block;
 }
 
-void TileLoadThreadPool::ProcessRequest(const TileLoadRequest& request) {
-    if (!loader_ || !cache_) {
+void TileLoadThreadPool::ProcessRequest(const SlideSource& source, const TileLoadRequest& request) {
+    if (!source.loader || !cache_) {
         return;
     }
 
+    if (IsCancelled(source)) {
+        return;  // Its slide is being removed
+    }
+
     // Check if already cached (might have been loaded by another thread)
     if (cache_->HasTile(request.key)) {
-        if (onTileReady_) {
-            onTileReady_(request.key);
+        if (source.onTileReady) {
+            source.onTileReady(request.key);
         }
         return;
     }
 
-    // Load tile from slide
-    const TileKey& key = request.key;
-    double downsample = loader_->GetLevelDownsample(key.level);
+    if (!LoadTile(source, request.key, request.requestTime) || IsCancelled(source)) {
+        return;
+    }
+
+    // Notify that tile is ready
+    if (source.onTileReady) {
+        source.onTileReady(request.key);
+    }
+}
+
+void TileLoadThreadPool::ProcessBatch(const SlideSource& source, const std::vector<TileLoadRequest>& batch) {
+    if (!source.loader || !cache_ || IsCancelled(source)) {
+        return;
+    }
+
+    // Only a batch that all needs decoding is read as one region; tiles
+    // served by a cache tier leave a hole, so fall back to tile by tile
+    bool allMissing = std::none_of(batch.begin(), batch.end(), [&](const TileLoadRequest& request) {
+        return IsCachedAnywhere(source, request.key);
+    });
+    if (!allMissing || !LoadRegion(source, batch)) {
+        for (const auto& request : batch) {
+            ProcessRequest(source, request);
+        }
+        return;
+    }
+
+    if (source.onTileReady && !IsCancelled(source)) {
+        for (const auto& request : batch) {
+            source.onTileReady(request.key);
+        }
+    }
+}
+
+bool TileLoadThreadPool::IsCachedAnywhere(const SlideSource& source, const TileKey& key) const {
+    const CompressedTileCache& compressedTier = cache_->GetCompressedTier();
+    return cache_->HasTile(key) || (compressedTier.IsEnabled() && compressedTier.HasTile(key)) ||
+           (source.diskCache && source.diskCache->HasTile(key));
+}
+
+TileLoadThreadPool::TileRect TileLoadThreadPool::GetTileRect(const SlideSource& source, const TileKey& key) const {
+    // Level geometry from the (possibly synthesized) pyramid, or the slide
+    const PyramidLevel* pyramidLevel = source.pyramid ? &source.pyramid->GetLevel(key.level) : nullptr;
+    auto levelDims = pyramidLevel ? pyramidLevel->dimensions : source.loader->GetLevelDimensions(key.level);
+
+    TileRect rect;
+    rect.sourceLevel = pyramidLevel ? pyramidLevel->sourceLevel : key.level;
+    rect.downsample = pyramidLevel ? pyramidLevel->downsample : source.loader->GetLevelDownsample(key.level);
+    rect.gridWidth = pyramidLevel ? pyramidLevel->tileWidth : DEFAULT_TILE_SIZE;
+    rect.gridHeight = pyramidLevel ? pyramidLevel->tileHeight : DEFAULT_TILE_SIZE;
+
+    // Calculate tile position and dimensions at this level
+    rect.levelX = key.tileX * rect.gridWidth;
+    rect.levelY = key.tileY * rect.gridHeight;
+    rect.width = std::min(rect.gridWidth, levelDims.width - rect.levelX);
+    rect.height = std::min(rect.gridHeight, levelDims.height - rect.levelY);
+    return rect;
+}
+
+bool TileLoadThreadPool::LoadRegion(const SlideSource& source, const std::vector<TileLoadRequest>& batch) {
+    // The batch is a rectangle of tiles (see CoalesceBlock): read the
+    // region under all of them in one call
+    TileRect first = GetTileRect(source, batch.front().key);
+    int64_t regionX = first.levelX, regionY = first.levelY;
+    int64_t regionRight = first.levelX + first.width, regionBottom = first.levelY + first.height;
+    std::vector<TileRect> rects;
+    rects.reserve(batch.size());
+    for (const auto& request : batch) {
+        TileRect rect = GetTileRect(source, request.key);
+        if (rect.width <= 0 || rect.height <= 0 || rect.sourceLevel < 0) {
+            return false;
+        }
+        regionX = std::min(regionX, rect.levelX);
+        regionY = std::min(regionY, rect.levelY);
+        regionRight = std::max(regionRight, rect.levelX + rect.width);
+        regionBottom = std::max(regionBottom, rect.levelY + rect.height);
+        rects.push_back(rect);
+    }
+    int64_t regionWidth = regionRight - regionX;
+    int64_t regionHeight = regionBottom - regionY;
+
+    std::shared_ptr<TileBufferPool> pool = cache_->GetBufferPool();
+    size_t regionCapacity = 0;
+    uint32_t* region = pool->Acquire(static_cast<size_t>(regionWidth * regionHeight), &regionCapacity);
+    auto decodeStart = TilePipelineStats::Clock::now();
+    if (!source.loader->ReadRegionInto(first.sourceLevel,
+                                 static_cast<int64_t>(regionX * first.downsample),
+                                 static_cast<int64_t>(regionY * first.downsample),
+                                 regionWidth, regionHeight, region)) {
+        pool->Release(region, regionCapacity);
+        return false;
+    }
+    RecordStage(source, TileStage::Decode, decodeStart);
+    decodedBytes_ += static_cast<uint64_t>(regionWidth * regionHeight) * sizeof(uint32_t);
+    if (IsCancelled(source)) {
+        pool->Release(region, regionCapacity);
+        return true;  // Decoded for nobody: discarded, and not retried tile by tile
+    }
+
+    // Split into tiles, each in its own pooled buffer
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const TileRect& rect = rects[i];
+        size_t capacity = 0;
+        uint32_t* pixels = pool->Acquire(static_cast<size_t>(rect.width * rect.height), &capacity);
+        const uint32_t* src = region + (rect.levelY - regionY) * regionWidth + (rect.levelX - regionX);
+        for (int64_t y = 0; y < rect.height; ++y) {
+            std::copy(src + y * regionWidth, src + y * regionWidth + rect.width, pixels + y * rect.width);
+        }
+
+        if (source.diskCache) {
+            source.diskCache->Store(batch[i].key, pixels, static_cast<int32_t>(rect.width),
+                                    static_cast<int32_t>(rect.height));
+        }
+        StoreCompressed(source, batch[i].key, pixels, rect.width, rect.height);
+        TileData tileData(pixels, rect.width, rect.height, pool, capacity);
+        tileData.requestTime = batch[i].requestTime;
+        auto insertStart = TilePipelineStats::Clock::now();
+        cache_->InsertTile(batch[i].key, std::move(tileData));
+        RecordStage(source, TileStage::CacheInsert, insertStart);
+    }
+    pool->Release(region, regionCapacity);
+
+    coalescedReads_++;
+    coalescedTiles_ += batch.size();
+    return true;
+}
+
+TileHandle TileLoadThreadPool::LoadTile(const SlideSource& source, const TileKey& key,
+                                        std::chrono::steady_clock::time_point requestTime) {
+    TileRect rect = GetTileRect(source, key);
+    int32_t sourceLevel = rect.sourceLevel;
+    int64_t tileWidth = rect.width;
+    int64_t tileHeight = rect.height;
+    int64_t gridWidth = rect.gridWidth;
+    int64_t gridHeight = rect.gridHeight;
 
     // Calculate tile position in level 0 coordinates
-    int64_t x0 = static_cast<int64_t>(key.tileX * 512 * downsample);  // TILE_SIZE = 512
-    int64_t y0 = static_cast<int64_t>(key.tileY * 512 * downsample);
+    int64_t x0 = static_cast<int64_t>(rect.levelX * rect.downsample);
+    int64_t y0 = static_cast<int64_t>(rect.levelY * rect.downsample);
 
-    // Calculate tile dimensions at this level
-    auto levelDims = loader_->GetLevelDimensions(key.level);
-    int64_t levelX = key.tileX * 512;
-    int64_t levelY = key.tileY * 512;
+    if (tileWidth <= 0 || tileHeight <= 0 || IsCancelled(source)) {
+        return nullptr;
+    }
 
-    int64_t tileWidth = std::min(static_cast<int64_t>(512), levelDims.width - levelX);
-    int64_t tileHeight = std::min(static_cast<int64_t>(512), levelDims.height - levelY);
+    // Decode straight into a recycled buffer from the cache's pool
+    std::shared_ptr<TileBufferPool> pool = cache_->GetBufferPool();
+    size_t capacity = 0;
+    uint32_t* pixels = pool->Acquire(static_cast<size_t>(tileWidth * tileHeight), &capacity);
 
-    if (tileWidth <= 0 || tileHeight <= 0) {
-        return;
+    // A tile the pixel tier evicted may still be held compressed in RAM,
+    // and one decoded in an earlier session is just a file read away
+    CompressedTileCache& compressedTier = cache_->GetCompressedTier();
+    int32_t storedWidth = 0, storedHeight = 0;
+    auto decompressStart = TilePipelineStats::Clock::now();
+    bool fromCompressed = compressedTier.IsEnabled() &&
+                          compressedTier.Load(key, pixels, capacity, &storedWidth, &storedHeight) &&
+                          storedWidth == tileWidth && storedHeight == tileHeight;
+    if (fromCompressed) {
+        RecordStage(source, TileStage::Decompress, decompressStart);
     }
 
-    // Read tile from slide (this is the blocking I/O that we moved off the render thread!)
-    uint32_t* pixels = loader_->ReadRegion(key.level, x0, y0, tileWidth, tileHeight);
-    if (!pixels) {
-        return;
+    auto diskStart = TilePipelineStats::Clock::now();
+    bool fromDisk = !fromCompressed && source.diskCache &&
+                    source.diskCache->Load(key, pixels, capacity, &storedWidth, &storedHeight) &&
+                    storedWidth == tileWidth && storedHeight == tileHeight;
+    if (fromDisk) {
+        RecordStage(source, TileStage::DiskRead, diskStart);
+    }
+
+    // Otherwise build it: downsample from the level below for synthesized
+    // levels, else read tile from slide (this is the blocking I/O that we
+    // moved off the render thread!)
+    if (!fromCompressed && !fromDisk) {
+        auto buildStart = TilePipelineStats::Clock::now();
+        if (sourceLevel < 0 && ReadScaledTile(source, rect, pixels)) {
+            RecordStage(source, TileStage::Decode, buildStart);
+            decodedBytes_ += static_cast<uint64_t>(tileWidth * tileHeight) * sizeof(uint32_t);
+        } else if (sourceLevel < 0) {
+            if (!SynthesizeTile(source, key, pixels, tileWidth, tileHeight, gridWidth / 2, gridHeight / 2)) {
+                pool->Release(pixels, capacity);
+                return nullptr;
+            }
+            RecordStage(source, TileStage::Synthesize, buildStart);
+        } else {
+            if (!source.loader->ReadRegionInto(sourceLevel, x0, y0, tileWidth, tileHeight, pixels)) {
+                pool->Release(pixels, capacity);
+                return nullptr;
+            }
+            RecordStage(source, TileStage::Decode, buildStart);
+            decodedBytes_ += static_cast<uint64_t>(tileWidth * tileHeight) * sizeof(uint32_t);
+        }
+
+        // Persist before handing the buffer to the cache, which may recycle
+        // it as soon as the tile is evicted. The write lands in the OS page
+        // cache, so it is cheap next to the decode.
+        if (source.diskCache) {
+            source.diskCache->Store(key, pixels, static_cast<int32_t>(tileWidth), static_cast<int32_t>(tileHeight));
+        }
+    }
+    if (!fromCompressed) {
+        StoreCompressed(source, key, pixels, tileWidth, tileHeight);
     }
 
-    // Store in cache
-    TileData tileData(pixels, tileWidth, tileHeight);
+    // Store in cache (the buffer returns to the pool when the tile is freed),
+    // unless its slide went away meanwhile
+    if (IsCancelled(source)) {
+        pool->Release(pixels, capacity);
+        return nullptr;
+    }
+    TileData tileData(pixels, tileWidth, tileHeight, std::move(pool), capacity);
+    tileData.requestTime = requestTime;
+    auto insertStart = TilePipelineStats::Clock::now();
     cache_->InsertTile(key, std::move(tileData));
+    RecordStage(source, TileStage::CacheInsert, insertStart);
+    return cache_->GetTile(key);
+}
 
-    // Notify that tile is ready
-    if (onTileReady_) {
-        onTileReady_(key);
+bool TileLoadThreadPool::ReadScaledTile(const SlideSource& source, const TileRect& rect, uint32_t* pixels) {
+    if (!source.pyramid) {
+        return false;
+    }
+    // Nearest finer level the slide stores; synthesized levels halve each
+    // step, so the ratio is a power of two and 8 at most reaches 3 levels
+    const PyramidLevel* finer = nullptr;
+    for (int32_t level = source.pyramid->GetLevelCount() - 1; level >= 0; --level) {
+        const PyramidLevel& candidate = source.pyramid->GetLevel(level);
+        if (candidate.sourceLevel >= 0 && candidate.downsample < rect.downsample) {
+            finer = &candidate;
+            break;
+        }
+    }
+    if (!finer) {
+        return false;
+    }
+    const int32_t scale = static_cast<int32_t>(std::lround(rect.downsample / finer->downsample));
+    if (!source.loader->CanReadScaled(finer->sourceLevel, scale)) {
+        return false;
+    }
+    return source.loader->ReadRegionScaled(finer->sourceLevel, static_cast<int64_t>(rect.levelX * rect.downsample),
+                                           static_cast<int64_t>(rect.levelY * rect.downsample), rect.width,
+                                           rect.height, scale, pixels);
+}
+
+bool TileLoadThreadPool::SynthesizeTile(const SlideSource& source, const TileKey& key, uint32_t* pixels,
+                                        int64_t width, int64_t height, int64_t halfWidth, int64_t halfHeight) {
+    // The 2x2 children on the next finer level (same tile grid) cover this
+    // tile exactly: child (dx, dy) lands in the quadrant starting at
+    // (halfWidth * dx, halfHeight * dy)
+    for (int32_t dy = 0; dy < 2; ++dy) {
+        for (int32_t dx = 0; dx < 2; ++dx) {
+            int64_t outX = halfWidth * dx;
+            int64_t outY = halfHeight * dy;
+            if (outX >= width || outY >= height) {
+                continue;  // Past the level's right or bottom edge
+            }
+
+            TileKey childKey{key.level - 1, key.tileX * 2 + dx, key.tileY * 2 + dy, key.slide};
+
+            // Children already in memory are free; the others are loaded
+            // (and cached) here, recursing through synthesized levels
+            TileHandle child = cache_->GetTile(childKey);
+            if (!child) {
+                child = LoadTile(source, childKey);
+            }
+            if (!child || outX + (child->width + 1) / 2 > width || outY + (child->height + 1) / 2 > height) {
+                return false;
+            }
+
+            std::vector<uint32_t> unpacked;
+            PyramidLayout::Downsample2x(child->GetArgb(unpacked), child->width, child->height, child->width,
+                                        pixels + outY * width + outX, static_cast<size_t>(width));
+        }
     }
+    return true;
 }
@@ -1,34 +1,100 @@
 #pragma once
 
+#include "FlatTileMap.h"
 #include "TileLoadRequest.h"
 #include "TileCache.h"
+#include "LatencyHistogram.h"
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
 #include <vector>
 #include <functional>
 #include <atomic>
-#include <set>
+#include <cstdint>
+#include <array>
+#include <list>
+#include <map>
+#include <optional>
 
 class SlideLoader;
+class DiskTileCache;
+class PyramidLayout;
 
 class TileLoadThreadPool {
 public:
     using TileReadyCallback = std::function<void(const TileKey&)>;
 
-    explicit TileLoadThreadPool(size_t numThreads = 4);
+    // Where one slide's tiles come from; everything but loader is optional
+    struct SlideSource {
+        SlideLoader* loader = nullptr;
+        const PyramidLayout* pyramid = nullptr;  // See SetPyramid
+        DiskTileCache* diskCache = nullptr;      // See SetDiskCache
+        TilePipelineStats* stats = nullptr;      // See SetStats
+        TileReadyCallback onTileReady;
+        // Set by the pool: raised once the slide is being removed, so its
+        // in-flight tiles stop at their next stage
+        const std::atomic<bool>* cancelled = nullptr;
+    };
+
+    // numThreads = 0 picks DefaultThreadCount()
+    explicit TileLoadThreadPool(size_t numThreads = 0);
     ~TileLoadThreadPool();
 
-    // Initialize with dependencies (must be called before Start)
+    // Single slide: the cache, and slide 0's loader (must be called before Start)
     void Initialize(SlideLoader* loader, TileCache* cache, TileReadyCallback onTileReady);
 
+    // Shared pool: the cache only; slides come and go with AddSlide and
+    // RemoveSlide while the workers run
+    void Initialize(TileCache* cache);
+
+    // Register a slide under the id its tile keys carry (TileKey::slide);
+    // its source must outlive the registration. False if the id is taken.
+    // Requests for slides not registered are ignored. Within a priority
+    // band, workers take turns among the slides with work queued, so one
+    // viewport's backlog never holds back another's visible tiles.
+    bool AddSlide(uint32_t slide, SlideSource source);
+
+    // Drop the slide's queued requests and wait for its in-flight ones,
+    // after which its loader may go away. In-flight tiles are abandoned at
+    // their next stage (read, decode, cache insert) and what they produce
+    // is discarded; a read already inside the loader runs to its end.
+    // With wait = false it returns at once and the slide leaves when its
+    // last in-flight tile does (HasSlide turns false): its source must
+    // stay alive until then. Slide switches use this so they never wait
+    // on stale decodes.
+    void RemoveSlide(uint32_t slide, bool wait = true);
+    bool HasSlide(uint32_t slide) const;
+
+    size_t GetSlideCount() const;
+
+    // Slide 0's optional persistent tier (must be set before Start). Workers
+    // try it before decoding and write every freshly decoded tile back to it.
+    void SetDiskCache(DiskTileCache* diskCache);
+
+    // Slide 0's optional pyramid with synthesized levels (must be set before
+    // Start and outlive the pool). Without it, tile keys index slide levels.
+    void SetPyramid(const PyramidLayout* pyramid);
+
+    // Slide 0's optional stage timings (queue wait, disk read, decode,
+    // synthesis, cache insert). Must be set before Start and outlive the pool.
+    void SetStats(TilePipelineStats* stats);
+
     // Start/stop the thread pool
     void Start();
     void Stop();
 
-    // Submit a tile load request
-    void SubmitRequest(const TileLoadRequest& request);
+    // Submit a tile load request. Returns true if the tile was newly queued.
+    // Resubmitting a queued tile refreshes its generation and promotes it if
+    // the new priority is higher (e.g. a prefetched tile that became visible).
+    bool SubmitRequest(const TileLoadRequest& request);
+
+    // Submit a frame's worth of requests under one lock. At most maxNew
+    // tiles are newly queued; already-queued ones are always refreshed.
+    // Each band is served in submission order, so submit best first; a
+    // resubmitted scored request (TileLoadRequest::score) also moves to
+    // the back of its band, taking this frame's place in the order.
+    // Returns how many were newly queued.
+    size_t SubmitRequests(const TileLoadRequest* requests, size_t count, size_t maxNew = SIZE_MAX);
 
     // Cancel a specific request (if not yet started)
     void CancelRequest(const TileKey& key);
@@ -36,35 +102,270 @@ public:
     // Cancel all pending requests
     void CancelAllRequests();
 
+    // Retire queued requests that were not resubmitted in the given render
+    // generation: visible-priority requests are demoted to ADJACENT, and any
+    // request older than STALE_DROP_GENERATIONS is dropped. Each slide's
+    // renderer counts its own generations, so a shared pool retires them
+    // one slide at a time.
+    void RetireStaleRequests(uint64_t currentGeneration);
+    void RetireStaleSlideRequests(uint32_t slide, uint64_t currentGeneration);
+
+    // Coalescing: a worker popping a VISIBLE or ADJACENT tile also takes
+    // queued neighbours of the same priority and decodes them with one
+    // region read, amortising OpenSlide's per-call cost and the native
+    // tiles they share. On by default.
+    void SetCoalescing(bool enabled) { coalescing_ = enabled; }
+
+    // Tiles read together with head: the largest rectangle containing head
+    // within its aligned COALESCE_BLOCK x COALESCE_BLOCK block whose other
+    // tiles all pass canJoin. Head comes first, and alone if none joins.
+    static std::vector<TileKey> CoalesceBlock(const TileKey& head,
+                                              const std::function<bool(const TileKey&)>& canJoin);
+
+    // Read-ahead stage: ioThreads I/O threads (DEFAULT_IO_THREADS unless
+    // set before Start; 0 disables the stage) take queued batches of
+    // slides with direct TIFF reads in the same priority order as the
+    // workers and fetch their tile bytes (SlideLoader::FetchRegion), so a
+    // worker decoding them does no I/O and never sits idle on a slow or
+    // network disk. At most READ_AHEAD_TILES tiles are fetched ahead of
+    // the workers, and a worker takes a fetched batch only when no queued
+    // one outranks it: read-ahead reorders nothing.
+    void SetReadAheadThreads(size_t ioThreads) { ioThreads_ = ioThreads; }
+    size_t GetReadAheadThreads() const { return ioThreads_; }
+
+    // OS scheduling of the worker and read-ahead threads (set before
+    // Start): below the render thread unless backgroundPriority is false
+    // (see ThreadScheduling::LowerCurrentThreadPriority), and kept off the
+    // first reservedCores cores so decode bursts never take the render
+    // thread's core (0 by default: no affinity)
+    void SetThreadScheduling(bool backgroundPriority, size_t reservedCores) {
+        backgroundPriority_ = backgroundPriority;
+        reservedCores_ = reservedCores;
+    }
+    bool HasBackgroundPriority() const { return backgroundPriority_; }
+    size_t GetReservedCores() const { return reservedCores_; }
+
     // Check if a tile is currently pending (in queue or being processed)
     bool IsPending(const TileKey& key) const;
 
+    // Runtime scaling: all numThreads workers are started, but only the
+    // first GetWorkerLimit() take work. UpdateScaling() (called once per
+    // frame) raises the limit while the backlog would take longer than
+    // SCALE_UP_BACKLOG_MS to drain at the measured decode latency, and
+    // lowers it back towards minThreads once the queue is empty.
+    void EnableAutoScaling(size_t minThreads);
+    void UpdateScaling();
+
+    // Hardware concurrency minus DEFAULT_HEADROOM_THREADS for the render
+    // thread and the OS, and at least one
+    static size_t DefaultThreadCount();
+
     // Statistics
     size_t GetPendingCount() const;
+    size_t GetPendingCount(uint32_t slide) const;
     size_t GetActiveCount() const { return activeCount_.load(); }
+    size_t GetDroppedCount() const { return droppedCount_.load(); }
+    size_t GetThreadCount() const { return numThreads_; }
+    size_t GetWorkerLimit() const { return workerLimit_.load(); }
+    double GetAverageDecodeMs() const { return averageDecodeMs_.load(); }
+    // Pixel bytes decoded by OpenSlide (disk cache hits excluded)
+    uint64_t GetDecodedBytes() const { return decodedBytes_.load(); }
+    // Region reads covering several tiles, and the tiles they produced
+    size_t GetCoalescedReadCount() const { return coalescedReads_.load(); }
+    size_t GetCoalescedTileCount() const { return coalescedTiles_.load(); }
+    // Tiles decoded after the read-ahead stage fetched them, and its bytes
+    size_t GetFetchedTileCount() const { return fetchedTiles_.load(); }
+    uint64_t GetFetchedBytes() const { return fetchedBytes_.load(); }
+
+    // Generations a request may go without being resubmitted before it is dropped
+    static constexpr uint64_t STALE_DROP_GENERATIONS = 30;
+
+    static constexpr size_t DEFAULT_HEADROOM_THREADS = 2;
+    static constexpr double SCALE_UP_BACKLOG_MS = 100.0;
+    // Frames the queue must stay empty before a worker is parked
+    static constexpr uint32_t SCALE_DOWN_IDLE_FRAMES = 60;
+
+    // Tile grid when no pyramid is set (see SetPyramid)
+    static constexpr int64_t DEFAULT_TILE_SIZE = 512;
+
+    // Coalesced reads cover at most this many tiles on each axis
+    static constexpr int32_t COALESCE_BLOCK = 2;
+
+    static constexpr size_t DEFAULT_IO_THREADS = 2;
+    // Tiles being fetched or fetched and waiting for a worker
+    static constexpr size_t READ_AHEAD_TILES = 32;
 
 private:
-    void WorkerLoop();
-    bool PopNextRequest(TileLoadRequest& outRequest);
-    void ProcessRequest(const TileLoadRequest& request);
+    // Queued requests wait in one FIFO band per priority level; each entry
+    // remembers its place so it can be moved or removed in O(1)
+    using Band = std::list<TileKey>;
+
+    static constexpr size_t PRIORITY_BANDS = 3;
+
+    // A registered slide with its own bands, so open slides take turns
+    // (see PopNextBatch)
+    struct Slide {
+        uint32_t id = 0;
+        SlideSource source;
+        std::array<Band, PRIORITY_BANDS> bands;
+        size_t queued = 0;
+        size_t inFlight = 0;
+        bool removing = false;  // RemoveSlide was called; no new work
+        bool detached = false;  // Nobody waits: the last in-flight tile erases it
+        std::atomic<bool> cancelled{false};  // source.cancelled
+    };
+
+    // The single record of a pending tile, from submission until its
+    // worker finishes (position is only meaningful while queued)
+    struct PendingRequest {
+        bool inFlight;
+        TileLoadPriority priority;
+        uint64_t generation;
+        Band::iterator position;
+        std::chrono::steady_clock::time_point requestTime;
+        Slide* slide;
+    };
+
+    using PendingMap = FlatTileMap<PendingRequest>;
+
+    // A batch the read-ahead stage has fetched, waiting for a worker. Its
+    // tiles stay in flight throughout.
+    struct FetchedBatch {
+        Slide* slide;
+        std::vector<TileLoadRequest> batch;
+    };
+
+    // A tile's place on its level's grid, clipped at the level's edge
+    struct TileRect {
+        int32_t sourceLevel;  // Slide level, or -1 if synthesized
+        double downsample;
+        int64_t levelX;       // Top-left, in level pixels
+        int64_t levelY;
+        int64_t width;
+        int64_t height;
+        int64_t gridWidth;
+        int64_t gridHeight;
+    };
+
+    // Applies SetThreadScheduling to the calling pool thread
+    void ApplyThreadScheduling();
+    void WorkerLoop(size_t workerIndex);
+    // Pop the highest-priority work: a fetched batch, or a queued request
+    // plus any neighbours coalesced with it if that outranks every fetched
+    // batch. Returns their slide, or nullptr if there is no work.
+    Slide* PopNextBatch(size_t workerIndex, std::vector<TileLoadRequest>& outBatch);
+
+    void ReadAheadLoop();
+    // Pop the highest-priority queued batch of a slide with direct reads,
+    // while the read-ahead bound allows; nullptr if none or shutting down
+    Slide* PopReadAheadBatch(std::vector<TileLoadRequest>& outBatch);
+    void FetchBatch(const SlideSource& source, const std::vector<TileLoadRequest>& batch);
+    void ProcessRequest(const SlideSource& source, const TileLoadRequest& request);
+    void ProcessBatch(const SlideSource& source, const std::vector<TileLoadRequest>& batch);
+
+    TileRect GetTileRect(const SlideSource& source, const TileKey& key) const;
+
+    static bool IsCancelled(const SlideSource& source) {
+        return source.cancelled && source.cancelled->load(std::memory_order_relaxed);
+    }
+
+    // Whether the tile is in memory, compressed or on disk already
+    bool IsCachedAnywhere(const SlideSource& source, const TileKey& key) const;
+
+    // Decode a rectangular batch with one region read and split it into
+    // cached tiles. Returns false (caching nothing) if the read fails.
+    bool LoadRegion(const SlideSource& source, const std::vector<TileLoadRequest>& batch);
+
+    // Read, decode or synthesize a tile and insert it into the cache
+    // requestTime travels with the tile for time-to-first-pixel stats.
+    TileHandle LoadTile(const SlideSource& source, const TileKey& key,
+                        std::chrono::steady_clock::time_point requestTime = {});
+    bool SynthesizeTile(const SlideSource& source, const TileKey& key, uint32_t* pixels,
+                        int64_t width, int64_t height, int64_t halfWidth, int64_t halfHeight);
+    // Decode a synthesized level's tile straight from the nearest finer
+    // slide level at reduced resolution (JPEG DCT scaling), skipping the
+    // full-size decode and downsampling. False if that level can't scale.
+    bool ReadScaledTile(const SlideSource& source, const TileRect& rect, uint32_t* pixels);
+
+    // All require queueMutex_ to be held
+    // The slide whose queued work comes next within bands [firstBand,
+    // bandLimit), taking turns among slides, and that band; slides_.end()
+    // if none. readAheadOnly skips slides without direct reads.
+    std::map<uint32_t, Slide>::iterator SelectSlide(size_t firstBand, size_t bandLimit, bool readAheadOnly,
+                                                    size_t* outBand);
+    // Move the band's oldest request, plus coalesced neighbours, in flight
+    void TakeBatch(Slide& slide, Band& band, std::vector<TileLoadRequest>& outBatch);
+    // The highest-priority fetched batch and its band (fetched_.end() and
+    // PRIORITY_BANDS if none)
+    std::list<FetchedBatch>::iterator BestFetched(size_t* outBand);
+    void DropFetched(Slide& slide);
+    void FinishInFlight(Slide& slide, const std::vector<TileLoadRequest>& batch);
+    void WakeWorkers(size_t count);
+    // Refresh a pending request, or queue it if allowNew (and not cached).
+    // Returns true if newly queued.
+    bool Enqueue(const TileLoadRequest& request, bool allowNew);
+    void EraseQueued(PendingMap::iterator it);
+    void StartLoading(PendingMap::iterator it);
+    void Reprioritize(PendingMap::iterator it, TileLoadPriority priority);
+    // All slides' requests, or one slide's
+    void RetireStale(uint64_t currentGeneration, std::optional<uint32_t> slide);
+    void ClearQueued(Slide& slide);
+
+    static void RecordStage(const SlideSource& source, TileStage stage,
+                            TilePipelineStats::Clock::time_point start);
+
+    // Keep a freshly built tile in the cache's compressed tier, if enabled
+    void StoreCompressed(const SlideSource& source, const TileKey& key, const uint32_t* pixels,
+                         int64_t width, int64_t height);
+
+    // Band index for a priority (0 is served first)
+    static size_t BandOf(TileLoadPriority priority);
 
     // Dependencies
-    SlideLoader* loader_ = nullptr;
     TileCache* cache_ = nullptr;
-    TileReadyCallback onTileReady_;
 
     // Thread pool
     std::vector<std::thread> workers_;
     size_t numThreads_;
     std::atomic<bool> running_{false};
     std::atomic<size_t> activeCount_{0};
+    std::atomic<size_t> droppedCount_{0};
+    std::atomic<uint64_t> decodedBytes_{0};
+    std::atomic<size_t> coalescedReads_{0};
+    std::atomic<size_t> coalescedTiles_{0};
+    bool coalescing_ = true;
+    bool backgroundPriority_ = true;
+    size_t reservedCores_ = 0;
+    std::atomic<bool> schedulingWarned_{false};  // Logged for the first thread only
+
+    // Read-ahead stage (see SetReadAheadThreads)
+    std::vector<std::thread> ioWorkers_;
+    size_t ioThreads_ = DEFAULT_IO_THREADS;
+    std::atomic<size_t> fetchedTiles_{0};
+    std::atomic<uint64_t> fetchedBytes_{0};
 
-    // Request queue (priority queue: highest priority first)
-    std::priority_queue<TileLoadRequest> requestQueue_;
+    // Scaling state: workers with index >= workerLimit_ stay parked
+    bool autoScaling_ = false;
+    size_t minThreads_ = 1;
+    std::atomic<size_t> workerLimit_{0};
+    std::atomic<double> averageDecodeMs_{0.0};  // EMA of per-tile decode time
+    uint32_t idleFrames_ = 0;
+
+    // Request queue: priority bands per slide for O(1) pops, and one hash
+    // table of every pending (queued or in-flight) key for O(1) dedup,
+    // promotion and removal. Everything sits behind one mutex, held only
+    // for these constant-time updates: decodes take milliseconds, so
+    // workers never contend on it, and a single queue keeps the global
+    // priority order that per-worker deques with stealing would lose.
+    // Slides sit in a std::map, whose nodes stay put as slides come and go.
+    std::map<uint32_t, Slide> slides_;
+    uint32_t lastServedSlide_ = 0;
+    PendingMap pending_;
+    size_t queuedCount_ = 0;
+    std::list<FetchedBatch> fetched_;
+    size_t readAheadTiles_ = 0;  // Being fetched, or in fetched_
     mutable std::mutex queueMutex_;
     std::condition_variable queueCondition_;
-
-    // Track pending tiles to avoid duplicate requests
-    std::set<TileKey> pendingKeys_;
-    mutable std::mutex pendingMutex_;
+    std::condition_variable readAheadCondition_;  // Queued work or read-ahead room
+    std::condition_variable slideIdleCondition_;  // A slide's in-flight tiles finished
 };
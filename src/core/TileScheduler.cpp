@@ -0,0 +1,88 @@
+#include "TileScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+void TileScheduler::BeginFrame(Clock::time_point now) {
+    now_ = now;
+    frame_++;
+    decisions_.clear();
+}
+
+TileLoadRequest TileScheduler::Schedule(const TileKey& key, Inputs inputs, uint64_t generation) {
+    auto inserted = missing_.try_emplace(key, Missing{now_, frame_, false});
+    Missing& missing = inserted.first->second;
+    missing.frame = frame_;
+    inputs.ageMs = std::chrono::duration<double, std::milli>(now_ - missing.since).count();
+
+    TileLoadPriority priority = PriorityOf(inputs);
+    if (inputs.hasFallback && priority == TileLoadPriority::URGENT && !missing.promoted) {
+        missing.promoted = true;
+        deadlineMisses_++;
+    }
+
+    double score = Score(inputs);
+    decisions_.push_back({key, inputs, score, priority});
+    TileLoadRequest request(key, priority, generation);
+    request.score = score;
+    return request;
+}
+
+void TileScheduler::EndFrame() {
+    for (auto it = missing_.begin(); it != missing_.end();) {
+        if (it->second.frame != frame_) {
+            it = missing_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+double TileScheduler::Score(const Inputs& inputs) const {
+    double age = deadlineMs_ > 0.0 ? std::min(inputs.ageMs / deadlineMs_, MAX_AGE_TERM) : 0.0;
+    return weights_.coverage * inputs.coverage +
+           weights_.centre * (1.0 - inputs.centreDistance) +
+           weights_.noFallback * (inputs.hasFallback ? 0.0 : 1.0) +
+           weights_.levelFit * inputs.levelFit +
+           weights_.age * age;
+}
+
+TileLoadPriority TileScheduler::PriorityOf(const Inputs& inputs) const {
+    if (!inputs.hasFallback) {
+        return TileLoadPriority::URGENT;  // Nothing on screen in its place
+    }
+    if (deadlineMs_ > 0.0 && inputs.ageMs >= deadlineMs_) {
+        return TileLoadPriority::URGENT;  // Blurry for too long
+    }
+    return TileLoadPriority::VISIBLE;
+}
+
+double TileScheduler::Coverage(const SDL_Rect& tile, int32_t viewWidth, int32_t viewHeight) {
+    if (viewWidth <= 0 || viewHeight <= 0) {
+        return 0.0;
+    }
+    int64_t visibleW = std::min<int64_t>(tile.x + tile.w, viewWidth) - std::max(tile.x, 0);
+    int64_t visibleH = std::min<int64_t>(tile.y + tile.h, viewHeight) - std::max(tile.y, 0);
+    if (visibleW <= 0 || visibleH <= 0) {
+        return 0.0;
+    }
+    return static_cast<double>(visibleW * visibleH) / (static_cast<double>(viewWidth) * viewHeight);
+}
+
+double TileScheduler::CentreDistance(const SDL_Rect& tile, int32_t viewWidth, int32_t viewHeight) {
+    double halfWidth = viewWidth / 2.0;
+    double halfHeight = viewHeight / 2.0;
+    double halfDiagonal = std::hypot(halfWidth, halfHeight);
+    if (halfDiagonal <= 0.0) {
+        return 0.0;
+    }
+    double dx = tile.x + tile.w / 2.0 - halfWidth;
+    double dy = tile.y + tile.h / 2.0 - halfHeight;
+    return std::min(std::hypot(dx, dy) / halfDiagonal, 1.0);
+}
+
+double TileScheduler::LevelFit(double levelDownsample, double idealDownsample) {
+    if (levelDownsample <= 0.0 || idealDownsample <= 0.0) {
+        return 0.0;
+    }
+    return std::min(levelDownsample, idealDownsample) / std::max(levelDownsample, idealDownsample);
+}
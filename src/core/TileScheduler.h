@@ -0,0 +1,103 @@
+#pragma once
+
+#include "FlatTileMap.h"
+#include "TileLoadRequest.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Ranks the visible tiles a frame still has to load. Each gets a score
+// from how much of its view it covers, how close it sits to the view's
+// centre, whether a coarser fallback is showing in its place, how well its
+// level fits the zoom, and how long it has been missing; the decode pool
+// serves a priority band's scored tiles highest score first (see
+// TileLoadThreadPool::SubmitRequests).
+//
+// The deadline is the "time to sharp" target: a tile still missing that
+// long after it first went missing is raised to URGENT even with a
+// fallback showing. The last frame's decisions are kept for tuning the
+// weights (the perf.tile_schedule IPC method).
+//
+// Render thread only.
+class TileScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Score = sum of weight * term, each term in [0, 1] (age up to
+    // MAX_AGE_TERM)
+    struct Weights {
+        double coverage = 1.0;    // Fraction of the view the tile covers
+        double centre = 0.5;      // 1 at the view's centre, 0 at a corner
+        double noFallback = 2.0;  // 1 if nothing is drawn in its place
+        double levelFit = 0.25;   // 1 if the level's downsample is the zoom's
+        double age = 1.0;         // Time missing over the deadline
+    };
+
+    // Where a missing tile stands this frame
+    struct Inputs {
+        double coverage = 0.0;
+        double centreDistance = 0.0;  // 0 at the centre, 1 at a corner
+        bool hasFallback = false;
+        double levelFit = 1.0;
+        double ageMs = 0.0;
+    };
+
+    struct Decision {
+        TileKey key;
+        Inputs inputs;
+        double score;
+        TileLoadPriority priority;
+    };
+
+    void SetWeights(const Weights& weights) { weights_ = weights; }
+    const Weights& GetWeights() const { return weights_; }
+
+    // 0 disables deadline promotion
+    void SetDeadlineMs(double deadlineMs) { deadlineMs_ = deadlineMs; }
+    double GetDeadlineMs() const { return deadlineMs_; }
+
+    // Start a frame: decisions of the previous one are cleared
+    void BeginFrame(Clock::time_point now);
+
+    // Score a missing tile (inputs.ageMs is filled in from when it first
+    // went missing) and return its request
+    TileLoadRequest Schedule(const TileKey& key, Inputs inputs, uint64_t generation);
+
+    // End a frame: tiles not scheduled during it loaded or left the
+    // screen, and start over if they go missing again
+    void EndFrame();
+
+    double Score(const Inputs& inputs) const;
+    TileLoadPriority PriorityOf(const Inputs& inputs) const;
+
+    // Screen-space inputs: the visible part of tile in a view of
+    // viewWidth x viewHeight, and the fit of a level of levelDownsample
+    // to the zoom's ideal downsample (their ratio, the smaller over the
+    // larger)
+    static double Coverage(const SDL_Rect& tile, int32_t viewWidth, int32_t viewHeight);
+    static double CentreDistance(const SDL_Rect& tile, int32_t viewWidth, int32_t viewHeight);
+    static double LevelFit(double levelDownsample, double idealDownsample);
+
+    // The last frame's decisions, in scheduling order
+    const std::vector<Decision>& GetDecisions() const { return decisions_; }
+    // Tiles promoted for missing the deadline, since construction
+    uint64_t GetDeadlineMissCount() const { return deadlineMisses_; }
+
+    static constexpr double DEFAULT_DEADLINE_MS = 250.0;
+    static constexpr double MAX_AGE_TERM = 2.0;
+
+private:
+    struct Missing {
+        Clock::time_point since;
+        uint64_t frame;
+        bool promoted;  // Counted as a deadline miss already
+    };
+
+    Weights weights_;
+    double deadlineMs_ = DEFAULT_DEADLINE_MS;
+    Clock::time_point now_{};
+    uint64_t frame_ = 0;
+    FlatTileMap<Missing> missing_;
+    std::vector<Decision> decisions_;
+    uint64_t deadlineMisses_ = 0;
+};
@@ -0,0 +1,525 @@
+#include "TileService.h"
+#include "PNGEncoder.h"
+#include "PixelConvert.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <csetjmp>
+#include <cstdio>  // jpeglib.h needs FILE
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+// Downsamples within this of a DeepZoom level's count as equal
+constexpr double DOWNSAMPLE_TOLERANCE = 1e-3;
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+struct JpegErrorManager {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+void JpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegErrorManager*>(info->err)->jump, 1);
+}
+
+bool EncodeJpeg(const std::vector<uint8_t>& rgb, int32_t width, int32_t height, int quality,
+                std::vector<uint8_t>& out) {
+    // Nothing below setjmp may need unwinding: the output buffer is malloc'd
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+
+    jpeg_compress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = JpegErrorExit;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_compress(&info);
+        std::free(buffer);
+        return false;
+    }
+    jpeg_create_compress(&info);
+    jpeg_mem_dest(&info, &buffer, &size);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, quality, TRUE);
+    jpeg_start_compress(&info, TRUE);
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(rgb.data() + static_cast<size_t>(info.next_scanline) * width * 3);
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    out.assign(buffer, buffer + size);
+    std::free(buffer);
+    return true;
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+bool EncodeTile(const std::vector<uint32_t>& pixels, int32_t width, int32_t height,
+                std::vector<uint8_t>& out) {
+    // Premultiplied ARGB over a white background
+#ifdef PATHVIEW_HAS_LIBJPEG
+    std::vector<uint8_t> rgb(pixels.size() * 3);
+    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGB24, AlphaMode::OverWhite>(
+        pixels.data(), rgb.data(), pixels.size());
+    return EncodeJpeg(rgb, width, height, TileService::JPEG_QUALITY, out);
+#else
+    std::vector<uint8_t> rgba(pixels.size() * 4);
+    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::OverWhite>(
+        pixels.data(), rgba.data(), pixels.size());
+    try {
+        out = pathview::PNGEncoder::Encode(rgba, width, height);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+#endif
+}
+
+}  // namespace
+
+TileService::TileService(size_t encodedCacheBytes)
+    : capacity_(encodedCacheBytes)
+{
+}
+
+TileService::~TileService() {
+    ClearSlide();
+}
+
+void TileService::SetSlide(TileServiceSlide slide) {
+    auto next = std::make_shared<const TileServiceSlide>(std::move(slide));
+    uint64_t epoch = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(sourceMutex_);
+        slide_ = std::move(next);
+        epoch = ++epoch_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        encoded_.clear();
+        lru_.clear();
+        cachedBytes_ = 0;
+        cacheEpoch_ = epoch;
+    }
+    tileReady_.notify_all();
+}
+
+void TileService::ClearSlide() {
+    uint64_t epoch = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(sourceMutex_);
+        slide_.reset();
+        epoch = ++epoch_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        encoded_.clear();
+        lru_.clear();
+        cachedBytes_ = 0;
+        cacheEpoch_ = epoch;
+    }
+    // Waiting requests notice the change and give up
+    tileReady_.notify_all();
+}
+
+void TileService::OnTileReady() {
+    tileReady_.notify_all();
+}
+
+std::string TileService::MakeSlideId(const std::string& path) {
+    // FNV-1a: stable across runs, so browser caches survive a restart
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream id;
+    id << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return id.str();
+}
+
+std::vector<std::string> TileService::GetSlideIds() const {
+    std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+    if (!slide_) {
+        return {};
+    }
+    return {slide_->id};
+}
+
+const char* TileService::GetTileFormat() {
+#ifdef PATHVIEW_HAS_LIBJPEG
+    return "jpg";
+#else
+    return "png";
+#endif
+}
+
+int32_t TileService::GetMaxLevel(int64_t width, int64_t height) {
+    int64_t size = std::max(width, height);
+    int32_t level = 0;
+    while ((int64_t{1} << level) < size) {
+        level++;
+    }
+    return level;
+}
+
+TileServiceStatus TileService::GetDzi(const std::string& id, std::string& xml) const {
+    std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+    if (!slide_ || slide_->id != id) {
+        return TileServiceStatus::NotFound;
+    }
+    std::ostringstream out;
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"" << GetTileFormat()
+        << "\" Overlap=\"0\" TileSize=\"" << TILE_SIZE << "\">\n"
+        << "  <Size Width=\"" << slide_->width << "\" Height=\"" << slide_->height << "\"/>\n"
+        << "</Image>\n";
+    xml = out.str();
+    return TileServiceStatus::Ok;
+}
+
+TileServiceStatus TileService::GetIiifInfo(const std::string& id, const std::string& baseUri,
+                                           std::string& json) const {
+    std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+    if (!slide_ || slide_->id != id) {
+        return TileServiceStatus::NotFound;
+    }
+    int32_t maxLevel = GetMaxLevel(slide_->width, slide_->height);
+    std::ostringstream out;
+    out << "{\"@context\":\"http://iiif.io/api/image/2/context.json\","
+        << "\"@id\":\"" << baseUri << "\","
+        << "\"protocol\":\"http://iiif.io/api/image\","
+        << "\"width\":" << slide_->width << ",\"height\":" << slide_->height << ","
+        << "\"profile\":[\"http://iiif.io/api/image/2/level0.json\",{\"formats\":[\""
+        << GetTileFormat() << "\"]}],"
+        << "\"tiles\":[{\"width\":" << TILE_SIZE << ",\"scaleFactors\":[";
+    // Down to the scale where the whole image fits one tile
+    for (int32_t k = 0; k <= maxLevel; ++k) {
+        out << (k ? "," : "") << (int64_t{1} << k);
+        if ((int64_t{TILE_SIZE} << k) >= std::max(slide_->width, slide_->height)) {
+            break;
+        }
+    }
+    out << "]}]}";
+    json = out.str();
+    return TileServiceStatus::Ok;
+}
+
+TileServiceStatus TileService::GetIiifTile(const std::string& id, int64_t x, int64_t y, int64_t width,
+                                           int64_t height, int64_t sizeWidth, EncodedTile& out) {
+    int64_t slideWidth = 0;
+    int64_t slideHeight = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+        if (!slide_ || slide_->id != id) {
+            return TileServiceStatus::NotFound;
+        }
+        slideWidth = slide_->width;
+        slideHeight = slide_->height;
+    }
+
+    if (width == 0 && height == 0) {
+        width = slideWidth;
+        height = slideHeight;
+    }
+
+    // Find the scale factor whose tile grid this region and size match
+    int32_t maxLevel = GetMaxLevel(slideWidth, slideHeight);
+    for (int32_t k = 0; k <= maxLevel; ++k) {
+        int64_t span = int64_t{TILE_SIZE} << k;
+        if (x < 0 || y < 0 || x % span != 0 || y % span != 0 || x >= slideWidth || y >= slideHeight) {
+            continue;
+        }
+        int64_t expectedWidth = std::min(span, slideWidth - x);
+        int64_t expectedHeight = std::min(span, slideHeight - y);
+        int64_t scale = int64_t{1} << k;
+        bool sizeMatches = sizeWidth == 0 ? k == 0 : sizeWidth == (expectedWidth + scale - 1) / scale;
+        if (width == expectedWidth && height == expectedHeight && sizeMatches) {
+            return GetTile(id, maxLevel - k, x / span, y / span, out);
+        }
+    }
+    return TileServiceStatus::NotFound;
+}
+
+TileServiceStatus TileService::GetTile(const std::string& id, int32_t level, int64_t column, int64_t row,
+                                       EncodedTile& out) {
+    std::shared_ptr<const TileServiceSlide> slide;
+    uint64_t epoch = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+        slide = slide_;
+        epoch = epoch_;
+    }
+    if (!slide || slide->id != id) {
+        return TileServiceStatus::NotFound;
+    }
+
+    int32_t maxLevel = GetMaxLevel(slide->width, slide->height);
+    if (level < 0 || level > maxLevel) {
+        return TileServiceStatus::NotFound;
+    }
+    int64_t scale = int64_t{1} << (maxLevel - level);
+    int64_t levelWidth = (slide->width + scale - 1) / scale;
+    int64_t levelHeight = (slide->height + scale - 1) / scale;
+    // Divided, not multiplied: column and row come from the URL
+    if (column < 0 || row < 0 || column >= (levelWidth + TILE_SIZE - 1) / TILE_SIZE ||
+        row >= (levelHeight + TILE_SIZE - 1) / TILE_SIZE) {
+        return TileServiceStatus::NotFound;
+    }
+
+    uint64_t key = CacheKey(level, column, row);
+    if (LookupEncoded(key, epoch, out)) {
+        encodedHits_++;
+        return TileServiceStatus::Ok;
+    }
+    encodedMisses_++;
+
+    int32_t outWidth = static_cast<int32_t>(std::min<int64_t>(TILE_SIZE, levelWidth - column * TILE_SIZE));
+    int32_t outHeight = static_cast<int32_t>(std::min<int64_t>(TILE_SIZE, levelHeight - row * TILE_SIZE));
+    int64_t x0 = column * TILE_SIZE * scale;
+    int64_t y0 = row * TILE_SIZE * scale;
+    int64_t x1 = std::min(x0 + outWidth * scale, slide->width);
+    int64_t y1 = std::min(y0 + outHeight * scale, slide->height);
+
+    std::vector<uint32_t> pixels;
+    TileServiceStatus status = ComposeTile(slide, static_cast<double>(scale), x0, y0, x1, y1,
+                                           outWidth, outHeight, pixels);
+    if (status != TileServiceStatus::Ok) {
+        return status;
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    if (!EncodeTile(pixels, outWidth, outHeight, *data)) {
+        return TileServiceStatus::Unavailable;
+    }
+
+    out.data = std::move(data);
+    out.etag = "\"" + slide->id + "-" + std::to_string(level) + "-" + std::to_string(column) + "-" +
+               std::to_string(row) + "-" + GetTileFormat() + std::to_string(JPEG_QUALITY) + "\"";
+#ifdef PATHVIEW_HAS_LIBJPEG
+    out.mimeType = "image/jpeg";
+#else
+    out.mimeType = "image/png";
+#endif
+    StoreEncoded(key, epoch, out);
+    return TileServiceStatus::Ok;
+}
+
+TileServiceStatus TileService::ComposeTile(const std::shared_ptr<const TileServiceSlide>& slide, double downsample,
+                                           int64_t x0, int64_t y0, int64_t x1, int64_t y1,
+                                           int32_t outWidth, int32_t outHeight, std::vector<uint32_t>& pixels) {
+    // Finest pipeline level no sharper than the DeepZoom level
+    const PyramidLayout& pyramid = slide->pyramid;
+    if (pyramid.GetLevelCount() == 0) {
+        return TileServiceStatus::NotFound;
+    }
+    int32_t level = 0;
+    for (int32_t i = 0; i < pyramid.GetLevelCount(); ++i) {
+        if (pyramid.GetLevelDownsample(i) <= downsample * (1.0 + DOWNSAMPLE_TOLERANCE)) {
+            level = i;
+        }
+    }
+    double levelDownsample = pyramid.GetLevelDownsample(level);
+    LevelDimensions dimensions = pyramid.GetLevelDimensions(level);
+    int64_t tileWidth = pyramid.GetTileWidth(level);
+    int64_t tileHeight = pyramid.GetTileHeight(level);
+
+    // The region in that level's pixels
+    int64_t sx0 = std::min(static_cast<int64_t>(std::floor(x0 / levelDownsample)), dimensions.width - 1);
+    int64_t sy0 = std::min(static_cast<int64_t>(std::floor(y0 / levelDownsample)), dimensions.height - 1);
+    int64_t sx1 = std::max(std::min(static_cast<int64_t>(std::ceil(x1 / levelDownsample)), dimensions.width), sx0 + 1);
+    int64_t sy1 = std::max(std::min(static_cast<int64_t>(std::ceil(y1 / levelDownsample)), dimensions.height), sy0 + 1);
+
+    std::vector<TileKey> keys;
+    for (int64_t row = sy0 / tileHeight; row * tileHeight < sy1; ++row) {
+        for (int64_t column = sx0 / tileWidth; column * tileWidth < sx1; ++column) {
+            keys.push_back({level, static_cast<int32_t>(column), static_cast<int32_t>(row)});
+        }
+    }
+
+    // Collect the pipeline tiles, queueing missing ones until they arrive.
+    // Resubmitting every slice keeps them current against the renderer's
+    // stale-request retirement.
+    std::vector<TileHandle> tiles(keys.size());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TILE_WAIT_MS);
+    for (;;) {
+        bool complete = true;
+        {
+            std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+            if (slide_ != slide) {
+                return TileServiceStatus::Unavailable;
+            }
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (tiles[i]) {
+                    continue;
+                }
+                tiles[i] = slide->getTile(keys[i]);
+                if (!tiles[i]) {
+                    complete = false;
+                    slide->requestTile(keys[i]);
+                }
+            }
+        }
+        if (complete) {
+            break;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            timeouts_++;
+            return TileServiceStatus::Unavailable;
+        }
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        tileReady_.wait_for(lock, std::chrono::milliseconds(WAIT_SLICE_MS));
+    }
+
+    // Stitch the region together at the pipeline level
+    int32_t width = static_cast<int32_t>(sx1 - sx0);
+    int32_t height = static_cast<int32_t>(sy1 - sy0);
+    std::vector<uint32_t> region(static_cast<size_t>(width) * height, 0);
+    std::vector<uint32_t> unpacked;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const TileData& tile = *tiles[i];
+        const uint32_t* pixels = tile.GetArgb(unpacked);
+        int64_t tileX = static_cast<int64_t>(keys[i].tileX) * tileWidth;
+        int64_t tileY = static_cast<int64_t>(keys[i].tileY) * tileHeight;
+        int64_t copyX0 = std::max(tileX, sx0);
+        int64_t copyX1 = std::min(tileX + tile.width, sx1);
+        int64_t copyY0 = std::max(tileY, sy0);
+        int64_t copyY1 = std::min(tileY + tile.height, sy1);
+        for (int64_t y = copyY0; y < copyY1; ++y) {
+            std::memcpy(region.data() + (y - sy0) * width + (copyX0 - sx0),
+                        pixels + (y - tileY) * tile.width + (copyX0 - tileX),
+                        static_cast<size_t>(std::max<int64_t>(0, copyX1 - copyX0)) * sizeof(uint32_t));
+        }
+    }
+
+    // Box-downsample by the remaining powers of two, then sample to the
+    // exact tile size (levels whose downsample is not a power of two)
+    double remaining = downsample / levelDownsample;
+    while (remaining >= 2.0 - DOWNSAMPLE_TOLERANCE && (width > outWidth || height > outHeight)) {
+        int32_t halfWidth = (width + 1) / 2;
+        int32_t halfHeight = (height + 1) / 2;
+        std::vector<uint32_t> half(static_cast<size_t>(halfWidth) * halfHeight);
+        PyramidLayout::Downsample2x(region.data(), width, height, static_cast<size_t>(width),
+                                    half.data(), static_cast<size_t>(halfWidth));
+        region.swap(half);
+        width = halfWidth;
+        height = halfHeight;
+        remaining /= 2.0;
+    }
+
+    if (width == outWidth && height == outHeight) {
+        pixels.swap(region);
+        return TileServiceStatus::Ok;
+    }
+    pixels.resize(static_cast<size_t>(outWidth) * outHeight);
+    for (int32_t y = 0; y < outHeight; ++y) {
+        int32_t sourceY = std::min(height - 1, static_cast<int32_t>((y + 0.5) * height / outHeight));
+        for (int32_t x = 0; x < outWidth; ++x) {
+            int32_t sourceX = std::min(width - 1, static_cast<int32_t>((x + 0.5) * width / outWidth));
+            pixels[static_cast<size_t>(y) * outWidth + x] = region[static_cast<size_t>(sourceY) * width + sourceX];
+        }
+    }
+    return TileServiceStatus::Ok;
+}
+
+TileServiceStatus TileService::RenderRegion(double x, double y, double downsample, int32_t outWidth,
+                                            int32_t outHeight, std::vector<uint32_t>& pixels) {
+    std::shared_ptr<const TileServiceSlide> slide;
+    {
+        std::shared_lock<std::shared_mutex> lock(sourceMutex_);
+        slide = slide_;
+    }
+    if (!slide || downsample <= 0.0 || outWidth <= 0 || outHeight <= 0) {
+        return TileServiceStatus::NotFound;
+    }
+    pixels.assign(static_cast<size_t>(outWidth) * outHeight, 0);
+
+    // Output pixels that show some of the slide
+    auto clampOutput = [](double value, int32_t size) {
+        return static_cast<int32_t>(std::clamp(value, 0.0, static_cast<double>(size)));
+    };
+    const int32_t outX0 = clampOutput(std::ceil(-x / downsample), outWidth);
+    const int32_t outY0 = clampOutput(std::ceil(-y / downsample), outHeight);
+    const int32_t outX1 = clampOutput(std::ceil((slide->width - x) / downsample), outWidth);
+    const int32_t outY1 = clampOutput(std::ceil((slide->height - y) / downsample), outHeight);
+
+    std::vector<uint32_t> chunk;
+    for (int32_t chunkY = outY0; chunkY < outY1; chunkY += REGION_CHUNK_SIZE) {
+        const int32_t chunkHeight = std::min(REGION_CHUNK_SIZE, outY1 - chunkY);
+        for (int32_t chunkX = outX0; chunkX < outX1; chunkX += REGION_CHUNK_SIZE) {
+            const int32_t chunkWidth = std::min(REGION_CHUNK_SIZE, outX1 - chunkX);
+            const int64_t x0 = std::max<int64_t>(0, static_cast<int64_t>(std::floor(x + chunkX * downsample)));
+            const int64_t y0 = std::max<int64_t>(0, static_cast<int64_t>(std::floor(y + chunkY * downsample)));
+            const int64_t x1 = std::min<int64_t>(slide->width,
+                static_cast<int64_t>(std::ceil(x + (chunkX + chunkWidth) * downsample)));
+            const int64_t y1 = std::min<int64_t>(slide->height,
+                static_cast<int64_t>(std::ceil(y + (chunkY + chunkHeight) * downsample)));
+            TileServiceStatus status = ComposeTile(slide, downsample, x0, y0, std::max(x1, x0 + 1),
+                                                   std::max(y1, y0 + 1), chunkWidth, chunkHeight, chunk);
+            if (status != TileServiceStatus::Ok) {
+                return status;
+            }
+            for (int32_t row = 0; row < chunkHeight; ++row) {
+                std::memcpy(pixels.data() + static_cast<size_t>(chunkY + row) * outWidth + chunkX,
+                            chunk.data() + static_cast<size_t>(row) * chunkWidth,
+                            static_cast<size_t>(chunkWidth) * sizeof(uint32_t));
+            }
+        }
+    }
+    return TileServiceStatus::Ok;
+}
+
+uint64_t TileService::CacheKey(int32_t level, int64_t column, int64_t row) {
+    return (static_cast<uint64_t>(level) << 56) | (static_cast<uint64_t>(column) << 28) |
+           static_cast<uint64_t>(row);
+}
+
+bool TileService::LookupEncoded(uint64_t key, uint64_t epoch, EncodedTile& out) {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (epoch != cacheEpoch_) {
+        return false;
+    }
+    auto it = encoded_.find(key);
+    if (it == encoded_.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    out = it->second.tile;
+    return true;
+}
+
+void TileService::StoreEncoded(uint64_t key, uint64_t epoch, const EncodedTile& tile) {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (epoch != cacheEpoch_ || tile.data->size() > capacity_ || encoded_.count(key)) {
+        return;  // Slide changed meanwhile, too large, or a concurrent request stored it
+    }
+    lru_.push_front(key);
+    encoded_.emplace(key, CachedTile{tile, lru_.begin()});
+    cachedBytes_ += tile.data->size();
+    while (cachedBytes_ > capacity_ && !lru_.empty()) {
+        auto it = encoded_.find(lru_.back());
+        cachedBytes_ -= it->second.tile.data->size();
+        encoded_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+size_t TileService::GetEncodedCacheBytes() const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cachedBytes_;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "PyramidLayout.h"
+#include "TileCache.h"  // For TileHandle
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The open slide as the tile service sees it: the render pipeline's
+// pyramid plus hooks into its tile cache and decode pool (see
+// SlideRenderer::GetCachedTile / RequestTile)
+struct TileServiceSlide {
+    std::string id;          // Slide id in URLs, see TileService::MakeSlideId
+    int64_t width = 0;       // Level 0
+    int64_t height = 0;
+    PyramidLayout pyramid;
+    std::function<TileHandle(const TileKey&)> getTile;  // Cached pixels or empty
+    std::function<void(const TileKey&)> requestTile;    // Queue a missing tile
+};
+
+enum class TileServiceStatus {
+    Ok,
+    NotFound,     // Unknown slide or tile outside the image
+    Unavailable   // The pipeline did not produce the tiles in time
+};
+
+// One encoded DeepZoom tile. Shared: cached tiles are handed to every
+// request without copying.
+struct EncodedTile {
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    std::string etag;       // Quoted, ready for the ETag header
+    const char* mimeType = "";
+};
+
+// DeepZoom tiles of the open slide for browser viewers (OpenSeadragon
+// and the like), cut from the viewer's own tile pipeline rather than a
+// second decoder.
+//
+// A DeepZoom tile is composed from the cached pipeline tiles of the
+// finest pyramid level no sharper than it; missing ones are queued on the
+// decode pool and waited for (OnTileReady wakes the wait). The result is
+// box-downsampled to the DeepZoom level, flattened onto white and encoded
+// as JPEG (PNG in builds without libjpeg). Encoded tiles are kept in an
+// LRU cache of ENCODED_CACHE_BYTES; ETags name the slide, tile and
+// encoding, so a browser can revalidate a tile without its bytes moving.
+//
+// Thread-safe: HTTP handler threads call GetDzi / GetTile concurrently
+// while the GUI thread swaps the slide.
+class TileService {
+public:
+    explicit TileService(size_t encodedCacheBytes = ENCODED_CACHE_BYTES);
+    ~TileService();
+
+    TileService(const TileService&) = delete;
+    TileService& operator=(const TileService&) = delete;
+
+    // Serve a new slide, or none. ClearSlide returns only once no request
+    // is calling into the old slide's hooks, so the pipeline behind them
+    // may be torn down right after.
+    void SetSlide(TileServiceSlide slide);
+    void ClearSlide();
+
+    // Wake requests waiting for pipeline tiles (call from the pipeline's
+    // tile-ready callback)
+    void OnTileReady();
+
+    // Stable id for a slide path (16 hex digits)
+    static std::string MakeSlideId(const std::string& path);
+
+    // Ids of the slides being served (at most one)
+    std::vector<std::string> GetSlideIds() const;
+
+    // DeepZoom descriptor (.dzi XML) of a slide
+    TileServiceStatus GetDzi(const std::string& id, std::string& xml) const;
+
+    // Tile column, row of a DeepZoom level (0 is 1x1 pixel, GetMaxLevel()
+    // is full resolution)
+    TileServiceStatus GetTile(const std::string& id, int32_t level, int64_t column, int64_t row,
+                              EncodedTile& out);
+
+    // IIIF Image API level 0 over the same tiles: info.json advertises the
+    // DeepZoom grid as TILE_SIZE tiles at power-of-two scale factors, and
+    // only those tiles are served. A region is x, y, width, height in
+    // level 0 pixels (width and height 0 for the full image); sizeWidth is
+    // the requested output width (0 for unscaled).
+    TileServiceStatus GetIiifInfo(const std::string& id, const std::string& baseUri, std::string& json) const;
+    TileServiceStatus GetIiifTile(const std::string& id, int64_t x, int64_t y, int64_t width, int64_t height,
+                                  int64_t sizeWidth, EncodedTile& out);
+
+    // Off-screen render of the current slide for region.render: outWidth x
+    // outHeight premultiplied ARGB pixels showing level 0 from (x, y) at
+    // any downsample, composed like a tile from the finest level no sharper.
+    // Large outputs are composed REGION_CHUNK_SIZE pixels at a time, so only
+    // one chunk's pipeline tiles are held at once; what lies outside the
+    // slide stays transparent.
+    TileServiceStatus RenderRegion(double x, double y, double downsample, int32_t outWidth, int32_t outHeight,
+                                   std::vector<uint32_t>& pixels);
+
+    // Extension of tile URLs ("jpg" or "png")
+    static const char* GetTileFormat();
+
+    // DeepZoom level holding the full-resolution image
+    static int32_t GetMaxLevel(int64_t width, int64_t height);
+
+    // Statistics
+    size_t GetEncodedCacheBytes() const;
+    size_t GetEncodedHitCount() const { return encodedHits_.load(); }
+    size_t GetEncodedMissCount() const { return encodedMisses_.load(); }
+    size_t GetTimeoutCount() const { return timeouts_.load(); }
+
+    static constexpr int32_t TILE_SIZE = 256;
+    static constexpr int32_t JPEG_QUALITY = 85;
+    static constexpr size_t ENCODED_CACHE_BYTES = 64 * 1024 * 1024;
+    // How long a request waits for the pipeline before answering 503
+    static constexpr int32_t TILE_WAIT_MS = 10000;
+    static constexpr int32_t REGION_CHUNK_SIZE = 1024;
+
+private:
+    struct CachedTile {
+        EncodedTile tile;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    // Compose the tile at downsample (a power of two) covering level 0
+    // [x0, x1) x [y0, y1) into an outWidth x outHeight image.
+    // Status Unavailable on timeout or if the slide changed meanwhile.
+    TileServiceStatus ComposeTile(const std::shared_ptr<const TileServiceSlide>& slide, double downsample,
+                                  int64_t x0, int64_t y0, int64_t x1, int64_t y1,
+                                  int32_t outWidth, int32_t outHeight, std::vector<uint32_t>& pixels);
+
+    // Encoded cache, keyed by level, column and row of the current slide
+    static uint64_t CacheKey(int32_t level, int64_t column, int64_t row);
+    bool LookupEncoded(uint64_t key, uint64_t epoch, EncodedTile& out);
+    void StoreEncoded(uint64_t key, uint64_t epoch, const EncodedTile& tile);
+
+    // Current slide. Hook calls hold sourceMutex_ shared; swapping the
+    // slide takes it exclusively.
+    mutable std::shared_mutex sourceMutex_;
+    std::shared_ptr<const TileServiceSlide> slide_;
+    uint64_t epoch_ = 0;  // Bumped with every slide change
+
+    std::mutex waitMutex_;
+    std::condition_variable tileReady_;
+
+    mutable std::mutex cacheMutex_;
+    std::unordered_map<uint64_t, CachedTile> encoded_;
+    std::list<uint64_t> lru_;  // Most recent first
+    uint64_t cacheEpoch_ = 0;
+    size_t cachedBytes_ = 0;
+    size_t capacity_;
+
+    std::atomic<size_t> encodedHits_{0};
+    std::atomic<size_t> encodedMisses_{0};
+    std::atomic<size_t> timeouts_{0};
+
+    static constexpr int32_t WAIT_SLICE_MS = 50;  // Resubmit interval while waiting
+};
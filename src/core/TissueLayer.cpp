@@ -0,0 +1,244 @@
+#include "TissueLayer.h"
+#include "Viewport.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Muted fills for tissue, so the cells stay readable on top
+const SDL_Color TISSUE_COLORS[] = {
+    {230, 159, 0, 255},    // Orange
+    {86, 180, 233, 255},   // Sky blue
+    {0, 158, 115, 255},    // Bluish green
+    {240, 228, 66, 255},   // Yellow
+    {0, 114, 178, 255},    // Blue
+    {213, 94, 0, 255},     // Vermillion
+    {204, 121, 167, 255},  // Reddish purple
+    {153, 153, 153, 255},  // Gray
+};
+
+constexpr size_t NUM_TISSUE_COLORS = sizeof(TISSUE_COLORS) / sizeof(TISSUE_COLORS[0]);
+
+// Premultiplied TILE_PIXEL_FORMAT (ARGB8888)
+uint32_t PackPremultiplied(SDL_Color color) {
+    const uint32_t a = color.a;
+    const uint32_t r = (color.r * a + 127) / 255;
+    const uint32_t g = (color.g * a + 127) / 255;
+    const uint32_t b = (color.b * a + 127) / 255;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+}  // namespace
+
+TissueLayer::TissueLayer(SDL_Renderer* renderer, size_t maxTextures)
+    : renderer_(renderer)
+    , maxTextures_(std::max<size_t>(1, maxTextures)) {
+    SetMap(nullptr);
+}
+
+TissueLayer::~TissueLayer() {
+    DropTextures();
+}
+
+SDL_Color TissueLayer::DefaultColor(int label) {
+    return TISSUE_COLORS[static_cast<size_t>(label) % NUM_TISSUE_COLORS];
+}
+
+void TissueLayer::SetMap(std::unique_ptr<TissueMap> map) {
+    DropTextures();
+    map_ = std::move(map);
+    pendingUploads_ = false;
+
+    visible_.fill(true);
+    for (int label = 0; label < 256; ++label) {
+        colors_[label] = DefaultColor(label);
+        palette_[label] = PackPremultiplied(colors_[label]);
+    }
+    if (map_) {
+        palette_[map_->GetEmptyLabel()] = 0;
+    }
+}
+
+std::vector<int> TissueLayer::GetClassIds() const {
+    std::vector<int> labels;
+    if (!map_) {
+        return labels;
+    }
+    for (const auto& pair : map_->GetClassNames()) {
+        if (pair.first >= 0 && pair.first <= 255 && pair.first != map_->GetEmptyLabel()) {
+            labels.push_back(pair.first);
+        }
+    }
+    return labels;
+}
+
+std::string TissueLayer::GetClassName(int label) const {
+    if (map_) {
+        auto it = map_->GetClassNames().find(label);
+        if (it != map_->GetClassNames().end()) {
+            return it->second;
+        }
+    }
+    return "Tissue " + std::to_string(label);
+}
+
+SDL_Color TissueLayer::GetClassColor(int label) const {
+    return label >= 0 && label <= 255 ? colors_[label] : SDL_Color{128, 128, 128, 255};
+}
+
+void TissueLayer::SetClassColor(int label, SDL_Color color) {
+    if (label < 0 || label > 255) {
+        return;
+    }
+    colors_[label] = color;
+    const bool drawn = visible_[label] && (!map_ || label != map_->GetEmptyLabel());
+    const uint32_t packed = drawn ? PackPremultiplied(color) : 0;
+    if (packed != palette_[label]) {
+        palette_[label] = packed;
+        DropTextures();
+    }
+}
+
+void TissueLayer::SetClassVisible(int label, bool visible) {
+    if (label < 0 || label > 255 || visible_[label] == visible) {
+        return;
+    }
+    visible_[label] = visible;
+    SetClassColor(label, colors_[label]);
+}
+
+void TissueLayer::DropTextures() {
+    for (auto& pair : textures_) {
+        SDL_DestroyTexture(pair.second.texture);
+    }
+    textures_.clear();
+    lru_.clear();
+}
+
+void TissueLayer::Touch(Resident& resident, const TileKey& key) {
+    lru_.erase(resident.lruPosition);
+    lru_.push_front(key);
+    resident.lruPosition = lru_.begin();
+}
+
+SDL_Texture* TissueLayer::Upload(const TileKey& key) {
+    const uint8_t* labels = map_->GetTile(key.level, key.tileX, key.tileY);
+    if (!labels) {
+        return nullptr;
+    }
+
+    // Make room: the least recently drawn go first
+    while (textures_.size() >= maxTextures_ && !lru_.empty()) {
+        auto it = textures_.find(lru_.back());
+        SDL_DestroyTexture(it->second.texture);
+        textures_.erase(it);
+        lru_.pop_back();
+    }
+
+    pixels_.resize(TissueMap::TILE_LABELS);
+    for (size_t i = 0; i < TissueMap::TILE_LABELS; ++i) {
+        pixels_[i] = palette_[labels[i]];
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer_, TextureManager::TILE_PIXEL_FORMAT,
+                                             SDL_TEXTUREACCESS_STATIC, TissueMap::TILE_SIZE, TissueMap::TILE_SIZE);
+    if (!texture) {
+        PATHVIEW_LOG_ERROR("Failed to create tissue tile texture: " << SDL_GetError());
+        return nullptr;
+    }
+    const int pitch = TissueMap::TILE_SIZE * static_cast<int>(sizeof(uint32_t));
+    if (SDL_UpdateTexture(texture, nullptr, pixels_.data(), pitch) != 0) {
+        PATHVIEW_LOG_ERROR("Failed to upload tissue tile: " << SDL_GetError());
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    TextureManager::ApplyPremultipliedBlendMode(texture);
+    // Labels are classes: blend nothing between them
+    SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+
+    lru_.push_front(key);
+    textures_.emplace(key, Resident{texture, lru_.begin()});
+    return texture;
+}
+
+SDL_Texture* TissueLayer::Acquire(const TileKey& key, bool upload) {
+    auto it = textures_.find(key);
+    if (it != textures_.end()) {
+        Touch(it->second, key);
+        return it->second.texture;
+    }
+    if (!upload) {
+        return nullptr;
+    }
+    if (uploadsThisFrame_ >= MAX_UPLOADS_PER_FRAME) {
+        pendingUploads_ = true;
+        return nullptr;
+    }
+    ++uploadsThisFrame_;
+    return Upload(key);
+}
+
+void TissueLayer::Render(const Viewport& viewport, float opacity) {
+    uploadsThisFrame_ = 0;
+    pendingUploads_ = false;
+    if (!map_ || map_->Empty()) {
+        return;
+    }
+
+    const int32_t level = map_->ChooseLevel(viewport.GetZoom());
+    const Rect visible = viewport.GetVisibleRegion();
+    map_->GetTilesInRegion(level, visible, visibleTiles_);
+
+    // Nearest the view center first, so a budget-limited frame fills the middle
+    const double span = map_->GetTexelSize(level) * TissueMap::TILE_SIZE;
+    const double centerX = (visible.x + visible.width * 0.5) / span - 0.5;
+    const double centerY = (visible.y + visible.height * 0.5) / span - 0.5;
+    std::sort(visibleTiles_.begin(), visibleTiles_.end(),
+              [centerX, centerY](const TissueMap::TileCoord& a, const TissueMap::TileCoord& b) {
+                  const double da = (a.x - centerX) * (a.x - centerX) + (a.y - centerY) * (a.y - centerY);
+                  const double db = (b.x - centerX) * (b.x - centerX) + (b.y - centerY) * (b.y - centerY);
+                  return da < db;
+              });
+
+    const Uint8 alpha = static_cast<Uint8>(std::max(0.0f, std::min(1.0f, opacity)) * 255);
+    auto draw = [&](SDL_Texture* texture, const SDL_Rect* part, const TissueMap::TileCoord& tile) {
+        const Rect bounds = map_->GetTileBounds(level, tile.x, tile.y);
+        const Vec2 topLeft = viewport.SlideToScreen(Vec2(bounds.Left(), bounds.Top()));
+        const Vec2 bottomRight = viewport.SlideToScreen(Vec2(bounds.Right(), bounds.Bottom()));
+        const SDL_FRect destination = {
+            static_cast<float>(topLeft.x), static_cast<float>(topLeft.y),
+            static_cast<float>(bottomRight.x - topLeft.x), static_cast<float>(bottomRight.y - topLeft.y)
+        };
+        // Premultiplied pixels: opacity scales color and alpha alike
+        SDL_SetTextureColorMod(texture, alpha, alpha, alpha);
+        SDL_SetTextureAlphaMod(texture, alpha);
+        SDL_RenderCopyF(renderer_, texture, part, &destination);
+    };
+
+    for (const TissueMap::TileCoord& tile : visibleTiles_) {
+        if (SDL_Texture* texture = Acquire({level, tile.x, tile.y}, true)) {
+            draw(texture, nullptr, tile);
+            continue;
+        }
+
+        // Not uploaded yet: stretch the part of a resident coarser tile
+        for (int32_t up = 1; up <= MAX_FALLBACK_LEVELS && level + up < map_->GetLevelCount(); ++up) {
+            const TileKey parent = {level + up, tile.x >> up, tile.y >> up};
+            SDL_Texture* texture = Acquire(parent, false);
+            if (texture) {
+                const int32_t partSpan = TissueMap::TILE_SIZE >> up;
+                const int32_t mask = (1 << up) - 1;
+                const SDL_Rect part = {(tile.x & mask) * partSpan, (tile.y & mask) * partSpan, partSpan, partSpan};
+                draw(texture, &part, tile);
+                break;
+            }
+        }
+    }
+}
+
+size_t TissueLayer::GetMemoryUsage() const {
+    const size_t textureBytes = TissueMap::TILE_LABELS * sizeof(uint32_t);
+    return (map_ ? map_->GetMemoryUsage() : 0) + textures_.size() * textureBytes +
+           pixels_.capacity() * sizeof(uint32_t);
+}
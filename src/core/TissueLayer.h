@@ -0,0 +1,91 @@
+#pragma once
+
+#include "TextureManager.h"  // For TileKey
+#include "TissueMap.h"
+#include <SDL2/SDL.h>
+#include <array>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Viewport;
+
+// Draws a TissueMap under the cells: the label tiles in view at the level
+// that matches the zoom, colored through a 256-entry palette.
+//
+// The CPU side keeps one byte per label. SDL_Renderer has no palettized
+// textures, so the palette lookup happens as a tile is uploaded; only the
+// tiles drawn recently are resident, at most maxTextures of them. A palette
+// change drops them all and the tiles in view are uploaded again. Opacity
+// is applied when compositing.
+class TissueLayer {
+public:
+    explicit TissueLayer(SDL_Renderer* renderer, size_t maxTextures = DEFAULT_MAX_TEXTURES);
+    ~TissueLayer();
+
+    TissueLayer(const TissueLayer&) = delete;
+    TissueLayer& operator=(const TissueLayer&) = delete;
+
+    // Take a map to draw (null clears it); labels get default colors
+    void SetMap(std::unique_ptr<TissueMap> map);
+    const TissueMap* GetMap() const { return map_.get(); }
+    bool HasMap() const { return map_ != nullptr; }
+
+    // Tissue classes: the map's labels other than the empty one, with
+    // their names and colors
+    std::vector<int> GetClassIds() const;
+    std::string GetClassName(int label) const;
+    SDL_Color GetClassColor(int label) const;
+    void SetClassColor(int label, SDL_Color color);
+    void SetClassVisible(int label, bool visible);
+    bool IsClassVisible(int label) const { return label < 0 || label > 255 || visible_[label]; }
+
+    // Upload the visible tiles missing (within the upload budget) and draw
+    // them; a tile not uploaded yet shows a coarser one if resident
+    void Render(const Viewport& viewport, float opacity);
+
+    // Visible tiles are waiting for upload budget: another frame is needed
+    bool HasPendingUploads() const { return pendingUploads_; }
+
+    // Labels plus resident textures
+    size_t GetMemoryUsage() const;
+
+    static constexpr size_t DEFAULT_MAX_TEXTURES = 256;  // 64 MB of RGBA tiles
+    static constexpr int MAX_UPLOADS_PER_FRAME = 8;
+    static constexpr int32_t MAX_FALLBACK_LEVELS = 3;
+
+private:
+    struct Resident {
+        SDL_Texture* texture;
+        std::list<TileKey>::iterator lruPosition;
+    };
+
+    // Default color of a label: a fixed palette, by label
+    static SDL_Color DefaultColor(int label);
+
+    // The texture of a tile, uploading it if the budget allows; null if
+    // the tile is not resident (yet)
+    SDL_Texture* Acquire(const TileKey& key, bool upload);
+    SDL_Texture* Upload(const TileKey& key);
+    void Touch(Resident& resident, const TileKey& key);
+    void DropTextures();
+
+    SDL_Renderer* renderer_;
+    size_t maxTextures_;
+    std::unique_ptr<TissueMap> map_;
+
+    // Per label: premultiplied TILE_PIXEL_FORMAT color (0 when hidden),
+    // and the chosen color and visibility behind it
+    std::array<uint32_t, 256> palette_;
+    std::array<SDL_Color, 256> colors_;
+    std::array<bool, 256> visible_;
+
+    std::unordered_map<TileKey, Resident, TileKeyHash> textures_;
+    std::list<TileKey> lru_;  // Most recently drawn first
+    std::vector<uint32_t> pixels_;  // Reused upload buffer
+    std::vector<TissueMap::TileCoord> visibleTiles_;
+    int uploadsThisFrame_ = 0;
+    bool pendingUploads_ = false;
+};
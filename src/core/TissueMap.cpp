@@ -0,0 +1,319 @@
+#include "TissueMap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void AppendBytes(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+// Bounds-checked reader over a serialized map
+struct Reader {
+    const uint8_t* data;
+    uint64_t bytes;
+    uint64_t pos = 0;
+
+    template <typename T>
+    bool Read(T& value) {
+        if (bytes - pos < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    const uint8_t* Take(uint64_t count) {
+        if (bytes - pos < count) {
+            return nullptr;
+        }
+        const uint8_t* p = data + pos;
+        pos += count;
+        return p;
+    }
+};
+
+int32_t FloorDiv(int32_t value, int32_t divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+}  // namespace
+
+TissueMap::TissueMap(double texelSize, uint8_t emptyLabel)
+    : texelSize_(texelSize > 0.0 ? texelSize : 1.0)
+    , emptyLabel_(emptyLabel)
+    , levels_(1) {
+}
+
+void TissueMap::AddRegion(const Rect& slideBounds, int32_t width, int32_t height, const uint8_t* labels) {
+    if (width <= 0 || height <= 0 || slideBounds.width <= 0.0 || slideBounds.height <= 0.0) {
+        return;
+    }
+    if (levels_.size() > 1) {
+        levels_.resize(1);  // Coarser levels are stale; BuildLevels() again
+    }
+    Level& level = levels_[0];
+
+    // Every level-0 texel whose center lies in the region takes the label
+    // of the source texel under that center
+    const int32_t firstX = static_cast<int32_t>(std::floor(slideBounds.Left() / texelSize_));
+    const int32_t lastX = static_cast<int32_t>(std::ceil(slideBounds.Right() / texelSize_));
+    const int32_t firstY = static_cast<int32_t>(std::floor(slideBounds.Top() / texelSize_));
+    const int32_t lastY = static_cast<int32_t>(std::ceil(slideBounds.Bottom() / texelSize_));
+    const double scaleX = width / slideBounds.width;
+    const double scaleY = height / slideBounds.height;
+
+    std::vector<uint8_t>* tile = nullptr;
+    uint64_t tileKey = 0;
+    for (int32_t ty = firstY; ty < lastY; ++ty) {
+        const double sy = ((ty + 0.5) * texelSize_ - slideBounds.Top()) * scaleY;
+        if (sy < 0.0 || sy >= height) {
+            continue;
+        }
+        const uint8_t* row = labels + size_t(sy) * size_t(width);
+        const int32_t tileY = FloorDiv(ty, TILE_SIZE);
+        const size_t rowStart = size_t(ty - tileY * TILE_SIZE) * TILE_SIZE;
+
+        for (int32_t tx = firstX; tx < lastX; ++tx) {
+            const double sx = ((tx + 0.5) * texelSize_ - slideBounds.Left()) * scaleX;
+            if (sx < 0.0 || sx >= width) {
+                continue;
+            }
+            const uint8_t label = row[size_t(sx)];
+            const int32_t tileX = FloorDiv(tx, TILE_SIZE);
+            const uint64_t key = Key(tileX, tileY);
+            if (!tile || key != tileKey) {
+                auto it = level.find(key);
+                if (it == level.end()) {
+                    if (label == emptyLabel_) {
+                        continue;  // Not worth a tile yet
+                    }
+                    it = level.emplace(key, std::vector<uint8_t>(TILE_LABELS, emptyLabel_)).first;
+                }
+                tile = &it->second;
+                tileKey = key;
+            }
+            (*tile)[rowStart + size_t(tx - tileX * TILE_SIZE)] = label;
+        }
+    }
+}
+
+uint8_t TissueMap::Majority(uint8_t a, uint8_t b, uint8_t c, uint8_t d) const {
+    // Most frequent of four; ties go to tissue over empty, then to the first
+    const uint8_t labels[4] = {a, b, c, d};
+    uint8_t best = emptyLabel_;
+    int bestCount = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (labels[i] == emptyLabel_) {
+            continue;
+        }
+        int count = 0;
+        for (int j = 0; j < 4; ++j) {
+            count += labels[j] == labels[i];
+        }
+        if (count > bestCount) {
+            best = labels[i];
+            bestCount = count;
+        }
+    }
+    const int emptyCount = (a == emptyLabel_) + (b == emptyLabel_) + (c == emptyLabel_) + (d == emptyLabel_);
+    return emptyCount > bestCount ? emptyLabel_ : best;
+}
+
+void TissueMap::BuildLevels() {
+    levels_.resize(1);
+
+    auto dropEmpty = [this](Level& level) {
+        for (auto it = level.begin(); it != level.end();) {
+            const std::vector<uint8_t>& labels = it->second;
+            const bool empty =
+                std::all_of(labels.begin(), labels.end(), [this](uint8_t l) { return l == emptyLabel_; });
+            it = empty ? level.erase(it) : std::next(it);
+        }
+    };
+    // Regions may have overwritten tissue with empty labels
+    dropEmpty(levels_[0]);
+
+    // Until the tissue fits one tile
+    constexpr int32_t HALF = TILE_SIZE / 2;
+    while (levels_.back().size() > 1 && levels_.size() < 32) {
+        Level coarser;
+        for (const auto& pair : levels_.back()) {
+            const int32_t x = int32_t(uint32_t(pair.first)), y = int32_t(uint32_t(pair.first >> 32));
+            const int32_t parentX = FloorDiv(x, 2), parentY = FloorDiv(y, 2);
+            auto it = coarser.find(Key(parentX, parentY));
+            if (it == coarser.end()) {
+                it = coarser.emplace(Key(parentX, parentY), std::vector<uint8_t>(TILE_LABELS, emptyLabel_)).first;
+            }
+
+            // This child fills one quadrant of its parent
+            const std::vector<uint8_t>& child = pair.second;
+            std::vector<uint8_t>& parent = it->second;
+            const size_t offsetX = size_t(x - parentX * 2) * HALF;
+            const size_t offsetY = size_t(y - parentY * 2) * HALF;
+            for (int32_t py = 0; py < HALF; ++py) {
+                const uint8_t* top = &child[size_t(py * 2) * TILE_SIZE];
+                const uint8_t* bottom = top + TILE_SIZE;
+                uint8_t* out = &parent[(offsetY + py) * TILE_SIZE + offsetX];
+                for (int32_t px = 0; px < HALF; ++px) {
+                    out[px] = Majority(top[px * 2], top[px * 2 + 1], bottom[px * 2], bottom[px * 2 + 1]);
+                }
+            }
+        }
+        dropEmpty(coarser);
+        levels_.push_back(std::move(coarser));
+    }
+}
+
+size_t TissueMap::GetTileCount() const {
+    size_t count = 0;
+    for (const Level& level : levels_) {
+        count += level.size();
+    }
+    return count;
+}
+
+int32_t TissueMap::ChooseLevel(double zoom) const {
+    int32_t level = 0;
+    while (level + 1 < GetLevelCount() && GetTexelSize(level + 1) * zoom <= 1.0) {
+        ++level;
+    }
+    return level;
+}
+
+const uint8_t* TissueMap::GetTile(int32_t level, int32_t x, int32_t y) const {
+    if (level < 0 || level >= GetLevelCount()) {
+        return nullptr;
+    }
+    auto it = levels_[level].find(Key(x, y));
+    return it != levels_[level].end() ? it->second.data() : nullptr;
+}
+
+void TissueMap::GetTilesInRegion(int32_t level, const Rect& region, std::vector<TileCoord>& out) const {
+    out.clear();
+    if (level < 0 || level >= GetLevelCount() || levels_[level].empty()) {
+        return;
+    }
+    const double tileSpan = GetTexelSize(level) * TILE_SIZE;
+    const int32_t firstX = static_cast<int32_t>(std::floor(region.Left() / tileSpan));
+    const int32_t lastX = static_cast<int32_t>(std::floor(region.Right() / tileSpan));
+    const int32_t firstY = static_cast<int32_t>(std::floor(region.Top() / tileSpan));
+    const int32_t lastY = static_cast<int32_t>(std::floor(region.Bottom() / tileSpan));
+
+    // Walk the kept tiles instead when the region covers many more slots
+    const Level& tiles = levels_[level];
+    if (double(lastX - firstX + 1) * double(lastY - firstY + 1) > double(tiles.size())) {
+        for (const auto& pair : tiles) {
+            const int32_t x = int32_t(uint32_t(pair.first)), y = int32_t(uint32_t(pair.first >> 32));
+            if (x >= firstX && x <= lastX && y >= firstY && y <= lastY) {
+                out.push_back({x, y});
+            }
+        }
+        return;
+    }
+    for (int32_t y = firstY; y <= lastY; ++y) {
+        for (int32_t x = firstX; x <= lastX; ++x) {
+            if (tiles.count(Key(x, y))) {
+                out.push_back({x, y});
+            }
+        }
+    }
+}
+
+Rect TissueMap::GetTileBounds(int32_t level, int32_t x, int32_t y) const {
+    const double tileSpan = GetTexelSize(level) * TILE_SIZE;
+    return Rect(x * tileSpan, y * tileSpan, tileSpan, tileSpan);
+}
+
+uint8_t TissueMap::GetLabel(double slideX, double slideY) const {
+    const int32_t tx = static_cast<int32_t>(std::floor(slideX / texelSize_));
+    const int32_t ty = static_cast<int32_t>(std::floor(slideY / texelSize_));
+    const int32_t tileX = FloorDiv(tx, TILE_SIZE), tileY = FloorDiv(ty, TILE_SIZE);
+    const uint8_t* tile = GetTile(0, tileX, tileY);
+    if (!tile) {
+        return emptyLabel_;
+    }
+    return tile[size_t(ty - tileY * TILE_SIZE) * TILE_SIZE + size_t(tx - tileX * TILE_SIZE)];
+}
+
+size_t TissueMap::GetMemoryUsage() const {
+    return GetTileCount() * (TILE_LABELS + sizeof(uint64_t) + sizeof(std::vector<uint8_t>));
+}
+
+std::vector<uint8_t> TissueMap::Serialize() const {
+    // double texel size, uint8 empty label, uint32 class count, per class
+    // (int32 label, uint32 name length, name), uint32 level count, per
+    // level (uint32 tile count, per tile (int32 x, int32 y, labels))
+    std::vector<uint8_t> out;
+    out.reserve(64 + GetTileCount() * (TILE_LABELS + 8));
+    AppendBytes(out, texelSize_);
+    out.push_back(emptyLabel_);
+    AppendBytes(out, static_cast<uint32_t>(classNames_.size()));
+    for (const auto& pair : classNames_) {
+        AppendBytes(out, static_cast<int32_t>(pair.first));
+        AppendBytes(out, static_cast<uint32_t>(pair.second.size()));
+        out.insert(out.end(), pair.second.begin(), pair.second.end());
+    }
+    AppendBytes(out, static_cast<uint32_t>(levels_.size()));
+    for (const Level& level : levels_) {
+        AppendBytes(out, static_cast<uint32_t>(level.size()));
+        for (const auto& pair : level) {
+            AppendBytes(out, int32_t(uint32_t(pair.first)));
+            AppendBytes(out, int32_t(uint32_t(pair.first >> 32)));
+            out.insert(out.end(), pair.second.begin(), pair.second.end());
+        }
+    }
+    return out;
+}
+
+std::unique_ptr<TissueMap> TissueMap::Deserialize(const uint8_t* data, uint64_t bytes) {
+    Reader in{data, bytes};
+    double texelSize;
+    uint8_t emptyLabel;
+    uint32_t classCount;
+    if (!in.Read(texelSize) || !in.Read(emptyLabel) || !in.Read(classCount) || !(texelSize > 0.0)) {
+        return nullptr;
+    }
+
+    auto map = std::make_unique<TissueMap>(texelSize, emptyLabel);
+    for (uint32_t c = 0; c < classCount; ++c) {
+        int32_t label;
+        uint32_t nameLength;
+        if (!in.Read(label) || !in.Read(nameLength)) {
+            return nullptr;
+        }
+        const uint8_t* name = in.Take(nameLength);
+        if (!name) {
+            return nullptr;
+        }
+        map->classNames_[label] = std::string(reinterpret_cast<const char*>(name), nameLength);
+    }
+
+    uint32_t levelCount;
+    if (!in.Read(levelCount) || levelCount == 0 || levelCount > 32) {
+        return nullptr;
+    }
+    map->levels_.resize(levelCount);
+    for (Level& level : map->levels_) {
+        uint32_t tileCount;
+        if (!in.Read(tileCount)) {
+            return nullptr;
+        }
+        for (uint32_t t = 0; t < tileCount; ++t) {
+            int32_t x, y;
+            if (!in.Read(x) || !in.Read(y)) {
+                return nullptr;
+            }
+            const uint8_t* labels = in.Take(TILE_LABELS);
+            if (!labels) {
+                return nullptr;
+            }
+            level.emplace(Key(x, y), std::vector<uint8_t>(labels, labels + TILE_LABELS));
+        }
+    }
+    return in.pos == bytes ? std::move(map) : nullptr;
+}
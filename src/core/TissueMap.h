@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Viewport.h"  // For Rect
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tissue class labels of a slide (one byte per texel) as a sparse tile
+// pyramid, from the per-tile segmentation maps of a polygon file.
+//
+// Level 0 is a grid of TILE_SIZE x TILE_SIZE label tiles anchored at the
+// slide origin, texelSize slide pixels (level 0) per label; every further
+// level halves the resolution, each label the majority of the 2x2 below
+// it, until the slide fits one tile. Tiles holding only the empty label
+// are not kept. Labels are turned into colors at draw time (TissueLayer).
+class TissueMap {
+public:
+    static constexpr int32_t TILE_SIZE = 256;
+    static constexpr size_t TILE_LABELS = size_t(TILE_SIZE) * TILE_SIZE;
+
+    struct TileCoord {
+        int32_t x;
+        int32_t y;
+    };
+
+    /**
+     * @param texelSize Slide pixels per label at level 0
+     * @param emptyLabel Label of no tissue (transparent, never stored alone)
+     */
+    TissueMap(double texelSize, uint8_t emptyLabel);
+
+    /**
+     * Sample a segmentation map onto level 0 (nearest label)
+     * @param slideBounds Slide area the map covers
+     * @param width, height Labels per row and rows
+     * @param labels Row-major, width * height
+     */
+    void AddRegion(const Rect& slideBounds, int32_t width, int32_t height, const uint8_t* labels);
+
+    // Build the coarser levels once every region is in
+    void BuildLevels();
+
+    void SetClassNames(std::map<int, std::string> classNames) { classNames_ = std::move(classNames); }
+    const std::map<int, std::string>& GetClassNames() const { return classNames_; }
+
+    double GetTexelSize(int32_t level = 0) const { return texelSize_ * double(int64_t(1) << level); }
+    uint8_t GetEmptyLabel() const { return emptyLabel_; }
+    int32_t GetLevelCount() const { return static_cast<int32_t>(levels_.size()); }
+    size_t GetTileCount() const;
+    bool Empty() const { return GetTileCount() == 0; }
+
+    // Coarsest level whose labels are still no larger than a screen pixel
+    // at this zoom (screen pixels per slide pixel)
+    int32_t ChooseLevel(double zoom) const;
+
+    // Labels of a tile (TILE_LABELS, row-major), or null if it is all empty
+    const uint8_t* GetTile(int32_t level, int32_t x, int32_t y) const;
+
+    // Kept tiles of a level overlapping a slide region
+    void GetTilesInRegion(int32_t level, const Rect& region, std::vector<TileCoord>& out) const;
+
+    // Slide area of a tile
+    Rect GetTileBounds(int32_t level, int32_t x, int32_t y) const;
+
+    // Label at a slide point (level 0), emptyLabel outside every region
+    uint8_t GetLabel(double slideX, double slideY) const;
+
+    size_t GetMemoryUsage() const;
+
+    // Flat copy for the polygon cache, and back (null if malformed)
+    std::vector<uint8_t> Serialize() const;
+    static std::unique_ptr<TissueMap> Deserialize(const uint8_t* data, uint64_t bytes);
+
+private:
+    using Level = std::unordered_map<uint64_t, std::vector<uint8_t>>;
+
+    static uint64_t Key(int32_t x, int32_t y) {
+        return (uint64_t(uint32_t(y)) << 32) | uint32_t(x);
+    }
+    uint8_t Majority(uint8_t a, uint8_t b, uint8_t c, uint8_t d) const;
+
+    double texelSize_;
+    uint8_t emptyLabel_;
+    std::vector<Level> levels_;
+    std::map<int, std::string> classNames_;  // Label -> tissue class
+};
@@ -0,0 +1,209 @@
+#include "TissueMask.h"
+#include "TissueMap.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Unpremultiplied channels of a premultiplied ARGB8888 pixel
+void Unpremultiply(uint32_t pixel, uint32_t& r, uint32_t& g, uint32_t& b) {
+    const uint32_t a = pixel >> 24;
+    r = (pixel >> 16) & 0xFF;
+    g = (pixel >> 8) & 0xFF;
+    b = pixel & 0xFF;
+    if (a > 0 && a < 255) {
+        r = std::min<uint32_t>(255, (r * 255 + a / 2) / a);
+        g = std::min<uint32_t>(255, (g * 255 + a / 2) / a);
+        b = std::min<uint32_t>(255, (b * 255 + a / 2) / a);
+    }
+}
+
+}  // namespace
+
+int TissueMask::OtsuThreshold(const std::array<uint64_t, 256>& histogram) {
+    double total = 0.0;
+    double sum = 0.0;
+    for (int value = 0; value < 256; ++value) {
+        total += double(histogram[value]);
+        sum += double(value) * double(histogram[value]);
+    }
+
+    int best = 0;
+    double bestVariance = -1.0;
+    double below = 0.0;
+    double belowSum = 0.0;
+    for (int threshold = 1; threshold < 256; ++threshold) {
+        below += double(histogram[threshold - 1]);
+        belowSum += double(threshold - 1) * double(histogram[threshold - 1]);
+        const double above = total - below;
+        if (below == 0.0 || above == 0.0) {
+            continue;
+        }
+        const double meanDifference = belowSum / below - (sum - belowSum) / above;
+        const double variance = below * above * meanDifference * meanDifference;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            best = threshold;
+        }
+    }
+    return best;
+}
+
+TissueMask TissueMask::FromOverview(const std::vector<uint32_t>& pixels, int64_t width, int64_t height,
+                                    double slideWidth, double slideHeight) {
+    TissueMask mask;
+    if (width <= 0 || height <= 0 || pixels.size() < size_t(width * height) ||
+        slideWidth <= 0.0 || slideHeight <= 0.0) {
+        return mask;
+    }
+
+    // Darkness of the darkest channel: 255 - min(r, g, b). Pale eosin is
+    // bright but far from gray, so it scores above the glass as well.
+    // Transparent pixels (no slide data) take no part and stay tissue, so
+    // their tiles are still decoded as they are.
+    const size_t count = size_t(width * height);
+    std::vector<int16_t> darkness(count, -1);
+    std::array<uint64_t, 256> histogram{};
+    for (size_t i = 0; i < count; ++i) {
+        if ((pixels[i] >> 24) == 0) {
+            continue;
+        }
+        uint32_t r, g, b;
+        Unpremultiply(pixels[i], r, g, b);
+        darkness[i] = static_cast<int16_t>(255 - std::min({r, g, b}));
+        ++histogram[darkness[i]];
+    }
+
+    const int threshold = OtsuThreshold(histogram);
+    double glass = 0.0, glassSum = 0.0, stain = 0.0, stainSum = 0.0;
+    for (int value = 0; value < 256; ++value) {
+        (value < threshold ? glass : stain) += double(histogram[value]);
+        (value < threshold ? glassSum : stainSum) += double(value) * double(histogram[value]);
+    }
+    if (glass == 0.0 || stain == 0.0 || stainSum / stain - glassSum / glass < MIN_CLASS_SEPARATION) {
+        return mask;  // One class only: no telling glass from tissue
+    }
+
+    mask.columns_ = width;
+    mask.rows_ = height;
+    mask.cellWidth_ = slideWidth / double(width);
+    mask.cellHeight_ = slideHeight / double(height);
+    mask.tissue_.assign(count, 1);
+    uint64_t red = 0, green = 0, blue = 0, glassCells = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (darkness[i] < 0 || darkness[i] >= threshold) {
+            continue;
+        }
+        mask.tissue_[i] = 0;
+        uint32_t r, g, b;
+        Unpremultiply(pixels[i], r, g, b);
+        red += r;
+        green += g;
+        blue += b;
+        ++glassCells;
+    }
+    const uint32_t meanR = uint32_t(red / glassCells), meanG = uint32_t(green / glassCells);
+    const uint32_t meanB = uint32_t(blue / glassCells);
+    mask.backgroundColor_ = 0xFF000000u | (meanR << 16) | (meanG << 8) | meanB;
+    mask.Grow();
+    return mask;
+}
+
+void TissueMask::ApplyTissueMap(const TissueMap& map) {
+    if (!IsValid() || map.Empty()) {
+        return;
+    }
+
+    std::vector<TissueMap::TileCoord> tiles;
+    map.GetTilesInRegion(0, Rect(0, 0, columns_ * cellWidth_, rows_ * cellHeight_), tiles);
+    if (tiles.empty()) {
+        return;
+    }
+
+    // Cells the map's extent covers whole become background, then its
+    // labels mark the tissue back
+    int32_t minX = tiles[0].x, maxX = tiles[0].x, minY = tiles[0].y, maxY = tiles[0].y;
+    for (const TissueMap::TileCoord& tile : tiles) {
+        minX = std::min(minX, tile.x);
+        maxX = std::max(maxX, tile.x);
+        minY = std::min(minY, tile.y);
+        maxY = std::max(maxY, tile.y);
+    }
+    const double tileSpan = map.GetTexelSize() * TissueMap::TILE_SIZE;
+    const int64_t firstColumn = std::max<int64_t>(0, int64_t(std::ceil(minX * tileSpan / cellWidth_)));
+    const int64_t lastColumn = std::min<int64_t>(columns_, int64_t(std::floor((maxX + 1) * tileSpan / cellWidth_)));
+    const int64_t firstRow = std::max<int64_t>(0, int64_t(std::ceil(minY * tileSpan / cellHeight_)));
+    const int64_t lastRow = std::min<int64_t>(rows_, int64_t(std::floor((maxY + 1) * tileSpan / cellHeight_)));
+    for (int64_t row = firstRow; row < lastRow; ++row) {
+        std::fill(tissue_.begin() + row * columns_ + firstColumn, tissue_.begin() + row * columns_ + lastColumn, 0);
+    }
+
+    const double texel = map.GetTexelSize();
+    const uint8_t empty = map.GetEmptyLabel();
+    std::array<int64_t, TissueMap::TILE_SIZE> columnOf;
+    for (const TissueMap::TileCoord& tile : tiles) {
+        const uint8_t* labels = map.GetTile(0, tile.x, tile.y);
+        for (int32_t i = 0; i < TissueMap::TILE_SIZE; ++i) {
+            const double x = (double(tile.x) * TissueMap::TILE_SIZE + i + 0.5) * texel;
+            columnOf[i] = std::min<int64_t>(columns_ - 1, int64_t(x / cellWidth_));
+        }
+        for (int32_t j = 0; j < TissueMap::TILE_SIZE; ++j) {
+            const double y = (double(tile.y) * TissueMap::TILE_SIZE + j + 0.5) * texel;
+            const int64_t row = int64_t(y / cellHeight_);
+            if (row >= rows_) {
+                break;
+            }
+            const uint8_t* line = labels + size_t(j) * TissueMap::TILE_SIZE;
+            for (int32_t i = 0; i < TissueMap::TILE_SIZE; ++i) {
+                if (line[i] != empty) {
+                    tissue_[row * columns_ + columnOf[i]] = 1;
+                }
+            }
+        }
+    }
+    Grow();
+}
+
+void TissueMask::Grow() {
+    grown_.assign(tissue_.size(), 0);
+    for (int64_t row = 0; row < rows_; ++row) {
+        for (int64_t column = 0; column < columns_; ++column) {
+            if (!tissue_[row * columns_ + column]) {
+                continue;
+            }
+            for (int64_t y = std::max<int64_t>(0, row - 1); y <= std::min(rows_ - 1, row + 1); ++y) {
+                for (int64_t x = std::max<int64_t>(0, column - 1); x <= std::min(columns_ - 1, column + 1); ++x) {
+                    grown_[y * columns_ + x] = 1;
+                }
+            }
+        }
+    }
+}
+
+bool TissueMask::IsBackground(const Rect& region) const {
+    if (!IsValid() || region.width <= 0.0 || region.height <= 0.0) {
+        return false;
+    }
+    const int64_t firstColumn = std::max<int64_t>(0, int64_t(std::floor(region.x / cellWidth_)));
+    const int64_t lastColumn = std::min(columns_ - 1, int64_t(std::ceil((region.x + region.width) / cellWidth_)) - 1);
+    const int64_t firstRow = std::max<int64_t>(0, int64_t(std::floor(region.y / cellHeight_)));
+    const int64_t lastRow = std::min(rows_ - 1, int64_t(std::ceil((region.y + region.height) / cellHeight_)) - 1);
+    if (firstColumn > lastColumn || firstRow > lastRow) {
+        return false;  // Off the slide: nothing known
+    }
+    for (int64_t row = firstRow; row <= lastRow; ++row) {
+        const uint8_t* cells = grown_.data() + row * columns_;
+        if (std::any_of(cells + firstColumn, cells + lastColumn + 1, [](uint8_t cell) { return cell != 0; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double TissueMask::GetBackgroundFraction() const {
+    if (!IsValid()) {
+        return 0.0;
+    }
+    const size_t tissue = size_t(std::count(grown_.begin(), grown_.end(), uint8_t(1)));
+    return 1.0 - double(tissue) / double(grown_.size());
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Viewport.h"  // For Rect
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class TissueMap;
+
+// Coarse tissue/background grid over a slide, so the tile scheduler can
+// leave glass alone: a tile over background only is drawn in the glass
+// color instead of being decoded.
+//
+// The grid is the minimap overview, one cell per overview pixel, split by
+// an Otsu threshold on how dark each pixel's darkest channel is (glass is
+// bright and gray, stain is dark or saturated). A tissue segmentation map
+// overrides it over the area the map covers. Tissue cells are grown by one
+// cell on every side, so tissue too thin for the overview still gets its
+// tiles. Without a clear split (a slide of tissue only, or a blank one)
+// the mask is invalid and every tile counts as tissue.
+class TissueMask {
+public:
+    // Invalid: no background anywhere
+    TissueMask() = default;
+
+    /**
+     * Threshold an overview of the whole slide
+     * @param pixels Premultiplied ARGB8888, width * height (MinimapOverview)
+     * @param slideWidth, slideHeight Level-0 dimensions the overview covers
+     */
+    static TissueMask FromOverview(const std::vector<uint32_t>& pixels, int64_t width, int64_t height,
+                                   double slideWidth, double slideHeight);
+
+    // Let a segmentation map decide the cells within its extent (the
+    // bounding box of its tiles): cells with a non-empty label are tissue,
+    // the rest background. An invalid mask keeps ignoring it.
+    void ApplyTissueMap(const TissueMap& map);
+
+    bool IsValid() const { return columns_ > 0; }
+
+    // Whether a level-0 slide region holds no tissue cell (grown)
+    bool IsBackground(const Rect& region) const;
+
+    // Mean color of the background cells, opaque ARGB8888
+    uint32_t GetBackgroundColor() const { return backgroundColor_; }
+
+    // Share of the grid that is background (after growing the tissue)
+    double GetBackgroundFraction() const;
+
+    // Otsu's threshold: the value splitting the histogram into the two
+    // classes of largest between-class variance (below vs. at or above)
+    static int OtsuThreshold(const std::array<uint64_t, 256>& histogram);
+
+    // Least gap between the two class means of the darkness histogram for
+    // the split to count as glass vs. tissue
+    static constexpr double MIN_CLASS_SEPARATION = 24.0;
+
+private:
+    // Grow tissue_ by one cell into grown_
+    void Grow();
+
+    int64_t columns_ = 0;
+    int64_t rows_ = 0;
+    double cellWidth_ = 0.0;   // Slide pixels per cell
+    double cellHeight_ = 0.0;
+    std::vector<uint8_t> tissue_;  // Row-major, 1 = tissue
+    std::vector<uint8_t> grown_;
+    uint32_t backgroundColor_ = 0xFFFFFFFF;
+};
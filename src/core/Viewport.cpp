@@ -1,8 +1,16 @@
 #include "Viewport.h"
-#include <iostream>
+#include "Log.h"
 #include <cmath>
 #include <SDL_timer.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PATHVIEW_VIEWPORT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PATHVIEW_VIEWPORT_NEON 1
+#endif
+
 Viewport::Viewport(int windowWidth, int windowHeight, int64_t slideWidth, int64_t slideHeight)
     : windowWidth_(windowWidth)
     , windowHeight_(windowHeight)
@@ -98,6 +106,14 @@ void Viewport::CenterOn(Vec2 slidePoint, AnimationMode mode) {
     animation_.Start(position_, zoom_, targetPos, zoom_, mode, 300.0);
 }
 
+void Viewport::SetView(Vec2 slideCenter, double zoom) {
+    animation_.Cancel();
+    zoom_ = std::clamp(zoom, minZoom_, maxZoom_);
+    position_ = Vec2(slideCenter.x - windowWidth_ / (2.0 * zoom_),
+                     slideCenter.y - windowHeight_ / (2.0 * zoom_));
+    ClampToBounds();
+}
+
 void Viewport::ResetView(AnimationMode mode) {
     // Calculate target position at minZoom_
     double viewportWidth = windowWidth_ / minZoom_;
@@ -123,20 +139,94 @@ void Viewport::ResetView(AnimationMode mode) {
     animation_.Start(position_, zoom_, targetPos, targetZoom, mode, 500.0);
 }
 
-Vec2 Viewport::ScreenToSlide(Vec2 screenPos) const {
-    // Screen coordinates → Slide coordinates
-    return Vec2(
-        screenPos.x / zoom_ + position_.x,
-        screenPos.y / zoom_ + position_.y
-    );
+void Viewport::TransformToScreen(const float* xs, const float* ys, size_t n, float* out) const {
+    const float scale = static_cast<float>(zoom_);
+    const float offsetX = static_cast<float>(-position_.x * zoom_);
+    const float offsetY = static_cast<float>(-position_.y * zoom_);
+    size_t i = 0;
+#if defined(PATHVIEW_VIEWPORT_SSE2)
+    const __m128 scales = _mm_set1_ps(scale);
+    const __m128 offsetsX = _mm_set1_ps(offsetX);
+    const __m128 offsetsY = _mm_set1_ps(offsetY);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(xs + i), scales), offsetsX);
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ys + i), scales), offsetsY);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(x, y));
+    }
+#elif defined(PATHVIEW_VIEWPORT_NEON)
+    const float32x4_t offsetsX = vdupq_n_f32(offsetX);
+    const float32x4_t offsetsY = vdupq_n_f32(offsetY);
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t xy;
+        xy.val[0] = vfmaq_n_f32(offsetsX, vld1q_f32(xs + i), scale);
+        xy.val[1] = vfmaq_n_f32(offsetsY, vld1q_f32(ys + i), scale);
+        vst2q_f32(out + 2 * i, xy);
+    }
+#endif
+    for (; i < n; ++i) {
+        out[2 * i] = xs[i] * scale + offsetX;
+        out[2 * i + 1] = ys[i] * scale + offsetY;
+    }
 }
 
-Vec2 Viewport::SlideToScreen(Vec2 slidePos) const {
-    // Slide coordinates → Screen coordinates
-    return Vec2(
-        (slidePos.x - position_.x) * zoom_,
-        (slidePos.y - position_.y) * zoom_
-    );
+void Viewport::TransformToScreen(const float* xy, size_t n, float* out,
+                                 double originX, double originY) const {
+    // One multiply-add per coordinate; the offset is worked out in double
+    const float scale = static_cast<float>(zoom_);
+    const float offsetX = static_cast<float>((originX - position_.x) * zoom_);
+    const float offsetY = static_cast<float>((originY - position_.y) * zoom_);
+    const size_t count = 2 * n;
+    size_t i = 0;
+#if defined(PATHVIEW_VIEWPORT_SSE2)
+    const __m128 scales = _mm_set1_ps(scale);
+    const __m128 offsets = _mm_setr_ps(offsetX, offsetY, offsetX, offsetY);
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(xy + i), scales), offsets);
+        __m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(xy + i + 4), scales), offsets);
+        _mm_storeu_ps(out + i, a);
+        _mm_storeu_ps(out + i + 4, b);
+    }
+#elif defined(PATHVIEW_VIEWPORT_NEON)
+    const float offsetPair[4] = {offsetX, offsetY, offsetX, offsetY};
+    const float32x4_t offsets = vld1q_f32(offsetPair);
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vfmaq_n_f32(offsets, vld1q_f32(xy + i), scale);
+        float32x4_t b = vfmaq_n_f32(offsets, vld1q_f32(xy + i + 4), scale);
+        vst1q_f32(out + i, a);
+        vst1q_f32(out + i + 4, b);
+    }
+#endif
+    for (; i < count; i += 2) {
+        out[i] = xy[i] * scale + offsetX;
+        out[i + 1] = xy[i + 1] * scale + offsetY;
+    }
+}
+
+void Viewport::TransformToScreen(const Vec2* points, size_t n, float* out) const {
+    // Subtract in double so large slide coordinates keep their precision
+    size_t i = 0;
+#if defined(PATHVIEW_VIEWPORT_SSE2)
+    const __m128d position = _mm_set_pd(position_.y, position_.x);
+    const __m128d zoom = _mm_set1_pd(zoom_);
+    for (; i + 2 <= n; i += 2) {
+        __m128d a = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(&points[i].x), position), zoom);
+        __m128d b = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(&points[i + 1].x), position), zoom);
+        _mm_storeu_ps(out + 2 * i, _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b)));
+    }
+#elif defined(PATHVIEW_VIEWPORT_NEON)
+    const double positionPair[2] = {position_.x, position_.y};
+    const float64x2_t position = vld1q_f64(positionPair);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t a = vmulq_n_f64(vsubq_f64(vld1q_f64(&points[i].x), position), zoom_);
+        float64x2_t b = vmulq_n_f64(vsubq_f64(vld1q_f64(&points[i + 1].x), position), zoom_);
+        vst1q_f32(out + 2 * i, vcombine_f32(vcvt_f32_f64(a), vcvt_f32_f64(b)));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[2 * i] = static_cast<float>((points[i].x - position_.x) * zoom_);
+        out[2 * i + 1] = static_cast<float>((points[i].y - position_.y) * zoom_);
+    }
 }
 
 Rect Viewport::GetVisibleRegion() const {
@@ -147,6 +237,22 @@ Rect Viewport::GetVisibleRegion() const {
     return Rect(position_.x, position_.y, viewportWidth, viewportHeight);
 }
 
+double Viewport::GetTargetZoom() const {
+    return animation_.IsActive() ? animation_.GetTargetZoom() : zoom_;
+}
+
+Rect Viewport::GetTargetVisibleRegion() const {
+    if (!animation_.IsActive()) {
+        return GetVisibleRegion();
+    }
+
+    // Targets are pre-clamped when the animation starts
+    Vec2 targetPos = animation_.GetTargetPosition();
+    double targetZoom = animation_.GetTargetZoom();
+
+    return Rect(targetPos.x, targetPos.y, windowWidth_ / targetZoom, windowHeight_ / targetZoom);
+}
+
 void Viewport::ClampToBounds() {
     // Calculate viewport size in slide coordinates
     double viewportWidth = windowWidth_ / zoom_;
@@ -189,7 +295,7 @@ void Viewport::CalculateZoomLimits() {
     // Maximum zoom: 4x magnification or 1:1 pixel mapping, whichever is larger
     maxZoom_ = 4.0;
 
-    std::cout << "Viewport zoom limits: " << minZoom_ << " - " << maxZoom_ << std::endl;
+    PATHVIEW_LOG_INFO("Viewport zoom limits: " << minZoom_ << " - " << maxZoom_);
 }
 
 void Viewport::UpdateAnimation(double currentTimeMs) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <algorithm>
 #include "Animation.h"  // Provides Vec2 and AnimationMode
@@ -52,18 +53,44 @@ public:
                   AnimationMode mode = AnimationMode::INSTANT);
     void ResetView(AnimationMode mode = AnimationMode::INSTANT);
 
+    // Jump straight to a view (zoom clamped to the limits), cancelling any
+    // animation; for views that follow another (see ViewportLink)
+    void SetView(Vec2 slideCenter, double zoom);
+
     // Animation update (called each frame)
     void UpdateAnimation(double currentTimeMs);
 
     // Coordinate transformations
-    Vec2 ScreenToSlide(Vec2 screenPos) const;
-    Vec2 SlideToScreen(Vec2 slidePos) const;
+    Vec2 ScreenToSlide(Vec2 screenPos) const {
+        return Vec2(screenPos.x / zoom_ + position_.x, screenPos.y / zoom_ + position_.y);
+    }
+    Vec2 SlideToScreen(Vec2 slidePos) const {
+        return Vec2((slidePos.x - position_.x) * zoom_, (slidePos.y - position_.y) * zoom_);
+    }
+
+    // Batch SlideToScreen in single precision, four points per SIMD step.
+    // Each writes n interleaved screen x, y pairs (2n floats) to out, the
+    // layout SDL_RenderGeometryRaw takes.
+    void TransformToScreen(const float* xs, const float* ys, size_t n, float* out) const;
+    // Interleaved x, y pairs, such as PolygonStore vertices. Coordinates
+    // stored relative to an origin (a geometry chunk) pass it here, which
+    // keeps the float arithmetic on small numbers. out may equal xy.
+    void TransformToScreen(const float* xy, size_t n, float* out,
+                           double originX = 0.0, double originY = 0.0) const;
+    // Double precision slide points, such as annotation vertices
+    void TransformToScreen(const Vec2* points, size_t n, float* out) const;
 
     // Viewport state queries
     double GetZoom() const { return zoom_; }
     Vec2 GetPosition() const { return position_; }
     Rect GetVisibleRegion() const;
 
+    // Animation target queries (used for prefetching).
+    // When no animation is running these return the current state.
+    bool IsAnimating() const { return animation_.IsActive(); }
+    double GetTargetZoom() const;
+    Rect GetTargetVisibleRegion() const;
+
     // Zoom limits
     double GetMinZoom() const { return minZoom_; }
     double GetMaxZoom() const { return maxZoom_; }
@@ -0,0 +1,36 @@
+#include "ViewportLink.h"
+#include <cmath>
+
+ViewportLink::ViewportLink(double a, double b, double c, double d, double tx, double ty)
+    : a_(a), b_(b), c_(c), d_(d), tx_(tx), ty_(ty) {
+}
+
+void ViewportLink::SetZoomRatio(double ratio) {
+    if (ratio > 0.0) {
+        zoomRatio_ = ratio;
+    }
+}
+
+Vec2 ViewportLink::Map(Vec2 leaderPoint) const {
+    return Vec2(a_ * leaderPoint.x + b_ * leaderPoint.y + tx_,
+                c_ * leaderPoint.x + d_ * leaderPoint.y + ty_);
+}
+
+double ViewportLink::GetScale() const {
+    return std::sqrt(std::abs(a_ * d_ - b_ * c_));
+}
+
+bool ViewportLink::IsValid() const {
+    return GetScale() > 0.0;
+}
+
+void ViewportLink::Apply(const Viewport& leader, Viewport& follower) const {
+    if (!IsValid()) {
+        return;
+    }
+    Vec2 center = leader.ScreenToSlide(Vec2(leader.GetWindowWidth() / 2.0, leader.GetWindowHeight() / 2.0));
+
+    // A leader screen pixel spans 1 / zoom leader units, that is
+    // scale / zoom follower units
+    follower.SetView(Map(center), leader.GetZoom() / GetScale() * zoomRatio_);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Viewport.h"
+
+// Keeps a follower view on what a leader view shows: the leader's center
+// mapped through an affine transform from leader slide coordinates to
+// follower slide coordinates, at the leader's field of view times a zoom
+// ratio. The identity with a ratio of 4 shows the same slide at four times
+// the magnification; a registration transform pairs serial sections.
+//
+// Tiles are drawn axis-aligned, so a transform that rotates moves the
+// follower's center and scale correctly but does not turn its picture.
+class ViewportLink {
+public:
+    ViewportLink() = default;  // Identity, same magnification
+
+    // follower = [a b; c d] * leader + (tx, ty)
+    ViewportLink(double a, double b, double c, double d, double tx, double ty);
+
+    void SetZoomRatio(double ratio);
+    double GetZoomRatio() const { return zoomRatio_; }
+
+    Vec2 Map(Vec2 leaderPoint) const;
+
+    // Follower slide units per leader slide unit (sqrt of |det|)
+    double GetScale() const;
+
+    // A singular transform maps everything onto a line
+    bool IsValid() const;
+
+    // Point the follower at the leader's view
+    void Apply(const Viewport& leader, Viewport& follower) const;
+
+private:
+    double a_ = 1.0;
+    double b_ = 0.0;
+    double c_ = 0.0;
+    double d_ = 1.0;
+    double tx_ = 0.0;
+    double ty_ = 0.0;
+    double zoomRatio_ = 1.0;
+};
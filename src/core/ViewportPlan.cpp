@@ -0,0 +1,30 @@
+#include "ViewportPlan.h"
+#include <cmath>
+#include <utility>
+
+void ViewportPlan::Set(std::vector<ViewportWaypoint> waypoints) {
+    waypoints_ = std::move(waypoints);
+    next_ = 0;
+}
+
+bool ViewportPlan::Update(Vec2 center, double zoom, int windowWidth, int windowHeight) {
+    if (IsDone() || zoom <= 0.0) {
+        return false;
+    }
+    const double toleranceX = MATCH_FRACTION * windowWidth / zoom;
+    const double toleranceY = MATCH_FRACTION * windowHeight / zoom;
+    for (size_t i = next_; i < waypoints_.size(); ++i) {
+        const ViewportWaypoint& waypoint = waypoints_[i];
+        if (std::abs(waypoint.center.x - center.x) <= toleranceX &&
+            std::abs(waypoint.center.y - center.y) <= toleranceY &&
+            std::abs(waypoint.zoom / zoom - 1.0) <= MATCH_FRACTION) {
+            next_ = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<ViewportWaypoint> ViewportPlan::GetUpcoming() const {
+    return std::vector<ViewportWaypoint>(waypoints_.begin() + static_cast<std::ptrdiff_t>(next_), waypoints_.end());
+}
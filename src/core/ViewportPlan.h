@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Viewport.h"
+#include <cstddef>
+#include <vector>
+
+// A view an agent will move to: its center in slide coordinates and zoom,
+// as viewport.move takes them
+struct ViewportWaypoint {
+    Vec2 center;
+    double zoom = 1.0;
+};
+
+// A tour announced up front (viewport.plan): the waypoints an agent will
+// move the view through, in order. Following the view tells which of them
+// it has reached, so the renderer can prefetch the ones still ahead (see
+// SlideRenderer::SetPlannedViews) while the current one is looked at.
+//
+// A waypoint counts as reached once the view shows it or is animating to
+// it: its center within MATCH_FRACTION of the view's size and its zoom
+// within MATCH_FRACTION. Waypoints may be skipped; a view that matches
+// none leaves the plan where it was.
+class ViewportPlan {
+public:
+    void Set(std::vector<ViewportWaypoint> waypoints);
+    void Clear() { Set({}); }
+
+    // Every waypoint reached, or none set
+    bool IsDone() const { return next_ >= waypoints_.size(); }
+
+    /**
+     * Follow the view to the waypoints it reached
+     * @param center Center of the view, or of its animation's target
+     * @param zoom Zoom of the view, or of its animation's target
+     * @param windowWidth, windowHeight View size in screen pixels
+     * @return Whether the next waypoint changed
+     */
+    bool Update(Vec2 center, double zoom, int windowWidth, int windowHeight);
+
+    const std::vector<ViewportWaypoint>& GetWaypoints() const { return waypoints_; }
+    // Index of the first waypoint after the last one reached
+    size_t GetNext() const { return next_; }
+    // The waypoints from GetNext() on
+    std::vector<ViewportWaypoint> GetUpcoming() const;
+
+    static constexpr double MATCH_FRACTION = 0.25;
+
+private:
+    std::vector<ViewportWaypoint> waypoints_;
+    size_t next_ = 0;
+};
@@ -0,0 +1,90 @@
+#include "ViewportTrace.h"
+#include "Log.h"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+struct TraceFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sampleCount;
+};
+
+// Times are stored in microseconds so a replay schedules frames exactly
+// as recorded
+struct TraceFileRecord {
+    uint64_t timeUs;
+    double x;
+    double y;
+    double zoom;
+    int32_t windowWidth;
+    int32_t windowHeight;
+};
+
+constexpr uint32_t TRACE_FILE_MAGIC = 0x54565650;  // "PVVT"
+constexpr uint32_t TRACE_FILE_VERSION = 1;
+
+}  // namespace
+
+bool ViewportTrace::Append(const ViewportSample& sample) {
+    if (!samples_.empty() && samples_.back().SameView(sample)) {
+        return false;
+    }
+    samples_.push_back(sample);
+    if (samples_.size() > 1) {
+        // Clock hiccups must not reorder the trace
+        ViewportSample& last = samples_.back();
+        last.timeMs = std::max(last.timeMs, samples_[samples_.size() - 2].timeMs);
+    }
+    return true;
+}
+
+size_t ViewportTrace::SampleIndexAt(double timeMs) const {
+    auto it = std::upper_bound(samples_.begin(), samples_.end(), timeMs,
+                               [](double t, const ViewportSample& sample) { return t < sample.timeMs; });
+    return it == samples_.begin() ? 0 : static_cast<size_t>(it - samples_.begin()) - 1;
+}
+
+bool ViewportTrace::Save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        PATHVIEW_LOG_ERROR("ViewportTrace: Cannot write " << path);
+        return false;
+    }
+
+    TraceFileHeader header{TRACE_FILE_MAGIC, TRACE_FILE_VERSION, samples_.size()};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const ViewportSample& sample : samples_) {
+        TraceFileRecord record{static_cast<uint64_t>(std::max(0.0, sample.timeMs) * 1000.0 + 0.5),
+                               sample.x, sample.y, sample.zoom,
+                               sample.windowWidth, sample.windowHeight};
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    return static_cast<bool>(file);
+}
+
+bool ViewportTrace::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    TraceFileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != TRACE_FILE_MAGIC || header.version != TRACE_FILE_VERSION) {
+        PATHVIEW_LOG_ERROR("ViewportTrace: " << path << " is not a viewport trace");
+        return false;
+    }
+
+    std::vector<ViewportSample> samples;
+    samples.reserve(static_cast<size_t>(std::min<uint64_t>(header.sampleCount, 1 << 20)));
+    for (uint64_t i = 0; i < header.sampleCount; ++i) {
+        TraceFileRecord record{};
+        if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            PATHVIEW_LOG_ERROR("ViewportTrace: " << path << " is truncated");
+            return false;
+        }
+        samples.push_back({record.timeUs / 1000.0, record.x, record.y, record.zoom,
+                           record.windowWidth, record.windowHeight});
+    }
+
+    samples_ = std::move(samples);
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One rendered viewport state
+struct ViewportSample {
+    double timeMs;          // Since the start of the recording
+    double x;               // Top-left corner in level-0 slide pixels
+    double y;
+    double zoom;
+    int32_t windowWidth;
+    int32_t windowHeight;
+
+    bool SameView(const ViewportSample& other) const {
+        return x == other.x && y == other.y && zoom == other.zoom &&
+               windowWidth == other.windowWidth && windowHeight == other.windowHeight;
+    }
+};
+
+// A review session as the sequence of viewport states that were drawn.
+//
+// States are appended once per frame and only kept when they differ from
+// the previous one, so idle time costs nothing while animations (smooth
+// zooms, viewport.move) are captured frame by frame. Replaying the states
+// on the recorded timestamps reproduces the session exactly, without
+// re-running input handling or animation easing.
+class ViewportTrace {
+public:
+    // Stores the sample unless it shows the same view as the last one.
+    // Returns true if it was stored.
+    bool Append(const ViewportSample& sample);
+
+    const std::vector<ViewportSample>& GetSamples() const { return samples_; }
+    size_t GetSampleCount() const { return samples_.size(); }
+    bool IsEmpty() const { return samples_.empty(); }
+    double GetDurationMs() const { return samples_.empty() ? 0.0 : samples_.back().timeMs; }
+    void Clear() { samples_.clear(); }
+
+    // Index of the latest sample recorded at or before timeMs (0 before
+    // the first one). Requires a non-empty trace.
+    size_t SampleIndexAt(double timeMs) const;
+
+    // Binary file: a header, then one fixed-size little-endian record per
+    // sample. Load replaces the current samples and fails on missing,
+    // foreign or truncated files.
+    bool Save(const std::string& path) const;
+    bool Load(const std::string& path);
+
+private:
+    std::vector<ViewportSample> samples_;
+};
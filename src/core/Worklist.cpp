@@ -0,0 +1,80 @@
+#include "Worklist.h"
+#include "Log.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::string Trim(const std::string& text) {
+    const char* whitespace = " \t\r\n";
+    size_t begin = text.find_first_not_of(whitespace);
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(whitespace) - begin + 1);
+}
+
+}  // namespace
+
+void Worklist::SetEntries(std::vector<WorklistEntry> entries) {
+    entries_ = std::move(entries);
+    index_ = NO_ENTRY;
+}
+
+void Worklist::Clear() {
+    SetEntries({});
+}
+
+std::vector<WorklistEntry> Worklist::Parse(const std::string& text) {
+    std::vector<WorklistEntry> entries;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string trimmed = Trim(line);
+        if (trimmed.empty() || trimmed[0] == '#') {
+            continue;
+        }
+        WorklistEntry entry;
+        size_t tab = trimmed.find('\t');
+        entry.slidePath = Trim(trimmed.substr(0, tab));
+        if (tab != std::string::npos) {
+            entry.polygonPath = Trim(trimmed.substr(tab + 1));
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+bool Worklist::LoadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        PATHVIEW_LOG_ERROR("Worklist: Cannot read " << path);
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    SetEntries(Parse(text.str()));
+    PATHVIEW_LOG_INFO("Worklist: " << entries_.size() << " slides from " << path);
+    return true;
+}
+
+const WorklistEntry* Worklist::GetCurrent() const {
+    return index_ < entries_.size() ? &entries_[index_] : nullptr;
+}
+
+bool Worklist::Select(size_t index) {
+    if (index >= entries_.size()) {
+        return false;
+    }
+    index_ = index;
+    return true;
+}
+
+size_t Worklist::GetNextIndex() const {
+    size_t next = index_ == NO_ENTRY ? 0 : index_ + 1;
+    return next < entries_.size() ? next : NO_ENTRY;
+}
+
+size_t Worklist::GetPreviousIndex() const {
+    return index_ != NO_ENTRY && index_ > 0 ? index_ - 1 : NO_ENTRY;
+}
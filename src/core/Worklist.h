@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct WorklistEntry {
+    std::string slidePath;
+    std::string polygonPath;  // Empty: no polygon file
+};
+
+// Ordered case list read one slide after another. Application opens the
+// current entry and preloads the next one in the background, so moving on
+// does not wait for the slide to open.
+class Worklist {
+public:
+    // Replaces the entries; none is current until Select()
+    void SetEntries(std::vector<WorklistEntry> entries);
+    void Clear();
+
+    // One entry per line: the slide path, optionally followed by a tab and
+    // its polygon file. Blank lines and lines starting with '#' are skipped.
+    static std::vector<WorklistEntry> Parse(const std::string& text);
+    bool LoadFile(const std::string& path);
+
+    const std::vector<WorklistEntry>& GetEntries() const { return entries_; }
+    size_t GetSize() const { return entries_.size(); }
+    bool IsEmpty() const { return entries_.empty(); }
+
+    // Current entry, or NO_ENTRY / nullptr before one is selected
+    size_t GetIndex() const { return index_; }
+    const WorklistEntry* GetCurrent() const;
+    bool Select(size_t index);
+
+    // Entries around the current one (NO_ENTRY past the ends); with none
+    // current, the first entry is next
+    size_t GetNextIndex() const;
+    size_t GetPreviousIndex() const;
+
+    static constexpr size_t NO_ENTRY = SIZE_MAX;
+
+private:
+    std::vector<WorklistEntry> entries_;
+    size_t index_ = NO_ENTRY;
+};
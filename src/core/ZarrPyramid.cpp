@@ -0,0 +1,620 @@
+#include "ZarrPyramid.h"
+#include "json.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <zlib.h>
+
+#ifdef PATHVIEW_HAS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PATHVIEW_HAS_BLOSC
+#include <blosc.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// Guards against corrupt or hostile metadata
+constexpr uint64_t MAX_CHUNK_BYTES = 256 * 1024 * 1024;
+constexpr size_t MAX_LEVELS = 32;
+constexpr int64_t MAX_CHANNELS = 1024;
+constexpr size_t MAX_DIMENSIONS = 8;
+
+// Decoded multichannel chunks each thread keeps, so a composite reading
+// channel after channel decodes a chunk once
+constexpr size_t CHUNK_CACHE_ENTRIES = 8;
+
+// NGFF before 0.3 names no axes: arrays are (t, c, z, y, x)
+const char* const DEFAULT_AXES = "tczyx";
+
+std::atomic<uint64_t> nextSerial{1};
+
+bool ReadFileBytes(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamoff size = file.tellg();
+    if (size < 0 || static_cast<uint64_t>(size) > MAX_CHUNK_BYTES) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return file.read(reinterpret_cast<char*>(out.data()), size).good() || size == 0;
+}
+
+std::optional<json> ReadJson(const fs::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    json value = json::parse(file, nullptr, false);
+    if (value.is_discarded() || !value.is_object()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Inflate a zlib (or gzip) stream into exactly raw.size() bytes
+bool Inflate(const uint8_t* data, size_t size, bool gzip, std::vector<uint8_t>& raw) {
+    z_stream stream{};
+    if (inflateInit2(&stream, gzip ? 16 + MAX_WBITS : MAX_WBITS) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = raw.data();
+    stream.avail_out = static_cast<uInt>(raw.size());
+    const int result = inflate(&stream, Z_FINISH);
+    const size_t produced = stream.total_out;
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && produced == raw.size();
+}
+
+// Scale to micrometres of an NGFF axis unit, 0 if not a length
+double MicronsPerUnit(const std::string& unit) {
+    if (unit == "micrometer") return 1.0;
+    if (unit == "nanometer") return 1e-3;
+    if (unit == "millimeter") return 1e3;
+    return 0.0;
+}
+
+// An array of integers, empty if value is anything else
+std::vector<int64_t> Integers(const json& value) {
+    std::vector<int64_t> integers;
+    if (!value.is_array()) {
+        return integers;
+    }
+    for (const json& item : value) {
+        if (!item.is_number_integer()) {
+            return {};
+        }
+        integers.push_back(item.get<int64_t>());
+    }
+    return integers;
+}
+
+uint32_t ParseHexColor(const std::string& text) {
+    if (text.size() != 6 || text.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        return ZarrPyramid::NO_COLOR;
+    }
+    return static_cast<uint32_t>(std::stoul(text, nullptr, 16));
+}
+
+}  // namespace
+
+ZarrPyramid::ZarrPyramid(const std::string& path)
+    : serial_(nextSerial++)
+{
+    fs::path root(path);
+    const std::string name = root.filename().string();
+    if (name == ".zattrs" || name == ".zgroup" || name == "zarr.json") {
+        root = root.parent_path();
+    }
+    bool opened = false;
+    try {
+        opened = OpenGroup(root.string());
+    } catch (const json::exception& e) {
+        // A metadata value of the wrong type
+        error_ = std::string("Invalid Zarr metadata: ") + e.what();
+    }
+    if (!opened) {
+        levels_.clear();
+        channelNames_.clear();
+        channelColors_.clear();
+    }
+}
+
+bool ZarrPyramid::IsZarrPath(const std::string& path) {
+    std::error_code error;
+    const fs::path root(path);
+    const std::string name = root.filename().string();
+    if (name == ".zattrs" || name == ".zgroup" || name == "zarr.json") {
+        return fs::is_regular_file(root, error);
+    }
+    return fs::is_directory(root, error) &&
+           (fs::exists(root / ".zattrs", error) || fs::exists(root / "zarr.json", error));
+}
+
+const char* ZarrPyramid::GetCodecName() const {
+    if (levels_.empty()) {
+        return "none";
+    }
+    switch (levels_[0].codec) {
+        case Codec::Zlib: return "zlib";
+        case Codec::Gzip: return "gzip";
+        case Codec::Zstd: return "zstd";
+        case Codec::Blosc: return "blosc";
+        case Codec::None: break;
+    }
+    return "none";
+}
+
+bool ZarrPyramid::OpenGroup(const std::string& rootPath) {
+    const fs::path root(rootPath);
+    json attributes;
+    std::error_code error;
+    if (std::optional<json> group = ReadJson(root / "zarr.json")) {
+        zarrFormat_ = 3;
+        metadataPath_ = (root / "zarr.json").string();
+        attributes = group->value("attributes", json::object());
+        // NGFF 0.5 keeps its metadata under "ome"
+        if (attributes.contains("ome") && attributes["ome"].is_object()) {
+            attributes = attributes["ome"];
+        }
+    } else if (std::optional<json> group = ReadJson(root / ".zattrs")) {
+        zarrFormat_ = 2;
+        metadataPath_ = (root / ".zattrs").string();
+        attributes = std::move(*group);
+    } else {
+        error_ = "No Zarr group metadata";
+        return false;
+    }
+
+    const json* multiscales = attributes.contains("multiscales") ? &attributes["multiscales"] : nullptr;
+    if (!multiscales || !multiscales->is_array() || multiscales->empty() || !(*multiscales)[0].is_object()) {
+        // A bioformats2raw container holds its images as numbered groups
+        if (attributes.contains("bioformats2raw.layout") && fs::is_directory(root / "0", error)) {
+            return OpenGroup((root / "0").string());
+        }
+        error_ = "No OME-NGFF multiscales";
+        return false;
+    }
+    const json& multiscale = (*multiscales)[0];
+
+    // Axis names, and the units of the spatial ones
+    std::vector<std::string> axes;
+    std::string unitX;
+    std::string unitY;
+    if (multiscale.contains("axes") && multiscale["axes"].is_array()) {
+        for (const json& axis : multiscale["axes"]) {
+            std::string name = axis.is_string() ? axis.get<std::string>()
+                                                : axis.is_object() ? axis.value("name", "") : "";
+            if (axis.is_object() && axis.contains("unit") && axis["unit"].is_string()) {
+                if (name == "x") {
+                    unitX = axis["unit"].get<std::string>();
+                } else if (name == "y") {
+                    unitY = axis["unit"].get<std::string>();
+                }
+            }
+            axes.push_back(std::move(name));
+        }
+    }
+
+    const json* datasets = multiscale.contains("datasets") ? &multiscale["datasets"] : nullptr;
+    if (!datasets || !datasets->is_array() || datasets->empty()) {
+        error_ = "Multiscale has no datasets";
+        return false;
+    }
+    for (const json& dataset : *datasets) {
+        if (levels_.size() >= MAX_LEVELS || !dataset.is_object() || !dataset.contains("path") ||
+            !dataset["path"].is_string()) {
+            break;
+        }
+        Array array;
+        if (!OpenArray((root / dataset["path"].get<std::string>()).string(), array)) {
+            if (levels_.empty()) {
+                return false;
+            }
+            break;  // Keep the finer levels
+        }
+        if (!levels_.empty() && array.shape.size() != levels_[0].shape.size()) {
+            break;
+        }
+        levels_.push_back(std::move(array));
+    }
+    if (levels_.empty()) {
+        error_ = "Multiscale has no readable datasets";
+        return false;
+    }
+
+    const size_t dimensions = levels_[0].shape.size();
+    if (axes.empty()) {
+        const std::string names(DEFAULT_AXES);
+        for (size_t i = names.size() - std::min(dimensions, names.size()); i < names.size(); ++i) {
+            axes.push_back(std::string(1, names[i]));
+        }
+    }
+    if (axes.size() != dimensions) {
+        error_ = "Axes do not match the array dimensions";
+        return false;
+    }
+    for (size_t i = 0; i < axes.size(); ++i) {
+        if (axes[i] == "x") axisX_ = static_cast<int32_t>(i);
+        if (axes[i] == "y") axisY_ = static_cast<int32_t>(i);
+        if (axes[i] == "c") axisC_ = static_cast<int32_t>(i);
+    }
+    if (axisX_ < 0 || axisY_ < 0) {
+        error_ = "Image has no x and y axes";
+        return false;
+    }
+
+    // Every level must have all the channels and be no larger than the last
+    const int64_t channels = axisC_ >= 0 ? levels_[0].shape[axisC_] : 1;
+    if (channels <= 0 || channels > MAX_CHANNELS) {
+        error_ = "Unsupported channel count";
+        return false;
+    }
+    for (size_t i = 1; i < levels_.size(); ++i) {
+        if ((axisC_ >= 0 && levels_[i].shape[axisC_] != channels) ||
+            levels_[i].shape[axisX_] > levels_[i - 1].shape[axisX_] ||
+            levels_[i].shape[axisY_] > levels_[i - 1].shape[axisY_] ||
+            levels_[i].bytesPerSample != levels_[0].bytesPerSample) {
+            levels_.resize(i);
+            break;
+        }
+    }
+
+    const json* omeroChannels = nullptr;
+    if (attributes.contains("omero") && attributes["omero"].is_object() &&
+        attributes["omero"].contains("channels") && attributes["omero"]["channels"].is_array()) {
+        omeroChannels = &attributes["omero"]["channels"];
+    }
+    for (int64_t i = 0; i < channels; ++i) {
+        std::string name = "Channel " + std::to_string(i);
+        uint32_t color = NO_COLOR;
+        if (omeroChannels && static_cast<size_t>(i) < omeroChannels->size() && (*omeroChannels)[i].is_object()) {
+            const json& channel = (*omeroChannels)[i];
+            if (channel.contains("label") && channel["label"].is_string() &&
+                !channel["label"].get<std::string>().empty()) {
+                name = channel["label"].get<std::string>();
+            }
+            if (channel.contains("color") && channel["color"].is_string()) {
+                color = ParseHexColor(channel["color"].get<std::string>());
+            }
+        }
+        channelNames_.push_back(std::move(name));
+        channelColors_.push_back(color);
+    }
+
+    // Level 0 pixel size from its scale transform (NGFF 0.4 on)
+    const json& first = (*datasets)[0];
+    if (first.contains("coordinateTransformations") && first["coordinateTransformations"].is_array()) {
+        for (const json& transform : first["coordinateTransformations"]) {
+            if (!transform.is_object() || transform.value("type", "") != "scale" ||
+                !transform.contains("scale") || !transform["scale"].is_array() ||
+                transform["scale"].size() != dimensions) {
+                continue;
+            }
+            const json& scale = transform["scale"];
+            if (scale[axisX_].is_number() && scale[axisY_].is_number()) {
+                pixelSizeX_ = scale[axisX_].get<double>() * MicronsPerUnit(unitX);
+                pixelSizeY_ = scale[axisY_].get<double>() * MicronsPerUnit(unitY);
+            }
+        }
+    }
+    return true;
+}
+
+bool ZarrPyramid::OpenArray(const std::string& path, Array& array) {
+    const fs::path directory(path);
+    array.path = path;
+
+    json codecs = json::array();
+    std::string dataType;
+    std::string chunkShapeKey;
+    json fillValue;
+    if (std::optional<json> metadata = ReadJson(directory / "zarr.json")) {
+        if (metadata->value("node_type", "") != "array") {
+            error_ = "Dataset " + path + " is not an array";
+            return false;
+        }
+        dataType = metadata->value("data_type", "");
+        if (metadata->contains("chunk_grid") && (*metadata)["chunk_grid"].is_object()) {
+            const json& grid = (*metadata)["chunk_grid"];
+            if (grid.value("name", "") == "regular" && grid.contains("configuration") &&
+                grid["configuration"].contains("chunk_shape")) {
+                (*metadata)["chunks"] = grid["configuration"]["chunk_shape"];
+            }
+        }
+        array.keyPrefix = "c";
+        array.separator = '/';
+        if (metadata->contains("chunk_key_encoding") && (*metadata)["chunk_key_encoding"].is_object()) {
+            const json& encoding = (*metadata)["chunk_key_encoding"];
+            if (encoding.value("name", "default") == "v2") {
+                array.keyPrefix.clear();
+                array.separator = '.';
+            }
+            if (encoding.contains("configuration") && encoding["configuration"].is_object()) {
+                const std::string separator = encoding["configuration"].value("separator", "");
+                if (separator == "." || separator == "/") {
+                    array.separator = separator[0];
+                }
+            }
+        }
+        if (!array.keyPrefix.empty()) {
+            array.keyPrefix += array.separator;
+        }
+        codecs = metadata->value("codecs", json::array());
+        fillValue = metadata->value("fill_value", json());
+        array.shape = Integers(metadata->value("shape", json()));
+        array.chunks = Integers(metadata->value("chunks", json()));
+    } else if (std::optional<json> metadata = ReadJson(directory / ".zarray")) {
+        if (metadata->value("order", "C") != "C" ||
+            (metadata->contains("filters") && !(*metadata)["filters"].is_null())) {
+            error_ = "Dataset " + path + " uses F order or filters";
+            return false;
+        }
+        const std::string dtype = metadata->value("dtype", "");
+        // "<u2": byte order, kind, size
+        if (dtype.size() == 3 && dtype[1] == 'u') {
+            dataType = dtype[2] == '1' ? "uint8" : dtype[2] == '2' ? "uint16" : "";
+            codecs.push_back({{"name", "bytes"}, {"configuration", {{"endian", dtype[0] == '>' ? "big" : "little"}}}});
+        }
+        if (metadata->contains("compressor") && (*metadata)["compressor"].is_object()) {
+            codecs.push_back({{"name", (*metadata)["compressor"].value("id", "")}});
+        }
+        const std::string separator = metadata->value("dimension_separator", ".");
+        array.separator = separator == "/" ? '/' : '.';
+        fillValue = metadata->value("fill_value", json());
+        array.shape = Integers(metadata->value("shape", json()));
+        array.chunks = Integers(metadata->value("chunks", json()));
+    } else {
+        error_ = "No array metadata in " + path;
+        return false;
+    }
+
+    if (dataType == "uint8") {
+        array.bytesPerSample = 1;
+    } else if (dataType == "uint16") {
+        array.bytesPerSample = 2;
+    } else {
+        error_ = "Dataset " + path + " is not uint8 or uint16";
+        return false;
+    }
+    if (fillValue.is_number_unsigned()) {
+        array.fillValue = static_cast<uint16_t>(std::min<uint64_t>(fillValue.get<uint64_t>(), 0xFFFF));
+    }
+
+    for (const json& codec : codecs) {
+        const std::string name = codec.is_object() ? codec.value("name", "") : "";
+        if (name == "bytes") {
+            if (codec.contains("configuration") && codec["configuration"].is_object()) {
+                array.bigEndian = codec["configuration"].value("endian", "little") == "big";
+            }
+        } else if ((name == "zlib" || name == "gzip" || name == "zstd" || name == "blosc") &&
+                   array.codec == Codec::None) {
+            array.codec = name == "zlib" ? Codec::Zlib : name == "gzip" ? Codec::Gzip
+                        : name == "zstd" ? Codec::Zstd : Codec::Blosc;
+        } else {
+            // sharding_indexed, transpose, crc32c, ...
+            error_ = "Dataset " + path + " uses the unsupported codec \"" + name + "\"";
+            return false;
+        }
+    }
+#ifndef PATHVIEW_HAS_ZSTD
+    if (array.codec == Codec::Zstd) {
+        error_ = "zstd chunks need a build with libzstd";
+        return false;
+    }
+#endif
+#ifndef PATHVIEW_HAS_BLOSC
+    if (array.codec == Codec::Blosc) {
+        error_ = "Blosc chunks need a build with c-blosc";
+        return false;
+    }
+#endif
+
+    uint64_t chunkBytes = array.bytesPerSample;
+    bool valid = array.shape.size() >= 2 && array.shape.size() <= MAX_DIMENSIONS &&
+                 array.chunks.size() == array.shape.size();
+    for (size_t i = 0; valid && i < array.shape.size(); ++i) {
+        valid = array.shape[i] > 0 && array.chunks[i] > 0 &&
+                chunkBytes * static_cast<uint64_t>(array.chunks[i]) <= MAX_CHUNK_BYTES;
+        chunkBytes *= valid ? static_cast<uint64_t>(array.chunks[i]) : 1;
+    }
+    if (!valid) {
+        error_ = "Dataset " + path + " has an invalid shape or chunk shape";
+        return false;
+    }
+    return true;
+}
+
+std::vector<LevelDimensions> ZarrPyramid::GetLevels() const {
+    std::vector<LevelDimensions> levels;
+    for (const Array& array : levels_) {
+        levels.push_back({array.shape[axisX_], array.shape[axisY_]});
+    }
+    return levels;
+}
+
+LevelDimensions ZarrPyramid::GetChunkSize(int32_t level) const {
+    if (level < 0 || level >= static_cast<int32_t>(levels_.size())) {
+        return {0, 0};
+    }
+    return {levels_[level].chunks[axisX_], levels_[level].chunks[axisY_]};
+}
+
+uint32_t ZarrPyramid::GetChannelBits(size_t) const {
+    return levels_.empty() ? 8 : levels_[0].bytesPerSample * 8;
+}
+
+std::string ZarrPyramid::ChunkPath(const Array& array, const std::vector<int64_t>& index) const {
+    std::string key = array.keyPrefix;
+    for (size_t i = 0; i < index.size(); ++i) {
+        if (i > 0) {
+            key += array.separator;
+        }
+        key += std::to_string(index[i]);
+    }
+    return (fs::path(array.path) / key).string();
+}
+
+bool ZarrPyramid::ReadChunk(const Array& array, const std::vector<int64_t>& index,
+                            std::vector<uint8_t>& raw) const {
+    thread_local std::vector<uint8_t> stored;
+    std::error_code error;
+    const std::string path = ChunkPath(array, index);
+    if (!fs::exists(path, error)) {
+        raw.clear();
+        return true;
+    }
+    if (!ReadFileBytes(path, stored)) {
+        return false;
+    }
+    chunkReadCount_++;
+
+    size_t rawSize = array.bytesPerSample;
+    for (int64_t extent : array.chunks) {
+        rawSize *= static_cast<size_t>(extent);
+    }
+    raw.resize(rawSize);
+    switch (array.codec) {
+        case Codec::None:
+            if (stored.size() < rawSize) {
+                return false;
+            }
+            std::memcpy(raw.data(), stored.data(), rawSize);
+            return true;
+        case Codec::Zlib:
+        case Codec::Gzip:
+            return Inflate(stored.data(), stored.size(), array.codec == Codec::Gzip, raw);
+        case Codec::Zstd:
+#ifdef PATHVIEW_HAS_ZSTD
+        {
+            const size_t size = ZSTD_decompress(raw.data(), raw.size(), stored.data(), stored.size());
+            return !ZSTD_isError(size) && size == raw.size();
+        }
+#else
+            return false;
+#endif
+        case Codec::Blosc:
+#ifdef PATHVIEW_HAS_BLOSC
+            return blosc_decompress_ctx(stored.data(), raw.data(), raw.size(), 1) ==
+                   static_cast<int>(raw.size());
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool ZarrPyramid::ReadChannelRegion(int32_t level, size_t channel, int64_t x, int64_t y, int64_t width,
+                                    int64_t height, uint16_t* samples) const {
+    if (level < 0 || level >= static_cast<int32_t>(levels_.size()) || channel >= channelNames_.size() ||
+        width <= 0 || height <= 0 || !samples) {
+        return false;
+    }
+    const Array& array = levels_[level];
+    const int64_t levelWidth = array.shape[axisX_];
+    const int64_t levelHeight = array.shape[axisY_];
+    const int64_t cw = array.chunks[axisX_];
+    const int64_t ch = array.chunks[axisY_];
+
+    std::fill(samples, samples + width * height, uint16_t{0});
+    const int64_t x0 = std::max<int64_t>(x, 0);
+    const int64_t y0 = std::max<int64_t>(y, 0);
+    const int64_t x1 = std::min(x + width, levelWidth);
+    const int64_t y1 = std::min(y + height, levelHeight);
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    // Element strides inside a chunk (C order), and where this channel's
+    // plane starts; other axes (t, z) read index 0
+    const size_t dimensions = array.shape.size();
+    std::vector<int64_t> strides(dimensions, 1);
+    for (size_t i = dimensions - 1; i > 0; --i) {
+        strides[i - 1] = strides[i] * array.chunks[i];
+    }
+    std::vector<int64_t> index(dimensions, 0);
+    int64_t planeOffset = 0;
+    const bool sharedChunk = axisC_ >= 0 && array.chunks[axisC_] > 1;
+    if (axisC_ >= 0) {
+        index[axisC_] = static_cast<int64_t>(channel) / array.chunks[axisC_];
+        planeOffset = static_cast<int64_t>(channel) % array.chunks[axisC_] * strides[axisC_];
+    }
+
+    struct CachedChunk {
+        uint64_t serial = 0;
+        int32_t level = -1;
+        std::vector<int64_t> index;
+        std::vector<uint8_t> raw;
+    };
+    thread_local std::array<CachedChunk, CHUNK_CACHE_ENTRIES> cache;
+    thread_local size_t cacheNext = 0;
+    thread_local std::vector<uint8_t> scratch;
+
+    for (int64_t row = y0 / ch; row * ch < y1; ++row) {
+        for (int64_t column = x0 / cw; column * cw < x1; ++column) {
+            index[axisY_] = row;
+            index[axisX_] = column;
+
+            const std::vector<uint8_t>* raw = nullptr;
+            if (sharedChunk) {
+                for (const CachedChunk& entry : cache) {
+                    if (entry.serial == serial_ && entry.level == level && entry.index == index) {
+                        raw = &entry.raw;
+                        break;
+                    }
+                }
+                if (!raw) {
+                    CachedChunk& entry = cache[cacheNext++ % CHUNK_CACHE_ENTRIES];
+                    entry.serial = 0;
+                    if (!ReadChunk(array, index, entry.raw)) {
+                        return false;
+                    }
+                    entry.serial = serial_;
+                    entry.level = level;
+                    entry.index = index;
+                    raw = &entry.raw;
+                }
+            } else {
+                if (!ReadChunk(array, index, scratch)) {
+                    return false;
+                }
+                raw = &scratch;
+            }
+
+            const int64_t chunkX = column * cw;
+            const int64_t chunkY = row * ch;
+            const int64_t copyX0 = std::max(chunkX, x0);
+            const int64_t copyX1 = std::min(chunkX + cw, x1);
+            for (int64_t py = std::max(chunkY, y0); py < std::min(chunkY + ch, y1); ++py) {
+                uint16_t* out = samples + (py - y) * width + (copyX0 - x);
+                if (raw->empty()) {
+                    std::fill(out, out + (copyX1 - copyX0), array.fillValue);
+                    continue;
+                }
+                const int64_t rowOffset = planeOffset + (py - chunkY) * strides[axisY_];
+                for (int64_t px = copyX0; px < copyX1; ++px) {
+                    const size_t element = static_cast<size_t>(rowOffset + (px - chunkX) * strides[axisX_]);
+                    if (array.bytesPerSample == 1) {
+                        *out++ = (*raw)[element];
+                    } else {
+                        const uint8_t* bytes = raw->data() + element * 2;
+                        *out++ = array.bigEndian ? static_cast<uint16_t>((bytes[0] << 8) | bytes[1])
+                                                 : static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "SlideLoader.h"  // For LevelDimensions
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reader for an OME-Zarr (OME-NGFF) multiscale image on local disk, Zarr
+// v2 (.zattrs / .zarray) or v3 (zarr.json): each resolution of the first
+// multiscale is a pyramid level and each index of its channel axis a
+// channel, read as samples like a multichannel TIFF (see
+// TiffTileReader::ReadChannelRegion). Images with time or z axes show
+// their first time point and plane. A bioformats2raw container opens its
+// first image ("0").
+//
+// A region read decodes the chunks it overlaps, each one file under the
+// array directory, so reads on different workers fetch and decompress
+// their chunks in parallel. The chunk size is the level's tile size: the
+// renderer's tile grid is laid over whole chunks, whatever their size. A
+// chunk holding several channels is decoded once for all of them (per
+// thread), and a missing chunk reads as the array's fill value.
+//
+// Chunks may be uncompressed, zlib or gzip; zstd and blosc when the build
+// has them (PATHVIEW_HAS_ZSTD, PATHVIEW_HAS_BLOSC). Arrays must be uint8
+// or uint16 in C order; sharded v3 arrays and filters are refused.
+//
+// Thread-safe after construction.
+class ZarrPyramid {
+public:
+    explicit ZarrPyramid(const std::string& path);
+
+    // Whether path is a directory holding Zarr group metadata, or one of
+    // those metadata files
+    static bool IsZarrPath(const std::string& path);
+
+    bool IsOpen() const { return !levels_.empty(); }
+    // Why the image could not be opened
+    const std::string& GetError() const { return error_; }
+    int32_t GetZarrFormat() const { return zarrFormat_; }
+    // Codec of the level 0 chunks ("none", "zlib", "gzip", "zstd", "blosc")
+    const char* GetCodecName() const;
+    // Group metadata file (.zattrs or zarr.json), fingerprinted for the slide
+    const std::string& GetMetadataPath() const { return metadataPath_; }
+
+    std::vector<LevelDimensions> GetLevels() const;
+    LevelDimensions GetChunkSize(int32_t level) const;
+
+    size_t GetChannelCount() const { return channelNames_.size(); }
+    // 8 or 16, the same for every channel and level
+    uint32_t GetChannelBits(size_t channel) const;
+    // From the omero channel labels, else "Channel N"
+    const std::string& GetChannelName(size_t channel) const { return channelNames_[channel]; }
+    // omero channel colour (0xRRGGBB), or NO_COLOR
+    uint32_t GetChannelColor(size_t channel) const { return channelColors_[channel]; }
+    static constexpr uint32_t NO_COLOR = 0xFFFFFFFFu;
+
+    // Level 0 pixel size in micrometres from the first dataset's scale
+    // transform, 0 if the axes carry no spatial unit
+    double GetPixelSizeX() const { return pixelSizeX_; }
+    double GetPixelSizeY() const { return pixelSizeY_; }
+
+    // Decode one channel of a region in level coordinates into width *
+    // height samples. Samples outside the level are 0. Returns false on any
+    // failure; the samples are then undefined.
+    bool ReadChannelRegion(int32_t level, size_t channel, int64_t x, int64_t y, int64_t width, int64_t height,
+                           uint16_t* samples) const;
+
+    size_t GetChunkReadCount() const { return chunkReadCount_.load(); }
+
+private:
+    enum class Codec { None, Zlib, Gzip, Zstd, Blosc };
+
+    struct Array {
+        std::string path;             // Array directory
+        std::vector<int64_t> shape;
+        std::vector<int64_t> chunks;
+        uint32_t bytesPerSample = 1;
+        bool bigEndian = false;
+        uint16_t fillValue = 0;
+        Codec codec = Codec::None;
+        std::string keyPrefix;        // "c/" for v3 default chunk keys
+        char separator = '.';
+    };
+
+    // Group metadata: the multiscale's axes, datasets and omero channels
+    bool OpenGroup(const std::string& root);
+    bool OpenArray(const std::string& path, Array& array);
+
+    // Stored bytes of one chunk decompressed into raw (chunk elements in
+    // C order); false if it exists but cannot be decoded. A missing chunk
+    // gives an empty raw.
+    bool ReadChunk(const Array& array, const std::vector<int64_t>& index, std::vector<uint8_t>& raw) const;
+    std::string ChunkPath(const Array& array, const std::vector<int64_t>& index) const;
+
+    std::string error_;
+    std::string metadataPath_;
+    int32_t zarrFormat_ = 2;
+    std::vector<Array> levels_;
+    // Axis positions in every array's dimensions, -1 if absent
+    int32_t axisX_ = -1;
+    int32_t axisY_ = -1;
+    int32_t axisC_ = -1;
+    std::vector<std::string> channelNames_;
+    std::vector<uint32_t> channelColors_;
+    double pixelSizeX_ = 0.0;
+    double pixelSizeY_ = 0.0;
+    uint64_t serial_ = 0;  // Tells this image's chunks apart in thread caches
+
+    mutable std::atomic<size_t> chunkReadCount_{0};
+};
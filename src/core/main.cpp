@@ -1,11 +1,362 @@
 #include "Application.h"
 #include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <optional>
 
-int main() {
+void print_usage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]\n"
+              << "\nOptions:\n"
+              << "  --decode-threads N   Tile decode worker threads (default: auto, hardware threads - 2)\n"
+              << "  --decode-autoscale   Grow/shrink the decode pool with the load backlog\n"
+              << "  --worker-priority P  Decode and read-ahead threads' OS priority: background\n"
+              << "                       (default: below the render thread) or normal\n"
+              << "  --reserve-render-core\n"
+              << "                       Keep decode threads off one core, left to the render\n"
+              << "                       thread (Linux, Windows)\n"
+              << "  --no-battery-throttle\n"
+              << "                       Keep prefetching at full rate on battery power\n"
+              << "  --disk-cache-mb MB   Persistent decoded-tile cache size (default: 2048, 0 disables)\n"
+              << "  --disk-cache-dir DIR Persistent tile cache location (default: per-user cache dir)\n"
+              << "  --annotation-dir DIR Where each slide's annotations and action cards are saved\n"
+              << "                       (default: per-user data dir; \"none\" keeps them in memory)\n"
+              << "  --session FILE       Where the last session is saved and restored from (default:\n"
+              << "                       per-user state dir; \"none\" starts empty and saves nothing)\n"
+              << "  --tile-cache-mb MB   In-memory tile cache size (default: 0, an eighth of RAM)\n"
+              << "  --compressed-cache-mb MB\n"
+              << "                       Compressed in-memory tier behind it (default: a quarter\n"
+              << "                       of the tile cache, 0 disables)\n"
+              << "  --tile-storage S     How the tile cache keeps opaque tiles: argb (default),\n"
+              << "                       rgb (3/4 the memory, exact) or yuv420 (3/8, lossy)\n"
+              << "  --huge-pages M       Tile buffers on 2 MB huge-page slabs: off (default),\n"
+              << "                       transparent (Linux THP) or explicit (reserved huge\n"
+              << "                       pages / Windows large pages, else transparent)\n"
+              << "  --tile-eviction P    Tile cache eviction: clock (default) or scan-resistant\n"
+              << "                       (fast flings through fine levels keep the tiles in use\n"
+              << "                       and favor coarse ones)\n"
+              << "  --pin-coarse-levels N\n"
+              << "                       Never evict each slide's N coarsest levels, the fallback\n"
+              << "                       drawn while finer tiles load (default: 0)\n"
+              << "  --direct-tiff        Decode SVS / tiled TIFF JPEG tiles directly instead of\n"
+              << "                       through OpenSlide (falls back to it when unsupported)\n"
+              << "  --gpu-jpeg           Also batch those decodes on the GPU (nvJPEG builds),\n"
+              << "                       implies --direct-tiff\n"
+              << "  --mmap-tiff          Memory-map the slide for direct reads (local disks),\n"
+              << "                       implies --direct-tiff\n"
+              << "  --texture-compression M\n"
+              << "                       Keep tile textures compressed on the GPU: none\n"
+              << "                       (default), bc7 (4x the tiles in VRAM, near lossless)\n"
+              << "                       or bc1 (8x, for navigation); OpenGL backend only\n"
+              << "  --continuous-render  Redraw every VSync instead of only when something changes\n"
+              << "  --level-selection M  Pyramid level choice: closest (default) or coarser\n"
+              << "                       (never sharper than the screen, linear filtering)\n"
+              << "  --motion-levels N    Draw up to N (0-2) levels coarser while panning fast,\n"
+              << "                       refining once the view settles (default 0: off)\n"
+              << "  --render-scale S[,M] Choose levels for S times the display's pixels (default\n"
+              << "                       1), M while moving (default S); 0.5 decodes a quarter\n"
+              << "  --record-trace FILE  Record every viewport change to FILE (saved on exit)\n"
+              << "  --replay-trace FILE  Replay a recorded trace once a slide is opened\n"
+              << "  --prefetch-model FILE\n"
+              << "                       Prefetch the next stops a model learned from recorded\n"
+              << "                       traces predicts (pathview-prefetch-model) once the view stops\n"
+              << "  --memory-budget-mb MB\n"
+              << "                       Shrink caches when accounted memory exceeds MB\n"
+              << "                       (default: 0, unlimited)\n"
+              << "  --tile-server-port N Serve the open slide as DeepZoom / IIIF tiles over HTTP\n"
+              << "                       (e.g. for OpenSeadragon) on port N (default: 0, off)\n"
+              << "  --tile-server-host HOST\n"
+              << "                       Address the tile server listens on (default: 127.0.0.1)\n"
+              << "  --ipc-max-clients N  Most IPC (agent) connections at once (default: 64)\n"
+              << "  --ipc-rate-limit N   Requests per second each normal-priority IPC session\n"
+              << "                       may send (default: 0, unlimited; background: 20)\n"
+              << "  --ipc-frame-budget-ms MS\n"
+              << "                       Time per frame for IPC requests; the rest wait for the\n"
+              << "                       next frame (default: 4, 0 for unlimited)\n"
+              << "  --ipc-socket PATH    Unix socket for IPC, next to the TCP port (default:\n"
+              << "                       <temp>/pathview-<pid>.sock; \"none\" for TCP only)\n"
+              << "  --headless           No window or UI, for batch servers: off-screen software\n"
+              << "                       rendering, driven over IPC / HTTP only\n"
+              << "  --view-size WxH      Headless view (snapshot) size (default: 1280x720)\n"
+              << "  --bench-trace FILE   Benchmark: open --bench-slide, replay the viewport trace\n"
+              << "                       FILE one recorded frame per frame, waiting at each stop\n"
+              << "                       until the view is sharp, write a JSON report of frame\n"
+              << "                       times, tiles and time to sharp, and quit (no session)\n"
+              << "  --bench-slide PATH   Slide to benchmark (default: synthetic://100000x80000)\n"
+              << "  --bench-polygons FILE\n"
+              << "                       Cell polygons to draw over it (e.g. from pathview-synth)\n"
+              << "  --bench-cache C      cold (default: disk cache off) or warm (replay once\n"
+              << "                       unmeasured first)\n"
+              << "  --bench-output FILE  Where the report goes (default: standard output)\n"
+              << "  --timings            Print the time to first frame phase by phase, and the\n"
+              << "                       startup work deferred past it\n"
+              << "  --help               Show this help message\n"
+              << "\nEnvironment:\n"
+              << "  PATHVIEW_DECODE_THREADS   Same as --decode-threads (the flag wins)\n"
+              << "  SDL_VIDEODRIVER, SDL_RENDER_DRIVER\n"
+              << "                            Headless drivers (default: offscreen, software)\n"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
     std::cout << "PathView - Digital Pathology Slide Viewer" << std::endl;
     std::cout << "===========================================" << std::endl;
 
+    // Parse command line arguments
+    size_t decodeThreads = 0;  // 0 means auto-size from hardware
+    bool decodeAutoScale = false;
+    bool workerBackgroundPriority = true;
+    size_t reservedRenderCores = 0;
+    bool batteryThrottling = true;
+    size_t diskCacheMB = DiskTileCache::DEFAULT_MAX_BYTES / (1024 * 1024);
+    std::string diskCacheDir;  // Empty means platform default
+    std::string annotationDir;  // Likewise
+    std::string sessionPath;    // Likewise
+    size_t tileCacheMB = 0;    // 0 means auto-size from physical memory
+    int compressedCacheMB = -1;  // -1 means a quarter of the tile cache
+    TileEvictionPolicy tileEviction = TileEvictionPolicy::Clock;
+    TileStorage tileStorage = TileStorage::Argb;
+    HugePageMode hugePages = HugePageMode::Off;
+    int pinnedCoarseLevels = 0;
+    bool directTiff = false;
+    bool gpuJpeg = false;
+    bool mmapTiff = false;
+    TextureCompression textureCompression = TextureCompression::None;
+    bool continuousRender = false;
+    LevelSelection levelSelection = LevelSelection::Closest;
+    int motionLevels = 0;
+    double renderScale = 1.0;
+    double movingRenderScale = 0.0;  // 0 means the still scale
+    std::string recordTracePath;
+    std::string replayTracePath;
+    std::string prefetchModelPath;
+    size_t memoryBudgetMB = 0;  // 0 means unlimited
+    int tileServerPort = 0;     // 0 means no tile server
+    std::string tileServerHost = "127.0.0.1";
+    size_t ipcMaxClients = 0;   // 0 means the IPC server's default
+    double ipcRateLimit = -1.0;       // Below 0 means the IPC server's default
+    double ipcFrameBudgetMs = -1.0;   // Likewise
+    std::optional<std::string> ipcSocketPath;  // Unset: the server's default
+    bool headless = false;
+    int viewWidth = 1280;
+    int viewHeight = 720;
+    FrameBenchmarkOptions benchmark;  // Empty tracePath: no benchmark
+    bool startupTimings = false;
+
+    if (const char* env = std::getenv("PATHVIEW_DECODE_THREADS")) {
+        decodeThreads = static_cast<size_t>(std::max(0, std::atoi(env)));
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--decode-threads" && i + 1 < argc) {
+            std::string value = argv[++i];
+            decodeThreads = value == "auto" ? 0 : static_cast<size_t>(std::max(0, std::atoi(value.c_str())));
+        } else if (arg == "--decode-autoscale") {
+            decodeAutoScale = true;
+        } else if (arg == "--worker-priority" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value != "background" && value != "normal") {
+                std::cerr << "Unknown worker priority: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            workerBackgroundPriority = value == "background";
+        } else if (arg == "--reserve-render-core") {
+            reservedRenderCores = 1;
+        } else if (arg == "--no-battery-throttle") {
+            batteryThrottling = false;
+        } else if (arg == "--disk-cache-mb" && i + 1 < argc) {
+            diskCacheMB = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--disk-cache-dir" && i + 1 < argc) {
+            diskCacheDir = argv[++i];
+        } else if (arg == "--annotation-dir" && i + 1 < argc) {
+            annotationDir = argv[++i];
+        } else if (arg == "--session" && i + 1 < argc) {
+            sessionPath = argv[++i];
+        } else if (arg == "--tile-cache-mb" && i + 1 < argc) {
+            tileCacheMB = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--compressed-cache-mb" && i + 1 < argc) {
+            compressedCacheMB = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--tile-storage" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::optional<TileStorage> storage = TileCache::ParseStorage(value);
+            if (!storage) {
+                std::cerr << "Unknown tile storage: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            tileStorage = *storage;
+        } else if (arg == "--huge-pages" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::optional<HugePageMode> mode = TileBufferPool::ParseHugePageMode(value);
+            if (!mode) {
+                std::cerr << "Unknown huge page mode: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            hugePages = *mode;
+        } else if (arg == "--tile-eviction" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::optional<TileEvictionPolicy> policy = TileCache::ParseEvictionPolicy(value);
+            if (!policy) {
+                std::cerr << "Unknown tile eviction policy: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            tileEviction = *policy;
+        } else if (arg == "--pin-coarse-levels" && i + 1 < argc) {
+            pinnedCoarseLevels = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--direct-tiff") {
+            directTiff = true;
+        } else if (arg == "--gpu-jpeg") {
+            gpuJpeg = true;
+        } else if (arg == "--mmap-tiff") {
+            mmapTiff = true;
+        } else if (arg == "--texture-compression" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::optional<TextureCompression> compression = ParseTextureCompression(value);
+            if (!compression) {
+                std::cerr << "Unknown texture compression: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            textureCompression = *compression;
+        } else if (arg == "--continuous-render") {
+            continuousRender = true;
+        } else if (arg == "--level-selection" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "closest") {
+                levelSelection = LevelSelection::Closest;
+            } else if (value == "coarser") {
+                levelSelection = LevelSelection::CoarserOrEqual;
+            } else {
+                std::cerr << "Unknown level selection: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--motion-levels" && i + 1 < argc) {
+            motionLevels = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--render-scale" && i + 1 < argc) {
+            std::string value = argv[++i];
+            size_t comma = value.find(',');
+            renderScale = std::atof(value.substr(0, comma).c_str());
+            movingRenderScale = comma == std::string::npos ? 0.0 : std::atof(value.substr(comma + 1).c_str());
+            if (renderScale <= 0.0 || (comma != std::string::npos && movingRenderScale <= 0.0)) {
+                std::cerr << "Invalid render scale: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--record-trace" && i + 1 < argc) {
+            recordTracePath = argv[++i];
+        } else if (arg == "--replay-trace" && i + 1 < argc) {
+            replayTracePath = argv[++i];
+        } else if (arg == "--prefetch-model" && i + 1 < argc) {
+            prefetchModelPath = argv[++i];
+        } else if (arg == "--memory-budget-mb" && i + 1 < argc) {
+            memoryBudgetMB = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--tile-server-port" && i + 1 < argc) {
+            tileServerPort = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--tile-server-host" && i + 1 < argc) {
+            tileServerHost = argv[++i];
+        } else if (arg == "--ipc-max-clients" && i + 1 < argc) {
+            ipcMaxClients = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--ipc-rate-limit" && i + 1 < argc) {
+            ipcRateLimit = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--ipc-frame-budget-ms" && i + 1 < argc) {
+            ipcFrameBudgetMs = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--ipc-socket" && i + 1 < argc) {
+            std::string path = argv[++i];
+            ipcSocketPath = path == "none" ? std::string() : path;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--view-size" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (std::sscanf(value.c_str(), "%dx%d", &viewWidth, &viewHeight) != 2 ||
+                viewWidth <= 0 || viewHeight <= 0) {
+                std::cerr << "Invalid view size: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--bench-trace" && i + 1 < argc) {
+            benchmark.tracePath = argv[++i];
+        } else if (arg == "--bench-slide" && i + 1 < argc) {
+            benchmark.slidePath = argv[++i];
+        } else if (arg == "--bench-polygons" && i + 1 < argc) {
+            benchmark.polygonPath = argv[++i];
+        } else if (arg == "--bench-cache" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value != "cold" && value != "warm") {
+                std::cerr << "Unknown benchmark cache: " << value << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            benchmark.warmCache = value == "warm";
+        } else if (arg == "--bench-output" && i + 1 < argc) {
+            benchmark.outputPath = argv[++i];
+        } else if (arg == "--timings") {
+            startupTimings = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // A benchmark neither reads nor writes the user's session and
+    // annotations, and a cold one finds no tiles left on disk by earlier runs
+    if (!benchmark.tracePath.empty()) {
+        sessionPath = "none";
+        annotationDir = "none";
+        if (!benchmark.warmCache) {
+            diskCacheMB = 0;
+        }
+    }
+
     Application app;
+    app.SetDecodeThreads(decodeThreads, decodeAutoScale);
+    app.SetWorkerScheduling(workerBackgroundPriority, reservedRenderCores);
+    app.SetBatteryThrottling(batteryThrottling);
+    app.SetDiskCache(diskCacheDir, diskCacheMB * 1024 * 1024);
+    app.SetAnnotationDirectory(annotationDir);
+    app.SetSessionPath(sessionPath);
+    app.SetTileCacheBudget(tileCacheMB * 1024 * 1024);
+    if (compressedCacheMB >= 0) {
+        app.SetCompressedCacheBudget(static_cast<size_t>(compressedCacheMB) * 1024 * 1024);
+    }
+    app.SetTileEvictionPolicy(tileEviction, pinnedCoarseLevels);
+    app.SetTileStorage(tileStorage);
+    app.SetHugePages(hugePages);
+    app.SetDirectTiffRead(directTiff);
+    app.SetGpuJpegDecode(gpuJpeg);
+    app.SetTiffMemoryMap(mmapTiff);
+    app.SetTextureCompression(textureCompression);
+    app.SetOnDemandRendering(!continuousRender);
+    app.SetLevelSelection(levelSelection);
+    app.SetMotionLevels(motionLevels);
+    app.SetRenderScale(renderScale, movingRenderScale > 0.0 ? movingRenderScale : renderScale);
+    app.SetTraceRecording(recordTracePath);
+    app.SetTraceReplay(replayTracePath);
+    app.SetPrefetchModel(prefetchModelPath);
+    app.SetMemoryBudget(memoryBudgetMB * 1024 * 1024);
+    app.SetTileServer(tileServerHost, tileServerPort);
+    app.SetIpcMaxClients(ipcMaxClients);
+    app.SetIpcScheduling(ipcRateLimit, ipcFrameBudgetMs);
+    if (ipcSocketPath) {
+        app.SetIpcSocketPath(*ipcSocketPath);
+    }
+    if (headless) {
+        app.SetHeadless(true, viewWidth, viewHeight);
+    }
+    if (!benchmark.tracePath.empty()) {
+        app.SetBenchmark(benchmark);
+    }
+    app.SetStartupTimings(startupTimings);
 
     if (!app.Initialize()) {
         std::cerr << "Failed to initialize application" << std::endl;
@@ -18,5 +369,5 @@ int main() {
     std::cout << "Application shutting down..." << std::endl;
     app.Shutdown();
 
-    return 0;
+    return app.HasBenchmarkFailed() ? 1 : 0;
 }
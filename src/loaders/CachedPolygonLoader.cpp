@@ -0,0 +1,24 @@
+#include "CachedPolygonLoader.h"
+#include "PolygonCache.h"
+#include "Log.h"
+
+bool CachedPolygonLoader::Load(const std::string& filepath,
+                               PolygonStore& outPolygons,
+                               std::map<int, SDL_Color>& outClassColors,
+                               std::map<int, std::string>& outClassNames) {
+    outPolygons.Clear();
+    outClassColors.clear();
+    outClassNames.clear();
+    index_.reset();
+    tissueMap_.reset();
+
+    if (!PolygonCache::Read(filepath, outPolygons, index_, outClassColors, outClassNames, tissueMap_)) {
+        PATHVIEW_LOG_ERROR("Failed to read polygon cache: " << PolygonCache::SidecarPath(filepath));
+        return false;
+    }
+
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices) from cache");
+    PATHVIEW_LOG_INFO("==================================\n");
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PolygonLoader.h"
+#include "PolygonIndex.h"
+#include "TissueMap.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <SDL2/SDL.h>
+
+/**
+ * Binary Polygon Cache Loader
+ *
+ * Loads a polygon file from the sidecar written after its first load
+ * (see PolygonCache), including its triangulations and spatial index,
+ * instead of parsing the file itself. PolygonLoaderFactory picks it while
+ * the sidecar is fresh.
+ */
+class CachedPolygonLoader: public PolygonLoader {
+public:
+    /**
+     * Load polygons from the cache of a polygon file
+     * @param filepath Path to the source polygon file (not the sidecar)
+     * @param outPolygons Output polygon store
+     * @param outClassColors Output map of class ID to color
+     * @param outClassNames Output map of class ID to class name
+     * @return true if successful, false otherwise
+     */
+    bool Load(const std::string& filepath,
+              PolygonStore& outPolygons,
+              std::map<int, SDL_Color>& outClassColors,
+              std::map<int, std::string>& outClassNames) override;
+
+    /**
+     * Spatial index read by the last Load(), if the cache held one
+     */
+    std::unique_ptr<PolygonIndex> TakeSpatialIndex() override { return std::move(index_); }
+
+    /**
+     * Tissue map read by the last Load(), if the cache held one
+     */
+    std::unique_ptr<TissueMap> TakeTissueMap() override { return std::move(tissueMap_); }
+
+private:
+    std::unique_ptr<PolygonIndex> index_;
+    std::unique_ptr<TissueMap> tissueMap_;
+};
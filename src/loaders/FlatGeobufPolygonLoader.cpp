@@ -0,0 +1,176 @@
+#include "FlatGeobufPolygonLoader.h"
+#include "Log.h"
+#include <atomic>
+#include <chrono>
+
+namespace {
+
+// Features per Load() worker at minimum: each is small, unlike a tile
+constexpr size_t MIN_FEATURES_PER_WORKER = 4096;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+bool FlatGeobufPolygonLoader::Open(const std::string& filepath,
+                                   std::map<int, SDL_Color>& outClassColors,
+                                   std::map<int, std::string>& outClassNames) {
+    auto openStart = std::chrono::steady_clock::now();
+    featureOffsets_.clear();
+    cellTypes_.Clear();
+    typeClasses_.clear();
+    outClassColors.clear();
+    outClassNames.clear();
+    if (!reader_.Open(filepath)) {
+        PATHVIEW_LOG_ERROR("Failed to open FlatGeobuf file: " << reader_.GetError());
+        return false;
+    }
+    if (!reader_.ScanFeatures(featureOffsets_)) {
+        PATHVIEW_LOG_ERROR("Truncated FlatGeobuf features in " << filepath);
+        return false;
+    }
+    PATHVIEW_LOG_INFO("Features: " << featureOffsets_.size()
+                      << (reader_.HasIndex() ? " (indexed, node size " + std::to_string(reader_.GetIndexNodeSize()) + ")"
+                                             : " (no index)"));
+
+    // One pass over the class column only, for the class table
+    std::string className;
+    if (reader_.GetClassColumn() >= 0) {
+        PATHVIEW_LOG_INFO("Class column: " << reader_.GetColumns()[reader_.GetClassColumn()].name);
+        for (uint64_t offset : featureOffsets_) {
+            if (!reader_.ReadClassName(offset, className)) {
+                PATHVIEW_LOG_ERROR("Malformed FlatGeobuf feature at " << offset << " in " << filepath);
+                return false;
+            }
+            cellTypes_.Intern(className);
+        }
+    }
+    cellTypes_.Freeze();
+    PATHVIEW_LOG_INFO("Unique cell types: " << cellTypes_.Size());
+
+    std::map<std::string, int> classMapping;
+    typeClasses_ = BuildClassMapping(cellTypes_, classMapping);
+    for (const auto& pair : classMapping) {
+        outClassNames[pair.second] = pair.first;
+        PATHVIEW_LOG_INFO("  " << pair.first << " -> Class " << pair.second);
+    }
+    GenerateColorsFromClassNames(classMapping, outClassColors);
+    PATHVIEW_LOG_INFO("Opened in " << MillisecondsSince(openStart) << " ms");
+    return true;
+}
+
+bool FlatGeobufPolygonLoader::ConvertFeature(uint64_t offset, FlatGeobufReader::Feature& scratch,
+                                             PolygonStore& out) const {
+    if (!reader_.ReadFeature(offset, scratch)) {
+        return false;
+    }
+    const uint32_t type = cellTypes_.Find(scratch.className);
+    const int classId = type != ClassNameTable::NOT_FOUND ? typeClasses_[type] : 0;
+
+    uint32_t begin = 0;
+    for (uint32_t end : scratch.ringEnds) {
+        if (end - begin >= 3) {
+            out.BeginPolygon(classId);
+            for (uint32_t k = begin; k < end; ++k) {
+                out.AddVertex(scratch.xy[2 * k], scratch.xy[2 * k + 1]);
+            }
+            const uint32_t index = out.EndPolygon();
+            if (scratch.hasConfidence) {
+                out.SetConfidence(index, scratch.confidence);
+            }
+        }
+        begin = end;
+    }
+    return true;
+}
+
+bool FlatGeobufPolygonLoader::Load(const std::string& filepath,
+                                   PolygonStore& outPolygons,
+                                   std::map<int, SDL_Color>& outClassColors,
+                                   std::map<int, std::string>& outClassNames) {
+    if (!Open(filepath, outClassColors, outClassNames)) {
+        return false;
+    }
+
+    outPolygons.Clear();
+    auto convertStart = std::chrono::steady_clock::now();
+    const size_t featureCount = featureOffsets_.size();
+    std::atomic<bool> failed{false};
+    int workerCount = ConvertInParallel(featureCount, featureCount, 0, [&](size_t begin, size_t end, PolygonStore& out) {
+        FlatGeobufReader::Feature scratch;
+        for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+            if (!ConvertFeature(featureOffsets_[i], scratch, out)) {
+                PATHVIEW_LOG_ERROR("Malformed FlatGeobuf feature at " << featureOffsets_[i] << " in " << filepath);
+                failed = true;
+            }
+        }
+    }, outPolygons, MIN_FEATURES_PER_WORKER);
+    if (failed) {
+        outPolygons.Clear();
+        return false;
+    }
+
+    PATHVIEW_LOG_INFO("Converted " << featureCount << " features on " << workerCount << " thread(s) in "
+                      << MillisecondsSince(convertStart) << " ms");
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices)");
+    PATHVIEW_LOG_INFO("==================================\n");
+    return true;
+}
+
+bool FlatGeobufPolygonLoader::LoadStreaming(const std::string& filepath,
+                                            const PolygonStreamCallbacks& callbacks) {
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    if (!Open(filepath, classColors, classNames)) {
+        return false;
+    }
+    std::vector<FlatGeobufReader::FeatureGroup> groups;
+    if (!reader_.GetFeatureGroups(groups)) {
+        // No index to stream by
+        return PolygonLoader::LoadStreaming(filepath, callbacks);
+    }
+    if (callbacks.onClasses) {
+        callbacks.onClasses(classColors, classNames);
+    }
+
+    std::vector<Rect> groupBounds;
+    groupBounds.reserve(groups.size());
+    for (const auto& group : groups) {
+        groupBounds.push_back(group.bounds);
+    }
+
+    auto convertStart = std::chrono::steady_clock::now();
+    FlatGeobufReader::Feature scratch;
+    size_t failedFeatures = 0;
+    bool complete = StreamTiles(groupBounds, [&](size_t group, PolygonStore& out) {
+        for (uint64_t leaf = groups[group].firstLeaf; leaf < groups[group].leafEnd; ++leaf) {
+            if (!ConvertFeature(reader_.GetLeafOffset(leaf), scratch, out)) {
+                ++failedFeatures;
+            }
+        }
+    }, callbacks);
+    if (failedFeatures > 0) {
+        PATHVIEW_LOG_ERROR("Failed to read " << failedFeatures << " feature(s) of " << filepath);
+    }
+
+    PATHVIEW_LOG_INFO((complete ? "Streamed " : "Cancelled streaming ") << groups.size()
+                      << " index nodes after " << MillisecondsSince(convertStart) << " ms");
+    return complete && failedFeatures == 0;
+}
+
+bool FlatGeobufPolygonLoader::QueryRegion(const Rect& region, PolygonStore& out) const {
+    std::vector<uint64_t> offsets;
+    if (!reader_.Query(region, offsets)) {
+        return false;
+    }
+    FlatGeobufReader::Feature scratch;
+    for (uint64_t offset : offsets) {
+        if (!ConvertFeature(offset, scratch, out)) {
+            return false;
+        }
+    }
+    return true;
+}
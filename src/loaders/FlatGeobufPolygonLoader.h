@@ -0,0 +1,83 @@
+#pragma once
+
+#include "FlatGeobufReader.h"
+#include "PolygonLoader.h"
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+/**
+ * FlatGeobuf Polygon File Loader
+ *
+ * Loads polygon features from FlatGeobuf (.fgb) files through
+ * FlatGeobufReader, which decodes features in place from the mapped file.
+ * Load() converts every feature on worker threads; LoadStreaming() walks
+ * the file's own packed R-tree, one group of neighbouring features per
+ * source tile, so the features nearest the focus arrive first.
+ *
+ * After Open(), QueryRegion() decodes only the features the file's index
+ * puts in a region, leaving the rest on disk.
+ *
+ * Each polygon's exterior ring becomes one polygon; the class column
+ * (see FlatGeobufReader::GetClassColumn) is mapped to integer class IDs.
+ */
+class FlatGeobufPolygonLoader: public PolygonLoader {
+public:
+    /**
+     * Load polygons from FlatGeobuf file
+     * @param filepath Path to .fgb file
+     * @param outPolygons Output polygon store
+     * @param outClassColors Output map of class ID to color
+     * @param outClassNames Output map of class ID to class name
+     * @return true if successful, false otherwise
+     */
+    bool Load(const std::string& filepath,
+              PolygonStore& outPolygons,
+              std::map<int, SDL_Color>& outClassColors,
+              std::map<int, std::string>& outClassNames) override;
+
+    /**
+     * Stream polygons from FlatGeobuf file, STREAM_BATCH_TILES index nodes
+     * at a time around the focus (the whole file in one batch if it has no
+     * index)
+     * @param filepath Path to .fgb file
+     * @param callbacks Receivers of the class tables and batches
+     * @return true if the whole file was loaded, false on error or cancel
+     */
+    bool LoadStreaming(const std::string& filepath,
+                       const PolygonStreamCallbacks& callbacks) override;
+
+    /**
+     * Open a file for region queries: its header is read and its class
+     * column values gathered, but no geometry is decoded
+     * @param filepath Path to .fgb file
+     * @param outClassColors Output map of class ID to color
+     * @param outClassNames Output map of class ID to class name
+     * @return true if successful, false otherwise
+     */
+    bool Open(const std::string& filepath,
+              std::map<int, SDL_Color>& outClassColors,
+              std::map<int, std::string>& outClassNames);
+
+    /**
+     * Append the polygons of the features whose boxes meet a region to
+     * out, decoding only those (every feature if the file has no index;
+     * thread-safe after Open())
+     * @return false on a malformed index or feature
+     */
+    bool QueryRegion(const Rect& region, PolygonStore& out) const;
+
+    const FlatGeobufReader& GetReader() const { return reader_; }
+
+private:
+    // Append one feature's polygons to out, decoding into scratch
+    bool ConvertFeature(uint64_t offset, FlatGeobufReader::Feature& scratch, PolygonStore& out) const;
+
+    FlatGeobufReader reader_;
+    std::vector<uint64_t> featureOffsets_;  // File order, from Open()
+    ClassNameTable cellTypes_;      // Frozen by Open()
+    std::vector<int> typeClasses_;  // Class ID of each of cellTypes_
+};
@@ -0,0 +1,487 @@
+#include "FlatGeobufReader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t MAGIC[] = {'f', 'g', 'b', 3, 'f', 'g', 'b'};
+constexpr size_t MAGIC_BYTES = 8;  // The last is the patch version
+
+// GeometryType
+constexpr uint8_t GEOMETRY_POLYGON = 3;
+constexpr uint8_t GEOMETRY_MULTIPOLYGON = 6;
+
+// Field numbers (declaration order in header.fbs and feature.fbs)
+constexpr int HEADER_GEOMETRY_TYPE = 2;
+constexpr int HEADER_COLUMNS = 7;
+constexpr int HEADER_FEATURES_COUNT = 8;
+constexpr int HEADER_INDEX_NODE_SIZE = 9;
+constexpr int COLUMN_NAME = 0;
+constexpr int COLUMN_TYPE = 1;
+constexpr int FEATURE_GEOMETRY = 0;
+constexpr int FEATURE_PROPERTIES = 1;
+constexpr int GEOMETRY_ENDS = 0;
+constexpr int GEOMETRY_XY = 1;
+constexpr int GEOMETRY_TYPE = 6;
+constexpr int GEOMETRY_PARTS = 7;
+
+constexpr uint16_t DEFAULT_NODE_SIZE = 16;
+
+template <typename T>
+T Load(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// A FlatBuffers table within one buffer, every read bounds-checked
+class FlatTable {
+public:
+    FlatTable() = default;
+
+    // The table at position, or false if it does not fit the buffer
+    static bool At(const uint8_t* data, size_t size, size_t position, FlatTable& out) {
+        if (position + 4 > size) {
+            return false;
+        }
+        int64_t vtable = static_cast<int64_t>(position) - Load<int32_t>(data + position);
+        if (vtable < 0 || static_cast<uint64_t>(vtable) + 4 > size) {
+            return false;
+        }
+        uint16_t vtableSize = Load<uint16_t>(data + vtable);
+        uint16_t tableSize = Load<uint16_t>(data + vtable + 2);
+        if (vtableSize < 4 || static_cast<uint64_t>(vtable) + vtableSize > size || position + tableSize > size) {
+            return false;
+        }
+        out = FlatTable(data, size, position, static_cast<size_t>(vtable), vtableSize);
+        return true;
+    }
+
+    static bool Root(const uint8_t* data, size_t size, FlatTable& out) {
+        return size >= 4 && At(data, size, Load<uint32_t>(data), out);
+    }
+
+    template <typename T>
+    T Scalar(int field, T defaultValue) const {
+        uint16_t offset = FieldOffset(field);
+        if (offset == 0 || table_ + offset + sizeof(T) > size_) {
+            return defaultValue;
+        }
+        return Load<T>(data_ + table_ + offset);
+    }
+
+    // Element count and first element of a vector field; false if absent
+    // or past the buffer
+    bool Vector(int field, size_t elementSize, const uint8_t*& outData, uint32_t& outCount) const {
+        size_t position;
+        if (!Target(field, position)) {
+            return false;
+        }
+        outCount = Load<uint32_t>(data_ + position);
+        if (position + 4 + static_cast<uint64_t>(outCount) * elementSize > size_) {
+            return false;
+        }
+        outData = data_ + position + 4;
+        return true;
+    }
+
+    bool String(int field, std::string& out) const {
+        const uint8_t* chars;
+        uint32_t length;
+        if (!Vector(field, 1, chars, length)) {
+            return false;
+        }
+        out.assign(reinterpret_cast<const char*>(chars), length);
+        return true;
+    }
+
+    bool Table(int field, FlatTable& out) const {
+        size_t position;
+        return Target(field, position) && At(data_, size_, position, out);
+    }
+
+    // Element i of a vector of tables from Vector(field, 4, ...)
+    bool TableAt(const uint8_t* elements, uint32_t i, FlatTable& out) const {
+        const uint8_t* element = elements + 4 * static_cast<size_t>(i);
+        size_t position = static_cast<size_t>(element - data_) + Load<uint32_t>(element);
+        return At(data_, size_, position, out);
+    }
+
+private:
+    FlatTable(const uint8_t* data, size_t size, size_t table, size_t vtable, uint16_t vtableSize)
+        : data_(data), size_(size), table_(table), vtable_(vtable), vtableSize_(vtableSize) {}
+
+    // Offset of a field within the table, 0 if absent
+    uint16_t FieldOffset(int field) const {
+        size_t entry = 4 + 2 * static_cast<size_t>(field);
+        return entry + 2 <= vtableSize_ ? Load<uint16_t>(data_ + vtable_ + entry) : 0;
+    }
+
+    // Where an offset field points
+    bool Target(int field, size_t& outPosition) const {
+        uint16_t offset = FieldOffset(field);
+        if (offset == 0 || table_ + offset + 4 > size_) {
+            return false;
+        }
+        outPosition = table_ + offset + Load<uint32_t>(data_ + table_ + offset);
+        return outPosition + 4 <= size_;
+    }
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t table_ = 0;
+    size_t vtable_ = 0;
+    uint16_t vtableSize_ = 0;
+};
+
+// Append a polygon geometry's exterior ring to out
+bool AppendExteriorRing(const FlatTable& geometry, FlatGeobufReader::Feature& out) {
+    const uint8_t* xy;
+    uint32_t doubles;
+    if (!geometry.Vector(GEOMETRY_XY, 8, xy, doubles)) {
+        return true;  // Empty polygon
+    }
+    uint32_t points = doubles / 2;
+    const uint8_t* ends;
+    uint32_t endCount;
+    if (geometry.Vector(GEOMETRY_ENDS, 4, ends, endCount) && endCount > 0) {
+        uint32_t exteriorEnd = Load<uint32_t>(ends);
+        if (exteriorEnd > points) {
+            return false;
+        }
+        points = exteriorEnd;
+    }
+    // Rings repeat their first point at the end; PolygonStore closes them
+    if (points >= 2 && std::memcmp(xy, xy + 16 * (static_cast<size_t>(points) - 1), 16) == 0) {
+        --points;
+    }
+    if (points == 0) {
+        return true;
+    }
+    size_t start = out.xy.size();
+    out.xy.resize(start + 2 * static_cast<size_t>(points));
+    std::memcpy(out.xy.data() + start, xy, 16 * static_cast<size_t>(points));
+    out.ringEnds.push_back(static_cast<uint32_t>(out.xy.size() / 2));
+    return true;
+}
+
+// Bytes of a fixed-size column value; 0 for the length-prefixed types
+size_t FixedValueBytes(FlatGeobufReader::ColumnType type) {
+    using ColumnType = FlatGeobufReader::ColumnType;
+    switch (type) {
+    case ColumnType::Byte: case ColumnType::UByte: case ColumnType::Bool: return 1;
+    case ColumnType::Short: case ColumnType::UShort: return 2;
+    case ColumnType::Int: case ColumnType::UInt: case ColumnType::Float: return 4;
+    case ColumnType::Long: case ColumnType::ULong: case ColumnType::Double: return 8;
+    default: return 0;
+    }
+}
+
+// A column value as class name text
+std::string ValueText(FlatGeobufReader::ColumnType type, const uint8_t* value, size_t size) {
+    using ColumnType = FlatGeobufReader::ColumnType;
+    switch (type) {
+    case ColumnType::Byte: return std::to_string(Load<int8_t>(value));
+    case ColumnType::UByte: return std::to_string(Load<uint8_t>(value));
+    case ColumnType::Bool: return value[0] ? "true" : "false";
+    case ColumnType::Short: return std::to_string(Load<int16_t>(value));
+    case ColumnType::UShort: return std::to_string(Load<uint16_t>(value));
+    case ColumnType::Int: return std::to_string(Load<int32_t>(value));
+    case ColumnType::UInt: return std::to_string(Load<uint32_t>(value));
+    case ColumnType::Long: return std::to_string(Load<int64_t>(value));
+    case ColumnType::ULong: return std::to_string(Load<uint64_t>(value));
+    case ColumnType::Float: return std::to_string(Load<float>(value));
+    case ColumnType::Double: return std::to_string(Load<double>(value));
+    default: return std::string(reinterpret_cast<const char*>(value), size);
+    }
+}
+
+std::string Lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+}  // namespace
+
+bool FlatGeobufReader::Open(const std::string& filepath) {
+    *this = FlatGeobufReader();
+    file_ = std::make_unique<MappedFile>(filepath);
+    const uint8_t* data = file_->Data();
+    const uint64_t size = file_->Size();
+    if (!data || size < MAGIC_BYTES + 4 || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        error_ = "Not a FlatGeobuf version 3 file: " + filepath;
+        return false;
+    }
+
+    uint32_t headerSize = Load<uint32_t>(data + MAGIC_BYTES);
+    FlatTable header;
+    if (MAGIC_BYTES + 4 + static_cast<uint64_t>(headerSize) > size ||
+        !FlatTable::Root(data + MAGIC_BYTES + 4, headerSize, header)) {
+        error_ = "Malformed FlatGeobuf header";
+        return false;
+    }
+
+    geometryType_ = header.Scalar<uint8_t>(HEADER_GEOMETRY_TYPE, 0);
+    featureCount_ = header.Scalar<uint64_t>(HEADER_FEATURES_COUNT, 0);
+    nodeSize_ = header.Scalar<uint16_t>(HEADER_INDEX_NODE_SIZE, DEFAULT_NODE_SIZE);
+
+    const uint8_t* columns;
+    uint32_t columnCount;
+    if (header.Vector(HEADER_COLUMNS, 4, columns, columnCount)) {
+        for (uint32_t i = 0; i < columnCount; ++i) {
+            FlatTable column;
+            if (!header.TableAt(columns, i, column)) {
+                error_ = "Malformed FlatGeobuf column";
+                return false;
+            }
+            Column entry;
+            column.String(COLUMN_NAME, entry.name);
+            entry.type = static_cast<ColumnType>(column.Scalar<uint8_t>(COLUMN_TYPE, 0));
+            columns_.push_back(std::move(entry));
+        }
+    }
+
+    // Class and confidence columns by name
+    static const char* const CLASS_NAMES[] = {"class", "cell_type", "classification", "type", "label", "name"};
+    for (const char* name : CLASS_NAMES) {
+        for (size_t i = 0; i < columns_.size() && classColumn_ < 0; ++i) {
+            if (Lowercase(columns_[i].name) == name) {
+                classColumn_ = static_cast<int>(i);
+            }
+        }
+    }
+    for (size_t i = 0; i < columns_.size() && classColumn_ < 0; ++i) {
+        if (columns_[i].type == ColumnType::String) {
+            classColumn_ = static_cast<int>(i);
+        }
+    }
+    for (size_t i = 0; i < columns_.size() && confidenceColumn_ < 0; ++i) {
+        std::string name = Lowercase(columns_[i].name);
+        bool number = columns_[i].type == ColumnType::Float || columns_[i].type == ColumnType::Double;
+        if (number && (name == "confidence" || name == "score" || name == "probability")) {
+            confidenceColumn_ = static_cast<int>(i);
+        }
+    }
+
+    // The packed R-tree: level sizes bottom-up, stored root first
+    indexOffset_ = MAGIC_BYTES + 4 + static_cast<uint64_t>(headerSize);
+    if (nodeSize_ >= 2 && featureCount_ > 0) {
+        // The count is the file's word: bound the tree by the bytes left
+        // before sizing anything, so nodeCount_ * NODE_ITEM_BYTES can't wrap
+        const uint64_t maxNodes = (size - indexOffset_) / NODE_ITEM_BYTES;
+        if (featureCount_ > maxNodes) {
+            error_ = "FlatGeobuf index runs past the end of the file";
+            return false;
+        }
+        std::vector<uint64_t> levelNodes = {featureCount_};
+        uint64_t n = featureCount_;
+        nodeCount_ = n;
+        do {
+            n = (n + nodeSize_ - 1) / nodeSize_;
+            levelNodes.push_back(n);
+            if (n > maxNodes - nodeCount_) {
+                error_ = "FlatGeobuf index runs past the end of the file";
+                return false;
+            }
+            nodeCount_ += n;
+        } while (n != 1);
+        uint64_t end = nodeCount_;
+        for (uint64_t nodes : levelNodes) {
+            levels_.emplace_back(end - nodes, end);
+            end -= nodes;
+        }
+        indexSize_ = nodeCount_ * NODE_ITEM_BYTES;
+    }
+    featuresOffset_ = indexOffset_ + indexSize_;
+    if (featuresOffset_ > size) {
+        error_ = "FlatGeobuf index runs past the end of the file";
+        return false;
+    }
+    return true;
+}
+
+FlatGeobufReader::NodeItem FlatGeobufReader::ReadNode(uint64_t node) const {
+    const uint8_t* p = file_->Data() + indexOffset_ + node * NODE_ITEM_BYTES;
+    return {Load<double>(p), Load<double>(p + 8), Load<double>(p + 16), Load<double>(p + 24), Load<uint64_t>(p + 32)};
+}
+
+bool FlatGeobufReader::ScanFeatures(std::vector<uint64_t>& outOffsets) const {
+    outOffsets.clear();
+    const uint64_t size = file_->Size() - featuresOffset_;
+    // Each feature takes at least its 4-byte size, whatever the header claims
+    outOffsets.reserve(std::min<uint64_t>(featureCount_, size / 4));
+    const uint8_t* features = file_->Data() + featuresOffset_;
+    uint64_t offset = 0;
+    while (offset + 4 <= size) {
+        uint64_t next = offset + 4 + Load<uint32_t>(features + offset);
+        if (next > size) {
+            return false;
+        }
+        outOffsets.push_back(offset);
+        offset = next;
+    }
+    return offset == size;
+}
+
+bool FlatGeobufReader::Query(const Rect& region, std::vector<uint64_t>& outOffsets) const {
+    if (!HasIndex()) {
+        // Without a tree every feature is a candidate
+        return ScanFeatures(outOffsets);
+    }
+    outOffsets.clear();
+
+    // Pending node groups: first node and level
+    std::vector<std::pair<uint64_t, size_t>> pending = {{0, levels_.size() - 1}};
+    while (!pending.empty()) {
+        auto [first, level] = pending.back();
+        pending.pop_back();
+        uint64_t end = std::min<uint64_t>(first + nodeSize_, levels_[level].second);
+        if (first < levels_[level].first || first >= end) {
+            return false;
+        }
+        for (uint64_t node = first; node < end; ++node) {
+            NodeItem item = ReadNode(node);
+            if (item.maxX < region.x || item.minX > region.Right() || item.maxY < region.y ||
+                item.minY > region.Bottom()) {
+                continue;
+            }
+            if (level == 0) {
+                outOffsets.push_back(item.offset);
+            } else {
+                pending.emplace_back(item.offset, level - 1);
+            }
+        }
+    }
+    std::sort(outOffsets.begin(), outOffsets.end());
+    return true;
+}
+
+bool FlatGeobufReader::GetFeatureGroups(std::vector<FeatureGroup>& outGroups) const {
+    outGroups.clear();
+    if (!HasIndex()) {
+        return false;
+    }
+    const auto& parents = levels_[1];
+    const uint64_t leafEnd = levels_[0].second;
+    for (uint64_t node = parents.first; node < parents.second; ++node) {
+        NodeItem item = ReadNode(node);
+        if (item.offset < levels_[0].first || item.offset >= leafEnd) {
+            return false;
+        }
+        outGroups.push_back({Rect(item.minX, item.minY, item.maxX - item.minX, item.maxY - item.minY), item.offset,
+                             std::min<uint64_t>(item.offset + nodeSize_, leafEnd)});
+    }
+    return true;
+}
+
+uint64_t FlatGeobufReader::GetLeafOffset(uint64_t leaf) const {
+    return ReadNode(leaf).offset;
+}
+
+bool FlatGeobufReader::FeatureBytes(uint64_t offset, const uint8_t*& outData, size_t& outSize) const {
+    const uint64_t size = file_->Size() - featuresOffset_;
+    if (offset + 4 > size) {
+        return false;
+    }
+    const uint8_t* feature = file_->Data() + featuresOffset_ + offset;
+    outSize = Load<uint32_t>(feature);
+    outData = feature + 4;
+    return offset + 4 + outSize <= size;
+}
+
+bool FlatGeobufReader::ReadProperties(const uint8_t* data, size_t size, std::string* className,
+                                      Feature* feature) const {
+    size_t position = 0;
+    while (position + 2 <= size) {
+        uint16_t column = Load<uint16_t>(data + position);
+        position += 2;
+        if (column >= columns_.size()) {
+            return false;
+        }
+        ColumnType type = columns_[column].type;
+        size_t valueBytes = FixedValueBytes(type);
+        const uint8_t* value = data + position;
+        if (valueBytes == 0) {
+            if (position + 4 > size) {
+                return false;
+            }
+            valueBytes = Load<uint32_t>(data + position);
+            value += 4;
+            position += 4;
+        }
+        if (position + valueBytes > size) {
+            return false;
+        }
+        if (className && column == classColumn_) {
+            *className = ValueText(type, value, valueBytes);
+        }
+        if (feature && column == confidenceColumn_) {
+            feature->confidence = type == ColumnType::Float ? Load<float>(value)
+                                                            : static_cast<float>(Load<double>(value));
+            feature->hasConfidence = true;
+        }
+        position += valueBytes;
+    }
+    return position == size;
+}
+
+bool FlatGeobufReader::ReadFeature(uint64_t offset, Feature& out) const {
+    out.xy.clear();
+    out.ringEnds.clear();
+    out.className.clear();
+    out.hasConfidence = false;
+
+    const uint8_t* data;
+    size_t size;
+    FlatTable feature;
+    if (!FeatureBytes(offset, data, size) || !FlatTable::Root(data, size, feature)) {
+        return false;
+    }
+
+    const uint8_t* properties;
+    uint32_t propertyBytes;
+    if (feature.Vector(FEATURE_PROPERTIES, 1, properties, propertyBytes) &&
+        !ReadProperties(properties, propertyBytes, &out.className, &out)) {
+        return false;
+    }
+
+    FlatTable geometry;
+    if (!feature.Table(FEATURE_GEOMETRY, geometry)) {
+        return true;  // No geometry
+    }
+    uint8_t type = geometryType_ != 0 ? geometryType_ : geometry.Scalar<uint8_t>(GEOMETRY_TYPE, 0);
+    if (type == GEOMETRY_POLYGON) {
+        return AppendExteriorRing(geometry, out);
+    }
+    if (type == GEOMETRY_MULTIPOLYGON) {
+        const uint8_t* parts;
+        uint32_t partCount;
+        if (!geometry.Vector(GEOMETRY_PARTS, 4, parts, partCount)) {
+            return true;
+        }
+        for (uint32_t i = 0; i < partCount; ++i) {
+            FlatTable part;
+            if (!geometry.TableAt(parts, i, part) || !AppendExteriorRing(part, out)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool FlatGeobufReader::ReadClassName(uint64_t offset, std::string& out) const {
+    out.clear();
+    const uint8_t* data;
+    size_t size;
+    FlatTable feature;
+    if (!FeatureBytes(offset, data, size) || !FlatTable::Root(data, size, feature)) {
+        return false;
+    }
+    const uint8_t* properties;
+    uint32_t propertyBytes;
+    if (!feature.Vector(FEATURE_PROPERTIES, 1, properties, propertyBytes)) {
+        return true;
+    }
+    return ReadProperties(properties, propertyBytes, &out, nullptr);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Viewport.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * FlatGeobuf files (https://flatgeobuf.org), read in place from a memory
+ * mapping.
+ *
+ * A file is a header, an optional packed Hilbert R-tree over the feature
+ * boxes and the features, each a size-prefixed FlatBuffer. The FlatBuffers
+ * are decoded directly, with bounds checks, instead of through generated
+ * code. Query() walks the file's own tree, so a region's features are
+ * found without touching the others; ReadFeature() decodes one into
+ * reused scratch.
+ *
+ * Only polygon geometry is kept (Polygon, MultiPolygon, or per-feature
+ * types of those): each polygon contributes its exterior ring, and other
+ * geometry reads as empty. Coordinates are taken as slide pixels.
+ */
+class FlatGeobufReader {
+public:
+    // Property column types (FlatGeobuf ColumnType)
+    enum class ColumnType : uint8_t {
+        Byte, UByte, Bool, Short, UShort, Int, UInt, Long, ULong,
+        Float, Double, String, Json, DateTime, Binary
+    };
+
+    struct Column {
+        std::string name;
+        ColumnType type;
+    };
+
+    /**
+     * One decoded feature (reused from call to call)
+     */
+    struct Feature {
+        std::vector<double> xy;          // Exterior ring points of each polygon, x then y
+        std::vector<uint32_t> ringEnds;  // One past each polygon's last point
+        std::string className;           // Class column value, "" without one
+        float confidence = 0.0f;
+        bool hasConfidence = false;
+    };
+
+    /**
+     * Index nodes just above the features: each covers up to the node
+     * size of features, consecutive in the file
+     */
+    struct FeatureGroup {
+        Rect bounds;
+        uint64_t firstLeaf;  // See GetLeafOffset
+        uint64_t leafEnd;
+    };
+
+    /**
+     * Map a file and read its header (replacing any opened before)
+     * @return false if it is not a readable FlatGeobuf file (see GetError)
+     */
+    bool Open(const std::string& filepath);
+    const std::string& GetError() const { return error_; }
+
+    /**
+     * Features in the header; 0 if the writer did not know
+     */
+    uint64_t GetFeatureCount() const { return featureCount_; }
+    bool HasIndex() const { return indexSize_ > 0; }
+    uint16_t GetIndexNodeSize() const { return nodeSize_; }
+    const std::vector<Column>& GetColumns() const { return columns_; }
+
+    /**
+     * Columns read into Feature::className and confidence; -1 if none.
+     * The class column is the first named like a cell class (class,
+     * cell_type, classification, type, label, name), else the first string
+     * column; the confidence column is a float or double one named
+     * confidence, score or probability.
+     */
+    int GetClassColumn() const { return classColumn_; }
+    int GetConfidenceColumn() const { return confidenceColumn_; }
+
+    /**
+     * Offsets of every feature, in file order, by walking their size
+     * prefixes (nothing is decoded)
+     * @return false if a size prefix runs past the end of the file
+     */
+    bool ScanFeatures(std::vector<uint64_t>& outOffsets) const;
+
+    /**
+     * Offsets of the features whose boxes meet a region, in file order,
+     * through the index (a full scan without one)
+     * @return false on a malformed index
+     */
+    bool Query(const Rect& region, std::vector<uint64_t>& outOffsets) const;
+
+    /**
+     * The index's feature groups, for streaming a file region by region
+     * @return false without an index
+     */
+    bool GetFeatureGroups(std::vector<FeatureGroup>& outGroups) const;
+    uint64_t GetLeafOffset(uint64_t leaf) const;
+
+    /**
+     * Decode the feature at an offset from ScanFeatures() or Query()
+     * (thread-safe)
+     * @return false if it is malformed
+     */
+    bool ReadFeature(uint64_t offset, Feature& out) const;
+
+    /**
+     * Only the class column value of a feature (thread-safe)
+     */
+    bool ReadClassName(uint64_t offset, std::string& out) const;
+
+    static constexpr size_t NODE_ITEM_BYTES = 40;  // Box (4 doubles) and offset
+
+private:
+    struct NodeItem {
+        double minX, minY, maxX, maxY;
+        uint64_t offset;
+    };
+
+    NodeItem ReadNode(uint64_t node) const;
+
+    // Feature FlatBuffer at an offset; false if it runs past the file
+    bool FeatureBytes(uint64_t offset, const uint8_t*& outData, size_t& outSize) const;
+
+    // The class and confidence columns of a properties buffer
+    bool ReadProperties(const uint8_t* data, size_t size, std::string* className, Feature* feature) const;
+
+    std::unique_ptr<MappedFile> file_;
+    std::string error_;
+
+    uint8_t geometryType_ = 0;
+    uint64_t featureCount_ = 0;
+    uint16_t nodeSize_ = 0;
+    std::vector<Column> columns_;
+    int classColumn_ = -1;
+    int confidenceColumn_ = -1;
+
+    uint64_t indexOffset_ = 0;
+    uint64_t indexSize_ = 0;
+    uint64_t featuresOffset_ = 0;
+    uint64_t nodeCount_ = 0;
+    // [first, end) node of each level, leaves first and the root last
+    std::vector<std::pair<uint64_t, uint64_t>> levels_;
+};
@@ -1,191 +1,466 @@
 #include "JSONPolygonLoader.h"
 #include "simdjson.h"
-#include <fstream>
-#include <iostream>
-#include <set>
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <functional>
+#include <thread>
 
-bool JSONPolygonLoader::Load(const std::string& filepath,
-                                   std::vector<Polygon>& outPolygons,
-                                   std::map<int, SDL_Color>& outClassColors,
-                                   std::map<int, std::string>& outClassNames) {
-    // Read file into string
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open JSON file: " << filepath << std::endl;
+namespace {
+
+// Tiles handled per worker at minimum; smaller files stay on one thread
+constexpr size_t MIN_TILES_PER_WORKER = 16;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The whole file, padded for simdjson, and the raw text of each element of
+// its "tiles" array. Tiles are parsed on their own (in parallel) straight
+// from these slices: the file's padding makes every slice safe to parse in
+// place.
+struct SplitDocument {
+    simdjson::padded_string json;
+    std::string slideId;
+    int maxDeepZoomLevel = 0;
+    std::vector<std::string_view> tiles;
+
+    // Bytes readable from the start of a tile slice, padding included
+    size_t CapacityFrom(std::string_view tile) const {
+        return json.size() + simdjson::SIMDJSON_PADDING - static_cast<size_t>(tile.data() - json.data());
+    }
+};
+
+// Tile placement: slide-space origin of its pixels and their scale
+struct TileFrame {
+    double originX = 0.0;
+    double originY = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+    double scaleFactor = 1.0;
+};
+
+// For optional fields: a missing or mistyped one keeps its default
+void KeepDefaultOnError(simdjson::error_code) {}
+
+// Read the file and split its "tiles" array, in one On-Demand pass that
+// only walks the structure (no tile value is parsed)
+bool SplitTiles(const std::string& filepath, SplitDocument& out) {
+    if (simdjson::padded_string::load(filepath).get(out.json) != simdjson::SUCCESS) {
+        PATHVIEW_LOG_ERROR("Failed to open JSON file: " << filepath);
         return false;
     }
 
-    // Read entire file into string
-    std::string jsonContent((std::istreambuf_iterator<char>(file)),
-                             std::istreambuf_iterator<char>());
-    file.close();
+    simdjson::ondemand::parser parser;
+    simdjson::ondemand::document doc;
+    simdjson::ondemand::object root;
+    auto error = parser.iterate(out.json).get(doc);
+    if (!error) {
+        error = doc.get_object().get(root);
+    }
+
+    bool hasTiles = false;
+    if (!error) {
+        for (auto field : root) {
+            std::string_view key;
+            if ((error = field.unescaped_key().get(key))) {
+                break;
+            }
 
-    // Parse JSON with simdjson
-    simdjson::dom::parser parser;
-    simdjson::dom::element doc;
+            // Missing or mistyped metadata keeps its default
+            if (key == "slide_id") {
+                std::string_view slideId;
+                if (field.value().get_string().get(slideId) == simdjson::SUCCESS) {
+                    out.slideId = std::string(slideId);
+                }
+            } else if (key == "max_level") {
+                int64_t maxLevel = 0;
+                if (field.value().get_int64().get(maxLevel) == simdjson::SUCCESS) {
+                    out.maxDeepZoomLevel = static_cast<int>(maxLevel);
+                }
+            } else if (key == "tiles") {
+                simdjson::ondemand::array tiles;
+                if (field.value().get_array().get(tiles) != simdjson::SUCCESS) {
+                    continue;
+                }
+                hasTiles = true;
+                for (auto tile : tiles) {
+                    std::string_view raw;
+                    if ((error = tile.raw_json().get(raw))) {
+                        break;
+                    }
+                    out.tiles.push_back(raw);
+                }
+                if (error) {
+                    break;
+                }
+            }
+        }
+    }
 
-    auto error = parser.parse(jsonContent).get(doc);
     if (error) {
-        std::cerr << "Failed to parse JSON: " << simdjson::error_message(error) << std::endl;
+        PATHVIEW_LOG_ERROR("Failed to parse JSON: " << simdjson::error_message(error));
         return false;
     }
+    if (!hasTiles) {
+        PATHVIEW_LOG_ERROR("No 'tiles' array found in JSON");
+        return false;
+    }
+    return true;
+}
 
-    // Clear output containers
-    outPolygons.clear();
-    outClassColors.clear();
-    outClassNames.clear();
-
-    // Extract slide metadata
-    std::string slideId;
-    int maxDeepZoomLevel = 0;
+TileFrame ReadTileFrame(simdjson::ondemand::object& tile, int maxDeepZoomLevel) {
+    int64_t level = 0;
+    double tileX = 0.0, tileY = 0.0;
+    int64_t tileWidth = 0, tileHeight = 0;
+
+    KeepDefaultOnError(tile["level"].get_int64().get(level));
+    KeepDefaultOnError(tile["x"].get_double().get(tileX));
+    KeepDefaultOnError(tile["y"].get_double().get(tileY));
+    KeepDefaultOnError(tile["width"].get_int64().get(tileWidth));
+    KeepDefaultOnError(tile["height"].get_int64().get(tileHeight));
+
+    TileFrame frame;
+    frame.scaleFactor = std::pow(2, maxDeepZoomLevel - level);
+    frame.originX = tileX * tileWidth;
+    frame.originY = tileY * tileHeight;
+    frame.width = static_cast<double>(tileWidth);
+    frame.height = static_cast<double>(tileHeight);
+    return frame;
+}
 
-    if (doc["slide_id"].error() == simdjson::SUCCESS) {
-        slideId = std::string(doc["slide_id"].get_c_str().value());
-        std::cout << "Slide ID: " << slideId << std::endl;
+// Support both object format {x: val, y: val} and array format [x, y]
+void ReadPoint(simdjson::ondemand::value point, double& x, double& y) {
+    simdjson::ondemand::json_type type;
+    if (point.type().get(type) != simdjson::SUCCESS) {
+        return;
     }
 
-    if (doc["max_level"].error() == simdjson::SUCCESS) {
-        maxDeepZoomLevel = static_cast<int>(doc["max_level"].get_int64().value());
+    if (type == simdjson::ondemand::json_type::object) {
+        simdjson::ondemand::object pointObject;
+        if (point.get_object().get(pointObject) == simdjson::SUCCESS) {
+            KeepDefaultOnError(pointObject["x"].get_double().get(x));
+            KeepDefaultOnError(pointObject["y"].get_double().get(y));
+        }
+    } else if (type == simdjson::ondemand::json_type::array) {
+        simdjson::ondemand::array pointArray;
+        if (point.get_array().get(pointArray) != simdjson::SUCCESS) {
+            return;
+        }
+        int component = 0;
+        for (auto value : pointArray) {
+            double coordinate = 0.0;
+            if (component > 1 || value.get_double().get(coordinate) != simdjson::SUCCESS) {
+                break;
+            }
+            (component++ == 0 ? x : y) = coordinate;
+        }
     }
+}
 
-    // Check if tiles array exists
-    simdjson::dom::array tiles;
-    if (doc["tiles"].get(tiles)) {
-        std::cerr << "No 'tiles' array found in JSON" << std::endl;
+// Parse tile `index` of doc with a worker's parser and pass its object to
+// use. Returns false for a malformed tile.
+bool WithTile(simdjson::ondemand::parser& parser, const SplitDocument& doc, size_t index,
+              const std::function<void(simdjson::ondemand::object&)>& use) {
+    std::string_view slice = doc.tiles[index];
+    simdjson::ondemand::document tileDoc;
+    simdjson::ondemand::object tile;
+    if (parser.iterate(slice.data(), slice.size(), doc.CapacityFrom(slice)).get(tileDoc) != simdjson::SUCCESS ||
+        tileDoc.get_object().get(tile) != simdjson::SUCCESS) {
         return false;
     }
+    use(tile);
+    return true;
+}
 
-    std::cout << "Tiles: " << tiles.size() << std::endl;
+// Append the polygons of one tile to out, classOf(cell type) numbering
+// their classes
+template <typename ClassOf>
+void ConvertTile(simdjson::ondemand::object& tile, int maxDeepZoomLevel,
+                 ClassOf&& classOf, PolygonStore& out) {
+    TileFrame frame = ReadTileFrame(tile, maxDeepZoomLevel);
+
+    // Get masks array
+    simdjson::ondemand::array masks;
+    if (tile["masks"].get_array().get(masks) != simdjson::SUCCESS) {
+        return;
+    }
 
-    // First pass: collect unique cell types
-    std::set<std::string> uniqueCellTypes;
-    size_t totalMasks = 0;
+    for (auto maskResult : masks) {
+        simdjson::ondemand::object mask;
+        if (maskResult.get_object().get(mask) != simdjson::SUCCESS) {
+            break;
+        }
 
-    for (auto tile : tiles) {
-        simdjson::dom::array masks;
-        if (tile["masks"].get(masks) == simdjson::SUCCESS) {
-            totalMasks += masks.size();
+        // Get cell type
+        std::string_view cellType;
+        if (mask["cell_type"].get_string().get(cellType) != simdjson::SUCCESS) {
+            continue;
+        }
+        int classId = classOf(cellType);
 
-            for (auto mask : masks) {
-                std::string_view cellType;
-                if (mask["cell_type"].get(cellType) == simdjson::SUCCESS) {
-                    uniqueCellTypes.insert(std::string(cellType));
-                }
+        // Get coordinates array
+        simdjson::ondemand::array coordinates;
+        if (mask["coordinates"].get_array().get(coordinates) != simdjson::SUCCESS) {
+            continue;
+        }
+
+        // Skip if not enough coordinates
+        size_t pointCount = 0;
+        if (coordinates.count_elements().get(pointCount) != simdjson::SUCCESS || pointCount < 3) {
+            continue;
+        }
+
+        out.BeginPolygon(classId);
+
+        // Extract vertices
+        for (auto pointResult : coordinates) {
+            double x = 0.0, y = 0.0;
+            simdjson::ondemand::value point;
+            if (pointResult.get(point) == simdjson::SUCCESS) {
+                ReadPoint(point, x, y);
             }
+
+            out.AddVertex(
+                (x + frame.originX) * frame.scaleFactor,
+                (y + frame.originY) * frame.scaleFactor
+            );
         }
+
+        out.EndPolygon();
     }
+}
 
-    std::cout << "Total polygons: " << totalMasks << std::endl;
-    std::cout << "Unique cell types: " << uniqueCellTypes.size() << std::endl;
+// Frame and cell types of one tile, its coordinates skipped unparsed
+void ScanTile(simdjson::ondemand::object& tile, int maxDeepZoomLevel,
+              TileFrame& frame, ClassNameTable& classes) {
+    frame = ReadTileFrame(tile, maxDeepZoomLevel);
+
+    simdjson::ondemand::array masks;
+    if (tile["masks"].get_array().get(masks) != simdjson::SUCCESS) {
+        return;
+    }
+    for (auto maskResult : masks) {
+        simdjson::ondemand::object mask;
+        if (maskResult.get_object().get(mask) != simdjson::SUCCESS) {
+            break;
+        }
+        std::string_view cellType;
+        if (mask["cell_type"].get_string().get(cellType) == simdjson::SUCCESS) {
+            classes.Intern(cellType);
+        }
+    }
+}
+
+// Workers for tileCount tiles: one per MIN_TILES_PER_WORKER, up to the
+// hardware's threads
+size_t WorkerCount(size_t tileCount) {
+    size_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(workerCount, tileCount / MIN_TILES_PER_WORKER));
+}
+
+// Run work(worker, begin, end) over workerCount contiguous tile ranges,
+// each on its own thread
+void ForTileRanges(size_t tileCount, size_t workerCount,
+                   const std::function<void(size_t worker, size_t begin, size_t end)>& work) {
+    if (workerCount == 1) {
+        work(0, 0, tileCount);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (size_t w = 0; w < workerCount; ++w) {
+        workers.emplace_back(work, w, tileCount * w / workerCount, tileCount * (w + 1) / workerCount);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ReportSkippedTiles(const std::vector<size_t>& skippedPerWorker) {
+    size_t skipped = 0;
+    for (size_t count : skippedPerWorker) {
+        skipped += count;
+    }
+    if (skipped > 0) {
+        PATHVIEW_LOG_ERROR("Skipped " << skipped << " malformed tile(s)");
+    }
+}
+
+}  // namespace
+
+std::vector<int> JSONPolygonLoader::MapClasses(const ClassNameTable& cellTypes,
+                                               std::map<std::string, int>& classMapping,
+                                               std::map<int, SDL_Color>& classColors,
+                                               std::map<int, std::string>& classNames) {
+    PATHVIEW_LOG_INFO("Unique cell types: " << cellTypes.Size());
 
     // Build class name to ID mapping
-    std::map<std::string, int> classMapping;
-    BuildClassMapping(uniqueCellTypes, classMapping);
+    std::vector<int> classIds = BuildClassMapping(cellTypes, classMapping);
 
     // Build reverse mapping (ID to name) for output
+    classNames.clear();
     for (const auto& pair : classMapping) {
-        outClassNames[pair.second] = pair.first;
+        classNames[pair.second] = pair.first;
     }
 
     // Print mapping
     for (const auto& pair : classMapping) {
-        std::cout << "  " << pair.first << " -> Class " << pair.second << std::endl;
+        PATHVIEW_LOG_INFO("  " << pair.first << " -> Class " << pair.second);
     }
 
     // Generate colors based on class names
-    std::cout << "Assigning colors to cell types:" << std::endl;
-    GenerateColorsFromClassNames(classMapping, outClassColors);
-
-    // Second pass: extract polygons from all tiles
-    outPolygons.reserve(totalMasks);
-
-    size_t tileCount = 0;
-    for (auto tile : tiles) {
-        // Extract tile metadata
-        int64_t level = 0;
-        double tileX = 0.0, tileY = 0.0;
-        int64_t tileWidth = 0, tileHeight = 0;
-
-        // Ignore errors if fields are missing, use defaults
-        (void)tile["level"].get(level);
-        (void)tile["x"].get(tileX);
-        (void)tile["y"].get(tileY);
-        (void)tile["width"].get(tileWidth);
-        (void)tile["height"].get(tileHeight);
-
-        double scaleFactor = std::pow(2, maxDeepZoomLevel - level);
-
-        // Get masks array
-        simdjson::dom::array masks;
-        if (tile["masks"].get(masks) != simdjson::SUCCESS) {
-            continue;
-        }
+    PATHVIEW_LOG_INFO("Assigning colors to cell types:");
+    GenerateColorsFromClassNames(classMapping, classColors);
+    return classIds;
+}
 
-        for (auto mask : masks) {
-            // Get cell type
-            std::string_view cellType;
-            if (mask["cell_type"].get(cellType) != simdjson::SUCCESS) {
-                continue;
-            }
+bool JSONPolygonLoader::Load(const std::string& filepath,
+                                   PolygonStore& outPolygons,
+                                   std::map<int, SDL_Color>& outClassColors,
+                                   std::map<int, std::string>& outClassNames) {
+    outPolygons.Clear();
+    outClassColors.clear();
+    outClassNames.clear();
 
-            // Get coordinates array
-            simdjson::dom::array coordinates;
-            if (mask["coordinates"].get(coordinates) != simdjson::SUCCESS) {
-                continue;
+    auto splitStart = std::chrono::steady_clock::now();
+    SplitDocument doc;
+    if (!SplitTiles(filepath, doc)) {
+        return false;
+    }
+    if (!doc.slideId.empty()) {
+        PATHVIEW_LOG_INFO("Slide ID: " << doc.slideId);
+    }
+    PATHVIEW_LOG_INFO("Tiles: " << doc.tiles.size() << " (read and split in "
+                      << MillisecondsSince(splitStart) << " ms)");
+
+    // A single pass over the tiles: each worker converts a contiguous range
+    // into its own store, numbering cell types as it meets them. Once all
+    // are done the numbers are mapped to the file's class IDs and the
+    // stores concatenated in file order.
+    auto convertStart = std::chrono::steady_clock::now();
+    const size_t tileCount = doc.tiles.size();
+    const size_t workerCount = WorkerCount(tileCount);
+    std::vector<PolygonStore> parts(workerCount);
+    std::vector<ClassNameTable> partClasses(workerCount);
+    std::vector<size_t> skipped(workerCount, 0);
+    ForTileRanges(tileCount, workerCount, [&](size_t w, size_t begin, size_t end) {
+        simdjson::ondemand::parser parser;
+        ClassNameTable& classes = partClasses[w];
+        auto classOf = [&classes](std::string_view name) { return static_cast<int>(classes.Intern(name)); };
+        for (size_t i = begin; i < end; ++i) {
+            if (!WithTile(parser, doc, i, [&](simdjson::ondemand::object& tile) {
+                    ConvertTile(tile, doc.maxDeepZoomLevel, classOf, parts[w]);
+                })) {
+                ++skipped[w];
             }
+        }
+    });
+    ReportSkippedTiles(skipped);
 
-            // Skip if not enough coordinates
-            if (coordinates.size() < 3) {
-                continue;
-            }
+    // Each worker's types, as indices of the file's
+    ClassNameTable uniqueCellTypes;
+    std::vector<std::vector<uint32_t>> partTypes(workerCount);
+    size_t totalMasks = 0;
+    size_t totalVertices = 0;
+    for (size_t w = 0; w < workerCount; ++w) {
+        for (const std::string& name : partClasses[w].GetNames()) {
+            partTypes[w].push_back(uniqueCellTypes.Intern(name));
+        }
+        totalMasks += parts[w].Size();
+        totalVertices += parts[w].GetTotalVertexCount();
+    }
 
-            Polygon polygon;
-            polygon.classId = classMapping[std::string(cellType)];
-
-            // Extract vertices
-            polygon.vertices.reserve(coordinates.size());
-            for (auto point : coordinates) {
-                double x = 0.0, y = 0.0;
-
-                // Support both object format {x: val, y: val} and array format [x, y]
-                if (point.is_object()) {
-                    (void)point["x"].get(x);
-                    (void)point["y"].get(y);
-                } else if (point.is_array()) {
-                    simdjson::dom::array pointArray = point.get_array().value();
-                    auto it = pointArray.begin();
-                    if (it != pointArray.end()) {
-                        (void)(*it).get(x);
-                        ++it;
-                        if (it != pointArray.end()) {
-                            (void)(*it).get(y);
-                        }
-                    }
-                }
+    std::map<std::string, int> classMapping;
+    const std::vector<int> typeClasses = MapClasses(uniqueCellTypes, classMapping, outClassColors, outClassNames);
+
+    outPolygons.Reserve(totalMasks, totalVertices);
+    for (size_t w = 0; w < workerCount; ++w) {
+        std::vector<int> classIds;
+        classIds.reserve(partTypes[w].size());
+        for (uint32_t type : partTypes[w]) {
+            classIds.push_back(typeClasses[type]);
+        }
+        parts[w].RemapClassIds(classIds);
+        outPolygons.Append(parts[w]);
+        parts[w] = PolygonStore();
+    }
 
-                polygon.vertices.emplace_back(
-                    (x + tileX * tileWidth) * scaleFactor,
-                    (y + tileY * tileHeight) * scaleFactor
-                );
-            }
+    PATHVIEW_LOG_INFO("Converted " << tileCount << " tiles on " << workerCount << " thread(s) in "
+                      << MillisecondsSince(convertStart) << " ms");
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices)");
+    PATHVIEW_LOG_INFO("==================================\n");
 
-            // Compute bounding box
-            polygon.ComputeBoundingBox();
+    return true;
+}
 
-            outPolygons.push_back(std::move(polygon));
+bool JSONPolygonLoader::LoadStreaming(const std::string& filepath,
+                                      const PolygonStreamCallbacks& callbacks) {
+    SplitDocument doc;
+    if (!SplitTiles(filepath, doc)) {
+        return false;
+    }
+    if (!doc.slideId.empty()) {
+        PATHVIEW_LOG_INFO("Slide ID: " << doc.slideId);
+    }
+    PATHVIEW_LOG_INFO("Tiles: " << doc.tiles.size());
+
+    // The class tables and tile bounds are needed before the first batch:
+    // scan the tiles in parallel for them, skipping the coordinates
+    const size_t tileCount = doc.tiles.size();
+    const size_t workerCount = WorkerCount(tileCount);
+    std::vector<TileFrame> frames(tileCount);
+    std::vector<ClassNameTable> partClasses(workerCount);
+    std::vector<size_t> skipped(workerCount, 0);
+    ForTileRanges(tileCount, workerCount, [&](size_t w, size_t begin, size_t end) {
+        simdjson::ondemand::parser parser;
+        for (size_t i = begin; i < end; ++i) {
+            if (!WithTile(parser, doc, i, [&](simdjson::ondemand::object& tile) {
+                    ScanTile(tile, doc.maxDeepZoomLevel, frames[i], partClasses[w]);
+                })) {
+                ++skipped[w];
+            }
         }
-
-        // Progress update every 10 tiles
-        ++tileCount;
-        if (tileCount % 10 == 0) {
-            std::cout << "  Processed " << tileCount << " / " << tiles.size()
-                      << " tiles..." << std::endl;
+    });
+    ReportSkippedTiles(skipped);
+
+    // Every cell type is known now: conversion only looks them up, in a
+    // table frozen to one probe per cell
+    ClassNameTable uniqueCellTypes;
+    for (const auto& classes : partClasses) {
+        for (const std::string& name : classes.GetNames()) {
+            uniqueCellTypes.Intern(name);
         }
     }
+    uniqueCellTypes.Freeze();
 
-    std::cout << "Successfully loaded " << outPolygons.size() << " polygons" << std::endl;
-    std::cout << "==================================\n" << std::endl;
+    std::map<std::string, int> classMapping;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    const std::vector<int> typeClasses = MapClasses(uniqueCellTypes, classMapping, classColors, classNames);
+    if (callbacks.onClasses) {
+        callbacks.onClasses(classColors, classNames);
+    }
+    auto classOf = [&](std::string_view name) {
+        const uint32_t type = uniqueCellTypes.Find(name);
+        return type != ClassNameTable::NOT_FOUND ? typeClasses[type] : 0;
+    };
+
+    // Extract polygons, tiles nearest the focus first
+    std::vector<Rect> tileBounds;
+    tileBounds.reserve(tileCount);
+    for (const TileFrame& frame : frames) {
+        tileBounds.emplace_back(frame.originX * frame.scaleFactor, frame.originY * frame.scaleFactor,
+                                frame.width * frame.scaleFactor, frame.height * frame.scaleFactor);
+    }
 
-    return true;
+    simdjson::ondemand::parser parser;
+    return StreamTiles(tileBounds, [&](size_t tile, PolygonStore& out) {
+        WithTile(parser, doc, tile, [&](simdjson::ondemand::object& tileObject) {
+            ConvertTile(tileObject, doc.maxDeepZoomLevel, classOf, out);
+        });
+    }, callbacks);
 }
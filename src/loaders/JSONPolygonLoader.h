@@ -6,12 +6,15 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <SDL2/SDL.h>
 
 /**
  * JSON Polygon File Loader
  *
- * Loads polygon data from JSON files.
+ * Loads polygon data from JSON files with the simdjson On-Demand API: the
+ * file is split into its tiles in one structural pass, then the tiles are
+ * converted in parallel, each parsed in place.
  *
  * Cell types (strings) are automatically mapped to integer class IDs.
  */
@@ -20,13 +23,32 @@ public:
     /**
      * Load polygons from JSON file
      * @param filepath Path to .json file
-     * @param outPolygons Output vector of polygons
+     * @param outPolygons Output polygon store
      * @param outClassColors Output map of class ID to color
      * @param outClassNames Output map of class ID to class name
      * @return true if successful, false otherwise
      */
     bool Load(const std::string& filepath,
-                    std::vector<Polygon>& outPolygons,
+                    PolygonStore& outPolygons,
                     std::map<int, SDL_Color>& outClassColors,
                     std::map<int, std::string>& outClassNames) override;
+
+    /**
+     * Stream polygons from JSON file: split and scanned for tile bounds
+     * and cell types, then converted STREAM_BATCH_TILES tiles at a time
+     * around the focus
+     * @param filepath Path to .json file
+     * @param callbacks Receivers of the class tables and batches
+     * @return true if the whole file was loaded, false on error or cancel
+     */
+    bool LoadStreaming(const std::string& filepath,
+                       const PolygonStreamCallbacks& callbacks) override;
+
+private:
+    // Class IDs, names and colors of the file's cell types; returns the
+    // class ID of each interned type, by index
+    static std::vector<int> MapClasses(const ClassNameTable& cellTypes,
+                                       std::map<std::string, int>& classMapping,
+                                       std::map<int, SDL_Color>& classColors,
+                                       std::map<int, std::string>& classNames);
 };
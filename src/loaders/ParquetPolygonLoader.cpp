@@ -0,0 +1,467 @@
+#include "ParquetPolygonLoader.h"
+#include "Log.h"
+#include "WkbReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/properties.h>
+#include <parquet/schema.h>
+#include <parquet/statistics.h>
+#endif
+
+bool ParquetPolygonLoader::IsSupported() {
+#ifdef PATHVIEW_HAS_PARQUET
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ParquetPolygonLoader::MayMatch(const RowGroupStats& stats, const Filter& filter) {
+    if (filter.hasRegion && stats.hasBounds) {
+        Rect bounds = stats.bounds;
+        if (stats.boundsAreCentroids) {
+            bounds = Rect(bounds.x - filter.centroidMargin, bounds.y - filter.centroidMargin,
+                          bounds.width + 2 * filter.centroidMargin, bounds.height + 2 * filter.centroidMargin);
+        }
+        if (!bounds.Intersects(filter.region)) {
+            return false;
+        }
+    }
+    if (filter.minConfidence > 0.0f && stats.hasConfidence && stats.maxConfidence < filter.minConfidence) {
+        return false;
+    }
+    if (!filter.classes.empty() && stats.hasClasses) {
+        auto it = filter.classes.lower_bound(stats.minClass);
+        if (it == filter.classes.end() || *it > stats.maxClass) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef PATHVIEW_HAS_PARQUET
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string Lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+// Leaf column of the first name a file has, -1 if none
+int FindColumn(const parquet::SchemaDescriptor& schema, std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        for (int i = 0; i < schema.num_columns(); ++i) {
+            if (Lowercase(schema.Column(i)->path()->ToDotString()) == name) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+// The statistics range of a numeric column chunk
+bool NumericRange(const parquet::RowGroupMetaData& rowGroup, int column, double& outMin, double& outMax) {
+    if (column < 0) {
+        return false;
+    }
+    std::shared_ptr<parquet::Statistics> stats = rowGroup.ColumnChunk(column)->statistics();
+    if (!stats || !stats->HasMinMax()) {
+        return false;
+    }
+    const std::string min = stats->EncodeMin();
+    const std::string max = stats->EncodeMax();
+    auto decode = [&](auto value) {
+        if (min.size() != sizeof(value) || max.size() != sizeof(value)) {
+            return false;
+        }
+        std::memcpy(&value, min.data(), sizeof(value));
+        outMin = static_cast<double>(value);
+        std::memcpy(&value, max.data(), sizeof(value));
+        outMax = static_cast<double>(value);
+        return true;
+    };
+    switch (stats->physical_type()) {
+    case parquet::Type::DOUBLE: return decode(double());
+    case parquet::Type::FLOAT: return decode(float());
+    case parquet::Type::INT32: return decode(int32_t());
+    case parquet::Type::INT64: return decode(int64_t());
+    default: return false;
+    }
+}
+
+// Leaf columns of a file's cell table
+struct Columns {
+    int geometry = -1;
+    int classes = -1;
+    int confidence = -1;
+    int centroidX = -1;
+    int centroidY = -1;
+    int minX = -1, minY = -1, maxX = -1, maxY = -1;
+
+    explicit Columns(const parquet::SchemaDescriptor& schema) {
+        geometry = FindColumn(schema, {"geometry", "wkb", "geom", "polygon"});
+        classes = FindColumn(schema, {"class", "cell_type", "classification", "type", "label"});
+        confidence = FindColumn(schema, {"confidence", "score", "probability"});
+        centroidX = FindColumn(schema, {"centroid_x", "x"});
+        centroidY = FindColumn(schema, {"centroid_y", "y"});
+        minX = FindColumn(schema, {"bbox.xmin", "xmin"});
+        minY = FindColumn(schema, {"bbox.ymin", "ymin"});
+        maxX = FindColumn(schema, {"bbox.xmax", "xmax"});
+        maxY = FindColumn(schema, {"bbox.ymax", "ymax"});
+    }
+};
+
+ParquetPolygonLoader::RowGroupStats ReadStats(const parquet::RowGroupMetaData& rowGroup, const Columns& columns) {
+    ParquetPolygonLoader::RowGroupStats stats;
+    double minX, maxX, minY, maxY, unused;
+    if (NumericRange(rowGroup, columns.minX, minX, unused) && NumericRange(rowGroup, columns.maxX, unused, maxX) &&
+        NumericRange(rowGroup, columns.minY, minY, unused) && NumericRange(rowGroup, columns.maxY, unused, maxY)) {
+        stats.hasBounds = true;
+    } else if (NumericRange(rowGroup, columns.centroidX, minX, maxX) &&
+               NumericRange(rowGroup, columns.centroidY, minY, maxY)) {
+        stats.hasBounds = true;
+        stats.boundsAreCentroids = true;
+    }
+    if (stats.hasBounds) {
+        stats.bounds = Rect(minX, minY, maxX - minX, maxY - minY);
+    }
+    stats.hasConfidence = NumericRange(rowGroup, columns.confidence, unused, stats.maxConfidence);
+
+    if (columns.classes >= 0) {
+        std::shared_ptr<parquet::Statistics> classStats = rowGroup.ColumnChunk(columns.classes)->statistics();
+        if (classStats && classStats->HasMinMax() && classStats->physical_type() == parquet::Type::BYTE_ARRAY) {
+            stats.hasClasses = true;
+            stats.minClass = classStats->EncodeMin();
+            stats.maxClass = classStats->EncodeMax();
+        }
+    }
+    return stats;
+}
+
+// A floating point column of one batch, read from its value buffer
+class NumberColumn {
+public:
+    explicit NumberColumn(std::shared_ptr<arrow::Array> array) : array_(std::move(array)) {
+        if (!array_) {
+            return;
+        }
+        if (array_->type_id() == arrow::Type::DOUBLE) {
+            doubles_ = static_cast<const arrow::DoubleArray&>(*array_).raw_values();
+        } else if (array_->type_id() == arrow::Type::FLOAT) {
+            floats_ = static_cast<const arrow::FloatArray&>(*array_).raw_values();
+        } else {
+            array_.reset();
+        }
+    }
+
+    bool Has(int64_t row) const { return array_ && array_->IsValid(row); }
+    double operator[](int64_t row) const { return doubles_ ? doubles_[row] : floats_[row]; }
+
+private:
+    std::shared_ptr<arrow::Array> array_;
+    const double* doubles_ = nullptr;
+    const float* floats_ = nullptr;
+};
+
+// A class column value as text ("" for null)
+std::string ClassText(const arrow::Array& array, int64_t row) {
+    if (array.IsNull(row)) {
+        return std::string();
+    }
+    switch (array.type_id()) {
+    case arrow::Type::STRING: return static_cast<const arrow::StringArray&>(array).GetString(row);
+    case arrow::Type::LARGE_STRING: return static_cast<const arrow::LargeStringArray&>(array).GetString(row);
+    default: {
+        auto scalar = array.GetScalar(row);
+        return scalar.ok() ? (*scalar)->ToString() : std::string();
+    }
+    }
+}
+
+// WKB bytes of a geometry column row; false for null or another type
+bool GeometryBytes(const arrow::Array& array, int64_t row, const uint8_t*& outData, size_t& outSize) {
+    if (array.IsNull(row)) {
+        return false;
+    }
+    if (array.type_id() == arrow::Type::BINARY) {
+        auto view = static_cast<const arrow::BinaryArray&>(array).GetView(row);
+        outData = reinterpret_cast<const uint8_t*>(view.data());
+        outSize = view.size();
+        return true;
+    }
+    if (array.type_id() == arrow::Type::LARGE_BINARY) {
+        auto view = static_cast<const arrow::LargeBinaryArray&>(array).GetView(row);
+        outData = reinterpret_cast<const uint8_t*>(view.data());
+        outSize = view.size();
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool ParquetPolygonLoader::Load(const std::string& filepath,
+                                PolygonStore& outPolygons,
+                                std::map<int, SDL_Color>& outClassColors,
+                                std::map<int, std::string>& outClassNames) {
+    auto openStart = std::chrono::steady_clock::now();
+    rowGroupCount_ = 0;
+    skippedRowGroups_ = 0;
+
+    auto input = arrow::io::MemoryMappedFile::Open(filepath, arrow::io::FileMode::READ);
+    if (!input.ok()) {
+        PATHVIEW_LOG_ERROR("Failed to open Parquet file: " << input.status().ToString());
+        return false;
+    }
+    parquet::arrow::FileReaderBuilder builder;
+    arrow::Status status = builder.Open(*input);
+    if (!status.ok()) {
+        PATHVIEW_LOG_ERROR("Failed to read Parquet file " << filepath << ": " << status.ToString());
+        return false;
+    }
+    std::shared_ptr<parquet::FileMetaData> metadata = builder.raw_reader()->metadata();
+    const parquet::SchemaDescriptor& schema = *metadata->schema();
+    Columns columns(schema);
+    if (columns.geometry < 0 || schema.Column(columns.geometry)->physical_type() != parquet::Type::BYTE_ARRAY ||
+        schema.Column(columns.geometry)->path()->ToDotVector().size() != 1) {
+        PATHVIEW_LOG_ERROR("No WKB geometry column in " << filepath);
+        return false;
+    }
+
+    // Classes arrive dictionary-encoded: one lookup per distinct name
+    parquet::ArrowReaderProperties properties;
+    properties.set_use_threads(true);
+    properties.set_pre_buffer(true);
+    if (columns.classes >= 0 && schema.Column(columns.classes)->physical_type() == parquet::Type::BYTE_ARRAY) {
+        properties.set_read_dictionary(columns.classes, true);
+    }
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    status = builder.properties(properties)->Build(&reader);
+    if (!status.ok()) {
+        PATHVIEW_LOG_ERROR("Failed to read Parquet file " << filepath << ": " << status.ToString());
+        return false;
+    }
+
+    // Prune row groups by their statistics before reading any data
+    rowGroupCount_ = metadata->num_row_groups();
+    std::vector<int> rowGroups;
+    size_t rowCount = 0;
+    for (int i = 0; i < rowGroupCount_; ++i) {
+        std::unique_ptr<parquet::RowGroupMetaData> rowGroup = metadata->RowGroup(i);
+        if (MayMatch(ReadStats(*rowGroup, columns), filter_)) {
+            rowGroups.push_back(i);
+            rowCount += static_cast<size_t>(rowGroup->num_rows());
+        }
+    }
+    skippedRowGroups_ = rowGroupCount_ - static_cast<int>(rowGroups.size());
+    PATHVIEW_LOG_INFO("Row groups: " << rowGroups.size() << " of " << rowGroupCount_ << " (" << rowCount
+                      << " rows) pass the filter");
+
+    std::vector<int> readColumns;
+    std::string geometryName, className, confidenceName, centroidXName, centroidYName;
+    const std::vector<std::pair<int, std::string*>> wanted = {
+        {columns.geometry, &geometryName}, {columns.classes, &className}, {columns.confidence, &confidenceName},
+        {columns.centroidX, &centroidXName}, {columns.centroidY, &centroidYName}};
+    for (auto [column, name] : wanted) {
+        // Top-level columns only: the bounding box struct is for statistics
+        if (column >= 0 && schema.Column(column)->path()->ToDotVector().size() == 1) {
+            readColumns.push_back(column);
+            *name = schema.Column(column)->name();
+        }
+    }
+
+    std::shared_ptr<arrow::Table> table;
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    if (!rowGroups.empty()) {
+        status = reader->ReadRowGroups(rowGroups, readColumns, &table);
+        if (!status.ok()) {
+            PATHVIEW_LOG_ERROR("Failed to read Parquet row groups of " << filepath << ": " << status.ToString());
+            return false;
+        }
+        // Batches share chunk boundaries across columns: slices, not copies
+        arrow::TableBatchReader batchReader(*table);
+        std::shared_ptr<arrow::RecordBatch> batch;
+        while (batchReader.ReadNext(&batch).ok() && batch) {
+            batches.push_back(batch);
+        }
+    }
+    PATHVIEW_LOG_INFO("Read " << rowCount << " rows in " << batches.size() << " batches in "
+                      << MillisecondsSince(openStart) << " ms");
+
+    // Class table: the names that pass the filter
+    auto keepClass = [this](const std::string& name) {
+        return filter_.classes.empty() || filter_.classes.count(name) > 0;
+    };
+    ClassNameTable cellTypes;
+    for (const auto& part : batches) {
+        std::shared_ptr<arrow::Array> classes = className.empty() ? nullptr : part->GetColumnByName(className);
+        if (!classes) {
+            if (keepClass("")) {
+                cellTypes.Intern("");
+            }
+            continue;
+        }
+        const arrow::Array* values = classes.get();
+        if (classes->type_id() == arrow::Type::DICTIONARY) {
+            values = static_cast<const arrow::DictionaryArray&>(*classes).dictionary().get();
+            if (classes->null_count() > 0 && keepClass("")) {
+                cellTypes.Intern("");
+            }
+        }
+        ClassNameTable seen;
+        for (int64_t i = 0; i < values->length(); ++i) {
+            seen.Intern(ClassText(*values, i));
+        }
+        for (const std::string& name : seen.GetNames()) {
+            if (keepClass(name)) {
+                cellTypes.Intern(name);
+            }
+        }
+    }
+    cellTypes.Freeze();
+
+    std::map<std::string, int> classMapping;
+    const std::vector<int> typeClasses = BuildClassMapping(cellTypes, classMapping);
+    outClassNames.clear();
+    for (const auto& pair : classMapping) {
+        outClassNames[pair.second] = pair.first;
+        PATHVIEW_LOG_INFO("  " << pair.first << " -> Class " << pair.second);
+    }
+    GenerateColorsFromClassNames(classMapping, outClassColors);
+
+    // Convert the batches in place on worker threads
+    auto convertStart = std::chrono::steady_clock::now();
+    std::atomic<size_t> malformedRows{0};
+    outPolygons.Clear();
+    int workerCount = ConvertInParallel(batches.size(), rowCount, 0, [&](size_t begin, size_t end, PolygonStore& out) {
+        std::vector<double> xy;
+        std::vector<uint32_t> ringEnds;
+        std::vector<int> dictionaryClasses;
+        size_t malformed = 0;
+        for (size_t b = begin; b < end; ++b) {
+            const arrow::RecordBatch& part = *batches[b];
+            std::shared_ptr<arrow::Array> geometry = part.GetColumnByName(geometryName);
+            std::shared_ptr<arrow::Array> classes = className.empty() ? nullptr : part.GetColumnByName(className);
+            NumberColumn confidence(confidenceName.empty() ? nullptr : part.GetColumnByName(confidenceName));
+            NumberColumn centroidX(centroidXName.empty() ? nullptr : part.GetColumnByName(centroidXName));
+            NumberColumn centroidY(centroidYName.empty() ? nullptr : part.GetColumnByName(centroidYName));
+
+            // Class ID of a name, -1 if the filter drops it
+            auto classOf = [&](const std::string& name) {
+                const uint32_t type = cellTypes.Find(name);
+                return type != ClassNameTable::NOT_FOUND ? typeClasses[type] : (keepClass(name) ? 0 : -1);
+            };
+            const arrow::DictionaryArray* dictionary = nullptr;
+            if (classes && classes->type_id() == arrow::Type::DICTIONARY) {
+                dictionary = static_cast<const arrow::DictionaryArray*>(classes.get());
+                const arrow::Array& values = *dictionary->dictionary();
+                dictionaryClasses.resize(static_cast<size_t>(values.length()));
+                for (int64_t i = 0; i < values.length(); ++i) {
+                    dictionaryClasses[static_cast<size_t>(i)] = classOf(ClassText(values, i));
+                }
+            }
+            const int nullClass = classOf("");
+
+            for (int64_t row = 0; row < part.num_rows(); ++row) {
+                int classId = nullClass;
+                if (classes && classes->IsValid(row)) {
+                    classId = dictionary ? dictionaryClasses[static_cast<size_t>(dictionary->GetValueIndex(row))]
+                                         : classOf(ClassText(*classes, row));
+                }
+                if (classId < 0) {
+                    continue;
+                }
+                const bool hasConfidence = confidence.Has(row);
+                if (hasConfidence && confidence[row] < filter_.minConfidence) {
+                    continue;
+                }
+                const uint8_t* wkb;
+                size_t wkbSize;
+                if (!GeometryBytes(*geometry, row, wkb, wkbSize)) {
+                    continue;
+                }
+                if (!WkbReader::ReadPolygons(wkb, wkbSize, xy, ringEnds)) {
+                    ++malformed;
+                    continue;
+                }
+
+                uint32_t ringBegin = 0;
+                for (uint32_t ringEnd : ringEnds) {
+                    if (ringEnd - ringBegin < 3) {
+                        ringBegin = ringEnd;
+                        continue;
+                    }
+                    if (filter_.hasRegion) {
+                        double minX = std::numeric_limits<double>::max(), minY = minX;
+                        double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+                        for (uint32_t k = ringBegin; k < ringEnd; ++k) {
+                            minX = std::min(minX, xy[2 * k]);
+                            maxX = std::max(maxX, xy[2 * k]);
+                            minY = std::min(minY, xy[2 * k + 1]);
+                            maxY = std::max(maxY, xy[2 * k + 1]);
+                        }
+                        if (!Rect(minX, minY, maxX - minX, maxY - minY).Intersects(filter_.region)) {
+                            ringBegin = ringEnd;
+                            continue;
+                        }
+                    }
+                    out.BeginPolygon(classId);
+                    for (uint32_t k = ringBegin; k < ringEnd; ++k) {
+                        out.AddVertex(xy[2 * k], xy[2 * k + 1]);
+                    }
+                    const uint32_t index = out.EndPolygon();
+                    if (centroidX.Has(row) && centroidY.Has(row)) {
+                        out.SetCentroid(index, centroidX[row], centroidY[row]);
+                    }
+                    if (hasConfidence) {
+                        out.SetConfidence(index, static_cast<float>(confidence[row]));
+                    }
+                    ringBegin = ringEnd;
+                }
+            }
+        }
+        malformedRows += malformed;
+    }, outPolygons, 1);
+
+    if (malformedRows > 0) {
+        PATHVIEW_LOG_WARNING("Skipped " << malformedRows << " rows of malformed WKB in " << filepath);
+    }
+    PATHVIEW_LOG_INFO("Converted " << batches.size() << " batches on " << workerCount << " thread(s) in "
+                      << MillisecondsSince(convertStart) << " ms");
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices)");
+    PATHVIEW_LOG_INFO("==================================\n");
+    return true;
+}
+
+#else
+
+bool ParquetPolygonLoader::Load(const std::string& filepath,
+                                PolygonStore& /*outPolygons*/,
+                                std::map<int, SDL_Color>& /*outClassColors*/,
+                                std::map<int, std::string>& /*outClassNames*/) {
+    rowGroupCount_ = 0;
+    skippedRowGroups_ = 0;
+    PATHVIEW_LOG_ERROR("Cannot load " << filepath << ": built without Apache Parquet support");
+    return false;
+}
+
+#endif
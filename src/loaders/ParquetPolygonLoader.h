@@ -0,0 +1,98 @@
+#pragma once
+
+#include "PolygonLoader.h"
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <SDL2/SDL.h>
+
+/**
+ * Parquet Cell Table Loader
+ *
+ * Loads per-cell tables (one row per cell: WKB geometry, class,
+ * confidence, optionally centroid and bounding box columns) with Apache
+ * Arrow's Parquet reader, built in when Arrow is found
+ * (PATHVIEW_HAS_PARQUET; without it such files are refused).
+ *
+ * Only the columns the store needs are read, into Arrow arrays that are
+ * walked in place: the class column is read dictionary-encoded, so each
+ * batch maps its dictionary to class IDs once instead of a string per row,
+ * and confidence and centroid values are taken straight from the column
+ * buffers. Batches are converted on worker threads.
+ *
+ * A Filter is pushed down to the row groups: their column statistics
+ * (bounding box or centroid, confidence and class ranges) skip groups that
+ * cannot match before any of their data is read, and the remaining rows
+ * are filtered as they are converted.
+ *
+ * Column names, first match wins (case-insensitive):
+ *   geometry    geometry, wkb, geom, polygon (WKB, see WkbReader)
+ *   class       class, cell_type, classification, type, label
+ *   confidence  confidence, score, probability
+ *   centroid    centroid_x / centroid_y, x / y
+ *   bounds      bbox.xmin ... (GeoParquet covering), or xmin / ymin / xmax / ymax
+ */
+class ParquetPolygonLoader: public PolygonLoader {
+public:
+    /**
+     * Rows to load; the default loads every row
+     */
+    struct Filter {
+        bool hasRegion = false;
+        Rect region;                  // Cells whose bounds meet it (slide pixels)
+        double centroidMargin = 64.0; // Furthest a cell reaches from its centroid, when
+                                      // only centroid statistics bound the row groups
+        float minConfidence = 0.0f;   // Rows below are dropped
+        std::set<std::string> classes;  // Class names to keep; empty keeps all
+    };
+
+    /**
+     * What a file's statistics say about one row group; a range is only
+     * set when the file has statistics for it
+     */
+    struct RowGroupStats {
+        bool hasBounds = false;
+        bool boundsAreCentroids = false;
+        Rect bounds;
+        bool hasConfidence = false;
+        double maxConfidence = 0.0;
+        bool hasClasses = false;
+        std::string minClass;
+        std::string maxClass;
+    };
+
+    void SetFilter(Filter filter) { filter_ = std::move(filter); }
+    const Filter& GetFilter() const { return filter_; }
+
+    /**
+     * Load the rows of a Parquet file that pass the filter
+     * @param filepath Path to .parquet file
+     * @param outPolygons Output polygon store
+     * @param outClassColors Output map of class ID to color
+     * @param outClassNames Output map of class ID to class name
+     * @return true if successful, false otherwise
+     */
+    bool Load(const std::string& filepath,
+              PolygonStore& outPolygons,
+              std::map<int, SDL_Color>& outClassColors,
+              std::map<int, std::string>& outClassNames) override;
+
+    /**
+     * Whether a row group may hold rows passing a filter, by its
+     * statistics alone (true wherever they are missing)
+     */
+    static bool MayMatch(const RowGroupStats& stats, const Filter& filter);
+
+    // Row groups of the last Load() and how many of them the filter skipped
+    int GetRowGroupCount() const { return rowGroupCount_; }
+    int GetSkippedRowGroupCount() const { return skippedRowGroups_; }
+
+    // Whether this build reads Parquet at all
+    static bool IsSupported();
+
+private:
+    Filter filter_;
+    int rowGroupCount_ = 0;
+    int skippedRowGroups_ = 0;
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "PolygonLoader.h"
+#include "PolygonCache.h"
+#include "CachedPolygonLoader.h"
+#include "FlatGeobufPolygonLoader.h"
 #include "JSONPolygonLoader.h"
+#include "ParquetPolygonLoader.h"
 #include "ProtobufPolygonLoader.h"
 
 #include <memory>
@@ -10,13 +14,23 @@
 
 class PolygonLoaderFactory {
 public:
-    static std::unique_ptr<PolygonLoader> CreateLoader(const std::string& filePath) {
+    // allowCache: load from a fresh PolygonCache sidecar instead of parsing
+    static std::unique_ptr<PolygonLoader> CreateLoader(const std::string& filePath, bool allowCache = true) {
+        // Reopening a file loads the binary cache written after its first load
+        if (allowCache && PolygonCache::IsFresh(filePath)) {
+            return std::make_unique<CachedPolygonLoader>();
+        }
+
         std::string extension = std::filesystem::path(filePath).extension().string();
 
         if (extension == ".json") {
             return std::make_unique<JSONPolygonLoader>();
         } else if (extension == ".pb" || extension == ".proto" || extension == ".bin") {
             return std::make_unique<ProtobufPolygonLoader>();
+        } else if (extension == ".fgb") {
+            return std::make_unique<FlatGeobufPolygonLoader>();
+        } else if (extension == ".parquet") {
+            return std::make_unique<ParquetPolygonLoader>();
         }
 
         return nullptr;
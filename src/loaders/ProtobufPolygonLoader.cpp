@@ -1,116 +1,416 @@
 #include "ProtobufPolygonLoader.h"
-#include "cell_polygons.pb.h"
-#include <fstream>
-#include <iostream>
+#include "MappedFile.h"
+#include "ProtobufTileSource.h"
+#include "SegmentationV2.h"
+#include "Log.h"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
 
-bool ProtobufPolygonLoader::Load(const std::string& filepath,
-                                 std::vector<Polygon>& outPolygons,
-                                 std::map<int, SDL_Color>& outClassColors,
-                                 std::map<int, std::string>& outClassNames) {
-    // Read file into string
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open protobuf file: " << filepath << std::endl;
-        return false;
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Append the polygons of one version 2 tile to out, decoding its cells
+// into scratch. typeClasses maps the file's cell type table to class IDs.
+void ConvertTileV2(const SegmentationV2Reader::Tile& tile, float coordinateScale, int maxDeepZoomLevel,
+                   const std::vector<int>& typeClasses, SegmentationV2Reader::TileCells& scratch,
+                   PolygonStore& out) {
+    if (!SegmentationV2Reader::DecodeTile(tile, scratch)) {
+        PATHVIEW_LOG_WARNING("Skipping malformed tile at level " << tile.level << " (" << tile.x << ", "
+                             << tile.y << ")");
+        return;
     }
+    const double scaleFactor = std::pow(2, maxDeepZoomLevel - tile.level);
+    const double unit = 1.0 / coordinateScale;
+    const double tileX = static_cast<double>(tile.x) * tile.width;
+    const double tileY = static_cast<double>(tile.y) * tile.height;
+    auto toSlideX = [&](int64_t x) { return (x * unit + tileX) * scaleFactor; };
+    auto toSlideY = [&](int64_t y) { return (y * unit + tileY) * scaleFactor; };
 
-    // Parse protobuf message
-    DataProtoPolygon::SlideSegmentationData slideData;
-    if (!slideData.ParseFromIstream(&file)) {
-        std::cerr << "Failed to parse protobuf message" << std::endl;
-        return false;
+    const int32_t* coords = scratch.coords.data();
+    for (size_t cell = 0; cell < scratch.vertexCounts.size(); ++cell) {
+        const uint32_t vertexCount = scratch.vertexCounts[cell];
+        if (vertexCount < 3) {
+            coords += 2 * static_cast<size_t>(vertexCount);
+            continue;
+        }
+
+        const uint32_t type = scratch.classIds[cell];
+        out.BeginPolygon(type < typeClasses.size() ? typeClasses[type] : 0);
+
+        // The first pair is the cell origin, the rest steps from it
+        int64_t originX = coords[0];
+        int64_t originY = coords[1];
+        int64_t x = 0;
+        int64_t y = 0;
+        for (uint32_t k = 0; k < vertexCount; ++k, coords += 2) {
+            x += coords[0];
+            y += coords[1];
+            out.AddVertex(toSlideX(x), toSlideY(y));
+        }
+
+        const uint32_t index = out.EndPolygon();
+        if (!scratch.centroids.empty()) {
+            out.SetCentroid(index, toSlideX(originX + scratch.centroids[2 * cell]),
+                            toSlideY(originY + scratch.centroids[2 * cell + 1]));
+        }
+        if (!scratch.confidences.empty()) {
+            out.SetConfidence(index, scratch.confidences[cell]);
+        }
     }
+}
 
-    std::cout << "Slide ID: " << slideData.slide_id() << std::endl;
-    std::cout << "Tiles: " << slideData.tiles_size() << std::endl;
+// One tile's tissue segmentation map, whichever version it came from
+struct TileTissue {
+    int level;
+    double x;
+    double y;
+    int width;
+    int height;
+    int mapWidth;
+    int mapHeight;
+    const uint8_t* labels;
+    size_t size;
+    std::string dtype;
+};
 
-    // Clear output containers
-    outPolygons.clear();
-    outClassColors.clear();
-    outClassNames.clear();
+// Gather the tiles' uint8 maps into a TissueMap; nullptr if none is usable
+std::unique_ptr<TissueMap> BuildTissueMap(const std::vector<TileTissue>& tiles, int maxDeepZoomLevel,
+                                          int emptyClass, std::map<int, std::string> classNames) {
+    auto start = std::chrono::steady_clock::now();
 
-    int maxDeepZoomLevel = static_cast<int>(slideData.max_level());
+    // Level 0 at the finest resolution any tile's map has
+    double texelSize = 0.0;
+    int usable = 0;
+    std::set<std::string> skippedTypes;
+    auto usableMap = [&skippedTypes](const TileTissue& tile) {
+        if (tile.mapWidth <= 0 || tile.mapHeight <= 0 ||
+            tile.size < static_cast<size_t>(tile.mapWidth) * static_cast<size_t>(tile.mapHeight)) {
+            return false;
+        }
+        if (tile.dtype != "uint8") {
+            skippedTypes.insert(tile.dtype);
+            return false;
+        }
+        return true;
+    };
+    for (const TileTissue& tile : tiles) {
+        if (!usableMap(tile)) {
+            continue;
+        }
+        const double scaleFactor = std::pow(2, maxDeepZoomLevel - tile.level);
+        const double tileTexel = tile.width * scaleFactor / tile.mapWidth;
+        texelSize = usable == 0 ? tileTexel : std::min(texelSize, tileTexel);
+        ++usable;
+    }
+    for (const std::string& dtype : skippedTypes) {
+        PATHVIEW_LOG_WARNING("Skipping tissue maps of unsupported dtype: " << dtype);
+    }
+    if (usable == 0 || !(texelSize > 0.0)) {
+        return nullptr;
+    }
 
-    // First pass: collect unique cell types
-    std::set<std::string> uniqueCellTypes;
-    int totalMasks = 0;
+    auto tissueMap = std::make_unique<TissueMap>(texelSize, static_cast<uint8_t>(emptyClass));
+    for (const TileTissue& tile : tiles) {
+        if (!usableMap(tile)) {
+            continue;
+        }
+        const double scaleFactor = std::pow(2, maxDeepZoomLevel - tile.level);
+        Rect bounds(tile.x * tile.width * scaleFactor, tile.y * tile.height * scaleFactor,
+                    tile.width * scaleFactor, tile.height * scaleFactor);
+        tissueMap->AddRegion(bounds, tile.mapWidth, tile.mapHeight, tile.labels);
+    }
+    tissueMap->BuildLevels();
+    if (tissueMap->Empty()) {
+        return nullptr;  // No tissue anywhere
+    }
+    tissueMap->SetClassNames(std::move(classNames));
+
+    PATHVIEW_LOG_INFO("Tissue map: " << usable << " tiles, " << tissueMap->GetTileCount() << " label tiles in "
+                      << tissueMap->GetLevelCount() << " levels (" << (tissueMap->GetMemoryUsage() / (1024 * 1024))
+                      << " MB) in " << MillisecondsSince(start) << " ms");
+    return tissueMap;
+}
+
+}  // namespace
 
-    for (int i = 0; i < slideData.tiles_size(); ++i) {
-        const auto& tile = slideData.tiles(i);
-        totalMasks += tile.masks_size();
+std::unique_ptr<TissueMap> ProtobufPolygonLoader::ReadTissueMap(const ProtobufTileSource& slideData) {
+    std::vector<TileTissue> tiles;
+    for (const auto& tile : slideData.GetTiles()) {
+        if (tile.tissueData) {
+            tiles.push_back({tile.level, tile.x, tile.y, tile.width, tile.height, tile.tissueWidth,
+                             tile.tissueHeight, tile.tissueData, tile.tissueSize, tile.tissueDtype});
+        }
+    }
+    return BuildTissueMap(tiles, slideData.GetMaxLevel(), slideData.GetTissueEmptyClass(),
+                          slideData.GetTissueClassMapping());
+}
 
-        for (int j = 0; j < tile.masks_size(); ++j) {
-            const auto& mask = tile.masks(j);
-            uniqueCellTypes.insert(mask.cell_type());
+std::unique_ptr<TissueMap> ProtobufPolygonLoader::ReadTissueMap(const SegmentationV2Reader& slideData) {
+    std::vector<TileTissue> tiles;
+    for (const auto& tile : slideData.tiles) {
+        if (tile.tissueData) {
+            tiles.push_back({tile.level, tile.x, tile.y, tile.width, tile.height, tile.tissueWidth,
+                             tile.tissueHeight, tile.tissueData, tile.tissueSize, tile.tissueDtype});
         }
     }
+    return BuildTissueMap(tiles, slideData.maxLevel, slideData.tissueEmptyClass, slideData.tissueClassMapping);
+}
 
-    std::cout << "Total polygons: " << totalMasks << std::endl;
-    std::cout << "Unique cell types: " << uniqueCellTypes.size() << std::endl;
+std::unique_ptr<ProtobufTileSource> ProtobufPolygonLoader::OpenTiles(const std::string& filepath,
+                                                                  std::map<int, SDL_Color>& outClassColors,
+                                                                  std::map<int, std::string>& outClassNames,
+                                                                  size_t cacheBytes) {
+    auto indexStart = std::chrono::steady_clock::now();
+    auto source = std::make_unique<ProtobufTileSource>(cacheBytes);
+    if (!source->Open(filepath)) {
+        PATHVIEW_LOG_ERROR("Failed to index protobuf file: " << source->GetError());
+        return nullptr;
+    }
+    PATHVIEW_LOG_INFO("Slide ID: " << source->GetSlideId());
+    PATHVIEW_LOG_INFO("Tiles: " << source->GetTiles().size());
+    PATHVIEW_LOG_INFO("Indexed in " << MillisecondsSince(indexStart) << " ms");
+    PATHVIEW_LOG_INFO("Total polygons: " << source->GetCellCount());
 
-    // Build class name to ID mapping
     std::map<std::string, int> classMapping;
-    BuildClassMapping(uniqueCellTypes, classMapping);
+    BuildClasses(source->GetCellTypes(), classMapping, outClassColors, outClassNames);
+    source->SetClassMapping(std::move(classMapping));
+    return source;
+}
+
+void ProtobufPolygonLoader::ReadClasses(const SegmentationV2Reader& slideData,
+                                        std::vector<int>& outTypeClasses,
+                                        std::map<int, SDL_Color>& outClassColors,
+                                        std::map<int, std::string>& outClassNames) {
+    size_t totalMasks = 0;
+    for (const auto& tile : slideData.tiles) {
+        totalMasks += tile.cellCount;
+    }
+    PATHVIEW_LOG_INFO("Total polygons: " << totalMasks);
+
+    // The file's string table, which may repeat a type
+    ClassNameTable uniqueTypes;
+    std::vector<uint32_t> entryTypes;
+    entryTypes.reserve(slideData.cellTypes.size());
+    for (const std::string& type : slideData.cellTypes) {
+        entryTypes.push_back(uniqueTypes.Intern(type));
+    }
+    std::map<std::string, int> mapping;
+    const std::vector<int> classIds = BuildClasses(uniqueTypes, mapping, outClassColors, outClassNames);
+    outTypeClasses.clear();
+    for (uint32_t type : entryTypes) {
+        outTypeClasses.push_back(classIds[type]);
+    }
+}
+
+std::vector<int> ProtobufPolygonLoader::BuildClasses(const ClassNameTable& uniqueCellTypes,
+                                                     std::map<std::string, int>& outMapping,
+                                                     std::map<int, SDL_Color>& outClassColors,
+                                                     std::map<int, std::string>& outClassNames) {
+    outClassColors.clear();
+    outClassNames.clear();
+    PATHVIEW_LOG_INFO("Unique cell types: " << uniqueCellTypes.Size());
+
+    // Build class name to ID mapping
+    std::vector<int> classIds = BuildClassMapping(uniqueCellTypes, outMapping);
 
     // Build reverse mapping (ID to name) for output
-    for (const auto& pair : classMapping) {
+    for (const auto& pair : outMapping) {
         outClassNames[pair.second] = pair.first;
     }
 
     // Print mapping
-    for (const auto& pair : classMapping) {
-        std::cout << "  " << pair.first << " -> Class " << pair.second << std::endl;
+    for (const auto& pair : outMapping) {
+        PATHVIEW_LOG_INFO("  " << pair.first << " -> Class " << pair.second);
     }
 
     // Generate colors based on class names
-    std::cout << "Assigning colors to cell types:" << std::endl;
-    GenerateColorsFromClassNames(classMapping, outClassColors);
+    PATHVIEW_LOG_INFO("Assigning colors to cell types:");
+    GenerateColorsFromClassNames(outMapping, outClassColors);
+    return classIds;
+}
 
-    // Second pass: extract polygons from all tiles
-    outPolygons.reserve(totalMasks);
+bool ProtobufPolygonLoader::Load(const std::string& filepath,
+                                 PolygonStore& outPolygons,
+                                 std::map<int, SDL_Color>& outClassColors,
+                                 std::map<int, std::string>& outClassNames) {
+    {
+        MappedFile input(filepath);
+        if (input.Data() && SegmentationV2Reader::IsV2(input.Data(), input.Size())) {
+            return LoadV2(input, outPolygons, outClassColors, outClassNames);
+        }
+    }
 
-    for (int i = 0; i < slideData.tiles_size(); ++i) {
-        const auto& tile = slideData.tiles(i);
+    // Index the tiles, then parse and convert them on worker threads
+    std::unique_ptr<ProtobufTileSource> source = OpenTiles(filepath, outClassColors, outClassNames);
+    if (!source) {
+        return false;
+    }
 
-        for (int j = 0; j < tile.masks_size(); ++j) {
-            const auto& mask = tile.masks(j);
+    outPolygons.Clear();
+    tissueMap_ = ReadTissueMap(*source);
 
-            // Skip if no coordinates
-            if (mask.coordinates_size() < 3) {
-                continue;
+    auto convertStart = std::chrono::steady_clock::now();
+    const size_t tileCount = source->GetTiles().size();
+    std::atomic<bool> failed{false};
+    int workerCount = ConvertInParallel(tileCount, source->GetCellCount(), source->GetVertexCount(),
+                                        [&](size_t begin, size_t end, PolygonStore& out) {
+        for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+            if (!source->DecodeTile(i, out)) {
+                PATHVIEW_LOG_ERROR("Failed to parse tile " << i << " of " << filepath);
+                failed = true;
             }
+        }
+    }, outPolygons);
+    if (failed) {
+        outPolygons.Clear();
+        tissueMap_.reset();
+        return false;
+    }
 
-            double scaleFactor = std::pow(2, maxDeepZoomLevel - tile.level());
+    PATHVIEW_LOG_INFO("Parsed and converted " << tileCount << " tiles on " << workerCount << " thread(s) in "
+                      << MillisecondsSince(convertStart) << " ms");
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices)");
+    PATHVIEW_LOG_INFO("==================================\n");
 
-            Polygon polygon;
-            polygon.classId = classMapping[mask.cell_type()];
+    return true;
+}
 
-            // Convert Point (float) to Vec2 (double)
-            polygon.vertices.reserve(mask.coordinates_size());
-            for (int k = 0; k < mask.coordinates_size(); ++k) {
-                const auto& point = mask.coordinates(k);
-                polygon.vertices.emplace_back(
-                    static_cast<double>((point.x() + tile.x() * tile.width()) * scaleFactor),
-                    static_cast<double>((point.y() + tile.y() * tile.height()) * scaleFactor)
-                );
-            }
+bool ProtobufPolygonLoader::LoadV2(const MappedFile& input,
+                                   PolygonStore& outPolygons,
+                                   std::map<int, SDL_Color>& outClassColors,
+                                   std::map<int, std::string>& outClassNames) {
+    auto parseStart = std::chrono::steady_clock::now();
+    SegmentationV2Reader slideData;
+    if (!slideData.Parse(input.Data(), input.Size())) {
+        PATHVIEW_LOG_ERROR("Failed to parse version 2 segmentation: " << slideData.GetError());
+        return false;
+    }
+    PATHVIEW_LOG_INFO("Slide ID: " << slideData.slideId);
+    PATHVIEW_LOG_INFO("Tiles: " << slideData.tiles.size() << " (version 2)");
+    PATHVIEW_LOG_INFO("Indexed in " << MillisecondsSince(parseStart) << " ms");
+
+    outPolygons.Clear();
+    std::vector<int> typeClasses;
+    ReadClasses(slideData, typeClasses, outClassColors, outClassNames);
+    tissueMap_ = ReadTissueMap(slideData);
+
+    size_t totalMasks = 0;
+    size_t totalVertices = 0;
+    for (const auto& tile : slideData.tiles) {
+        totalMasks += tile.cellCount;
+        totalVertices += tile.vertexCount;
+    }
+
+    auto convertStart = std::chrono::steady_clock::now();
+    const size_t tileCount = slideData.tiles.size();
+    int workerCount = ConvertInParallel(tileCount, totalMasks, totalVertices, [&](size_t begin, size_t end, PolygonStore& out) {
+        SegmentationV2Reader::TileCells scratch;
+        for (size_t i = begin; i < end; ++i) {
+            ConvertTileV2(slideData.tiles[i], slideData.coordinateScale, slideData.maxLevel, typeClasses, scratch, out);
+        }
+    }, outPolygons);
+
+    PATHVIEW_LOG_INFO("Converted " << tileCount << " tiles on " << workerCount << " thread(s) in "
+                      << MillisecondsSince(convertStart) << " ms");
+    PATHVIEW_LOG_INFO("Successfully loaded " << outPolygons.Size() << " polygons ("
+                      << outPolygons.GetTotalVertexCount() << " vertices)");
+    PATHVIEW_LOG_INFO("==================================\n");
 
-            // Compute bounding box
-            polygon.ComputeBoundingBox();
+    return true;
+}
 
-            outPolygons.push_back(std::move(polygon));
+bool ProtobufPolygonLoader::LoadStreaming(const std::string& filepath,
+                                          const PolygonStreamCallbacks& callbacks) {
+    {
+        MappedFile input(filepath);
+        if (input.Data() && SegmentationV2Reader::IsV2(input.Data(), input.Size())) {
+            return LoadStreamingV2(input, callbacks);
         }
+    }
 
-        // Progress update every 10 tiles
-        if ((i + 1) % 10 == 0) {
-            std::cout << "  Processed " << (i + 1) << " / " << slideData.tiles_size()
-                      << " tiles..." << std::endl;
+    // Only the index is read up front: each tile is parsed as its batch comes
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    std::unique_ptr<ProtobufTileSource> source = OpenTiles(filepath, classColors, classNames);
+    if (!source) {
+        return false;
+    }
+    if (callbacks.onClasses) {
+        callbacks.onClasses(classColors, classNames);
+    }
+    if (callbacks.onTissueMap) {
+        std::unique_ptr<TissueMap> tissueMap = ReadTissueMap(*source);
+        if (tissueMap) {
+            callbacks.onTissueMap(std::move(tissueMap));
         }
     }
 
-    std::cout << "Successfully loaded " << outPolygons.size() << " polygons" << std::endl;
-    std::cout << "==================================\n" << std::endl;
+    std::vector<Rect> tileBounds;
+    tileBounds.reserve(source->GetTiles().size());
+    for (const auto& tile : source->GetTiles()) {
+        tileBounds.push_back(tile.bounds);
+    }
 
-    return true;
+    auto convertStart = std::chrono::steady_clock::now();
+    size_t failedTiles = 0;
+    bool complete = StreamTiles(tileBounds, [&](size_t tile, PolygonStore& out) {
+        if (!source->DecodeTile(tile, out)) {
+            ++failedTiles;
+        }
+    }, callbacks);
+    if (failedTiles > 0) {
+        PATHVIEW_LOG_ERROR("Failed to parse " << failedTiles << " tile(s) of " << filepath);
+    }
+
+    PATHVIEW_LOG_INFO((complete ? "Streamed " : "Cancelled streaming ") << tileBounds.size()
+                      << " tiles after " << MillisecondsSince(convertStart) << " ms");
+    return complete && failedTiles == 0;
+}
+
+bool ProtobufPolygonLoader::LoadStreamingV2(const MappedFile& input, const PolygonStreamCallbacks& callbacks) {
+    SegmentationV2Reader slideData;
+    if (!slideData.Parse(input.Data(), input.Size())) {
+        PATHVIEW_LOG_ERROR("Failed to parse version 2 segmentation: " << slideData.GetError());
+        return false;
+    }
+
+    std::vector<int> typeClasses;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    ReadClasses(slideData, typeClasses, classColors, classNames);
+    if (callbacks.onClasses) {
+        callbacks.onClasses(classColors, classNames);
+    }
+    if (callbacks.onTissueMap) {
+        std::unique_ptr<TissueMap> tissueMap = ReadTissueMap(slideData);
+        if (tissueMap) {
+            callbacks.onTissueMap(std::move(tissueMap));
+        }
+    }
+
+    std::vector<Rect> tileBounds;
+    tileBounds.reserve(slideData.tiles.size());
+    for (const auto& tile : slideData.tiles) {
+        double scaleFactor = std::pow(2, slideData.maxLevel - tile.level);
+        tileBounds.emplace_back(static_cast<double>(tile.x) * tile.width * scaleFactor,
+                                static_cast<double>(tile.y) * tile.height * scaleFactor,
+                                tile.width * scaleFactor, tile.height * scaleFactor);
+    }
+
+    auto convertStart = std::chrono::steady_clock::now();
+    SegmentationV2Reader::TileCells scratch;
+    bool complete = StreamTiles(tileBounds, [&](size_t tile, PolygonStore& out) {
+        ConvertTileV2(slideData.tiles[tile], slideData.coordinateScale, slideData.maxLevel, typeClasses, scratch, out);
+    }, callbacks);
+
+    PATHVIEW_LOG_INFO((complete ? "Streamed " : "Cancelled streaming ") << tileBounds.size()
+                      << " tiles after " << MillisecondsSince(convertStart) << " ms");
+    return complete;
 }
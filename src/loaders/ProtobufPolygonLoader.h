@@ -2,31 +2,113 @@
 
 #include "PolygonLoader.h"
 #include "PolygonOverlay.h"
+#include "ProtobufTileSource.h"
+#include "TissueMap.h"
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <SDL2/SDL.h>
 
+class MappedFile;
+class SegmentationV2Reader;
+
 /**
  * Protocol Buffer Polygon File Loader
  *
  * Loads polygon data from protobuf-serialized SlideSegmentationData files.
  * The file format uses the histowmics.SlideSegmentationData message type.
+ * Files are indexed tile by tile (ProtobufTileSource) rather than parsed
+ * as one message, so Load() parses tiles on worker threads and
+ * LoadStreaming() parses each tile only when its batch is due.
+ * Version 2 files (SlideSegmentationDataV2, packed delta-encoded cells)
+ * are recognised by their first field and read through
+ * SegmentationV2Reader instead, in place from the mapped file.
  *
  * Cell types (strings) are automatically mapped to integer class IDs.
+ * The per-tile tissue segmentation maps (uint8 labels) are gathered into
+ * a TissueMap.
  */
 class ProtobufPolygonLoader: public PolygonLoader {
 public:
     /**
      * Load polygons from protobuf file
      * @param filepath Path to .pb or .protobuf file
-     * @param outPolygons Output vector of polygons
+     * @param outPolygons Output polygon store
      * @param outClassColors Output map of class ID to color
      * @param outClassNames Output map of class ID to class name
      * @return true if successful, false otherwise
      */
     bool Load(const std::string& filepath,
-                    std::vector<Polygon>& outPolygons,
+                    PolygonStore& outPolygons,
                     std::map<int, SDL_Color>& outClassColors,
                     std::map<int, std::string>& outClassNames) override;
+
+    /**
+     * Stream polygons from protobuf file: indexed, then parsed and
+     * converted STREAM_BATCH_TILES tiles at a time around the focus
+     * @param filepath Path to .pb or .protobuf file
+     * @param callbacks Receivers of the class tables and batches
+     * @return true if the whole file was loaded, false on error or cancel
+     */
+    bool LoadStreaming(const std::string& filepath,
+                       const PolygonStreamCallbacks& callbacks) override;
+
+    /**
+     * Tissue map of the last Load(), if its file had uint8 tissue maps
+     */
+    std::unique_ptr<TissueMap> TakeTissueMap() override { return std::move(tissueMap_); }
+
+    /**
+     * Open a version 1 file for random access: indexed once, its tiles
+     * parsed on demand (see ProtobufTileSource)
+     * @param filepath Path to .pb or .protobuf file
+     * @param outClassColors Output map of class ID to color
+     * @param outClassNames Output map of class ID to class name
+     * @param cacheBytes Budget of the source's decoded tile LRU
+     * @return The source, with its class mapping set, or nullptr on error
+     */
+    static std::unique_ptr<ProtobufTileSource> OpenTiles(const std::string& filepath,
+                                                         std::map<int, SDL_Color>& outClassColors,
+                                                         std::map<int, std::string>& outClassNames,
+                                                         size_t cacheBytes = ProtobufTileSource::DEFAULT_CACHE_BYTES);
+
+private:
+    /**
+     * Load and LoadStreaming for a version 2 file
+     */
+    bool LoadV2(const MappedFile& input,
+                PolygonStore& outPolygons,
+                std::map<int, SDL_Color>& outClassColors,
+                std::map<int, std::string>& outClassNames);
+    bool LoadStreamingV2(const MappedFile& input, const PolygonStreamCallbacks& callbacks);
+
+    /**
+     * Gather the tissue segmentation maps of an indexed file
+     * @param slideData Indexed file
+     * @return The map, or nullptr if no tile has a usable one
+     */
+    static std::unique_ptr<TissueMap> ReadTissueMap(const ProtobufTileSource& slideData);
+    static std::unique_ptr<TissueMap> ReadTissueMap(const SegmentationV2Reader& slideData);
+
+    /**
+     * Class tables of a version 2 file
+     * @param outTypeClasses Output class ID of each entry of its cell type table
+     */
+    static void ReadClasses(const SegmentationV2Reader& slideData,
+                            std::vector<int>& outTypeClasses,
+                            std::map<int, SDL_Color>& outClassColors,
+                            std::map<int, std::string>& outClassNames);
+
+    /**
+     * Class IDs, names and colors for a file's unique cell types
+     * @return Class ID of each interned type, by index
+     */
+    static std::vector<int> BuildClasses(const ClassNameTable& uniqueCellTypes,
+                                         std::map<std::string, int>& outMapping,
+                                         std::map<int, SDL_Color>& outClassColors,
+                                         std::map<int, std::string>& outClassNames);
+
+    std::unique_ptr<TissueMap> tissueMap_;
 };
@@ -0,0 +1,540 @@
+#include "ProtobufTileSource.h"
+#include "cell_polygons.pb.h"
+#include "Log.h"
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using google::protobuf::io::CodedInputStream;
+
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_FIXED64 = 1;
+constexpr uint32_t WIRE_BYTES = 2;
+constexpr uint32_t WIRE_FIXED32 = 5;
+
+// CodedInputStream reads at most INT_MAX bytes: past this position the
+// scan starts a new stream at the next top-level field
+constexpr int REBASE_BYTES = 1 << 30;
+
+// Arena blocks of one parsed tile
+constexpr size_t ARENA_START_BLOCK_BYTES = 64 * 1024;
+constexpr size_t ARENA_MAX_BLOCK_BYTES = 16 << 20;
+
+// Skip the value of a field whose tag was just read
+bool SkipField(CodedInputStream& in, uint32_t tag) {
+    switch (tag & 7) {
+    case WIRE_VARINT: {
+        uint64_t value;
+        return in.ReadVarint64(&value);
+    }
+    case WIRE_FIXED64:
+        return in.Skip(8);
+    case WIRE_BYTES: {
+        uint32_t length;
+        return in.ReadVarint32(&length) && length <= INT_MAX && in.Skip(static_cast<int>(length));
+    }
+    case WIRE_FIXED32:
+        return in.Skip(4);
+    default:
+        return false;  // Groups: not in the schema
+    }
+}
+
+bool ReadInt32(CodedInputStream& in, uint32_t tag, int32_t& out) {
+    if ((tag & 7) != WIRE_VARINT) {
+        return SkipField(in, tag);
+    }
+    uint64_t value;
+    if (!in.ReadVarint64(&value)) {
+        return false;
+    }
+    out = static_cast<int32_t>(value);
+    return true;
+}
+
+bool ReadFloat(CodedInputStream& in, uint32_t tag, float& out) {
+    if ((tag & 7) != WIRE_FIXED32) {
+        return SkipField(in, tag);
+    }
+    uint32_t bits;
+    if (!in.ReadLittleEndian32(&bits)) {
+        return false;
+    }
+    std::memcpy(&out, &bits, sizeof(out));
+    return true;
+}
+
+bool ReadString(CodedInputStream& in, uint32_t tag, std::string& out) {
+    if ((tag & 7) != WIRE_BYTES) {
+        return SkipField(in, tag);
+    }
+    uint32_t length;
+    return in.ReadVarint32(&length) && length <= INT_MAX && in.ReadString(&out, static_cast<int>(length));
+}
+
+// Step into a length-delimited field whose tag was just read
+bool Enter(CodedInputStream& in, CodedInputStream::Limit& outLimit, uint32_t* outLength = nullptr) {
+    uint32_t length;
+    if (!in.ReadVarint32(&length) || length > static_cast<uint32_t>(in.BytesUntilLimit())) {
+        return false;
+    }
+    outLimit = in.PushLimit(static_cast<int>(length));
+    if (outLength) {
+        *outLength = length;
+    }
+    return true;
+}
+
+// Step out of it once its fields are read (ReadTag() returned 0)
+bool Leave(CodedInputStream& in, CodedInputStream::Limit limit) {
+    if (in.BytesUntilLimit() != 0) {
+        return false;  // Stopped on a malformed field
+    }
+    in.PopLimit(limit);
+    return true;
+}
+
+}  // namespace
+
+ProtobufTileSource::ProtobufTileSource(size_t cacheBytes, size_t threadCount)
+    : capacity_(cacheBytes) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount_ = std::min(threadCount, MAX_THREADS);
+}
+
+ProtobufTileSource::~ProtobufTileSource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ProtobufTileSource::Open(const std::string& filepath) {
+    if (file_) {
+        error_ = "Source already open";
+        return false;
+    }
+    file_ = std::make_unique<MappedFile>(filepath);
+    if (!file_->Data()) {
+        error_ = "Cannot map " + filepath;
+        return false;
+    }
+    return Index();
+}
+
+bool ProtobufTileSource::Index() {
+    const uint8_t* data = file_->Data();
+    const uint64_t size = file_->Size();
+    std::string cellType;  // Scratch: the table copies only new types
+
+    // Index the tile whose length-delimited value is next
+    auto indexTile = [&](CodedInputStream& in, uint64_t base) {
+        CodedInputStream::Limit tileLimit;
+        uint32_t length;
+        if (!Enter(in, tileLimit, &length)) {
+            return false;
+        }
+        Tile tile;
+        tile.offset = base + static_cast<uint64_t>(in.CurrentPosition());
+        tile.size = length;
+
+        uint32_t tag;
+        while ((tag = in.ReadTag()) != 0) {
+            bool ok = true;
+            switch (tag >> 3) {
+            case 2: ok = ReadInt32(in, tag, tile.level); break;
+            case 3: ok = ReadFloat(in, tag, tile.x); break;
+            case 4: ok = ReadFloat(in, tag, tile.y); break;
+            case 5: ok = ReadInt32(in, tag, tile.width); break;
+            case 6: ok = ReadInt32(in, tag, tile.height); break;
+            case 7: {
+                // A cell: its type and how many points, nothing else
+                CodedInputStream::Limit cellLimit;
+                if ((tag & 7) != WIRE_BYTES) {
+                    ok = SkipField(in, tag);
+                    break;
+                }
+                ok = Enter(in, cellLimit);
+                while (ok && (tag = in.ReadTag()) != 0) {
+                    if (tag >> 3 == 2) {
+                        ok = ReadString(in, tag, cellType);
+                        cellTypes_.Intern(cellType);
+                    } else {
+                        tile.vertexCount += (tag >> 3 == 4) ? 1 : 0;
+                        ok = SkipField(in, tag);
+                    }
+                }
+                ok = ok && Leave(in, cellLimit);
+                ++tile.cellCount;
+                break;
+            }
+            case 8: {
+                CodedInputStream::Limit mapLimit;
+                if ((tag & 7) != WIRE_BYTES) {
+                    ok = SkipField(in, tag);
+                    break;
+                }
+                ok = Enter(in, mapLimit);
+                while (ok && (tag = in.ReadTag()) != 0) {
+                    switch (tag >> 3) {
+                    case 1: {
+                        // The labels stay in the mapping
+                        uint32_t labels;
+                        if ((tag & 7) != WIRE_BYTES) {
+                            ok = SkipField(in, tag);
+                            break;
+                        }
+                        ok = in.ReadVarint32(&labels) && labels <= static_cast<uint32_t>(in.BytesUntilLimit());
+                        if (ok) {
+                            tile.tissueData = data + base + static_cast<uint64_t>(in.CurrentPosition());
+                            tile.tissueSize = labels;
+                            ok = in.Skip(static_cast<int>(labels));
+                        }
+                        break;
+                    }
+                    case 2: ok = ReadInt32(in, tag, tile.tissueWidth); break;
+                    case 3: ok = ReadInt32(in, tag, tile.tissueHeight); break;
+                    case 4: ok = ReadString(in, tag, tile.tissueDtype); break;
+                    default: ok = SkipField(in, tag); break;
+                    }
+                }
+                ok = ok && Leave(in, mapLimit);
+                break;
+            }
+            default:
+                ok = SkipField(in, tag);
+                break;
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (!Leave(in, tileLimit)) {
+            return false;
+        }
+
+        cellCount_ += tile.cellCount;
+        vertexCount_ += tile.vertexCount;
+        tiles_.push_back(std::move(tile));
+        return true;
+    };
+
+    // A tissue_class_mapping entry
+    auto indexClass = [&](CodedInputStream& in) {
+        CodedInputStream::Limit entryLimit;
+        if (!Enter(in, entryLimit)) {
+            return false;
+        }
+        int32_t label = 0;
+        std::string name;
+        uint32_t tag;
+        bool ok = true;
+        while (ok && (tag = in.ReadTag()) != 0) {
+            switch (tag >> 3) {
+            case 1: ok = ReadInt32(in, tag, label); break;
+            case 2: ok = ReadString(in, tag, name); break;
+            default: ok = SkipField(in, tag); break;
+            }
+        }
+        if (!ok || !Leave(in, entryLimit)) {
+            return false;
+        }
+        tissueClassMapping_[label] = std::move(name);
+        return true;
+    };
+
+    uint64_t base = 0;
+    while (base < size) {
+        const int window = static_cast<int>(std::min<uint64_t>(size - base, INT_MAX));
+        CodedInputStream in(data + base, window);
+        in.PushLimit(window);
+
+        bool end = false;
+        while (!end && in.CurrentPosition() < REBASE_BYTES) {
+            uint32_t tag = in.ReadTag();
+            bool ok = true;
+            switch (tag >> 3) {
+            case 0: end = true; break;  // End of the file, or an invalid tag
+            case 1: ok = ReadString(in, tag, slideId_); break;
+            case 4: ok = ReadInt32(in, tag, maxLevel_); break;
+            case 7: ok = ReadInt32(in, tag, tissueEmptyClass_); break;
+            case 8: ok = (tag & 7) == WIRE_BYTES ? indexTile(in, base) : SkipField(in, tag); break;
+            case 9: ok = (tag & 7) == WIRE_BYTES ? indexClass(in) : SkipField(in, tag); break;
+            default: ok = SkipField(in, tag); break;
+            }
+            if (!ok || (end && in.BytesUntilLimit() != 0)) {
+                error_ = "Malformed segmentation file near byte " +
+                         std::to_string(base + static_cast<uint64_t>(in.CurrentPosition()));
+                return false;
+            }
+        }
+        base += static_cast<uint64_t>(in.CurrentPosition());
+    }
+
+    // Every type is known: decoding only looks them up
+    cellTypes_.Freeze();
+
+    // max_level may follow the tiles: place them once it is known
+    for (Tile& tile : tiles_) {
+        double scaleFactor = std::pow(2, maxLevel_ - tile.level);
+        tile.bounds = Rect(static_cast<double>(tile.x) * tile.width * scaleFactor,
+                           static_cast<double>(tile.y) * tile.height * scaleFactor,
+                           tile.width * scaleFactor, tile.height * scaleFactor);
+    }
+    return true;
+}
+
+void ProtobufTileSource::SetClassMapping(std::map<std::string, int> classMapping) {
+    typeClasses_.assign(cellTypes_.Size(), 0);
+    for (uint32_t i = 0; i < cellTypes_.Size(); ++i) {
+        auto it = classMapping.find(cellTypes_.GetName(i));
+        if (it != classMapping.end()) {
+            typeClasses_[i] = it->second;
+        }
+    }
+}
+
+void ProtobufTileSource::QueryTiles(const Rect& region, std::vector<size_t>& outTiles) const {
+    // A linear pass: files hold thousands of tiles, not millions
+    outTiles.clear();
+    for (size_t i = 0; i < tiles_.size(); ++i) {
+        if (tiles_[i].bounds.Intersects(region)) {
+            outTiles.push_back(i);
+        }
+    }
+}
+
+void ProtobufTileSource::ConvertTile(const DataProtoPolygon::TileSegmentationData& tile, int maxDeepZoomLevel,
+                                     const ClassNameTable& cellTypes, const std::vector<int>& typeClasses,
+                                     PolygonStore& out) {
+    double scaleFactor = std::pow(2, maxDeepZoomLevel - tile.level());
+
+    for (int j = 0; j < tile.masks_size(); ++j) {
+        const auto& mask = tile.masks(j);
+
+        // Skip if no coordinates
+        if (mask.coordinates_size() < 3) {
+            continue;
+        }
+
+        const uint32_t type = cellTypes.Find(mask.cell_type());
+        out.BeginPolygon(type < typeClasses.size() ? typeClasses[type] : 0);
+
+        // Tile-local points to slide coordinates
+        auto toSlideX = [&](float x) { return static_cast<double>((x + tile.x() * tile.width()) * scaleFactor); };
+        auto toSlideY = [&](float y) { return static_cast<double>((y + tile.y() * tile.height()) * scaleFactor); };
+        for (int k = 0; k < mask.coordinates_size(); ++k) {
+            const auto& point = mask.coordinates(k);
+            out.AddVertex(toSlideX(point.x()), toSlideY(point.y()));
+        }
+
+        // Keep the segmentation's own centroid and confidence with the cell
+        const uint32_t index = out.EndPolygon();
+        if (mask.has_centroid()) {
+            out.SetCentroid(index, toSlideX(mask.centroid().x()), toSlideY(mask.centroid().y()));
+        }
+        if (mask.has_confidence()) {
+            out.SetConfidence(index, mask.confidence());
+        }
+    }
+}
+
+bool ProtobufTileSource::DecodeTile(size_t tile, PolygonStore& out) const {
+    if (tile >= tiles_.size()) {
+        return false;
+    }
+    const Tile& entry = tiles_[tile];
+
+    google::protobuf::ArenaOptions options;
+    options.start_block_size = ARENA_START_BLOCK_BYTES;
+    options.max_block_size = ARENA_MAX_BLOCK_BYTES;
+    google::protobuf::Arena arena(options);
+    auto* message = google::protobuf::Arena::Create<DataProtoPolygon::TileSegmentationData>(&arena);
+    if (!message->ParseFromArray(file_->Data() + entry.offset, static_cast<int>(entry.size))) {
+        return false;
+    }
+    ConvertTile(*message, maxLevel_, cellTypes_, typeClasses_, out);
+    return true;
+}
+
+std::shared_ptr<const PolygonStore> ProtobufTileSource::GetTile(size_t tile) {
+    if (tile >= tiles_.size()) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        auto it = entries_.find(tile);
+        if (it == entries_.end()) {
+            break;
+        }
+        if (it->second.ready) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            return it->second.polygons;
+        }
+        // A worker is decoding it
+        tileReady_.wait(lock);
+    }
+    entries_.emplace(tile, Entry());
+    lock.unlock();
+    return DecodeAndPublish(tile);
+}
+
+std::shared_ptr<const PolygonStore> ProtobufTileSource::TryGetTile(size_t tile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(tile);
+    if (it == entries_.end() || !it->second.ready) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.polygons;
+}
+
+std::shared_ptr<const PolygonStore> ProtobufTileSource::DecodeAndPublish(size_t tile) {
+    auto polygons = std::make_shared<PolygonStore>();
+    polygons->Reserve(tiles_[tile].cellCount, tiles_[tile].vertexCount);
+    size_t bytes = 0;
+    if (DecodeTile(tile, *polygons)) {
+        bytes = polygons->GetVertexMemoryUsage();
+    } else {
+        PATHVIEW_LOG_WARNING("Failed to parse segmentation tile " << tile);
+        polygons.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Still there: only decoded tiles are evicted
+        Entry& entry = entries_[tile];
+        entry.polygons = polygons;
+        entry.bytes = bytes;
+        entry.ready = true;
+        lru_.push_front(tile);
+        entry.lru = lru_.begin();
+        cachedBytes_ += bytes;
+        ++decodeCount_;
+        EvictLocked();
+    }
+    tileReady_.notify_all();
+    return polygons;
+}
+
+void ProtobufTileSource::EvictLocked() {
+    auto it = lru_.end();
+    while (cachedBytes_ > capacity_ && it != lru_.begin()) {
+        --it;
+        if (pinned_.count(*it)) {
+            continue;
+        }
+        auto entry = entries_.find(*it);
+        cachedBytes_ -= entry->second.bytes;
+        entries_.erase(entry);
+        it = lru_.erase(it);
+    }
+}
+
+void ProtobufTileSource::Request(const Rect& viewport, double prefetchMargin) {
+    std::vector<size_t> visible;
+    std::vector<size_t> ring;
+    QueryTiles(viewport, visible);
+    QueryTiles(Rect(viewport.x - prefetchMargin, viewport.y - prefetchMargin, viewport.width + 2 * prefetchMargin,
+                    viewport.height + 2 * prefetchMargin),
+               ring);
+
+    // Nearest the viewport center first, in both bands
+    const double centerX = viewport.x + viewport.width / 2;
+    const double centerY = viewport.y + viewport.height / 2;
+    auto distance = [&](size_t tile) {
+        const Rect& bounds = tiles_[tile].bounds;
+        double dx = bounds.x + bounds.width / 2 - centerX;
+        double dy = bounds.y + bounds.height / 2 - centerY;
+        return dx * dx + dy * dy;
+    };
+    auto nearer = [&](size_t a, size_t b) { return distance(a) < distance(b); };
+    std::sort(visible.begin(), visible.end(), nearer);
+    std::sort(ring.begin(), ring.end(), nearer);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        pinned_.clear();
+        for (size_t tile : visible) {
+            pinned_.insert(tile);
+            if (!entries_.count(tile)) {
+                queue_.push_back(tile);
+            }
+        }
+        for (size_t tile : ring) {
+            if (!pinned_.count(tile) && !entries_.count(tile)) {
+                queue_.push_back(tile);
+            }
+        }
+        if (queue_.empty()) {
+            return;
+        }
+        if (workers_.empty()) {
+            StartWorkers();
+        }
+    }
+    workAvailable_.notify_all();
+}
+
+void ProtobufTileSource::StartWorkers() {
+    workers_.reserve(threadCount_);
+    for (size_t i = 0; i < threadCount_; ++i) {
+        workers_.emplace_back(&ProtobufTileSource::WorkerLoop, this);
+    }
+}
+
+void ProtobufTileSource::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (queue_.empty() && busyWorkers_ == 0) {
+            idle_.notify_all();
+        }
+        workAvailable_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        size_t tile = queue_.front();
+        queue_.pop_front();
+        if (entries_.count(tile)) {
+            continue;  // Cached, or GetTile() is decoding it
+        }
+        entries_.emplace(tile, Entry());
+        ++busyWorkers_;
+        lock.unlock();
+        DecodeAndPublish(tile);
+        lock.lock();
+        --busyWorkers_;
+    }
+}
+
+void ProtobufTileSource::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && busyWorkers_ == 0; });
+}
+
+size_t ProtobufTileSource::GetCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cachedBytes_;
+}
+
+size_t ProtobufTileSource::GetCachedTileCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+size_t ProtobufTileSource::GetDecodeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decodeCount_;
+}
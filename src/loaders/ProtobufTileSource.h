@@ -0,0 +1,202 @@
+#pragma once
+
+#include "ClassNameTable.h"
+#include "MappedFile.h"
+#include "PolygonStore.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace DataProtoPolygon {
+class TileSegmentationData;
+}
+
+/**
+ * Random access to the tiles of a version 1 segmentation file
+ * (SlideSegmentationData).
+ *
+ * Open() maps the file and walks it once with CodedInputStream, recording
+ * each tiles element's byte range, slide bounds and cell and vertex counts,
+ * the location of its tissue map and the file's cell types, without
+ * materialising a message. A tile is then parsed on its own, only when
+ * asked for: DecodeTile() converts it into a caller's store, GetTile()
+ * keeps the result in an LRU of decoded tiles bounded by bytes, and
+ * Request() has worker threads decode a viewport's tiles and a prefetch
+ * ring around them ahead of GetTile().
+ *
+ * Thread-safe once opened.
+ */
+class ProtobufTileSource {
+public:
+    /**
+     * One tiles element of the file, indexed but not parsed
+     */
+    struct Tile {
+        uint64_t offset = 0;  // Encoded TileSegmentationData in the file
+        uint64_t size = 0;
+        int32_t level = 0;
+        float x = 0.0f;
+        float y = 0.0f;
+        int32_t width = 0;
+        int32_t height = 0;
+        Rect bounds;          // Slide space (level 0)
+        size_t cellCount = 0;
+        size_t vertexCount = 0;
+
+        // Tissue segmentation map, if the tile has one (in the mapping)
+        const uint8_t* tissueData = nullptr;
+        size_t tissueSize = 0;
+        int32_t tissueWidth = 0;
+        int32_t tissueHeight = 0;
+        std::string tissueDtype;
+    };
+
+    static constexpr size_t DEFAULT_CACHE_BYTES = 256 * 1024 * 1024;
+
+    /**
+     * @param cacheBytes Budget of the decoded tile LRU
+     * @param threadCount Request() workers; 0 picks the hardware's, up to MAX_THREADS
+     */
+    explicit ProtobufTileSource(size_t cacheBytes = DEFAULT_CACHE_BYTES, size_t threadCount = 0);
+    ~ProtobufTileSource();
+
+    ProtobufTileSource(const ProtobufTileSource&) = delete;
+    ProtobufTileSource& operator=(const ProtobufTileSource&) = delete;
+
+    /**
+     * Map and index a file (once per source)
+     * @return false if it cannot be read or is malformed (see GetError)
+     */
+    bool Open(const std::string& filepath);
+    const std::string& GetError() const { return error_; }
+
+    /**
+     * Class ID of each cell type the decoded cells take (unknown types get
+     * 0), kept per interned type. Set before decoding anything.
+     */
+    void SetClassMapping(std::map<std::string, int> classMapping);
+
+    // Slide fields and the index
+    const std::string& GetSlideId() const { return slideId_; }
+    int32_t GetMaxLevel() const { return maxLevel_; }
+    int32_t GetTissueEmptyClass() const { return tissueEmptyClass_; }
+    const std::map<int, std::string>& GetTissueClassMapping() const { return tissueClassMapping_; }
+    // The cell types of every tile, interned and frozen by Open()
+    const ClassNameTable& GetCellTypes() const { return cellTypes_; }
+    const std::vector<Tile>& GetTiles() const { return tiles_; }
+    size_t GetCellCount() const { return cellCount_; }
+    size_t GetVertexCount() const { return vertexCount_; }
+
+    /**
+     * Tiles whose bounds meet a slide region, into a reused buffer, in
+     * file order
+     */
+    void QueryTiles(const Rect& region, std::vector<size_t>& outTiles) const;
+
+    /**
+     * Parse one tile and append its cells, in slide space, to out. Does
+     * not touch the cache.
+     * @return false if the tile does not parse
+     */
+    bool DecodeTile(size_t tile, PolygonStore& out) const;
+
+    /**
+     * A tile's cells from the cache, or decoded on the calling thread (or
+     * waited for, if a worker is on it) and cached
+     * @return nullptr if the tile does not parse
+     */
+    std::shared_ptr<const PolygonStore> GetTile(size_t tile);
+
+    /**
+     * A tile's cells if already decoded, else nullptr; never blocks
+     */
+    std::shared_ptr<const PolygonStore> TryGetTile(size_t tile);
+
+    /**
+     * Queue the tiles meeting a viewport for the workers, nearest its
+     * center first, then those within prefetchMargin slide pixels of it.
+     * Replaces whatever an earlier request left queued; tiles it asks for
+     * are kept out of eviction until the next request.
+     */
+    void Request(const Rect& viewport, double prefetchMargin);
+
+    /**
+     * Block until the queue is empty and no worker is decoding
+     */
+    void WaitIdle();
+
+    // Statistics
+    size_t GetCachedBytes() const;
+    size_t GetCachedTileCount() const;
+    size_t GetCacheCapacity() const { return capacity_; }
+    size_t GetDecodeCount() const;
+
+    /**
+     * Append one parsed tile's cells to out, in slide space
+     * @param maxDeepZoomLevel The file's max_level
+     * @param cellTypes The file's cell types
+     * @param typeClasses Class ID of each of them by index (unknown types get 0)
+     */
+    static void ConvertTile(const DataProtoPolygon::TileSegmentationData& tile, int maxDeepZoomLevel,
+                            const ClassNameTable& cellTypes, const std::vector<int>& typeClasses,
+                            PolygonStore& out);
+
+    static constexpr size_t MAX_THREADS = 8;
+
+private:
+    struct Entry {
+        std::shared_ptr<const PolygonStore> polygons;  // Null if the tile did not parse
+        size_t bytes = 0;
+        bool ready = false;                            // False while decoding
+        std::list<size_t>::iterator lru;               // Valid once decoded
+    };
+
+    bool Index();
+    void StartWorkers();
+    void WorkerLoop();
+
+    // Decode a claimed tile (entry inserted, polygons null) and publish it
+    std::shared_ptr<const PolygonStore> DecodeAndPublish(size_t tile);
+    void EvictLocked();
+
+    std::unique_ptr<MappedFile> file_;
+    std::string error_;
+
+    std::string slideId_;
+    int32_t maxLevel_ = 0;
+    int32_t tissueEmptyClass_ = 0;
+    std::map<int, std::string> tissueClassMapping_;
+    ClassNameTable cellTypes_;
+    std::vector<int> typeClasses_;  // Class ID of each of cellTypes_
+    std::vector<Tile> tiles_;
+    size_t cellCount_ = 0;
+    size_t vertexCount_ = 0;
+
+    size_t capacity_;
+    size_t threadCount_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable tileReady_;
+    std::condition_variable workAvailable_;
+    std::condition_variable idle_;
+    std::unordered_map<size_t, Entry> entries_;
+    std::list<size_t> lru_;             // Decoded tiles, most recent first
+    std::set<size_t> pinned_;           // Tiles of the latest request
+    size_t cachedBytes_ = 0;
+    size_t decodeCount_ = 0;
+
+    std::deque<size_t> queue_;          // Request()ed tiles, next at front
+    size_t busyWorkers_ = 0;
+    std::vector<std::thread> workers_;  // Started by the first Request()
+    bool stopping_ = false;
+};
@@ -0,0 +1,525 @@
+#include "SegmentationV2.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_FIXED64 = 1;
+constexpr uint32_t WIRE_BYTES = 2;
+constexpr uint32_t WIRE_FIXED32 = 5;
+
+constexpr uint32_t FORMAT_VERSION = 2;
+
+// Sequential reader of one message's fields
+class WireCursor {
+public:
+    WireCursor(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool AtEnd() const { return p_ >= end_; }
+
+    bool Varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+            uint8_t byte = *p_++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Fixed32(uint32_t& value) {
+        if (end_ - p_ < 4) {
+            return false;
+        }
+        value = static_cast<uint32_t>(p_[0]) | (static_cast<uint32_t>(p_[1]) << 8) |
+                (static_cast<uint32_t>(p_[2]) << 16) | (static_cast<uint32_t>(p_[3]) << 24);
+        p_ += 4;
+        return true;
+    }
+
+    bool Float(float& value) {
+        uint32_t bits;
+        if (!Fixed32(bits)) {
+            return false;
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool Bytes(const uint8_t*& data, size_t& size) {
+        uint64_t length;
+        if (!Varint(length) || length > static_cast<uint64_t>(end_ - p_)) {
+            return false;
+        }
+        data = p_;
+        size = static_cast<size_t>(length);
+        p_ += size;
+        return true;
+    }
+
+    bool String(std::string& value) {
+        const uint8_t* data;
+        size_t size;
+        if (!Bytes(data, size)) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(data), size);
+        return true;
+    }
+
+    bool Tag(uint32_t& field, uint32_t& wireType) {
+        uint64_t tag;
+        if (!Varint(tag) || (tag >> 3) == 0 || (tag >> 3) > UINT32_MAX) {
+            return false;
+        }
+        field = static_cast<uint32_t>(tag >> 3);
+        wireType = static_cast<uint32_t>(tag & 7);
+        return true;
+    }
+
+    bool Skip(uint32_t wireType) {
+        uint64_t value;
+        const uint8_t* data;
+        size_t size;
+        switch (wireType) {
+            case WIRE_VARINT: return Varint(value);
+            case WIRE_FIXED64:
+                if (end_ - p_ < 8) return false;
+                p_ += 8;
+                return true;
+            case WIRE_BYTES: return Bytes(data, size);
+            case WIRE_FIXED32:
+                if (end_ - p_ < 4) return false;
+                p_ += 4;
+                return true;
+            default: return false;  // Groups are not used by either version
+        }
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+int32_t ZigZagDecode(uint64_t value) {
+    uint32_t bits = static_cast<uint32_t>(value);
+    return static_cast<int32_t>((bits >> 1) ^ (~(bits & 1) + 1));
+}
+
+uint32_t ZigZagEncode(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+// A repeated varint field, packed or not: each value through decode
+template <typename T, typename Decode>
+bool AppendVarints(WireCursor& cursor, uint32_t wireType, std::vector<T>& out, Decode decode) {
+    uint64_t value;
+    if (wireType == WIRE_VARINT) {
+        if (!cursor.Varint(value)) {
+            return false;
+        }
+        out.push_back(decode(value));
+        return true;
+    }
+    const uint8_t* data;
+    size_t size;
+    if (wireType != WIRE_BYTES || !cursor.Bytes(data, size)) {
+        return false;
+    }
+    WireCursor packed(data, size);
+    while (!packed.AtEnd()) {
+        if (!packed.Varint(value)) {
+            return false;
+        }
+        out.push_back(decode(value));
+    }
+    return true;
+}
+
+bool AppendFloats(WireCursor& cursor, uint32_t wireType, std::vector<float>& out) {
+    float value;
+    if (wireType == WIRE_FIXED32) {
+        if (!cursor.Float(value)) {
+            return false;
+        }
+        out.push_back(value);
+        return true;
+    }
+    const uint8_t* data;
+    size_t size;
+    if (wireType != WIRE_BYTES || !cursor.Bytes(data, size) || size % 4 != 0) {
+        return false;
+    }
+    size_t first = out.size();
+    out.resize(first + size / 4);
+    WireCursor packed(data, size);
+    for (size_t i = first; i < out.size(); ++i) {
+        packed.Float(out[i]);
+    }
+    return true;
+}
+
+uint32_t ToUint32(uint64_t value) { return static_cast<uint32_t>(value); }
+int32_t ToInt32(uint64_t value) { return static_cast<int32_t>(static_cast<uint32_t>(value)); }
+
+// TissueSegmentationMap (shared with version 1)
+bool ParseTissueMap(const uint8_t* data, size_t size, SegmentationV2Reader::Tile& tile) {
+    WireCursor cursor(data, size);
+    uint32_t field;
+    uint32_t wireType;
+    uint64_t value;
+    while (!cursor.AtEnd()) {
+        if (!cursor.Tag(field, wireType)) {
+            return false;
+        }
+        bool ok;
+        if (field == 1 && wireType == WIRE_BYTES) {
+            ok = cursor.Bytes(tile.tissueData, tile.tissueSize);
+        } else if ((field == 2 || field == 3) && wireType == WIRE_VARINT) {
+            ok = cursor.Varint(value);
+            (field == 2 ? tile.tissueWidth : tile.tissueHeight) = ToInt32(value);
+        } else if (field == 4 && wireType == WIRE_BYTES) {
+            ok = cursor.String(tile.tissueDtype);
+        } else {
+            ok = cursor.Skip(wireType);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Header fields, cell and vertex counts and tissue map of one tile
+bool IndexTile(const uint8_t* data, size_t size, SegmentationV2Reader::Tile& tile) {
+    tile.data = data;
+    tile.size = size;
+    WireCursor cursor(data, size);
+    uint32_t field;
+    uint32_t wireType;
+    uint64_t value;
+    std::vector<uint32_t> vertexCounts;
+    while (!cursor.AtEnd()) {
+        if (!cursor.Tag(field, wireType)) {
+            return false;
+        }
+        bool ok;
+        if ((field == 2 || field == 5 || field == 6) && wireType == WIRE_VARINT) {
+            ok = cursor.Varint(value);
+            (field == 2 ? tile.level : field == 5 ? tile.width : tile.height) = ToInt32(value);
+        } else if ((field == 3 || field == 4) && wireType == WIRE_FIXED32) {
+            ok = cursor.Float(field == 3 ? tile.x : tile.y);
+        } else if (field == 8) {
+            ok = AppendVarints(cursor, wireType, vertexCounts, ToUint32);
+        } else if (field == 12 && wireType == WIRE_BYTES) {
+            const uint8_t* map;
+            size_t mapSize;
+            ok = cursor.Bytes(map, mapSize) && ParseTissueMap(map, mapSize, tile);
+        } else {
+            ok = cursor.Skip(wireType);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    tile.cellCount = vertexCounts.size();
+    tile.vertexCount = 0;
+    for (uint32_t count : vertexCounts) {
+        tile.vertexCount += count;
+    }
+    return true;
+}
+
+void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutTag(std::vector<uint8_t>& out, uint32_t field, uint32_t wireType) {
+    PutVarint(out, (static_cast<uint64_t>(field) << 3) | wireType);
+}
+
+void PutBytes(std::vector<uint8_t>& out, uint32_t field, const void* data, size_t size) {
+    PutTag(out, field, WIRE_BYTES);
+    PutVarint(out, size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void PutString(std::vector<uint8_t>& out, uint32_t field, const std::string& value) {
+    PutBytes(out, field, value.data(), value.size());
+}
+
+// int32 fields: negative values sign-extend to ten bytes
+void PutInt32(std::vector<uint8_t>& out, uint32_t field, int32_t value) {
+    PutTag(out, field, WIRE_VARINT);
+    PutVarint(out, static_cast<uint64_t>(static_cast<int64_t>(value)));
+}
+
+void PutFloat(std::vector<uint8_t>& out, uint32_t field, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutTag(out, field, WIRE_FIXED32);
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+template <typename T, typename Encode>
+void PutPackedVarints(std::vector<uint8_t>& out, uint32_t field, const std::vector<T>& values, Encode encode) {
+    std::vector<uint8_t> packed;
+    for (T value : values) {
+        PutVarint(packed, encode(value));
+    }
+    PutBytes(out, field, packed.data(), packed.size());
+}
+
+}  // namespace
+
+void SegmentationV2Reader::TileCells::Clear() {
+    classIds.clear();
+    vertexCounts.clear();
+    coords.clear();
+    confidences.clear();
+    centroids.clear();
+}
+
+bool SegmentationV2Reader::IsV2(const uint8_t* data, size_t size) {
+    WireCursor cursor(data, size);
+    uint32_t field;
+    uint32_t wireType;
+    return cursor.Tag(field, wireType) && field == 1 && wireType == WIRE_VARINT;
+}
+
+bool SegmentationV2Reader::Parse(const uint8_t* data, size_t size) {
+    WireCursor cursor(data, size);
+    uint32_t field;
+    uint32_t wireType;
+    uint64_t value;
+    while (!cursor.AtEnd()) {
+        if (!cursor.Tag(field, wireType)) {
+            error_ = "Malformed field tag";
+            return false;
+        }
+        bool ok;
+        if (wireType == WIRE_VARINT && (field == 1 || field == 5 || field == 8)) {
+            ok = cursor.Varint(value);
+            if (field == 1) {
+                formatVersion = ToUint32(value);
+            } else {
+                (field == 5 ? maxLevel : tissueEmptyClass) = ToInt32(value);
+            }
+        } else if (wireType == WIRE_BYTES && (field == 2 || field == 3 || field == 6 || field == 7)) {
+            ok = cursor.String(field == 2 ? slideId : field == 3 ? slidePath : field == 6 ? cellModelName
+                                                                                             : tissueModelName);
+        } else if (wireType == WIRE_FIXED32 && (field == 4 || field == 12)) {
+            ok = cursor.Float(field == 4 ? mpp : coordinateScale);
+        } else if (wireType == WIRE_BYTES && field == 9) {
+            cellTypes.emplace_back();
+            ok = cursor.String(cellTypes.back());
+        } else if (wireType == WIRE_BYTES && field == 10) {
+            const uint8_t* tileData;
+            size_t tileSize;
+            tiles.emplace_back();
+            ok = cursor.Bytes(tileData, tileSize) && IndexTile(tileData, tileSize, tiles.back());
+        } else if (wireType == WIRE_BYTES && field == 11) {
+            const uint8_t* entryData;
+            size_t entrySize;
+            ok = cursor.Bytes(entryData, entrySize);
+            WireCursor entry(entryData, ok ? entrySize : 0);
+            int32_t key = 0;
+            std::string name;
+            while (ok && !entry.AtEnd()) {
+                uint32_t entryField;
+                uint32_t entryWire;
+                ok = entry.Tag(entryField, entryWire);
+                if (ok && entryField == 1 && entryWire == WIRE_VARINT) {
+                    ok = entry.Varint(value);
+                    key = ToInt32(value);
+                } else if (ok && entryField == 2 && entryWire == WIRE_BYTES) {
+                    ok = entry.String(name);
+                } else if (ok) {
+                    ok = entry.Skip(entryWire);
+                }
+            }
+            tissueClassMapping[key] = name;
+        } else {
+            ok = cursor.Skip(wireType);
+        }
+        if (!ok) {
+            error_ = "Malformed field " + std::to_string(field);
+            return false;
+        }
+    }
+    if (formatVersion != FORMAT_VERSION) {
+        error_ = "Unsupported format version " + std::to_string(formatVersion);
+        return false;
+    }
+    if (!(coordinateScale > 0.0f)) {
+        error_ = "Invalid coordinate scale";
+        return false;
+    }
+    return true;
+}
+
+bool SegmentationV2Reader::DecodeTile(const Tile& tile, TileCells& out) {
+    out.Clear();
+    WireCursor cursor(tile.data, tile.size);
+    uint32_t field;
+    uint32_t wireType;
+    while (!cursor.AtEnd()) {
+        if (!cursor.Tag(field, wireType)) {
+            return false;
+        }
+        bool ok;
+        switch (field) {
+            case 7: ok = AppendVarints(cursor, wireType, out.classIds, ToUint32); break;
+            case 8: ok = AppendVarints(cursor, wireType, out.vertexCounts, ToUint32); break;
+            case 9: ok = AppendVarints(cursor, wireType, out.coords, ZigZagDecode); break;
+            case 10: ok = AppendFloats(cursor, wireType, out.confidences); break;
+            case 11: ok = AppendVarints(cursor, wireType, out.centroids, ZigZagDecode); break;
+            default: ok = cursor.Skip(wireType); break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    const size_t cells = out.vertexCounts.size();
+    size_t vertices = 0;
+    for (uint32_t count : out.vertexCounts) {
+        vertices += count;
+    }
+    return out.classIds.size() == cells && out.coords.size() == 2 * vertices &&
+           (out.confidences.empty() || out.confidences.size() == cells) &&
+           (out.centroids.empty() || out.centroids.size() == 2 * cells);
+}
+
+SegmentationV2Writer::SegmentationV2Writer(float coordinateScale)
+    : scale_(coordinateScale) {
+}
+
+void SegmentationV2Writer::SetSlideInfo(const std::string& slideId, const std::string& slidePath, float mpp,
+                                        int32_t maxLevel, const std::string& cellModelName,
+                                        const std::string& tissueModelName, int32_t tissueEmptyClass) {
+    header_.clear();
+    PutString(header_, 2, slideId);
+    PutString(header_, 3, slidePath);
+    PutFloat(header_, 4, mpp);
+    PutInt32(header_, 5, maxLevel);
+    PutString(header_, 6, cellModelName);
+    PutString(header_, 7, tissueModelName);
+    PutInt32(header_, 8, tissueEmptyClass);
+}
+
+void SegmentationV2Writer::SetTissueClass(int32_t label, const std::string& name) {
+    std::vector<uint8_t> entry;
+    PutInt32(entry, 1, label);
+    PutString(entry, 2, name);
+    PutBytes(mapping_, 11, entry.data(), entry.size());
+}
+
+void SegmentationV2Writer::BeginTile(const std::string& tileId, int32_t level, float x, float y, int32_t width,
+                                     int32_t height) {
+    tileHeader_.clear();
+    PutString(tileHeader_, 1, tileId);
+    PutInt32(tileHeader_, 2, level);
+    PutFloat(tileHeader_, 3, x);
+    PutFloat(tileHeader_, 4, y);
+    PutInt32(tileHeader_, 5, width);
+    PutInt32(tileHeader_, 6, height);
+}
+
+void SegmentationV2Writer::AddCell(const std::string& cellType, const float* xy, size_t vertexCount,
+                                   float centroidX, float centroidY, float confidence) {
+    auto type = typeIndex_.emplace(cellType, static_cast<uint32_t>(types_.size()));
+    if (type.second) {
+        types_.push_back(cellType);
+    }
+    classIds_.push_back(type.first->second);
+    vertexCounts_.push_back(static_cast<uint32_t>(vertexCount));
+
+    // Steps between rounded vertices, so rounding errors never accumulate
+    int32_t originX = 0;
+    int32_t originY = 0;
+    int32_t previousX = 0;
+    int32_t previousY = 0;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        int32_t x = static_cast<int32_t>(std::lround(xy[2 * i] * scale_));
+        int32_t y = static_cast<int32_t>(std::lround(xy[2 * i + 1] * scale_));
+        if (i == 0) {
+            originX = x;
+            originY = y;
+        }
+        coords_.push_back(x - previousX);
+        coords_.push_back(y - previousY);
+        previousX = x;
+        previousY = y;
+    }
+    centroids_.push_back(static_cast<int32_t>(std::lround(centroidX * scale_)) - originX);
+    centroids_.push_back(static_cast<int32_t>(std::lround(centroidY * scale_)) - originY);
+    confidences_.push_back(confidence);
+}
+
+void SegmentationV2Writer::SetTissueMap(const uint8_t* labels, size_t size, int32_t width, int32_t height,
+                                        const std::string& dtype) {
+    tissue_.clear();
+    PutBytes(tissue_, 1, labels, size);
+    PutInt32(tissue_, 2, width);
+    PutInt32(tissue_, 3, height);
+    PutString(tissue_, 4, dtype);
+}
+
+void SegmentationV2Writer::EndTile() {
+    std::vector<uint8_t> tile = std::move(tileHeader_);
+    auto same = [](uint32_t value) { return static_cast<uint64_t>(value); };
+    auto zigzag = [](int32_t value) { return static_cast<uint64_t>(ZigZagEncode(value)); };
+    PutPackedVarints(tile, 7, classIds_, same);
+    PutPackedVarints(tile, 8, vertexCounts_, same);
+    PutPackedVarints(tile, 9, coords_, zigzag);
+    std::vector<uint8_t> floats;
+    for (float confidence : confidences_) {
+        uint32_t bits;
+        std::memcpy(&bits, &confidence, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            floats.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+        }
+    }
+    PutBytes(tile, 10, floats.data(), floats.size());
+    PutPackedVarints(tile, 11, centroids_, zigzag);
+    if (!tissue_.empty()) {
+        PutBytes(tile, 12, tissue_.data(), tissue_.size());
+    }
+    PutBytes(tiles_, 10, tile.data(), tile.size());
+
+    tileHeader_.clear();
+    tissue_.clear();
+    classIds_.clear();
+    vertexCounts_.clear();
+    coords_.clear();
+    confidences_.clear();
+    centroids_.clear();
+}
+
+std::vector<uint8_t> SegmentationV2Writer::Finish() {
+    std::vector<uint8_t> out;
+    PutTag(out, 1, WIRE_VARINT);
+    PutVarint(out, FORMAT_VERSION);
+    out.insert(out.end(), header_.begin(), header_.end());
+    for (const std::string& type : types_) {
+        PutString(out, 9, type);
+    }
+    out.insert(out.end(), tiles_.begin(), tiles_.end());
+    out.insert(out.end(), mapping_.begin(), mapping_.end());
+    if (scale_ != 1.0f) {
+        PutFloat(out, 12, scale_);
+    }
+    std::vector<uint8_t>().swap(tiles_);
+    return out;
+}
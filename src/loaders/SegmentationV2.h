@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Version 2 segmentation files (protobuf/cell_polygons_v2.proto)
+ *
+ * Decoded straight from the protobuf wire format rather than through
+ * generated classes: a tile's cells are a handful of packed arrays, read
+ * in place from the mapped file into per-thread scratch vectors, so
+ * nothing is allocated per cell or per vertex.
+ */
+class SegmentationV2Reader {
+public:
+    /**
+     * One tile, indexed but not decoded: its cells stay in the file
+     */
+    struct Tile {
+        const uint8_t* data = nullptr;  // Encoded TileSegmentationDataV2
+        size_t size = 0;
+        int32_t level = 0;
+        float x = 0.0f;
+        float y = 0.0f;
+        int32_t width = 0;
+        int32_t height = 0;
+        size_t cellCount = 0;
+        size_t vertexCount = 0;
+
+        // Tissue segmentation map, if the tile has one
+        const uint8_t* tissueData = nullptr;
+        size_t tissueSize = 0;
+        int32_t tissueWidth = 0;
+        int32_t tissueHeight = 0;
+        std::string tissueDtype;
+    };
+
+    /**
+     * The cells of one tile as parallel arrays (see the .proto)
+     */
+    struct TileCells {
+        std::vector<uint32_t> classIds;
+        std::vector<uint32_t> vertexCounts;
+        std::vector<int32_t> coords;
+        std::vector<float> confidences;
+        std::vector<int32_t> centroids;
+
+        void Clear();
+    };
+
+    /**
+     * Whether data starts like a version 2 file: field 1 is a varint
+     * (version 1 files begin with their slide_id string)
+     */
+    static bool IsV2(const uint8_t* data, size_t size);
+
+    /**
+     * Index a file: slide fields, string tables and each tile's header.
+     * data must outlive the reader and its tiles.
+     * @return false if the file is malformed (see GetError)
+     */
+    bool Parse(const uint8_t* data, size_t size);
+
+    /**
+     * Decode a tile's cells into out (cleared first; thread-safe)
+     * @return false if the tile is malformed or its arrays disagree
+     */
+    static bool DecodeTile(const Tile& tile, TileCells& out);
+
+    const std::string& GetError() const { return error_; }
+
+    uint32_t formatVersion = 0;
+    std::string slideId;
+    std::string slidePath;
+    float mpp = 0.0f;
+    int32_t maxLevel = 0;
+    std::string cellModelName;
+    std::string tissueModelName;
+    int32_t tissueEmptyClass = 0;
+    std::vector<std::string> cellTypes;
+    std::map<int, std::string> tissueClassMapping;
+    float coordinateScale = 1.0f;
+    std::vector<Tile> tiles;
+
+private:
+    std::string error_;
+};
+
+/**
+ * Builds a version 2 file, tile by tile, from tile-local cell outlines
+ * (what version 1 stores), e.g. to convert version 1 files
+ */
+class SegmentationV2Writer {
+public:
+    /**
+     * @param coordinateScale Coordinate units per tile pixel: vertices
+     *        are rounded to 1 / coordinateScale pixel
+     */
+    explicit SegmentationV2Writer(float coordinateScale = 1.0f);
+
+    void SetSlideInfo(const std::string& slideId, const std::string& slidePath, float mpp, int32_t maxLevel,
+                      const std::string& cellModelName, const std::string& tissueModelName,
+                      int32_t tissueEmptyClass);
+    void SetTissueClass(int32_t label, const std::string& name);
+
+    void BeginTile(const std::string& tileId, int32_t level, float x, float y, int32_t width, int32_t height);
+
+    /**
+     * Add a cell to the current tile
+     * @param xy Tile-local x, y pairs, vertexCount of them
+     */
+    void AddCell(const std::string& cellType, const float* xy, size_t vertexCount, float centroidX,
+                 float centroidY, float confidence);
+
+    void SetTissueMap(const uint8_t* labels, size_t size, int32_t width, int32_t height, const std::string& dtype);
+
+    void EndTile();
+
+    /**
+     * The encoded file (the writer is spent afterwards)
+     */
+    std::vector<uint8_t> Finish();
+
+private:
+    float scale_;
+    std::vector<uint8_t> header_;  // Fields 2-8
+    std::vector<uint8_t> tiles_;   // Field 10, every tile so far
+    std::vector<uint8_t> mapping_; // Field 11
+    std::map<std::string, uint32_t> typeIndex_;
+    std::vector<std::string> types_;
+
+    // Current tile
+    std::vector<uint8_t> tileHeader_;
+    std::vector<uint8_t> tissue_;
+    std::vector<uint32_t> classIds_;
+    std::vector<uint32_t> vertexCounts_;
+    std::vector<int32_t> coords_;
+    std::vector<float> confidences_;
+    std::vector<int32_t> centroids_;
+};
@@ -0,0 +1,83 @@
+#include "SyntheticCellWriter.h"
+#include "SegmentationV2.h"
+#include "SyntheticSlide.h"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+std::string TileId(int64_t column, int64_t row) {
+    return std::to_string(column) + "_" + std::to_string(row);
+}
+
+}  // namespace
+
+bool SyntheticCellWriter::WriteJson(const std::string& path, const std::string& slideId,
+                                    const SyntheticCells& generator) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "{\"slide_id\":\"%s\",\"max_level\":0,\"tiles\":[", slideId.c_str());
+    std::vector<SyntheticCells::Cell> cells;
+    std::vector<float> xy;
+    uint64_t cellId = 0;
+    bool firstTile = true;
+    for (int64_t row = 0; row < generator.GetRows(); ++row) {
+        for (int64_t column = 0; column < generator.GetColumns(); ++column) {
+            generator.Generate(column, row, cells, xy);
+            if (cells.empty()) {
+                continue;
+            }
+            std::fprintf(file, "%s{\"tile_id\":\"%s\",\"level\":0,\"x\":%lld,\"y\":%lld,\"width\":%d,"
+                         "\"height\":%d,\"masks\":[",
+                         firstTile ? "" : ",", TileId(column, row).c_str(), static_cast<long long>(column),
+                         static_cast<long long>(row), SyntheticCells::TILE_SIZE, SyntheticCells::TILE_SIZE);
+            firstTile = false;
+            for (size_t i = 0; i < cells.size(); ++i) {
+                const SyntheticCells::Cell& cell = cells[i];
+                std::fprintf(file, "%s{\"cell_id\":%llu,\"cell_type\":\"%s\",\"confidence\":%.3f,\"coordinates\":[",
+                             i == 0 ? "" : ",", static_cast<unsigned long long>(cellId++),
+                             SyntheticCells::GetClassName(cell.classId), cell.confidence);
+                for (uint32_t v = 0; v < cell.vertexCount; ++v) {
+                    const float* point = &xy[(cell.firstVertex + v) * 2];
+                    std::fprintf(file, "%s[%.2f,%.2f]", v == 0 ? "" : ",", point[0], point[1]);
+                }
+                std::fprintf(file, "],\"centroid\":{\"x\":%.2f,\"y\":%.2f}}", cell.centroidX, cell.centroidY);
+            }
+            std::fprintf(file, "]}");
+        }
+    }
+    std::fprintf(file, "]}\n");
+    const bool ok = !std::ferror(file);
+    return std::fclose(file) == 0 && ok;
+}
+
+bool SyntheticCellWriter::WriteProtobuf(const std::string& path, const std::string& slidePath,
+                                        const SyntheticCells& generator) {
+    SegmentationV2Writer writer(V2_COORDINATE_SCALE);
+    writer.SetSlideInfo("synthetic", slidePath, static_cast<float>(SyntheticSlide::MICRONS_PER_PIXEL), 0,
+                        "pathview-synth", "", 0);
+    std::vector<SyntheticCells::Cell> cells;
+    std::vector<float> xy;
+    for (int64_t row = 0; row < generator.GetRows(); ++row) {
+        for (int64_t column = 0; column < generator.GetColumns(); ++column) {
+            generator.Generate(column, row, cells, xy);
+            if (cells.empty()) {
+                continue;
+            }
+            writer.BeginTile(TileId(column, row), 0, static_cast<float>(column), static_cast<float>(row),
+                             SyntheticCells::TILE_SIZE, SyntheticCells::TILE_SIZE);
+            for (const SyntheticCells::Cell& cell : cells) {
+                writer.AddCell(SyntheticCells::GetClassName(cell.classId), &xy[cell.firstVertex * 2],
+                               cell.vertexCount, cell.centroidX, cell.centroidY, cell.confidence);
+            }
+            writer.EndTile();
+        }
+    }
+    const std::vector<uint8_t> bytes = writer.Finish();
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
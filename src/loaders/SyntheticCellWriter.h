@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+class SyntheticCells;
+
+/**
+ * Writes SyntheticCells as the cell files PathView loads, generated and
+ * written one tile at a time, every tile at level 0 of max_level 0 so
+ * tile-local coordinates are slide pixels past the tile's origin.
+ */
+class SyntheticCellWriter {
+public:
+    /**
+     * JSON segmentation (tiles of masks), streamed: only the current
+     * tile's cells are held
+     * @param slideId Written as the file's slide_id
+     */
+    static bool WriteJson(const std::string& path, const std::string& slideId, const SyntheticCells& cells);
+
+    /**
+     * Packed version 2 protobuf (see SegmentationV2Writer), vertices to
+     * 1 / V2_COORDINATE_SCALE pixel
+     * @param slidePath Written as the file's slide_path
+     */
+    static bool WriteProtobuf(const std::string& path, const std::string& slidePath, const SyntheticCells& cells);
+
+    static constexpr float V2_COORDINATE_SCALE = 4.0f;
+};
@@ -0,0 +1,146 @@
+#include "WkbReader.h"
+#include <cstring>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t WKB_POLYGON = 3;
+constexpr uint32_t WKB_MULTIPOLYGON = 6;
+
+// Extended WKB flags on the type
+constexpr uint32_t EWKB_Z = 0x80000000u;
+constexpr uint32_t EWKB_M = 0x40000000u;
+constexpr uint32_t EWKB_SRID = 0x20000000u;
+
+// Multipolygons nest one level of polygons
+constexpr int MAX_DEPTH = 2;
+
+class Cursor {
+public:
+    Cursor(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool Remaining(size_t bytes) const { return size_ - position_ >= bytes; }
+    void Skip(size_t bytes) { position_ += bytes; }
+
+    bool ReadByte(uint8_t& out) {
+        if (!Remaining(1)) {
+            return false;
+        }
+        out = data_[position_++];
+        return true;
+    }
+
+    bool ReadUint32(bool bigEndian, uint32_t& out) {
+        if (!Remaining(4)) {
+            return false;
+        }
+        uint8_t bytes[4];
+        std::memcpy(bytes, data_ + position_, 4);
+        position_ += 4;
+        out = bigEndian ? (uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | bytes[3])
+                        : (uint32_t(bytes[3]) << 24 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[1]) << 8 | bytes[0]);
+        return true;
+    }
+
+    // Caller checks Remaining(8) first
+    double ReadDouble(bool bigEndian) {
+        uint8_t bytes[8];
+        std::memcpy(bytes, data_ + position_, 8);
+        position_ += 8;
+        if (bigEndian) {
+            for (int i = 0; i < 4; ++i) {
+                std::swap(bytes[i], bytes[7 - i]);
+            }
+        }
+        double value;
+        std::memcpy(&value, bytes, 8);
+        return value;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+bool ReadGeometry(Cursor& cursor, int depth, std::vector<double>& xy, std::vector<uint32_t>& ringEnds) {
+    uint8_t byteOrder;
+    uint32_t type;
+    if (!cursor.ReadByte(byteOrder) || byteOrder > 1) {
+        return false;
+    }
+    const bool bigEndian = byteOrder == 0;
+    if (!cursor.ReadUint32(bigEndian, type)) {
+        return false;
+    }
+
+    // Ordinates per point: EWKB flags, or ISO thousands (1000 Z, 2000 M, 3000 ZM)
+    size_t ordinates = 2 + ((type & EWKB_Z) ? 1 : 0) + ((type & EWKB_M) ? 1 : 0);
+    if (type & EWKB_SRID) {
+        uint32_t srid;
+        if (!cursor.ReadUint32(bigEndian, srid)) {
+            return false;
+        }
+    }
+    type &= 0x0FFFFFFFu;
+    if (type >= 1000 && type < 4000) {
+        ordinates = 2 + (type / 1000 == 3 ? 2 : 1);
+        type %= 1000;
+    }
+
+    if (type == WKB_POLYGON) {
+        uint32_t ringCount;
+        if (!cursor.ReadUint32(bigEndian, ringCount)) {
+            return false;
+        }
+        for (uint32_t ring = 0; ring < ringCount; ++ring) {
+            uint32_t pointCount;
+            if (!cursor.ReadUint32(bigEndian, pointCount) || !cursor.Remaining(size_t(pointCount) * ordinates * 8)) {
+                return false;
+            }
+            if (ring > 0) {
+                cursor.Skip(size_t(pointCount) * ordinates * 8);  // Holes
+                continue;
+            }
+            const size_t start = xy.size();
+            for (uint32_t i = 0; i < pointCount; ++i) {
+                xy.push_back(cursor.ReadDouble(bigEndian));
+                xy.push_back(cursor.ReadDouble(bigEndian));
+                cursor.Skip((ordinates - 2) * 8);
+            }
+            // Rings repeat their first point at the end; PolygonStore closes them
+            if (xy.size() - start >= 4 && xy[start] == xy[xy.size() - 2] && xy[start + 1] == xy[xy.size() - 1]) {
+                xy.resize(xy.size() - 2);
+            }
+            if (xy.size() > start) {
+                ringEnds.push_back(static_cast<uint32_t>(xy.size() / 2));
+            }
+        }
+        return true;
+    }
+    if (type == WKB_MULTIPOLYGON && depth < MAX_DEPTH) {
+        uint32_t partCount;
+        if (!cursor.ReadUint32(bigEndian, partCount)) {
+            return false;
+        }
+        for (uint32_t part = 0; part < partCount; ++part) {
+            if (!ReadGeometry(cursor, depth + 1, xy, ringEnds)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Other geometry has no polygons to keep, but a multipolygon's parts
+    // must be polygons
+    return depth == 1;
+}
+
+}  // namespace
+
+bool WkbReader::ReadPolygons(const uint8_t* data, size_t size,
+                             std::vector<double>& outXy, std::vector<uint32_t>& outRingEnds) {
+    outXy.clear();
+    outRingEnds.clear();
+    Cursor cursor(data, size);
+    return ReadGeometry(cursor, 1, outXy, outRingEnds);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Well-known binary (WKB) polygon geometry, as GeoParquet and most
+ * spatial tables store it.
+ *
+ * Reads ISO and extended (PostGIS) WKB in either byte order, with or
+ * without Z / M ordinates (dropped). Like FlatGeobufReader, each Polygon or
+ * MultiPolygon part contributes its exterior ring without the repeated
+ * closing point; other geometry reads as empty.
+ */
+class WkbReader {
+public:
+    /**
+     * Decode one geometry's exterior rings
+     * @param outXy Ring points, x then y (replaced)
+     * @param outRingEnds One past each ring's last point (replaced)
+     * @return false if the geometry is malformed or truncated
+     */
+    static bool ReadPolygons(const uint8_t* data, size_t size,
+                             std::vector<double>& outXy, std::vector<uint32_t>& outRingEnds);
+};
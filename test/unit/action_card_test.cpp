@@ -68,6 +68,29 @@ TEST_F(ActionCardTest, LogEntryOrdering) {
     EXPECT_LT(card.logEntries[1].timestamp, card.logEntries[2].timestamp);
 }
 
+TEST_F(ActionCardTest, LogBound_DropsOldestEntries) {
+    for (size_t i = 0; i < ActionCard::MAX_LOG_ENTRIES + 5; ++i) {
+        card.AppendLog("Entry " + std::to_string(i));
+    }
+
+    EXPECT_EQ(card.logEntries.size(), ActionCard::MAX_LOG_ENTRIES);
+    EXPECT_EQ(card.droppedLogEntries, 5u);
+    EXPECT_EQ(card.GetLogEntryCount(), ActionCard::MAX_LOG_ENTRIES + 5);
+    EXPECT_EQ(card.logEntries.front().message, "Entry 5");
+    EXPECT_EQ(card.logEntries.back().message, "Entry " + std::to_string(ActionCard::MAX_LOG_ENTRIES + 4));
+}
+
+TEST_F(ActionCardTest, AppendLogEntry_KeepsTimestamp) {
+    ActionCardLogEntry entry("Replayed", "success");
+    entry.timestamp = std::chrono::system_clock::time_point(std::chrono::seconds(1000));
+
+    card.AppendLogEntry(entry);
+
+    ASSERT_EQ(card.logEntries.size(), 1u);
+    EXPECT_EQ(card.logEntries[0].timestamp, entry.timestamp);
+    EXPECT_EQ(card.logEntries[0].level, "success");
+}
+
 TEST_F(ActionCardTest, UpdateTimestamp) {
     auto created = card.createdAt;
 
@@ -0,0 +1,84 @@
+// AnnotationGeoJson Unit Tests
+// Tests for GeoJSON import and export of annotations: a round trip keeps
+// names and outlines, rings are closed on export and opened on import,
+// and the other GeoJSON shapes (Feature, MultiPolygon, bare geometry)
+// import too
+
+#include <gtest/gtest.h>
+#include "AnnotationGeoJson.h"
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+TEST(AnnotationGeoJsonTest, Export_WritesClosedPolygonFeatures) {
+    StoredAnnotation annotation;
+    annotation.id = 7;
+    annotation.name = "Tumor";
+    annotation.vertices = {Vec2(0, 0), Vec2(10, 0), Vec2(10, 5)};
+
+    json geojson = AnnotationGeoJson::Export({annotation});
+    EXPECT_EQ(geojson["type"], "FeatureCollection");
+    ASSERT_EQ(geojson["features"].size(), 1u);
+    const json& feature = geojson["features"][0];
+    EXPECT_EQ(feature["properties"]["id"], 7);
+    EXPECT_EQ(feature["properties"]["name"], "Tumor");
+    EXPECT_EQ(feature["geometry"]["type"], "Polygon");
+    const json& ring = feature["geometry"]["coordinates"][0];
+    ASSERT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring[3], ring[0]);
+}
+
+TEST(AnnotationGeoJsonTest, RoundTrip_KeepsNamesAndOutlines) {
+    StoredAnnotation first;
+    first.name = "A";
+    first.vertices = {Vec2(0.5, 0), Vec2(10, 0), Vec2(10, 5), Vec2(0, 5)};
+    StoredAnnotation second;
+    second.name = "B";
+    second.vertices = {Vec2(100, 100), Vec2(200, 100), Vec2(150, 180)};
+
+    std::vector<StoredAnnotation> imported =
+        AnnotationGeoJson::Import(json::parse(AnnotationGeoJson::Export({first, second}).dump()));
+    ASSERT_EQ(imported.size(), 2u);
+    EXPECT_EQ(imported[0].name, "A");
+    ASSERT_EQ(imported[0].vertices.size(), 4u);
+    EXPECT_DOUBLE_EQ(imported[0].vertices[0].x, 0.5);
+    EXPECT_EQ(imported[1].name, "B");
+    EXPECT_EQ(imported[1].vertices.size(), 3u);
+    EXPECT_EQ(imported[1].id, 0);  // Ids are the importer's to assign
+}
+
+TEST(AnnotationGeoJsonTest, Import_TakesOuterRingsOfMultiPolygonsAndBareGeometry) {
+    json multi = {
+        {"type", "Feature"},
+        {"properties", {{"name", "Islets"}}},
+        {"geometry", {
+            {"type", "MultiPolygon"},
+            {"coordinates", {
+                {{{0, 0}, {1, 0}, {1, 1}, {0, 0}}, {{0.2, 0.2}, {0.4, 0.2}, {0.4, 0.4}, {0.2, 0.2}}},
+                {{{5, 5}, {6, 5}, {6, 6}, {5, 5}}}
+            }}
+        }}
+    };
+    std::vector<StoredAnnotation> imported = AnnotationGeoJson::Import(multi);
+    ASSERT_EQ(imported.size(), 2u);  // The hole is not an annotation
+    EXPECT_EQ(imported[0].name, "Islets");
+    EXPECT_EQ(imported[0].vertices.size(), 3u);
+    EXPECT_DOUBLE_EQ(imported[1].vertices[0].x, 5.0);
+
+    json bare = {{"type", "Polygon"}, {"coordinates", {{{0, 0}, {3, 0}, {3, 3}}}}};
+    EXPECT_EQ(AnnotationGeoJson::Import(bare).size(), 1u);
+
+    json points = {
+        {"type", "FeatureCollection"},
+        {"features", {{{"type", "Feature"}, {"geometry", {{"type", "Point"}, {"coordinates", {1, 2}}}}}}}
+    };
+    EXPECT_TRUE(AnnotationGeoJson::Import(points).empty());
+}
+
+TEST(AnnotationGeoJsonTest, Import_RejectsMalformedInput) {
+    EXPECT_THROW(AnnotationGeoJson::Import(json::array()), std::runtime_error);
+    json badPosition = {{"type", "Polygon"}, {"coordinates", {{{0, 0}, {"x", 1}, {3, 3}}}}};
+    EXPECT_THROW(AnnotationGeoJson::Import(badPosition), std::runtime_error);
+    json noFeatures = {{"type", "FeatureCollection"}};
+    EXPECT_THROW(AnnotationGeoJson::Import(noFeatures), std::runtime_error);
+}
@@ -0,0 +1,97 @@
+// AnnotationIndex Unit Tests
+// Tests for the dynamic annotation index: queries find exactly the boxes
+// a linear scan finds, at every size and across cell borders, and
+// removals take annotations out of later queries
+
+#include <gtest/gtest.h>
+#include "AnnotationIndex.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<int> Query(const AnnotationIndex& index, const Rect& region) {
+    std::vector<int> ids;
+    index.Query(region, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<int> Scan(const std::vector<Rect>& boxes, const std::vector<bool>& present, const Rect& region) {
+    std::vector<int> ids;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (present[i] && boxes[i].Intersects(region)) {
+            ids.push_back(static_cast<int>(i));
+        }
+    }
+    return ids;
+}
+
+}  // namespace
+
+TEST(AnnotationIndexTest, Query_FindsBoxesAcrossCellBorders) {
+    AnnotationIndex index;
+    // Starts just left of a base cell border and reaches into the next
+    index.Insert(1, Rect(250, 10, 20, 20));
+    index.Insert(2, Rect(5000, 5000, 10, 10));
+
+    EXPECT_EQ(Query(index, Rect(260, 0, 100, 100)), std::vector<int>({1}));
+    EXPECT_EQ(Query(index, Rect(0, 0, 100, 100)), std::vector<int>());
+    EXPECT_EQ(Query(index, Rect(0, 0, 10000, 10000)), std::vector<int>({1, 2}));
+    EXPECT_EQ(index.Size(), 2u);
+}
+
+TEST(AnnotationIndexTest, Query_FindsOversizedAndNegativeBoxes) {
+    AnnotationIndex index;
+    const double huge = AnnotationIndex::BASE_CELL_SIZE * (1 << AnnotationIndex::LEVEL_COUNT);
+    index.Insert(1, Rect(0, 0, huge, 100));
+    index.Insert(2, Rect(-300, -300, 50, 50));
+
+    EXPECT_EQ(Query(index, Rect(huge - 10, 50, 5, 5)), std::vector<int>({1}));
+    EXPECT_EQ(Query(index, Rect(-260, -260, 1, 1)), std::vector<int>({2}));
+}
+
+TEST(AnnotationIndexTest, Remove_TakesAnnotationOut) {
+    AnnotationIndex index;
+    index.Insert(1, Rect(0, 0, 100, 100));
+    index.Insert(2, Rect(50, 50, 100, 100));
+
+    EXPECT_TRUE(index.Remove(1, Rect(0, 0, 100, 100)));
+    EXPECT_FALSE(index.Remove(1, Rect(0, 0, 100, 100)));
+    EXPECT_EQ(Query(index, Rect(0, 0, 200, 200)), std::vector<int>({2}));
+    EXPECT_EQ(index.Size(), 1u);
+
+    index.Clear();
+    EXPECT_EQ(index.Size(), 0u);
+    EXPECT_TRUE(Query(index, Rect(0, 0, 200, 200)).empty());
+}
+
+TEST(AnnotationIndexTest, RandomInsertsAndRemovals_MatchLinearScan) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> position(-2000.0, 200000.0);
+    std::uniform_real_distribution<double> exponent(0.0, 17.0);
+
+    AnnotationIndex index;
+    std::vector<Rect> boxes;
+    std::vector<bool> present;
+    for (int i = 0; i < 3000; ++i) {
+        // Sizes from one pixel to past the coarsest cells
+        Rect box(position(rng), position(rng), std::exp2(exponent(rng)), std::exp2(exponent(rng)));
+        boxes.push_back(box);
+        present.push_back(true);
+        index.Insert(i, box);
+    }
+    for (int i = 0; i < 3000; i += 3) {
+        ASSERT_TRUE(index.Remove(i, boxes[i]));
+        present[i] = false;
+    }
+    EXPECT_EQ(index.Size(), 2000u);
+
+    for (int q = 0; q < 200; ++q) {
+        // Views from a few hundred pixels to the whole slide
+        const double size = std::exp2(8.0 + exponent(rng));
+        const Rect region(position(rng), position(rng), size, size * 0.6);
+        ASSERT_EQ(Query(index, region), Scan(boxes, present, region)) << "query " << q;
+    }
+}
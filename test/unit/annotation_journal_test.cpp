@@ -0,0 +1,209 @@
+// AnnotationJournal Unit Tests
+// Tests for the annotation and action card journal: changes survive a
+// reopen, later records supersede earlier ones, a torn last record is cut
+// off, and compaction shrinks the log without losing anything. Each test
+// works in its own temp directory.
+
+#include <gtest/gtest.h>
+#include "AnnotationJournal.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class AnnotationJournalTest : public ::testing::Test {
+protected:
+    fs::path root;
+    std::string path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_annotation_journal_") + info->name());
+        fs::remove_all(root);
+        path = AnnotationJournal::PathFor(root.string(), "0123456789abcdef");
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    static StoredAnnotation Square(int id, double x, const std::string& name) {
+        StoredAnnotation annotation;
+        annotation.id = id;
+        annotation.name = name;
+        annotation.vertices = {Vec2(x, 0), Vec2(x + 10, 0), Vec2(x + 10, 10), Vec2(x, 10)};
+        return annotation;
+    }
+
+    AnnotationJournal::Contents Reopen() {
+        AnnotationJournal journal;
+        AnnotationJournal::Contents contents;
+        EXPECT_TRUE(journal.Open(path, contents));
+        return contents;
+    }
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST_F(AnnotationJournalTest, Open_CreatesEmptyJournal) {
+    AnnotationJournal::Contents contents = Reopen();
+    EXPECT_TRUE(contents.annotations.empty());
+    EXPECT_TRUE(contents.cards.empty());
+    EXPECT_TRUE(fs::exists(path));
+}
+
+TEST_F(AnnotationJournalTest, Changes_SurviveReopen) {
+    {
+        AnnotationJournal journal;
+        AnnotationJournal::Contents contents;
+        ASSERT_TRUE(journal.Open(path, contents));
+        journal.PutAnnotation(Square(1, 0, "first"));
+        journal.PutAnnotation(Square(2, 100, "second"));
+        journal.PutAnnotation(Square(3, 200, "third"));
+        journal.PutAnnotation(Square(1, 0, "renamed"));
+        journal.DeleteAnnotation(2);
+
+        pathview::ActionCard card("card-1", "Count tumor cells");
+        card.summary = "Three ROIs";
+        card.AppendLog("started", "info");
+        card.UpdateStatus(pathview::ActionCardStatus::COMPLETED);
+        journal.PutCard(card);
+        journal.PutCard(pathview::ActionCard("card-2", "Dropped"));
+        journal.DeleteCard("card-2");
+        // Closing writes what is queued
+    }
+
+    AnnotationJournal::Contents contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 2u);
+    EXPECT_EQ(contents.annotations[0].id, 1);
+    EXPECT_EQ(contents.annotations[0].name, "renamed");
+    EXPECT_EQ(contents.annotations[1].id, 3);
+    ASSERT_EQ(contents.annotations[1].vertices.size(), 4u);
+    EXPECT_DOUBLE_EQ(contents.annotations[1].vertices[2].x, 210.0);
+    EXPECT_DOUBLE_EQ(contents.annotations[1].vertices[2].y, 10.0);
+
+    ASSERT_EQ(contents.cards.size(), 1u);
+    const pathview::ActionCard& card = contents.cards[0];
+    EXPECT_EQ(card.id, "card-1");
+    EXPECT_EQ(card.title, "Count tumor cells");
+    EXPECT_EQ(card.summary, "Three ROIs");
+    EXPECT_EQ(card.status, pathview::ActionCardStatus::COMPLETED);
+    ASSERT_EQ(card.logEntries.size(), 1u);
+    EXPECT_EQ(card.logEntries[0].message, "started");
+    EXPECT_EQ(card.logEntries[0].level, "info");
+}
+
+TEST_F(AnnotationJournalTest, Flush_PutsQueuedChangesInFile) {
+    AnnotationJournal journal;
+    AnnotationJournal::Contents contents;
+    ASSERT_TRUE(journal.Open(path, contents));
+    const auto emptySize = fs::file_size(path);
+
+    journal.PutAnnotation(Square(1, 0, "a"));
+    journal.Flush();
+    EXPECT_GT(fs::file_size(path), emptySize);
+    EXPECT_EQ(journal.GetRecordCount(), 1u);
+    EXPECT_EQ(journal.GetLiveCount(), 1u);
+}
+
+TEST_F(AnnotationJournalTest, TornRecord_IsCutOff) {
+    {
+        AnnotationJournal journal;
+        AnnotationJournal::Contents contents;
+        ASSERT_TRUE(journal.Open(path, contents));
+        journal.PutAnnotation(Square(1, 0, "kept"));
+        journal.PutAnnotation(Square(2, 100, "torn"));
+    }
+    // A crash partway through the last record
+    fs::resize_file(path, fs::file_size(path) - 5);
+
+    AnnotationJournal::Contents contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 1u);
+    EXPECT_EQ(contents.annotations[0].name, "kept");
+
+    // Appends after the cut read back
+    {
+        AnnotationJournal journal;
+        ASSERT_TRUE(journal.Open(path, contents));
+        journal.PutAnnotation(Square(3, 200, "after"));
+    }
+    contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 2u);
+    EXPECT_EQ(contents.annotations[1].name, "after");
+}
+
+TEST_F(AnnotationJournalTest, CorruptRecord_StopsReplayThere) {
+    {
+        AnnotationJournal journal;
+        AnnotationJournal::Contents contents;
+        ASSERT_TRUE(journal.Open(path, contents));
+        journal.PutAnnotation(Square(1, 0, "kept"));
+        journal.PutAnnotation(Square(2, 100, "flipped"));
+    }
+    // Flip the last byte: the checksum no longer matches
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-1, std::ios::end);
+        char last = 0;
+        file.read(&last, 1);
+        file.seekp(-1, std::ios::end);
+        last = static_cast<char>(last ^ 0x5A);
+        file.write(&last, 1);
+    }
+
+    AnnotationJournal::Contents contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 1u);
+    EXPECT_EQ(contents.annotations[0].name, "kept");
+}
+
+TEST_F(AnnotationJournalTest, Compaction_ShrinksLogAndKeepsLiveRecords) {
+    const size_t rounds = AnnotationJournal::MIN_COMPACT_RECORDS;
+    {
+        AnnotationJournal journal;
+        AnnotationJournal::Contents contents;
+        ASSERT_TRUE(journal.Open(path, contents));
+        // Ten annotations edited over and over: mostly superseded records
+        for (size_t i = 0; i < rounds; ++i) {
+            int id = static_cast<int>(i % 10) + 1;
+            journal.PutAnnotation(Square(id, id * 100.0, "edit " + std::to_string(i)));
+        }
+        journal.Flush();
+        EXPECT_LT(journal.GetRecordCount(), rounds);
+        EXPECT_EQ(journal.GetLiveCount(), 10u);
+    }
+
+    AnnotationJournal::Contents contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 10u);
+    for (size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(contents.annotations[i].id, static_cast<int>(i) + 1);
+        const size_t lastEdit = rounds - 1 - (rounds - 1 - i) % 10;
+        EXPECT_EQ(contents.annotations[i].name, "edit " + std::to_string(lastEdit));
+    }
+}
+
+TEST_F(AnnotationJournalTest, ForeignFile_IsStartedOver) {
+    fs::create_directories(root);
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a journal";
+    }
+    AnnotationJournal::Contents contents = Reopen();
+    EXPECT_TRUE(contents.annotations.empty());
+
+    {
+        AnnotationJournal journal;
+        ASSERT_TRUE(journal.Open(path, contents));
+        journal.PutAnnotation(Square(1, 0, "new"));
+    }
+    contents = Reopen();
+    ASSERT_EQ(contents.annotations.size(), 1u);
+}
@@ -0,0 +1,151 @@
+// AsyncFileReader Unit Tests
+// Tests for batched positional reads through io_uring (where the build and
+// kernel allow it) and through the I/O thread fallback: data, batches
+// larger than one submission, and failure reporting.
+
+#include <gtest/gtest.h>
+#include "AsyncFileReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class AsyncFileReaderTest : public ::testing::Test {
+protected:
+    static constexpr size_t FILE_BYTES = 1 << 20;
+
+    fs::path path;
+    std::vector<uint8_t> contents;
+    int fd = -1;
+    std::FILE* file = nullptr;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = fs::temp_directory_path() / (std::string("pathview_async_reader_") + info->name());
+        contents.resize(FILE_BYTES);
+        for (size_t i = 0; i < contents.size(); ++i) {
+            contents[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+        }
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+        out.close();
+#ifndef _WIN32
+        fd = open(path.string().c_str(), O_RDONLY);
+        ASSERT_GE(fd, 0);
+#endif
+        file = std::fopen(path.string().c_str(), "rb");
+        ASSERT_NE(file, nullptr);
+    }
+
+    void TearDown() override {
+#ifndef _WIN32
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+        if (file) {
+            std::fclose(file);
+        }
+        fs::remove(path);
+    }
+
+    // Serialised reads through stdio, counted
+    AsyncFileReader::ReadFunction Read() {
+        return [this](uint64_t offset, void* data, size_t size) {
+            reads++;
+            std::lock_guard<std::mutex> lock(fileMutex);
+            return std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+                   std::fread(data, 1, size, file) == size;
+        };
+    }
+
+    // count reads of size bytes spread over the file
+    bool ReadSpread(AsyncFileReader& reader, size_t count, size_t size, std::vector<std::vector<uint8_t>>& out) {
+        out.assign(count, std::vector<uint8_t>(size));
+        std::vector<AsyncFileReader::Request> requests;
+        for (size_t i = 0; i < count; ++i) {
+            requests.push_back({(i * 7919 * 64) % (FILE_BYTES - size), size, out[i].data()});
+        }
+        return reader.ReadBatch(requests.data(), requests.size());
+    }
+
+    void ExpectSpread(const std::vector<std::vector<uint8_t>>& out, size_t size) {
+        for (size_t i = 0; i < out.size(); ++i) {
+            size_t offset = (i * 7919 * 64) % (FILE_BYTES - size);
+            ASSERT_TRUE(std::equal(out[i].begin(), out[i].end(), contents.begin() + offset)) << "read " << i;
+        }
+    }
+
+    std::atomic<size_t> reads{0};
+    std::mutex fileMutex;
+};
+
+}  // namespace
+
+TEST_F(AsyncFileReaderTest, Create_ReadsBatch) {
+    auto reader = AsyncFileReader::Create(fd, Read());
+    ASSERT_NE(reader, nullptr);
+    std::cout << "AsyncFileReader: " << reader->GetName() << std::endl;
+
+    std::vector<std::vector<uint8_t>> out;
+    ASSERT_TRUE(ReadSpread(*reader, 16, 4096, out));
+    ExpectSpread(out, 4096);
+}
+
+TEST_F(AsyncFileReaderTest, Create_BatchLargerThanRing_ReadsAll) {
+    auto reader = AsyncFileReader::Create(fd, Read());
+
+    std::vector<std::vector<uint8_t>> out;
+    ASSERT_TRUE(ReadSpread(*reader, AsyncFileReader::RING_ENTRIES * 2 + 3, 1000, out));
+    ExpectSpread(out, 1000);
+}
+
+TEST_F(AsyncFileReaderTest, Create_ReadPastEnd_Fails) {
+    auto reader = AsyncFileReader::Create(fd, Read());
+    std::vector<uint8_t> inside(64);
+    std::vector<uint8_t> past(64);
+    AsyncFileReader::Request requests[] = {
+        {0, inside.size(), inside.data()},
+        {FILE_BYTES - 16, past.size(), past.data()},
+    };
+
+    EXPECT_FALSE(reader->ReadBatch(requests, 2));
+    EXPECT_TRUE(std::equal(inside.begin(), inside.end(), contents.begin()));
+}
+
+TEST_F(AsyncFileReaderTest, Threaded_ReadsBatchThroughReadFunction) {
+    auto reader = AsyncFileReader::CreateThreaded(Read());
+    EXPECT_STREQ(reader->GetName(), "threads");
+
+    std::vector<std::vector<uint8_t>> out;
+    ASSERT_TRUE(ReadSpread(*reader, 40, 2048, out));
+    ExpectSpread(out, 2048);
+    EXPECT_EQ(reads.load(), 40u);
+}
+
+TEST_F(AsyncFileReaderTest, Threaded_FailedRead_FailsBatch) {
+    auto reader = AsyncFileReader::CreateThreaded([](uint64_t offset, void*, size_t) { return offset != 100; });
+    std::vector<uint8_t> buffer(3 * 10);
+    AsyncFileReader::Request requests[] = {
+        {0, 10, buffer.data()},
+        {100, 10, buffer.data() + 10},
+        {200, 10, buffer.data() + 20},
+    };
+
+    EXPECT_FALSE(reader->ReadBatch(requests, 3));
+    EXPECT_TRUE(reader->ReadBatch(requests, 1));
+    EXPECT_TRUE(reader->ReadBatch(requests, 0));
+}
@@ -0,0 +1,183 @@
+// BlockCompressor Unit Tests
+// Tests for BC1/BC7 round-trip quality on slide-like content, transparent
+// edges, partial blocks and compressed sizes
+
+#include <gtest/gtest.h>
+#include "BlockCompressor.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+uint32_t Argb(int a, int r, int g, int b) {
+    return (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+}
+
+// Stained-tissue-like pixels: smooth pink/purple gradients with noise
+std::vector<uint32_t> TissuePixels(int32_t width, int32_t height) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(-6, 6);
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    for (int32_t y = 0; y < height; ++y) {
+        for (int32_t x = 0; x < width; ++x) {
+            const double s = 0.5 + 0.5 * std::sin(x * 0.11) * std::cos(y * 0.07);
+            const int r = std::clamp(int(230 - 90 * s) + noise(rng), 0, 255);
+            const int g = std::clamp(int(190 - 140 * s) + noise(rng), 0, 255);
+            const int b = std::clamp(int(220 - 40 * s) + noise(rng), 0, 255);
+            pixels[static_cast<size_t>(y) * width + x] = Argb(255, r, g, b);
+        }
+    }
+    return pixels;
+}
+
+std::vector<uint32_t> RoundTrip(TextureCompression compression, const std::vector<uint32_t>& pixels,
+                                int32_t width, int32_t height) {
+    std::vector<uint8_t> blocks(BlockCompressor::CompressedSize(compression, width, height));
+    BlockCompressor::Compress(compression, pixels.data(), width * 4, width, height, blocks.data());
+    std::vector<uint32_t> decoded(pixels.size());
+    BlockCompressor::Decompress(compression, blocks.data(), width, height, decoded.data());
+    return decoded;
+}
+
+double Psnr(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            const double d = double((a[i] >> shift) & 255) - double((b[i] >> shift) & 255);
+            sum += d * d;
+        }
+    }
+    const double mse = sum / (a.size() * 4.0);
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+}  // namespace
+
+// ============================================================================
+// Size Tests
+// ============================================================================
+
+TEST(BlockCompressorTest, CompressedSize_WholeBlocks) {
+    EXPECT_EQ(BlockCompressor::CompressedSize(TextureCompression::Bc7, 512, 512), 512u * 512u);
+    EXPECT_EQ(BlockCompressor::CompressedSize(TextureCompression::Bc1, 512, 512), 512u * 512u / 2);
+    EXPECT_EQ(BlockCompressor::CompressedSize(TextureCompression::None, 512, 512), 512u * 512u * 4);
+    // 13x9 rounds up to 4x3 blocks
+    EXPECT_EQ(BlockCompressor::CompressedSize(TextureCompression::Bc7, 13, 9), 12u * 16u);
+    EXPECT_EQ(BlockCompressor::CompressedSize(TextureCompression::Bc1, 13, 9), 12u * 8u);
+}
+
+TEST(BlockCompressorTest, ParseTextureCompression_Names) {
+    EXPECT_EQ(ParseTextureCompression("bc7"), TextureCompression::Bc7);
+    EXPECT_EQ(ParseTextureCompression("bc1"), TextureCompression::Bc1);
+    EXPECT_EQ(ParseTextureCompression("none"), TextureCompression::None);
+    EXPECT_FALSE(ParseTextureCompression("astc").has_value());
+    EXPECT_STREQ(TextureCompressionName(TextureCompression::Bc7), "bc7");
+}
+
+// ============================================================================
+// Quality Tests
+// ============================================================================
+
+TEST(BlockCompressorTest, Bc7_TissueContent_NearLossless) {
+    const auto pixels = TissuePixels(256, 256);
+    const double psnr = Psnr(pixels, RoundTrip(TextureCompression::Bc7, pixels, 256, 256));
+    EXPECT_GT(psnr, 38.0);
+}
+
+TEST(BlockCompressorTest, Bc1_TissueContent_Acceptable) {
+    const auto pixels = TissuePixels(256, 256);
+    const double psnr = Psnr(pixels, RoundTrip(TextureCompression::Bc1, pixels, 256, 256));
+    EXPECT_GT(psnr, 30.0);
+}
+
+TEST(BlockCompressorTest, SolidColor_RoundTripsClosely) {
+    const std::vector<uint32_t> pixels(64, Argb(255, 200, 100, 50));
+    for (auto compression : {TextureCompression::Bc7, TextureCompression::Bc1}) {
+        const auto decoded = RoundTrip(compression, pixels, 8, 8);
+        for (uint32_t p : decoded) {
+            EXPECT_EQ(p >> 24, 255u);
+            EXPECT_NEAR(int((p >> 16) & 255), 200, 4);
+            EXPECT_NEAR(int((p >> 8) & 255), 100, 4);
+            EXPECT_NEAR(int(p & 255), 50, 4);
+        }
+    }
+}
+
+TEST(BlockCompressorTest, None_IsExact) {
+    const auto pixels = TissuePixels(13, 9);
+    EXPECT_EQ(RoundTrip(TextureCompression::None, pixels, 13, 9), pixels);
+}
+
+// ============================================================================
+// Edge Tests
+// ============================================================================
+
+TEST(BlockCompressorTest, Bc1_TransparentPixels_DecodeToZero) {
+    // Left half outside the slide (premultiplied transparent), right half tissue
+    auto pixels = TissuePixels(16, 16);
+    for (int32_t y = 0; y < 16; ++y) {
+        for (int32_t x = 0; x < 6; ++x) {
+            pixels[y * 16 + x] = 0;
+        }
+    }
+    const auto decoded = RoundTrip(TextureCompression::Bc1, pixels, 16, 16);
+    for (int32_t y = 0; y < 16; ++y) {
+        for (int32_t x = 0; x < 16; ++x) {
+            if (x < 6) {
+                EXPECT_EQ(decoded[y * 16 + x], 0u);
+            } else {
+                EXPECT_EQ(decoded[y * 16 + x] >> 24, 255u);
+            }
+        }
+    }
+}
+
+TEST(BlockCompressorTest, Bc7_TransparentPixels_StayNearZero) {
+    auto pixels = TissuePixels(16, 16);
+    for (int32_t x = 0; x < 16; ++x) {
+        pixels[x] = 0;
+    }
+    const auto decoded = RoundTrip(TextureCompression::Bc7, pixels, 16, 16);
+    for (int32_t x = 0; x < 16; ++x) {
+        EXPECT_LE(decoded[x] >> 24, 8u);
+    }
+}
+
+TEST(BlockCompressorTest, PartialBlocks_OddSize_RoundTrip) {
+    const auto pixels = TissuePixels(13, 9);
+    EXPECT_GT(Psnr(pixels, RoundTrip(TextureCompression::Bc7, pixels, 13, 9)), 36.0);
+    EXPECT_GT(Psnr(pixels, RoundTrip(TextureCompression::Bc1, pixels, 13, 9)), 28.0);
+}
+
+TEST(BlockCompressorTest, Compress_HonorsPitch) {
+    // 8x4 image inside rows of 12 pixels
+    const auto tight = TissuePixels(8, 4);
+    std::vector<uint32_t> padded(12 * 4, 0xDEADBEEF);
+    for (int32_t y = 0; y < 4; ++y) {
+        std::copy(tight.begin() + y * 8, tight.begin() + y * 8 + 8, padded.begin() + y * 12);
+    }
+    std::vector<uint8_t> a(BlockCompressor::CompressedSize(TextureCompression::Bc7, 8, 4));
+    std::vector<uint8_t> b(a.size());
+    BlockCompressor::Compress(TextureCompression::Bc7, tight.data(), 8 * 4, 8, 4, a.data());
+    BlockCompressor::Compress(TextureCompression::Bc7, padded.data(), 12 * 4, 8, 4, b.data());
+    EXPECT_EQ(a, b);
+}
+
+// ============================================================================
+// Performance Tests
+// ============================================================================
+
+TEST(BlockCompressorTest, Performance_TileCompressionTime) {
+    const auto pixels = TissuePixels(512, 512);
+    std::vector<uint8_t> blocks(BlockCompressor::CompressedSize(TextureCompression::Bc7, 512, 512));
+    for (auto compression : {TextureCompression::Bc1, TextureCompression::Bc7}) {
+        const auto start = std::chrono::steady_clock::now();
+        BlockCompressor::Compress(compression, pixels.data(), 512 * 4, 512, 512, blocks.data());
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::cout << TextureCompressionName(compression) << " 512x512 tile: " << elapsed.count() << " ms"
+                  << std::endl;
+    }
+}
@@ -0,0 +1,138 @@
+// CellStatsPyramid Unit Tests
+// Tests for per-class region summaries: rectangles and outlines agree with
+// visiting every cell, sums of area and confidence, centroids left of or
+// above the slide origin, and the density layer built from level 0
+
+#include <gtest/gtest.h>
+#include "CellStatsPyramid.h"
+#include "PolygonDensity.h"
+#include "PolygonIndex.h"
+#include <random>
+
+namespace {
+
+constexpr int32_t BIN = CellStatsPyramid::BIN_SIZE;
+
+void AddCell(PolygonStore& polygons, int classId, double centerX, double centerY, double half = 4) {
+    polygons.Add(classId, {Vec2(centerX - half, centerY - half), Vec2(centerX + half, centerY - half),
+                           Vec2(centerX + half, centerY + half), Vec2(centerX - half, centerY + half)});
+}
+
+PolygonStore RandomCells(size_t count, double extent, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> position(0.0, extent);
+    std::uniform_int_distribution<int> classId(1, 4);
+    PolygonStore polygons;
+    for (size_t i = 0; i < count; ++i) {
+        AddCell(polygons, classId(random), position(random), position(random));
+        polygons.SetConfidence(static_cast<uint32_t>(i), 0.5f + 0.5f * float(i % 2));
+    }
+    return polygons;
+}
+
+}  // namespace
+
+TEST(CellStatsPyramidTest, EmptyStore_SummarizesNothing) {
+    CellStatsPyramid stats;
+    stats.Build(PolygonStore());
+    EXPECT_TRUE(stats.Empty());
+    std::map<int, CellStatsPyramid::ClassStats> out;
+    stats.Summarize(PolygonStore(), Rect(0, 0, 100, 100), out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(CellStatsPyramidTest, Rectangle_MatchesVisitingEveryCell) {
+    PolygonStore polygons = RandomCells(20000, 10000.0, 3);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+    ASSERT_FALSE(stats.Empty());
+    EXPECT_EQ(stats.GetLevel(stats.GetLevelCount() - 1).columns, 1);
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> position(-500.0, 10500.0);
+    for (int query = 0; query < 50; ++query) {
+        double x0 = position(random), x1 = position(random), y0 = position(random), y1 = position(random);
+        const Rect region(std::min(x0, x1), std::min(y0, y1), std::abs(x1 - x0), std::abs(y1 - y0));
+
+        std::map<int, CellStatsPyramid::ClassStats> expected;
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            Vec2 c = polygons.GetCentroid(polygon);
+            if (c.x >= region.x && c.x <= region.Right() && c.y >= region.y && c.y <= region.Bottom()) {
+                CellStatsPyramid::ClassStats& e = expected[polygons.GetClassId(polygon)];
+                e.count++;
+                e.area += polygons.GetArea(polygon);
+                e.confidence += polygons.GetConfidence(polygon);
+            }
+        }
+
+        std::map<int, CellStatsPyramid::ClassStats> out;
+        stats.Summarize(polygons, region, out);
+        ASSERT_EQ(out.size(), expected.size());
+        for (const auto& [classId, e] : expected) {
+            EXPECT_EQ(out[classId].count, e.count);
+            EXPECT_NEAR(out[classId].area, e.area, 1e-6 * e.area);
+            EXPECT_NEAR(out[classId].confidence, e.confidence, 1e-6 * e.confidence);
+        }
+    }
+}
+
+TEST(CellStatsPyramidTest, Outline_MatchesCountCentroids) {
+    PolygonStore polygons = RandomCells(20000, 10000.0, 5);
+    PolygonIndex index;
+    index.Build(polygons);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+
+    PolygonMask mask({Vec2(1000, 1000), Vec2(9000, 2000), Vec2(5000, 5000), Vec2(8000, 9000), Vec2(1500, 7000)});
+    std::map<int, int> expected;
+    mask.CountCentroids(polygons, &index, expected);
+
+    std::map<int, CellStatsPyramid::ClassStats> out;
+    stats.Summarize(polygons, mask, out);
+    ASSERT_EQ(out.size(), expected.size());
+    for (const auto& [classId, count] : expected) {
+        EXPECT_EQ(out[classId].count, uint64_t(count));
+    }
+    EXPECT_FLOAT_EQ(stats.GetMinConfidence(), 0.5f);
+}
+
+TEST(CellStatsPyramidTest, CentroidsLeftOfOrigin) {
+    PolygonStore polygons;
+    AddCell(polygons, 1, -300, -10);
+    AddCell(polygons, 1, -100, 50);
+    AddCell(polygons, 2, 200, 200);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+    EXPECT_LE(stats.GetOriginX(), -300.0);
+
+    std::map<int, CellStatsPyramid::ClassStats> out;
+    stats.Summarize(polygons, Rect(-400, -400, 400, 800), out);
+    EXPECT_EQ(out[1].count, 2u);
+    EXPECT_EQ(out.count(2), 0u);
+    EXPECT_DOUBLE_EQ(out[1].area, 128.0);
+}
+
+TEST(CellStatsPyramidTest, Density_SameAsFromCells) {
+    PolygonStore polygons;
+    for (int i = 0; i < 200; ++i) {
+        AddCell(polygons, 1 + i % 3, (i * 37) % 1000 + 10, (i * 91) % 700 + 10);
+    }
+    std::map<int, SDL_Color> colors = {{1, {255, 0, 0, 255}}, {2, {0, 255, 0, 255}}, {3, {0, 0, 255, 255}}};
+    ClassVisibility visibility;
+    visibility.SetVisible(3, false);
+
+    PolygonDensity fromCells;
+    fromCells.Build(polygons, colors, visibility);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+    PolygonDensity fromStats;
+    ASSERT_TRUE(fromStats.Build(stats, colors, visibility));
+
+    ASSERT_EQ(fromStats.GetLevelCount(), fromCells.GetLevelCount());
+    for (size_t level = 0; level < fromCells.GetLevelCount(); ++level) {
+        EXPECT_EQ(fromStats.GetLevel(level).columns, fromCells.GetLevel(level).columns);
+        EXPECT_EQ(fromStats.GetLevel(level).rows, fromCells.GetLevel(level).rows);
+        EXPECT_EQ(fromStats.GetLevel(level).pixels, fromCells.GetLevel(level).pixels);
+    }
+    EXPECT_EQ(BIN, PolygonDensity::BIN_SIZE);
+}
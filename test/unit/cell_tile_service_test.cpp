@@ -0,0 +1,405 @@
+// CellTileService Unit Tests
+// Tests for the Mapbox Vector Tiles of cell polygons: encoding, the
+// per-level detail, tile lookup and the encoded tile cache, decoded by a
+// small protobuf reader
+
+#include <gtest/gtest.h>
+#include "CellTileService.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int64_t SLIDE_SIZE = 4096;  // DeepZoom level 12 is full resolution
+constexpr int32_t MAX_LEVEL = 12;
+constexpr double PI = 3.14159265358979323846;
+
+// Just enough of the protobuf wire format to read a tile back
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool AtEnd() const { return p_ >= end_; }
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; p_ < end_; shift += 7) {
+            uint8_t byte = *p_++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // Field number, with the wire type in wireType
+    uint32_t Tag(uint32_t& wireType) {
+        uint64_t tag = Varint();
+        wireType = static_cast<uint32_t>(tag & 7);
+        return static_cast<uint32_t>(tag >> 3);
+    }
+
+    Reader Bytes() {
+        size_t size = static_cast<size_t>(Varint());
+        Reader inner(p_, size);
+        p_ += size;
+        return inner;
+    }
+
+    std::string String() {
+        Reader inner = Bytes();
+        return std::string(reinterpret_cast<const char*>(inner.p_), inner.end_ - inner.p_);
+    }
+
+    float Fixed32Float() {
+        float value;
+        std::memcpy(&value, p_, sizeof(value));
+        p_ += 4;
+        return value;
+    }
+
+    std::vector<uint32_t> Packed() {
+        Reader inner = Bytes();
+        std::vector<uint32_t> values;
+        while (!inner.AtEnd()) {
+            values.push_back(static_cast<uint32_t>(inner.Varint()));
+        }
+        return values;
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+struct Point {
+    int32_t x, y;
+};
+
+struct Feature {
+    uint64_t id = 0;
+    std::vector<uint32_t> tags;
+    uint32_t type = 0;
+    std::vector<Point> points;  // Cursor positions of every MoveTo / LineTo
+    int closePaths = 0;
+};
+
+struct Value {
+    std::string text;
+    float number = 0.0f;
+    uint64_t integer = 0;
+};
+
+struct Layer {
+    uint32_t version = 0;
+    std::string name;
+    uint32_t extent = 0;
+    std::vector<Feature> features;
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+    int count = 0;  // Layers in the tile
+};
+
+int32_t ZigZagDecode(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+Feature DecodeFeature(Reader reader) {
+    Feature feature;
+    while (!reader.AtEnd()) {
+        uint32_t wireType;
+        switch (reader.Tag(wireType)) {
+            case 1: feature.id = reader.Varint(); break;
+            case 2: feature.tags = reader.Packed(); break;
+            case 3: feature.type = static_cast<uint32_t>(reader.Varint()); break;
+            case 4: {
+                std::vector<uint32_t> geometry = reader.Packed();
+                Point cursor{0, 0};
+                for (size_t i = 0; i < geometry.size();) {
+                    uint32_t command = geometry[i] & 7;
+                    uint32_t count = geometry[i] >> 3;
+                    ++i;
+                    if (command == 7) {
+                        feature.closePaths += static_cast<int>(count);
+                        continue;
+                    }
+                    for (uint32_t j = 0; j < count; ++j, i += 2) {
+                        cursor.x += ZigZagDecode(geometry[i]);
+                        cursor.y += ZigZagDecode(geometry[i + 1]);
+                        feature.points.push_back(cursor);
+                    }
+                }
+                break;
+            }
+            default: ADD_FAILURE() << "Unexpected feature field"; return feature;
+        }
+    }
+    return feature;
+}
+
+Layer DecodeTile(const std::vector<uint8_t>& data) {
+    Layer layer;
+    Reader tile(data.data(), data.size());
+    while (!tile.AtEnd()) {
+        uint32_t wireType;
+        EXPECT_EQ(tile.Tag(wireType), 3u);
+        ++layer.count;
+        Reader reader = tile.Bytes();
+        while (!reader.AtEnd()) {
+            switch (reader.Tag(wireType)) {
+                case 15: layer.version = static_cast<uint32_t>(reader.Varint()); break;
+                case 1: layer.name = reader.String(); break;
+                case 2: layer.features.push_back(DecodeFeature(reader.Bytes())); break;
+                case 3: layer.keys.push_back(reader.String()); break;
+                case 4: {
+                    Reader valueReader = reader.Bytes();
+                    Value value;
+                    while (!valueReader.AtEnd()) {
+                        uint32_t field = valueReader.Tag(wireType);
+                        if (field == 1) {
+                            value.text = valueReader.String();
+                        } else if (field == 2) {
+                            value.number = valueReader.Fixed32Float();
+                        } else {
+                            value.integer = valueReader.Varint();
+                        }
+                    }
+                    layer.values.push_back(value);
+                    break;
+                }
+                case 5: layer.extent = static_cast<uint32_t>(reader.Varint()); break;
+                default: ADD_FAILURE() << "Unexpected layer field"; return layer;
+            }
+        }
+    }
+    return layer;
+}
+
+// Twice the signed area by the MVT surveyor's formula (positive: exterior)
+int64_t RingArea(const std::vector<Point>& ring) {
+    int64_t area = 0;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        area += int64_t(ring[j].x) * ring[i].y - int64_t(ring[i].x) * ring[j].y;
+    }
+    return area;
+}
+
+// Value of a feature's tag by key, or null
+const Value* FindTag(const Layer& layer, const Feature& feature, const std::string& key) {
+    for (size_t i = 0; i + 1 < feature.tags.size(); i += 2) {
+        if (layer.keys.at(feature.tags[i]) == key) {
+            return &layer.values.at(feature.tags[i + 1]);
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class CellTileServiceTest : public ::testing::Test {
+protected:
+    PolygonStore polygons;
+    PolygonIndex index;
+    CellTileService service;
+    std::string slideId = TileService::MakeSlideId("/slides/cells.svs");
+
+    // A 64-gon of radius 40 at (100, 100), counterclockwise on screen, and
+    // a 3x3 square at (200, 200)
+    void SetUp() override {
+        std::vector<Vec2> circle;
+        for (int i = 0; i < 64; ++i) {
+            double angle = -2.0 * PI * i / 64;
+            circle.emplace_back(100.0 + 40.0 * std::cos(angle), 100.0 + 40.0 * std::sin(angle));
+        }
+        polygons.Add(1, circle);
+        polygons.Add(2, {Vec2(200, 200), Vec2(203, 200), Vec2(203, 203), Vec2(200, 203)});
+        polygons.SetConfidence(1, 0.5f);
+        polygons.TriangulateAll(1);
+        index.Build(polygons, 1);
+        Serve();
+    }
+
+    void Serve() {
+        CellTileSource cells;
+        cells.slideId = slideId;
+        cells.width = SLIDE_SIZE;
+        cells.height = SLIDE_SIZE;
+        cells.polygons = &polygons;
+        cells.index = &index;
+        cells.classNames = {{1, "Tumor"}, {2, "Lymphocyte"}};
+        service.SetSource(std::move(cells));
+    }
+
+    Layer Fetch(int32_t level, int64_t column = 0, int64_t row = 0) {
+        EncodedTile tile;
+        EXPECT_EQ(service.GetTile(slideId, level, column, row, tile), TileServiceStatus::Ok);
+        EXPECT_STREQ(tile.mimeType, CellTileService::MIME_TYPE);
+        return tile.data ? DecodeTile(*tile.data) : Layer();
+    }
+};
+
+// ============================================================================
+// Encoding Tests
+// ============================================================================
+
+TEST_F(CellTileServiceTest, FullResolution_EncodesLayerAndFeatures) {
+    Layer layer = Fetch(MAX_LEVEL);
+    EXPECT_EQ(layer.count, 1);
+    EXPECT_EQ(layer.version, 2u);
+    EXPECT_EQ(layer.name, "cells");
+    EXPECT_EQ(layer.extent, CellTileService::EXTENT);
+    ASSERT_EQ(layer.features.size(), 2u);
+
+    // 80 pixels across: every vertex of the outline, closed once
+    const Feature& circle = layer.features[0];
+    EXPECT_EQ(circle.id, 0u);
+    EXPECT_EQ(circle.type, 3u);
+    EXPECT_EQ(circle.points.size(), 64u);
+    EXPECT_EQ(circle.closePaths, 1);
+    EXPECT_TRUE(std::any_of(circle.points.begin(), circle.points.end(), [](const Point& p) {
+        return p.x == 140 * 16 && p.y == 100 * 16;  // 16 tile units per pixel
+    }));
+
+    // 3 pixels across: the centroid
+    const Feature& square = layer.features[1];
+    EXPECT_EQ(square.id, 1u);
+    EXPECT_EQ(square.type, 1u);
+    ASSERT_EQ(square.points.size(), 1u);
+    EXPECT_EQ(square.points[0].x, 3224);
+    EXPECT_EQ(square.points[0].y, 3224);
+}
+
+TEST_F(CellTileServiceTest, Tags_NameClassConfidence) {
+    Layer layer = Fetch(MAX_LEVEL);
+    ASSERT_EQ(layer.features.size(), 2u);
+
+    const Value* classId = FindTag(layer, layer.features[0], "class");
+    const Value* name = FindTag(layer, layer.features[0], "class_name");
+    const Value* confidence = FindTag(layer, layer.features[0], "confidence");
+    ASSERT_TRUE(classId && name && confidence);
+    EXPECT_EQ(classId->integer, 1u);
+    EXPECT_EQ(name->text, "Tumor");
+    EXPECT_FLOAT_EQ(confidence->number, 1.0f);
+
+    const Value* squareName = FindTag(layer, layer.features[1], "class_name");
+    const Value* squareConfidence = FindTag(layer, layer.features[1], "confidence");
+    ASSERT_TRUE(squareName && squareConfidence);
+    EXPECT_EQ(squareName->text, "Lymphocyte");
+    EXPECT_FLOAT_EQ(squareConfidence->number, 0.5f);
+}
+
+TEST_F(CellTileServiceTest, Rings_AreClockwise) {
+    // The outline was added counterclockwise
+    Layer layer = Fetch(MAX_LEVEL);
+    ASSERT_FALSE(layer.features.empty());
+    EXPECT_GT(RingArea(layer.features[0].points), 0);
+}
+
+// ============================================================================
+// Level of Detail Tests
+// ============================================================================
+
+TEST_F(CellTileServiceTest, CoarserLevels_FollowPolygonLod) {
+    // 20 and 10 tile pixels: the simplified outline
+    for (int32_t level : {MAX_LEVEL - 2, MAX_LEVEL - 3}) {
+        Layer simplified = Fetch(level);
+        ASSERT_EQ(simplified.features.size(), 1u);  // The square is skipped
+        EXPECT_EQ(simplified.features[0].type, 3u);
+        EXPECT_GE(simplified.features[0].points.size(), 3u);
+        EXPECT_LT(simplified.features[0].points.size(), 64u);
+        EXPECT_GT(RingArea(simplified.features[0].points), 0);
+    }
+
+    // 5 tile pixels: the bounding box
+    Layer box = Fetch(MAX_LEVEL - 4);
+    ASSERT_EQ(box.features.size(), 1u);
+    EXPECT_EQ(box.features[0].type, 3u);
+    EXPECT_EQ(box.features[0].points.size(), 4u);
+    EXPECT_GT(RingArea(box.features[0].points), 0);
+
+    // 2.5 tile pixels: a point
+    Layer point = Fetch(MAX_LEVEL - 5);
+    ASSERT_EQ(point.features.size(), 1u);
+    EXPECT_EQ(point.features[0].type, 1u);
+}
+
+TEST_F(CellTileServiceTest, TooCoarseLevels_AreEmpty) {
+    EncodedTile tile;
+    ASSERT_EQ(service.GetTile(slideId, MAX_LEVEL - 6, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_TRUE(tile.data->empty());
+    ASSERT_EQ(service.GetTile(slideId, 0, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_TRUE(tile.data->empty());
+}
+
+TEST_F(CellTileServiceTest, PolygonAcrossTiles_InBoth) {
+    // The circle spans x 60..140; move it onto the border at x 256
+    polygons.Clear();
+    std::vector<Vec2> square = {Vec2(236, 20), Vec2(276, 20), Vec2(276, 60), Vec2(236, 60)};
+    polygons.Add(1, square);
+    polygons.TriangulateAll(1);
+    index.Build(polygons, 1);
+    Serve();
+
+    Layer left = Fetch(MAX_LEVEL, 0, 0);
+    Layer right = Fetch(MAX_LEVEL, 1, 0);
+    ASSERT_EQ(left.features.size(), 1u);
+    ASSERT_EQ(right.features.size(), 1u);
+    int32_t leftMax = 0;
+    int32_t rightMin = 0;
+    for (const Point& p : left.features[0].points) leftMax = std::max(leftMax, p.x);
+    for (const Point& p : right.features[0].points) rightMin = std::min(rightMin, p.x);
+    EXPECT_EQ(leftMax, 276 * 16);          // Past the extent
+    EXPECT_EQ(rightMin, (236 - 256) * 16);  // Before the origin
+}
+
+// ============================================================================
+// Lookup and Cache Tests
+// ============================================================================
+
+TEST_F(CellTileServiceTest, UnknownTiles_NotFound) {
+    EncodedTile tile;
+    EXPECT_EQ(service.GetTile("0000000000000000", MAX_LEVEL, 0, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL + 1, 0, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL, 16, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, -1, tile), TileServiceStatus::NotFound);
+    // Indices whose origins would overflow int64
+    EXPECT_EQ(service.GetTile(slideId, 0, int64_t{1} << 55, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, std::numeric_limits<int64_t>::max(), tile),
+              TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL, 15, 15, tile), TileServiceStatus::Ok);
+
+    service.ClearSource();
+    EXPECT_FALSE(service.HasSource());
+    EXPECT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, 0, tile), TileServiceStatus::NotFound);
+}
+
+TEST_F(CellTileServiceTest, RepeatedTile_ServedFromCache) {
+    EncodedTile first;
+    EncodedTile second;
+    ASSERT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, 0, first), TileServiceStatus::Ok);
+    ASSERT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, 0, second), TileServiceStatus::Ok);
+    EXPECT_EQ(service.GetEncodedMissCount(), 1u);
+    EXPECT_EQ(service.GetEncodedHitCount(), 1u);
+    EXPECT_EQ(first.data, second.data);
+    EXPECT_EQ(first.etag, second.etag);
+    EXPECT_EQ(service.GetEncodedCacheBytes(), first.data->size());
+
+    // Other polygons: encoded anew, under another ETag
+    polygons.SetConfidence(0, 0.25f);
+    Serve();
+    EXPECT_EQ(service.GetEncodedCacheBytes(), 0u);
+    ASSERT_EQ(service.GetTile(slideId, MAX_LEVEL, 0, 0, second), TileServiceStatus::Ok);
+    EXPECT_EQ(service.GetEncodedMissCount(), 2u);
+    EXPECT_NE(first.etag, second.etag);
+}
@@ -0,0 +1,55 @@
+// ClassNameTable Unit Tests
+// Tests for interning cell type names, lookups before and after freezing
+// to a perfect hash, and class IDs in sorted name order
+
+#include <gtest/gtest.h>
+#include "ClassNameTable.h"
+#include <string>
+
+TEST(ClassNameTableTest, Intern_NumbersInFirstSeenOrder) {
+    ClassNameTable table;
+    EXPECT_TRUE(table.Empty());
+    EXPECT_EQ(table.Find("Tumor"), ClassNameTable::NOT_FOUND);
+
+    EXPECT_EQ(table.Intern("Tumor"), 0u);
+    EXPECT_EQ(table.Intern("Stroma"), 1u);
+    EXPECT_EQ(table.Intern("Tumor"), 0u);
+    EXPECT_EQ(table.Intern(""), 2u);
+    EXPECT_EQ(table.Size(), 3u);
+    EXPECT_EQ(table.GetName(1), "Stroma");
+    EXPECT_EQ(table.Find(""), 2u);
+    EXPECT_EQ(table.Find("Lymphocytes"), ClassNameTable::NOT_FOUND);
+}
+
+TEST(ClassNameTableTest, Freeze_FindsEveryNameInOneProbe) {
+    ClassNameTable table;
+    for (int i = 0; i < 200; ++i) {
+        table.Intern("Cell type " + std::to_string(i));
+    }
+    ASSERT_TRUE(table.Freeze());
+    EXPECT_TRUE(table.IsFrozen());
+    for (uint32_t i = 0; i < 200; ++i) {
+        EXPECT_EQ(table.Find("Cell type " + std::to_string(i)), i);
+    }
+    EXPECT_EQ(table.Find("Cell type 200"), ClassNameTable::NOT_FOUND);
+    EXPECT_EQ(table.Find("Cell type"), ClassNameTable::NOT_FOUND);
+
+    // A new name goes back to probing, keeping the others
+    EXPECT_EQ(table.Intern("Cell type 200"), 200u);
+    EXPECT_FALSE(table.IsFrozen());
+    EXPECT_EQ(table.Find("Cell type 7"), 7u);
+    EXPECT_EQ(table.Find("Cell type 200"), 200u);
+}
+
+TEST(ClassNameTableTest, SortedIds_RankNames) {
+    ClassNameTable table;
+    table.Intern("Tumor");
+    table.Intern("Lymphocytes");
+    table.Intern("Stroma");
+    EXPECT_EQ(table.SortedIds(), (std::vector<int>{2, 0, 1}));
+
+    table.Clear();
+    EXPECT_TRUE(table.Empty());
+    EXPECT_TRUE(table.SortedIds().empty());
+    EXPECT_EQ(table.Find("Tumor"), ClassNameTable::NOT_FOUND);
+}
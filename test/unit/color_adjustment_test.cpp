@@ -0,0 +1,86 @@
+// ColorAdjustment Unit Tests
+// Tests that the blend passes of a plan, run with the render target's
+// 8-bit clamping after each, reproduce the clamped affine adjustment
+
+#include <gtest/gtest.h>
+#include "ColorAdjustment.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// One channel through the passes as the blender computes them
+int Simulate(const std::vector<ColorAdjustment::Pass>& passes, int channel, int value) {
+    for (const auto& pass : passes) {
+        const int c = pass.color[channel];
+        switch (pass.op) {
+            case ColorAdjustment::Pass::Op::Multiply: value = (value * c + 127) / 255; break;
+            case ColorAdjustment::Pass::Op::Scale: value = value + (value * c + 127) / 255; break;
+            case ColorAdjustment::Pass::Op::Add: value = value + c; break;
+            case ColorAdjustment::Pass::Op::Subtract: value = value - c; break;
+        }
+        value = std::max(0, std::min(value, 255));
+    }
+    return value;
+}
+
+int Expected(const ColorAdjustment& adjustment, int channel, int value) {
+    float in = value / 255.0f;
+    float out = adjustment.gain[channel] * ((in - 0.5f) * adjustment.contrast + 0.5f + adjustment.brightness);
+    return static_cast<int>(std::lround(std::max(0.0f, std::min(out, 1.0f)) * 255.0f));
+}
+
+// Largest difference over every input value of every channel
+int MaxError(const ColorAdjustment& adjustment) {
+    std::vector<ColorAdjustment::Pass> passes = adjustment.Plan();
+    int error = 0;
+    for (int channel = 0; channel < 3; ++channel) {
+        for (int value = 0; value < 256; ++value) {
+            error = std::max(error, std::abs(Simulate(passes, channel, value) - Expected(adjustment, channel, value)));
+        }
+    }
+    return error;
+}
+
+}  // namespace
+
+TEST(ColorAdjustmentTest, Identity_HasNoPasses) {
+    ColorAdjustment adjustment;
+    EXPECT_TRUE(adjustment.IsIdentity());
+    EXPECT_TRUE(adjustment.Plan().empty());
+}
+
+TEST(ColorAdjustmentTest, Brightness_IsOneBiasPass) {
+    ColorAdjustment adjustment;
+    adjustment.brightness = -0.2f;
+    std::vector<ColorAdjustment::Pass> passes = adjustment.Plan();
+
+    ASSERT_EQ(passes.size(), 1u);
+    EXPECT_EQ(passes[0].op, ColorAdjustment::Pass::Op::Subtract);
+    EXPECT_EQ(passes[0].color[0], 51);
+    EXPECT_LE(MaxError(adjustment), 1);
+}
+
+TEST(ColorAdjustmentTest, LowContrast_MatchesAffineMap) {
+    ColorAdjustment adjustment;
+    adjustment.contrast = 0.6f;
+    adjustment.brightness = 0.1f;
+    EXPECT_LE(MaxError(adjustment), 2);
+}
+
+TEST(ColorAdjustmentTest, HighContrast_SaturatesLikeClamp) {
+    ColorAdjustment adjustment;
+    adjustment.contrast = 3.0f;
+    adjustment.brightness = -0.15f;
+    EXPECT_LE(MaxError(adjustment), 3);
+}
+
+TEST(ColorAdjustmentTest, MixedChannelGains_EachChannelOnItsOwnPath) {
+    // Red scaled up (bias first), blue down (bias last), green unchanged
+    ColorAdjustment adjustment;
+    adjustment.gain[0] = 1.8f;
+    adjustment.gain[2] = 0.5f;
+    adjustment.brightness = 0.05f;
+    EXPECT_LE(MaxError(adjustment), 3);
+}
@@ -0,0 +1,86 @@
+// CommandExecutor Unit Tests
+// Tests for IPC jobs run on worker threads: results and exceptions through
+// the future, the completion callback, waiting for idle and dropping queued
+// jobs on destruction
+
+#include <gtest/gtest.h>
+#include "CommandExecutor.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using pathview::ipc::CommandExecutor;
+using pathview::ipc::json;
+
+TEST(CommandExecutorTest, Submit_ReturnsResultAndException) {
+    CommandExecutor executor(2);
+    EXPECT_EQ(executor.GetThreadCount(), 2u);
+
+    std::future<json> result = executor.Submit([]() { return json{{"width", 640}}; });
+    std::future<json> failure = executor.Submit([]() -> json { throw std::runtime_error("no slide"); });
+
+    EXPECT_EQ(result.get()["width"], 640);
+    EXPECT_THROW(failure.get(), std::runtime_error);
+}
+
+TEST(CommandExecutorTest, WaitIdle_AfterEveryJobAndCallback) {
+    std::atomic<int> completed{0};
+    std::atomic<int> finishedJobs{0};
+    CommandExecutor executor(3, [&completed]() { completed++; });
+
+    std::vector<std::future<json>> results;
+    for (int i = 0; i < 50; ++i) {
+        results.push_back(executor.Submit([&finishedJobs, i]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            finishedJobs++;
+            return json(i);
+        }));
+    }
+    executor.WaitIdle();
+    EXPECT_EQ(finishedJobs.load(), 50);
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(results[i].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(results[i].get(), i);
+    }
+
+    // The callback runs after the job's result is set
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (completed.load() < 50 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(completed.load(), 50);
+}
+
+TEST(CommandExecutorTest, Destruction_FinishesRunningAndDropsQueuedJobs) {
+    std::promise<void> started, release;
+    std::shared_future<void> released = release.get_future().share();
+    std::future<json> running, queued;
+    std::thread releaser;
+    {
+        CommandExecutor executor(1);
+        running = executor.Submit([&started, released]() {
+            started.set_value();
+            released.wait();
+            return json("ran");
+        });
+        queued = executor.Submit([]() { return json("never"); });
+        started.get_future().wait();
+
+        // Let the running job finish only once the destructor is waiting
+        releaser = std::thread([&release]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            release.set_value();
+        });
+    }
+    releaser.join();
+
+    EXPECT_EQ(running.get(), "ran");
+    try {
+        queued.get();
+        ADD_FAILURE() << "Queued job ran after destruction began";
+    } catch (const std::future_error& e) {
+        EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+    }
+}
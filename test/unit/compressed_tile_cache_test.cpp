@@ -0,0 +1,109 @@
+// CompressedTileCache Unit Tests
+// Tests for the compressed tier's round trips, LRU budget and statistics
+
+#include <gtest/gtest.h>
+#include "CompressedTileCache.h"
+#include <vector>
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class CompressedTileCacheTest : public ::testing::Test {
+protected:
+    static constexpr int32_t TILE_DIM = 64;
+
+    // Mostly background with a per-tile stripe, so tiles compress but differ
+    std::vector<uint32_t> MakeTile(uint32_t seed) {
+        std::vector<uint32_t> pixels(TILE_DIM * TILE_DIM, 0xFFF0F0F0);
+        for (int32_t x = 0; x < TILE_DIM; ++x) {
+            pixels[(seed % TILE_DIM) * TILE_DIM + x] = 0xFF800000 | (seed << 8) | static_cast<uint32_t>(x);
+        }
+        return pixels;
+    }
+
+    size_t StoredBytes(CompressedTileCache& cache, uint32_t seed) {
+        std::vector<uint32_t> pixels = MakeTile(seed);
+        size_t before = cache.GetMemoryUsage();
+        cache.Store({0, static_cast<int32_t>(seed), 0}, pixels.data(), TILE_DIM, TILE_DIM);
+        return cache.GetMemoryUsage() - before;
+    }
+};
+
+// ============================================================================
+// Round Trip Tests
+// ============================================================================
+
+TEST_F(CompressedTileCacheTest, Disabled_StoresNothing) {
+    CompressedTileCache cache;
+    std::vector<uint32_t> pixels = MakeTile(1);
+    cache.Store({0, 1, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    EXPECT_FALSE(cache.IsEnabled());
+    EXPECT_FALSE(cache.HasTile({0, 1, 0}));
+}
+
+TEST_F(CompressedTileCacheTest, StoreThenLoad_RoundTripsPixels) {
+    CompressedTileCache cache(1024 * 1024);
+    std::vector<uint32_t> pixels = MakeTile(3);
+    cache.Store({1, 2, 3}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    std::vector<uint32_t> out(TILE_DIM * TILE_DIM);
+    int32_t w = 0, h = 0;
+    ASSERT_TRUE(cache.Load({1, 2, 3}, out.data(), out.size(), &w, &h));
+    EXPECT_EQ(w, TILE_DIM);
+    EXPECT_EQ(h, TILE_DIM);
+    EXPECT_EQ(out, pixels);
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+
+    EXPECT_FALSE(cache.Load({1, 2, 4}, out.data(), out.size(), &w, &h));
+    EXPECT_EQ(cache.GetMissCount(), 1u);
+}
+
+TEST_F(CompressedTileCacheTest, Store_TracksCompressionRatio) {
+    CompressedTileCache cache(1024 * 1024);
+    StoredBytes(cache, 5);
+
+    EXPECT_EQ(cache.GetTileCount(), 1u);
+    EXPECT_EQ(cache.GetRawBytes(), TILE_DIM * TILE_DIM * sizeof(uint32_t));
+    EXPECT_GT(cache.GetCompressionRatio(), 4.0);
+}
+
+// ============================================================================
+// Budget Tests
+// ============================================================================
+
+TEST_F(CompressedTileCacheTest, OverBudget_EvictsLeastRecentlyUsed) {
+    CompressedTileCache probe(1024 * 1024);
+    size_t tileBytes = StoredBytes(probe, 1);
+    CompressedTileCache cache(tileBytes * 2 + tileBytes / 2);
+
+    StoredBytes(cache, 1);
+    StoredBytes(cache, 2);
+    std::vector<uint32_t> out(TILE_DIM * TILE_DIM);
+    int32_t w = 0, h = 0;
+    ASSERT_TRUE(cache.Load({0, 1, 0}, out.data(), out.size(), &w, &h));  // 2 is now oldest
+    StoredBytes(cache, 3);
+
+    EXPECT_TRUE(cache.HasTile({0, 1, 0}));
+    EXPECT_FALSE(cache.HasTile({0, 2, 0}));
+    EXPECT_TRUE(cache.HasTile({0, 3, 0}));
+    EXPECT_LE(cache.GetMemoryUsage(), cache.GetMaxBytes());
+}
+
+TEST_F(CompressedTileCacheTest, SetMaxBytesAndTrim_Evict) {
+    CompressedTileCache cache(1024 * 1024);
+    for (uint32_t i = 0; i < 4; ++i) {
+        StoredBytes(cache, i);
+    }
+    size_t usage = cache.GetMemoryUsage();
+
+    EXPECT_GE(cache.Trim(1), 1u);
+    EXPECT_EQ(cache.GetTileCount(), 3u);
+
+    cache.SetMaxBytes(0);
+    EXPECT_EQ(cache.GetTileCount(), 0u);
+    EXPECT_EQ(cache.GetMemoryUsage(), 0u);
+    EXPECT_EQ(cache.GetRawBytes(), 0u);
+    EXPECT_LT(cache.GetMemoryUsage(), usage);
+}
@@ -0,0 +1,456 @@
+// DicomFrameIndex Unit Tests
+// Tests for DICOM WSI instance parsing, frame offsets from the extended
+// and basic offset tables or an item scan, pyramid discovery across a
+// series' files, and frame reads through TiffTileReader. Each test writes
+// its own small instances to a temp directory.
+
+#include <gtest/gtest.h>
+#include "DicomFrameIndex.h"
+#include "TiffTileReader.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class OffsetTable { Extended, Basic, None };
+
+// One instance: frames are tiles, stored row-major
+struct TestInstance {
+    std::string transferSyntax = "1.2.840.10008.1.2.4.50";
+    std::string imageType = "ORIGINAL\\PRIMARY\\VOLUME\\NONE";
+    std::string seriesUid = "1.2.3.4";
+    std::string organization = "TILED_FULL";
+    std::string photometric = "YBR_FULL_422";
+    uint32_t width = 40;
+    uint32_t height = 24;
+    uint16_t tileWidth = 16;
+    uint16_t tileHeight = 16;
+    int frameCount = -1;  // Number of frames written, -1 for frames.size()
+    float imagedWidthMm = 0.01f;
+    float imagedHeightMm = 0.006f;
+    OffsetTable table = OffsetTable::Basic;
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+// Minimal explicit VR little endian Part 10 writer
+class DicomWriter {
+public:
+    void Save(const TestInstance& instance, const fs::path& path) {
+        data_.assign(128, 0);
+        data_.insert(data_.end(), {'D', 'I', 'C', 'M'});
+        Text(0x0002, 0x0010, "UI", instance.transferSyntax);
+
+        Text(0x0008, 0x0008, "CS", instance.imageType);
+        // A nested sequence the parser must step over
+        Tag(0x0008, 0x1115);
+        Vr("SQ", 0xFFFFFFFF);
+        Tag(0xFFFE, 0xE000);
+        Put(0xFFFFFFFF, 4);
+        Text(0x0020, 0x000E, "UI", "9.9.9");
+        Tag(0xFFFE, 0xE00D);
+        Put(0, 4);
+        Tag(0xFFFE, 0xE0DD);
+        Put(0, 4);
+        Text(0x0020, 0x000E, "UI", instance.seriesUid);
+        if (!instance.organization.empty()) {
+            Text(0x0020, 0x9311, "CS", instance.organization);
+        }
+        Short(0x0028, 0x0002, 3);
+        Text(0x0028, 0x0004, "CS", instance.photometric);
+        const int frameCount = instance.frameCount < 0 ? static_cast<int>(instance.frames.size())
+                                                       : instance.frameCount;
+        Text(0x0028, 0x0008, "IS", std::to_string(frameCount));
+        Short(0x0028, 0x0010, instance.tileHeight);
+        Short(0x0028, 0x0011, instance.tileWidth);
+        Short(0x0028, 0x0100, 8);
+        Float(0x0048, 0x0001, instance.imagedWidthMm);
+        Float(0x0048, 0x0002, instance.imagedHeightMm);
+        Long(0x0048, 0x0006, instance.width);
+        Long(0x0048, 0x0007, instance.height);
+
+        // Item offsets from the first fragment's tag
+        std::vector<uint64_t> offsets, lengths;
+        uint64_t position = 0;
+        for (const auto& frame : instance.frames) {
+            offsets.push_back(position);
+            lengths.push_back(Padded(frame.size()));
+            position += 8 + Padded(frame.size());
+        }
+        if (instance.table == OffsetTable::Extended) {
+            Tag(0x7FE0, 0x0001);
+            Vr("OV", static_cast<uint32_t>(offsets.size() * 8));
+            for (uint64_t offset : offsets) {
+                Put(offset, 8);
+            }
+            Tag(0x7FE0, 0x0002);
+            Vr("OV", static_cast<uint32_t>(lengths.size() * 8));
+            for (uint64_t length : lengths) {
+                Put(length, 8);
+            }
+        }
+
+        Tag(0x7FE0, 0x0010);
+        Vr("OB", 0xFFFFFFFF);
+        Tag(0xFFFE, 0xE000);
+        if (instance.table == OffsetTable::Basic) {
+            Put(offsets.size() * 4, 4);
+            for (uint64_t offset : offsets) {
+                Put(offset, 4);
+            }
+        } else {
+            Put(0, 4);
+        }
+        for (const auto& frame : instance.frames) {
+            Tag(0xFFFE, 0xE000);
+            Put(Padded(frame.size()), 4);
+            data_.insert(data_.end(), frame.begin(), frame.end());
+            data_.resize(data_.size() + Padded(frame.size()) - frame.size(), 0);
+        }
+        Tag(0xFFFE, 0xE0DD);
+        Put(0, 4);
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+    }
+
+private:
+    static uint64_t Padded(size_t size) { return (size + 1) & ~size_t(1); }
+
+    void Put(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            data_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+    void Tag(uint16_t group, uint16_t element) {
+        Put(group, 2);
+        Put(element, 2);
+    }
+    void Vr(const char* vr, uint32_t length) {
+        data_.push_back(static_cast<uint8_t>(vr[0]));
+        data_.push_back(static_cast<uint8_t>(vr[1]));
+        const bool longLength = std::strcmp(vr, "OB") == 0 || std::strcmp(vr, "OV") == 0 ||
+                                std::strcmp(vr, "SQ") == 0;
+        if (longLength) {
+            Put(0, 2);
+            Put(length, 4);
+        } else {
+            Put(length, 2);
+        }
+    }
+    void Text(uint16_t group, uint16_t element, const char* vr, std::string value) {
+        if (value.size() % 2 != 0) {
+            value.push_back(std::strcmp(vr, "UI") == 0 ? '\0' : ' ');
+        }
+        Tag(group, element);
+        Vr(vr, static_cast<uint32_t>(value.size()));
+        data_.insert(data_.end(), value.begin(), value.end());
+    }
+    void Short(uint16_t group, uint16_t element, uint16_t value) {
+        Tag(group, element);
+        Vr("US", 2);
+        Put(value, 2);
+    }
+    void Long(uint16_t group, uint16_t element, uint32_t value) {
+        Tag(group, element);
+        Vr("UL", 4);
+        Put(value, 4);
+    }
+    void Float(uint16_t group, uint16_t element, float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Tag(group, element);
+        Vr("FL", 4);
+        Put(bits, 4);
+    }
+
+    std::vector<uint8_t> data_;
+};
+
+// Six frames of distinct bytes and odd and even sizes
+std::vector<std::vector<uint8_t>> ByteFrames() {
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 6; ++i) {
+        frames.push_back(std::vector<uint8_t>(10 + i * 3, static_cast<uint8_t>(0x10 + i)));
+    }
+    return frames;
+}
+
+std::vector<uint8_t> ReadBytes(const std::string& path, uint64_t offset, uint64_t size) {
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::vector<uint8_t> bytes(size);
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size));
+    return bytes;
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+// A complete baseline JPEG stream of one colour, as a DICOM frame holds
+std::vector<uint8_t> EncodeSolidFrame(uint32_t color, int width, int height) {
+    jpeg_compress_struct info;
+    jpeg_error_mgr error;
+    info.err = jpeg_std_error(&error);
+    jpeg_create_compress(&info);
+    info.image_width = static_cast<JDIMENSION>(width);
+    info.image_height = static_cast<JDIMENSION>(height);
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, 95, TRUE);
+
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&info, &buffer, &size);
+    jpeg_start_compress(&info, TRUE);
+    std::vector<uint8_t> line(static_cast<size_t>(width) * 3);
+    for (int x = 0; x < width; ++x) {
+        line[x * 3] = static_cast<uint8_t>(color >> 16);
+        line[x * 3 + 1] = static_cast<uint8_t>(color >> 8);
+        line[x * 3 + 2] = static_cast<uint8_t>(color);
+    }
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = line.data();
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_compress(&info);
+    std::vector<uint8_t> frame(buffer, buffer + size);
+    std::free(buffer);
+    jpeg_destroy_compress(&info);
+    return frame;
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class DicomFrameIndexTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_dicom_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    std::string Write(const TestInstance& instance, const std::string& name) {
+        fs::path path = root / name;
+        DicomWriter().Save(instance, path);
+        return path.string();
+    }
+
+    // 40x24 in 16x16 frames (3 x 2, partial on the right and bottom)
+    static TestInstance Level0(OffsetTable table = OffsetTable::Basic) {
+        TestInstance instance;
+        instance.table = table;
+        instance.frames = ByteFrames();
+        return instance;
+    }
+
+    void ExpectFramesAt(const DicomFrameIndex& index, const std::vector<std::vector<uint8_t>>& frames) {
+        ASSERT_EQ(index.frameOffsets.size(), frames.size());
+        ASSERT_EQ(index.frameSizes.size(), frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+            // Odd frames carry their pad byte
+            ASSERT_EQ(index.frameSizes[i], (frames[i].size() + 1) & ~size_t(1)) << "frame " << i;
+            std::vector<uint8_t> bytes = ReadBytes(index.path, index.frameOffsets[i], frames[i].size());
+            EXPECT_EQ(bytes, frames[i]) << "frame " << i;
+        }
+    }
+};
+
+// ============================================================================
+// Instance Parsing Tests
+// ============================================================================
+
+TEST_F(DicomFrameIndexTest, Read_NotDicom_ReturnsNullopt) {
+    std::string path = (root / "plain.bin").string();
+    std::ofstream(path, std::ios::binary) << std::string(200, 'x');
+    EXPECT_FALSE(DicomFrameIndex::IsDicomPath(path));
+    EXPECT_FALSE(DicomFrameIndex::Read(path).has_value());
+}
+
+TEST_F(DicomFrameIndexTest, Read_ParsesGeometryAndSeries) {
+    std::string path = Write(Level0(), "level0.dcm");
+    EXPECT_TRUE(DicomFrameIndex::IsDicomPath(path));
+    auto index = DicomFrameIndex::Read(path);
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->imageType, "VOLUME");
+    EXPECT_EQ(index->seriesUid, "1.2.3.4");  // Not the nested sequence's
+    EXPECT_EQ(index->transferSyntax, "1.2.840.10008.1.2.4.50");
+    EXPECT_EQ(index->photometric, "YBR_FULL_422");
+    EXPECT_EQ(index->dimensionOrganization, "TILED_FULL");
+    EXPECT_EQ(index->width, 40);
+    EXPECT_EQ(index->height, 24);
+    EXPECT_EQ(index->tileWidth, 16);
+    EXPECT_EQ(index->tileHeight, 16);
+    EXPECT_EQ(index->TilesAcross(), 3);
+    EXPECT_EQ(index->TilesDown(), 2);
+    EXPECT_EQ(index->frameCount, 6);
+    EXPECT_NEAR(index->imagedWidthMm, 0.01, 1e-6);
+    EXPECT_TRUE(index->IsTiledJpegVolume());
+}
+
+TEST_F(DicomFrameIndexTest, Read_ExtendedOffsetTable_IndexesFrames) {
+    auto index = DicomFrameIndex::Read(Write(Level0(OffsetTable::Extended), "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->offsetSource, DicomFrameIndex::OffsetSource::ExtendedTable);
+    ExpectFramesAt(*index, ByteFrames());
+}
+
+TEST_F(DicomFrameIndexTest, Read_BasicOffsetTable_IndexesFrames) {
+    auto index = DicomFrameIndex::Read(Write(Level0(OffsetTable::Basic), "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->offsetSource, DicomFrameIndex::OffsetSource::BasicTable);
+    ExpectFramesAt(*index, ByteFrames());
+}
+
+TEST_F(DicomFrameIndexTest, Read_NoOffsetTable_ScansItems) {
+    auto index = DicomFrameIndex::Read(Write(Level0(OffsetTable::None), "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->offsetSource, DicomFrameIndex::OffsetSource::ItemScan);
+    ExpectFramesAt(*index, ByteFrames());
+}
+
+TEST_F(DicomFrameIndexTest, Read_MoreFragmentsThanFrames_NotIndexed) {
+    // Frames split over fragments: one frame per fragment cannot hold
+    TestInstance instance = Level0(OffsetTable::None);
+    instance.frameCount = 3;
+    auto index = DicomFrameIndex::Read(Write(instance, "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_TRUE(index->frameOffsets.empty());
+    EXPECT_FALSE(index->IsTiledJpegVolume());
+}
+
+TEST_F(DicomFrameIndexTest, Read_ImplicitVr_ReturnsNullopt) {
+    TestInstance instance = Level0();
+    instance.transferSyntax = "1.2.840.10008.1.2";
+    EXPECT_FALSE(DicomFrameIndex::Read(Write(instance, "level0.dcm")).has_value());
+}
+
+TEST_F(DicomFrameIndexTest, IsTiledJpegVolume_SparseOrJpeg2000_IsFalse) {
+    TestInstance sparse = Level0();
+    sparse.organization = "TILED_SPARSE";
+    auto index = DicomFrameIndex::Read(Write(sparse, "sparse.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_FALSE(index->IsTiledJpegVolume());
+
+    TestInstance jpeg2000 = Level0();
+    jpeg2000.transferSyntax = "1.2.840.10008.1.2.4.90";
+    index = DicomFrameIndex::Read(Write(jpeg2000, "jpeg2000.dcm"));
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->frameOffsets.size(), 6u);
+    EXPECT_FALSE(index->IsTiledJpegVolume());
+}
+
+// ============================================================================
+// Pyramid Discovery Tests
+// ============================================================================
+
+TEST_F(DicomFrameIndexTest, FindPyramid_Directory_LargestFirstWithoutLabels) {
+    TestInstance level1;
+    level1.width = 20;
+    level1.height = 12;
+    level1.tileWidth = 32;
+    level1.frames = {{1, 2, 3, 4}};
+    Write(level1, "a_level1.dcm");
+    Write(Level0(), "b_level0.dcm");
+    TestInstance label = Level0();
+    label.imageType = "ORIGINAL\\PRIMARY\\LABEL\\NONE";
+    Write(label, "c_label.dcm");
+    std::ofstream(root / "notes.txt") << "not dicom";
+
+    auto levels = DicomFrameIndex::FindPyramid(root.string());
+    ASSERT_EQ(levels.size(), 2u);
+    EXPECT_EQ(levels[0].width, 40);
+    EXPECT_EQ(levels[0].path, (root / "b_level0.dcm").string());
+    EXPECT_EQ(levels[1].width, 20);
+}
+
+TEST_F(DicomFrameIndexTest, FindPyramid_File_KeepsItsSeries) {
+    TestInstance other = Level0();
+    other.seriesUid = "5.6.7";
+    Write(other, "a_other.dcm");
+    TestInstance mine = Level0();
+    mine.width = 48;
+    std::string path = Write(mine, "b_mine.dcm");
+    // A second focal plane of the same size is dropped
+    Write(mine, "c_mine_plane2.dcm");
+
+    auto levels = DicomFrameIndex::FindPyramid(path);
+    ASSERT_EQ(levels.size(), 1u);
+    EXPECT_EQ(levels[0].seriesUid, "1.2.3.4");
+    EXPECT_EQ(levels[0].path, path);
+}
+
+// ============================================================================
+// Frame Reads Through TiffTileReader
+// ============================================================================
+
+TEST_F(DicomFrameIndexTest, TiffTileReader_ServesFramesAsTiles) {
+    TestInstance instance = Level0(OffsetTable::Extended);
+    auto index = DicomFrameIndex::Read(Write(instance, "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+
+    TiffTileReader reader(*index);
+    ASSERT_TRUE(reader.IsOpen());
+    ASSERT_EQ(reader.BindLevels({{40, 24}}), 1u);
+    EXPECT_EQ(reader.GetTileSize(0).width, 16);
+    std::vector<uint8_t> raw;
+    ASSERT_TRUE(reader.ReadRawTile(0, 2, 1, raw));
+    EXPECT_EQ(std::vector<uint8_t>(raw.begin(), raw.begin() + 25), ByteFrames()[5]);
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+TEST_F(DicomFrameIndexTest, TiffTileReader_DecodesJpegFrames) {
+    const std::vector<uint32_t> colors = {
+        0xFFC03020, 0xFF20C030, 0xFF3020C0,
+        0xFF808080, 0xFFE0D0C0, 0xFF402060,
+    };
+    TestInstance instance = Level0(OffsetTable::None);
+    instance.frames.clear();
+    for (uint32_t color : colors) {
+        instance.frames.push_back(EncodeSolidFrame(color, 16, 16));
+    }
+    auto index = DicomFrameIndex::Read(Write(instance, "level0.dcm"));
+    ASSERT_TRUE(index.has_value());
+    ASSERT_TRUE(index->IsTiledJpegVolume());
+
+    TiffTileReader reader(*index);
+    ASSERT_EQ(reader.BindLevels({{40, 24}}), 1u);
+    std::vector<uint32_t> pixels(40 * 24, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 40, 24, pixels.data()));
+    for (size_t tile = 0; tile < colors.size(); ++tile) {
+        const uint32_t pixel = pixels[(tile / 3) * 16 * 40 + (tile % 3) * 16];
+        EXPECT_EQ(pixel >> 24, 0xFFu);
+        for (int shift = 0; shift <= 16; shift += 8) {
+            EXPECT_NEAR(static_cast<int>((pixel >> shift) & 0xFF),
+                        static_cast<int>((colors[tile] >> shift) & 0xFF), 4) << "tile " << tile;
+        }
+    }
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
@@ -0,0 +1,178 @@
+// DiskTileCache Unit Tests
+// Tests for round-tripping tiles, persistence across instances, slide
+// identity (by content, not path) and the LRU size cap. Each test works in
+// its own temp directory.
+
+#include <gtest/gtest.h>
+#include "DiskTileCache.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class DiskTileCacheTest : public ::testing::Test {
+protected:
+    static constexpr int32_t TILE_DIM = 32;
+    static constexpr size_t TILE_PIXELS = TILE_DIM * TILE_DIM;
+    static constexpr size_t TILE_FILE_BYTES = 16 + TILE_PIXELS * sizeof(uint32_t);
+
+    fs::path root;
+    fs::path slidePath;
+    std::vector<uint32_t> pixels;
+    std::vector<uint32_t> readBack;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_disk_cache_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+
+        slidePath = root / "slide.svs";
+        WriteSlide("original contents");
+
+        pixels.assign(TILE_PIXELS, 0xFF336699);
+        readBack.assign(TILE_PIXELS, 0);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    void WriteSlide(const std::string& contents) {
+        std::ofstream file(slidePath, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    std::unique_ptr<DiskTileCache> MakeCache(size_t maxBytes = 64 * 1024 * 1024) {
+        return std::make_unique<DiskTileCache>((root / "cache").string(), slidePath.string(), maxBytes);
+    }
+
+    bool LoadTile(DiskTileCache& cache, const TileKey& key) {
+        int32_t w = 0, h = 0;
+        return cache.Load(key, readBack.data(), readBack.size(), &w, &h) &&
+               w == TILE_DIM && h == TILE_DIM;
+    }
+};
+
+// ============================================================================
+// Basic Functionality Tests
+// ============================================================================
+
+TEST_F(DiskTileCacheTest, Load_Empty_Misses) {
+    auto cache = MakeCache();
+
+    ASSERT_TRUE(cache->IsEnabled());
+    EXPECT_FALSE(LoadTile(*cache, {0, 0, 0}));
+    EXPECT_EQ(cache->GetMissCount(), 1);
+}
+
+TEST_F(DiskTileCacheTest, StoreThenLoad_RoundTripsPixels) {
+    auto cache = MakeCache();
+
+    cache->Store({1, 2, 3}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    ASSERT_TRUE(LoadTile(*cache, {1, 2, 3}));
+    EXPECT_EQ(readBack, pixels);
+    EXPECT_EQ(cache->GetTileCount(), 1);
+    EXPECT_EQ(cache->GetDiskUsage(), TILE_FILE_BYTES);
+    EXPECT_EQ(cache->GetHitCount(), 1);
+}
+
+TEST_F(DiskTileCacheTest, Load_BufferTooSmall_Fails) {
+    auto cache = MakeCache();
+    cache->Store({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    int32_t w = 0, h = 0;
+    EXPECT_FALSE(cache->Load({0, 0, 0}, readBack.data(), TILE_PIXELS / 2, &w, &h));
+    EXPECT_TRUE(cache->HasTile({0, 0, 0}));
+}
+
+// ============================================================================
+// Persistence Tests
+// ============================================================================
+
+TEST_F(DiskTileCacheTest, NewInstance_SameSlide_FindsStoredTiles) {
+    MakeCache()->Store({0, 1, 1}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    auto reopened = MakeCache();
+
+    EXPECT_TRUE(reopened->HasTile({0, 1, 1}));
+    ASSERT_TRUE(LoadTile(*reopened, {0, 1, 1}));
+    EXPECT_EQ(readBack, pixels);
+}
+
+TEST_F(DiskTileCacheTest, SlideIdentity_ChangesWhenFileChanges) {
+    std::string before = DiskTileCache::SlideIdentity(slidePath.string());
+
+    WriteSlide("rewritten with different contents");
+
+    EXPECT_NE(DiskTileCache::SlideIdentity(slidePath.string()), before);
+}
+
+TEST_F(DiskTileCacheTest, RenamedSlide_FindsStoredTiles) {
+    MakeCache()->Store({0, 2, 2}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    fs::path renamed = root / "renamed.svs";
+    fs::rename(slidePath, renamed);
+    slidePath = renamed;
+
+    EXPECT_TRUE(MakeCache()->HasTile({0, 2, 2}));
+}
+
+TEST_F(DiskTileCacheTest, Load_CorruptFile_MissesAndForgetsTile) {
+    auto cache = MakeCache();
+    cache->Store({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    // Truncate every tile file on disk
+    for (auto& entry : fs::recursive_directory_iterator(root / "cache")) {
+        if (entry.path().extension() == ".tile") {
+            std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "bad";
+        }
+    }
+
+    EXPECT_FALSE(LoadTile(*cache, {0, 0, 0}));
+    EXPECT_FALSE(cache->HasTile({0, 0, 0}));
+    EXPECT_EQ(cache->GetDiskUsage(), 0);
+}
+
+// ============================================================================
+// Eviction Tests
+// ============================================================================
+
+TEST_F(DiskTileCacheTest, Store_OverCap_EvictsLeastRecentlyUsed) {
+    auto cache = MakeCache(3 * TILE_FILE_BYTES);
+
+    cache->Store({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+    cache->Store({0, 1, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+    cache->Store({0, 2, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    // Touch the oldest so {0, 1, 0} becomes least recently used
+    ASSERT_TRUE(LoadTile(*cache, {0, 0, 0}));
+    cache->Store({0, 3, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+
+    EXPECT_TRUE(cache->HasTile({0, 0, 0}));
+    EXPECT_FALSE(cache->HasTile({0, 1, 0}));
+    EXPECT_TRUE(cache->HasTile({0, 2, 0}));
+    EXPECT_TRUE(cache->HasTile({0, 3, 0}));
+    EXPECT_LE(cache->GetDiskUsage(), cache->GetMaxBytes());
+}
+
+TEST_F(DiskTileCacheTest, NewInstance_SmallerCap_TrimsOnOpen) {
+    {
+        auto cache = MakeCache();
+        for (int32_t x = 0; x < 4; ++x) {
+            cache->Store({0, x, 0}, pixels.data(), TILE_DIM, TILE_DIM);
+        }
+    }
+
+    auto reopened = MakeCache(2 * TILE_FILE_BYTES);
+
+    EXPECT_EQ(reopened->GetTileCount(), 2);
+    EXPECT_LE(reopened->GetDiskUsage(), 2 * TILE_FILE_BYTES);
+}
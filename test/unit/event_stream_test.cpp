@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "../../src/api/http/EventStream.h"
+#include <thread>
+
+using namespace pathview::http;
+using namespace std::chrono_literals;
+
+TEST(EventStreamTest, KeepsLatestOfEachType) {
+    EventStream stream;
+    EXPECT_TRUE(stream.WaitForEvents(0, 10ms).empty());
+
+    stream.Publish("viewport", R"({"zoom":1})");
+    stream.Publish("tiles_settled", "{}");
+    stream.Publish("viewport", R"({"zoom":2})");
+    auto events = stream.WaitForEvents(0, 10ms);
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].type, "tiles_settled");  // In sequence order
+    EXPECT_EQ(events[0].sequence, 2u);
+    EXPECT_EQ(events[1].type, "viewport");
+    EXPECT_EQ(events[1].data, R"({"zoom":2})");
+    EXPECT_EQ(stream.GetSequence(), 3u);
+
+    // Only what is newer than the last one seen
+    EXPECT_TRUE(stream.WaitForEvents(3, 10ms).empty());
+    stream.Publish("annotations", R"({"revision":1})");
+    events = stream.WaitForEvents(3, 10ms);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].type, "annotations");
+}
+
+TEST(EventStreamTest, PublishWakesWaiter) {
+    EventStream stream;
+    std::thread publisher([&]() {
+        std::this_thread::sleep_for(20ms);
+        stream.Publish("viewport", "{}");
+    });
+    auto events = stream.WaitForEvents(0, 5s);
+    publisher.join();
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].sequence, 1u);
+}
+
+TEST(EventStreamTest, CloseWakesWaiters) {
+    EventStream stream;
+    std::thread waiter([&]() { EXPECT_TRUE(stream.WaitForEvents(0, 10s).empty()); });
+    std::this_thread::sleep_for(20ms);
+    const auto start = std::chrono::steady_clock::now();
+    stream.Close();
+    waiter.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    EXPECT_TRUE(stream.IsClosed());
+}
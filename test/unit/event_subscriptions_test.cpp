@@ -0,0 +1,82 @@
+// EventSubscriptions Unit Tests
+// Tests for pushed viewer events: only subscribers get them, later events
+// replace ones not yet sent, the per-subscriber interval, unsubscribing and
+// event names
+
+#include <gtest/gtest.h>
+#include "EventSubscriptions.h"
+
+using namespace pathview::ipc;
+using namespace std::chrono_literals;
+
+TEST(EventSubscriptionsTest, OnlySubscribersReceive) {
+    EventSubscriptions subscriptions;
+    subscriptions.Subscribe(3, {EventType::Viewport}, 0ms);
+    subscriptions.Subscribe(4, {EventType::Annotations}, 0ms);
+    EXPECT_TRUE(subscriptions.HasSubscribers(EventType::Viewport));
+    EXPECT_FALSE(subscriptions.HasSubscribers(EventType::TilesSettled));
+
+    subscriptions.Post(EventType::Viewport, {{"zoom", 1.0}});
+    auto due = subscriptions.TakeDue(EventSubscriptions::Clock::now());
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0].clientFd, 3);
+    EXPECT_EQ(due[0].type, EventType::Viewport);
+    EXPECT_EQ(due[0].payload["zoom"], 1.0);
+
+    // Taken once
+    EXPECT_TRUE(subscriptions.TakeDue(EventSubscriptions::Clock::now()).empty());
+    EXPECT_FALSE(subscriptions.NextDue().has_value());
+}
+
+// A pan posts every frame; the subscriber gets the latest once per interval
+TEST(EventSubscriptionsTest, CoalescesWithinInterval) {
+    EventSubscriptions subscriptions;
+    subscriptions.Subscribe(3, {EventType::Viewport}, 100ms);
+    const auto start = EventSubscriptions::Clock::now();
+
+    subscriptions.Post(EventType::Viewport, {{"x", 1}});
+    ASSERT_EQ(subscriptions.TakeDue(start).size(), 1u);
+
+    subscriptions.Post(EventType::Viewport, {{"x", 2}});
+    subscriptions.Post(EventType::Viewport, {{"x", 3}});
+    EXPECT_TRUE(subscriptions.TakeDue(start + 50ms).empty());
+    ASSERT_TRUE(subscriptions.NextDue().has_value());
+    EXPECT_EQ(*subscriptions.NextDue(), start + 100ms);
+
+    auto due = subscriptions.TakeDue(start + 100ms);
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0].payload["x"], 3);
+}
+
+TEST(EventSubscriptionsTest, UnsubscribeAndRemoveClient) {
+    EventSubscriptions subscriptions;
+    subscriptions.Subscribe(3, {EventType::Viewport, EventType::TilesSettled}, 0ms);
+    subscriptions.Post(EventType::TilesSettled, json::object());
+
+    // Dropping a type drops its queued event too
+    subscriptions.Unsubscribe(3, {EventType::TilesSettled});
+    EXPECT_FALSE(subscriptions.IsSubscribed(3, EventType::TilesSettled));
+    EXPECT_TRUE(subscriptions.IsSubscribed(3, EventType::Viewport));
+    EXPECT_TRUE(subscriptions.TakeDue(EventSubscriptions::Clock::now()).empty());
+
+    subscriptions.Post(EventType::Viewport, json::object());
+    subscriptions.RemoveClient(3);
+    EXPECT_TRUE(subscriptions.TakeDue(EventSubscriptions::Clock::now()).empty());
+    EXPECT_FALSE(subscriptions.HasSubscribers(EventType::Viewport));
+
+    // Empty list: everything
+    subscriptions.Subscribe(5, {EventType::Annotations}, 0ms);
+    subscriptions.Unsubscribe(5, {});
+    EXPECT_FALSE(subscriptions.IsSubscribed(5, EventType::Annotations));
+}
+
+TEST(EventSubscriptionsTest, EventNamesRoundTrip) {
+    for (EventType type : {EventType::Viewport, EventType::TilesSettled, EventType::Annotations,
+                           EventType::Metrics}) {
+        auto parsed = ParseEventType(EventTypeName(type));
+        ASSERT_TRUE(parsed.has_value());
+        EXPECT_EQ(*parsed, type);
+    }
+    EXPECT_EQ(std::string(EventTypeName(EventType::TilesSettled)), "tiles_settled");
+    EXPECT_FALSE(ParseEventType("tiles").has_value());
+}
@@ -0,0 +1,264 @@
+// FlatTileMap Unit Tests
+// Tests for TileKeyHash over large and negative coordinates, and for the
+// open-addressing map: lookups, insert-only-if-absent, erasing (also while
+// iterating), growth and tombstone reuse, and copies and moves
+
+#include <gtest/gtest.h>
+#include "FlatTileMap.h"
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+
+// ============================================================================
+// Hash Tests
+// ============================================================================
+
+TEST(TileKeyHashTest, LargeAndNegativeCoordinates_Distinct) {
+    std::vector<TileKey> keys;
+    for (int32_t level = 0; level < 8; ++level) {
+        for (int32_t x = 0; x < 128; ++x) {
+            keys.push_back({level, x << 24, 0});  // Overlapped level in the shifted hash
+        }
+    }
+    for (int32_t x = -2048; x < 2048; ++x) {
+        keys.push_back({0, x, -1});  // Sign-extended over every field
+    }
+
+    std::unordered_set<size_t> hashes;
+    for (const TileKey& key : keys) {
+        hashes.insert(TileKeyHash{}(key));
+    }
+    EXPECT_EQ(hashes.size(), keys.size());
+}
+
+TEST(TileKeyHashTest, EveryFieldChangesHash) {
+    TileKey key{3, 100, 200, 1};
+    size_t hash = TileKeyHash{}(key);
+    EXPECT_NE(TileKeyHash{}({4, 100, 200, 1}), hash);
+    EXPECT_NE(TileKeyHash{}({3, 101, 200, 1}), hash);
+    EXPECT_NE(TileKeyHash{}({3, 100, 201, 1}), hash);
+    EXPECT_NE(TileKeyHash{}({3, 100, 200, 2}), hash);
+    EXPECT_NE(TileKeyHash{}({3, 200, 100, 1}), hash);  // Not symmetric in x and y
+}
+
+// ============================================================================
+// Lookup Tests
+// ============================================================================
+
+TEST(FlatTileMapTest, Empty_FindsNothing) {
+    FlatTileMap<int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find({0, 0, 0}), map.end());
+    EXPECT_EQ(map.count({0, 0, 0}), 0u);
+    EXPECT_EQ(map.erase({0, 0, 0}), 0u);
+    EXPECT_EQ(map.begin(), map.end());
+    EXPECT_THROW(map.at({0, 0, 0}), std::out_of_range);
+}
+
+TEST(FlatTileMapTest, TryEmplace_KeepsFirstValue) {
+    FlatTileMap<std::string> map;
+    auto first = map.try_emplace({1, 2, 3}, "first");
+    EXPECT_TRUE(first.second);
+    auto second = map.try_emplace({1, 2, 3}, "second");
+    EXPECT_FALSE(second.second);
+    EXPECT_EQ(second.first->second, "first");
+    EXPECT_EQ(map.size(), 1u);
+    EXPECT_EQ(map.at({1, 2, 3}), "first");
+}
+
+TEST(FlatTileMapTest, Subscript_DefaultConstructs) {
+    FlatTileMap<int> map;
+    map[{0, 1, 1}] += 5;
+    map[{0, 1, 1}] += 2;
+    EXPECT_EQ(map.at({0, 1, 1}), 7);
+    EXPECT_EQ(map.count({0, 1, 2}), 0u);
+}
+
+TEST(FlatTileMapTest, SlideIsPartOfKey) {
+    FlatTileMap<int> map;
+    map.emplace(TileKey{0, 5, 5, 1}, 1);
+    map.emplace(TileKey{0, 5, 5, 2}, 2);
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.at({0, 5, 5, 1}), 1);
+    EXPECT_EQ(map.at({0, 5, 5, 2}), 2);
+    EXPECT_EQ(map.count({0, 5, 5, 0}), 0u);
+}
+
+// ============================================================================
+// Erase Tests
+// ============================================================================
+
+TEST(FlatTileMapTest, Erase_ByKeyAndIterator) {
+    FlatTileMap<int> map;
+    for (int32_t x = 0; x < 10; ++x) {
+        map.emplace(TileKey{0, x, 0}, x);
+    }
+    EXPECT_EQ(map.erase({0, 3, 0}), 1u);
+    EXPECT_EQ(map.erase({0, 3, 0}), 0u);
+    map.erase(map.find({0, 7, 0}));
+
+    EXPECT_EQ(map.size(), 8u);
+    EXPECT_EQ(map.count({0, 3, 0}), 0u);
+    EXPECT_EQ(map.count({0, 7, 0}), 0u);
+    for (int32_t x : {0, 1, 2, 4, 5, 6, 8, 9}) {
+        EXPECT_EQ(map.at({0, x, 0}), x);
+    }
+}
+
+TEST(FlatTileMapTest, EraseWhileIterating_VisitsEveryEntryOnce) {
+    FlatTileMap<int> map;
+    for (int32_t i = 0; i < 1000; ++i) {
+        map.emplace(TileKey{i % 4, i, i / 7, static_cast<uint32_t>(i % 3)}, i);
+    }
+
+    std::set<int> visited;
+    for (auto it = map.begin(); it != map.end();) {
+        EXPECT_TRUE(visited.insert(it->second).second);
+        if (it->first.slide == 1) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(visited.size(), 1000u);
+    EXPECT_EQ(map.size(), 667u);
+    for (const auto& entry : map) {
+        EXPECT_NE(entry.first.slide, 1u);
+    }
+}
+
+TEST(FlatTileMapTest, Erase_KeepsIteratorToLaterEntryValid) {
+    FlatTileMap<int> map;
+    for (int32_t i = 0; i < 100; ++i) {
+        map.emplace(TileKey{0, i, 0}, i);
+    }
+    auto it = map.begin();
+    auto next = std::next(it);
+    int nextValue = next->second;
+    map.erase(it);
+    EXPECT_EQ(next->second, nextValue);
+}
+
+TEST(FlatTileMapTest, Clear_DestroysEntriesAndKeepsWorking) {
+    auto tracker = std::make_shared<int>(0);
+    FlatTileMap<std::shared_ptr<int>> map;
+    for (int32_t i = 0; i < 50; ++i) {
+        map.emplace(TileKey{1, i, i}, tracker);
+    }
+    EXPECT_EQ(tracker.use_count(), 51);
+    map.clear();
+    EXPECT_EQ(tracker.use_count(), 1);
+    EXPECT_TRUE(map.empty());
+
+    map.emplace(TileKey{1, 0, 0}, tracker);
+    EXPECT_EQ(map.size(), 1u);
+}
+
+// ============================================================================
+// Growth Tests
+// ============================================================================
+
+TEST(FlatTileMapTest, Growth_KeepsEveryEntry) {
+    FlatTileMap<int> map;
+    for (int32_t i = 0; i < 10000; ++i) {
+        map.emplace(TileKey{i % 10, i * 37, -i}, i);
+    }
+    EXPECT_EQ(map.size(), 10000u);
+    EXPECT_LE(map.size() * FlatTileMap<int>::MAX_LOAD_DENOMINATOR,
+              map.capacity() * FlatTileMap<int>::MAX_LOAD_NUMERATOR);
+    for (int32_t i = 0; i < 10000; ++i) {
+        ASSERT_EQ(map.at({i % 10, i * 37, -i}), i);
+    }
+}
+
+TEST(FlatTileMapTest, Reserve_AvoidsGrowth) {
+    FlatTileMap<int> map;
+    map.reserve(1000);
+    size_t capacity = map.capacity();
+    for (int32_t i = 0; i < 1000; ++i) {
+        map.emplace(TileKey{0, i, 0}, i);
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(FlatTileMapTest, Churn_TombstonesDoNotGrowTable) {
+    // A cache at a steady size: every insert follows an erase
+    FlatTileMap<int> map;
+    for (int32_t i = 0; i < 500; ++i) {
+        map.emplace(TileKey{0, i, 0}, i);
+    }
+    size_t capacity = map.capacity();
+    for (int32_t i = 500; i < 100000; ++i) {
+        map.erase({0, i - 500, 0});
+        map.emplace(TileKey{0, i, 0}, i);
+    }
+    EXPECT_EQ(map.size(), 500u);
+    EXPECT_EQ(map.capacity(), capacity);
+    for (int32_t i = 99500; i < 100000; ++i) {
+        ASSERT_EQ(map.at({0, i, 0}), i);
+    }
+}
+
+TEST(FlatTileMapTest, MoveOnlyValues_SurviveGrowth) {
+    FlatTileMap<std::unique_ptr<int>> map;
+    for (int32_t i = 0; i < 200; ++i) {
+        map.try_emplace({2, i, i}, std::make_unique<int>(i));
+    }
+    for (int32_t i = 0; i < 200; ++i) {
+        ASSERT_EQ(*map.at({2, i, i}), i);
+    }
+}
+
+// Against std::map through a random mix of inserts, erases and lookups
+TEST(FlatTileMapTest, RandomOperations_MatchStdMap) {
+    std::mt19937 random(1);
+    FlatTileMap<int> map;
+    std::map<TileKey, int> reference;
+    for (int i = 0; i < 50000; ++i) {
+        TileKey key{static_cast<int32_t>(random() % 4), static_cast<int32_t>(random() % 64) - 32,
+                    static_cast<int32_t>(random() % 64), static_cast<uint32_t>(random() % 2)};
+        switch (random() % 3) {
+            case 0:
+                EXPECT_EQ(map.try_emplace(key, i).second, reference.emplace(key, i).second);
+                break;
+            case 1:
+                EXPECT_EQ(map.erase(key), reference.erase(key));
+                break;
+            default:
+                EXPECT_EQ(map.count(key), reference.count(key));
+                break;
+        }
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    for (const auto& entry : reference) {
+        ASSERT_EQ(map.at(entry.first), entry.second);
+    }
+}
+
+// ============================================================================
+// Copy and Move Tests
+// ============================================================================
+
+TEST(FlatTileMapTest, CopyAndMove) {
+    FlatTileMap<int> map;
+    for (int32_t i = 0; i < 100; ++i) {
+        map.emplace(TileKey{0, i, 0}, i);
+    }
+
+    FlatTileMap<int> copy(map);
+    copy.erase({0, 0, 0});
+    EXPECT_EQ(map.size(), 100u);
+    EXPECT_EQ(copy.size(), 99u);
+
+    FlatTileMap<int> moved(std::move(copy));
+    EXPECT_EQ(moved.size(), 99u);
+    EXPECT_EQ(moved.at({0, 42, 0}), 42);
+
+    map = moved;
+    EXPECT_EQ(map.size(), 99u);
+    EXPECT_EQ(map.count({0, 0, 0}), 0u);
+}
@@ -0,0 +1,512 @@
+// FlatGeobufPolygonLoader Unit Tests
+// Tests for FlatGeobuf files: header and column decoding, exterior rings of
+// Polygon and MultiPolygon features, class and confidence columns, region
+// queries through the packed R-tree against a brute-force scan, streaming
+// by index node, files without an index, and malformed files, including
+// forged feature counts. The files are written by a small FlatBuffers
+// builder below.
+
+#include <gtest/gtest.h>
+#include "FlatGeobufPolygonLoader.h"
+#include "FlatGeobufReader.h"
+#include "PolygonStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+template <typename T>
+void Put(Bytes& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+void PutAt(Bytes& out, size_t position, T value) {
+    std::memcpy(out.data() + position, &value, sizeof(T));
+}
+
+// A table field: inline scalar bytes, or a child (vector, string, table)
+// written after the table, returning its position
+struct Field {
+    Bytes scalar;
+    std::function<size_t(Bytes&)> child;
+};
+using Fields = std::map<int, Field>;
+
+template <typename T>
+Field Scalar(T value) {
+    Field field;
+    Put(field.scalar, value);
+    return field;
+}
+
+size_t WriteTable(Bytes& out, const Fields& fields);
+
+Field Vector(Bytes data, uint32_t count) {
+    return {{}, [data, count](Bytes& out) {
+        size_t position = out.size();
+        Put(out, count);
+        out.insert(out.end(), data.begin(), data.end());
+        return position;
+    }};
+}
+
+Field String(const std::string& text) {
+    return Vector(Bytes(text.begin(), text.end()), static_cast<uint32_t>(text.size()));
+}
+
+template <typename T>
+Field Numbers(const std::vector<T>& values) {
+    Bytes data;
+    for (T value : values) {
+        Put(data, value);
+    }
+    return Vector(data, static_cast<uint32_t>(values.size()));
+}
+
+Field Tables(std::vector<Fields> tables) {
+    return {{}, [tables](Bytes& out) {
+        size_t position = out.size();
+        Put(out, static_cast<uint32_t>(tables.size()));
+        for (size_t i = 0; i < tables.size(); ++i) {
+            Put<uint32_t>(out, 0);
+        }
+        for (size_t i = 0; i < tables.size(); ++i) {
+            size_t slot = position + 4 + 4 * i;
+            PutAt(out, slot, static_cast<uint32_t>(WriteTable(out, tables[i]) - slot));
+        }
+        return position;
+    }};
+}
+
+Field Table(Fields table) {
+    return {{}, [table](Bytes& out) { return WriteTable(out, table); }};
+}
+
+// Vtable, then the table, then its children; offsets all point forward
+size_t WriteTable(Bytes& out, const Fields& fields) {
+    const int slots = fields.empty() ? 0 : fields.rbegin()->first + 1;
+    const size_t vtable = out.size();
+    Put(out, static_cast<uint16_t>(4 + 2 * slots));
+    Put<uint16_t>(out, 0);
+    for (int i = 0; i < slots; ++i) {
+        Put<uint16_t>(out, 0);
+    }
+    const size_t table = out.size();
+    Put(out, static_cast<int32_t>(table - vtable));
+
+    std::vector<std::pair<size_t, const Field*>> children;
+    for (const auto& [index, field] : fields) {
+        PutAt(out, vtable + 4 + 2 * index, static_cast<uint16_t>(out.size() - table));
+        if (field.child) {
+            children.emplace_back(out.size(), &field);
+            Put<uint32_t>(out, 0);
+        } else {
+            out.insert(out.end(), field.scalar.begin(), field.scalar.end());
+        }
+    }
+    PutAt(out, vtable + 2, static_cast<uint16_t>(out.size() - table));
+    for (const auto& [slot, field] : children) {
+        PutAt(out, slot, static_cast<uint32_t>(field->child(out) - slot));
+    }
+    return table;
+}
+
+Bytes Root(const Fields& fields) {
+    Bytes out(4, 0);
+    PutAt(out, 0, static_cast<uint32_t>(WriteTable(out, fields)));
+    return out;
+}
+
+// Closed ring of a square, as FlatGeobuf writes it
+std::vector<double> Square(double x, double y, double size) {
+    return {x, y, x + size, y, x + size, y + size, x, y + size, x, y};
+}
+
+// Columns: id (Int), class (String), score (Float)
+Bytes Properties(int32_t id, const std::string& className, float score) {
+    Bytes properties;
+    Put<uint16_t>(properties, 0);
+    Put(properties, id);
+    Put<uint16_t>(properties, 1);
+    Put(properties, static_cast<uint32_t>(className.size()));
+    properties.insert(properties.end(), className.begin(), className.end());
+    Put<uint16_t>(properties, 2);
+    Put(properties, score);
+    return properties;
+}
+
+Field PolygonGeometry(const std::vector<double>& xy, const std::vector<uint32_t>& ends = {}) {
+    Fields geometry = {{1, Numbers(xy)}};
+    if (!ends.empty()) {
+        geometry[0] = Numbers(ends);
+    }
+    return Table(geometry);
+}
+
+struct TestFeature {
+    Bytes buffer;
+    Rect box;
+};
+
+TestFeature Feature(Field geometry, const std::vector<double>& allXy, int32_t id, const std::string& className,
+                    float score) {
+    Bytes properties = Properties(id, className, score);
+    TestFeature feature;
+    feature.buffer = Root({{0, geometry}, {1, Vector(properties, static_cast<uint32_t>(properties.size()))}});
+    double minX = allXy[0], maxX = allXy[0], minY = allXy[1], maxY = allXy[1];
+    for (size_t i = 0; i < allXy.size(); i += 2) {
+        minX = std::min(minX, allXy[i]);
+        maxX = std::max(maxX, allXy[i]);
+        minY = std::min(minY, allXy[i + 1]);
+        maxY = std::max(maxY, allXy[i + 1]);
+    }
+    feature.box = Rect(minX, minY, maxX - minX, maxY - minY);
+    return feature;
+}
+
+TestFeature SquareFeature(double x, double y, double size, int32_t id, const std::string& className, float score) {
+    std::vector<double> xy = Square(x, y, size);
+    return Feature(PolygonGeometry(xy), xy, id, className, score);
+}
+
+// A whole file; nodeSize 0 writes no index. Features keep their order
+// (the leaves need not be Hilbert sorted for reading). A nonzero
+// claimedCount forges the header's feature count.
+std::string FlatGeobufFile(const std::vector<TestFeature>& features, uint8_t geometryType, uint16_t nodeSize,
+                           uint64_t claimedCount = 0) {
+    Bytes file = {'f', 'g', 'b', 3, 'f', 'g', 'b', 0};
+    Bytes header = Root({{0, String("cells")},
+                         {2, Scalar(geometryType)},
+                         {7, Tables({{{0, String("id")}, {1, Scalar<uint8_t>(5)}},
+                                     {{0, String("class")}, {1, Scalar<uint8_t>(11)}},
+                                     {{0, String("score")}, {1, Scalar<uint8_t>(9)}}})},
+                         {8, Scalar(claimedCount ? claimedCount : static_cast<uint64_t>(features.size()))},
+                         {9, Scalar(nodeSize)}});
+    Put(file, static_cast<uint32_t>(header.size()));
+    file.insert(file.end(), header.begin(), header.end());
+
+    if (nodeSize > 0 && !features.empty()) {
+        struct Node {
+            double minX, minY, maxX, maxY;
+            uint64_t offset;
+        };
+        // Level sizes bottom-up; nodes are stored root first
+        std::vector<size_t> levelNodes = {features.size()};
+        while (levelNodes.back() > 1) {
+            levelNodes.push_back((levelNodes.back() + nodeSize - 1) / nodeSize);
+        }
+        size_t nodeCount = 0;
+        for (size_t count : levelNodes) {
+            nodeCount += count;
+        }
+        std::vector<size_t> levelStart(levelNodes.size());
+        size_t end = nodeCount;
+        for (size_t level = 0; level < levelNodes.size(); ++level) {
+            end -= levelNodes[level];
+            levelStart[level] = end;
+        }
+
+        std::vector<Node> nodes(nodeCount);
+        uint64_t offset = 0;
+        for (size_t i = 0; i < features.size(); ++i) {
+            const Rect& box = features[i].box;
+            nodes[levelStart[0] + i] = {box.x, box.y, box.x + box.width, box.y + box.height, offset};
+            offset += 4 + features[i].buffer.size();
+        }
+        for (size_t level = 1; level < levelNodes.size(); ++level) {
+            for (size_t j = 0; j < levelNodes[level]; ++j) {
+                size_t first = levelStart[level - 1] + j * nodeSize;
+                size_t last = std::min(first + nodeSize, levelStart[level - 1] + levelNodes[level - 1]);
+                Node node = nodes[first];
+                for (size_t child = first; child < last; ++child) {
+                    node.minX = std::min(node.minX, nodes[child].minX);
+                    node.minY = std::min(node.minY, nodes[child].minY);
+                    node.maxX = std::max(node.maxX, nodes[child].maxX);
+                    node.maxY = std::max(node.maxY, nodes[child].maxY);
+                }
+                node.offset = first;
+                nodes[levelStart[level] + j] = node;
+            }
+        }
+        for (const Node& node : nodes) {
+            Put(file, node.minX);
+            Put(file, node.minY);
+            Put(file, node.maxX);
+            Put(file, node.maxY);
+            Put(file, node.offset);
+        }
+    }
+
+    for (const TestFeature& feature : features) {
+        Put(file, static_cast<uint32_t>(feature.buffer.size()));
+        file.insert(file.end(), feature.buffer.begin(), feature.buffer.end());
+    }
+    return std::string(file.begin(), file.end());
+}
+
+// columns x rows squares of 10 pixels, 20 apart, alternating classes
+std::vector<TestFeature> Grid(int columns, int rows) {
+    std::vector<TestFeature> features;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            int id = row * columns + column;
+            features.push_back(SquareFeature(20.0 * column, 20.0 * row, 10.0, id, id % 2 == 0 ? "Tumor" : "Stroma",
+                                             0.5f));
+        }
+    }
+    return features;
+}
+
+constexpr uint8_t POLYGON = 3;
+constexpr uint8_t UNKNOWN = 0;
+constexpr uint8_t MULTIPOLYGON = 6;
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class FlatGeobufLoaderTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_flatgeobuf_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    std::string Save(const std::string& bytes) {
+        std::string path = (root / "cells.fgb").string();
+        std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+
+    static int ClassId(const std::map<int, std::string>& classNames, const std::string& name) {
+        for (const auto& [id, className] : classNames) {
+            if (className == name) {
+                return id;
+            }
+        }
+        return -1;
+    }
+};
+
+// ============================================================================
+// Reader Tests
+// ============================================================================
+
+TEST_F(FlatGeobufLoaderTest, Open_ReadsHeaderAndColumns) {
+    FlatGeobufReader reader;
+    ASSERT_TRUE(reader.Open(Save(FlatGeobufFile(Grid(5, 5), POLYGON, 4)))) << reader.GetError();
+    EXPECT_EQ(reader.GetFeatureCount(), 25u);
+    EXPECT_TRUE(reader.HasIndex());
+    EXPECT_EQ(reader.GetIndexNodeSize(), 4);
+    ASSERT_EQ(reader.GetColumns().size(), 3u);
+    EXPECT_EQ(reader.GetColumns()[1].name, "class");
+    EXPECT_EQ(reader.GetColumns()[1].type, FlatGeobufReader::ColumnType::String);
+    EXPECT_EQ(reader.GetClassColumn(), 1);
+    EXPECT_EQ(reader.GetConfidenceColumn(), 2);
+
+    std::vector<uint64_t> offsets;
+    ASSERT_TRUE(reader.ScanFeatures(offsets));
+    ASSERT_EQ(offsets.size(), 25u);
+    FlatGeobufReader::Feature feature;
+    ASSERT_TRUE(reader.ReadFeature(offsets[7], feature));
+    EXPECT_EQ(feature.className, "Stroma");
+    EXPECT_FLOAT_EQ(feature.confidence, 0.5f);
+    // Closing point dropped
+    EXPECT_EQ(feature.ringEnds, (std::vector<uint32_t>{4}));
+    EXPECT_DOUBLE_EQ(feature.xy[0], 40.0);
+    EXPECT_DOUBLE_EQ(feature.xy[1], 20.0);
+}
+
+TEST_F(FlatGeobufLoaderTest, Open_MalformedFiles_Fail) {
+    FlatGeobufReader reader;
+    EXPECT_FALSE(reader.Open(Save("not a flatgeobuf file")));
+    EXPECT_FALSE(reader.GetError().empty());
+    EXPECT_FALSE(reader.Open((root / "missing.fgb").string()));
+
+    // Index cut short
+    std::string bytes = FlatGeobufFile(Grid(5, 5), POLYGON, 4);
+    EXPECT_FALSE(reader.Open(Save(bytes.substr(0, 300))));
+
+    // Last feature cut short
+    FlatGeobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    EXPECT_FALSE(loader.Load(Save(bytes.substr(0, bytes.size() - 9)), polygons, colors, names));
+}
+
+TEST_F(FlatGeobufLoaderTest, Open_ForgedFeatureCount_FailsOrScansTheRealFeatures) {
+    FlatGeobufReader reader;
+
+    // An index for more features than the file could hold, including
+    // counts whose node bytes would wrap a uint64
+    for (uint64_t count : {uint64_t{1} << 60, ~uint64_t{0} / 2 + 1, ~uint64_t{0}}) {
+        EXPECT_FALSE(reader.Open(Save(FlatGeobufFile(Grid(2, 2), POLYGON, 2, count)))) << count;
+        EXPECT_FALSE(reader.GetError().empty());
+    }
+
+    // Without an index the count only sizes the scan, which mustn't trust it
+    ASSERT_TRUE(reader.Open(Save(FlatGeobufFile(Grid(2, 2), POLYGON, 0, uint64_t{1} << 60))));
+    EXPECT_FALSE(reader.HasIndex());
+    std::vector<uint64_t> offsets;
+    ASSERT_TRUE(reader.ScanFeatures(offsets));
+    EXPECT_EQ(offsets.size(), 4u);
+}
+
+TEST_F(FlatGeobufLoaderTest, Query_MatchesBruteForce) {
+    std::vector<TestFeature> features = Grid(12, 9);
+    FlatGeobufReader reader;
+    ASSERT_TRUE(reader.Open(Save(FlatGeobufFile(features, POLYGON, 4))));
+    std::vector<uint64_t> all;
+    ASSERT_TRUE(reader.ScanFeatures(all));
+
+    for (const Rect& region : {Rect(0, 0, 5, 5), Rect(35, 35, 50, 30), Rect(-100, -100, 50, 50),
+                               Rect(0, 0, 1000, 1000), Rect(12, 0, 6, 1000)}) {
+        std::vector<uint64_t> expected;
+        for (size_t i = 0; i < features.size(); ++i) {
+            if (features[i].box.Intersects(region)) {
+                expected.push_back(all[i]);
+            }
+        }
+        std::vector<uint64_t> offsets;
+        ASSERT_TRUE(reader.Query(region, offsets));
+        EXPECT_EQ(offsets, expected) << region.x << ", " << region.y;
+    }
+}
+
+// ============================================================================
+// Loader Tests
+// ============================================================================
+
+TEST_F(FlatGeobufLoaderTest, Load_KeepsExteriorRingsWithClassesAndConfidence) {
+    // A polygon with a hole: only its 4 outer corners are kept
+    std::vector<double> withHole = Square(100, 100, 50);
+    std::vector<double> hole = Square(110, 110, 10);
+    withHole.insert(withHole.end(), hole.begin(), hole.end());
+    std::vector<TestFeature> features = {
+        SquareFeature(0, 0, 10, 1, "Tumor", 0.9f),
+        Feature(PolygonGeometry(withHole, {5, 10}), withHole, 2, "Stroma", 0.25f),
+    };
+
+    FlatGeobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(Save(FlatGeobufFile(features, POLYGON, 16)), polygons, colors, names));
+
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_EQ(colors.size(), 2u);
+    ASSERT_EQ(polygons.Size(), 2u);
+    EXPECT_EQ(polygons.GetClassId(0), ClassId(names, "Tumor"));
+    EXPECT_EQ(polygons.GetClassId(1), ClassId(names, "Stroma"));
+    EXPECT_EQ(polygons.GetVertexCount(0), 4u);
+    EXPECT_EQ(polygons.GetVertexCount(1), 4u);
+    EXPECT_FLOAT_EQ(polygons.GetConfidence(0), 0.9f);
+    EXPECT_FLOAT_EQ(polygons.GetMaxX(1), 150.0f);
+}
+
+TEST_F(FlatGeobufLoaderTest, Load_MultiPolygonGivesOnePolygonPerPart) {
+    std::vector<double> first = Square(0, 0, 10);
+    std::vector<double> second = Square(30, 0, 10);
+    std::vector<double> both = first;
+    both.insert(both.end(), second.begin(), second.end());
+    Field geometry = Table({{6, Scalar(MULTIPOLYGON)},
+                            {7, Tables({{{1, Numbers(first)}}, {{1, Numbers(second)}}})}});
+    // Per-feature types: the plain square says Polygon itself
+    std::vector<double> third = Square(60, 0, 10);
+    std::vector<TestFeature> features = {
+        Feature(geometry, both, 1, "Lymphocyte", 0.5f),
+        Feature(Table({{1, Numbers(third)}, {6, Scalar(POLYGON)}}), third, 2, "Tumor", 0.5f),
+    };
+
+    FlatGeobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(Save(FlatGeobufFile(features, UNKNOWN, 16)), polygons, colors, names));
+    ASSERT_EQ(polygons.Size(), 3u);
+    EXPECT_EQ(polygons.GetClassId(0), polygons.GetClassId(1));
+    EXPECT_FLOAT_EQ(polygons.GetMinX(1), 30.0f);
+    EXPECT_FLOAT_EQ(polygons.GetMinX(2), 60.0f);
+}
+
+TEST_F(FlatGeobufLoaderTest, QueryRegion_DecodesOnlyRegionFeatures) {
+    FlatGeobufPolygonLoader loader;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Open(Save(FlatGeobufFile(Grid(20, 20), POLYGON, 4)), colors, names));
+    EXPECT_EQ(names.size(), 2u);
+
+    // Squares at columns 2-3, rows 5 (x 40-70, y 100-110)
+    PolygonStore polygons;
+    ASSERT_TRUE(loader.QueryRegion(Rect(45, 102, 20, 5), polygons));
+    ASSERT_EQ(polygons.Size(), 2u);
+    EXPECT_FLOAT_EQ(polygons.GetMinX(0), 40.0f);
+    EXPECT_FLOAT_EQ(polygons.GetMinX(1), 60.0f);
+    EXPECT_FLOAT_EQ(polygons.GetMinY(1), 100.0f);
+}
+
+TEST_F(FlatGeobufLoaderTest, LoadStreaming_DeliversEveryFeature) {
+    FlatGeobufPolygonLoader loader;
+    PolygonStreamCallbacks callbacks;
+    int classCalls = 0;
+    size_t total = 0;
+    callbacks.onClasses = [&](const std::map<int, SDL_Color>&, const std::map<int, std::string>& names) {
+        ++classCalls;
+        EXPECT_EQ(names.size(), 2u);
+    };
+    callbacks.onBatch = [&](PolygonStore&& batch, float) {
+        total += batch.Size();
+        return true;
+    };
+    ASSERT_TRUE(loader.LoadStreaming(Save(FlatGeobufFile(Grid(30, 30), POLYGON, 4)), callbacks));
+    EXPECT_EQ(classCalls, 1);
+    EXPECT_EQ(total, 900u);
+}
+
+TEST_F(FlatGeobufLoaderTest, NoIndex_LoadsAndQueriesEveryFeature) {
+    std::string path = Save(FlatGeobufFile(Grid(6, 6), POLYGON, 0));
+    FlatGeobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+    EXPECT_EQ(polygons.Size(), 36u);
+    EXPECT_FALSE(loader.GetReader().HasIndex());
+
+    PolygonStore region;
+    ASSERT_TRUE(loader.QueryRegion(Rect(0, 0, 5, 5), region));
+    EXPECT_EQ(region.Size(), 36u);
+
+    size_t streamed = 0;
+    PolygonStreamCallbacks callbacks;
+    callbacks.onBatch = [&](PolygonStore&& batch, float) {
+        streamed += batch.Size();
+        return true;
+    };
+    ASSERT_TRUE(loader.LoadStreaming(path, callbacks));
+    EXPECT_EQ(streamed, 36u);
+}
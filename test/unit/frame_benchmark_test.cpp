@@ -0,0 +1,160 @@
+// FrameBenchmark Unit Tests
+// Tests for stop detection, frame-by-frame stepping, waiting at stops
+// for a sharp view, the warm-up pass and the JSON report
+
+#include <gtest/gtest.h>
+#include "FrameBenchmark.h"
+#include <chrono>
+
+namespace {
+
+using Clock = FrameBenchmark::Clock;
+
+// Moves at 0-20 ms, holds at x = 20 for 500 ms, moves once more and stops
+ViewportTrace MakeTrace() {
+    ViewportTrace trace;
+    trace.Append({0.0, 0.0, 0.0, 1.0, 1280, 720});
+    trace.Append({10.0, 10.0, 0.0, 1.0, 1280, 720});
+    trace.Append({20.0, 20.0, 0.0, 1.0, 1280, 720});
+    trace.Append({520.0, 30.0, 0.0, 1.0, 1280, 720});
+    return trace;
+}
+
+// Draws one frame of the benchmark at now, lasting 5 ms
+void DrawFrame(FrameBenchmark& benchmark, Clock::time_point& now, bool sharp, size_t requested = 0) {
+    benchmark.BeginFrame(now);
+    now += std::chrono::milliseconds(5);
+    FrameBenchmark::Frame frame;
+    frame.cpuMs = 4.0;
+    frame.presentMs = 1.0;
+    frame.visibleTiles = 12;
+    frame.displayedTiles = sharp ? 12 : 3;
+    frame.requestedTiles = requested;
+    benchmark.EndFrame(frame, sharp, now);
+}
+
+}  // namespace
+
+// ============================================================================
+// Stops
+// ============================================================================
+
+TEST(FrameBenchmarkTest, FindStops_HeldSamplesAndTheLast) {
+    std::vector<bool> stops = FrameBenchmark::FindStops(MakeTrace(), 250.0);
+    EXPECT_EQ(stops, (std::vector<bool>{false, false, true, true}));
+
+    stops = FrameBenchmark::FindStops(MakeTrace(), 1000.0);
+    EXPECT_EQ(stops, (std::vector<bool>{false, false, false, true}));
+}
+
+// ============================================================================
+// Stepping
+// ============================================================================
+
+TEST(FrameBenchmarkTest, Cold_OneFramePerSampleAndWaitsAtStops) {
+    FrameBenchmarkOptions options;
+    FrameBenchmark benchmark(MakeTrace(), options);
+    ASSERT_TRUE(benchmark.IsMeasuring());
+    Clock::time_point now{};
+
+    // Moving samples advance even when blurry
+    DrawFrame(benchmark, now, false, 8);
+    EXPECT_DOUBLE_EQ(benchmark.GetSample().x, 10.0);
+    DrawFrame(benchmark, now, false, 8);
+    EXPECT_DOUBLE_EQ(benchmark.GetSample().x, 20.0);
+
+    // The stop is drawn until sharp: three frames, 15 ms
+    DrawFrame(benchmark, now, false, 4);
+    DrawFrame(benchmark, now, false);
+    EXPECT_DOUBLE_EQ(benchmark.GetSample().x, 20.0);
+    DrawFrame(benchmark, now, true);
+    EXPECT_DOUBLE_EQ(benchmark.GetSample().x, 30.0);
+
+    DrawFrame(benchmark, now, true);
+    EXPECT_TRUE(benchmark.IsDone());
+
+    ASSERT_EQ(benchmark.GetFrames().size(), 6u);
+    EXPECT_FALSE(benchmark.GetFrames()[2].settling);
+    EXPECT_TRUE(benchmark.GetFrames()[3].settling);
+    EXPECT_EQ(benchmark.GetFrames()[4].sample, 2u);
+
+    ASSERT_EQ(benchmark.GetStops().size(), 2u);
+    EXPECT_EQ(benchmark.GetStops()[0].sample, 2u);
+    EXPECT_EQ(benchmark.GetStops()[0].frames, 3u);
+    EXPECT_DOUBLE_EQ(benchmark.GetStops()[0].timeToSharpMs, 15.0);
+    EXPECT_FALSE(benchmark.GetStops()[0].timedOut);
+    EXPECT_DOUBLE_EQ(benchmark.GetStops()[1].timeToSharpMs, 5.0);
+}
+
+TEST(FrameBenchmarkTest, Stop_GivesUpAfterTheTimeout) {
+    FrameBenchmarkOptions options;
+    options.sharpTimeoutMs = 12.0;
+    ViewportTrace trace;
+    trace.Append({0.0, 0.0, 0.0, 1.0, 1280, 720});
+    FrameBenchmark benchmark(trace, options);
+    Clock::time_point now{};
+
+    DrawFrame(benchmark, now, false);
+    DrawFrame(benchmark, now, false);
+    EXPECT_FALSE(benchmark.IsDone());
+    DrawFrame(benchmark, now, false);
+    ASSERT_TRUE(benchmark.IsDone());
+    ASSERT_EQ(benchmark.GetStops().size(), 1u);
+    EXPECT_TRUE(benchmark.GetStops()[0].timedOut);
+    EXPECT_EQ(benchmark.GetStops()[0].frames, 3u);
+}
+
+TEST(FrameBenchmarkTest, Warm_MeasuresOnlyTheSecondPass) {
+    FrameBenchmarkOptions options;
+    options.warmCache = true;
+    FrameBenchmark benchmark(MakeTrace(), options);
+    Clock::time_point now{};
+
+    EXPECT_FALSE(benchmark.IsMeasuring());
+    for (int i = 0; i < 5; ++i) {
+        DrawFrame(benchmark, now, i >= 3);  // Warm-up: the first stop takes two frames
+    }
+    EXPECT_TRUE(benchmark.IsMeasuring());
+    EXPECT_TRUE(benchmark.GetFrames().empty());
+    EXPECT_DOUBLE_EQ(benchmark.GetSample().x, 0.0);
+
+    for (int i = 0; i < 4; ++i) {
+        DrawFrame(benchmark, now, true);
+    }
+    EXPECT_TRUE(benchmark.IsDone());
+    EXPECT_EQ(benchmark.GetFrames().size(), 4u);
+    EXPECT_EQ(benchmark.GetStops().size(), 2u);
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+TEST(FrameBenchmarkTest, ToJson_SummarizesFramesAndStops) {
+    FrameBenchmarkOptions options;
+    options.tracePath = "review.pvt";
+    FrameBenchmark benchmark(MakeTrace(), options);
+    Clock::time_point now{};
+    DrawFrame(benchmark, now, false, 8);
+    DrawFrame(benchmark, now, false, 8);
+    DrawFrame(benchmark, now, false, 4);
+    DrawFrame(benchmark, now, true);
+    DrawFrame(benchmark, now, true);
+    ASSERT_TRUE(benchmark.IsDone());
+
+    const FrameBenchmark::json report = benchmark.ToJson({{"view_width", 1280}});
+    EXPECT_EQ(report.at("trace"), "review.pvt");
+    EXPECT_EQ(report.at("cache"), "cold");
+    EXPECT_EQ(report.at("environment").at("view_width"), 1280);
+    ASSERT_EQ(report.at("frames").size(), 5u);
+    EXPECT_EQ(report.at("frames")[0].at("tiles_requested"), 8);
+    EXPECT_EQ(report.at("stops")[0].at("x"), 20.0);
+
+    const FrameBenchmark::json& summary = report.at("summary");
+    EXPECT_EQ(summary.at("frames"), 5);
+    EXPECT_EQ(summary.at("tiles_requested"), 20);
+    EXPECT_DOUBLE_EQ(summary.at("wall_ms").get<double>(), 25.0);
+    EXPECT_DOUBLE_EQ(summary.at("cpu_ms").at("p50").get<double>(), 4.0);
+    EXPECT_DOUBLE_EQ(summary.at("time_to_sharp_ms").at("max").get<double>(), 10.0);
+    EXPECT_EQ(summary.at("stops_timed_out"), 0);
+}
@@ -0,0 +1,126 @@
+// FrameProfiler Unit Tests
+// Tests for zone nesting, the frame ring buffer and Chrome trace export
+
+#include <gtest/gtest.h>
+#include "FrameProfiler.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Zone Tests
+// ============================================================================
+
+TEST(FrameProfilerTest, NestedZones_RecordDepthAndOrder) {
+    FrameProfiler profiler;
+
+    profiler.BeginFrame();
+    {
+        ProfileZone outer(&profiler, "Outer");
+        ProfileZone inner(&profiler, "Inner");
+    }
+    {
+        ProfileZone sibling(&profiler, "Sibling");
+    }
+    profiler.EndFrame();
+
+    ASSERT_EQ(profiler.GetFrameCount(), 1u);
+    const auto& zones = profiler.GetFrame(0).zones;
+    ASSERT_EQ(zones.size(), 3u);
+    EXPECT_STREQ(zones[0].name, "Outer");
+    EXPECT_EQ(zones[0].depth, 0u);
+    EXPECT_EQ(zones[1].depth, 1u);
+    EXPECT_EQ(zones[2].depth, 0u);
+    EXPECT_LE(zones[0].startUs, zones[1].startUs);
+    EXPECT_GE(zones[0].endUs, zones[1].endUs);
+}
+
+TEST(FrameProfilerTest, ZoneOutsideFrame_IsIgnored) {
+    FrameProfiler profiler;
+    {
+        ProfileZone zone(&profiler, "Stray");
+    }
+
+    profiler.BeginFrame();
+    profiler.EndFrame();
+
+    EXPECT_TRUE(profiler.GetFrame(0).zones.empty());
+}
+
+TEST(FrameProfilerTest, OpenZone_IsClosedAtFrameEnd) {
+    FrameProfiler profiler;
+
+    profiler.BeginFrame();
+    profiler.BeginZone("Unclosed");
+    profiler.EndFrame();
+
+    const FrameProfiler::Frame& frame = profiler.GetFrame(0);
+    ASSERT_EQ(frame.zones.size(), 1u);
+    EXPECT_EQ(frame.zones[0].endUs, frame.endUs);
+}
+
+TEST(FrameProfilerTest, ZonesPastMaxDepth_AreDroppedWithoutUnbalancing) {
+    FrameProfiler profiler;
+
+    profiler.BeginFrame();
+    for (uint32_t i = 0; i < FrameProfiler::MAX_DEPTH + 4; ++i) {
+        profiler.BeginZone("Deep");
+    }
+    for (uint32_t i = 0; i < FrameProfiler::MAX_DEPTH + 4; ++i) {
+        profiler.EndZone();
+    }
+    profiler.BeginZone("After");
+    profiler.EndZone();
+    profiler.EndFrame();
+
+    const auto& zones = profiler.GetFrame(0).zones;
+    ASSERT_EQ(zones.size(), FrameProfiler::MAX_DEPTH + 1);
+    EXPECT_STREQ(zones.back().name, "After");
+    EXPECT_EQ(zones.back().depth, 0u);
+}
+
+// ============================================================================
+// Ring Buffer Tests
+// ============================================================================
+
+TEST(FrameProfilerTest, History_KeepsNewestFrames) {
+    FrameProfiler profiler;
+    size_t total = FrameProfiler::HISTORY_FRAMES + 10;
+    for (size_t i = 0; i < total; ++i) {
+        profiler.BeginFrame();
+        profiler.EndFrame();
+    }
+
+    EXPECT_EQ(profiler.GetFrameCount(), FrameProfiler::HISTORY_FRAMES);
+    EXPECT_EQ(profiler.GetFrame(0).index, total - 1);
+    EXPECT_EQ(profiler.GetFrame(FrameProfiler::HISTORY_FRAMES - 1).index, 10u);
+}
+
+// ============================================================================
+// Export Tests
+// ============================================================================
+
+TEST(FrameProfilerTest, ExportChromeTrace_WritesCompleteEvents) {
+    FrameProfiler profiler;
+    profiler.BeginFrame();
+    {
+        ProfileZone zone(&profiler, "Say \"hi\"");
+    }
+    profiler.EndFrame();
+
+    std::string path = (fs::temp_directory_path() / "pathview_profiler_test.json").string();
+    ASSERT_TRUE(profiler.ExportChromeTrace(path));
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+    fs::remove(path);
+
+    EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\": \"Frame\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\": \"Say \\\"hi\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\": \"X\""), std::string::npos);
+}
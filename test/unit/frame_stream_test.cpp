@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "../../src/api/http/FrameStream.h"
+#include <atomic>
+#include <thread>
+
+using namespace pathview::http;
+using namespace std::chrono_literals;
+
+TEST(FrameStreamTest, WaitsOnlyForNewerFrames) {
+    FrameStream stream;
+    EXPECT_EQ(stream.WaitForFrame(0, 10ms), nullptr);
+
+    stream.Publish({1, 2, 3}, "image/jpeg", 4, 2);
+    auto frame = stream.WaitForFrame(0, 10ms);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->sequence, 1u);
+    EXPECT_EQ(frame->mimeType, "image/jpeg");
+    EXPECT_EQ(frame->data.size(), 3u);
+
+    // Already sent: nothing until the next publish
+    EXPECT_EQ(stream.WaitForFrame(frame->sequence, 10ms), nullptr);
+    stream.Publish({4}, "image/jpeg", 4, 2);
+    stream.Publish({5}, "image/jpeg", 4, 2);
+    auto latest = stream.WaitForFrame(frame->sequence, 10ms);
+    ASSERT_NE(latest, nullptr);
+    EXPECT_EQ(latest->sequence, 3u);  // Skips to the latest
+    EXPECT_EQ(latest->data[0], 5);
+}
+
+// One publish wakes every waiting subscriber with the same frame
+TEST(FrameStreamTest, FansOutToAllSubscribers) {
+    FrameStream stream;
+    std::atomic<int> received{0};
+    std::vector<std::thread> subscribers;
+    for (int i = 0; i < 4; ++i) {
+        subscribers.emplace_back([&]() {
+            if (auto frame = stream.WaitForFrame(0, 5s)) {
+                if (frame->data.size() == 2) {
+                    ++received;
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+    stream.Publish({7, 8}, "image/png", 1, 1);
+    for (std::thread& thread : subscribers) {
+        thread.join();
+    }
+    EXPECT_EQ(received.load(), 4);
+}
+
+TEST(FrameStreamTest, RequestedFpsIsFastestSubscriber) {
+    FrameStream stream;
+    EXPECT_EQ(stream.GetRequestedFps(), 0);
+    stream.AddSubscriber(5);
+    stream.AddSubscriber(15);
+    stream.AddSubscriber(15);
+    EXPECT_EQ(stream.GetRequestedFps(), 15);
+    EXPECT_EQ(stream.GetSubscriberCount(), 3u);
+
+    stream.RemoveSubscriber(15);
+    EXPECT_EQ(stream.GetRequestedFps(), 15);
+    stream.RemoveSubscriber(15);
+    EXPECT_EQ(stream.GetRequestedFps(), 5);
+    stream.RemoveSubscriber(5);
+    EXPECT_EQ(stream.GetRequestedFps(), 0);
+    EXPECT_EQ(stream.GetSubscriberCount(), 0u);
+}
+
+TEST(FrameStreamTest, CloseWakesWaiters) {
+    FrameStream stream;
+    std::thread waiter([&]() { EXPECT_EQ(stream.WaitForFrame(0, 10s), nullptr); });
+    std::this_thread::sleep_for(20ms);
+    const auto start = std::chrono::steady_clock::now();
+    stream.Close();
+    waiter.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    EXPECT_TRUE(stream.IsClosed());
+}
@@ -0,0 +1,78 @@
+// GeometryBatch Unit Tests
+// Tests for screen-space batching: vertices transformed with their color,
+// triangle indices offset by their base, outline quads per edge (none for
+// zero-length edges, none closing an open path), also around screen
+// positions held elsewhere, vertex markers, and Clear()
+
+#include <gtest/gtest.h>
+#include "GeometryBatch.h"
+
+namespace {
+
+constexpr SDL_Color FILL = {255, 255, 0, 80};
+constexpr SDL_Color EDGE = {255, 200, 0, 255};
+
+}  // namespace
+
+TEST(GeometryBatchTest, Fill_IndicesOffsetByBase) {
+    Viewport viewport(1000, 1000, 1000, 1000);
+    ASSERT_DOUBLE_EQ(viewport.GetZoom(), 1.0);
+
+    GeometryBatch batch;
+    EXPECT_TRUE(batch.Empty());
+    std::vector<Vec2> square = {Vec2(10, 10), Vec2(20, 10), Vec2(20, 20), Vec2(10, 20)};
+    const uint32_t triangles[] = {0, 1, 2, 0, 2, 3};
+
+    EXPECT_EQ(batch.AddVertices(square.data(), square.size(), viewport, FILL), 0);
+    batch.AddTriangles(0, triangles, 6);
+    const std::vector<float> xy = {30, 30, 40, 30, 40, 40, 30, 40};
+    const int base = batch.AddVertices(xy.data(), 4, viewport, FILL);
+    EXPECT_EQ(base, 4);
+    batch.AddTriangles(base, triangles, 6);
+
+    EXPECT_FALSE(batch.Empty());
+    EXPECT_EQ(batch.GetVertexCount(), 8u);
+    EXPECT_EQ(batch.GetIndexCount(), 12u);
+}
+
+TEST(GeometryBatchTest, Outline_QuadPerEdge) {
+    Viewport viewport(1000, 1000, 1000, 1000);
+    GeometryBatch batch;
+
+    // A repeated vertex makes one zero-length edge, which draws nothing
+    std::vector<Vec2> outline = {Vec2(10, 10), Vec2(110, 10), Vec2(110, 10), Vec2(110, 110), Vec2(10, 110)};
+    const int base = batch.AddVertices(outline.data(), outline.size(), viewport, FILL);
+    batch.AddOutline(base, outline.size(), 1.0f, EDGE);
+    EXPECT_EQ(batch.GetVertexCount(), outline.size() + 4 * 4);
+    EXPECT_EQ(batch.GetIndexCount(), 4u * 6);
+
+    batch.Clear();
+    EXPECT_TRUE(batch.Empty());
+    EXPECT_EQ(batch.GetVertexCount(), 0u);
+}
+
+TEST(GeometryBatchTest, Outline_FromScreenPositions) {
+    GeometryBatch batch;
+    const std::vector<float> xy = {10, 10, 110, 10, 110, 110, 10, 110};
+    batch.AddOutline(xy.data(), 4, 2.0f, EDGE);
+    EXPECT_EQ(batch.GetVertexCount(), 4u * 4);
+    EXPECT_EQ(batch.GetIndexCount(), 4u * 6);
+
+    batch.AddOutline(xy.data(), 3, 2.0f, EDGE, false);
+    EXPECT_EQ(batch.GetIndexCount(), 6u * 6);
+}
+
+TEST(GeometryBatchTest, OpenPathAndMarkers) {
+    Viewport viewport(1000, 1000, 1000, 1000);
+    GeometryBatch batch;
+
+    std::vector<Vec2> path = {Vec2(10, 10), Vec2(110, 10), Vec2(110, 110)};
+    const int base = batch.AddVertices(path.data(), path.size(), viewport, EDGE);
+    batch.AddOutline(base, path.size(), 1.0f, EDGE, false);
+    EXPECT_EQ(batch.GetIndexCount(), 2u * 6);
+
+    // Markers on the last two vertices only, as a path grows
+    batch.AddDiscs(base + 1, 2, 5.0f, FILL);
+    EXPECT_EQ(batch.GetVertexCount(), path.size() + 2 * 4 + 2 * (GeometryBatch::DISC_SEGMENTS + 1));
+    EXPECT_EQ(batch.GetIndexCount(), 2u * 6 + 2 * 3 * GeometryBatch::DISC_SEGMENTS);
+}
@@ -0,0 +1,309 @@
+// Heatmap Unit Tests
+// Tests for heatmap grids (.npy headers, types and byte orders, forged
+// shapes, Zarr v2 and v3 arrays with compressed and missing chunks), the
+// lazily made min/max pyramid with its NaN handling and bounded cache, and
+// the colormap, range and threshold mapping of HeatmapLayer.
+
+#include <gtest/gtest.h>
+#include "HeatmapGrid.h"
+#include "HeatmapLayer.h"
+#include "HeatmapPyramid.h"
+#include "json.hpp"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// Value of cell (x, y) in the test grids, distinct everywhere
+float ValueAt(int64_t x, int64_t y) {
+    return static_cast<float>(y * 1000 + x);
+}
+
+void WriteFile(const fs::path& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+// An .npy file (version 1) of a header dictionary and raw values
+std::vector<uint8_t> Npy(const std::string& dictionary, const std::vector<uint8_t>& values) {
+    std::string header = dictionary;
+    // The header pads to 64 bytes with spaces and ends in a newline
+    while ((10 + header.size() + 1) % 64 != 0) {
+        header += ' ';
+    }
+    header += '\n';
+    std::vector<uint8_t> bytes = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    bytes.push_back(static_cast<uint8_t>(header.size() & 0xFF));
+    bytes.push_back(static_cast<uint8_t>(header.size() >> 8));
+    bytes.insert(bytes.end(), header.begin(), header.end());
+    bytes.insert(bytes.end(), values.begin(), values.end());
+    return bytes;
+}
+
+// ValueAt() over a width x height grid as little- or big-endian float32
+std::vector<uint8_t> Float32Values(int64_t width, int64_t height, bool bigEndian = false) {
+    std::vector<uint8_t> bytes;
+    for (int64_t y = 0; y < height; ++y) {
+        for (int64_t x = 0; x < width; ++x) {
+            const float value = ValueAt(x, y);
+            uint8_t raw[4];
+            std::memcpy(raw, &value, 4);
+            for (int i = 0; i < 4; ++i) {
+                bytes.push_back(raw[bigEndian ? 3 - i : i]);
+            }
+        }
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> Deflate(const std::vector<uint8_t>& raw) {
+    uLongf size = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> out(size);
+    compress(out.data(), &size, raw.data(), static_cast<uLong>(raw.size()));
+    out.resize(size);
+    return out;
+}
+
+}  // namespace
+
+class HeatmapTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_heatmap_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    std::string WriteNpy(const std::string& name, int64_t width, int64_t height, bool bigEndian = false) {
+        const std::string descr = bigEndian ? ">f4" : "<f4";
+        const std::string dictionary = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" +
+                                       std::to_string(height) + ", " + std::to_string(width) + "), }";
+        const fs::path path = root / name;
+        WriteFile(path, Npy(dictionary, Float32Values(width, height, bigEndian)));
+        return path.string();
+    }
+};
+
+// ============================================================================
+// Grid Tests
+// ============================================================================
+
+TEST_F(HeatmapTest, Npy_ReadsRegionsInPlace) {
+    for (bool bigEndian : {false, true}) {
+        HeatmapGrid grid(WriteNpy(bigEndian ? "big.npy" : "little.npy", 300, 200, bigEndian));
+        ASSERT_TRUE(grid.IsOpen()) << grid.GetError();
+        EXPECT_EQ(grid.GetWidth(), 300);
+        EXPECT_EQ(grid.GetHeight(), 200);
+        EXPECT_FLOAT_EQ(grid.GetNaturalMax(), 1.0f);
+
+        // Straddling the right edge: cells past it read NaN
+        std::vector<float> values(20 * 3);
+        ASSERT_TRUE(grid.ReadRegion(290, 50, 20, 3, values.data()));
+        EXPECT_FLOAT_EQ(values[0], ValueAt(290, 50));
+        EXPECT_FLOAT_EQ(values[2 * 20 + 9], ValueAt(299, 52));
+        EXPECT_TRUE(std::isnan(values[10]));
+    }
+}
+
+TEST_F(HeatmapTest, Npy_OtherTypesAndRefusals) {
+    // uint8 and float16 (1.5 = 0x3E00)
+    WriteFile(root / "u1.npy", Npy("{'descr': '|u1', 'fortran_order': False, 'shape': (2, 2), }", {0, 7, 128, 255}));
+    HeatmapGrid bytes((root / "u1.npy").string());
+    ASSERT_TRUE(bytes.IsOpen()) << bytes.GetError();
+    EXPECT_FLOAT_EQ(bytes.GetNaturalMax(), 255.0f);
+    float values[4];
+    ASSERT_TRUE(bytes.ReadRegion(0, 0, 2, 2, values));
+    EXPECT_FLOAT_EQ(values[2], 128.0f);
+
+    WriteFile(root / "f2.npy", Npy("{'descr': '<f2', 'fortran_order': False, 'shape': (1, 2), }", {0x00, 0x3E, 0x00, 0x7E}));
+    HeatmapGrid halves((root / "f2.npy").string());
+    ASSERT_TRUE(halves.IsOpen()) << halves.GetError();
+    ASSERT_TRUE(halves.ReadRegion(0, 0, 2, 1, values));
+    EXPECT_FLOAT_EQ(values[0], 1.5f);
+    EXPECT_TRUE(std::isnan(values[1]));
+
+    // Fortran order, other types, other ranks, short data
+    WriteFile(root / "fortran.npy", Npy("{'descr': '<f4', 'fortran_order': True, 'shape': (1, 1), }", {0, 0, 0, 0}));
+    EXPECT_FALSE(HeatmapGrid((root / "fortran.npy").string()).IsOpen());
+    WriteFile(root / "int.npy", Npy("{'descr': '<i4', 'fortran_order': False, 'shape': (1, 1), }", {0, 0, 0, 0}));
+    EXPECT_FALSE(HeatmapGrid((root / "int.npy").string()).IsOpen());
+    WriteFile(root / "cube.npy", Npy("{'descr': '|u1', 'fortran_order': False, 'shape': (1, 1, 1), }", {0}));
+    EXPECT_FALSE(HeatmapGrid((root / "cube.npy").string()).IsOpen());
+    WriteFile(root / "short.npy", Npy("{'descr': '<f4', 'fortran_order': False, 'shape': (4, 4), }", {0, 0, 0, 0}));
+    EXPECT_FALSE(HeatmapGrid((root / "short.npy").string()).IsOpen());
+    EXPECT_FALSE(HeatmapGrid((root / "missing.npy").string()).IsOpen());
+}
+
+TEST_F(HeatmapTest, Npy_ForgedShapesAreRefused) {
+    // Dimensions whose product wraps to 0, and one past int64
+    WriteFile(root / "wrap.npy", Npy("{'descr': '|u1', 'fortran_order': False, 'shape': (4294967296, 4294967296), }",
+                                     {0, 0, 0, 0}));
+    EXPECT_FALSE(HeatmapGrid((root / "wrap.npy").string()).IsOpen());
+    WriteFile(root / "huge.npy", Npy("{'descr': '|u1', 'fortran_order': False, 'shape': (99999999999999999999, 1), }",
+                                     {0, 0, 0, 0}));
+    HeatmapGrid huge((root / "huge.npy").string());
+    EXPECT_FALSE(huge.IsOpen());
+    EXPECT_FALSE(huge.GetError().empty());
+}
+
+TEST_F(HeatmapTest, Zarr_DecodesChunksAndFillsMissingOnes) {
+    // 50 x 30 float32 in 32 x 16 zlib chunks; chunk (1, 1) missing
+    const fs::path array = root / "probabilities.zarr";
+    fs::create_directories(array);
+    json metadata = {{"zarr_format", 2}, {"shape", {30, 50}}, {"chunks", {16, 32}}, {"dtype", "<f4"},
+                     {"compressor", {{"id", "zlib"}, {"level", 1}}}, {"fill_value", 0.25},
+                     {"order", "C"}, {"filters", nullptr}};
+    std::ofstream(array / ".zarray") << metadata.dump();
+    for (int64_t row = 0; row < 2; ++row) {
+        for (int64_t column = 0; column < 2; ++column) {
+            if (row == 1 && column == 1) {
+                continue;
+            }
+            std::vector<uint8_t> raw;
+            for (int64_t y = row * 16; y < row * 16 + 16; ++y) {
+                for (int64_t x = column * 32; x < column * 32 + 32; ++x) {
+                    const float value = ValueAt(x, y);
+                    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+                    raw.insert(raw.end(), bytes, bytes + 4);
+                }
+            }
+            WriteFile(array / (std::to_string(row) + "." + std::to_string(column)), Deflate(raw));
+        }
+    }
+
+    EXPECT_TRUE(HeatmapGrid::IsHeatmapPath(array.string()));
+    HeatmapGrid grid((array / ".zarray").string());
+    ASSERT_TRUE(grid.IsOpen()) << grid.GetError();
+    EXPECT_EQ(grid.GetWidth(), 50);
+    EXPECT_EQ(grid.GetHeight(), 30);
+
+    std::vector<float> values(50 * 30);
+    ASSERT_TRUE(grid.ReadRegion(0, 0, 50, 30, values.data()));
+    EXPECT_FLOAT_EQ(values[10 * 50 + 40], ValueAt(40, 10));
+    EXPECT_FLOAT_EQ(values[20 * 50 + 5], ValueAt(5, 20));
+    EXPECT_FLOAT_EQ(values[20 * 50 + 40], 0.25f);
+    EXPECT_EQ(grid.GetChunkReadCount(), 3u);
+}
+
+TEST_F(HeatmapTest, Zarr_V3ArrayAndPathDetection) {
+    const fs::path array = root / "scores";
+    fs::create_directories(array / "c" / "0");
+    json metadata = {{"zarr_format", 3}, {"node_type", "array"}, {"shape", {2, 3}}, {"data_type", "uint8"},
+                     {"chunk_grid", {{"name", "regular"}, {"configuration", {{"chunk_shape", {2, 3}}}}}},
+                     {"chunk_key_encoding", {{"name", "default"}}},
+                     {"codecs", {{{"name", "bytes"}}}}, {"fill_value", 0}};
+    std::ofstream(array / "zarr.json") << metadata.dump();
+    WriteFile(array / "c" / "0" / "0", {1, 2, 3, 4, 5, 6});
+
+    EXPECT_TRUE(HeatmapGrid::IsHeatmapPath(array.string()));
+    EXPECT_TRUE(HeatmapGrid::IsHeatmapPath(WriteNpy("grid.npy", 2, 2)));
+    EXPECT_FALSE(HeatmapGrid::IsHeatmapPath(root.string()));
+
+    HeatmapGrid grid(array.string());
+    ASSERT_TRUE(grid.IsOpen()) << grid.GetError();
+    float values[6];
+    ASSERT_TRUE(grid.ReadRegion(0, 0, 3, 2, values));
+    EXPECT_FLOAT_EQ(values[5], 6.0f);
+}
+
+// ============================================================================
+// Pyramid Tests
+// ============================================================================
+
+TEST_F(HeatmapTest, Pyramid_KeepsMinAndMaxOfEachBlock) {
+    // 600 x 300 cells: 3 x 2 tiles at level 0, down to one at level 2
+    auto grid = std::make_unique<HeatmapGrid>(WriteNpy("grid.npy", 600, 300));
+    ASSERT_TRUE(grid->IsOpen());
+    HeatmapPyramid pyramid(std::move(grid), 4.0);
+    EXPECT_EQ(pyramid.GetLevelCount(), 3);
+    EXPECT_EQ(pyramid.GetTileColumns(0), 3);
+    EXPECT_EQ(pyramid.GetTileRows(0), 2);
+    EXPECT_EQ(pyramid.ChooseLevel(1.0 / 8.0), 1);  // 8 slide px per texel at level 1
+
+    // Nothing is made until asked for, then the whole chain below
+    EXPECT_EQ(pyramid.FindTile(2, 0, 0), nullptr);
+    std::shared_ptr<const HeatmapPyramid::Tile> top = pyramid.GetTile(2, 0, 0);
+    ASSERT_NE(top, nullptr);
+    EXPECT_EQ(pyramid.GetTilesMade(), 1u + 2u + 6u);
+    EXPECT_NE(pyramid.FindTile(0, 2, 1), nullptr);
+
+    // Texel (10, 5) of level 2 covers cells x 40-43, y 20-23
+    const size_t texel = 5 * HeatmapPyramid::TILE_SIZE + 10;
+    EXPECT_FLOAT_EQ(top->Min()[texel], ValueAt(40, 20));
+    EXPECT_FLOAT_EQ(top->Max()[texel], ValueAt(43, 23));
+    // Past the grid (600 / 4 = 150 texels across)
+    EXPECT_TRUE(std::isnan(top->Max()[150]));
+
+    EXPECT_EQ(pyramid.GetTile(0, 3, 0), nullptr);  // Out of range
+    const Rect bounds = pyramid.GetTileBounds(1, 1, 0);
+    EXPECT_DOUBLE_EQ(bounds.x, 2048.0);
+    EXPECT_DOUBLE_EQ(bounds.width, 2048.0);
+}
+
+TEST_F(HeatmapTest, Pyramid_SkipsNaNAndBoundsItsCache) {
+    // Every value NaN except one hot cell
+    std::vector<uint8_t> raw;
+    for (int i = 0; i < 512 * 512; ++i) {
+        const float value = i == 300 * 512 + 400 ? 0.9f : std::nanf("");
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        raw.insert(raw.end(), bytes, bytes + 4);
+    }
+    WriteFile(root / "sparse.npy", Npy("{'descr': '<f4', 'fortran_order': False, 'shape': (512, 512), }", raw));
+    auto grid = std::make_unique<HeatmapGrid>((root / "sparse.npy").string());
+    ASSERT_TRUE(grid->IsOpen());
+
+    // Room for about two full tiles
+    const size_t tileBytes = HeatmapPyramid::TILE_TEXELS * sizeof(float);
+    HeatmapPyramid pyramid(std::move(grid), 1.0, tileBytes * 2 + tileBytes / 2);
+    std::shared_ptr<const HeatmapPyramid::Tile> top = pyramid.GetTile(1, 0, 0);
+    ASSERT_NE(top, nullptr);
+    EXPECT_FLOAT_EQ(top->Max()[150 * HeatmapPyramid::TILE_SIZE + 200], 0.9f);
+    EXPECT_TRUE(std::isnan(top->Min()[0]));
+
+    // The tiles without the hot cell hold nothing
+    std::shared_ptr<const HeatmapPyramid::Tile> empty = pyramid.GetTile(0, 0, 0);
+    ASSERT_NE(empty, nullptr);
+    EXPECT_TRUE(empty->Empty());
+    EXPECT_LE(pyramid.GetMemoryUsage(), tileBytes * 2 + tileBytes / 2);
+}
+
+// ============================================================================
+// Value Mapping Tests
+// ============================================================================
+
+TEST(HeatmapLayerTest, MapValue_RangeThresholdAndColormap) {
+    HeatmapLayer layer(nullptr);
+    layer.SetThreshold(0.2f);
+    EXPECT_EQ(layer.MapValue(0.1f), 0u);
+    EXPECT_EQ(layer.MapValue(std::nanf("")), 0u);
+
+    // Viridis ends, opaque
+    EXPECT_EQ(layer.MapValue(1.0f), 0xFFFDE725u);
+    EXPECT_EQ(layer.MapValue(5.0f), 0xFFFDE725u);
+    layer.SetThreshold(0.0f);
+    EXPECT_EQ(layer.MapValue(0.0f), 0xFF440154u);
+
+    // A narrower range saturates sooner
+    layer.SetRange(0.0f, 0.5f);
+    EXPECT_EQ(layer.MapValue(0.5f), 0xFFFDE725u);
+
+    layer.SetColormap(HeatmapLayer::Colormap::Gray);
+    EXPECT_EQ(layer.MapValue(0.25f), 0xFF808080u);
+    EXPECT_STREQ(HeatmapLayer::GetColormapName(HeatmapLayer::Colormap::Magma), "Magma");
+}
@@ -0,0 +1,100 @@
+// IncrementalCellCount Unit Tests
+// Tests for live counts of an outline drawn vertex by vertex matching
+// counts of the whole outline, with and without the spatial index, and for
+// counting again when the cells change
+
+#include <gtest/gtest.h>
+#include "IncrementalCellCount.h"
+#include "PolygonIndex.h"
+#include "PolygonMask.h"
+#include "PolygonStore.h"
+#include <cmath>
+#include <random>
+
+namespace {
+
+// A 60 x 60 grid of 8 px cells every 50 px, in three classes
+PolygonStore GridOfCells() {
+    PolygonStore polygons;
+    for (int row = 0; row < 60; ++row) {
+        for (int column = 0; column < 60; ++column) {
+            const double x = column * 50.0, y = row * 50.0;
+            polygons.Add((row * 7 + column) % 3, {Vec2(x, y), Vec2(x + 8, y), Vec2(x + 8, y + 8), Vec2(x, y + 8)});
+        }
+    }
+    return polygons;
+}
+
+// Hand-drawn-like lasso: wobbly, concave, and crossing itself once
+std::vector<Vec2> Lasso() {
+    std::vector<Vec2> vertices;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> wobble(0.7, 1.3);
+    for (int i = 0; i < 40; ++i) {
+        const double angle = 2.0 * M_PI * i / 40;
+        const double r = 1000.0 * wobble(random) * (i % 5 == 0 ? 0.5 : 1.0);
+        vertices.emplace_back(1500 + r * std::cos(angle), 1500 + r * std::sin(angle));
+    }
+    std::swap(vertices[10], vertices[12]);
+    return vertices;
+}
+
+std::map<int, int> CountWhole(const std::vector<Vec2>& outline, const PolygonStore& polygons) {
+    std::map<int, int> counts;
+    PolygonMask(outline).CountCentroids(polygons, nullptr, counts);
+    return counts;
+}
+
+}  // namespace
+
+TEST(IncrementalCellCountTest, EachVertex_MatchesCountingTheWholeOutline) {
+    PolygonStore polygons = GridOfCells();
+    PolygonIndex index;
+    index.Build(polygons);
+
+    const std::vector<Vec2> lasso = Lasso();
+    IncrementalCellCount indexed, scanned;
+    std::vector<Vec2> drawn;
+    for (const Vec2& vertex : lasso) {
+        drawn.push_back(vertex);
+        indexed.Update(drawn, &polygons, &index);
+        scanned.Update(drawn, &polygons, nullptr);
+
+        const std::map<int, int> expected = drawn.size() < 3 ? std::map<int, int>() : CountWhole(drawn, polygons);
+        ASSERT_EQ(indexed.GetCounts(), expected) << drawn.size() << " vertices";
+        ASSERT_EQ(scanned.GetCounts(), expected) << drawn.size() << " vertices";
+
+        int total = 0;
+        for (const auto& [classId, count] : expected) {
+            total += count;
+        }
+        EXPECT_EQ(indexed.GetTotal(), total);
+        EXPECT_TRUE(indexed.IsCurrent(drawn.size(), &polygons));
+    }
+    EXPECT_GT(indexed.GetTotal(), 100);
+}
+
+TEST(IncrementalCellCountTest, ChangedCellsOrShorterOutline_CountAgain) {
+    PolygonStore polygons = GridOfCells();
+    const std::vector<Vec2> square = {Vec2(0, 0), Vec2(500, 0), Vec2(500, 500), Vec2(0, 500)};
+
+    IncrementalCellCount count;
+    count.Update(square, &polygons, nullptr);
+    EXPECT_EQ(count.GetTotal(), 100);
+
+    // More cells arrive (e.g. a streaming load) while drawing
+    polygons.Add(5, {Vec2(200, 220), Vec2(210, 220), Vec2(210, 230)});
+    EXPECT_FALSE(count.IsCurrent(square.size(), &polygons));
+    count.Update(square, &polygons, nullptr);
+    EXPECT_EQ(count.GetTotal(), 101);
+    EXPECT_EQ(count.GetCounts().at(5), 1);
+
+    // Drawing restarted with fewer vertices
+    const std::vector<Vec2> triangle = {Vec2(0, 0), Vec2(500, 0), Vec2(0, 500)};
+    count.Update(triangle, &polygons, nullptr);
+    EXPECT_EQ(count.GetCounts(), CountWhole(triangle, polygons));
+
+    count.Update(square, nullptr, nullptr);
+    EXPECT_TRUE(count.GetCounts().empty());
+    EXPECT_FALSE(count.IsCurrent(square.size(), nullptr));
+}
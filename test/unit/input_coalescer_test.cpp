@@ -0,0 +1,55 @@
+// InputCoalescer Unit Tests
+// Tests for per-frame input: pan deltas and fractional wheel steps summed,
+// the last cursor kept, opposite steps cancelling, and zoom from summed
+// steps matching the steps taken one at a time
+
+#include <gtest/gtest.h>
+#include "InputCoalescer.h"
+#include <cmath>
+
+TEST(InputCoalescerTest, SumsFrameAndStartsOver) {
+    InputCoalescer input;
+    EXPECT_TRUE(input.Empty());
+
+    input.AddPan(3, -1);
+    input.AddPan(4, -2);
+    input.AddWheel(0.25, 100, 200);
+    input.AddWheel(0.5, 110, 210);
+    input.AddMotion(10, 20);
+    input.AddMotion(12, 25);
+    EXPECT_FALSE(input.Empty());
+
+    InputCoalescer::Frame frame = input.Take();
+    EXPECT_EQ(frame.panX, 7);
+    EXPECT_EQ(frame.panY, -3);
+    EXPECT_DOUBLE_EQ(frame.wheel, 0.75);
+    EXPECT_EQ(frame.wheelX, 110);
+    EXPECT_EQ(frame.wheelY, 210);
+    EXPECT_TRUE(frame.moved);
+    EXPECT_EQ(frame.cursorX, 12);
+    EXPECT_EQ(frame.cursorY, 25);
+
+    EXPECT_TRUE(input.Empty());
+    frame = input.Take();
+    EXPECT_FALSE(frame.HasPan());
+    EXPECT_DOUBLE_EQ(frame.wheel, 0.0);
+    EXPECT_FALSE(frame.moved);
+}
+
+TEST(InputCoalescerTest, OppositeInputCancels) {
+    InputCoalescer input;
+    input.AddPan(5, 5);
+    input.AddPan(-5, -5);
+    input.AddWheel(1.0, 0, 0);
+    input.AddWheel(-1.0, 0, 0);
+    EXPECT_TRUE(input.Empty());
+}
+
+TEST(InputCoalescerTest, ZoomFactor_SameAsStepsOneAtATime) {
+    EXPECT_DOUBLE_EQ(InputCoalescer::ZoomFactor(0.0), 1.0);
+    EXPECT_DOUBLE_EQ(InputCoalescer::ZoomFactor(1.0), InputCoalescer::WHEEL_ZOOM_STEP);
+    EXPECT_NEAR(InputCoalescer::ZoomFactor(3.0), std::pow(InputCoalescer::WHEEL_ZOOM_STEP, 3), 1e-12);
+    EXPECT_NEAR(InputCoalescer::ZoomFactor(0.5) * InputCoalescer::ZoomFactor(0.5),
+                InputCoalescer::WHEEL_ZOOM_STEP, 1e-12);
+    EXPECT_NEAR(InputCoalescer::ZoomFactor(1.0) * InputCoalescer::ZoomFactor(-1.0), 1.0, 1e-12);
+}
@@ -0,0 +1,541 @@
+// IPCServer Unit Tests
+// Tests over loopback TCP: many clients at once, pipelined requests held
+// behind a deferred one, batches piping results past a deferred step,
+// sessions scheduled by priority, rate limit and frame budget, traced
+// requests answered with their spans, the request (wake) and disconnect
+// callbacks; and over the Unix socket, with a
+// file descriptor passed along. IPCClient:
+// requests multiplexed on one connection, pooled connections passing a
+// deferred request, per-request timeouts and pushed notifications
+
+#include <gtest/gtest.h>
+#include "IPCServer.h"
+#include "IPCClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+using namespace pathview::ipc;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Runs ProcessMessages() on its own thread, as the GUI loop would
+class ServerFixture : public ::testing::Test {
+protected:
+    void StartServer(CommandHandler handler, const std::string& socketPath = "") {
+        server_ = std::make_unique<IPCServer>(std::move(handler));
+        server_->SetSocketPath(socketPath);
+        server_->SetRequestCallback([this]() { ++wakeups_; });
+        server_->SetDisconnectCallback([this](socket_t) { ++disconnects_; });
+        if (!server_->Start()) {
+            server_.reset();
+            return;
+        }
+        loop_ = std::thread([this]() {
+            while (running_) {
+                server_->ProcessMessages(5);
+            }
+        });
+    }
+
+    void TearDown() override {
+        running_ = false;
+        if (loop_.joinable()) {
+            loop_.join();
+        }
+        server_.reset();
+    }
+
+    static IPCRequest Request(int id, const std::string& method, json params = json::object()) {
+        IPCRequest request;
+        request.id = id;
+        request.method = method;
+        request.params = std::move(params);
+        return request;
+    }
+
+    std::unique_ptr<IPCServer> server_;
+    std::thread loop_;
+    std::atomic<bool> running_{true};
+    std::atomic<int> wakeups_{0};
+    std::atomic<int> disconnects_{0};
+};
+
+}  // namespace
+
+// Well past the five clients select() used to allow
+TEST_F(ServerFixture, ServesManyClientsAtOnce) {
+    StartServer([](const std::string&, const json& params) { return json{{"n", params["n"]}}; });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+
+    const int clientCount = 20;
+    std::vector<std::unique_ptr<IPCClient>> clients;
+    for (int i = 0; i < clientCount; ++i) {
+        clients.push_back(std::make_unique<IPCClient>(server_->GetPort()));
+        ASSERT_TRUE(clients.back()->Connect());
+    }
+
+    std::vector<std::thread> threads;
+    std::atomic<int> answered{0};
+    for (int i = 0; i < clientCount; ++i) {
+        threads.emplace_back([&, i]() {
+            IPCResponse response = clients[i]->SendRequest(Request(1, "echo", {{"n", i}}));
+            if (response.result && (*response.result)["n"] == i) {
+                ++answered;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(answered.load(), clientCount);
+    EXPECT_GT(wakeups_.load(), 0);
+
+    clients.clear();
+    for (int i = 0; i < 200 && disconnects_.load() < clientCount; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(disconnects_.load(), clientCount);
+}
+
+// A deferred request holds back that client's later ones, not other clients
+TEST_F(ServerFixture, DeferredRequestHoldsBackOnlyItsClient) {
+    std::promise<json> slow;
+    std::atomic<bool> slowReceived{false};
+    std::atomic<bool> slowAnswered{false};
+    std::atomic<bool> afterSlowHandled{false};
+    std::atomic<bool> afterSlowHandledEarly{false};
+    IPCServer* server = nullptr;
+    StartServer([&](const std::string& method, const json&) {
+        if (method == "slow") {
+            server->Defer(slow.get_future());
+            slowReceived = true;
+            return json();
+        }
+        if (method == "after_slow") {
+            afterSlowHandledEarly = !slowAnswered;
+            afterSlowHandled = true;
+        }
+        return json{{"method", method}};
+    });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+    server = server_.get();
+
+    IPCClient pipelined(server_->GetPort());
+    IPCClient other(server_->GetPort());
+    ASSERT_TRUE(pipelined.Connect());
+    ASSERT_TRUE(other.Connect());
+
+    auto batch = std::async(std::launch::async, [&]() {
+        return pipelined.SendRequests({Request(1, "slow"), Request(2, "after_slow")});
+    });
+    for (int i = 0; i < 400 && !slowReceived; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_TRUE(slowReceived.load());
+
+    // Other clients are served meanwhile
+    IPCResponse response = other.SendRequest(Request(3, "ping"));
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["method"], "ping");
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(afterSlowHandled.load());
+
+    slowAnswered = true;
+    slow.set_value(json{{"done", true}});
+    std::vector<IPCResponse> responses = batch.get();
+    ASSERT_EQ(responses.size(), 2u);
+    ASSERT_TRUE(responses[0].result.has_value());
+    EXPECT_EQ((*responses[0].result)["done"], true);
+    ASSERT_TRUE(responses[1].result.has_value());
+    EXPECT_EQ((*responses[1].result)["method"], "after_slow");
+    EXPECT_FALSE(afterSlowHandledEarly.load());
+}
+
+// A batch pipes results between steps and waits out a deferred one
+TEST_F(ServerFixture, BatchPipesResultsAcrossDeferredStep) {
+    std::promise<json> capture;
+    std::atomic<bool> captureReceived{false};
+    IPCServer* server = nullptr;
+    StartServer([&](const std::string& method, const json& params) {
+        if (method == "move") {
+            return json{{"token", "t" + std::to_string(params["x"].get<int>())}};
+        }
+        if (method == "capture") {
+            server->Defer(capture.get_future());
+            captureReceived = true;
+            return json();
+        }
+        if (method == "fail") {
+            throw std::runtime_error("failed");
+        }
+        return json{{"method", method}, {"params", params}};
+    });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+    server = server_.get();
+
+    IPCClient client(server_->GetPort());
+    ASSERT_TRUE(client.Connect());
+    auto batch = std::async(std::launch::async, [&]() {
+        return client.SendRequest(Request(1, "batch", {{"steps", {
+            {{"method", "move"}, {"params", {{"x", 7}}}},
+            {{"method", "capture"}},
+            {{"method", "echo"}, {"params", {{"token", "$0.token"}, {"width", "$prev.size.0"}, {"raw", "$$1"}}}},
+            {{"method", "fail"}},
+            {{"method", "echo"}}
+        }}}), 2000);
+    });
+    for (int i = 0; i < 400 && !captureReceived; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_TRUE(captureReceived.load());
+    capture.set_value(json{{"size", {640, 480}}});
+
+    IPCResponse response = batch.get();
+    ASSERT_TRUE(response.result.has_value());
+    const json& results = (*response.result)["results"];
+    ASSERT_EQ(results.size(), 4u);  // Stopped at the failing step
+    EXPECT_EQ(results[0]["result"]["token"], "t7");
+    EXPECT_EQ(results[1]["result"]["size"][1], 480);
+    EXPECT_EQ(results[2]["result"]["params"]["token"], "t7");
+    EXPECT_EQ(results[2]["result"]["params"]["width"], 640);
+    EXPECT_EQ(results[2]["result"]["params"]["raw"], "$1");
+    EXPECT_EQ(results[3]["error"], "failed");
+
+    // Unresolved references and nested batches fail their step only
+    response = client.SendRequest(Request(2, "batch", {{"continue_on_error", true}, {"steps", {
+        {{"method", "echo"}, {"params", {{"token", "$3.token"}}}},
+        {{"method", "batch"}},
+        {{"method", "echo"}}
+    }}}));
+    ASSERT_TRUE(response.result.has_value());
+    const json& after = (*response.result)["results"];
+    ASSERT_EQ(after.size(), 3u);
+    EXPECT_TRUE(after[0].contains("error"));
+    EXPECT_TRUE(after[1].contains("error"));
+    EXPECT_EQ(after[2]["result"]["method"], "echo");
+}
+
+// Driven from the test thread: one request per call on a tiny budget
+TEST_F(ServerFixture, SchedulesSessionsByPriorityAndRateLimit) {
+    std::mutex mutex;
+    std::vector<std::string> order;
+    server_ = std::make_unique<IPCServer>([&](const std::string& method, const json& params) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(method);
+        return json{{"session_id", params.value("session_id", std::string())}};
+    });
+    server_->SetSocketPath("");
+    if (!server_->Start()) {
+        server_.reset();
+        GTEST_SKIP() << "IPC port in use";
+    }
+    server_->SetRateLimit(RequestPriority::Background, {1.0, 2.0});
+    auto process = [&](std::future<IPCResponse>& reply) {
+        for (int i = 0; i < 200 && reply.wait_for(0ms) != std::future_status::ready; ++i) {
+            server_->ProcessMessages(5);
+        }
+        return reply.get();
+    };
+
+    IPCClient background(server_->GetPort()), normal(server_->GetPort()), interactive(server_->GetPort());
+    ASSERT_TRUE(background.Connect());
+    ASSERT_TRUE(normal.Connect());
+    ASSERT_TRUE(interactive.Connect());
+    auto hello = background.SendRequestAsync(Request(1, "session.hello", {{"session_id", "bg"}, {"priority", "background"}}));
+    EXPECT_EQ((*process(hello).result)["priority"], "background");
+    hello = interactive.SendRequestAsync(Request(1, "session.hello", {{"session_id", "ui"}, {"priority", "interactive"}}));
+    EXPECT_EQ((*process(hello).result)["priority"], "interactive");
+
+    // The hello ran before the session was background: two run, the rest wait
+    std::vector<std::future<IPCResponse>> held;
+    for (int i = 0; i < 4; ++i) {
+        held.push_back(background.SendRequestAsync(Request(2 + i, "background")));
+    }
+    auto first = normal.SendRequestAsync(Request(1, "normal"));
+    EXPECT_TRUE(process(first).result.has_value());
+    for (int i = 0; i < 20; ++i) {
+        server_->ProcessMessages(5);
+    }
+    EXPECT_EQ(held[1].wait_for(0ms), std::future_status::ready);
+    EXPECT_NE(held[2].wait_for(0ms), std::future_status::ready);
+
+    IPCServer::Stats stats = server_->GetStats();
+    EXPECT_EQ(stats.queued, 2u);
+    EXPECT_EQ(stats.throttled, 1u);  // Once per request, however long it waits
+    EXPECT_EQ(stats.executed, 5u);
+    ASSERT_EQ(stats.sessions.size(), 3u);
+    for (const IPCServer::SessionStats& session : stats.sessions) {
+        if (session.session == "bg") {
+            EXPECT_EQ(session.priority, RequestPriority::Background);
+            EXPECT_EQ(session.queued, 2u);
+            EXPECT_EQ(session.executed, 3u);
+        }
+    }
+
+    // Both queued before one call that has budget for one: the interactive
+    // session's goes first
+    server_->SetRateLimit(RequestPriority::Background, {});
+    server_->SetFrameBudget(1us);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.clear();
+    }
+    auto later = normal.SendRequestAsync(Request(2, "normal"));
+    auto urgent = interactive.SendRequestAsync(Request(2, "interactive"));
+    std::this_thread::sleep_for(50ms);
+    server_->ProcessMessages(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(order.size(), 1u);
+        EXPECT_EQ(order[0], "interactive");
+    }
+    EXPECT_GE(server_->GetStats().overBudget, 1u);
+    process(later);
+    process(urgent);
+    for (auto& reply : held) {
+        EXPECT_TRUE(process(reply).result.has_value());
+    }
+    EXPECT_EQ(server_->GetStats().queued, 0u);
+}
+
+// A traced request comes back with the server's spans and the deferred
+// job's, which merge with the caller's into one Chrome trace
+TEST_F(ServerFixture, TracedRequestReturnsSpans) {
+    IPCServer* server = nullptr;
+    StartServer([&](const std::string& method, const json&) {
+        if (method == "encode") {
+            std::shared_ptr<RequestTrace> trace = server->GetCurrentTrace();
+            server->Defer(std::async(std::launch::async, [trace]() {
+                RequestTrace::Scope span(trace.get(), "job.encode");
+                std::this_thread::sleep_for(2ms);
+                return json{{"done", true}};
+            }));
+        }
+        return json();
+    });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+    server = server_.get();
+
+    IPCClient client(server_->GetPort());
+    ASSERT_TRUE(client.Connect());
+    EXPECT_FALSE(client.SendRequest(Request(1, "encode")).trace.has_value());
+
+    RequestTrace trace(RequestTrace::NewId(), "client");
+    ASSERT_EQ(trace.GetId().size(), 32u);
+    IPCRequest request = Request(2, "encode");
+    request.traceId = trace.GetId();
+    RequestTrace::Scope roundTrip(&trace, "ipc.round_trip");
+    IPCResponse response = client.SendRequest(request);
+    roundTrip.End();
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["done"], true);
+    ASSERT_TRUE(response.trace.has_value());
+
+    trace.Merge(*response.trace);
+    std::vector<std::string> names;
+    for (const RequestTrace::Span& span : trace.GetSpans()) {
+        names.push_back(span.name);
+        EXPECT_EQ(span.process, span.name == "ipc.round_trip" ? "client" : IPCServer::TRACE_PROCESS);
+    }
+    for (const char* name : {"ipc.round_trip", "ipc.queue", "encode", "job.encode", "ipc.deferred"}) {
+        EXPECT_NE(std::find(names.begin(), names.end(), name), names.end()) << name;
+    }
+
+    // A pid per process, each named once
+    const json chrome = trace.ToChromeTrace();
+    int processNames = 0;
+    for (const json& event : chrome["traceEvents"]) {
+        processNames += event["ph"] == "M";
+        if (event["name"] == "job.encode") {
+            EXPECT_GE(event["dur"].get<int64_t>(), 2000);
+        }
+    }
+    EXPECT_EQ(processNames, 2);
+    EXPECT_EQ(chrome["otherData"]["trace_id"], trace.GetId());
+}
+
+// Threads share one connection; each gets its own answer
+TEST_F(ServerFixture, ClientMultiplexesConcurrentRequests) {
+    StartServer([](const std::string&, const json& params) { return json{{"n", params["n"]}}; });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+
+    IPCClient client(server_->GetPort());
+    ASSERT_TRUE(client.Connect());
+    std::vector<std::thread> threads;
+    std::atomic<int> answered{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 25; ++j) {
+                const int n = i * 100 + j;
+                IPCResponse response = client.SendRequest(Request(n, "echo", {{"n", n}}));
+                if (response.id == n && response.result && (*response.result)["n"] == n) {
+                    ++answered;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(answered.load(), 8 * 25);
+}
+
+// A deferred request holds back its connection; the pool routes around it,
+// and a request that times out does not break the connection
+TEST_F(ServerFixture, ClientPoolPassesDeferredRequest) {
+    std::promise<json> slow;
+    std::atomic<bool> slowReceived{false};
+    IPCServer* server = nullptr;
+    StartServer([&](const std::string& method, const json&) {
+        if (method == "slow") {
+            server->Defer(slow.get_future());
+            slowReceived = true;
+            return json();
+        }
+        return json{{"method", method}};
+    });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+    server = server_.get();
+
+    IPCClient client(server_->GetPort());
+    client.SetPoolSize(2);
+    ASSERT_TRUE(client.Connect());
+
+    std::future<IPCResponse> slowResponse = client.SendRequestAsync(Request(1, "slow"), 5000);
+    for (int i = 0; i < 400 && !slowReceived; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    ASSERT_TRUE(slowReceived.load());
+
+    // Behind the slow one on the first connection: times out
+    std::future<IPCResponse> held = client.SendRequestAsync(Request(2, "held"), 100);
+    EXPECT_THROW(held.get(), std::runtime_error);
+
+    // Any connection: the idle one answers meanwhile
+    IPCResponse response = client.SendRequest(Request(3, "ping"), 2000, true);
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["method"], "ping");
+    EXPECT_EQ(response.id, 3);
+
+    slow.set_value(json{{"done", true}});
+    response = slowResponse.get();
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["done"], true);
+
+    // The timed-out request's late answer is skipped
+    response = client.SendRequest(Request(4, "after"));
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["method"], "after");
+    EXPECT_TRUE(client.IsConnected());
+}
+
+// Notifications reach the client's handler, in order with its responses
+TEST_F(ServerFixture, NotifiesSubscribedClient) {
+    std::atomic<bool> unknownNotified{true};
+    IPCServer* server = nullptr;
+    StartServer([&](const std::string& method, const json&) {
+        if (method == "notify_me") {
+            unknownNotified = server->Notify(INVALID_SOCKET_VALUE, "event.test", json::object());
+            server->Notify(server->GetCurrentClientFd(), "event.test", {{"n", 1}});
+            server->Notify(server->GetCurrentClientFd(), "event.test", {{"n", 2}});
+        }
+        return json{{"method", method}};
+    });
+    if (!server_) GTEST_SKIP() << "IPC port in use";
+    server = server_.get();
+
+    std::mutex mutex;
+    std::vector<int> received;
+    IPCClient client(server_->GetPort());
+    client.SetNotificationHandler([&](const std::string& method, const json& params) {
+        if (method == "event.test") {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(params["n"].get<int>());
+        }
+    });
+    ASSERT_TRUE(client.Connect());
+
+    IPCResponse response = client.SendRequest(Request(1, "notify_me"));
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_FALSE(unknownNotified.load());
+    {
+        // Sent ahead of the response, so already handled
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(received, (std::vector<int>{1, 2}));
+    }
+
+    // Pushed while no request is waiting
+    std::this_thread::sleep_for(20ms);
+    response = client.SendRequest(Request(2, "notify_me"));
+    ASSERT_TRUE(response.result.has_value());
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(received.size(), 4u);
+}
+
+#ifndef _WIN32
+// Another viewer may hold the TCP port: the Unix socket is enough
+TEST_F(ServerFixture, ServesUnixSocketAndPassesDescriptors) {
+    const std::string socketPath = "/tmp/pathview-test-" + std::to_string(getpid()) + ".sock";
+    StartServer([&](const std::string& method, const json&) {
+        if (method == "pipe") {
+            // Hand over the read end of a pipe holding one byte
+            int fds[2];
+            if (pipe(fds) != 0 || write(fds[1], "x", 1) != 1) {
+                throw std::runtime_error("pipe failed");
+            }
+            const bool attached = server_->CanPassDescriptors() && server_->AttachDescriptor(fds[0]);
+            close(fds[0]);
+            close(fds[1]);
+            return json{{"attached", attached}};
+        }
+        return json{{"method", method}};
+    }, socketPath);
+    ASSERT_NE(server_, nullptr);
+    EXPECT_EQ(server_->GetSocketPath(), socketPath);
+
+    IPCClient client(socketPath);
+    ASSERT_TRUE(client.Connect());
+    IPCResponse response = client.SendRequest(Request(1, "ping"));
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["method"], "ping");
+    EXPECT_EQ(client.TakePassedFd(), -1);
+
+    response = client.SendRequest(Request(2, "pipe"));
+    ASSERT_TRUE(response.result.has_value());
+    EXPECT_EQ((*response.result)["attached"], true);
+    int fd = client.TakePassedFd();
+    ASSERT_GE(fd, 0);
+    char byte = 0;
+    EXPECT_EQ(read(fd, &byte, 1), 1);
+    EXPECT_EQ(byte, 'x');
+    close(fd);
+
+    // TCP clients cannot be passed descriptors
+    if (server_->GetPort() > 0) {
+        IPCClient tcp(server_->GetPort());
+        if (tcp.Connect()) {
+            response = tcp.SendRequest(Request(3, "pipe"));
+            ASSERT_TRUE(response.result.has_value());
+            EXPECT_EQ((*response.result)["attached"], false);
+        }
+    }
+
+    client.Disconnect();
+    running_ = false;
+    loop_.join();
+    server_.reset();
+    EXPECT_FALSE(std::filesystem::exists(socketPath));
+}
+#endif
@@ -0,0 +1,114 @@
+// LatencyHistogram Unit Tests
+// Tests for bucket precision, percentiles, concurrent recording and the
+// tile pipeline stage wrapper
+
+#include <gtest/gtest.h>
+#include "LatencyHistogram.h"
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Bucket Tests
+// ============================================================================
+
+TEST(LatencyHistogramTest, SmallValues_HaveExactBuckets) {
+    for (uint64_t v = 0; v < LatencyHistogram::SUB_BUCKETS; ++v) {
+        size_t index = LatencyHistogram::BucketIndex(v);
+        EXPECT_EQ(LatencyHistogram::BucketLowerBound(index), v);
+        EXPECT_EQ(LatencyHistogram::BucketWidth(index), 1u);
+    }
+}
+
+TEST(LatencyHistogramTest, LargeValues_StayWithinRelativePrecision) {
+    for (uint64_t v : {17ull, 100ull, 1000ull, 123456ull, 98765432ull}) {
+        size_t index = LatencyHistogram::BucketIndex(v);
+        uint64_t lower = LatencyHistogram::BucketLowerBound(index);
+        uint64_t width = LatencyHistogram::BucketWidth(index);
+
+        EXPECT_LE(lower, v);
+        EXPECT_LT(v, lower + width);
+        EXPECT_LE(static_cast<double>(width) / lower, 1.0 / LatencyHistogram::SUB_BUCKETS);
+    }
+}
+
+TEST(LatencyHistogramTest, HugeValue_ClampsToLastBucket) {
+    EXPECT_EQ(LatencyHistogram::BucketIndex(UINT64_MAX), LatencyHistogram::BUCKET_COUNT - 1);
+}
+
+// ============================================================================
+// Percentile Tests
+// ============================================================================
+
+TEST(LatencyHistogramTest, Empty_ReportsZero) {
+    LatencyHistogram histogram;
+
+    EXPECT_EQ(histogram.GetCount(), 0u);
+    EXPECT_EQ(histogram.GetPercentile(0.5), 0u);
+    EXPECT_DOUBLE_EQ(histogram.GetMean(), 0.0);
+}
+
+TEST(LatencyHistogramTest, Percentiles_TrackDistribution) {
+    LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        histogram.Record(v);
+    }
+
+    EXPECT_EQ(histogram.GetCount(), 1000u);
+    EXPECT_EQ(histogram.GetMax(), 1000u);
+    EXPECT_DOUBLE_EQ(histogram.GetMean(), 500.5);
+    EXPECT_NEAR(static_cast<double>(histogram.GetPercentile(0.50)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(histogram.GetPercentile(0.99)), 990.0, 990.0 / 16);
+    EXPECT_LE(histogram.GetPercentile(1.0), histogram.GetMax());
+}
+
+TEST(LatencyHistogramTest, Reset_ClearsEverything) {
+    LatencyHistogram histogram;
+    histogram.Record(42);
+
+    histogram.Reset();
+
+    EXPECT_EQ(histogram.GetCount(), 0u);
+    EXPECT_EQ(histogram.GetMax(), 0u);
+    EXPECT_EQ(histogram.GetPercentile(0.99), 0u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecord_CountsEverySample) {
+    LatencyHistogram histogram;
+    constexpr int THREADS = 4;
+    constexpr int SAMPLES = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < SAMPLES; ++i) {
+                histogram.Record(static_cast<uint64_t>(t * 100 + i % 100));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(histogram.GetCount(), static_cast<uint64_t>(THREADS * SAMPLES));
+    EXPECT_EQ(histogram.GetMax(), static_cast<uint64_t>((THREADS - 1) * 100 + 99));
+}
+
+// ============================================================================
+// Pipeline Stats Tests
+// ============================================================================
+
+TEST(LatencyHistogramTest, PipelineStats_UnsetStart_IsSkipped) {
+    TilePipelineStats stats;
+
+    stats.RecordSince(TileStage::FirstDraw, TilePipelineStats::Clock::time_point{});
+    stats.RecordSince(TileStage::Decode, TilePipelineStats::Clock::now());
+
+    EXPECT_EQ(stats.Get(TileStage::FirstDraw).GetCount(), 0u);
+    EXPECT_EQ(stats.Get(TileStage::Decode).GetCount(), 1u);
+}
+
+TEST(LatencyHistogramTest, PipelineStats_StagesHaveNames) {
+    for (size_t i = 0; i < TilePipelineStats::STAGE_COUNT; ++i) {
+        EXPECT_STRNE(TilePipelineStats::StageName(static_cast<TileStage>(i)), "unknown");
+    }
+}
@@ -0,0 +1,196 @@
+// Log Unit Tests
+// Tests for the asynchronous log: lines reach the sink in order from one
+// thread and whole from many, levels filter at run time and compile time,
+// a full ring drops and reports lines, and rate limits hold lines back
+
+#include <gtest/gtest.h>
+#include "Log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Collects what the sink thread writes, and restores the log afterwards
+class LogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Log::Instance().Flush();
+        previousLevel_ = Log::Instance().GetLevel();
+        Log::Instance().SetSink([this](LogLevel level, const std::string& line) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.emplace_back(level, line);
+        });
+    }
+
+    void TearDown() override {
+        Log::Instance().Flush();
+        Log::Instance().SetSink(nullptr);
+        Log::Instance().SetLevel(previousLevel_);
+    }
+
+    std::vector<std::pair<LogLevel, std::string>> TakeLines() {
+        Log::Instance().Flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::move(lines_);
+    }
+
+    std::mutex mutex_;
+    std::vector<std::pair<LogLevel, std::string>> lines_;
+    LogLevel previousLevel_ = LogLevel::Info;
+};
+
+}  // namespace
+
+TEST_F(LogTest, Write_ReachesSinkInOrder) {
+    PATHVIEW_LOG_INFO("Loaded " << 42 << " tiles");
+    PATHVIEW_LOG_WARNING("Slow read");
+    PATHVIEW_LOG_ERROR("Failed: " << std::string("x.svs"));
+
+    auto lines = TakeLines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], std::make_pair(LogLevel::Info, std::string("Loaded 42 tiles")));
+    EXPECT_EQ(lines[1], std::make_pair(LogLevel::Warning, std::string("Slow read")));
+    EXPECT_EQ(lines[2], std::make_pair(LogLevel::Error, std::string("Failed: x.svs")));
+}
+
+TEST_F(LogTest, Write_CutsLongLines) {
+    Log::Instance().Write(LogLevel::Info, std::string(Log::MAX_LINE_BYTES + 100, 'a'));
+    auto lines = TakeLines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].second, std::string(Log::MAX_LINE_BYTES, 'a'));
+}
+
+TEST_F(LogTest, Levels_FilterAtRunTimeAndCompileTime) {
+    int evaluated = 0;
+    auto count = [&evaluated]() { return ++evaluated; };
+
+    // Debug lines are not compiled in below PATHVIEW_LOG_MIN_LEVEL 0
+    PATHVIEW_LOG_DEBUG("debug " << count());
+    EXPECT_EQ(evaluated, PATHVIEW_LOG_MIN_LEVEL <= 0 ? 1 : 0);
+
+    Log::Instance().SetLevel(LogLevel::Warning);
+    evaluated = 0;
+    PATHVIEW_LOG_INFO("info " << count());
+    PATHVIEW_LOG_WARNING("warning " << count());
+    EXPECT_EQ(evaluated, 1);  // The message of a disabled level is not built
+
+    auto lines = TakeLines();
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ(lines.back(), std::make_pair(LogLevel::Warning, std::string("warning 1")));
+    for (const auto& line : lines) {
+        EXPECT_NE(line.first, LogLevel::Info);
+    }
+}
+
+TEST_F(LogTest, ManyThreads_EveryLineWhole) {
+    constexpr int THREADS = 8;
+    constexpr int LINES = 100;  // Fewer than CAPACITY in all: none dropped
+    const uint64_t droppedBefore = Log::Instance().GetDroppedCount();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < LINES; ++i) {
+                PATHVIEW_LOG_INFO("thread " << t << " line " << i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    auto lines = TakeLines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(THREADS * LINES));
+    EXPECT_EQ(Log::Instance().GetDroppedCount(), droppedBefore);
+
+    // Each thread's lines whole and in its own order
+    std::vector<int> next(THREADS, 0);
+    for (const auto& line : lines) {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(std::sscanf(line.second.c_str(), "thread %d line %d", &t, &i), 2) << line.second;
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, THREADS);
+        EXPECT_EQ(i, next[t]++);
+    }
+}
+
+TEST_F(LogTest, FullRing_DropsAndReports) {
+    // Hold the sink thread inside the sink while the ring fills
+    std::mutex gateMutex;
+    std::condition_variable gate;
+    bool blocked = false;
+    bool open = false;
+    Log::Instance().SetSink([&](LogLevel level, const std::string& line) {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        if (!open) {
+            blocked = true;
+            gate.notify_all();
+            gate.wait(lock, [&] { return open; });
+        }
+        std::lock_guard<std::mutex> linesLock(mutex_);
+        lines_.emplace_back(level, line);
+    });
+
+    PATHVIEW_LOG_INFO("first");
+    {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        gate.wait(lock, [&] { return blocked; });
+    }
+    const uint64_t droppedBefore = Log::Instance().GetDroppedCount();
+    for (size_t i = 0; i < Log::CAPACITY + 10; ++i) {
+        PATHVIEW_LOG_INFO("line " << i);
+    }
+    EXPECT_EQ(Log::Instance().GetDroppedCount() - droppedBefore, 10u);
+
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        open = true;
+    }
+    gate.notify_all();
+
+    // The count is reported with the next line written after the drops
+    auto lines = TakeLines();
+    Log::Instance().SetSink(nullptr);
+    ASSERT_EQ(lines.size(), 2 + Log::CAPACITY);
+    EXPECT_EQ(lines[0].second, "first");
+    EXPECT_EQ(lines[1].first, LogLevel::Warning);
+    EXPECT_NE(lines[1].second.find("10 lines dropped"), std::string::npos);
+    EXPECT_EQ(lines[2].second, "line 0");
+    EXPECT_EQ(lines.back().second, "line " + std::to_string(Log::CAPACITY - 1));
+}
+
+TEST(LogRateLimitTest, Allow_OncePerIntervalAndCountsHeldBack) {
+    LogRateLimit limit(60000);
+    uint64_t suppressed = 99;
+    EXPECT_TRUE(limit.Allow(suppressed));
+    EXPECT_EQ(suppressed, 0u);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_FALSE(limit.Allow(suppressed));
+    }
+
+    LogRateLimit always(0);
+    EXPECT_TRUE(always.Allow(suppressed));
+    EXPECT_TRUE(always.Allow(suppressed));
+    EXPECT_EQ(suppressed, 0u);
+}
+
+TEST_F(LogTest, EveryMs_SaysHowManyWereHeldBack) {
+    auto logFrame = [](int frame) { PATHVIEW_LOG_EVERY_MS(LogLevel::Info, 200, "frame " << frame); };
+    for (int frame = 0; frame < 3; ++frame) {
+        logFrame(frame);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    logFrame(3);
+
+    auto lines = TakeLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].second, "frame 0");
+    EXPECT_EQ(lines[1].second, "frame 3 (2 similar suppressed)");
+}
@@ -0,0 +1,137 @@
+// MemoryRegistry Unit Tests
+// Tests for per-subsystem live/peak accounting and budget enforcement
+
+#include <gtest/gtest.h>
+#include "MemoryRegistry.h"
+#include <algorithm>
+
+// ============================================================================
+// Accounting Tests
+// ============================================================================
+
+TEST(MemoryRegistryTest, Update_PollsEntriesInRegistrationOrder) {
+    MemoryRegistry registry;
+    size_t a = 100;
+    size_t b = 50;
+    registry.Register("A", [&]() { return a; });
+    registry.Register("B", [&]() { return b; });
+
+    registry.Update();
+
+    const auto& entries = registry.GetEntries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].name, "A");
+    EXPECT_EQ(entries[0].liveBytes, 100u);
+    EXPECT_EQ(entries[1].name, "B");
+    EXPECT_EQ(entries[1].liveBytes, 50u);
+    EXPECT_FALSE(entries[0].reclaimable);
+    EXPECT_EQ(registry.GetTotalBytes(), 150u);
+}
+
+TEST(MemoryRegistryTest, Peaks_KeepHighWaterMarks) {
+    MemoryRegistry registry;
+    size_t a = 300;
+    size_t b = 0;
+    registry.Register("A", [&]() { return a; });
+    registry.Register("B", [&]() { return b; });
+
+    registry.Update();
+    a = 100;
+    b = 250;
+    registry.Update();
+
+    const auto& entries = registry.GetEntries();
+    EXPECT_EQ(entries[0].liveBytes, 100u);
+    EXPECT_EQ(entries[0].peakBytes, 300u);
+    EXPECT_EQ(entries[1].peakBytes, 250u);
+    EXPECT_EQ(registry.GetPeakTotalBytes(), 350u);
+}
+
+TEST(MemoryRegistryTest, GetProcessResidentBytes_IsNonZero) {
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+    EXPECT_GT(MemoryRegistry::GetProcessResidentBytes(), 0u);
+#endif
+}
+
+// ============================================================================
+// Budget Tests
+// ============================================================================
+
+TEST(MemoryRegistryTest, NoBudget_NeverReclaims) {
+    MemoryRegistry registry;
+    size_t cache = 1000;
+    int calls = 0;
+    registry.Register("Cache", [&]() { return cache; },
+                      [&](size_t) { calls++; return size_t{0}; });
+
+    registry.Update();
+
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(registry.GetPressureEventCount(), 0u);
+}
+
+TEST(MemoryRegistryTest, OverBudget_ReclaimsInOrderUntilWithinBudget) {
+    MemoryRegistry registry;
+    size_t first = 100;
+    size_t second = 500;
+    size_t fixed = 200;
+    size_t secondRequest = 0;
+    registry.Register("First", [&]() { return first; },
+                      [&](size_t) { size_t freed = first; first = 0; return freed; });
+    registry.Register("Fixed", [&]() { return fixed; });
+    registry.Register("Second", [&]() { return second; },
+                      [&](size_t bytes) {
+                          secondRequest = bytes;
+                          size_t freed = std::min(bytes, second);
+                          second -= freed;
+                          return freed;
+                      });
+    registry.SetBudget(600);
+
+    registry.Update();
+
+    // First gives back everything, Second only what is still over
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(secondRequest, 100u);
+    EXPECT_EQ(registry.GetTotalBytes(), 600u);
+    EXPECT_EQ(registry.GetReclaimedBytes(), 200u);
+    EXPECT_EQ(registry.GetPressureEventCount(), 1u);
+    EXPECT_EQ(registry.GetPeakTotalBytes(), 800u);
+}
+
+TEST(MemoryRegistryTest, OverBudget_StopsOnceFirstReclaimSuffices) {
+    MemoryRegistry registry;
+    size_t first = 500;
+    int secondCalls = 0;
+    registry.Register("First", [&]() { return first; },
+                      [&](size_t bytes) { first -= bytes; return bytes; });
+    registry.Register("Second", [&]() { return size_t{100}; },
+                      [&](size_t) { secondCalls++; return size_t{0}; });
+    registry.SetBudget(400);
+
+    registry.Update();
+
+    EXPECT_EQ(first, 300u);
+    EXPECT_EQ(secondCalls, 0);
+    EXPECT_EQ(registry.GetTotalBytes(), 400u);
+}
+
+TEST(MemoryRegistryTest, ReclaimGrowingAnotherEntry_IsSeenByRepoll) {
+    // Evicting tiles parks their buffers in the pool; the pool's reclaimer
+    // registered after the cache must see and free the moved bytes
+    MemoryRegistry registry;
+    size_t cache = 400;
+    size_t pool = 0;
+    registry.Register("Cache", [&]() { return cache; },
+                      [&](size_t bytes) { cache -= bytes; pool += bytes; return bytes; });
+    registry.Register("Pool", [&]() { return pool; },
+                      [&](size_t) { size_t freed = pool; pool = 0; return freed; });
+    registry.SetBudget(100);
+
+    registry.Update();
+
+    EXPECT_EQ(cache, 100u);
+    EXPECT_EQ(pool, 0u);
+    EXPECT_EQ(registry.GetTotalBytes(), 100u);
+    EXPECT_EQ(registry.GetReclaimedBytes(), 300u);
+}
@@ -0,0 +1,151 @@
+// MessageBuffer Unit Tests
+// Tests for reassembling IPC messages: split across reads, several per
+// read, CRLF, the size limit, and the binary (length-prefixed) encodings
+
+#include <gtest/gtest.h>
+#include "IPCMessage.h"
+#include <algorithm>
+#include <string>
+
+using namespace pathview::ipc;
+
+TEST(MessageBufferTest, ReassemblesSplitMessage) {
+    MessageBuffer buffer;
+    std::string message;
+    const std::string text = R"({"id":1,"method":"viewport.pan"})";
+
+    // One byte at a time, as the worst TCP segmentation would deliver it
+    for (char c : text) {
+        ASSERT_TRUE(buffer.Append(&c, 1));
+        EXPECT_FALSE(buffer.Next(message));
+    }
+    ASSERT_TRUE(buffer.Append("\n", 1));
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message, text);
+    EXPECT_FALSE(buffer.Next(message));
+    EXPECT_EQ(buffer.GetBufferedBytes(), 0u);
+}
+
+TEST(MessageBufferTest, SeveralMessagesInOneRead) {
+    MessageBuffer buffer;
+    const std::string data = "{\"id\":1}\n{\"id\":2}\r\n\n{\"id\":3";
+    ASSERT_TRUE(buffer.Append(data.data(), data.size()));
+
+    std::string message;
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message, "{\"id\":1}");
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message, "{\"id\":2}");  // CR dropped
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message, "");  // Blank line: callers skip it
+    EXPECT_FALSE(buffer.Next(message));
+
+    // The unfinished third survives compaction on the next append
+    ASSERT_TRUE(buffer.Append("}\n", 2));
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message, "{\"id\":3}");
+}
+
+// Well past the 64KB the server used to read in one go
+TEST(MessageBufferTest, LargeMessage) {
+    MessageBuffer buffer;
+    std::string vertices(3 * 1024 * 1024, 'x');
+    const size_t chunk = 65536;
+    for (size_t offset = 0; offset < vertices.size(); offset += chunk) {
+        ASSERT_TRUE(buffer.Append(vertices.data() + offset, std::min(chunk, vertices.size() - offset)));
+    }
+    buffer.Append("\n", 1);
+
+    std::string message;
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(message.size(), vertices.size());
+}
+
+TEST(MessageBufferTest, RejectsUnterminatedOversizedMessage) {
+    MessageBuffer buffer;
+    std::string chunk(1024 * 1024, 'x');
+    bool accepted = true;
+    for (size_t total = 0; accepted && total <= MessageBuffer::MAX_MESSAGE_BYTES; total += chunk.size()) {
+        accepted = buffer.Append(chunk.data(), chunk.size());
+    }
+    EXPECT_FALSE(accepted);
+}
+
+// A hello switching to MessagePack, then binary messages behind it in the
+// same read: the switch applies from the next message on
+TEST(MessageBufferTest, SwitchesToLengthPrefixedFraming) {
+    MessageBuffer buffer;
+    json second = {{"id", 2}, {"method", "viewport.pan"}, {"params", {{"dx", 1.5}}}};
+    json third = {{"id", 3}, {"params", {{"png", json::binary({0x89, 'P', '\n', 0})}}}};
+    std::string data = EncodeMessage({{"id", 1}, {"method", "session.hello"}}, WireEncoding::Json) +
+                       EncodeMessage(second, WireEncoding::MessagePack) +
+                       EncodeMessage(third, WireEncoding::MessagePack);
+
+    std::string message;
+    ASSERT_TRUE(buffer.Append(data.data(), 3));
+    ASSERT_TRUE(buffer.Append(data.data() + 3, data.size() - 3));
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(DecodeMessage(message, WireEncoding::Json)["method"], "session.hello");
+
+    buffer.SetEncoding(WireEncoding::MessagePack);
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(DecodeMessage(message, WireEncoding::MessagePack), second);
+    ASSERT_TRUE(buffer.Next(message));
+    EXPECT_EQ(DecodeMessage(message, WireEncoding::MessagePack), third);  // Newline inside is just a byte
+    EXPECT_FALSE(buffer.Next(message));
+}
+
+TEST(MessageBufferTest, RejectsOversizedLengthPrefix) {
+    MessageBuffer buffer;
+    buffer.SetEncoding(WireEncoding::Cbor);
+    const char prefix[] = {0x7F, 0x00, 0x00, 0x00};
+    EXPECT_FALSE(buffer.Append(prefix, sizeof(prefix)));
+}
+
+// Json connections see binary values as base64, exactly as before
+TEST(MessageBufferTest, JsonEncodesBinaryAsBase64) {
+    json message = {{"result", {{"png_data", json::binary({'a', 'b', 'c', 'd'})}}}};
+    std::string line = EncodeMessage(message, WireEncoding::Json);
+    ASSERT_EQ(line.back(), '\n');
+    EXPECT_EQ(DecodeMessage(line.substr(0, line.size() - 1), WireEncoding::Json)["result"]["png_data"], "YWJjZA==");
+}
+
+TEST(MessageBufferTest, PackedDoublesRoundTrip) {
+    std::vector<double> values = {0.0, -1.25, 123456.789, 1e-300};
+    json packed = PackDoubles(values);
+    ASSERT_TRUE(packed.is_binary());
+    EXPECT_EQ(packed.get_binary().size(), values.size() * sizeof(double));
+    EXPECT_EQ(packed.get_binary()[8 + 7], 0xBF);  // -1.25, little-endian: sign byte last
+    EXPECT_EQ(UnpackDoubles(packed), values);
+
+    // And through the wire
+    for (WireEncoding encoding : {WireEncoding::MessagePack, WireEncoding::Cbor}) {
+        std::string framed = EncodeMessage({{"vertices", packed}}, encoding);
+        json decoded = DecodeMessage(framed.substr(MessageBuffer::LENGTH_PREFIX_BYTES), encoding);
+        EXPECT_EQ(UnpackDoubles(decoded["vertices"]), values);
+    }
+    EXPECT_THROW(UnpackDoubles(json::array({1.0, 2.0})), std::runtime_error);
+}
+
+TEST(MessageBufferTest, PackedColumnsAreLittleEndian) {
+    json floats = PackFloats({1.0f, -2.0f});
+    ASSERT_EQ(floats.get_binary().size(), 8u);
+    EXPECT_EQ(floats.get_binary()[3], 0x3F);  // 1.0f = 0x3F800000
+    EXPECT_EQ(floats.get_binary()[7], 0xC0);  // -2.0f = 0xC0000000
+
+    json unsignedInts = PackUInt32s({0x01020304u});
+    const std::vector<uint8_t>& unsignedBytes = unsignedInts.get_binary();
+    EXPECT_EQ(unsignedBytes, std::vector<uint8_t>({0x04, 0x03, 0x02, 0x01}));
+
+    json signedInts = PackInt32s({-1, 2});
+    const std::vector<uint8_t>& signedBytes = signedInts.get_binary();
+    EXPECT_EQ(signedBytes, std::vector<uint8_t>({0xFF, 0xFF, 0xFF, 0xFF, 0x02, 0x00, 0x00, 0x00}));
+}
+
+TEST(MessageBufferTest, ParsesEncodingNames) {
+    EXPECT_EQ(ParseWireEncoding("json"), WireEncoding::Json);
+    EXPECT_EQ(ParseWireEncoding("msgpack"), WireEncoding::MessagePack);
+    EXPECT_EQ(ParseWireEncoding("cbor"), WireEncoding::Cbor);
+    EXPECT_FALSE(ParseWireEncoding("protobuf").has_value());
+    EXPECT_STREQ(WireEncodingName(WireEncoding::MessagePack), "msgpack");
+}
@@ -0,0 +1,67 @@
+// Metrics Unit Tests
+// Tests for the /metrics registry: counters, gauges and histograms in the
+// Prometheus text format, escaped labels, one series per name and label
+// however many threads look it up, and forwarded text
+
+#include <gtest/gtest.h>
+#include "../../src/api/http/Metrics.h"
+#include <thread>
+#include <vector>
+
+using namespace pathview::http;
+
+TEST(MetricsTest, RendersTextFormat) {
+    Metrics metrics;
+    metrics.Counter("pathview_requests_total", "Requests").Add(2);
+    metrics.Gauge("pathview_bytes", "Bytes held", "cache", "tile \"main\"").Set(1024);
+    Metrics::Series& latency = metrics.Histogram("pathview_seconds", "Latency", {0.1, 1.0});
+    latency.Observe(0.05);
+    latency.Observe(0.1);  // On a bound: that bucket
+    latency.Observe(5.0);
+
+    const std::string text = metrics.Render();
+    EXPECT_NE(text.find("# HELP pathview_requests_total Requests\n# TYPE pathview_requests_total counter\n"
+                        "pathview_requests_total 2\n"), std::string::npos);
+    EXPECT_NE(text.find("pathview_bytes{cache=\"tile \\\"main\\\"\"} 1024\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE pathview_seconds histogram\n"
+                        "pathview_seconds_bucket{le=\"0.10000000000000001\"} 2\n"
+                        "pathview_seconds_bucket{le=\"1\"} 2\n"
+                        "pathview_seconds_bucket{le=\"+Inf\"} 3\n"
+                        "pathview_seconds_sum 5.1500000000000004\n"
+                        "pathview_seconds_count 3\n"), std::string::npos);
+
+    // Replaced wholesale from a histogram kept elsewhere
+    latency.SetBuckets({1, 0, 4}, 9.0);
+    EXPECT_NE(metrics.Render().find("pathview_seconds_bucket{le=\"+Inf\"} 5\n"), std::string::npos);
+}
+
+TEST(MetricsTest, OneSeriesPerLabelAcrossThreads) {
+    Metrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&metrics, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                metrics.Histogram("pathview_ipc_request_seconds", "Latency", Metrics::LatencyBounds(),
+                                  "method", i % 2 ? "slide.info" : "viewport.pan")
+                    .Observe(0.001 * t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Grouped under one HELP / TYPE, each label counted once
+    const std::string text = metrics.Render();
+    EXPECT_EQ(text.find("# HELP pathview_ipc_request_seconds"), text.rfind("# HELP pathview_ipc_request_seconds"));
+    EXPECT_NE(text.find("pathview_ipc_request_seconds_count{method=\"slide.info\"} 4000\n"), std::string::npos);
+    EXPECT_NE(text.find("pathview_ipc_request_seconds_count{method=\"viewport.pan\"} 4000\n"), std::string::npos);
+}
+
+TEST(MetricsTest, AppendsForwardedText) {
+    Metrics metrics;
+    metrics.Gauge("pathview_mcp_up", "Up").Set(1);
+    metrics.SetForwarded("# TYPE pathview_frames gauge\npathview_frames 3\n");
+    const std::string text = metrics.Render();
+    EXPECT_LT(text.find("pathview_mcp_up 1"), text.find("pathview_frames 3"));
+}
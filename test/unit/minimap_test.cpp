@@ -0,0 +1,95 @@
+// Minimap Unit Tests
+// Tests for the overview box filter and building overviews from
+// thumbnails (no renderer needed)
+
+#include <gtest/gtest.h>
+#include "Minimap.h"
+#include <vector>
+
+namespace {
+
+uint32_t Gray(uint32_t value) {
+    return 0xFF000000u | (value << 16) | (value << 8) | value;
+}
+
+}  // namespace
+
+// ============================================================================
+// ResampleBox Tests
+// ============================================================================
+
+TEST(MinimapTest, ResampleBox_AveragesCoveredPixels) {
+    // 4x2 -> 2x1: each output pixel averages a 2x2 block
+    std::vector<uint32_t> src = {Gray(0), Gray(100), Gray(10), Gray(20),
+                                 Gray(200), Gray(100), Gray(30), Gray(40)};
+    std::vector<uint32_t> dst(2);
+    Minimap::ResampleBox(src.data(), 4, 2, 4, dst.data(), 2, 1, 2);
+    EXPECT_EQ(dst[0], Gray(100));
+    EXPECT_EQ(dst[1], Gray(25));
+}
+
+TEST(MinimapTest, ResampleBox_NonIntegerRatio_CoversEverySourcePixel) {
+    // 5 -> 2 columns: boxes [0, 2) and [2, 5)
+    std::vector<uint32_t> src = {Gray(10), Gray(20), Gray(30), Gray(60), Gray(90)};
+    std::vector<uint32_t> dst(2);
+    Minimap::ResampleBox(src.data(), 5, 1, 5, dst.data(), 2, 1, 2);
+    EXPECT_EQ(dst[0], Gray(15));
+    EXPECT_EQ(dst[1], Gray(60));
+}
+
+TEST(MinimapTest, ResampleBox_Premultiplied_AveragesAlphaToo) {
+    std::vector<uint32_t> src = {0xFF804020u, 0x00000000u};
+    std::vector<uint32_t> dst(1);
+    Minimap::ResampleBox(src.data(), 2, 1, 2, dst.data(), 1, 1, 1);
+    EXPECT_EQ(dst[0], 0x80402010u);
+}
+
+TEST(MinimapTest, ResampleBox_Enlarging_RepeatsNearest) {
+    std::vector<uint32_t> src = {Gray(1), Gray(2)};
+    std::vector<uint32_t> dst(4);
+    Minimap::ResampleBox(src.data(), 2, 1, 2, dst.data(), 4, 1, 4);
+    EXPECT_EQ(dst, (std::vector<uint32_t>{Gray(1), Gray(1), Gray(2), Gray(2)}));
+}
+
+TEST(MinimapTest, ResampleBox_RespectsStrides) {
+    // 2x2 source inside a 3-wide buffer, into a 1x1 slot of a 2-wide one
+    std::vector<uint32_t> src = {Gray(10), Gray(30), Gray(255),
+                                 Gray(50), Gray(70), Gray(255)};
+    std::vector<uint32_t> dst = {0, 0};
+    Minimap::ResampleBox(src.data(), 2, 2, 3, dst.data() + 1, 1, 1, 2);
+    EXPECT_EQ(dst[0], 0u);
+    EXPECT_EQ(dst[1], Gray(40));
+}
+
+// ============================================================================
+// OverviewFromImage Tests
+// ============================================================================
+
+TEST(MinimapTest, OverviewFromImage_LargeThumbnail_FitsMaxSize) {
+    std::vector<uint32_t> thumbnail(1000 * 500, Gray(128));
+    MinimapOverview overview;
+    ASSERT_TRUE(Minimap::OverviewFromImage(thumbnail, 1000, 500, 100000, 50000, overview));
+    EXPECT_EQ(overview.width, Minimap::MINIMAP_MAX_SIZE);
+    EXPECT_EQ(overview.height, Minimap::MINIMAP_MAX_SIZE / 2);
+    EXPECT_EQ(overview.pixels.size(), static_cast<size_t>(overview.width * overview.height));
+    EXPECT_EQ(overview.pixels[0], Gray(128));
+    EXPECT_FALSE(overview.exact);
+}
+
+TEST(MinimapTest, OverviewFromImage_SmallThumbnail_KeepsSize) {
+    std::vector<uint32_t> thumbnail(100 * 80, Gray(7));
+    MinimapOverview overview;
+    ASSERT_TRUE(Minimap::OverviewFromImage(thumbnail, 100, 80, 50000, 40000, overview));
+    EXPECT_EQ(overview.width, 100);
+    EXPECT_EQ(overview.height, 80);
+    EXPECT_EQ(overview.pixels, thumbnail);
+}
+
+TEST(MinimapTest, OverviewFromImage_MismatchedAspect_Rejected) {
+    // A macro photo of the whole glass is not the scanned area
+    std::vector<uint32_t> macro(300 * 100, Gray(1));
+    MinimapOverview overview;
+    EXPECT_FALSE(Minimap::OverviewFromImage(macro, 300, 100, 40000, 30000, overview));
+    EXPECT_FALSE(Minimap::OverviewFromImage(macro, 0, 0, 40000, 30000, overview));
+    EXPECT_FALSE(Minimap::OverviewFromImage(macro, 400, 100, 40000, 10000, overview));  // Too few pixels
+}
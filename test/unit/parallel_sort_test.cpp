@@ -0,0 +1,92 @@
+// ParallelSort Unit Tests
+// Tests for the bulk build steps: blocks covering the range once, a stable
+// scatter whatever the thread count, and the radix sort against std::sort
+
+#include <gtest/gtest.h>
+#include "ParallelSort.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+namespace {
+
+std::vector<uint64_t> RandomKeys(size_t count, uint64_t mask, uint32_t seed) {
+    std::mt19937_64 random(seed);
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys) {
+        key = random() & mask;
+    }
+    return keys;
+}
+
+}  // namespace
+
+TEST(ParallelSortTest, For_BlocksCoverRangeOnce) {
+    const size_t count = 5 * ParallelSort::MIN_BLOCK_SIZE + 7;
+    EXPECT_EQ(ParallelSort::BlockCount(count, 8), 5u);
+    EXPECT_EQ(ParallelSort::BlockCount(count, 2), 2u);
+    EXPECT_EQ(ParallelSort::BlockCount(10, 8), 1u);
+
+    std::vector<std::atomic<int>> visits(count);
+    ParallelSort::For(count, 8, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            visits[i]++;
+        }
+    });
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(visits[i].load(), 1) << i;
+    }
+}
+
+TEST(ParallelSortTest, Scatter_StableAndSameForAnyThreadCount) {
+    // Bucket in the low bits, position in the rest
+    const size_t count = 4 * ParallelSort::MIN_BLOCK_SIZE;
+    std::vector<uint64_t> keys(count);
+    std::mt19937 random(7);
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = (uint64_t(i) << 8) | (random() % 5);
+    }
+    auto bucketOf = [](uint64_t key) { return size_t(key & 0xFF); };
+
+    std::vector<uint64_t> serial, parallel;
+    const std::vector<size_t> starts = ParallelSort::Scatter(keys, serial, 5, bucketOf, 1);
+    ParallelSort::Scatter(keys, parallel, 5, bucketOf, 4);
+    EXPECT_EQ(serial, parallel);
+
+    ASSERT_EQ(starts.size(), 6u);
+    EXPECT_EQ(starts.front(), 0u);
+    EXPECT_EQ(starts.back(), count);
+    for (size_t bucket = 0; bucket < 5; ++bucket) {
+        for (size_t i = starts[bucket]; i < starts[bucket + 1]; ++i) {
+            ASSERT_EQ(bucketOf(serial[i]), bucket);
+            if (i > starts[bucket]) {
+                ASSERT_LT(serial[i - 1], serial[i]);
+            }
+        }
+    }
+}
+
+TEST(ParallelSortTest, RadixSort_MatchesStdSort) {
+    // Full keys, keys with constant digits (skipped passes), and a small
+    // input sorted directly
+    const uint64_t masks[] = {~uint64_t(0), 0x0000FFFF0000FFFFull, 0xFFFF000000000000ull};
+    for (uint64_t mask : masks) {
+        for (size_t threads : {size_t(1), size_t(3), size_t(0)}) {
+            std::vector<uint64_t> keys = RandomKeys(200000, mask, 11);
+            std::vector<uint64_t> expected = keys;
+            std::sort(expected.begin(), expected.end());
+            ParallelSort::RadixSort(keys, threads);
+            ASSERT_EQ(keys, expected) << std::hex << mask << " on " << threads << " threads";
+        }
+    }
+
+    std::vector<uint64_t> small = RandomKeys(100, ~uint64_t(0), 3);
+    std::vector<uint64_t> expected = small;
+    std::sort(expected.begin(), expected.end());
+    ParallelSort::RadixSort(small);
+    EXPECT_EQ(small, expected);
+
+    std::vector<uint64_t> empty;
+    ParallelSort::RadixSort(empty);
+    EXPECT_TRUE(empty.empty());
+}
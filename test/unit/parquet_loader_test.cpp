@@ -0,0 +1,263 @@
+// ParquetPolygonLoader Unit Tests
+// Tests for Parquet cell tables: WKB polygon decoding (byte orders, Z
+// ordinates, holes, multipolygons, truncation), row group pruning by
+// statistics against the filter, and, when built with Apache Arrow, loading
+// a written table with class, confidence and region filters pushed down.
+
+#include <gtest/gtest.h>
+#include "ParquetPolygonLoader.h"
+#include "PolygonStore.h"
+#include "WkbReader.h"
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// WKB writer for the tests, either byte order
+class Wkb {
+public:
+    explicit Wkb(bool bigEndian = false) : bigEndian_(bigEndian) {}
+
+    Wkb& Header(uint32_t type) {
+        bytes_.push_back(bigEndian_ ? 0 : 1);
+        return Uint32(type);
+    }
+    Wkb& Uint32(uint32_t value) { return Put(&value, 4); }
+    Wkb& Double(double value) { return Put(&value, 8); }
+
+    // A polygon of closed rings, ordinates values per point
+    Wkb& Polygon(const std::vector<std::vector<double>>& rings, uint32_t type = 3, int ordinates = 2) {
+        Header(type).Uint32(static_cast<uint32_t>(rings.size()));
+        for (const auto& ring : rings) {
+            Uint32(static_cast<uint32_t>(ring.size() / ordinates));
+            for (double value : ring) {
+                Double(value);
+            }
+        }
+        return *this;
+    }
+
+    const std::vector<uint8_t>& Bytes() const { return bytes_; }
+
+private:
+    Wkb& Put(const void* value, size_t size) {
+        uint8_t buffer[8];
+        std::memcpy(buffer, value, size);
+        for (size_t i = 0; i < size; ++i) {
+            bytes_.push_back(buffer[bigEndian_ ? size - 1 - i : i]);
+        }
+        return *this;
+    }
+
+    bool bigEndian_;
+    std::vector<uint8_t> bytes_;
+};
+
+std::vector<double> Square(double x, double y, double size) {
+    return {x, y, x + size, y, x + size, y + size, x, y + size, x, y};
+}
+
+}  // namespace
+
+// ============================================================================
+// WKB Tests
+// ============================================================================
+
+TEST(WkbReaderTest, Polygon_KeepsExteriorRingWithoutClosingPoint) {
+    for (bool bigEndian : {false, true}) {
+        Wkb wkb(bigEndian);
+        wkb.Polygon({Square(10, 20, 5), Square(11, 21, 1)});
+        std::vector<double> xy;
+        std::vector<uint32_t> ringEnds;
+        ASSERT_TRUE(WkbReader::ReadPolygons(wkb.Bytes().data(), wkb.Bytes().size(), xy, ringEnds));
+        EXPECT_EQ(ringEnds, (std::vector<uint32_t>{4}));
+        EXPECT_EQ(xy, (std::vector<double>{10, 20, 15, 20, 15, 25, 10, 25}));
+    }
+}
+
+TEST(WkbReaderTest, MultiPolygonAndZ_OneRingPerPart) {
+    // ISO Polygon Z (1003): z dropped
+    std::vector<double> withZ = {0, 0, 7, 4, 0, 7, 4, 4, 7, 0, 0, 7};
+    Wkb wkb;
+    wkb.Header(6).Uint32(2);
+    wkb.Polygon({withZ}, 1003, 3);
+    wkb.Polygon({Square(10, 10, 2)});
+    std::vector<double> xy;
+    std::vector<uint32_t> ringEnds;
+    ASSERT_TRUE(WkbReader::ReadPolygons(wkb.Bytes().data(), wkb.Bytes().size(), xy, ringEnds));
+    EXPECT_EQ(ringEnds, (std::vector<uint32_t>{3, 7}));
+    EXPECT_DOUBLE_EQ(xy[2], 4.0);
+    EXPECT_DOUBLE_EQ(xy[3], 0.0);
+}
+
+TEST(WkbReaderTest, TruncatedOrOtherGeometry) {
+    Wkb wkb;
+    wkb.Polygon({Square(0, 0, 1)});
+    std::vector<double> xy;
+    std::vector<uint32_t> ringEnds;
+    EXPECT_FALSE(WkbReader::ReadPolygons(wkb.Bytes().data(), wkb.Bytes().size() - 3, xy, ringEnds));
+    EXPECT_FALSE(WkbReader::ReadPolygons(wkb.Bytes().data(), 0, xy, ringEnds));
+
+    // A point has no polygon
+    Wkb point;
+    point.Header(1).Double(1).Double(2);
+    ASSERT_TRUE(WkbReader::ReadPolygons(point.Bytes().data(), point.Bytes().size(), xy, ringEnds));
+    EXPECT_TRUE(ringEnds.empty());
+}
+
+// ============================================================================
+// Row Group Pruning Tests
+// ============================================================================
+
+TEST(ParquetPolygonLoaderTest, MayMatch_PrunesByStatistics) {
+    ParquetPolygonLoader::RowGroupStats stats;
+    stats.hasBounds = true;
+    stats.bounds = Rect(0, 0, 100, 100);
+    stats.hasConfidence = true;
+    stats.maxConfidence = 0.6;
+    stats.hasClasses = true;
+    stats.minClass = "Lymphocyte";
+    stats.maxClass = "Stroma";
+
+    ParquetPolygonLoader::Filter filter;
+    EXPECT_TRUE(ParquetPolygonLoader::MayMatch(stats, filter));
+
+    filter.hasRegion = true;
+    filter.region = Rect(150, 0, 10, 10);
+    EXPECT_FALSE(ParquetPolygonLoader::MayMatch(stats, filter));
+    // Centroid statistics are widened by the margin
+    stats.boundsAreCentroids = true;
+    EXPECT_TRUE(ParquetPolygonLoader::MayMatch(stats, filter));
+    filter.hasRegion = false;
+
+    filter.minConfidence = 0.7f;
+    EXPECT_FALSE(ParquetPolygonLoader::MayMatch(stats, filter));
+    filter.minConfidence = 0.5f;
+    EXPECT_TRUE(ParquetPolygonLoader::MayMatch(stats, filter));
+
+    filter.classes = {"Tumor"};
+    EXPECT_FALSE(ParquetPolygonLoader::MayMatch(stats, filter));
+    filter.classes = {"Necrosis", "Tumor"};
+    EXPECT_TRUE(ParquetPolygonLoader::MayMatch(stats, filter));
+
+    // Missing statistics never prune
+    EXPECT_TRUE(ParquetPolygonLoader::MayMatch(ParquetPolygonLoader::RowGroupStats(), filter));
+}
+
+#ifdef PATHVIEW_HAS_PARQUET
+
+// ============================================================================
+// Load Tests (Apache Arrow builds)
+// ============================================================================
+
+class ParquetLoadTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_parquet_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    // A row of 10 pixel squares every 20 pixels along x, rowsPerGroup to a
+    // row group; classes alternate Stroma / Tumor, confidence climbs
+    std::string WriteCells(int count, int rowsPerGroup) {
+        arrow::BinaryBuilder geometry;
+        arrow::StringBuilder classes;
+        arrow::FloatBuilder confidence;
+        arrow::DoubleBuilder centroidX;
+        arrow::DoubleBuilder centroidY;
+        for (int i = 0; i < count; ++i) {
+            Wkb wkb;
+            wkb.Polygon({Square(20.0 * i, 0, 10)});
+            EXPECT_TRUE(geometry.Append(wkb.Bytes().data(), static_cast<int32_t>(wkb.Bytes().size())).ok());
+            EXPECT_TRUE(classes.Append(i % 2 == 0 ? "Stroma" : "Tumor").ok());
+            EXPECT_TRUE(confidence.Append(static_cast<float>(i) / count).ok());
+            EXPECT_TRUE(centroidX.Append(20.0 * i + 5).ok());
+            EXPECT_TRUE(centroidY.Append(5.0).ok());
+        }
+        std::vector<std::shared_ptr<arrow::Array>> arrays(5);
+        EXPECT_TRUE(geometry.Finish(&arrays[0]).ok());
+        EXPECT_TRUE(classes.Finish(&arrays[1]).ok());
+        EXPECT_TRUE(confidence.Finish(&arrays[2]).ok());
+        EXPECT_TRUE(centroidX.Finish(&arrays[3]).ok());
+        EXPECT_TRUE(centroidY.Finish(&arrays[4]).ok());
+        auto schema = arrow::schema({arrow::field("geometry", arrow::binary()), arrow::field("class", arrow::utf8()),
+                                     arrow::field("confidence", arrow::float32()),
+                                     arrow::field("centroid_x", arrow::float64()),
+                                     arrow::field("centroid_y", arrow::float64())});
+        std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, arrays);
+
+        std::string path = (root / "cells.parquet").string();
+        auto output = arrow::io::FileOutputStream::Open(path);
+        EXPECT_TRUE(output.ok());
+        EXPECT_TRUE(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), *output, rowsPerGroup).ok());
+        EXPECT_TRUE((*output)->Close().ok());
+        return path;
+    }
+};
+
+TEST_F(ParquetLoadTest, Load_ReadsEveryRow) {
+    std::string path = WriteCells(100, 25);
+    ParquetPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+    EXPECT_EQ(loader.GetRowGroupCount(), 4);
+    EXPECT_EQ(loader.GetSkippedRowGroupCount(), 0);
+    ASSERT_EQ(polygons.Size(), 100u);
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_EQ(names.at(polygons.GetClassId(1)), "Tumor");
+    EXPECT_EQ(polygons.GetVertexCount(0), 4u);
+    EXPECT_FLOAT_EQ(polygons.GetConfidence(50), 0.5f);
+    EXPECT_DOUBLE_EQ(polygons.GetCentroid(3).x, 65.0);
+}
+
+TEST_F(ParquetLoadTest, Load_PushesFilterDown) {
+    std::string path = WriteCells(100, 25);
+    ParquetPolygonLoader loader;
+    ParquetPolygonLoader::Filter filter;
+    // Cells 10-12 (x 200-250), inside the first row group
+    filter.hasRegion = true;
+    filter.region = Rect(205, 2, 40, 2);
+    filter.centroidMargin = 10.0;
+    filter.classes = {"Tumor"};
+    loader.SetFilter(filter);
+
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+    EXPECT_EQ(loader.GetSkippedRowGroupCount(), 3);
+    ASSERT_EQ(polygons.Size(), 1u);  // Cell 11
+    EXPECT_FLOAT_EQ(polygons.GetMinX(0), 220.0f);
+    EXPECT_EQ(names.size(), 1u);
+
+    // Confidence prunes the low row groups
+    filter = ParquetPolygonLoader::Filter();
+    filter.minConfidence = 0.8f;
+    loader.SetFilter(filter);
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+    EXPECT_EQ(loader.GetSkippedRowGroupCount(), 3);
+    EXPECT_EQ(polygons.Size(), 20u);
+}
+
+#endif
@@ -0,0 +1,109 @@
+// PixelConvert Unit Tests
+// Tests for the per-layout row kernels: channel order, alpha handling,
+// the scalar tail after the vectorized blocks and the runtime table
+
+#include <gtest/gtest.h>
+#include "PixelConvert.h"
+#include <vector>
+
+TEST(PixelConvertTest, ArgbOverWhiteToRgba) {
+    // Opaque red, half-covered blue (premultiplied), fully transparent
+    const uint32_t argb[] = {0xFFFF0000u, 0x80000080u, 0x00000000u};
+    uint8_t rgba[12];
+    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::OverWhite>(argb, rgba, 3);
+
+    const uint8_t expected[12] = {255, 0, 0, 255, 127, 127, 255, 255, 255, 255, 255, 255};
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_EQ(rgba[i], expected[i]) << "byte " << i;
+    }
+}
+
+TEST(PixelConvertTest, ArgbKeepsOrDropsAlpha) {
+    const uint32_t argb = 0x80402010u;
+    uint8_t kept[4];
+    uint8_t opaque[4];
+    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::Keep>(&argb, kept, 1);
+    PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGBA8, AlphaMode::Opaque>(&argb, opaque, 1);
+
+    EXPECT_EQ(kept[0], 0x40);
+    EXPECT_EQ(kept[1], 0x20);
+    EXPECT_EQ(kept[2], 0x10);
+    EXPECT_EQ(kept[3], 0x80);
+    EXPECT_EQ(opaque[3], 255);
+}
+
+TEST(PixelConvertTest, BgrAndGrayToArgb) {
+    const uint8_t bgr[] = {0x10, 0x20, 0x30};
+    const uint8_t gray[] = {0x7F};
+    uint32_t fromBgr = 0;
+    uint32_t fromGray = 0;
+    PixelConvert::ConvertRow<PixelLayout::BGR24, PixelLayout::ARGB32, AlphaMode::Keep>(bgr, &fromBgr, 1);
+    PixelConvert::ConvertRow<PixelLayout::Gray8, PixelLayout::ARGB32, AlphaMode::Keep>(gray, &fromGray, 1);
+
+    EXPECT_EQ(fromBgr, 0xFF302010u);
+    EXPECT_EQ(fromGray, 0xFF7F7F7Fu);
+}
+
+TEST(PixelConvertTest, BlockAndTailAgree) {
+    // 21 pixels: two full blocks of 8 and a tail of 5, against one pixel
+    // per block
+    std::vector<uint8_t> rgba(21 * 4);
+    for (size_t i = 0; i < rgba.size(); ++i) {
+        rgba[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+    std::vector<uint8_t> blocked(21 * 3);
+    std::vector<uint8_t> scalar(21 * 3);
+    PixelConvert::ConvertRow<PixelLayout::RGBA8, PixelLayout::RGB24, AlphaMode::Opaque>(
+        rgba.data(), blocked.data(), 21);
+    PixelConvert::ConvertRow<PixelLayout::RGBA8, PixelLayout::RGB24, AlphaMode::Opaque, 1>(
+        rgba.data(), scalar.data(), 21);
+
+    EXPECT_EQ(blocked, scalar);
+    EXPECT_EQ(blocked[60], rgba[80]);
+    EXPECT_EQ(blocked[62], rgba[82]);
+}
+
+TEST(PixelConvertTest, Get_MatchesDirectInstantiation) {
+    EXPECT_EQ(PixelConvert::Get(PixelLayout::ARGB32, PixelLayout::RGB24, AlphaMode::OverWhite),
+              (&PixelConvert::ConvertRow<PixelLayout::ARGB32, PixelLayout::RGB24, AlphaMode::OverWhite>));
+    EXPECT_EQ(PixelConvert::Get(PixelLayout::Gray8, PixelLayout::BGR24, AlphaMode::Keep),
+              (&PixelConvert::ConvertRow<PixelLayout::Gray8, PixelLayout::BGR24, AlphaMode::Keep>));
+
+    // Gray8 is not an output layout
+    EXPECT_EQ(PixelConvert::Get(PixelLayout::RGBA8, PixelLayout::Gray8, AlphaMode::Keep), nullptr);
+}
+
+TEST(PixelConvertTest, Yuv420RoundTrip_SmoothColorsStayClose) {
+    // 5x3: odd sizes leave a partial chroma column and row
+    const int32_t width = 5, height = 3;
+    std::vector<uint32_t> argb(width * height);
+    for (int32_t i = 0; i < width * height; ++i) {
+        argb[i] = 0xFF000000u | (uint32_t(200 + i) << 16) | (uint32_t(120 + i) << 8) | uint32_t(180 - i);
+    }
+    std::vector<uint8_t> yuv(PixelConvert::Yuv420Bytes(width, height));
+    EXPECT_EQ(yuv.size(), 15u + 2 * 3 * 2);
+    PixelConvert::ArgbToYuv420(argb.data(), width, height, width, yuv.data());
+
+    std::vector<uint32_t> back(width * height);
+    PixelConvert::Yuv420ToArgb(yuv.data(), width, height, back.data(), width);
+    for (int32_t i = 0; i < width * height; ++i) {
+        EXPECT_EQ(back[i] >> 24, 0xFFu);
+        for (int shift = 0; shift < 24; shift += 8) {
+            EXPECT_NEAR(int((back[i] >> shift) & 0xFF), int((argb[i] >> shift) & 0xFF), 6) << "pixel " << i;
+        }
+    }
+}
+
+TEST(PixelConvertTest, Yuv420_GraysAreExact) {
+    const uint32_t argb[4] = {0xFF000000u, 0xFF808080u, 0xFFFFFFFFu, 0xFF404040u};
+    uint8_t yuv[6];
+    PixelConvert::ArgbToYuv420(argb, 2, 2, 2, yuv);
+    EXPECT_EQ(yuv[4], 128);  // Cb
+    EXPECT_EQ(yuv[5], 128);  // Cr
+
+    uint32_t back[4];
+    PixelConvert::Yuv420ToArgb(yuv, 2, 2, back, 2);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(back[i], argb[i]);
+    }
+}
@@ -0,0 +1,235 @@
+// PolygonCache Unit Tests
+// Tests for round-tripping the store, class tables, spatial index and
+// tissue map through the binary sidecar, freshness against the source file
+// and rejection of a corrupted sidecar. Each test works in its own temp
+// directory.
+
+#include <gtest/gtest.h>
+#include "PolygonCache.h"
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include "TissueMap.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class PolygonCacheTest : public ::testing::Test {
+protected:
+    fs::path root;
+    std::string sourcePath;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_polygon_cache_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+
+        sourcePath = (root / "cells.pb").string();
+        WriteSource("original contents");
+
+        polygons.Add(0, {Vec2(10, 10), Vec2(40, 10), Vec2(40, 40), Vec2(10, 40)});
+        polygons.Add(1, {Vec2(600, 600), Vec2(700, 620), Vec2(650, 700)});
+        polygons.Add(1, {Vec2(300, 800), Vec2(320, 800), Vec2(330, 820), Vec2(310, 840), Vec2(295, 820)});
+        polygons.SetConfidence(1, 0.75f);
+        polygons.SetCentroid(1, 660, 640);
+
+        // Fine enough outline to have a simplified triangulation of its own
+        std::vector<Vec2> circle;
+        for (int i = 0; i < 48; ++i) {
+            double angle = i * 2.0 * M_PI / 48;
+            circle.emplace_back(2000 + 50 * std::cos(angle), 2000 + 50 * std::sin(angle));
+        }
+        polygons.Add(0, circle);
+
+        classColors[0] = SDL_Color{255, 0, 0, 255};
+        classColors[1] = SDL_Color{0, 128, 255, 200};
+        classNames[0] = "Tumor";
+        classNames[1] = "Lymphocyte";
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    void WriteSource(const std::string& contents) {
+        std::ofstream out(sourcePath, std::ios::binary | std::ios::trunc);
+        out << contents;
+    }
+
+    bool WriteCache(bool withIndex, const TissueMap* tissueMap = nullptr) {
+        PolygonIndex index(2);
+        index.Build(polygons);
+        return PolygonCache::Write(sourcePath, polygons, withIndex ? &index : nullptr,
+                                   classColors, classNames, tissueMap);
+    }
+};
+
+// ============================================================================
+// Round Trip Tests
+// ============================================================================
+
+TEST_F(PolygonCacheTest, RoundTrip_RestoresStoreAndClasses) {
+    ASSERT_TRUE(WriteCache(false));
+    EXPECT_TRUE(PolygonCache::IsFresh(sourcePath));
+
+    PolygonStore loaded;
+    std::unique_ptr<PolygonIndex> index;
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedNames;
+    std::unique_ptr<TissueMap> tissue;
+    ASSERT_TRUE(PolygonCache::Read(sourcePath, loaded, index, loadedColors, loadedNames, tissue));
+
+    EXPECT_EQ(index, nullptr);
+    EXPECT_EQ(tissue, nullptr);
+    ASSERT_EQ(loaded.Size(), polygons.Size());
+    EXPECT_EQ(loaded.GetTotalVertexCount(), polygons.GetTotalVertexCount());
+    for (uint32_t i = 0; i < loaded.Size(); ++i) {
+        EXPECT_EQ(loaded.GetClassId(i), polygons.GetClassId(i));
+        ASSERT_EQ(loaded.GetVertexCount(i), polygons.GetVertexCount(i));
+        for (uint32_t v = 0; v < loaded.GetVertexCount(i); ++v) {
+            EXPECT_FLOAT_EQ(loaded.GetVertices(i)[v].x, polygons.GetVertices(i)[v].x);
+            EXPECT_FLOAT_EQ(loaded.GetVertices(i)[v].y, polygons.GetVertices(i)[v].y);
+        }
+        EXPECT_FLOAT_EQ(loaded.GetMaxX(i), polygons.GetMaxX(i));
+        EXPECT_FLOAT_EQ(loaded.GetMinY(i), polygons.GetMinY(i));
+        EXPECT_DOUBLE_EQ(loaded.GetCentroid(i).x, polygons.GetCentroid(i).x);
+        EXPECT_FLOAT_EQ(loaded.GetArea(i), polygons.GetArea(i));
+        EXPECT_FLOAT_EQ(loaded.GetConfidence(i), polygons.GetConfidence(i));
+
+        // Triangulations come from the sidecar, identical to the originals
+        uint32_t expectedCount = 0;
+        uint32_t loadedCount = 0;
+        const uint32_t* expected = polygons.GetTriangles(i, expectedCount);
+        const uint32_t* triangles = loaded.GetTriangles(i, loadedCount);
+        ASSERT_EQ(loadedCount, expectedCount);
+        EXPECT_TRUE(std::equal(triangles, triangles + loadedCount, expected));
+
+        expected = polygons.GetSimplifiedTriangles(i, expectedCount);
+        triangles = loaded.GetSimplifiedTriangles(i, loadedCount);
+        ASSERT_EQ(loadedCount, expectedCount);
+        EXPECT_TRUE(std::equal(triangles, triangles + loadedCount, expected));
+    }
+    uint32_t fullCount = 0;
+    uint32_t simplifiedCount = 0;
+    loaded.GetTriangles(3, fullCount);
+    loaded.GetSimplifiedTriangles(3, simplifiedCount);
+    EXPECT_LT(simplifiedCount, fullCount);
+
+    ASSERT_EQ(loadedNames.size(), 2u);
+    EXPECT_EQ(loadedNames[0], "Tumor");
+    EXPECT_EQ(loadedNames[1], "Lymphocyte");
+    EXPECT_EQ(loadedColors[1].b, 255);
+    EXPECT_EQ(loadedColors[1].a, 200);
+}
+
+TEST_F(PolygonCacheTest, RoundTrip_RestoresSpatialIndex) {
+    ASSERT_TRUE(WriteCache(true));
+
+    PolygonStore loaded;
+    std::unique_ptr<PolygonIndex> index;
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedNames;
+    std::unique_ptr<TissueMap> tissue;
+    ASSERT_TRUE(PolygonCache::Read(sourcePath, loaded, index, loadedColors, loadedNames, tissue));
+
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->Size(), polygons.Size());
+
+    std::vector<uint32_t> hits = index->QueryRegion(Rect(550, 550, 200, 200));
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0], 1u);
+    EXPECT_EQ(index->QueryNearest(Vec2(320, 790), 1), std::vector<uint32_t>{2});
+}
+
+TEST_F(PolygonCacheTest, RoundTrip_RestoresTissueMap) {
+    // Stroma left, tumor right of a 1024 x 512 px area, 4 px per label
+    std::vector<uint8_t> labels(256 * 128, 1);
+    for (int y = 0; y < 128; ++y) {
+        std::fill(labels.begin() + y * 256 + 128, labels.begin() + (y + 1) * 256, 2);
+    }
+    TissueMap written(4.0, 0);
+    written.AddRegion(Rect(1024, 0, 1024, 512), 256, 128, labels.data());
+    written.BuildLevels();
+    written.SetClassNames({{1, "Stroma"}, {2, "Tumor"}});
+    ASSERT_TRUE(WriteCache(true, &written));
+
+    PolygonStore loaded;
+    std::unique_ptr<PolygonIndex> index;
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedNames;
+    std::unique_ptr<TissueMap> tissue;
+    ASSERT_TRUE(PolygonCache::Read(sourcePath, loaded, index, loadedColors, loadedNames, tissue));
+
+    ASSERT_NE(tissue, nullptr);
+    EXPECT_DOUBLE_EQ(tissue->GetTexelSize(), 4.0);
+    EXPECT_EQ(tissue->GetLevelCount(), written.GetLevelCount());
+    EXPECT_EQ(tissue->GetTileCount(), written.GetTileCount());
+    EXPECT_EQ(tissue->GetLabel(1100, 100), 1);
+    EXPECT_EQ(tissue->GetLabel(1900, 500), 2);
+    EXPECT_EQ(tissue->GetLabel(100, 100), 0);
+    EXPECT_EQ(tissue->GetClassNames().at(2), "Tumor");
+    EXPECT_NE(index, nullptr);
+}
+
+// ============================================================================
+// Validation Tests
+// ============================================================================
+
+TEST_F(PolygonCacheTest, SourceChange_MakesSidecarStale) {
+    EXPECT_FALSE(PolygonCache::IsFresh(sourcePath));
+    ASSERT_TRUE(WriteCache(false));
+    EXPECT_TRUE(PolygonCache::IsFresh(sourcePath));
+
+    WriteSource("edited contents, now longer");
+    EXPECT_FALSE(PolygonCache::IsFresh(sourcePath));
+}
+
+TEST_F(PolygonCacheTest, CorruptedSidecar_IsRejected) {
+    ASSERT_TRUE(WriteCache(true));
+    std::string cachePath = PolygonCache::SidecarPath(sourcePath);
+
+    // Flip a byte in the last section
+    {
+        std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-1, std::ios::end);
+        char byte = 0;
+        file.read(&byte, 1);
+        file.seekp(-1, std::ios::end);
+        byte = static_cast<char>(byte ^ 0x5A);
+        file.write(&byte, 1);
+    }
+
+    PolygonStore loaded;
+    loaded.Add(7, {Vec2(1, 1), Vec2(2, 1), Vec2(2, 2)});
+    std::unique_ptr<PolygonIndex> index;
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedNames;
+    std::unique_ptr<TissueMap> tissue;
+    EXPECT_FALSE(PolygonCache::Read(sourcePath, loaded, index, loadedColors, loadedNames, tissue));
+
+    // Outputs are untouched on failure
+    ASSERT_EQ(loaded.Size(), 1u);
+    EXPECT_EQ(loaded.GetClassId(0), 7);
+    EXPECT_EQ(index, nullptr);
+}
+
+TEST_F(PolygonCacheTest, MissingSidecar_IsNotFresh) {
+    PolygonStore loaded;
+    std::unique_ptr<PolygonIndex> index;
+    std::map<int, SDL_Color> loadedColors;
+    std::map<int, std::string> loadedNames;
+    std::unique_ptr<TissueMap> tissue;
+    EXPECT_FALSE(PolygonCache::IsFresh(sourcePath));
+    EXPECT_FALSE(PolygonCache::Read(sourcePath, loaded, index, loadedColors, loadedNames, tissue));
+}
@@ -0,0 +1,97 @@
+// PolygonClip Unit Tests
+// Tests for exact areas of overlap: partly overlapping, identical and
+// touching outlines, opposite windings, concave regions checked against
+// areas worked out by hand, coordinates far from the origin, and the
+// inside / outside / across classification of boxes
+
+#include <gtest/gtest.h>
+#include "PolygonClip.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+std::vector<Vec2> Box(double x, double y, double width, double height) {
+    return {Vec2(x, y), Vec2(x + width, y), Vec2(x + width, y + height), Vec2(x, y + height)};
+}
+
+double RectOverlap(double ax, double ay, double aw, double ah, double bx, double by, double bw, double bh) {
+    const double w = std::min(ax + aw, bx + bw) - std::max(ax, bx);
+    const double h = std::min(ay + ah, by + bh) - std::max(ay, by);
+    return w > 0 && h > 0 ? w * h : 0.0;
+}
+
+}  // namespace
+
+TEST(PolygonClipTest, OverlappingSquares) {
+    std::vector<Vec2> a = Box(0, 0, 10, 10);
+    std::vector<Vec2> b = Box(5, 5, 10, 10);
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(a, b), 25.0);
+    EXPECT_DOUBLE_EQ(PolygonClip::UnionArea(a, b), 175.0);
+    EXPECT_DOUBLE_EQ(PolygonClip::DifferenceArea(a, b), 75.0);
+}
+
+TEST(PolygonClipTest, SharedEdgesAndVertices) {
+    std::vector<Vec2> square = Box(0, 0, 10, 10);
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, square), 100.0);
+
+    // Same outline, opposite winding
+    std::vector<Vec2> reversed(square.rbegin(), square.rend());
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, reversed), 100.0);
+
+    // Side by side: only an edge in common
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, Box(10, 0, 10, 10)), 0.0);
+    // Sharing part of an edge, overlapping inside
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, Box(0, 2, 4, 4)), 16.0);
+
+    // A diamond whose edges pass through the square's corners
+    std::vector<Vec2> diamond = {Vec2(5, -5), Vec2(15, 5), Vec2(5, 15), Vec2(-5, 5)};
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, diamond), 100.0);
+
+    // Half the square, cut along its diagonal
+    EXPECT_DOUBLE_EQ(PolygonClip::IntersectionArea(square, {Vec2(0, 0), Vec2(10, 0), Vec2(0, 10)}), 50.0);
+}
+
+TEST(PolygonClipTest, ConcaveRegionMatchesHandWorkedAreas) {
+    // An L: [0,100] x [0,40] and [0,40] x [40,100]
+    std::vector<Vec2> l = {Vec2(0, 0), Vec2(100, 0), Vec2(100, 40), Vec2(40, 40), Vec2(40, 100), Vec2(0, 100)};
+    PolygonClip clip(l);
+    EXPECT_DOUBLE_EQ(clip.GetArea(), 100 * 40 + 40 * 60);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> position(-20.0, 110.0);
+    std::uniform_real_distribution<double> size(0.5, 30.0);
+    for (int i = 0; i < 500; ++i) {
+        // Quarter pixels, so the snapped boxes are the boxes
+        const double x = std::round(position(random) * 4) / 4, y = std::round(position(random) * 4) / 4;
+        const double w = std::round(size(random) * 4) / 4, h = std::round(size(random) * 4) / 4;
+        const double expected = RectOverlap(x, y, w, h, 0, 0, 100, 40) + RectOverlap(x, y, w, h, 0, 40, 40, 60);
+        ASSERT_NEAR(clip.OverlapArea(Box(x, y, w, h)), expected, 1e-9) << x << "," << y << " " << w << "x" << h;
+        ASSERT_NEAR(clip.OverlapArea(Rect(x, y, w, h)), expected, 1e-9);
+    }
+}
+
+TEST(PolygonClipTest, FarFromOrigin) {
+    const double x = 150000.25, y = 98000.5;
+    PolygonClip clip(Box(x, y, 20, 20));
+    std::vector<Vec2> cell = {Vec2(x + 15, y + 5), Vec2(x + 25, y + 5), Vec2(x + 25, y + 15), Vec2(x + 15, y + 15)};
+    EXPECT_DOUBLE_EQ(clip.OverlapArea(cell), 50.0);
+
+    std::vector<Vec2f> stored;
+    for (const Vec2& v : cell) {
+        stored.push_back({float(v.x), float(v.y)});
+    }
+    EXPECT_NEAR(clip.OverlapArea(stored.data(), uint32_t(stored.size())), 50.0, 0.05);
+}
+
+TEST(PolygonClipTest, Classify_BoxesInsideOutsideAndAcross) {
+    PolygonClip clip(Box(0, 0, 1000, 1000));
+    EXPECT_EQ(clip.Classify(Rect(100, 100, 10, 10)), PolygonMask::WHOLE);
+    EXPECT_EQ(clip.Classify(Rect(2000, 100, 10, 10)), PolygonMask::NONE);
+    EXPECT_EQ(clip.Classify(Rect(995, 100, 10, 10)), PolygonMask::PARTIAL);
+    EXPECT_EQ(clip.Classify(Rect(-100, -100, 2000, 2000)), PolygonMask::PARTIAL);
+
+    PolygonClip empty({Vec2(0, 0), Vec2(1, 1)});
+    EXPECT_DOUBLE_EQ(empty.GetArea(), 0.0);
+    EXPECT_DOUBLE_EQ(empty.OverlapArea(Box(0, 0, 1, 1)), 0.0);
+}
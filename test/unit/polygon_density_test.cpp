@@ -0,0 +1,176 @@
+// PolygonDensity Unit Tests
+// Tests for binning polygon centers, class color mixing, hidden classes,
+// the 2x2 pyramid, level selection by zoom and the minimap overview drawn
+// from the cell stats pyramid
+
+#include <gtest/gtest.h>
+#include "PolygonDensity.h"
+#include "CellStatsPyramid.h"
+#include <map>
+
+namespace {
+
+constexpr int32_t BIN = PolygonDensity::BIN_SIZE;
+
+uint32_t Alpha(uint32_t pixel) { return pixel >> 24; }
+uint32_t Red(uint32_t pixel) { return (pixel >> 16) & 0xFF; }
+uint32_t Green(uint32_t pixel) { return (pixel >> 8) & 0xFF; }
+uint32_t Blue(uint32_t pixel) { return pixel & 0xFF; }
+
+void AddCell(PolygonStore& polygons, int classId, double centerX, double centerY) {
+    polygons.Add(classId, {Vec2(centerX - 5, centerY - 5), Vec2(centerX + 5, centerY - 5),
+                           Vec2(centerX + 5, centerY + 5), Vec2(centerX - 5, centerY + 5)});
+}
+
+}  // namespace
+
+TEST(PolygonDensityTest, EmptyStore_HasNoLevels) {
+    PolygonDensity density;
+    density.Build(PolygonStore(), {});
+    EXPECT_TRUE(density.Empty());
+    EXPECT_EQ(density.GetLevelCount(), 0u);
+}
+
+TEST(PolygonDensityTest, Build_BinsCentersAndHalvesEachLevel) {
+    PolygonStore polygons;
+    AddCell(polygons, 0, 10, 10);
+    AddCell(polygons, 0, BIN * 5 + 10, BIN * 2 + 10);  // Farthest: 6x3 bins
+
+    PolygonDensity density;
+    density.Build(polygons, {{0, SDL_Color{255, 0, 0, 255}}});
+
+    ASSERT_EQ(density.GetLevelCount(), 4u);  // 6x3, 3x2, 2x1, 1x1
+    const DensityLevel& finest = density.GetLevel(0);
+    EXPECT_EQ(finest.binSize, BIN);
+    EXPECT_EQ(finest.columns, 6);
+    EXPECT_EQ(finest.rows, 3);
+    EXPECT_EQ(density.GetLevel(1).columns, 3);
+    EXPECT_EQ(density.GetLevel(1).rows, 2);
+    EXPECT_EQ(density.GetLevel(3).columns, 1);
+    EXPECT_EQ(density.GetLevel(3).rows, 1);
+    EXPECT_EQ(density.GetLevel(3).binSize, BIN * 8);
+
+    EXPECT_EQ(Alpha(finest.pixels[0]), 255u);
+    EXPECT_EQ(Alpha(finest.pixels[2 * 6 + 5]), 255u);
+    EXPECT_EQ(finest.pixels[1], 0u);
+    EXPECT_EQ(Red(finest.pixels[0]), 255u);
+}
+
+TEST(PolygonDensityTest, Build_MixesClassColorsAndScalesAlphaByCount) {
+    PolygonStore polygons;
+    // Bin 0: one red and one blue cell; bins 1-20: two cells each (the
+    // crowded majority); bin 21: a single cell
+    AddCell(polygons, 0, 10, 10);
+    AddCell(polygons, 1, 20, 20);
+    for (int bin = 1; bin <= 20; ++bin) {
+        AddCell(polygons, 0, bin * BIN + 10, 10);
+        AddCell(polygons, 0, bin * BIN + 20, 20);
+    }
+    AddCell(polygons, 0, 21 * BIN + 10, 10);
+
+    PolygonDensity density;
+    density.Build(polygons, {{0, SDL_Color{255, 0, 0, 255}}, {1, SDL_Color{0, 0, 255, 255}}});
+    const DensityLevel& finest = density.GetLevel(0);
+
+    // Full alpha at two cells: the mix is premultiplied half red, half blue
+    EXPECT_EQ(Alpha(finest.pixels[0]), 255u);
+    EXPECT_NEAR(Red(finest.pixels[0]), 128u, 1u);
+    EXPECT_NEAR(Blue(finest.pixels[0]), 128u, 1u);
+    EXPECT_EQ(Green(finest.pixels[0]), 0u);
+
+    // Half the typical count: half alpha, color premultiplied to match
+    EXPECT_NEAR(Alpha(finest.pixels[21]), 128u, 1u);
+    EXPECT_NEAR(Red(finest.pixels[21]), 128u, 1u);
+}
+
+TEST(PolygonDensityTest, Build_LeavesOutHiddenClasses) {
+    PolygonStore polygons;
+    AddCell(polygons, 1, 10, 10);
+    AddCell(polygons, 2, 20, 20);
+    AddCell(polygons, 2, BIN + 10, 10);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(2, false);
+    PolygonDensity density;
+    density.Build(polygons, {{1, SDL_Color{255, 0, 0, 255}}, {2, SDL_Color{0, 0, 255, 255}}}, visibility);
+
+    // Bin 0 holds only the red cell; bin 1 is empty
+    const DensityLevel& finest = density.GetLevel(0);
+    ASSERT_EQ(finest.columns, 2);
+    EXPECT_EQ(Red(finest.pixels[0]), 255u);
+    EXPECT_EQ(Blue(finest.pixels[0]), 0u);
+    EXPECT_EQ(finest.pixels[1], 0u);
+}
+
+TEST(PolygonDensityTest, SelectLevel_PicksFinestBinCoveringScreenPixels) {
+    PolygonStore polygons;
+    AddCell(polygons, 0, 10, 10);
+    AddCell(polygons, 0, BIN * 100, BIN * 100);
+
+    PolygonDensity density;
+    density.Build(polygons, {});
+    ASSERT_GT(density.GetLevelCount(), 4u);
+
+    EXPECT_EQ(density.SelectLevel(1.0 / BIN, 1.0), 0u);         // 64 px bins at 1/64
+    EXPECT_EQ(density.SelectLevel(1.0 / (BIN * 2), 1.0), 1u);   // 128 px bins at 1/128
+    EXPECT_EQ(density.SelectLevel(1.0 / (BIN * 3), 1.0), 2u);   // 128 px fall short
+    EXPECT_EQ(density.SelectLevel(1e-9, 1.0), density.GetLevelCount() - 1);
+}
+
+TEST(PolygonDensityTest, ReleasePixels_KeepsGeometry) {
+    PolygonStore polygons;
+    AddCell(polygons, 0, BIN * 3, BIN * 3);
+
+    PolygonDensity density;
+    density.Build(polygons, {});
+    EXPECT_GT(density.GetMemoryUsage(), 0u);
+
+    density.ReleasePixels();
+    EXPECT_EQ(density.GetMemoryUsage(), 0u);
+    EXPECT_EQ(density.GetLevel(0).columns, 4);
+    EXPECT_TRUE(density.GetLevel(0).pixels.empty());
+}
+
+TEST(PolygonDensityTest, RenderOverview_SumsBinsIntoPixels) {
+    PolygonStore polygons;
+    AddCell(polygons, 1, 10, 10);
+    AddCell(polygons, 2, BIN * 15 + 10, BIN * 7 + 10);
+    AddCell(polygons, 2, BIN * 15 + 20, BIN * 7 + 20);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+    const std::map<int, SDL_Color> colors = {{1, SDL_Color{255, 0, 0, 255}}, {2, SDL_Color{0, 0, 255, 255}}};
+
+    // A pixel per 2 x 2 bins of a 2048 x 1024 slide
+    std::vector<uint32_t> pixels;
+    ASSERT_TRUE(PolygonDensity::RenderOverview(stats, colors, ClassVisibility(), BIN * 32, BIN * 16, 16, 8, pixels));
+    ASSERT_EQ(pixels.size(), 16u * 8u);
+    EXPECT_EQ(Red(pixels[0]), 255u);
+    EXPECT_EQ(Blue(pixels[3 * 16 + 7]), 255u);
+    EXPECT_EQ(Alpha(pixels[3 * 16 + 7]), 255u);  // The fuller pixel
+    EXPECT_EQ(pixels[1], 0u);
+
+    // One class alone
+    ClassVisibility onlyRed;
+    onlyRed.SetVisible(2, false);
+    ASSERT_TRUE(PolygonDensity::RenderOverview(stats, colors, onlyRed, BIN * 32, BIN * 16, 16, 8, pixels));
+    EXPECT_EQ(Red(pixels[0]), 255u);
+    EXPECT_EQ(pixels[3 * 16 + 7], 0u);
+
+    EXPECT_FALSE(PolygonDensity::RenderOverview(CellStatsPyramid(), colors, ClassVisibility(), BIN * 32, BIN * 16,
+                                                16, 8, pixels));
+}
+
+TEST(PolygonDensityTest, RenderOverview_SpreadsCoarseBinsOverPixels) {
+    PolygonStore polygons;
+    AddCell(polygons, 0, 10, 10);
+    CellStatsPyramid stats;
+    stats.Build(polygons);
+
+    // Four pixels per bin side
+    std::vector<uint32_t> pixels;
+    ASSERT_TRUE(PolygonDensity::RenderOverview(stats, {}, ClassVisibility(), BIN * 4, BIN * 4, 16, 16, pixels));
+    EXPECT_EQ(Alpha(pixels[0]), 255u);
+    EXPECT_EQ(Alpha(pixels[3 * 16 + 3]), 255u);
+    EXPECT_EQ(pixels[4], 0u);
+    EXPECT_EQ(pixels[4 * 16], 0u);
+}
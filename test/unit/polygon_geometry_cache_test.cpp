@@ -0,0 +1,267 @@
+// PolygonGeometryCache Unit Tests
+// Tests for bucketing polygons into chunks, chunk queries, geometry kept
+// relative to the chunk origin, simplified triangles ordered by polygon
+// size, colors refilled after a style change, hidden classes left out,
+// cells below the confidence threshold made transparent, chunks prepared
+// across threads and the geometry version
+
+#include <gtest/gtest.h>
+#include "PolygonGeometryCache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int32_t CHUNK = PolygonGeometryCache::CHUNK_SIZE;
+
+void AddSquare(PolygonStore& polygons, int classId, double x, double y, double size) {
+    polygons.Add(classId, {Vec2(x, y), Vec2(x + size, y), Vec2(x + size, y + size), Vec2(x, y + size)});
+}
+
+SDL_Color ClassColor(int classId) {
+    return SDL_Color{static_cast<Uint8>(classId * 10), 0, 0, 128};
+}
+
+}  // namespace
+
+TEST(PolygonGeometryCacheTest, EmptyStore_HasNoChunks) {
+    PolygonGeometryCache cache;
+    cache.Build(PolygonStore());
+    EXPECT_TRUE(cache.Empty());
+
+    std::vector<uint32_t> chunks = {7};
+    cache.QueryChunks(Rect(0, 0, 1000, 1000), chunks);
+    EXPECT_TRUE(chunks.empty());
+}
+
+TEST(PolygonGeometryCacheTest, QueryChunks_ReturnsChunksNearTheRegion) {
+    PolygonStore polygons;
+    AddSquare(polygons, 0, 10, 10, 20);                  // Chunk (0, 0)
+    AddSquare(polygons, 0, CHUNK * 3 + 10, 10, 20);      // Chunk (3, 0)
+    AddSquare(polygons, 0, 10, CHUNK * 2 + 10, 20);      // Chunk (0, 2)
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    ASSERT_EQ(cache.GetChunkCount(), 12u);  // 4 x 3
+
+    std::vector<uint32_t> chunks;
+    cache.QueryChunks(Rect(0, 0, CHUNK, CHUNK), chunks);
+    EXPECT_EQ(chunks, std::vector<uint32_t>({0}));
+
+    cache.QueryChunks(Rect(0, 0, CHUNK * 4, CHUNK * 3), chunks);
+    std::sort(chunks.begin(), chunks.end());
+    EXPECT_EQ(chunks, std::vector<uint32_t>({0, 3, 8}));
+
+    // Empty chunks and chunks whose polygons miss the region are skipped
+    cache.QueryChunks(Rect(CHUNK, CHUNK, CHUNK, CHUNK), chunks);
+    EXPECT_TRUE(chunks.empty());
+    cache.QueryChunks(Rect(100, 100, 50, 50), chunks);
+    EXPECT_TRUE(chunks.empty());
+}
+
+TEST(PolygonGeometryCacheTest, QueryChunks_FindsPolygonsReachingIntoTheRegion) {
+    PolygonStore polygons;
+    AddSquare(polygons, 0, CHUNK - 250, 10, 300);  // Center in chunk 0, box reaches past it
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+
+    std::vector<uint32_t> chunks;
+    cache.QueryChunks(Rect(CHUNK + 10, 0, 40, 40), chunks);
+    EXPECT_EQ(chunks, std::vector<uint32_t>({0}));
+}
+
+TEST(PolygonGeometryCacheTest, GetGeometry_PositionsRelativeToChunkOrigin) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, CHUNK + 10, CHUNK + 20, 30);
+    AddSquare(polygons, 2, CHUNK + 100, CHUNK + 100, 30);
+    AddSquare(polygons, 1, 10, 10, 30);  // Another chunk
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    cache.SetStyle(ClassColor);
+
+    const uint32_t chunk = 3;  // (1, 1) of a 2 x 2 grid
+    EXPECT_FLOAT_EQ(cache.GetOriginX(chunk), CHUNK);
+    EXPECT_FLOAT_EQ(cache.GetOriginY(chunk), CHUNK);
+
+    const PolygonChunkGeometry& geometry = cache.GetGeometry(chunk, polygons);
+    ASSERT_EQ(geometry.xy.size(), 16u);
+    EXPECT_FLOAT_EQ(geometry.xy[0], 10.0f);
+    EXPECT_FLOAT_EQ(geometry.xy[1], 20.0f);
+    EXPECT_FLOAT_EQ(geometry.xy[8], 100.0f);
+    ASSERT_EQ(geometry.indices.size(), 24u);  // Two triangles per square, simplified and full
+    auto secondSquare = [](int index) { return index >= 4 && index < 8; };
+    EXPECT_TRUE(std::all_of(geometry.indices.begin() + 6, geometry.indices.begin() + 12, secondSquare));
+    EXPECT_TRUE(std::all_of(geometry.indices.begin() + 18, geometry.indices.end(), secondSquare));
+
+    ASSERT_EQ(geometry.colors.size(), 8u);
+    EXPECT_EQ(geometry.colors[0].r, 10);
+    EXPECT_EQ(geometry.colors[4].r, 20);
+    EXPECT_EQ(geometry.colors[4].a, 128);
+    EXPECT_GT(cache.GetMemoryUsage(), 0u);
+}
+
+TEST(PolygonGeometryCacheTest, GetGeometry_OrdersPolygonsBySizeWithSimplifiedFirst) {
+    PolygonStore polygons;
+    std::vector<Vec2> circle;
+    for (int i = 0; i < 64; ++i) {
+        double angle = i * 2.0 * M_PI / 64;
+        circle.emplace_back(200 + 100 * std::cos(angle), 200 + 100 * std::sin(angle));
+    }
+    polygons.Add(1, circle);
+    AddSquare(polygons, 2, 10, 10, 30);
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    const PolygonChunkGeometry& geometry = cache.GetGeometry(0, polygons);
+    ASSERT_EQ(geometry.sizes, std::vector<float>({30.0f, 200.0f}));
+    ASSERT_EQ(geometry.simplifiedStarts.size(), 3u);
+    ASSERT_EQ(geometry.fullStarts.size(), 3u);
+
+    uint32_t simplifiedCount = 0;
+    uint32_t fullCount = 0;
+    polygons.GetSimplifiedTriangles(0, simplifiedCount);
+    polygons.GetTriangles(0, fullCount);
+    ASSERT_LT(simplifiedCount, fullCount);
+
+    // Square, then circle, simplified; then the same two in full
+    EXPECT_EQ(geometry.simplifiedStarts[1], 6u);
+    EXPECT_EQ(geometry.simplifiedStarts[2], 6u + simplifiedCount);
+    EXPECT_EQ(geometry.fullStarts[0], geometry.simplifiedStarts[2]);
+    EXPECT_EQ(geometry.fullStarts[1], geometry.fullStarts[0] + 6);
+    EXPECT_EQ(geometry.fullStarts[2], geometry.indices.size());
+    EXPECT_EQ(geometry.indices.size(), 12u + simplifiedCount + fullCount);
+    EXPECT_EQ(geometry.runs.front().classId, 2);
+}
+
+TEST(PolygonGeometryCacheTest, SetStyle_RefillsColorsOnNextUse) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, 10, 10, 30);
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    cache.SetStyle(ClassColor);
+    EXPECT_EQ(cache.GetGeometry(0, polygons).colors[0].r, 10);
+
+    cache.SetStyle([](int) { return SDL_Color{0, 200, 0, 255}; });
+    const PolygonChunkGeometry& geometry = cache.GetGeometry(0, polygons);
+    EXPECT_EQ(geometry.colors[0].r, 0);
+    EXPECT_EQ(geometry.colors[3].g, 200);
+}
+
+TEST(PolygonGeometryCacheTest, SetVisibility_RebuildsWithoutHiddenClasses) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, 10, 10, 30);
+    AddSquare(polygons, 2, 100, 100, 30);
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    ASSERT_EQ(cache.GetGeometry(0, polygons).xy.size(), 16u);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(1, false);
+    cache.SetVisibility(visibility);
+    const PolygonChunkGeometry& geometry = cache.GetGeometry(0, polygons);
+    ASSERT_EQ(geometry.xy.size(), 8u);
+    EXPECT_FLOAT_EQ(geometry.xy[0], 100.0f);
+    ASSERT_EQ(geometry.runs.size(), 1u);
+    EXPECT_EQ(geometry.runs[0].classId, 2);
+    EXPECT_EQ(geometry.indices.size(), 12u);
+}
+
+TEST(PolygonGeometryCacheTest, SetMinConfidence_RefillsAlphaWithoutRebuilding) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, 10, 10, 30);
+    AddSquare(polygons, 1, 100, 100, 20);
+    polygons.SetConfidence(0, 0.9f);
+    polygons.SetConfidence(1, 0.5f);
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    cache.SetStyle(ClassColor);
+    const uint64_t version = cache.GetGeometryVersion();
+    const PolygonChunkGeometry& geometry = cache.GetGeometry(0, polygons);
+    ASSERT_EQ(geometry.confidences.size(), 2u);
+    ASSERT_EQ(geometry.vertexStarts.size(), 3u);
+    EXPECT_FLOAT_EQ(geometry.confidences[0], 0.5f);  // Smallest first
+
+    cache.SetMinConfidence(0.8f);
+    cache.GetGeometry(0, polygons);
+    for (uint32_t v = 0; v < 8; ++v) {
+        EXPECT_EQ(geometry.colors[v].a, v < 4 ? 0 : 128) << v;
+    }
+    EXPECT_EQ(geometry.indices.size(), 24u);  // Triangles kept
+    EXPECT_EQ(cache.GetGeometryVersion(), version);
+
+    cache.SetMinConfidence(0.0f);
+    EXPECT_EQ(cache.GetGeometry(0, polygons).colors[0].a, 128);
+}
+
+TEST(PolygonGeometryCacheTest, Prepare_Threaded_MatchesGetGeometry) {
+    // A 6 x 6 grid of chunks, each with squares of several classes
+    PolygonStore polygons;
+    for (int row = 0; row < 6; ++row) {
+        for (int column = 0; column < 6; ++column) {
+            for (int i = 0; i < 20; ++i) {
+                AddSquare(polygons, i % 3, column * CHUNK + 10 + i * 20, row * CHUNK + 10 + i * 5, 8 + i);
+            }
+        }
+    }
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache serial;
+    serial.Build(polygons);
+    serial.SetStyle(ClassColor);
+    PolygonGeometryCache threaded;
+    threaded.Build(polygons);
+    threaded.SetStyle(ClassColor);
+
+    std::vector<uint32_t> chunks;
+    threaded.QueryChunks(Rect(0, 0, CHUNK * 6, CHUNK * 6), chunks);
+    ASSERT_EQ(chunks.size(), 36u);
+
+    std::vector<int> calls(chunks.size(), 0);
+    std::vector<size_t> vertices(chunks.size(), 0);
+    threaded.Prepare(chunks, polygons, [&](size_t slot, const PolygonChunkGeometry& geometry) {
+        ++calls[slot];
+        vertices[slot] = geometry.xy.size() / 2;
+    }, 4);
+
+    for (size_t slot = 0; slot < chunks.size(); ++slot) {
+        EXPECT_EQ(calls[slot], 1);
+        const PolygonChunkGeometry& expected = serial.GetGeometry(chunks[slot], polygons);
+        const PolygonChunkGeometry& prepared = threaded.GetGeometry(chunks[slot], polygons);
+        EXPECT_EQ(vertices[slot], expected.xy.size() / 2);
+        EXPECT_EQ(prepared.xy, expected.xy);
+        EXPECT_EQ(prepared.indices, expected.indices);
+        EXPECT_EQ(prepared.fullStarts, expected.fullStarts);
+        ASSERT_EQ(prepared.colors.size(), expected.colors.size());
+        EXPECT_EQ(prepared.colors[0].r, expected.colors[0].r);
+    }
+    EXPECT_EQ(threaded.GetMemoryUsage(), serial.GetMemoryUsage());
+}
+
+TEST(PolygonGeometryCacheTest, GeometryVersion_ChangesOnlyWithPositions) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, 10, 10, 30);
+    polygons.TriangulateAll();
+
+    PolygonGeometryCache cache;
+    cache.Build(polygons);
+    const uint64_t built = cache.GetGeometryVersion();
+    cache.GetGeometry(0, polygons);
+    cache.SetStyle(ClassColor);  // Colors only
+    EXPECT_EQ(cache.GetGeometryVersion(), built);
+
+    cache.SetVisibility(ClassVisibility());
+    EXPECT_NE(cache.GetGeometryVersion(), built);
+    const uint64_t visible = cache.GetGeometryVersion();
+    cache.Build(polygons);
+    EXPECT_NE(cache.GetGeometryVersion(), visible);
+}
@@ -1,10 +1,10 @@
 // PolygonIndex Unit Tests
-// Tests for spatial indexing and region queries
+// Tests for spatial indexing with region, point and nearest queries
 // Critical for efficient polygon rendering
 
 #include <gtest/gtest.h>
 #include "PolygonIndex.h"
-#include "PolygonOverlay.h"
+#include "PolygonStore.h"
 #include <vector>
 #include <algorithm>
 
@@ -14,36 +14,27 @@
 
 class PolygonIndexTest : public ::testing::Test {
 protected:
-    std::vector<Polygon> polygons;
+    PolygonStore polygons;
     static constexpr double SLIDE_WIDTH = 10000.0;
     static constexpr double SLIDE_HEIGHT = 8000.0;
-    static constexpr int GRID_SIZE = 100;  // 100x100 grid
 
     void SetUp() override {
-        polygons.clear();
+        polygons.Clear();
     }
 
-    // Helper to create a rectangular polygon at specific position
-    Polygon CreateRectPolygon(double x, double y, double width, double height, int classId = 0) {
-        Polygon p;
-        p.classId = classId;
-        p.vertices = {
+    // Helper to add a rectangular polygon at specific position
+    void AddRectPolygon(double x, double y, double width, double height, int classId = 0) {
+        polygons.Add(classId, {
             Vec2(x, y),
             Vec2(x + width, y),
             Vec2(x + width, y + height),
             Vec2(x, y + height)
-        };
-        p.ComputeBoundingBox();
-        return p;
+        });
     }
 
-    // Helper to create a triangular polygon
-    Polygon CreateTrianglePolygon(double x1, double y1, double x2, double y2, double x3, double y3) {
-        Polygon p;
-        p.classId = 0;
-        p.vertices = {Vec2(x1, y1), Vec2(x2, y2), Vec2(x3, y3)};
-        p.ComputeBoundingBox();
-        return p;
+    // Helper to add a triangular polygon
+    void AddTrianglePolygon(double x1, double y1, double x2, double y2, double x3, double y3) {
+        polygons.Add(0, {Vec2(x1, y1), Vec2(x2, y2), Vec2(x3, y3)});
     }
 };
 
@@ -53,12 +44,12 @@ protected:
 
 TEST_F(PolygonIndexTest, Constructor_ValidParameters_Succeeds) {
     EXPECT_NO_THROW({
-        PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+        PolygonIndex index(8);
     });
 }
 
 TEST_F(PolygonIndexTest, Build_EmptyPolygonList_Succeeds) {
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
 
     EXPECT_NO_THROW({
         index.Build(polygons);
@@ -70,51 +61,51 @@ TEST_F(PolygonIndexTest, Build_EmptyPolygonList_Succeeds) {
 // ============================================================================
 
 TEST_F(PolygonIndexTest, QueryRegion_EmptyIndex_ReturnsEmpty) {
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(0, 0, 1000, 1000);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 0);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_ContainsPolygon_ReturnsPolygon) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));  // 100-150, 100-150
+    AddRectPolygon(100, 100, 50, 50);  // 100-150, 100-150
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query region that contains the polygon
     Rect query_region(90, 90, 70, 70);  // 90-160, 90-160
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
-    EXPECT_EQ(results[0]->classId, 0);
+    EXPECT_EQ(polygons.GetClassId(results[0]), 0);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_NoOverlap_ReturnsEmpty) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
+    AddRectPolygon(100, 100, 50, 50);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query region that doesn't overlap
     Rect query_region(200, 200, 100, 100);  // 200-300, 200-300
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 0);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_PartialOverlap_ReturnsPolygon) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));  // 100-150, 100-150
+    AddRectPolygon(100, 100, 50, 50);  // 100-150, 100-150
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query region overlaps only corner of polygon
     Rect query_region(140, 140, 50, 50);  // 140-190, 140-190
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     // Should return the polygon (partial overlap)
     EXPECT_EQ(results.size(), 1);
@@ -125,16 +116,16 @@ TEST_F(PolygonIndexTest, QueryRegion_PartialOverlap_ReturnsPolygon) {
 // ============================================================================
 
 TEST_F(PolygonIndexTest, QueryRegion_MultiplePolygons_ReturnsAll) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
-    polygons.push_back(CreateRectPolygon(120, 120, 50, 50));
-    polygons.push_back(CreateRectPolygon(500, 500, 50, 50));  // Far away
+    AddRectPolygon(100, 100, 50, 50);
+    AddRectPolygon(120, 120, 50, 50);
+    AddRectPolygon(500, 500, 50, 50);  // Far away
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query region that overlaps first two polygons
     Rect query_region(90, 90, 90, 90);  // 90-180, 90-180
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 2);
 }
@@ -142,59 +133,108 @@ TEST_F(PolygonIndexTest, QueryRegion_MultiplePolygons_ReturnsAll) {
 TEST_F(PolygonIndexTest, QueryRegion_EntireSlide_ReturnsAllPolygons) {
     // Add polygons at various positions
     for (int i = 0; i < 20; ++i) {
-        polygons.push_back(CreateRectPolygon(i * 100, i * 100, 50, 50));
+        AddRectPolygon(i * 100, i * 100, 50, 50);
     }
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query entire slide
     Rect query_region(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 20);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_NoDuplicates_EachPolygonOnce) {
-    // Create a large polygon that spans multiple grid cells
-    polygons.push_back(CreateRectPolygon(50, 50, 500, 500));
+    // Create a large polygon that spans many others' surroundings
+    AddRectPolygon(50, 50, 500, 500);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query a region that overlaps the polygon
     Rect query_region(100, 100, 400, 400);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     // Should return polygon exactly once, not multiple times
     EXPECT_EQ(results.size(), 1);
 }
 
+TEST_F(PolygonIndexTest, Insert_AppendedBatch_MatchesFullBuild) {
+    AddRectPolygon(100, 100, 50, 50);
+    AddRectPolygon(5000, 4000, 50, 50);
+
+    PolygonIndex index;
+    index.Build(polygons);
+
+    // A later batch lands in the same store and is indexed on its own
+    AddRectPolygon(120, 120, 300, 300);
+    AddRectPolygon(9000, 7000, 50, 50);
+    index.Insert(polygons, 2, 4);
+
+    PolygonIndex rebuilt;
+    rebuilt.Build(polygons);
+
+    Rect query_region(0, 0, 500, 500);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
+    EXPECT_EQ(results, (std::vector<uint32_t>{0, 2}));
+    EXPECT_EQ(results, rebuilt.QueryRegion(query_region));
+
+    Rect whole_slide(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT);
+    EXPECT_EQ(index.QueryRegion(whole_slide).size(), 4u);
+}
+
+TEST_F(PolygonIndexTest, Insert_BeyondPackThreshold_RepacksAndMatchesFullBuild) {
+    // Enough streamed batches that the pending polygons get packed into the tree
+    PolygonIndex index;
+    index.Build(polygons);
+    for (int batch = 0; batch < 10; ++batch) {
+        uint32_t begin = static_cast<uint32_t>(polygons.Size());
+        for (int i = 0; i < 1000; ++i) {
+            int cell = batch * 1000 + i;
+            AddRectPolygon((cell % 100) * 100, (cell / 100) * 80, 40, 30);
+        }
+        index.Insert(polygons, begin, static_cast<uint32_t>(polygons.Size()));
+    }
+    EXPECT_EQ(index.Size(), 10000u);
+
+    PolygonIndex rebuilt;
+    rebuilt.Build(polygons);
+
+    Rect query_region(1234, 2345, 1500, 900);
+    EXPECT_EQ(index.QueryRegion(query_region), rebuilt.QueryRegion(query_region));
+    index.Pack();
+    EXPECT_EQ(index.QueryRegion(query_region), rebuilt.QueryRegion(query_region));
+    EXPECT_EQ(index.Size(), 10000u);
+}
+
 // ============================================================================
-// Grid Boundary Tests
+// Boundary Tests
 // ============================================================================
 
-TEST_F(PolygonIndexTest, QueryRegion_AtGridBoundary_HandlesCorrectly) {
-    // Grid cell size: 10000 / 100 = 100 pixels per cell
-    // Place polygon exactly at grid boundary
-    polygons.push_back(CreateRectPolygon(99, 99, 2, 2));  // Straddles boundary at 100
+TEST_F(PolygonIndexTest, QueryRegion_AtBoundary_HandlesCorrectly) {
+    // Polygon edges meet the query edges exactly
+    AddRectPolygon(99, 99, 2, 2);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query region that includes the boundary
     Rect query_region(95, 95, 10, 10);  // 95-105, 95-105
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
-TEST_F(PolygonIndexTest, QueryRegion_PolygonSpansMultipleCells_FoundInAllCells) {
-    // Create polygon that definitely spans multiple grid cells
-    // Grid cell = 100x100, so 500x500 polygon spans 25 cells
-    polygons.push_back(CreateRectPolygon(50, 50, 500, 500));
+TEST_F(PolygonIndexTest, QueryRegion_LargePolygon_FoundFromEveryPart) {
+    // Large polygon among small ones, which fill the tree's lower nodes
+    AddRectPolygon(50, 50, 500, 500);
+    for (int i = 0; i < 200; ++i) {
+        AddRectPolygon(1000 + (i % 20) * 50, 1000 + (i / 20) * 50, 10, 10);
+    }
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query different regions within the polygon
@@ -202,9 +242,9 @@ TEST_F(PolygonIndexTest, QueryRegion_PolygonSpansMultipleCells_FoundInAllCells)
     Rect query2(500, 500, 50, 50);  // Bottom-right
     Rect query3(250, 250, 50, 50);  // Center
 
-    EXPECT_EQ(index.QueryRegion(query1).size(), 1);
-    EXPECT_EQ(index.QueryRegion(query2).size(), 1);
-    EXPECT_EQ(index.QueryRegion(query3).size(), 1);
+    EXPECT_EQ(index.QueryRegion(query1), std::vector<uint32_t>{0});
+    EXPECT_EQ(index.QueryRegion(query2), std::vector<uint32_t>{0});
+    EXPECT_EQ(index.QueryRegion(query3), std::vector<uint32_t>{0});
 }
 
 // ============================================================================
@@ -213,48 +253,46 @@ TEST_F(PolygonIndexTest, QueryRegion_PolygonSpansMultipleCells_FoundInAllCells)
 
 TEST_F(PolygonIndexTest, QueryRegion_TinyPolygon_StillFound) {
     // 1x1 pixel polygon
-    polygons.push_back(CreateRectPolygon(100, 100, 1, 1));
+    AddRectPolygon(100, 100, 1, 1);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(99, 99, 3, 3);  // 99-102, 99-102
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_PolygonAtEdge_FoundCorrectly) {
     // Polygon at slide edge
-    polygons.push_back(CreateRectPolygon(9950, 7950, 50, 50));  // Near bottom-right corner
+    AddRectPolygon(9950, 7950, 50, 50);  // Near bottom-right corner
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(9900, 7900, 100, 100);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_PolygonAtOrigin_FoundCorrectly) {
-    polygons.push_back(CreateRectPolygon(0, 0, 50, 50));
+    AddRectPolygon(0, 0, 50, 50);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(0, 0, 100, 100);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
 TEST_F(PolygonIndexTest, Build_PolygonWithNoVertices_HandlesGracefully) {
-    Polygon empty_polygon;
-    empty_polygon.ComputeBoundingBox();
-    polygons.push_back(empty_polygon);
+    polygons.Add(0, std::vector<Vec2>{});
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
 
     EXPECT_NO_THROW({
         index.Build(polygons);
@@ -263,13 +301,13 @@ TEST_F(PolygonIndexTest, Build_PolygonWithNoVertices_HandlesGracefully) {
 
 TEST_F(PolygonIndexTest, QueryRegion_ExactBoundaryMatch_ReturnsPolygon) {
     // Polygon and query region have exact same bounds
-    polygons.push_back(CreateRectPolygon(100, 100, 100, 100));
+    AddRectPolygon(100, 100, 100, 100);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(100, 100, 100, 100);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
@@ -279,10 +317,10 @@ TEST_F(PolygonIndexTest, QueryRegion_ExactBoundaryMatch_ReturnsPolygon) {
 // ============================================================================
 
 TEST_F(PolygonIndexTest, Clear_RemovesAllPolygons) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
-    polygons.push_back(CreateRectPolygon(200, 200, 50, 50));
+    AddRectPolygon(100, 100, 50, 50);
+    AddRectPolygon(200, 200, 50, 50);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Verify polygons are indexed
@@ -295,16 +333,16 @@ TEST_F(PolygonIndexTest, Clear_RemovesAllPolygons) {
 }
 
 TEST_F(PolygonIndexTest, Clear_ThenRebuild_WorksCorrectly) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
+    AddRectPolygon(100, 100, 50, 50);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     index.Clear();
 
     // Add different polygons and rebuild
-    polygons.clear();
-    polygons.push_back(CreateRectPolygon(500, 500, 50, 50));
+    polygons.Clear();
+    AddRectPolygon(500, 500, 50, 50);
     index.Build(polygons);
 
     Rect query_old(100, 100, 50, 50);
@@ -322,85 +360,191 @@ TEST_F(PolygonIndexTest, QueryRegion_ManyPolygons_ReturnsOnlyRelevant) {
     // Add 100 polygons scattered across slide
     for (int i = 0; i < 10; ++i) {
         for (int j = 0; j < 10; ++j) {
-            polygons.push_back(CreateRectPolygon(i * 1000, j * 800, 50, 50));
+            AddRectPolygon(i * 1000, j * 800, 50, 50);
         }
     }
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query small region that should only contain 1 polygon
     Rect small_query(2020, 1620, 100, 100);
-    std::vector<Polygon*> results = index.QueryRegion(small_query);
+    std::vector<uint32_t> results = index.QueryRegion(small_query);
 
     // Should return a small number, not all 100
     EXPECT_LT(results.size(), 10);
     EXPECT_GT(results.size(), 0);  // Should find at least the nearby one
 }
 
+TEST_F(PolygonIndexTest, QueryRegion_ManyPolygons_MatchesBruteForce) {
+    // Irregular layout, so the tree has several levels with partial overlaps
+    uint32_t seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % 10000;
+    };
+    for (int i = 0; i < 5000; ++i) {
+        AddRectPolygon(next(), next() * 0.8, 5 + next() % 60, 5 + next() % 60);
+    }
+
+    PolygonIndex index;
+    index.Build(polygons);
+
+    const Rect queries[] = {
+        Rect(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT),
+        Rect(2500, 1500, 3000, 2000),
+        Rect(4000, 4000, 120, 90),
+        Rect(-500, -500, 600, 600),
+    };
+    for (const Rect& query : queries) {
+        std::vector<uint32_t> expected;
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            if (polygons.Intersects(polygon, query)) {
+                expected.push_back(polygon);
+            }
+        }
+        EXPECT_EQ(index.QueryRegion(query), expected);
+    }
+}
+
+TEST_F(PolygonIndexTest, QueryRegion_IntoBuffer_EachPolygonOnceAndBufferReused) {
+    for (int i = 0; i < 2000; ++i) {
+        AddRectPolygon((i % 50) * 200, (i / 50) * 200, 150, 150);
+    }
+    PolygonIndex index;
+    index.Build(polygons);
+    AddRectPolygon(1000, 1000, 500, 500);
+    index.Insert(polygons, 2000, 2001);
+
+    // Stale contents are replaced, not appended to
+    std::vector<uint32_t> buffer(5000, 7);
+    const size_t capacity = buffer.capacity();
+    Rect query_region(900, 900, 700, 700);
+    index.QueryRegion(query_region, buffer);
+
+    EXPECT_EQ(buffer.capacity(), capacity);
+    std::vector<uint32_t> sorted = buffer;
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(std::adjacent_find(sorted.begin(), sorted.end()), sorted.end());
+    EXPECT_EQ(sorted, index.QueryRegion(query_region));
+    EXPECT_EQ(sorted.back(), 2000u);
+
+    index.QueryRegion(Rect(-100, -100, 10, 10), buffer);
+    EXPECT_TRUE(buffer.empty());
+}
+
+// ============================================================================
+// Point and Nearest Query Tests
+// ============================================================================
+
+TEST_F(PolygonIndexTest, QueryPoint_ReturnsPolygonsUnderPoint) {
+    AddRectPolygon(100, 100, 50, 50);
+    AddRectPolygon(120, 120, 50, 50);
+    AddRectPolygon(500, 500, 50, 50);
+
+    PolygonIndex index;
+    index.Build(polygons);
+
+    EXPECT_EQ(index.QueryPoint(Vec2(130, 130)), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(index.QueryPoint(Vec2(550, 550)), std::vector<uint32_t>{2});
+    EXPECT_TRUE(index.QueryPoint(Vec2(300, 300)).empty());
+}
+
+TEST_F(PolygonIndexTest, QueryPoint_SkipsHiddenClasses) {
+    AddRectPolygon(100, 100, 50, 50, 1);
+    AddRectPolygon(120, 120, 50, 50, 2);
+    PolygonIndex index;
+    index.Build(polygons);
+    AddRectPolygon(110, 110, 50, 50, 1);  // Streamed in, awaiting a pack
+    index.Insert(polygons, 2, 3);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(2, false);
+    std::vector<uint32_t> result;
+    index.QueryPoint(Vec2(130, 130), visibility, result);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(result, (std::vector<uint32_t>{0, 2}));
+}
+
+TEST_F(PolygonIndexTest, QueryNearest_OrdersByDistance) {
+    for (int i = 0; i < 100; ++i) {
+        AddRectPolygon((i % 10) * 1000, (i / 10) * 800, 50, 50);
+    }
+    // One more streamed in, awaiting a pack
+    PolygonIndex index;
+    index.Build(polygons);
+    AddRectPolygon(5100, 4000, 10, 10);
+    index.Insert(polygons, 100, 101);
+
+    // Inside polygon 55 (5000-5050, 4000-4050), then the streamed one 80
+    // away, then the neighbour above (770 away, the one below is 780)
+    std::vector<uint32_t> nearest = index.QueryNearest(Vec2(5020, 4020), 3);
+    EXPECT_EQ(nearest, (std::vector<uint32_t>{55, 100, 45}));
+
+    EXPECT_EQ(index.QueryNearest(Vec2(0, 0), 0).size(), 0u);
+    EXPECT_EQ(index.QueryNearest(Vec2(0, 0), 500).size(), 101u);
+}
+
 // ============================================================================
 // Correctness Tests with Different Shapes
 // ============================================================================
 
 TEST_F(PolygonIndexTest, QueryRegion_TriangularPolygon_FoundByBoundingBox) {
-    polygons.push_back(CreateTrianglePolygon(100, 100, 150, 100, 125, 150));
+    AddTrianglePolygon(100, 100, 150, 100, 125, 150);
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query the bounding box area
     Rect query_region(100, 100, 50, 50);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
 TEST_F(PolygonIndexTest, QueryRegion_ComplexPolygon_IndexedCorrectly) {
     // Create irregular polygon (L-shape)
-    Polygon l_shape;
-    l_shape.vertices = {
+    polygons.Add(0, {
         Vec2(100, 100), Vec2(200, 100), Vec2(200, 150),
         Vec2(150, 150), Vec2(150, 200), Vec2(100, 200)
-    };
-    l_shape.ComputeBoundingBox();
-    polygons.push_back(l_shape);
+    });
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     // Query overlapping region
     Rect query_region(120, 120, 50, 50);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
 // ============================================================================
-// Grid Size Variation Tests
+// Node Size Variation Tests
 // ============================================================================
 
-TEST_F(PolygonIndexTest, Constructor_SmallGrid_WorksCorrectly) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
+TEST_F(PolygonIndexTest, Constructor_SmallNodes_WorksCorrectly) {
+    AddRectPolygon(100, 100, 50, 50);
 
-    // Very coarse grid (10x10)
-    PolygonIndex index(10, 10, SLIDE_WIDTH, SLIDE_HEIGHT);
+    // Binary tree
+    PolygonIndex index(2);
     index.Build(polygons);
 
     Rect query_region(90, 90, 70, 70);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
 
-TEST_F(PolygonIndexTest, Constructor_LargeGrid_WorksCorrectly) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50));
+TEST_F(PolygonIndexTest, Constructor_LargeNodes_WorksCorrectly) {
+    AddRectPolygon(100, 100, 50, 50);
 
-    // Very fine grid (1000x1000)
-    PolygonIndex index(1000, 1000, SLIDE_WIDTH, SLIDE_HEIGHT);
+    // Every polygon in one node under the root
+    PolygonIndex index(1000);
     index.Build(polygons);
 
     Rect query_region(90, 90, 70, 70);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 1);
 }
@@ -410,22 +554,22 @@ TEST_F(PolygonIndexTest, Constructor_LargeGrid_WorksCorrectly) {
 // ============================================================================
 
 TEST_F(PolygonIndexTest, QueryRegion_DifferentClasses_AllReturned) {
-    polygons.push_back(CreateRectPolygon(100, 100, 50, 50, 1));  // Class 1
-    polygons.push_back(CreateRectPolygon(120, 120, 50, 50, 2));  // Class 2
-    polygons.push_back(CreateRectPolygon(140, 140, 50, 50, 3));  // Class 3
+    AddRectPolygon(100, 100, 50, 50, 1);  // Class 1
+    AddRectPolygon(120, 120, 50, 50, 2);  // Class 2
+    AddRectPolygon(140, 140, 50, 50, 3);  // Class 3
 
-    PolygonIndex index(GRID_SIZE, GRID_SIZE, SLIDE_WIDTH, SLIDE_HEIGHT);
+    PolygonIndex index;
     index.Build(polygons);
 
     Rect query_region(90, 90, 110, 110);
-    std::vector<Polygon*> results = index.QueryRegion(query_region);
+    std::vector<uint32_t> results = index.QueryRegion(query_region);
 
     EXPECT_EQ(results.size(), 3);
 
     // Verify all classes are present
     std::vector<int> classes;
-    for (const auto* poly : results) {
-        classes.push_back(poly->classId);
+    for (uint32_t poly : results) {
+        classes.push_back(polygons.GetClassId(poly));
     }
     std::sort(classes.begin(), classes.end());
 
@@ -433,3 +577,124 @@ TEST_F(PolygonIndexTest, QueryRegion_DifferentClasses_AllReturned) {
     EXPECT_EQ(classes[1], 2);
     EXPECT_EQ(classes[2], 3);
 }
+
+TEST_F(PolygonIndexTest, QueryRegion_HiddenClasses_MatchesBruteForce) {
+    uint32_t seed = 777;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % 10000;
+    };
+    for (int i = 0; i < 4000; ++i) {
+        AddRectPolygon(next(), next() * 0.8, 5 + next() % 60, 5 + next() % 60, static_cast<int>(next() % 5));
+    }
+
+    PolygonIndex index;
+    index.Build(polygons);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(1, false);
+    visibility.SetVisible(3, false);
+
+    const Rect queries[] = {
+        Rect(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT),
+        Rect(2500, 1500, 3000, 2000),
+        Rect(4000, 4000, 120, 90),
+    };
+    for (const Rect& query : queries) {
+        std::vector<uint32_t> expected;
+        for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+            if (polygons.Intersects(polygon, query) && visibility.IsVisible(polygons.GetClassId(polygon))) {
+                expected.push_back(polygon);
+            }
+        }
+        EXPECT_EQ(index.QueryRegion(query, visibility), expected);
+    }
+
+    // Nothing visible: nothing reported
+    for (int classId = 0; classId < 5; ++classId) {
+        visibility.SetVisible(classId, false);
+    }
+    EXPECT_TRUE(index.QueryRegion(queries[0], visibility).empty());
+}
+
+TEST_F(PolygonIndexTest, QueryRegion_ClassRuns_BucketedInClassOrder) {
+    for (int i = 0; i < 3000; ++i) {
+        AddRectPolygon((i % 60) * 150, (i / 60) * 150, 100, 100, (i * 7) % 4);
+    }
+    PolygonIndex index;
+    index.Build(polygons);
+
+    // Streamed polygons, not packed yet, are merged into their class
+    for (int i = 0; i < 20; ++i) {
+        AddRectPolygon(1000 + i * 10, 1000, 50, 50, i % 5);
+    }
+    index.Insert(polygons, 3000, 3020);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(2, false);
+    std::vector<uint32_t> results;
+    std::vector<PolygonIndex::ClassRun> runs;
+    const Rect query(500, 500, 2000, 2000);
+    index.QueryRegion(query, visibility, results, runs);
+
+    ASSERT_EQ(runs.size(), 4u);  // Classes 0, 1, 3 and 4
+    EXPECT_EQ(runs[0].classId, 0);
+    EXPECT_EQ(runs[1].classId, 1);
+    EXPECT_EQ(runs[2].classId, 3);
+    EXPECT_EQ(runs[3].classId, 4);
+    EXPECT_EQ(runs.front().begin, 0u);
+    EXPECT_EQ(runs.back().end, results.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (i > 0) {
+            EXPECT_EQ(runs[i].begin, runs[i - 1].end);
+        }
+        for (uint32_t r = runs[i].begin; r < runs[i].end; ++r) {
+            EXPECT_EQ(polygons.GetClassId(results[r]), runs[i].classId);
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    EXPECT_EQ(results, index.QueryRegion(query, visibility));
+}
+
+TEST_F(PolygonIndexTest, QueryRegion_ManyClasses_HidesClassesSharingTheLastMaskBit) {
+    // 100 classes: those past the 63rd share one mask bit
+    for (int i = 0; i < 2000; ++i) {
+        AddRectPolygon((i % 50) * 200, (i / 50) * 200, 150, 150, i % 100);
+    }
+    PolygonIndex index;
+    index.Build(polygons);
+
+    ClassVisibility visibility;
+    visibility.SetVisible(5, false);
+    visibility.SetVisible(70, false);
+    visibility.SetVisible(99, false);
+    const std::vector<uint32_t> results = index.QueryRegion(Rect(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT), visibility);
+
+    EXPECT_EQ(results.size(), 2000u - 3 * 20);
+    for (uint32_t polygon : results) {
+        const int classId = polygons.GetClassId(polygon);
+        EXPECT_TRUE(classId != 5 && classId != 70 && classId != 99);
+    }
+}
+
+TEST_F(PolygonIndexTest, Build_SameTreeForAnyThreadCount) {
+    // Enough cells for several build blocks, in shuffled classes
+    for (int i = 0; i < 150000; ++i) {
+        AddRectPolygon((i * 7919) % 9900, static_cast<int64_t>(i) * 104729 % 7900, 30, 30, (i * 31) % 7);
+    }
+    PolygonIndex serial;
+    serial.Build(polygons, 1);
+    PolygonIndex parallel;
+    parallel.Build(polygons, 4);
+    ASSERT_EQ(parallel.Size(), serial.Size());
+
+    // Results come out in leaf order, so equal results mean equal leaves
+    std::vector<uint32_t> expected, results;
+    for (const Rect& region : {Rect(0, 0, SLIDE_WIDTH, SLIDE_HEIGHT), Rect(1234, 567, 800, 900)}) {
+        serial.QueryRegion(region, expected);
+        parallel.QueryRegion(region, results);
+        EXPECT_EQ(results, expected);
+    }
+    EXPECT_EQ(parallel.QueryNearest(Vec2(5000, 4000), 50), serial.QueryNearest(Vec2(5000, 4000), 50));
+}
@@ -0,0 +1,176 @@
+// PolygonMask Unit Tests
+// Tests for the inside / outside / boundary grid agreeing with ray casting,
+// for counting centroids with and without the spatial index or below a
+// confidence, and for the same counts on a finer grid on any thread count
+
+#include <gtest/gtest.h>
+#include "PolygonIndex.h"
+#include "PolygonMask.h"
+#include "PolygonStore.h"
+#include <cmath>
+#include <random>
+
+namespace {
+
+bool RayCast(const std::vector<Vec2>& vertices, double x, double y) {
+    bool inside = false;
+    for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+        if (((vertices[i].y > y) != (vertices[j].y > y)) &&
+            (x < (vertices[j].x - vertices[i].x) * (y - vertices[i].y) / (vertices[j].y - vertices[i].y) +
+                     vertices[i].x)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Wobbly star of n vertices around (cx, cy), concave like a hand-drawn lasso
+std::vector<Vec2> Star(size_t n, double cx, double cy, double radius) {
+    std::vector<Vec2> vertices;
+    for (size_t i = 0; i < n; ++i) {
+        double angle = 2.0 * M_PI * i / n;
+        double r = radius * (i % 2 == 0 ? 1.0 : 0.45) * (1.0 + 0.1 * std::sin(angle * 5));
+        vertices.emplace_back(cx + r * std::cos(angle), cy + r * std::sin(angle));
+    }
+    return vertices;
+}
+
+void AddSquare(PolygonStore& polygons, int classId, double x, double y, double size) {
+    polygons.Add(classId, {Vec2(x, y), Vec2(x + size, y), Vec2(x + size, y + size), Vec2(x, y + size)});
+}
+
+}  // namespace
+
+TEST(PolygonMaskTest, TooFewVertices_ContainsNothing) {
+    PolygonMask mask({Vec2(0, 0), Vec2(10, 10)});
+    EXPECT_FALSE(mask.Contains(5, 5));
+    EXPECT_EQ(mask.GetColumns(), 0);
+}
+
+TEST(PolygonMaskTest, Square_InteriorCellsNeedNoRayCast) {
+    PolygonMask mask({Vec2(0, 0), Vec2(1000, 0), Vec2(1000, 1000), Vec2(0, 1000)});
+    ASSERT_EQ(mask.GetColumns(), PolygonMask::GRID_SIZE);
+    ASSERT_EQ(mask.GetRows(), PolygonMask::GRID_SIZE);
+
+    // Only the outer ring of cells touches an edge
+    const size_t side = PolygonMask::GRID_SIZE;
+    EXPECT_EQ(mask.GetBoundaryCellCount(), 4 * side - 4);
+    EXPECT_TRUE(mask.Contains(500, 500));
+    EXPECT_TRUE(mask.Contains(1, 999));
+    EXPECT_FALSE(mask.Contains(-1, 500));
+    EXPECT_FALSE(mask.Contains(500, 1000.5));
+}
+
+TEST(PolygonMaskTest, ConcavePolygon_MatchesRayCasting) {
+    const std::vector<Vec2> star = Star(57, 3000, 2000, 800);
+    PolygonMask mask(star);
+    EXPECT_LT(mask.GetBoundaryCellCount(), size_t(mask.GetColumns()) * mask.GetRows() / 2);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> x(2100, 3900), y(1100, 2900);
+    for (int i = 0; i < 20000; ++i) {
+        const double px = x(random), py = y(random);
+        ASSERT_EQ(mask.Contains(px, py), RayCast(star, px, py)) << px << ", " << py;
+    }
+
+    // Vertices and points on the center lines of grid rows and columns
+    for (const Vec2& v : star) {
+        EXPECT_EQ(mask.Contains(v.x, v.y), RayCast(star, v.x, v.y));
+    }
+}
+
+TEST(PolygonMaskTest, ThinPolygon_UsesFewRows) {
+    PolygonMask mask({Vec2(0, 0), Vec2(1000, 0), Vec2(1000, 10), Vec2(0, 10)});
+    EXPECT_EQ(mask.GetColumns(), PolygonMask::GRID_SIZE);
+    EXPECT_EQ(mask.GetRows(), 3);
+    EXPECT_TRUE(mask.Contains(500, 5));
+    EXPECT_FALSE(mask.Contains(500, 10.5));
+}
+
+TEST(PolygonMaskTest, CountCentroids_SameWithAndWithoutIndex) {
+    PolygonStore polygons;
+    for (int row = 0; row < 40; ++row) {
+        for (int column = 0; column < 40; ++column) {
+            AddSquare(polygons, (row + column) % 3, column * 100.0, row * 100.0, 20);
+        }
+    }
+    polygons.Add(1, std::vector<Vec2>());  // No vertices: never counted
+
+    const std::vector<Vec2> star = Star(40, 2000, 2000, 1500);
+    std::map<int, int> expected;
+    for (uint32_t polygon = 0; polygon + 1 < polygons.Size(); ++polygon) {
+        const Vec2 centroid = polygons.GetCentroid(polygon);
+        if (RayCast(star, centroid.x, centroid.y)) {
+            expected[polygons.GetClassId(polygon)]++;
+        }
+    }
+    ASSERT_EQ(expected.size(), 3u);
+
+    PolygonMask mask(star);
+    std::map<int, int> scanned;
+    mask.CountCentroids(polygons, nullptr, scanned);
+    EXPECT_EQ(scanned, expected);
+
+    PolygonIndex index;
+    index.Build(polygons);
+    std::map<int, int> indexed = {{5, 1}};  // Counts are added to
+    mask.CountCentroids(polygons, &index, indexed);
+    expected[5] = 1;
+    EXPECT_EQ(indexed, expected);
+}
+
+TEST(PolygonMaskTest, CountCentroids_SkipsCellsBelowMinConfidence) {
+    PolygonStore polygons;
+    AddSquare(polygons, 1, 10, 10, 20);
+    AddSquare(polygons, 1, 50, 50, 20);
+    AddSquare(polygons, 2, 80, 10, 20);
+    polygons.SetConfidence(0, 0.3f);
+    polygons.SetConfidence(2, 0.9f);
+
+    PolygonIndex index;
+    index.Build(polygons);
+    PolygonMask mask({Vec2(0, 0), Vec2(200, 0), Vec2(200, 200), Vec2(0, 200)});
+    std::map<int, int> counts;
+    mask.CountCentroids(polygons, &index, counts, 0.5f);
+    EXPECT_EQ(counts, (std::map<int, int>{{1, 1}, {2, 1}}));
+}
+
+TEST(PolygonMaskTest, GridSizeFor_AboutOnePointACell) {
+    EXPECT_EQ(PolygonMask::GridSizeFor(0), PolygonMask::GRID_SIZE);
+    EXPECT_EQ(PolygonMask::GridSizeFor(256 * 256), 256);
+    EXPECT_EQ(PolygonMask::GridSizeFor(256 * 256 + 1), 512);
+    EXPECT_EQ(PolygonMask::GridSizeFor(size_t(1) << 40), PolygonMask::MAX_GRID_SIZE);
+
+    PolygonMask mask(Star(40, 2000, 2000, 1500), 1024);
+    EXPECT_EQ(std::max(mask.GetColumns(), mask.GetRows()), 1024);
+}
+
+TEST(PolygonMaskTest, CountCentroids_ManyCells_SameOnAnyThreadCount) {
+    // Enough cells for a finer grid and several blocks of candidates
+    PolygonStore polygons;
+    std::mt19937 random(17);
+    std::uniform_real_distribution<double> position(0.0, 4000.0);
+    for (int i = 0; i < 120000; ++i) {
+        AddSquare(polygons, i % 4, position(random), position(random), 6);
+    }
+
+    const std::vector<Vec2> star = Star(60, 2000, 2000, 1900);
+    std::map<int, int> expected;
+    for (uint32_t polygon = 0; polygon < polygons.Size(); ++polygon) {
+        const Vec2 centroid = polygons.GetCentroid(polygon);
+        if (RayCast(star, centroid.x, centroid.y)) {
+            expected[polygons.GetClassId(polygon)]++;
+        }
+    }
+
+    PolygonIndex index;
+    index.Build(polygons);
+    PolygonMask mask(star);
+    for (size_t threads : {size_t(1), size_t(4)}) {
+        std::map<int, int> indexed, scanned;
+        mask.CountCentroids(polygons, &index, indexed, 0.0f, threads);
+        mask.CountCentroids(polygons, nullptr, scanned, 0.0f, threads);
+        EXPECT_EQ(indexed, expected) << threads << " threads";
+        EXPECT_EQ(scanned, expected) << threads << " threads";
+    }
+}
@@ -0,0 +1,124 @@
+// PolygonPicker Unit Tests
+// Tests for picking the cell under a point: outline rather than box hits,
+// nested cells, hidden classes and cells below the confidence threshold,
+// and the cached answer
+
+#include <gtest/gtest.h>
+#include "PolygonIndex.h"
+#include "PolygonPicker.h"
+#include "PolygonStore.h"
+
+namespace {
+
+std::vector<Vec2> Square(double x, double y, double size) {
+    return {Vec2(x, y), Vec2(x + size, y), Vec2(x + size, y + size), Vec2(x, y + size)};
+}
+
+std::vector<Vec2> Diamond(double centerX, double centerY, double radius) {
+    return {Vec2(centerX, centerY - radius), Vec2(centerX + radius, centerY), Vec2(centerX, centerY + radius),
+            Vec2(centerX - radius, centerY)};
+}
+
+}  // namespace
+
+TEST(PolygonPickerTest, Pick_TestsOutlineNotBox) {
+    PolygonStore polygons;
+    polygons.Add(1, Diamond(100, 100, 50));
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+
+    PolygonPicker picker;
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(100, 100), 0), 0u);
+    // In the diamond's box, outside the diamond
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(60, 60), 0), PolygonPicker::NO_POLYGON);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(500, 500), 0), PolygonPicker::NO_POLYGON);
+}
+
+TEST(PolygonPickerTest, Pick_PrefersSmallestNestedCell) {
+    PolygonStore polygons;
+    polygons.Add(1, Square(0, 0, 100));
+    polygons.Add(2, Square(40, 40, 20));
+    polygons.Add(1, Square(200, 0, 100));
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+
+    PolygonPicker picker;
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 0), 1u);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(10, 10), 0), 0u);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(250, 50), 0), 2u);
+}
+
+TEST(PolygonPickerTest, Pick_SkipsHiddenClasses) {
+    PolygonStore polygons;
+    polygons.Add(1, Square(0, 0, 100));
+    polygons.Add(2, Square(40, 40, 20));
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+    visibility.SetVisible(2, false);
+
+    PolygonPicker picker;
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 0), 0u);
+    EXPECT_EQ(picker.Pick(polygons, nullptr, visibility, Vec2(50, 50), 1), 0u);
+}
+
+TEST(PolygonPickerTest, Pick_SkipsCellsBelowMinConfidence) {
+    PolygonStore polygons;
+    polygons.Add(1, Square(0, 0, 100));
+    polygons.Add(1, Square(40, 40, 20));
+    polygons.SetConfidence(1, 0.6f);
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+
+    PolygonPicker picker;
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 0), 1u);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 1, 0.8f), 0u);
+    EXPECT_EQ(picker.Pick(polygons, nullptr, visibility, Vec2(50, 50), 2, 0.8f), 0u);
+}
+
+TEST(PolygonPickerTest, Pick_WithoutIndexMatchesIndex) {
+    PolygonStore polygons;
+    for (int i = 0; i < 400; ++i) {
+        polygons.Add(i % 3, Diamond((i % 20) * 30.0, (i / 20) * 30.0, 12 + i % 5));
+    }
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+    visibility.SetVisible(1, false);
+
+    PolygonPicker indexed;
+    PolygonPicker scanned;
+    for (double y = -10; y < 600; y += 7) {
+        for (double x = -10; x < 600; x += 7) {
+            ASSERT_EQ(indexed.Pick(polygons, &index, visibility, Vec2(x, y), 0),
+                      scanned.Pick(polygons, nullptr, visibility, Vec2(x, y), 0));
+        }
+    }
+}
+
+TEST(PolygonPickerTest, Pick_CachedUntilPointRevisionOrStoreChanges) {
+    PolygonStore polygons;
+    polygons.Add(1, Square(0, 0, 100));
+    PolygonIndex index;
+    index.Build(polygons);
+    ClassVisibility visibility;
+
+    PolygonPicker picker;
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 0), 0u);
+
+    // Hidden without a new revision: the cached answer stands
+    visibility.SetVisible(1, false);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 0), 0u);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 1), PolygonPicker::NO_POLYGON);
+
+    // A cell streamed in is seen at once
+    visibility.SetVisible(1, true);
+    picker.Reset();
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 1), 0u);
+    polygons.Add(2, Square(45, 45, 10));
+    index.Insert(polygons, 1, 2);
+    EXPECT_EQ(picker.Pick(polygons, &index, visibility, Vec2(50, 50), 1), 1u);
+}
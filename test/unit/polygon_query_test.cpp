@@ -0,0 +1,118 @@
+// PolygonQuery Unit Tests
+// Tests for region, class and confidence filters, and for cursor
+// pagination: pages cover every match once, in store order, with or
+// without a spatial index
+
+#include <gtest/gtest.h>
+#include "PolygonIndex.h"
+#include "PolygonQuery.h"
+#include "PolygonStore.h"
+
+namespace {
+
+std::vector<Vec2> Square(double x, double y, double size) {
+    return {Vec2(x, y), Vec2(x + size, y), Vec2(x + size, y + size), Vec2(x, y + size)};
+}
+
+// A 10 x 10 grid of 10 px cells every 100 px, alternating classes 1 and 2;
+// confidence rises with the column
+PolygonStore GridOfCells() {
+    PolygonStore polygons;
+    for (int row = 0; row < 10; ++row) {
+        for (int column = 0; column < 10; ++column) {
+            uint32_t polygon = polygons.Add(1 + (row + column) % 2, Square(column * 100.0, row * 100.0, 10));
+            polygons.SetConfidence(polygon, column / 10.0f);
+        }
+    }
+    return polygons;
+}
+
+}  // namespace
+
+// ============================================================================
+// Filter Tests
+// ============================================================================
+
+TEST(PolygonQueryTest, Region_MatchesCellsMeetingIt) {
+    PolygonStore polygons = GridOfCells();
+    PolygonQuery query;
+    query.region = Rect(0, 0, 205, 105);  // Columns 0-2 of rows 0-1
+
+    PolygonQuery::Page page = query.Run(polygons, nullptr);
+    EXPECT_EQ(page.polygons, std::vector<uint32_t>({0, 1, 2, 10, 11, 12}));
+    EXPECT_EQ(page.total, 6u);
+    EXPECT_TRUE(page.done);
+}
+
+TEST(PolygonQueryTest, ClassAndConfidenceFilters) {
+    PolygonStore polygons = GridOfCells();
+    PolygonQuery query;
+    query.region = Rect(0, 0, 1000, 1000);
+    query.classes = {2};
+    query.minConfidence = 0.75f;  // Columns 8 and 9
+
+    PolygonQuery::Page page = query.Run(polygons, nullptr);
+    ASSERT_EQ(page.total, 10u);
+    for (uint32_t polygon : page.polygons) {
+        EXPECT_EQ(polygons.GetClassId(polygon), 2);
+        EXPECT_GE(polygons.GetConfidence(polygon), 0.75f);
+    }
+}
+
+// ============================================================================
+// Pagination Tests
+// ============================================================================
+
+TEST(PolygonQueryTest, Cursor_PagesCoverEveryMatchOnce) {
+    PolygonStore polygons = GridOfCells();
+    PolygonIndex index;
+    index.Build(polygons);
+
+    PolygonQuery query;
+    query.region = Rect(150, 150, 600, 600);
+    query.classes = {1};
+    query.limit = 7;
+    const PolygonQuery::Page all = [&] {
+        PolygonQuery whole = query;
+        whole.limit = PolygonQuery::MAX_LIMIT;
+        return whole.Run(polygons, nullptr);
+    }();
+    ASSERT_TRUE(all.done);
+
+    std::vector<uint32_t> paged;
+    for (int pages = 0; pages < 100; ++pages) {
+        PolygonQuery::Page page = query.Run(polygons, &index);
+        EXPECT_EQ(page.total, all.total);
+        EXPECT_LE(page.polygons.size(), 7u);
+        paged.insert(paged.end(), page.polygons.begin(), page.polygons.end());
+        if (page.done) {
+            break;
+        }
+        EXPECT_GT(page.nextCursor, page.polygons.back());
+        query.cursor = page.nextCursor;
+    }
+    EXPECT_EQ(paged, all.polygons);
+}
+
+TEST(PolygonQueryTest, Cursor_PastLastMatch_EmptyAndDone) {
+    PolygonStore polygons = GridOfCells();
+    PolygonQuery query;
+    query.region = Rect(0, 0, 50, 50);
+    query.cursor = 1;
+
+    PolygonQuery::Page page = query.Run(polygons, nullptr);
+    EXPECT_TRUE(page.polygons.empty());
+    EXPECT_EQ(page.total, 1u);
+    EXPECT_TRUE(page.done);
+}
+
+TEST(PolygonQueryTest, ExactlyFullPage_IsDone) {
+    PolygonStore polygons = GridOfCells();
+    PolygonQuery query;
+    query.region = Rect(0, 0, 1000, 50);  // Row 0: 10 cells
+    query.limit = 10;
+
+    PolygonQuery::Page page = query.Run(polygons, nullptr);
+    EXPECT_EQ(page.polygons.size(), 10u);
+    EXPECT_TRUE(page.done);
+}
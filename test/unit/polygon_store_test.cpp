@@ -0,0 +1,304 @@
+// PolygonStore Unit Tests
+// Tests for packed vertex storage, bounding boxes, the centroid, area and
+// confidence columns and the parallel triangulation with its simplified
+// triangle lists
+
+#include <gtest/gtest.h>
+#include "PolygonStore.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+// ============================================================================
+// Add / Layout Tests
+// ============================================================================
+
+TEST(PolygonStoreTest, Add_ComputesBoundingBoxAndKeepsVertices) {
+    PolygonStore store;
+    uint32_t index = store.Add(3, {Vec2(10, 20), Vec2(40, 25), Vec2(30, 60)});
+
+    EXPECT_EQ(index, 0u);
+    ASSERT_EQ(store.Size(), 1u);
+    EXPECT_EQ(store.GetClassId(index), 3);
+    ASSERT_EQ(store.GetVertexCount(index), 3u);
+    EXPECT_FLOAT_EQ(store.GetVertices(index)[1].x, 40.0f);
+    EXPECT_FLOAT_EQ(store.GetVertices(index)[1].y, 25.0f);
+
+    Rect box = store.GetBoundingBox(index);
+    EXPECT_DOUBLE_EQ(box.x, 10.0);
+    EXPECT_DOUBLE_EQ(box.y, 20.0);
+    EXPECT_DOUBLE_EQ(box.width, 30.0);
+    EXPECT_DOUBLE_EQ(box.height, 40.0);
+}
+
+TEST(PolygonStoreTest, Streaming_MatchesAdd) {
+    PolygonStore store;
+    store.Add(1, {Vec2(0, 0), Vec2(5, 0), Vec2(5, 5)});
+
+    store.BeginPolygon(2);
+    store.AddVertex(100, 100);
+    store.AddVertex(110, 100);
+    store.AddVertex(110, 120);
+    store.AddVertex(100, 120);
+    uint32_t index = store.EndPolygon();
+
+    EXPECT_EQ(index, 1u);
+    EXPECT_EQ(store.GetTotalVertexCount(), 7u);
+    EXPECT_EQ(store.GetVertexCount(index), 4u);
+    EXPECT_EQ(store.GetClassId(index), 2);
+    EXPECT_FLOAT_EQ(store.GetVertices(index)[0].x, 100.0f);
+    EXPECT_FLOAT_EQ(store.GetMaxY(index), 120.0f);
+}
+
+TEST(PolygonStoreTest, EmptyPolygon_HasZeroBoxAndNoTriangles) {
+    PolygonStore store;
+    uint32_t index = store.Add(0, std::vector<Vec2>{});
+
+    Rect box = store.GetBoundingBox(index);
+    EXPECT_DOUBLE_EQ(box.width, 0.0);
+    EXPECT_DOUBLE_EQ(box.height, 0.0);
+
+    store.TriangulateAll();
+    uint32_t count = 1;
+    store.GetTriangles(index, count);
+    EXPECT_EQ(count, 0u);
+}
+
+TEST(PolygonStoreTest, Intersects_MatchesRectSemantics) {
+    PolygonStore store;
+    uint32_t index = store.Add(0, {Vec2(100, 100), Vec2(150, 100), Vec2(150, 150)});
+
+    EXPECT_TRUE(store.Intersects(index, Rect(140, 140, 50, 50)));
+    EXPECT_TRUE(store.Intersects(index, Rect(150, 150, 10, 10)));  // Touching edge
+    EXPECT_FALSE(store.Intersects(index, Rect(200, 200, 10, 10)));
+}
+
+TEST(PolygonStoreTest, Contains_FollowsOutlineNotBox) {
+    PolygonStore store;
+    // An L: the box's top right quarter is outside the outline
+    uint32_t index = store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 20), Vec2(20, 20), Vec2(20, 30),
+                                   Vec2(0, 30)});
+
+    EXPECT_TRUE(store.Contains(index, 5, 5));
+    EXPECT_TRUE(store.Contains(index, 15, 25));
+    EXPECT_FALSE(store.Contains(index, 15, 5));  // In the box, outside the L
+    EXPECT_FALSE(store.Contains(index, 25, 25));
+    EXPECT_FALSE(store.Contains(store.Add(0, std::vector<Vec2>{}), 0, 0));
+}
+
+TEST(PolygonStoreTest, SlideScaleCoordinates_KeepSubPixelPrecision) {
+    PolygonStore store;
+    uint32_t index = store.Add(0, {Vec2(199999.25, 149999.5), Vec2(200004.75, 149999.5),
+                                   Vec2(200004.75, 150003.25)});
+    const Vec2f* v = store.GetVertices(index);
+    EXPECT_NEAR(v[0].x, 199999.25, 1.0 / 32);
+    EXPECT_NEAR(v[2].y, 150003.25, 1.0 / 32);
+}
+
+// ============================================================================
+// Centroid / Triangle Tests
+// ============================================================================
+
+TEST(PolygonStoreTest, GetCentroid_AveragesVertices) {
+    PolygonStore store;
+    uint32_t index = store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 20), Vec2(0, 20)});
+    Vec2 centroid = store.GetCentroid(index);
+    EXPECT_DOUBLE_EQ(centroid.x, 5.0);
+    EXPECT_DOUBLE_EQ(centroid.y, 10.0);
+}
+
+TEST(PolygonStoreTest, Attributes_AreaAndLoaderValues) {
+    PolygonStore store;
+    uint32_t square = store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 20), Vec2(0, 20)});
+    uint32_t clockwise = store.Add(0, {Vec2(0, 0), Vec2(0, 4), Vec2(4, 0)});
+    EXPECT_FLOAT_EQ(store.GetArea(square), 200.0f);
+    EXPECT_FLOAT_EQ(store.GetArea(clockwise), 8.0f);
+    EXPECT_FLOAT_EQ(store.GetConfidence(square), 1.0f);
+
+    store.SetConfidence(square, 0.25f);
+    store.SetCentroid(square, 4, 9);
+    EXPECT_FLOAT_EQ(store.GetConfidence(square), 0.25f);
+    EXPECT_DOUBLE_EQ(store.GetCentroid(square).x, 4.0);
+    EXPECT_DOUBLE_EQ(store.GetCentroid(square).y, 9.0);
+
+    // A centroid off the polygon's box keeps the vertex mean
+    store.SetCentroid(clockwise, 50, 1);
+    EXPECT_NEAR(store.GetCentroid(clockwise).x, 4.0 / 3.0, 1e-6);
+
+    PolygonStore copy;
+    copy.Append(store);
+    EXPECT_FLOAT_EQ(copy.GetConfidence(square), 0.25f);
+    EXPECT_FLOAT_EQ(copy.GetArea(clockwise), 8.0f);
+    EXPECT_DOUBLE_EQ(copy.GetCentroid(square).y, 9.0);
+}
+
+TEST(PolygonStoreTest, TriangulateAll_FillsEveryTriangleListOnce) {
+    PolygonStore store;
+    store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10), Vec2(0, 10)});
+    uint32_t pentagon = store.Add(1, {Vec2(0, 0), Vec2(10, 0), Vec2(12, 8), Vec2(5, 14), Vec2(-2, 8)});
+    EXPECT_EQ(store.GetTriangleMemoryUsage(), 0u);
+
+    // Nothing is triangulated on access
+    uint32_t count = 1;
+    store.GetTriangles(pentagon, count);
+    EXPECT_EQ(count, 0u);
+
+    store.TriangulateAll();
+    const uint32_t* triangles = store.GetTriangles(pentagon, count);
+    ASSERT_EQ(count, 9u);  // 3 triangles
+    for (uint32_t i = 0; i < count; ++i) {
+        EXPECT_LT(triangles[i], store.GetVertexCount(pentagon));
+    }
+    store.GetTriangles(0, count);
+    EXPECT_EQ(count, 6u);
+
+    size_t triangulated = store.GetTriangleMemoryUsage();
+    EXPECT_GT(triangulated, 0u);
+    store.TriangulateAll();
+    EXPECT_EQ(store.GetTriangleMemoryUsage(), triangulated);
+}
+
+TEST(PolygonStoreTest, TriangulateAll_SameResultOnAnyThreadCount) {
+    PolygonStore single;
+    for (int i = 0; i < 5000; ++i) {
+        std::vector<Vec2> outline;
+        const int vertexCount = 3 + i % 40;
+        for (int v = 0; v < vertexCount; ++v) {
+            double angle = v * 2.0 * M_PI / vertexCount;
+            double radius = 10 + (v % 3);
+            outline.emplace_back((i % 100) * 30 + radius * std::cos(angle), (i / 100) * 30 + radius * std::sin(angle));
+        }
+        single.Add(i % 5, outline);
+    }
+    PolygonStore parallel = single;
+
+    single.TriangulateAll(1);
+    parallel.TriangulateAll(4);
+    for (uint32_t polygon = 0; polygon < single.Size(); ++polygon) {
+        uint32_t expectedCount = 0;
+        uint32_t count = 0;
+        const uint32_t* expected = single.GetTriangles(polygon, expectedCount);
+        const uint32_t* triangles = parallel.GetTriangles(polygon, count);
+        ASSERT_EQ(count, expectedCount);
+        ASSERT_GT(count, 0u);
+        ASSERT_TRUE(std::equal(triangles, triangles + count, expected));
+
+        expected = single.GetSimplifiedTriangles(polygon, expectedCount);
+        triangles = parallel.GetSimplifiedTriangles(polygon, count);
+        ASSERT_EQ(count, expectedCount);
+        ASSERT_TRUE(std::equal(triangles, triangles + count, expected));
+    }
+    EXPECT_EQ(parallel.GetTriangleMemoryUsage(), single.GetTriangleMemoryUsage());
+}
+
+TEST(PolygonStoreTest, GetSimplifiedTriangles_DropsVerticesWithinTolerance) {
+    PolygonStore store;
+    std::vector<Vec2> circle;
+    for (int i = 0; i < 64; ++i) {
+        double angle = i * 2.0 * M_PI / 64;
+        circle.emplace_back(100 + 50 * std::cos(angle), 100 + 50 * std::sin(angle));
+    }
+    uint32_t polygon = store.Add(0, circle);
+    store.TriangulateAll();
+
+    uint32_t fullCount = 0;
+    uint32_t simplifiedCount = 0;
+    store.GetTriangles(polygon, fullCount);
+    const uint32_t* simplified = store.GetSimplifiedTriangles(polygon, simplifiedCount);
+    ASSERT_EQ(fullCount, 62u * 3);
+    ASSERT_GT(simplifiedCount, 0u);
+    EXPECT_LT(simplifiedCount, fullCount / 2);
+    EXPECT_EQ(simplifiedCount % 3, 0u);
+
+    // Kept vertices are the polygon's own, within tolerance of the circle
+    std::set<uint32_t> kept(simplified, simplified + simplifiedCount);
+    EXPECT_TRUE(kept.count(0));
+    for (uint32_t vertex : kept) {
+        ASSERT_LT(vertex, 64u);
+    }
+    const double tolerance = 100 * PolygonStore::SIMPLIFY_TOLERANCE;
+    auto next = kept.begin();
+    for (auto it = kept.begin(); it != kept.end(); ++it) {
+        uint32_t to = ++next == kept.end() ? 64 : *next;
+        double span = (to - *it) * 2.0 * M_PI / 64;
+        EXPECT_LE(50 * (1 - std::cos(span / 2)), tolerance + 1e-9);  // Chord sagitta
+    }
+}
+
+TEST(PolygonStoreTest, GetSimplifiedTriangles_SharesListWhenNothingDrops) {
+    PolygonStore store;
+    store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10), Vec2(0, 10)});
+    store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(12, 8), Vec2(5, 14), Vec2(-2, 8)});
+    store.TriangulateAll();
+
+    for (uint32_t polygon = 0; polygon < store.Size(); ++polygon) {
+        uint32_t fullCount = 0;
+        uint32_t simplifiedCount = 0;
+        const uint32_t* full = store.GetTriangles(polygon, fullCount);
+        const uint32_t* simplified = store.GetSimplifiedTriangles(polygon, simplifiedCount);
+        EXPECT_EQ(simplified, full);
+        EXPECT_EQ(simplifiedCount, fullCount);
+    }
+}
+
+TEST(PolygonStoreTest, Clear_RemovesEverything) {
+    PolygonStore store;
+    store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10)});
+    store.TriangulateAll();
+
+    store.Clear();
+    EXPECT_TRUE(store.Empty());
+    EXPECT_EQ(store.GetTotalVertexCount(), 0u);
+
+    uint32_t index = store.Add(4, {Vec2(1, 1), Vec2(2, 1), Vec2(2, 2)});
+    EXPECT_EQ(index, 0u);
+    EXPECT_EQ(store.GetClassId(index), 4);
+    store.TriangulateAll();
+    uint32_t count = 0;
+    store.GetTriangles(index, count);
+    EXPECT_EQ(count, 3u);
+}
+
+TEST(PolygonStoreTest, Append_ConcatenatesInOrder) {
+    PolygonStore first;
+    first.Add(1, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10)});
+    first.TriangulateAll();
+
+    PolygonStore second;
+    second.Add(2, {Vec2(100, 100), Vec2(110, 100), Vec2(110, 110), Vec2(100, 110)});
+    second.Add(3, {Vec2(200, 200), Vec2(210, 200), Vec2(210, 210)});
+    second.TriangulateAll();
+
+    first.Append(second);
+    ASSERT_EQ(first.Size(), 3u);
+    EXPECT_EQ(first.GetTotalVertexCount(), 10u);
+    EXPECT_EQ(first.GetClassId(1), 2);
+    EXPECT_EQ(first.GetVertexCount(2), 3u);
+    EXPECT_FLOAT_EQ(first.GetVertices(2)[0].x, 200.0f);
+    EXPECT_FLOAT_EQ(first.GetMinY(1), 100.0f);
+
+    // Triangulations come along, rebased onto the shared buffer
+    uint32_t count = 0;
+    const uint32_t* triangles = first.GetTriangles(1, count);
+    ASSERT_EQ(count, 6u);
+    for (uint32_t i = 0; i < count; ++i) {
+        EXPECT_LT(triangles[i], 4u);
+    }
+    first.GetTriangles(2, count);
+    EXPECT_EQ(count, 3u);
+    first.GetTriangles(0, count);
+    EXPECT_EQ(count, 3u);
+}
+
+TEST(PolygonStoreTest, RemapClassIds_ReplacesEveryId) {
+    PolygonStore store;
+    store.Add(0, {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10)});
+    store.Add(1, {Vec2(20, 0), Vec2(30, 0), Vec2(30, 10)});
+    store.Add(0, {Vec2(40, 0), Vec2(50, 0), Vec2(50, 10)});
+
+    store.RemapClassIds({5, 2});
+    EXPECT_EQ(store.GetClassId(0), 5);
+    EXPECT_EQ(store.GetClassId(1), 2);
+    EXPECT_EQ(store.GetClassId(2), 5);
+}
@@ -0,0 +1,237 @@
+// PolygonTileLayer Unit Tests
+// Tests for tile level selection, rasterizing cells into tiles at each LOD,
+// filled or outlined, and style changes invalidating only the tiles holding a changed class.
+// The layer tests use SDL's software renderer, so no window or GPU is required
+
+#include <gtest/gtest.h>
+#include "PolygonTileLayer.h"
+#include "PolygonIndex.h"
+#include "Viewport.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+
+constexpr int32_t TILE = PolygonTileLayer::TILE_SIZE;
+constexpr uint32_t RED = 0xFFFF0000;
+constexpr uint32_t BLUE = 0xFF0000FF;
+
+void AddRect(PolygonStore& polygons, int classId, double x0, double y0, double x1, double y1) {
+    polygons.Add(classId, {Vec2(x0, y0), Vec2(x1, y0), Vec2(x1, y1), Vec2(x0, y1)});
+}
+
+PolygonTileStyle RedBlueStyle() {
+    PolygonTileStyle style;
+    style.classColors = {{0, SDL_Color{255, 0, 0, 255}}, {1, SDL_Color{0, 0, 255, 255}}};
+    return style;
+}
+
+uint32_t Pixel(const std::vector<uint32_t>& pixels, int32_t x, int32_t y) {
+    return pixels[static_cast<size_t>(y) * TILE + x];
+}
+
+}  // namespace
+
+TEST(PolygonTileLayerTest, SelectLevel_TexelsNeverLargerThanScreenPixels) {
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(4.0), 0);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(1.0), 0);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(0.75), 0);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(0.5), 1);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(0.3), 1);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(0.25), 2);
+    EXPECT_EQ(PolygonTileLayer::SelectLevel(1.0 / 32), 5);
+}
+
+TEST(PolygonTileLayerTest, RasterizeTile_FillsPixelCentersInside) {
+    PolygonStore polygons;
+    AddRect(polygons, 0, 10, 20, 110, 70);
+    PolygonIndex index;
+    index.Build(polygons);
+
+    std::vector<uint32_t> pixels;
+    std::vector<int> classes;
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, RedBlueStyle(), {0, 0, 0}, pixels, classes));
+    ASSERT_EQ(pixels.size(), static_cast<size_t>(TILE) * TILE);
+    EXPECT_EQ(classes, std::vector<int>({0}));
+
+    EXPECT_EQ(Pixel(pixels, 10, 20), RED);
+    EXPECT_EQ(Pixel(pixels, 109, 69), RED);
+    EXPECT_EQ(Pixel(pixels, 9, 20), 0u);
+    EXPECT_EQ(Pixel(pixels, 110, 20), 0u);
+    EXPECT_EQ(Pixel(pixels, 10, 70), 0u);
+}
+
+TEST(PolygonTileLayerTest, RasterizeTile_OutlinesLeaveTheInsideClear) {
+    PolygonStore polygons;
+    AddRect(polygons, 0, 10, 20, 110, 70);
+    AddRect(polygons, 1, 200, 200, 206, 206);  // Box-sized
+    PolygonIndex index;
+    index.Build(polygons);
+    PolygonTileStyle style = RedBlueStyle();
+    style.outlines = true;
+    style.defaultOutlineWidth = 1.0f;
+    style.outlineWidths[1] = 3.0f;
+
+    std::vector<uint32_t> pixels;
+    std::vector<int> classes;
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, style, {0, 0, 0}, pixels, classes));
+    EXPECT_EQ(classes, std::vector<int>({0, 1}));
+    // Strokes are centered on the edges: one texel wide at y = 20 covers
+    // the row whose centers are at 19.5
+    EXPECT_EQ(Pixel(pixels, 60, 19), RED);  // Top edge
+    EXPECT_EQ(Pixel(pixels, 60, 20), 0u);
+    EXPECT_EQ(Pixel(pixels, 9, 45), RED);   // Left edge
+    EXPECT_EQ(Pixel(pixels, 60, 45), 0u);   // Inside
+    EXPECT_EQ(Pixel(pixels, 203, 198), BLUE);  // Three texels wide
+    EXPECT_EQ(Pixel(pixels, 203, 200), BLUE);
+    EXPECT_EQ(Pixel(pixels, 203, 202), 0u);
+}
+
+TEST(PolygonTileLayerTest, RasterizeTile_LaterPolygonsDrawnOnTop) {
+    PolygonStore polygons;
+    AddRect(polygons, 0, 0, 0, 100, 100);
+    AddRect(polygons, 1, 50, 50, 150, 150);
+    PolygonIndex index;
+    index.Build(polygons);
+
+    std::vector<uint32_t> pixels;
+    std::vector<int> classes;
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, RedBlueStyle(), {0, 0, 0}, pixels, classes));
+    EXPECT_EQ(classes, std::vector<int>({0, 1}));
+    EXPECT_EQ(Pixel(pixels, 25, 25), RED);
+    EXPECT_EQ(Pixel(pixels, 75, 75), BLUE);
+    EXPECT_EQ(Pixel(pixels, 125, 125), BLUE);
+}
+
+TEST(PolygonTileLayerTest, RasterizeTile_SmallCellsSkippedOrSimplified) {
+    PolygonStore polygons;
+    AddRect(polygons, 0, 10, 10, 11, 11);  // 1 texel: skipped
+    polygons.Add(1, {Vec2(100, 100), Vec2(103, 100), Vec2(100, 103)});  // 3 texels: a point
+    polygons.Add(1, {Vec2(200, 200), Vec2(208, 200), Vec2(200, 208)});  // 8 texels: its box
+    PolygonIndex index;
+    index.Build(polygons);
+
+    std::vector<uint32_t> pixels;
+    std::vector<int> classes;
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, RedBlueStyle(), {0, 0, 0}, pixels, classes));
+    EXPECT_EQ(classes, std::vector<int>({1}));
+    EXPECT_EQ(Pixel(pixels, 10, 10), 0u);
+
+    EXPECT_EQ(Pixel(pixels, 101, 101), BLUE);
+    EXPECT_EQ(Pixel(pixels, 100, 100), 0u);
+
+    EXPECT_EQ(Pixel(pixels, 207, 207), BLUE);  // Outside the triangle, inside its box
+    EXPECT_EQ(Pixel(pixels, 208, 208), 0u);
+}
+
+TEST(PolygonTileLayerTest, RasterizeTile_CoarserLevelsAndNeighbouringTiles) {
+    PolygonStore polygons;
+    AddRect(polygons, 0, TILE - 100, 0, TILE + 100, 100);  // Straddles tiles 0 and 1
+    PolygonIndex index;
+    index.Build(polygons);
+    const PolygonTileStyle style = RedBlueStyle();
+
+    std::vector<uint32_t> pixels;
+    std::vector<int> classes;
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, style, {0, 0, 0}, pixels, classes));
+    EXPECT_EQ(Pixel(pixels, TILE - 1, 0), RED);
+    EXPECT_EQ(Pixel(pixels, TILE - 101, 0), 0u);
+
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, style, {0, 1, 0}, pixels, classes));
+    EXPECT_EQ(Pixel(pixels, 0, 0), RED);
+    EXPECT_EQ(Pixel(pixels, 99, 99), RED);
+    EXPECT_EQ(Pixel(pixels, 100, 0), 0u);
+
+    // Level 1: two slide pixels per texel
+    ASSERT_TRUE(PolygonTileLayer::RasterizeTile(polygons, index, style, {1, 0, 0}, pixels, classes));
+    EXPECT_EQ(Pixel(pixels, TILE / 2 - 50, 0), RED);
+    EXPECT_EQ(Pixel(pixels, TILE / 2 + 49, 49), RED);
+    EXPECT_EQ(Pixel(pixels, TILE / 2 + 50, 0), 0u);
+
+    EXPECT_FALSE(PolygonTileLayer::RasterizeTile(polygons, index, style, {0, 0, 3}, pixels, classes));
+    EXPECT_TRUE(classes.empty());
+}
+
+// ============================================================================
+// Layer Tests
+// ============================================================================
+
+class PolygonTileLayerRenderTest : public ::testing::Test {
+protected:
+    SDL_Surface* surface = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    PolygonStore polygons;
+    PolygonIndex index;
+    std::unique_ptr<PolygonTileLayer> layer;
+
+    void SetUp() override {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, TILE, TILE, 32, SDL_PIXELFORMAT_RGBA32);
+        ASSERT_NE(surface, nullptr);
+        renderer = SDL_CreateSoftwareRenderer(surface);
+        ASSERT_NE(renderer, nullptr);
+
+        // Class 0 only in tile (0, 0), class 1 only in tile (1, 0)
+        AddRect(polygons, 0, 10, 10, 100, 100);
+        AddRect(polygons, 1, TILE + 10, 10, TILE + 100, 100);
+        index.Build(polygons);
+
+        layer = std::make_unique<PolygonTileLayer>(renderer, PolygonTileLayer::DEFAULT_MAX_MEMORY, 2);
+        layer->SetPolygons(&polygons, &index);
+        layer->SetStyle(RedBlueStyle(), {});
+    }
+
+    void TearDown() override {
+        layer.reset();
+        if (renderer) SDL_DestroyRenderer(renderer);
+        if (surface) SDL_FreeSurface(surface);
+    }
+
+    // Render until both tiles are current
+    bool RenderUntilCurrent(const Viewport& viewport) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            layer->Render(viewport, 1.0f);
+            if (layer->IsTileCurrent({0, 0, 0}) && layer->IsTileCurrent({0, 1, 0})) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+TEST_F(PolygonTileLayerRenderTest, Render_RasterizesAndUploadsVisibleTiles) {
+    Viewport viewport(TILE * 2, TILE, TILE * 2, TILE);
+    ASSERT_DOUBLE_EQ(viewport.GetZoom(), 1.0);
+
+    ASSERT_TRUE(RenderUntilCurrent(viewport));
+    EXPECT_GT(layer->GetMemoryUsage(), 0u);
+    EXPECT_FALSE(layer->HasPendingUploads());
+}
+
+TEST_F(PolygonTileLayerRenderTest, SetStyle_InvalidatesOnlyTilesWithChangedClass) {
+    Viewport viewport(TILE * 2, TILE, TILE * 2, TILE);
+    ASSERT_TRUE(RenderUntilCurrent(viewport));
+
+    PolygonTileStyle style = RedBlueStyle();
+    style.classColors[1] = SDL_Color{0, 255, 0, 255};
+    layer->SetStyle(style, {1});
+    EXPECT_TRUE(layer->IsTileCurrent({0, 0, 0}));
+    EXPECT_FALSE(layer->IsTileCurrent({0, 1, 0}));
+    ASSERT_TRUE(RenderUntilCurrent(viewport));
+
+    // No list: every tile
+    layer->SetStyle(style, {});
+    EXPECT_FALSE(layer->IsTileCurrent({0, 0, 0}));
+    EXPECT_FALSE(layer->IsTileCurrent({0, 1, 0}));
+}
+
+TEST_F(PolygonTileLayerRenderTest, Reset_DropsTiles) {
+    Viewport viewport(TILE * 2, TILE, TILE * 2, TILE);
+    ASSERT_TRUE(RenderUntilCurrent(viewport));
+
+    layer->Reset();
+    EXPECT_FALSE(layer->HasPolygons());
+    EXPECT_FALSE(layer->IsTileCurrent({0, 0, 0}));
+    EXPECT_EQ(layer->GetMemoryUsage(), 0u);
+}
@@ -1,11 +1,14 @@
 // PolygonTriangulator Unit Tests
-// Tests for ear-clipping triangulation algorithm
+// Tests for ear-clipping triangulation algorithm, with and without the
+// z-order index, polygons with holes, and Douglas-Peucker simplification
 // Critical for polygon rendering
 
 #include <gtest/gtest.h>
 #include "PolygonTriangulator.h"
+#include <algorithm>
 #include <vector>
 #include <set>
+#include <cmath>
 
 // ============================================================================
 // Test Fixture
@@ -27,6 +30,37 @@ protected:
         }
         return true;
     }
+
+    // Sum of the triangles' areas; equals the polygon's area when they tile it
+    double TriangleArea(const std::vector<Vec2>& vertices, const std::vector<int>& indices) {
+        double area = 0.0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const Vec2& a = vertices[indices[i]];
+            const Vec2& b = vertices[indices[i + 1]];
+            const Vec2& c = vertices[indices[i + 2]];
+            area += std::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) / 2.0;
+        }
+        return area;
+    }
+
+    double RingArea(const std::vector<Vec2>& ring) {
+        double sum = 0.0;
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            sum += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+        }
+        return std::abs(sum) / 2.0;
+    }
+
+    // Wobbly closed trace of n vertices, like a lasso annotation
+    std::vector<Vec2> Lasso(int n, double radius) {
+        std::vector<Vec2> vertices;
+        for (int i = 0; i < n; ++i) {
+            double angle = 2.0 * M_PI * i / n;
+            double r = radius * (1.0 + 0.2 * std::sin(angle * 7) + 0.05 * std::sin(angle * 53));
+            vertices.push_back(Vec2(r * cos(angle), r * sin(angle)));
+        }
+        return vertices;
+    }
 };
 
 // ============================================================================
@@ -370,3 +404,107 @@ TEST_F(PolygonTriangulatorTest, Triangulate_NoRepeatedTriangles_UniqueIndices) {
     // Number of unique triangles should equal total triangles
     EXPECT_EQ(unique_triangles.size(), indices.size() / 3);
 }
+
+// ============================================================================
+// Large Polygon Tests (z-order index)
+// ============================================================================
+
+TEST_F(PolygonTriangulatorTest, Triangulate_LargeLasso_TilesThePolygon) {
+    std::vector<Vec2> vertices = Lasso(20000, 1000.0);
+
+    std::vector<int> indices = PolygonTriangulator::Triangulate(vertices);
+
+    EXPECT_EQ(CountTriangles(indices), 20000 - 2);
+    EXPECT_TRUE(AllIndicesValid(indices, vertices.size()));
+    EXPECT_NEAR(TriangleArea(vertices, indices), RingArea(vertices), RingArea(vertices) * 1e-9);
+}
+
+TEST_F(PolygonTriangulatorTest, Triangulate_LargeConcaveComb_TilesThePolygon) {
+    // Comb with 100 teeth: every tooth tip is an ear, every gap reflex
+    std::vector<Vec2> vertices;
+    for (int tooth = 0; tooth < 100; ++tooth) {
+        vertices.push_back(Vec2(tooth * 10.0, 0));
+        vertices.push_back(Vec2(tooth * 10.0 + 5, 0));
+        vertices.push_back(Vec2(tooth * 10.0 + 5, 80));
+        vertices.push_back(Vec2(tooth * 10.0 + 10, 80));
+    }
+    vertices.push_back(Vec2(1000, 100));
+    vertices.push_back(Vec2(0, 100));
+    std::reverse(vertices.begin(), vertices.end());
+
+    std::vector<int> indices = PolygonTriangulator::Triangulate(vertices);
+
+    EXPECT_TRUE(AllIndicesValid(indices, vertices.size()));
+    EXPECT_NEAR(TriangleArea(vertices, indices), RingArea(vertices), 1e-6);
+}
+
+// ============================================================================
+// Hole Tests
+// ============================================================================
+
+TEST_F(PolygonTriangulatorTest, Triangulate_SquareWithHole_LeavesHoleUncovered) {
+    std::vector<Vec2> outer = {Vec2(0, 0), Vec2(10, 0), Vec2(10, 10), Vec2(0, 10)};
+    std::vector<Vec2> hole = {Vec2(3, 3), Vec2(3, 7), Vec2(7, 7), Vec2(7, 3)};
+
+    std::vector<int> indices = PolygonTriangulator::Triangulate(outer, {hole});
+
+    // Indices run over the outer ring, then the hole
+    std::vector<Vec2> all = outer;
+    all.insert(all.end(), hole.begin(), hole.end());
+    EXPECT_EQ(CountTriangles(indices), 8);  // n + 2h - 2
+    EXPECT_TRUE(AllIndicesValid(indices, all.size()));
+    EXPECT_NEAR(TriangleArea(all, indices), 100.0 - 16.0, 1e-9);
+    EXPECT_TRUE(std::find(indices.begin(), indices.end(), 4) != indices.end());
+}
+
+TEST_F(PolygonTriangulatorTest, Triangulate_ManyHoles_EitherWinding) {
+    std::vector<Vec2> outer = Lasso(2000, 1000.0);
+    std::vector<std::vector<Vec2>> holes;
+    double holeArea = 0.0;
+    for (int i = 0; i < 10; ++i) {
+        double x = -450.0 + i * 90.0;
+        std::vector<Vec2> hole = {Vec2(x, -20), Vec2(x + 40, -20), Vec2(x + 40, 20), Vec2(x, 20)};
+        if (i % 2) {
+            std::reverse(hole.begin(), hole.end());
+        }
+        holeArea += RingArea(hole);
+        holes.push_back(hole);
+    }
+
+    std::vector<int> indices = PolygonTriangulator::Triangulate(outer, holes);
+
+    std::vector<Vec2> all = outer;
+    for (const auto& hole : holes) {
+        all.insert(all.end(), hole.begin(), hole.end());
+    }
+    EXPECT_TRUE(AllIndicesValid(indices, all.size()));
+    EXPECT_NEAR(TriangleArea(all, indices), RingArea(outer) - holeArea, RingArea(outer) * 1e-9);
+}
+
+TEST_F(PolygonTriangulatorTest, Simplify_DroppedVerticesStayWithinTolerance) {
+    std::vector<Vec2> vertices = Lasso(20000, 1000.0);
+    for (double tolerance : {0.5, 2.0, 8.0, 32.0}) {
+        std::vector<uint32_t> kept;
+        PolygonTriangulator::Simplify(vertices, tolerance, kept);
+        ASSERT_GE(kept.size(), 3u);
+        EXPECT_LT(kept.size(), vertices.size());
+        EXPECT_EQ(kept[0], 0u);
+        EXPECT_TRUE(std::is_sorted(kept.begin(), kept.end()));
+
+        // Each dropped vertex against the kept edge that spans it
+        for (size_t k = 0; k < kept.size(); ++k) {
+            const Vec2& a = vertices[kept[k]];
+            const uint32_t last = k + 1 < kept.size() ? kept[k + 1] : uint32_t(vertices.size());
+            const Vec2& b = vertices[last % vertices.size()];
+            const double length = std::hypot(b.x - a.x, b.y - a.y);
+            for (uint32_t i = kept[k] + 1; i < last; ++i) {
+                const double cross = (b.x - a.x) * (vertices[i].y - a.y) - (b.y - a.y) * (vertices[i].x - a.x);
+                ASSERT_LE(std::abs(cross) / length, tolerance + 1e-9);
+            }
+        }
+    }
+
+    std::vector<uint32_t> kept = {7};
+    PolygonTriangulator::Simplify({}, 1.0, kept);
+    EXPECT_TRUE(kept.empty());
+}
@@ -0,0 +1,153 @@
+// PrefetchModel Unit Tests
+// Tests for learning stop-to-stop transitions from viewport traces, the
+// views predicted from them, and model files per slide type
+
+#include <gtest/gtest.h>
+#include "PrefetchModel.h"
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+// A sample showing center at zoom in an 800 x 600 window
+ViewportSample View(double timeMs, double centerX, double centerY, double zoom) {
+    return {timeMs, centerX - WIDTH / zoom / 2, centerY - HEIGHT / zoom / 2, zoom, WIDTH, HEIGHT};
+}
+
+// Reviews that stop on a low-power view, zoom into its top right ninth,
+// then go back out, count times, with frames of the zoom in between
+ViewportTrace ZoomIntoTopRight(int count) {
+    ViewportTrace trace;
+    double time = 0.0;
+    const double lowCenterX = 20000.0;
+    const double lowCenterY = 15000.0;
+    const double lowZoom = 1.0 / 16;
+    // Centre of the top right ninth of the low-power view
+    const double targetX = lowCenterX + WIDTH / lowZoom / 3;
+    const double targetY = lowCenterY - HEIGHT / lowZoom / 3;
+    for (int i = 0; i < count; ++i) {
+        trace.Append(View(time, lowCenterX, lowCenterY, lowZoom));
+        time += 2000.0;
+        for (int frame = 1; frame < 10; ++frame, time += 16.0) {
+            const double t = frame / 10.0;
+            trace.Append(View(time, lowCenterX + (targetX - lowCenterX) * t, lowCenterY + (targetY - lowCenterY) * t,
+                              lowZoom * (1.0 + 3.0 * t)));
+        }
+        trace.Append(View(time, targetX, targetY, 0.25));
+        time += 2000.0;
+    }
+    return trace;
+}
+
+}  // namespace
+
+TEST(PrefetchModelTest, Empty_PredictsNothing) {
+    PrefetchModel model;
+    EXPECT_TRUE(model.IsEmpty());
+    EXPECT_TRUE(model.Predict(Vec2(0.0, 0.0), 0.25, WIDTH, HEIGHT).empty());
+
+    // Too few transitions from an octave
+    model.Learn(ZoomIntoTopRight(2));
+    EXPECT_FALSE(model.IsEmpty());
+    EXPECT_TRUE(model.Predict(Vec2(20000.0, 15000.0), 1.0 / 16, WIDTH, HEIGHT).empty());
+}
+
+TEST(PrefetchModelTest, Octave_RoundsAndClamps) {
+    EXPECT_EQ(PrefetchModel::Octave(1.0), static_cast<size_t>(-PrefetchModel::MIN_OCTAVE));
+    EXPECT_EQ(PrefetchModel::Octave(0.26), PrefetchModel::Octave(0.25));
+    EXPECT_EQ(PrefetchModel::Octave(1e-9), 0u);
+    EXPECT_EQ(PrefetchModel::Octave(64.0), PrefetchModel::OCTAVES - 1);
+    EXPECT_EQ(PrefetchModel::Octave(0.0), 0u);
+}
+
+TEST(PrefetchModelTest, Learn_ZoomInLandsWhereReviewersWent) {
+    PrefetchModel model;
+    model.Learn(ZoomIntoTopRight(10));
+    // 10 zoom-ins and 9 zoom-outs; the frames between are not stops
+    EXPECT_DOUBLE_EQ(model.GetTransitionCount(), 19.0);
+
+    // Another low-power view: the zoom goes to its top right ninth
+    const Vec2 center(5000.0, 5000.0);
+    std::vector<PrefetchModel::Prediction> predictions = model.Predict(center, 1.0 / 16, WIDTH, HEIGHT);
+    ASSERT_EQ(predictions.size(), 1u);
+    EXPECT_DOUBLE_EQ(predictions[0].probability, 1.0);
+    EXPECT_DOUBLE_EQ(predictions[0].view.zoom, 0.25);
+    EXPECT_DOUBLE_EQ(predictions[0].view.center.x, center.x + WIDTH * 16.0 / 3);
+    EXPECT_DOUBLE_EQ(predictions[0].view.center.y, center.y - HEIGHT * 16.0 / 3);
+
+    // From high power, back out over the same place
+    predictions = model.Predict(center, 0.25, WIDTH, HEIGHT);
+    ASSERT_EQ(predictions.size(), 1u);
+    EXPECT_DOUBLE_EQ(predictions[0].view.zoom, 1.0 / 16);
+    EXPECT_DOUBLE_EQ(predictions[0].view.center.x, center.x);
+}
+
+TEST(PrefetchModelTest, Learn_PansKeepTheirDirectionAndLength) {
+    // A sweep left to right, three quarters of a view at a time, with one
+    // step down for every three to the right
+    ViewportTrace trace;
+    const double zoom = 0.5;
+    const double stepX = 0.75 * WIDTH / zoom;
+    const double stepY = 0.75 * HEIGHT / zoom;
+    Vec2 center(1000.0, 1000.0);
+    for (int i = 0; i < 40; ++i) {
+        trace.Append(View(i * 1000.0, center.x, center.y, zoom));
+        center = i % 4 == 3 ? center + Vec2(0.0, stepY) : center + Vec2(stepX, 0.0);
+    }
+    PrefetchModel model;
+    model.Learn(trace);
+
+    std::vector<PrefetchModel::Prediction> predictions = model.Predict(Vec2(0.0, 0.0), zoom, WIDTH, HEIGHT);
+    ASSERT_EQ(predictions.size(), 2u);
+    EXPECT_NEAR(predictions[0].probability, 0.75, 0.03);
+    EXPECT_NEAR(predictions[0].view.center.x, stepX, 1e-6);
+    EXPECT_NEAR(predictions[0].view.center.y, 0.0, 1e-6);
+    EXPECT_NEAR(predictions[1].view.center.x, 0.0, 1e-6);
+    EXPECT_NEAR(predictions[1].view.center.y, 0.75 * HEIGHT / zoom, 1e-6);
+
+    // Limits
+    EXPECT_EQ(model.Predict(Vec2(0.0, 0.0), zoom, WIDTH, HEIGHT, 1).size(), 1u);
+    EXPECT_EQ(model.Predict(Vec2(0.0, 0.0), zoom, WIDTH, HEIGHT, 4, 0.5).size(), 1u);
+}
+
+TEST(PrefetchModelTest, SaveLoad_PerSlideType) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "pathview_prefetch_model_test.json").string();
+    std::remove(path.c_str());
+
+    PrefetchModel learned;
+    learned.Learn(ZoomIntoTopRight(10));
+    ASSERT_TRUE(learned.Save(path, "aperio-40x"));
+    ASSERT_TRUE(PrefetchModel().Save(path, "default"));
+
+    PrefetchModel loaded;
+    ASSERT_TRUE(loaded.Load(path, "aperio-40x"));
+    EXPECT_EQ(loaded.ToJson(), learned.ToJson());
+
+    // Unknown types get the default model
+    PrefetchModel fallback;
+    ASSERT_TRUE(fallback.Load(path, "hamamatsu"));
+    EXPECT_TRUE(fallback.IsEmpty());
+
+    EXPECT_FALSE(PrefetchModel().Load(path + ".missing", "aperio-40x"));
+    std::remove(path.c_str());
+}
+
+TEST(PrefetchModelTest, FromJson_RejectsMalformedModels) {
+    PrefetchModel model;
+    model.Learn(ZoomIntoTopRight(10));
+    PrefetchModel::json json = model.ToJson();
+    json["next"][0] = {1.0, 2.0};
+    EXPECT_FALSE(model.FromJson(json));
+    EXPECT_FALSE(model.FromJson(PrefetchModel::json::array()));
+    EXPECT_FALSE(model.IsEmpty());  // Unchanged
+}
+
+TEST(PrefetchModelTest, SlideType) {
+    EXPECT_EQ(PrefetchModel::SlideType("aperio", 40.0), "aperio-40x");
+    EXPECT_EQ(PrefetchModel::SlideType("hamamatsu", 0.0), "hamamatsu");
+    EXPECT_EQ(PrefetchModel::SlideType("", 20.0), "default");
+}
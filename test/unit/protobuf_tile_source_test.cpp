@@ -0,0 +1,301 @@
+// ProtobufTileSource Unit Tests
+// Tests for random access to version 1 segmentation files: the one-pass
+// tile index (offsets, bounds, counts, cell types, tissue maps), parsing
+// single tiles, the decoded tile LRU and its eviction, viewport requests
+// on the worker threads, malformed files, and ProtobufPolygonLoader
+// loading through the index.
+
+#include <gtest/gtest.h>
+#include "ProtobufTileSource.h"
+#include "ProtobufPolygonLoader.h"
+#include "PolygonStore.h"
+#include "cell_polygons.pb.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A grid of columns x rows level 0 tiles (max level 1: scale 2), each
+// 100 tile pixels on a side with cellsPerTile squares of 4 pixels
+DataProtoPolygon::SlideSegmentationData Grid(int columns, int rows, int cellsPerTile) {
+    DataProtoPolygon::SlideSegmentationData slide;
+    slide.set_slide_id("grid");
+    slide.set_slide_path("/slides/grid.svs");
+    slide.set_mpp(0.5f);
+    slide.set_max_level(1);
+    slide.set_cell_model_name("cells");
+    slide.set_tissue_model_name("tissue");
+    slide.set_tissue_empty_class(0);
+    (*slide.mutable_tissue_class_mapping())[1] = "tumor";
+
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            auto* tile = slide.add_tiles();
+            tile->set_tile_id(std::to_string(column) + "_" + std::to_string(row));
+            tile->set_level(0);
+            tile->set_x(static_cast<float>(column));
+            tile->set_y(static_cast<float>(row));
+            tile->set_width(100);
+            tile->set_height(100);
+            for (int i = 0; i < cellsPerTile; ++i) {
+                auto* mask = tile->add_masks();
+                mask->set_cell_id(i);
+                mask->set_cell_type(i % 2 == 0 ? "Tumor" : "Stroma");
+                mask->set_confidence(0.5f);
+                float x = 10.0f * i;
+                for (auto [dx, dy] : {std::pair{0, 0}, {4, 0}, {4, 4}, {0, 4}}) {
+                    auto* point = mask->add_coordinates();
+                    point->set_x(x + dx);
+                    point->set_y(10.0f + dy);
+                }
+                mask->mutable_centroid()->set_x(x + 2.0f);
+                mask->mutable_centroid()->set_y(12.0f);
+            }
+            auto* map = tile->mutable_tissue_segmentation_map();
+            map->set_data(std::string(10 * 10, '\1'));
+            map->set_width(10);
+            map->set_height(10);
+            map->set_dtype("uint8");
+        }
+    }
+    return slide;
+}
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class ProtobufTileSourceTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_tile_source_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    std::string Save(const std::string& bytes) {
+        std::string path = (root / "cells.pb").string();
+        std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+
+    std::string Save(const DataProtoPolygon::SlideSegmentationData& slide) {
+        return Save(slide.SerializeAsString());
+    }
+};
+
+// ============================================================================
+// Index Tests
+// ============================================================================
+
+TEST_F(ProtobufTileSourceTest, Open_IndexesEveryTile) {
+    auto slide = Grid(3, 2, 5);
+    std::string bytes = slide.SerializeAsString();
+    ProtobufTileSource source;
+    ASSERT_TRUE(source.Open(Save(bytes))) << source.GetError();
+
+    EXPECT_EQ(source.GetSlideId(), "grid");
+    EXPECT_EQ(source.GetMaxLevel(), 1);
+    EXPECT_EQ(source.GetTissueClassMapping().at(1), "tumor");
+    const std::vector<std::string>& cellTypes = source.GetCellTypes().GetNames();
+    EXPECT_EQ(std::set<std::string>(cellTypes.begin(), cellTypes.end()), (std::set<std::string>{"Stroma", "Tumor"}));
+    EXPECT_TRUE(source.GetCellTypes().IsFrozen());
+    EXPECT_EQ(source.GetCellCount(), 30u);
+    EXPECT_EQ(source.GetVertexCount(), 120u);
+
+    const auto& tiles = source.GetTiles();
+    ASSERT_EQ(tiles.size(), 6u);
+    // Column 2, row 1 at level 0: scale 2
+    const auto& tile = tiles[5];
+    EXPECT_DOUBLE_EQ(tile.bounds.x, 400.0);
+    EXPECT_DOUBLE_EQ(tile.bounds.y, 200.0);
+    EXPECT_DOUBLE_EQ(tile.bounds.width, 200.0);
+    EXPECT_EQ(tile.cellCount, 5u);
+    EXPECT_EQ(tile.tissueWidth, 10);
+    EXPECT_EQ(tile.tissueSize, 100u);
+    EXPECT_EQ(tile.tissueDtype, "uint8");
+    ASSERT_NE(tile.tissueData, nullptr);
+    EXPECT_EQ(tile.tissueData[0], 1);
+
+    // The recorded range is exactly the encoded tile
+    DataProtoPolygon::TileSegmentationData parsed;
+    ASSERT_TRUE(parsed.ParseFromArray(bytes.data() + tile.offset, static_cast<int>(tile.size)));
+    EXPECT_EQ(parsed.tile_id(), "2_1");
+}
+
+TEST_F(ProtobufTileSourceTest, Open_MalformedOrTruncated_Fails) {
+    std::string bytes = Grid(2, 2, 3).SerializeAsString();
+    ProtobufTileSource truncated;
+    EXPECT_FALSE(truncated.Open(Save(bytes.substr(0, bytes.size() - 7))));
+    EXPECT_FALSE(truncated.GetError().empty());
+
+    ProtobufTileSource missing;
+    EXPECT_FALSE(missing.Open((root / "missing.pb").string()));
+}
+
+TEST_F(ProtobufTileSourceTest, QueryTiles_MeetsRegionOnly) {
+    ProtobufTileSource source;
+    ASSERT_TRUE(source.Open(Save(Grid(4, 4, 1))));
+    std::vector<size_t> tiles;
+    source.QueryTiles(Rect(250, 250, 100, 100), tiles);
+    // Inside column 1, row 1 (slide 200-400)
+    EXPECT_EQ(tiles, (std::vector<size_t>{5}));
+    source.QueryTiles(Rect(-1000, -1000, 500, 500), tiles);
+    EXPECT_TRUE(tiles.empty());
+}
+
+// ============================================================================
+// Decode and Cache Tests
+// ============================================================================
+
+TEST_F(ProtobufTileSourceTest, DecodeTile_ConvertsToSlideSpace) {
+    ProtobufTileSource source;
+    ASSERT_TRUE(source.Open(Save(Grid(2, 2, 2))));
+    source.SetClassMapping({{"Stroma", 1}, {"Tumor", 2}});
+
+    PolygonStore polygons;
+    ASSERT_TRUE(source.DecodeTile(3, polygons));
+    ASSERT_EQ(polygons.Size(), 2u);
+    EXPECT_EQ(polygons.GetClassId(0), 2);
+    EXPECT_EQ(polygons.GetClassId(1), 1);
+    // Tile (1, 1): (x + 100) * 2
+    const Vec2f* square = polygons.GetVertices(1);
+    EXPECT_FLOAT_EQ(square[0].x, 220.0f);
+    EXPECT_FLOAT_EQ(square[0].y, 220.0f);
+    EXPECT_DOUBLE_EQ(polygons.GetCentroid(1).x, 224.0);
+    EXPECT_FLOAT_EQ(polygons.GetConfidence(1), 0.5f);
+    EXPECT_FALSE(source.DecodeTile(4, polygons));
+}
+
+TEST_F(ProtobufTileSourceTest, GetTile_DecodesOnceThenHits) {
+    ProtobufTileSource source;
+    ASSERT_TRUE(source.Open(Save(Grid(2, 2, 3))));
+    EXPECT_EQ(source.TryGetTile(1), nullptr);
+
+    auto first = source.GetTile(1);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->Size(), 3u);
+    EXPECT_EQ(source.GetTile(1), first);
+    EXPECT_EQ(source.TryGetTile(1), first);
+    EXPECT_EQ(source.GetDecodeCount(), 1u);
+    EXPECT_EQ(source.GetCachedTileCount(), 1u);
+    EXPECT_GT(source.GetCachedBytes(), 0u);
+}
+
+TEST_F(ProtobufTileSourceTest, GetTile_EvictsLeastRecentlyUsed) {
+    // Room for about two decoded tiles
+    ProtobufTileSource probe;
+    ASSERT_TRUE(probe.Open(Save(Grid(4, 1, 20))));
+    size_t tileBytes = probe.GetTile(0) ? probe.GetCachedBytes() : 0;
+    ASSERT_GT(tileBytes, 0u);
+
+    ProtobufTileSource source(tileBytes * 2 + tileBytes / 2, 1);
+    ASSERT_TRUE(source.Open((root / "cells.pb").string()));
+    source.GetTile(0);
+    source.GetTile(1);
+    source.GetTile(0);  // Now 1 is the oldest
+    source.GetTile(2);
+    EXPECT_EQ(source.GetCachedTileCount(), 2u);
+    EXPECT_LE(source.GetCachedBytes(), source.GetCacheCapacity());
+    EXPECT_NE(source.TryGetTile(0), nullptr);
+    EXPECT_EQ(source.TryGetTile(1), nullptr);
+    EXPECT_NE(source.TryGetTile(2), nullptr);
+}
+
+TEST_F(ProtobufTileSourceTest, Request_DecodesViewAndRingOnWorkers) {
+    ProtobufTileSource source(ProtobufTileSource::DEFAULT_CACHE_BYTES, 2);
+    ASSERT_TRUE(source.Open(Save(Grid(8, 8, 4))));
+
+    // Inside tile (3, 3); the 150 pixel ring reaches its eight neighbours
+    source.Request(Rect(650, 650, 100, 100), 150.0);
+    source.WaitIdle();
+    EXPECT_EQ(source.GetDecodeCount(), 9u);
+    EXPECT_NE(source.TryGetTile(3 * 8 + 3), nullptr);
+    EXPECT_NE(source.TryGetTile(2 * 8 + 4), nullptr);
+    EXPECT_EQ(source.TryGetTile(0), nullptr);
+
+    // Asking again decodes nothing new
+    source.Request(Rect(650, 650, 100, 100), 150.0);
+    source.WaitIdle();
+    EXPECT_EQ(source.GetDecodeCount(), 9u);
+}
+
+TEST_F(ProtobufTileSourceTest, Request_KeepsViewTilesOverBudget) {
+    // A budget below one tile still keeps the requested view
+    ProtobufTileSource source(1, 1);
+    ASSERT_TRUE(source.Open(Save(Grid(4, 4, 4))));
+    source.Request(Rect(250, 250, 10, 10), 0.0);
+    source.WaitIdle();
+    EXPECT_NE(source.TryGetTile(5), nullptr);
+
+    // Tiles outside it go as soon as they are used
+    ASSERT_NE(source.GetTile(0), nullptr);
+    EXPECT_EQ(source.TryGetTile(0), nullptr);
+    EXPECT_NE(source.TryGetTile(5), nullptr);
+}
+
+// ============================================================================
+// Loader Tests
+// ============================================================================
+
+TEST_F(ProtobufTileSourceTest, ProtobufLoader_LoadsThroughIndex) {
+    std::string path = Save(Grid(5, 4, 6));
+    ProtobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+
+    EXPECT_EQ(polygons.Size(), 120u);
+    EXPECT_EQ(polygons.GetTotalVertexCount(), 480u);
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_EQ(colors.size(), 2u);
+    std::unique_ptr<TissueMap> tissue = loader.TakeTissueMap();
+    ASSERT_NE(tissue, nullptr);
+    EXPECT_EQ(tissue->GetClassNames().at(1), "tumor");
+
+    // Truncated files fail as a whole
+    std::string bytes = Grid(5, 4, 6).SerializeAsString();
+    EXPECT_FALSE(loader.Load(Save(bytes.substr(0, bytes.size() / 2)), polygons, colors, names));
+}
+
+TEST_F(ProtobufTileSourceTest, ProtobufLoader_StreamsNearestTilesFirst) {
+    std::string path = Save(Grid(40, 40, 1));
+    ProtobufPolygonLoader loader;
+    std::vector<size_t> batchSizes;
+    Rect firstBounds;
+    PolygonStreamCallbacks callbacks;
+    callbacks.focus = [] { return Vec2(7900.0, 7900.0); };
+    callbacks.onBatch = [&](PolygonStore&& batch, float) {
+        if (batchSizes.empty()) {
+            firstBounds = batch.GetBoundingBox(0);
+        }
+        batchSizes.push_back(batch.Size());
+        return true;
+    };
+    ASSERT_TRUE(loader.LoadStreaming(path, callbacks));
+
+    size_t total = 0;
+    for (size_t size : batchSizes) {
+        total += size;
+    }
+    EXPECT_EQ(total, 1600u);
+    EXPECT_GT(batchSizes.size(), 1u);
+    // The first batch comes from around the focus, the far corner
+    EXPECT_GT(firstBounds.x, 4000.0);
+    EXPECT_GT(firstBounds.y, 4000.0);
+}
@@ -0,0 +1,174 @@
+// PyramidLayout Unit Tests
+// Tests for inserting synthesized levels into sparse pyramids, per-level
+// tile grids aligned to native tiles, and the 2x box filter
+
+#include <gtest/gtest.h>
+#include "PyramidLayout.h"
+#include <vector>
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class PyramidLayoutTest : public ::testing::Test {
+protected:
+    static constexpr int32_t TILE_SIZE = 512;
+
+    // Three-level scan (1x, 4x, 16x) of a 40000 x 32000 slide
+    PyramidLayout MakeSparseLayout(bool synthesize = true) {
+        return PyramidLayout({1.0, 4.0, 16.0},
+                             {{40000, 32000}, {10000, 8000}, {2500, 2000}},
+                             TILE_SIZE, synthesize);
+    }
+
+    static uint32_t Pixel(uint8_t a, uint8_t r, uint8_t g, uint8_t b) {
+        return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) |
+               (static_cast<uint32_t>(g) << 8) | b;
+    }
+};
+
+// ============================================================================
+// Layout Tests
+// ============================================================================
+
+TEST_F(PyramidLayoutTest, SparsePyramid_FillsPowerOfTwoGaps) {
+    PyramidLayout layout = MakeSparseLayout();
+
+    ASSERT_GE(layout.GetLevelCount(), 5);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(0), 1.0);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(1), 2.0);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(2), 4.0);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(3), 8.0);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(4), 16.0);
+
+    EXPECT_FALSE(layout.IsSynthesized(0));
+    EXPECT_TRUE(layout.IsSynthesized(1));
+    EXPECT_FALSE(layout.IsSynthesized(2));
+    EXPECT_EQ(layout.GetLevel(2).sourceLevel, 1);
+    EXPECT_EQ(layout.GetLevel(4).sourceLevel, 2);
+}
+
+TEST_F(PyramidLayoutTest, SynthesizedLevel_HalvesFinerDimensions) {
+    PyramidLayout layout({1.0, 4.0}, {{1001, 777}, {250, 194}}, TILE_SIZE);
+
+    LevelDimensions dims = layout.GetLevelDimensions(1);
+    EXPECT_EQ(dims.width, 501);
+    EXPECT_EQ(dims.height, 389);
+}
+
+TEST_F(PyramidLayoutTest, CoarsestLevel_ContinuesUntilOneTile) {
+    PyramidLayout layout = MakeSparseLayout();
+
+    // 16x is 2500 x 2000: 32x, 64x and 128x follow (last is 313 x 250)
+    LevelDimensions last = layout.GetLevelDimensions(layout.GetLevelCount() - 1);
+    EXPECT_LE(last.width, TILE_SIZE);
+    EXPECT_LE(last.height, TILE_SIZE);
+    EXPECT_DOUBLE_EQ(layout.GetLevelDownsample(layout.GetLevelCount() - 1), 128.0);
+    EXPECT_EQ(layout.GetSynthesizedLevelCount(), 5u);
+}
+
+TEST_F(PyramidLayoutTest, DensePyramid_AddsNothingBetweenLevels) {
+    PyramidLayout layout({1.0, 2.0, 4.0}, {{1024, 1024}, {512, 512}, {256, 256}}, TILE_SIZE);
+
+    EXPECT_EQ(layout.GetLevelCount(), 3);
+    EXPECT_EQ(layout.GetSynthesizedLevelCount(), 0u);
+}
+
+TEST_F(PyramidLayoutTest, SynthesizeDisabled_MirrorsSlide) {
+    PyramidLayout layout = MakeSparseLayout(false);
+
+    EXPECT_EQ(layout.GetLevelCount(), 3);
+    EXPECT_EQ(layout.GetSynthesizedLevelCount(), 0u);
+}
+
+// ============================================================================
+// Tile Grid Tests
+// ============================================================================
+
+TEST_F(PyramidLayoutTest, AlignTileSize_RoundsToNativeMultiple) {
+    EXPECT_EQ(PyramidLayout::AlignTileSize(240, TILE_SIZE), 480);
+    EXPECT_EQ(PyramidLayout::AlignTileSize(256, TILE_SIZE), 512);
+    EXPECT_EQ(PyramidLayout::AlignTileSize(8, TILE_SIZE), 512);     // Strip height
+    EXPECT_EQ(PyramidLayout::AlignTileSize(2048, TILE_SIZE), 2048);  // Never splits a native tile
+}
+
+TEST_F(PyramidLayoutTest, AlignTileSize_UnknownOrHuge_KeepsPreferred) {
+    EXPECT_EQ(PyramidLayout::AlignTileSize(0, TILE_SIZE), TILE_SIZE);
+    EXPECT_EQ(PyramidLayout::AlignTileSize(PyramidLayout::MAX_TILE_SIZE + 1, TILE_SIZE), TILE_SIZE);
+}
+
+TEST_F(PyramidLayoutTest, AlignTileSize_OddMultiple_StaysEven) {
+    EXPECT_EQ(PyramidLayout::AlignTileSize(171, TILE_SIZE) % 2, 0);
+}
+
+TEST_F(PyramidLayoutTest, NativeTileSizes_SetGridAndAreInherited) {
+    PyramidLayout layout({1.0, 4.0}, {{10000, 8000}, {2500, 2000}}, TILE_SIZE, true,
+                         {{240, 240}, {2048, 8}});
+
+    EXPECT_EQ(layout.GetTileWidth(0), 480);
+    EXPECT_EQ(layout.GetTileHeight(0), 480);
+    ASSERT_TRUE(layout.IsSynthesized(1));
+    EXPECT_EQ(layout.GetTileWidth(1), 480);  // Same grid as its children
+    EXPECT_EQ(layout.GetTileWidth(2), 2048);
+    EXPECT_EQ(layout.GetTileHeight(2), 512);
+}
+
+TEST_F(PyramidLayoutTest, NoNativeTileSizes_UsesPreferred) {
+    PyramidLayout layout = MakeSparseLayout();
+
+    for (int32_t i = 0; i < layout.GetLevelCount(); ++i) {
+        EXPECT_EQ(layout.GetTileWidth(i), TILE_SIZE);
+        EXPECT_EQ(layout.GetTileHeight(i), TILE_SIZE);
+    }
+}
+
+// ============================================================================
+// Downsample Tests
+// ============================================================================
+
+TEST_F(PyramidLayoutTest, Downsample2x_AveragesEachChannel) {
+    std::vector<uint32_t> src = {
+        Pixel(255, 0, 0, 0),   Pixel(255, 100, 0, 0),
+        Pixel(255, 0, 200, 0), Pixel(255, 0, 0, 40),
+    };
+    uint32_t dst = 0;
+
+    PyramidLayout::Downsample2x(src.data(), 2, 2, 2, &dst, 1);
+
+    EXPECT_EQ(dst, Pixel(255, 25, 50, 10));
+}
+
+TEST_F(PyramidLayoutTest, Downsample2x_RoundsToNearest) {
+    // Red sums to 3 (0.75 rounds to 1), green to 5 (1.25 rounds to 1)
+    std::vector<uint32_t> src = {
+        Pixel(255, 1, 2, 0), Pixel(255, 1, 1, 0),
+        Pixel(255, 1, 1, 0), Pixel(255, 0, 1, 0),
+    };
+    uint32_t dst = 0;
+
+    PyramidLayout::Downsample2x(src.data(), 2, 2, 2, &dst, 1);
+
+    EXPECT_EQ(dst, Pixel(255, 1, 1, 0));
+}
+
+TEST_F(PyramidLayoutTest, Downsample2x_OddSize_RepeatsEdge) {
+    // 3x1 image: last output column averages the edge pixel with itself
+    std::vector<uint32_t> src = {Pixel(255, 10, 0, 0), Pixel(255, 30, 0, 0), Pixel(255, 200, 0, 0)};
+    std::vector<uint32_t> dst(2, 0);
+
+    PyramidLayout::Downsample2x(src.data(), 3, 1, 3, dst.data(), 2);
+
+    EXPECT_EQ(dst[0], Pixel(255, 20, 0, 0));
+    EXPECT_EQ(dst[1], Pixel(255, 200, 0, 0));
+}
+
+TEST_F(PyramidLayoutTest, Downsample2x_RespectsDestinationStride) {
+    std::vector<uint32_t> src(4 * 4, Pixel(255, 8, 8, 8));
+    std::vector<uint32_t> dst(2 * 5, 0);
+
+    PyramidLayout::Downsample2x(src.data(), 4, 4, 4, dst.data(), 5);
+
+    EXPECT_EQ(dst[0], Pixel(255, 8, 8, 8));
+    EXPECT_EQ(dst[6], Pixel(255, 8, 8, 8));
+    EXPECT_EQ(dst[2], 0u);  // Outside the 2x2 output
+}
@@ -0,0 +1,130 @@
+// RegionOverlay Unit Tests
+// Tests for filled polygons and outlines drawn at an origin and downsample,
+// layers blended at their opacity without overlapping shapes darkening
+// each other, drawing across several bands, and indexed overlays drawn in
+// parts
+
+#include <gtest/gtest.h>
+#include "RegionOverlay.h"
+#include <vector>
+
+namespace {
+
+constexpr uint32_t WHITE = 0xFFFFFFFF;
+constexpr uint32_t RED = 0xFF0000;
+
+std::vector<Vec2> Square(double x, double y, double size) {
+    return {{x, y}, {x + size, y}, {x + size, y + size}, {x, y + size}};
+}
+
+uint32_t At(const std::vector<uint32_t>& pixels, int32_t width, int32_t column, int32_t row) {
+    return pixels[static_cast<size_t>(row) * width + column];
+}
+
+}  // namespace
+
+TEST(RegionOverlayTest, FillsAtOriginAndDownsample) {
+    RegionOverlay overlay;
+    size_t layer = overlay.AddLayer(1.0f);
+    overlay.AddPolygon(layer, Square(1000.0, 2000.0, 40.0), RED);
+    EXPECT_EQ(overlay.GetShapeCount(), 1u);
+
+    // 4x from (1000, 2000): the square covers 10 x 10 pixels
+    std::vector<uint32_t> pixels(32 * 32, WHITE);
+    overlay.Draw(pixels.data(), 32, 32, 1000.0, 2000.0, 4.0);
+    EXPECT_EQ(At(pixels, 32, 0, 0), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 32, 9, 9), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 32, 10, 0), WHITE);
+    EXPECT_EQ(At(pixels, 32, 0, 10), WHITE);
+}
+
+TEST(RegionOverlayTest, LayerOpacity_OverlapsDoNotDarken) {
+    RegionOverlay overlay;
+    size_t layer = overlay.AddLayer(0.5f);
+    overlay.AddPolygon(layer, Square(0.0, 0.0, 8.0), 0x000000);
+    overlay.AddPolygon(layer, Square(4.0, 0.0, 8.0), 0x000000);
+
+    std::vector<uint32_t> pixels(16 * 16, WHITE);
+    overlay.Draw(pixels.data(), 16, 16, 0.0, 0.0, 1.0);
+    // Half white (alpha 128), whether under one square or two
+    EXPECT_EQ(At(pixels, 16, 2, 2), 0xFF7F7F7Fu);
+    EXPECT_EQ(At(pixels, 16, 6, 2), 0xFF7F7F7Fu);
+    EXPECT_EQ(At(pixels, 16, 14, 2), WHITE);
+
+    // Over transparent pixels the result is premultiplied
+    std::vector<uint32_t> clear(16 * 16, 0);
+    overlay.Draw(clear.data(), 16, 16, 0.0, 0.0, 1.0);
+    EXPECT_EQ(At(clear, 16, 2, 2), 0x80000000u);
+}
+
+TEST(RegionOverlayTest, Outline_KeepsWidthInOutputPixels) {
+    RegionOverlay overlay;
+    size_t layer = overlay.AddLayer(1.0f);
+    overlay.AddOutline(layer, Square(80.0, 80.0, 800.0), RED, 2.0f);
+
+    // 10x: edges at pixels 8 and 88, about two pixels wide
+    std::vector<uint32_t> pixels(100 * 100, WHITE);
+    overlay.Draw(pixels.data(), 100, 100, 0.0, 0.0, 10.0);
+    EXPECT_EQ(At(pixels, 100, 8, 40), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 100, 7, 40), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 100, 10, 40), WHITE);
+    EXPECT_EQ(At(pixels, 100, 48, 48), WHITE);  // Inside is not filled
+    EXPECT_EQ(At(pixels, 100, 40, 88), 0xFFFF0000u);
+}
+
+TEST(RegionOverlayTest, DrawsAcrossBands) {
+    RegionOverlay overlay;
+    size_t layer = overlay.AddLayer(1.0f);
+    overlay.AddPolygon(layer, Square(0.0, 0.0, 3.0 * RegionOverlay::BAND_ROWS), RED);
+
+    const int32_t height = RegionOverlay::BAND_ROWS * 3 + 7;
+    std::vector<uint32_t> pixels(static_cast<size_t>(4) * height, WHITE);
+    overlay.Draw(pixels.data(), 4, height, 0.0, 0.0, 1.0);
+    EXPECT_EQ(At(pixels, 4, 0, RegionOverlay::BAND_ROWS - 1), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 4, 0, RegionOverlay::BAND_ROWS), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 4, 0, 3 * RegionOverlay::BAND_ROWS - 1), 0xFFFF0000u);
+    EXPECT_EQ(At(pixels, 4, 0, 3 * RegionOverlay::BAND_ROWS), WHITE);
+}
+
+TEST(RegionOverlayTest, DegenerateShapesAndUnknownLayerIgnored) {
+    RegionOverlay overlay;
+    size_t layer = overlay.AddLayer(1.0f);
+    overlay.AddPolygon(layer, std::vector<Vec2>{{0.0, 0.0}, {10.0, 10.0}}, RED);
+    overlay.AddPolygon(layer + 1, Square(0.0, 0.0, 10.0), RED);
+    EXPECT_TRUE(overlay.IsEmpty());
+
+    std::vector<uint32_t> pixels(8 * 8, WHITE);
+    overlay.Draw(pixels.data(), 8, 8, 0.0, 0.0, 1.0);
+    EXPECT_EQ(pixels, std::vector<uint32_t>(8 * 8, WHITE));
+}
+
+TEST(RegionOverlayTest, BuildIndex_DrawsTheSameInParts) {
+    // Overlapping cells of two colours, and an outline across them all
+    RegionOverlay indexed;
+    RegionOverlay plain;
+    for (RegionOverlay* overlay : {&indexed, &plain}) {
+        const size_t cells = overlay->AddLayer(0.5f);
+        for (int i = 0; i < 400; ++i) {
+            overlay->AddPolygon(cells, Square((i % 20) * 37.0, (i / 20) * 41.0, 50.0), i % 2 ? RED : 0x0000FF);
+        }
+        const size_t outline = overlay->AddLayer(1.0f);
+        overlay->AddOutline(outline, Square(100.0, 100.0, 600.0), 0x00FF00, 3.0f);
+    }
+    indexed.BuildIndex(64.0);
+
+    // Tiles of 32 x 32 pixels at 2x, as an export draws them
+    for (int32_t tileY = 0; tileY < 14; ++tileY) {
+        for (int32_t tileX = 0; tileX < 13; ++tileX) {
+            std::vector<uint32_t> expected(32 * 32, WHITE);
+            std::vector<uint32_t> actual(32 * 32, WHITE);
+            plain.Draw(expected.data(), 32, 32, tileX * 64.0, tileY * 64.0, 2.0);
+            indexed.Draw(actual.data(), 32, 32, tileX * 64.0, tileY * 64.0, 2.0);
+            ASSERT_EQ(actual, expected) << "tile " << tileX << "," << tileY;
+        }
+    }
+
+    // Outside every shape
+    std::vector<uint32_t> pixels(8 * 8, WHITE);
+    indexed.Draw(pixels.data(), 8, 8, -1000.0, 5000.0, 1.0);
+    EXPECT_EQ(pixels, std::vector<uint32_t>(8 * 8, WHITE));
+}
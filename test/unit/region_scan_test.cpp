@@ -0,0 +1,182 @@
+// RegionScan Unit Tests
+// Tests for the field grid, Hilbert ordering, every field rendered once,
+// failed fields, holding workers back until results are acknowledged, and
+// cancellation
+
+#include <gtest/gtest.h>
+#include "RegionScan.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+void WaitUntil(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Renders a field as its position
+RegionScan::json RenderPosition(const Rect& field) {
+    return {{"x", field.x}, {"y", field.y}};
+}
+
+}  // namespace
+
+// ============================================================================
+// Grid and order
+// ============================================================================
+
+TEST(RegionScanTest, Grid_CutsTheLastFieldsAtTheEdge) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(100, 50, 1000, 500), 400, 300);
+    ASSERT_EQ(fields.size(), 6u);
+    EXPECT_DOUBLE_EQ(fields[0].x, 100.0);
+    EXPECT_DOUBLE_EQ(fields[2].x, 900.0);
+    EXPECT_DOUBLE_EQ(fields[2].width, 200.0);
+    EXPECT_DOUBLE_EQ(fields[3].y, 350.0);
+    EXPECT_DOUBLE_EQ(fields[5].height, 200.0);
+}
+
+TEST(RegionScanTest, Grid_Overlap) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 1000, 400), 400, 400, 100);
+    ASSERT_EQ(fields.size(), 3u);
+    EXPECT_DOUBLE_EQ(fields[1].x, 300.0);
+    EXPECT_DOUBLE_EQ(fields[2].x, 600.0);
+    EXPECT_DOUBLE_EQ(fields[2].Right(), 1000.0);
+
+    EXPECT_TRUE(RegionScan::Grid(Rect(0, 0, 1000, 400), 400, 400, 400).empty());
+}
+
+TEST(RegionScanTest, HilbertIndex_FirstOrderCurve) {
+    EXPECT_EQ(RegionScan::HilbertIndex(0, 0, 1), 0u);
+    EXPECT_EQ(RegionScan::HilbertIndex(0, 1, 1), 1u);
+    EXPECT_EQ(RegionScan::HilbertIndex(1, 1, 1), 2u);
+    EXPECT_EQ(RegionScan::HilbertIndex(1, 0, 1), 3u);
+}
+
+TEST(RegionScanTest, HilbertOrder_StepsBetweenNeighbours) {
+    // 8 x 8 fields given row by row, of one cell each or four cells across
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 800, 800), 100, 100);
+    for (double cellSize : {100.0, 25.0}) {
+        std::vector<size_t> order = RegionScan::HilbertOrder(fields, cellSize);
+        ASSERT_EQ(order.size(), 64u);
+
+        std::vector<bool> seen(64, false);
+        for (size_t i = 0; i < order.size(); ++i) {
+            ASSERT_LT(order[i], 64u);
+            EXPECT_FALSE(seen[order[i]]);
+            seen[order[i]] = true;
+            if (i > 0) {
+                const Rect& a = fields[order[i - 1]];
+                const Rect& b = fields[order[i]];
+                EXPECT_DOUBLE_EQ(std::abs(a.x - b.x) + std::abs(a.y - b.y), 100.0)
+                    << "cell " << cellSize << ", step " << i;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+TEST(RegionScanTest, EveryFieldRenderedOnce) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 1000, 1000), 100, 100);
+    RegionScan scan(fields, 100, RenderPosition, 3, fields.size());
+    WaitUntil([&]() { return scan.IsDone(); });
+    ASSERT_TRUE(scan.IsDone());
+    EXPECT_FALSE(scan.IsCancelled());
+
+    std::vector<RegionScan::Result> results;
+    ASSERT_EQ(scan.GetResults(0, SIZE_MAX, results), fields.size());
+    ASSERT_EQ(results.size(), fields.size());
+    std::vector<bool> seen(fields.size(), false);
+    for (const RegionScan::Result& result : results) {
+        ASSERT_LT(result.field, fields.size());
+        EXPECT_FALSE(seen[result.field]);
+        seen[result.field] = true;
+        EXPECT_TRUE(result.error.empty());
+        EXPECT_EQ(result.image.at("x"), fields[result.field].x);
+        EXPECT_EQ(result.image.at("y"), fields[result.field].y);
+    }
+
+    // Only results after the ones received, up to the limit; received
+    // images are released
+    std::vector<RegionScan::Result> later;
+    EXPECT_EQ(scan.GetResults(90, 4, later), fields.size());
+    ASSERT_EQ(later.size(), 4u);
+    EXPECT_EQ(later[0].field, results[90].field);
+    later.clear();
+    scan.GetResults(0, 1, later);
+    EXPECT_TRUE(later[0].image.is_null());
+}
+
+TEST(RegionScanTest, FailedField_ReportsItsError) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 300, 100), 100, 100);
+    RegionScan scan(fields, 100, [](const Rect& field) -> RegionScan::json {
+        if (field.x == 100) {
+            throw std::runtime_error("tiles did not load");
+        }
+        return RenderPosition(field);
+    }, 1);
+    WaitUntil([&]() { return scan.IsDone(); });
+
+    std::vector<RegionScan::Result> results;
+    ASSERT_EQ(scan.GetResults(0, SIZE_MAX, results), 3u);
+    for (const RegionScan::Result& result : results) {
+        EXPECT_EQ(result.error.empty(), result.field != 1);
+        if (result.field == 1) {
+            EXPECT_EQ(result.error, "tiles did not load");
+        }
+    }
+}
+
+TEST(RegionScanTest, MaxPending_HoldsWorkersUntilAcknowledged) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 1000, 100), 100, 100);
+    std::atomic<size_t> rendered{0};
+    RegionScan scan(fields, 100, [&](const Rect& field) {
+        ++rendered;
+        return RenderPosition(field);
+    }, 2, 3);
+
+    std::vector<RegionScan::Result> results;
+    WaitUntil([&]() { return scan.GetResults(0, 0, results) == 3; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(rendered.load(), 3u);
+    EXPECT_FALSE(scan.IsDone());
+
+    // Receiving two lets two more through
+    WaitUntil([&]() { return scan.GetResults(2, 0, results) == 5; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(rendered.load(), 5u);
+
+    // Once every field is taken the workers stop, received or not
+    WaitUntil([&]() { return scan.GetResults(10, 0, results) == 10 && scan.IsDone(); });
+    EXPECT_TRUE(scan.IsDone());
+    EXPECT_EQ(rendered.load(), 10u);
+}
+
+TEST(RegionScanTest, Cancel_StopsWorkers) {
+    std::vector<Rect> fields = RegionScan::Grid(Rect(0, 0, 10000, 10000), 100, 100);
+    RegionScan scan(fields, 100, [](const Rect& field) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return RenderPosition(field);
+    }, 2);
+    scan.Cancel();
+    EXPECT_TRUE(scan.IsDone());
+    EXPECT_TRUE(scan.IsCancelled());
+
+    std::vector<RegionScan::Result> results;
+    EXPECT_LT(scan.GetResults(0, SIZE_MAX, results), fields.size());
+}
+
+TEST(RegionScanTest, EmptyScan_IsDone) {
+    RegionScan scan({}, 100, RenderPosition);
+    EXPECT_TRUE(scan.IsDone());
+    std::vector<RegionScan::Result> results;
+    EXPECT_EQ(scan.GetResults(0, SIZE_MAX, results), 0u);
+}
@@ -0,0 +1,236 @@
+// RemoteFile Unit Tests
+// Tests for block-cached range reads, request coalescing, LRU eviction,
+// failed fetches and background prefetch, over an in-memory transport
+
+#include <gtest/gtest.h>
+#include "RemoteFile.h"
+#include "HttpRangeTransport.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Serves a byte pattern from memory and records every request
+class MemoryTransport : public RangeTransport {
+public:
+    struct Log {
+        std::mutex mutex;
+        std::vector<std::pair<uint64_t, uint64_t>> requests;  // Offset, size
+        bool fail = false;
+    };
+
+    MemoryTransport(uint64_t size, std::shared_ptr<Log> log) : size_(size), log_(std::move(log)) {}
+
+    bool GetSize(uint64_t& size) override {
+        size = size_;
+        return size_ > 0;
+    }
+
+    bool Fetch(uint64_t offset, uint64_t size, uint8_t* out) override {
+        std::lock_guard<std::mutex> lock(log_->mutex);
+        log_->requests.emplace_back(offset, size);
+        if (log_->fail || offset + size > size_) {
+            return false;
+        }
+        for (uint64_t i = 0; i < size; ++i) {
+            out[i] = ByteAt(offset + i);
+        }
+        return true;
+    }
+
+    static uint8_t ByteAt(uint64_t position) {
+        return static_cast<uint8_t>((position * 31) ^ (position >> 13));
+    }
+
+private:
+    uint64_t size_;
+    std::shared_ptr<Log> log_;
+};
+
+constexpr uint64_t BLOCK = RemoteFile::BLOCK_SIZE;
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class RemoteFileTest : public ::testing::Test {
+protected:
+    std::shared_ptr<MemoryTransport::Log> log = std::make_shared<MemoryTransport::Log>();
+
+    std::unique_ptr<RemoteFile> Open(uint64_t size, size_t cacheBytes = RemoteFile::DEFAULT_CACHE_BYTES) {
+        return std::make_unique<RemoteFile>(std::make_unique<MemoryTransport>(size, log), cacheBytes);
+    }
+
+    size_t RequestCount() {
+        std::lock_guard<std::mutex> lock(log->mutex);
+        return log->requests.size();
+    }
+
+    static bool Matches(const std::vector<uint8_t>& bytes, uint64_t offset) {
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            if (bytes[i] != MemoryTransport::ByteAt(offset + i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// ============================================================================
+// Read Tests
+// ============================================================================
+
+TEST_F(RemoteFileTest, EmptyRemote_IsNotOpen) {
+    auto file = Open(0);
+    EXPECT_FALSE(file->IsOpen());
+
+    uint8_t byte = 0;
+    EXPECT_FALSE(file->ReadAt(0, &byte, 1));
+}
+
+TEST_F(RemoteFileTest, ReadAt_SpanningBlocks_ReturnsRemoteBytes) {
+    auto file = Open(3 * BLOCK + 100);
+    ASSERT_TRUE(file->IsOpen());
+    EXPECT_EQ(file->GetSize(), 3 * BLOCK + 100);
+
+    std::vector<uint8_t> bytes(BLOCK + 50);
+    ASSERT_TRUE(file->ReadAt(BLOCK - 20, bytes.data(), bytes.size()));
+    EXPECT_TRUE(Matches(bytes, BLOCK - 20));
+
+    // The file's short last block
+    std::vector<uint8_t> tail(100);
+    ASSERT_TRUE(file->ReadAt(3 * BLOCK, tail.data(), tail.size()));
+    EXPECT_TRUE(Matches(tail, 3 * BLOCK));
+}
+
+TEST_F(RemoteFileTest, ReadAt_PastEnd_ReturnsFalse) {
+    auto file = Open(BLOCK);
+    std::vector<uint8_t> bytes(10);
+    EXPECT_FALSE(file->ReadAt(BLOCK - 5, bytes.data(), bytes.size()));
+    EXPECT_EQ(RequestCount(), 0u);
+}
+
+TEST_F(RemoteFileTest, ReadAt_CachedBlock_IssuesNoRequest) {
+    auto file = Open(4 * BLOCK);
+    std::vector<uint8_t> bytes(64);
+    ASSERT_TRUE(file->ReadAt(10, bytes.data(), bytes.size()));
+    ASSERT_TRUE(file->ReadAt(1000, bytes.data(), bytes.size()));
+
+    EXPECT_EQ(RequestCount(), 1u);
+    EXPECT_EQ(file->GetBlockMisses(), 1u);
+    EXPECT_EQ(file->GetBlockHits(), 1u);
+    EXPECT_TRUE(Matches(bytes, 1000));
+}
+
+TEST_F(RemoteFileTest, ReadAt_FailedFetch_ReturnsFalseAndRetriesLater) {
+    auto file = Open(2 * BLOCK);
+    log->fail = true;
+    std::vector<uint8_t> bytes(16);
+    EXPECT_FALSE(file->ReadAt(0, bytes.data(), bytes.size()));
+    EXPECT_EQ(file->GetCachedBytes(), 0u);
+
+    log->fail = false;
+    ASSERT_TRUE(file->ReadAt(0, bytes.data(), bytes.size()));
+    EXPECT_TRUE(Matches(bytes, 0));
+}
+
+// ============================================================================
+// Coalescing Tests
+// ============================================================================
+
+TEST_F(RemoteFileTest, Load_NeighbouringRanges_ShareOneRequest) {
+    auto file = Open(16 * BLOCK);
+    // Blocks 0, 1 and 3: the one-block gap rides along
+    ASSERT_TRUE(file->Load({{0, 100}, {BLOCK + 5, BLOCK + 10}, {3 * BLOCK, 3 * BLOCK + 1}}));
+
+    ASSERT_EQ(RequestCount(), 1u);
+    EXPECT_EQ(log->requests[0].first, 0u);
+    EXPECT_EQ(log->requests[0].second, 4 * BLOCK);
+    EXPECT_EQ(file->GetCachedBytes(), 4 * BLOCK);
+}
+
+TEST_F(RemoteFileTest, Load_DistantRanges_IssueSeparateRequests) {
+    auto file = Open(16 * BLOCK);
+    ASSERT_TRUE(file->Load({{0, 100}, {10 * BLOCK, 10 * BLOCK + 100}}));
+    EXPECT_EQ(RequestCount(), 2u);
+    EXPECT_EQ(file->GetFetchedBytes(), 2 * BLOCK);
+}
+
+TEST_F(RemoteFileTest, Load_LongRun_IsSplitIntoBoundedRequests) {
+    auto file = Open(40 * BLOCK);
+    ASSERT_TRUE(file->Load({{0, 40 * BLOCK}}));
+
+    EXPECT_EQ(RequestCount(), 3u);  // 16 + 16 + 8 blocks
+    for (const auto& request : log->requests) {
+        EXPECT_LE(request.second, 16 * BLOCK);
+    }
+}
+
+// ============================================================================
+// Eviction / Prefetch Tests
+// ============================================================================
+
+TEST_F(RemoteFileTest, Cache_OverCapacity_EvictsLeastRecentBlocks) {
+    auto file = Open(8 * BLOCK, 2 * BLOCK);
+    uint8_t byte = 0;
+    ASSERT_TRUE(file->ReadAt(0, &byte, 1));
+    ASSERT_TRUE(file->ReadAt(4 * BLOCK, &byte, 1));
+    ASSERT_TRUE(file->ReadAt(0, &byte, 1));          // Block 0 is now the most recent
+    ASSERT_TRUE(file->ReadAt(6 * BLOCK, &byte, 1));  // Evicts block 4
+    EXPECT_LE(file->GetCachedBytes(), 2 * BLOCK);
+
+    size_t before = RequestCount();
+    ASSERT_TRUE(file->ReadAt(0, &byte, 1));
+    EXPECT_EQ(RequestCount(), before);
+    ASSERT_TRUE(file->ReadAt(4 * BLOCK, &byte, 1));
+    EXPECT_EQ(RequestCount(), before + 1);
+}
+
+TEST_F(RemoteFileTest, Prefetch_MakesBlocksResident) {
+    auto file = Open(8 * BLOCK);
+    file->Prefetch(2 * BLOCK, BLOCK);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (file->GetCachedBytes() < BLOCK && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(file->GetCachedBytes(), BLOCK);
+
+    std::vector<uint8_t> bytes(32);
+    ASSERT_TRUE(file->ReadAt(2 * BLOCK + 7, bytes.data(), bytes.size()));
+    EXPECT_EQ(RequestCount(), 1u);
+    EXPECT_TRUE(Matches(bytes, 2 * BLOCK + 7));
+}
+
+TEST_F(RemoteFileTest, ConcurrentReaders_SameBlock_FetchOnce) {
+    auto file = Open(4 * BLOCK);
+    std::vector<std::thread> readers;
+    std::atomic<int> failures{0};
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back([&file, &failures, i]() {
+            std::vector<uint8_t> bytes(128);
+            if (!file->ReadAt(static_cast<uint64_t>(i) * 1000, bytes.data(), bytes.size()) ||
+                !Matches(bytes, static_cast<uint64_t>(i) * 1000)) {
+                failures++;
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(RequestCount(), 1u);
+}
+
+TEST_F(RemoteFileTest, IsUrl_RecognizesHttpSchemes) {
+    EXPECT_TRUE(HttpRangeTransport::IsUrl("http://host/slide.svs"));
+    EXPECT_TRUE(HttpRangeTransport::IsUrl("https://bucket.example.com/a/b.tiff?sig=1"));
+    EXPECT_FALSE(HttpRangeTransport::IsUrl("/data/slide.svs"));
+    EXPECT_FALSE(HttpRangeTransport::IsUrl("C:\\slides\\http.svs"));
+}
@@ -0,0 +1,166 @@
+// RoiMetrics Unit Tests
+// Tests for the metrics of one outline and for batches computed on worker
+// threads: every outline reported once, results taken incrementally, and
+// cancellation
+
+#include <gtest/gtest.h>
+#include "PolygonIndex.h"
+#include "PolygonStore.h"
+#include "RoiMetrics.h"
+#include "TissueMap.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+std::vector<Vec2> Square(double x, double y, double size) {
+    return {Vec2(x, y), Vec2(x + size, y), Vec2(x + size, y + size), Vec2(x, y + size)};
+}
+
+// A 10 x 10 grid of 10 px cells every 100 px, alternating classes 1 and 2
+PolygonStore GridOfCells() {
+    PolygonStore polygons;
+    for (int row = 0; row < 10; ++row) {
+        for (int column = 0; column < 10; ++column) {
+            polygons.Add(1 + (row + column) % 2, Square(column * 100.0, row * 100.0, 10));
+        }
+    }
+    return polygons;
+}
+
+void WaitUntilDone(const RoiMetricsBatch& batch) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!batch.IsDone() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+}  // namespace
+
+TEST(RoiMetricsTest, Compute_AreaPerimeterAndCounts) {
+    PolygonStore polygons = GridOfCells();
+    PolygonIndex index;
+    index.Build(polygons);
+
+    // Covers the cells of columns 0-1 and rows 0-2
+    RoiMetrics metrics =
+        RoiMetrics::Compute({Vec2(0, 0), Vec2(200, 0), Vec2(200, 300), Vec2(0, 300)}, &polygons, &index);
+    EXPECT_DOUBLE_EQ(metrics.area, 60000.0);
+    EXPECT_DOUBLE_EQ(metrics.perimeter, 1000.0);
+    EXPECT_DOUBLE_EQ(metrics.boundingBox.width, 200.0);
+    EXPECT_DOUBLE_EQ(metrics.boundingBox.height, 300.0);
+    EXPECT_EQ(metrics.totalCells, 6);
+    EXPECT_EQ(metrics.cellCounts[1], 3);
+    EXPECT_EQ(metrics.cellCounts[2], 3);
+
+    RoiMetrics uncounted = RoiMetrics::Compute(Square(0, 0, 200), nullptr, nullptr);
+    EXPECT_TRUE(uncounted.cellCounts.empty());
+    EXPECT_EQ(uncounted.totalCells, 0);
+}
+
+TEST(RoiMetricsBatchTest, EveryRoiReportedOnceMatchingCompute) {
+    PolygonStore polygons = GridOfCells();
+    PolygonIndex index;
+    index.Build(polygons);
+
+    std::vector<std::vector<Vec2>> rois;
+    for (int i = 0; i < 40; ++i) {
+        rois.push_back(Square((i % 8) * 100.0 - 5, (i / 8) * 100.0 - 5, 150 + i * 5));
+    }
+
+    RoiMetricsBatch batch(rois, &polygons, &index, {}, 4);
+    WaitUntilDone(batch);
+    ASSERT_TRUE(batch.IsDone());
+
+    std::vector<RoiMetricsBatch::Result> results;
+    ASSERT_EQ(batch.GetResults(0, results), rois.size());
+    ASSERT_EQ(results.size(), rois.size());
+    std::vector<bool> seen(rois.size(), false);
+    for (const RoiMetricsBatch::Result& result : results) {
+        ASSERT_LT(result.roi, rois.size());
+        EXPECT_FALSE(seen[result.roi]);
+        seen[result.roi] = true;
+
+        RoiMetrics expected = RoiMetrics::Compute(rois[result.roi], &polygons, &index);
+        EXPECT_EQ(result.metrics.cellCounts, expected.cellCounts);
+        EXPECT_DOUBLE_EQ(result.metrics.area, expected.area);
+    }
+
+    // Only results after the ones already taken
+    std::vector<RoiMetricsBatch::Result> later;
+    EXPECT_EQ(batch.GetResults(35, later), rois.size());
+    EXPECT_EQ(later.size(), 5u);
+    EXPECT_EQ(later[0].roi, results[35].roi);
+}
+
+TEST(RoiMetricsBatchTest, EmptyBatch_IsDone) {
+    RoiMetricsBatch batch({}, nullptr, nullptr, {});
+    EXPECT_TRUE(batch.IsDone());
+    std::vector<RoiMetricsBatch::Result> results;
+    EXPECT_EQ(batch.GetResults(0, results), 0u);
+}
+
+TEST(RoiMetricsBatchTest, Cancel_StopsWorkers) {
+    PolygonStore polygons = GridOfCells();
+    std::vector<std::vector<Vec2>> rois(500, Square(0, 0, 1000));
+
+    RoiMetricsBatch batch(rois, &polygons, nullptr, {}, 2);
+    batch.Cancel();
+    EXPECT_TRUE(batch.IsDone());
+
+    std::vector<RoiMetricsBatch::Result> results;
+    const size_t finished = batch.GetResults(0, results);
+    EXPECT_LE(finished, rois.size());
+    for (const RoiMetricsBatch::Result& result : results) {
+        EXPECT_EQ(result.metrics.totalCells, 100);
+    }
+}
+
+TEST(RoiMetricsTest, CellOverlap_WeighsStraddlingCells) {
+    PolygonStore polygons = GridOfCells();
+    PolygonIndex index;
+    index.Build(polygons);
+
+    // Cells of columns 0-1 and rows 0-2 whole, plus a 3 px wide strip of
+    // each cell in column 2 of those rows
+    std::vector<Vec2> roi = {Vec2(0, 0), Vec2(203, 0), Vec2(203, 300), Vec2(0, 300)};
+    RoiMetrics::Options options;
+    options.cellOverlap = RoiMetrics::CellOverlap::EXACT;
+    RoiMetrics exact = RoiMetrics::Compute(roi, &polygons, &index, options);
+    EXPECT_EQ(exact.totalCells, 6);  // Centroid counts as before
+    // Column 2 is class 1 in rows 0 and 2, class 2 in row 1
+    EXPECT_NEAR(exact.cellFractions[1], 3 + 2 * 0.3, 1e-6);
+    EXPECT_NEAR(exact.cellFractions[2], 3 + 0.3, 1e-6);
+    EXPECT_NEAR(exact.cellAreas[1], 300 + 2 * 30, 1e-4);
+
+    options.cellOverlap = RoiMetrics::CellOverlap::RASTER;
+    RoiMetrics raster = RoiMetrics::Compute(roi, &polygons, nullptr, options);
+    EXPECT_NEAR(raster.cellFractions[1], exact.cellFractions[1], 0.2);
+    EXPECT_NEAR(raster.cellFractions[2], exact.cellFractions[2], 0.1);
+
+    RoiMetrics centroid = RoiMetrics::Compute(roi, &polygons, &index);
+    EXPECT_TRUE(centroid.cellFractions.empty());
+}
+
+TEST(RoiMetricsTest, TissueMap_AreaByLabelInside) {
+    // 4 px texels: label 1 left of x = 400, label 2 right of it
+    TissueMap map(4.0, 0);
+    std::vector<uint8_t> labels(200 * 200);
+    for (int y = 0; y < 200; ++y) {
+        for (int x = 0; x < 200; ++x) {
+            labels[y * 200 + x] = x < 100 ? 1 : 2;
+        }
+    }
+    map.AddRegion(Rect(0, 0, 800, 800), 200, 200, labels.data());
+    map.BuildLevels();
+
+    RoiMetrics::Options options;
+    options.tissueMap = &map;
+    // 10 px left of the class boundary, 30 px right of it, 2 px into the texels
+    RoiMetrics metrics = RoiMetrics::Compute({Vec2(390, 101), Vec2(430, 101), Vec2(430, 151), Vec2(390, 151)},
+                                             nullptr, nullptr, options);
+    EXPECT_NEAR(metrics.tissueAreas[1], 10 * 50, 1e-6);
+    EXPECT_NEAR(metrics.tissueAreas[2], 30 * 50, 1e-6);
+    EXPECT_EQ(metrics.tissueAreas.count(0), 0u);
+}
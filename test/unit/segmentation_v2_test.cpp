@@ -0,0 +1,241 @@
+// SegmentationV2 Unit Tests
+// Tests for the version 2 polygon format: writer / reader round trips of
+// the packed, delta-encoded cells, version detection, malformed input,
+// and ProtobufPolygonLoader loading version 2 files into slide space.
+
+#include <gtest/gtest.h>
+#include "SegmentationV2.h"
+#include "ProtobufPolygonLoader.h"
+#include "PolygonStore.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A square cell at (x, y) in tile pixels, size on a side
+std::vector<float> Square(float x, float y, float size) {
+    return {x, y, x + size, y, x + size, y + size, x, y + size};
+}
+
+// Two tiles at max level 1: a level 1 tile (scale 1) with two cells, one
+// of them degenerate, and a level 0 tile (scale 2) with one cell
+std::vector<uint8_t> TwoTileFile(float coordinateScale = 1.0f) {
+    SegmentationV2Writer writer(coordinateScale);
+    writer.SetSlideInfo("slide-7", "/slides/7.svs", 0.25f, 1, "cells-v3", "tissue-v1", 0);
+    writer.SetTissueClass(1, "tumor");
+
+    writer.BeginTile("1_0", 1, 1.0f, 0.0f, 100, 100);
+    std::vector<float> tumor = Square(10.0f, 20.0f, 8.0f);
+    writer.AddCell("Tumor", tumor.data(), 4, 14.0f, 24.0f, 0.9f);
+    std::vector<float> line = {1.0f, 1.0f, 2.0f, 2.0f};
+    writer.AddCell("Lymphocyte", line.data(), 2, 1.5f, 1.5f, 0.5f);
+    writer.EndTile();
+
+    writer.BeginTile("0_1", 0, 0.0f, 1.0f, 100, 100);
+    std::vector<float> lymphocyte = Square(50.0f, 60.0f, 4.0f);
+    writer.AddCell("Lymphocyte", lymphocyte.data(), 4, 52.0f, 62.0f, 0.75f);
+    std::vector<uint8_t> labels(10 * 10, 1);
+    writer.SetTissueMap(labels.data(), labels.size(), 10, 10, "uint8");
+    writer.EndTile();
+
+    return writer.Finish();
+}
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SegmentationV2Test : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_segmentation_v2_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    std::string Save(const std::vector<uint8_t>& bytes) {
+        std::string path = (root / "cells.pb").string();
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()),
+                                                    static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+};
+
+// ============================================================================
+// Reader Tests
+// ============================================================================
+
+TEST_F(SegmentationV2Test, IsV2_VersionFieldFirst) {
+    std::vector<uint8_t> file = TwoTileFile();
+    EXPECT_TRUE(SegmentationV2Reader::IsV2(file.data(), file.size()));
+
+    // Version 1 starts with slide_id, a string (field 1, wire type 2)
+    const uint8_t v1[] = {0x0A, 0x03, 'a', 'b', 'c'};
+    EXPECT_FALSE(SegmentationV2Reader::IsV2(v1, sizeof(v1)));
+    EXPECT_FALSE(SegmentationV2Reader::IsV2(v1, 0));
+}
+
+TEST_F(SegmentationV2Test, Parse_ReadsSlideFieldsAndTileIndex) {
+    std::vector<uint8_t> file = TwoTileFile();
+    SegmentationV2Reader reader;
+    ASSERT_TRUE(reader.Parse(file.data(), file.size())) << reader.GetError();
+
+    EXPECT_EQ(reader.formatVersion, 2u);
+    EXPECT_EQ(reader.slideId, "slide-7");
+    EXPECT_EQ(reader.slidePath, "/slides/7.svs");
+    EXPECT_FLOAT_EQ(reader.mpp, 0.25f);
+    EXPECT_EQ(reader.maxLevel, 1);
+    EXPECT_EQ(reader.cellModelName, "cells-v3");
+    EXPECT_FLOAT_EQ(reader.coordinateScale, 1.0f);
+    // String table in first-use order, each type once
+    ASSERT_EQ(reader.cellTypes.size(), 2u);
+    EXPECT_EQ(reader.cellTypes[0], "Tumor");
+    EXPECT_EQ(reader.cellTypes[1], "Lymphocyte");
+    EXPECT_EQ(reader.tissueClassMapping.at(1), "tumor");
+
+    ASSERT_EQ(reader.tiles.size(), 2u);
+    EXPECT_EQ(reader.tiles[0].level, 1);
+    EXPECT_FLOAT_EQ(reader.tiles[0].x, 1.0f);
+    EXPECT_EQ(reader.tiles[0].width, 100);
+    EXPECT_EQ(reader.tiles[0].cellCount, 2u);
+    EXPECT_EQ(reader.tiles[0].vertexCount, 6u);
+    EXPECT_EQ(reader.tiles[0].tissueData, nullptr);
+    EXPECT_EQ(reader.tiles[1].tissueWidth, 10);
+    EXPECT_EQ(reader.tiles[1].tissueSize, 100u);
+    EXPECT_EQ(reader.tiles[1].tissueDtype, "uint8");
+}
+
+TEST_F(SegmentationV2Test, DecodeTile_CoordsAreOriginThenSteps) {
+    std::vector<uint8_t> file = TwoTileFile();
+    SegmentationV2Reader reader;
+    ASSERT_TRUE(reader.Parse(file.data(), file.size()));
+
+    SegmentationV2Reader::TileCells cells;
+    ASSERT_TRUE(SegmentationV2Reader::DecodeTile(reader.tiles[0], cells));
+    ASSERT_EQ(cells.vertexCounts, (std::vector<uint32_t>{4, 2}));
+    EXPECT_EQ(cells.classIds, (std::vector<uint32_t>{0, 1}));
+    // Square at (10, 20): origin, then +8 x, +8 y, -8 x; then the line
+    EXPECT_EQ(cells.coords, (std::vector<int32_t>{10, 20, 8, 0, 0, 8, -8, 0, 1, 1, 1, 1}));
+    EXPECT_EQ(cells.centroids, (std::vector<int32_t>{4, 4, 1, 1}));
+    ASSERT_EQ(cells.confidences.size(), 2u);
+    EXPECT_FLOAT_EQ(cells.confidences[0], 0.9f);
+}
+
+TEST_F(SegmentationV2Test, DecodeTile_CoordinateScaleKeepsSubpixels) {
+    SegmentationV2Writer writer(4.0f);
+    writer.BeginTile("t", 0, 0.0f, 0.0f, 64, 64);
+    std::vector<float> xy = {1.25f, 2.5f, 3.75f, 2.5f, 3.0f, 5.0f};
+    writer.AddCell("A", xy.data(), 3, 2.5f, 3.0f, 1.0f);
+    writer.EndTile();
+    std::vector<uint8_t> file = writer.Finish();
+
+    SegmentationV2Reader reader;
+    ASSERT_TRUE(reader.Parse(file.data(), file.size()));
+    EXPECT_FLOAT_EQ(reader.coordinateScale, 4.0f);
+    SegmentationV2Reader::TileCells cells;
+    ASSERT_TRUE(SegmentationV2Reader::DecodeTile(reader.tiles[0], cells));
+    EXPECT_EQ(cells.coords, (std::vector<int32_t>{5, 10, 10, 0, -3, 10}));
+}
+
+TEST_F(SegmentationV2Test, DecodeTile_UnpackedValuesAccepted) {
+    // A tile written by an encoder that does not pack: class_ids and
+    // vertex_counts as single varints, coords as separate zigzag values
+    std::vector<uint8_t> tile = {0x38, 0x00, 0x40, 0x03};
+    for (uint8_t zigzag : {0x00, 0x00, 0x04, 0x00, 0x00, 0x04}) {  // (0,0) (+2,0) (0,+2)
+        tile.push_back(0x48);
+        tile.push_back(zigzag);
+    }
+    std::vector<uint8_t> file = {0x08, 0x02, 0x52, static_cast<uint8_t>(tile.size())};
+    file.insert(file.end(), tile.begin(), tile.end());
+
+    SegmentationV2Reader reader;
+    ASSERT_TRUE(reader.Parse(file.data(), file.size())) << reader.GetError();
+    ASSERT_EQ(reader.tiles.size(), 1u);
+    EXPECT_EQ(reader.tiles[0].vertexCount, 3u);
+    SegmentationV2Reader::TileCells cells;
+    ASSERT_TRUE(SegmentationV2Reader::DecodeTile(reader.tiles[0], cells));
+    EXPECT_EQ(cells.coords, (std::vector<int32_t>{0, 0, 2, 0, 0, 2}));
+    EXPECT_TRUE(cells.confidences.empty());
+}
+
+TEST_F(SegmentationV2Test, Parse_TruncatedOrWrongVersion_Fails) {
+    std::vector<uint8_t> file = TwoTileFile();
+    SegmentationV2Reader truncated;
+    EXPECT_FALSE(truncated.Parse(file.data(), file.size() - 5));
+    EXPECT_FALSE(truncated.GetError().empty());
+
+    const uint8_t version3[] = {0x08, 0x03};
+    SegmentationV2Reader future;
+    EXPECT_FALSE(future.Parse(version3, sizeof(version3)));
+}
+
+// ============================================================================
+// Loader Tests
+// ============================================================================
+
+TEST_F(SegmentationV2Test, ProtobufLoader_LoadsVersion2InSlideSpace) {
+    std::string path = Save(TwoTileFile());
+    ProtobufPolygonLoader loader;
+    PolygonStore polygons;
+    std::map<int, SDL_Color> colors;
+    std::map<int, std::string> names;
+    ASSERT_TRUE(loader.Load(path, polygons, colors, names));
+
+    // The two-vertex cell is skipped, as in version 1
+    ASSERT_EQ(polygons.Size(), 2u);
+    EXPECT_EQ(polygons.GetTotalVertexCount(), 8u);
+    ASSERT_EQ(names.size(), 2u);
+    EXPECT_EQ(names.at(polygons.GetClassId(0)), "Tumor");
+    EXPECT_EQ(names.at(polygons.GetClassId(1)), "Lymphocyte");
+
+    // Level 1 tile at column 1: x + 100, scale 1
+    const Vec2f* tumor = polygons.GetVertices(0);
+    EXPECT_FLOAT_EQ(tumor[0].x, 110.0f);
+    EXPECT_FLOAT_EQ(tumor[0].y, 20.0f);
+    EXPECT_FLOAT_EQ(tumor[2].x, 118.0f);
+    EXPECT_FLOAT_EQ(tumor[2].y, 28.0f);
+    EXPECT_DOUBLE_EQ(polygons.GetCentroid(0).x, 114.0);
+    EXPECT_FLOAT_EQ(polygons.GetConfidence(0), 0.9f);
+
+    // Level 0 tile at row 1: y + 100, both scaled by 2
+    const Vec2f* lymphocyte = polygons.GetVertices(1);
+    EXPECT_FLOAT_EQ(lymphocyte[0].x, 100.0f);
+    EXPECT_FLOAT_EQ(lymphocyte[0].y, 320.0f);
+    EXPECT_DOUBLE_EQ(polygons.GetCentroid(1).y, 324.0);
+
+    std::unique_ptr<TissueMap> tissue = loader.TakeTissueMap();
+    ASSERT_NE(tissue, nullptr);
+    EXPECT_EQ(tissue->GetClassNames().at(1), "tumor");
+}
+
+TEST_F(SegmentationV2Test, ProtobufLoader_StreamsVersion2) {
+    std::string path = Save(TwoTileFile());
+    ProtobufPolygonLoader loader;
+    size_t streamed = 0;
+    size_t classes = 0;
+    PolygonStreamCallbacks callbacks;
+    callbacks.onClasses = [&](const std::map<int, SDL_Color>&, const std::map<int, std::string>& names) {
+        classes = names.size();
+    };
+    callbacks.onBatch = [&](PolygonStore&& batch, float) {
+        streamed += batch.Size();
+        return true;
+    };
+    ASSERT_TRUE(loader.LoadStreaming(path, callbacks));
+    EXPECT_EQ(classes, 2u);
+    EXPECT_EQ(streamed, 2u);
+}
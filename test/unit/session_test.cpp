@@ -0,0 +1,216 @@
+// Session Unit Tests
+// Tests for the saved session: a save/load round trip, hand-edited and
+// foreign files, and the tile usage counts that pick the tiles a restored
+// session warms up. Each test works in its own temp directory.
+
+#include <gtest/gtest.h>
+#include "Session.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SessionTest : public ::testing::Test {
+protected:
+    fs::path root;
+    std::string path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_session_") + info->name());
+        fs::remove_all(root);
+        path = (root / "state" / "session.txt").string();
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    void WriteFile(const std::string& text) {
+        fs::create_directories(fs::path(path).parent_path());
+        std::ofstream(path) << text;
+    }
+};
+
+// ============================================================================
+// Save / Load
+// ============================================================================
+
+TEST_F(SessionTest, SaveLoad_RoundTrips) {
+    SessionState saved;
+    saved.slidePath = "/data/case 1.svs";
+    saved.hasView = true;
+    saved.viewCenter = Vec2(51200.25, 38400.5);
+    saved.viewZoom = 0.123456789;
+    saved.polygonPath = "/data/case 1.pb";
+    saved.heatmapPath = "/data/case 1.npy";
+    saved.heatmapTexelSize = 16.0;
+    saved.worklist = {{"/data/case 1.svs", "/data/case 1.pb"}, {"/data/case2.svs", ""}};
+    saved.worklistIndex = 0;
+    saved.warmTiles = {TileKey{3, 12, 7}, TileKey{0, 100, 200}};
+
+    ASSERT_TRUE(Session::Save(path, saved));  // Creates the directory
+    EXPECT_FALSE(fs::exists(path + ".tmp"));
+
+    SessionState loaded;
+    ASSERT_TRUE(Session::Load(path, loaded));
+    EXPECT_EQ(loaded.slidePath, saved.slidePath);
+    EXPECT_TRUE(loaded.hasView);
+    EXPECT_DOUBLE_EQ(loaded.viewCenter.x, 51200.25);
+    EXPECT_DOUBLE_EQ(loaded.viewCenter.y, 38400.5);
+    EXPECT_DOUBLE_EQ(loaded.viewZoom, 0.123456789);
+    EXPECT_EQ(loaded.polygonPath, saved.polygonPath);
+    EXPECT_EQ(loaded.heatmapPath, saved.heatmapPath);
+    EXPECT_DOUBLE_EQ(loaded.heatmapTexelSize, 16.0);
+    ASSERT_EQ(loaded.worklist.size(), 2u);
+    EXPECT_EQ(loaded.worklist[0].slidePath, "/data/case 1.svs");
+    EXPECT_EQ(loaded.worklist[0].polygonPath, "/data/case 1.pb");
+    EXPECT_EQ(loaded.worklist[1].slidePath, "/data/case2.svs");
+    EXPECT_TRUE(loaded.worklist[1].polygonPath.empty());
+    EXPECT_EQ(loaded.worklistIndex, 0u);
+    EXPECT_EQ(loaded.warmTiles, saved.warmTiles);
+}
+
+TEST_F(SessionTest, SaveLoad_EmptyStateHasNoView) {
+    ASSERT_TRUE(Session::Save(path, SessionState()));
+
+    SessionState loaded;
+    loaded.slidePath = "stale";
+    ASSERT_TRUE(Session::Load(path, loaded));
+    EXPECT_TRUE(loaded.IsEmpty());
+    EXPECT_FALSE(loaded.hasView);
+    EXPECT_EQ(loaded.worklistIndex, Worklist::NO_ENTRY);
+    EXPECT_TRUE(loaded.warmTiles.empty());
+}
+
+TEST_F(SessionTest, Save_KeepsAtMostMaxWarmTiles) {
+    SessionState saved;
+    saved.slidePath = "/data/a.svs";
+    for (int32_t i = 0; i < static_cast<int32_t>(Session::MAX_WARM_TILES) + 10; ++i) {
+        saved.warmTiles.push_back(TileKey{0, i, 0});
+    }
+    ASSERT_TRUE(Session::Save(path, saved));
+
+    SessionState loaded;
+    ASSERT_TRUE(Session::Load(path, loaded));
+    ASSERT_EQ(loaded.warmTiles.size(), Session::MAX_WARM_TILES);
+    EXPECT_EQ(loaded.warmTiles.front(), (TileKey{0, 0, 0}));
+}
+
+TEST_F(SessionTest, Load_MissingFileFails) {
+    SessionState state;
+    EXPECT_FALSE(Session::Load(path, state));
+}
+
+TEST_F(SessionTest, Load_ForeignFileFails) {
+    WriteFile("slide /data/a.svs\n");
+    SessionState state;
+    EXPECT_FALSE(Session::Load(path, state));
+
+    WriteFile("pathview-session 99\nslide /data/a.svs\n");
+    EXPECT_FALSE(Session::Load(path, state));
+}
+
+TEST_F(SessionTest, Load_SkipsUnknownAndMalformedLines) {
+    WriteFile("pathview-session 1\r\n"
+              "slide /data/a.svs\r\n"
+              "layout compare\n"
+              "view 10 20\n"        // No zoom
+              "tile 1 2\n"          // No row
+              "tile -1 0 0\n"
+              "tile 2 3 4\n"
+              "\n"
+              "worklist 5\n");      // Past the entries
+    SessionState state;
+    ASSERT_TRUE(Session::Load(path, state));
+    EXPECT_EQ(state.slidePath, "/data/a.svs");
+    EXPECT_FALSE(state.hasView);
+    ASSERT_EQ(state.warmTiles.size(), 1u);
+    EXPECT_EQ(state.warmTiles[0], (TileKey{2, 3, 4}));
+    EXPECT_EQ(state.worklistIndex, Worklist::NO_ENTRY);
+}
+
+TEST_F(SessionTest, Save_ReplacesPreviousSession) {
+    SessionState first;
+    first.slidePath = "/data/a.svs";
+    first.polygonPath = "/data/a.pb";
+    ASSERT_TRUE(Session::Save(path, first));
+
+    SessionState second;
+    second.slidePath = "/data/b.svs";
+    ASSERT_TRUE(Session::Save(path, second));
+
+    SessionState loaded;
+    ASSERT_TRUE(Session::Load(path, loaded));
+    EXPECT_EQ(loaded.slidePath, "/data/b.svs");
+    EXPECT_TRUE(loaded.polygonPath.empty());
+}
+
+TEST(SessionPathTest, DefaultPath_IsSessionFile) {
+    std::string name = fs::path(Session::DefaultPath()).filename().string();
+    ASSERT_GE(name.size(), 11u);
+    EXPECT_EQ(name.substr(name.size() - 11), "session.txt");
+}
+
+// ============================================================================
+// Tile usage
+// ============================================================================
+
+TEST(TileUsageTest, GetMostUsed_OrdersByViewsThenCoarsestLevel) {
+    TileUsage usage;
+    usage.Record({TileKey{0, 1, 1}, TileKey{2, 0, 0}, TileKey{1, 0, 0}});
+    usage.Record({TileKey{0, 1, 1}});
+    usage.Record({TileKey{0, 1, 1}, TileKey{1, 0, 0}});
+
+    std::vector<TileKey> tiles = usage.GetMostUsed(10);
+    ASSERT_EQ(tiles.size(), 3u);
+    EXPECT_EQ(tiles[0], (TileKey{0, 1, 1}));  // 3 views
+    EXPECT_EQ(tiles[1], (TileKey{1, 0, 0}));  // 2
+    EXPECT_EQ(tiles[2], (TileKey{2, 0, 0}));  // 1
+
+    usage.Record({TileKey{2, 0, 0}});  // Ties with level 1: coarser first
+    tiles = usage.GetMostUsed(2);
+    ASSERT_EQ(tiles.size(), 2u);
+    EXPECT_EQ(tiles[1], (TileKey{2, 0, 0}));
+}
+
+TEST(TileUsageTest, Record_IgnoresSlide) {
+    TileUsage usage;
+    TileKey tile{1, 2, 3};
+    tile.slide = 7;
+    usage.Record({tile});
+    tile.slide = 8;
+    usage.Record({tile});
+
+    EXPECT_EQ(usage.GetTrackedCount(), 1u);
+    std::vector<TileKey> tiles = usage.GetMostUsed(1);
+    ASSERT_EQ(tiles.size(), 1u);
+    EXPECT_EQ(tiles[0], (TileKey{1, 2, 3}));
+    EXPECT_EQ(tiles[0].slide, 0u);
+}
+
+TEST(TileUsageTest, Record_AgesCountsWhenFull) {
+    TileUsage usage;
+    usage.Record({TileKey{5, 0, 0}});
+    usage.Record({TileKey{5, 0, 0}});  // Count 2 survives a halving
+
+    std::vector<TileKey> once;
+    for (int32_t i = 0; i < static_cast<int32_t>(TileUsage::TRACKED_TILES); ++i) {
+        once.push_back(TileKey{0, i, 0});
+    }
+    usage.Record(once);  // One past the limit: halve, the single views go
+
+    EXPECT_EQ(usage.GetTrackedCount(), 1u);
+    EXPECT_EQ(usage.GetMostUsed(10), (std::vector<TileKey>{TileKey{5, 0, 0}}));
+
+    usage.Clear();
+    EXPECT_EQ(usage.GetTrackedCount(), 0u);
+    EXPECT_TRUE(usage.GetMostUsed(10).empty());
+}
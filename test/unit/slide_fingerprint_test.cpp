@@ -0,0 +1,137 @@
+// SlideFingerprint Unit Tests
+// Tests that the fingerprint follows a file's contents rather than its
+// name: stable across reads and renames, changed by edits to the header,
+// a TIFF directory past the header, or sampled bytes deep in the file
+
+#include <gtest/gtest.h>
+#include "SlideFingerprint.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SlideFingerprintTest : public ::testing::Test {
+protected:
+    fs::path root;
+    fs::path slidePath;
+    std::vector<uint8_t> contents;
+    fs::file_time_type mtime;
+
+    static constexpr size_t FILE_BYTES = 1024 * 1024;
+    static constexpr size_t DIRECTORY_OFFSET = 512 * 1024;  // Past the hashed header
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_fingerprint_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+        slidePath = root / "slide.tif";
+
+        // Little-endian classic TIFF whose only directory sits mid-file,
+        // as in slides written tiles first
+        contents.assign(FILE_BYTES, 0);
+        for (size_t i = 0; i < contents.size(); ++i) {
+            contents[i] = static_cast<uint8_t>(i * 31 + 7);
+        }
+        contents[0] = 'I';
+        contents[1] = 'I';
+        WriteLE(2, 42, 2);
+        WriteLE(4, DIRECTORY_OFFSET, 4);  // First directory
+        WriteLE(DIRECTORY_OFFSET, 1, 2);  // One entry
+        WriteLE(DIRECTORY_OFFSET + 2, 256, 2);  // ImageWidth, SHORT, 1, 50000
+        WriteLE(DIRECTORY_OFFSET + 4, 3, 2);
+        WriteLE(DIRECTORY_OFFSET + 6, 1, 4);
+        WriteLE(DIRECTORY_OFFSET + 10, 50000, 4);
+        WriteLE(DIRECTORY_OFFSET + 14, 0, 4);  // Last directory
+        WriteSlide();
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    void WriteLE(size_t offset, uint64_t value, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            contents[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // Rewrites the file with the first write's mtime, so only contents differ
+    void WriteSlide() {
+        {
+            std::ofstream file(slidePath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+        }
+        if (mtime == fs::file_time_type()) {
+            mtime = fs::last_write_time(slidePath);
+        } else {
+            fs::last_write_time(slidePath, mtime);
+        }
+    }
+};
+
+// ============================================================================
+// Identity Tests
+// ============================================================================
+
+TEST_F(SlideFingerprintTest, SameFile_SameFingerprint) {
+    std::string fingerprint = SlideFingerprint::Compute(slidePath.string());
+    EXPECT_EQ(fingerprint.size(), 16u);
+    EXPECT_EQ(SlideFingerprint::Compute(slidePath.string()), fingerprint);
+}
+
+TEST_F(SlideFingerprintTest, Renamed_KeepsFingerprint) {
+    std::string before = SlideFingerprint::Compute(slidePath.string());
+    fs::path moved = root / "elsewhere" / "renamed.tif";
+    fs::create_directories(moved.parent_path());
+    fs::rename(slidePath, moved);
+    EXPECT_EQ(SlideFingerprint::Compute(moved.string()), before);
+}
+
+TEST_F(SlideFingerprintTest, MissingFile_Empty) {
+    EXPECT_TRUE(SlideFingerprint::Compute((root / "missing.tif").string()).empty());
+    EXPECT_TRUE(SlideFingerprint::Compute("https://example.com/slide.svs").empty());
+}
+
+// ============================================================================
+// Change Detection Tests
+// ============================================================================
+
+TEST_F(SlideFingerprintTest, HeaderEdit_Changes) {
+    std::string before = SlideFingerprint::Compute(slidePath.string());
+    contents[100] ^= 1;
+    WriteSlide();
+    EXPECT_NE(SlideFingerprint::Compute(slidePath.string()), before);
+}
+
+TEST_F(SlideFingerprintTest, DirectoryEdit_Changes) {
+    std::string before = SlideFingerprint::Compute(slidePath.string());
+    WriteLE(DIRECTORY_OFFSET + 10, 50001, 4);  // Another image width
+    WriteSlide();
+    EXPECT_NE(SlideFingerprint::Compute(slidePath.string()), before);
+}
+
+TEST_F(SlideFingerprintTest, SampledByteEdit_Changes) {
+    std::string before = SlideFingerprint::Compute(slidePath.string());
+    // Start of the last sample
+    size_t offset = SlideFingerprint::HEADER_BYTES +
+                    (FILE_BYTES - SlideFingerprint::HEADER_BYTES) / (SlideFingerprint::SAMPLE_COUNT + 1) *
+                        SlideFingerprint::SAMPLE_COUNT;
+    contents[offset] ^= 1;
+    WriteSlide();
+    EXPECT_NE(SlideFingerprint::Compute(slidePath.string()), before);
+}
+
+TEST_F(SlideFingerprintTest, SizeChange_Changes) {
+    std::string before = SlideFingerprint::Compute(slidePath.string());
+    contents.push_back(0);
+    WriteSlide();
+    EXPECT_NE(SlideFingerprint::Compute(slidePath.string()), before);
+}
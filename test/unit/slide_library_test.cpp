@@ -0,0 +1,184 @@
+// SlideLibrary Unit Tests
+// Tests for scanning a directory tree for slides, thumbnails served from
+// the disk cache by fingerprint, failures, and the cache file format.
+// Each test works in its own temp directory.
+
+#include <gtest/gtest.h>
+#include "SlideLibrary.h"
+#include "SlideFingerprint.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SlideLibraryTest : public ::testing::Test {
+protected:
+    fs::path root;
+    fs::path slides;
+    fs::path cache;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_slide_library_") + info->name());
+        fs::remove_all(root);
+        slides = root / "slides";
+        cache = root / "cache";
+        fs::create_directories(slides / "case 2");
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    static void WriteFile(const fs::path& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    static SlideThumbnail Gradient(int32_t width, int32_t height) {
+        SlideThumbnail thumbnail;
+        thumbnail.width = width;
+        thumbnail.height = height;
+        for (int32_t y = 0; y < height; ++y) {
+            for (int32_t x = 0; x < width; ++x) {
+                thumbnail.pixels.push_back(0xFF000000u | static_cast<uint32_t>(x << 8 | y));
+            }
+        }
+        return thumbnail;
+    }
+
+    static bool WaitForThumbnails(const SlideLibrary& library) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (library.GetPendingCount() > 0) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+};
+
+// ============================================================================
+// Scan Tests
+// ============================================================================
+
+TEST_F(SlideLibraryTest, FindSlides_RecursesAndFiltersByExtension) {
+    WriteFile(slides / "b.svs", "b");
+    WriteFile(slides / "A.NDPI", "a");
+    WriteFile(slides / "case 2" / "c.tiff", "c");
+    WriteFile(slides / "notes.txt", "not a slide");
+    WriteFile(slides / "case 2" / "cells.pb", "not a slide");
+
+    std::vector<std::string> found = SlideLibrary::FindSlides(slides.string());
+    ASSERT_EQ(found.size(), 3u);
+    EXPECT_EQ(fs::path(found[0]).filename(), "A.NDPI");
+    EXPECT_EQ(fs::path(found[1]).filename(), "b.svs");
+    EXPECT_EQ(fs::path(found[2]).filename(), "c.tiff");
+
+    EXPECT_TRUE(SlideLibrary::FindSlides((root / "missing").string()).empty());
+}
+
+TEST_F(SlideLibraryTest, Scan_NotADirectory_ClearsEntries) {
+    WriteFile(slides / "a.svs", "a");
+    SlideLibrary library(cache.string(), 1);
+    ASSERT_TRUE(library.Scan(slides.string()));
+    EXPECT_EQ(library.GetEntries().size(), 1u);
+
+    EXPECT_FALSE(library.Scan((slides / "a.svs").string()));
+    EXPECT_TRUE(library.GetEntries().empty());
+    EXPECT_TRUE(library.GetRoot().empty());
+}
+
+// ============================================================================
+// Thumbnail Tests
+// ============================================================================
+
+TEST_F(SlideLibraryTest, Scan_UnreadableSlide_Fails) {
+    WriteFile(slides / "case 2" / "broken.svs", "not a whole-slide image");
+    auto calls = std::make_shared<std::atomic<int>>(0);
+    SlideLibrary library(cache.string(), 2, [calls]() { (*calls)++; });
+    ASSERT_TRUE(library.Scan(slides.string()));
+    ASSERT_TRUE(WaitForThumbnails(library));
+
+    std::vector<SlideLibrary::Entry> entries = library.GetEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].name, "case 2/broken.svs");
+    EXPECT_EQ(entries[0].bytes, 23u);
+    EXPECT_EQ(entries[0].state, SlideLibrary::ThumbnailState::Failed);
+    EXPECT_FALSE(entries[0].fingerprint.empty());
+    // Notified once the entry is updated
+    for (int i = 0; i < 1000 && calls->load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(calls->load(), 1);
+
+    SlideThumbnail thumbnail;
+    EXPECT_FALSE(library.TakeThumbnail(0, library.GetScanRevision(), thumbnail));
+    EXPECT_FALSE(fs::exists(cache));  // Nothing to cache
+}
+
+TEST_F(SlideLibraryTest, Scan_CachedThumbnail_ServedByFingerprint) {
+    const fs::path slide = slides / "a.svs";
+    WriteFile(slide, "slide contents that do not open");
+    fs::create_directories(cache);
+    const std::string fingerprint = SlideFingerprint::Compute(slide.string());
+    ASSERT_FALSE(fingerprint.empty());
+    const SlideThumbnail cached = Gradient(40, 30);
+    ASSERT_TRUE(SlideLibrary::WriteCachedThumbnail(
+        (cache / (fingerprint + SlideLibrary::CACHE_FILE_EXTENSION)).string(), cached));
+
+    // A moved slide keeps its thumbnail
+    fs::rename(slide, slides / "case 2" / "moved.svs");
+
+    SlideLibrary library(cache.string(), 1);
+    ASSERT_TRUE(library.Scan(slides.string()));
+    const uint64_t scan = library.GetScanRevision();
+    ASSERT_TRUE(WaitForThumbnails(library));
+
+    std::vector<SlideLibrary::Entry> entries = library.GetEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].state, SlideLibrary::ThumbnailState::Ready);
+    EXPECT_TRUE(entries[0].fromCache);
+    EXPECT_EQ(entries[0].fingerprint, fingerprint);
+
+    SlideThumbnail thumbnail;
+    EXPECT_FALSE(library.TakeThumbnail(0, scan - 1, thumbnail));
+    ASSERT_TRUE(library.TakeThumbnail(0, scan, thumbnail));
+    EXPECT_EQ(thumbnail.width, 40);
+    EXPECT_EQ(thumbnail.height, 30);
+    EXPECT_EQ(thumbnail.pixels, cached.pixels);
+    EXPECT_FALSE(library.TakeThumbnail(0, scan, thumbnail));  // Handed over once
+}
+
+// ============================================================================
+// Cache File Tests
+// ============================================================================
+
+TEST_F(SlideLibraryTest, CachedThumbnail_RoundTripsAndRejectsBadFiles) {
+    fs::create_directories(cache);
+    const std::string file = (cache / "0123456789abcdef.thumb").string();
+    const SlideThumbnail original = Gradient(SlideLibrary::THUMBNAIL_SIZE, 17);
+    ASSERT_TRUE(SlideLibrary::WriteCachedThumbnail(file, original));
+
+    SlideThumbnail read;
+    ASSERT_TRUE(SlideLibrary::ReadCachedThumbnail(file, read));
+    EXPECT_EQ(read.width, original.width);
+    EXPECT_EQ(read.height, original.height);
+    EXPECT_EQ(read.pixels, original.pixels);
+
+    EXPECT_FALSE(SlideLibrary::WriteCachedThumbnail(file, Gradient(SlideLibrary::THUMBNAIL_SIZE + 1, 1)));
+    EXPECT_FALSE(SlideLibrary::ReadCachedThumbnail((cache / "missing.thumb").string(), read));
+    WriteFile(file, "PVTH truncated");
+    EXPECT_FALSE(SlideLibrary::ReadCachedThumbnail(file, read));
+}
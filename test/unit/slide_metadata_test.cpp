@@ -0,0 +1,73 @@
+// SlideMetadata Unit Tests
+// Tests for the standard properties parsed from the vendor ones (OpenSlide's
+// normalized names first, Aperio's as fallback) and for the lookups
+
+#include <gtest/gtest.h>
+#include "SlideMetadata.h"
+
+// ============================================================================
+// Standard Property Tests
+// ============================================================================
+
+TEST(SlideMetadataTest, ParseStandardProperties_OpenSlideNames) {
+    SlideMetadata metadata;
+    metadata.properties = {
+        {"openslide.mpp-x", "0.2527"},
+        {"openslide.mpp-y", "0.2531"},
+        {"openslide.objective-power", "40"},
+        {"aperio.MPP", "0.5"},
+        {"aperio.AppMag", "20"}
+    };
+    metadata.ParseStandardProperties();
+    EXPECT_DOUBLE_EQ(metadata.mppX, 0.2527);
+    EXPECT_DOUBLE_EQ(metadata.mppY, 0.2531);
+    EXPECT_DOUBLE_EQ(metadata.objectivePower, 40.0);
+}
+
+TEST(SlideMetadataTest, ParseStandardProperties_FallsBackToAperio) {
+    SlideMetadata metadata;
+    metadata.properties = {
+        {"openslide.mpp-x", "0.25"},  // Without mpp-y: not used
+        {"aperio.MPP", "0.4990"},
+        {"aperio.AppMag", "20"}
+    };
+    metadata.ParseStandardProperties();
+    EXPECT_DOUBLE_EQ(metadata.mppX, 0.499);
+    EXPECT_DOUBLE_EQ(metadata.mppY, 0.499);
+    EXPECT_DOUBLE_EQ(metadata.objectivePower, 20.0);
+}
+
+TEST(SlideMetadataTest, ParseStandardProperties_MissingOrInvalid_Zero) {
+    SlideMetadata metadata;
+    metadata.properties = {
+        {"openslide.mpp-x", "unknown"},
+        {"openslide.mpp-y", "-1"},
+        {"openslide.objective-power", ""}
+    };
+    metadata.ParseStandardProperties();
+    EXPECT_EQ(metadata.mppX, 0.0);
+    EXPECT_EQ(metadata.mppY, 0.0);
+    EXPECT_EQ(metadata.objectivePower, 0.0);
+}
+
+// ============================================================================
+// Lookup Tests
+// ============================================================================
+
+TEST(SlideMetadataTest, FindProperty) {
+    SlideMetadata metadata;
+    metadata.properties = {{"openslide.vendor", "aperio"}};
+    ASSERT_NE(metadata.FindProperty("openslide.vendor"), nullptr);
+    EXPECT_EQ(*metadata.FindProperty("openslide.vendor"), "aperio");
+    EXPECT_EQ(metadata.FindProperty("openslide.quickhash-1"), nullptr);
+}
+
+TEST(SlideMetadataTest, FindAssociatedImage) {
+    SlideMetadata metadata;
+    metadata.associatedImages = {{"thumbnail", 1024, 768}, {"label", 400, 300}};
+    const SlideMetadata::AssociatedImage* label = metadata.FindAssociatedImage("label");
+    ASSERT_NE(label, nullptr);
+    EXPECT_EQ(label->width, 400);
+    EXPECT_EQ(label->height, 300);
+    EXPECT_EQ(metadata.FindAssociatedImage("macro"), nullptr);
+}
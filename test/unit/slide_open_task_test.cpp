@@ -0,0 +1,111 @@
+// SlideOpenTask Unit Tests
+// Tests for the background open's failure path, progress notifications
+// and abandoning a task. Each test works in its own temp directory.
+
+#include <gtest/gtest.h>
+#include "SlideOpenTask.h"
+#include "SlideLoader.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SlideOpenTaskTest : public ::testing::Test {
+protected:
+    fs::path root;
+    fs::path notASlide;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_slide_open_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+
+        notASlide = root / "notes.txt";
+        std::ofstream file(notASlide, std::ios::binary | std::ios::trunc);
+        file << "not a whole-slide image";
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+};
+
+// ============================================================================
+// Failure Tests
+// ============================================================================
+
+TEST_F(SlideOpenTaskTest, SlideOpenTask_NotASlide_FailsWithError) {
+    SlideOpenTask task(notASlide.string(), SlideOpenOptions());
+    task.Wait();
+
+    EXPECT_TRUE(task.IsFinished());
+    EXPECT_EQ(task.GetStage(), SlideOpenStage::Failed);
+    EXPECT_FALSE(task.GetError().empty());
+    EXPECT_EQ(task.TakeLoader(), nullptr);
+    EXPECT_TRUE(task.TakeOverview().pixels.empty());
+
+    SlidePreview preview;
+    EXPECT_FALSE(task.TakePreview(preview));
+}
+
+TEST_F(SlideOpenTaskTest, SlideOpenTask_MissingFile_Fails) {
+    SlideOpenTask task((root / "missing.svs").string(), SlideOpenOptions());
+    task.Wait();
+
+    EXPECT_EQ(task.GetStage(), SlideOpenStage::Failed);
+    EXPECT_EQ(task.TakeLoader(), nullptr);
+}
+
+// ============================================================================
+// Progress Tests
+// ============================================================================
+
+TEST_F(SlideOpenTaskTest, SlideOpenTask_Finish_NotifiesProgress) {
+    auto calls = std::make_shared<std::atomic<int>>(0);
+    SlideOpenTask task(notASlide.string(), SlideOpenOptions(), [calls]() { (*calls)++; });
+    task.Wait();
+
+    EXPECT_GE(calls->load(), 1);
+    EXPECT_EQ(task.GetPath(), notASlide.string());
+    EXPECT_GE(task.GetElapsedSeconds(), 0.0);
+}
+
+TEST_F(SlideOpenTaskTest, SlideOpenTask_Abandoned_StopsNotifying) {
+    auto abandoned = std::make_shared<std::atomic<bool>>(false);
+    auto lateCalls = std::make_shared<std::atomic<int>>(0);
+
+    auto task = std::make_unique<SlideOpenTask>(notASlide.string(), SlideOpenOptions(),
+                                                [abandoned, lateCalls]() {
+                                                    if (abandoned->load()) {
+                                                        (*lateCalls)++;
+                                                    }
+                                                });
+    task.reset();
+    abandoned->store(true);
+
+    // The worker finishes on its own; give it time to (not) call back
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(lateCalls->load(), 0);
+}
+
+TEST_F(SlideOpenTaskTest, SlideOpenStageName_AllStages_AreDistinct) {
+    std::set<std::string> names;
+    for (SlideOpenStage stage : {SlideOpenStage::Opening, SlideOpenStage::ReadingThumbnail,
+                                 SlideOpenStage::ReadingOverview, SlideOpenStage::Ready,
+                                 SlideOpenStage::Failed}) {
+        names.insert(SlideOpenStageName(stage));
+    }
+    EXPECT_EQ(names.size(), 5u);
+}
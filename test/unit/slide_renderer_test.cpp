@@ -1,11 +1,12 @@
 // SlideRenderer Unit Tests
-// Tests for level selection and tile enumeration logic
+// Tests for level selection, tile enumeration and fallback tile merging
 // Note: Full testing requires mock SlideLoader and SDL_Renderer
 
 #include <gtest/gtest.h>
 #include "SlideRenderer.h"
 #include "Viewport.h"
 #include <cmath>
+#include <set>
 
 // ============================================================================
 // Test Fixture
@@ -149,6 +150,48 @@ TEST_F(SlideRendererTest, SelectLevel_TieBreaker_PrefersHigherResolution) {
     EXPECT_EQ(level, 0);  // Prefers higher resolution on tie
 }
 
+// ============================================================================
+// Level Selection Strategy Tests
+// ============================================================================
+
+TEST_F(SlideRendererTest, SelectLevelStatic_Closest_MatchesReferenceLogic) {
+    auto slide = CreateStandardSlide();
+
+    for (double zoom = 0.05; zoom <= 2.0; zoom += 0.05) {
+        EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, zoom, LevelSelection::Closest),
+                  TestSelectLevel(slide, zoom))
+            << "zoom=" << zoom;
+    }
+}
+
+TEST_F(SlideRendererTest, SelectLevelStatic_CoarserOrEqual_NeverSharperThanScreen) {
+    auto slide = CreateStandardSlide();
+
+    // Zoom 0.7 → targetDownsample = 1.43: closest is level 0, which would
+    // decode ~2x the pixels the screen shows
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.7, LevelSelection::Closest), 0);
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.7, LevelSelection::CoarserOrEqual), 1);
+
+    // Zoom 0.3 → targetDownsample = 3.33
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.3, LevelSelection::CoarserOrEqual), 2);
+}
+
+TEST_F(SlideRendererTest, SelectLevelStatic_CoarserOrEqual_ExactAndNearlyExactMatches) {
+    // Real pyramids report downsamples slightly off the power of two
+    std::vector<double> downsamples = {1.0, 4.00012, 16.0009};
+
+    EXPECT_EQ(SlideRenderer::SelectLevel(downsamples, 1.0, LevelSelection::CoarserOrEqual), 0);
+    EXPECT_EQ(SlideRenderer::SelectLevel(downsamples, 0.25, LevelSelection::CoarserOrEqual), 1);
+    EXPECT_EQ(SlideRenderer::SelectLevel(downsamples, 1.0 / 16.0, LevelSelection::CoarserOrEqual), 2);
+}
+
+TEST_F(SlideRendererTest, SelectLevelStatic_CoarserOrEqual_ClampsToPyramid) {
+    auto slide = CreateStandardSlide();
+
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 4.0, LevelSelection::CoarserOrEqual), 0);
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.01, LevelSelection::CoarserOrEqual), 3);
+}
+
 // ============================================================================
 // Edge Cases
 // ============================================================================
@@ -269,3 +312,123 @@ TEST_F(SlideRendererTest, LevelSelection_Mathematics_Documented) {
         }
     }
 }
+
+TEST_F(SlideRendererTest, MergeRequests_OneRequestPerTileAtHighestPriority) {
+    TileKey shared{2, 3, 4};
+    TileKey first{2, 5, 4};
+    TileKey otherSlide{2, 3, 4, 1};
+
+    // Two views: the first has a fallback for the shared tile, the second not
+    std::vector<TileLoadRequest> requests = {
+        TileLoadRequest(shared, TileLoadPriority::VISIBLE, 7),
+        TileLoadRequest(first, TileLoadPriority::VISIBLE, 7),
+        TileLoadRequest(shared, TileLoadPriority::URGENT, 7),
+        TileLoadRequest(otherSlide, TileLoadPriority::ADJACENT, 7),
+    };
+    SlideRenderer::MergeRequests(requests);
+
+    ASSERT_EQ(requests.size(), 3u);
+    for (const TileLoadRequest& request : requests) {
+        if (request.key == shared) {
+            EXPECT_EQ(request.priority, TileLoadPriority::URGENT);
+        }
+    }
+}
+
+TEST_F(SlideRendererTest, MergeTileRanges_FallbackFillsGapLeftByPartialPass) {
+    // A 4x4 view whose own level drew all but the right column and bottom
+    // row; the fallback plan must cover exactly that L-shaped gap
+    std::set<std::pair<int32_t, int32_t>> uncovered;  // (y, x)
+    std::set<std::pair<int32_t, int32_t>> gap;
+    for (int32_t i = 0; i < 4; ++i) {
+        gap.insert({i, 3});
+        gap.insert({3, i});
+    }
+    uncovered = gap;
+
+    std::vector<SlideRenderer::TileRange> ranges;
+    SlideRenderer::MergeTileRanges(uncovered, &ranges);
+    EXPECT_TRUE(uncovered.empty());
+
+    // Column first (it starts the top row), then what's left of the row
+    ASSERT_EQ(ranges.size(), 2u);
+    EXPECT_EQ(ranges[0].x0, 3);
+    EXPECT_EQ(ranges[0].y0, 0);
+    EXPECT_EQ(ranges[0].x1, 3);
+    EXPECT_EQ(ranges[0].y1, 3);
+    EXPECT_EQ(ranges[1].x0, 0);
+    EXPECT_EQ(ranges[1].y0, 3);
+    EXPECT_EQ(ranges[1].x1, 2);
+    EXPECT_EQ(ranges[1].y1, 3);
+
+    // Every gap tile once, no tile the pass already drew
+    std::set<std::pair<int32_t, int32_t>> merged;
+    for (const auto& range : ranges) {
+        for (int32_t y = range.y0; y <= range.y1; ++y) {
+            for (int32_t x = range.x0; x <= range.x1; ++x) {
+                EXPECT_TRUE(merged.insert({y, x}).second) << "tile " << x << "," << y << " covered twice";
+            }
+        }
+    }
+    EXPECT_EQ(merged, gap);
+}
+
+TEST_F(SlideRendererTest, MergeTileRanges_JoinsFullBlockIntoOneRange) {
+    std::set<std::pair<int32_t, int32_t>> uncovered;
+    for (int32_t y = 2; y < 5; ++y) {
+        for (int32_t x = 1; x < 3; ++x) {
+            uncovered.insert({y, x});
+        }
+    }
+    std::vector<SlideRenderer::TileRange> ranges;
+    SlideRenderer::MergeTileRanges(uncovered, &ranges);
+
+    ASSERT_EQ(ranges.size(), 1u);
+    EXPECT_EQ(ranges[0].x0, 1);
+    EXPECT_EQ(ranges[0].y0, 2);
+    EXPECT_EQ(ranges[0].x1, 2);
+    EXPECT_EQ(ranges[0].y1, 4);
+}
+
+// ============================================================================
+// Motion-Adaptive Resolution Tests
+// ============================================================================
+
+TEST_F(SlideRendererTest, MotionBias_CoarsensWithScreenSpeed) {
+    const double speed = SlideRenderer::MOTION_SPEED;
+    EXPECT_EQ(SlideRenderer::MotionBias(0.0, 2), 0);
+    EXPECT_EQ(SlideRenderer::MotionBias(speed * 0.9, 2), 0);
+    EXPECT_EQ(SlideRenderer::MotionBias(speed, 2), 1);
+    EXPECT_EQ(SlideRenderer::MotionBias(speed * 2.0, 2), 2);
+    EXPECT_EQ(SlideRenderer::MotionBias(speed * 10.0, 2), 2);
+}
+
+TEST_F(SlideRendererTest, MotionBias_CappedByMaxLevels) {
+    const double fast = SlideRenderer::MOTION_SPEED * 4.0;
+    EXPECT_EQ(SlideRenderer::MotionBias(fast, 1), 1);
+    EXPECT_EQ(SlideRenderer::MotionBias(fast, 0), 0);
+}
+
+// ============================================================================
+// Level Hysteresis Tests
+// ============================================================================
+
+TEST_F(SlideRendererTest, SelectLevelHysteresis_KeepsCurrentNearBoundary) {
+    auto slide = CreateStandardSlide();
+    // Closest switches between levels 0 and 1 at downsample 1.5 (zoom 0.667)
+    const double justPast = 1.0 / 1.55;
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, justPast, LevelSelection::Closest), 1);
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, justPast, LevelSelection::Closest, 0), 0);
+
+    const double justBefore = 1.0 / 1.45;
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, justBefore, LevelSelection::Closest, 1), 1);
+}
+
+TEST_F(SlideRendererTest, SelectLevelHysteresis_SwitchesWellPastBoundary) {
+    auto slide = CreateStandardSlide();
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 1.0 / 1.9, LevelSelection::Closest, 0), 1);
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 1.0 / 1.1, LevelSelection::Closest, 1), 0);
+    // Non-adjacent or no current level: plain selection
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.125, LevelSelection::Closest, 0), 3);
+    EXPECT_EQ(SlideRenderer::SelectLevel(slide.level_downsamples, 0.5, LevelSelection::Closest, -1), 1);
+}
@@ -0,0 +1,199 @@
+// SlideTranscoder Unit Tests
+// Tests for the pathview-convert pipeline: the power-of-two level count,
+// the pyramidal TIFF it writes (read back through TiffTileReader),
+// compositing of transparent pixels, read failures, cancelling and how
+// many decoded tiles it holds at once. Each test converts a synthetic
+// slide into a temp directory.
+
+#include <gtest/gtest.h>
+#include "SlideTranscoder.h"
+#include "TiffTileReader.h"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t TOP_LEFT = 0xFFC03020;
+constexpr uint32_t TOP_RIGHT = 0xFF20C030;
+constexpr uint32_t BOTTOM_LEFT = 0xFF3020C0;
+constexpr uint32_t BOTTOM_RIGHT = 0xFF808080;
+
+// A width x height slide in four solid quadrants, transparent outside
+SlideTranscoder::RegionReader QuadrantSlide(int64_t width, int64_t height) {
+    return [width, height](int64_t x, int64_t y, int64_t regionWidth, int64_t regionHeight, uint32_t* pixels) {
+        for (int64_t row = 0; row < regionHeight; ++row) {
+            for (int64_t column = 0; column < regionWidth; ++column) {
+                int64_t px = x + column;
+                int64_t py = y + row;
+                uint32_t color = 0;
+                if (px < width && py < height) {
+                    bool right = px >= width / 2;
+                    bool bottom = py >= height / 2;
+                    color = bottom ? (right ? BOTTOM_RIGHT : BOTTOM_LEFT) : (right ? TOP_RIGHT : TOP_LEFT);
+                }
+                pixels[row * regionWidth + column] = color;
+            }
+        }
+        return true;
+    };
+}
+
+void ExpectColorNear(uint32_t pixel, uint32_t expected, const std::string& where) {
+    EXPECT_EQ(pixel >> 24, 0xFFu) << where;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        EXPECT_NEAR(static_cast<int>((pixel >> shift) & 0xFF), static_cast<int>((expected >> shift) & 0xFF), 6)
+            << where;
+    }
+}
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class SlideTranscoderTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_transcoder_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    static SlideTranscoder::Options SmallTiles() {
+        SlideTranscoder::Options options;
+        options.tileSize = 64;
+        options.threads = 4;
+        return options;
+    }
+};
+
+// ============================================================================
+// Level Count Tests
+// ============================================================================
+
+TEST_F(SlideTranscoderTest, LevelCount_HalvesUntilOneTile) {
+    EXPECT_EQ(SlideTranscoder::LevelCount(512, 512, 512), 1);
+    EXPECT_EQ(SlideTranscoder::LevelCount(513, 100, 512), 2);
+    EXPECT_EQ(SlideTranscoder::LevelCount(1000, 600, 512), 2);
+    // 100000 wide: 196 tiles, so 8 halvings to get under one
+    EXPECT_EQ(SlideTranscoder::LevelCount(100000, 40000, 512), 9);
+}
+
+TEST_F(SlideTranscoderTest, Convert_InvalidTileSize_Fails) {
+    SlideTranscoder::Options options;
+    options.tileSize = 100;  // Not a whole number of JPEG blocks
+    auto result = SlideTranscoder::Convert(200, 200, QuadrantSlide(200, 200), (root / "out.tiff").string(), options);
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(result.error.empty());
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+// ============================================================================
+// Conversion Tests
+// ============================================================================
+
+TEST_F(SlideTranscoderTest, Convert_WritesPyramidTheTiffReaderServes) {
+    std::string path = (root / "out.tiff").string();
+    auto result = SlideTranscoder::Convert(600, 360, QuadrantSlide(600, 360), path, SmallTiles());
+    ASSERT_TRUE(result.ok) << result.error;
+    // 600x360, 300x180, 150x90, 75x45 (a single 64 tile needs 38x23)
+    EXPECT_EQ(result.levels, 5);
+    EXPECT_EQ(result.tiles, 60u + 15u + 6u + 2u + 1u);
+
+    TiffTileReader reader(path);
+    ASSERT_TRUE(reader.IsOpen());
+    // The thumbnail directory is stripped, so not a level
+    std::vector<LevelDimensions> levels = reader.GetPyramidLevels();
+    ASSERT_EQ(levels.size(), 5u);
+    EXPECT_EQ(levels[0].width, 600);
+    EXPECT_EQ(levels[0].height, 360);
+    EXPECT_EQ(levels[1].width, 300);
+    EXPECT_EQ(levels[4].width, 38);
+    EXPECT_EQ(levels[4].height, 23);
+    ASSERT_EQ(reader.BindLevels(levels), 5u);
+    EXPECT_EQ(reader.GetTileSize(0).width, 64);
+
+    for (int32_t level = 0; level < 5; ++level) {
+        int64_t width = levels[static_cast<size_t>(level)].width;
+        int64_t height = levels[static_cast<size_t>(level)].height;
+        std::vector<uint32_t> pixels(static_cast<size_t>(width * height), 0);
+        ASSERT_TRUE(reader.ReadRegion(level, 0, 0, width, height, pixels.data())) << "level " << level;
+        auto at = [&](int64_t x, int64_t y) { return pixels[static_cast<size_t>(y * width + x)]; };
+        std::string where = "level " + std::to_string(level);
+        ExpectColorNear(at(width / 4, height / 4), TOP_LEFT, where);
+        ExpectColorNear(at(width * 3 / 4, height / 4), TOP_RIGHT, where);
+        ExpectColorNear(at(width / 4, height * 3 / 4), BOTTOM_LEFT, where);
+        ExpectColorNear(at(width * 3 / 4, height * 3 / 4), BOTTOM_RIGHT, where);
+    }
+}
+
+TEST_F(SlideTranscoderTest, Convert_TransparentPixels_WrittenWhite) {
+    std::string path = (root / "out.tiff").string();
+    auto clear = [](int64_t, int64_t, int64_t width, int64_t height, uint32_t* pixels) {
+        std::fill(pixels, pixels + width * height, 0u);
+        return true;
+    };
+    auto result = SlideTranscoder::Convert(128, 128, clear, path, SmallTiles());
+    ASSERT_TRUE(result.ok) << result.error;
+
+    TiffTileReader reader(path);
+    ASSERT_EQ(reader.BindLevels(reader.GetPyramidLevels()), 2u);
+    std::vector<uint32_t> pixels(64 * 64, 0);
+    ASSERT_TRUE(reader.ReadRegion(1, 0, 0, 64, 64, pixels.data()));
+    ExpectColorNear(pixels[32 * 64 + 32], 0xFFFFFFFF, "level 1");
+}
+
+TEST_F(SlideTranscoderTest, Convert_ReadFailure_ReportsError) {
+    std::atomic<int> reads{0};
+    auto failing = [&reads](int64_t, int64_t, int64_t width, int64_t height, uint32_t* pixels) {
+        std::fill(pixels, pixels + width * height, 0xFFFFFFFFu);
+        return reads.fetch_add(1) < 5;
+    };
+    auto result = SlideTranscoder::Convert(640, 640, failing, (root / "out.tiff").string(), SmallTiles());
+    EXPECT_FALSE(result.ok);
+    EXPECT_NE(result.error.find("read"), std::string::npos);
+}
+
+TEST_F(SlideTranscoderTest, Convert_Cancelled_StopsReading) {
+    std::atomic<int> reads{0};
+    auto counting = [&reads](int64_t, int64_t, int64_t width, int64_t height, uint32_t* pixels) {
+        std::fill(pixels, pixels + width * height, 0xFFFFFFFFu);
+        reads.fetch_add(1);
+        return true;
+    };
+    SlideTranscoder::Options options = SmallTiles();
+    options.cancelled = [&reads] { return reads.load() >= 8; };
+    options.backgroundPriority = true;
+    auto result = SlideTranscoder::Convert(1024, 1024, counting, (root / "out.tiff").string(), options);
+    EXPECT_FALSE(result.ok);
+    EXPECT_TRUE(result.cancelled);
+    // Each worker finishes the tile it has
+    EXPECT_LE(reads.load(), 8 + static_cast<int>(options.threads));
+}
+
+TEST_F(SlideTranscoderTest, Convert_HoldsFewTilesAtOnce) {
+    // 64 x 64 level 0 tiles; parents are built as soon as their children
+    // are written, so only a handful of tiles ever wait for siblings
+    auto result = SlideTranscoder::Convert(4096, 4096, QuadrantSlide(4096, 4096), (root / "out.tiff").string(),
+                                           SmallTiles());
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.levels, 7);
+    EXPECT_LT(result.peakPendingTiles, 64u);
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
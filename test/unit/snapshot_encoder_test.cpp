@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include "../../src/core/SnapshotEncoder.h"
+#include "../../src/core/PNGEncoder.h"
+#include <zlib.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace pathview;
+
+namespace {
+
+// Noisy gradient with flat patches: exercises every QOI op and gives
+// deflate something to do
+std::vector<uint8_t> MakeFrame(int width, int height) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* px = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            seed = seed * 1664525 + 1013904223;
+            const bool flat = ((x / 16) + (y / 16)) % 3 == 0;
+            px[0] = flat ? 240 : static_cast<uint8_t>(x + (seed >> 29));
+            px[1] = flat ? 235 : static_cast<uint8_t>(y * 2);
+            px[2] = flat ? 245 : static_cast<uint8_t>(seed >> 24);
+            px[3] = (x % 97 == 0) ? 128 : 255;
+        }
+    }
+    return pixels;
+}
+
+uint32_t ReadBigEndian32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Minimal PNG reader for what PNGEncoder writes (RGBA8, Up filter):
+// checks every chunk CRC, inflates the IDATs as one zlib stream
+bool DecodePng(const std::vector<uint8_t>& png, int& width, int& height, std::vector<uint8_t>& pixels) {
+    if (png.size() < 8 || png[0] != 0x89 || png[1] != 'P') return false;
+    std::vector<uint8_t> idat;
+    size_t at = 8;
+    while (at + 12 <= png.size()) {
+        const uint32_t length = ReadBigEndian32(&png[at]);
+        const uint8_t* type = &png[at + 4];
+        if (at + 12 + length > png.size()) return false;
+        const uLong crc = crc32(0L, type, length + 4);
+        if (crc != ReadBigEndian32(type + 4 + length)) return false;
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            width = static_cast<int>(ReadBigEndian32(type + 4));
+            height = static_cast<int>(ReadBigEndian32(type + 8));
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), type + 4, type + 4 + length);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        at += 12 + length;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> filtered((rowBytes + 1) * height);
+    uLongf filteredSize = static_cast<uLongf>(filtered.size());
+    if (uncompress(filtered.data(), &filteredSize, idat.data(), static_cast<uLong>(idat.size())) != Z_OK ||
+        filteredSize != filtered.size()) {
+        return false;
+    }
+    pixels.assign(rowBytes * height, 0);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* in = &filtered[y * (rowBytes + 1)];
+        if (in[0] != 2) return false;  // Up
+        uint8_t* row = &pixels[y * rowBytes];
+        for (size_t i = 0; i < rowBytes; ++i) {
+            row[i] = static_cast<uint8_t>(in[1 + i] + (y > 0 ? row[i - rowBytes] : 0));
+        }
+    }
+    return true;
+}
+
+// Reference QOI decoder, straight from the specification
+bool DecodeQoi(const std::vector<uint8_t>& qoi, int& width, int& height, std::vector<uint8_t>& pixels) {
+    if (qoi.size() < 22 || std::memcmp(qoi.data(), "qoif", 4) != 0) return false;
+    width = static_cast<int>(ReadBigEndian32(&qoi[4]));
+    height = static_cast<int>(ReadBigEndian32(&qoi[8]));
+    pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+    uint8_t index[64][4] = {};
+    uint8_t px[4] = {0, 0, 0, 255};
+    size_t at = 14;
+    const size_t end = qoi.size() - 8;
+    int run = 0;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        if (run > 0) {
+            --run;
+        } else if (at < end) {
+            const uint8_t op = qoi[at++];
+            if (op == 0xFE) {
+                px[0] = qoi[at++]; px[1] = qoi[at++]; px[2] = qoi[at++];
+            } else if (op == 0xFF) {
+                px[0] = qoi[at++]; px[1] = qoi[at++]; px[2] = qoi[at++]; px[3] = qoi[at++];
+            } else if ((op & 0xC0) == 0x00) {
+                std::memcpy(px, index[op], 4);
+            } else if ((op & 0xC0) == 0x40) {
+                px[0] += ((op >> 4) & 3) - 2;
+                px[1] += ((op >> 2) & 3) - 2;
+                px[2] += (op & 3) - 2;
+            } else if ((op & 0xC0) == 0x80) {
+                const uint8_t second = qoi[at++];
+                const int dg = (op & 0x3F) - 32;
+                px[0] += dg - 8 + ((second >> 4) & 0x0F);
+                px[1] += dg;
+                px[2] += dg - 8 + (second & 0x0F);
+            } else {
+                run = op & 0x3F;
+            }
+            std::memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        }
+        std::memcpy(&pixels[i], px, 4);
+    }
+    const uint8_t marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    return at == end && std::memcmp(&qoi[end], marker, 8) == 0;
+}
+
+}  // namespace
+
+// Strips from several threads must still make one valid zlib stream
+TEST(SnapshotEncoderTest, ParallelPngRoundTrips) {
+    const int width = 700;
+    const int height = 333;  // Several strips, the last one short
+    std::vector<uint8_t> pixels = MakeFrame(width, height);
+
+    for (size_t threads : {size_t(1), size_t(4)}) {
+        std::vector<uint8_t> png = PNGEncoder::Encode(pixels, width, height, PNGEncoder::FAST_LEVEL, threads);
+        int decodedWidth = 0;
+        int decodedHeight = 0;
+        std::vector<uint8_t> decoded;
+        ASSERT_TRUE(DecodePng(png, decodedWidth, decodedHeight, decoded)) << threads << " threads";
+        EXPECT_EQ(decodedWidth, width);
+        EXPECT_EQ(decodedHeight, height);
+        EXPECT_EQ(decoded, pixels) << threads << " threads";
+    }
+}
+
+// Strip boundaries don't depend on the thread count, so neither do the bytes
+TEST(SnapshotEncoderTest, PngIndependentOfThreadCount) {
+    std::vector<uint8_t> pixels = MakeFrame(1024, 512);
+    EXPECT_EQ(PNGEncoder::Encode(pixels, 1024, 512, PNGEncoder::FAST_LEVEL, 1),
+              PNGEncoder::Encode(pixels, 1024, 512, PNGEncoder::FAST_LEVEL, 8));
+}
+
+TEST(SnapshotEncoderTest, QoiRoundTrips) {
+    const int width = 301;
+    const int height = 97;
+    std::vector<uint8_t> pixels = MakeFrame(width, height);
+
+    SnapshotEncoder::Options options;
+    options.format = SnapshotFormat::Qoi;
+    SnapshotEncoder::Result result = SnapshotEncoder::Encode(pixels, width, height, options);
+    EXPECT_EQ(result.format, SnapshotFormat::Qoi);
+
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    std::vector<uint8_t> decoded;
+    ASSERT_TRUE(DecodeQoi(result.data, decodedWidth, decodedHeight, decoded));
+    EXPECT_EQ(decodedWidth, width);
+    EXPECT_EQ(decodedHeight, height);
+    EXPECT_EQ(decoded, pixels);
+}
+
+// Formats this build lacks come back as PNG, and say so
+TEST(SnapshotEncoderTest, UnsupportedFormatsFallBackToPng) {
+    std::vector<uint8_t> pixels = MakeFrame(64, 64);
+    for (SnapshotFormat format : {SnapshotFormat::Jpeg, SnapshotFormat::WebP}) {
+        SnapshotEncoder::Options options;
+        options.format = format;
+        options.quality = 80;
+        SnapshotEncoder::Result result = SnapshotEncoder::Encode(pixels, 64, 64, options);
+        ASSERT_GE(result.data.size(), 4u);
+        if (SnapshotEncoder::IsSupported(format)) {
+            EXPECT_EQ(result.format, format);
+        } else {
+            EXPECT_EQ(result.format, SnapshotFormat::Png);
+            EXPECT_EQ(result.data[1], 'P');
+        }
+    }
+}
+
+TEST(SnapshotEncoderTest, ParsesFormatNames) {
+    EXPECT_EQ(SnapshotEncoder::ParseFormat("png"), SnapshotFormat::Png);
+    EXPECT_EQ(SnapshotEncoder::ParseFormat("jpg"), SnapshotFormat::Jpeg);
+    EXPECT_EQ(SnapshotEncoder::ParseFormat("jpeg"), SnapshotFormat::Jpeg);
+    EXPECT_EQ(SnapshotEncoder::ParseFormat("webp"), SnapshotFormat::WebP);
+    EXPECT_EQ(SnapshotEncoder::ParseFormat("qoi"), SnapshotFormat::Qoi);
+    EXPECT_FALSE(SnapshotEncoder::ParseFormat("gif").has_value());
+    EXPECT_STREQ(SnapshotEncoder::MimeType(SnapshotFormat::Jpeg), "image/jpeg");
+}
+
+TEST(SnapshotEncoderTest, FitSize_ScaleAndLongerSide) {
+    int width = 0, height = 0;
+    SnapshotEncoder::FitSize(1920, 1080, 0, 1.0, width, height);
+    EXPECT_EQ(width, 1920);
+    EXPECT_EQ(height, 1080);
+    SnapshotEncoder::FitSize(1920, 1080, 1024, 1.0, width, height);
+    EXPECT_EQ(width, 1024);
+    EXPECT_EQ(height, 576);
+    SnapshotEncoder::FitSize(1080, 1920, 0, 0.25, width, height);
+    EXPECT_EQ(width, 270);
+    EXPECT_EQ(height, 480);
+    // Both: the smaller wins; never upscaled
+    SnapshotEncoder::FitSize(1920, 1080, 512, 0.5, width, height);
+    EXPECT_EQ(width, 512);
+    SnapshotEncoder::FitSize(640, 480, 4096, 1.0, width, height);
+    EXPECT_EQ(width, 640);
+    EXPECT_EQ(height, 480);
+}
+
+TEST(SnapshotEncoderTest, Downscale_AveragesBlocks) {
+    // 4x2 RGBA: left 2x2 block black, right 2x2 block white
+    std::vector<uint8_t> pixels(4 * 2 * 4, 0);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 2; x < 4; ++x) {
+            std::memset(&pixels[(y * 4 + x) * 4], 255, 4);
+        }
+    }
+    std::vector<uint8_t> out = SnapshotEncoder::Downscale(pixels, 4, 2, 2, 1);
+    ASSERT_EQ(out.size(), 8u);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[4], 255);
+
+    std::vector<uint8_t> frame = MakeFrame(301, 199);
+    std::vector<uint8_t> small = SnapshotEncoder::Downscale(frame, 301, 199, 100, 66);
+    EXPECT_EQ(small.size(), 100u * 66 * 4);
+    EXPECT_THROW(SnapshotEncoder::Downscale(frame, 302, 199, 100, 66), std::runtime_error);
+}
+
+TEST(SnapshotEncoderTest, ContentKey_PixelsSizeAndEncoding) {
+    std::vector<uint8_t> frame = MakeFrame(61, 37);
+    SnapshotEncoder::Options png;
+    const uint64_t key = SnapshotEncoder::ContentKey(frame, 61, 37, png);
+    EXPECT_EQ(SnapshotEncoder::ContentKey(std::vector<uint8_t>(frame), 61, 37, png), key);
+
+    // One byte anywhere, including the tail past the last whole block
+    for (size_t at : {size_t(0), frame.size() / 2, frame.size() - 1}) {
+        std::vector<uint8_t> changed = frame;
+        changed[at] ^= 1;
+        EXPECT_NE(SnapshotEncoder::ContentKey(changed, 61, 37, png), key);
+    }
+    SnapshotEncoder::Options jpeg;
+    jpeg.format = SnapshotFormat::Jpeg;
+    EXPECT_NE(SnapshotEncoder::ContentKey(frame, 61, 37, jpeg), key);
+    jpeg.quality = 50;
+    EXPECT_NE(SnapshotEncoder::ContentKey(frame, 61, 37, jpeg), SnapshotEncoder::ContentKey(frame, 61, 37, png));
+    EXPECT_NE(SnapshotEncoder::ContentKey(frame, 37, 61, png), key);
+}
+
+TEST(EncodedImageCacheTest, KeepsMostRecent) {
+    EncodedImageCache cache;
+    EXPECT_EQ(cache.Find(1), nullptr);
+    for (uint64_t key = 1; key <= EncodedImageCache::CAPACITY; ++key) {
+        auto image = std::make_shared<SnapshotEncoder::Result>();
+        image->data.assign(size_t(key), uint8_t(key));
+        cache.Insert(key, image);
+    }
+    // Touching 1 leaves 2 the least recent
+    ASSERT_NE(cache.Find(1), nullptr);
+    EXPECT_EQ(cache.Find(1)->data.size(), 1u);
+    cache.Insert(100, std::make_shared<SnapshotEncoder::Result>());
+    EXPECT_EQ(cache.Find(2), nullptr);
+    EXPECT_NE(cache.Find(1), nullptr);
+    EXPECT_NE(cache.Find(100), nullptr);
+}
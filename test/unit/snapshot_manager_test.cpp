@@ -16,11 +16,11 @@ TEST(SnapshotManagerTest, AddAndGetSnapshot) {
     EXPECT_FALSE(id.empty());
 
     auto snapshot = mgr.GetSnapshot(id);
-    ASSERT_TRUE(snapshot.has_value());
+    ASSERT_NE(snapshot, nullptr);
     EXPECT_EQ(snapshot->id, id);
     EXPECT_EQ(snapshot->width, 100);
     EXPECT_EQ(snapshot->height, 100);
-    EXPECT_EQ(snapshot->pngData, dummyPNG);
+    EXPECT_EQ(*snapshot->data, dummyPNG);
 }
 
 // Test LRU cache eviction
@@ -36,10 +36,35 @@ TEST(SnapshotManagerTest, LRUEviction) {
     std::string id4 = mgr.AddSnapshot(dummyPNG, 10, 10);
 
     // id1 should be evicted
-    EXPECT_FALSE(mgr.GetSnapshot(id1).has_value());
-    EXPECT_TRUE(mgr.GetSnapshot(id2).has_value());
-    EXPECT_TRUE(mgr.GetSnapshot(id3).has_value());
-    EXPECT_TRUE(mgr.GetSnapshot(id4).has_value());
+    EXPECT_EQ(mgr.GetSnapshot(id1), nullptr);
+    EXPECT_NE(mgr.GetSnapshot(id2), nullptr);
+    EXPECT_NE(mgr.GetSnapshot(id3), nullptr);
+    EXPECT_NE(mgr.GetSnapshot(id4), nullptr);
+}
+
+// Test eviction by encoded bytes, least recently used first
+TEST(SnapshotManagerTest, ByteBudgetEviction) {
+    SnapshotManager mgr(50, std::chrono::milliseconds(10), 1000);
+
+    std::string id1 = mgr.AddSnapshot(std::vector<uint8_t>(400), 10, 10);
+    std::string id2 = mgr.AddSnapshot(std::vector<uint8_t>(400), 10, 10);
+    EXPECT_EQ(mgr.GetMemoryUsage(), 800u);
+
+    // Touch id1 so id2 is the least recently used
+    auto held = mgr.GetSnapshot(id1);
+    std::string id3 = mgr.AddSnapshot(std::vector<uint8_t>(400), 10, 10);
+
+    EXPECT_EQ(mgr.GetSnapshot(id2), nullptr);
+    EXPECT_NE(mgr.GetSnapshot(id3), nullptr);
+    EXPECT_EQ(mgr.GetMemoryUsage(), 800u);
+
+    // Over the whole budget: kept alone; a snapshot handed out before
+    // eviction stays valid
+    std::string big = mgr.AddSnapshot(std::vector<uint8_t>(2000), 10, 10);
+    EXPECT_NE(mgr.GetSnapshot(big), nullptr);
+    EXPECT_EQ(mgr.GetCacheSize(), 1u);
+    EXPECT_EQ(mgr.GetMemoryUsage(), 2000u);
+    EXPECT_EQ(held->data->size(), 400u);
 }
 
 // Test cache size reporting
@@ -97,7 +122,7 @@ TEST(SnapshotManagerTest, StreamBufferEviction) {
 
     // All snapshots should still be in the main cache (capacity 50)
     for (const auto& id : ids) {
-        EXPECT_TRUE(mgr.GetSnapshot(id).has_value());
+        EXPECT_NE(mgr.GetSnapshot(id), nullptr);
     }
 }
 
@@ -122,7 +147,7 @@ TEST(SnapshotManagerTest, ThreadSafety) {
                 std::string id = mgr.AddSnapshot(dummyPNG, 10 + t, 10 + t);
                 mgr.AddStreamFrame(id);
                 auto snapshot = mgr.GetSnapshot(id);
-                EXPECT_TRUE(snapshot.has_value());
+                EXPECT_NE(snapshot, nullptr);
             }
         });
     }
@@ -143,14 +168,14 @@ TEST(SnapshotManagerTest, CleanupRemovesExpired) {
 
     // Add a snapshot
     std::string id = mgr.AddSnapshot(dummyPNG, 10, 10);
-    EXPECT_TRUE(mgr.GetSnapshot(id).has_value());
+    EXPECT_NE(mgr.GetSnapshot(id), nullptr);
 
     // Manually call Cleanup (normally called by background thread)
     // Note: Snapshots expire after 1 hour, so they won't be removed here
     mgr.Cleanup();
 
     // Snapshot should still exist (not expired yet)
-    EXPECT_TRUE(mgr.GetSnapshot(id).has_value());
+    EXPECT_NE(mgr.GetSnapshot(id), nullptr);
 }
 
 // Test UUID generation produces valid UUIDs
@@ -172,3 +197,26 @@ TEST(SnapshotManagerTest, UUIDGeneration) {
     EXPECT_EQ(id1[18], '-');
     EXPECT_EQ(id1[23], '-');
 }
+
+// A content key is the ID; the same content again keeps the first snapshot
+TEST(SnapshotManagerTest, ContentKeyDeduplicates) {
+    SnapshotManager mgr(2, std::chrono::milliseconds(10));
+
+    std::string id1 = mgr.AddSnapshot(std::vector<uint8_t>{1, 2, 3}, 10, 10, "image/png", "00000000000000ab");
+    EXPECT_EQ(id1, "00000000000000ab");
+    auto first = mgr.GetSnapshot(id1);
+    ASSERT_NE(first, nullptr);
+
+    std::string id2 = mgr.AddSnapshot(std::vector<uint8_t>{1, 2, 3}, 10, 10, "image/png", "00000000000000ab");
+    EXPECT_EQ(id2, id1);
+    EXPECT_EQ(mgr.GetCacheSize(), 1u);
+    EXPECT_EQ(mgr.GetMemoryUsage(), 3u);
+    EXPECT_EQ(mgr.GetSnapshot(id1), first);
+
+    // Re-adding made it recent: the other one goes first
+    std::string other = mgr.AddSnapshot(std::vector<uint8_t>{4}, 1, 1);
+    mgr.AddSnapshot(std::vector<uint8_t>{1, 2, 3}, 10, 10, "image/png", id1);
+    mgr.AddSnapshot(std::vector<uint8_t>{5}, 1, 1);
+    EXPECT_EQ(mgr.GetSnapshot(other), nullptr);
+    EXPECT_NE(mgr.GetSnapshot(id1), nullptr);
+}
@@ -0,0 +1,127 @@
+// SnapshotRing Unit Tests
+// Tests for handing snapshot bytes over through the shared-memory ring:
+// reading a slot back through a second mapping, oversized data, slots
+// reused by later writes, opening a ring that does not exist and mapping
+// one from a passed descriptor
+
+#include <gtest/gtest.h>
+#include "SnapshotRing.h"
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using pathview::ipc::SnapshotRing;
+
+namespace {
+
+std::string TestRingName() {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    return SnapshotRing::DefaultName() + "-" + info->name();
+}
+
+std::vector<uint8_t> Pattern(size_t size, uint8_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(seed + i * 31);
+    }
+    return data;
+}
+
+}  // namespace
+
+TEST(SnapshotRingTest, Write_ReadsBackThroughAnotherMapping) {
+    std::unique_ptr<SnapshotRing> writer = SnapshotRing::Create(TestRingName(), 3, 4096);
+    ASSERT_NE(writer, nullptr);
+    std::unique_ptr<SnapshotRing> reader = SnapshotRing::Open(TestRingName());
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->GetSlotCount(), 3u);
+    EXPECT_EQ(reader->GetSlotBytes(), 4096u);
+
+    const std::vector<uint8_t> first = Pattern(1000, 1);
+    const std::vector<uint8_t> second = Pattern(4096, 2);
+    SnapshotRing::SlotRef a, b;
+    ASSERT_TRUE(writer->Write(first.data(), first.size(), a));
+    ASSERT_TRUE(writer->Write(second.data(), second.size(), b));
+    EXPECT_NE(a.slot, b.slot);
+    EXPECT_EQ(a.size, 1000u);
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(reader->Read(b, out));
+    EXPECT_EQ(out, second);
+    ASSERT_TRUE(reader->Read(a, out));
+    EXPECT_EQ(out, first);
+
+    // Readers cannot write, and nothing larger than a slot fits
+    SnapshotRing::SlotRef c;
+    EXPECT_FALSE(reader->Write(first.data(), first.size(), c));
+    const std::vector<uint8_t> large = Pattern(4097, 3);
+    EXPECT_FALSE(writer->Write(large.data(), large.size(), c));
+}
+
+TEST(SnapshotRingTest, ReusedSlot_IsNoLongerRead) {
+    std::unique_ptr<SnapshotRing> writer = SnapshotRing::Create(TestRingName(), 2, 256);
+    ASSERT_NE(writer, nullptr);
+    std::unique_ptr<SnapshotRing> reader = SnapshotRing::Open(TestRingName());
+    ASSERT_NE(reader, nullptr);
+
+    const std::vector<uint8_t> data = Pattern(200, 4);
+    SnapshotRing::SlotRef first, second, third;
+    ASSERT_TRUE(writer->Write(data.data(), data.size(), first));
+    ASSERT_TRUE(writer->Write(data.data(), data.size(), second));
+    ASSERT_TRUE(writer->Write(data.data(), 100, third));
+    EXPECT_EQ(third.slot, first.slot);
+
+    std::vector<uint8_t> out;
+    EXPECT_FALSE(reader->Read(first, out));
+    EXPECT_TRUE(reader->Read(second, out));
+    ASSERT_TRUE(reader->Read(third, out));
+    EXPECT_EQ(out, std::vector<uint8_t>(data.begin(), data.begin() + 100));
+
+    // References that never came from a write
+    SnapshotRing::SlotRef bogus;
+    EXPECT_FALSE(reader->Read(bogus, out));
+    bogus = third;
+    bogus.slot = 7;
+    EXPECT_FALSE(reader->Read(bogus, out));
+}
+
+TEST(SnapshotRingTest, Open_MissingRingFails) {
+    EXPECT_EQ(SnapshotRing::Open(TestRingName()), nullptr);
+
+    // The owner removes the ring when it goes
+    SnapshotRing::Create(TestRingName(), 1, 64).reset();
+    EXPECT_EQ(SnapshotRing::Open(TestRingName()), nullptr);
+}
+
+#ifndef _WIN32
+TEST(SnapshotRingTest, OpenFd_MapsOwnersDescriptor) {
+    std::unique_ptr<SnapshotRing> writer = SnapshotRing::Create(TestRingName(), 2, 512);
+    ASSERT_NE(writer, nullptr);
+    ASSERT_GE(writer->GetFd(), 0);
+
+    // As IPCServer::AttachDescriptor would pass it
+    std::unique_ptr<SnapshotRing> reader =
+        SnapshotRing::OpenFd(fcntl(writer->GetFd(), F_DUPFD_CLOEXEC, 0), writer->GetName());
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->GetFd(), -1);
+    EXPECT_EQ(reader->GetSlotCount(), 2u);
+
+    const std::vector<uint8_t> data = Pattern(300, 5);
+    SnapshotRing::SlotRef ref;
+    ASSERT_TRUE(writer->Write(data.data(), data.size(), ref));
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(reader->Read(ref, out));
+    EXPECT_EQ(out, data);
+
+    // Not a ring
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[1]);
+    EXPECT_EQ(SnapshotRing::OpenFd(fds[0], "pipe"), nullptr);
+    EXPECT_EQ(SnapshotRing::OpenFd(-1, "none"), nullptr);
+}
+#endif
@@ -0,0 +1,50 @@
+// StartupTimings Unit Tests
+// Tests for phases timed between marks, the time to first frame, phases
+// deferred past it, and the printed breakdown
+
+#include <gtest/gtest.h>
+#include "StartupTimings.h"
+
+using Clock = StartupTimings::Clock;
+using std::chrono::milliseconds;
+
+TEST(StartupTimingsTest, Mark_TimesEachPhaseFromTheLast) {
+    const Clock::time_point start = Clock::now();
+    StartupTimings timings(start);
+    timings.Mark("SDL init", start + milliseconds(20));
+    timings.Mark("window", start + milliseconds(50));
+
+    ASSERT_EQ(timings.GetPhases().size(), 2u);
+    EXPECT_EQ(timings.GetPhases()[0].name, "SDL init");
+    EXPECT_DOUBLE_EQ(timings.GetPhases()[0].ms, 20.0);
+    EXPECT_DOUBLE_EQ(timings.GetPhases()[1].ms, 30.0);
+    EXPECT_FALSE(timings.GetPhases()[1].deferred);
+    EXPECT_FALSE(timings.HasFirstFrame());
+    EXPECT_DOUBLE_EQ(timings.GetFirstFrameMs(), -1.0);
+    EXPECT_DOUBLE_EQ(timings.GetTotalMs(), 50.0);
+}
+
+TEST(StartupTimingsTest, MarkFirstFrame_SplitsOffTheDeferredPhases) {
+    const Clock::time_point start = Clock::now();
+    StartupTimings timings(start);
+    timings.Mark("renderer", start + milliseconds(40));
+    timings.MarkFirstFrame(start + milliseconds(100));
+    timings.MarkFirstFrame(start + milliseconds(150));  // Ignored
+    timings.Mark("IPC listener", start + milliseconds(110));
+
+    ASSERT_EQ(timings.GetPhases().size(), 3u);
+    EXPECT_EQ(timings.GetPhases()[1].name, "first frame");
+    EXPECT_DOUBLE_EQ(timings.GetPhases()[1].ms, 60.0);
+    EXPECT_FALSE(timings.GetPhases()[1].deferred);
+    EXPECT_TRUE(timings.GetPhases()[2].deferred);
+    EXPECT_DOUBLE_EQ(timings.GetFirstFrameMs(), 100.0);
+    EXPECT_DOUBLE_EQ(timings.GetTotalMs(), 110.0);
+
+    const std::string text = timings.Format();
+    const size_t firstFrame = text.find("time to first frame");
+    ASSERT_NE(firstFrame, std::string::npos);
+    EXPECT_NE(text.find("100.0 ms", firstFrame), std::string::npos);
+    EXPECT_LT(text.find("renderer"), firstFrame);
+    EXPECT_GT(text.find("IPC listener"), firstFrame);
+    EXPECT_NE(text.find("total"), std::string::npos);
+}
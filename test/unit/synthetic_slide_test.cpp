@@ -0,0 +1,208 @@
+// SyntheticSlide Unit Tests
+// Tests for the procedural benchmark slide: parsing synthetic:// paths,
+// its level pyramid, deterministic pixels, and the cell generator's
+// counts and bounds.
+
+#include <gtest/gtest.h>
+#include "SyntheticSlide.h"
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Spec parsing
+// ============================================================================
+
+TEST(SyntheticSlideSpecTest, Parse_ReadsSizeAndQuery) {
+    SyntheticSlideSpec spec;
+    std::string error;
+    ASSERT_TRUE(SyntheticSlideSpec::Parse("synthetic://4000x3000?levels=3&tile=512&latency_us=800&seed=7",
+                                          spec, error)) << error;
+    EXPECT_EQ(spec.width, 4000);
+    EXPECT_EQ(spec.height, 3000);
+    EXPECT_EQ(spec.levels, 3);
+    EXPECT_EQ(spec.tileSize, 512);
+    EXPECT_EQ(spec.latencyUs, 800);
+    EXPECT_EQ(spec.seed, 7u);
+}
+
+TEST(SyntheticSlideSpecTest, Parse_DefaultsWhenOmitted) {
+    SyntheticSlideSpec spec;
+    std::string error;
+    ASSERT_TRUE(SyntheticSlideSpec::Parse("synthetic://", spec, error)) << error;
+    EXPECT_EQ(spec.width, 100000);
+    EXPECT_EQ(spec.height, 80000);
+    EXPECT_EQ(spec.levels, 0);
+    EXPECT_EQ(spec.tileSize, 256);
+    EXPECT_EQ(spec.latencyUs, 0);
+}
+
+TEST(SyntheticSlideSpecTest, Parse_RejectsMalformedPaths) {
+    const char* paths[] = {
+        "/data/slide.svs",
+        "synthetic://100000",
+        "synthetic://0x100",
+        "synthetic://100x100abc",
+        "synthetic://100x100?tile=8",
+        "synthetic://100x100?levels=99",
+        "synthetic://100x100?latency_us=-1",
+        "synthetic://100x100?colour=red",
+        "synthetic://100x100?tile=",
+    };
+    for (const char* path : paths) {
+        SyntheticSlideSpec spec;
+        std::string error;
+        EXPECT_FALSE(SyntheticSlideSpec::Parse(path, spec, error)) << path;
+        EXPECT_FALSE(error.empty()) << path;
+    }
+}
+
+// ============================================================================
+// Slide
+// ============================================================================
+
+TEST(SyntheticSlideTest, Levels_HalveUntilOneTile) {
+    SyntheticSlideSpec spec;
+    spec.width = 1000;
+    spec.height = 600;
+    spec.tileSize = 256;
+    SyntheticSlide slide(spec);
+
+    std::vector<LevelDimensions> levels = slide.GetLevels();
+    ASSERT_EQ(levels.size(), 3u);  // 1000x600, 500x300, 250x150
+    EXPECT_EQ(levels[1].width, 500);
+    EXPECT_EQ(levels[1].height, 300);
+    EXPECT_EQ(levels[2].width, 250);
+    EXPECT_EQ(levels[2].height, 150);
+    EXPECT_DOUBLE_EQ(slide.GetLevelDownsample(2), 4.0);
+
+    spec.levels = 5;
+    EXPECT_EQ(SyntheticSlide(spec).GetLevels().size(), 5u);
+}
+
+TEST(SyntheticSlideTest, ReadRegion_IsDeterministicAndOpaque) {
+    SyntheticSlideSpec spec;
+    spec.width = 4096;
+    spec.height = 4096;
+    SyntheticSlide first(spec);
+    SyntheticSlide second(spec);
+
+    std::vector<uint32_t> a(128 * 128);
+    std::vector<uint32_t> b(128 * 128);
+    first.ReadRegion(0, 1900, 2000, 128, 128, a.data());
+    second.ReadRegion(0, 1900, 2000, 128, 128, b.data());
+    EXPECT_EQ(a, b);
+    for (uint32_t pixel : a) {
+        ASSERT_EQ(pixel >> 24, 0xFFu);
+    }
+
+    spec.seed = 2;
+    SyntheticSlide reseeded(spec);
+    reseeded.ReadRegion(0, 1900, 2000, 128, 128, b.data());
+    EXPECT_NE(a, b);
+}
+
+TEST(SyntheticSlideTest, ReadRegion_OutsideIsTransparentAndCountsTiles) {
+    SyntheticSlideSpec spec;
+    spec.width = 1000;
+    spec.height = 1000;
+    spec.tileSize = 256;
+    SyntheticSlide slide(spec);
+
+    // Straddles the right edge: 2 columns x 1 row of tiles inside
+    std::vector<uint32_t> pixels(100 * 100, 0x12345678u);
+    slide.ReadRegion(0, 950, 0, 100, 10, pixels.data());
+    EXPECT_EQ(pixels[0] >> 24, 0xFFu);
+    EXPECT_EQ(pixels[49] >> 24, 0xFFu);
+    EXPECT_EQ(pixels[50], 0u);
+    EXPECT_EQ(pixels[99], 0u);
+    EXPECT_EQ(slide.GetTileReadCount(), 1u);
+
+    slide.ReadRegion(0, 200, 200, 100, 100, pixels.data());
+    EXPECT_EQ(slide.GetTileReadCount(), 5u);  // 2 x 2 more
+
+    slide.ReadRegion(0, 2000, 0, 10, 10, pixels.data());
+    EXPECT_EQ(slide.GetTileReadCount(), 5u);
+}
+
+TEST(SyntheticSlideTest, TissueDensity_IsGlassAtTheEdge) {
+    SyntheticSlideSpec spec;
+    SyntheticSlide slide(spec);
+    EXPECT_EQ(slide.GetTissueDensity(0.0, 0.0), 0.0);
+    EXPECT_EQ(slide.GetTissueDensity(-5.0, 100.0), 0.0);
+
+    // Some tissue somewhere along the middle row
+    double total = 0.0;
+    for (int64_t x = 0; x < spec.width; x += 1000) {
+        total += slide.GetTissueDensity(static_cast<double>(x), spec.height / 2.0);
+    }
+    EXPECT_GT(total, 0.0);
+}
+
+// ============================================================================
+// Cells
+// ============================================================================
+
+TEST(SyntheticCellsTest, CountsAddUpExactly) {
+    SyntheticSlideSpec spec;
+    spec.width = 20000;
+    spec.height = 15000;
+    SyntheticSlide slide(spec);
+    SyntheticCells cells(slide, 12345);
+
+    EXPECT_EQ(cells.GetColumns(), 10);
+    EXPECT_EQ(cells.GetRows(), 8);
+    size_t total = 0;
+    for (int64_t row = 0; row < cells.GetRows(); ++row) {
+        for (int64_t column = 0; column < cells.GetColumns(); ++column) {
+            total += cells.GetCellCount(column, row);
+        }
+    }
+    EXPECT_EQ(total, 12345u);
+}
+
+TEST(SyntheticCellsTest, Generate_IsDeterministicAndInBounds) {
+    SyntheticSlideSpec spec;
+    spec.width = 5000;
+    spec.height = 3000;
+    SyntheticSlide slide(spec);
+    SyntheticCells cells(slide, 5000);
+
+    std::vector<SyntheticCells::Cell> first;
+    std::vector<float> firstXy;
+    std::vector<SyntheticCells::Cell> again;
+    std::vector<float> againXy;
+    for (int64_t row = 0; row < cells.GetRows(); ++row) {
+        for (int64_t column = 0; column < cells.GetColumns(); ++column) {
+            cells.Generate(column, row, first, firstXy);
+            ASSERT_EQ(first.size(), cells.GetCellCount(column, row));
+            const double left = static_cast<double>(column * SyntheticCells::TILE_SIZE);
+            const double top = static_cast<double>(row * SyntheticCells::TILE_SIZE);
+            for (const SyntheticCells::Cell& cell : first) {
+                EXPECT_GE(cell.vertexCount, 8u);
+                EXPECT_LE(cell.vertexCount, 14u);
+                EXPECT_GE(cell.classId, 0);
+                EXPECT_LT(cell.classId, SyntheticCells::CLASS_COUNT);
+                EXPECT_GE(cell.confidence, 0.5f);
+                EXPECT_LE(cell.confidence, 1.0f);
+                for (uint32_t v = 0; v < cell.vertexCount; ++v) {
+                    const double x = left + firstXy[(cell.firstVertex + v) * 2];
+                    const double y = top + firstXy[(cell.firstVertex + v) * 2 + 1];
+                    ASSERT_GE(x, 0.0);
+                    ASSERT_LE(x, static_cast<double>(spec.width));
+                    ASSERT_GE(y, 0.0);
+                    ASSERT_LE(y, static_cast<double>(spec.height));
+                }
+            }
+
+            cells.Generate(column, row, again, againXy);
+            EXPECT_EQ(firstXy, againXy);
+        }
+    }
+}
+
+TEST(SyntheticCellsTest, GetClassName_NamesEveryClass) {
+    for (int32_t id = 0; id < SyntheticCells::CLASS_COUNT; ++id) {
+        EXPECT_STRNE(SyntheticCells::GetClassName(id), "Unknown");
+    }
+    EXPECT_STREQ(SyntheticCells::GetClassName(SyntheticCells::CLASS_COUNT), "Unknown");
+}
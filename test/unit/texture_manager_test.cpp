@@ -0,0 +1,470 @@
+// TextureManager Unit Tests
+// Tests for the VRAM and upload budgets, atlas packing, LRU eviction and hit/miss
+// accounting. Uses SDL's software renderer, so no window or GPU is required
+
+#include <gtest/gtest.h>
+#include "TextureManager.h"
+#include "SdlRenderBackend.h"
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TextureManagerTest : public ::testing::Test {
+protected:
+    static constexpr int32_t TILE_DIM = 16;
+    static constexpr size_t TILE_BYTES = TILE_DIM * TILE_DIM * sizeof(uint32_t);
+
+    SDL_Surface* surface = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    std::unique_ptr<TextureManager> manager;
+    std::vector<uint32_t> pixels;
+
+    void SetUp() override {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA32);
+        ASSERT_NE(surface, nullptr);
+        renderer = SDL_CreateSoftwareRenderer(surface);
+        ASSERT_NE(renderer, nullptr);
+
+        // Budget for exactly four tiles
+        manager = std::make_unique<TextureManager>(renderer, 4 * TILE_BYTES);
+        pixels.assign(TILE_DIM * TILE_DIM, 0xFFFF0000);  // Opaque red, ARGB
+    }
+
+    void TearDown() override {
+        manager.reset();
+        if (renderer) SDL_DestroyRenderer(renderer);
+        if (surface) SDL_FreeSurface(surface);
+    }
+
+    RenderTexture* Upload(int32_t x, int32_t y = 0) {
+        return manager->GetOrCreateTexture({0, x, y}, pixels.data(), TILE_DIM, TILE_DIM);
+    }
+};
+
+// ============================================================================
+// Basic Functionality Tests
+// ============================================================================
+
+TEST_F(TextureManagerTest, Constructor_DefaultState_EmptyCache) {
+    EXPECT_EQ(manager->GetCacheSize(), 0);
+    EXPECT_EQ(manager->GetMemoryUsage(), 0);
+    EXPECT_EQ(manager->GetMaxMemory(), 4 * TILE_BYTES);
+    EXPECT_EQ(manager->GetEvictionCount(), 0);
+}
+
+TEST_F(TextureManagerTest, GetOrCreateTexture_SameKey_ReturnsCachedTexture) {
+    RenderTexture* first = Upload(0);
+    RenderTexture* second = Upload(0);
+
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(manager->GetCacheSize(), 1);
+    EXPECT_EQ(manager->GetMemoryUsage(), TILE_BYTES);
+    EXPECT_EQ(manager->GetMissCount(), 1);
+    EXPECT_EQ(manager->GetHitCount(), 1);
+}
+
+TEST_F(TextureManagerTest, GetTexture_Miss_ReturnsNullWithoutUpload) {
+    EXPECT_EQ(manager->GetTexture({0, 0, 0}), nullptr);
+    EXPECT_EQ(manager->GetCacheSize(), 0);
+}
+
+TEST_F(TextureManagerTest, GetTexture_Hit_ReportsDimensions) {
+    Upload(0);
+
+    int32_t w = 0, h = 0;
+    EXPECT_NE(manager->GetTexture({0, 0, 0}, &w, &h), nullptr);
+    EXPECT_EQ(w, TILE_DIM);
+    EXPECT_EQ(h, TILE_DIM);
+}
+
+// ============================================================================
+// Eviction Tests
+// ============================================================================
+
+TEST_F(TextureManagerTest, Eviction_OverBudget_RemovesLeastRecentlyUsed) {
+    for (int32_t x = 0; x < 4; ++x) {
+        Upload(x);
+        manager->BeginFrame();
+    }
+
+    // Touch tile 0 so tile 1 becomes the LRU victim
+    manager->GetTexture({0, 0, 0});
+    manager->BeginFrame();
+    Upload(4);
+
+    EXPECT_EQ(manager->GetCacheSize(), 4);
+    EXPECT_LE(manager->GetMemoryUsage(), manager->GetMaxMemory());
+    EXPECT_EQ(manager->GetEvictionCount(), 1);
+    EXPECT_TRUE(manager->HasTexture({0, 0, 0}));
+    EXPECT_FALSE(manager->HasTexture({0, 1, 0}));
+}
+
+TEST_F(TextureManagerTest, Eviction_CurrentFrameTextures_ArePinned) {
+    // All six uploads are drawn in the same frame: none may be destroyed
+    for (int32_t x = 0; x < 6; ++x) {
+        ASSERT_NE(Upload(x), nullptr);
+    }
+
+    EXPECT_EQ(manager->GetCacheSize(), 6);
+    EXPECT_EQ(manager->GetEvictionCount(), 0);
+
+    // Next frame trims the overshoot back to budget
+    manager->BeginFrame();
+    EXPECT_EQ(manager->GetCacheSize(), 4);
+    EXPECT_LE(manager->GetMemoryUsage(), manager->GetMaxMemory());
+    EXPECT_EQ(manager->GetEvictionCount(), 2);
+}
+
+TEST_F(TextureManagerTest, SetMaxMemory_Shrink_EvictsImmediately) {
+    for (int32_t x = 0; x < 4; ++x) {
+        Upload(x);
+    }
+    manager->BeginFrame();
+
+    manager->SetMaxMemory(2 * TILE_BYTES);
+
+    EXPECT_EQ(manager->GetCacheSize(), 2);
+    EXPECT_EQ(manager->GetMemoryUsage(), 2 * TILE_BYTES);
+}
+
+TEST_F(TextureManagerTest, Trim_FreesRequestedBytesSparingCurrentFrame) {
+    for (int32_t x = 0; x < 3; ++x) {
+        Upload(x);
+    }
+    manager->BeginFrame();
+    Upload(3);  // Drawn this frame
+
+    EXPECT_EQ(manager->Trim(TILE_BYTES + 1), 2 * TILE_BYTES);
+    EXPECT_FALSE(manager->HasTexture({0, 0, 0}));
+    EXPECT_FALSE(manager->HasTexture({0, 1, 0}));
+
+    // Only the pinned texture is left after the remaining old one goes
+    EXPECT_EQ(manager->Trim(10 * TILE_BYTES), TILE_BYTES);
+    EXPECT_TRUE(manager->HasTexture({0, 3, 0}));
+}
+
+TEST_F(TextureManagerTest, ClearCache_ResetsMemoryUsage) {
+    Upload(0);
+    Upload(1);
+
+    manager->ClearCache();
+
+    EXPECT_EQ(manager->GetCacheSize(), 0);
+    EXPECT_EQ(manager->GetMemoryUsage(), 0);
+    EXPECT_FALSE(manager->HasTexture({0, 0, 0}));
+}
+
+TEST_F(TextureManagerTest, RemoveTexture_Cached_ReleasesBudget) {
+    Upload(0);
+    Upload(1);
+
+    manager->RemoveTexture({0, 0, 0});
+
+    EXPECT_EQ(manager->GetCacheSize(), 1);
+    EXPECT_EQ(manager->GetMemoryUsage(), TILE_BYTES);
+    EXPECT_FALSE(manager->HasTexture({0, 0, 0}));
+}
+
+TEST_F(TextureManagerTest, DestroyTexture_AtlasPage_RemovesTilesOnPage) {
+    RenderTexture* page = Upload(0);
+    Upload(1);
+
+    manager->DestroyTexture(page);
+
+    EXPECT_EQ(manager->GetCacheSize(), 0);
+    EXPECT_EQ(manager->GetMemoryUsage(), 0);
+    EXPECT_EQ(manager->GetAtlasPageCount(), 0);
+}
+
+// ============================================================================
+// Atlas Tests
+// ============================================================================
+
+TEST_F(TextureManagerTest, Atlas_SmallTiles_ShareOnePage) {
+    SDL_Rect first{}, second{};
+    RenderTexture* a = manager->GetOrCreateTexture({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM, &first);
+    RenderTexture* b = manager->GetOrCreateTexture({0, 1, 0}, pixels.data(), TILE_DIM, TILE_DIM, &second);
+
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(manager->GetAtlasPageCount(), 1);
+    EXPECT_EQ(first.w, TILE_DIM);
+    EXPECT_EQ(first.h, TILE_DIM);
+    EXPECT_FALSE(first.x == second.x && first.y == second.y);
+}
+
+TEST_F(TextureManagerTest, Atlas_GetTexture_ReportsSourceRect) {
+    SDL_Rect uploaded{};
+    manager->GetOrCreateTexture({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM, &uploaded);
+
+    SDL_Rect looked{};
+    ASSERT_NE(manager->GetTexture({0, 0, 0}, nullptr, nullptr, &looked), nullptr);
+
+    EXPECT_EQ(looked.x, uploaded.x);
+    EXPECT_EQ(looked.y, uploaded.y);
+    EXPECT_EQ(looked.w, uploaded.w);
+}
+
+TEST_F(TextureManagerTest, Atlas_OversizedTile_GetsOwnTexture) {
+    constexpr int32_t dim = TextureManager::ATLAS_SLOT_SIZE + 1;
+    std::vector<uint32_t> big(dim * dim, 0xFF00FF00);
+    manager->SetMaxMemory(big.size() * sizeof(uint32_t) + 4 * TILE_BYTES);
+
+    RenderTexture* page = Upload(0);
+    SDL_Rect source{};
+    RenderTexture* own = manager->GetOrCreateTexture({0, 9, 9}, big.data(), dim, dim, &source);
+
+    ASSERT_NE(own, nullptr);
+    EXPECT_NE(own, page);
+    EXPECT_EQ(source.x, 0);
+    EXPECT_EQ(source.y, 0);
+    EXPECT_EQ(source.w, dim);
+}
+
+TEST_F(TextureManagerTest, Atlas_LastTileEvicted_ReleasesPage) {
+    Upload(0);
+    ASSERT_EQ(manager->GetAtlasPageCount(), 1);
+
+    manager->RemoveTexture({0, 0, 0});
+
+    EXPECT_EQ(manager->GetAtlasPageCount(), 0);
+}
+
+// ============================================================================
+// Pixel Format Tests
+// ============================================================================
+
+TEST_F(TextureManagerTest, CreateTexture_UsesNativeTileFormat) {
+    RenderTexture* texture = Upload(0);
+    ASSERT_NE(texture, nullptr);
+
+    Uint32 format = 0;
+    ASSERT_EQ(SDL_QueryTexture(SdlRenderBackend::ToSdl(texture), &format, nullptr, nullptr, nullptr), 0);
+    EXPECT_EQ(format, static_cast<Uint32>(SDL_PIXELFORMAT_ARGB8888));
+}
+
+TEST_F(TextureManagerTest, CreateTexture_SetsBlendMode) {
+    RenderTexture* texture = Upload(0);
+    ASSERT_NE(texture, nullptr);
+
+    SDL_BlendMode mode = SDL_BLENDMODE_INVALID;
+    ASSERT_EQ(SDL_GetTextureBlendMode(SdlRenderBackend::ToSdl(texture), &mode), 0);
+    EXPECT_NE(mode, SDL_BLENDMODE_NONE);
+}
+
+// ============================================================================
+// Upload Budget Tests
+// ============================================================================
+
+TEST_F(TextureManagerTest, UploadBudget_FirstUploadOfFrame_AlwaysFits) {
+    manager->SetUploadBudget(TILE_BYTES / 2, 0.0);  // Smaller than one tile
+
+    EXPECT_TRUE(manager->HasUploadBudget(TILE_BYTES));
+}
+
+TEST_F(TextureManagerTest, UploadBudget_BytesExhausted_DefersFurtherUploads) {
+    manager->SetUploadBudget(2 * TILE_BYTES, 0.0);
+
+    Upload(0);
+    EXPECT_TRUE(manager->HasUploadBudget(TILE_BYTES));
+    Upload(1);
+    EXPECT_FALSE(manager->HasUploadBudget(TILE_BYTES));
+    EXPECT_EQ(manager->GetFrameUploadCount(), 2);
+    EXPECT_EQ(manager->GetFrameUploadBytes(), 2 * TILE_BYTES);
+}
+
+TEST_F(TextureManagerTest, UploadBudget_BeginFrame_ResetsUsage) {
+    manager->SetUploadBudget(TILE_BYTES, 0.0);
+    Upload(0);
+    ASSERT_FALSE(manager->HasUploadBudget(TILE_BYTES));
+
+    manager->BeginFrame();
+
+    EXPECT_TRUE(manager->HasUploadBudget(TILE_BYTES));
+    EXPECT_EQ(manager->GetFrameUploadBytes(), 0);
+}
+
+TEST_F(TextureManagerTest, UploadBudget_CacheHit_IsNotCharged) {
+    manager->SetUploadBudget(TILE_BYTES, 0.0);
+    Upload(0);
+    manager->BeginFrame();
+
+    Upload(0);
+
+    EXPECT_EQ(manager->GetFrameUploadCount(), 0);
+}
+
+TEST_F(TextureManagerTest, UploadBudget_Disabled_NeverDefers) {
+    manager->SetUploadBudget(0, 0.0);
+
+    for (int32_t x = 0; x < 4; ++x) {
+        Upload(x);
+    }
+
+    EXPECT_TRUE(manager->HasUploadBudget(TILE_BYTES));
+}
+
+// ============================================================================
+// Asynchronous Upload Tests
+// ============================================================================
+
+// Uploads synchronously but reports them only when told to, like a backend
+// whose upload thread has not got to them yet
+class QueuedUploadBackend : public SdlRenderBackend {
+public:
+    using SdlRenderBackend::SdlRenderBackend;
+
+    bool HasAsyncUploads() const override { return true; }
+
+    bool QueueUpload(RenderTexture* texture, const SDL_Rect& rect, std::shared_ptr<const void> owner,
+                     const uint32_t* pixels, int pitch, uint64_t ticket) override {
+        owners.push_back(std::move(owner));
+        queued.push_back(ticket);
+        return UpdateTexture(texture, &rect, pixels, pitch);
+    }
+
+    void PollUploads(std::vector<uint64_t>* completed) override {
+        if (finished) {
+            completed->insert(completed->end(), queued.begin(), queued.end());
+            queued.clear();
+            owners.clear();
+        }
+    }
+
+    std::vector<uint64_t> queued;
+    std::vector<std::shared_ptr<const void>> owners;
+    bool finished = false;
+};
+
+TEST_F(TextureManagerTest, QueueTexture_SdlBackend_IsNotQueued) {
+    EXPECT_FALSE(manager->HasAsyncUploads());
+    EXPECT_FALSE(manager->QueueTexture({0, 0, 0}, nullptr, pixels.data(), TILE_DIM, TILE_DIM));
+    EXPECT_FALSE(manager->HasTexture({0, 0, 0}));
+}
+
+TEST_F(TextureManagerTest, QueueTexture_PendingUntilBackendReportsIt) {
+    QueuedUploadBackend backend(renderer);
+    TextureManager async(&backend, 4 * TILE_BYTES);
+    auto owner = std::make_shared<std::vector<uint32_t>>(pixels);
+
+    ASSERT_TRUE(async.QueueTexture({0, 0, 0}, owner, owner->data(), TILE_DIM, TILE_DIM));
+    EXPECT_TRUE(async.IsUploadPending({0, 0, 0}));
+    EXPECT_EQ(async.GetTexture({0, 0, 0}), nullptr);
+    EXPECT_EQ(async.GetOrCreateTexture({0, 0, 0}, pixels.data(), TILE_DIM, TILE_DIM), nullptr);
+    EXPECT_EQ(async.GetFrameUploadBytes(), TILE_BYTES);
+    EXPECT_EQ(owner.use_count(), 2);  // Held until copied
+
+    async.BeginFrame();
+    EXPECT_TRUE(async.IsUploadPending({0, 0, 0}));
+
+    backend.finished = true;
+    async.BeginFrame();
+    EXPECT_FALSE(async.IsUploadPending({0, 0, 0}));
+    EXPECT_NE(async.GetTexture({0, 0, 0}), nullptr);
+    EXPECT_EQ(owner.use_count(), 1);
+}
+
+TEST_F(TextureManagerTest, QueueTexture_RemovedWhilePending_IgnoresLateReport) {
+    QueuedUploadBackend backend(renderer);
+    TextureManager async(&backend, 4 * TILE_BYTES);
+    ASSERT_TRUE(async.QueueTexture({0, 0, 0}, nullptr, pixels.data(), TILE_DIM, TILE_DIM));
+
+    async.RemoveTexture({0, 0, 0});
+    ASSERT_TRUE(async.QueueTexture({0, 0, 0}, nullptr, pixels.data(), TILE_DIM, TILE_DIM));
+    backend.queued.erase(backend.queued.begin() + 1);  // Only the removed tile's upload lands
+    backend.finished = true;
+    async.BeginFrame();
+
+    EXPECT_TRUE(async.IsUploadPending({0, 0, 0}));
+    EXPECT_EQ(async.GetMemoryUsage(), TILE_BYTES);
+}
+
+// ============================================================================
+// Compression Tests
+// ============================================================================
+
+// Claims BC7 support, keeping the pages as plain SDL textures
+class CompressingBackend : public SdlRenderBackend {
+public:
+    using SdlRenderBackend::SdlRenderBackend;
+
+    bool SupportsCompression(TextureCompression compression) const override {
+        return compression != TextureCompression::Bc1;
+    }
+
+    RenderTexture* CreateCompressedTexture(int32_t width, int32_t height, SDL_ScaleMode scaleMode,
+                                           TextureCompression compression) override {
+        lastCompression = compression;
+        return CreateTexture(width, height, scaleMode);
+    }
+
+    TextureCompression lastCompression = TextureCompression::None;
+};
+
+TEST_F(TextureManagerTest, SetCompression_Unsupported_StaysUncompressed) {
+    Upload(0);
+    EXPECT_FALSE(manager->SetCompression(TextureCompression::Bc7));
+    EXPECT_EQ(manager->GetCompression(), TextureCompression::None);
+    EXPECT_TRUE(manager->HasTexture({0, 0, 0}));
+}
+
+TEST_F(TextureManagerTest, SetCompression_Bc7_FourTimesTheTilesInBudget) {
+    CompressingBackend backend(renderer);
+    TextureManager compressed(&backend, 4 * TILE_BYTES);
+    ASSERT_TRUE(compressed.SetCompression(TextureCompression::Bc7));
+    EXPECT_FALSE(compressed.SetCompression(TextureCompression::Bc1));
+    EXPECT_EQ(compressed.GetCompression(), TextureCompression::Bc7);
+
+    for (int32_t x = 0; x < 16; ++x) {
+        ASSERT_NE(compressed.GetOrCreateTexture({0, x, 0}, pixels.data(), TILE_DIM, TILE_DIM), nullptr);
+        compressed.BeginFrame();
+    }
+    EXPECT_EQ(backend.lastCompression, TextureCompression::Bc7);
+    EXPECT_EQ(compressed.GetCacheSize(), 16);
+    EXPECT_EQ(compressed.GetMemoryUsage(), 4 * TILE_BYTES);
+    EXPECT_EQ(compressed.GetEvictionCount(), 0);
+
+    // Switching back drops the compressed tiles
+    ASSERT_TRUE(compressed.SetCompression(TextureCompression::None));
+    EXPECT_EQ(compressed.GetCacheSize(), 0);
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+// Per-tile cost of getting a decoded 512x512 tile into a texture, with and
+// without the ARGB->RGBA swizzle pass SlideLoader used to run per tile.
+TEST_F(TextureManagerTest, Benchmark_FullTileUpload_ReportsPerTileCost) {
+    constexpr int32_t dim = 512;
+    constexpr int iterations = 32;
+    std::vector<uint32_t> tile(dim * dim, 0xFF8040C0);
+
+    auto timeUploads = [&](bool swizzle) -> double {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            if (swizzle) {
+                for (uint32_t& p : tile) {
+                    p = ((p >> 16) & 0xFF) | (p & 0xFF00FF00) | ((p & 0xFF) << 16);
+                }
+            }
+            RenderTexture* texture = manager->CreateTexture(tile.data(), dim, dim);
+            EXPECT_NE(texture, nullptr);
+            manager->GetBackend()->DestroyTexture(texture);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    };
+
+    double swizzledUs = timeUploads(true);
+    double directUs = timeUploads(false);
+
+    std::cout << "  512x512 tile upload: " << directUs << " us direct, "
+              << swizzledUs << " us with swizzle pass" << std::endl;
+    RecordProperty("direct_us_per_tile", std::to_string(directUs));
+    RecordProperty("swizzled_us_per_tile", std::to_string(swizzledUs));
+}
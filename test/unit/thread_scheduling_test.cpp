@@ -0,0 +1,61 @@
+// ThreadScheduling Unit Tests
+// Tests for the cores left to workers once render cores are reserved, and
+// lowering a thread's priority without touching its caller
+
+#include <gtest/gtest.h>
+#include "ThreadScheduling.h"
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// Worker Cores
+// ============================================================================
+
+TEST(ThreadSchedulingTest, WorkerCores_SkipsTheFirstReservedCores) {
+    std::vector<size_t> cores = ThreadScheduling::WorkerCores({0, 1, 2, 3}, 1);
+    EXPECT_EQ(cores, (std::vector<size_t>{1, 2, 3}));
+}
+
+TEST(ThreadSchedulingTest, WorkerCores_FollowsTheProcessMask) {
+    // A process already restricted to cores 4-7 reserves core 4
+    std::vector<size_t> cores = ThreadScheduling::WorkerCores({4, 5, 6, 7}, 1);
+    EXPECT_EQ(cores, (std::vector<size_t>{5, 6, 7}));
+}
+
+TEST(ThreadSchedulingTest, WorkerCores_NoneLeft_IsEmpty) {
+    EXPECT_TRUE(ThreadScheduling::WorkerCores({0}, 1).empty());
+    EXPECT_TRUE(ThreadScheduling::WorkerCores({0, 1}, 4).empty());
+}
+
+TEST(ThreadSchedulingTest, ReserveCores_Zero_IsANoOp) {
+    EXPECT_TRUE(ThreadScheduling::ReserveCoresFromCurrentThread(0));
+}
+
+// ============================================================================
+// Priority
+// ============================================================================
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+TEST(ThreadSchedulingTest, LowerPriority_OnlyAffectsTheCallingThread) {
+    auto niceOf = [](pid_t thread) {
+        return getpriority(PRIO_PROCESS, static_cast<id_t>(thread));
+    };
+    const pid_t self = static_cast<pid_t>(syscall(SYS_gettid));
+    const int before = niceOf(self);
+
+    int workerNice = 0;
+    std::thread worker([&]() {
+        ASSERT_TRUE(ThreadScheduling::LowerCurrentThreadPriority());
+        workerNice = niceOf(static_cast<pid_t>(syscall(SYS_gettid)));
+    });
+    worker.join();
+
+    EXPECT_GE(workerNice, ThreadScheduling::BACKGROUND_NICE);
+    EXPECT_EQ(niceOf(self), before);
+}
+#endif
@@ -0,0 +1,866 @@
+// TiffTileReader Unit Tests
+// Tests for TIFF / BigTIFF directory parsing, level binding, direct JPEG
+// tile decoding, batch decoder hand-off, memory mapping, prewarm hints,
+// reads through a RemoteFile and multichannel (fluorescence) channels.
+// Each test writes its own small tiled TIFF to a temp file.
+
+#include <gtest/gtest.h>
+#include "TiffTileReader.h"
+#include "JpegBatchDecoder.h"
+#include "RemoteFile.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <zlib.h>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// One pyramid directory: tiles are stored row-major
+struct TestDirectory {
+    int64_t width = 0;
+    int64_t height = 0;
+    int64_t tileWidth = 16;
+    int64_t tileHeight = 16;
+    uint16_t compression = 7;  // JPEG
+    uint16_t photometric = 6;  // YCbCr
+    uint16_t samplesPerPixel = 3;
+    uint16_t bitsPerSample = 8;
+    uint16_t predictor = 1;
+    std::string description;
+    std::vector<std::vector<uint8_t>> tiles;
+    std::vector<uint8_t> jpegTables;
+};
+
+// Minimal little-endian TIFF / BigTIFF writer
+class TiffWriter {
+public:
+    explicit TiffWriter(bool bigTiff) : bigTiff_(bigTiff) {
+        if (bigTiff_) {
+            Put(0x4949, 2);
+            Put(43, 2);
+            Put(8, 2);
+            Put(0, 2);
+        } else {
+            Put(0x4949, 2);
+            Put(42, 2);
+        }
+        nextOffsetPos_ = data_.size();
+        Put(0, OffsetSize());
+    }
+
+    void AddDirectory(const TestDirectory& dir) {
+        std::vector<uint64_t> offsets;
+        std::vector<uint64_t> counts;
+        for (const auto& tile : dir.tiles) {
+            offsets.push_back(data_.size());
+            counts.push_back(tile.size());
+            data_.insert(data_.end(), tile.begin(), tile.end());
+        }
+
+        uint16_t offsetType = bigTiff_ ? 16 : 4;  // LONG8 or LONG
+        std::vector<Entry> entries;
+        entries.push_back(Scalar(256, 4, static_cast<uint64_t>(dir.width)));
+        entries.push_back(Scalar(257, 4, static_cast<uint64_t>(dir.height)));
+        entries.push_back(Array(258, 3, std::vector<uint64_t>(dir.samplesPerPixel, dir.bitsPerSample)));
+        entries.push_back(Scalar(259, 3, dir.compression));
+        entries.push_back(Scalar(262, 3, dir.photometric));
+        if (!dir.description.empty()) {
+            std::vector<uint8_t> text(dir.description.begin(), dir.description.end());
+            text.push_back(0);
+            entries.push_back(Entry{270, 2, text.size(), text});
+        }
+        entries.push_back(Scalar(277, 3, dir.samplesPerPixel));
+        entries.push_back(Scalar(284, 3, 1));
+        if (dir.predictor != 1) {
+            entries.push_back(Scalar(317, 3, dir.predictor));
+        }
+        entries.push_back(Scalar(322, 3, static_cast<uint64_t>(dir.tileWidth)));
+        entries.push_back(Scalar(323, 3, static_cast<uint64_t>(dir.tileHeight)));
+        entries.push_back(Array(324, offsetType, offsets));
+        entries.push_back(Array(325, 4, counts));
+        if (!dir.jpegTables.empty()) {
+            entries.push_back(Entry{347, 7, dir.jpegTables.size(), dir.jpegTables});
+        }
+
+        // Out-of-line values first, then the directory itself
+        std::vector<uint64_t> valueOffsets;
+        for (const Entry& entry : entries) {
+            if (entry.bytes.size() > OffsetSize()) {
+                Align();
+                valueOffsets.push_back(data_.size());
+                data_.insert(data_.end(), entry.bytes.begin(), entry.bytes.end());
+            } else {
+                valueOffsets.push_back(0);
+            }
+        }
+
+        Align();
+        Patch(nextOffsetPos_, data_.size(), OffsetSize());
+        Put(entries.size(), bigTiff_ ? 8 : 2);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry& entry = entries[i];
+            Put(entry.tag, 2);
+            Put(entry.type, 2);
+            Put(entry.count, bigTiff_ ? 8 : 4);
+            if (entry.bytes.size() > OffsetSize()) {
+                Put(valueOffsets[i], OffsetSize());
+            } else {
+                std::vector<uint8_t> field(OffsetSize(), 0);
+                std::copy(entry.bytes.begin(), entry.bytes.end(), field.begin());
+                data_.insert(data_.end(), field.begin(), field.end());
+            }
+        }
+        nextOffsetPos_ = data_.size();
+        Put(0, OffsetSize());
+    }
+
+    void Save(const fs::path& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+    }
+
+private:
+    struct Entry {
+        uint16_t tag;
+        uint16_t type;
+        uint64_t count;
+        std::vector<uint8_t> bytes;
+    };
+
+    static size_t TypeBytes(uint16_t type) {
+        return type == 3 ? 2 : type == 16 ? 8 : 4;
+    }
+
+    static std::vector<uint8_t> Encode(uint64_t value, size_t size) {
+        std::vector<uint8_t> bytes(size);
+        for (size_t i = 0; i < size; ++i) {
+            bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        return bytes;
+    }
+
+    static Entry Scalar(uint16_t tag, uint16_t type, uint64_t value) {
+        return Entry{tag, type, 1, Encode(value, TypeBytes(type))};
+    }
+
+    static Entry Array(uint16_t tag, uint16_t type, const std::vector<uint64_t>& values) {
+        Entry entry{tag, type, values.size(), {}};
+        for (uint64_t value : values) {
+            std::vector<uint8_t> bytes = Encode(value, TypeBytes(type));
+            entry.bytes.insert(entry.bytes.end(), bytes.begin(), bytes.end());
+        }
+        return entry;
+    }
+
+    size_t OffsetSize() const { return bigTiff_ ? 8 : 4; }
+
+    void Put(uint64_t value, size_t size) {
+        std::vector<uint8_t> bytes = Encode(value, size);
+        data_.insert(data_.end(), bytes.begin(), bytes.end());
+    }
+
+    void Patch(size_t pos, uint64_t value, size_t size) {
+        std::vector<uint8_t> bytes = Encode(value, size);
+        std::copy(bytes.begin(), bytes.end(), data_.begin() + static_cast<std::ptrdiff_t>(pos));
+    }
+
+    void Align() {
+        if (data_.size() % 2) {
+            data_.push_back(0);
+        }
+    }
+
+    bool bigTiff_;
+    std::vector<uint8_t> data_;
+    size_t nextOffsetPos_ = 0;
+};
+
+// Serves a file's bytes from memory, counting requests
+class FileBytesTransport : public RangeTransport {
+public:
+    explicit FileBytesTransport(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        bytes_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    bool GetSize(uint64_t& size) override {
+        size = bytes_.size();
+        return !bytes_.empty();
+    }
+
+    bool Fetch(uint64_t offset, uint64_t size, uint8_t* out) override {
+        if (offset + size > bytes_.size()) {
+            return false;
+        }
+        std::memcpy(out, bytes_.data() + offset, static_cast<size_t>(size));
+        return true;
+    }
+
+private:
+    std::vector<char> bytes_;
+};
+
+// One grey channel directory: 16x16 tiles of samples[y * width + x],
+// uncompressed, or deflated with horizontal differencing
+TestDirectory ChannelDirectory(int64_t width, int64_t height, uint16_t bits,
+                               const std::vector<uint16_t>& samples, bool deflate,
+                               const std::string& description = "") {
+    TestDirectory dir;
+    dir.width = width;
+    dir.height = height;
+    dir.compression = deflate ? 8 : 1;
+    dir.photometric = 1;  // BlackIsZero
+    dir.samplesPerPixel = 1;
+    dir.bitsPerSample = bits;
+    dir.predictor = deflate ? 2 : 1;
+    dir.description = description;
+
+    const size_t sampleBytes = bits / 8;
+    for (int64_t ty = 0; ty < (height + dir.tileHeight - 1) / dir.tileHeight; ++ty) {
+        for (int64_t tx = 0; tx < (width + dir.tileWidth - 1) / dir.tileWidth; ++tx) {
+            std::vector<uint8_t> tile;
+            for (int64_t y = 0; y < dir.tileHeight; ++y) {
+                uint16_t previous = 0;
+                for (int64_t x = 0; x < dir.tileWidth; ++x) {
+                    int64_t sx = tx * dir.tileWidth + x;
+                    int64_t sy = ty * dir.tileHeight + y;
+                    uint16_t value = sx < width && sy < height ? samples[sy * width + sx] : 0;
+                    uint16_t stored = deflate ? static_cast<uint16_t>(value - previous) : value;
+                    previous = value;
+                    tile.push_back(static_cast<uint8_t>(stored));
+                    if (sampleBytes == 2) {
+                        tile.push_back(static_cast<uint8_t>(stored >> 8));
+                    }
+                }
+            }
+            if (deflate) {
+                uLongf size = compressBound(static_cast<uLong>(tile.size()));
+                std::vector<uint8_t> compressed(size);
+                compress(compressed.data(), &size, tile.data(), static_cast<uLong>(tile.size()));
+                compressed.resize(size);
+                tile = std::move(compressed);
+            }
+            dir.tiles.push_back(std::move(tile));
+        }
+    }
+    return dir;
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+// Encodes solid-colour tiles as abbreviated streams sharing one set of
+// tables, as Aperio does. rgb stores untransformed RGB without an Adobe
+// marker or RGB component ids, so only the Photometric tag says so.
+void EncodeSolidTiles(TestDirectory& dir, const std::vector<uint32_t>& colors, bool rgb) {
+    jpeg_compress_struct info;
+    jpeg_error_mgr error;
+    info.err = jpeg_std_error(&error);
+    jpeg_create_compress(&info);
+    info.image_width = static_cast<JDIMENSION>(dir.tileWidth);
+    info.image_height = static_cast<JDIMENSION>(dir.tileHeight);
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, 95, TRUE);
+    if (rgb) {
+        jpeg_set_colorspace(&info, JCS_RGB);
+        info.write_Adobe_marker = FALSE;
+        for (int i = 0; i < 3; ++i) {
+            info.comp_info[i].component_id = i + 1;  // Not 'R', 'G', 'B'
+        }
+        dir.photometric = 2;
+    }
+
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&info, &buffer, &size);
+    jpeg_write_tables(&info);
+    dir.jpegTables.assign(buffer, buffer + size);
+    std::free(buffer);
+
+    std::vector<uint8_t> line(static_cast<size_t>(dir.tileWidth) * 3);
+    for (uint32_t color : colors) {
+        for (int64_t x = 0; x < dir.tileWidth; ++x) {
+            line[x * 3] = static_cast<uint8_t>(color >> 16);
+            line[x * 3 + 1] = static_cast<uint8_t>(color >> 8);
+            line[x * 3 + 2] = static_cast<uint8_t>(color);
+        }
+        buffer = nullptr;
+        size = 0;
+        jpeg_mem_dest(&info, &buffer, &size);
+        jpeg_start_compress(&info, FALSE);
+        while (info.next_scanline < info.image_height) {
+            JSAMPROW row = line.data();
+            jpeg_write_scanlines(&info, &row, 1);
+        }
+        jpeg_finish_compress(&info);
+        dir.tiles.emplace_back(buffer, buffer + size);
+        std::free(buffer);
+    }
+    jpeg_destroy_compress(&info);
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TiffTileReaderTest : public ::testing::Test {
+protected:
+    fs::path root;
+    fs::path tiffPath;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_tiff_reader_") + info->name());
+        fs::remove_all(root);
+        fs::create_directories(root);
+        tiffPath = root / "slide.tiff";
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    // 40x24 level in 16x16 tiles (3 x 2, partial on the right and bottom)
+    // plus a 20x12 level in a single 32x16 tile
+    static std::vector<TestDirectory> TwoLevels() {
+        TestDirectory level0;
+        level0.width = 40;
+        level0.height = 24;
+        for (int i = 0; i < 6; ++i) {
+            level0.tiles.push_back(std::vector<uint8_t>(10 + i, static_cast<uint8_t>(i)));
+        }
+        TestDirectory level1;
+        level1.width = 20;
+        level1.height = 12;
+        level1.tileWidth = 32;
+        level1.tiles.push_back({0xAA, 0xBB, 0xCC});
+        return {level0, level1};
+    }
+
+    void Write(const std::vector<TestDirectory>& dirs, bool bigTiff = false) {
+        TiffWriter writer(bigTiff);
+        for (const auto& dir : dirs) {
+            writer.AddDirectory(dir);
+        }
+        writer.Save(tiffPath);
+    }
+};
+
+// ============================================================================
+// Directory Parsing Tests
+// ============================================================================
+
+TEST_F(TiffTileReaderTest, Open_NotTiff_IsNotOpen) {
+    std::ofstream(tiffPath, std::ios::binary) << "not a tiff file";
+    TiffTileReader reader(tiffPath.string());
+    EXPECT_FALSE(reader.IsOpen());
+    EXPECT_EQ(reader.BindLevels({{40, 24}}), 0u);
+    EXPECT_FALSE(reader.HasLevel(0));
+}
+
+TEST_F(TiffTileReaderTest, BindLevels_MatchesDirectoriesByDimensions) {
+    Write(TwoLevels());
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_TRUE(reader.IsOpen());
+
+    EXPECT_EQ(reader.BindLevels({{40, 24}, {20, 12}, {10, 6}}), 2u);
+    EXPECT_TRUE(reader.HasLevel(0));
+    EXPECT_TRUE(reader.HasLevel(1));
+    EXPECT_FALSE(reader.HasLevel(2));
+    EXPECT_EQ(reader.GetTileSize(0).width, 16);
+    EXPECT_EQ(reader.GetTileSize(0).height, 16);
+}
+
+TEST_F(TiffTileReaderTest, BindLevels_NonJpegDirectory_NotBound) {
+    auto dirs = TwoLevels();
+    dirs[1].compression = 1;  // Uncompressed
+    Write(dirs);
+    TiffTileReader reader(tiffPath.string());
+
+    EXPECT_EQ(reader.BindLevels({{40, 24}, {20, 12}}), 1u);
+    EXPECT_TRUE(reader.HasLevel(0));
+    EXPECT_FALSE(reader.HasLevel(1));
+}
+
+TEST_F(TiffTileReaderTest, ReadRawTile_ReturnsStoredBytes) {
+    Write(TwoLevels());
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}, {20, 12}});
+
+    std::vector<uint8_t> bytes;
+    ASSERT_TRUE(reader.ReadRawTile(0, 2, 1, bytes));  // Tile index 5
+    EXPECT_EQ(bytes, std::vector<uint8_t>(15, 5));
+    ASSERT_TRUE(reader.ReadRawTile(1, 0, 0, bytes));
+    EXPECT_EQ(bytes, (std::vector<uint8_t>{0xAA, 0xBB, 0xCC}));
+    EXPECT_FALSE(reader.ReadRawTile(0, 3, 0, bytes));
+}
+
+TEST_F(TiffTileReaderTest, ReadRawTile_BigTiff_ReturnsStoredBytes) {
+    Write(TwoLevels(), true);
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_TRUE(reader.IsOpen());
+    EXPECT_EQ(reader.BindLevels({{40, 24}, {20, 12}}), 2u);
+
+    std::vector<uint8_t> bytes;
+    ASSERT_TRUE(reader.ReadRawTile(0, 1, 0, bytes));
+    EXPECT_EQ(bytes, std::vector<uint8_t>(11, 1));
+}
+
+TEST_F(TiffTileReaderTest, GetPyramidLevels_SkipsNonJpegAndLargerDirectories) {
+    auto dirs = TwoLevels();
+    TestDirectory label = dirs[1];
+    label.compression = 1;  // Uncompressed, like an associated image
+    TestDirectory macro = dirs[0];  // Not smaller than the level before it
+    Write({dirs[0], label, dirs[1], macro});
+    TiffTileReader reader(tiffPath.string());
+
+    std::vector<LevelDimensions> levels = reader.GetPyramidLevels();
+    ASSERT_EQ(levels.size(), 2u);
+    EXPECT_EQ(levels[0].width, 40);
+    EXPECT_EQ(levels[1].width, 20);
+    EXPECT_EQ(levels[1].height, 12);
+}
+
+// ============================================================================
+// Remote Read Tests
+// ============================================================================
+
+TEST_F(TiffTileReaderTest, Remote_ReadRawTile_ReturnsStoredBytes) {
+    Write(TwoLevels(), true);
+    auto remote = std::make_shared<RemoteFile>(std::make_unique<FileBytesTransport>(tiffPath));
+    TiffTileReader reader(remote);
+    ASSERT_TRUE(reader.IsOpen());
+    EXPECT_TRUE(reader.IsRemote());
+    EXPECT_FALSE(reader.IsMapped());
+    EXPECT_EQ(reader.BindLevels(reader.GetPyramidLevels()), 2u);
+
+    std::vector<uint8_t> bytes;
+    ASSERT_TRUE(reader.ReadRawTile(0, 2, 1, bytes));
+    EXPECT_EQ(bytes, std::vector<uint8_t>(15, 5));
+
+    // The whole test file fits in one block: parsing fetched it already
+    EXPECT_EQ(remote->GetRequestCount(), 1u);
+    EXPECT_GT(reader.Prewarm(0, 0, 0, 40, 24), 0u);
+}
+
+TEST_F(TiffTileReaderTest, Remote_NotTiff_IsNotOpen) {
+    std::ofstream(tiffPath, std::ios::binary) << "not a tiff file";
+    auto remote = std::make_shared<RemoteFile>(std::make_unique<FileBytesTransport>(tiffPath));
+    TiffTileReader reader(remote);
+    EXPECT_FALSE(reader.IsOpen());
+    EXPECT_TRUE(reader.GetPyramidLevels().empty());
+}
+
+// ============================================================================
+// Memory Mapping / Prewarm Tests
+// ============================================================================
+
+TEST_F(TiffTileReaderTest, BatchRead_OnlyForPositionalReads) {
+    Write(TwoLevels());
+    TiffTileReader positional(tiffPath.string());
+    TiffTileReader mapped(tiffPath.string(), true);
+    auto remote = std::make_shared<RemoteFile>(std::make_unique<FileBytesTransport>(tiffPath));
+    TiffTileReader remoteReader(remote);
+
+    ASSERT_NE(positional.GetBatchReadName(), nullptr);
+    EXPECT_EQ(mapped.GetBatchReadName(), nullptr);
+    EXPECT_EQ(remoteReader.GetBatchReadName(), nullptr);
+}
+
+TEST_F(TiffTileReaderTest, ReadRawTile_MemoryMapped_ReturnsStoredBytes) {
+    Write(TwoLevels());
+    TiffTileReader reader(tiffPath.string(), true);
+    ASSERT_TRUE(reader.IsOpen());
+    EXPECT_TRUE(reader.IsMapped());
+    EXPECT_EQ(reader.BindLevels({{40, 24}, {20, 12}}), 2u);
+
+    std::vector<uint8_t> bytes;
+    ASSERT_TRUE(reader.ReadRawTile(0, 2, 1, bytes));
+    EXPECT_EQ(bytes, std::vector<uint8_t>(15, 5));
+}
+
+TEST_F(TiffTileReaderTest, Prewarm_HintsOverlappingTileBytes) {
+    Write(TwoLevels());
+    for (bool mapped : {false, true}) {
+        TiffTileReader reader(tiffPath.string(), mapped);
+        reader.BindLevels({{40, 24}, {20, 12}});
+        reader.Advise(TiffAccessPattern::Random);
+
+        // Tiles are 10..15 bytes, stored back to back
+        EXPECT_EQ(reader.Prewarm(0, 0, 0, 40, 24), 75u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Prewarm(0, 0, 0, 16, 16, true), 10u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Prewarm(0, 100, 100, 16, 16), 0u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Prewarm(2, 0, 0, 16, 16), 0u) << "mapped " << mapped;
+    }
+}
+
+TEST_F(TiffTileReaderTest, Fetch_ReadsOverlappingTileBytes) {
+    Write(TwoLevels());
+    for (bool mapped : {false, true}) {
+        TiffTileReader reader(tiffPath.string(), mapped);
+        reader.BindLevels({{40, 24}, {20, 12}});
+
+        EXPECT_EQ(reader.Fetch(0, 0, 0, 40, 24), 75u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Fetch(0, 0, 0, 16, 16), 10u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Fetch(0, 100, 100, 16, 16), 0u) << "mapped " << mapped;
+        EXPECT_EQ(reader.Fetch(2, 0, 0, 16, 16), 0u) << "mapped " << mapped;
+    }
+
+    auto remote = std::make_shared<RemoteFile>(std::make_unique<FileBytesTransport>(tiffPath));
+    TiffTileReader remoteReader(remote);
+    remoteReader.BindLevels({{40, 24}, {20, 12}});
+    EXPECT_EQ(remoteReader.Fetch(0, 0, 0, 40, 24), 75u);
+}
+
+// ============================================================================
+// Decode Tests
+// ============================================================================
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+namespace {
+
+const std::vector<uint32_t> TILE_COLORS = {
+    0xFFC03020, 0xFF20C030, 0xFF3020C0,
+    0xFF808080, 0xFFE0D0C0, 0xFF402060,
+};
+
+// Solid tiles survive JPEG within a few levels per channel
+void ExpectColorNear(uint32_t actual, uint32_t expected) {
+    EXPECT_EQ(actual >> 24, expected >> 24);
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int a = static_cast<int>((actual >> shift) & 0xFF);
+        int e = static_cast<int>((expected >> shift) & 0xFF);
+        EXPECT_NEAR(a, e, 4) << "pixel 0x" << std::hex << actual << " vs 0x" << expected;
+    }
+}
+
+// Stands in for a hardware backend: fills accepted tiles with one colour
+class FakeBatchDecoder : public JpegBatchDecoder {
+public:
+    explicit FakeBatchDecoder(bool accept) : accept_(accept) {}
+
+    const char* GetName() const override { return "fake"; }
+
+    void DecodeBatch(std::vector<JpegDecodeJob>& jobs) override {
+        batches++;
+        for (JpegDecodeJob& job : jobs) {
+            // Handed complete streams: SOI ... EOI
+            completeStreams += job.size >= 4 && job.data[0] == 0xFF && job.data[1] == 0xD8 &&
+                               job.data[job.size - 2] == 0xFF && job.data[job.size - 1] == 0xD9;
+            jobCount++;
+            if (!accept_) {
+                continue;
+            }
+            for (int64_t y = 0; y < job.rowCount; ++y) {
+                std::fill(job.pixels + y * job.stride, job.pixels + y * job.stride + job.width, FILL);
+            }
+            job.decoded = true;
+        }
+    }
+
+    static constexpr uint32_t FILL = 0xFFFF00FF;
+    size_t batches = 0;
+    size_t jobCount = 0;
+    size_t completeStreams = 0;
+
+private:
+    bool accept_;
+};
+
+}  // namespace
+
+TEST_F(TiffTileReaderTest, ReadRegion_DecodesTilesWithSharedTables) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_EQ(reader.BindLevels({{40, 24}}), 1u);
+
+    std::vector<uint32_t> pixels(40 * 24, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 40, 24, pixels.data()));
+    ExpectColorNear(pixels[0], TILE_COLORS[0]);
+    ExpectColorNear(pixels[5 * 40 + 20], TILE_COLORS[1]);
+    ExpectColorNear(pixels[15 * 40 + 39], TILE_COLORS[2]);
+    ExpectColorNear(pixels[16 * 40 + 0], TILE_COLORS[3]);
+    ExpectColorNear(pixels[23 * 40 + 39], TILE_COLORS[5]);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_MemoryMapped_DecodesFromMapping) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string(), true);
+    ASSERT_TRUE(reader.IsMapped());
+    reader.BindLevels({{40, 24}});
+
+    std::vector<uint32_t> pixels(40 * 24, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 40, 24, pixels.data()));
+    ExpectColorNear(pixels[0], TILE_COLORS[0]);
+    ExpectColorNear(pixels[23 * 40 + 39], TILE_COLORS[5]);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_Remote_DecodesFetchedTiles) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    auto remote = std::make_shared<RemoteFile>(std::make_unique<FileBytesTransport>(tiffPath));
+    TiffTileReader reader(remote);
+    ASSERT_EQ(reader.BindLevels({{40, 24}}), 1u);
+
+    std::vector<uint32_t> pixels(40 * 24, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 40, 24, pixels.data()));
+    ExpectColorNear(pixels[0], TILE_COLORS[0]);
+    ExpectColorNear(pixels[23 * 40 + 39], TILE_COLORS[5]);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_OutsideLevel_IsTransparent) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+
+    // Starts left of the level and runs past its bottom-right corner
+    const int64_t x = -4, y = 8, w = 48, h = 20;
+    std::vector<uint32_t> pixels(w * h, 0x12345678);
+    ASSERT_TRUE(reader.ReadRegion(0, x, y, w, h, pixels.data()));
+    EXPECT_EQ(pixels[0], 0u);                            // Left of the level
+    EXPECT_EQ(pixels[2 * w + 47], 0u);                   // Right of the level
+    EXPECT_EQ(pixels[19 * w + 10], 0u);                  // Below the level
+    ExpectColorNear(pixels[0 * w + 4], TILE_COLORS[0]);  // Level (0, 8)
+    ExpectColorNear(pixels[8 * w + 43], TILE_COLORS[5]); // Level (39, 16)
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_RgbPhotometric_DecodesWithoutColorTransform) {
+    auto dirs = TwoLevels();
+    dirs[1].tiles.clear();
+    EncodeSolidTiles(dirs[1], {0xFFC03020}, true);
+    Write({dirs[1]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{20, 12}});
+
+    std::vector<uint32_t> pixels(20 * 12, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 20, 12, pixels.data()));
+    ExpectColorNear(pixels[6 * 20 + 10], 0xFFC03020);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_BatchDecoder_DecodesInPlaceTiles) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+    auto decoder = std::make_shared<FakeBatchDecoder>(true);
+    reader.SetBatchDecoder(decoder);
+
+    // Two whole tiles in place, plus the right-hand edge tile via scratch
+    std::vector<uint32_t> pixels(40 * 16, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 40, 16, pixels.data()));
+    EXPECT_EQ(decoder->batches, 1u);
+    EXPECT_EQ(decoder->jobCount, 2u);
+    EXPECT_EQ(decoder->completeStreams, 2u);
+    EXPECT_EQ(reader.GetBatchDecodedCount(), 2u);
+    EXPECT_EQ(pixels[0], FakeBatchDecoder::FILL);
+    EXPECT_EQ(pixels[15 * 40 + 31], FakeBatchDecoder::FILL);
+    ExpectColorNear(pixels[15 * 40 + 39], TILE_COLORS[2]);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_BatchDecoderDeclines_DecodesSplicedStreamOnCpu) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+    auto decoder = std::make_shared<FakeBatchDecoder>(false);
+    reader.SetBatchDecoder(decoder);
+
+    std::vector<uint32_t> pixels(32 * 16, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 32, 16, pixels.data()));
+    EXPECT_EQ(decoder->jobCount, 2u);
+    EXPECT_EQ(reader.GetBatchDecodedCount(), 0u);
+    ExpectColorNear(pixels[0], TILE_COLORS[0]);
+    ExpectColorNear(pixels[8 * 32 + 20], TILE_COLORS[1]);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_RgbPhotometric_SkipsBatchDecoder) {
+    auto dirs = TwoLevels();
+    dirs[1].tiles.clear();
+    EncodeSolidTiles(dirs[1], {0xFFC03020}, true);
+    Write({dirs[1]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{20, 12}});
+    auto decoder = std::make_shared<FakeBatchDecoder>(true);
+    reader.SetBatchDecoder(decoder);
+
+    std::vector<uint32_t> pixels(32 * 16, 0);
+    ASSERT_TRUE(reader.ReadRegion(0, 0, 0, 32, 16, pixels.data()));
+    EXPECT_EQ(decoder->jobCount, 0u);
+    ExpectColorNear(pixels[6 * 32 + 10], 0xFFC03020);
+}
+
+TEST_F(TiffTileReaderTest, ReadRegion_CorruptTile_ReturnsFalse) {
+    Write(TwoLevels());  // Tile bytes are not JPEG
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+
+    std::vector<uint32_t> pixels(16 * 16, 0);
+    EXPECT_FALSE(reader.ReadRegion(0, 0, 0, 16, 16, pixels.data()));
+}
+
+TEST_F(TiffTileReaderTest, ReadRegionScaled_HalfResolution_DecodesReducedTiles) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+    EXPECT_TRUE(reader.CanScale(0, 2));
+    EXPECT_TRUE(reader.CanScale(0, 8));
+    EXPECT_FALSE(reader.CanScale(0, 3));
+
+    // 16x16 tiles decode to 8x8; the region runs one pixel past the level
+    const int64_t w = 21, h = 12;
+    std::vector<uint32_t> pixels(w * h, 0x12345678);
+    ASSERT_TRUE(reader.ReadRegionScaled(0, 0, 0, w, h, 2, pixels.data()));
+    ExpectColorNear(pixels[0], TILE_COLORS[0]);
+    ExpectColorNear(pixels[7 * w + 8], TILE_COLORS[1]);
+    ExpectColorNear(pixels[3 * w + 19], TILE_COLORS[2]);
+    ExpectColorNear(pixels[8 * w + 0], TILE_COLORS[3]);
+    ExpectColorNear(pixels[11 * w + 19], TILE_COLORS[5]);
+    EXPECT_EQ(pixels[5 * w + 20], 0u);  // Right of the level
+}
+
+TEST_F(TiffTileReaderTest, ReadRegionScaled_UnsupportedScale_ReturnsFalse) {
+    auto dirs = TwoLevels();
+    dirs[0].tiles.clear();
+    EncodeSolidTiles(dirs[0], TILE_COLORS, false);
+    Write({dirs[0]});
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+
+    std::vector<uint32_t> pixels(8 * 8, 0);
+    EXPECT_FALSE(reader.ReadRegionScaled(0, 0, 0, 8, 8, 3, pixels.data()));
+    EXPECT_FALSE(reader.ReadRegionScaled(0, 0, 0, 1, 1, 16, pixels.data()));
+}
+
+#else
+
+TEST_F(TiffTileReaderTest, ReadRegion_WithoutLibjpeg_ReturnsFalse) {
+    Write(TwoLevels());
+    TiffTileReader reader(tiffPath.string());
+    reader.BindLevels({{40, 24}});
+
+    EXPECT_FALSE(TiffTileReader::IsDecodeAvailable());
+    std::vector<uint32_t> pixels(16 * 16, 0);
+    EXPECT_FALSE(reader.ReadRegion(0, 0, 0, 16, 16, pixels.data()));
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+// ============================================================================
+// Multichannel Tests
+// ============================================================================
+
+TEST_F(TiffTileReaderTest, BindChannels_RunsOfChannelDirectories_FormLevels) {
+    std::vector<uint16_t> full(40 * 24, 7);
+    std::vector<uint16_t> half(20 * 12, 9);
+    Write({ChannelDirectory(40, 24, 8, full, false, "<Name>DAPI</Name>"),
+           ChannelDirectory(40, 24, 8, full, false, "<Name>CD8</Name>"),
+           ChannelDirectory(40, 24, 8, full, false),
+           ChannelDirectory(20, 12, 8, half, false),
+           ChannelDirectory(20, 12, 8, half, false),
+           ChannelDirectory(20, 12, 8, half, false)});
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_TRUE(reader.IsOpen());
+
+    ASSERT_EQ(reader.BindChannels(), 3u);
+    std::vector<LevelDimensions> levels = reader.GetChannelLevels();
+    ASSERT_EQ(levels.size(), 2u);
+    EXPECT_EQ(levels[1].width, 20);
+    EXPECT_EQ(reader.GetChannelTileSize(0).width, 16);
+    EXPECT_EQ(reader.GetChannelBits(0), 8u);
+    EXPECT_EQ(reader.GetChannelName(0), "DAPI");
+    EXPECT_EQ(reader.GetChannelName(1), "CD8");
+    EXPECT_EQ(reader.GetChannelName(2), "Channel 3");
+}
+
+TEST_F(TiffTileReaderTest, BindChannels_RgbJpegPyramid_FindsNone) {
+    Write(TwoLevels());
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_TRUE(reader.IsOpen());
+
+    EXPECT_EQ(reader.BindChannels(), 0u);
+    EXPECT_TRUE(reader.GetChannelLevels().empty());
+}
+
+TEST_F(TiffTileReaderTest, ReadChannelRegion_Uncompressed8Bit_ReadsAcrossTiles) {
+    std::vector<uint16_t> samples(40 * 24);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<uint16_t>(i % 251);
+    }
+    Write({ChannelDirectory(40, 24, 8, samples, false), ChannelDirectory(40, 24, 8, samples, false)});
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_EQ(reader.BindChannels(), 2u);
+
+    // 8x8 straddling the four tiles around (16, 16)
+    std::vector<uint16_t> region(64);
+    ASSERT_TRUE(reader.ReadChannelRegion(0, 1, 12, 12, 8, 8, region.data()));
+    for (int64_t y = 0; y < 8; ++y) {
+        for (int64_t x = 0; x < 8; ++x) {
+            EXPECT_EQ(region[y * 8 + x], samples[(12 + y) * 40 + 12 + x]) << x << "," << y;
+        }
+    }
+}
+
+TEST_F(TiffTileReaderTest, ReadChannelRegion_Deflate16BitPredictor_Decodes) {
+    std::vector<uint16_t> samples(40 * 24);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<uint16_t>(i * 977);
+    }
+    Write({ChannelDirectory(40, 24, 16, samples, true), ChannelDirectory(40, 24, 16, samples, true)});
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_EQ(reader.BindChannels(), 2u);
+    EXPECT_EQ(reader.GetChannelBits(0), 16u);
+
+    std::vector<uint16_t> region(40 * 24);
+    ASSERT_TRUE(reader.ReadChannelRegion(0, 0, 0, 0, 40, 24, region.data()));
+    EXPECT_EQ(region, samples);
+}
+
+TEST_F(TiffTileReaderTest, ReadChannelRegion_OutsideLevel_IsZero) {
+    std::vector<uint16_t> samples(40 * 24, 200);
+    Write({ChannelDirectory(40, 24, 8, samples, false), ChannelDirectory(40, 24, 8, samples, false)});
+    TiffTileReader reader(tiffPath.string());
+    ASSERT_EQ(reader.BindChannels(), 2u);
+
+    // Half past the right edge
+    std::vector<uint16_t> region(8 * 4, 0xFFFF);
+    ASSERT_TRUE(reader.ReadChannelRegion(0, 0, 36, 0, 8, 4, region.data()));
+    EXPECT_EQ(region[0], 200);
+    EXPECT_EQ(region[3], 200);
+    EXPECT_EQ(region[4], 0);
+    EXPECT_EQ(region[7], 0);
+}
@@ -0,0 +1,129 @@
+// TileBatch Unit Tests
+// Tests that queued quads are grouped into one draw call per texture
+// Uses SDL's software renderer, so no window or GPU is required
+
+#include <gtest/gtest.h>
+#include "TileBatch.h"
+#include "SdlRenderBackend.h"
+#include <memory>
+#include <vector>
+
+// Records what reaches the backend instead of drawing it
+class RecordingBackend : public SdlRenderBackend {
+public:
+    using SdlRenderBackend::SdlRenderBackend;
+
+    bool DrawGeometry(RenderTexture*, const SDL_Vertex* vertices, int vertexCount,
+                      const int*, int, SDL_BlendMode blendMode) override {
+        drawn.assign(vertices, vertices + vertexCount);
+        mode = blendMode;
+        return true;
+    }
+
+    std::vector<SDL_Vertex> drawn;
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+};
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TileBatchTest : public ::testing::Test {
+protected:
+    SDL_Surface* surface = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    std::unique_ptr<SdlRenderBackend> backend;
+    RenderTexture* pageA = nullptr;
+    RenderTexture* pageB = nullptr;
+    TileBatch batch;
+
+    void SetUp() override {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA32);
+        ASSERT_NE(surface, nullptr);
+        renderer = SDL_CreateSoftwareRenderer(surface);
+        ASSERT_NE(renderer, nullptr);
+
+        backend = std::make_unique<SdlRenderBackend>(renderer);
+        pageA = backend->CreateTexture(64, 64, SDL_ScaleModeNearest);
+        pageB = backend->CreateTexture(64, 64, SDL_ScaleModeNearest);
+        ASSERT_NE(pageA, nullptr);
+        ASSERT_NE(pageB, nullptr);
+    }
+
+    void TearDown() override {
+        if (pageA) backend->DestroyTexture(pageA);
+        if (pageB) backend->DestroyTexture(pageB);
+        if (renderer) SDL_DestroyRenderer(renderer);
+        if (surface) SDL_FreeSurface(surface);
+    }
+
+    void Add(RenderTexture* texture, float x) {
+        batch.AddQuad(texture, SDL_FRect{0, 0, 16, 16}, SDL_FRect{x, 0, 16, 16});
+    }
+};
+
+// ============================================================================
+// Batching Tests
+// ============================================================================
+
+TEST_F(TileBatchTest, Flush_Empty_IssuesNoDrawCalls) {
+    EXPECT_TRUE(batch.IsEmpty());
+    EXPECT_EQ(batch.Flush(*backend), 0u);
+}
+
+TEST_F(TileBatchTest, Flush_SameTexture_IssuesOneDrawCall) {
+    for (int i = 0; i < 4; ++i) {
+        Add(pageA, i * 16.0f);
+    }
+
+    EXPECT_EQ(batch.GetQuadCount(), 4u);
+    EXPECT_EQ(batch.Flush(*backend), 1u);
+}
+
+TEST_F(TileBatchTest, Flush_TwoTextures_IssuesOneDrawCallEach) {
+    Add(pageA, 0);
+    Add(pageB, 16);
+    Add(pageA, 32);
+
+    EXPECT_EQ(batch.Flush(*backend), 2u);
+}
+
+TEST_F(TileBatchTest, Flush_ClearsQueuedQuads) {
+    Add(pageA, 0);
+    batch.Flush(*backend);
+
+    EXPECT_TRUE(batch.IsEmpty());
+    EXPECT_EQ(batch.Flush(*backend), 0u);
+}
+
+TEST_F(TileBatchTest, AddQuad_NullTexture_IsIgnored) {
+    Add(nullptr, 0);
+
+    EXPECT_TRUE(batch.IsEmpty());
+}
+
+TEST_F(TileBatchTest, Flush_BlendModeOverride_RestoresTextureMode) {
+    SDL_Texture* texture = SdlRenderBackend::ToSdl(pageA);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    batch.SetBlendMode(SDL_BLENDMODE_ADD);
+    batch.AddQuad(pageA, SDL_FRect{0, 0, 16, 16}, SDL_FRect{0, 0, 16, 16}, SDL_Color{255, 0, 0, 255});
+
+    EXPECT_EQ(batch.Flush(*backend), 1u);
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    ASSERT_EQ(SDL_GetTextureBlendMode(texture, &mode), 0);
+    EXPECT_EQ(mode, SDL_BLENDMODE_BLEND);
+}
+
+TEST_F(TileBatchTest, Flush_NormalizesTexelCoordinates) {
+    RecordingBackend recorder(renderer);
+    batch.SetBlendMode(SDL_BLENDMODE_ADD);
+    batch.AddQuad(pageA, SDL_FRect{16, 8, 32, 16}, SDL_FRect{0, 0, 16, 16});
+
+    EXPECT_EQ(batch.Flush(recorder), 1u);
+    ASSERT_EQ(recorder.drawn.size(), 4u);
+    EXPECT_FLOAT_EQ(recorder.drawn[0].tex_coord.x, 0.25f);
+    EXPECT_FLOAT_EQ(recorder.drawn[0].tex_coord.y, 0.125f);
+    EXPECT_FLOAT_EQ(recorder.drawn[2].tex_coord.x, 0.75f);
+    EXPECT_FLOAT_EQ(recorder.drawn[2].tex_coord.y, 0.375f);
+    EXPECT_EQ(recorder.mode, SDL_BLENDMODE_ADD);
+}
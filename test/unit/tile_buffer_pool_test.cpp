@@ -0,0 +1,263 @@
+// TileBufferPool Unit Tests
+// Tests for size classes, alignment, buffer reuse and statistics, and
+// huge-page slabs: carving, reuse and giving idle slabs back
+// Also covers TileData returning pooled buffers when the cache frees them
+
+#include <gtest/gtest.h>
+#include "TileBufferPool.h"
+#include "TileCache.h"
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TileBufferPoolTest : public ::testing::Test {
+protected:
+    static constexpr size_t TILE_PIXELS = 512 * 512;
+
+    TileBufferPool pool;
+};
+
+// ============================================================================
+// Allocation Tests
+// ============================================================================
+
+TEST_F(TileBufferPoolTest, Acquire_ReturnsAlignedBuffer) {
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(TILE_PIXELS, &capacity);
+
+    ASSERT_NE(pixels, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(pixels) % TileBufferPool::ALIGNMENT, 0u);
+
+    pool.Release(pixels, capacity);
+}
+
+TEST_F(TileBufferPoolTest, Acquire_RoundsUpToSizeClass) {
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(300 * 200, &capacity);
+
+    EXPECT_GE(capacity, 300u * 200u);
+    EXPECT_EQ(capacity & (capacity - 1), 0u);  // Power of two
+
+    pool.Release(pixels, capacity);
+}
+
+TEST_F(TileBufferPoolTest, Acquire_OversizedRequest_UsesExactSize) {
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(TILE_PIXELS * 2, &capacity);
+
+    EXPECT_EQ(capacity, TILE_PIXELS * 2);
+
+    pool.Release(pixels, capacity);
+    EXPECT_EQ(pool.GetStats().idleBytes, 0u);
+}
+
+// ============================================================================
+// Reuse Tests
+// ============================================================================
+
+TEST_F(TileBufferPoolTest, Release_ThenAcquire_ReusesBuffer) {
+    size_t capacity = 0;
+    uint32_t* first = pool.Acquire(TILE_PIXELS, &capacity);
+    pool.Release(first, capacity);
+
+    uint32_t* second = pool.Acquire(TILE_PIXELS, &capacity);
+
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(pool.GetStats().reuseCount, 1u);
+
+    pool.Release(second, capacity);
+}
+
+TEST_F(TileBufferPoolTest, Release_BeyondIdleLimit_FreesBuffer) {
+    TileBufferPool smallPool(TILE_PIXELS * sizeof(uint32_t));  // Room for one idle tile
+
+    size_t capA = 0, capB = 0;
+    uint32_t* a = smallPool.Acquire(TILE_PIXELS, &capA);
+    uint32_t* b = smallPool.Acquire(TILE_PIXELS, &capB);
+    smallPool.Release(a, capA);
+    smallPool.Release(b, capB);
+
+    EXPECT_EQ(smallPool.GetStats().idleBytes, TILE_PIXELS * sizeof(uint32_t));
+}
+
+TEST_F(TileBufferPoolTest, Trim_FreesIdleBuffers) {
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(TILE_PIXELS, &capacity);
+    pool.Release(pixels, capacity);
+    ASSERT_GT(pool.GetStats().idleBytes, 0u);
+
+    pool.Trim();
+
+    EXPECT_EQ(pool.GetStats().idleBytes, 0u);
+}
+
+// ============================================================================
+// Statistics Tests
+// ============================================================================
+
+TEST_F(TileBufferPoolTest, Stats_TrackLiveAndIdleBytes) {
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(TILE_PIXELS, &capacity);
+
+    TileBufferPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.liveBytes, TILE_PIXELS * sizeof(uint32_t));
+    EXPECT_EQ(stats.idleBytes, 0u);
+    EXPECT_EQ(stats.acquireCount, 1u);
+
+    pool.Release(pixels, capacity);
+
+    stats = pool.GetStats();
+    EXPECT_EQ(stats.liveBytes, 0u);
+    EXPECT_EQ(stats.idleBytes, TILE_PIXELS * sizeof(uint32_t));
+}
+
+// ============================================================================
+// Huge Page Slab Tests
+// ============================================================================
+
+TEST_F(TileBufferPoolTest, HugePages_CarvesClassBuffersFromOneSlab) {
+    pool.SetHugePages(HugePageMode::Transparent);
+    size_t capA = 0, capB = 0;
+    uint32_t* a = pool.Acquire(TILE_PIXELS, &capA);
+    uint32_t* b = pool.Acquire(TILE_PIXELS, &capB);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    a[0] = 1;
+    b[TILE_PIXELS - 1] = 2;
+
+    // Two 1MB tiles fill one 2MB slab
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % TileBufferPool::ALIGNMENT, 0u);
+    EXPECT_EQ(reinterpret_cast<uint8_t*>(b) - reinterpret_cast<uint8_t*>(a),
+              static_cast<ptrdiff_t>(TILE_PIXELS * sizeof(uint32_t)));
+    TileBufferPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.slabBytes, TileBufferPool::SLAB_BYTES);
+    EXPECT_LE(stats.hugePageBytes, stats.slabBytes);
+    EXPECT_EQ(stats.idleBytes, 0u);
+
+    pool.Release(a, capA);
+    pool.Release(b, capB);
+}
+
+TEST_F(TileBufferPoolTest, HugePages_SmallClassesShareASlab) {
+    pool.SetHugePages(HugePageMode::Transparent);
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(64 * 64, &capacity);
+
+    // The rest of the slab is idle, ready for the next acquires
+    TileBufferPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.slabBytes, TileBufferPool::SLAB_BYTES);
+    EXPECT_EQ(stats.idleBytes, TileBufferPool::SLAB_BYTES - capacity * sizeof(uint32_t));
+
+    size_t next = 0;
+    uint32_t* second = pool.Acquire(64 * 64, &next);
+    EXPECT_EQ(pool.GetStats().reuseCount, 1u);
+    EXPECT_EQ(pool.GetStats().slabBytes, TileBufferPool::SLAB_BYTES);
+
+    pool.Release(second, next);
+    pool.Release(pixels, capacity);
+}
+
+TEST_F(TileBufferPoolTest, HugePages_PartlyLiveSlab_SurvivesTrim) {
+    pool.SetHugePages(HugePageMode::Transparent);
+    size_t capA = 0, capB = 0;
+    uint32_t* a = pool.Acquire(TILE_PIXELS, &capA);
+    uint32_t* b = pool.Acquire(TILE_PIXELS, &capB);
+    pool.Release(a, capA);
+
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().slabBytes, TileBufferPool::SLAB_BYTES);
+    EXPECT_EQ(pool.GetStats().idleBytes, TILE_PIXELS * sizeof(uint32_t));
+
+    // Once the last buffer is back the slab goes
+    pool.Release(b, capB);
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().slabBytes, 0u);
+    EXPECT_EQ(pool.GetStats().idleBytes, 0u);
+}
+
+TEST_F(TileBufferPoolTest, HugePages_IdleSlabBeyondIdleLimit_IsUnmapped) {
+    TileBufferPool smallPool(0);
+    smallPool.SetHugePages(HugePageMode::Transparent);
+    size_t capA = 0, capB = 0;
+    uint32_t* a = smallPool.Acquire(TILE_PIXELS, &capA);
+    uint32_t* b = smallPool.Acquire(TILE_PIXELS, &capB);
+
+    smallPool.Release(a, capA);
+    EXPECT_EQ(smallPool.GetStats().slabBytes, TileBufferPool::SLAB_BYTES);
+    smallPool.Release(b, capB);
+    EXPECT_EQ(smallPool.GetStats().slabBytes, 0u);
+    EXPECT_EQ(smallPool.GetStats().idleBytes, 0u);
+}
+
+TEST_F(TileBufferPoolTest, HugePages_Explicit_FallsBackWhenNoneReserved) {
+    // Without reserved huge pages this still returns usable memory
+    pool.SetHugePages(HugePageMode::Explicit);
+    size_t capacity = 0;
+    uint32_t* pixels = pool.Acquire(TILE_PIXELS, &capacity);
+    ASSERT_NE(pixels, nullptr);
+    pixels[TILE_PIXELS - 1] = 0xFFFFFFFFu;
+    EXPECT_EQ(pool.GetStats().slabBytes, TileBufferPool::SLAB_BYTES);
+    pool.Release(pixels, capacity);
+}
+
+TEST_F(TileBufferPoolTest, HugePages_Off_HeapBuffersReleaseAlongsideSlabs) {
+    size_t heapCapacity = 0;
+    uint32_t* heap = pool.Acquire(TILE_PIXELS, &heapCapacity);
+    pool.SetHugePages(HugePageMode::Transparent);
+    size_t slabCapacity = 0;
+    uint32_t* slab = pool.Acquire(TILE_PIXELS, &slabCapacity);
+    pool.SetHugePages(HugePageMode::Off);
+
+    pool.Release(heap, heapCapacity);
+    pool.Release(slab, slabCapacity);
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().idleBytes, 0u);
+    EXPECT_EQ(pool.GetStats().slabBytes, 0u);
+}
+
+TEST_F(TileBufferPoolTest, ParseHugePageMode_RoundTrips) {
+    for (HugePageMode mode : {HugePageMode::Off, HugePageMode::Transparent, HugePageMode::Explicit}) {
+        EXPECT_EQ(TileBufferPool::ParseHugePageMode(TileBufferPool::HugePageModeName(mode)), mode);
+    }
+    EXPECT_FALSE(TileBufferPool::ParseHugePageMode("always").has_value());
+}
+
+// ============================================================================
+// TileCache Integration Tests
+// ============================================================================
+
+TEST_F(TileBufferPoolTest, TileCache_Eviction_RecyclesBuffer) {
+    const size_t tileBytes = TILE_PIXELS * sizeof(uint32_t);
+    TileCache cache(tileBytes);  // Room for exactly one tile
+    std::shared_ptr<TileBufferPool> cachePool = cache.GetBufferPool();
+
+    size_t capacity = 0;
+    uint32_t* pixels = cachePool->Acquire(TILE_PIXELS, &capacity);
+    cache.InsertTile({0, 0, 0}, TileData(pixels, 512, 512, cachePool, capacity));
+
+    // Inserting a second tile evicts the first, returning its buffer
+    uint32_t* next = cachePool->Acquire(TILE_PIXELS, &capacity);
+    cache.InsertTile({0, 1, 0}, TileData(next, 512, 512, cachePool, capacity));
+
+    EXPECT_EQ(cache.GetBufferPoolStats().idleBytes, tileBytes);
+    EXPECT_EQ(cachePool->Acquire(TILE_PIXELS, &capacity), pixels);
+    cachePool->Release(pixels, capacity);
+}
+
+TEST_F(TileBufferPoolTest, TileData_HandleOutlivesCache_ReleasesSafely) {
+    TileHandle handle;
+    {
+        TileCache cache;
+        std::shared_ptr<TileBufferPool> cachePool = cache.GetBufferPool();
+        size_t capacity = 0;
+        uint32_t* pixels = cachePool->Acquire(TILE_PIXELS, &capacity);
+        pixels[0] = 0xDEADBEEF;
+        cache.InsertTile({0, 0, 0}, TileData(pixels, 512, 512, cachePool, capacity));
+        handle = cache.GetTile({0, 0, 0});
+    }
+
+    ASSERT_NE(handle, nullptr);
+    EXPECT_EQ(handle->pixels[0], 0xDEADBEEFu);
+    handle.reset();  // Releases into the pool kept alive by the tile
+}
@@ -1,11 +1,14 @@
 // TileCache Unit Tests
-// Tests for LRU eviction policy and memory tracking
+// Tests for LRU (CLOCK) eviction policy, memory tracking, shard concurrency
+// and dropping one slide's tiles
 // Critical for efficient tile management
 
 #include <gtest/gtest.h>
 #include "TileCache.h"
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 // ============================================================================
 // Test Fixture
@@ -63,7 +66,7 @@ TEST_F(TileCacheTest, HasTile_EmptyCache_ReturnsFalse) {
 
 TEST_F(TileCacheTest, GetTile_EmptyCache_ReturnsNullptr) {
     TileKey key = MakeTileKey(0, 0, 0);
-    const TileData* tile = cache->GetTile(key);
+    TileHandle tile = cache->GetTile(key);
     EXPECT_EQ(tile, nullptr);
 }
 
@@ -105,7 +108,7 @@ TEST_F(TileCacheTest, GetTile_AfterInsert_ReturnsValidPointer) {
 
     cache->InsertTile(key, std::move(data));
 
-    const TileData* tile = cache->GetTile(key);
+    TileHandle tile = cache->GetTile(key);
     ASSERT_NE(tile, nullptr);
     EXPECT_EQ(tile->width * tile->height * sizeof(uint32_t), 1000 * sizeof(uint32_t));
 }
@@ -200,6 +203,58 @@ TEST_F(TileCacheTest, Eviction_MemoryUsage_CorrectAfterEviction) {
     EXPECT_GE(cache->GetMemoryUsage(), 300000);
 }
 
+// ============================================================================
+// Runtime Resize Tests
+// ============================================================================
+
+TEST_F(TileCacheTest, SetMaxMemory_Shrink_EvictsNothingUntilEvictLRU) {
+    for (int i = 0; i < 8; ++i) {
+        cache->InsertTile(MakeTileKey(0, i, 0), CreateTileData(100 * 1024));
+    }
+
+    cache->SetMaxMemory(300 * 1024);
+    EXPECT_EQ(cache->GetMaxMemory(), 300 * 1024);
+    EXPECT_EQ(cache->GetTileCount(), 8);
+
+    // Bounded steps, oldest first, stopping at the new limit
+    EXPECT_EQ(cache->EvictLRU(2), 200 * 1024);
+    EXPECT_EQ(cache->GetTileCount(), 6);
+    EXPECT_FALSE(cache->HasTile(MakeTileKey(0, 1, 0)));
+    EXPECT_EQ(cache->EvictLRU(100), 300 * 1024);
+    EXPECT_EQ(cache->GetMemoryUsage(), 300 * 1024);
+    EXPECT_EQ(cache->EvictLRU(100), 0);
+}
+
+TEST_F(TileCacheTest, InsertTile_AfterShrink_EvictsOnlyRoomForItself) {
+    for (int i = 0; i < 8; ++i) {
+        cache->InsertTile(MakeTileKey(0, i, 0), CreateTileData(100 * 1024));
+    }
+    cache->SetMaxMemory(200 * 1024);
+
+    cache->InsertTile(MakeTileKey(1, 0, 0), CreateTileData(100 * 1024));
+
+    EXPECT_EQ(cache->GetTileCount(), 8);
+    EXPECT_TRUE(cache->HasTile(MakeTileKey(1, 0, 0)));
+    EXPECT_FALSE(cache->HasTile(MakeTileKey(0, 0, 0)));
+}
+
+TEST_F(TileCacheTest, SetMaxMemory_Grow_KeepsTilesPastOldLimit) {
+    cache->SetMaxMemory(4 * 1024 * 1024);
+    for (int i = 0; i < 20; ++i) {
+        cache->InsertTile(MakeTileKey(0, i, 0), CreateTileData(100 * 1024));
+    }
+
+    EXPECT_EQ(cache->GetTileCount(), 20);
+}
+
+TEST(TileCacheAutoSizeTest, AutoSizeMaxMemory_EighthOfRamWithinBounds) {
+    const size_t GB = 1024ull * 1024 * 1024;
+    EXPECT_EQ(TileCache::AutoSizeMaxMemory(0), TileCache::DEFAULT_MAX_MEMORY);
+    EXPECT_EQ(TileCache::AutoSizeMaxMemory(16 * GB), 2 * GB);
+    EXPECT_EQ(TileCache::AutoSizeMaxMemory(1 * GB), TileCache::MIN_AUTO_MEMORY);
+    EXPECT_EQ(TileCache::AutoSizeMaxMemory(1024 * GB), TileCache::MAX_AUTO_MEMORY);
+}
+
 // ============================================================================
 // Hit/Miss Statistics Tests
 // ============================================================================
@@ -413,3 +468,340 @@ TEST_F(TileCacheTest, StressTest_AlternatingAccessPattern_CorrectLRU) {
     EXPECT_TRUE(cache->HasTile(key_b));
     // C may or may not be evicted depending on exact implementation
 }
+
+// ============================================================================
+// Tile Handle Tests
+// ============================================================================
+
+TEST_F(TileCacheTest, TileHandle_SurvivesEviction) {
+    cache = std::make_unique<TileCache>(200000);
+
+    TileKey key_a = MakeTileKey(0, 0, 0);
+    cache->InsertTile(key_a, CreateTileData(200000));
+    TileHandle pinned = cache->GetTile(key_a);
+    ASSERT_NE(pinned, nullptr);
+
+    // Evicts A from the cache while the handle is still held
+    cache->InsertTile(MakeTileKey(0, 1, 0), CreateTileData(200000));
+
+    EXPECT_FALSE(cache->HasTile(key_a));
+    EXPECT_EQ(pinned->memorySize, 200000u);
+    EXPECT_EQ(pinned->pixels[0], 0xFF0000FFu);
+}
+
+TEST_F(TileCacheTest, TileHandle_SurvivesClear) {
+    TileKey key = MakeTileKey(0, 0, 0);
+    cache->InsertTile(key, CreateTileData(1000));
+    TileHandle pinned = cache->GetTile(key);
+
+    cache->Clear();
+
+    ASSERT_NE(pinned, nullptr);
+    EXPECT_EQ(pinned->memorySize, 1000u);
+    EXPECT_EQ(cache->GetMemoryUsage(), 0u);
+}
+
+TEST_F(TileCacheTest, TileHandle_ReleasedAfterEviction_FreesData) {
+    cache = std::make_unique<TileCache>(1000);
+
+    TileKey key = MakeTileKey(0, 0, 0);
+    cache->InsertTile(key, CreateTileData(1000));
+    std::weak_ptr<const TileData> weak = cache->GetTile(key);
+
+    cache->InsertTile(MakeTileKey(0, 1, 0), CreateTileData(1000));
+
+    EXPECT_TRUE(weak.expired());
+}
+
+// ============================================================================
+// Concurrency Tests
+// ============================================================================
+
+TEST_F(TileCacheTest, Concurrency_ReadersAndWriters_MaintainMemoryLimit) {
+    cache = std::make_unique<TileCache>(500000);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w) {
+        writers.emplace_back([this, w]() {
+            for (int i = 0; i < 200; ++i) {
+                cache->InsertTile(MakeTileKey(w, i, 0), CreateTileData(10000));
+            }
+        });
+    }
+
+    // Render-thread style reader probing a working set across all shards.
+    // Handles keep the pixels valid even if a writer evicts the entry.
+    std::thread reader([this, &stop]() {
+        while (!stop.load()) {
+            for (int i = 0; i < 50; ++i) {
+                TileHandle tile = cache->GetTile(MakeTileKey(i % 4, i, 0));
+                if (tile) {
+                    EXPECT_EQ(tile->memorySize, 10000u);
+                    EXPECT_EQ(tile->pixels[0], 0xFF0000FFu);
+                }
+            }
+        }
+    });
+
+    for (auto& t : writers) {
+        t.join();
+    }
+    stop.store(true);
+    reader.join();
+
+    EXPECT_LE(cache->GetMemoryUsage(), 500000u);
+    EXPECT_EQ(cache->GetMemoryUsage(), cache->GetTileCount() * 10000u);
+}
+
+TEST_F(TileCacheTest, Eviction_SpansShards_KeepsGlobalOrder) {
+    // Keys spread over many shards must still evict oldest-first globally
+    cache = std::make_unique<TileCache>(TileCache::NUM_SHARDS * 2 * 1000);
+
+    size_t count = TileCache::NUM_SHARDS * 2;
+    for (size_t i = 0; i < count; ++i) {
+        cache->InsertTile(MakeTileKey(0, static_cast<int32_t>(i), 0), CreateTileData(1000));
+    }
+    cache->InsertTile(MakeTileKey(1, 0, 0), CreateTileData(1000));
+
+    EXPECT_FALSE(cache->HasTile(MakeTileKey(0, 0, 0)));
+    EXPECT_TRUE(cache->HasTile(MakeTileKey(0, 1, 0)));
+    EXPECT_TRUE(cache->HasTile(MakeTileKey(1, 0, 0)));
+}
+
+TEST_F(TileCacheTest, RemoveSlide_FreesOnlyThatSlide) {
+    TileKey first = MakeTileKey(0, 0, 0);
+    TileKey second = first;
+    second.slide = 2;
+    cache->InsertTile(first, CreateTileData(1000));
+    cache->InsertTile(second, CreateTileData(2000));
+    cache->GetCompressedTier().SetMaxBytes(1024 * 1024);
+    std::vector<uint32_t> pixels(64 * 64, 0xFF00FF00u);
+    cache->GetCompressedTier().Store(second, pixels.data(), 64, 64);
+
+    EXPECT_EQ(cache->RemoveSlide(2), 2000u);
+
+    EXPECT_TRUE(cache->HasTile(first));
+    EXPECT_FALSE(cache->HasTile(second));
+    EXPECT_FALSE(cache->GetCompressedTier().HasTile(second));
+    EXPECT_EQ(cache->GetMemoryUsage(), 1000u);
+    EXPECT_EQ(cache->GetTileCount(), 1u);
+}
+
+// ============================================================================
+// Eviction Policy and Pinning Tests
+// ============================================================================
+
+namespace {
+
+// Ten 100KB tiles fit in the fixture's 1MB: four in use, read every frame,
+// then a fling through fifty fresh level-0 tiles, each read once
+size_t WorkingSetLeftAfterFling(TileCache& cache, TileData (*create)(size_t)) {
+    std::vector<TileKey> working;
+    for (int32_t i = 0; i < 4; ++i) {
+        working.push_back({0, i, 100});
+        cache.InsertTile(working.back(), create(100 * 1000));
+    }
+    for (int32_t i = 0; i < 50; ++i) {
+        for (const TileKey& key : working) {
+            cache.GetTile(key);
+        }
+        TileKey fresh{0, i, 0};
+        cache.InsertTile(fresh, create(100 * 1000));
+        cache.GetTile(fresh);
+    }
+    return std::count_if(working.begin(), working.end(), [&](const TileKey& key) { return cache.HasTile(key); });
+}
+
+TileData CreateTile(size_t bytes) {
+    return TileData(new uint32_t[bytes / sizeof(uint32_t)](), static_cast<int32_t>(bytes / sizeof(uint32_t)), 1);
+}
+
+}  // namespace
+
+TEST_F(TileCacheTest, ScanResistant_FlingKeepsWorkingSet) {
+    cache->SetEvictionPolicy(TileEvictionPolicy::ScanResistant);
+    EXPECT_EQ(WorkingSetLeftAfterFling(*cache, CreateTile), 4u);
+    EXPECT_LE(cache->GetMemoryUsage(), cache->GetMaxMemory());
+}
+
+TEST_F(TileCacheTest, ScanResistant_CoarseLevelsOutliveFine) {
+    cache->SetEvictionPolicy(TileEvictionPolicy::ScanResistant);
+    // Both read twice, so both reach the main CLOCK, then never again
+    TileKey fine = MakeTileKey(0, 0, 0);
+    TileKey coarse = MakeTileKey(3, 0, 0);
+    for (const TileKey& key : {fine, coarse}) {
+        cache->InsertTile(key, CreateTileData(100 * 1000));
+        cache->GetTile(key);
+        cache->GetTile(key);
+    }
+    for (int32_t i = 0; i < 12; ++i) {
+        TileKey fresh = MakeTileKey(1, i, 0);
+        cache->InsertTile(fresh, CreateTileData(100 * 1000));
+        cache->GetTile(fresh);
+        cache->GetTile(fresh);
+    }
+    EXPECT_FALSE(cache->HasTile(fine));
+    EXPECT_TRUE(cache->HasTile(coarse));
+}
+
+TEST_F(TileCacheTest, PinLevels_CoarseLevelsNeverEvicted) {
+    TileKey coarse = MakeTileKey(5, 0, 0);
+    coarse.slide = 1;
+    TileKey other = coarse;
+    other.slide = 2;
+    cache->InsertTile(coarse, CreateTileData(100 * 1000));  // Before the pin: pinned on the sweep
+    cache->PinLevels(1, 4);
+    TileKey pinnedLater = MakeTileKey(4, 0, 0);
+    pinnedLater.slide = 1;
+    cache->InsertTile(pinnedLater, CreateTileData(100 * 1000));
+    cache->InsertTile(other, CreateTileData(100 * 1000));
+    EXPECT_EQ(cache->GetPinnedMemory(), 100u * 1000);
+
+    for (int32_t i = 0; i < 30; ++i) {
+        cache->InsertTile(MakeTileKey(0, i, 0), CreateTileData(100 * 1000));
+    }
+    EXPECT_TRUE(cache->HasTile(coarse));
+    EXPECT_TRUE(cache->HasTile(pinnedLater));
+    EXPECT_FALSE(cache->HasTile(other));
+    EXPECT_EQ(cache->GetPinnedMemory(), 200u * 1000);
+
+    // Past MAX_PINNED_FRACTION of the limit, tiles are evicted as usual
+    TileKey overBudget = MakeTileKey(4, 1, 0);
+    overBudget.slide = 1;
+    cache->InsertTile(overBudget, CreateTileData(100 * 1000));
+    EXPECT_EQ(cache->GetPinnedMemory(), 200u * 1000);
+
+    // Fewer levels pinned: level 4 back in the CLOCK
+    cache->PinLevels(1, 5);
+    EXPECT_EQ(cache->GetPinnedMemory(), 100u * 1000);
+    for (int32_t i = 0; i < 30; ++i) {
+        cache->InsertTile(MakeTileKey(0, i, 1), CreateTileData(100 * 1000));
+    }
+    EXPECT_TRUE(cache->HasTile(coarse));
+    EXPECT_FALSE(cache->HasTile(pinnedLater));
+
+    cache->RemoveSlide(1);
+    EXPECT_EQ(cache->GetPinnedMemory(), 0u);
+}
+
+TEST(TileCachePolicyTest, ParsesPolicyNames) {
+    EXPECT_EQ(TileCache::ParseEvictionPolicy("clock"), TileEvictionPolicy::Clock);
+    EXPECT_EQ(TileCache::ParseEvictionPolicy("scan-resistant"), TileEvictionPolicy::ScanResistant);
+    EXPECT_FALSE(TileCache::ParseEvictionPolicy("arc"));
+    EXPECT_STREQ(TileCache::EvictionPolicyName(TileEvictionPolicy::ScanResistant), "scan-resistant");
+}
+
+// ============================================================================
+// Packed Storage Tests
+// ============================================================================
+
+namespace {
+
+TileData CreateTissueTile(int32_t width, int32_t height, uint32_t alpha = 0xFF) {
+    uint32_t* pixels = new uint32_t[static_cast<size_t>(width) * height];
+    for (int32_t i = 0; i < width * height; ++i) {
+        const uint32_t r = 200 + i % 40, g = 100 + i % 60, b = 170 + i % 30;
+        pixels[i] = (alpha << 24) | (r << 16) | (g << 8) | b;
+    }
+    return TileData(pixels, width, height);
+}
+
+}  // namespace
+
+TEST_F(TileCacheTest, Storage_Rgb_ThreeQuartersOfTheMemoryAndExact) {
+    cache->SetStorage(TileStorage::Rgb);
+    TileData tile = CreateTissueTile(64, 32);
+    std::vector<uint32_t> original(tile.pixels, tile.pixels + 64 * 32);
+    cache->InsertTile(MakeTileKey(0, 0, 0), std::move(tile));
+
+    TileHandle cached = cache->GetTile(MakeTileKey(0, 0, 0));
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(cached->storage, TileStorage::Rgb);
+    EXPECT_EQ(cache->GetMemoryUsage(), 64u * 32 * 3);
+    EXPECT_EQ(cache->GetPackedTileCount(), 1u);
+
+    std::vector<uint32_t> scratch;
+    const uint32_t* pixels = cached->GetArgb(scratch);
+    EXPECT_EQ(std::vector<uint32_t>(pixels, pixels + 64 * 32), original);
+}
+
+TEST_F(TileCacheTest, Storage_Yuv420_ThreeEighthsOfTheMemory) {
+    cache->SetStorage(TileStorage::Yuv420);
+    cache->InsertTile(MakeTileKey(0, 0, 0), CreateTissueTile(64, 32));
+
+    TileHandle cached = cache->GetTile(MakeTileKey(0, 0, 0));
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(cached->storage, TileStorage::Yuv420);
+    EXPECT_EQ(cache->GetMemoryUsage(), 64u * 32 * 3 / 2);
+
+    std::vector<uint32_t> scratch;
+    const uint32_t* pixels = cached->GetArgb(scratch);
+    EXPECT_EQ(pixels[0] >> 24, 0xFFu);
+
+    cache->Clear();
+    EXPECT_EQ(cache->GetPackedTileCount(), 0u);
+}
+
+TEST_F(TileCacheTest, Storage_TransparentTile_StaysArgb) {
+    cache->SetStorage(TileStorage::Yuv420);
+    cache->InsertTile(MakeTileKey(0, 0, 0), CreateTissueTile(16, 16, 0x80));
+
+    TileHandle cached = cache->GetTile(MakeTileKey(0, 0, 0));
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(cached->storage, TileStorage::Argb);
+    EXPECT_EQ(cache->GetMemoryUsage(), 16u * 16 * 4);
+    EXPECT_EQ(cache->GetPackedTileCount(), 0u);
+}
+
+TEST_F(TileCacheTest, SolidTiles_UniformTile_KeepsOnlyItsColor) {
+    cache->SetSolidTiles(true);
+    cache->InsertTile(MakeTileKey(0, 0, 0), CreateTileData(64 * 64 * 4));
+
+    TileHandle cached = cache->GetTile(MakeTileKey(0, 0, 0));
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(cached->storage, TileStorage::Solid);
+    EXPECT_EQ(cached->solidColor, 0xFF0000FFu);
+    EXPECT_EQ(cached->pixels, nullptr);
+    EXPECT_EQ(cache->GetMemoryUsage(), 0u);
+    EXPECT_EQ(cache->GetSolidTileCount(), 1u);
+    EXPECT_EQ(cache->GetPackedTileCount(), 0u);
+
+    std::vector<uint32_t> scratch;
+    const uint32_t* pixels = cached->GetArgb(scratch);
+    EXPECT_EQ(std::vector<uint32_t>(pixels, pixels + cached->width * cached->height),
+              std::vector<uint32_t>(static_cast<size_t>(cached->width) * cached->height, 0xFF0000FFu));
+
+    cache->Clear();
+    EXPECT_EQ(cache->GetSolidTileCount(), 0u);
+}
+
+TEST_F(TileCacheTest, SolidTiles_TissueAndPartlyTransparent_KeepPixels) {
+    cache->SetSolidTiles(true);
+    cache->InsertTile(MakeTileKey(0, 0, 0), CreateTissueTile(16, 16));
+    uint32_t* faded = new uint32_t[16 * 16];
+    std::fill(faded, faded + 16 * 16, 0x80402020u);
+    cache->InsertTile(MakeTileKey(0, 1, 0), TileData(faded, 16, 16));
+
+    EXPECT_EQ(cache->GetTile(MakeTileKey(0, 0, 0))->storage, TileStorage::Argb);
+    EXPECT_EQ(cache->GetTile(MakeTileKey(0, 1, 0))->storage, TileStorage::Argb);
+    EXPECT_EQ(cache->GetSolidTileCount(), 0u);
+}
+
+TEST(TileCachePolicyTest, FindSolidColor_ChecksEveryPixel) {
+    std::vector<uint32_t> pixels(300, 0xFFF0F0F0u);
+    uint32_t color = 0;
+    EXPECT_TRUE(TileCache::FindSolidColor(pixels.data(), pixels.size(), &color));
+    EXPECT_EQ(color, 0xFFF0F0F0u);
+    pixels.back() = 0xFFF0F0F1u;
+    EXPECT_FALSE(TileCache::FindSolidColor(pixels.data(), pixels.size(), &color));
+    EXPECT_FALSE(TileCache::FindSolidColor(pixels.data(), 0, &color));
+}
+
+TEST(TileCachePolicyTest, ParsesStorageNames) {
+    EXPECT_EQ(TileCache::ParseStorage("rgb"), TileStorage::Rgb);
+    EXPECT_EQ(TileCache::ParseStorage("yuv420"), TileStorage::Yuv420);
+    EXPECT_EQ(TileCache::ParseStorage("argb"), TileStorage::Argb);
+    EXPECT_FALSE(TileCache::ParseStorage("yuv444"));
+    EXPECT_STREQ(TileCache::StorageName(TileStorage::Yuv420), "yuv420");
+}
@@ -0,0 +1,110 @@
+// TileCodec Unit Tests
+// Tests for lossless round trips, compression of slide-like content and
+// rejection of corrupt streams
+
+#include <gtest/gtest.h>
+#include "TileCodec.h"
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> RoundTrip(const std::vector<uint32_t>& pixels, int32_t width, int32_t height,
+                                size_t* compressedSize = nullptr) {
+    std::vector<uint8_t> encoded;
+    TileCodec::Compress(pixels.data(), width, height, encoded);
+    if (compressedSize) {
+        *compressedSize = encoded.size();
+    }
+    std::vector<uint32_t> decoded(pixels.size(), 0);
+    int32_t outWidth = 0, outHeight = 0;
+    EXPECT_TRUE(TileCodec::Decompress(encoded.data(), encoded.size(), decoded.data(), decoded.size(),
+                                      &outWidth, &outHeight));
+    EXPECT_EQ(outWidth, width);
+    EXPECT_EQ(outHeight, height);
+    return decoded;
+}
+
+}  // namespace
+
+// ============================================================================
+// Round Trip Tests
+// ============================================================================
+
+TEST(TileCodecTest, RoundTrip_RandomPixels_IsLossless) {
+    std::mt19937 rng(42);
+    std::vector<uint32_t> pixels(257 * 131);
+    for (auto& p : pixels) {
+        p = rng();
+    }
+
+    EXPECT_EQ(RoundTrip(pixels, 257, 131), pixels);
+}
+
+TEST(TileCodecTest, RoundTrip_AllOpsMixed_IsLossless) {
+    // Runs longer than one op, repeats from the colour table, small and
+    // medium deltas, literal colours and alpha changes
+    std::vector<uint32_t> pixels;
+    pixels.insert(pixels.end(), 200, 0xFFFFFFFF);
+    for (uint32_t i = 0; i < 300; ++i) {
+        uint8_t v = static_cast<uint8_t>(200 - (i % 7) - (i % 40));
+        pixels.push_back(0xFF000000 | (v << 16) | (static_cast<uint8_t>(v + 3) << 8) | (v - 5u));
+        if (i % 50 == 0) {
+            pixels.push_back(0xFFFFFFFF);
+            pixels.push_back(0x80402010);
+        }
+    }
+    pixels.insert(pixels.end(), 5, 0xFF000000);
+    int32_t width = static_cast<int32_t>(pixels.size());
+
+    EXPECT_EQ(RoundTrip(pixels, width, 1), pixels);
+}
+
+TEST(TileCodecTest, Compress_SlideLikeTile_ShrinksSeveralTimes) {
+    // Bright background with a smooth stained blob, as on most tiles
+    const int32_t size = 512;
+    std::vector<uint32_t> pixels(size * size, 0xFFF4F2F5);
+    for (int32_t y = 100; y < 400; ++y) {
+        for (int32_t x = 150; x < 450; ++x) {
+            uint8_t r = static_cast<uint8_t>(180 + (x + y) % 40 / 4);
+            uint8_t g = static_cast<uint8_t>(100 + (x * y) % 9);
+            uint8_t b = static_cast<uint8_t>(160 + y % 12);
+            pixels[y * size + x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    size_t compressedSize = 0;
+    EXPECT_EQ(RoundTrip(pixels, size, size, &compressedSize), pixels);
+    EXPECT_LT(compressedSize * 3, pixels.size() * sizeof(uint32_t));
+}
+
+// ============================================================================
+// Error Handling Tests
+// ============================================================================
+
+TEST(TileCodecTest, Decompress_TooSmallBuffer_Fails) {
+    std::vector<uint32_t> pixels(64, 0xFF102030);
+    std::vector<uint8_t> encoded;
+    TileCodec::Compress(pixels.data(), 8, 8, encoded);
+
+    std::vector<uint32_t> decoded(63);
+    int32_t w = 0, h = 0;
+    EXPECT_FALSE(TileCodec::Decompress(encoded.data(), encoded.size(), decoded.data(), decoded.size(), &w, &h));
+}
+
+TEST(TileCodecTest, Decompress_TruncatedOrForeign_Fails) {
+    std::mt19937 rng(7);
+    std::vector<uint32_t> pixels(32 * 32);
+    for (auto& p : pixels) {
+        p = rng();
+    }
+    std::vector<uint8_t> encoded;
+    TileCodec::Compress(pixels.data(), 32, 32, encoded);
+
+    std::vector<uint32_t> decoded(pixels.size());
+    int32_t w = 0, h = 0;
+    EXPECT_FALSE(TileCodec::Decompress(encoded.data(), encoded.size() - 1, decoded.data(), decoded.size(), &w, &h));
+
+    encoded[0] ^= 0xFF;
+    EXPECT_FALSE(TileCodec::Decompress(encoded.data(), encoded.size(), decoded.data(), decoded.size(), &w, &h));
+}
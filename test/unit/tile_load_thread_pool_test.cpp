@@ -0,0 +1,306 @@
+// TileLoadThreadPool Unit Tests
+// Tests for request deduplication, promotion, stale-request retirement, scaling,
+// choosing which neighbours coalesce into one region read, and slides
+// sharing one pool
+// Workers are never started, so only the queue bookkeeping is exercised
+
+#include <gtest/gtest.h>
+#include "TileLoadThreadPool.h"
+#include <set>
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TileLoadThreadPoolTest : public ::testing::Test {
+protected:
+    std::unique_ptr<TileCache> cache;
+    std::unique_ptr<TileLoadThreadPool> pool;
+
+    void SetUp() override {
+        cache = std::make_unique<TileCache>(1024 * 1024);
+        pool = std::make_unique<TileLoadThreadPool>(1);
+        pool->Initialize(nullptr, cache.get(), nullptr);
+    }
+
+    TileLoadRequest MakeRequest(int32_t x, TileLoadPriority priority, uint64_t generation) {
+        return TileLoadRequest({0, x, 0}, priority, generation);
+    }
+};
+
+// ============================================================================
+// Submission Tests
+// ============================================================================
+
+TEST_F(TileLoadThreadPoolTest, SubmitRequest_NewTile_IsQueued) {
+    EXPECT_TRUE(pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1)));
+
+    EXPECT_TRUE(pool->IsPending({0, 0, 0}));
+    EXPECT_EQ(pool->GetPendingCount(), 1);
+}
+
+TEST_F(TileLoadThreadPoolTest, SubmitRequest_Duplicate_IsDeduplicated) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::VISIBLE, 1));
+
+    EXPECT_FALSE(pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 2)));
+    EXPECT_EQ(pool->GetPendingCount(), 1);
+}
+
+TEST_F(TileLoadThreadPoolTest, SubmitRequest_CachedTile_IsSkipped) {
+    cache->InsertTile({0, 0, 0}, TileData(new uint32_t[4], 2, 2));
+
+    EXPECT_FALSE(pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1)));
+    EXPECT_FALSE(pool->IsPending({0, 0, 0}));
+}
+
+TEST_F(TileLoadThreadPoolTest, SubmitRequests_MaxNew_CapsOnlyNewTiles) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::ADJACENT, 1));
+    std::vector<TileLoadRequest> requests = {
+        MakeRequest(0, TileLoadPriority::ADJACENT, 2),
+        MakeRequest(1, TileLoadPriority::ADJACENT, 2),
+        MakeRequest(2, TileLoadPriority::ADJACENT, 2),
+    };
+
+    EXPECT_EQ(pool->SubmitRequests(requests.data(), requests.size(), 1), 1u);
+    EXPECT_EQ(pool->GetPendingCount(), 2);
+    EXPECT_FALSE(pool->IsPending({0, 2, 0}));
+
+    // The already-queued tile was still refreshed to generation 2
+    pool->RetireStaleRequests(2);
+    EXPECT_TRUE(pool->IsPending({0, 0, 0}));
+}
+
+TEST_F(TileLoadThreadPoolTest, CancelRequest_RemovesQueuedRequest) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1));
+    pool->SubmitRequest(MakeRequest(1, TileLoadPriority::URGENT, 1));
+
+    pool->CancelRequest({0, 0, 0});
+
+    EXPECT_FALSE(pool->IsPending({0, 0, 0}));
+    EXPECT_TRUE(pool->IsPending({0, 1, 0}));
+    EXPECT_EQ(pool->GetPendingCount(), 1);
+}
+
+TEST_F(TileLoadThreadPoolTest, CancelAllRequests_EmptiesQueue) {
+    for (int32_t x = 0; x < 5; ++x) {
+        pool->SubmitRequest(MakeRequest(x, TileLoadPriority::VISIBLE, 1));
+    }
+
+    pool->CancelAllRequests();
+
+    EXPECT_EQ(pool->GetPendingCount(), 0);
+}
+
+// ============================================================================
+// Stale Request Retirement Tests
+// ============================================================================
+
+TEST_F(TileLoadThreadPoolTest, RetireStale_CurrentGeneration_IsKept) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 5));
+
+    pool->RetireStaleRequests(5);
+
+    EXPECT_TRUE(pool->IsPending({0, 0, 0}));
+    EXPECT_EQ(pool->GetDroppedCount(), 0);
+}
+
+TEST_F(TileLoadThreadPoolTest, RetireStale_Resubmitted_RefreshesGeneration) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1));
+
+    uint64_t later = 1 + TileLoadThreadPool::STALE_DROP_GENERATIONS + 10;
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, later));
+    pool->RetireStaleRequests(later);
+
+    EXPECT_TRUE(pool->IsPending({0, 0, 0}));
+}
+
+TEST_F(TileLoadThreadPoolTest, RetireStale_LongUnrequested_IsDropped) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1));
+    pool->SubmitRequest(MakeRequest(1, TileLoadPriority::URGENT, 1));
+
+    uint64_t later = 1 + TileLoadThreadPool::STALE_DROP_GENERATIONS + 1;
+    pool->SubmitRequest(MakeRequest(1, TileLoadPriority::URGENT, later));
+    pool->RetireStaleRequests(later);
+
+    EXPECT_FALSE(pool->IsPending({0, 0, 0}));
+    EXPECT_TRUE(pool->IsPending({0, 1, 0}));
+    EXPECT_EQ(pool->GetDroppedCount(), 1);
+}
+
+TEST_F(TileLoadThreadPoolTest, RetireStale_RecentlyUnrequested_IsDemotedNotDropped) {
+    pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 1));
+
+    pool->RetireStaleRequests(2);
+
+    // Demoted requests can be promoted again once the tile is visible
+    EXPECT_TRUE(pool->IsPending({0, 0, 0}));
+    EXPECT_EQ(pool->GetDroppedCount(), 0);
+    EXPECT_FALSE(pool->SubmitRequest(MakeRequest(0, TileLoadPriority::URGENT, 3)));
+    EXPECT_EQ(pool->GetPendingCount(), 1);
+}
+
+// ============================================================================
+// Worker Scaling Tests
+// ============================================================================
+
+TEST_F(TileLoadThreadPoolTest, Constructor_ZeroThreads_UsesDefaultCount) {
+    TileLoadThreadPool autoPool(0);
+
+    EXPECT_EQ(autoPool.GetThreadCount(), TileLoadThreadPool::DefaultThreadCount());
+    EXPECT_GE(autoPool.GetThreadCount(), 1);
+}
+
+TEST_F(TileLoadThreadPoolTest, UpdateScaling_Disabled_KeepsAllWorkers) {
+    TileLoadThreadPool fixedPool(8);
+    fixedPool.Initialize(nullptr, cache.get(), nullptr);
+
+    fixedPool.UpdateScaling();
+
+    EXPECT_EQ(fixedPool.GetWorkerLimit(), 8);
+}
+
+TEST_F(TileLoadThreadPoolTest, UpdateScaling_Backlog_AddsWorkersUpToMax) {
+    TileLoadThreadPool scaledPool(4);
+    scaledPool.Initialize(nullptr, cache.get(), nullptr);
+    scaledPool.EnableAutoScaling(1);
+    ASSERT_EQ(scaledPool.GetWorkerLimit(), 1);
+
+    for (int32_t x = 0; x < 50; ++x) {
+        scaledPool.SubmitRequest(MakeRequest(x, TileLoadPriority::VISIBLE, 1));
+    }
+    for (int i = 0; i < 10; ++i) {
+        scaledPool.UpdateScaling();
+    }
+
+    EXPECT_EQ(scaledPool.GetWorkerLimit(), 4);
+}
+
+TEST_F(TileLoadThreadPoolTest, UpdateScaling_SustainedIdle_ParksWorkers) {
+    TileLoadThreadPool scaledPool(4);
+    scaledPool.Initialize(nullptr, cache.get(), nullptr);
+    scaledPool.EnableAutoScaling(2);
+
+    scaledPool.SubmitRequest(MakeRequest(0, TileLoadPriority::VISIBLE, 1));
+    scaledPool.UpdateScaling();
+    scaledPool.UpdateScaling();
+    ASSERT_EQ(scaledPool.GetWorkerLimit(), 4);
+
+    scaledPool.CancelAllRequests();
+    for (uint32_t i = 0; i < 10 * TileLoadThreadPool::SCALE_DOWN_IDLE_FRAMES; ++i) {
+        scaledPool.UpdateScaling();
+    }
+
+    EXPECT_EQ(scaledPool.GetWorkerLimit(), 2);
+}
+
+// ============================================================================
+// Coalescing Tests
+// ============================================================================
+
+TEST_F(TileLoadThreadPoolTest, CoalesceBlock_AllNeighboursQueued_TakesWholeBlock) {
+    std::vector<TileKey> block = TileLoadThreadPool::CoalesceBlock({0, 3, 5}, [](const TileKey&) { return true; });
+
+    ASSERT_EQ(block.size(), 4u);
+    EXPECT_EQ(block.front(), (TileKey{0, 3, 5}));
+    EXPECT_EQ(std::set<TileKey>(block.begin(), block.end()),
+              (std::set<TileKey>{{0, 2, 4}, {0, 3, 4}, {0, 2, 5}, {0, 3, 5}}));
+}
+
+TEST_F(TileLoadThreadPoolTest, CoalesceBlock_OneNeighbour_TakesPair) {
+    std::vector<TileKey> block = TileLoadThreadPool::CoalesceBlock(
+        {0, 0, 0}, [](const TileKey& key) { return key == TileKey{0, 0, 1}; });
+
+    ASSERT_EQ(block.size(), 2u);
+    EXPECT_EQ(block[1], (TileKey{0, 0, 1}));
+}
+
+TEST_F(TileLoadThreadPoolTest, CoalesceBlock_OnlyDiagonal_StaysAlone) {
+    // A region read must be rectangular: the diagonal tile would drag in two more
+    std::vector<TileKey> block = TileLoadThreadPool::CoalesceBlock(
+        {0, 0, 0}, [](const TileKey& key) { return key == TileKey{0, 1, 1}; });
+
+    ASSERT_EQ(block.size(), 1u);
+    EXPECT_EQ(block.front(), (TileKey{0, 0, 0}));
+}
+
+// ============================================================================
+// Shared Pool Tests
+// ============================================================================
+
+TEST_F(TileLoadThreadPoolTest, SharedPool_QueuesOnlyRegisteredSlides) {
+    TileLoadThreadPool shared(1);
+    shared.Initialize(cache.get());
+    EXPECT_EQ(shared.GetSlideCount(), 0u);
+
+    TileLoadRequest request({0, 0, 0, 7}, TileLoadPriority::VISIBLE, 1);
+    EXPECT_FALSE(shared.SubmitRequest(request));
+
+    EXPECT_TRUE(shared.AddSlide(7, {}));
+    EXPECT_FALSE(shared.AddSlide(7, {}));
+    EXPECT_TRUE(shared.SubmitRequest(request));
+    EXPECT_EQ(shared.GetPendingCount(7), 1u);
+    EXPECT_EQ(shared.GetPendingCount(8), 0u);
+}
+
+TEST_F(TileLoadThreadPoolTest, SharedPool_SameTileOfTwoSlides_QueuedTwice) {
+    TileLoadThreadPool shared(1);
+    shared.Initialize(cache.get());
+    shared.AddSlide(1, {});
+    shared.AddSlide(2, {});
+
+    EXPECT_TRUE(shared.SubmitRequest(TileLoadRequest({0, 3, 4, 1}, TileLoadPriority::VISIBLE, 1)));
+    EXPECT_TRUE(shared.SubmitRequest(TileLoadRequest({0, 3, 4, 2}, TileLoadPriority::VISIBLE, 1)));
+    EXPECT_EQ(shared.GetPendingCount(), 2u);
+
+    // Each slide's cached tiles only satisfy that slide
+    cache->InsertTile({0, 5, 5, 1}, TileData(new uint32_t[4], 2, 2));
+    EXPECT_FALSE(shared.SubmitRequest(TileLoadRequest({0, 5, 5, 1}, TileLoadPriority::VISIBLE, 1)));
+    EXPECT_TRUE(shared.SubmitRequest(TileLoadRequest({0, 5, 5, 2}, TileLoadPriority::VISIBLE, 1)));
+}
+
+TEST_F(TileLoadThreadPoolTest, SharedPool_RetireSlide_LeavesOtherSlides) {
+    TileLoadThreadPool shared(1);
+    shared.Initialize(cache.get());
+    shared.AddSlide(1, {});
+    shared.AddSlide(2, {});
+    shared.SubmitRequest(TileLoadRequest({0, 0, 0, 1}, TileLoadPriority::URGENT, 1));
+    shared.SubmitRequest(TileLoadRequest({0, 0, 0, 2}, TileLoadPriority::URGENT, 1));
+
+    // Slide 1's renderer has moved far ahead; slide 2 counts its own generations
+    shared.RetireStaleSlideRequests(1, 1 + TileLoadThreadPool::STALE_DROP_GENERATIONS + 1);
+
+    EXPECT_FALSE(shared.IsPending({0, 0, 0, 1}));
+    EXPECT_TRUE(shared.IsPending({0, 0, 0, 2}));
+}
+
+TEST_F(TileLoadThreadPoolTest, SharedPool_RemoveSlide_DropsItsRequests) {
+    TileLoadThreadPool shared(1);
+    shared.Initialize(cache.get());
+    shared.AddSlide(1, {});
+    shared.AddSlide(2, {});
+    for (int32_t x = 0; x < 3; ++x) {
+        shared.SubmitRequest(TileLoadRequest({0, x, 0, 1}, TileLoadPriority::VISIBLE, 1));
+    }
+    shared.SubmitRequest(TileLoadRequest({0, 0, 0, 2}, TileLoadPriority::VISIBLE, 1));
+
+    shared.RemoveSlide(1);
+
+    EXPECT_EQ(shared.GetSlideCount(), 1u);
+    EXPECT_EQ(shared.GetPendingCount(), 1u);
+    EXPECT_FALSE(shared.IsPending({0, 0, 0, 1}));
+    EXPECT_FALSE(shared.SubmitRequest(TileLoadRequest({0, 0, 0, 1}, TileLoadPriority::VISIBLE, 1)));
+}
+
+TEST_F(TileLoadThreadPoolTest, SharedPool_RemoveSlideWithoutWaiting_NothingInFlight_LeavesAtOnce) {
+    TileLoadThreadPool shared(1);
+    shared.Initialize(cache.get());
+    shared.AddSlide(1, {});
+    shared.SubmitRequest(TileLoadRequest({0, 0, 0, 1}, TileLoadPriority::VISIBLE, 1));
+    EXPECT_TRUE(shared.HasSlide(1));
+
+    shared.RemoveSlide(1, false);
+
+    EXPECT_FALSE(shared.HasSlide(1));
+    EXPECT_EQ(shared.GetPendingCount(), 0u);
+    shared.RemoveSlide(1);  // Already gone: no-op
+}
@@ -0,0 +1,157 @@
+// TileScheduler Unit Tests
+// Tests for the screen-space score inputs, score ordering, deadline
+// promotion as a tile stays missing, and the recorded decisions
+
+#include <gtest/gtest.h>
+#include "TileScheduler.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+TileScheduler::Inputs MakeInputs(double coverage, double centreDistance, bool hasFallback) {
+    TileScheduler::Inputs inputs;
+    inputs.coverage = coverage;
+    inputs.centreDistance = centreDistance;
+    inputs.hasFallback = hasFallback;
+    return inputs;
+}
+
+}  // namespace
+
+// ============================================================================
+// Input Tests
+// ============================================================================
+
+TEST(TileSchedulerTest, Coverage_ClipsToView) {
+    EXPECT_DOUBLE_EQ(TileScheduler::Coverage({0, 0, 50, 50}, 100, 100), 0.25);
+    EXPECT_DOUBLE_EQ(TileScheduler::Coverage({-50, -50, 100, 100}, 100, 100), 0.25);
+    EXPECT_DOUBLE_EQ(TileScheduler::Coverage({200, 0, 50, 50}, 100, 100), 0.0);
+}
+
+TEST(TileSchedulerTest, CentreDistance_ZeroAtCentreOneAtCorner) {
+    EXPECT_DOUBLE_EQ(TileScheduler::CentreDistance({40, 40, 20, 20}, 100, 100), 0.0);
+    EXPECT_DOUBLE_EQ(TileScheduler::CentreDistance({-10, -10, 20, 20}, 100, 100), 1.0);
+    EXPECT_DOUBLE_EQ(TileScheduler::CentreDistance({-500, 0, 20, 20}, 100, 100), 1.0);
+}
+
+TEST(TileSchedulerTest, LevelFit_IsRatioOfDownsamples) {
+    EXPECT_DOUBLE_EQ(TileScheduler::LevelFit(4.0, 4.0), 1.0);
+    EXPECT_DOUBLE_EQ(TileScheduler::LevelFit(4.0, 2.0), 0.5);
+    EXPECT_DOUBLE_EQ(TileScheduler::LevelFit(1.0, 2.0), 0.5);
+}
+
+// ============================================================================
+// Scoring Tests
+// ============================================================================
+
+TEST(TileSchedulerTest, Score_CentralLargeTileRanksFirst) {
+    TileScheduler scheduler;
+    double central = scheduler.Score(MakeInputs(0.2, 0.1, true));
+    double edge = scheduler.Score(MakeInputs(0.05, 0.9, true));
+    EXPECT_GT(central, edge);
+}
+
+TEST(TileSchedulerTest, Score_NoFallbackOutranksFallback) {
+    TileScheduler scheduler;
+    EXPECT_GT(scheduler.Score(MakeInputs(0.05, 0.9, false)), scheduler.Score(MakeInputs(0.2, 0.1, true)));
+    EXPECT_EQ(scheduler.PriorityOf(MakeInputs(0.05, 0.9, false)), TileLoadPriority::URGENT);
+    EXPECT_EQ(scheduler.PriorityOf(MakeInputs(0.05, 0.9, true)), TileLoadPriority::VISIBLE);
+}
+
+TEST(TileSchedulerTest, Score_ZeroWeightsIgnoreTerms) {
+    TileScheduler scheduler;
+    TileScheduler::Weights weights;
+    weights.centre = 0.0;
+    weights.noFallback = 0.0;
+    weights.levelFit = 0.0;
+    weights.age = 0.0;
+    scheduler.SetWeights(weights);
+    EXPECT_DOUBLE_EQ(scheduler.Score(MakeInputs(0.3, 0.7, false)), 0.3);
+}
+
+// ============================================================================
+// Deadline Tests
+// ============================================================================
+
+TEST(TileSchedulerTest, Schedule_MissingPastDeadline_BecomesUrgent) {
+    TileScheduler scheduler;
+    scheduler.SetDeadlineMs(100.0);
+    TileKey key{1, 2, 3};
+    auto start = TileScheduler::Clock::now();
+
+    scheduler.BeginFrame(start);
+    TileLoadRequest first = scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 1);
+    scheduler.EndFrame();
+    EXPECT_EQ(first.priority, TileLoadPriority::VISIBLE);
+
+    scheduler.BeginFrame(start + 50ms);
+    TileLoadRequest waiting = scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 2);
+    scheduler.EndFrame();
+    EXPECT_EQ(waiting.priority, TileLoadPriority::VISIBLE);
+    EXPECT_GT(waiting.score, first.score);  // Older ranks higher
+
+    scheduler.BeginFrame(start + 150ms);
+    TileLoadRequest late = scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 3);
+    scheduler.EndFrame();
+    EXPECT_EQ(late.priority, TileLoadPriority::URGENT);
+    EXPECT_EQ(scheduler.GetDeadlineMissCount(), 1u);
+
+    // Still late next frame: one miss, not two
+    scheduler.BeginFrame(start + 200ms);
+    scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 4);
+    scheduler.EndFrame();
+    EXPECT_EQ(scheduler.GetDeadlineMissCount(), 1u);
+}
+
+TEST(TileSchedulerTest, Schedule_TileGoneForAFrame_AgeRestarts) {
+    TileScheduler scheduler;
+    scheduler.SetDeadlineMs(100.0);
+    TileKey key{0, 0, 0};
+    auto start = TileScheduler::Clock::now();
+
+    scheduler.BeginFrame(start);
+    scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 1);
+    scheduler.EndFrame();
+
+    scheduler.BeginFrame(start + 50ms);  // Loaded, or scrolled away
+    scheduler.EndFrame();
+
+    scheduler.BeginFrame(start + 150ms);
+    TileLoadRequest again = scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 3);
+    scheduler.EndFrame();
+    EXPECT_EQ(again.priority, TileLoadPriority::VISIBLE);
+    EXPECT_DOUBLE_EQ(scheduler.GetDecisions().front().inputs.ageMs, 0.0);
+}
+
+TEST(TileSchedulerTest, Schedule_ZeroDeadline_NeverPromotes) {
+    TileScheduler scheduler;
+    scheduler.SetDeadlineMs(0.0);
+    TileKey key{0, 1, 1};
+    auto start = TileScheduler::Clock::now();
+    scheduler.BeginFrame(start);
+    scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 1);
+    scheduler.EndFrame();
+    scheduler.BeginFrame(start + 10s);
+    EXPECT_EQ(scheduler.Schedule(key, MakeInputs(0.1, 0.5, true), 2).priority, TileLoadPriority::VISIBLE);
+}
+
+TEST(TileSchedulerTest, GetDecisions_LastFrameInScheduleOrder) {
+    TileScheduler scheduler;
+    auto start = TileScheduler::Clock::now();
+    scheduler.BeginFrame(start);
+    scheduler.Schedule({0, 0, 0}, MakeInputs(0.1, 0.5, true), 1);
+    scheduler.EndFrame();
+
+    scheduler.BeginFrame(start + 16ms);
+    scheduler.Schedule({0, 1, 0}, MakeInputs(0.1, 0.5, false), 2);
+    scheduler.Schedule({0, 2, 0}, MakeInputs(0.3, 0.2, true), 2);
+    scheduler.EndFrame();
+
+    const auto& decisions = scheduler.GetDecisions();
+    ASSERT_EQ(decisions.size(), 2u);
+    EXPECT_EQ(decisions[0].key.tileX, 1);
+    EXPECT_EQ(decisions[0].priority, TileLoadPriority::URGENT);
+    EXPECT_EQ(decisions[1].key.tileX, 2);
+    EXPECT_DOUBLE_EQ(decisions[1].inputs.coverage, 0.3);
+}
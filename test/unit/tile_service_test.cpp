@@ -0,0 +1,374 @@
+// TileService Unit Tests
+// Tests for the DeepZoom grid, tile composition from pipeline tiles,
+// the encoded tile cache, waiting on missing tiles, and the IIIF mapping,
+// over fake pipeline hooks
+
+#include <gtest/gtest.h>
+#include "TileService.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+#include <cstdio>  // jpeglib.h needs FILE
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+constexpr int64_t SLIDE_WIDTH = 1000;
+constexpr int64_t SLIDE_HEIGHT = 600;
+constexpr int32_t PIPELINE_TILE = 256;
+constexpr uint32_t LEVEL0_COLOR = 0xFF204060;
+constexpr uint32_t LEVEL1_COLOR = 0xFF608020;
+
+// A two-level slide (1x, 4x) whose pipeline tiles are solid per level.
+// Tiles become "cached" once requested unless holdRequests is set.
+struct FakePipeline {
+    std::mutex mutex;
+    std::unordered_map<TileKey, TileHandle, TileKeyHash> cached;
+    std::vector<TileKey> fetched;
+    std::vector<TileKey> requested;
+    bool holdRequests = false;
+
+    TileHandle MakeTile(const TileKey& key) {
+        LevelDimensions dimensions = key.level == 0 ? LevelDimensions{SLIDE_WIDTH, SLIDE_HEIGHT}
+                                                    : LevelDimensions{SLIDE_WIDTH / 4, SLIDE_HEIGHT / 4};
+        int32_t width = static_cast<int32_t>(std::min<int64_t>(PIPELINE_TILE, dimensions.width - key.tileX * PIPELINE_TILE));
+        int32_t height = static_cast<int32_t>(std::min<int64_t>(PIPELINE_TILE, dimensions.height - key.tileY * PIPELINE_TILE));
+        auto* pixels = new uint32_t[static_cast<size_t>(width) * height];
+        std::fill(pixels, pixels + static_cast<size_t>(width) * height, key.level == 0 ? LEVEL0_COLOR : LEVEL1_COLOR);
+        return std::make_shared<const TileData>(pixels, width, height);
+    }
+
+    void CacheAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int32_t level = 0; level < 2; ++level) {
+            int64_t scale = level == 0 ? 1 : 4;
+            for (int32_t row = 0; row * PIPELINE_TILE < SLIDE_HEIGHT / scale; ++row) {
+                for (int32_t column = 0; column * PIPELINE_TILE < SLIDE_WIDTH / scale; ++column) {
+                    TileKey key{level, column, row};
+                    cached[key] = MakeTile(key);
+                }
+            }
+        }
+    }
+
+    TileServiceSlide MakeSlide(const std::string& id) {
+        TileServiceSlide slide;
+        slide.id = id;
+        slide.width = SLIDE_WIDTH;
+        slide.height = SLIDE_HEIGHT;
+        slide.pyramid = PyramidLayout({1.0, 4.0},
+                                      {{SLIDE_WIDTH, SLIDE_HEIGHT}, {SLIDE_WIDTH / 4, SLIDE_HEIGHT / 4}},
+                                      PIPELINE_TILE, false);
+        slide.getTile = [this](const TileKey& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            fetched.push_back(key);
+            auto it = cached.find(key);
+            return it == cached.end() ? TileHandle() : it->second;
+        };
+        slide.requestTile = [this](const TileKey& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            requested.push_back(key);
+            if (!holdRequests) {
+                cached[key] = MakeTile(key);
+            }
+        };
+        return slide;
+    }
+
+    std::set<int32_t> FetchedLevels() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::set<int32_t> levels;
+        for (const TileKey& key : fetched) {
+            levels.insert(key.level);
+        }
+        return levels;
+    }
+
+    size_t FetchCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fetched.size();
+    }
+};
+
+const std::string SLIDE_ID = "0123456789abcdef";
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class TileServiceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        pipeline.CacheAll();
+        service.SetSlide(pipeline.MakeSlide(SLIDE_ID));
+    }
+
+    static bool HasImageSignature(const EncodedTile& tile) {
+        if (!tile.data || tile.data->size() < 4) {
+            return false;
+        }
+        const auto& bytes = *tile.data;
+        if (std::strcmp(TileService::GetTileFormat(), "jpg") == 0) {
+            return bytes[0] == 0xFF && bytes[1] == 0xD8;
+        }
+        return bytes[1] == 'P' && bytes[2] == 'N' && bytes[3] == 'G';
+    }
+
+    FakePipeline pipeline;
+    TileService service;
+};
+
+// ============================================================================
+// Grid Tests
+// ============================================================================
+
+TEST_F(TileServiceTest, GetMaxLevel_CoversLongerSide) {
+    EXPECT_EQ(TileService::GetMaxLevel(1, 1), 0);
+    EXPECT_EQ(TileService::GetMaxLevel(256, 256), 8);
+    EXPECT_EQ(TileService::GetMaxLevel(257, 1), 9);
+    EXPECT_EQ(TileService::GetMaxLevel(SLIDE_WIDTH, SLIDE_HEIGHT), 10);
+}
+
+TEST_F(TileServiceTest, MakeSlideId_IsStableHex) {
+    std::string id = TileService::MakeSlideId("/data/slide.svs");
+    EXPECT_EQ(id.size(), 16u);
+    EXPECT_EQ(id.find_first_not_of("0123456789abcdef"), std::string::npos);
+    EXPECT_EQ(id, TileService::MakeSlideId("/data/slide.svs"));
+    EXPECT_NE(id, TileService::MakeSlideId("/data/slide2.svs"));
+}
+
+TEST_F(TileServiceTest, GetDzi_DescribesSlide) {
+    std::string xml;
+    ASSERT_EQ(service.GetDzi(SLIDE_ID, xml), TileServiceStatus::Ok);
+    EXPECT_NE(xml.find("TileSize=\"256\""), std::string::npos);
+    EXPECT_NE(xml.find("Overlap=\"0\""), std::string::npos);
+    EXPECT_NE(xml.find("Width=\"1000\" Height=\"600\""), std::string::npos);
+    EXPECT_NE(xml.find(std::string("Format=\"") + TileService::GetTileFormat() + "\""), std::string::npos);
+
+    EXPECT_EQ(service.GetDzi("ffffffffffffffff", xml), TileServiceStatus::NotFound);
+    ASSERT_EQ(service.GetSlideIds().size(), 1u);
+    EXPECT_EQ(service.GetSlideIds()[0], SLIDE_ID);
+}
+
+// ============================================================================
+// Tile Tests
+// ============================================================================
+
+TEST_F(TileServiceTest, GetTile_FullResolution_UsesFinestLevel) {
+    EncodedTile tile;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_TRUE(HasImageSignature(tile));
+    EXPECT_EQ(pipeline.FetchedLevels(), std::set<int32_t>{0});
+    EXPECT_EQ(pipeline.FetchCount(), 1u);
+    EXPECT_FALSE(tile.etag.empty());
+    EXPECT_EQ(tile.etag.front(), '"');
+}
+
+TEST_F(TileServiceTest, GetTile_Downsampled_UsesCoarsestLevelNoSharper) {
+    EncodedTile tile;
+    // DeepZoom level 9 is 2x: built from level 0 (4x is too coarse)
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 9, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_EQ(pipeline.FetchedLevels(), std::set<int32_t>{0});
+    EXPECT_EQ(pipeline.FetchCount(), 4u);  // 512 x 512 level 0 pixels
+
+    // Level 8 is 4x and level 0 is 1024x: both from level 1
+    pipeline.fetched.clear();
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 8, 0, 0, tile), TileServiceStatus::Ok);
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 0, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_EQ(pipeline.FetchedLevels(), std::set<int32_t>{1});
+}
+
+TEST_F(TileServiceTest, GetTile_OutsideGrid_NotFound) {
+    EncodedTile tile;
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 11, 0, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(SLIDE_ID, -1, 0, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, 4, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, 0, 3, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile("ffffffffffffffff", 10, 0, 0, tile), TileServiceStatus::NotFound);
+
+    // Indices whose pixel offsets would overflow int64
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, int64_t{1} << 55, 0, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, 0, std::numeric_limits<int64_t>::max(), tile),
+              TileServiceStatus::NotFound);
+
+    // The partial edge tile exists
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, 3, 2, tile), TileServiceStatus::Ok);
+}
+
+TEST_F(TileServiceTest, GetTile_Repeated_ServedFromEncodedCache) {
+    EncodedTile first;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 1, 1, first), TileServiceStatus::Ok);
+    size_t fetches = pipeline.FetchCount();
+
+    EncodedTile second;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 1, 1, second), TileServiceStatus::Ok);
+    EXPECT_EQ(pipeline.FetchCount(), fetches);
+    EXPECT_EQ(second.data, first.data);
+    EXPECT_EQ(second.etag, first.etag);
+    EXPECT_EQ(service.GetEncodedHitCount(), 1u);
+    EXPECT_EQ(service.GetEncodedMissCount(), 1u);
+    EXPECT_EQ(service.GetEncodedCacheBytes(), first.data->size());
+
+    // Other tiles have other tags
+    EncodedTile other;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 0, 1, other), TileServiceStatus::Ok);
+    EXPECT_NE(other.etag, first.etag);
+}
+
+TEST_F(TileServiceTest, SetSlide_ClearsEncodedCache) {
+    EncodedTile tile;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 0, 0, tile), TileServiceStatus::Ok);
+    EXPECT_GT(service.GetEncodedCacheBytes(), 0u);
+
+    service.SetSlide(pipeline.MakeSlide("fedcba9876543210"));
+    EXPECT_EQ(service.GetEncodedCacheBytes(), 0u);
+    EXPECT_EQ(service.GetTile(SLIDE_ID, 10, 0, 0, tile), TileServiceStatus::NotFound);
+}
+
+TEST_F(TileServiceTest, GetTile_MissingPipelineTiles_RequestsAndWaits) {
+    {
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        pipeline.cached.clear();
+    }
+    EncodedTile tile;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 2, 1, tile), TileServiceStatus::Ok);
+    ASSERT_EQ(pipeline.requested.size(), 1u);
+    EXPECT_EQ(pipeline.requested[0], (TileKey{0, 2, 1}));
+}
+
+TEST_F(TileServiceTest, ClearSlide_WhileWaiting_ReturnsUnavailable) {
+    {
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        pipeline.cached.clear();
+        pipeline.holdRequests = true;
+    }
+    std::atomic<TileServiceStatus> status{TileServiceStatus::Ok};
+    std::thread request([&]() {
+        EncodedTile tile;
+        status = service.GetTile(SLIDE_ID, 10, 0, 0, tile);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto start = std::chrono::steady_clock::now();
+    service.ClearSlide();
+    request.join();
+    EXPECT_EQ(status.load(), TileServiceStatus::Unavailable);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+}
+
+#ifdef PATHVIEW_HAS_LIBJPEG
+
+TEST_F(TileServiceTest, GetTile_EdgeTile_DecodesToClippedSizeAndColor) {
+    EncodedTile tile;
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 3, 2, tile), TileServiceStatus::Ok);
+
+    jpeg_decompress_struct info;
+    jpeg_error_mgr error;
+    info.err = jpeg_std_error(&error);
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, tile.data->data(), static_cast<unsigned long>(tile.data->size()));
+    ASSERT_EQ(jpeg_read_header(&info, TRUE), JPEG_HEADER_OK);
+    jpeg_start_decompress(&info);
+    EXPECT_EQ(info.output_width, 1000u - 3 * 256);
+    EXPECT_EQ(info.output_height, 600u - 2 * 256);
+
+    std::vector<uint8_t> row(info.output_width * info.output_components);
+    JSAMPROW rowPointer = row.data();
+    jpeg_read_scanlines(&info, &rowPointer, 1);
+    EXPECT_NEAR(row[0], 0x20, 4);
+    EXPECT_NEAR(row[1], 0x40, 4);
+    EXPECT_NEAR(row[2], 0x60, 4);
+    jpeg_abort_decompress(&info);
+    jpeg_destroy_decompress(&info);
+}
+
+#endif  // PATHVIEW_HAS_LIBJPEG
+
+// ============================================================================
+// Region Render Tests
+// ============================================================================
+
+TEST_F(TileServiceTest, RenderRegion_ClipsToSlide) {
+    // 600 x 400 output at 2x from (-200, 0): the first 100 columns are off the slide
+    std::vector<uint32_t> pixels;
+    ASSERT_EQ(service.RenderRegion(-200.0, 0.0, 2.0, 600, 400, pixels), TileServiceStatus::Ok);
+    ASSERT_EQ(pixels.size(), 600u * 400u);
+    EXPECT_EQ(pixels[0], 0u);
+    EXPECT_EQ(pixels[99], 0u);
+    EXPECT_EQ(pixels[100], LEVEL0_COLOR);
+    EXPECT_EQ(pixels[299 * 600 + 599], LEVEL0_COLOR);  // Level 0 (998, 598)
+    EXPECT_EQ(pixels[300 * 600 + 100], 0u);             // Below the slide
+}
+
+TEST_F(TileServiceTest, RenderRegion_LargeOutput_ComposedInChunks) {
+    // Larger than one chunk each way, upsampled from level 0
+    const int32_t width = TileService::REGION_CHUNK_SIZE + 100;
+    const int32_t height = TileService::REGION_CHUNK_SIZE + 10;
+    std::vector<uint32_t> pixels;
+    ASSERT_EQ(service.RenderRegion(0.0, 0.0, 0.5, width, height, pixels), TileServiceStatus::Ok);
+    EXPECT_EQ(pixels.front(), LEVEL0_COLOR);
+    EXPECT_EQ(pixels.back(), LEVEL0_COLOR);
+    EXPECT_EQ(pixels[static_cast<size_t>(height / 2) * width + TileService::REGION_CHUNK_SIZE], LEVEL0_COLOR);
+
+    // Coarse downsamples come from level 1
+    pipeline.fetched.clear();
+    ASSERT_EQ(service.RenderRegion(0.0, 0.0, 8.0, 125, 75, pixels), TileServiceStatus::Ok);
+    EXPECT_EQ(pipeline.FetchedLevels(), std::set<int32_t>{1});
+    EXPECT_EQ(pixels[0], LEVEL1_COLOR);
+}
+
+TEST_F(TileServiceTest, RenderRegion_NoSlide_NotFound) {
+    std::vector<uint32_t> pixels;
+    EXPECT_EQ(service.RenderRegion(0.0, 0.0, 0.0, 10, 10, pixels), TileServiceStatus::NotFound);
+    service.ClearSlide();
+    EXPECT_EQ(service.RenderRegion(0.0, 0.0, 1.0, 10, 10, pixels), TileServiceStatus::NotFound);
+}
+
+// ============================================================================
+// IIIF Tests
+// ============================================================================
+
+TEST_F(TileServiceTest, GetIiifInfo_ListsScaleFactors) {
+    std::string json;
+    ASSERT_EQ(service.GetIiifInfo(SLIDE_ID, "http://host/iiif/" + SLIDE_ID, json), TileServiceStatus::Ok);
+    EXPECT_NE(json.find("\"@id\":\"http://host/iiif/" + SLIDE_ID + "\""), std::string::npos);
+    EXPECT_NE(json.find("\"width\":1000,\"height\":600"), std::string::npos);
+    EXPECT_NE(json.find("\"scaleFactors\":[1,2,4]"), std::string::npos);
+}
+
+TEST_F(TileServiceTest, GetIiifTile_MapsToDeepZoomGrid) {
+    EncodedTile iiif;
+    EncodedTile dz;
+    ASSERT_EQ(service.GetIiifTile(SLIDE_ID, 256, 0, 256, 256, 256, iiif), TileServiceStatus::Ok);
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 10, 1, 0, dz), TileServiceStatus::Ok);
+    EXPECT_EQ(iiif.etag, dz.etag);
+
+    // Scale factor 2, clipped at the right edge
+    ASSERT_EQ(service.GetIiifTile(SLIDE_ID, 512, 0, 488, 512, 244, iiif), TileServiceStatus::Ok);
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 9, 1, 0, dz), TileServiceStatus::Ok);
+    EXPECT_EQ(iiif.etag, dz.etag);
+
+    // Whole image at scale factor 4
+    ASSERT_EQ(service.GetIiifTile(SLIDE_ID, 0, 0, 0, 0, 250, iiif), TileServiceStatus::Ok);
+    ASSERT_EQ(service.GetTile(SLIDE_ID, 8, 0, 0, dz), TileServiceStatus::Ok);
+    EXPECT_EQ(iiif.etag, dz.etag);
+}
+
+TEST_F(TileServiceTest, GetIiifTile_OffGrid_NotFound) {
+    EncodedTile tile;
+    EXPECT_EQ(service.GetIiifTile(SLIDE_ID, 100, 0, 256, 256, 256, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetIiifTile(SLIDE_ID, 256, 0, 256, 256, 128, tile), TileServiceStatus::NotFound);
+    EXPECT_EQ(service.GetIiifTile(SLIDE_ID, 0, 0, 300, 256, 300, tile), TileServiceStatus::NotFound);
+}
@@ -0,0 +1,141 @@
+// TissueMap Unit Tests
+// Tests for sampling segmentation maps onto the label grid, the majority
+// pyramid and its level choice, sparse tiles and region queries, and the
+// serialized form used by the polygon cache
+
+#include <gtest/gtest.h>
+#include "TissueMap.h"
+#include <vector>
+
+namespace {
+
+// A tile's worth of source labels: class 1 with a class 2 block in the
+// lower right quarter
+std::vector<uint8_t> QuarteredLabels(int size) {
+    std::vector<uint8_t> labels(size_t(size) * size, 1);
+    for (int y = size / 2; y < size; ++y) {
+        for (int x = size / 2; x < size; ++x) {
+            labels[size_t(y) * size + x] = 2;
+        }
+    }
+    return labels;
+}
+
+}  // namespace
+
+TEST(TissueMapTest, AddRegion_SamplesNearestLabel) {
+    // 128 labels over 1024 slide px onto a grid of 4 px per label
+    TissueMap map(4.0, 0);
+    const std::vector<uint8_t> labels = QuarteredLabels(128);
+    map.AddRegion(Rect(2048, 1024, 1024, 1024), 128, 128, labels.data());
+    map.BuildLevels();
+
+    EXPECT_EQ(map.GetLabel(2050, 1030), 1);
+    EXPECT_EQ(map.GetLabel(2600, 1600), 2);
+    EXPECT_EQ(map.GetLabel(2559, 1600), 1);
+    EXPECT_EQ(map.GetLabel(3000, 1500), 1);
+    EXPECT_EQ(map.GetLabel(3071, 2047), 2);
+
+    // Outside the region, and off the slide
+    EXPECT_EQ(map.GetLabel(2040, 1500), 0);
+    EXPECT_EQ(map.GetLabel(3080, 1500), 0);
+    EXPECT_EQ(map.GetLabel(-10, -10), 0);
+}
+
+TEST(TissueMapTest, EmptyRegions_KeepNoTiles) {
+    TissueMap map(2.0, 0);
+    std::vector<uint8_t> empty(64 * 64, 0);
+    map.AddRegion(Rect(0, 0, 4096, 4096), 64, 64, empty.data());
+    map.BuildLevels();
+    EXPECT_TRUE(map.Empty());
+    EXPECT_EQ(map.GetLevelCount(), 1);
+    EXPECT_EQ(map.GetMemoryUsage(), 0u);
+
+    // Tissue only in one corner keeps only the tiles it touches
+    std::vector<uint8_t> corner(64 * 64, 0);
+    corner[0] = 3;
+    map.AddRegion(Rect(0, 0, 4096, 4096), 64, 64, corner.data());
+    map.BuildLevels();
+    EXPECT_EQ(map.GetLabel(10, 10), 3);
+
+    std::vector<TissueMap::TileCoord> tiles;
+    map.GetTilesInRegion(0, Rect(0, 0, 4096, 4096), tiles);
+    ASSERT_EQ(tiles.size(), 1u);
+    EXPECT_EQ(tiles[0].x, 0);
+    EXPECT_EQ(tiles[0].y, 0);
+    EXPECT_NE(map.GetTile(0, 0, 0), nullptr);
+    EXPECT_EQ(map.GetTile(0, 1, 0), nullptr);
+}
+
+TEST(TissueMapTest, BuildLevels_MajorityPyramidUntilOneTile) {
+    // 4 x 2 level-0 tiles of 1 px labels
+    TissueMap map(1.0, 0);
+    const int width = 4 * TissueMap::TILE_SIZE, height = 2 * TissueMap::TILE_SIZE;
+    std::vector<uint8_t> labels(size_t(width) * height, 1);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            // Checkerboard of 2 px cells in the right half: labels 2 and 0 tie
+            if (x >= width / 2 && ((x / 2 + y / 2) % 2 == 0)) {
+                labels[size_t(y) * width + x] = 2;
+            } else if (x >= width / 2) {
+                labels[size_t(y) * width + x] = 0;
+            }
+        }
+    }
+    map.AddRegion(Rect(0, 0, width, height), width, height, labels.data());
+    map.BuildLevels();
+
+    ASSERT_EQ(map.GetLevelCount(), 3);
+    EXPECT_DOUBLE_EQ(map.GetTexelSize(2), 4.0);
+
+    std::vector<TissueMap::TileCoord> tiles;
+    map.GetTilesInRegion(0, Rect(0, 0, width, height), tiles);
+    EXPECT_EQ(tiles.size(), 8u);
+    map.GetTilesInRegion(1, Rect(0, 0, width, height), tiles);
+    EXPECT_EQ(tiles.size(), 2u);
+    map.GetTilesInRegion(2, Rect(0, 0, width, height), tiles);
+    ASSERT_EQ(tiles.size(), 1u);
+
+    // Level 1 labels are 2x2 blocks: the checkerboard cells are whole
+    const uint8_t* right = map.GetTile(1, 1, 0);
+    ASSERT_NE(right, nullptr);
+    EXPECT_EQ(right[0], 2);
+    EXPECT_EQ(right[1], 0);
+    EXPECT_EQ(map.GetTile(1, 0, 0)[0], 1);
+
+    // Level 2 mixes two of each: tissue wins the tie
+    const uint8_t* top = map.GetTile(2, 0, 0);
+    ASSERT_NE(top, nullptr);
+    EXPECT_EQ(top[0], 1);
+    EXPECT_EQ(top[TissueMap::TILE_SIZE / 2], 2);
+
+    // Labels at most a screen pixel wide
+    EXPECT_EQ(map.ChooseLevel(1.0), 0);
+    EXPECT_EQ(map.ChooseLevel(0.5), 1);
+    EXPECT_EQ(map.ChooseLevel(0.3), 1);
+    EXPECT_EQ(map.ChooseLevel(0.01), 2);
+}
+
+TEST(TissueMapTest, Serialize_RoundTripsAndRejectsTruncation) {
+    TissueMap map(8.0, 255);
+    const std::vector<uint8_t> labels = QuarteredLabels(300);
+    map.AddRegion(Rect(0, 0, 2400, 2400), 300, 300, labels.data());
+    map.BuildLevels();
+    map.SetClassNames({{1, "Stroma"}, {2, "Tumor"}});
+
+    const std::vector<uint8_t> bytes = map.Serialize();
+    std::unique_ptr<TissueMap> copy = TissueMap::Deserialize(bytes.data(), bytes.size());
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->GetEmptyLabel(), 255);
+    EXPECT_EQ(copy->GetLevelCount(), map.GetLevelCount());
+    EXPECT_EQ(copy->GetTileCount(), map.GetTileCount());
+    EXPECT_EQ(copy->GetClassNames(), map.GetClassNames());
+    for (double y = 4; y < 2400; y += 97) {
+        for (double x = 4; x < 2400; x += 89) {
+            ASSERT_EQ(copy->GetLabel(x, y), map.GetLabel(x, y)) << x << ", " << y;
+        }
+    }
+
+    EXPECT_EQ(TissueMap::Deserialize(bytes.data(), bytes.size() - 1), nullptr);
+    EXPECT_EQ(TissueMap::Deserialize(bytes.data(), 5), nullptr);
+}
@@ -0,0 +1,119 @@
+// TissueMask Unit Tests
+// Tests for the Otsu threshold, telling glass from tissue on an overview,
+// growing the tissue, giving up on a single class, and the tissue map
+// overriding the overview within its extent
+
+#include <gtest/gtest.h>
+#include "TissueMask.h"
+#include "TissueMap.h"
+#include <vector>
+
+namespace {
+
+constexpr uint32_t GLASS = 0xFFF0EEF2;  // Opaque near-white
+constexpr uint32_t STAIN = 0xFFB0407A;  // Opaque purple
+
+// 100 x 50 overview of a 10000 x 5000 slide (100 px cells): glass with a
+// block of stain over cells [20, 40) x [10, 20)
+std::vector<uint32_t> BlockOverview() {
+    std::vector<uint32_t> pixels(100 * 50, GLASS);
+    for (int y = 10; y < 20; ++y) {
+        for (int x = 20; x < 40; ++x) {
+            pixels[size_t(y) * 100 + x] = STAIN;
+        }
+    }
+    return pixels;
+}
+
+}  // namespace
+
+TEST(TissueMaskTest, OtsuThreshold_SplitsTwoPeaks) {
+    std::array<uint64_t, 256> histogram{};
+    histogram[15] = 700;
+    histogram[18] = 100;
+    histogram[120] = 150;
+    histogram[140] = 50;
+    const int threshold = TissueMask::OtsuThreshold(histogram);
+    EXPECT_GT(threshold, 18);
+    EXPECT_LE(threshold, 120);
+}
+
+TEST(TissueMaskTest, FromOverview_SeparatesGlassFromTissue) {
+    const TissueMask mask = TissueMask::FromOverview(BlockOverview(), 100, 50, 10000, 5000);
+    ASSERT_TRUE(mask.IsValid());
+    EXPECT_EQ(mask.GetBackgroundColor(), GLASS);
+
+    // Inside the block, and in the ring one cell around it
+    EXPECT_FALSE(mask.IsBackground(Rect(2500, 1200, 512, 512)));
+    EXPECT_FALSE(mask.IsBackground(Rect(1920, 920, 50, 50)));
+    EXPECT_FALSE(mask.IsBackground(Rect(4020, 1500, 50, 50)));
+
+    // Two cells away, and far off
+    EXPECT_TRUE(mask.IsBackground(Rect(4120, 1500, 50, 50)));
+    EXPECT_TRUE(mask.IsBackground(Rect(6000, 3000, 512, 512)));
+    EXPECT_TRUE(mask.IsBackground(Rect(0, 0, 1800, 800)));
+
+    // A region reaching into the ring is not
+    EXPECT_FALSE(mask.IsBackground(Rect(0, 0, 2000, 950)));
+
+    // Off the slide nothing is known
+    EXPECT_FALSE(mask.IsBackground(Rect(-600, -600, 512, 512)));
+
+    // 22 x 12 grown tissue cells out of 5000
+    EXPECT_NEAR(mask.GetBackgroundFraction(), 1.0 - 22.0 * 12.0 / 5000.0, 1e-9);
+}
+
+TEST(TissueMaskTest, FromOverview_WithoutTwoClassesIsInvalid) {
+    // All glass with a little noise: no tissue to tell apart
+    std::vector<uint32_t> pixels(64 * 64, GLASS);
+    for (size_t i = 0; i < pixels.size(); i += 7) {
+        pixels[i] = 0xFFE8E6EA;
+    }
+    const TissueMask glass = TissueMask::FromOverview(pixels, 64, 64, 6400, 6400);
+    EXPECT_FALSE(glass.IsValid());
+    EXPECT_FALSE(glass.IsBackground(Rect(100, 100, 512, 512)));
+
+    // Transparent pixels are no data, not glass
+    std::vector<uint32_t> transparent = BlockOverview();
+    for (int x = 60; x < 100; ++x) {
+        for (int y = 0; y < 50; ++y) {
+            transparent[size_t(y) * 100 + x] = 0;
+        }
+    }
+    const TissueMask mask = TissueMask::FromOverview(transparent, 100, 50, 10000, 5000);
+    ASSERT_TRUE(mask.IsValid());
+    EXPECT_FALSE(mask.IsBackground(Rect(8000, 1000, 100, 100)));
+    EXPECT_TRUE(mask.IsBackground(Rect(5000, 1000, 100, 100)));
+
+    EXPECT_FALSE(TissueMask().IsValid());
+    EXPECT_FALSE(TissueMask::FromOverview({}, 0, 0, 100, 100).IsValid());
+}
+
+TEST(TissueMaskTest, ApplyTissueMap_DecidesWithinItsExtent) {
+    TissueMask mask = TissueMask::FromOverview(BlockOverview(), 100, 50, 10000, 5000);
+    ASSERT_TRUE(mask.IsValid());
+
+    // Segmentation over [0, 4096) x [0, 2048) at 4 px per label: tissue
+    // only in [3000, 3400) x [1200, 1600), the block's right part
+    const int width = 1024, height = 512;
+    std::vector<uint8_t> labels(size_t(width) * height, 0);
+    for (int y = 300; y < 400; ++y) {
+        for (int x = 750; x < 850; ++x) {
+            labels[size_t(y) * width + x] = 1;
+        }
+    }
+    TissueMap map(4.0, 0);
+    map.AddRegion(Rect(0, 0, 4096, 2048), width, height, labels.data());
+    map.BuildLevels();
+    mask.ApplyTissueMap(map);
+    ASSERT_TRUE(mask.IsValid());
+
+    // The map keeps the labelled tissue, and clears the rest of the block
+    // the overview saw within its tiles ([2048, 4096) x [1024, 2048))
+    EXPECT_FALSE(mask.IsBackground(Rect(3100, 1300, 100, 100)));
+    EXPECT_TRUE(mask.IsBackground(Rect(2300, 1300, 300, 300)));
+
+    // Outside the map's tiles the overview still decides
+    EXPECT_FALSE(mask.IsBackground(Rect(2500, 900, 100, 100)));
+    EXPECT_TRUE(mask.IsBackground(Rect(7000, 3000, 100, 100)));
+}
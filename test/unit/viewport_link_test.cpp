@@ -0,0 +1,56 @@
+// ViewportLink Unit Tests
+// Tests for a follower view tracking its leader through an affine
+// transform and zoom ratio
+
+#include <gtest/gtest.h>
+#include "ViewportLink.h"
+
+namespace {
+
+Vec2 Center(const Viewport& viewport) {
+    return viewport.ScreenToSlide(Vec2(viewport.GetWindowWidth() / 2.0, viewport.GetWindowHeight() / 2.0));
+}
+
+}  // namespace
+
+TEST(ViewportLinkTest, ZoomRatio_SameCenterHigherMagnification) {
+    Viewport leader(800, 600, 100000, 80000);
+    Viewport follower(800, 600, 100000, 80000);
+    leader.SetView(Vec2(30000.0, 20000.0), 0.1);
+
+    ViewportLink link;
+    link.SetZoomRatio(4.0);
+    link.Apply(leader, follower);
+
+    EXPECT_NEAR(follower.GetZoom(), 0.4, 1e-9);
+    EXPECT_NEAR(Center(follower).x, 30000.0, 1e-6);
+    EXPECT_NEAR(Center(follower).y, 20000.0, 1e-6);
+}
+
+TEST(ViewportLinkTest, AffineMapsCenterAndScale) {
+    Viewport leader(800, 600, 100000, 80000);
+    Viewport follower(800, 600, 200000, 160000);
+    leader.SetView(Vec2(10000.0, 5000.0), 0.2);
+
+    // Follower section scanned at twice the resolution, offset
+    ViewportLink link(2.0, 0.0, 0.0, 2.0, 1000.0, -500.0);
+    EXPECT_DOUBLE_EQ(link.GetScale(), 2.0);
+    link.Apply(leader, follower);
+
+    // Same field of view: half the zoom on twice the pixels
+    EXPECT_NEAR(follower.GetZoom(), 0.1, 1e-9);
+    EXPECT_NEAR(Center(follower).x, 21000.0, 1e-6);
+    EXPECT_NEAR(Center(follower).y, 9500.0, 1e-6);
+}
+
+TEST(ViewportLinkTest, SingularTransformLeavesFollower) {
+    Viewport leader(800, 600, 100000, 80000);
+    Viewport follower(800, 600, 100000, 80000);
+    leader.SetView(Vec2(30000.0, 20000.0), 0.5);
+    double zoom = follower.GetZoom();
+
+    ViewportLink link(1.0, 2.0, 2.0, 4.0, 0.0, 0.0);
+    EXPECT_FALSE(link.IsValid());
+    link.Apply(leader, follower);
+    EXPECT_DOUBLE_EQ(follower.GetZoom(), zoom);
+}
@@ -0,0 +1,76 @@
+// ViewportPlan Unit Tests
+// Tests for following an announced tour: waypoints reached by the view or
+// its move target, skipped waypoints, and views that match none
+
+#include <gtest/gtest.h>
+#include "ViewportPlan.h"
+
+namespace {
+
+// Three fields side by side at zoom 0.5 in an 800 x 600 window (1600 x
+// 1200 slide pixels each)
+ViewportPlan MakeTour() {
+    ViewportPlan plan;
+    plan.Set({{Vec2(800.0, 600.0), 0.5}, {Vec2(2400.0, 600.0), 0.5}, {Vec2(4000.0, 600.0), 0.5}});
+    return plan;
+}
+
+}  // namespace
+
+TEST(ViewportPlanTest, Empty_IsDone) {
+    ViewportPlan plan;
+    EXPECT_TRUE(plan.IsDone());
+    EXPECT_FALSE(plan.Update(Vec2(0.0, 0.0), 1.0, 800, 600));
+    EXPECT_TRUE(plan.GetUpcoming().empty());
+}
+
+TEST(ViewportPlanTest, Update_AdvancesPastTheWaypointReached) {
+    ViewportPlan plan = MakeTour();
+    EXPECT_EQ(plan.GetUpcoming().size(), 3u);
+
+    // Within a quarter of the view of the first waypoint
+    EXPECT_TRUE(plan.Update(Vec2(1100.0, 500.0), 0.52, 800, 600));
+    EXPECT_EQ(plan.GetNext(), 1u);
+    ASSERT_EQ(plan.GetUpcoming().size(), 2u);
+    EXPECT_DOUBLE_EQ(plan.GetUpcoming()[0].center.x, 2400.0);
+
+    // Staying there changes nothing
+    EXPECT_FALSE(plan.Update(Vec2(800.0, 600.0), 0.5, 800, 600));
+    EXPECT_EQ(plan.GetNext(), 1u);
+
+    EXPECT_TRUE(plan.Update(Vec2(2400.0, 600.0), 0.5, 800, 600));
+    EXPECT_TRUE(plan.Update(Vec2(4000.0, 600.0), 0.5, 800, 600));
+    EXPECT_TRUE(plan.IsDone());
+    EXPECT_TRUE(plan.GetUpcoming().empty());
+}
+
+TEST(ViewportPlanTest, Update_SkipsAhead) {
+    ViewportPlan plan = MakeTour();
+    EXPECT_TRUE(plan.Update(Vec2(4000.0, 600.0), 0.5, 800, 600));
+    EXPECT_TRUE(plan.IsDone());
+}
+
+TEST(ViewportPlanTest, Update_IgnoresViewsOffThePlan) {
+    ViewportPlan plan = MakeTour();
+
+    // Between two waypoints, and at the first one's center zoomed in
+    EXPECT_FALSE(plan.Update(Vec2(1600.0, 600.0), 0.5, 800, 600));
+    EXPECT_FALSE(plan.Update(Vec2(800.0, 600.0), 2.0, 800, 600));
+    EXPECT_EQ(plan.GetNext(), 0u);
+
+    // Waypoints already passed are not gone back to
+    plan.Update(Vec2(2400.0, 600.0), 0.5, 800, 600);
+    EXPECT_FALSE(plan.Update(Vec2(800.0, 600.0), 0.5, 800, 600));
+    EXPECT_EQ(plan.GetNext(), 2u);
+}
+
+TEST(ViewportPlanTest, Set_StartsOver) {
+    ViewportPlan plan = MakeTour();
+    plan.Update(Vec2(2400.0, 600.0), 0.5, 800, 600);
+    plan.Set({{Vec2(100.0, 100.0), 1.0}});
+    EXPECT_EQ(plan.GetNext(), 0u);
+    EXPECT_EQ(plan.GetUpcoming().size(), 1u);
+
+    plan.Clear();
+    EXPECT_TRUE(plan.IsDone());
+}
@@ -95,6 +95,48 @@ TEST_F(ViewportTest, SlideToScreen_ViewportPosition_MapsToOrigin) {
     ExpectVec2Near(result, Vec2(0, 0), 1.0);
 }
 
+TEST_F(ViewportTest, TransformToScreen_MatchesSlideToScreen) {
+    viewport->ZoomAtPoint(Vec2(300, 200), 2.5);
+
+    // 11 points: full SIMD steps plus a scalar tail
+    std::vector<Vec2> points;
+    std::vector<float> xs, ys, xy;
+    for (int i = 0; i < 11; ++i) {
+        points.emplace_back(1000.0 + i * 137.5, 2000.0 + i * 91.25);
+        xs.push_back(static_cast<float>(points.back().x));
+        ys.push_back(static_cast<float>(points.back().y));
+        xy.push_back(xs.back());
+        xy.push_back(ys.back());
+    }
+
+    std::vector<float> fromSplit(2 * points.size());
+    std::vector<float> fromPairs(2 * points.size());
+    std::vector<float> fromDoubles(2 * points.size());
+    viewport->TransformToScreen(xs.data(), ys.data(), points.size(), fromSplit.data());
+    viewport->TransformToScreen(xy.data(), points.size(), fromPairs.data());
+    viewport->TransformToScreen(points.data(), points.size(), fromDoubles.data());
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        Vec2 expected = viewport->SlideToScreen(points[i]);
+        ExpectVec2Near(Vec2(fromSplit[2 * i], fromSplit[2 * i + 1]), expected, 1e-2);
+        ExpectVec2Near(Vec2(fromPairs[2 * i], fromPairs[2 * i + 1]), expected, 1e-2);
+        ExpectVec2Near(Vec2(fromDoubles[2 * i], fromDoubles[2 * i + 1]), expected, 1e-3);
+    }
+}
+
+TEST_F(ViewportTest, TransformToScreen_OriginOffsetInPlace) {
+    viewport->ZoomAtPoint(Vec2(300, 200), 2.0);
+
+    // Chunk-relative coordinates, transformed in place
+    const double originX = 4096.0, originY = 2048.0;
+    std::vector<float> xy = {0.0f, 0.0f, 10.5f, 20.25f, 100.0f, 3.0f};
+    viewport->TransformToScreen(xy.data(), 3, xy.data(), originX, originY);
+
+    ExpectVec2Near(Vec2(xy[0], xy[1]), viewport->SlideToScreen(Vec2(originX, originY)), 1e-2);
+    ExpectVec2Near(Vec2(xy[2], xy[3]), viewport->SlideToScreen(Vec2(originX + 10.5, originY + 20.25)), 1e-2);
+    ExpectVec2Near(Vec2(xy[4], xy[5]), viewport->SlideToScreen(Vec2(originX + 100.0, originY + 3.0)), 1e-2);
+}
+
 // ============================================================================
 // Zoom Tests
 // ============================================================================
@@ -340,6 +382,39 @@ TEST_F(ViewportTest, GetVisibleRegion_SizeInverselyProportionalToZoom) {
     EXPECT_NEAR(width2, width1 / 2.0, width1 * 0.1);  // 10% tolerance
 }
 
+TEST_F(ViewportTest, GetTargetVisibleRegion_Idle_MatchesVisibleRegion) {
+    viewport->UpdateAnimation(SDL_GetTicks() + 1000.0);
+    ASSERT_FALSE(viewport->IsAnimating());
+
+    Rect visible = viewport->GetVisibleRegion();
+    Rect target = viewport->GetTargetVisibleRegion();
+
+    EXPECT_DOUBLE_EQ(target.x, visible.x);
+    EXPECT_DOUBLE_EQ(target.y, visible.y);
+    EXPECT_DOUBLE_EQ(target.width, visible.width);
+    EXPECT_DOUBLE_EQ(viewport->GetTargetZoom(), viewport->GetZoom());
+}
+
+TEST_F(ViewportTest, GetTargetVisibleRegion_SmoothZoom_ReportsDestination) {
+    viewport->UpdateAnimation(SDL_GetTicks() + 1000.0);
+    double startZoom = viewport->GetZoom();
+
+    viewport->ZoomAtPoint(Vec2(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2), 2.0, AnimationMode::SMOOTH);
+    ASSERT_TRUE(viewport->IsAnimating());
+
+    // Destination is known before the animation has moved the camera
+    EXPECT_NEAR(viewport->GetTargetZoom(), startZoom * 2.0, 1e-9);
+    Rect target = viewport->GetTargetVisibleRegion();
+    EXPECT_NEAR(target.width, WINDOW_WIDTH / (startZoom * 2.0), 1e-6);
+
+    // And matches where the animation actually ends up
+    viewport->UpdateAnimation(SDL_GetTicks() + 1000.0);
+    Rect visible = viewport->GetVisibleRegion();
+    EXPECT_NEAR(visible.x, target.x, 1e-6);
+    EXPECT_NEAR(visible.y, target.y, 1e-6);
+    EXPECT_NEAR(visible.width, target.width, 1e-6);
+}
+
 // ============================================================================
 // Window Resize Tests
 // ============================================================================
@@ -0,0 +1,126 @@
+// ViewportTrace Unit Tests
+// Tests for sample deduplication, time lookup and the binary file
+// round trip used by trace record/replay
+
+#include <gtest/gtest.h>
+#include "ViewportTrace.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+ViewportSample Sample(double timeMs, double x, double zoom = 1.0) {
+    return {timeMs, x, 0.0, zoom, 1280, 720};
+}
+
+class ViewportTraceFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = (fs::temp_directory_path() /
+                 ("pathview_trace_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + ".pvt")).string();
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    std::string path_;
+};
+
+}  // namespace
+
+// ============================================================================
+// Recording Tests
+// ============================================================================
+
+TEST(ViewportTraceTest, Append_UnchangedView_IsSkipped) {
+    ViewportTrace trace;
+
+    EXPECT_TRUE(trace.Append(Sample(0.0, 100.0)));
+    EXPECT_FALSE(trace.Append(Sample(16.0, 100.0)));
+    EXPECT_TRUE(trace.Append(Sample(32.0, 101.0)));
+
+    EXPECT_EQ(trace.GetSampleCount(), 2u);
+    EXPECT_DOUBLE_EQ(trace.GetDurationMs(), 32.0);
+}
+
+TEST(ViewportTraceTest, Append_WindowResize_IsKept) {
+    ViewportTrace trace;
+    ViewportSample resized = Sample(16.0, 100.0);
+    resized.windowWidth = 1920;
+
+    trace.Append(Sample(0.0, 100.0));
+
+    EXPECT_TRUE(trace.Append(resized));
+}
+
+TEST(ViewportTraceTest, Append_EarlierTime_IsClampedToLast) {
+    ViewportTrace trace;
+
+    trace.Append(Sample(50.0, 1.0));
+    trace.Append(Sample(40.0, 2.0));
+
+    EXPECT_DOUBLE_EQ(trace.GetSamples().back().timeMs, 50.0);
+}
+
+// ============================================================================
+// Lookup Tests
+// ============================================================================
+
+TEST(ViewportTraceTest, SampleIndexAt_ReturnsLatestAtOrBefore) {
+    ViewportTrace trace;
+    trace.Append(Sample(10.0, 1.0));
+    trace.Append(Sample(20.0, 2.0));
+    trace.Append(Sample(30.0, 3.0));
+
+    EXPECT_EQ(trace.SampleIndexAt(0.0), 0u);
+    EXPECT_EQ(trace.SampleIndexAt(10.0), 0u);
+    EXPECT_EQ(trace.SampleIndexAt(25.0), 1u);
+    EXPECT_EQ(trace.SampleIndexAt(30.0), 2u);
+    EXPECT_EQ(trace.SampleIndexAt(1000.0), 2u);
+}
+
+// ============================================================================
+// File Tests
+// ============================================================================
+
+TEST_F(ViewportTraceFileTest, SaveLoad_RoundTrips) {
+    ViewportTrace trace;
+    trace.Append(Sample(0.0, 12.5, 0.25));
+    trace.Append(Sample(16.667, 13.75, 0.5));
+
+    ASSERT_TRUE(trace.Save(path_));
+
+    ViewportTrace loaded;
+    ASSERT_TRUE(loaded.Load(path_));
+    ASSERT_EQ(loaded.GetSampleCount(), 2u);
+    EXPECT_NEAR(loaded.GetSamples()[1].timeMs, 16.667, 0.001);
+    EXPECT_DOUBLE_EQ(loaded.GetSamples()[1].x, 13.75);
+    EXPECT_DOUBLE_EQ(loaded.GetSamples()[1].zoom, 0.5);
+    EXPECT_EQ(loaded.GetSamples()[1].windowWidth, 1280);
+    EXPECT_EQ(loaded.GetSamples()[1].windowHeight, 720);
+}
+
+TEST_F(ViewportTraceFileTest, Load_ForeignFile_Fails) {
+    std::ofstream(path_) << "0 0 0 1 1280 720\n";
+
+    ViewportTrace trace;
+    EXPECT_FALSE(trace.Load(path_));
+}
+
+TEST_F(ViewportTraceFileTest, Load_Truncated_FailsAndKeepsSamples) {
+    ViewportTrace trace;
+    trace.Append(Sample(0.0, 1.0));
+    trace.Append(Sample(16.0, 2.0));
+    ASSERT_TRUE(trace.Save(path_));
+    fs::resize_file(path_, fs::file_size(path_) - 8);
+
+    ViewportTrace loaded;
+    loaded.Append(Sample(0.0, 99.0));
+
+    EXPECT_FALSE(loaded.Load(path_));
+    EXPECT_EQ(loaded.GetSampleCount(), 1u);
+}
@@ -0,0 +1,170 @@
+// WorkerPool Unit Tests
+// Tests for routing sessions by slide affinity and queue depth, workers
+// that are not ready, draining, and reading queue depths from /metrics
+
+#include <gtest/gtest.h>
+#include "WorkerPool.h"
+
+using pathview::pool::WorkerPool;
+
+namespace {
+
+// Two Ready workers, idle
+void AddWorkers(WorkerPool& pool) {
+    pool.SetLoad(pool.Add("http://a:9200", "http://a:9201"), 0.0);
+    pool.SetLoad(pool.Add("http://b:9200", "http://b:9201"), 0.0);
+}
+
+}  // namespace
+
+// ============================================================================
+// Routing
+// ============================================================================
+
+TEST(WorkerPoolTest, NoReadyWorker_RoutesNothing) {
+    WorkerPool pool;
+    WorkerPool::Route route;
+    EXPECT_FALSE(pool.RouteSession("slide", route));
+
+    // Added but never scraped
+    pool.Add("http://a:9200", "http://a:9201");
+    EXPECT_FALSE(pool.RouteSession("slide", route));
+}
+
+TEST(WorkerPoolTest, RouteSession_PrefersTheWorkerWithTheSlideWarm) {
+    WorkerPool pool;
+    AddWorkers(pool);
+    WorkerPool::Route first;
+    ASSERT_TRUE(pool.RouteSession("slide-a", first));
+    EXPECT_FALSE(first.affinity);
+    EXPECT_EQ(first.worker, "w1");
+    EXPECT_EQ(first.mcpUrl, "http://a:9200");
+
+    // A different slide goes to the idle worker, the same one back
+    WorkerPool::Route other;
+    ASSERT_TRUE(pool.RouteSession("slide-b", other));
+    EXPECT_EQ(other.worker, "w2");
+
+    WorkerPool::Route again;
+    ASSERT_TRUE(pool.RouteSession("slide-a", again));
+    EXPECT_EQ(again.worker, "w1");
+    EXPECT_TRUE(again.affinity);
+    EXPECT_NE(again.session, first.session);
+}
+
+TEST(WorkerPoolTest, RouteSession_LeavesAWarmWorkerBusierThanTheSlack) {
+    WorkerPool pool(4.0);
+    AddWorkers(pool);
+    WorkerPool::Route route;
+    ASSERT_TRUE(pool.RouteSession("slide", route));
+    ASSERT_EQ(route.worker, "w1");
+
+    pool.SetLoad("w1", 3.0);  // 3 + 1 session: within 4 of idle w2
+    ASSERT_TRUE(pool.RouteSession("slide", route));
+    EXPECT_EQ(route.worker, "w1");
+
+    pool.SetLoad("w1", 10.0);
+    ASSERT_TRUE(pool.RouteSession("slide", route));
+    EXPECT_EQ(route.worker, "w2");
+    EXPECT_FALSE(route.affinity);
+}
+
+TEST(WorkerPoolTest, RouteSession_CountsSessionsBeforeTheNextScrape) {
+    WorkerPool pool(0.0);
+    AddWorkers(pool);
+    WorkerPool::Route route;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(pool.RouteSession("slide-" + std::to_string(i), route));
+    }
+    for (const WorkerPool::Worker& worker : pool.GetWorkers()) {
+        EXPECT_EQ(worker.sessions, 3u);
+        EXPECT_LE(worker.hotSlides.size(), WorkerPool::MAX_HOT_SLIDES);
+    }
+
+    EXPECT_TRUE(pool.EndSession(route.session));
+    EXPECT_FALSE(pool.EndSession(route.session));
+    EXPECT_EQ(pool.GetSessionCount(), 5u);
+}
+
+TEST(WorkerPoolTest, Unreachable_TakesNoSessionsUntilScraped) {
+    WorkerPool pool;
+    AddWorkers(pool);
+    pool.SetUnreachable("w1");
+    WorkerPool::Route route;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(pool.RouteSession("slide", route));
+        EXPECT_EQ(route.worker, "w2");
+    }
+    pool.SetLoad("w1", 0.0);
+    ASSERT_TRUE(pool.RouteSession("other", route));
+    EXPECT_EQ(route.worker, "w1");
+}
+
+// ============================================================================
+// Draining
+// ============================================================================
+
+TEST(WorkerPoolTest, Drain_StopsOnceSessionsEnd) {
+    WorkerPool pool;
+    AddWorkers(pool);
+    WorkerPool::Clock::time_point now = WorkerPool::Clock::now();
+    WorkerPool::Route route;
+    ASSERT_TRUE(pool.RouteSession("slide", route));
+    ASSERT_EQ(route.worker, "w1");
+
+    EXPECT_TRUE(pool.Drain("w1", now));
+    EXPECT_FALSE(pool.Drain("w9", now));
+
+    // New sessions, even for its warm slide, go elsewhere; a scrape does
+    // not make it Ready again
+    pool.SetLoad("w1", 0.0);
+    WorkerPool::Route next;
+    ASSERT_TRUE(pool.RouteSession("slide", next));
+    EXPECT_EQ(next.worker, "w2");
+
+    EXPECT_TRUE(pool.TakeDrained(now, std::chrono::seconds(60)).empty());
+    pool.EndSession(route.session);
+    std::vector<WorkerPool::Worker> drained = pool.TakeDrained(now, std::chrono::seconds(60));
+    ASSERT_EQ(drained.size(), 1u);
+    EXPECT_EQ(drained[0].id, "w1");
+    EXPECT_EQ(pool.GetWorkers()[0].state, WorkerPool::State::Stopped);
+    EXPECT_FALSE(pool.Drain("w1", now));
+}
+
+TEST(WorkerPoolTest, Drain_TimesOutWithSessionsLeft) {
+    WorkerPool pool;
+    AddWorkers(pool);
+    WorkerPool::Clock::time_point now = WorkerPool::Clock::now();
+    WorkerPool::Route route;
+    ASSERT_TRUE(pool.RouteSession("slide", route));
+    pool.DrainAll(now);
+    EXPECT_FALSE(pool.AllStopped());
+    EXPECT_FALSE(pool.RouteSession("slide", route));
+
+    EXPECT_EQ(pool.TakeDrained(now, std::chrono::seconds(60)).size(), 1u);  // The idle one
+    EXPECT_EQ(pool.TakeDrained(now + std::chrono::seconds(60), std::chrono::seconds(60)).size(), 1u);
+    EXPECT_TRUE(pool.AllStopped());
+    EXPECT_EQ(pool.GetSessionCount(), 0u);
+    EXPECT_FALSE(pool.EndSession(route.session));
+}
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+TEST(WorkerPoolTest, SumMetric_AddsEveryLabel) {
+    const std::string text =
+        "# HELP pathview_ipc_queued_requests IPC requests received, not yet handled\n"
+        "# TYPE pathview_ipc_queued_requests gauge\n"
+        "pathview_ipc_queued_requests 3\n"
+        "pathview_ipc_queued_requests_total 100\n"
+        "pathview_tile_queue_depth{priority=\"visible\"} 40\n"
+        "pathview_tile_queue_depth{priority=\"adjacent\"} 24.5\n";
+    bool found = false;
+    EXPECT_DOUBLE_EQ(WorkerPool::SumMetric(text, "pathview_ipc_queued_requests", found), 3.0);
+    EXPECT_TRUE(found);
+    EXPECT_DOUBLE_EQ(WorkerPool::SumMetric(text, "pathview_tile_queue_depth", found), 64.5);
+    EXPECT_TRUE(found);
+    EXPECT_DOUBLE_EQ(WorkerPool::SumMetric(text, "pathview_frame_seconds", found), 0.0);
+    EXPECT_FALSE(found);
+}
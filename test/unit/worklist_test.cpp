@@ -0,0 +1,45 @@
+// Worklist Unit Tests
+// Tests for parsing a case list (comments, blank lines, polygon columns)
+// and stepping through it
+
+#include <gtest/gtest.h>
+#include "Worklist.h"
+
+TEST(WorklistTest, Parse_SkipsCommentsAndReadsPolygonColumn) {
+    std::vector<WorklistEntry> entries = Worklist::Parse(
+        "# case 42\n"
+        "/slides/a.svs\n"
+        "\n"
+        "  /slides/b.svs\t/cells/b.pb  \r\n");
+
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].slidePath, "/slides/a.svs");
+    EXPECT_TRUE(entries[0].polygonPath.empty());
+    EXPECT_EQ(entries[1].slidePath, "/slides/b.svs");
+    EXPECT_EQ(entries[1].polygonPath, "/cells/b.pb");
+}
+
+TEST(WorklistTest, StepsThroughEntries) {
+    Worklist worklist;
+    worklist.SetEntries({{"a.svs", ""}, {"b.svs", ""}, {"c.svs", ""}});
+
+    // Nothing open yet: the first entry comes next
+    EXPECT_EQ(worklist.GetCurrent(), nullptr);
+    EXPECT_EQ(worklist.GetNextIndex(), 0u);
+    EXPECT_EQ(worklist.GetPreviousIndex(), Worklist::NO_ENTRY);
+
+    ASSERT_TRUE(worklist.Select(1));
+    EXPECT_EQ(worklist.GetCurrent()->slidePath, "b.svs");
+    EXPECT_EQ(worklist.GetNextIndex(), 2u);
+    EXPECT_EQ(worklist.GetPreviousIndex(), 0u);
+
+    ASSERT_TRUE(worklist.Select(2));
+    EXPECT_EQ(worklist.GetNextIndex(), Worklist::NO_ENTRY);
+
+    EXPECT_FALSE(worklist.Select(3));
+    EXPECT_EQ(worklist.GetIndex(), 2u);
+
+    // New entries start over
+    worklist.SetEntries({{"d.svs", ""}});
+    EXPECT_EQ(worklist.GetIndex(), Worklist::NO_ENTRY);
+}
@@ -0,0 +1,461 @@
+// ZarrPyramid Unit Tests
+// Tests for OME-Zarr group and array metadata (Zarr v2 and v3), chunk key
+// layouts, chunk codecs, fill values, axis order and channel reads. Each
+// test writes its own small image to a temp directory.
+
+#include <gtest/gtest.h>
+#include "ZarrPyramid.h"
+#include "json.hpp"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#ifdef PATHVIEW_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// Sample at (channel, x, y) of a level, distinct everywhere
+uint16_t SampleAt(int64_t channel, int64_t x, int64_t y) {
+    return static_cast<uint16_t>(channel * 1000 + y * 40 + x);
+}
+
+// One array: its layout and how its chunks are stored
+struct TestArray {
+    std::vector<int64_t> shape;
+    std::vector<int64_t> chunks;
+    std::string axes = "cyx";  // Which of c, y, x (or t, z) each dimension is
+    uint32_t bytes = 2;
+    bool bigEndian = false;
+    std::string codec;          // "", "zlib", "gzip", "zstd"
+    std::string keyPrefix;      // "c/" for v3 default keys
+    char separator = '.';
+    int64_t scale = 1;          // Level downsample: sample (x, y) is SampleAt(c, x * scale, y * scale)
+    std::vector<std::vector<int64_t>> skipChunks;  // Not written (fill value)
+};
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& raw, const std::string& codec) {
+    if (codec == "zlib") {
+        uLongf size = compressBound(static_cast<uLong>(raw.size()));
+        std::vector<uint8_t> out(size);
+        compress(out.data(), &size, raw.data(), static_cast<uLong>(raw.size()));
+        out.resize(size);
+        return out;
+    }
+    if (codec == "gzip") {
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::vector<uint8_t> out(deflateBound(&stream, static_cast<uLong>(raw.size())) + 32);
+        stream.next_in = const_cast<Bytef*>(raw.data());
+        stream.avail_in = static_cast<uInt>(raw.size());
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+#ifdef PATHVIEW_HAS_ZSTD
+    if (codec == "zstd") {
+        std::vector<uint8_t> out(ZSTD_compressBound(raw.size()));
+        out.resize(ZSTD_compress(out.data(), out.size(), raw.data(), raw.size(), 3));
+        return out;
+    }
+#endif
+    return raw;
+}
+
+// Write every chunk of an array (edge chunks padded to the full chunk shape)
+void WriteChunks(const fs::path& directory, const TestArray& array) {
+    const size_t dimensions = array.shape.size();
+    std::vector<int64_t> grid(dimensions);
+    for (size_t i = 0; i < dimensions; ++i) {
+        grid[i] = (array.shape[i] + array.chunks[i] - 1) / array.chunks[i];
+    }
+    std::vector<int64_t> chunk(dimensions, 0);
+    for (;;) {
+        if (std::find(array.skipChunks.begin(), array.skipChunks.end(), chunk) == array.skipChunks.end()) {
+            std::vector<uint8_t> raw;
+            std::vector<int64_t> element(dimensions, 0);
+            for (;;) {
+                int64_t c = 0, x = 0, y = 0;
+                bool inside = true;
+                for (size_t i = 0; i < dimensions; ++i) {
+                    const int64_t position = chunk[i] * array.chunks[i] + element[i];
+                    inside = inside && position < array.shape[i];
+                    if (array.axes[i] == 'c') c = position;
+                    if (array.axes[i] == 'x') x = position;
+                    if (array.axes[i] == 'y') y = position;
+                }
+                const uint16_t value = inside ? SampleAt(c, x * array.scale, y * array.scale) : 0;
+                if (array.bytes == 1) {
+                    raw.push_back(static_cast<uint8_t>(value));
+                } else if (array.bigEndian) {
+                    raw.push_back(static_cast<uint8_t>(value >> 8));
+                    raw.push_back(static_cast<uint8_t>(value));
+                } else {
+                    raw.push_back(static_cast<uint8_t>(value));
+                    raw.push_back(static_cast<uint8_t>(value >> 8));
+                }
+                size_t i = dimensions;
+                while (i > 0 && ++element[i - 1] == array.chunks[i - 1]) {
+                    element[--i] = 0;
+                }
+                if (i == 0) {
+                    break;
+                }
+            }
+
+            std::string key = array.keyPrefix;
+            for (size_t i = 0; i < dimensions; ++i) {
+                key += (i > 0 ? std::string(1, array.separator) : std::string()) + std::to_string(chunk[i]);
+            }
+            fs::path path = directory / key;
+            fs::create_directories(path.parent_path());
+            std::vector<uint8_t> stored = Compress(raw, array.codec);
+            std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(stored.data()),
+                                                        static_cast<std::streamsize>(stored.size()));
+        }
+        size_t i = dimensions;
+        while (i > 0 && ++chunk[i - 1] == grid[i - 1]) {
+            chunk[--i] = 0;
+        }
+        if (i == 0) {
+            return;
+        }
+    }
+}
+
+void WriteJson(const fs::path& path, const json& value) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << value.dump(2);
+}
+
+json Axes(const std::string& names) {
+    json axes = json::array();
+    for (char name : names) {
+        if (name == 'c') {
+            axes.push_back({{"name", "c"}, {"type", "channel"}});
+        } else if (name == 'x' || name == 'y') {
+            axes.push_back({{"name", std::string(1, name)}, {"type", "space"}, {"unit", "micrometer"}});
+        } else {
+            axes.push_back({{"name", std::string(1, name)}, {"type", name == 't' ? "time" : "space"}});
+        }
+    }
+    return axes;
+}
+
+}  // namespace
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class ZarrPyramidTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        root = fs::temp_directory_path() / (std::string("pathview_zarr_") + info->name() + ".zarr");
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    // Two channels of 40x24 in 16x16 chunks, plus a 20x12 level
+    static std::vector<TestArray> TwoLevels() {
+        TestArray level0;
+        level0.shape = {2, 24, 40};
+        level0.chunks = {1, 16, 16};
+        TestArray level1 = level0;
+        level1.shape = {2, 12, 20};
+        level1.scale = 2;
+        return {level0, level1};
+    }
+
+    json Multiscales(const std::vector<TestArray>& levels) {
+        json datasets = json::array();
+        for (size_t i = 0; i < levels.size(); ++i) {
+            json scale = json::array();
+            for (char name : levels[i].axes) {
+                scale.push_back(name == 'x' || name == 'y' ? 0.25 * levels[i].scale : 1.0);
+            }
+            datasets.push_back({{"path", std::to_string(i)},
+                                {"coordinateTransformations", {{{"type", "scale"}, {"scale", scale}}}}});
+        }
+        return json::array({{{"version", "0.4"}, {"axes", Axes(levels[0].axes)}, {"datasets", datasets}}});
+    }
+
+    static json Omero() {
+        return {{"channels", {{{"label", "DAPI"}, {"color", "0000FF"}}, {{"label", "CD8"}, {"color", "00FF00"}}}}};
+    }
+
+    // Zarr v2: .zattrs / .zarray
+    void WriteV2(const fs::path& group, const std::vector<TestArray>& levels) {
+        WriteJson(group / ".zgroup", {{"zarr_format", 2}});
+        WriteJson(group / ".zattrs", {{"multiscales", Multiscales(levels)}, {"omero", Omero()}});
+        for (size_t i = 0; i < levels.size(); ++i) {
+            const TestArray& array = levels[i];
+            json compressor = array.codec.empty() ? json(nullptr) : json({{"id", array.codec}});
+            std::string dtype = std::string(array.bigEndian ? ">" : "<") + "u" + std::to_string(array.bytes);
+            json metadata = {{"zarr_format", 2}, {"shape", array.shape}, {"chunks", array.chunks},
+                             {"dtype", dtype}, {"compressor", compressor}, {"fill_value", 7},
+                             {"order", "C"}, {"filters", nullptr}};
+            if (array.separator == '/') {
+                metadata["dimension_separator"] = "/";
+            }
+            WriteJson(group / std::to_string(i) / ".zarray", metadata);
+            WriteChunks(group / std::to_string(i), array);
+        }
+    }
+
+    // Zarr v3 (NGFF 0.5): zarr.json with the metadata under "ome"
+    void WriteV3(const fs::path& group, std::vector<TestArray> levels, const json& extraCodec = json()) {
+        WriteJson(group / "zarr.json",
+                  {{"zarr_format", 3}, {"node_type", "group"},
+                   {"attributes", {{"ome", {{"version", "0.5"}, {"multiscales", Multiscales(levels)},
+                                            {"omero", Omero()}}}}}});
+        for (size_t i = 0; i < levels.size(); ++i) {
+            TestArray& array = levels[i];
+            array.keyPrefix = "c/";
+            array.separator = '/';
+            json codecs = json::array({{{"name", "bytes"}, {"configuration", {{"endian", "little"}}}}});
+            if (!array.codec.empty()) {
+                codecs.push_back({{"name", array.codec}, {"configuration", json::object()}});
+            }
+            if (!extraCodec.is_null()) {
+                codecs.push_back(extraCodec);
+            }
+            json metadata = {{"zarr_format", 3}, {"node_type", "array"}, {"shape", array.shape},
+                             {"data_type", array.bytes == 1 ? "uint8" : "uint16"},
+                             {"chunk_grid", {{"name", "regular"}, {"configuration", {{"chunk_shape", array.chunks}}}}},
+                             {"chunk_key_encoding", {{"name", "default"}, {"configuration", {{"separator", "/"}}}}},
+                             {"fill_value", 7}, {"codecs", codecs}};
+            WriteJson(group / std::to_string(i) / "zarr.json", metadata);
+            WriteChunks(group / std::to_string(i), array);
+        }
+    }
+
+    // Every sample of a channel's level against SampleAt
+    static void ExpectChannel(const ZarrPyramid& zarr, int32_t level, size_t channel, int64_t scale = 1) {
+        const LevelDimensions dims = zarr.GetLevels()[level];
+        std::vector<uint16_t> samples(static_cast<size_t>(dims.width * dims.height));
+        ASSERT_TRUE(zarr.ReadChannelRegion(level, channel, 0, 0, dims.width, dims.height, samples.data()));
+        for (int64_t y = 0; y < dims.height; ++y) {
+            for (int64_t x = 0; x < dims.width; ++x) {
+                ASSERT_EQ(samples[y * dims.width + x], SampleAt(channel, x * scale, y * scale))
+                    << "level " << level << " channel " << channel << " at " << x << "," << y;
+            }
+        }
+    }
+};
+
+// ============================================================================
+// Metadata Tests
+// ============================================================================
+
+TEST_F(ZarrPyramidTest, IsZarrPath_GroupDirectoryOrMetadataFile) {
+    WriteV2(root, TwoLevels());
+    EXPECT_TRUE(ZarrPyramid::IsZarrPath(root.string()));
+    EXPECT_TRUE(ZarrPyramid::IsZarrPath((root / ".zattrs").string()));
+    EXPECT_FALSE(ZarrPyramid::IsZarrPath((root / "0" / "0.0.0").string()));
+    EXPECT_FALSE(ZarrPyramid::IsZarrPath(fs::temp_directory_path().string()));
+}
+
+TEST_F(ZarrPyramidTest, Open_V2_ReadsLevelsChannelsAndPixelSize) {
+    WriteV2(root, TwoLevels());
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    EXPECT_EQ(zarr.GetZarrFormat(), 2);
+    EXPECT_STREQ(zarr.GetCodecName(), "none");
+    EXPECT_EQ(zarr.GetMetadataPath(), (root / ".zattrs").string());
+
+    auto levels = zarr.GetLevels();
+    ASSERT_EQ(levels.size(), 2u);
+    EXPECT_EQ(levels[0].width, 40);
+    EXPECT_EQ(levels[0].height, 24);
+    EXPECT_EQ(levels[1].width, 20);
+    EXPECT_EQ(zarr.GetChunkSize(0).width, 16);
+    EXPECT_EQ(zarr.GetChunkSize(0).height, 16);
+
+    ASSERT_EQ(zarr.GetChannelCount(), 2u);
+    EXPECT_EQ(zarr.GetChannelName(0), "DAPI");
+    EXPECT_EQ(zarr.GetChannelName(1), "CD8");
+    EXPECT_EQ(zarr.GetChannelColor(0), 0x0000FFu);
+    EXPECT_EQ(zarr.GetChannelColor(1), 0x00FF00u);
+    EXPECT_EQ(zarr.GetChannelBits(0), 16u);
+    EXPECT_DOUBLE_EQ(zarr.GetPixelSizeX(), 0.25);
+    EXPECT_DOUBLE_EQ(zarr.GetPixelSizeY(), 0.25);
+}
+
+TEST_F(ZarrPyramidTest, Open_NoMultiscales_IsNotOpen) {
+    WriteJson(root / ".zattrs", {{"something", 1}});
+    ZarrPyramid zarr(root.string());
+    EXPECT_FALSE(zarr.IsOpen());
+    EXPECT_FALSE(zarr.GetError().empty());
+}
+
+TEST_F(ZarrPyramidTest, Open_Bioformats2RawContainer_OpensFirstImage) {
+    WriteJson(root / ".zattrs", {{"bioformats2raw.layout", 3}});
+    WriteV2(root / "0", TwoLevels());
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    EXPECT_EQ(zarr.GetLevels().size(), 2u);
+}
+
+TEST_F(ZarrPyramidTest, Open_ShardedV3_IsRefused) {
+    WriteV3(root, TwoLevels(), {{"name", "sharding_indexed"}, {"configuration", json::object()}});
+    ZarrPyramid zarr(root.string());
+    EXPECT_FALSE(zarr.IsOpen());
+    EXPECT_NE(zarr.GetError().find("sharding_indexed"), std::string::npos);
+}
+
+TEST_F(ZarrPyramidTest, Open_WrongMetadataTypes_IsNotOpen) {
+    WriteJson(root / ".zattrs", {{"multiscales", {{{"datasets", {{{"path", "0"}}}}}}}});
+    WriteJson(root / "0" / ".zarray", {{"shape", "big"}, {"chunks", {1, 2}}, {"dtype", 5}});
+    ZarrPyramid zarr(root.string());
+    EXPECT_FALSE(zarr.IsOpen());
+}
+
+// ============================================================================
+// Chunk Read Tests
+// ============================================================================
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_V2Uncompressed_AcrossChunksAndLevels) {
+    WriteV2(root, TwoLevels());
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    ExpectChannel(zarr, 0, 0);
+    ExpectChannel(zarr, 0, 1);
+    ExpectChannel(zarr, 1, 1, 2);
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_V2ZlibNestedKeys_Decodes) {
+    auto levels = TwoLevels();
+    for (TestArray& array : levels) {
+        array.codec = "zlib";
+        array.separator = '/';
+    }
+    WriteV2(root, levels);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    EXPECT_STREQ(zarr.GetCodecName(), "zlib");
+    ExpectChannel(zarr, 0, 1);
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_V3Gzip_DefaultChunkKeys) {
+    auto levels = TwoLevels();
+    for (TestArray& array : levels) {
+        array.codec = "gzip";
+    }
+    WriteV3(root, levels);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    EXPECT_EQ(zarr.GetZarrFormat(), 3);
+    EXPECT_EQ(zarr.GetChannelName(1), "CD8");
+    ExpectChannel(zarr, 0, 0);
+    ExpectChannel(zarr, 1, 1, 2);
+}
+
+#ifdef PATHVIEW_HAS_ZSTD
+TEST_F(ZarrPyramidTest, ReadChannelRegion_V3Zstd_Decodes) {
+    auto levels = TwoLevels();
+    for (TestArray& array : levels) {
+        array.codec = "zstd";
+    }
+    WriteV3(root, levels);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    ExpectChannel(zarr, 0, 1);
+}
+#endif
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_BigEndian8And16Bit_Decode) {
+    auto levels = TwoLevels();
+    levels.resize(1);
+    levels[0].bigEndian = true;
+    WriteV2(root, levels);
+    ZarrPyramid big(root.string());
+    ASSERT_TRUE(big.IsOpen()) << big.GetError();
+    ExpectChannel(big, 0, 1);
+
+    fs::remove_all(root);
+    levels[0].bigEndian = false;
+    levels[0].bytes = 1;
+    levels[0].shape = {2, 5, 6};  // Samples below 256
+    WriteV2(root, levels);
+    ZarrPyramid small(root.string());
+    ASSERT_TRUE(small.IsOpen()) << small.GetError();
+    EXPECT_EQ(small.GetChannelBits(0), 8u);
+    std::vector<uint16_t> samples(6 * 5);
+    ASSERT_TRUE(small.ReadChannelRegion(0, 0, 0, 0, 6, 5, samples.data()));
+    EXPECT_EQ(samples[4 * 6 + 5], SampleAt(0, 5, 4));
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_MissingChunk_ReadsFillValue) {
+    auto levels = TwoLevels();
+    levels[0].skipChunks = {{0, 1, 2}};
+    WriteV2(root, levels);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    std::vector<uint16_t> samples(40 * 24);
+    ASSERT_TRUE(zarr.ReadChannelRegion(0, 0, 0, 0, 40, 24, samples.data()));
+    EXPECT_EQ(samples[20 * 40 + 35], 7);  // Chunk (row 1, column 2)
+    EXPECT_EQ(samples[20 * 40 + 20], SampleAt(0, 20, 20));
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_OutsideLevel_IsZero) {
+    WriteV2(root, TwoLevels());
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    std::vector<uint16_t> samples(8 * 8, 1);
+    ASSERT_TRUE(zarr.ReadChannelRegion(0, 0, 36, 20, 8, 8, samples.data()));
+    EXPECT_EQ(samples[0], SampleAt(0, 36, 20));
+    EXPECT_EQ(samples[7], 0);
+    EXPECT_EQ(samples[7 * 8], 0);
+    EXPECT_FALSE(zarr.ReadChannelRegion(2, 0, 0, 0, 8, 8, samples.data()));
+    EXPECT_FALSE(zarr.ReadChannelRegion(0, 2, 0, 0, 8, 8, samples.data()));
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_ChunkOfAllChannels_DecodedOnce) {
+    auto levels = TwoLevels();
+    levels.resize(1);
+    levels[0].chunks = {2, 16, 16};
+    WriteV2(root, levels);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    ExpectChannel(zarr, 0, 0);
+    ExpectChannel(zarr, 0, 1);
+    EXPECT_EQ(zarr.GetChunkReadCount(), 6u);  // 3 x 2 chunks, each read once
+}
+
+TEST_F(ZarrPyramidTest, ReadChannelRegion_UnnamedFiveDimensionalAxes_FirstPlane) {
+    // NGFF 0.1: no axes, arrays are (t, c, z, y, x)
+    TestArray array;
+    array.shape = {2, 2, 3, 24, 40};
+    array.chunks = {1, 1, 1, 16, 16};
+    array.axes = "tczyx";
+    WriteV2(root, {array});
+    json zattrs;
+    zattrs["multiscales"] = json::array({{{"version", "0.1"}, {"datasets", {{{"path", "0"}}}}}});
+    WriteJson(root / ".zattrs", zattrs);
+    ZarrPyramid zarr(root.string());
+    ASSERT_TRUE(zarr.IsOpen()) << zarr.GetError();
+    ASSERT_EQ(zarr.GetChannelCount(), 2u);
+    EXPECT_EQ(zarr.GetChannelName(1), "Channel 1");
+    EXPECT_EQ(zarr.GetChannelColor(1), ZarrPyramid::NO_COLOR);
+    EXPECT_EQ(zarr.GetPixelSizeX(), 0.0);
+    ExpectChannel(zarr, 0, 1);
+}
@@ -0,0 +1,121 @@
+// pathview-convert: rewrites any slide PathView opens as a tiled pyramidal
+// BigTIFF laid out for the viewer (see SlideTranscoder), so that it opens
+// on the direct TIFF path with a stored level at every zoom step.
+
+#include "SlideLoader.h"
+#include "SlideMetadata.h"
+#include "SlideTranscoder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct Options {
+    std::string inputPath;
+    std::string outputPath;
+    int quality = 90;
+    size_t threads = 0;
+    bool quiet = false;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " <slide> <output.tiff> [options]\n"
+              << "\nOptions:\n"
+              << "  --quality N          JPEG quality, 1-100 (default: 90)\n"
+              << "  --threads N          Read and encode threads (default: auto)\n"
+              << "  --quiet              No progress output\n"
+              << "  --help               Show this help message\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--quality" && i + 1 < argc) {
+            options.quality = std::clamp(std::atoi(argv[++i]), 1, 100);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else if (options.inputPath.empty()) {
+            options.inputPath = arg;
+        } else if (options.outputPath.empty()) {
+            options.outputPath = arg;
+        } else {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.inputPath.empty() && !options.outputPath.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (!SlideTranscoder::IsAvailable()) {
+        std::cerr << "This build has no JPEG encoder (libjpeg-turbo not found)" << std::endl;
+        return 1;
+    }
+
+    SlideLoader loader(options.inputPath);
+    if (!loader.IsValid()) {
+        std::cerr << "Failed to open slide: " << loader.GetError() << std::endl;
+        return 1;
+    }
+    // Level 0 of a JPEG TIFF decodes without OpenSlide's cache in the way
+    loader.SetDirectTiffRead(true);
+
+    SlideTranscoder::Options convert;
+    convert.quality = options.quality;
+    convert.threads = options.threads;
+    if (auto metadata = loader.GetMetadata()) {
+        convert.mpp = metadata->mppX;
+    }
+    convert.description = "pathview-convert " + options.inputPath;
+    std::atomic<int> lastPercent{-1};
+    if (!options.quiet) {
+        convert.progress = [&lastPercent](size_t done, size_t total) {
+            int percent = static_cast<int>(done * 100 / total);
+            if (lastPercent.exchange(percent) != percent) {
+                std::fprintf(stderr, "\r%3d%% (%zu / %zu tiles)", percent, done, total);
+            }
+        };
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    SlideTranscoder::Result result = SlideTranscoder::Convert(
+        loader.GetWidth(), loader.GetHeight(),
+        [&loader](int64_t x, int64_t y, int64_t width, int64_t height, uint32_t* pixels) {
+            return loader.ReadRegionInto(0, x, y, width, height, pixels);
+        },
+        options.outputPath, convert);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!options.quiet) {
+        std::fprintf(stderr, "\n");
+    }
+    if (!result.ok) {
+        std::cerr << "Conversion failed: " << result.error << std::endl;
+        return 1;
+    }
+
+    std::printf("%s: %lld x %lld, %d levels, %zu tiles, %.1f MB in %.1f s (at most %zu tiles held)\n",
+                options.outputPath.c_str(), static_cast<long long>(loader.GetWidth()),
+                static_cast<long long>(loader.GetHeight()), result.levels, result.tiles,
+                static_cast<double>(result.bytes) / (1024.0 * 1024.0), seconds, result.peakPendingTiles);
+    return 0;
+}
@@ -0,0 +1,186 @@
+// pathview-prefetch-model: learns where reviewers go next from the stops
+// of recorded review sessions (pathview --record-trace) and writes the
+// model pathview --prefetch-model loads, one per slide type in the same
+// file. Traces given to --evaluate are replayed against the model instead
+// of learned from: for each stop, how much of the next stop's view the
+// model would have prefetched at its level, next to what the velocity
+// predictor alone covers with the view still.
+
+#include "FrameBenchmark.h"
+#include "PrefetchModel.h"
+#include "ViewportTrace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string modelPath;
+    std::string slideType = "default";
+    double stopHoldMs = PrefetchModel::DEFAULT_STOP_HOLD_MS;
+    std::vector<std::string> traces;
+    std::vector<std::string> evaluateTraces;
+};
+
+// Screen pixels of the tile ring SlideRenderer::PrefetchTiles keeps around
+// a still view (a typical tile)
+constexpr double RING_PIXELS = 256.0;
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " <model.json> <trace.pvt>... [options]\n"
+              << "\nOptions:\n"
+              << "  --type TYPE        Slide type the traces are of, e.g. aperio-40x (vendor and\n"
+              << "                     objective, as slide.info reports them; default: default,\n"
+              << "                     used for types without a model of their own)\n"
+              << "  --stop-hold-ms MS  A view held this long is a stop (default: 250)\n"
+              << "  --evaluate TRACE   Held-out trace to score the model on (repeatable)\n"
+              << "  --help             Show this help message\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--type" && i + 1 < argc) {
+            options.slideType = argv[++i];
+        } else if (arg == "--stop-hold-ms" && i + 1 < argc) {
+            options.stopHoldMs = std::max(1.0, std::atof(argv[++i]));
+        } else if (arg == "--evaluate" && i + 1 < argc) {
+            options.evaluateTraces.push_back(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else if (options.modelPath.empty()) {
+            options.modelPath = arg;
+        } else {
+            options.traces.push_back(arg);
+        }
+    }
+    return !options.modelPath.empty() && (!options.traces.empty() || !options.evaluateTraces.empty());
+}
+
+Rect ViewOf(Vec2 center, double zoom, const ViewportSample& size) {
+    const double width = size.windowWidth / zoom;
+    const double height = size.windowHeight / zoom;
+    return Rect(center.x - width / 2, center.y - height / 2, width, height);
+}
+
+// Fraction of view inside region
+double Coverage(const Rect& region, const Rect& view) {
+    const double width = std::min(region.Right(), view.Right()) - std::max(region.x, view.x);
+    const double height = std::min(region.Bottom(), view.Bottom()) - std::max(region.y, view.y);
+    if (width <= 0.0 || height <= 0.0 || view.width <= 0.0 || view.height <= 0.0) {
+        return 0.0;
+    }
+    return width * height / (view.width * view.height);
+}
+
+struct Score {
+    size_t transitions = 0;
+    double velocity = 0.0;  // Summed coverage of the next stop
+    double model = 0.0;
+    double both = 0.0;
+};
+
+// Per stop: the velocity predictor's ring (current level, and the coarser
+// one) against the best single predicted view at the next stop's level.
+// Overlapping predictions are not merged, so the model's figure is a lower
+// bound.
+void Evaluate(const PrefetchModel& model, const ViewportTrace& trace, double stopHoldMs, Score& score) {
+    const std::vector<ViewportSample>& samples = trace.GetSamples();
+    const std::vector<bool> isStop = FrameBenchmark::FindStops(trace, stopHoldMs);
+    const ViewportSample* from = nullptr;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!isStop[i]) {
+            continue;
+        }
+        const ViewportSample& to = samples[i];
+        if (from && from->zoom > 0.0 && to.zoom > 0.0) {
+            const Rect next(to.x, to.y, to.windowWidth / to.zoom, to.windowHeight / to.zoom);
+            const size_t nextOctave = PrefetchModel::Octave(to.zoom);
+            const size_t octave = PrefetchModel::Octave(from->zoom);
+            const double margin = RING_PIXELS / from->zoom;
+            const Rect ring(from->x - margin, from->y - margin, from->windowWidth / from->zoom + 2 * margin,
+                            from->windowHeight / from->zoom + 2 * margin);
+            const double velocity = nextOctave == octave || nextOctave + 1 == octave ? Coverage(ring, next) : 0.0;
+
+            double predicted = 0.0;
+            const Vec2 center(from->x + from->windowWidth / from->zoom / 2,
+                              from->y + from->windowHeight / from->zoom / 2);
+            for (const PrefetchModel::Prediction& prediction :
+                 model.Predict(center, from->zoom, from->windowWidth, from->windowHeight)) {
+                if (PrefetchModel::Octave(prediction.view.zoom) == nextOctave) {
+                    predicted = std::max(predicted,
+                                         Coverage(ViewOf(prediction.view.center, prediction.view.zoom, *from), next));
+                }
+            }
+            score.transitions++;
+            score.velocity += velocity;
+            score.model += predicted;
+            score.both += std::max(velocity, predicted);
+        }
+        from = &to;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    PrefetchModel model;
+    if (!options.traces.empty()) {
+        for (const std::string& path : options.traces) {
+            ViewportTrace trace;
+            if (!trace.Load(path)) {
+                std::cerr << "Failed to load trace " << path << std::endl;
+                return 1;
+            }
+            model.Learn(trace, options.stopHoldMs);
+        }
+        if (!model.Save(options.modelPath, options.slideType)) {
+            std::cerr << "Failed to write " << options.modelPath << std::endl;
+            return 1;
+        }
+        std::cout << "Learned " << model.GetTransitionCount() << " stop transitions from "
+                  << options.traces.size() << " traces into " << options.modelPath << " (type "
+                  << options.slideType << ")" << std::endl;
+    } else if (!model.Load(options.modelPath, options.slideType)) {
+        std::cerr << "No model for " << options.slideType << " in " << options.modelPath << std::endl;
+        return 1;
+    }
+
+    if (options.evaluateTraces.empty()) {
+        return 0;
+    }
+    Score score;
+    for (const std::string& path : options.evaluateTraces) {
+        ViewportTrace trace;
+        if (!trace.Load(path)) {
+            std::cerr << "Failed to load trace " << path << std::endl;
+            return 1;
+        }
+        Evaluate(model, trace, options.stopHoldMs, score);
+    }
+    if (score.transitions == 0) {
+        std::cout << "No stop transitions to evaluate" << std::endl;
+        return 0;
+    }
+    const double n = static_cast<double>(score.transitions);
+    std::cout << "Next stop prefetched at its level, mean over " << score.transitions << " transitions:\n"
+              << "  velocity only:    " << 100.0 * score.velocity / n << "%\n"
+              << "  model:            " << 100.0 * score.model / n << "%\n"
+              << "  velocity + model: " << 100.0 * score.both / n << "%\n"
+              << "Time to sharp: pathview --headless --bench-trace TRACE [--prefetch-model "
+              << options.modelPath << "]" << std::endl;
+    return 0;
+}
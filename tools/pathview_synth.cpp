@@ -0,0 +1,124 @@
+// pathview-synth: writes a synthetic cell segmentation to go with a
+// synthetic:// slide (see SyntheticSlide), as JSON or packed version 2
+// protobuf, optionally with its binary sidecar, so loaders, the renderer
+// and the tile server can be benchmarked on millions of cells without
+// patient data. The same slide URL and cell count always give the same
+// file.
+
+#include "SyntheticSlide.h"
+#include "PolygonCache.h"
+#include "PolygonIndex.h"
+#include "PolygonLoaderFactory.h"
+#include "PolygonStore.h"
+#include "SyntheticCellWriter.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string outputPath;
+    std::string slideUrl = "synthetic://100000x80000";
+    size_t cellCount = 1000000;
+    bool sidecar = false;
+};
+
+void PrintUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " <output.json|output.pb> [options]\n"
+              << "\nOptions:\n"
+              << "  --cells N      Cells to generate (default: 1000000)\n"
+              << "  --slide URL    synthetic:// slide the cells go with (default: synthetic://100000x80000)\n"
+              << "  --sidecar      Also write the binary sidecar the viewer would cache\n"
+              << "  --help         Show this help message\n";
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--cells" && i + 1 < argc) {
+            options.cellCount = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--slide" && i + 1 < argc) {
+            options.slideUrl = argv[++i];
+        } else if (arg == "--sidecar") {
+            options.sidecar = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else if (options.outputPath.empty()) {
+            options.outputPath = arg;
+        } else {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.outputPath.empty();
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Load the file back as the viewer would and cache it
+bool WriteSidecar(const std::string& path) {
+    std::unique_ptr<PolygonLoader> loader = PolygonLoaderFactory::CreateLoader(path, false);
+    PolygonStore polygons;
+    std::map<int, SDL_Color> classColors;
+    std::map<int, std::string> classNames;
+    if (!loader || !loader->Load(path, polygons, classColors, classNames)) {
+        return false;
+    }
+    PolygonIndex index;
+    index.Build(polygons);
+    return PolygonCache::Write(path, polygons, &index, classColors, classNames, nullptr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    const bool json = EndsWith(options.outputPath, ".json");
+    if (!json && !EndsWith(options.outputPath, ".pb")) {
+        std::cerr << "Output must end in .json or .pb" << std::endl;
+        return 1;
+    }
+    SyntheticSlideSpec spec;
+    std::string error;
+    if (!SyntheticSlideSpec::Parse(options.slideUrl, spec, error)) {
+        std::cerr << error << ": " << options.slideUrl << std::endl;
+        return 1;
+    }
+
+    const auto start = Clock::now();
+    SyntheticSlide slide(spec);
+    SyntheticCells generator(slide, options.cellCount);
+    const bool written = json ? SyntheticCellWriter::WriteJson(options.outputPath, options.slideUrl, generator)
+                              : SyntheticCellWriter::WriteProtobuf(options.outputPath, options.slideUrl, generator);
+    if (!written) {
+        std::cerr << "Failed to write " << options.outputPath << std::endl;
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Wrote " << options.cellCount << " cells for " << options.slideUrl << " to "
+              << options.outputPath << " in " << seconds << " s" << std::endl;
+
+    if (options.sidecar) {
+        if (!WriteSidecar(options.outputPath)) {
+            std::cerr << "Failed to write the sidecar of " << options.outputPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << PolygonCache::SidecarPath(options.outputPath) << std::endl;
+    }
+    return 0;
+}